@@ -12,7 +12,13 @@ Feature: osrm-contract command line options: help
         And stdout should contain "--threads"
         And stdout should contain "--core"
         And stdout should contain "--level-cache"
+        And stdout should contain "--cch"
         And stdout should contain "--segment-speed-file"
+        And stdout should contain "--segment-speed-profile-file"
+        And stdout should contain "--cache-lookup-files"
+        And stdout should contain "--contraction-telemetry"
+        And stdout should contain "--metric"
+        And stdout should contain "--exclude"
         And it should exit with an error
 
     Scenario: osrm-contract - Help, short
@@ -26,7 +32,13 @@ Feature: osrm-contract command line options: help
         And stdout should contain "--threads"
         And stdout should contain "--core"
         And stdout should contain "--level-cache"
+        And stdout should contain "--cch"
         And stdout should contain "--segment-speed-file"
+        And stdout should contain "--segment-speed-profile-file"
+        And stdout should contain "--cache-lookup-files"
+        And stdout should contain "--contraction-telemetry"
+        And stdout should contain "--metric"
+        And stdout should contain "--exclude"
         And it should exit successfully
 
     Scenario: osrm-contract - Help, long
@@ -40,5 +52,11 @@ Feature: osrm-contract command line options: help
         And stdout should contain "--threads"
         And stdout should contain "--core"
         And stdout should contain "--level-cache"
+        And stdout should contain "--cch"
         And stdout should contain "--segment-speed-file"
+        And stdout should contain "--segment-speed-profile-file"
+        And stdout should contain "--cache-lookup-files"
+        And stdout should contain "--contraction-telemetry"
+        And stdout should contain "--metric"
+        And stdout should contain "--exclude"
         And it should exit successfully
@@ -15,12 +15,33 @@ Feature: osrm-routed command line options: help
         And stdout should contain "Configuration:"
         And stdout should contain "--ip"
         And stdout should contain "--port"
+        And stdout should contain "--unix-socket"
         And stdout should contain "--threads"
         And stdout should contain "--shared-memory"
+        And stdout should contain "--prefetch-rtree-leaves"
+        And stdout should contain "--huge-pages"
+        And stdout should contain "--lazy-blocks"
+        And stdout should contain "--container"
         And stdout should contain "--max-viaroute-size"
         And stdout should contain "--max-trip-size"
         And stdout should contain "--max-table-size"
         And stdout should contain "--max-matching-size"
+        And stdout should contain "--matching-beam-width"
+        And stdout should contain "--trip-improvement-time"
+        And stdout should contain "--parallel-search-distance"
+        And stdout should contain "--compression-level"
+        And stdout should contain "--compression-min-size"
+        And stdout should contain "--worker-pool"
+        And stdout should contain "--acceptor-per-thread"
+        And stdout should contain "--pin-threads"
+        And stdout should contain "--numa-replicas"
+        And stdout should contain "--shortcut-cache-size"
+        And stdout should contain "--tile-cache-size"
+        And stdout should contain "--phantom-node-cache-size"
+        And stdout should contain "--route-cache-size"
+        And stdout should contain "--max-target-sets"
+        And stdout should contain "--search-space-cache-size"
+        And stdout should contain "--max-isochrone-duration"
         And it should exit successfully
 
     Scenario: osrm-routed - Help, short
@@ -34,12 +55,33 @@ Feature: osrm-routed command line options: help
         And stdout should contain "Configuration:"
         And stdout should contain "--ip"
         And stdout should contain "--port"
+        And stdout should contain "--unix-socket"
         And stdout should contain "--threads"
         And stdout should contain "--shared-memory"
+        And stdout should contain "--prefetch-rtree-leaves"
+        And stdout should contain "--huge-pages"
+        And stdout should contain "--lazy-blocks"
+        And stdout should contain "--container"
         And stdout should contain "--max-viaroute-size"
         And stdout should contain "--max-trip-size"
         And stdout should contain "--max-table-size"
         And stdout should contain "--max-matching-size"
+        And stdout should contain "--matching-beam-width"
+        And stdout should contain "--trip-improvement-time"
+        And stdout should contain "--parallel-search-distance"
+        And stdout should contain "--compression-level"
+        And stdout should contain "--compression-min-size"
+        And stdout should contain "--worker-pool"
+        And stdout should contain "--acceptor-per-thread"
+        And stdout should contain "--pin-threads"
+        And stdout should contain "--numa-replicas"
+        And stdout should contain "--shortcut-cache-size"
+        And stdout should contain "--tile-cache-size"
+        And stdout should contain "--phantom-node-cache-size"
+        And stdout should contain "--route-cache-size"
+        And stdout should contain "--max-target-sets"
+        And stdout should contain "--search-space-cache-size"
+        And stdout should contain "--max-isochrone-duration"
         And it should exit successfully
 
     Scenario: osrm-routed - Help, long
@@ -53,10 +95,31 @@ Feature: osrm-routed command line options: help
         And stdout should contain "Configuration:"
         And stdout should contain "--ip"
         And stdout should contain "--port"
+        And stdout should contain "--unix-socket"
         And stdout should contain "--threads"
         And stdout should contain "--shared-memory"
+        And stdout should contain "--prefetch-rtree-leaves"
+        And stdout should contain "--huge-pages"
+        And stdout should contain "--lazy-blocks"
+        And stdout should contain "--container"
         And stdout should contain "--max-trip-size"
         And stdout should contain "--max-table-size"
         And stdout should contain "--max-table-size"
         And stdout should contain "--max-matching-size"
+        And stdout should contain "--matching-beam-width"
+        And stdout should contain "--trip-improvement-time"
+        And stdout should contain "--parallel-search-distance"
+        And stdout should contain "--compression-level"
+        And stdout should contain "--compression-min-size"
+        And stdout should contain "--worker-pool"
+        And stdout should contain "--acceptor-per-thread"
+        And stdout should contain "--pin-threads"
+        And stdout should contain "--numa-replicas"
+        And stdout should contain "--shortcut-cache-size"
+        And stdout should contain "--tile-cache-size"
+        And stdout should contain "--phantom-node-cache-size"
+        And stdout should contain "--route-cache-size"
+        And stdout should contain "--max-target-sets"
+        And stdout should contain "--search-space-cache-size"
+        And stdout should contain "--max-isochrone-duration"
         And it should exit successfully
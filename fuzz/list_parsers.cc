@@ -0,0 +1,170 @@
+#include "engine/api/base_parameters.hpp"
+#include "server/api/list_parsers.hpp"
+
+#include "util.hpp"
+
+#include <boost/spirit/include/phoenix.hpp>
+#include <boost/spirit/include/qi.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+using osrm::engine::api::BaseParameters;
+
+namespace qi = boost::spirit::qi;
+namespace ph = boost::phoenix;
+
+using Iterator = std::string::iterator;
+using Rule = qi::rule<Iterator, void(BaseParameters &)>;
+
+// The Spirit rules the hand-written parsers replaced
+struct SpiritRules
+{
+    SpiritRules()
+    {
+        using namespace osrm;
+
+        const auto add_hint = [](BaseParameters &parameters,
+                                 const boost::optional<std::string> &hint_string) {
+            if (hint_string)
+                parameters.hints.emplace_back(engine::Hint::FromBase64(hint_string.get()));
+            else
+                parameters.hints.emplace_back(boost::none);
+        };
+
+        const auto add_bearing = [](BaseParameters &parameters,
+                                    boost::optional<boost::fusion::vector2<short, short>> range) {
+            boost::optional<engine::Bearing> bearing;
+            if (range)
+                bearing = engine::Bearing{boost::fusion::at_c<0>(*range),
+                                          boost::fusion::at_c<1>(*range)};
+            parameters.bearings.push_back(std::move(bearing));
+        };
+
+        base64_char = qi::char_("a-zA-Z0-9--_=");
+        unlimited_rule = qi::lit("unlimited")[qi::_val = std::numeric_limits<double>::infinity()];
+
+        location_rule =
+            (double_ > qi::lit(',') >
+             double_)[qi::_val = ph::bind(
+                          [](double lon, double lat) {
+                              return util::Coordinate(util::toFixed(util::FloatLongitude{lon}),
+                                                      util::toFixed(util::FloatLatitude{lat}));
+                          },
+                          qi::_1,
+                          qi::_2)];
+
+        coordinates =
+            (location_rule % ';')[ph::bind(&BaseParameters::coordinates, qi::_r1) = qi::_1];
+
+        radiuses = (-(qi::double_ | unlimited_rule) %
+                    ';')[ph::bind(&BaseParameters::radiuses, qi::_r1) = qi::_1];
+
+        hints = (-qi::as_string[qi::repeat(engine::ENCODED_HINT_SIZE)[base64_char]])[ph::bind(
+                    add_hint, qi::_r1, qi::_1)] %
+                ';';
+
+        bearings =
+            (-(qi::short_ > ',' > qi::short_))[ph::bind(add_bearing, qi::_r1, qi::_1)] % ';';
+    }
+
+    Rule coordinates;
+    Rule radiuses;
+    Rule hints;
+    Rule bearings;
+
+    qi::rule<Iterator, osrm::util::Coordinate()> location_rule;
+    qi::rule<Iterator, unsigned char()> base64_char;
+    qi::rule<Iterator, double()> unlimited_rule;
+    qi::real_parser<double, osrm::server::api::no_trailing_dot_policy<double>> double_;
+};
+
+struct ListParsers
+{
+    ListParsers()
+    {
+        using namespace osrm::server::api;
+
+        coordinates = CoordinatesParser();
+        radiuses = RadiusesParser();
+        hints = HintsParser();
+        bearings = BearingsParser();
+    }
+
+    Rule coordinates;
+    Rule radiuses;
+    Rule hints;
+    Rule bearings;
+};
+
+struct Result
+{
+    bool ok = false;
+    Iterator position;
+    BaseParameters parameters;
+};
+
+Result parse(std::string &in, const Rule &rule)
+{
+    Result result;
+    result.position = begin(in);
+    try
+    {
+        result.ok = qi::parse(result.position, end(in), rule(ph::ref(result.parameters)));
+    }
+    catch (const qi::expectation_failure<Iterator> &failure)
+    {
+        result.position = failure.first;
+    }
+    catch (const boost::numeric::bad_numeric_cast &)
+    {
+        result.position = end(in);
+    }
+    return result;
+}
+
+// Radiuses can be NaN, the bits of equal numbers are equal
+bool equal(const boost::optional<double> &lhs, const boost::optional<double> &rhs)
+{
+    return !lhs == !rhs && (!lhs || std::memcmp(&*lhs, &*rhs, sizeof(double)) == 0);
+}
+
+void compare(std::string &in, const Rule &spirit_rule, const Rule &list_parser)
+{
+    const auto expected = parse(in, spirit_rule);
+    const auto actual = parse(in, list_parser);
+
+    if (expected.ok != actual.ok || expected.position != actual.position)
+    {
+        std::abort();
+    }
+
+    // the parameters of a failed parse are dropped
+    const auto &lhs = expected.parameters;
+    const auto &rhs = actual.parameters;
+    if (expected.ok &&
+        (lhs.coordinates != rhs.coordinates || lhs.bearings != rhs.bearings ||
+         lhs.hints != rhs.hints || lhs.radiuses.size() != rhs.radiuses.size() ||
+         !std::equal(lhs.radiuses.begin(), lhs.radiuses.end(), rhs.radiuses.begin(), equal)))
+    {
+        std::abort();
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const unsigned char *data, unsigned long size)
+{
+    static const SpiritRules spirit_rules;
+    static const ListParsers list_parsers;
+
+    std::string in(reinterpret_cast<const char *>(data), size);
+
+    compare(in, spirit_rules.coordinates, list_parsers.coordinates);
+    compare(in, spirit_rules.radiuses, list_parsers.radiuses);
+    compare(in, spirit_rules.hints, list_parsers.hints);
+    compare(in, spirit_rules.bearings, list_parsers.bearings);
+    escape(&in);
+
+    return 0;
+}
@@ -29,12 +29,15 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define CONTRACTOR_CONTRACTOR_HPP
 
 #include "contractor/contractor_config.hpp"
+#include "contractor/customizable_contractor.hpp"
 #include "contractor/query_edge.hpp"
 #include "extractor/edge_based_edge.hpp"
 #include "extractor/edge_based_node.hpp"
 #include "util/deallocating_vector.hpp"
 #include "util/typedefs.hpp"
 
+#include <stxxl/vector>
+
 #include <string>
 #include <vector>
 
@@ -61,16 +64,36 @@ class Contractor
   protected:
     void ContractGraph(const unsigned max_edge_id,
                        util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
-                       util::DeallocatingVector<QueryEdge> &contracted_edge_list,
+                       stxxl::vector<QueryEdge> &contracted_edge_list,
                        std::vector<EdgeWeight> &&node_weights,
                        std::vector<bool> &is_core_node,
                        std::vector<float> &inout_node_levels) const;
+    void CustomizeGraph(const unsigned max_edge_id,
+                        util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
+                        stxxl::vector<QueryEdge> &contracted_edge_list) const;
     void WriteCoreNodeMarker(std::vector<bool> &&is_core_node) const;
+    void WriteCoreLandmarks(const stxxl::vector<QueryEdge> &contracted_edge_list,
+                            const std::vector<bool> &is_core_node) const;
+    void WriteSpeedProfiles() const;
+    void
+    ExcludeClasses(util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list) const;
+    void
+    ExtractShard(util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list) const;
+    void BuildMultiLevelGraph(
+        const EdgeID max_edge_id,
+        util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list) const;
     void WriteNodeLevels(std::vector<float> &&node_levels) const;
     void ReadNodeLevels(std::vector<float> &contraction_order) const;
+    void WriteNodeRanks(const std::vector<NodeID> &node_ranks) const;
+    void ReadNodeRanks(std::vector<NodeID> &node_ranks) const;
+    void WriteCustomizedMetric(const CustomizableContractor::Metric &metric) const;
+    bool ReadCustomizedMetric(CustomizableContractor::Metric &metric) const;
+    void RenumberNodes(const unsigned max_node_id,
+                       stxxl::vector<QueryEdge> &contracted_edge_list,
+                       std::vector<bool> &is_core_node) const;
     std::size_t
     WriteContractedGraph(unsigned number_of_edge_based_nodes,
-                         const util::DeallocatingVector<QueryEdge> &contracted_edge_list);
+                         stxxl::vector<QueryEdge> &contracted_edge_list);
     void FindComponents(unsigned max_edge_id,
                         const util::DeallocatingVector<extractor::EdgeBasedEdge> &edges,
                         std::vector<extractor::EdgeBasedNode> &nodes) const;
@@ -87,10 +110,12 @@ class Contractor
                           const std::vector<std::string> &turn_penalty_path,
                           const std::string &nodes_filename,
                           const std::string &geometry_filename,
+                          const std::string &geometry_output_filename,
                           const std::string &datasource_names_filename,
                           const std::string &datasource_indexes_filename,
                           const std::string &rtree_leaf_filename,
-                          const double log_edge_updates_factor);
+                          const double log_edge_updates_factor,
+                          const bool cache_lookup_files);
 };
 }
 }
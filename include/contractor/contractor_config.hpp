@@ -28,9 +28,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef CONTRACTOR_OPTIONS_HPP
 #define CONTRACTOR_OPTIONS_HPP
 
+#include "contractor/geographic_partition.hpp"
+#include "extractor/class_data.hpp"
+
 #include <boost/filesystem/path.hpp>
 
 #include <string>
+#include <vector>
 
 namespace osrm
 {
@@ -39,39 +43,123 @@ namespace contractor
 
 struct ContractorConfig
 {
-    ContractorConfig() : requested_num_threads(0) {}
+    ContractorConfig()
+        : customizable(false), renumber_nodes(false), core_landmarks(0), excluded_classes(0),
+          cell(-1), multi_level(false), mld_cell_sizes{128, 4096, 65536, 2097152},
+          requested_num_threads(0), cache_lookup_files(false)
+    {
+    }
 
     // Infer the output names from the path of the .osrm file
     void UseDefaultOutputNames()
     {
         level_output_path = osrm_input_path.string() + ".level";
+        rank_output_path = osrm_input_path.string() + ".cch_order";
+        metric_output_path = osrm_input_path.string() + ".cch_metric";
         core_output_path = osrm_input_path.string() + ".core";
         graph_output_path = osrm_input_path.string() + ".hsgr";
+        renumbering_output_path = osrm_input_path.string() + ".renumbering";
+        core_landmarks_output_path = osrm_input_path.string() + ".landmarks";
         edge_based_graph_path = osrm_input_path.string() + ".ebg";
         edge_segment_lookup_path = osrm_input_path.string() + ".edge_segment_lookup";
         edge_penalty_path = osrm_input_path.string() + ".edge_penalties";
+        edge_based_node_classes_path = osrm_input_path.string() + ".edge_classes";
         node_based_graph_path = osrm_input_path.string() + ".nodes";
         geometry_path = osrm_input_path.string() + ".geometry";
+        geometry_output_path = geometry_path;
         rtree_leaf_path = osrm_input_path.string() + ".fileIndex";
         datasource_names_path = osrm_input_path.string() + ".datasource_names";
         datasource_indexes_path = osrm_input_path.string() + ".datasource_indexes";
+        speed_profiles_path = osrm_input_path.string() + ".speed_profiles";
+        partition_path = osrm_input_path.string() + ".cells";
+        mld_partition_path = osrm_input_path.string() + ".mld_partition";
+        mld_graph_output_path = osrm_input_path.string() + ".mldgr";
+    }
+
+    // Write the outputs that depend on the edge weights to <base>.<metric>.*. The node order is
+    // shared with the default metric, the segment weights start from its geometries.
+    void UseMetricOutputNames()
+    {
+        const auto metric_base = osrm_input_path.string() + "." + metric;
+        metric_output_path = metric_base + ".cch_metric";
+        core_output_path = metric_base + ".core";
+        graph_output_path = metric_base + ".hsgr";
+        renumbering_output_path = metric_base + ".renumbering";
+        core_landmarks_output_path = metric_base + ".landmarks";
+        geometry_output_path = metric_base + ".geometry";
+        datasource_names_path = metric_base + ".datasource_names";
+        datasource_indexes_path = metric_base + ".datasource_indexes";
+        speed_profiles_path = metric_base + ".speed_profiles";
+        mld_graph_output_path = metric_base + ".mldgr";
+    }
+
+    // Write the hierarchy of the shard of the cell to <base>.cell<n>.*, it has a node order of its
+    // own and the overlay edges between its border nodes
+    void UseCellOutputNames()
+    {
+        metric = getCellMetricName(cell);
+        UseMetricOutputNames();
+        const auto metric_base = osrm_input_path.string() + "." + metric;
+        level_output_path = metric_base + ".level";
+        rank_output_path = metric_base + ".cch_order";
+        overlay_output_path = metric_base + ".overlay";
     }
 
     boost::filesystem::path config_file_path;
     boost::filesystem::path osrm_input_path;
 
     std::string level_output_path;
+    std::string rank_output_path;
+    std::string metric_output_path;
     std::string core_output_path;
     std::string graph_output_path;
+    std::string renumbering_output_path;
+    std::string core_landmarks_output_path;
     std::string edge_based_graph_path;
 
     std::string edge_segment_lookup_path;
     std::string edge_penalty_path;
+    std::string edge_based_node_classes_path;
     std::string node_based_graph_path;
     std::string geometry_path;
+    std::string geometry_output_path;
     std::string rtree_leaf_path;
     bool use_cached_priority;
 
+    // Contract in a metric independent nested dissection order and customize the weights. With
+    // the cached order of a previous run only the customization is repeated.
+    bool customizable;
+
+    // Write the hierarchy with the nodes ordered by their height and by a depth first search
+    // instead of in the order of the extraction, together with the id of every node in it
+    bool renumber_nodes;
+
+    // Number of landmarks whose weights to and from every core node are written for the A*
+    // search in the core, none without a core
+    unsigned core_landmarks;
+
+    // Name of an additional metric over the topology of the dataset, empty for the default one.
+    // A metric is contracted in the node order of the default metric.
+    std::string metric;
+
+    // Classes of edge-based nodes the metric is contracted without, their metric is named after
+    // them so that requests excluding the classes find it
+    extractor::ClassData excluded_classes;
+
+    // Cell of the partition written by osrm-partition whose shard is contracted, -1 for the
+    // whole graph
+    int cell;
+    std::string partition_path;
+    std::string overlay_output_path;
+
+    // Build a multi-level overlay graph instead of a hierarchy. The nested cells of its partition
+    // hold at most mld_cell_sizes nodes from the lowest level up. With the cached partition of a
+    // previous run only the cliques of the cells are customized.
+    bool multi_level;
+    std::vector<std::size_t> mld_cell_sizes;
+    std::string mld_partition_path;
+    std::string mld_graph_output_path;
+
     unsigned requested_num_threads;
     double log_edge_updates_factor;
 
@@ -83,8 +171,17 @@ struct ContractorConfig
 
     std::vector<std::string> segment_speed_lookup_paths;
     std::vector<std::string> turn_penalty_lookup_paths;
+    // Lookup files with the speeds of segments for the quarter hours of a day
+    std::vector<std::string> segment_speed_profile_lookup_paths;
+    // Keep a binary copy of every parsed lookup file and reuse it until the file changes
+    bool cache_lookup_files;
+    // Writes the statistics of every contraction round as a line of JSON to this file if set
+    std::string contraction_telemetry_path;
+    // Writes the time, memory and I/O of the phases of the run as JSON to this file if set
+    std::string phase_report_path;
     std::string datasource_indexes_path;
     std::string datasource_names_path;
+    std::string speed_profiles_path;
 };
 }
 }
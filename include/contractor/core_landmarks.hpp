@@ -0,0 +1,43 @@
+#ifndef OSRM_CONTRACTOR_CORE_LANDMARKS_HPP
+#define OSRM_CONTRACTOR_CORE_LANDMARKS_HPP
+
+#include "contractor/query_edge.hpp"
+#include "util/typedefs.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Landmarks of the uncontracted core of a hierarchy, written by osrm-contract --core-landmarks.
+// The weights of the shortest paths in the core between every core node and the landmarks bound
+// the weight of a path between two core nodes from below, the core search of a query uses them
+// as the potentials of an A* search.
+struct CoreLandmarks
+{
+    std::uint32_t number_of_landmarks = 0;
+    // position of every node of the hierarchy among the core nodes, SPECIAL_NODEID for the nodes
+    // outside of the core
+    std::vector<NodeID> core_indices;
+    // the weights of core node c start at c * 2 * number_of_landmarks, first the ones from the
+    // landmarks to the node, then the ones from the node to the landmarks. INVALID_EDGE_WEIGHT if
+    // there is no path in the core.
+    std::vector<EdgeWeight> weights;
+};
+
+// Picks the landmarks by farthest selection: every landmark is the core node that is farthest
+// from the ones picked before, the first one is the farthest from the first core node. The
+// edges are those of the hierarchy, edges to nodes outside of the core are ignored.
+CoreLandmarks computeCoreLandmarks(const std::vector<bool> &is_core_node,
+                                   const std::vector<QueryEdge> &edges,
+                                   const std::uint32_t number_of_landmarks);
+
+void writeCoreLandmarks(const std::string &path, const CoreLandmarks &landmarks);
+}
+}
+
+#endif // OSRM_CONTRACTOR_CORE_LANDMARKS_HPP
@@ -0,0 +1,105 @@
+#ifndef OSRM_CONTRACTOR_CUSTOMIZABLE_CONTRACTOR_HPP
+#define OSRM_CONTRACTOR_CUSTOMIZABLE_CONTRACTOR_HPP
+
+#include "contractor/query_edge.hpp"
+#include "extractor/edge_based_edge.hpp"
+#include "util/deallocating_vector.hpp"
+#include "util/typedefs.hpp"
+
+#include <stxxl/vector>
+
+#include <cstdint>
+
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Customizable contraction hierarchy: the nodes are contracted in a nested dissection order that
+// only depends on the topology of the graph. Contracting without witness searches yields the
+// chordal supergraph of the graph, whose arcs are the same for every metric. Customizing computes
+// the weights of all arcs bottom up from their lower triangles, which is a fraction of the cost
+// of a contraction, so weight updates only rerun the customization.
+//
+// The customized arcs are handed out in the format of the contraction hierarchy, its query
+// algorithms run on them unchanged.
+class CustomizableContractor
+{
+  public:
+    using EdgeList = util::DeallocatingVector<extractor::EdgeBasedEdge>;
+
+    // Weight and length of one direction of an arc, the edge id of an original edge or the rank
+    // of the middle node of a shortcut
+    struct ArcMetric
+    {
+        EdgeWeight weight;
+        EdgeDistance distance;
+        NodeID via;
+        NodeID edge_id;
+    };
+
+    // Customized weights of all arcs together with the weights of the original edges they were
+    // derived from. The checksum identifies the arcs, a metric only fits arcs with the same one.
+    struct Metric
+    {
+        std::uint32_t checksum;
+        std::vector<ArcMetric> edge_up;
+        std::vector<ArcMetric> edge_down;
+        std::vector<ArcMetric> up;
+        std::vector<ArcMetric> down;
+        // u-turns through a lower node, indexed by rank
+        std::vector<ArcMetric> loop;
+    };
+
+    // Computes the nested dissection order of the nodes by recursively splitting the graph at
+    // the smallest breadth first search level close to its middle. The separator nodes get the
+    // highest ranks, the node with rank 0 is contracted first.
+    static std::vector<NodeID> ComputeNodeRanks(const NodeID number_of_nodes, EdgeList &edges);
+
+    // Builds the arcs of the chordal supergraph for contracting the nodes by their rank
+    CustomizableContractor(const NodeID number_of_nodes,
+                           EdgeList &edges,
+                           std::vector<NodeID> node_ranks);
+
+    // Sets the weights of the edges and derives the weights of all shortcuts. The nodes of a
+    // level only depend on lower levels, each level is customized in parallel.
+    void Customize(EdgeList &edges);
+
+    // Customizes again after some edge weights changed since the previous metric. Only nodes
+    // with changed edges or with a lower neighbour whose arcs changed are customized, the others
+    // keep their previous arcs. The result equals a full customization. Falls back to one if the
+    // previous metric does not fit the arcs. Returns the number of customized nodes.
+    std::size_t Customize(EdgeList &edges, Metric previous);
+
+    const Metric &GetMetric() const { return metric; }
+
+    // Appends the customized arcs, stored at their lower node like contracted edges
+    void GetEdges(stxxl::vector<QueryEdge> &edges) const;
+
+    std::size_t GetNumberOfArcs() const { return arc_head.size(); }
+
+  private:
+    void SetEdgeMetric(EdgeList &edges);
+    void CustomizeNode(const NodeID rank);
+
+    std::vector<NodeID> node_ranks;
+    std::vector<NodeID> rank_nodes;
+
+    // arcs from a rank to higher ranks, sorted by the rank of their head
+    std::vector<EdgeID> first_arc;
+    std::vector<NodeID> arc_head;
+    // arcs from lower ranks to a rank, sorted by the rank of their tail
+    std::vector<EdgeID> first_lower_arc;
+    std::vector<EdgeID> lower_arcs;
+    std::vector<NodeID> lower_arc_tails;
+    // ranks grouped by the length of the longest downward path from them
+    std::vector<std::vector<NodeID>> levels;
+
+    Metric metric;
+};
+}
+}
+
+#endif // OSRM_CONTRACTOR_CUSTOMIZABLE_CONTRACTOR_HPP
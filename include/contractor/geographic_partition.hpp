@@ -0,0 +1,94 @@
+#ifndef OSRM_CONTRACTOR_GEOGRAPHIC_PARTITION_HPP
+#define OSRM_CONTRACTOR_GEOGRAPHIC_PARTITION_HPP
+
+#include "extractor/edge_based_edge.hpp"
+#include "util/coordinate.hpp"
+#include "util/deallocating_vector.hpp"
+#include "util/typedefs.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+using CellID = std::uint32_t;
+const constexpr CellID INVALID_CELL_ID = std::numeric_limits<CellID>::max();
+
+// Geographic cells of the edge-based nodes, written by osrm-partition. Every node belongs to one
+// cell. The shard of a cell adds the nodes of other cells up to an overlap away from it, so that
+// routes close to the boundary of a cell stay in its shard. osrm-contract --cell contracts the
+// edges between the nodes of a shard on their own.
+struct GeographicPartition
+{
+    // cell of every edge-based node, INVALID_CELL_ID for nodes without a location
+    std::vector<CellID> node_cells;
+    // the nodes of the shard of cell c are shard_nodes[shard_offsets[c], shard_offsets[c + 1]),
+    // sorted by their id
+    std::vector<std::uint32_t> shard_offsets;
+    std::vector<NodeID> shard_nodes;
+
+    CellID NumberOfCells() const
+    {
+        return shard_offsets.empty() ? 0 : static_cast<CellID>(shard_offsets.size() - 1);
+    }
+
+    // Whether the nodes are part of the shard of the cell, indexed by node id
+    std::vector<bool> GetShardNodes(const CellID cell) const;
+};
+
+// Shortest path between two border nodes of a cell inside its shard. Border nodes have edges to
+// nodes of other cells. The overlay edges of all cells and the edges between the cells form the
+// overlay graph that connects the shards.
+struct OverlayEdge
+{
+    NodeID source;
+    NodeID target;
+    EdgeWeight weight;
+};
+
+// The metric osrm-contract --cell writes the shard of a cell to, <base>.cell<n>.*
+inline std::string getCellMetricName(const CellID cell) { return "cell" + std::to_string(cell); }
+
+// Location of every edge-based node, the start of its first segment in the r-tree leaves.
+// Nodes without segments get an invalid coordinate.
+std::vector<util::Coordinate> readEdgeBasedNodeCoordinates(const std::string &nodes_path,
+                                                           const std::string &rtree_leaf_path);
+
+// Splits the nodes by recursive coordinate bisection: every split divides the nodes of a region
+// at the share of its cells along its longer side. The shards extend every cell by
+// overlap_meters to all sides.
+GeographicPartition partitionByCoordinates(const std::vector<util::Coordinate> &coordinates,
+                                           const CellID number_of_cells,
+                                           const double overlap_meters);
+
+// Nested cells for a multi-level overlay by recursive coordinate bisection at the median of the
+// longer side. The cells of level l + 1 are the largest regions with at most max_cell_sizes[l]
+// nodes, the sizes have to increase. Returns the cells of the nodes on every level.
+std::vector<std::vector<CellID>>
+partitionIntoLevels(const std::vector<util::Coordinate> &coordinates,
+                    const std::vector<std::size_t> &max_cell_sizes);
+
+void writePartition(const std::string &path, const GeographicPartition &partition);
+GeographicPartition readPartition(const std::string &path);
+
+// Nodes of the cell with an edge to or from a node of another cell
+std::vector<NodeID>
+getBorderNodes(const GeographicPartition &partition,
+               const CellID cell,
+               const util::DeallocatingVector<extractor::EdgeBasedEdge> &edges);
+
+// Runs a Dijkstra search from every border node over the edges, which are the edges of a shard,
+// and returns the shortest paths to the other border nodes that exist
+std::vector<OverlayEdge>
+computeOverlayEdges(const NodeID number_of_nodes,
+                    const std::vector<NodeID> &border_nodes,
+                    const util::DeallocatingVector<extractor::EdgeBasedEdge> &edges);
+}
+}
+
+#endif // OSRM_CONTRACTOR_GEOGRAPHIC_PARTITION_HPP
@@ -3,15 +3,16 @@
 
 #include "contractor/query_edge.hpp"
 #include "util/binary_heap.hpp"
+#include "util/compact_dynamic_graph.hpp"
+#include "util/d_ary_heap.hpp"
 #include "util/deallocating_vector.hpp"
-#include "util/dynamic_graph.hpp"
 #include "util/integer_range.hpp"
+#include "util/page_fault_counter.hpp"
 #include "util/percent.hpp"
 #include "util/simple_logger.hpp"
 #include "util/timing_util.hpp"
 #include "util/typedefs.hpp"
 #include "util/xor_fast_hash.hpp"
-#include "util/xor_fast_hash_storage.hpp"
 
 #include <boost/assert.hpp>
 
@@ -20,8 +21,12 @@
 #include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_sort.h>
+#include <tbb/pipeline.h>
+#include <tbb/task_scheduler_init.h>
 
 #include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <limits>
 #include <memory>
 #include <vector>
@@ -37,22 +42,26 @@ class GraphContractor
     struct ContractorEdgeData
     {
         ContractorEdgeData()
-            : weight(0), id(0), originalEdges(0), shortcut(0), forward(0), backward(0),
-              is_original_via_node_ID(false)
+            : weight(0), distance(0), id(0), originalEdges(0), shortcut(0), forward(0),
+              backward(0), is_original_via_node_ID(false)
         {
         }
         ContractorEdgeData(unsigned weight,
+                           EdgeDistance distance,
                            unsigned original_edges,
                            unsigned id,
                            bool shortcut,
                            bool forward,
                            bool backward)
-            : weight(weight), id(id), originalEdges(std::min((unsigned)1 << 28, original_edges)),
+            : weight(weight), distance(distance), id(id),
+              originalEdges(std::min((unsigned)1 << 28, original_edges)),
               shortcut(shortcut), forward(forward), backward(backward),
               is_original_via_node_ID(false)
         {
         }
         unsigned weight;
+        // length of the path the edge stands for, it takes no part in the contraction
+        EdgeDistance distance;
         unsigned id;
         unsigned originalEdges : 28;
         bool shortcut : 1;
@@ -70,22 +79,36 @@ class GraphContractor
         bool target = false;
     };
 
-    using ContractorGraph = util::DynamicGraph<ContractorEdgeData>;
-    //    using ContractorHeap = util::BinaryHeap<NodeID, NodeID, int, ContractorHeapData,
-    //    ArrayStorage<NodeID, NodeID>
-    //    >;
-    using ContractorHeap = util::BinaryHeap<NodeID,
-                                            NodeID,
-                                            int,
-                                            ContractorHeapData,
-                                            util::XORFastHashStorage<NodeID, NodeID>>;
+    // The graph changes in rounds of independent nodes, whose new edges are inserted in one batch
+    using ContractorGraph = util::CompactDynamicGraph<ContractorEdgeData>;
+    // Witness searches run once per in-neighbour of every contracted node, a flat index array
+    // cleared by its timestamp avoids the probing of a hash table on every heap access. The
+    // thread data is recreated after every flush, so the arrays shrink with the remaining graph.
+    using ContractorHeap = util::DAryHeap<NodeID,
+                                          NodeID,
+                                          int,
+                                          ContractorHeapData,
+                                          util::TimestampedArrayStorage<NodeID, NodeID>,
+                                          4>;
     using ContractorEdge = ContractorGraph::InputEdge;
 
+    // Out-neighbour of the node that is contracted, shared by the searches from all sources
+    struct WitnessTarget
+    {
+        NodeID target;
+        unsigned weight;
+        EdgeDistance distance;
+        unsigned original_edges;
+    };
+
     struct ContractorThreadData
     {
         ContractorHeap heap;
         std::vector<ContractorEdge> inserted_edges;
         std::vector<NodeID> neighbours;
+        std::vector<WitnessTarget> targets;
+        // witness searches since the start of the round
+        std::uint64_t witness_searches = 0;
         explicit ContractorThreadData(NodeID nodes) : heap(nodes) {}
     };
 
@@ -134,6 +157,32 @@ class GraphContractor
     };
 
   public:
+    // What one round of contracting an independent node set did and how long its phases took
+    struct RoundStatistics
+    {
+        unsigned round;
+        // nodes left before the round
+        NodeID remaining_nodes;
+        NodeID independent_nodes;
+        // witness searches of contracting the independent nodes and updating the priorities
+        std::uint64_t witness_searches;
+        // shortcuts the contracted nodes added to the graph
+        std::uint64_t shortcuts;
+        // edges of the graph after the round
+        std::uint64_t edges;
+        std::uint64_t max_resident_bytes;
+        // the graph was renumbered to the remaining nodes before the round
+        bool flushed;
+
+        double flush_ms;
+        double independent_set_ms;
+        double contraction_ms;
+        double deletion_ms;
+        double insertion_ms;
+        double priority_update_ms;
+    };
+    using RoundCallback = std::function<void(const RoundStatistics &)>;
+
     template <class ContainerT>
     GraphContractor(int nodes, ContainerT &input_edge_list)
         : GraphContractor(nodes, input_edge_list, {}, {})
@@ -166,6 +215,7 @@ class GraphContractor
             edges.emplace_back(diter->source,
                                diter->target,
                                static_cast<unsigned int>(std::max(diter->weight, 1)),
+                               diter->distance,
                                1,
                                diter->edge_id,
                                false,
@@ -175,6 +225,7 @@ class GraphContractor
             edges.emplace_back(diter->target,
                                diter->source,
                                static_cast<unsigned int>(std::max(diter->weight, 1)),
+                               diter->distance,
                                1,
                                diter->edge_id,
                                false,
@@ -209,23 +260,25 @@ class GraphContractor
             forward_edge.data.id = reverse_edge.data.id = id;
             forward_edge.data.originalEdges = reverse_edge.data.originalEdges = 1;
             forward_edge.data.weight = reverse_edge.data.weight = INVALID_EDGE_WEIGHT;
-            // remove parallel edges
+            forward_edge.data.distance = reverse_edge.data.distance = 0;
+            // remove parallel edges, the distance follows the smallest weight
             while (i < edges.size() && edges[i].source == source && edges[i].target == target)
             {
-                if (edges[i].data.forward)
+                if (edges[i].data.forward && edges[i].data.weight < forward_edge.data.weight)
                 {
-                    forward_edge.data.weight =
-                        std::min(edges[i].data.weight, forward_edge.data.weight);
+                    forward_edge.data.weight = edges[i].data.weight;
+                    forward_edge.data.distance = edges[i].data.distance;
                 }
-                if (edges[i].data.backward)
+                if (edges[i].data.backward && edges[i].data.weight < reverse_edge.data.weight)
                 {
-                    reverse_edge.data.weight =
-                        std::min(edges[i].data.weight, reverse_edge.data.weight);
+                    reverse_edge.data.weight = edges[i].data.weight;
+                    reverse_edge.data.distance = edges[i].data.distance;
                 }
                 ++i;
             }
             // merge edges (s,t) and (t,s) into bidirectional edge
-            if (forward_edge.data.weight == reverse_edge.data.weight)
+            if (forward_edge.data.weight == reverse_edge.data.weight &&
+                forward_edge.data.distance == reverse_edge.data.distance)
             {
                 if ((int)forward_edge.data.weight != INVALID_EDGE_WEIGHT)
                 {
@@ -256,7 +309,9 @@ class GraphContractor
         util::SimpleLogger().Write() << "contractor finished initalization";
     }
 
-    void Run(double core_factor = 1.0)
+    // Contracts the nodes in rounds of independent node sets until only the core is left.
+    // Reports the statistics of every round to on_round if given.
+    void Run(double core_factor = 1.0, const RoundCallback &on_round = RoundCallback())
     {
         // for the preperation we can use a big grain size, which is much faster (probably cache)
         const constexpr size_t InitGrainSize = 100000;
@@ -268,6 +323,9 @@ class GraphContractor
         const constexpr size_t ContractGrainSize = 1;
         const constexpr size_t NeighboursGrainSize = 1;
         const constexpr size_t DeleteGrainSize = 1;
+        // stale priorities are evaluated lazily when a node is a candidate for an independent
+        // set, and for all nodes every few rounds to keep the order close to eager updates
+        const constexpr unsigned StalePriorityRefreshRounds = 4;
 
         const NodeID number_of_nodes = contractor_graph->GetNumberOfNodes();
         util::Percent p(number_of_nodes);
@@ -277,6 +335,9 @@ class GraphContractor
         NodeID number_of_contracted_nodes = 0;
         std::vector<NodeDepth> node_depth;
         std::vector<float> node_priorities;
+        // priorities of neighbours of contracted nodes are only evaluated again once they are
+        // candidates for an independent set
+        std::vector<std::uint8_t> is_stale_priority(number_of_nodes, 0);
         is_core_node.resize(number_of_nodes, false);
 
         std::vector<RemainingNodeData> remaining_nodes(number_of_nodes);
@@ -319,14 +380,45 @@ class GraphContractor
 
         std::cout << "preprocessing " << number_of_nodes << " nodes ..." << std::flush;
 
+        // only count the witness searches of the rounds, not of the initial priorities
+        for (auto &data : thread_data_list.data)
+        {
+            data->witness_searches = 0;
+        }
+
+        // evaluates the stale priorities of the remaining nodes selected by the filter
+        const auto refresh_stale_priorities = [&](const auto filter) {
+            tbb::parallel_for(
+                tbb::blocked_range<std::size_t>(0, remaining_nodes.size(), IndependentGrainSize),
+                [&](const tbb::blocked_range<std::size_t> &range) {
+                    ContractorThreadData *data = thread_data_list.GetThreadData();
+                    for (auto i = range.begin(), end = range.end(); i != end; ++i)
+                    {
+                        const NodeID node = remaining_nodes[i].id;
+                        if (is_stale_priority[node] && filter(remaining_nodes[i]))
+                        {
+                            node_priorities[node] =
+                                this->EvaluateNodePriority(data, node_depth[node], node);
+                            is_stale_priority[node] = 0;
+                        }
+                    }
+                });
+        };
+
         unsigned current_level = 0;
         bool flushed_contractor = false;
         while (number_of_nodes > 2 &&
                number_of_contracted_nodes < static_cast<NodeID>(number_of_nodes * core_factor))
         {
+            RoundStatistics statistics{};
+            statistics.round = current_level;
+            statistics.remaining_nodes = remaining_nodes.size();
+
+            TIMER_START(flush);
             if (!flushed_contractor && (number_of_contracted_nodes >
                                         static_cast<NodeID>(number_of_nodes * 0.65 * core_factor)))
             {
+                statistics.flushed = true;
                 util::DeallocatingVector<ContractorEdge>
                     new_edge_set; // this one is not explicitely
                                   // cleared since it goes out of
@@ -338,6 +430,7 @@ class GraphContractor
 
                 // Create new priority array
                 std::vector<float> new_node_priority(remaining_nodes.size());
+                std::vector<std::uint8_t> new_is_stale_priority(remaining_nodes.size());
                 std::vector<EdgeWeight> new_node_weights(remaining_nodes.size());
                 // this map gives the old IDs from the new ones, necessary to get a consistent graph
                 // at the end of contraction
@@ -352,6 +445,7 @@ class GraphContractor
                     auto &node = remaining_nodes[new_node_id];
                     BOOST_ASSERT(node_priorities.size() > node.id);
                     new_node_priority[new_node_id] = node_priorities[node.id];
+                    new_is_stale_priority[new_node_id] = is_stale_priority[node.id];
                     BOOST_ASSERT(node_weights.size() > node.id);
                     new_node_weights[new_node_id] = node_weights[node.id];
                 }
@@ -382,7 +476,7 @@ class GraphContractor
                         else
                         {
                             // node is not yet contracted.
-                            // add (renumbered) outgoing edges to new util::DynamicGraph.
+                            // add (renumbered) outgoing edges to the new graph.
                             ContractorEdge new_edge = {new_node_id_from_orig_id_map[source],
                                                        new_node_id_from_orig_id_map[target],
                                                        data};
@@ -408,6 +502,7 @@ class GraphContractor
                 // agree?
                 new_node_priority.clear();
                 new_node_priority.shrink_to_fit();
+                is_stale_priority.swap(new_is_stale_priority);
 
                 node_weights.swap(new_node_weights);
                 // old Graph is removed
@@ -425,6 +520,13 @@ class GraphContractor
                 // reinitialize heaps and ThreadData objects with appropriate size
                 thread_data_list.number_of_nodes = contractor_graph->GetNumberOfNodes();
             }
+            TIMER_STOP(flush);
+
+            TIMER_START(independent_set);
+            if (!use_cached_node_priorities && current_level % StalePriorityRefreshRounds == 0)
+            {
+                refresh_stale_priorities([](const RemainingNodeData &) { return true; });
+            }
 
             tbb::parallel_for(
                 tbb::blocked_range<std::size_t>(0, remaining_nodes.size(), IndependentGrainSize),
@@ -440,6 +542,30 @@ class GraphContractor
                     }
                 });
 
+            if (!use_cached_node_priorities)
+            {
+                // candidates with a stale priority are evaluated now. Only the candidates that are
+                // still local minima with the new priorities are contracted, so the set stays
+                // independent.
+                refresh_stale_priorities(
+                    [](const RemainingNodeData &node_data) { return node_data.is_independent; });
+                tbb::parallel_for(
+                    tbb::blocked_range<std::size_t>(
+                        0, remaining_nodes.size(), IndependentGrainSize),
+                    [this, &node_priorities, &remaining_nodes, &thread_data_list](
+                        const tbb::blocked_range<std::size_t> &range) {
+                        ContractorThreadData *data = thread_data_list.GetThreadData();
+                        for (auto i = range.begin(), end = range.end(); i != end; ++i)
+                        {
+                            if (remaining_nodes[i].is_independent)
+                            {
+                                remaining_nodes[i].is_independent = this->IsNodeIndependent(
+                                    node_priorities, data, remaining_nodes[i].id);
+                            }
+                        }
+                    });
+            }
+
             // sort all remaining nodes to the beginning of the sequence
             const auto begin_independent_nodes = stable_partition(
                 remaining_nodes.begin(), remaining_nodes.end(), [](RemainingNodeData node_data) {
@@ -448,7 +574,10 @@ class GraphContractor
             auto begin_independent_nodes_idx =
                 std::distance(remaining_nodes.begin(), begin_independent_nodes);
             auto end_independent_nodes_idx = remaining_nodes.size();
+            TIMER_STOP(independent_set);
+            statistics.independent_nodes = end_independent_nodes_idx - begin_independent_nodes_idx;
 
+            TIMER_START(contraction);
             if (!use_cached_node_priorities)
             {
                 // write out contraction level
@@ -492,7 +621,9 @@ class GraphContractor
                         this->ContractNode<false>(data, x);
                     }
                 });
+            TIMER_STOP(contraction);
 
+            TIMER_START(deletion);
             tbb::parallel_for(
                 tbb::blocked_range<int>(
                     begin_independent_nodes_idx, end_independent_nodes_idx, DeleteGrainSize),
@@ -505,8 +636,10 @@ class GraphContractor
                         this->DeleteIncomingEdges(data, x);
                     }
                 });
+            TIMER_STOP(deletion);
 
             // make sure we really sort each block
+            TIMER_START(insertion);
             tbb::parallel_for(
                 thread_data_list.data.range(),
                 [&](const ThreadDataContainer::EnumerableThreadData::range_type &range) {
@@ -518,6 +651,19 @@ class GraphContractor
             // insert new edges
             for (auto &data : thread_data_list.data)
             {
+                // make room for all new edges of a node at once, so its block moves at most once
+                const auto &inserted_edges = data->inserted_edges;
+                statistics.shortcuts += inserted_edges.size();
+                for (auto first = inserted_edges.begin(); first != inserted_edges.end();)
+                {
+                    const auto last =
+                        std::find_if(first, inserted_edges.end(), [&](const ContractorEdge &edge) {
+                            return edge.source != first->source;
+                        });
+                    contractor_graph->ReserveEdges(first->source, std::distance(first, last));
+                    first = last;
+                }
+
                 for (const ContractorEdge &edge : data->inserted_edges)
                 {
                     const EdgeID current_edge_ID =
@@ -539,30 +685,52 @@ class GraphContractor
                 }
                 data->inserted_edges.clear();
             }
+            contractor_graph->CompactIfFragmented();
+            TIMER_STOP(insertion);
 
+            TIMER_START(priority_update);
             if (!use_cached_node_priorities)
             {
                 tbb::parallel_for(
                     tbb::blocked_range<int>(begin_independent_nodes_idx,
                                             end_independent_nodes_idx,
                                             NeighboursGrainSize),
-                    [this, &node_priorities, &remaining_nodes, &node_depth, &thread_data_list](
+                    [this, &node_priorities, &is_stale_priority, &remaining_nodes, &node_depth](
                         const tbb::blocked_range<int> &range) {
-                        ContractorThreadData *data = thread_data_list.GetThreadData();
                         for (int position = range.begin(), end = range.end(); position != end;
                              ++position)
                         {
                             NodeID x = remaining_nodes[position].id;
-                            this->UpdateNodeNeighbours(node_priorities, node_depth, data, x);
+                            this->UpdateNodeNeighbours(
+                                node_priorities, is_stale_priority, node_depth, x);
                         }
                     });
             }
+            TIMER_STOP(priority_update);
 
             // remove contracted nodes from the pool
             number_of_contracted_nodes += end_independent_nodes_idx - begin_independent_nodes_idx;
             remaining_nodes.resize(begin_independent_nodes_idx);
 
             p.PrintStatus(number_of_contracted_nodes);
+
+            if (on_round)
+            {
+                for (auto &data : thread_data_list.data)
+                {
+                    statistics.witness_searches += data->witness_searches;
+                    data->witness_searches = 0;
+                }
+                statistics.edges = contractor_graph->GetNumberOfEdges();
+                statistics.max_resident_bytes = util::getMaxResidentBytes();
+                statistics.flush_ms = TIMER_MSEC(flush);
+                statistics.independent_set_ms = TIMER_MSEC(independent_set);
+                statistics.contraction_ms = TIMER_MSEC(contraction);
+                statistics.deletion_ms = TIMER_MSEC(deletion);
+                statistics.insertion_ms = TIMER_MSEC(insertion);
+                statistics.priority_update_ms = TIMER_MSEC(priority_update);
+                on_round(statistics);
+            }
             ++current_level;
         }
 
@@ -616,51 +784,62 @@ class GraphContractor
         out_node_levels.swap(node_levels);
     }
 
-    template <class Edge> inline void GetEdges(util::DeallocatingVector<Edge> &edges)
+    // Moves the edges into external memory next to the ones of contracted nodes
+    inline void GetEdges(stxxl::vector<QueryEdge> &edges)
     {
         util::Percent p(contractor_graph->GetNumberOfNodes());
         util::SimpleLogger().Write() << "Getting edges of minimized graph";
         const NodeID number_of_nodes = contractor_graph->GetNumberOfNodes();
         if (contractor_graph->GetNumberOfNodes())
         {
-            Edge new_edge;
-            for (const auto node : util::irange(0u, number_of_nodes))
+            // The edges of ranges of nodes are converted in parallel into buffers of their own.
+            // Writing to the external vector is serial and in the order of the nodes, which
+            // makes the order of the edges independent of the number of threads.
+            struct EdgeChunk
             {
-                p.PrintStatus(node);
-                for (auto edge : contractor_graph->GetAdjacentEdgeRange(node))
-                {
-                    const NodeID target = contractor_graph->GetTarget(edge);
-                    const ContractorGraph::EdgeData &data = contractor_graph->GetEdgeData(edge);
-                    if (!orig_node_id_from_new_node_id_map.empty())
-                    {
-                        new_edge.source = orig_node_id_from_new_node_id_map[node];
-                        new_edge.target = orig_node_id_from_new_node_id_map[target];
-                    }
-                    else
-                    {
-                        new_edge.source = node;
-                        new_edge.target = target;
-                    }
-                    BOOST_ASSERT_MSG(SPECIAL_NODEID != new_edge.source, "Source id invalid");
-                    BOOST_ASSERT_MSG(SPECIAL_NODEID != new_edge.target, "Target id invalid");
-                    new_edge.data.weight = data.weight;
-                    new_edge.data.shortcut = data.shortcut;
-                    if (!data.is_original_via_node_ID && !orig_node_id_from_new_node_id_map.empty())
-                    {
-                        // tranlate the _node id_ of the shortcutted node
-                        new_edge.data.id = orig_node_id_from_new_node_id_map[data.id];
-                    }
-                    else
-                    {
-                        new_edge.data.id = data.id;
-                    }
-                    BOOST_ASSERT_MSG(new_edge.data.id != INT_MAX, // 2^31
-                                     "edge id invalid");
-                    new_edge.data.forward = data.forward;
-                    new_edge.data.backward = data.backward;
-                    edges.push_back(new_edge);
-                }
-            }
+                NodeID begin;
+                NodeID end;
+                std::vector<QueryEdge> edges;
+            };
+            const constexpr NodeID EDGE_CHUNK_SIZE = 4096;
+
+            NodeID next_chunk_begin = 0;
+            tbb::parallel_pipeline(
+                2 * tbb::task_scheduler_init::default_num_threads(),
+                tbb::make_filter<void, std::shared_ptr<EdgeChunk>>(
+                    tbb::filter::serial_in_order,
+                    [&](tbb::flow_control &control) -> std::shared_ptr<EdgeChunk> {
+                        if (next_chunk_begin >= number_of_nodes)
+                        {
+                            control.stop();
+                            return nullptr;
+                        }
+                        auto chunk = std::make_shared<EdgeChunk>();
+                        chunk->begin = next_chunk_begin;
+                        chunk->end = std::min(number_of_nodes, next_chunk_begin + EDGE_CHUNK_SIZE);
+                        next_chunk_begin = chunk->end;
+                        return chunk;
+                    }) &
+                    tbb::make_filter<std::shared_ptr<EdgeChunk>, std::shared_ptr<EdgeChunk>>(
+                        tbb::filter::parallel,
+                        [&](std::shared_ptr<EdgeChunk> chunk) {
+                            for (const auto node : util::irange(chunk->begin, chunk->end))
+                            {
+                                for (auto edge : contractor_graph->GetAdjacentEdgeRange(node))
+                                {
+                                    chunk->edges.push_back(GetQueryEdge(node, edge));
+                                }
+                            }
+                            return chunk;
+                        }) &
+                    tbb::make_filter<std::shared_ptr<EdgeChunk>, void>(
+                        tbb::filter::serial_in_order, [&](std::shared_ptr<EdgeChunk> chunk) {
+                            p.PrintStatus(chunk->end - 1);
+                            for (const auto &edge : chunk->edges)
+                            {
+                                external_edge_list.push_back(edge);
+                            }
+                        }));
         }
         contractor_graph.reset();
         orig_node_id_from_new_node_id_map.clear();
@@ -668,11 +847,48 @@ class GraphContractor
 
         BOOST_ASSERT(0 == orig_node_id_from_new_node_id_map.capacity());
 
-        edges.append(external_edge_list.begin(), external_edge_list.end());
+        edges.swap(external_edge_list);
         external_edge_list.clear();
     }
 
   private:
+    // Edge of the hierarchy with the ids of the nodes before they were renumbered
+    QueryEdge GetQueryEdge(const NodeID node, const EdgeID edge) const
+    {
+        QueryEdge new_edge;
+        const NodeID target = contractor_graph->GetTarget(edge);
+        const ContractorGraph::EdgeData &data = contractor_graph->GetEdgeData(edge);
+        if (!orig_node_id_from_new_node_id_map.empty())
+        {
+            new_edge.source = orig_node_id_from_new_node_id_map[node];
+            new_edge.target = orig_node_id_from_new_node_id_map[target];
+        }
+        else
+        {
+            new_edge.source = node;
+            new_edge.target = target;
+        }
+        BOOST_ASSERT_MSG(SPECIAL_NODEID != new_edge.source, "Source id invalid");
+        BOOST_ASSERT_MSG(SPECIAL_NODEID != new_edge.target, "Target id invalid");
+        new_edge.data.weight = data.weight;
+        new_edge.data.distance = data.distance;
+        new_edge.data.shortcut = data.shortcut;
+        if (!data.is_original_via_node_ID && !orig_node_id_from_new_node_id_map.empty())
+        {
+            // tranlate the _node id_ of the shortcutted node
+            new_edge.data.id = orig_node_id_from_new_node_id_map[data.id];
+        }
+        else
+        {
+            new_edge.data.id = data.id;
+        }
+        BOOST_ASSERT_MSG(new_edge.data.id != INT_MAX, // 2^31
+                         "edge id invalid");
+        new_edge.data.forward = data.forward;
+        new_edge.data.backward = data.backward;
+        return new_edge;
+    }
+
     inline void RelaxNode(const NodeID node,
                           const NodeID forbidden_node,
                           const int weight,
@@ -784,6 +1000,20 @@ class GraphContractor
         const constexpr bool REVERSE_DIRECTION_ENABLED = true;
         const constexpr bool REVERSE_DIRECTION_DISABLED = false;
 
+        // the targets are the same for the searches from every source, collect them only once
+        std::vector<WitnessTarget> &targets = data->targets;
+        targets.clear();
+        for (auto out_edge : contractor_graph->GetAdjacentEdgeRange(node))
+        {
+            const ContractorEdgeData &out_data = contractor_graph->GetEdgeData(out_edge);
+            const NodeID target = contractor_graph->GetTarget(out_edge);
+            if (out_data.forward && target != node)
+            {
+                targets.push_back(
+                    {target, out_data.weight, out_data.distance, out_data.originalEdges});
+            }
+        }
+
         for (auto in_edge : contractor_graph->GetAdjacentEdgeRange(node))
         {
             const ContractorEdgeData &in_data = contractor_graph->GetEdgeData(in_edge);
@@ -807,18 +1037,10 @@ class GraphContractor
             int max_weight = 0;
             unsigned number_of_targets = 0;
 
-            for (auto out_edge : contractor_graph->GetAdjacentEdgeRange(node))
+            for (const auto &out : targets)
             {
-                const ContractorEdgeData &out_data = contractor_graph->GetEdgeData(out_edge);
-                if (!out_data.forward)
-                {
-                    continue;
-                }
-                const NodeID target = contractor_graph->GetTarget(out_edge);
-                if (node == target)
-                    continue;
-
-                const EdgeWeight path_weight = in_data.weight + out_data.weight;
+                const NodeID target = out.target;
+                const EdgeWeight path_weight = in_data.weight + out.weight;
                 if (target == source)
                 {
                     if (path_weight < node_weights[node])
@@ -834,7 +1056,7 @@ class GraphContractor
                             BOOST_ASSERT(stats != nullptr);
                             stats->edges_added_count += 2;
                             stats->original_edges_added_count +=
-                                2 * (out_data.originalEdges + in_data.originalEdges);
+                                2 * (out.original_edges + in_data.originalEdges);
                         }
                         else
                         {
@@ -845,8 +1067,8 @@ class GraphContractor
                             inserted_edges.emplace_back(source,
                                                         target,
                                                         path_weight,
-                                                        out_data.originalEdges +
-                                                            in_data.originalEdges,
+                                                        in_data.distance + out.distance,
+                                                        out.original_edges + in_data.originalEdges,
                                                         node,
                                                         SHORTCUT_ARC,
                                                         FORWARD_DIRECTION_ENABLED,
@@ -855,8 +1077,8 @@ class GraphContractor
                             inserted_edges.emplace_back(target,
                                                         source,
                                                         path_weight,
-                                                        out_data.originalEdges +
-                                                            in_data.originalEdges,
+                                                        in_data.distance + out.distance,
+                                                        out.original_edges + in_data.originalEdges,
                                                         node,
                                                         SHORTCUT_ARC,
                                                         FORWARD_DIRECTION_DISABLED,
@@ -873,6 +1095,13 @@ class GraphContractor
                 }
             }
 
+            // a source whose only target is itself needs no witness search
+            if (0 == number_of_targets)
+            {
+                continue;
+            }
+
+            ++data->witness_searches;
             if (RUNSIMULATION)
             {
                 const int constexpr SIMULATION_SEARCH_SPACE_SIZE = 1000;
@@ -883,17 +1112,12 @@ class GraphContractor
                 const int constexpr FULL_SEARCH_SPACE_SIZE = 2000;
                 Dijkstra(max_weight, number_of_targets, FULL_SEARCH_SPACE_SIZE, *data, node);
             }
-            for (auto out_edge : contractor_graph->GetAdjacentEdgeRange(node))
+            for (const auto &out : targets)
             {
-                const ContractorEdgeData &out_data = contractor_graph->GetEdgeData(out_edge);
-                if (!out_data.forward)
-                {
-                    continue;
-                }
-                const NodeID target = contractor_graph->GetTarget(out_edge);
-                if (target == node)
+                const NodeID target = out.target;
+                if (target == source)
                     continue;
-                const int path_weight = in_data.weight + out_data.weight;
+                const int path_weight = in_data.weight + out.weight;
                 const int weight = heap.GetKey(target);
                 if (path_weight < weight)
                 {
@@ -902,14 +1126,15 @@ class GraphContractor
                         BOOST_ASSERT(stats != nullptr);
                         stats->edges_added_count += 2;
                         stats->original_edges_added_count +=
-                            2 * (out_data.originalEdges + in_data.originalEdges);
+                            2 * (out.original_edges + in_data.originalEdges);
                     }
                     else
                     {
                         inserted_edges.emplace_back(source,
                                                     target,
                                                     path_weight,
-                                                    out_data.originalEdges + in_data.originalEdges,
+                                                    in_data.distance + out.distance,
+                                                    out.original_edges + in_data.originalEdges,
                                                     node,
                                                     SHORTCUT_ARC,
                                                     FORWARD_DIRECTION_ENABLED,
@@ -918,7 +1143,8 @@ class GraphContractor
                         inserted_edges.emplace_back(target,
                                                     source,
                                                     path_weight,
-                                                    out_data.originalEdges + in_data.originalEdges,
+                                                    in_data.distance + out.distance,
+                                                    out.original_edges + in_data.originalEdges,
                                                     node,
                                                     SHORTCUT_ARC,
                                                     FORWARD_DIRECTION_DISABLED,
@@ -945,7 +1171,8 @@ class GraphContractor
                     {
                         continue;
                     }
-                    if (inserted_edges[other].data.weight != inserted_edges[i].data.weight)
+                    if (inserted_edges[other].data.weight != inserted_edges[i].data.weight ||
+                        inserted_edges[other].data.distance != inserted_edges[i].data.distance)
                     {
                         continue;
                     }
@@ -992,15 +1219,15 @@ class GraphContractor
         }
     }
 
+    // The neighbours of a contracted node get deeper and their priorities stale. The depth is a
+    // linear term of the priority and is added right away, the simulated contraction is only
+    // repeated once they are a candidate for an independent set. Independent nodes have no
+    // common neighbours, contracted nodes can be handled in parallel.
     inline bool UpdateNodeNeighbours(std::vector<float> &priorities,
+                                     std::vector<std::uint8_t> &is_stale_priority,
                                      std::vector<NodeDepth> &node_depth,
-                                     ContractorThreadData *const data,
                                      const NodeID node)
     {
-        std::vector<NodeID> &neighbours = data->neighbours;
-        neighbours.clear();
-
-        // find all neighbours
         for (auto e : contractor_graph->GetAdjacentEdgeRange(node))
         {
             const NodeID u = contractor_graph->GetTarget(e);
@@ -1008,17 +1235,10 @@ class GraphContractor
             {
                 continue;
             }
-            neighbours.push_back(u);
-            node_depth[u] = std::max(node_depth[node] + 1, node_depth[u]);
-        }
-        // eliminate duplicate entries ( forward + backward edges )
-        std::sort(neighbours.begin(), neighbours.end());
-        neighbours.resize(std::unique(neighbours.begin(), neighbours.end()) - neighbours.begin());
-
-        // re-evaluate priorities of neighboring nodes
-        for (const NodeID u : neighbours)
-        {
-            priorities[u] = EvaluateNodePriority(data, node_depth[u], u);
+            const NodeDepth depth = std::max(node_depth[node] + 1, node_depth[u]);
+            priorities[u] += depth - node_depth[u];
+            node_depth[u] = depth;
+            is_stale_priority[u] = 1;
         }
         return true;
     }
@@ -0,0 +1,18 @@
+#ifndef OSRM_CONTRACTOR_MULTI_LEVEL_CUSTOMIZER_HPP
+#define OSRM_CONTRACTOR_MULTI_LEVEL_CUSTOMIZER_HPP
+
+#include "util/multi_level_graph.hpp"
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Computes the cliques of all cells from the weights of the arcs, level by level from the lowest.
+// A clique is found by a search from every boundary node of the cell on the overlay of the level
+// below, the cells of a level are customized in parallel.
+void customizeMultiLevelGraph(util::MultiLevelGraph &graph);
+}
+}
+
+#endif // OSRM_CONTRACTOR_MULTI_LEVEL_CUSTOMIZER_HPP
@@ -16,7 +16,10 @@ struct QueryEdge
     NodeID target;
     struct EdgeData
     {
-        EdgeData() : id(0), shortcut(false), weight(0), forward(false), backward(false) {}
+        EdgeData()
+            : id(0), shortcut(false), weight(0), forward(false), backward(false), distance(0)
+        {
+        }
 
         template <class OtherT> EdgeData(const OtherT &other)
         {
@@ -25,12 +28,15 @@ struct QueryEdge
             id = other.id;
             forward = other.forward;
             backward = other.backward;
+            distance = other.distance;
         }
         NodeID id : 31;
         bool shortcut : 1;
         int weight : 30;
         bool forward : 1;
         bool backward : 1;
+        // length of the path in decimeters, summed up like the weight
+        EdgeDistance distance;
     } data;
 
     QueryEdge() : source(SPECIAL_NODEID), target(SPECIAL_NODEID) {}
@@ -50,7 +56,7 @@ struct QueryEdge
         return (source == right.source && target == right.target &&
                 data.weight == right.data.weight && data.shortcut == right.data.shortcut &&
                 data.forward == right.data.forward && data.backward == right.data.backward &&
-                data.id == right.data.id);
+                data.id == right.data.id && data.distance == right.data.distance);
     }
 };
 }
@@ -5,8 +5,11 @@
 #include "engine/datafacade/datafacade_base.hpp"
 
 #include "engine/api/json_factory.hpp"
+#include "engine/api/pbf_factory.hpp"
 #include "engine/hint.hpp"
 
+#include "util/allocation_statistics.hpp"
+
 #include <boost/assert.hpp>
 #include <boost/range/algorithm/transform.hpp>
 
@@ -44,15 +47,48 @@ class BaseAPI
         return waypoints;
     }
 
+    void WriteWaypoints(protozero::pbf_writer &response_writer,
+                        const std::vector<PhantomNodes> &segment_end_coordinates) const
+    {
+        BOOST_ASSERT(parameters.coordinates.size() > 0);
+        BOOST_ASSERT(parameters.coordinates.size() == segment_end_coordinates.size() + 1);
+
+        WriteWaypoint(response_writer,
+                      pbf::tag::RESPONSE_WAYPOINTS,
+                      segment_end_coordinates.front().source_phantom);
+        for (const auto &phantom_pair : segment_end_coordinates)
+        {
+            WriteWaypoint(
+                response_writer, pbf::tag::RESPONSE_WAYPOINTS, phantom_pair.target_phantom);
+        }
+    }
+
     // FIXME gcc 4.8 doesn't support for lambdas to call protected member functions
     //  protected:
     util::json::Object MakeWaypoint(const PhantomNode &phantom) const
     {
+        if (!parameters.generate_hints)
+        {
+            return json::makeWaypoint(phantom.location,
+                                      std::string(facade.GetNameForID(phantom.name_id)));
+        }
         return json::makeWaypoint(phantom.location,
-                                  facade.GetNameForID(phantom.name_id),
+                                  std::string(facade.GetNameForID(phantom.name_id)),
                                   Hint{phantom, facade.GetCheckSum()});
     }
 
+    void WriteWaypoint(protozero::pbf_writer &parent,
+                       const protozero::pbf_tag_type field,
+                       const PhantomNode &phantom) const
+    {
+        const Hint hint{phantom, facade.GetCheckSum()};
+        pbf::writeWaypoint(parent,
+                           field,
+                           phantom.location,
+                           std::string(facade.GetNameForID(phantom.name_id)),
+                           parameters.generate_hints ? &hint : nullptr);
+    }
+
     const datafacade::BaseDataFacade &facade;
     const BaseParameters &parameters;
 };
@@ -28,6 +28,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef ENGINE_API_BASE_PARAMETERS_HPP
 #define ENGINE_API_BASE_PARAMETERS_HPP
 
+#include "extractor/class_data.hpp"
 #include "engine/bearing.hpp"
 #include "engine/hint.hpp"
 #include "util/coordinate.hpp"
@@ -35,6 +36,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/optional.hpp>
 
 #include <algorithm>
+#include <string>
 #include <vector>
 
 namespace osrm
@@ -44,6 +46,15 @@ namespace engine
 namespace api
 {
 
+// Encoding of the response: JSON, a compact protobuf message or the bare matrices of a table,
+// see docs/http.md
+enum class OutputFormatType
+{
+    JSON,
+    PBF,
+    Binary
+};
+
 /**
  * General parameters for OSRM service queries.
  *
@@ -55,6 +66,7 @@ namespace api
  *              optional per coordinate
  *  - bearings: limits the search for segments in the road network to given bearing(s) in degree
  *              towards true north in clockwise direction, optional per coordinate
+ *  - generate_hints: adds the hint of every waypoint to the response, true by default
  *
  * \see OSRM, Coordinate, Hint, Bearing, RouteParame, RouteParameters, TableParameters,
  *      NearestParameters, TripParameters, MatchParameters and TileParameters
@@ -65,6 +77,13 @@ struct BaseParameters
     std::vector<boost::optional<Hint>> hints;
     std::vector<boost::optional<double>> radiuses;
     std::vector<boost::optional<Bearing>> bearings;
+    bool generate_hints = true;
+    // metric written by osrm-contract --metric, empty for the default metric of the dataset
+    std::string metric;
+    // classes of the profile to avoid, selects the metric written by osrm-contract --exclude
+    std::vector<std::string> exclude;
+    // selects a dataset of EngineConfig::profiles, the default dataset for other profiles
+    std::string profile;
 
     // FIXME add validation for invalid bearing values
     bool IsValid() const
@@ -72,6 +91,7 @@ struct BaseParameters
         return (hints.empty() || hints.size() == coordinates.size()) &&
                (bearings.empty() || bearings.size() == coordinates.size()) &&
                (radiuses.empty() || radiuses.size() == coordinates.size()) &&
+               (exclude.empty() || (metric.empty() && extractor::getClasses(exclude) != 0)) &&
                std::all_of(bearings.begin(),
                            bearings.end(),
                            [](const boost::optional<Bearing> bearing_and_range) {
@@ -0,0 +1,50 @@
+#ifndef ENGINE_API_BINARY_FACTORY_HPP
+#define ENGINE_API_BINARY_FACTORY_HPP
+
+#include "util/typedefs.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+namespace binary
+{
+
+// A binary table is a header of 32 bit words followed by the matrices of the header, row by row.
+// All words and values are little-endian, see docs/http.md.
+const constexpr char TABLE_MAGIC[4] = {'O', 'S', 'R', 'M'};
+const constexpr std::uint32_t TABLE_VERSION = 1;
+const constexpr std::size_t TABLE_HEADER_SIZE = 6 * sizeof(std::uint32_t);
+
+enum class TableValueType : std::uint32_t
+{
+    // seconds and meters, NaN without a route
+    Float32 = 0,
+    // tenth of seconds and decimeters as computed, -1 without a route
+    Int32 = 1
+};
+
+// Bits of the header word that lists the matrices
+const constexpr std::uint32_t TABLE_DURATIONS = 0x01;
+const constexpr std::uint32_t TABLE_DISTANCES = 0x02;
+
+// Writes the header and the matrices that are not nullptr into the buffer
+void writeTables(std::string &buffer,
+                 const TableValueType value_type,
+                 const std::size_t number_of_rows,
+                 const std::size_t number_of_columns,
+                 const std::vector<EdgeWeight> *durations,
+                 const std::vector<EdgeDistance> *distances);
+}
+}
+}
+}
+
+#endif // ENGINE_API_BINARY_FACTORY_HPP
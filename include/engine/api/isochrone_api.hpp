@@ -0,0 +1,71 @@
+#ifndef ENGINE_API_ISOCHRONE_API_HPP
+#define ENGINE_API_ISOCHRONE_API_HPP
+
+#include "engine/api/base_api.hpp"
+#include "engine/api/isochrone_parameters.hpp"
+#include "engine/api/json_factory.hpp"
+#include "engine/phantom_node.hpp"
+
+#include "util/coordinate.hpp"
+
+#include <boost/assert.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+
+class IsochroneAPI final : public BaseAPI
+{
+  public:
+    // reachable part of a road segment, from the first to the second coordinate
+    using Segment = std::pair<util::Coordinate, util::Coordinate>;
+
+    IsochroneAPI(const datafacade::BaseDataFacade &facade_,
+                 const IsochroneParameters &parameters_)
+        : BaseAPI(facade_, parameters_), parameters(parameters_)
+    {
+    }
+
+    void MakeResponse(const PhantomNode &phantom_node,
+                      const std::vector<Segment> &segments,
+                      util::json::Object &response) const
+    {
+        util::AllocationPhaseScope allocation_phase(util::AllocationPhase::JSON);
+        BOOST_ASSERT(parameters.coordinates.size() == 1);
+
+        util::json::Array waypoints;
+        waypoints.values.push_back(MakeWaypoint(phantom_node));
+
+        util::json::Array lines;
+        lines.values.reserve(segments.size());
+        for (const auto &segment : segments)
+        {
+            util::json::Array line;
+            line.values.push_back(json::detail::coordinateToLonLat(segment.first));
+            line.values.push_back(json::detail::coordinateToLonLat(segment.second));
+            lines.values.push_back(std::move(line));
+        }
+
+        util::json::Object geometry;
+        geometry.values["type"] = "MultiLineString";
+        geometry.values["coordinates"] = std::move(lines);
+
+        response.values["code"] = "Ok";
+        response.values["waypoints"] = std::move(waypoints);
+        response.values["segments"] = std::move(geometry);
+    }
+
+    const IsochroneParameters &parameters;
+};
+
+} // ns api
+} // ns engine
+} // ns osrm
+
+#endif
@@ -81,6 +81,8 @@ util::json::Object makeRoute(const guidance::Route &route,
                              util::json::Array legs,
                              boost::optional<util::json::Value> geometry);
 
+util::json::Object makeWaypoint(const util::Coordinate location, std::string name);
+
 util::json::Object
 makeWaypoint(const util::Coordinate location, std::string name, const Hint &hint);
 
@@ -30,6 +30,18 @@ class MatchAPI final : public RouteAPI
                       const std::vector<InternalRouteResult> &sub_routes,
                       util::json::Object &response) const
     {
+        MakeResponse(sub_matchings, sub_routes, 0, parameters.coordinates.size(), response);
+    }
+
+    // Responds with the tracepoints of the trace positions [first_tracepoint, first_tracepoint +
+    // number_of_tracepoints), the sub matchings of a session index the whole trace
+    void MakeResponse(const std::vector<map_matching::SubMatching> &sub_matchings,
+                      const std::vector<InternalRouteResult> &sub_routes,
+                      const std::size_t first_tracepoint,
+                      const std::size_t number_of_tracepoints,
+                      util::json::Object &response) const
+    {
+        util::AllocationPhaseScope allocation_phase(util::AllocationPhase::JSON);
         auto number_of_routes = sub_matchings.size();
         util::json::Array routes;
         routes.values.reserve(number_of_routes);
@@ -43,7 +55,8 @@ class MatchAPI final : public RouteAPI
             route.values["confidence"] = sub_matchings[index].confidence;
             routes.values.push_back(std::move(route));
         }
-        response.values["tracepoints"] = MakeTracepoints(sub_matchings);
+        response.values["tracepoints"] =
+            MakeTracepoints(sub_matchings, first_tracepoint, number_of_tracepoints);
         response.values["matchings"] = std::move(routes);
         response.values["code"] = "Ok";
     }
@@ -56,9 +69,16 @@ class MatchAPI final : public RouteAPI
     // routing algorithm to be easier to consume here.
     util::json::Array
     MakeTracepoints(const std::vector<map_matching::SubMatching> &sub_matchings) const
+    {
+        return MakeTracepoints(sub_matchings, 0, parameters.coordinates.size());
+    }
+
+    util::json::Array MakeTracepoints(const std::vector<map_matching::SubMatching> &sub_matchings,
+                                      const std::size_t first_tracepoint,
+                                      const std::size_t number_of_tracepoints) const
     {
         util::json::Array waypoints;
-        waypoints.values.reserve(parameters.coordinates.size());
+        waypoints.values.reserve(number_of_tracepoints);
 
         struct MatchingIndex
         {
@@ -78,19 +98,27 @@ class MatchAPI final : public RouteAPI
             }
         };
 
-        std::vector<MatchingIndex> trace_idx_to_matching_idx(parameters.coordinates.size());
+        std::vector<MatchingIndex> trace_idx_to_matching_idx(number_of_tracepoints);
         for (auto sub_matching_index :
              util::irange(0u, static_cast<unsigned>(sub_matchings.size())))
         {
             for (auto point_index : util::irange(
                      0u, static_cast<unsigned>(sub_matchings[sub_matching_index].indices.size())))
             {
-                trace_idx_to_matching_idx[sub_matchings[sub_matching_index].indices[point_index]] =
+                const auto trace_index = sub_matchings[sub_matching_index].indices[point_index];
+                // the first point of a sub matching of a session may be the last of the response
+                // before
+                if (trace_index < first_tracepoint ||
+                    trace_index >= first_tracepoint + number_of_tracepoints)
+                {
+                    continue;
+                }
+                trace_idx_to_matching_idx[trace_index - first_tracepoint] =
                     MatchingIndex{sub_matching_index, point_index};
             }
         }
 
-        for (auto trace_index : util::irange<std::size_t>(0UL, parameters.coordinates.size()))
+        for (auto trace_index : util::irange<std::size_t>(0UL, number_of_tracepoints))
         {
             auto matching_index = trace_idx_to_matching_idx[trace_index];
             if (matching_index.NotMatched())
@@ -0,0 +1,92 @@
+#ifndef ENGINE_API_PBF_FACTORY_HPP
+#define ENGINE_API_PBF_FACTORY_HPP
+
+#include "engine/guidance/route.hpp"
+#include "engine/guidance/route_leg.hpp"
+#include "util/coordinate.hpp"
+#include "util/typedefs.hpp"
+
+#include <protozero/pbf_writer.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+struct Hint;
+
+namespace api
+{
+namespace pbf
+{
+
+// Field numbers of the protobuf response, the full schema is documented in docs/http.md
+namespace tag
+{
+const constexpr protozero::pbf_tag_type RESPONSE_CODE = 1;
+const constexpr protozero::pbf_tag_type RESPONSE_MESSAGE = 2;
+const constexpr protozero::pbf_tag_type RESPONSE_WAYPOINTS = 3;
+const constexpr protozero::pbf_tag_type RESPONSE_ROUTES = 4;
+const constexpr protozero::pbf_tag_type RESPONSE_SOURCES = 5;
+const constexpr protozero::pbf_tag_type RESPONSE_DESTINATIONS = 6;
+const constexpr protozero::pbf_tag_type RESPONSE_DURATIONS = 7;
+const constexpr protozero::pbf_tag_type RESPONSE_COLUMNS = 8;
+const constexpr protozero::pbf_tag_type RESPONSE_DISTANCES = 9;
+
+const constexpr protozero::pbf_tag_type WAYPOINT_NAME = 1;
+const constexpr protozero::pbf_tag_type WAYPOINT_LONGITUDE = 2;
+const constexpr protozero::pbf_tag_type WAYPOINT_LATITUDE = 3;
+const constexpr protozero::pbf_tag_type WAYPOINT_HINT = 4;
+
+const constexpr protozero::pbf_tag_type ROUTE_DISTANCE = 1;
+const constexpr protozero::pbf_tag_type ROUTE_DURATION = 2;
+const constexpr protozero::pbf_tag_type ROUTE_GEOMETRY = 3;
+const constexpr protozero::pbf_tag_type ROUTE_LEGS = 4;
+
+const constexpr protozero::pbf_tag_type LEG_DISTANCE = 1;
+const constexpr protozero::pbf_tag_type LEG_DURATION = 2;
+const constexpr protozero::pbf_tag_type LEG_SUMMARY = 3;
+}
+
+// Encoded duration and distance for table entries without a route
+const constexpr std::int32_t NO_DURATION = -1;
+const constexpr std::int32_t NO_DISTANCE = -1;
+
+void writeError(std::string &buffer, const std::string &code, const std::string &message);
+
+// Reads the code and the message of a response, false if the buffer is no protobuf response
+bool readError(const std::string &buffer, std::string &code, std::string &message);
+
+// The hint is left out without one
+void writeWaypoint(protozero::pbf_writer &parent,
+                   const protozero::pbf_tag_type field,
+                   const util::Coordinate location,
+                   const std::string &name,
+                   const Hint *hint);
+
+// Coordinates are written as zigzag encoded deltas in 1e-6 degrees, longitude first
+void writeGeometry(protozero::pbf_writer &route_writer,
+                   const std::vector<util::Coordinate> &coordinates);
+
+void writeRouteLeg(protozero::pbf_writer &route_writer, const guidance::RouteLeg &leg);
+
+void writeRouteSummary(protozero::pbf_writer &route_writer, const guidance::Route &route);
+
+// Durations are written row by row in tenth of seconds
+void writeDurations(protozero::pbf_writer &response_writer,
+                    const std::vector<EdgeWeight> &durations);
+
+// Distances are written row by row in decimeters
+void writeDistances(protozero::pbf_writer &response_writer,
+                    const std::vector<EdgeDistance> &distances);
+}
+}
+} // namespace engine
+} // namespace osrm
+
+#endif // ENGINE_API_PBF_FACTORY_HPP
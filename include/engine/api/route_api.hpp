@@ -3,6 +3,7 @@
 
 #include "engine/api/base_api.hpp"
 #include "engine/api/json_factory.hpp"
+#include "engine/api/pbf_factory.hpp"
 #include "engine/api/route_parameters.hpp"
 
 #include "engine/datafacade/datafacade_base.hpp"
@@ -17,10 +18,15 @@
 
 #include "engine/internal_route_result.hpp"
 
+#include "util/allocation_statistics.hpp"
 #include "util/coordinate.hpp"
 #include "util/integer_range.hpp"
 
+#include <tbb/parallel_for.h>
+
+#include <cstddef>
 #include <iterator>
+#include <string>
 #include <vector>
 
 namespace osrm
@@ -30,6 +36,56 @@ namespace engine
 namespace api
 {
 
+namespace detail
+{
+// Encodes coordinates in one of the geometry formats of the response
+template <RouteParameters::GeometriesType> struct GeometryEncoder;
+
+template <> struct GeometryEncoder<RouteParameters::GeometriesType::Polyline>
+{
+    template <typename ForwardIter>
+    static util::json::Value Encode(ForwardIter begin, ForwardIter end)
+    {
+        return json::makePolyline<100000>(begin, end);
+    }
+};
+
+template <> struct GeometryEncoder<RouteParameters::GeometriesType::Polyline6>
+{
+    template <typename ForwardIter>
+    static util::json::Value Encode(ForwardIter begin, ForwardIter end)
+    {
+        return json::makePolyline<1000000>(begin, end);
+    }
+};
+
+template <> struct GeometryEncoder<RouteParameters::GeometriesType::GeoJSON>
+{
+    template <typename ForwardIter>
+    static util::json::Value Encode(ForwardIter begin, ForwardIter end)
+    {
+        return json::makeGeoJSONGeometry(begin, end);
+    }
+};
+
+// Calls the function with the encoder of the geometry format, which is selected once per
+// response instead of once per geometry
+template <typename Function>
+auto withGeometryEncoder(const RouteParameters::GeometriesType geometries, Function &&function)
+{
+    switch (geometries)
+    {
+    case RouteParameters::GeometriesType::Polyline:
+        return function(GeometryEncoder<RouteParameters::GeometriesType::Polyline>{});
+    case RouteParameters::GeometriesType::Polyline6:
+        return function(GeometryEncoder<RouteParameters::GeometriesType::Polyline6>{});
+    default:
+        BOOST_ASSERT(geometries == RouteParameters::GeometriesType::GeoJSON);
+        return function(GeometryEncoder<RouteParameters::GeometriesType::GeoJSON>{});
+    }
+}
+}
+
 class RouteAPI : public BaseAPI
 {
   public:
@@ -40,6 +96,7 @@ class RouteAPI : public BaseAPI
 
     void MakeResponse(const InternalRouteResult &raw_route, util::json::Object &response) const
     {
+        util::AllocationPhaseScope allocation_phase(util::AllocationPhase::JSON);
         auto number_of_routes = raw_route.has_alternative() ? 2UL : 1UL;
         util::json::Array routes;
         routes.values.resize(number_of_routes);
@@ -66,18 +123,90 @@ class RouteAPI : public BaseAPI
     template <typename ForwardIter>
     util::json::Value MakeGeometry(ForwardIter begin, ForwardIter end) const
     {
-        if (parameters.geometries == RouteParameters::GeometriesType::Polyline)
+        return detail::withGeometryEncoder(parameters.geometries, [begin, end](auto encoder) {
+            return decltype(encoder)::Encode(begin, end);
+        });
+    }
+
+    // The geometries of all steps of all legs, in the order of makeRouteLegs
+    template <typename Encoder>
+    std::vector<util::json::Value>
+    MakeStepGeometries(const std::vector<guidance::RouteLeg> &legs,
+                       const std::vector<guidance::LegGeometry> &leg_geometries) const
+    {
+        std::size_t number_of_steps = 0;
+        for (const auto &leg : legs)
         {
-            return json::makePolyline<100000>(begin, end);
+            number_of_steps += leg.steps.size();
         }
 
-        if (parameters.geometries == RouteParameters::GeometriesType::Polyline6)
+        std::vector<util::json::Value> step_geometries;
+        step_geometries.reserve(number_of_steps);
+        for (const auto idx : util::irange<std::size_t>(0UL, legs.size()))
         {
-            return json::makePolyline<1000000>(begin, end);
+            const auto &locations = leg_geometries[idx].locations;
+            for (const auto &step : legs[idx].steps)
+            {
+                step_geometries.push_back(Encoder::Encode(locations.begin() + step.geometry_begin,
+                                                          locations.begin() + step.geometry_end));
+            }
         }
+        return step_geometries;
+    }
 
-        BOOST_ASSERT(parameters.geometries == RouteParameters::GeometriesType::GeoJSON);
-        return json::makeGeoJSONGeometry(begin, end);
+    // Protobuf encoded response, see pbf::tag for the layout.
+    // Steps and annotations are only part of the JSON response.
+    void MakeResponse(const InternalRouteResult &raw_route, std::string &buffer) const
+    {
+        util::AllocationPhaseScope allocation_phase(util::AllocationPhase::JSON);
+        protozero::pbf_writer response_writer{buffer};
+        response_writer.add_string(pbf::tag::RESPONSE_CODE, "Ok");
+        BaseAPI::WriteWaypoints(response_writer, raw_route.segment_end_coordinates);
+        WriteRoute(response_writer,
+                   raw_route.segment_end_coordinates,
+                   raw_route.unpacked_path_segments,
+                   raw_route.source_traversed_in_reverse,
+                   raw_route.target_traversed_in_reverse);
+        if (raw_route.has_alternative())
+        {
+            std::vector<std::vector<PathData>> wrapped_leg(1);
+            wrapped_leg.front() = raw_route.unpacked_alternative;
+            WriteRoute(response_writer,
+                       raw_route.segment_end_coordinates,
+                       wrapped_leg,
+                       raw_route.alt_source_traversed_in_reverse,
+                       raw_route.alt_target_traversed_in_reverse);
+        }
+    }
+
+    void WriteRoute(protozero::pbf_writer &response_writer,
+                    const std::vector<PhantomNodes> &segment_end_coordinates,
+                    const std::vector<std::vector<PathData>> &unpacked_path_segments,
+                    const std::vector<bool> &source_traversed_in_reverse,
+                    const std::vector<bool> &target_traversed_in_reverse) const
+    {
+        std::vector<guidance::RouteLeg> legs;
+        std::vector<guidance::LegGeometry> leg_geometries;
+        AssembleLegs(segment_end_coordinates,
+                     unpacked_path_segments,
+                     source_traversed_in_reverse,
+                     target_traversed_in_reverse,
+                     legs,
+                     leg_geometries);
+
+        protozero::pbf_writer route_writer{response_writer, pbf::tag::RESPONSE_ROUTES};
+        pbf::writeRouteSummary(route_writer, guidance::assembleRoute(legs));
+        if (parameters.overview != RouteParameters::OverviewType::False)
+        {
+            const auto use_simplification =
+                parameters.overview == RouteParameters::OverviewType::Simplified;
+            pbf::writeGeometry(route_writer,
+                               guidance::assembleOverview(leg_geometries, use_simplification));
+        }
+        for (const auto &leg : legs)
+        {
+            pbf::writeRouteLeg(route_writer, leg);
+        }
     }
 
     util::json::Object MakeRoute(const std::vector<PhantomNodes> &segment_end_coordinates,
@@ -87,87 +216,12 @@ class RouteAPI : public BaseAPI
     {
         std::vector<guidance::RouteLeg> legs;
         std::vector<guidance::LegGeometry> leg_geometries;
-        auto number_of_legs = segment_end_coordinates.size();
-        legs.reserve(number_of_legs);
-        leg_geometries.reserve(number_of_legs);
-
-        for (auto idx : util::irange<std::size_t>(0UL, number_of_legs))
-        {
-            const auto &phantoms = segment_end_coordinates[idx];
-            const auto &path_data = unpacked_path_segments[idx];
-
-            const bool reversed_source = source_traversed_in_reverse[idx];
-            const bool reversed_target = target_traversed_in_reverse[idx];
-
-            auto leg_geometry = guidance::assembleGeometry(BaseAPI::facade,
-                                                           path_data,
-                                                           phantoms.source_phantom,
-                                                           phantoms.target_phantom,
-                                                           reversed_source,
-                                                           reversed_target);
-            auto leg = guidance::assembleLeg(facade,
-                                             path_data,
-                                             leg_geometry,
-                                             phantoms.source_phantom,
-                                             phantoms.target_phantom,
-                                             reversed_target,
-                                             parameters.steps);
-
-            if (parameters.steps)
-            {
-                auto steps = guidance::assembleSteps(BaseAPI::facade,
-                                                     path_data,
-                                                     leg_geometry,
-                                                     phantoms.source_phantom,
-                                                     phantoms.target_phantom,
-                                                     reversed_source,
-                                                     reversed_target);
-
-                /* Perform step-based post-processing.
-                 *
-                 * Using post-processing on basis of route-steps for a single leg at a time
-                 * comes at the cost that we cannot count the correct exit for roundabouts.
-                 * We can only emit the exit nr/intersections up to/starting at a part of the leg.
-                 * If a roundabout is not terminated in a leg, we will end up with a
-                 *enter-roundabout
-                 * and exit-roundabout-nr where the exit nr is out of sync with the previous enter.
-                 *
-                 *         | S |
-                 *         *   *
-                 *  ----*        * ----
-                 *                  T
-                 *  ----*        * ----
-                 *       V *   *
-                 *         |   |
-                 *         |   |
-                 *
-                 * Coming from S via V to T, we end up with the legs S->V and V->T. V-T will say to
-                 *take
-                 * the second exit, even though counting from S it would be the third.
-                 * For S, we only emit `roundabout` without an exit number, showing that we enter a
-                 *roundabout
-                 * to find a via point.
-                 * The same exit will be emitted, though, if we should start routing at S, making
-                 * the overall response consistent.
-                 */
-
-                guidance::trimShortSegments(steps, leg_geometry);
-                leg.steps = guidance::postProcess(std::move(steps));
-                leg.steps = guidance::collapseTurns(std::move(leg.steps));
-                leg.steps = guidance::buildIntersections(std::move(leg.steps));
-                leg.steps = guidance::assignRelativeLocations(std::move(leg.steps),
-                                                              leg_geometry,
-                                                              phantoms.source_phantom,
-                                                              phantoms.target_phantom);
-                leg.steps = guidance::removeLanesFromRoundabouts(std::move(leg.steps));
-                leg.steps = guidance::anticipateLaneChange(std::move(leg.steps));
-                leg.steps = guidance::collapseUseLane(std::move(leg.steps));
-                leg_geometry = guidance::resyncGeometry(std::move(leg_geometry), leg.steps);
-            }
-
-            leg_geometries.push_back(std::move(leg_geometry));
-            legs.push_back(std::move(leg));
-        }
+        AssembleLegs(segment_end_coordinates,
+                     unpacked_path_segments,
+                     source_traversed_in_reverse,
+                     target_traversed_in_reverse,
+                     legs,
+                     leg_geometries);
 
         auto route = guidance::assembleRoute(legs);
         boost::optional<util::json::Value> json_overview;
@@ -182,36 +236,13 @@ class RouteAPI : public BaseAPI
             json_overview = MakeGeometry(overview.begin(), overview.end());
         }
 
+        // without steps the legs have no steps and there is nothing to encode
         std::vector<util::json::Value> step_geometries;
-        for (const auto idx : util::irange<std::size_t>(0UL, legs.size()))
+        if (parameters.steps)
         {
-            auto &leg_geometry = leg_geometries[idx];
-
-            step_geometries.reserve(step_geometries.size() + legs[idx].steps.size());
-
-            std::transform(
-                legs[idx].steps.begin(),
-                legs[idx].steps.end(),
-                std::back_inserter(step_geometries),
-                [this, &leg_geometry](const guidance::RouteStep &step) {
-                    if (parameters.geometries == RouteParameters::GeometriesType::Polyline)
-                    {
-                        return static_cast<util::json::Value>(json::makePolyline<100000>(
-                            leg_geometry.locations.begin() + step.geometry_begin,
-                            leg_geometry.locations.begin() + step.geometry_end));
-                    }
-
-                    if (parameters.geometries == RouteParameters::GeometriesType::Polyline6)
-                    {
-                        return static_cast<util::json::Value>(json::makePolyline<1000000>(
-                            leg_geometry.locations.begin() + step.geometry_begin,
-                            leg_geometry.locations.begin() + step.geometry_end));
-                    }
-
-                    BOOST_ASSERT(parameters.geometries == RouteParameters::GeometriesType::GeoJSON);
-                    return static_cast<util::json::Value>(json::makeGeoJSONGeometry(
-                        leg_geometry.locations.begin() + step.geometry_begin,
-                        leg_geometry.locations.begin() + step.geometry_end));
+            step_geometries =
+                detail::withGeometryEncoder(parameters.geometries, [&](auto encoder) {
+                    return this->MakeStepGeometries<decltype(encoder)>(legs, leg_geometries);
                 });
         }
 
@@ -219,38 +250,10 @@ class RouteAPI : public BaseAPI
 
         if (parameters.annotations)
         {
-            for (const auto idx : util::irange<std::size_t>(0UL, leg_geometries.size()))
+            annotations.reserve(leg_geometries.size());
+            for (const auto &leg_geometry : leg_geometries)
             {
-                util::json::Array durations;
-                util::json::Array distances;
-                util::json::Array nodes;
-                util::json::Array datasources;
-                auto &leg_geometry = leg_geometries[idx];
-
-                durations.values.reserve(leg_geometry.annotations.size());
-                distances.values.reserve(leg_geometry.annotations.size());
-                nodes.values.reserve(leg_geometry.osm_node_ids.size());
-                datasources.values.reserve(leg_geometry.annotations.size());
-
-                std::for_each(leg_geometry.annotations.begin(),
-                              leg_geometry.annotations.end(),
-                              [this, &durations, &distances, &datasources](
-                                  const guidance::LegGeometry::Annotation &step) {
-                                  durations.values.push_back(step.duration);
-                                  distances.values.push_back(step.distance);
-                                  datasources.values.push_back(step.datasource);
-                              });
-                std::for_each(leg_geometry.osm_node_ids.begin(),
-                              leg_geometry.osm_node_ids.end(),
-                              [this, &nodes](const OSMNodeID &node_id) {
-                                  nodes.values.push_back(static_cast<std::uint64_t>(node_id));
-                              });
-                util::json::Object annotation;
-                annotation.values["distance"] = std::move(distances);
-                annotation.values["duration"] = std::move(durations);
-                annotation.values["nodes"] = std::move(nodes);
-                annotation.values["datasources"] = std::move(datasources);
-                annotations.push_back(std::move(annotation));
+                annotations.push_back(MakeAnnotation(leg_geometry));
             }
         }
 
@@ -263,7 +266,180 @@ class RouteAPI : public BaseAPI
         return result;
     }
 
+    // Only the requested annotations are added, each array is filled in a single pass
+    util::json::Object MakeAnnotation(const guidance::LegGeometry &leg_geometry) const
+    {
+        using AnnotationsType = RouteParameters::AnnotationsType;
+        const auto &segments = leg_geometry.annotations;
+
+        const auto make_array = [&segments](const auto get_value) {
+            util::json::Array array;
+            array.values.reserve(segments.size());
+            for (const auto &segment : segments)
+            {
+                array.values.push_back(util::json::Number(get_value(segment)));
+            }
+            return array;
+        };
+
+        util::json::Object annotation;
+        if (parameters.annotations_type & AnnotationsType::Distance)
+        {
+            annotation.values["distance"] = make_array(
+                [](const guidance::LegGeometry::Annotation &segment) { return segment.distance; });
+        }
+        if (parameters.annotations_type & AnnotationsType::Duration)
+        {
+            annotation.values["duration"] = make_array(
+                [](const guidance::LegGeometry::Annotation &segment) { return segment.duration; });
+        }
+        if (parameters.annotations_type & AnnotationsType::Nodes)
+        {
+            util::json::Array nodes;
+            nodes.values.reserve(leg_geometry.osm_node_ids.size());
+            for (const auto node_id : leg_geometry.osm_node_ids)
+            {
+                nodes.values.push_back(util::json::Number(static_cast<std::uint64_t>(node_id)));
+            }
+            annotation.values["nodes"] = std::move(nodes);
+        }
+        if (parameters.annotations_type & AnnotationsType::Datasources)
+        {
+            annotation.values["datasources"] =
+                make_array([](const guidance::LegGeometry::Annotation &segment) {
+                    return static_cast<double>(segment.datasource);
+                });
+        }
+        return annotation;
+    }
+
+    // The legs are independent of each other, those of routes with many legs are assembled in
+    // parallel
+    void AssembleLegs(const std::vector<PhantomNodes> &segment_end_coordinates,
+                      const std::vector<std::vector<PathData>> &unpacked_path_segments,
+                      const std::vector<bool> &source_traversed_in_reverse,
+                      const std::vector<bool> &target_traversed_in_reverse,
+                      std::vector<guidance::RouteLeg> &legs,
+                      std::vector<guidance::LegGeometry> &leg_geometries) const
+    {
+        util::AllocationPhaseScope allocation_phase(util::AllocationPhase::Guidance);
+        const auto number_of_legs = segment_end_coordinates.size();
+        legs.resize(number_of_legs);
+        leg_geometries.resize(number_of_legs);
+
+        const auto assemble_leg = [&](const std::size_t idx) {
+            AssembleLeg(segment_end_coordinates[idx],
+                        unpacked_path_segments[idx],
+                        source_traversed_in_reverse[idx],
+                        target_traversed_in_reverse[idx],
+                        legs[idx],
+                        leg_geometries[idx]);
+        };
+
+        if (number_of_legs < PARALLEL_LEG_THRESHOLD)
+        {
+            for (const auto idx : util::irange<std::size_t>(0UL, number_of_legs))
+            {
+                assemble_leg(idx);
+            }
+            return;
+        }
+
+        util::ParallelAllocationStatistics allocations;
+        tbb::parallel_for(std::size_t{0}, number_of_legs, [&](const std::size_t idx) {
+            allocations.Run([&] { assemble_leg(idx); });
+        });
+    }
+
+    void AssembleLeg(const PhantomNodes &phantoms,
+                     const std::vector<PathData> &path_data,
+                     const bool reversed_source,
+                     const bool reversed_target,
+                     guidance::RouteLeg &leg,
+                     guidance::LegGeometry &leg_geometry) const
+    {
+        using AnnotationsType = RouteParameters::AnnotationsType;
+        const bool needs_annotations =
+            parameters.annotations &&
+            parameters.annotations_type &
+                (AnnotationsType::Duration | AnnotationsType::Distance |
+                 AnnotationsType::Datasources);
+        const bool needs_osm_node_ids =
+            parameters.annotations && parameters.annotations_type & AnnotationsType::Nodes;
+
+        leg_geometry = guidance::assembleGeometry(BaseAPI::facade,
+                                                  path_data,
+                                                  phantoms.source_phantom,
+                                                  phantoms.target_phantom,
+                                                  reversed_source,
+                                                  reversed_target,
+                                                  needs_annotations,
+                                                  needs_osm_node_ids);
+        leg = guidance::assembleLeg(facade,
+                                    path_data,
+                                    leg_geometry,
+                                    phantoms.source_phantom,
+                                    phantoms.target_phantom,
+                                    reversed_target,
+                                    parameters.steps);
+
+        if (parameters.steps)
+        {
+            auto steps = guidance::assembleSteps(BaseAPI::facade,
+                                                 path_data,
+                                                 leg_geometry,
+                                                 phantoms.source_phantom,
+                                                 phantoms.target_phantom,
+                                                 reversed_source,
+                                                 reversed_target);
+
+            /* Perform step-based post-processing.
+             *
+             * Using post-processing on basis of route-steps for a single leg at a time
+             * comes at the cost that we cannot count the correct exit for roundabouts.
+             * We can only emit the exit nr/intersections up to/starting at a part of the leg.
+             * If a roundabout is not terminated in a leg, we will end up with a
+             *enter-roundabout
+             * and exit-roundabout-nr where the exit nr is out of sync with the previous enter.
+             *
+             *         | S |
+             *         *   *
+             *  ----*        * ----
+             *                  T
+             *  ----*        * ----
+             *       V *   *
+             *         |   |
+             *         |   |
+             *
+             * Coming from S via V to T, we end up with the legs S->V and V->T. V-T will say to
+             *take
+             * the second exit, even though counting from S it would be the third.
+             * For S, we only emit `roundabout` without an exit number, showing that we enter a
+             *roundabout
+             * to find a via point.
+             * The same exit will be emitted, though, if we should start routing at S, making
+             * the overall response consistent.
+             */
+
+            guidance::trimShortSegments(steps, leg_geometry);
+            leg.steps = guidance::postProcess(std::move(steps));
+            leg.steps = guidance::collapseTurns(std::move(leg.steps));
+            leg.steps = guidance::buildIntersections(std::move(leg.steps));
+            leg.steps = guidance::assignRelativeLocations(std::move(leg.steps),
+                                                          leg_geometry,
+                                                          phantoms.source_phantom,
+                                                          phantoms.target_phantom);
+            leg.steps = guidance::removeLanesFromRoundabouts(std::move(leg.steps));
+            leg.steps = guidance::anticipateLaneChange(std::move(leg.steps));
+            leg.steps = guidance::collapseUseLane(std::move(leg.steps));
+            leg_geometry = guidance::resyncGeometry(std::move(leg_geometry), leg.steps);
+        }
+    }
+
     const RouteParameters &parameters;
+
+    // number of legs from which on they are assembled in parallel
+    static constexpr std::size_t PARALLEL_LEG_THRESHOLD = 8;
 };
 
 } // ns api
@@ -30,6 +30,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "engine/api/base_parameters.hpp"
 
+#include <boost/optional.hpp>
+
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 
 namespace osrm
@@ -48,7 +52,12 @@ namespace api
  *  - geometries: route geometry encoded in Polyline, Polyline6 or GeoJSON
  *  - overview: adds overview geometry either Full, Simplified (according to highest zoom level) or
  *              False (not at all)
+ *  - annotations: adds the annotations of annotations_type to every leg
+ *  - annotations_type: the annotations to add, all of them by default
  *  - continue_straight: enable or disable continue_straight (disabled by default)
+ *  - output_format: JSON (default) or a PBF message, only supported by the Route service
+ *  - departure_time: UNIX timestamp to compute the durations of the route at with the speed
+ *                    profiles of the dataset, if any
  *
  * \see OSRM, Coordinate, Hint, Bearing, RouteParame, RouteParameters, TableParameters,
  *      NearestParameters, TripParameters, MatchParameters and TileParameters
@@ -67,6 +76,15 @@ struct RouteParameters : public BaseParameters
         Full,
         False
     };
+    enum class AnnotationsType
+    {
+        None = 0,
+        Duration = 0x01,
+        Nodes = 0x02,
+        Distance = 0x04,
+        Datasources = 0x08,
+        All = Duration | Nodes | Distance | Datasources
+    };
 
     RouteParameters() = default;
 
@@ -102,12 +120,36 @@ struct RouteParameters : public BaseParameters
     bool steps = false;
     bool alternatives = false;
     bool annotations = false;
+    AnnotationsType annotations_type = AnnotationsType::All;
     GeometriesType geometries = GeometriesType::Polyline;
     OverviewType overview = OverviewType::Simplified;
     boost::optional<bool> continue_straight;
+    OutputFormatType output_format = OutputFormatType::JSON;
+    boost::optional<std::uint64_t> departure_time;
 
     bool IsValid() const { return coordinates.size() >= 2 && BaseParameters::IsValid(); }
 };
+
+inline bool operator&(const RouteParameters::AnnotationsType lhs,
+                      const RouteParameters::AnnotationsType rhs)
+{
+    return static_cast<std::underlying_type_t<RouteParameters::AnnotationsType>>(lhs) &
+           static_cast<std::underlying_type_t<RouteParameters::AnnotationsType>>(rhs);
+}
+
+inline RouteParameters::AnnotationsType operator|(const RouteParameters::AnnotationsType lhs,
+                                                  const RouteParameters::AnnotationsType rhs)
+{
+    return static_cast<RouteParameters::AnnotationsType>(
+        static_cast<std::underlying_type_t<RouteParameters::AnnotationsType>>(lhs) |
+        static_cast<std::underlying_type_t<RouteParameters::AnnotationsType>>(rhs));
+}
+
+inline RouteParameters::AnnotationsType &operator|=(RouteParameters::AnnotationsType &lhs,
+                                                    const RouteParameters::AnnotationsType rhs)
+{
+    return lhs = lhs | rhs;
+}
 }
 }
 }
@@ -2,7 +2,9 @@
 #define ENGINE_API_TABLE_HPP
 
 #include "engine/api/base_api.hpp"
+#include "engine/api/binary_factory.hpp"
 #include "engine/api/json_factory.hpp"
+#include "engine/api/pbf_factory.hpp"
 #include "engine/api/table_parameters.hpp"
 
 #include "engine/datafacade/datafacade_base.hpp"
@@ -16,10 +18,13 @@
 #include "engine/internal_route_result.hpp"
 
 #include "util/integer_range.hpp"
+#include "util/json_writer.hpp"
 
 #include <boost/range/algorithm/transform.hpp>
 
 #include <iterator>
+#include <string>
+#include <type_traits>
 
 namespace osrm
 {
@@ -36,10 +41,13 @@ class TableAPI final : public BaseAPI
     {
     }
 
+    // The distances are only used if the parameters ask for them
     virtual void MakeResponse(const std::vector<EdgeWeight> &durations,
+                              const std::vector<EdgeDistance> &distances,
                               const std::vector<PhantomNode> &phantoms,
                               util::json::Object &response) const
     {
+        util::AllocationPhaseScope allocation_phase(util::AllocationPhase::JSON);
         auto number_of_sources = parameters.sources.size();
         auto number_of_destinations = parameters.destinations.size();
         ;
@@ -65,11 +73,159 @@ class TableAPI final : public BaseAPI
             response.values["destinations"] = MakeWaypoints(phantoms, parameters.destinations);
         }
 
-        response.values["durations"] =
-            MakeTable(durations, number_of_sources, number_of_destinations);
+        if (parameters.annotations & TableParameters::AnnotationsType::Duration)
+        {
+            response.values["durations"] =
+                MakeTable(durations, number_of_sources, number_of_destinations);
+        }
+        if (parameters.annotations & TableParameters::AnnotationsType::Distance)
+        {
+            response.values["distances"] =
+                MakeTable(distances, number_of_sources, number_of_destinations);
+        }
         response.values["code"] = "Ok";
     }
 
+    // Same response as above, but the tables are written out directly instead of as a tree
+    virtual void MakeResponse(const std::vector<EdgeWeight> &durations,
+                              const std::vector<EdgeDistance> &distances,
+                              const std::vector<PhantomNode> &phantoms,
+                              util::json::Writer &writer) const
+    {
+        util::AllocationPhaseScope allocation_phase(util::AllocationPhase::JSON);
+        auto number_of_sources = parameters.sources.size();
+        auto number_of_destinations = parameters.destinations.size();
+
+        // symmetric case
+        util::json::Array sources;
+        if (parameters.sources.empty())
+        {
+            sources = MakeWaypoints(phantoms);
+            number_of_sources = phantoms.size();
+        }
+        else
+        {
+            sources = MakeWaypoints(phantoms, parameters.sources);
+        }
+
+        util::json::Array destinations;
+        if (parameters.destinations.empty())
+        {
+            destinations = MakeWaypoints(phantoms);
+            number_of_destinations = phantoms.size();
+        }
+        else
+        {
+            destinations = MakeWaypoints(phantoms, parameters.destinations);
+        }
+
+        const auto with_durations =
+            parameters.annotations & TableParameters::AnnotationsType::Duration;
+        const auto with_distances =
+            parameters.annotations & TableParameters::AnnotationsType::Distance;
+
+        // durations are rarely longer than a few hours and distances than a few hundred
+        // kilometers, room for the waypoints is reserved too
+        const constexpr std::size_t BYTES_PER_VALUE = 8;
+        const constexpr std::size_t BYTES_PER_WAYPOINT = 128;
+        const std::size_t number_of_tables = (with_durations ? 1 : 0) + (with_distances ? 1 : 0);
+        writer.Reserve(number_of_tables * number_of_sources * number_of_destinations *
+                           BYTES_PER_VALUE +
+                       (number_of_sources + number_of_destinations) * BYTES_PER_WAYPOINT);
+
+        writer.BeginObject();
+        writer.Key("code");
+        writer.String("Ok");
+        writer.Key("sources");
+        writer.Write(sources);
+        writer.Key("destinations");
+        writer.Write(destinations);
+        if (with_durations)
+        {
+            writer.Key("durations");
+            WriteTable(durations, number_of_sources, number_of_destinations, writer);
+        }
+        if (with_distances)
+        {
+            writer.Key("distances");
+            WriteTable(distances, number_of_sources, number_of_destinations, writer);
+        }
+        writer.EndObject();
+    }
+
+    // Protobuf encoded response, see pbf::tag for the layout, or the bare matrices for the binary
+    // output format, see binary::writeTables
+    virtual void MakeResponse(const std::vector<EdgeWeight> &durations,
+                              const std::vector<EdgeDistance> &distances,
+                              const std::vector<PhantomNode> &phantoms,
+                              std::string &buffer) const
+    {
+        util::AllocationPhaseScope allocation_phase(util::AllocationPhase::JSON);
+        if (parameters.output_format == OutputFormatType::Binary)
+        {
+            const auto number_of_sources =
+                parameters.sources.empty() ? phantoms.size() : parameters.sources.size();
+            const auto number_of_destinations = parameters.destinations.empty()
+                                                    ? phantoms.size()
+                                                    : parameters.destinations.size();
+            const auto value_type =
+                parameters.binary_values == TableParameters::BinaryValuesType::Int32
+                    ? binary::TableValueType::Int32
+                    : binary::TableValueType::Float32;
+            binary::writeTables(
+                buffer,
+                value_type,
+                number_of_sources,
+                number_of_destinations,
+                parameters.annotations & TableParameters::AnnotationsType::Duration ? &durations
+                                                                                     : nullptr,
+                parameters.annotations & TableParameters::AnnotationsType::Distance ? &distances
+                                                                                     : nullptr);
+            return;
+        }
+
+        auto number_of_destinations = parameters.destinations.size();
+
+        protozero::pbf_writer response_writer{buffer};
+        response_writer.add_string(pbf::tag::RESPONSE_CODE, "Ok");
+
+        // symmetric case
+        if (parameters.sources.empty())
+        {
+            WriteWaypoints(response_writer, pbf::tag::RESPONSE_SOURCES, phantoms);
+        }
+        else
+        {
+            WriteWaypoints(
+                response_writer, pbf::tag::RESPONSE_SOURCES, phantoms, parameters.sources);
+        }
+
+        if (parameters.destinations.empty())
+        {
+            WriteWaypoints(response_writer, pbf::tag::RESPONSE_DESTINATIONS, phantoms);
+            number_of_destinations = phantoms.size();
+        }
+        else
+        {
+            WriteWaypoints(response_writer,
+                           pbf::tag::RESPONSE_DESTINATIONS,
+                           phantoms,
+                           parameters.destinations);
+        }
+
+        BOOST_ASSERT(number_of_destinations == 0 || durations.size() % number_of_destinations == 0);
+        response_writer.add_uint32(pbf::tag::RESPONSE_COLUMNS,
+                                   static_cast<std::uint32_t>(number_of_destinations));
+        if (parameters.annotations & TableParameters::AnnotationsType::Duration)
+        {
+            pbf::writeDurations(response_writer, durations);
+        }
+        if (parameters.annotations & TableParameters::AnnotationsType::Distance)
+        {
+            pbf::writeDistances(response_writer, distances);
+        }
+    }
+
     // FIXME gcc 4.8 doesn't support for lambdas to call protected member functions
     //  protected:
     virtual util::json::Array MakeWaypoints(const std::vector<PhantomNode> &phantoms) const
@@ -99,6 +255,33 @@ class TableAPI final : public BaseAPI
         return json_waypoints;
     }
 
+    virtual void WriteWaypoints(protozero::pbf_writer &response_writer,
+                                const protozero::pbf_tag_type field,
+                                const std::vector<PhantomNode> &phantoms) const
+    {
+        BOOST_ASSERT(phantoms.size() == parameters.coordinates.size());
+        for (const auto &phantom : phantoms)
+        {
+            BaseAPI::WriteWaypoint(response_writer, field, phantom);
+        }
+    }
+
+    virtual void WriteWaypoints(protozero::pbf_writer &response_writer,
+                                const protozero::pbf_tag_type field,
+                                const std::vector<PhantomNode> &phantoms,
+                                const std::vector<std::size_t> &indices) const
+    {
+        for (const auto idx : indices)
+        {
+            BOOST_ASSERT(idx < phantoms.size());
+            BaseAPI::WriteWaypoint(response_writer, field, phantoms[idx]);
+        }
+    }
+
+    // Durations are in tenth of seconds and distances in decimeters, both are written in units.
+    // Unreachable entries are marked the same way in both.
+    static_assert(std::is_same<EdgeWeight, EdgeDistance>::value,
+                  "distances are written as weights");
     virtual util::json::Array MakeTable(const std::vector<EdgeWeight> &values,
                                         std::size_t number_of_rows,
                                         std::size_t number_of_columns) const
@@ -113,18 +296,44 @@ class TableAPI final : public BaseAPI
             std::transform(row_begin_iterator,
                            row_end_iterator,
                            json_row.values.begin(),
-                           [](const EdgeWeight duration) {
-                               if (duration == INVALID_EDGE_WEIGHT)
+                           [](const EdgeWeight value) {
+                               if (value == INVALID_EDGE_WEIGHT)
                                {
                                    return util::json::Value(util::json::Null());
                                }
-                               return util::json::Value(util::json::Number(duration / 10.));
+                               return util::json::Value(util::json::Number(value / 10.));
                            });
             json_table.values.push_back(std::move(json_row));
         }
         return json_table;
     }
 
+    virtual void WriteTable(const std::vector<EdgeWeight> &values,
+                            std::size_t number_of_rows,
+                            std::size_t number_of_columns,
+                            util::json::Writer &writer) const
+    {
+        writer.BeginArray();
+        for (const auto row : util::irange<std::size_t>(0UL, number_of_rows))
+        {
+            writer.BeginArray();
+            for (const auto column : util::irange<std::size_t>(0UL, number_of_columns))
+            {
+                const auto value = values[row * number_of_columns + column];
+                if (value == INVALID_EDGE_WEIGHT)
+                {
+                    writer.Null();
+                }
+                else
+                {
+                    writer.Tenths(value);
+                }
+            }
+            writer.EndArray();
+        }
+        writer.EndArray();
+    }
+
     const TableParameters &parameters;
 };
 
@@ -34,6 +34,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <algorithm>
 #include <iterator>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 namespace osrm
@@ -51,14 +53,46 @@ namespace api
  *             use all coordinates as sources
  *  - destinations: indices into coordinates indicating destinations for the Table service, no
  *                  destinations means use all coordinates as destinations
+ *  - output_format: JSON (default), a PBF message or the binary matrices
+ *  - annotations: the tables to return, durations (default) and/or distances
+ *  - binary_values: the values of the binary matrices, float32 (default) or int32
+ *  - target_set: name of a target set. With destinations they are registered as the set,
+ *                without them the destinations are the targets of the registered set and all
+ *                coordinates can be sources.
+ *  - approximate: durations that are at most APPROXIMATE_MAX_ERROR longer than the shortest
+ *                 ones, never shorter, for large tables. Only for durations without target sets.
  *
  * \see OSRM, Coordinate, Hint, Bearing, RouteParame, RouteParameters, TableParameters,
  *      NearestParameters, TripParameters, MatchParameters and TileParameters
  */
 struct TableParameters : public BaseParameters
 {
+    enum class AnnotationsType
+    {
+        None = 0,
+        Duration = 0x01,
+        Distance = 0x02,
+        All = Duration | Distance
+    };
+
+    enum class BinaryValuesType
+    {
+        // seconds and meters
+        Float32,
+        // tenth of seconds and decimeters
+        Int32
+    };
+
     std::vector<std::size_t> sources;
     std::vector<std::size_t> destinations;
+    OutputFormatType output_format = OutputFormatType::JSON;
+    AnnotationsType annotations = AnnotationsType::Duration;
+    BinaryValuesType binary_values = BinaryValuesType::Float32;
+    std::string target_set;
+    bool approximate = false;
+
+    // relative error of approximate durations
+    static constexpr double APPROXIMATE_MAX_ERROR = 0.05;
 
     TableParameters() = default;
     template <typename... Args>
@@ -75,8 +109,9 @@ struct TableParameters : public BaseParameters
         if (!BaseParameters::IsValid())
             return false;
 
-        // Distance Table makes only sense with 2+ coodinates
-        if (coordinates.size() < 2)
+        // Distance Table makes only sense with 2+ coodinates, the targets of a set are not
+        // part of the coordinates
+        if (coordinates.size() < (UsesTargetSet() ? 1 : 2))
             return false;
 
         // 1/ The user is able to specify duplicates in srcs and dsts, in that case it's her fault
@@ -97,9 +132,40 @@ struct TableParameters : public BaseParameters
         if (std::any_of(begin(destinations), end(destinations), not_in_range))
             return false;
 
+        if (annotations == AnnotationsType::None)
+            return false;
+
+        // the error is only bounded for the weights, which target sets answer exactly
+        if (approximate && (annotations != AnnotationsType::Duration || !target_set.empty()))
+            return false;
+
         return true;
     }
+
+    // the destinations are the targets of a registered set
+    bool UsesTargetSet() const { return !target_set.empty() && destinations.empty(); }
 };
+
+inline bool operator&(const TableParameters::AnnotationsType lhs,
+                      const TableParameters::AnnotationsType rhs)
+{
+    return static_cast<std::underlying_type_t<TableParameters::AnnotationsType>>(lhs) &
+           static_cast<std::underlying_type_t<TableParameters::AnnotationsType>>(rhs);
+}
+
+inline TableParameters::AnnotationsType operator|(const TableParameters::AnnotationsType lhs,
+                                                  const TableParameters::AnnotationsType rhs)
+{
+    return static_cast<TableParameters::AnnotationsType>(
+        static_cast<std::underlying_type_t<TableParameters::AnnotationsType>>(lhs) |
+        static_cast<std::underlying_type_t<TableParameters::AnnotationsType>>(rhs));
+}
+
+inline TableParameters::AnnotationsType &operator|=(TableParameters::AnnotationsType &lhs,
+                                                    const TableParameters::AnnotationsType rhs)
+{
+    return lhs = lhs | rhs;
+}
 }
 }
 }
@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define ENGINE_API_TILE_PARAMETERS_HPP
 
 #include <cmath>
+#include <string>
 
 namespace osrm
 {
@@ -57,6 +58,9 @@ struct TileParameters final
     unsigned x;
     unsigned y;
     unsigned z;
+    // selects a dataset of EngineConfig::profiles, the default dataset for other profiles.
+    // Initialized here so that TileParameters{x, y, z} does not miss it.
+    std::string profile = {};
 
     bool IsValid() const
     {
@@ -64,8 +68,9 @@ struct TileParameters final
         // https://wiki.openstreetmap.org/wiki/Slippy_map_tilenames#X_and_Y
         const auto valid_x = x <= static_cast<unsigned>(std::pow(2., z)) - 1;
         const auto valid_y = y <= static_cast<unsigned>(std::pow(2., z)) - 1;
-        // zoom limits are due to slippy map and server performance limits
-        const auto valid_z = z < 20 && z >= 12;
+        // zoom limits are due to slippy map and server performance limits, levels below 12
+        // only show the longer road geometries of the tile overview
+        const auto valid_z = z < 20 && z >= 8;
 
         return valid_x && valid_y && valid_z;
     };
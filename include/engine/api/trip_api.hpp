@@ -30,6 +30,7 @@ class TripAPI final : public RouteAPI
                       const std::vector<PhantomNode> &phantoms,
                       util::json::Object &response) const
     {
+        util::AllocationPhaseScope allocation_phase(util::AllocationPhase::JSON);
         auto number_of_routes = sub_trips.size();
         util::json::Array routes;
         routes.values.reserve(number_of_routes);
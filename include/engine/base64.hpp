@@ -1,19 +1,16 @@
 #ifndef OSRM_BASE64_HPP
 #define OSRM_BASE64_HPP
 
+#include <array>
 #include <iterator>
 #include <string>
 #include <type_traits>
-#include <vector>
 
 #include <climits>
 #include <cstddef>
+#include <cstdint>
 
-#include <boost/algorithm/string/trim.hpp>
-#include <boost/archive/iterators/base64_from_binary.hpp>
-#include <boost/archive/iterators/binary_from_base64.hpp>
-#include <boost/archive/iterators/transform_width.hpp>
-#include <boost/range/algorithm/copy.hpp>
+#include <boost/assert.hpp>
 
 namespace osrm
 {
@@ -27,88 +24,187 @@ namespace detail
 static_assert(CHAR_BIT == 8u, "we assume a byte holds 8 bits");
 static_assert(sizeof(char) == 1u, "we assume a char is one byte large");
 
-using Base64FromBinary = boost::archive::iterators::base64_from_binary<
-    boost::archive::iterators::transform_width<const char *, // sequence of chars
-                                               6,            // get view of 6 bit
-                                               8             // from sequence of 8 bit
-                                               >>;
-
-using BinaryFromBase64 = boost::archive::iterators::transform_width<
-    boost::archive::iterators::binary_from_base64<std::string::const_iterator>,
-    8, // get a view of 8 bit
-    6  // from a sequence of 6 bit
-    >;
+const constexpr char BASE64_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+// Section 5: the alphabet that can be used in URLs and file names
+const constexpr char BASE64_URL_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+const constexpr std::uint8_t INVALID_BASE64_VALUE = 0xff;
+
+// The 6 bit values of the characters of both alphabets, so either can be decoded.
+// The padding character decodes to zero bits.
+inline const std::array<std::uint8_t, 256> &getBase64Values()
+{
+    static const auto values = [] {
+        std::array<std::uint8_t, 256> values;
+        values.fill(INVALID_BASE64_VALUE);
+        for (std::uint8_t value = 0; value < 64; ++value)
+        {
+            values[static_cast<unsigned char>(BASE64_ALPHABET[value])] = value;
+            values[static_cast<unsigned char>(BASE64_URL_ALPHABET[value])] = value;
+        }
+        values['='] = 0;
+        return values;
+    }();
+    return values;
+}
+
+// The two characters of every 12 bit value, three bytes are encoded with two lookups
+using Base64Pairs = std::array<std::array<char, 2>, 4096>;
+
+inline Base64Pairs makeBase64Pairs(const char *const characters)
+{
+    Base64Pairs pairs;
+    for (std::size_t value = 0; value < pairs.size(); ++value)
+    {
+        pairs[value] = {{characters[value >> 6], characters[value & 0x3f]}};
+    }
+    return pairs;
+}
 } // ns detail
 namespace engine
 {
 
+enum class Base64Alphabet
+{
+    Standard,
+    URLSafe
+};
+
 // Encoding Implementation
 
-// Encodes a chunk of memory to Base64.
-inline std::string encodeBase64(const unsigned char *first, std::size_t size)
+// Encodes a chunk of memory to Base64 into a buffer of (size + 2) / 3 * 4 characters and
+// returns the end of the characters. Every three bytes are encoded as two pairs of characters
+// looked up at once, the last one to two bytes are padded with '='.
+inline char *encodeBase64(const unsigned char *first,
+                          std::size_t size,
+                          char *out,
+                          const Base64Alphabet alphabet = Base64Alphabet::Standard)
 {
-    std::vector<unsigned char> bytes{first, first + size};
-    BOOST_ASSERT(!bytes.empty());
+    static const auto standard_pairs = detail::makeBase64Pairs(detail::BASE64_ALPHABET);
+    static const auto url_pairs = detail::makeBase64Pairs(detail::BASE64_URL_ALPHABET);
+    const auto &pairs = alphabet == Base64Alphabet::Standard ? standard_pairs : url_pairs;
 
-    std::size_t bytes_to_pad{0};
-
-    while (bytes.size() % 3 != 0)
+    const auto *const last_triple = first + size / 3 * 3;
+    for (; first != last_triple; first += 3)
     {
-        bytes_to_pad += 1;
-        bytes.push_back(0);
+        const std::uint32_t bits = (std::uint32_t{first[0]} << 16) |
+                                   (std::uint32_t{first[1]} << 8) | std::uint32_t{first[2]};
+        const auto &high = pairs[bits >> 12];
+        const auto &low = pairs[bits & 0xfff];
+        out[0] = high[0];
+        out[1] = high[1];
+        out[2] = low[0];
+        out[3] = low[1];
+        out += 4;
     }
 
-    BOOST_ASSERT(bytes_to_pad == 0 || bytes_to_pad == 1 || bytes_to_pad == 2);
-    BOOST_ASSERT_MSG(0 == bytes.size() % 3, "base64 input data size is not a multiple of 3");
+    const auto remaining = size % 3;
+    if (remaining > 0)
+    {
+        const std::uint32_t bits = (std::uint32_t{first[0]} << 16) |
+                                   (remaining == 2 ? std::uint32_t{first[1]} << 8 : 0u);
+        const auto &high = pairs[bits >> 12];
+        const auto &low = pairs[bits & 0xfff];
+        out[0] = high[0];
+        out[1] = high[1];
+        out[2] = remaining == 2 ? low[0] : '=';
+        out[3] = '=';
+        out += 4;
+    }
 
-    std::string encoded{detail::Base64FromBinary{bytes.data()},
-                        detail::Base64FromBinary{bytes.data() + (bytes.size() - bytes_to_pad)}};
+    return out;
+}
 
-    return encoded.append(bytes_to_pad, '=');
+// Encodes a chunk of memory to Base64.
+inline std::string encodeBase64(const unsigned char *first,
+                                std::size_t size,
+                                const Base64Alphabet alphabet = Base64Alphabet::Standard)
+{
+    BOOST_ASSERT(size > 0);
+    std::string encoded((size + 2) / 3 * 4, '=');
+    encodeBase64(first, size, &encoded[0], alphabet);
+    return encoded;
 }
 
 // C++11 standard 3.9.1/1: Plain char, signed char, and unsigned char are three distinct types
 
 // Overload for signed char catches (not only but also) C-string literals.
-inline std::string encodeBase64(const signed char *first, std::size_t size)
+inline std::string encodeBase64(const signed char *first,
+                                std::size_t size,
+                                const Base64Alphabet alphabet = Base64Alphabet::Standard)
 {
-    return encodeBase64(reinterpret_cast<const unsigned char *>(first), size);
+    return encodeBase64(reinterpret_cast<const unsigned char *>(first), size, alphabet);
 }
 
 // Overload for char catches (not only but also) C-string literals.
-inline std::string encodeBase64(const char *first, std::size_t size)
+inline std::string encodeBase64(const char *first,
+                                std::size_t size,
+                                const Base64Alphabet alphabet = Base64Alphabet::Standard)
 {
-    return encodeBase64(reinterpret_cast<const unsigned char *>(first), size);
+    return encodeBase64(reinterpret_cast<const unsigned char *>(first), size, alphabet);
 }
 
 // Convenience specialization, encoding from string instead of byte-dumping it.
 inline std::string encodeBase64(const std::string &x) { return encodeBase64(x.data(), x.size()); }
 
 // Encode any sufficiently trivial object to Base64.
-template <typename T> std::string encodeBase64Bytewise(const T &x)
+template <typename T>
+std::string encodeBase64Bytewise(const T &x,
+                                 const Base64Alphabet alphabet = Base64Alphabet::Standard)
 {
 #if not defined __GNUC__ or __GNUC__ > 4
     static_assert(std::is_trivially_copyable<T>::value, "requires a trivially copyable type");
 #endif
 
-    return encodeBase64(reinterpret_cast<const unsigned char *>(&x), sizeof(T));
+    return encodeBase64(reinterpret_cast<const unsigned char *>(&x), sizeof(T), alphabet);
 }
 
 // Decoding Implementation
 
-// Decodes into a chunk of memory that is at least as large as the input.
-template <typename OutputIter> void decodeBase64(const std::string &encoded, OutputIter out)
+// Decodes the characters of a range into a chunk of memory that is at least as large as the
+// input. Accepts the characters of the standard and of the URL safe alphabet.
+template <typename InputIter, typename OutputIter>
+void decodeBase64(const InputIter encoded_first, const InputIter encoded_last, OutputIter out)
 {
-    auto unpadded = encoded;
+    const std::size_t encoded_size = std::distance(encoded_first, encoded_last);
+    BOOST_ASSERT_MSG(encoded_size % 4 == 0, "base64 input is not padded");
+    const auto &values = detail::getBase64Values();
 
-    const auto num_padded = std::count(begin(encoded), end(encoded), '=');
-    std::replace(begin(unpadded), end(unpadded), '=', 'A'); // A_64 == \0
+    std::size_t num_padded = 0;
+    for (auto last = encoded_last; last != encoded_first && *std::prev(last) == '='; --last)
+    {
+        ++num_padded;
+    }
+    const auto size = encoded_size / 4 * 3 - num_padded;
 
-    std::string decoded{detail::BinaryFromBase64{begin(unpadded)},
-                        detail::BinaryFromBase64{begin(unpadded) + unpadded.length()}};
+    std::size_t decoded_bytes = 0;
+    for (auto quadruple = encoded_first; quadruple != encoded_last; quadruple += 4)
+    {
+        const auto first = values[static_cast<unsigned char>(quadruple[0])];
+        const auto second = values[static_cast<unsigned char>(quadruple[1])];
+        const auto third = values[static_cast<unsigned char>(quadruple[2])];
+        const auto fourth = values[static_cast<unsigned char>(quadruple[3])];
+        BOOST_ASSERT_MSG((first | second | third | fourth) != detail::INVALID_BASE64_VALUE,
+                         "invalid base64 character");
+        const std::uint32_t bits = (std::uint32_t{first} << 18) | (std::uint32_t{second} << 12) |
+                                   (std::uint32_t{third} << 6) | std::uint32_t{fourth};
+
+        for (const auto shift : {16, 8, 0})
+        {
+            if (decoded_bytes == size)
+            {
+                return;
+            }
+            *out++ = static_cast<unsigned char>((bits >> shift) & 0xff);
+            ++decoded_bytes;
+        }
+    }
+}
 
-    decoded.erase(end(decoded) - num_padded, end(decoded));
-    std::copy(begin(decoded), end(decoded), out);
+template <typename OutputIter> void decodeBase64(const std::string &encoded, OutputIter out)
+{
+    decodeBase64(encoded.begin(), encoded.end(), out);
 }
 
 // Convenience specialization, filling string instead of byte-dumping into it.
@@ -122,7 +218,8 @@ inline std::string decodeBase64(const std::string &encoded)
 }
 
 // Decodes from Base 64 to any sufficiently trivial object.
-template <typename T> T decodeBase64Bytewise(const std::string &encoded)
+template <typename T, typename InputIter>
+T decodeBase64Bytewise(const InputIter encoded_first, const InputIter encoded_last)
 {
 #if not defined __GNUC__ or __GNUC__ > 4
     static_assert(std::is_trivially_copyable<T>::value, "requires a trivially copyable type");
@@ -130,11 +227,16 @@ template <typename T> T decodeBase64Bytewise(const std::string &encoded)
 
     T x;
 
-    decodeBase64(encoded, reinterpret_cast<unsigned char *>(&x));
+    decodeBase64(encoded_first, encoded_last, reinterpret_cast<unsigned char *>(&x));
 
     return x;
 }
 
+template <typename T> T decodeBase64Bytewise(const std::string &encoded)
+{
+    return decodeBase64Bytewise<T>(encoded.begin(), encoded.end());
+}
+
 } // ns engine
 } // ns osrm
 
@@ -6,13 +6,20 @@
 #include "storage/shared_barriers.hpp"
 #include "storage/shared_datatype.hpp"
 #include "storage/shared_memory.hpp"
+#include "util/integer_range.hpp"
+#include "util/numa.hpp"
 
 #include <boost/interprocess/sync/named_upgradable_mutex.hpp>
-#include <boost/thread/lock_types.hpp>
-#include <boost/thread/locks.hpp>
-#include <boost/thread/shared_mutex.hpp>
+#include <boost/interprocess/sync/sharable_lock.hpp>
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace osrm
 {
@@ -23,17 +30,31 @@ namespace engine
 // the data and layout regions that should be used. This region is updated
 // once a new dataset arrives.
 //
-// TODO: This also needs a shared memory reader lock with other clients and
-// possibly osrm-datastore since updating the CURRENT_REGIONS data is not atomic.
-// Currently we enfore this by waiting that all queries have finished before
-// osrm-datastore writes to this section.
+// Queries share a reference counted facade of the newest dataset. Checking for a new dataset is
+// a single atomic read, the interprocess lock is only taken to attach a new one. Facades of
+// replaced datasets live on until their last query finished, so neither side waits for the other.
+//
+// A dataset has a facade for each of its metrics, they all map the same data region.
+//
+// With NUMA replicas every node holds a copy of the dataset, queries use the one of the node they
+// run on.
 class DataWatchdog
 {
   public:
-    DataWatchdog()
-        : shared_barriers{std::make_shared<storage::SharedBarriers>()},
+    explicit DataWatchdog(const bool numa_replicas = false,
+                          const std::size_t shortcut_cache_size = 0,
+                          const std::size_t tile_cache_size = 0,
+                          const std::size_t phantom_node_cache_size = 0,
+                          const std::size_t route_cache_memory = 0,
+                          const std::size_t search_space_cache_size = 0)
+        : shortcut_cache_size(shortcut_cache_size), tile_cache_size(tile_cache_size),
+          phantom_node_cache_size(phantom_node_cache_size), route_cache_memory(route_cache_memory),
+          search_space_cache_size(search_space_cache_size),
+          shared_barriers{std::make_shared<storage::SharedBarriers>()},
           shared_regions(storage::makeSharedMemory(storage::CURRENT_REGIONS)),
-          current_timestamp{storage::LAYOUT_NONE, storage::DATA_NONE, 0}
+          shared_timestamp(
+              static_cast<const storage::SharedDataTimestamp *>(shared_regions->Ptr())),
+          datasets(numa_replicas ? util::getNumaNodes().size() : 1)
     {
     }
 
@@ -43,84 +64,138 @@ class DataWatchdog
         return storage::SharedMemory::RegionExists(storage::CURRENT_REGIONS);
     }
 
-    using RegionsLock =
-        boost::interprocess::sharable_lock<boost::interprocess::named_sharable_mutex>;
-    using LockAndFacade = std::pair<RegionsLock, std::shared_ptr<datafacade::BaseDataFacade>>;
+    // Returns the facade of a metric of the newest dataset, attaching the dataset first if it
+    // changed. The default metric has no name, nullptr is returned for unknown metrics.
+    std::shared_ptr<datafacade::BaseDataFacade> GetDataFacade(const std::string &metric = "")
+    {
+        const auto dataset = GetDataset();
+        const auto facade = dataset->facades.find(metric);
+        if (facade == dataset->facades.end())
+        {
+            return nullptr;
+        }
+        return facade->second;
+    }
 
-    // This will either update the contens of facade or just leave it as is
-    // if the update was already done by another thread
-    LockAndFacade GetDataFacade()
+  private:
+    struct Dataset
     {
-        const boost::interprocess::sharable_lock<boost::interprocess::named_upgradable_mutex> lock(
-            shared_barriers->current_regions_mutex);
+        unsigned timestamp;
+        // facades by the name of their metric
+        std::unordered_map<std::string, std::shared_ptr<datafacade::SharedDataFacade>> facades;
+    };
 
-        const auto shared_timestamp =
-            static_cast<const storage::SharedDataTimestamp *>(shared_regions->Ptr());
+    std::shared_ptr<const Dataset> GetDataset()
+    {
+        auto &dataset = datasets.size() > 1
+                            ? datasets[util::getCurrentNumaNode() % datasets.size()]
+                            : datasets.front();
 
-        const auto get_locked_facade = [this, shared_timestamp]() {
-            if (current_timestamp.data == storage::DATA_1)
-            {
-                BOOST_ASSERT(current_timestamp.layout == storage::LAYOUT_1);
-                return std::make_pair(RegionsLock(shared_barriers->regions_1_mutex), facade);
-            }
-            else
+        auto current_dataset = std::atomic_load(&dataset);
+        if (current_dataset && current_dataset->timestamp ==
+                                   shared_timestamp->timestamp.load(std::memory_order_acquire))
+        {
+            return current_dataset;
+        }
+
+        // only one thread attaches the new dataset, the others keep using the old one meanwhile
+        std::unique_lock<std::mutex> update_lock(update_mutex, std::try_to_lock);
+        if (!update_lock.owns_lock())
+        {
+            if (current_dataset)
             {
-                BOOST_ASSERT(current_timestamp.layout == storage::LAYOUT_2);
-                BOOST_ASSERT(current_timestamp.data == storage::DATA_2);
-                return std::make_pair(RegionsLock(shared_barriers->regions_2_mutex), facade);
+                return current_dataset;
             }
-        };
+            update_lock.lock();
+        }
 
-        // this blocks handle the common case when there is no data update -> we will only need a
-        // shared lock
+        // we might get overtaken before we actually do the update
+        current_dataset = std::atomic_load(&dataset);
+        if (current_dataset && current_dataset->timestamp ==
+                                   shared_timestamp->timestamp.load(std::memory_order_acquire))
         {
-            boost::shared_lock<boost::shared_mutex> facade_lock(facade_mutex);
+            return current_dataset;
+        }
+
+        // osrm-datastore does not remove the regions of the current dataset while we hold this
+        const boost::interprocess::sharable_lock<boost::interprocess::named_upgradable_mutex> lock(
+            shared_barriers->current_regions_mutex);
 
-            if (shared_timestamp->timestamp == current_timestamp.timestamp)
+        const auto timestamp = shared_timestamp->timestamp.load(std::memory_order_acquire);
+        std::vector<std::string> metrics{""};
+        {
+            const auto layout_memory = storage::makeSharedMemory(shared_timestamp->layout);
+            const auto shared_metrics = storage::GetSharedMetrics(layout_memory->Ptr());
+            for (const auto index : util::irange<std::uint32_t>(0, shared_metrics->number_of_metrics))
             {
-                BOOST_ASSERT(shared_timestamp->layout == current_timestamp.layout);
-                BOOST_ASSERT(shared_timestamp->data == current_timestamp.data);
-                return get_locked_facade();
+                metrics.emplace_back(shared_metrics->metrics[index].name);
             }
         }
 
-        // if we reach this code there is a data update to be made. multiple
-        // requests can reach this, but only ever one goes through at a time.
-        boost::upgrade_lock<boost::shared_mutex> facade_lock(facade_mutex);
-
-        // we might get overtaken before we actually do the writing
-        // in that case we don't modify anthing
-        if (shared_timestamp->timestamp == current_timestamp.timestamp)
+        auto newest_dataset = std::make_shared<Dataset>();
+        newest_dataset->timestamp = timestamp;
+        for (const auto &metric : metrics)
         {
-            BOOST_ASSERT(shared_timestamp->layout == current_timestamp.layout);
-            BOOST_ASSERT(shared_timestamp->data == current_timestamp.data);
-
-            return get_locked_facade();
+            newest_dataset->facades[metric] =
+                std::make_shared<datafacade::SharedDataFacade>(shared_timestamp->layout,
+                                                               shared_timestamp->data,
+                                                               shared_timestamp->metric,
+                                                               timestamp,
+                                                               metric);
+            newest_dataset->facades[metric]->EnableShortcutCache(shortcut_cache_size);
+            newest_dataset->facades[metric]->EnableTileCache(tile_cache_size);
+            newest_dataset->facades[metric]->EnablePhantomNodeCache(phantom_node_cache_size);
+            newest_dataset->facades[metric]->EnableRouteCache(route_cache_memory);
+            newest_dataset->facades[metric]->EnableSearchSpaceCache(search_space_cache_size);
+        }
+        if (datasets.size() == 1)
+        {
+            std::atomic_store(&dataset, std::shared_ptr<const Dataset>(std::move(newest_dataset)));
+            return std::atomic_load(&dataset);
         }
 
-        // this thread has won and can update the data
-        boost::upgrade_to_unique_lock<boost::upgrade_mutex> unique_facade_lock(facade_lock);
-
-        current_timestamp = *shared_timestamp;
-        facade = std::make_shared<datafacade::SharedDataFacade>(shared_barriers,
-                                                                current_timestamp.layout,
-                                                                current_timestamp.data,
-                                                                current_timestamp.timestamp);
-
-        return get_locked_facade();
+        // the replicas do not refer to the shared memory, it is freed once they are all updated
+        for (const auto node : util::irange<std::size_t>(0, datasets.size()))
+        {
+            auto replica = std::make_shared<Dataset>();
+            replica->timestamp = timestamp;
+            util::runOnNumaNode(node, [&] {
+                for (const auto &facade : newest_dataset->facades)
+                {
+                    replica->facades[facade.first] =
+                        datafacade::SharedDataFacade::Replicate(*facade.second);
+                    replica->facades[facade.first]->EnableShortcutCache(shortcut_cache_size);
+                    replica->facades[facade.first]->EnableTileCache(tile_cache_size);
+                    replica->facades[facade.first]->EnablePhantomNodeCache(
+                        phantom_node_cache_size);
+                    replica->facades[facade.first]->EnableRouteCache(route_cache_memory);
+                    replica->facades[facade.first]->EnableSearchSpaceCache(
+                        search_space_cache_size);
+                }
+            });
+            std::atomic_store(&datasets[node], std::shared_ptr<const Dataset>(std::move(replica)));
+        }
+        return std::atomic_load(&dataset);
     }
 
-  private:
-    // mutexes should be mutable even on const objects: This enables
-    // marking functions as logical const and thread-safe.
+    // every facade caches its own shortcuts, tiles, phantom nodes, routes and search spaces,
+    // they are dropped with the dataset
+    const std::size_t shortcut_cache_size;
+    const std::size_t tile_cache_size;
+    const std::size_t phantom_node_cache_size;
+    // in bytes
+    const std::size_t route_cache_memory;
+    const std::size_t search_space_cache_size;
+
     std::shared_ptr<storage::SharedBarriers> shared_barriers;
 
     // shared memory table containing pointers to all shared regions
     std::unique_ptr<storage::SharedMemory> shared_regions;
+    const storage::SharedDataTimestamp *shared_timestamp;
 
-    mutable boost::shared_mutex facade_mutex;
-    std::shared_ptr<datafacade::SharedDataFacade> facade;
-    storage::SharedDataTimestamp current_timestamp;
+    std::mutex update_mutex;
+    // one dataset per NUMA node with replicas, a single one otherwise
+    std::vector<std::shared_ptr<const Dataset>> datasets;
 };
 }
 }
@@ -10,19 +10,35 @@
 #include "extractor/guidance/turn_lane_types.hpp"
 #include "extractor/original_edge_data.hpp"
 #include "engine/phantom_node.hpp"
+#include "engine/phantom_node_cache.hpp"
+#include "engine/query_graph.hpp"
+#include "engine/route_cache.hpp"
+#include "engine/search_space_cache.hpp"
+#include "engine/shortcut_cache.hpp"
+#include "engine/sweep_order.hpp"
+#include "engine/tile_cache.hpp"
+#include "engine/tile_overview.hpp"
+#include "util/array_view.hpp"
 #include "util/exception.hpp"
+#include "util/geometry_node_list.hpp"
 #include "util/guidance/bearing_class.hpp"
 #include "util/guidance/entry_class.hpp"
 #include "util/guidance/turn_bearing.hpp"
 #include "util/guidance/turn_lanes.hpp"
 #include "util/integer_range.hpp"
+#include "util/multi_level_graph.hpp"
+#include "util/segment_weight_list.hpp"
+#include "util/speed_profile.hpp"
 #include "util/string_util.hpp"
+#include "util/string_view.hpp"
 #include "util/typedefs.hpp"
 
 #include "osrm/coordinate.hpp"
 
 #include <cstddef>
 
+#include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -44,6 +60,72 @@ class BaseDataFacade
     BaseDataFacade() {}
     virtual ~BaseDataFacade() {}
 
+    // Caches the original edges of up to this many shortcuts for path unpacking, 0 disables it.
+    void EnableShortcutCache(const std::size_t number_of_entries)
+    {
+        shortcut_cache.reset(number_of_entries > 0 ? new ShortcutCache(number_of_entries)
+                                                   : nullptr);
+    }
+
+    // nullptr unless the shortcut cache is enabled
+    ShortcutCache *GetShortcutCache() const { return shortcut_cache.get(); }
+
+    // Caches up to this many encoded debug tiles, 0 disables it.
+    void EnableTileCache(const std::size_t number_of_tiles)
+    {
+        tile_cache.reset(number_of_tiles > 0 ? new TileCache(number_of_tiles) : nullptr);
+    }
+
+    // nullptr unless the tile cache is enabled
+    TileCache *GetTileCache() const { return tile_cache.get(); }
+
+    // Caches the snapped phantom nodes of up to this many coordinates, 0 disables it.
+    void EnablePhantomNodeCache(const std::size_t number_of_entries)
+    {
+        phantom_node_cache.reset(number_of_entries > 0 ? new PhantomNodeCache(number_of_entries)
+                                                       : nullptr);
+    }
+
+    // nullptr unless the phantom node cache is enabled
+    PhantomNodeCache *GetPhantomNodeCache() const { return phantom_node_cache.get(); }
+
+    // Caches route responses up to this many bytes, 0 disables it.
+    void EnableRouteCache(const std::size_t memory_budget)
+    {
+        route_cache.reset(memory_budget > 0 ? new RouteCache(memory_budget) : nullptr);
+    }
+
+    // nullptr unless the route cache is enabled
+    RouteCache *GetRouteCache() const { return route_cache.get(); }
+
+    // Caches the upward search spaces of up to this many table sources, 0 disables it.
+    void EnableSearchSpaceCache(const std::size_t number_of_entries)
+    {
+        search_space_cache.reset(number_of_entries > 0 ? new SearchSpaceCache(number_of_entries)
+                                                       : nullptr);
+    }
+
+    // nullptr unless the search space cache is enabled
+    SearchSpaceCache *GetSearchSpaceCache() const { return search_space_cache.get(); }
+
+    // nullptr unless the overlay graph for the MLD algorithm is loaded
+    virtual const util::MultiLevelGraph *GetMultiLevelGraph() const { return nullptr; }
+
+    // Road geometries for the debug tiles of low zoom levels, collected on the first call
+    const TileOverview &GetTileOverview() const
+    {
+        std::call_once(tile_overview_collected,
+                       [this] { tile_overview.reset(new TileOverview(*this)); });
+        return *tile_overview;
+    }
+
+    // Nodes in the order of a downward sweep over the hierarchy, computed on the first call
+    const std::vector<NodeID> &GetSweepOrder() const
+    {
+        std::call_once(sweep_order_computed, [this] { sweep_order = computeSweepOrder(*this); });
+        return sweep_order;
+    }
+
     // search graph access
     virtual unsigned GetNumberOfNodes() const = 0;
 
@@ -53,7 +135,11 @@ class BaseDataFacade
 
     virtual NodeID GetTarget(const EdgeID e) const = 0;
 
-    virtual const EdgeData &GetEdgeData(const EdgeID e) const = 0;
+    // Both parts of an edge, searches that only need the target, the weight and the directions
+    // read the hot part
+    virtual EdgeData GetEdgeData(const EdgeID e) const = 0;
+
+    virtual const HotEdgeData &GetHotEdgeData(const EdgeID e) const = 0;
 
     virtual EdgeID BeginEdges(const NodeID n) const = 0;
 
@@ -61,6 +147,11 @@ class BaseDataFacade
 
     virtual EdgeRange GetAdjacentEdgeRange(const NodeID node) const = 0;
 
+    // the edges of a node that the forward respectively the backward search relaxes
+    virtual EdgeRange GetForwardEdgeRange(const NodeID node) const = 0;
+
+    virtual EdgeRange GetBackwardEdgeRange(const NodeID node) const = 0;
+
     // searches for a specific edge
     virtual EdgeID FindEdge(const NodeID from, const NodeID to) const = 0;
 
@@ -79,29 +170,56 @@ class BaseDataFacade
 
     virtual GeometryID GetGeometryIndexForEdgeID(const unsigned id) const = 0;
 
-    virtual std::vector<NodeID> GetUncompressedForwardGeometry(const EdgeID id) const = 0;
+    // The uncompressed geometry accessors return views into the geometry arrays of the facade,
+    // they stay valid as long as the facade. The nodes might be delta encoded, their views are
+    // cheapest to read in order, see util::GeometryNodeView.
+    virtual util::GeometryNodeView GetUncompressedForwardGeometry(const EdgeID id) const = 0;
 
-    virtual std::vector<NodeID> GetUncompressedReverseGeometry(const EdgeID id) const = 0;
+    virtual util::GeometryNodeView GetUncompressedReverseGeometry(const EdgeID id) const = 0;
 
     // Gets the weight values for each segment in an uncompressed geometry.
     // Should always be 1 shorter than GetUncompressedGeometry
-    virtual std::vector<EdgeWeight> GetUncompressedForwardWeights(const EdgeID id) const = 0;
+    virtual util::SegmentWeightView GetUncompressedForwardWeights(const EdgeID id) const = 0;
+
+    virtual util::SegmentWeightView GetUncompressedReverseWeights(const EdgeID id) const = 0;
+
+    // Gets the offset of each segment in an uncompressed geometry, the sum of the weights before
+    // it, followed by the sum of all weights. Empty if the dataset was loaded without them, see
+    // util::toSegmentWeightOffsets.
+    virtual util::ArrayView<EdgeWeight>
+    GetUncompressedForwardWeightOffsets(const EdgeID id) const = 0;
+
+    virtual util::ArrayView<EdgeWeight>
+    GetUncompressedReverseWeightOffsets(const EdgeID id) const = 0;
 
-    virtual std::vector<EdgeWeight> GetUncompressedReverseWeights(const EdgeID id) const = 0;
+    // Gets the length of each segment in an uncompressed geometry, aligned with the weights.
+    // Empty if the dataset has no segment lengths, see SegmentLength for the encoding.
+    virtual util::ArrayView<SegmentLength> GetUncompressedForwardLengths(const EdgeID id) const = 0;
+
+    virtual util::ArrayView<SegmentLength> GetUncompressedReverseLengths(const EdgeID id) const = 0;
 
     // Returns the data source ids that were used to supply the edge
-    // weights.  Will return an empty array when only the base profile is used.
-    virtual std::vector<uint8_t> GetUncompressedForwardDatasources(const EdgeID id) const = 0;
-    virtual std::vector<uint8_t> GetUncompressedReverseDatasources(const EdgeID id) const = 0;
+    // weights.  Will return all 0's when only the base profile is used.
+    virtual util::ArrayView<uint8_t> GetUncompressedForwardDatasources(const EdgeID id) const = 0;
+    virtual util::ArrayView<uint8_t> GetUncompressedReverseDatasources(const EdgeID id) const = 0;
 
     // Gets the name of a datasource
     virtual std::string GetDatasourceName(const uint8_t datasource_name_id) const = 0;
 
+    // Gets the speed factors of the segment from one node based node to the next for every slot
+    // of a day, see util::SpeedProfileSegment. Empty if the segment has no speed profile.
+    virtual util::ArrayView<std::uint8_t> GetSpeedProfile(const NodeID from,
+                                                          const NodeID to) const = 0;
+
     virtual extractor::guidance::TurnInstruction
     GetTurnInstructionForEdgeID(const unsigned id) const = 0;
 
     virtual extractor::TravelMode GetTravelModeForEdgeID(const unsigned id) const = 0;
 
+    // The name, component and travel mode of an edge-based node, which the segments in the
+    // R-tree leave out
+    virtual extractor::EdgeBasedNodeData GetEdgeBasedNodeData(const NodeID id) const = 0;
+
     virtual std::vector<RTreeLeaf> GetEdgesInBox(const util::Coordinate south_west,
                                                  const util::Coordinate north_east) const = 0;
 
@@ -157,15 +275,28 @@ class BaseDataFacade
 
     virtual bool IsCoreNode(const NodeID id) const = 0;
 
+    // Node of the hierarchy that stores the edge-based node with the given id, osrm-contract can
+    // write the hierarchy in another order than the extraction
+    virtual NodeID GetHierarchyNode(const NodeID edge_based_node_id) const = 0;
+
+    // Number of landmarks written by osrm-contract --core-landmarks, 0 without them
+    virtual unsigned GetNumberOfCoreLandmarks() const = 0;
+
+    // Weights of the shortest paths in the core from the landmarks to the core node, followed by
+    // the ones from the node to the landmarks. INVALID_EDGE_WEIGHT if there is no path, empty for
+    // nodes outside of the core.
+    virtual util::ArrayView<EdgeWeight> GetCoreLandmarkWeights(const NodeID id) const = 0;
+
     virtual unsigned GetNameIndexFromEdgeID(const unsigned id) const = 0;
 
-    virtual std::string GetNameForID(const unsigned name_id) const = 0;
+    // The names are views into the names of the dataset, valid as long as the facade is.
+    virtual util::StringView GetNameForID(const unsigned name_id) const = 0;
 
-    virtual std::string GetRefForID(const unsigned name_id) const = 0;
+    virtual util::StringView GetRefForID(const unsigned name_id) const = 0;
 
-    virtual std::string GetPronunciationForID(const unsigned name_id) const = 0;
+    virtual util::StringView GetPronunciationForID(const unsigned name_id) const = 0;
 
-    virtual std::string GetDestinationsForID(const unsigned name_id) const = 0;
+    virtual util::StringView GetDestinationsForID(const unsigned name_id) const = 0;
 
     virtual std::size_t GetCoreSize() const = 0;
 
@@ -186,6 +317,18 @@ class BaseDataFacade
     virtual EntryClassID GetEntryClassID(const EdgeID eid) const = 0;
 
     virtual util::guidance::EntryClass GetEntryClass(const EntryClassID entry_class_id) const = 0;
+
+  private:
+    // shared by all queries on the facade
+    std::unique_ptr<ShortcutCache> shortcut_cache;
+    std::unique_ptr<TileCache> tile_cache;
+    std::unique_ptr<PhantomNodeCache> phantom_node_cache;
+    std::unique_ptr<RouteCache> route_cache;
+    std::unique_ptr<SearchSpaceCache> search_space_cache;
+    mutable std::once_flag tile_overview_collected;
+    mutable std::unique_ptr<TileOverview> tile_overview;
+    mutable std::once_flag sweep_order_computed;
+    mutable std::vector<NodeID> sweep_order;
 };
 }
 }
@@ -13,18 +13,24 @@
 #include "extractor/original_edge_data.hpp"
 #include "extractor/profile_properties.hpp"
 #include "extractor/query_node.hpp"
+#include "storage/bulk_reader.hpp"
 #include "storage/io.hpp"
 #include "storage/storage_config.hpp"
 #include "engine/geospatial_query.hpp"
+#include "util/coordinate_list.hpp"
+#include "util/geometry_node_list.hpp"
 #include "util/graph_loader.hpp"
+#include "util/huge_pages.hpp"
 #include "util/guidance/turn_bearing.hpp"
 #include "util/guidance/turn_lanes.hpp"
 #include "util/io.hpp"
 #include "util/packed_vector.hpp"
 #include "util/range_table.hpp"
 #include "util/rectangle.hpp"
+#include "util/segment_weight_list.hpp"
 #include "util/shared_memory_vector_wrapper.hpp"
 #include "util/simple_logger.hpp"
+#include "util/speed_profile.hpp"
 #include "util/static_graph.hpp"
 #include "util/static_rtree.hpp"
 #include "util/typedefs.hpp"
@@ -35,11 +41,14 @@
 #include <cstdlib>
 
 #include <algorithm>
+#include <array>
 #include <fstream>
 #include <ios>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -50,6 +59,9 @@
 #include <boost/filesystem/path.hpp>
 #include <boost/thread/tss.hpp>
 
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_invoke.h>
+
 namespace osrm
 {
 namespace engine
@@ -62,11 +74,10 @@ class InternalDataFacade final : public BaseDataFacade
 
   private:
     using super = BaseDataFacade;
-    using QueryGraph = util::StaticGraph<typename super::EdgeData>;
-    using InputEdge = QueryGraph::InputEdge;
+    using QueryGraph = engine::QueryGraph<false>;
     using RTreeLeaf = super::RTreeLeaf;
     using InternalRTree =
-        util::StaticRTree<RTreeLeaf, util::ShM<util::Coordinate, false>::vector, false>;
+        util::StaticRTree<extractor::EdgeBasedNodeSegment, util::CoordinateList<false>, false>;
     using InternalGeospatialQuery = GeospatialQuery<InternalRTree, BaseDataFacade>;
 
     InternalDataFacade() {}
@@ -75,7 +86,7 @@ class InternalDataFacade final : public BaseDataFacade
     std::unique_ptr<QueryGraph> m_query_graph;
     std::string m_timestamp;
 
-    util::ShM<util::Coordinate, false>::vector m_coordinate_list;
+    util::CoordinateList<false> m_coordinate_list;
     util::PackedVector<OSMNodeID, false> m_osmnodeid_list;
     util::ShM<GeometryID, false>::vector m_via_geometry_list;
     util::ShM<unsigned, false>::vector m_name_ID_list;
@@ -85,18 +96,29 @@ class InternalDataFacade final : public BaseDataFacade
     util::ShM<extractor::TravelMode, false>::vector m_travel_mode_list;
     util::ShM<char, false>::vector m_names_char_list;
     util::ShM<unsigned, false>::vector m_geometry_indices;
-    util::ShM<NodeID, false>::vector m_geometry_node_list;
-    util::ShM<EdgeWeight, false>::vector m_geometry_fwd_weight_list;
-    util::ShM<EdgeWeight, false>::vector m_geometry_rev_weight_list;
+    util::GeometryNodeList<false> m_geometry_node_list;
+    util::SegmentWeightList<false> m_geometry_fwd_weight_list;
+    util::SegmentWeightList<false> m_geometry_rev_weight_list;
+    util::ShM<EdgeWeight, false>::vector m_geometry_fwd_weight_offsets;
+    util::ShM<EdgeWeight, false>::vector m_geometry_rev_weight_offsets;
+    util::ShM<SegmentLength, false>::vector m_geometry_length_list;
     util::ShM<bool, false>::vector m_is_core_node;
+    util::ShM<NodeID, false>::vector m_node_renumbering;
+    util::ShM<extractor::EdgeBasedNodeData, false>::vector m_edge_based_node_data;
+    unsigned m_number_of_core_landmarks = 0;
+    util::ShM<NodeID, false>::vector m_core_landmark_indices;
+    util::ShM<EdgeWeight, false>::vector m_core_landmark_weights;
     util::ShM<uint8_t, false>::vector m_datasource_list;
     util::ShM<std::string, false>::vector m_datasource_names;
+    util::ShM<std::uint8_t, false>::vector m_speed_profile_factors;
+    util::ShM<util::SpeedProfileSegment, false>::vector m_speed_profile_segments;
     util::ShM<std::uint32_t, false>::vector m_lane_description_offsets;
     util::ShM<extractor::guidance::TurnLaneType::Mask, false>::vector m_lane_description_masks;
     extractor::ProfileProperties m_profile_properties;
 
     std::unique_ptr<InternalRTree> m_static_rtree;
     std::unique_ptr<InternalGeospatialQuery> m_geospatial_query;
+    std::unique_ptr<util::MultiLevelGraph> m_multi_level_graph;
     boost::filesystem::path ram_index_path;
     boost::filesystem::path file_index_path;
     util::RangeTable<16, false> m_name_table;
@@ -116,6 +138,127 @@ class InternalDataFacade final : public BaseDataFacade
     util::RangeTable<16, false> m_bearing_ranges_table;
     util::ShM<DiscreteBearing, false>::vector m_bearing_values_table;
 
+    // Blocks that only guidance, names and annotations read. Table and nearest requests do not
+    // touch most of them, with lazy loading they are read from their files on first access.
+    enum LazyBlock
+    {
+        STREET_NAMES,
+        TURN_LANES,
+        INTERSECTION_CLASSES,
+        DATASOURCES,
+        NUM_LAZY_BLOCKS
+    };
+    storage::StorageConfig storage_config;
+    mutable std::array<std::once_flag, NUM_LAZY_BLOCKS> lazy_blocks_loaded;
+
+    bool use_huge_pages = false;
+    bool compress_coordinates = false;
+    bool weight_offsets = false;
+    bool compress_geometries = false;
+    // arrays advised to be backed by huge pages, the files are loaded in parallel
+    std::vector<std::pair<const void *, std::size_t>> huge_page_ranges;
+    std::mutex huge_page_ranges_mutex;
+
+    // Sizes the vector, advising huge pages for it before its pages are touched the first time
+    template <typename VectorT> void Allocate(VectorT &vector, const std::size_t size)
+    {
+        if (use_huge_pages)
+        {
+            vector.reserve(size);
+            const auto bytes = size * sizeof(typename VectorT::value_type);
+            if (util::adviseHugePages(vector.data(), bytes))
+            {
+                std::lock_guard<std::mutex> lock(huge_page_ranges_mutex);
+                huge_page_ranges.emplace_back(vector.data(), bytes);
+            }
+        }
+        vector.resize(size);
+    }
+
+    void ReportHugePages() const
+    {
+        std::size_t advised_bytes = 0;
+        std::size_t huge_page_bytes = 0;
+        for (const auto &range : huge_page_ranges)
+        {
+            advised_bytes += range.second;
+            huge_page_bytes += util::getHugePageBackedBytes(range.first, range.second);
+        }
+        util::SimpleLogger().Write() << huge_page_bytes << " of " << advised_bytes
+                                     << " bytes of graph and geometry data are backed by huge "
+                                        "pages";
+    }
+
+    // Loads the block unless it already is, safe to call from concurrent queries
+    void LoadLazyBlock(const LazyBlock block) const
+    {
+        std::call_once(lazy_blocks_loaded[block], [this, block] {
+            // facades are never constant objects, only their query interface is
+            auto &facade = const_cast<InternalDataFacade &>(*this);
+            facade.LoadBlock(block);
+        });
+    }
+
+    void LoadBlock(const LazyBlock block)
+    {
+        switch (block)
+        {
+        case STREET_NAMES:
+            util::SimpleLogger().Write() << "loading street names";
+            LoadStreetNames(storage_config.names_data_path);
+            break;
+        case TURN_LANES:
+            util::SimpleLogger().Write() << "loading lane tags";
+            LoadLaneDescriptions(storage_config.turn_lane_description_path);
+            util::SimpleLogger().Write() << "Loading Lane Data Pairs";
+            LoadLaneTupleIdPairs(storage_config.turn_lane_data_path);
+            break;
+        case INTERSECTION_CLASSES:
+            util::SimpleLogger().Write() << "loading intersection class data";
+            LoadIntersectionClasses(storage_config.intersection_class_path);
+            break;
+        case DATASOURCES:
+            util::SimpleLogger().Write() << "loading datasource info";
+            LoadDatasourceInfo(storage_config.datasource_names_path,
+                               storage_config.datasource_indexes_path);
+            break;
+        default:
+            BOOST_ASSERT_MSG(false, "unknown lazy block");
+        }
+        util::SimpleLogger().Write() << GetLazyBlockBytes(block) << " bytes resident for "
+                                     << GetLazyBlockName(block);
+    }
+
+    static const char *GetLazyBlockName(const LazyBlock block)
+    {
+        const constexpr char *names[NUM_LAZY_BLOCKS] = {
+            "street names", "lane tags", "intersection classes", "datasources"};
+        return names[block];
+    }
+
+    // Approximate resident size of the arrays of a lazy block, 0 if it is not loaded yet
+    std::size_t GetLazyBlockBytes(const LazyBlock block) const
+    {
+        const auto bytes = [](const auto &vector) {
+            return vector.size() * sizeof(typename std::decay_t<decltype(vector)>::value_type);
+        };
+        switch (block)
+        {
+        case STREET_NAMES:
+            return bytes(m_names_char_list);
+        case TURN_LANES:
+            return bytes(m_lane_description_offsets) + bytes(m_lane_description_masks) +
+                   bytes(m_lane_tuple_id_pairs);
+        case INTERSECTION_CLASSES:
+            return bytes(m_bearing_class_id_table) + bytes(m_bearing_values_table) +
+                   bytes(m_entry_class_table);
+        case DATASOURCES:
+            return bytes(m_datasource_list);
+        default:
+            return 0;
+        }
+    }
+
     void LoadProfileProperties(const boost::filesystem::path &properties_path)
     {
         boost::filesystem::ifstream in_stream(properties_path);
@@ -158,25 +301,26 @@ class InternalDataFacade final : public BaseDataFacade
 
     void LoadGraph(const boost::filesystem::path &hsgr_path)
     {
-        boost::filesystem::ifstream hsgr_input_stream(hsgr_path);
-        if (!hsgr_input_stream)
-        {
-            throw util::exception("Could not open " + hsgr_path.string() + " for reading.");
-        }
-
-        const auto header = storage::io::readHSGRHeader(hsgr_input_stream);
+        storage::io::BulkReader hsgr_reader(hsgr_path);
+        const auto header = storage::io::readHSGRHeader(hsgr_reader);
         m_check_sum = header.checksum;
 
-        util::ShM<QueryGraph::NodeArrayEntry, false>::vector node_list(header.number_of_nodes);
-        util::ShM<QueryGraph::EdgeArrayEntry, false>::vector edge_list(header.number_of_edges);
+        util::ShM<QueryGraph::NodeArrayEntry, false>::vector node_list;
+        util::ShM<HotEdgeData, false>::vector hot_edge_list;
+        util::ShM<ColdEdgeData, false>::vector cold_edge_list;
+        Allocate(node_list, header.number_of_nodes);
+        Allocate(hot_edge_list, header.number_of_edges);
+        Allocate(cold_edge_list, header.number_of_edges);
 
-        storage::io::readHSGR(hsgr_input_stream,
+        storage::io::readHSGR(hsgr_reader,
                               node_list.data(),
                               header.number_of_nodes,
-                              edge_list.data(),
+                              hot_edge_list.data(),
+                              cold_edge_list.data(),
                               header.number_of_edges);
 
-        m_query_graph = std::unique_ptr<QueryGraph>(new QueryGraph(node_list, edge_list));
+        m_query_graph = std::unique_ptr<QueryGraph>(
+            new QueryGraph(node_list, hot_edge_list, cold_edge_list));
 
         util::SimpleLogger().Write() << "Data checksum is " << m_check_sum;
     }
@@ -191,10 +335,40 @@ class InternalDataFacade final : public BaseDataFacade
         }
 
         const auto number_of_coordinates = storage::io::readElementCount(nodes_input_stream);
-        m_coordinate_list.resize(number_of_coordinates);
+        util::ShM<util::Coordinate, false>::vector coordinates;
+        if (compress_coordinates)
+        {
+            // the plain coordinates are only needed until they are compressed
+            coordinates.resize(number_of_coordinates);
+        }
+        else
+        {
+            Allocate(coordinates, number_of_coordinates);
+        }
         m_osmnodeid_list.reserve(number_of_coordinates);
         storage::io::readNodes(
-            nodes_input_stream, m_coordinate_list.data(), m_osmnodeid_list, number_of_coordinates);
+            nodes_input_stream, coordinates.data(), m_osmnodeid_list, number_of_coordinates);
+
+        if (compress_coordinates)
+        {
+            util::CoordinateEncoder counter;
+            for (const auto &coordinate : coordinates)
+                counter.push_back(coordinate);
+
+            util::ShM<util::CoordinateBlock, false>::vector blocks;
+            util::ShM<std::uint8_t, false>::vector bytes;
+            Allocate(blocks, counter.GetNumberOfBlocks());
+            Allocate(bytes, counter.GetNumberOfBytes());
+            util::CoordinateEncoder encoder(blocks.data(), bytes.data());
+            for (const auto &coordinate : coordinates)
+                encoder.push_back(coordinate);
+
+            m_coordinate_list = util::CoordinateList<false>(blocks, bytes, number_of_coordinates);
+        }
+        else
+        {
+            m_coordinate_list = util::CoordinateList<false>(coordinates);
+        }
 
         boost::filesystem::ifstream edges_input_stream(edges_file_path, std::ios::binary);
         if (!edges_input_stream)
@@ -202,7 +376,7 @@ class InternalDataFacade final : public BaseDataFacade
             throw util::exception("Could not open " + edges_file_path.string() + " for reading.");
         }
         const auto number_of_edges = storage::io::readElementCount(edges_input_stream);
-        m_via_geometry_list.resize(number_of_edges);
+        Allocate(m_via_geometry_list, number_of_edges);
         m_name_ID_list.resize(number_of_edges);
         m_turn_instruction_list.resize(number_of_edges);
         m_lane_data_id.resize(number_of_edges);
@@ -246,38 +420,188 @@ class InternalDataFacade final : public BaseDataFacade
         }
     }
 
+    // The renumbering is optional, without it the hierarchy is in the order of the extraction
+    void LoadNodeRenumbering(const boost::filesystem::path &renumbering_file)
+    {
+        if (!boost::filesystem::exists(renumbering_file))
+        {
+            return;
+        }
+        if (!util::deserializeVector(renumbering_file.string(), m_node_renumbering))
+        {
+            throw util::exception("Could not read the node renumbering from " +
+                                  renumbering_file.string());
+        }
+    }
+
+    void LoadEdgeBasedNodeData(const boost::filesystem::path &edge_based_nodes_file)
+    {
+        if (!util::deserializeVector(edge_based_nodes_file.string(), m_edge_based_node_data))
+        {
+            throw util::exception("Could not read the edge-based nodes from " +
+                                  edge_based_nodes_file.string());
+        }
+    }
+
+    // The landmarks are optional, the core is searched without a goal direction without them
+    void LoadCoreLandmarks(const boost::filesystem::path &landmarks_file)
+    {
+        boost::filesystem::ifstream landmarks_stream(landmarks_file, std::ios::binary);
+        if (!landmarks_stream)
+        {
+            return;
+        }
+        if (!util::readAndCheckFingerprint(landmarks_stream) ||
+            !landmarks_stream.read(reinterpret_cast<char *>(&m_number_of_core_landmarks),
+                                   sizeof(m_number_of_core_landmarks)) ||
+            !util::deserializeVector(landmarks_stream, m_core_landmark_indices) ||
+            !util::deserializeVector(landmarks_stream, m_core_landmark_weights))
+        {
+            throw util::exception("Could not read the core landmarks from " +
+                                  landmarks_file.string());
+        }
+        if (m_core_landmark_indices.size() != m_is_core_node.size())
+        {
+            throw util::exception("The core landmarks " + landmarks_file.string() +
+                                  " do not belong to the core of the hierarchy");
+        }
+    }
+
+    // The arrays of the geometry file are preceded by their counts, all are read at once
     void LoadGeometries(const boost::filesystem::path &geometry_file)
     {
-        std::ifstream geometry_stream(geometry_file.string().c_str(), std::ios::binary);
-        unsigned number_of_indices = 0;
-        unsigned number_of_compressed_geometries = 0;
+        storage::io::BulkReader geometry_reader(geometry_file);
+        const auto number_of_indices = geometry_reader.Read<unsigned>(0);
+        Allocate(m_geometry_indices, number_of_indices);
+        geometry_reader.Queue(
+            sizeof(unsigned), m_geometry_indices.data(), number_of_indices * sizeof(unsigned));
+
+        const auto nodes_offset = (1 + std::uint64_t{number_of_indices}) * sizeof(unsigned);
+        const auto number_of_compressed_geometries = geometry_reader.Read<unsigned>(nodes_offset);
+        util::ShM<NodeID, false>::vector nodes;
+        if (compress_geometries)
+        {
+            // the plain nodes are only needed until they are compressed
+            nodes.resize(number_of_compressed_geometries);
+        }
+        else
+        {
+            Allocate(nodes, number_of_compressed_geometries);
+        }
+        const auto nodes_size = number_of_compressed_geometries * sizeof(NodeID);
+        geometry_reader.Queue(nodes_offset + sizeof(unsigned), nodes.data(), nodes_size);
+
+        std::vector<EdgeWeight> fwd_weights(number_of_compressed_geometries);
+        std::vector<EdgeWeight> rev_weights(number_of_compressed_geometries);
+        const auto weights_size = number_of_compressed_geometries * sizeof(EdgeWeight);
+        const auto weights_offset = nodes_offset + sizeof(unsigned) + nodes_size;
+        geometry_reader.Queue(weights_offset, fwd_weights.data(), weights_size);
+        geometry_reader.Queue(weights_offset + weights_size, rev_weights.data(), weights_size);
+        geometry_reader.Wait();
+        BOOST_ASSERT(m_geometry_indices.back() == number_of_compressed_geometries);
 
-        geometry_stream.read((char *)&number_of_indices, sizeof(unsigned));
+        if (compress_geometries)
+        {
+            util::GeometryNodeEncoder counter;
+            for (const auto node : nodes)
+                counter.push_back(node);
+
+            util::ShM<util::GeometryNodeBlock, false>::vector blocks;
+            util::ShM<std::uint8_t, false>::vector bytes;
+            Allocate(blocks, counter.GetNumberOfBlocks());
+            Allocate(bytes, counter.GetNumberOfBytes());
+            util::GeometryNodeEncoder encoder(blocks.data(), bytes.data());
+            for (const auto node : nodes)
+                encoder.push_back(node);
+
+            m_geometry_node_list =
+                util::GeometryNodeList<false>(blocks, bytes, number_of_compressed_geometries);
+        }
+        else
+        {
+            m_geometry_node_list = util::GeometryNodeList<false>(nodes);
+        }
+
+        m_geometry_fwd_weight_list = LoadSegmentWeights(fwd_weights);
+        m_geometry_rev_weight_list = LoadSegmentWeights(rev_weights);
+
+        if (weight_offsets)
+        {
+            Allocate(m_geometry_fwd_weight_offsets, number_of_compressed_geometries);
+            Allocate(m_geometry_rev_weight_offsets, number_of_compressed_geometries);
+            std::copy(fwd_weights.begin(), fwd_weights.end(), m_geometry_fwd_weight_offsets.data());
+            std::copy(rev_weights.begin(), rev_weights.end(), m_geometry_rev_weight_offsets.data());
+            util::toSegmentWeightOffsets(m_geometry_indices.data(),
+                                         m_geometry_indices.data() + m_geometry_indices.size(),
+                                         m_geometry_fwd_weight_offsets.data(),
+                                         m_geometry_rev_weight_offsets.data());
+        }
+    }
 
-        m_geometry_indices.resize(number_of_indices);
-        if (number_of_indices > 0)
+    // Packs the weights of the geometry file to 16 bits
+    util::SegmentWeightList<false> LoadSegmentWeights(const std::vector<EdgeWeight> &weights)
+    {
+        const auto number_of_weights = weights.size();
+        util::SegmentWeightEncoder counter;
+        for (const auto weight : weights)
         {
-            geometry_stream.read((char *)&(m_geometry_indices[0]),
-                                 number_of_indices * sizeof(unsigned));
+            counter.push_back(weight);
         }
 
-        geometry_stream.read((char *)&number_of_compressed_geometries, sizeof(unsigned));
+        util::ShM<std::uint16_t, false>::vector values;
+        util::ShM<util::SegmentWeightOverflow, false>::vector overflows;
+        Allocate(values, number_of_weights);
+        Allocate(overflows, counter.GetNumberOfOverflows());
+        util::SegmentWeightEncoder encoder(values.data(), overflows.data());
+        for (const auto weight : weights)
+        {
+            encoder.push_back(weight);
+        }
+        return util::SegmentWeightList<false>(values, overflows);
+    }
 
-        BOOST_ASSERT(m_geometry_indices.back() == number_of_compressed_geometries);
-        m_geometry_node_list.resize(number_of_compressed_geometries);
-        m_geometry_fwd_weight_list.resize(number_of_compressed_geometries);
-        m_geometry_rev_weight_list.resize(number_of_compressed_geometries);
+    // The segment lengths are optional, without them they are computed from the coordinates
+    void LoadSegmentLengths(const boost::filesystem::path &segment_lengths_file)
+    {
+        if (!boost::filesystem::exists(segment_lengths_file))
+        {
+            return;
+        }
 
-        if (number_of_compressed_geometries > 0)
+        storage::io::BulkReader segment_lengths_reader(segment_lengths_file);
+        const auto number_of_segment_lengths = segment_lengths_reader.Read<std::uint64_t>(0);
+        if (number_of_segment_lengths != m_geometry_node_list.size())
         {
-            geometry_stream.read((char *)&(m_geometry_node_list[0]),
-                                 number_of_compressed_geometries * sizeof(NodeID));
+            throw util::exception(segment_lengths_file.string() +
+                                  " does not match the geometries of the dataset.");
+        }
+        Allocate(m_geometry_length_list, number_of_segment_lengths);
+        if (number_of_segment_lengths > 0)
+        {
+            storage::io::readSegmentLengths(
+                segment_lengths_reader, &m_geometry_length_list[0], number_of_segment_lengths);
+        }
+    }
 
-            geometry_stream.read((char *)&(m_geometry_fwd_weight_list[0]),
-                                 number_of_compressed_geometries * sizeof(EdgeWeight));
+    // The speed profiles are optional, without them all segments keep their static weights
+    void LoadSpeedProfiles(const boost::filesystem::path &speed_profiles_file)
+    {
+        boost::filesystem::ifstream speed_profiles_stream(speed_profiles_file, std::ios::binary);
+        if (!speed_profiles_stream)
+        {
+            return;
+        }
 
-            geometry_stream.read((char *)&(m_geometry_rev_weight_list[0]),
-                                 number_of_compressed_geometries * sizeof(EdgeWeight));
+        const auto header = storage::io::readSpeedProfilesHeader(speed_profiles_stream);
+        if (header.number_of_segments > 0)
+        {
+            m_speed_profile_factors.resize(header.number_of_factors);
+            m_speed_profile_segments.resize(header.number_of_segments);
+            storage::io::readSpeedProfiles(speed_profiles_stream,
+                                           m_speed_profile_factors.data(),
+                                           header.number_of_factors,
+                                           m_speed_profile_segments.data(),
+                                           header.number_of_segments);
         }
     }
 
@@ -411,46 +735,107 @@ class InternalDataFacade final : public BaseDataFacade
         m_geospatial_query.reset();
     }
 
-    explicit InternalDataFacade(const storage::StorageConfig &config)
+    explicit InternalDataFacade(const storage::StorageConfig &config,
+                                const bool prefetch_rtree_leaves = false,
+                                const bool use_huge_pages = false,
+                                const bool lazy_blocks = false,
+                                const bool compress_coordinates = false,
+                                const bool weight_offsets = false,
+                                const bool compress_geometries = false)
+        : storage_config(config), use_huge_pages(use_huge_pages),
+          compress_coordinates(compress_coordinates), weight_offsets(weight_offsets),
+          compress_geometries(compress_geometries)
     {
         ram_index_path = config.ram_index_path;
         file_index_path = config.file_index_path;
 
-        util::SimpleLogger().Write() << "loading graph data";
-        LoadGraph(config.hsgr_data_path);
-
-        util::SimpleLogger().Write() << "loading edge information";
-        LoadNodeAndEdgeInformation(config.nodes_data_path, config.edges_data_path);
-
-        util::SimpleLogger().Write() << "loading core information";
-        LoadCoreInformation(config.core_data_path);
-
-        util::SimpleLogger().Write() << "loading geometries";
-        LoadGeometries(config.geometries_path);
-
-        util::SimpleLogger().Write() << "loading datasource info";
-        LoadDatasourceInfo(config.datasource_names_path, config.datasource_indexes_path);
-
-        util::SimpleLogger().Write() << "loading timestamp";
-        LoadTimestamp(config.timestamp_path);
-
-        util::SimpleLogger().Write() << "loading profile properties";
-        LoadProfileProperties(config.properties_path);
-
-        util::SimpleLogger().Write() << "loading street names";
-        LoadStreetNames(config.names_data_path);
-
-        util::SimpleLogger().Write() << "loading lane tags";
-        LoadLaneDescriptions(config.turn_lane_description_path);
-
-        util::SimpleLogger().Write() << "loading rtree";
-        LoadRTree();
+        // the files are independent except for the r-tree, which needs the coordinates, and the
+        // segment lengths, which are checked against the geometries
+        tbb::parallel_invoke(
+            [&] {
+                util::SimpleLogger().Write() << "loading graph data";
+                LoadGraph(config.hsgr_data_path);
+            },
+            [&] {
+                util::SimpleLogger().Write() << "loading edge information";
+                LoadNodeAndEdgeInformation(config.nodes_data_path, config.edges_data_path);
+
+                util::SimpleLogger().Write() << "loading rtree";
+                LoadEdgeBasedNodeData(config.edge_based_nodes_data_path);
+                LoadRTree();
+                if (prefetch_rtree_leaves)
+                {
+                    util::SimpleLogger().Write() << "prefetching rtree leaves";
+                    m_static_rtree->PrefetchLeafNodes();
+                }
+            },
+            [&] {
+                util::SimpleLogger().Write() << "loading core information";
+                LoadCoreInformation(config.core_data_path);
+                LoadNodeRenumbering(config.node_renumbering_path);
+                LoadCoreLandmarks(config.core_landmarks_path);
+            },
+            [&] {
+                util::SimpleLogger().Write() << "loading geometries";
+                LoadGeometries(config.geometries_path);
+                LoadSegmentLengths(config.segment_lengths_path);
+            },
+            [&] {
+                util::SimpleLogger().Write() << "loading speed profiles";
+                LoadSpeedProfiles(config.speed_profiles_path);
+
+                util::SimpleLogger().Write() << "loading timestamp";
+                LoadTimestamp(config.timestamp_path);
+
+                util::SimpleLogger().Write() << "loading profile properties";
+                LoadProfileProperties(config.properties_path);
+            },
+            [&] {
+                if (lazy_blocks)
+                {
+                    util::SimpleLogger().Write() << "street names, lane tags, intersection "
+                                                    "classes and datasources are loaded on "
+                                                    "first use";
+                    return;
+                }
+                tbb::parallel_for(0, static_cast<int>(NUM_LAZY_BLOCKS), [this](const int block) {
+                    LoadLazyBlock(static_cast<LazyBlock>(block));
+                });
+            });
+
+        if (use_huge_pages)
+        {
+            ReportHugePages();
+        }
+    }
 
-        util::SimpleLogger().Write() << "loading intersection class data";
-        LoadIntersectionClasses(config.intersection_class_path);
+    // The overlay graph shares the node ids of the phantom nodes, which are those of the hierarchy
+    void LoadMultiLevelGraph(const boost::filesystem::path &graph_file)
+    {
+        if (!m_node_renumbering.empty())
+        {
+            throw util::exception("The MLD algorithm does not support datasets contracted with "
+                                  "--renumber-nodes");
+        }
+        util::SimpleLogger().Write() << "loading multi-level graph";
+        boost::filesystem::ifstream graph_stream(graph_file, std::ios::binary);
+        auto graph = std::unique_ptr<util::MultiLevelGraph>(new util::MultiLevelGraph());
+        if (!graph_stream || !graph->Read(graph_stream))
+        {
+            throw util::exception("Could not read the multi-level graph from " +
+                                  graph_file.string() + ", run osrm-contract --mld first");
+        }
+        if (graph->GetNumberOfNodes() != GetNumberOfNodes())
+        {
+            throw util::exception("The multi-level graph " + graph_file.string() +
+                                  " does not belong to the dataset");
+        }
+        m_multi_level_graph = std::move(graph);
+    }
 
-        util::SimpleLogger().Write() << "Loading Lane Data Pairs";
-        LoadLaneTupleIdPairs(config.turn_lane_data_path);
+    const util::MultiLevelGraph *GetMultiLevelGraph() const override final
+    {
+        return m_multi_level_graph.get();
     }
 
     // search graph access
@@ -465,11 +850,16 @@ class InternalDataFacade final : public BaseDataFacade
 
     NodeID GetTarget(const EdgeID e) const override final { return m_query_graph->GetTarget(e); }
 
-    EdgeData &GetEdgeData(const EdgeID e) const override final
+    EdgeData GetEdgeData(const EdgeID e) const override final
     {
         return m_query_graph->GetEdgeData(e);
     }
 
+    const HotEdgeData &GetHotEdgeData(const EdgeID e) const override final
+    {
+        return m_query_graph->GetHotEdgeData(e);
+    }
+
     EdgeID BeginEdges(const NodeID n) const override final { return m_query_graph->BeginEdges(n); }
 
     EdgeID EndEdges(const NodeID n) const override final { return m_query_graph->EndEdges(n); }
@@ -479,6 +869,16 @@ class InternalDataFacade final : public BaseDataFacade
         return m_query_graph->GetAdjacentEdgeRange(node);
     }
 
+    EdgeRange GetForwardEdgeRange(const NodeID node) const override final
+    {
+        return m_query_graph->GetForwardEdgeRange(node);
+    }
+
+    EdgeRange GetBackwardEdgeRange(const NodeID node) const override final
+    {
+        return m_query_graph->GetBackwardEdgeRange(node);
+    }
+
     // searches for a specific edge
     EdgeID FindEdge(const NodeID from, const NodeID to) const override final
     {
@@ -525,6 +925,12 @@ class InternalDataFacade final : public BaseDataFacade
         return m_travel_mode_list.at(id);
     }
 
+    extractor::EdgeBasedNodeData GetEdgeBasedNodeData(const NodeID id) const override final
+    {
+        BOOST_ASSERT(id < m_edge_based_node_data.size());
+        return m_edge_based_node_data[id];
+    }
+
     std::vector<RTreeLeaf> GetEdgesInBox(const util::Coordinate south_west,
                                          const util::Coordinate north_east) const override final
     {
@@ -647,27 +1053,23 @@ class InternalDataFacade final : public BaseDataFacade
         return m_name_ID_list.at(id);
     }
 
-    std::string GetNameForID(const unsigned name_id) const override final
+    util::StringView GetNameForID(const unsigned name_id) const override final
     {
         if (std::numeric_limits<unsigned>::max() == name_id)
         {
             return "";
         }
+        LoadLazyBlock(STREET_NAMES);
         auto range = m_name_table.GetRange(name_id);
 
-        std::string result;
-        result.reserve(range.size());
-        if (range.begin() != range.end())
+        if (range.size() == 0)
         {
-            result.resize(range.back() - range.front() + 1);
-            std::copy(m_names_char_list.begin() + range.front(),
-                      m_names_char_list.begin() + range.back() + 1,
-                      result.begin());
+            return "";
         }
-        return result;
+        return util::StringView(m_names_char_list.data() + range.front(), range.size());
     }
 
-    std::string GetRefForID(const unsigned name_id) const override final
+    util::StringView GetRefForID(const unsigned name_id) const override final
     {
         // We store the ref after the name, destination and pronunciation of a street.
         // We do this to get around the street length limit of 255 which would hit
@@ -676,7 +1078,7 @@ class InternalDataFacade final : public BaseDataFacade
         return GetNameForID(name_id + 3);
     }
 
-    std::string GetPronunciationForID(const unsigned name_id) const override final
+    util::StringView GetPronunciationForID(const unsigned name_id) const override final
     {
         // We store the pronunciation after the name and destination of a street.
         // We do this to get around the street length limit of 255 which would hit
@@ -685,7 +1087,7 @@ class InternalDataFacade final : public BaseDataFacade
         return GetNameForID(name_id + 2);
     }
 
-    std::string GetDestinationsForID(const unsigned name_id) const override final
+    util::StringView GetDestinationsForID(const unsigned name_id) const override final
     {
         // We store the destination after the name of a street.
         // We do this to get around the street length limit of 255 which would hit
@@ -701,6 +1103,28 @@ class InternalDataFacade final : public BaseDataFacade
 
     virtual std::size_t GetCoreSize() const override final { return m_is_core_node.size(); }
 
+    NodeID GetHierarchyNode(const NodeID edge_based_node_id) const override final
+    {
+        return m_node_renumbering.empty() ? edge_based_node_id
+                                          : m_node_renumbering[edge_based_node_id];
+    }
+
+    unsigned GetNumberOfCoreLandmarks() const override final
+    {
+        return m_core_landmark_indices.empty() ? 0 : m_number_of_core_landmarks;
+    }
+
+    util::ArrayView<EdgeWeight> GetCoreLandmarkWeights(const NodeID id) const override final
+    {
+        if (m_core_landmark_indices.empty() || m_core_landmark_indices[id] == SPECIAL_NODEID)
+        {
+            return {};
+        }
+        const std::size_t stride = 2 * m_number_of_core_landmarks;
+        const auto first = &m_core_landmark_weights[m_core_landmark_indices[id] * stride];
+        return {first, first + stride};
+    }
+
     virtual bool IsCoreNode(const NodeID id) const override final
     {
         if (m_is_core_node.size() > 0)
@@ -713,7 +1137,8 @@ class InternalDataFacade final : public BaseDataFacade
         }
     }
 
-    virtual std::vector<NodeID> GetUncompressedForwardGeometry(const EdgeID id) const override final
+    virtual util::GeometryNodeView
+    GetUncompressedForwardGeometry(const EdgeID id) const override final
     {
         /*
          * NodeID's for geometries are stored in one place for
@@ -727,18 +1152,11 @@ class InternalDataFacade final : public BaseDataFacade
         const unsigned begin = m_geometry_indices.at(id);
         const unsigned end = m_geometry_indices.at(id + 1);
 
-        std::vector<NodeID> result_nodes;
-
-        result_nodes.resize(end - begin);
-
-        std::copy(m_geometry_node_list.begin() + begin,
-                  m_geometry_node_list.begin() + end,
-                  result_nodes.begin());
-
-        return result_nodes;
+        return m_geometry_node_list.GetView(begin, end);
     }
 
-    virtual std::vector<NodeID> GetUncompressedReverseGeometry(const EdgeID id) const override final
+    virtual util::GeometryNodeView
+    GetUncompressedReverseGeometry(const EdgeID id) const override final
     {
         /*
          * NodeID's for geometries are stored in one place for
@@ -750,18 +1168,10 @@ class InternalDataFacade final : public BaseDataFacade
         const unsigned begin = m_geometry_indices.at(id);
         const unsigned end = m_geometry_indices.at(id + 1);
 
-        std::vector<NodeID> result_nodes;
-
-        result_nodes.resize(end - begin);
-
-        std::copy(m_geometry_node_list.rbegin() + (m_geometry_node_list.size() - end),
-                  m_geometry_node_list.rbegin() + (m_geometry_node_list.size() - begin),
-                  result_nodes.begin());
-
-        return result_nodes;
+        return m_geometry_node_list.GetView(begin, end, true);
     }
 
-    virtual std::vector<EdgeWeight>
+    virtual util::SegmentWeightView
     GetUncompressedForwardWeights(const EdgeID id) const override final
     {
         /*
@@ -774,17 +1184,10 @@ class InternalDataFacade final : public BaseDataFacade
         const unsigned begin = m_geometry_indices.at(id) + 1;
         const unsigned end = m_geometry_indices.at(id + 1);
 
-        std::vector<EdgeWeight> result_weights;
-        result_weights.resize(end - begin);
-
-        std::copy(m_geometry_fwd_weight_list.begin() + begin,
-                  m_geometry_fwd_weight_list.begin() + end,
-                  result_weights.begin());
-
-        return result_weights;
+        return m_geometry_fwd_weight_list.GetView(begin, end);
     }
 
-    virtual std::vector<EdgeWeight>
+    virtual util::SegmentWeightView
     GetUncompressedReverseWeights(const EdgeID id) const override final
     {
         /*
@@ -799,19 +1202,79 @@ class InternalDataFacade final : public BaseDataFacade
         const unsigned begin = m_geometry_indices.at(id);
         const unsigned end = m_geometry_indices.at(id + 1) - 1;
 
-        std::vector<EdgeWeight> result_weights;
-        result_weights.resize(end - begin);
+        return m_geometry_rev_weight_list.GetView(begin, end, true);
+    }
 
-        std::copy(m_geometry_rev_weight_list.rbegin() + (m_geometry_rev_weight_list.size() - end),
-                  m_geometry_rev_weight_list.rbegin() + (m_geometry_rev_weight_list.size() - begin),
-                  result_weights.begin());
+    virtual util::ArrayView<EdgeWeight>
+    GetUncompressedForwardWeightOffsets(const EdgeID id) const override final
+    {
+        // The offsets are stored for every node of the geometry
+        if (m_geometry_fwd_weight_offsets.empty())
+        {
+            return {};
+        }
 
-        return result_weights;
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+
+        return util::ArrayView<EdgeWeight>(m_geometry_fwd_weight_offsets.data() + begin,
+                                           m_geometry_fwd_weight_offsets.data() + end);
+    }
+
+    virtual util::ArrayView<EdgeWeight>
+    GetUncompressedReverseWeightOffsets(const EdgeID id) const override final
+    {
+        // The reverse offsets are sums to the end of the geometry, read in reverse they are the
+        // offsets of the reverse weights
+        if (m_geometry_rev_weight_offsets.empty())
+        {
+            return {};
+        }
+
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+
+        return util::ArrayView<EdgeWeight>(m_geometry_rev_weight_offsets.data() + begin,
+                                           m_geometry_rev_weight_offsets.data() + end,
+                                           true);
+    }
+
+    virtual util::ArrayView<SegmentLength>
+    GetUncompressedForwardLengths(const EdgeID id) const override final
+    {
+        // The lengths are stored like the forward weights
+        if (m_geometry_length_list.empty())
+        {
+            return {};
+        }
+
+        const unsigned begin = m_geometry_indices.at(id) + 1;
+        const unsigned end = m_geometry_indices.at(id + 1);
+
+        return util::ArrayView<SegmentLength>(m_geometry_length_list.data() + begin,
+                                              m_geometry_length_list.data() + end);
+    }
+
+    virtual util::ArrayView<SegmentLength>
+    GetUncompressedReverseLengths(const EdgeID id) const override final
+    {
+        // A segment has the same length in both directions, so these are the forward lengths
+        // read in reverse
+        if (m_geometry_length_list.empty())
+        {
+            return {};
+        }
+
+        const unsigned begin = m_geometry_indices.at(id) + 1;
+        const unsigned end = m_geometry_indices.at(id + 1);
+
+        return util::ArrayView<SegmentLength>(
+            m_geometry_length_list.data() + begin, m_geometry_length_list.data() + end, true);
     }
 
     // Returns the data source ids that were used to supply the edge
     // weights.
-    virtual std::vector<uint8_t>
+    virtual util::ArrayView<uint8_t>
     GetUncompressedForwardDatasources(const EdgeID id) const override final
     {
         /*
@@ -826,30 +1289,20 @@ class InternalDataFacade final : public BaseDataFacade
         const unsigned begin = m_geometry_indices.at(id) + 1;
         const unsigned end = m_geometry_indices.at(id + 1);
 
-        std::vector<uint8_t> result_datasources;
-        result_datasources.resize(end - begin);
-
+        LoadLazyBlock(DATASOURCES);
         // If there was no datasource info, return an array of 0's.
         if (m_datasource_list.empty())
         {
-            for (unsigned i = 0; i < end - begin; ++i)
-            {
-                result_datasources.push_back(0);
-            }
-        }
-        else
-        {
-            std::copy(m_datasource_list.begin() + begin,
-                      m_datasource_list.begin() + end,
-                      result_datasources.begin());
+            return util::ArrayView<uint8_t>(end - begin);
         }
 
-        return result_datasources;
+        return util::ArrayView<uint8_t>(m_datasource_list.data() + begin,
+                                        m_datasource_list.data() + end);
     }
 
     // Returns the data source ids that were used to supply the edge
     // weights.
-    virtual std::vector<uint8_t>
+    virtual util::ArrayView<uint8_t>
     GetUncompressedReverseDatasources(const EdgeID id) const override final
     {
         /*
@@ -864,34 +1317,43 @@ class InternalDataFacade final : public BaseDataFacade
         const unsigned begin = m_geometry_indices.at(id);
         const unsigned end = m_geometry_indices.at(id + 1) - 1;
 
-        std::vector<uint8_t> result_datasources;
-        result_datasources.resize(end - begin);
-
+        LoadLazyBlock(DATASOURCES);
         // If there was no datasource info, return an array of 0's.
         if (m_datasource_list.empty())
         {
-            for (unsigned i = 0; i < end - begin; ++i)
-            {
-                result_datasources.push_back(0);
-            }
-        }
-        else
-        {
-            std::copy(m_datasource_list.rbegin() + (m_datasource_list.size() - end),
-                      m_datasource_list.rbegin() + (m_datasource_list.size() - begin),
-                      result_datasources.begin());
+            return util::ArrayView<uint8_t>(end - begin);
         }
 
-        return result_datasources;
+        return util::ArrayView<uint8_t>(
+            m_datasource_list.data() + begin, m_datasource_list.data() + end, true);
     }
 
     virtual std::string GetDatasourceName(const uint8_t datasource_name_id) const override final
     {
+        LoadLazyBlock(DATASOURCES);
         BOOST_ASSERT(m_datasource_names.size() >= 1);
         BOOST_ASSERT(m_datasource_names.size() > datasource_name_id);
         return m_datasource_names[datasource_name_id];
     }
 
+    util::ArrayView<std::uint8_t> GetSpeedProfile(const NodeID from,
+                                                  const NodeID to) const override final
+    {
+        const util::SpeedProfileSegment key{from, to, 0};
+        const auto segments_end = m_speed_profile_segments.data() + m_speed_profile_segments.size();
+        const auto segment =
+            std::lower_bound(m_speed_profile_segments.data(), segments_end, key);
+        if (segment == segments_end || segment->from != from || segment->to != to)
+        {
+            return {};
+        }
+
+        BOOST_ASSERT(segment->offset + util::SPEED_PROFILE_SLOTS <=
+                     m_speed_profile_factors.size());
+        const auto first = m_speed_profile_factors.data() + segment->offset;
+        return util::ArrayView<std::uint8_t>(first, first + util::SPEED_PROFILE_SLOTS);
+    }
+
     std::string GetTimestamp() const override final { return m_timestamp; }
 
     bool GetContinueStraightDefault() const override final
@@ -906,6 +1368,7 @@ class InternalDataFacade final : public BaseDataFacade
 
     BearingClassID GetBearingClassID(const NodeID nid) const override final
     {
+        LoadLazyBlock(INTERSECTION_CLASSES);
         return m_bearing_class_id_table.at(nid);
     }
 
@@ -913,6 +1376,7 @@ class InternalDataFacade final : public BaseDataFacade
     GetBearingClass(const BearingClassID bearing_class_id) const override final
     {
         BOOST_ASSERT(bearing_class_id != INVALID_BEARING_CLASSID);
+        LoadLazyBlock(INTERSECTION_CLASSES);
         auto range = m_bearing_ranges_table.GetRange(bearing_class_id);
 
         util::guidance::BearingClass result;
@@ -941,6 +1405,7 @@ class InternalDataFacade final : public BaseDataFacade
 
     util::guidance::EntryClass GetEntryClass(const EntryClassID entry_class_id) const override final
     {
+        LoadLazyBlock(INTERSECTION_CLASSES);
         return m_entry_class_table.at(entry_class_id);
     }
 
@@ -952,6 +1417,7 @@ class InternalDataFacade final : public BaseDataFacade
     util::guidance::LaneTupleIdPair GetLaneData(const EdgeID id) const override final
     {
         BOOST_ASSERT(hasLaneData(id));
+        LoadLazyBlock(TURN_LANES);
         return m_lane_tuple_id_pairs[m_lane_data_id[id]];
     }
 
@@ -960,11 +1426,12 @@ class InternalDataFacade final : public BaseDataFacade
     {
         if (lane_description_id == INVALID_LANE_DESCRIPTIONID)
             return {};
-        else
-            return extractor::guidance::TurnLaneDescription(
-                m_lane_description_masks.begin() + m_lane_description_offsets[lane_description_id],
-                m_lane_description_masks.begin() +
-                    m_lane_description_offsets[lane_description_id + 1]);
+
+        LoadLazyBlock(TURN_LANES);
+        return extractor::guidance::TurnLaneDescription(
+            m_lane_description_masks.begin() + m_lane_description_offsets[lane_description_id],
+            m_lane_description_masks.begin() +
+                m_lane_description_offsets[lane_description_id + 1]);
     }
 };
 }
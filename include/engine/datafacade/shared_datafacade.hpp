@@ -3,7 +3,7 @@
 
 // implements all data storage when shared memory _IS_ used
 
-#include "storage/shared_barriers.hpp"
+#include "storage/container.hpp"
 #include "storage/shared_datatype.hpp"
 #include "storage/shared_memory.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
@@ -17,18 +17,21 @@
 #include "util/guidance/turn_lanes.hpp"
 
 #include "engine/geospatial_query.hpp"
+#include "util/coordinate_list.hpp"
+#include "util/geometry_node_list.hpp"
+#include "util/exception.hpp"
 #include "util/guidance/turn_bearing.hpp"
 #include "util/packed_vector.hpp"
 #include "util/range_table.hpp"
+#include "util/segment_weight_list.hpp"
 #include "util/rectangle.hpp"
 #include "util/simple_logger.hpp"
+#include "util/speed_profile.hpp"
 #include "util/static_graph.hpp"
 #include "util/static_rtree.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/assert.hpp>
-#include <boost/interprocess/sync/named_sharable_mutex.hpp>
-#include <boost/interprocess/sync/sharable_lock.hpp>
 #include <boost/thread/tss.hpp>
 
 #include <algorithm>
@@ -52,33 +55,38 @@ class SharedDataFacade final : public BaseDataFacade
 
   private:
     using super = BaseDataFacade;
-    using QueryGraph = util::StaticGraph<EdgeData, true>;
+    using QueryGraph = engine::QueryGraph<true>;
     using GraphNode = QueryGraph::NodeArrayEntry;
-    using GraphEdge = QueryGraph::EdgeArrayEntry;
     using IndexBlock = util::RangeTable<16, true>::BlockT;
-    using InputEdge = QueryGraph::InputEdge;
     using RTreeLeaf = super::RTreeLeaf;
     using SharedRTree =
-        util::StaticRTree<RTreeLeaf, util::ShM<util::Coordinate, true>::vector, true>;
+        util::StaticRTree<extractor::EdgeBasedNodeSegment, util::CoordinateList<true>, true>;
     using SharedGeospatialQuery = GeospatialQuery<SharedRTree, BaseDataFacade>;
     using RTreeNode = SharedRTree::TreeNode;
 
     storage::SharedDataLayout *data_layout;
     char *shared_memory;
+    char *metric_memory;
 
-    std::shared_ptr<storage::SharedBarriers> shared_barriers;
     storage::SharedDataType layout_region;
     storage::SharedDataType data_region;
+    storage::SharedDataType metric_region;
     unsigned shared_timestamp;
 
     unsigned m_check_sum;
     std::unique_ptr<QueryGraph> m_query_graph;
     std::unique_ptr<storage::SharedMemory> m_layout_memory;
     std::unique_ptr<storage::SharedMemory> m_large_memory;
+    std::unique_ptr<storage::SharedMemory> m_metric_memory;
+    std::unique_ptr<storage::MappedContainer> m_container;
+    // the dataset of a replica
+    std::unique_ptr<storage::SharedDataLayout> m_layout_copy;
+    std::unique_ptr<char[]> m_data_copy;
+    std::unique_ptr<char[]> m_metric_copy;
     std::string m_timestamp;
     extractor::ProfileProperties *m_profile_properties;
 
-    util::ShM<util::Coordinate, true>::vector m_coordinate_list;
+    util::CoordinateList<true> m_coordinate_list;
     util::PackedVector<OSMNodeID, true> m_osmnodeid_list;
     util::ShM<GeometryID, true>::vector m_via_geometry_list;
     util::ShM<unsigned, true>::vector m_name_ID_list;
@@ -90,10 +98,18 @@ class SharedDataFacade final : public BaseDataFacade
     util::ShM<char, true>::vector m_names_char_list;
     util::ShM<unsigned, true>::vector m_name_begin_indices;
     util::ShM<unsigned, true>::vector m_geometry_indices;
-    util::ShM<NodeID, true>::vector m_geometry_node_list;
-    util::ShM<EdgeWeight, true>::vector m_geometry_fwd_weight_list;
-    util::ShM<EdgeWeight, true>::vector m_geometry_rev_weight_list;
+    util::GeometryNodeList<true> m_geometry_node_list;
+    util::SegmentWeightList<true> m_geometry_fwd_weight_list;
+    util::SegmentWeightList<true> m_geometry_rev_weight_list;
+    util::ShM<EdgeWeight, true>::vector m_geometry_fwd_weight_offsets;
+    util::ShM<EdgeWeight, true>::vector m_geometry_rev_weight_offsets;
+    util::ShM<SegmentLength, true>::vector m_geometry_length_list;
     util::ShM<bool, true>::vector m_is_core_node;
+    util::ShM<NodeID, true>::vector m_node_renumbering;
+    util::ShM<extractor::EdgeBasedNodeData, true>::vector m_edge_based_node_data;
+    unsigned m_number_of_core_landmarks;
+    util::ShM<NodeID, true>::vector m_core_landmark_indices;
+    util::ShM<EdgeWeight, true>::vector m_core_landmark_weights;
     util::ShM<uint8_t, true>::vector m_datasource_list;
     util::ShM<std::uint32_t, true>::vector m_lane_description_offsets;
     util::ShM<extractor::guidance::TurnLaneType::Mask, true>::vector m_lane_description_masks;
@@ -101,6 +117,8 @@ class SharedDataFacade final : public BaseDataFacade
     util::ShM<char, true>::vector m_datasource_name_data;
     util::ShM<std::size_t, true>::vector m_datasource_name_offsets;
     util::ShM<std::size_t, true>::vector m_datasource_name_lengths;
+    util::ShM<std::uint8_t, true>::vector m_speed_profile_factors;
+    util::ShM<util::SpeedProfileSegment, true>::vector m_speed_profile_segments;
     util::ShM<util::guidance::LaneTupleIdPair, true>::vector m_lane_tupel_id_pairs;
 
     std::unique_ptr<SharedRTree> m_static_rtree;
@@ -123,7 +141,7 @@ class SharedDataFacade final : public BaseDataFacade
 
     void LoadChecksum()
     {
-        m_check_sum = *data_layout->GetBlockPtr<unsigned>(shared_memory,
+        m_check_sum = *data_layout->GetBlockPtr<unsigned>(metric_memory,
                                                           storage::SharedDataLayout::HSGR_CHECKSUM);
         util::SimpleLogger().Write() << "set checksum: " << m_check_sum;
     }
@@ -172,25 +190,48 @@ class SharedDataFacade final : public BaseDataFacade
     void LoadGraph()
     {
         auto graph_nodes_ptr = data_layout->GetBlockPtr<GraphNode>(
-            shared_memory, storage::SharedDataLayout::GRAPH_NODE_LIST);
+            metric_memory, storage::SharedDataLayout::GRAPH_NODE_LIST);
 
-        auto graph_edges_ptr = data_layout->GetBlockPtr<GraphEdge>(
-            shared_memory, storage::SharedDataLayout::GRAPH_EDGE_LIST);
+        auto graph_hot_edges_ptr = data_layout->GetBlockPtr<HotEdgeData>(
+            metric_memory, storage::SharedDataLayout::GRAPH_HOT_EDGE_LIST);
+        auto graph_cold_edges_ptr = data_layout->GetBlockPtr<ColdEdgeData>(
+            metric_memory, storage::SharedDataLayout::GRAPH_COLD_EDGE_LIST);
 
         util::ShM<GraphNode, true>::vector node_list(
             graph_nodes_ptr, data_layout->num_entries[storage::SharedDataLayout::GRAPH_NODE_LIST]);
-        util::ShM<GraphEdge, true>::vector edge_list(
-            graph_edges_ptr, data_layout->num_entries[storage::SharedDataLayout::GRAPH_EDGE_LIST]);
-        m_query_graph.reset(new QueryGraph(node_list, edge_list));
+        util::ShM<HotEdgeData, true>::vector hot_edge_list(
+            graph_hot_edges_ptr,
+            data_layout->num_entries[storage::SharedDataLayout::GRAPH_HOT_EDGE_LIST]);
+        util::ShM<ColdEdgeData, true>::vector cold_edge_list(
+            graph_cold_edges_ptr,
+            data_layout->num_entries[storage::SharedDataLayout::GRAPH_COLD_EDGE_LIST]);
+        m_query_graph.reset(new QueryGraph(node_list, hot_edge_list, cold_edge_list));
     }
 
     void LoadNodeAndEdgeInformation()
     {
-        const auto coordinate_list_ptr = data_layout->GetBlockPtr<util::Coordinate>(
-            shared_memory, storage::SharedDataLayout::COORDINATE_LIST);
-        m_coordinate_list.reset(
-            coordinate_list_ptr,
-            data_layout->num_entries[storage::SharedDataLayout::COORDINATE_LIST]);
+        const auto number_of_coordinates = *data_layout->GetBlockPtr<std::uint64_t>(
+            shared_memory, storage::SharedDataLayout::NUMBER_OF_COORDINATES);
+        if (data_layout->num_entries[storage::SharedDataLayout::COORDINATE_BLOCKS] > 0)
+        {
+            util::ShM<util::CoordinateBlock, true>::vector blocks(
+                data_layout->GetBlockPtr<util::CoordinateBlock>(
+                    shared_memory, storage::SharedDataLayout::COORDINATE_BLOCKS),
+                data_layout->num_entries[storage::SharedDataLayout::COORDINATE_BLOCKS]);
+            util::ShM<std::uint8_t, true>::vector bytes(
+                data_layout->GetBlockPtr<std::uint8_t>(
+                    shared_memory, storage::SharedDataLayout::COORDINATE_DELTAS),
+                data_layout->num_entries[storage::SharedDataLayout::COORDINATE_DELTAS]);
+            m_coordinate_list = util::CoordinateList<true>(blocks, bytes, number_of_coordinates);
+        }
+        else
+        {
+            util::ShM<util::Coordinate, true>::vector coordinates(
+                data_layout->GetBlockPtr<util::Coordinate>(
+                    shared_memory, storage::SharedDataLayout::COORDINATE_LIST),
+                data_layout->num_entries[storage::SharedDataLayout::COORDINATE_LIST]);
+            m_coordinate_list = util::CoordinateList<true>(coordinates);
+        }
 
         for (unsigned i = 0; i < m_coordinate_list.size(); ++i)
         {
@@ -202,9 +243,8 @@ class SharedDataFacade final : public BaseDataFacade
         m_osmnodeid_list.reset(
             osmnodeid_list_ptr,
             data_layout->num_entries[storage::SharedDataLayout::OSM_NODE_ID_LIST]);
-        // We (ab)use the number of coordinates here because we know we have the same amount of ids
-        m_osmnodeid_list.set_number_of_entries(
-            data_layout->num_entries[storage::SharedDataLayout::COORDINATE_LIST]);
+        // there is an id for every coordinate
+        m_osmnodeid_list.set_number_of_entries(number_of_coordinates);
 
         const auto travel_mode_list_ptr = data_layout->GetBlockPtr<extractor::TravelMode>(
             shared_memory, storage::SharedDataLayout::TRAVEL_MODE);
@@ -313,12 +353,50 @@ class SharedDataFacade final : public BaseDataFacade
     void LoadCoreInformation()
     {
         auto core_marker_ptr = data_layout->GetBlockPtr<unsigned>(
-            shared_memory, storage::SharedDataLayout::CORE_MARKER);
+            metric_memory, storage::SharedDataLayout::CORE_MARKER);
         util::ShM<bool, true>::vector is_core_node(
             core_marker_ptr, data_layout->num_entries[storage::SharedDataLayout::CORE_MARKER]);
         m_is_core_node = std::move(is_core_node);
     }
 
+    void LoadNodeRenumbering()
+    {
+        auto node_renumbering_ptr = data_layout->GetBlockPtr<NodeID>(
+            metric_memory, storage::SharedDataLayout::NODE_RENUMBERING);
+        util::ShM<NodeID, true>::vector node_renumbering(
+            node_renumbering_ptr,
+            data_layout->num_entries[storage::SharedDataLayout::NODE_RENUMBERING]);
+        m_node_renumbering = std::move(node_renumbering);
+    }
+
+    void LoadEdgeBasedNodeData()
+    {
+        auto node_data_ptr = data_layout->GetBlockPtr<extractor::EdgeBasedNodeData>(
+            shared_memory, storage::SharedDataLayout::EDGE_BASED_NODE_DATA);
+        util::ShM<extractor::EdgeBasedNodeData, true>::vector node_data(
+            node_data_ptr,
+            data_layout->num_entries[storage::SharedDataLayout::EDGE_BASED_NODE_DATA]);
+        m_edge_based_node_data = std::move(node_data);
+    }
+
+    void LoadCoreLandmarks()
+    {
+        m_number_of_core_landmarks = *data_layout->GetBlockPtr<std::uint32_t>(
+            metric_memory, storage::SharedDataLayout::NUMBER_OF_CORE_LANDMARKS);
+        auto indices_ptr = data_layout->GetBlockPtr<NodeID>(
+            metric_memory, storage::SharedDataLayout::CORE_LANDMARK_INDICES);
+        util::ShM<NodeID, true>::vector indices(
+            indices_ptr,
+            data_layout->num_entries[storage::SharedDataLayout::CORE_LANDMARK_INDICES]);
+        m_core_landmark_indices = std::move(indices);
+        auto weights_ptr = data_layout->GetBlockPtr<EdgeWeight>(
+            metric_memory, storage::SharedDataLayout::CORE_LANDMARK_WEIGHTS);
+        util::ShM<EdgeWeight, true>::vector weights(
+            weights_ptr,
+            data_layout->num_entries[storage::SharedDataLayout::CORE_LANDMARK_WEIGHTS]);
+        m_core_landmark_weights = std::move(weights);
+    }
+
     void LoadGeometries()
     {
         auto geometries_index_ptr = data_layout->GetBlockPtr<unsigned>(
@@ -328,54 +406,112 @@ class SharedDataFacade final : public BaseDataFacade
             data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_INDEX]);
         m_geometry_indices = std::move(geometry_begin_indices);
 
-        auto geometries_node_list_ptr = data_layout->GetBlockPtr<NodeID>(
-            shared_memory, storage::SharedDataLayout::GEOMETRIES_NODE_LIST);
-        util::ShM<NodeID, true>::vector geometry_node_list(
-            geometries_node_list_ptr,
-            data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_NODE_LIST]);
-        m_geometry_node_list = std::move(geometry_node_list);
-
-        auto geometries_fwd_weight_list_ptr = data_layout->GetBlockPtr<EdgeWeight>(
-            shared_memory, storage::SharedDataLayout::GEOMETRIES_FWD_WEIGHT_LIST);
-        util::ShM<EdgeWeight, true>::vector geometry_fwd_weight_list(
-            geometries_fwd_weight_list_ptr,
-            data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_FWD_WEIGHT_LIST]);
-        m_geometry_fwd_weight_list = std::move(geometry_fwd_weight_list);
+        if (data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_NODE_BLOCKS] > 0)
+        {
+            // the index ends with the number of nodes
+            BOOST_ASSERT(!m_geometry_indices.empty());
+            util::ShM<util::GeometryNodeBlock, true>::vector blocks(
+                data_layout->GetBlockPtr<util::GeometryNodeBlock>(
+                    shared_memory, storage::SharedDataLayout::GEOMETRIES_NODE_BLOCKS),
+                data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_NODE_BLOCKS]);
+            util::ShM<std::uint8_t, true>::vector bytes(
+                data_layout->GetBlockPtr<std::uint8_t>(
+                    shared_memory, storage::SharedDataLayout::GEOMETRIES_NODE_DELTAS),
+                data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_NODE_DELTAS]);
+            m_geometry_node_list =
+                util::GeometryNodeList<true>(
+                blocks, bytes, m_geometry_indices[m_geometry_indices.size() - 1]);
+        }
+        else
+        {
+            util::ShM<NodeID, true>::vector nodes(
+                data_layout->GetBlockPtr<NodeID>(shared_memory,
+                                                 storage::SharedDataLayout::GEOMETRIES_NODE_LIST),
+                data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_NODE_LIST]);
+            m_geometry_node_list = util::GeometryNodeList<true>(nodes);
+        }
+
+        auto geometries_length_list_ptr = data_layout->GetBlockPtr<SegmentLength>(
+            shared_memory, storage::SharedDataLayout::GEOMETRIES_LENGTH_LIST);
+        util::ShM<SegmentLength, true>::vector geometry_length_list(
+            geometries_length_list_ptr,
+            data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_LENGTH_LIST]);
+        m_geometry_length_list = std::move(geometry_length_list);
 
-        auto geometries_rev_weight_list_ptr = data_layout->GetBlockPtr<EdgeWeight>(
-            shared_memory, storage::SharedDataLayout::GEOMETRIES_REV_WEIGHT_LIST);
-        util::ShM<EdgeWeight, true>::vector geometry_rev_weight_list(
-            geometries_rev_weight_list_ptr,
+        util::ShM<std::uint16_t, true>::vector geometry_fwd_weight_list(
+            data_layout->GetBlockPtr<std::uint16_t>(
+                metric_memory, storage::SharedDataLayout::GEOMETRIES_FWD_WEIGHT_LIST),
+            data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_FWD_WEIGHT_LIST]);
+        util::ShM<util::SegmentWeightOverflow, true>::vector geometry_fwd_weight_overflow(
+            data_layout->GetBlockPtr<util::SegmentWeightOverflow>(
+                metric_memory, storage::SharedDataLayout::GEOMETRIES_FWD_WEIGHT_OVERFLOW),
+            data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_FWD_WEIGHT_OVERFLOW]);
+        m_geometry_fwd_weight_list = util::SegmentWeightList<true>(geometry_fwd_weight_list,
+                                                                   geometry_fwd_weight_overflow);
+
+        util::ShM<std::uint16_t, true>::vector geometry_rev_weight_list(
+            data_layout->GetBlockPtr<std::uint16_t>(
+                metric_memory, storage::SharedDataLayout::GEOMETRIES_REV_WEIGHT_LIST),
             data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_REV_WEIGHT_LIST]);
-        m_geometry_rev_weight_list = std::move(geometry_rev_weight_list);
+        util::ShM<util::SegmentWeightOverflow, true>::vector geometry_rev_weight_overflow(
+            data_layout->GetBlockPtr<util::SegmentWeightOverflow>(
+                metric_memory, storage::SharedDataLayout::GEOMETRIES_REV_WEIGHT_OVERFLOW),
+            data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_REV_WEIGHT_OVERFLOW]);
+        m_geometry_rev_weight_list = util::SegmentWeightList<true>(geometry_rev_weight_list,
+                                                                   geometry_rev_weight_overflow);
+
+        util::ShM<EdgeWeight, true>::vector geometry_fwd_weight_offsets(
+            data_layout->GetBlockPtr<EdgeWeight>(
+                metric_memory, storage::SharedDataLayout::GEOMETRIES_FWD_WEIGHT_OFFSETS),
+            data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_FWD_WEIGHT_OFFSETS]);
+        m_geometry_fwd_weight_offsets = std::move(geometry_fwd_weight_offsets);
+        util::ShM<EdgeWeight, true>::vector geometry_rev_weight_offsets(
+            data_layout->GetBlockPtr<EdgeWeight>(
+                metric_memory, storage::SharedDataLayout::GEOMETRIES_REV_WEIGHT_OFFSETS),
+            data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_REV_WEIGHT_OFFSETS]);
+        m_geometry_rev_weight_offsets = std::move(geometry_rev_weight_offsets);
 
         auto datasources_list_ptr = data_layout->GetBlockPtr<uint8_t>(
-            shared_memory, storage::SharedDataLayout::DATASOURCES_LIST);
+            metric_memory, storage::SharedDataLayout::DATASOURCES_LIST);
         util::ShM<uint8_t, true>::vector datasources_list(
             datasources_list_ptr,
             data_layout->num_entries[storage::SharedDataLayout::DATASOURCES_LIST]);
         m_datasource_list = std::move(datasources_list);
 
         auto datasource_name_data_ptr = data_layout->GetBlockPtr<char>(
-            shared_memory, storage::SharedDataLayout::DATASOURCE_NAME_DATA);
+            metric_memory, storage::SharedDataLayout::DATASOURCE_NAME_DATA);
         util::ShM<char, true>::vector datasource_name_data(
             datasource_name_data_ptr,
             data_layout->num_entries[storage::SharedDataLayout::DATASOURCE_NAME_DATA]);
         m_datasource_name_data = std::move(datasource_name_data);
 
         auto datasource_name_offsets_ptr = data_layout->GetBlockPtr<std::size_t>(
-            shared_memory, storage::SharedDataLayout::DATASOURCE_NAME_OFFSETS);
+            metric_memory, storage::SharedDataLayout::DATASOURCE_NAME_OFFSETS);
         util::ShM<std::size_t, true>::vector datasource_name_offsets(
             datasource_name_offsets_ptr,
             data_layout->num_entries[storage::SharedDataLayout::DATASOURCE_NAME_OFFSETS]);
         m_datasource_name_offsets = std::move(datasource_name_offsets);
 
         auto datasource_name_lengths_ptr = data_layout->GetBlockPtr<std::size_t>(
-            shared_memory, storage::SharedDataLayout::DATASOURCE_NAME_LENGTHS);
+            metric_memory, storage::SharedDataLayout::DATASOURCE_NAME_LENGTHS);
         util::ShM<std::size_t, true>::vector datasource_name_lengths(
             datasource_name_lengths_ptr,
             data_layout->num_entries[storage::SharedDataLayout::DATASOURCE_NAME_LENGTHS]);
         m_datasource_name_lengths = std::move(datasource_name_lengths);
+
+        auto speed_profile_factors_ptr = data_layout->GetBlockPtr<std::uint8_t>(
+            metric_memory, storage::SharedDataLayout::SPEED_PROFILE_FACTORS);
+        util::ShM<std::uint8_t, true>::vector speed_profile_factors(
+            speed_profile_factors_ptr,
+            data_layout->num_entries[storage::SharedDataLayout::SPEED_PROFILE_FACTORS]);
+        m_speed_profile_factors = std::move(speed_profile_factors);
+
+        auto speed_profile_segments_ptr = data_layout->GetBlockPtr<util::SpeedProfileSegment>(
+            metric_memory, storage::SharedDataLayout::SPEED_PROFILE_SEGMENTS);
+        util::ShM<util::SpeedProfileSegment, true>::vector speed_profile_segments(
+            speed_profile_segments_ptr,
+            data_layout->num_entries[storage::SharedDataLayout::SPEED_PROFILE_SEGMENTS]);
+        m_speed_profile_segments = std::move(speed_profile_segments);
     }
 
     void LoadIntersectionClasses()
@@ -412,46 +548,58 @@ class SharedDataFacade final : public BaseDataFacade
         m_entry_class_table = std::move(entry_class_table);
     }
 
-  public:
-    // this function handle the deallocation of the shared memory it we can prove it will not be
-    // used anymore
-    virtual ~SharedDataFacade()
+    void LoadData()
     {
-        boost::interprocess::scoped_lock<boost::interprocess::named_sharable_mutex> exclusive_lock(
-            data_region == storage::DATA_1 ? shared_barriers->regions_1_mutex
-                                           : shared_barriers->regions_2_mutex,
-            boost::interprocess::defer_lock);
-
-        // if this returns false this is still in use
-        if (exclusive_lock.try_lock())
-        {
-            // Now check if this is still the newest dataset
-            const boost::interprocess::sharable_lock<boost::interprocess::named_upgradable_mutex>
-                lock(shared_barriers->current_regions_mutex);
-
-            auto shared_regions = storage::makeSharedMemory(storage::CURRENT_REGIONS);
-            const auto current_timestamp =
-                static_cast<const storage::SharedDataTimestamp *>(shared_regions->Ptr());
+        LoadGraph();
+        LoadChecksum();
+        LoadNodeAndEdgeInformation();
+        LoadGeometries();
+        LoadTimestamp();
+        LoadViaNodeList();
+        LoadNames();
+        LoadTurnLaneDescriptions();
+        LoadCoreInformation();
+        LoadNodeRenumbering();
+        LoadCoreLandmarks();
+        LoadProfileProperties();
+        LoadEdgeBasedNodeData();
+        LoadRTree();
+        LoadIntersectionClasses();
+    }
 
-            if (current_timestamp->timestamp == shared_timestamp)
-            {
-                util::SimpleLogger().Write(logDEBUG) << "Retaining data with shared timestamp "
-                                                     << shared_timestamp;
-            }
-            else
-            {
-                storage::SharedMemory::Remove(data_region);
-                storage::SharedMemory::Remove(layout_region);
-            }
-        }
+    // Copying the whole dataset is only done on purpose by Replicate
+    SharedDataFacade(const SharedDataFacade &original)
+        : layout_region(original.layout_region), data_region(original.data_region),
+          metric_region(original.metric_region), shared_timestamp(original.shared_timestamp),
+          m_layout_copy(std::make_unique<storage::SharedDataLayout>(*original.data_layout)),
+          m_data_copy(new char[original.data_layout->GetSizeOfLayout()]),
+          m_metric_copy(new char[original.data_layout->GetSizeOfMetric()])
+    {
+        data_layout = m_layout_copy.get();
+        shared_memory = m_data_copy.get();
+        metric_memory = m_metric_copy.get();
+        std::copy(original.shared_memory,
+                  original.shared_memory + data_layout->GetSizeOfLayout(),
+                  shared_memory);
+        std::copy(original.metric_memory,
+                  original.metric_memory + data_layout->GetSizeOfMetric(),
+                  metric_memory);
+
+        LoadData();
     }
 
-    SharedDataFacade(const std::shared_ptr<storage::SharedBarriers> &shared_barriers_,
-                     storage::SharedDataType layout_region_,
+  public:
+    // The regions stay attached for the lifetime of the facade. osrm-datastore removes them once a
+    // newer dataset is current, the memory is freed when the last facade using them is gone.
+    // An additional metric of the dataset is selected by its name, it shares all blocks but the
+    // metric ones with the default metric.
+    SharedDataFacade(storage::SharedDataType layout_region_,
                      storage::SharedDataType data_region_,
-                     unsigned shared_timestamp_)
-        : shared_barriers(shared_barriers_), layout_region(layout_region_),
-          data_region(data_region_), shared_timestamp(shared_timestamp_)
+                     storage::SharedDataType metric_region_,
+                     unsigned shared_timestamp_,
+                     const std::string &metric = "")
+        : layout_region(layout_region_), data_region(data_region_), metric_region(metric_region_),
+          shared_timestamp(shared_timestamp_)
     {
         util::SimpleLogger().Write(logDEBUG) << "Loading new data with shared timestamp "
                                              << shared_timestamp;
@@ -465,20 +613,45 @@ class SharedDataFacade final : public BaseDataFacade
         m_large_memory = storage::makeSharedMemory(data_region);
         shared_memory = (char *)(m_large_memory->Ptr());
 
-        LoadGraph();
-        LoadChecksum();
-        LoadNodeAndEdgeInformation();
-        LoadGeometries();
-        LoadTimestamp();
-        LoadViaNodeList();
-        LoadNames();
-        LoadTurnLaneDescriptions();
-        LoadCoreInformation();
-        LoadProfileProperties();
-        LoadRTree();
-        LoadIntersectionClasses();
+        BOOST_ASSERT(storage::SharedMemory::RegionExists(metric_region));
+        m_metric_memory = storage::makeSharedMemory(metric_region);
+        metric_memory = (char *)(m_metric_memory->Ptr());
+
+        if (!metric.empty())
+        {
+            auto shared_metric = storage::GetSharedMetrics(m_layout_memory->Ptr())->Find(metric);
+            if (!shared_metric)
+            {
+                throw util::exception("No metric " + metric + " in shared memory");
+            }
+            data_layout = &shared_metric->layout;
+            metric_memory += shared_metric->offset;
+        }
+
+        LoadData();
+    }
+
+    // Maps a dataset container, the data is neither parsed nor copied
+    explicit SharedDataFacade(const boost::filesystem::path &container_path)
+        : shared_timestamp(0),
+          m_container(std::make_unique<storage::MappedContainer>(container_path))
+    {
+        data_layout = m_container->Layout();
+        shared_memory = m_container->Data();
+        metric_memory = m_container->Metric();
+
+        LoadData();
     }
 
+    // Returns a copy of the dataset in memory of its own. The pages are allocated on the NUMA
+    // node of the calling thread, which makes the replica local to the cpus of that node.
+    static std::shared_ptr<SharedDataFacade> Replicate(const SharedDataFacade &original)
+    {
+        return std::shared_ptr<SharedDataFacade>(new SharedDataFacade(original));
+    }
+
+    unsigned GetSharedTimestamp() const { return shared_timestamp; }
+
     // search graph access
     unsigned GetNumberOfNodes() const override final { return m_query_graph->GetNumberOfNodes(); }
 
@@ -491,11 +664,16 @@ class SharedDataFacade final : public BaseDataFacade
 
     NodeID GetTarget(const EdgeID e) const override final { return m_query_graph->GetTarget(e); }
 
-    EdgeData &GetEdgeData(const EdgeID e) const override final
+    EdgeData GetEdgeData(const EdgeID e) const override final
     {
         return m_query_graph->GetEdgeData(e);
     }
 
+    const HotEdgeData &GetHotEdgeData(const EdgeID e) const override final
+    {
+        return m_query_graph->GetHotEdgeData(e);
+    }
+
     EdgeID BeginEdges(const NodeID n) const override final { return m_query_graph->BeginEdges(n); }
 
     EdgeID EndEdges(const NodeID n) const override final { return m_query_graph->EndEdges(n); }
@@ -505,6 +683,16 @@ class SharedDataFacade final : public BaseDataFacade
         return m_query_graph->GetAdjacentEdgeRange(node);
     }
 
+    EdgeRange GetForwardEdgeRange(const NodeID node) const override final
+    {
+        return m_query_graph->GetForwardEdgeRange(node);
+    }
+
+    EdgeRange GetBackwardEdgeRange(const NodeID node) const override final
+    {
+        return m_query_graph->GetBackwardEdgeRange(node);
+    }
+
     // searches for a specific edge
     EdgeID FindEdge(const NodeID from, const NodeID to) const override final
     {
@@ -540,7 +728,8 @@ class SharedDataFacade final : public BaseDataFacade
         return m_osmnodeid_list.at(id);
     }
 
-    virtual std::vector<NodeID> GetUncompressedForwardGeometry(const EdgeID id) const override final
+    virtual util::GeometryNodeView
+    GetUncompressedForwardGeometry(const EdgeID id) const override final
     {
         /*
          * NodeID's for geometries are stored in one place for
@@ -554,18 +743,11 @@ class SharedDataFacade final : public BaseDataFacade
         const unsigned begin = m_geometry_indices.at(id);
         const unsigned end = m_geometry_indices.at(id + 1);
 
-        std::vector<NodeID> result_nodes;
-
-        result_nodes.resize(end - begin);
-
-        std::copy(m_geometry_node_list.begin() + begin,
-                  m_geometry_node_list.begin() + end,
-                  result_nodes.begin());
-
-        return result_nodes;
+        return m_geometry_node_list.GetView(begin, end);
     }
 
-    virtual std::vector<NodeID> GetUncompressedReverseGeometry(const EdgeID id) const override final
+    virtual util::GeometryNodeView
+    GetUncompressedReverseGeometry(const EdgeID id) const override final
     {
         /*
          * NodeID's for geometries are stored in one place for
@@ -577,18 +759,10 @@ class SharedDataFacade final : public BaseDataFacade
         const unsigned begin = m_geometry_indices.at(id);
         const unsigned end = m_geometry_indices.at(id + 1);
 
-        std::vector<NodeID> result_nodes;
-
-        result_nodes.resize(end - begin);
-
-        std::copy(m_geometry_node_list.rbegin() + (m_geometry_node_list.size() - end),
-                  m_geometry_node_list.rbegin() + (m_geometry_node_list.size() - begin),
-                  result_nodes.begin());
-
-        return result_nodes;
+        return m_geometry_node_list.GetView(begin, end, true);
     }
 
-    virtual std::vector<EdgeWeight>
+    virtual util::SegmentWeightView
     GetUncompressedForwardWeights(const EdgeID id) const override final
     {
         /*
@@ -601,17 +775,10 @@ class SharedDataFacade final : public BaseDataFacade
         const unsigned begin = m_geometry_indices.at(id) + 1;
         const unsigned end = m_geometry_indices.at(id + 1);
 
-        std::vector<EdgeWeight> result_weights;
-        result_weights.resize(end - begin);
-
-        std::copy(m_geometry_fwd_weight_list.begin() + begin,
-                  m_geometry_fwd_weight_list.begin() + end,
-                  result_weights.begin());
-
-        return result_weights;
+        return m_geometry_fwd_weight_list.GetView(begin, end);
     }
 
-    virtual std::vector<EdgeWeight>
+    virtual util::SegmentWeightView
     GetUncompressedReverseWeights(const EdgeID id) const override final
     {
         /*
@@ -626,14 +793,74 @@ class SharedDataFacade final : public BaseDataFacade
         const unsigned begin = m_geometry_indices.at(id);
         const unsigned end = m_geometry_indices.at(id + 1) - 1;
 
-        std::vector<EdgeWeight> result_weights;
-        result_weights.resize(end - begin);
+        return m_geometry_rev_weight_list.GetView(begin, end, true);
+    }
+
+    virtual util::ArrayView<EdgeWeight>
+    GetUncompressedForwardWeightOffsets(const EdgeID id) const override final
+    {
+        // The offsets are stored for every node of the geometry
+        if (m_geometry_fwd_weight_offsets.empty())
+        {
+            return {};
+        }
+
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+
+        return util::ArrayView<EdgeWeight>(m_geometry_fwd_weight_offsets.data() + begin,
+                                           m_geometry_fwd_weight_offsets.data() + end);
+    }
+
+    virtual util::ArrayView<EdgeWeight>
+    GetUncompressedReverseWeightOffsets(const EdgeID id) const override final
+    {
+        // The reverse offsets are sums to the end of the geometry, read in reverse they are the
+        // offsets of the reverse weights
+        if (m_geometry_rev_weight_offsets.empty())
+        {
+            return {};
+        }
+
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+
+        return util::ArrayView<EdgeWeight>(m_geometry_rev_weight_offsets.data() + begin,
+                                           m_geometry_rev_weight_offsets.data() + end,
+                                           true);
+    }
+
+    virtual util::ArrayView<SegmentLength>
+    GetUncompressedForwardLengths(const EdgeID id) const override final
+    {
+        // The lengths are stored like the forward weights
+        if (m_geometry_length_list.empty())
+        {
+            return {};
+        }
+
+        const unsigned begin = m_geometry_indices.at(id) + 1;
+        const unsigned end = m_geometry_indices.at(id + 1);
+
+        return util::ArrayView<SegmentLength>(m_geometry_length_list.data() + begin,
+                                              m_geometry_length_list.data() + end);
+    }
+
+    virtual util::ArrayView<SegmentLength>
+    GetUncompressedReverseLengths(const EdgeID id) const override final
+    {
+        // A segment has the same length in both directions, so these are the forward lengths
+        // read in reverse
+        if (m_geometry_length_list.empty())
+        {
+            return {};
+        }
 
-        std::copy(m_geometry_rev_weight_list.rbegin() + (m_geometry_rev_weight_list.size() - end),
-                  m_geometry_rev_weight_list.rbegin() + (m_geometry_rev_weight_list.size() - begin),
-                  result_weights.begin());
+        const unsigned begin = m_geometry_indices.at(id) + 1;
+        const unsigned end = m_geometry_indices.at(id + 1);
 
-        return result_weights;
+        return util::ArrayView<SegmentLength>(
+            m_geometry_length_list.data() + begin, m_geometry_length_list.data() + end, true);
     }
 
     virtual GeometryID GetGeometryIndexForEdgeID(const unsigned id) const override final
@@ -652,6 +879,12 @@ class SharedDataFacade final : public BaseDataFacade
         return m_travel_mode_list.at(id);
     }
 
+    extractor::EdgeBasedNodeData GetEdgeBasedNodeData(const NodeID id) const override final
+    {
+        BOOST_ASSERT(id < m_edge_based_node_data.size());
+        return m_edge_based_node_data[id];
+    }
+
     std::vector<RTreeLeaf> GetEdgesInBox(const util::Coordinate south_west,
                                          const util::Coordinate north_east) const override final
     {
@@ -774,7 +1007,7 @@ class SharedDataFacade final : public BaseDataFacade
         return m_name_ID_list.at(id);
     }
 
-    std::string GetNameForID(const unsigned name_id) const override final
+    util::StringView GetNameForID(const unsigned name_id) const override final
     {
         if (std::numeric_limits<unsigned>::max() == name_id)
         {
@@ -782,19 +1015,14 @@ class SharedDataFacade final : public BaseDataFacade
         }
         auto range = m_name_table->GetRange(name_id);
 
-        std::string result;
-        result.reserve(range.size());
-        if (range.begin() != range.end())
+        if (range.size() == 0)
         {
-            result.resize(range.back() - range.front() + 1);
-            std::copy(m_names_char_list.begin() + range.front(),
-                      m_names_char_list.begin() + range.back() + 1,
-                      result.begin());
+            return "";
         }
-        return result;
+        return util::StringView(m_names_char_list.data() + range.front(), range.size());
     }
 
-    std::string GetRefForID(const unsigned name_id) const override final
+    util::StringView GetRefForID(const unsigned name_id) const override final
     {
         // We store the ref after the name, destination and pronunciation of a street.
         // We do this to get around the street length limit of 255 which would hit
@@ -803,7 +1031,7 @@ class SharedDataFacade final : public BaseDataFacade
         return GetNameForID(name_id + 3);
     }
 
-    std::string GetPronunciationForID(const unsigned name_id) const override final
+    util::StringView GetPronunciationForID(const unsigned name_id) const override final
     {
         // We store the pronunciation after the name and destination of a street.
         // We do this to get around the street length limit of 255 which would hit
@@ -812,7 +1040,7 @@ class SharedDataFacade final : public BaseDataFacade
         return GetNameForID(name_id + 2);
     }
 
-    std::string GetDestinationsForID(const unsigned name_id) const override final
+    util::StringView GetDestinationsForID(const unsigned name_id) const override final
     {
         // We store the destination after the name of a street.
         // We do this to get around the street length limit of 255 which would hit
@@ -833,9 +1061,31 @@ class SharedDataFacade final : public BaseDataFacade
 
     virtual std::size_t GetCoreSize() const override final { return m_is_core_node.size(); }
 
+    NodeID GetHierarchyNode(const NodeID edge_based_node_id) const override final
+    {
+        return m_node_renumbering.empty() ? edge_based_node_id
+                                          : m_node_renumbering[edge_based_node_id];
+    }
+
+    unsigned GetNumberOfCoreLandmarks() const override final
+    {
+        return m_core_landmark_indices.empty() ? 0 : m_number_of_core_landmarks;
+    }
+
+    util::ArrayView<EdgeWeight> GetCoreLandmarkWeights(const NodeID id) const override final
+    {
+        if (m_core_landmark_indices.empty() || m_core_landmark_indices[id] == SPECIAL_NODEID)
+        {
+            return {};
+        }
+        const std::size_t stride = 2 * m_number_of_core_landmarks;
+        const auto first = &m_core_landmark_weights[m_core_landmark_indices[id] * stride];
+        return {first, first + stride};
+    }
+
     // Returns the data source ids that were used to supply the edge
     // weights.
-    virtual std::vector<uint8_t>
+    virtual util::ArrayView<uint8_t>
     GetUncompressedForwardDatasources(const EdgeID id) const override final
     {
         /*
@@ -850,30 +1100,19 @@ class SharedDataFacade final : public BaseDataFacade
         const unsigned begin = m_geometry_indices.at(id) + 1;
         const unsigned end = m_geometry_indices.at(id + 1);
 
-        std::vector<uint8_t> result_datasources;
-        result_datasources.resize(end - begin);
-
         // If there was no datasource info, return an array of 0's.
         if (m_datasource_list.empty())
         {
-            for (unsigned i = 0; i < end - begin; ++i)
-            {
-                result_datasources.push_back(0);
-            }
-        }
-        else
-        {
-            std::copy(m_datasource_list.begin() + begin,
-                      m_datasource_list.begin() + end,
-                      result_datasources.begin());
+            return util::ArrayView<uint8_t>(end - begin);
         }
 
-        return result_datasources;
+        return util::ArrayView<uint8_t>(m_datasource_list.data() + begin,
+                                        m_datasource_list.data() + end);
     }
 
     // Returns the data source ids that were used to supply the edge
     // weights.
-    virtual std::vector<uint8_t>
+    virtual util::ArrayView<uint8_t>
     GetUncompressedReverseDatasources(const EdgeID id) const override final
     {
         /*
@@ -888,25 +1127,14 @@ class SharedDataFacade final : public BaseDataFacade
         const unsigned begin = m_geometry_indices.at(id);
         const unsigned end = m_geometry_indices.at(id + 1) - 1;
 
-        std::vector<uint8_t> result_datasources;
-        result_datasources.resize(end - begin);
-
         // If there was no datasource info, return an array of 0's.
         if (m_datasource_list.empty())
         {
-            for (unsigned i = 0; i < end - begin; ++i)
-            {
-                result_datasources.push_back(0);
-            }
-        }
-        else
-        {
-            std::copy(m_datasource_list.rbegin() + (m_datasource_list.size() - end),
-                      m_datasource_list.rbegin() + (m_datasource_list.size() - begin),
-                      result_datasources.begin());
+            return util::ArrayView<uint8_t>(end - begin);
         }
 
-        return result_datasources;
+        return util::ArrayView<uint8_t>(
+            m_datasource_list.data() + begin, m_datasource_list.data() + end, true);
     }
 
     virtual std::string GetDatasourceName(const uint8_t datasource_name_id) const override final
@@ -924,6 +1152,24 @@ class SharedDataFacade final : public BaseDataFacade
         return result;
     }
 
+    util::ArrayView<std::uint8_t> GetSpeedProfile(const NodeID from,
+                                                  const NodeID to) const override final
+    {
+        const util::SpeedProfileSegment key{from, to, 0};
+        const auto segments_end = m_speed_profile_segments.data() + m_speed_profile_segments.size();
+        const auto segment =
+            std::lower_bound(m_speed_profile_segments.data(), segments_end, key);
+        if (segment == segments_end || segment->from != from || segment->to != to)
+        {
+            return {};
+        }
+
+        BOOST_ASSERT(segment->offset + util::SPEED_PROFILE_SLOTS <=
+                     m_speed_profile_factors.size());
+        const auto first = m_speed_profile_factors.data() + segment->offset;
+        return util::ArrayView<std::uint8_t>(first, first + util::SPEED_PROFILE_SLOTS);
+    }
+
     std::string GetTimestamp() const override final { return m_timestamp; }
 
     bool GetContinueStraightDefault() const override final
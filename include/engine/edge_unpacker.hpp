@@ -4,11 +4,13 @@
 #include "extractor/guidance/turn_instruction.hpp"
 #include "extractor/travel_mode.hpp"
 #include "engine/phantom_node.hpp"
+#include "engine/shortcut_cache.hpp"
 #include "osrm/coordinate.hpp"
 #include "util/guidance/turn_lanes.hpp"
 #include "util/typedefs.hpp"
 
-#include <stack>
+#include <iterator>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -37,50 +39,47 @@ namespace engine
  * original edge found.
  */
 
-template <typename DataFacadeT, typename BidirectionalIterator, typename Callback>
-inline void UnpackCHPath(const DataFacadeT &facade,
-                         BidirectionalIterator packed_path_begin,
-                         BidirectionalIterator packed_path_end,
-                         Callback &&callback)
+namespace detail
+{
+// Finds the CH edge between two adjacent nodes of a packed path.
+template <typename DataFacadeT>
+inline EdgeID FindCHEdge(const DataFacadeT &facade, const NodeID from, const NodeID to)
 {
-    // make sure we have at least something to unpack
-    if (packed_path_begin == packed_path_end)
-        return;
-
     using EdgeData = typename DataFacadeT::EdgeData;
 
-    std::stack<std::pair<NodeID, NodeID>> recursion_stack;
+    // Look for an edge on the forward CH graph (.forward)
+    EdgeID smaller_edge_id =
+        facade.FindSmallestEdge(from, to, [](const EdgeData &data) { return data.forward; });
 
-    // We have to push the path in reverse order onto the stack because it's LIFO.
-    for (auto current = std::prev(packed_path_end); current != packed_path_begin;
-         current = std::prev(current))
+    // If we didn't find one there, the we might be looking at a part of the path that
+    // was found using the backward search.  Here, we flip the node order (.second, .first)
+    // and only consider edges with the `.backward` flag.
+    if (SPECIAL_EDGEID == smaller_edge_id)
     {
-        recursion_stack.emplace(*std::prev(current), *current);
+        smaller_edge_id =
+            facade.FindSmallestEdge(to, from, [](const EdgeData &data) { return data.backward; });
     }
 
+    // If we didn't find anything *still*, then something is broken and someone has
+    // called this function with bad values.
+    BOOST_ASSERT_MSG(smaller_edge_id != SPECIAL_EDGEID, "Invalid smaller edge ID");
+    return smaller_edge_id;
+}
+
+// Unpacks the edges on the recursion stack depth first, the callback is called with the node
+// pair, the id and the data of every original edge.
+template <typename DataFacadeT, typename Callback>
+inline void UnpackCHEdges(const DataFacadeT &facade,
+                          std::vector<std::pair<NodeID, NodeID>> &recursion_stack,
+                          Callback &&callback)
+{
     std::pair<NodeID, NodeID> edge;
     while (!recursion_stack.empty())
     {
-        edge = recursion_stack.top();
-        recursion_stack.pop();
-
-        // Look for an edge on the forward CH graph (.forward)
-        EdgeID smaller_edge_id = facade.FindSmallestEdge(
-            edge.first, edge.second, [](const EdgeData &data) { return data.forward; });
-
-        // If we didn't find one there, the we might be looking at a part of the path that
-        // was found using the backward search.  Here, we flip the node order (.second, .first)
-        // and only consider edges with the `.backward` flag.
-        if (SPECIAL_EDGEID == smaller_edge_id)
-        {
-            smaller_edge_id = facade.FindSmallestEdge(
-                edge.second, edge.first, [](const EdgeData &data) { return data.backward; });
-        }
-
-        // If we didn't find anything *still*, then something is broken and someone has
-        // called this function with bad values.
-        BOOST_ASSERT_MSG(smaller_edge_id != SPECIAL_EDGEID, "Invalid smaller edge ID");
+        edge = recursion_stack.back();
+        recursion_stack.pop_back();
 
+        const auto smaller_edge_id = FindCHEdge(facade, edge.first, edge.second);
         const auto &data = facade.GetEdgeData(smaller_edge_id);
         BOOST_ASSERT_MSG(data.weight != std::numeric_limits<EdgeWeight>::max(),
                          "edge weight invalid");
@@ -91,13 +90,88 @@ inline void UnpackCHPath(const DataFacadeT &facade,
             const NodeID middle_node_id = data.id;
             // Note the order here - we're adding these to a stack, so we
             // want the first->middle to get visited before middle->second
-            recursion_stack.emplace(middle_node_id, edge.second);
-            recursion_stack.emplace(edge.first, middle_node_id);
+            recursion_stack.emplace_back(middle_node_id, edge.second);
+            recursion_stack.emplace_back(edge.first, middle_node_id);
         }
         else
         {
             // We found an original edge, call our callback.
+            callback(edge, smaller_edge_id, data);
+        }
+    }
+}
+}
+
+template <typename DataFacadeT, typename BidirectionalIterator, typename Callback>
+inline void UnpackCHPath(const DataFacadeT &facade,
+                         BidirectionalIterator packed_path_begin,
+                         BidirectionalIterator packed_path_end,
+                         Callback &&callback)
+{
+    // make sure we have at least something to unpack
+    if (packed_path_begin == packed_path_end)
+        return;
+
+    using EdgeData = typename DataFacadeT::EdgeData;
+
+    // The buffers are reused by all unpackings of a thread, so they only grow to the largest path
+    // once instead of allocating for every query. The callback must not unpack paths itself.
+    static thread_local std::vector<std::pair<NodeID, NodeID>> recursion_stack;
+    static thread_local std::vector<ShortcutCache::OriginalEdge> shortcut_edges;
+    recursion_stack.clear();
+
+    const auto forward_original_edge =
+        [&callback](std::pair<NodeID, NodeID> &edge, const EdgeID, const EdgeData &data) {
+            std::forward<Callback>(callback)(edge, data);
+        };
+
+    auto *const shortcut_cache = facade.GetShortcutCache();
+    if (shortcut_cache == nullptr)
+    {
+        // We have to push the path in reverse order onto the stack because it's LIFO.
+        for (auto current = std::prev(packed_path_end); current != packed_path_begin;
+             current = std::prev(current))
+        {
+            recursion_stack.emplace_back(*std::prev(current), *current);
+        }
+        detail::UnpackCHEdges(facade, recursion_stack, forward_original_edge);
+        return;
+    }
+
+    // The top level shortcuts of the path are looked up in the cache and cached after they were
+    // unpacked, shortcuts inside of them are unpacked as usual.
+    std::pair<NodeID, NodeID> edge;
+    for (auto current = packed_path_begin; std::next(current) != packed_path_end; ++current)
+    {
+        edge = std::make_pair(*current, *std::next(current));
+        const auto edge_id = detail::FindCHEdge(facade, edge.first, edge.second);
+        const auto &data = facade.GetEdgeData(edge_id);
+        if (!data.shortcut)
+        {
             std::forward<Callback>(callback)(edge, data);
+            continue;
+        }
+
+        const auto *cached = shortcut_cache->Find(edge_id);
+        if (cached == nullptr)
+        {
+            shortcut_edges.clear();
+            recursion_stack.push_back(edge);
+            detail::UnpackCHEdges(facade,
+                                  recursion_stack,
+                                  [](std::pair<NodeID, NodeID> &original,
+                                     const EdgeID original_id,
+                                     const EdgeData & /* data */) {
+                                      shortcut_edges.push_back(
+                                          {original.first, original.second, original_id});
+                                  });
+            shortcut_cache->Insert(edge_id, shortcut_edges);
+        }
+
+        for (const auto &original : cached ? cached->original_edges : shortcut_edges)
+        {
+            edge = std::make_pair(original.source, original.target);
+            std::forward<Callback>(callback)(edge, facade.GetEdgeData(original.edge));
         }
     }
 }
@@ -2,6 +2,7 @@
 #define ENGINE_HPP
 
 #include "storage/shared_barriers.hpp"
+#include "engine/api/isochrone_parameters.hpp"
 #include "engine/api/match_parameters.hpp"
 #include "engine/api/nearest_parameters.hpp"
 #include "engine/api/route_parameters.hpp"
@@ -11,6 +12,8 @@
 #include "engine/data_watchdog.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
 #include "engine/engine_config.hpp"
+#include "engine/match_session.hpp"
+#include "engine/plugins/isochrone.hpp"
 #include "engine/plugins/match.hpp"
 #include "engine/plugins/nearest.hpp"
 #include "engine/plugins/table.hpp"
@@ -19,10 +22,18 @@
 #include "engine/plugins/viaroute.hpp"
 #include "engine/status.hpp"
 #include "util/json_container.hpp"
+#include "util/json_writer.hpp"
 
+#include <tbb/task_arena.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace osrm
 {
@@ -32,7 +43,16 @@ namespace engine
 class Engine final
 {
   public:
+    // Receives the result of the query at the given index of a batch
+    using BatchCallback = std::function<void(
+        const std::size_t index, const Status status, util::json::Object &result)>;
+    // Receives the result of an asynchronous query
+    using AsyncCallback = std::function<void(const Status status, util::json::Object &result)>;
+    using AsyncTileCallback = std::function<void(const Status status, std::string &result)>;
+
     explicit Engine(const EngineConfig &config);
+    // waits for the asynchronous queries that did not finish yet
+    ~Engine();
 
     Engine(Engine &&) noexcept = delete;
     Engine &operator=(Engine &&) noexcept = delete;
@@ -41,15 +61,52 @@ class Engine final
     Engine &operator=(const Engine &) = delete;
 
     Status Route(const api::RouteParameters &parameters, util::json::Object &result) const;
+    Status Route(const api::RouteParameters &parameters, std::string &result) const;
+    void Route(const std::vector<api::RouteParameters> &parameters,
+               const BatchCallback &callback) const;
     Status Table(const api::TableParameters &parameters, util::json::Object &result) const;
+    Status Table(const api::TableParameters &parameters, util::json::Writer &result) const;
+    Status Table(const api::TableParameters &parameters, std::string &result) const;
+    void Table(const std::vector<api::TableParameters> &parameters,
+               const BatchCallback &callback) const;
     Status Nearest(const api::NearestParameters &parameters, util::json::Object &result) const;
     Status Trip(const api::TripParameters &parameters, util::json::Object &result) const;
     Status Match(const api::MatchParameters &parameters, util::json::Object &result) const;
+    Status Match(MatchSession &session,
+                 const api::MatchParameters &parameters,
+                 util::json::Object &result) const;
+    Status FinishMatch(MatchSession &session,
+                       const api::MatchParameters &parameters,
+                       util::json::Object &result) const;
     Status Tile(const api::TileParameters &parameters, std::string &result) const;
+    Status Isochrone(const api::IsochroneParameters &parameters, util::json::Object &result) const;
+
+    // Asynchronous queries return at once and run on the threads of the engine
+    void Route(const api::RouteParameters &parameters, AsyncCallback callback) const;
+    void Table(const api::TableParameters &parameters, AsyncCallback callback) const;
+    void Nearest(const api::NearestParameters &parameters, AsyncCallback callback) const;
+    void Trip(const api::TripParameters &parameters, AsyncCallback callback) const;
+    void Match(const api::MatchParameters &parameters, AsyncCallback callback) const;
+    void Tile(const api::TileParameters &parameters, AsyncTileCallback callback) const;
+    void Isochrone(const api::IsochroneParameters &parameters, AsyncCallback callback) const;
+
+    // Allocates the search heaps of the calling thread for the largest dataset
+    void WarmUpThread() const;
+
+    // Only the default dataset can be in shared memory, then the watchdog provides the
+    // up-to-date facade and there are no immutable facades. Otherwise there is a facade per
+    // NUMA node with replicas.
+    struct Dataset
+    {
+        std::unique_ptr<DataWatchdog> watchdog;
+        std::vector<std::shared_ptr<datafacade::BaseDataFacade>> immutable_data_facades;
+    };
+
+    // The dataset of a profile of EngineConfig::profiles, the default dataset for other profiles
+    const Dataset &GetDataset(const std::string &profile) const;
 
   private:
     std::unique_ptr<storage::SharedBarriers> lock;
-    std::unique_ptr<DataWatchdog> watchdog;
 
     const plugins::ViaRoutePlugin route_plugin;
     const plugins::TablePlugin table_plugin;
@@ -57,10 +114,18 @@ class Engine final
     const plugins::TripPlugin trip_plugin;
     const plugins::MatchPlugin match_plugin;
     const plugins::TilePlugin tile_plugin;
+    const plugins::IsochronePlugin isochrone_plugin;
+
+    Dataset default_dataset;
+    std::unordered_map<std::string, Dataset> profile_datasets;
+
+    // Runs a task of an asynchronous query on the work-stealing threads of the arena
+    void RunAsync(std::function<void()> task) const;
 
-    // note in case of shared memory this will be empty, since the watchdog
-    // will provide us with the up-to-date facade
-    std::shared_ptr<datafacade::BaseDataFacade> immutable_data_facade;
+    mutable tbb::task_arena async_arena;
+    mutable std::mutex async_mutex;
+    mutable std::condition_variable async_finished;
+    mutable std::size_t async_pending = 0;
 };
 }
 }
@@ -32,7 +32,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/filesystem/path.hpp>
 
+#include <cstddef>
 #include <string>
+#include <unordered_map>
 
 namespace osrm
 {
@@ -53,12 +55,57 @@ namespace engine
  *  - Match
  *  - Nearest
  *
+ * The map matching beam width limits how many of the most probable candidates of a trace point
+ * are expanded into the next one (-1 for all candidates).
+ *
  * In addition, shared memory can be used for datasets loaded with osrm-datastore.
+ * Without shared memory the r-tree leaves are memory mapped and faulted in lazily, unless
+ * prefetching them at startup is requested. The graph and geometry arrays can be backed by
+ * transparent huge pages to reduce TLB misses, osrm-datastore --huge-pages does the same for
+ * shared memory. Street names, lane tags, intersection classes and datasources can be loaded on
+ * their first use, deployments that only serve tables or nearest queries rarely need them.
+ * A dataset container written by osrm-datastore --write-container can be memory mapped as a
+ * whole instead of loading the individual files.
+ * On multi-socket hosts the dataset can be replicated into the memory of every NUMA node, queries
+ * then read the copy local to the node they run on at the cost of one copy per node.
+ * The original edges of up to shortcut_cache_size frequently unpacked shortcuts can be cached and
+ * shared by all queries, which speeds up unpacking long routes (0 disables the cache).
+ * Likewise up to tile_cache_size of the most recently requested debug tiles can be kept encoded,
+ * and the snapped phantom nodes of up to phantom_node_cache_size recently requested coordinates.
+ * Route responses can be cached in up to route_cache_size megabytes, identical requests are then
+ * answered without routing. The upward searches of up to search_space_cache_size recently used
+ * table sources can be cached as well, tables from these sources then only scan the buckets of
+ * their targets.
+ * Table queries can register up to max_target_sets named sets of destinations, whose backward
+ * searches are kept for the tables of later queries to the set (0 disables target sets).
+ * Trips of more than 16 locations are approximated and can be improved by a local search for up
+ * to trip_improvement_time milliseconds per request (0 disables the local search).
+ * Route queries between locations at least parallel_search_distance meters apart search the
+ * core of a partially contracted hierarchy in both directions at once on two threads, which
+ * shortens the longest queries (0 disables the parallel searches).
+ * Isochrones can be limited to durations of max_isochrone_duration seconds, their search covers
+ * all roads within the distance driven at the maximum speed of the profile in that time.
+ * Asynchronous queries run on a pool of async_threads threads of the instance (0 for one per
+ * core), independent of the threads that submit them.
+ * The search heaps are kept in a pool shared by the queries of the process, at most
+ * max_heap_sets queries search at the same time and the others wait for a set (0 for no limit).
+ * Additional datasets can be served by the same instance, queries select them by the profile
+ * of their parameters. They are loaded from their files, or containers with use_container, with
+ * the settings of this configuration. Queries of other profiles use the default dataset.
+ * Route queries search the contraction hierarchy, or with the MLD algorithm the multi-level
+ * overlay graph written by osrm-contract --mld, whose weights are updated much faster. The other
+ * services always use the hierarchy. The overlay graph is only loaded from files.
  *
  * \see OSRM, StorageConfig
  */
 struct EngineConfig final
 {
+    enum class Algorithm
+    {
+        CH,
+        MLD
+    };
+
     bool IsValid() const;
 
     storage::StorageConfig storage_config;
@@ -67,7 +114,34 @@ struct EngineConfig final
     int max_locations_distance_table = -1;
     int max_locations_map_matching = -1;
     int max_results_nearest = -1;
+    // in seconds
+    int max_isochrone_duration = -1;
+    int matching_beam_width = -1;
+    int trip_improvement_time = 0;
+    // in meters
+    int parallel_search_distance = 0;
     bool use_shared_memory = true;
+    bool prefetch_rtree_leaves = false;
+    bool use_huge_pages = false;
+    bool lazy_blocks = false;
+    // only for data not in shared memory, osrm-datastore has an option of its own
+    bool compress_coordinates = false;
+    bool weight_offsets = false;
+    bool compress_geometries = false;
+    bool use_container = false;
+    bool numa_replicas = false;
+    std::size_t shortcut_cache_size = 0;
+    std::size_t tile_cache_size = 0;
+    std::size_t phantom_node_cache_size = 0;
+    // in megabytes
+    std::size_t route_cache_size = 0;
+    std::size_t max_target_sets = 0;
+    std::size_t search_space_cache_size = 0;
+    std::size_t async_threads = 0;
+    std::size_t max_heap_sets = 0;
+    Algorithm algorithm = Algorithm::CH;
+    // additional datasets by the name of their profile
+    std::unordered_map<std::string, storage::StorageConfig> profiles;
 };
 }
 }
@@ -2,6 +2,7 @@
 #define GEOSPATIAL_QUERY_HPP
 
 #include "engine/phantom_node.hpp"
+#include "extractor/edge_based_node.hpp"
 #include "util/bearing.hpp"
 #include "util/coordinate_calculation.hpp"
 #include "util/rectangle.hpp"
@@ -13,6 +14,7 @@
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <numeric>
 #include <vector>
 
 namespace osrm
@@ -41,9 +43,16 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
     {
     }
 
-    std::vector<EdgeData> Search(const util::RectangleInt2D &bbox)
+    std::vector<extractor::EdgeBasedNode> Search(const util::RectangleInt2D &bbox)
     {
-        return rtree.SearchInBox(bbox);
+        const auto segments = rtree.SearchInBox(bbox);
+        std::vector<extractor::EdgeBasedNode> results;
+        results.reserve(segments.size());
+        for (const auto &segment : segments)
+        {
+            results.push_back(ToHierarchyNodes(MakeEdgeBasedNode(segment)));
+        }
+        return results;
     }
 
     // Returns nearest PhantomNodes in the given bearing range within max_distance.
@@ -73,6 +82,7 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
     {
         auto results = rtree.Nearest(
             input_coordinate,
+            RTreeT::GetBearingClasses(bearing, bearing_range),
             [this, bearing, bearing_range, max_distance](const CandidateSegment &segment) {
                 return boolPairAnd(CheckSegmentBearing(segment, bearing, bearing_range),
                                    HasValidEdge(segment));
@@ -95,6 +105,7 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
     {
         auto results = rtree.Nearest(
             input_coordinate,
+            RTreeT::GetBearingClasses(bearing, bearing_range),
             [this, bearing, bearing_range](const CandidateSegment &segment) {
                 return boolPairAnd(CheckSegmentBearing(segment, bearing, bearing_range),
                                    HasValidEdge(segment));
@@ -118,6 +129,7 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
     {
         auto results = rtree.Nearest(
             input_coordinate,
+            RTreeT::GetBearingClasses(bearing, bearing_range),
             [this, bearing, bearing_range](const CandidateSegment &segment) {
                 return boolPairAnd(CheckSegmentBearing(segment, bearing, bearing_range),
                                    HasValidEdge(segment));
@@ -177,14 +189,14 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
             input_coordinate,
             [this, &has_big_component, &has_small_component](const CandidateSegment &segment) {
                 auto use_segment = (!has_small_component ||
-                                    (!has_big_component && !segment.data.component.is_tiny));
+                                    (!has_big_component && !segment.data.is_tiny_component));
                 auto use_directions = std::make_pair(use_segment, use_segment);
                 const auto valid_edges = HasValidEdge(segment);
 
                 if (valid_edges.first || valid_edges.second)
                 {
-                    has_big_component = has_big_component || !segment.data.component.is_tiny;
-                    has_small_component = has_small_component || segment.data.component.is_tiny;
+                    has_big_component = has_big_component || !segment.data.is_tiny_component;
+                    has_small_component = has_small_component || segment.data.is_tiny_component;
                 }
                 use_directions = boolPairAnd(use_directions, valid_edges);
                 return use_directions;
@@ -216,7 +228,7 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
             input_coordinate,
             [this, &has_big_component, &has_small_component](const CandidateSegment &segment) {
                 auto use_segment = (!has_small_component ||
-                                    (!has_big_component && !segment.data.component.is_tiny));
+                                    (!has_big_component && !segment.data.is_tiny_component));
                 auto use_directions = std::make_pair(use_segment, use_segment);
                 if (!use_directions.first && !use_directions.second)
                     return use_directions;
@@ -225,8 +237,8 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                 if (valid_edges.first || valid_edges.second)
                 {
 
-                    has_big_component = has_big_component || !segment.data.component.is_tiny;
-                    has_small_component = has_small_component || segment.data.component.is_tiny;
+                    has_big_component = has_big_component || !segment.data.is_tiny_component;
+                    has_small_component = has_small_component || segment.data.is_tiny_component;
                 }
 
                 use_directions = boolPairAnd(use_directions, valid_edges);
@@ -255,10 +267,11 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
         bool has_big_component = false;
         auto results = rtree.Nearest(
             input_coordinate,
+            RTreeT::GetBearingClasses(bearing, bearing_range),
             [this, bearing, bearing_range, &has_big_component, &has_small_component](
                 const CandidateSegment &segment) {
                 auto use_segment = (!has_small_component ||
-                                    (!has_big_component && !segment.data.component.is_tiny));
+                                    (!has_big_component && !segment.data.is_tiny_component));
                 auto use_directions = std::make_pair(use_segment, use_segment);
                 use_directions = boolPairAnd(use_directions, HasValidEdge(segment));
 
@@ -269,8 +282,8 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                                     HasValidEdge(segment));
                     if (use_directions.first || use_directions.second)
                     {
-                        has_big_component = has_big_component || !segment.data.component.is_tiny;
-                        has_small_component = has_small_component || segment.data.component.is_tiny;
+                        has_big_component = has_big_component || !segment.data.is_tiny_component;
+                        has_small_component = has_small_component || segment.data.is_tiny_component;
                     }
                 }
 
@@ -302,10 +315,11 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
         bool has_big_component = false;
         auto results = rtree.Nearest(
             input_coordinate,
+            RTreeT::GetBearingClasses(bearing, bearing_range),
             [this, bearing, bearing_range, &has_big_component, &has_small_component](
                 const CandidateSegment &segment) {
                 auto use_segment = (!has_small_component ||
-                                    (!has_big_component && !segment.data.component.is_tiny));
+                                    (!has_big_component && !segment.data.is_tiny_component));
                 auto use_directions = std::make_pair(use_segment, use_segment);
                 use_directions = boolPairAnd(use_directions, HasValidEdge(segment));
 
@@ -316,8 +330,8 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                                     HasValidEdge(segment));
                     if (use_directions.first || use_directions.second)
                     {
-                        has_big_component = has_big_component || !segment.data.component.is_tiny;
-                        has_small_component = has_small_component || segment.data.component.is_tiny;
+                        has_big_component = has_big_component || !segment.data.is_tiny_component;
+                        has_small_component = has_small_component || segment.data.is_tiny_component;
                     }
                 }
 
@@ -340,58 +354,168 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
     }
 
   private:
+    // The results are mostly on a few geometries, so the weights of a geometry are decoded into
+    // prefix sums once for all phantom nodes on it instead of being summed up for each of them.
+    // Datasets with precomputed weight offsets need neither.
     std::vector<PhantomNodeWithDistance>
     MakePhantomNodes(const util::Coordinate input_coordinate,
                      const std::vector<EdgeData> &results) const
     {
         std::vector<PhantomNodeWithDistance> distance_and_phantoms(results.size());
-        std::transform(results.begin(),
-                       results.end(),
-                       distance_and_phantoms.begin(),
-                       [this, &input_coordinate](const EdgeData &data) {
-                           return MakePhantomNode(input_coordinate, data);
-                       });
+        if (results.empty())
+        {
+            return distance_and_phantoms;
+        }
+        if (results.size() == 1 ||
+            !datafacade.GetUncompressedForwardWeightOffsets(results.front().packed_geometry_id)
+                 .empty())
+        {
+            std::transform(results.begin(),
+                           results.end(),
+                           distance_and_phantoms.begin(),
+                           [this, input_coordinate](const EdgeData &data) {
+                               return MakePhantomNode(input_coordinate, data);
+                           });
+            return distance_and_phantoms;
+        }
+
+        std::vector<std::size_t> order(results.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&results](const auto lhs, const auto rhs) {
+            return results[lhs].packed_geometry_id < results[rhs].packed_geometry_id;
+        });
+
+        std::vector<EdgeWeight> forward_offsets;
+        std::vector<EdgeWeight> reverse_offsets;
+        const auto decode_offsets = [](const auto &weights, std::vector<EdgeWeight> &offsets) {
+            offsets.resize(weights.size() + 1);
+            offsets.front() = 0;
+            weights.decode(offsets.begin() + 1);
+            std::partial_sum(offsets.begin() + 1, offsets.end(), offsets.begin() + 1);
+        };
+
+        for (auto first = order.begin(); first != order.end();)
+        {
+            const auto packed_geometry_id = results[*first].packed_geometry_id;
+            const auto last = std::find_if(first, order.end(), [&](const auto index) {
+                return results[index].packed_geometry_id != packed_geometry_id;
+            });
+
+            decode_offsets(datafacade.GetUncompressedForwardWeights(packed_geometry_id),
+                           forward_offsets);
+            decode_offsets(datafacade.GetUncompressedReverseWeights(packed_geometry_id),
+                           reverse_offsets);
+
+            for (; first != last; ++first)
+            {
+                const auto &data = results[*first];
+                const std::size_t forward_position = data.fwd_segment_position;
+                BOOST_ASSERT(forward_position + 1 < reverse_offsets.size());
+                const std::size_t reverse_position =
+                    reverse_offsets.size() - 2 - data.fwd_segment_position;
+                distance_and_phantoms[*first] =
+                    MakePhantomNode(input_coordinate,
+                                    data,
+                                    forward_offsets[forward_position],
+                                    forward_offsets[forward_position + 1] -
+                                        forward_offsets[forward_position],
+                                    reverse_offsets[reverse_position],
+                                    reverse_offsets[reverse_position + 1] -
+                                        reverse_offsets[reverse_position]);
+            }
+        }
         return distance_and_phantoms;
     }
 
+    // The segments in the R-tree leave out the data of their edge-based nodes
+    extractor::EdgeBasedNode MakeEdgeBasedNode(const EdgeData &segment) const
+    {
+        const auto node_data = [this](const SegmentID segment_id) {
+            return segment_id.enabled ? datafacade.GetEdgeBasedNodeData(segment_id.id)
+                                      : extractor::EdgeBasedNodeData{};
+        };
+        return extractor::makeEdgeBasedNode(
+            segment, node_data(segment.forward_segment_id), node_data(segment.reverse_segment_id));
+    }
+
+    // The R-tree holds the ids of the edge-based nodes, the phantom nodes the ones of the
+    // hierarchy
+    extractor::EdgeBasedNode ToHierarchyNodes(extractor::EdgeBasedNode data) const
+    {
+        if (data.forward_segment_id.id != SPECIAL_SEGMENTID)
+        {
+            data.forward_segment_id.id = datafacade.GetHierarchyNode(data.forward_segment_id.id);
+        }
+        if (data.reverse_segment_id.id != SPECIAL_SEGMENTID)
+        {
+            data.reverse_segment_id.id = datafacade.GetHierarchyNode(data.reverse_segment_id.id);
+        }
+        return data;
+    }
+
     PhantomNodeWithDistance MakePhantomNode(const util::Coordinate input_coordinate,
                                             const EdgeData &data) const
     {
-        util::Coordinate point_on_segment;
-        double ratio;
-        const auto current_perpendicular_distance =
-            util::coordinate_calculation::perpendicularDistance(coordinates[data.u],
-                                                                coordinates[data.v],
-                                                                input_coordinate,
-                                                                point_on_segment,
-                                                                ratio);
-
         // Find the node-based-edge that this belongs to, and directly
         // calculate the forward_weight, forward_offset, reverse_weight, reverse_offset
 
         int forward_offset = 0, forward_weight = 0;
         int reverse_offset = 0, reverse_weight = 0;
 
-        const std::vector<EdgeWeight> forward_weight_vector =
+        const auto forward_weight_vector =
             datafacade.GetUncompressedForwardWeights(data.packed_geometry_id);
-        const std::vector<EdgeWeight> reverse_weight_vector =
+        const auto reverse_weight_vector =
             datafacade.GetUncompressedReverseWeights(data.packed_geometry_id);
 
-        for (std::size_t i = 0; i < data.fwd_segment_position; i++)
+        BOOST_ASSERT(data.fwd_segment_position < reverse_weight_vector.size());
+        const std::size_t reverse_position =
+            reverse_weight_vector.size() - data.fwd_segment_position - 1;
+
+        // the offsets are either precomputed or summed up over the segments before
+        const auto forward_offset_vector =
+            datafacade.GetUncompressedForwardWeightOffsets(data.packed_geometry_id);
+        if (!forward_offset_vector.empty())
+        {
+            BOOST_ASSERT(forward_offset_vector.size() == forward_weight_vector.size() + 1);
+            forward_offset = forward_offset_vector[data.fwd_segment_position];
+            reverse_offset = datafacade.GetUncompressedReverseWeightOffsets(
+                data.packed_geometry_id)[reverse_position];
+        }
+        else
         {
-            forward_offset += forward_weight_vector[i];
+            for (std::size_t i = 0; i < data.fwd_segment_position; i++)
+            {
+                forward_offset += forward_weight_vector[i];
+            }
+            for (std::size_t i = 0; i < reverse_position; i++)
+            {
+                reverse_offset += reverse_weight_vector[i];
+            }
         }
         forward_weight = forward_weight_vector[data.fwd_segment_position];
+        reverse_weight = reverse_weight_vector[reverse_position];
 
-        BOOST_ASSERT(data.fwd_segment_position < reverse_weight_vector.size());
+        return MakePhantomNode(
+            input_coordinate, data, forward_offset, forward_weight, reverse_offset, reverse_weight);
+    }
 
-        for (std::size_t i = 0; i < reverse_weight_vector.size() - data.fwd_segment_position - 1;
-             i++)
-        {
-            reverse_offset += reverse_weight_vector[i];
-        }
-        reverse_weight =
-            reverse_weight_vector[reverse_weight_vector.size() - data.fwd_segment_position - 1];
+    // The weights of the segment of the phantom node and the offsets of the segment in its
+    // geometry, in both directions
+    PhantomNodeWithDistance MakePhantomNode(const util::Coordinate input_coordinate,
+                                            const EdgeData &data,
+                                            const int forward_offset,
+                                            int forward_weight,
+                                            const int reverse_offset,
+                                            int reverse_weight) const
+    {
+        util::Coordinate point_on_segment;
+        double ratio;
+        const auto current_perpendicular_distance =
+            util::coordinate_calculation::perpendicularDistance(coordinates[data.u],
+                                                                coordinates[data.v],
+                                                                input_coordinate,
+                                                                point_on_segment,
+                                                                ratio);
 
         ratio = std::min(1.0, std::max(0.0, ratio));
         if (data.forward_segment_id.id != SPECIAL_SEGMENTID)
@@ -403,14 +527,15 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
             reverse_weight *= 1.0 - ratio;
         }
 
-        auto transformed = PhantomNodeWithDistance{PhantomNode{data,
-                                                               forward_weight,
-                                                               forward_offset,
-                                                               reverse_weight,
-                                                               reverse_offset,
-                                                               point_on_segment,
-                                                               input_coordinate},
-                                                   current_perpendicular_distance};
+        auto transformed =
+            PhantomNodeWithDistance{PhantomNode{ToHierarchyNodes(MakeEdgeBasedNode(data)),
+                                                forward_weight,
+                                                forward_offset,
+                                                reverse_weight,
+                                                reverse_offset,
+                                                point_on_segment,
+                                                input_coordinate},
+                                    current_perpendicular_distance};
 
         return transformed;
     }
@@ -470,7 +595,7 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
         bool forward_edge_valid = false;
         bool reverse_edge_valid = false;
 
-        const std::vector<EdgeWeight> forward_weight_vector =
+        const auto forward_weight_vector =
             datafacade.GetUncompressedForwardWeights(segment.data.packed_geometry_id);
 
         if (forward_weight_vector[segment.data.fwd_segment_position] != INVALID_EDGE_WEIGHT)
@@ -478,7 +603,7 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
             forward_edge_valid = segment.data.forward_segment_id.enabled;
         }
 
-        const std::vector<EdgeWeight> reverse_weight_vector =
+        const auto reverse_weight_vector =
             datafacade.GetUncompressedReverseWeights(segment.data.packed_geometry_id);
         if (reverse_weight_vector[reverse_weight_vector.size() - segment.data.fwd_segment_position -
                                   1] != INVALID_EDGE_WEIGHT)
@@ -32,14 +32,28 @@ namespace guidance
 //             |---| segment 1
 //                 |---| segment 2
 //                     |---| segment 3
+//
+// The annotations of the segments and the OSM node ids are only assembled if the response
+// contains them, in the same pass as the locations.
 inline LegGeometry assembleGeometry(const datafacade::BaseDataFacade &facade,
                                     const std::vector<PathData> &leg_data,
                                     const PhantomNode &source_node,
                                     const PhantomNode &target_node,
                                     const bool reversed_source,
-                                    const bool reversed_target)
+                                    const bool reversed_target,
+                                    const bool needs_annotations = true,
+                                    const bool needs_osm_node_ids = true)
 {
     LegGeometry geometry;
+    geometry.locations.reserve(leg_data.size() + 2);
+    if (needs_annotations)
+    {
+        geometry.annotations.reserve(leg_data.size() + 1);
+    }
+    if (needs_osm_node_ids)
+    {
+        geometry.osm_node_ids.reserve(leg_data.size() + 2);
+    }
 
     // segment 0 first and last
     geometry.segment_offsets.push_back(0);
@@ -50,12 +64,15 @@ inline LegGeometry assembleGeometry(const datafacade::BaseDataFacade &facade,
     // fwd_segment_position:  1
     // source node fwd:       1      1 -> 2 -> 3
     // source node rev:       2 0 <- 1 <- 2
-    const auto source_segment_start_coordinate =
-        source_node.fwd_segment_position + (reversed_source ? 1 : 0);
-    const std::vector<NodeID> source_geometry =
-        facade.GetUncompressedForwardGeometry(source_node.packed_geometry_id);
-    geometry.osm_node_ids.push_back(
-        facade.GetOSMNodeIDOfNode(source_geometry[source_segment_start_coordinate]));
+    if (needs_osm_node_ids)
+    {
+        const auto source_segment_start_coordinate =
+            source_node.fwd_segment_position + (reversed_source ? 1 : 0);
+        const auto source_geometry =
+            facade.GetUncompressedForwardGeometry(source_node.packed_geometry_id);
+        geometry.osm_node_ids.push_back(
+            facade.GetOSMNodeIDOfNode(source_geometry[source_segment_start_coordinate]));
+    }
 
     auto cumulative_distance = 0.;
     auto current_distance = 0.;
@@ -76,10 +93,16 @@ inline LegGeometry assembleGeometry(const datafacade::BaseDataFacade &facade,
         }
 
         prev_coordinate = coordinate;
-        geometry.annotations.emplace_back(LegGeometry::Annotation{
-            current_distance, path_point.duration_until_turn / 10., path_point.datasource_id});
         geometry.locations.push_back(std::move(coordinate));
-        geometry.osm_node_ids.push_back(facade.GetOSMNodeIDOfNode(path_point.turn_via_node));
+        if (needs_annotations)
+        {
+            geometry.annotations.emplace_back(LegGeometry::Annotation{
+                current_distance, path_point.duration_until_turn / 10., path_point.datasource_id});
+        }
+        if (needs_osm_node_ids)
+        {
+            geometry.osm_node_ids.push_back(facade.GetOSMNodeIDOfNode(path_point.turn_via_node));
+        }
     }
     current_distance =
         util::coordinate_calculation::haversineDistance(prev_coordinate, target_node.location);
@@ -87,13 +110,16 @@ inline LegGeometry assembleGeometry(const datafacade::BaseDataFacade &facade,
     // segment leading to the target node
     geometry.segment_distances.push_back(cumulative_distance);
 
-    const std::vector<DatasourceID> forward_datasources =
-        facade.GetUncompressedForwardDatasources(target_node.packed_geometry_id);
+    if (needs_annotations)
+    {
+        const auto forward_datasources =
+            facade.GetUncompressedForwardDatasources(target_node.packed_geometry_id);
 
-    geometry.annotations.emplace_back(
-        LegGeometry::Annotation{current_distance,
-                                target_node.forward_weight / 10.,
-                                forward_datasources[target_node.fwd_segment_position]});
+        geometry.annotations.emplace_back(
+            LegGeometry::Annotation{current_distance,
+                                    target_node.forward_weight / 10.,
+                                    forward_datasources[target_node.fwd_segment_position]});
+    }
     geometry.segment_offsets.push_back(geometry.locations.size());
     geometry.locations.push_back(target_node.location);
 
@@ -102,16 +128,20 @@ inline LegGeometry assembleGeometry(const datafacade::BaseDataFacade &facade,
     // fwd_segment_position:  1
     // target node fwd:       2  0 -> 1 -> 2
     // target node rev:       1       1 <- 2 <- 3
-    const auto target_segment_end_coordinate =
-        target_node.fwd_segment_position + (reversed_target ? 0 : 1);
-    const std::vector<NodeID> target_geometry =
-        facade.GetUncompressedForwardGeometry(target_node.packed_geometry_id);
-    geometry.osm_node_ids.push_back(
-        facade.GetOSMNodeIDOfNode(target_geometry[target_segment_end_coordinate]));
+    if (needs_osm_node_ids)
+    {
+        const auto target_segment_end_coordinate =
+            target_node.fwd_segment_position + (reversed_target ? 0 : 1);
+        const auto target_geometry =
+            facade.GetUncompressedForwardGeometry(target_node.packed_geometry_id);
+        geometry.osm_node_ids.push_back(
+            facade.GetOSMNodeIDOfNode(target_geometry[target_segment_end_coordinate]));
+    }
 
     BOOST_ASSERT(geometry.segment_distances.size() == geometry.segment_offsets.size() - 1);
     BOOST_ASSERT(geometry.locations.size() > geometry.segment_distances.size());
-    BOOST_ASSERT(geometry.annotations.size() == geometry.locations.size() - 1);
+    BOOST_ASSERT(!needs_annotations ||
+                 geometry.annotations.size() == geometry.locations.size() - 1);
 
     return geometry;
 }
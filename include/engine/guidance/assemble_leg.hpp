@@ -186,11 +186,11 @@ inline RouteLeg assembleLeg(const datafacade::BaseDataFacade &facade,
         const auto name_id_to_string = [&](const NameID name_id) {
             const auto name = facade.GetNameForID(name_id);
             if (!name.empty())
-                return name;
+                return std::string(name);
             else
             {
                 const auto ref = facade.GetRefForID(name_id);
-                return ref;
+                return std::string(ref);
             }
         };
 
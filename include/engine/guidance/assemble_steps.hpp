@@ -100,10 +100,10 @@ inline std::vector<RouteStep> assembleSteps(const datafacade::BaseDataFacade &fa
             if (path_point.turn_instruction.type != extractor::guidance::TurnType::NoTurn)
             {
                 BOOST_ASSERT(segment_duration >= 0);
-                const auto name = facade.GetNameForID(step_name_id);
-                const auto ref = facade.GetRefForID(step_name_id);
-                const auto pronunciation = facade.GetPronunciationForID(step_name_id);
-                const auto destinations = facade.GetDestinationsForID(step_name_id);
+                auto name = facade.GetNameForID(step_name_id);
+                auto ref = facade.GetRefForID(step_name_id);
+                auto pronunciation = facade.GetPronunciationForID(step_name_id);
+                auto destinations = facade.GetDestinationsForID(step_name_id);
                 const auto distance = leg_geometry.segment_distances[segment_index];
 
                 steps.push_back(RouteStep{step_name_id,
@@ -139,7 +139,9 @@ inline std::vector<RouteStep> assembleSteps(const datafacade::BaseDataFacade &fa
                 auto bearing_data = bearing_class.getAvailableBearings();
                 intersection.in = bearing_class.findMatchingBearing(bearings.first);
                 intersection.out = bearing_class.findMatchingBearing(bearings.second);
-                intersection.location = facade.GetCoordinateOfNode(path_point.turn_via_node);
+                // the turn location ends the segment in the already assembled geometry
+                intersection.location =
+                    leg_geometry.locations[leg_geometry.BackIndex(segment_index)];
                 intersection.bearings.clear();
                 intersection.bearings.reserve(bearing_class.getAvailableBearings().size());
                 intersection.lanes = path_point.lane_data.first;
@@ -31,7 +31,7 @@ struct LegGeometry
     std::vector<std::size_t> segment_offsets;
     // length of the segment in meters
     std::vector<double> segment_distances;
-    // original OSM node IDs for each coordinate
+    // original OSM node IDs for each coordinate, empty unless annotations are requested
     std::vector<OSMNodeID> osm_node_ids;
 
     // Per-coordinate metadata
@@ -41,6 +41,7 @@ struct LegGeometry
         double duration;
         DatasourceID datasource;
     };
+    // empty unless annotations are requested
     std::vector<Annotation> annotations;
 
     std::size_t FrontIndex(std::size_t segment_index) const
@@ -9,6 +9,7 @@
 
 #include "extractor/guidance/turn_lane_types.hpp"
 #include "util/guidance/turn_lanes.hpp"
+#include "util/string_view.hpp"
 
 #include <cstddef>
 
@@ -54,15 +55,17 @@ inline Intersection getInvalidIntersection()
             {}};
 }
 
+// The names are views into the names of the data facade, they are only copied into strings when
+// the response is written. Steps must not outlive the facade they were assembled with.
 struct RouteStep
 {
     unsigned name_id;
-    std::string name;
-    std::string ref;
-    std::string pronunciation;
-    std::string destinations;
-    std::string rotary_name;
-    std::string rotary_pronunciation;
+    util::StringView name;
+    util::StringView ref;
+    util::StringView pronunciation;
+    util::StringView destinations;
+    util::StringView rotary_name;
+    util::StringView rotary_pronunciation;
     double duration;
     double distance;
     extractor::TravelMode mode;
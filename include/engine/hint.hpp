@@ -57,7 +57,11 @@ struct Hint
                  const datafacade::BaseDataFacade &facade) const;
 
     std::string ToBase64() const;
+    // Encodes the hint to the ENCODED_HINT_SIZE characters of a buffer
+    void ToBase64(char *base64Hint) const;
     static Hint FromBase64(const std::string &base64Hint);
+    // Decodes the ENCODED_HINT_SIZE characters of a hint from a buffer
+    static Hint FromBase64(const char *base64Hint);
 
     friend bool operator==(const Hint &, const Hint &);
     friend std::ostream &operator<<(std::ostream &, const Hint &);
@@ -8,7 +8,9 @@
 
 #include <cmath>
 
+#include <algorithm>
 #include <limits>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -48,73 +50,136 @@ struct TransitionLogProbability
     double operator()(const double d_t) const { return -log_beta - d_t / beta; }
 };
 
-template <class CandidateLists> struct HiddenMarkovModel
+// The state of the candidates of all timestamps of a trace. Every field keeps the values of all
+// candidates in one buffer, the candidates of timestamp t are [offsets[t], offsets[t + 1]) in
+// all of them, so the Viterbi steps run over contiguous memory. A thread reuses its model for
+// all traces it matches, Initialize only grows the buffers. Matching sessions append the
+// timestamps of new points and drop the ones whose match is final.
+struct HiddenMarkovModel
 {
-    std::vector<std::vector<double>> viterbi;
-    std::vector<std::vector<std::pair<unsigned, unsigned>>> parents;
-    std::vector<std::vector<float>> path_distances;
-    std::vector<std::vector<bool>> pruned;
+    std::vector<std::size_t> offsets = {0};
+    std::vector<double> emission_log_probabilities;
+    std::vector<double> viterbi;
+    std::vector<std::pair<unsigned, unsigned>> parents;
+    std::vector<float> path_distances;
+    std::vector<bool> pruned;
     std::vector<bool> breakage;
 
-    const CandidateLists &candidates_list;
-    const std::vector<std::vector<double>> &emission_log_probabilities;
+    // Lays out the candidates of a trace, the emission probabilities are left to the caller
+    template <class CandidateLists> void Initialize(const CandidateLists &candidates_list)
+    {
+        offsets.resize(1);
+        breakage.clear();
+        Append(candidates_list);
+    }
 
-    HiddenMarkovModel(const CandidateLists &candidates_list,
-                      const std::vector<std::vector<double>> &emission_log_probabilities)
-        : breakage(candidates_list.size()), candidates_list(candidates_list),
-          emission_log_probabilities(emission_log_probabilities)
+    // Lays out the candidates of the timestamps of candidates_list the model does not have yet
+    template <class CandidateLists> void Append(const CandidateLists &candidates_list)
     {
-        viterbi.resize(candidates_list.size());
-        parents.resize(candidates_list.size());
-        path_distances.resize(candidates_list.size());
-        pruned.resize(candidates_list.size());
+        const auto first_timestamp = NumberOfTimestamps();
+        BOOST_ASSERT(first_timestamp <= candidates_list.size());
+
+        offsets.resize(candidates_list.size() + 1);
+        for (const auto t : util::irange<std::size_t>(first_timestamp, candidates_list.size()))
+        {
+            offsets[t + 1] = offsets[t] + candidates_list[t].size();
+        }
+
+        const auto num_candidates = offsets.back();
+        emission_log_probabilities.resize(num_candidates);
+        viterbi.resize(num_candidates);
+        parents.resize(num_candidates);
+        path_distances.resize(num_candidates);
+        pruned.resize(num_candidates);
         breakage.resize(candidates_list.size());
-        for (const auto i : util::irange<std::size_t>(0UL, candidates_list.size()))
+
+        Clear(first_timestamp);
+    }
+
+    // Removes the first timestamps, the others move to the front. Parents in the removed
+    // timestamps are replaced by the states themselves, which start the remaining paths.
+    void DropFront(const std::size_t num_timestamps)
+    {
+        BOOST_ASSERT(num_timestamps <= NumberOfTimestamps());
+        const auto num_candidates = offsets[num_timestamps];
+
+        emission_log_probabilities.erase(emission_log_probabilities.begin(),
+                                         emission_log_probabilities.begin() + num_candidates);
+        viterbi.erase(viterbi.begin(), viterbi.begin() + num_candidates);
+        parents.erase(parents.begin(), parents.begin() + num_candidates);
+        path_distances.erase(path_distances.begin(), path_distances.begin() + num_candidates);
+        pruned.erase(pruned.begin(), pruned.begin() + num_candidates);
+        breakage.erase(breakage.begin(), breakage.begin() + num_timestamps);
+
+        offsets.erase(offsets.begin(), offsets.begin() + num_timestamps);
+        for (auto &offset : offsets)
+        {
+            offset -= num_candidates;
+        }
+
+        for (const auto t : util::irange<std::size_t>(0UL, NumberOfTimestamps()))
         {
-            const auto &num_candidates = candidates_list[i].size();
-            // add empty vectors
-            if (num_candidates > 0)
+            for (const auto s : util::irange<std::size_t>(0UL, NumberOfCandidates(t)))
             {
-                viterbi[i].resize(num_candidates);
-                parents[i].resize(num_candidates);
-                path_distances[i].resize(num_candidates);
-                pruned[i].resize(num_candidates);
+                auto &parent = parents[Index(t, s)];
+                // states that continued a dropped one start their paths now
+                if (parent.first < num_timestamps)
+                {
+                    parent = std::make_pair(t, s);
+                    path_distances[Index(t, s)] = 0;
+                }
+                else
+                {
+                    parent.first -= num_timestamps;
+                }
             }
         }
+    }
 
-        Clear(0);
+    std::size_t NumberOfTimestamps() const { return breakage.size(); }
+
+    std::size_t NumberOfCandidates(const std::size_t t) const
+    {
+        return offsets[t + 1] - offsets[t];
+    }
+
+    // Position of the candidate s of timestamp t in the fields
+    std::size_t Index(const std::size_t t, const std::size_t s) const
+    {
+        BOOST_ASSERT(offsets[t] + s < offsets[t + 1]);
+        return offsets[t] + s;
     }
 
     void Clear(std::size_t initial_timestamp)
     {
         BOOST_ASSERT(viterbi.size() == parents.size() && parents.size() == path_distances.size() &&
-                     path_distances.size() == pruned.size() && pruned.size() == breakage.size());
-
-        for (const auto t : util::irange(initial_timestamp, viterbi.size()))
-        {
-            std::fill(viterbi[t].begin(), viterbi[t].end(), IMPOSSIBLE_LOG_PROB);
-            std::fill(parents[t].begin(), parents[t].end(), std::make_pair(0u, 0u));
-            std::fill(path_distances[t].begin(), path_distances[t].end(), 0);
-            std::fill(pruned[t].begin(), pruned[t].end(), true);
-        }
+                     path_distances.size() == pruned.size() &&
+                     offsets.size() == breakage.size() + 1);
+
+        const auto first = offsets[initial_timestamp];
+        std::fill(viterbi.begin() + first, viterbi.end(), IMPOSSIBLE_LOG_PROB);
+        std::fill(parents.begin() + first, parents.end(), std::make_pair(0u, 0u));
+        std::fill(path_distances.begin() + first, path_distances.end(), 0);
+        std::fill(pruned.begin() + first, pruned.end(), true);
         std::fill(breakage.begin() + initial_timestamp, breakage.end(), true);
     }
 
     std::size_t initialize(std::size_t initial_timestamp)
     {
-        auto num_points = candidates_list.size();
+        auto num_points = NumberOfTimestamps();
         do
         {
             BOOST_ASSERT(initial_timestamp < num_points);
 
-            for (const auto s : util::irange<std::size_t>(0UL, viterbi[initial_timestamp].size()))
+            for (const auto s :
+                 util::irange<std::size_t>(0UL, NumberOfCandidates(initial_timestamp)))
             {
-                viterbi[initial_timestamp][s] = emission_log_probabilities[initial_timestamp][s];
-                parents[initial_timestamp][s] = std::make_pair(initial_timestamp, s);
-                pruned[initial_timestamp][s] = viterbi[initial_timestamp][s] < MINIMAL_LOG_PROB;
+                const auto index = Index(initial_timestamp, s);
+                viterbi[index] = emission_log_probabilities[index];
+                parents[index] = std::make_pair(initial_timestamp, s);
+                pruned[index] = viterbi[index] < MINIMAL_LOG_PROB;
 
-                breakage[initial_timestamp] =
-                    breakage[initial_timestamp] && pruned[initial_timestamp][s];
+                breakage[initial_timestamp] = breakage[initial_timestamp] && pruned[index];
             }
 
             ++initial_timestamp;
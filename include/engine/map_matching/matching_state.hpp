@@ -0,0 +1,105 @@
+#ifndef MAP_MATCHING_MATCHING_STATE_HPP
+#define MAP_MATCHING_MATCHING_STATE_HPP
+
+#include "engine/datafacade/datafacade_base.hpp"
+#include "engine/map_matching/hidden_markov_model.hpp"
+#include "engine/phantom_node.hpp"
+
+#include "util/coordinate.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace map_matching
+{
+
+// Where the Viterbi algorithm is in a trace: the timestamps it can continue from, the breakage
+// it is in and the split points it found. Timestamps are positions in the model.
+struct ViterbiState
+{
+    // timestamps with states that the next timestamp can continue from, the latest one last
+    std::vector<std::size_t> prev_unbroken_timestamps;
+    std::size_t breakage_begin = INVALID_STATE;
+    // ends of the sub matchings that are not collected yet
+    std::vector<std::size_t> split_points;
+    // first timestamp of the sub matching that is not collected yet
+    std::size_t sub_matching_begin = 0;
+    // first timestamp the algorithm did not process yet
+    std::size_t next_timestamp = 0;
+    // without unbroken timestamps the algorithm looks for a new start from here
+    std::size_t restart_timestamp = 0;
+
+    void DropFront(const std::size_t num_timestamps)
+    {
+        BOOST_ASSERT(split_points.empty());
+        BOOST_ASSERT(sub_matching_begin >= num_timestamps);
+        for (auto &timestamp : prev_unbroken_timestamps)
+        {
+            BOOST_ASSERT(timestamp >= num_timestamps);
+            timestamp -= num_timestamps;
+        }
+        if (breakage_begin != INVALID_STATE)
+        {
+            breakage_begin -= num_timestamps;
+        }
+        sub_matching_begin -= num_timestamps;
+        next_timestamp -= num_timestamps;
+        restart_timestamp -= std::min(restart_timestamp, num_timestamps);
+    }
+};
+
+// A trace that is matched while its points arrive. It keeps the points from the first one whose
+// match can still change, the window, and the model and Viterbi state over them.
+struct MatchingState
+{
+    // the dataset of the first points, the session keeps using it
+    std::shared_ptr<datafacade::BaseDataFacade> facade;
+
+    // position of the first point of the window in the trace
+    std::size_t offset = 0;
+    // the points before this position of the trace got their final tracepoints
+    std::size_t tracepoints_end = 0;
+    // the first points decide whether the session uses timestamps
+    bool use_timestamps = false;
+    // timestamp of the last point, the timestamps of later points can not be smaller
+    unsigned last_timestamp = 0;
+
+    std::vector<std::vector<PhantomNodeWithDistance>> candidates_list;
+    std::vector<util::Coordinate> coordinates;
+    std::vector<unsigned> timestamps;
+    std::vector<boost::optional<double>> gps_precisions;
+
+    HiddenMarkovModel model;
+    ViterbiState viterbi;
+
+    std::size_t NumberOfPoints() const { return offset + coordinates.size(); }
+
+    void DropFront(const std::size_t num_points)
+    {
+        BOOST_ASSERT(num_points <= coordinates.size());
+        candidates_list.erase(candidates_list.begin(), candidates_list.begin() + num_points);
+        coordinates.erase(coordinates.begin(), coordinates.begin() + num_points);
+        if (use_timestamps)
+        {
+            timestamps.erase(timestamps.begin(), timestamps.begin() + num_points);
+        }
+        gps_precisions.erase(gps_precisions.begin(), gps_precisions.begin() + num_points);
+        model.DropFront(num_points);
+        viterbi.DropFront(num_points);
+        offset += num_points;
+    }
+};
+}
+}
+}
+
+#endif // MAP_MATCHING_MATCHING_STATE_HPP
@@ -0,0 +1,80 @@
+/*
+
+Copyright (c) 2016, Project OSRM contributors
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef ENGINE_MATCH_SESSION_HPP
+#define ENGINE_MATCH_SESSION_HPP
+
+#include <cstddef>
+#include <memory>
+
+namespace osrm
+{
+namespace engine
+{
+namespace map_matching
+{
+struct MatchingState;
+}
+namespace plugins
+{
+class MatchPlugin;
+}
+
+/**
+ * A trace that is matched while its coordinates arrive.
+ *
+ * Every Match query with the session appends its coordinates to the trace and returns the
+ * tracepoints and matchings that can no longer change, FinishMatch returns the rest. The
+ * session only keeps the coordinates whose match is not final, so traces of any length can
+ * be matched in constant memory. A session uses the dataset of its first query until it is
+ * finished and is not thread safe.
+ * \see OSRM::Match
+ */
+class MatchSession final
+{
+  public:
+    MatchSession();
+    ~MatchSession();
+
+    // Moveable but not copyable
+    MatchSession(MatchSession &&) noexcept;
+    MatchSession &operator=(MatchSession &&) noexcept;
+
+    // number of coordinates that were appended to the trace
+    std::size_t NumberOfCoordinates() const;
+    // number of coordinates that got their final tracepoints
+    std::size_t NumberOfTracepoints() const;
+
+  private:
+    friend class plugins::MatchPlugin;
+    std::unique_ptr<map_matching::MatchingState> state;
+};
+}
+}
+
+#endif // ENGINE_MATCH_SESSION_HPP
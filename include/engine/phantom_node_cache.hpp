@@ -0,0 +1,166 @@
+#ifndef OSRM_ENGINE_PHANTOM_NODE_CACHE_HPP
+#define OSRM_ENGINE_PHANTOM_NODE_CACHE_HPP
+
+#include "engine/bearing.hpp"
+#include "engine/phantom_node.hpp"
+#include "util/coordinate.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/optional.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Snapped phantom nodes of recently requested coordinates, shared by all queries on a dataset.
+// Clients that send the same depots and vehicle positions over and over skip the r-tree search
+// for them. Like the tile cache it lives with the dataset, a new dataset starts empty.
+//
+// A coordinate is cached with the radius and bearing it was snapped with. The entries are spread
+// over shards with a lock each, every shard evicts its entries in least recently used order.
+class PhantomNodeCache
+{
+  public:
+    static const constexpr std::size_t NUMBER_OF_SHARDS = 16;
+
+    explicit PhantomNodeCache(const std::size_t number_of_entries)
+    {
+        BOOST_ASSERT(number_of_entries > 0);
+        for (auto &shard : shards)
+        {
+            shard.number_of_entries = (number_of_entries + NUMBER_OF_SHARDS - 1) / NUMBER_OF_SHARDS;
+        }
+    }
+
+    PhantomNodeCache(const PhantomNodeCache &) = delete;
+    PhantomNodeCache &operator=(const PhantomNodeCache &) = delete;
+
+    // copies the cached phantom nodes into the pair, false if they are not cached
+    bool Find(const util::Coordinate coordinate,
+              const boost::optional<double> &radius,
+              const boost::optional<Bearing> &bearing,
+              PhantomNodePair &phantom_nodes)
+    {
+        const Key key = makeKey(coordinate, radius, bearing);
+        auto &shard = getShard(key);
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto position = shard.positions.find(key);
+        if (position == shard.positions.end())
+        {
+            return false;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, position->second);
+        phantom_nodes = position->second->second;
+        return true;
+    }
+
+    void Insert(const util::Coordinate coordinate,
+                const boost::optional<double> &radius,
+                const boost::optional<Bearing> &bearing,
+                const PhantomNodePair &phantom_nodes)
+    {
+        const Key key = makeKey(coordinate, radius, bearing);
+        auto &shard = getShard(key);
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto position = shard.positions.find(key);
+        if (position != shard.positions.end())
+        {
+            // another query snapped the same coordinate in the meantime
+            shard.entries.splice(shard.entries.begin(), shard.entries, position->second);
+            return;
+        }
+
+        if (shard.entries.size() == shard.number_of_entries)
+        {
+            shard.positions.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+        }
+        shard.entries.emplace_front(key, phantom_nodes);
+        shard.positions.emplace(key, shard.entries.begin());
+    }
+
+    std::size_t GetNumberOfEntries() const
+    {
+        std::size_t number_of_entries = 0;
+        for (const auto &shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            number_of_entries += shard.entries.size();
+        }
+        return number_of_entries;
+    }
+
+  private:
+    struct Key
+    {
+        std::int32_t lon;
+        std::int32_t lat;
+        // negative without a radius, the default radius is the same for every query
+        double radius;
+        // the range is negative without a bearing
+        short bearing;
+        short range;
+
+        bool operator==(const Key &other) const
+        {
+            return lon == other.lon && lat == other.lat && radius == other.radius &&
+                   bearing == other.bearing && range == other.range;
+        }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &key) const
+        {
+            std::size_t seed = 0;
+            boost::hash_combine(seed, key.lon);
+            boost::hash_combine(seed, key.lat);
+            boost::hash_combine(seed, key.radius);
+            boost::hash_combine(seed, key.bearing);
+            boost::hash_combine(seed, key.range);
+            return seed;
+        }
+    };
+
+    using Entries = std::list<std::pair<Key, PhantomNodePair>>;
+
+    struct Shard
+    {
+        std::size_t number_of_entries;
+        mutable std::mutex mutex;
+        // most recently used entry first
+        Entries entries;
+        std::unordered_map<Key, Entries::iterator, KeyHash> positions;
+    };
+
+    static Key makeKey(const util::Coordinate coordinate,
+                       const boost::optional<double> &radius,
+                       const boost::optional<Bearing> &bearing)
+    {
+        return Key{static_cast<std::int32_t>(coordinate.lon),
+                   static_cast<std::int32_t>(coordinate.lat),
+                   radius ? *radius : -1.,
+                   bearing ? bearing->bearing : short{0},
+                   bearing ? bearing->range : short{-1}};
+    }
+
+    Shard &getShard(const Key &key) { return shards[KeyHash{}(key) % NUMBER_OF_SHARDS]; }
+
+    std::array<Shard, NUMBER_OF_SHARDS> shards;
+};
+}
+}
+
+#endif // OSRM_ENGINE_PHANTOM_NODE_CACHE_HPP
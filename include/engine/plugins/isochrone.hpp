@@ -0,0 +1,37 @@
+#ifndef ISOCHRONE_HPP
+#define ISOCHRONE_HPP
+
+#include "engine/plugins/plugin_base.hpp"
+
+#include "engine/api/isochrone_parameters.hpp"
+#include "engine/routing_algorithms/facade_dispatch.hpp"
+#include "engine/routing_algorithms/isochrone.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/json_container.hpp"
+
+namespace osrm
+{
+namespace engine
+{
+namespace plugins
+{
+
+class IsochronePlugin final : public BasePlugin
+{
+  public:
+    explicit IsochronePlugin(const int max_isochrone_duration);
+
+    Status HandleRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
+                         const api::IsochroneParameters &params,
+                         util::json::Object &result) const;
+
+  private:
+    mutable SearchEngineData heaps;
+    mutable routing_algorithms::FacadeDispatch<routing_algorithms::IsochroneRouting> isochrone;
+    const int max_isochrone_duration;
+};
+}
+}
+}
+
+#endif // ISOCHRONE_HPP
@@ -5,10 +5,14 @@
 #include "engine/plugins/plugin_base.hpp"
 
 #include "engine/map_matching/bayes_classifier.hpp"
+#include "engine/match_session.hpp"
+#include "engine/routing_algorithms/facade_dispatch.hpp"
 #include "engine/routing_algorithms/map_matching.hpp"
 #include "engine/routing_algorithms/shortest_path.hpp"
 #include "util/json_util.hpp"
 
+#include <cstddef>
+#include <memory>
 #include <vector>
 
 namespace osrm
@@ -26,9 +30,11 @@ class MatchPlugin : public BasePlugin
     using CandidateLists = routing_algorithms::CandidateLists;
     static const constexpr double DEFAULT_GPS_PRECISION = 5;
     static const constexpr double RADIUS_MULTIPLIER = 3;
+    // points a session keeps at most if the number of locations is not limited
+    static const constexpr std::size_t DEFAULT_SESSION_WINDOW = 1000;
 
-    MatchPlugin(const int max_locations_map_matching)
-        : map_matching(heaps, DEFAULT_GPS_PRECISION), shortest_path(heaps),
+    MatchPlugin(const int max_locations_map_matching, const int matching_beam_width = -1)
+        : map_matching(heaps, DEFAULT_GPS_PRECISION, matching_beam_width), shortest_path(heaps),
           max_locations_map_matching(max_locations_map_matching)
     {
     }
@@ -37,10 +43,23 @@ class MatchPlugin : public BasePlugin
                          const api::MatchParameters &parameters,
                          util::json::Object &json_result) const;
 
+    // Appends the coordinates to the trace of the session and responds with the tracepoints
+    // and matchings that are final, or with all remaining ones if the session is finished
+    Status HandleRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
+                         MatchSession &session,
+                         const api::MatchParameters &parameters,
+                         const bool finish,
+                         util::json::Object &json_result) const;
+
   private:
+    void RouteSubMatchings(const datafacade::BaseDataFacade &facade,
+                           const SubMatchingList &sub_matchings,
+                           std::vector<InternalRouteResult> &sub_routes) const;
+
     mutable SearchEngineData heaps;
-    mutable routing_algorithms::MapMatching<datafacade::BaseDataFacade> map_matching;
-    mutable routing_algorithms::ShortestPathRouting<datafacade::BaseDataFacade> shortest_path;
+    mutable routing_algorithms::FacadeDispatch<routing_algorithms::MapMatching> map_matching;
+    mutable routing_algorithms::FacadeDispatch<routing_algorithms::ShortestPathRouting>
+        shortest_path;
     const int max_locations_map_matching;
 };
 }
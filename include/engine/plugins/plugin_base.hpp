@@ -2,16 +2,22 @@
 #define BASE_PLUGIN_HPP
 
 #include "engine/api/base_parameters.hpp"
+#include "engine/api/pbf_factory.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
 #include "engine/phantom_node.hpp"
+#include "engine/query_metrics.hpp"
 #include "engine/status.hpp"
 
+#include "util/allocation_statistics.hpp"
 #include "util/coordinate.hpp"
 #include "util/coordinate_calculation.hpp"
 #include "util/integer_range.hpp"
 #include "util/json_container.hpp"
+#include "util/json_writer.hpp"
+#include "util/probes.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <iterator>
 #include <string>
 #include <vector>
@@ -26,6 +32,22 @@ namespace plugins
 class BasePlugin
 {
   protected:
+    // Records the time since phase_start for the phase, returns the start of the next phase
+    static std::chrono::steady_clock::time_point
+    RecordPhase(const QueryType type,
+                const QueryPhase phase,
+                const std::chrono::steady_clock::time_point phase_start)
+    {
+        const auto phase_end = std::chrono::steady_clock::now();
+        QueryMetrics::GetInstance().Record(type, phase, phase_end - phase_start);
+        OSRM_PROBE3(phase__done,
+                    static_cast<int>(type),
+                    static_cast<int>(phase),
+                    std::chrono::duration_cast<std::chrono::microseconds>(phase_end - phase_start)
+                        .count());
+        return phase_end;
+    }
+
     bool CheckAllCoordinates(const std::vector<util::Coordinate> &coordinates) const
     {
         return !std::any_of(
@@ -34,6 +56,8 @@ class BasePlugin
             });
     }
 
+  public:
+    // Writes an error response, the engine uses these for errors before a plugin runs
     Status Error(const std::string &code,
                  const std::string &message,
                  util::json::Object &json_result) const
@@ -43,11 +67,32 @@ class BasePlugin
         return Status::Error;
     }
 
+    Status Error(const std::string &code,
+                 const std::string &message,
+                 util::json::Writer &json_result) const
+    {
+        json_result.BeginObject();
+        json_result.Key("code");
+        json_result.String(code);
+        json_result.Key("message");
+        json_result.String(message);
+        json_result.EndObject();
+        return Status::Error;
+    }
+
+    Status Error(const std::string &code, const std::string &message, std::string &pbf_result) const
+    {
+        api::pbf::writeError(pbf_result, code, message);
+        return Status::Error;
+    }
+
+  protected:
     // Decides whether to use the phantom node from a big or small component if both are found.
     // Returns true if all phantom nodes are in the same component after snapping.
     std::vector<PhantomNode>
     SnapPhantomNodes(const std::vector<PhantomNodePair> &phantom_node_pair_list) const
     {
+        util::AllocationPhaseScope allocation_phase(util::AllocationPhase::PhantomLookup);
         const auto check_component_id_is_tiny =
             [](const std::pair<PhantomNode, PhantomNode> &phantom_pair) {
                 return phantom_pair.first.component.is_tiny;
@@ -112,6 +157,7 @@ class BasePlugin
                            const api::BaseParameters &parameters,
                            const std::vector<double> radiuses) const
     {
+        util::AllocationPhaseScope allocation_phase(util::AllocationPhase::PhantomLookup);
         std::vector<std::vector<PhantomNodeWithDistance>> phantom_nodes(
             parameters.coordinates.size());
         BOOST_ASSERT(radiuses.size() == parameters.coordinates.size());
@@ -131,6 +177,15 @@ class BasePlugin
                 });
                 continue;
             }
+            // repeated points, e.g. of a stopped vehicle, have the candidates of the point before
+            if (i > 0 && parameters.coordinates[i] == parameters.coordinates[i - 1] &&
+                radiuses[i] == radiuses[i - 1] &&
+                (!use_bearings || parameters.bearings[i] == parameters.bearings[i - 1]) &&
+                (!use_hints || !parameters.hints[i - 1]))
+            {
+                phantom_nodes[i] = phantom_nodes[i - 1];
+                continue;
+            }
             if (use_bearings && parameters.bearings[i])
             {
                 phantom_nodes[i] =
@@ -154,6 +209,7 @@ class BasePlugin
                     const api::BaseParameters &parameters,
                     unsigned number_of_results) const
     {
+        util::AllocationPhaseScope allocation_phase(util::AllocationPhase::PhantomLookup);
         std::vector<std::vector<PhantomNodeWithDistance>> phantom_nodes(
             parameters.coordinates.size());
 
@@ -219,11 +275,15 @@ class BasePlugin
     std::vector<PhantomNodePair> GetPhantomNodes(const datafacade::BaseDataFacade &facade,
                                                  const api::BaseParameters &parameters) const
     {
+        util::AllocationPhaseScope allocation_phase(util::AllocationPhase::PhantomLookup);
         std::vector<PhantomNodePair> phantom_node_pairs(parameters.coordinates.size());
 
         const bool use_hints = !parameters.hints.empty();
         const bool use_bearings = !parameters.bearings.empty();
         const bool use_radiuses = !parameters.radiuses.empty();
+        auto *const phantom_node_cache = facade.GetPhantomNodeCache();
+        const boost::optional<double> no_radius;
+        const boost::optional<Bearing> no_bearing;
 
         BOOST_ASSERT(parameters.IsValid());
         for (const auto i : util::irange<std::size_t>(0UL, parameters.coordinates.size()))
@@ -236,6 +296,15 @@ class BasePlugin
                 continue;
             }
 
+            const auto &radius = use_radiuses ? parameters.radiuses[i] : no_radius;
+            const auto &bearing = use_bearings ? parameters.bearings[i] : no_bearing;
+            if (phantom_node_cache &&
+                phantom_node_cache->Find(
+                    parameters.coordinates[i], radius, bearing, phantom_node_pairs[i]))
+            {
+                continue;
+            }
+
             if (use_bearings && parameters.bearings[i])
             {
                 if (use_radiuses && parameters.radiuses[i])
@@ -281,6 +350,12 @@ class BasePlugin
             }
             BOOST_ASSERT(phantom_node_pairs[i].first.IsValid(facade.GetNumberOfNodes()));
             BOOST_ASSERT(phantom_node_pairs[i].second.IsValid(facade.GetNumberOfNodes()));
+
+            if (phantom_node_cache)
+            {
+                phantom_node_cache->Insert(
+                    parameters.coordinates[i], radius, bearing, phantom_node_pairs[i]);
+            }
         }
         return phantom_node_pairs;
     }
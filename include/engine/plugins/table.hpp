@@ -4,9 +4,15 @@
 #include "engine/plugins/plugin_base.hpp"
 
 #include "engine/api/table_parameters.hpp"
+#include "engine/routing_algorithms/facade_dispatch.hpp"
 #include "engine/routing_algorithms/many_to_many.hpp"
 #include "engine/search_engine_data.hpp"
+#include "engine/target_set_cache.hpp"
 #include "util/json_container.hpp"
+#include "util/json_writer.hpp"
+
+#include <cstddef>
+#include <memory>
 
 namespace osrm
 {
@@ -18,16 +24,40 @@ namespace plugins
 class TablePlugin final : public BasePlugin
 {
   public:
-    explicit TablePlugin(const int max_locations_distance_table);
+    // keeps up to max_target_sets target sets, 0 disables them
+    TablePlugin(const int max_locations_distance_table, const std::size_t max_target_sets = 0);
 
     Status HandleRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
                          const api::TableParameters &params,
                          util::json::Object &result) const;
 
+    Status HandleRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
+                         const api::TableParameters &params,
+                         util::json::Writer &result) const;
+
+    Status HandleRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
+                         const api::TableParameters &params,
+                         std::string &result) const;
+
   private:
+    template <typename ResultT>
+    Status HandleTableRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
+                              const api::TableParameters &params,
+                              ResultT &result) const;
+
+    // the set of the parameters snapped to the facade, searched on its first use
+    TargetSetCache::SnappedTargets
+    GetSnappedTargets(const std::shared_ptr<datafacade::BaseDataFacade> &facade,
+                      const api::TableParameters &params,
+                      const TargetSetCache::Targets &targets,
+                      const std::vector<PhantomNode> &snapped_phantoms) const;
+
     mutable SearchEngineData heaps;
-    mutable routing_algorithms::ManyToManyRouting<datafacade::BaseDataFacade> distance_table;
+    mutable routing_algorithms::FacadeDispatch<routing_algorithms::ManyToManyRouting>
+        distance_table;
     const int max_locations_distance_table;
+    // nullptr unless target sets are enabled
+    const std::unique_ptr<TargetSetCache> target_sets;
 };
 }
 }
@@ -4,6 +4,7 @@
 #include "engine/plugins/plugin_base.hpp"
 
 #include "engine/api/trip_parameters.hpp"
+#include "engine/routing_algorithms/facade_dispatch.hpp"
 #include "engine/routing_algorithms/many_to_many.hpp"
 #include "engine/routing_algorithms/shortest_path.hpp"
 
@@ -12,6 +13,7 @@
 #include <boost/assert.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <iterator>
 #include <memory>
@@ -30,17 +32,21 @@ class TripPlugin final : public BasePlugin
 {
   private:
     mutable SearchEngineData heaps;
-    mutable routing_algorithms::ShortestPathRouting<datafacade::BaseDataFacade> shortest_path;
-    mutable routing_algorithms::ManyToManyRouting<datafacade::BaseDataFacade> duration_table;
+    mutable routing_algorithms::FacadeDispatch<routing_algorithms::ShortestPathRouting>
+        shortest_path;
+    mutable routing_algorithms::FacadeDispatch<routing_algorithms::ManyToManyRouting>
+        duration_table;
     const int max_locations_trip;
+    const std::chrono::milliseconds trip_improvement_time;
 
     InternalRouteResult ComputeRoute(const datafacade::BaseDataFacade &facade,
                                      const std::vector<PhantomNode> &phantom_node_list,
                                      const std::vector<NodeID> &trip) const;
 
   public:
-    explicit TripPlugin(const int max_locations_trip_)
-        : shortest_path(heaps), duration_table(heaps), max_locations_trip(max_locations_trip_)
+    explicit TripPlugin(const int max_locations_trip_, const int trip_improvement_time_ = 0)
+        : shortest_path(heaps), duration_table(heaps), max_locations_trip(max_locations_trip_),
+          trip_improvement_time(trip_improvement_time_)
     {
     }
 
@@ -7,6 +7,8 @@
 
 #include "engine/routing_algorithms/alternative_path.hpp"
 #include "engine/routing_algorithms/direct_shortest_path.hpp"
+#include "engine/routing_algorithms/facade_dispatch.hpp"
+#include "engine/routing_algorithms/multi_level_routing.hpp"
 #include "engine/routing_algorithms/shortest_path.hpp"
 #include "engine/search_engine_data.hpp"
 #include "util/json_container.hpp"
@@ -29,18 +31,32 @@ class ViaRoutePlugin final : public BasePlugin
 {
   private:
     mutable SearchEngineData heaps;
-    mutable routing_algorithms::ShortestPathRouting<datafacade::BaseDataFacade> shortest_path;
-    mutable routing_algorithms::AlternativeRouting<datafacade::BaseDataFacade> alternative_path;
-    mutable routing_algorithms::DirectShortestPathRouting<datafacade::BaseDataFacade>
+    mutable routing_algorithms::FacadeDispatch<routing_algorithms::ShortestPathRouting>
+        shortest_path;
+    mutable routing_algorithms::FacadeDispatch<routing_algorithms::AlternativeRouting>
+        alternative_path;
+    mutable routing_algorithms::FacadeDispatch<routing_algorithms::DirectShortestPathRouting>
         direct_shortest_path;
+    mutable routing_algorithms::FacadeDispatch<routing_algorithms::MultiLevelRouting>
+        multi_level_path;
     const int max_locations_viaroute;
 
   public:
-    explicit ViaRoutePlugin(int max_locations_viaroute);
+    explicit ViaRoutePlugin(int max_locations_viaroute, int parallel_search_distance = 0);
 
     Status HandleRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
                          const api::RouteParameters &route_parameters,
                          util::json::Object &json_result) const;
+
+    Status HandleRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
+                         const api::RouteParameters &route_parameters,
+                         std::string &pbf_result) const;
+
+  private:
+    template <typename ResultT>
+    Status HandleRouteRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
+                              const api::RouteParameters &route_parameters,
+                              ResultT &result) const;
 };
 }
 }
@@ -0,0 +1,124 @@
+#ifndef OSRM_ENGINE_QUERY_DEADLINE_HPP
+#define OSRM_ENGINE_QUERY_DEADLINE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <utility>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Thrown out of the searches of a query that ran past its deadline or was cancelled. The engine
+// turns it into an error response with the code "Timeout" or "Cancelled".
+class QueryCancelled final : public std::exception
+{
+  public:
+    explicit QueryCancelled(const bool timed_out) : timed_out(timed_out) {}
+
+    bool TimedOut() const { return timed_out; }
+    const char *Code() const { return timed_out ? "Timeout" : "Cancelled"; }
+    const char *what() const noexcept override
+    {
+        return timed_out ? "The query did not finish before its deadline"
+                         : "The query was cancelled";
+    }
+
+  private:
+    bool timed_out;
+};
+
+// When the query on a thread has to stop: a point in time and a flag another thread might set,
+// e.g. once the client is gone. The loops of the searches call Check, which only looks at the
+// clock and the flag every CHECK_INTERVAL calls and throws QueryCancelled once the query has to
+// stop. Without a deadline Check does nothing.
+class QueryDeadline
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr unsigned CHECK_INTERVAL = 64;
+
+    QueryDeadline() = default;
+    QueryDeadline(const Clock::time_point deadline,
+                  std::shared_ptr<const std::atomic<bool>> cancelled)
+        : deadline(deadline), cancelled(std::move(cancelled)),
+          active(deadline != Clock::time_point::max() || this->cancelled)
+    {
+    }
+    QueryDeadline(const QueryDeadline &other)
+        : deadline(other.deadline), cancelled(other.cancelled), active(other.active)
+    {
+    }
+    QueryDeadline &operator=(const QueryDeadline &other)
+    {
+        deadline = other.deadline;
+        cancelled = other.cancelled;
+        active = other.active;
+        calls = 0;
+        return *this;
+    }
+
+    bool IsActive() const { return active; }
+
+    void Check()
+    {
+        if (active && ++calls % CHECK_INTERVAL == 0)
+        {
+            CheckNow();
+        }
+    }
+
+    void CheckNow() const
+    {
+        if (!active)
+        {
+            return;
+        }
+        if (cancelled && cancelled->load(std::memory_order_relaxed))
+        {
+            throw QueryCancelled(false);
+        }
+        if (Clock::now() >= deadline)
+        {
+            throw QueryCancelled(true);
+        }
+    }
+
+  private:
+    Clock::time_point deadline = Clock::time_point::max();
+    std::shared_ptr<const std::atomic<bool>> cancelled;
+    bool active = false;
+    unsigned calls = 0;
+};
+
+// The deadline of the query on the calling thread
+inline QueryDeadline &GetQueryDeadline()
+{
+    static thread_local QueryDeadline deadline;
+    return deadline;
+}
+
+// Sets the deadline of the calling thread for the lifetime of the scope, e.g. for the query a
+// server runs on it or in the tasks of a parallel loop of a query
+class QueryDeadlineScope
+{
+  public:
+    explicit QueryDeadlineScope(const QueryDeadline &deadline) : previous(GetQueryDeadline())
+    {
+        GetQueryDeadline() = deadline;
+    }
+    QueryDeadlineScope(const QueryDeadlineScope &) = delete;
+    QueryDeadlineScope &operator=(const QueryDeadlineScope &) = delete;
+
+    ~QueryDeadlineScope() { GetQueryDeadline() = previous; }
+
+  private:
+    QueryDeadline previous;
+};
+}
+}
+
+#endif // OSRM_ENGINE_QUERY_DEADLINE_HPP
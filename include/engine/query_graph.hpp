@@ -0,0 +1,238 @@
+#ifndef OSRM_ENGINE_QUERY_GRAPH_HPP
+#define OSRM_ENGINE_QUERY_GRAPH_HPP
+
+#include "contractor/query_edge.hpp"
+#include "util/integer_range.hpp"
+#include "util/shared_memory_vector_wrapper.hpp"
+#include "util/static_graph.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+// The part of an edge of the hierarchy that every relaxation reads
+struct HotEdgeData
+{
+    NodeID target;
+    EdgeWeight weight : 30;
+    bool forward : 1;
+    bool backward : 1;
+};
+
+// The part that only path unpacking and distance tables read
+struct ColdEdgeData
+{
+    NodeID id : 31;
+    bool shortcut : 1;
+    EdgeDistance distance;
+};
+
+// The edges of a node are ordered by the directions they can be relaxed in: first the edges
+// with only the forward flag, then the edges with both flags and last the edges with only the
+// backward flag. The forward search scans [first_edge, first_backward_only_edge) and the backward
+// search [first_both_edge, first_edge of the next node).
+struct QueryNodeEntry
+{
+    EdgeID first_edge;
+    EdgeID first_both_edge;
+    EdgeID first_backward_only_edge;
+};
+
+// Search graph of the hierarchy with the edges stored as two arrays. The hot entries are half
+// the size of whole edges, so that twice as many of them share a cache line when searches scan
+// the edges of a node. The .hsgr file stores whole edges, they are split with SplitEdge.
+template <bool UseSharedMemory> class QueryGraph
+{
+  public:
+    using EdgeData = contractor::QueryEdge::EdgeData;
+    using FileGraph = util::StaticGraph<EdgeData>;
+    using FileNodeEntry = FileGraph::NodeArrayEntry;
+    using NodeArrayEntry = QueryNodeEntry;
+    using FileEdgeEntry = FileGraph::EdgeArrayEntry;
+    using EdgeRange = util::range<EdgeID>;
+
+    static void SplitEdge(const FileEdgeEntry &edge, HotEdgeData &hot, ColdEdgeData &cold)
+    {
+        hot.target = edge.target;
+        hot.weight = edge.data.weight;
+        hot.forward = edge.data.forward;
+        hot.backward = edge.data.backward;
+        cold.id = edge.data.id;
+        cold.shortcut = edge.data.shortcut;
+        cold.distance = edge.data.distance;
+    }
+
+    using EdgeBuffer = std::vector<std::pair<HotEdgeData, ColdEdgeData>>;
+
+    // Orders the edges [begin, end) of a node by their directions and sets the ranges of the
+    // node. The order of the edges with the same directions is kept, the buffer is reused
+    // between the nodes.
+    static void PartitionEdges(const EdgeID begin,
+                               const EdgeID end,
+                               HotEdgeData *hot_edges,
+                               ColdEdgeData *cold_edges,
+                               NodeArrayEntry &node,
+                               EdgeBuffer &edges)
+    {
+        const auto rank = [](const HotEdgeData &hot) {
+            return hot.backward ? (hot.forward ? 1 : 2) : 0;
+        };
+
+        edges.clear();
+        for (auto edge = begin; edge < end; ++edge)
+        {
+            edges.emplace_back(hot_edges[edge], cold_edges[edge]);
+        }
+        std::stable_sort(edges.begin(), edges.end(), [&](const auto &lhs, const auto &rhs) {
+            return rank(lhs.first) < rank(rhs.first);
+        });
+
+        node.first_edge = begin;
+        node.first_both_edge = end;
+        node.first_backward_only_edge = end;
+        for (auto edge = begin; edge < end; ++edge)
+        {
+            const auto &entry = edges[edge - begin];
+            hot_edges[edge] = entry.first;
+            cold_edges[edge] = entry.second;
+
+            const auto edge_rank = rank(entry.first);
+            if (edge_rank >= 1 && node.first_both_edge == end)
+                node.first_both_edge = edge;
+            if (edge_rank == 2 && node.first_backward_only_edge == end)
+                node.first_backward_only_edge = edge;
+        }
+    }
+
+    QueryGraph(typename util::ShM<NodeArrayEntry, UseSharedMemory>::vector &nodes,
+               typename util::ShM<HotEdgeData, UseSharedMemory>::vector &hot_edges,
+               typename util::ShM<ColdEdgeData, UseSharedMemory>::vector &cold_edges)
+    {
+        BOOST_ASSERT(hot_edges.size() == cold_edges.size());
+        number_of_nodes = static_cast<NodeID>(nodes.size() - 1);
+        number_of_edges = static_cast<EdgeID>(hot_edges.size());
+
+        using std::swap;
+        swap(node_array, nodes);
+        swap(hot_edge_array, hot_edges);
+        swap(cold_edge_array, cold_edges);
+    }
+
+    unsigned GetNumberOfNodes() const { return number_of_nodes; }
+
+    unsigned GetNumberOfEdges() const { return number_of_edges; }
+
+    unsigned GetOutDegree(const NodeID n) const { return EndEdges(n) - BeginEdges(n); }
+
+    NodeID GetTarget(const EdgeID e) const { return hot_edge_array[e].target; }
+
+    const HotEdgeData &GetHotEdgeData(const EdgeID e) const { return hot_edge_array[e]; }
+
+    // Both parts of an edge
+    EdgeData GetEdgeData(const EdgeID e) const
+    {
+        const auto &hot = hot_edge_array[e];
+        const auto &cold = cold_edge_array[e];
+        EdgeData data;
+        data.id = cold.id;
+        data.shortcut = cold.shortcut;
+        data.weight = hot.weight;
+        data.forward = hot.forward;
+        data.backward = hot.backward;
+        data.distance = cold.distance;
+        return data;
+    }
+
+    EdgeID BeginEdges(const NodeID n) const { return node_array.at(n).first_edge; }
+
+    EdgeID EndEdges(const NodeID n) const { return node_array.at(n + 1).first_edge; }
+
+    EdgeRange GetAdjacentEdgeRange(const NodeID node) const
+    {
+        return util::irange(BeginEdges(node), EndEdges(node));
+    }
+
+    // Edges of the node with the forward flag
+    EdgeRange GetForwardEdgeRange(const NodeID node) const
+    {
+        return util::irange(BeginEdges(node), node_array[node].first_backward_only_edge);
+    }
+
+    // Edges of the node with the backward flag
+    EdgeRange GetBackwardEdgeRange(const NodeID node) const
+    {
+        return util::irange(node_array[node].first_both_edge, EndEdges(node));
+    }
+
+    EdgeID FindEdge(const NodeID from, const NodeID to) const
+    {
+        for (const auto edge : GetAdjacentEdgeRange(from))
+        {
+            if (to == hot_edge_array[edge].target)
+            {
+                return edge;
+            }
+        }
+        return SPECIAL_EDGEID;
+    }
+
+    // Edge with the smallest weight from `from` to `to` whose data passes the filter, or
+    // SPECIAL_EDGEID if there is none
+    template <typename FilterFunction>
+    EdgeID FindSmallestEdge(const NodeID from, const NodeID to, FilterFunction &&filter) const
+    {
+        EdgeID smallest_edge = SPECIAL_EDGEID;
+        EdgeWeight smallest_weight = INVALID_EDGE_WEIGHT;
+        for (const auto edge : GetAdjacentEdgeRange(from))
+        {
+            const auto &hot = hot_edge_array[edge];
+            if (hot.target == to && hot.weight < smallest_weight &&
+                std::forward<FilterFunction>(filter)(GetEdgeData(edge)))
+            {
+                smallest_edge = edge;
+                smallest_weight = hot.weight;
+            }
+        }
+        return smallest_edge;
+    }
+
+    EdgeID FindEdgeInEitherDirection(const NodeID from, const NodeID to) const
+    {
+        const EdgeID edge = FindEdge(from, to);
+        return SPECIAL_EDGEID != edge ? edge : FindEdge(to, from);
+    }
+
+    EdgeID FindEdgeIndicateIfReverse(const NodeID from, const NodeID to, bool &result) const
+    {
+        EdgeID edge = FindEdge(from, to);
+        if (SPECIAL_EDGEID == edge)
+        {
+            edge = FindEdge(to, from);
+            if (SPECIAL_EDGEID != edge)
+            {
+                result = true;
+            }
+        }
+        return edge;
+    }
+
+  private:
+    NodeID number_of_nodes;
+    EdgeID number_of_edges;
+
+    typename util::ShM<NodeArrayEntry, UseSharedMemory>::vector node_array;
+    typename util::ShM<HotEdgeData, UseSharedMemory>::vector hot_edge_array;
+    typename util::ShM<ColdEdgeData, UseSharedMemory>::vector cold_edge_array;
+};
+}
+}
+
+#endif // OSRM_ENGINE_QUERY_GRAPH_HPP
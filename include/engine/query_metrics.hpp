@@ -0,0 +1,128 @@
+#ifndef ENGINE_QUERY_METRICS_HPP
+#define ENGINE_QUERY_METRICS_HPP
+
+#include "util/latency_histogram.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+enum class QueryType
+{
+    Route,
+    Table,
+    Nearest,
+    Trip,
+    Match,
+    Tile,
+    Isochrone
+};
+
+enum class QueryPhase
+{
+    Total,
+    PhantomLookup,
+    Search,
+    Assembly,
+    Serialization
+};
+
+// Latency histograms of all query phases, every thread records into histograms of its own
+// so recording neither locks nor contends. Collecting sums up the histograms of all threads,
+// including the ones of threads that already finished.
+class QueryMetrics
+{
+  public:
+    static constexpr std::size_t NUM_QUERY_TYPES = 7;
+    static constexpr std::size_t NUM_QUERY_PHASES = 5;
+
+    static QueryMetrics &GetInstance();
+
+    QueryMetrics(const QueryMetrics &) = delete;
+    QueryMetrics &operator=(const QueryMetrics &) = delete;
+
+    void Record(const QueryType type, const QueryPhase phase, const std::uint64_t microseconds);
+
+    template <typename Duration>
+    void Record(const QueryType type, const QueryPhase phase, const Duration duration)
+    {
+        Record(type,
+               phase,
+               static_cast<std::uint64_t>(
+                   std::chrono::duration_cast<std::chrono::microseconds>(duration).count()));
+    }
+
+    util::LatencySummary Collect(const QueryType type, const QueryPhase phase) const;
+
+    // Counts the lookups of the route response cache of all datasets
+    void RecordRouteCacheLookup(const bool hit)
+    {
+        (hit ? route_cache_hits : route_cache_misses).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t GetRouteCacheHits() const
+    {
+        return route_cache_hits.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t GetRouteCacheMisses() const
+    {
+        return route_cache_misses.load(std::memory_order_relaxed);
+    }
+
+    static const char *ToString(const QueryType type);
+    static const char *ToString(const QueryPhase phase);
+    // Returns false for services without a query type
+    static bool FromString(const std::string &service, QueryType &type);
+
+  private:
+    using ThreadHistograms =
+        std::array<std::array<util::LatencyHistogram, NUM_QUERY_PHASES>, NUM_QUERY_TYPES>;
+
+    QueryMetrics() = default;
+
+    ThreadHistograms &LocalHistograms();
+
+    mutable std::mutex threads_mutex;
+    std::vector<std::unique_ptr<ThreadHistograms>> threads;
+
+    std::atomic<std::uint64_t> route_cache_hits{0};
+    std::atomic<std::uint64_t> route_cache_misses{0};
+};
+
+// The phases of the query the calling thread ran last, every recorded phase also counts into
+// it. The engine resets it when a query starts, the slow query log of osrm-routed breaks its
+// requests down with it. Unpacking the paths is part of the search phase.
+struct QueryProfile
+{
+    std::array<std::uint64_t, QueryMetrics::NUM_QUERY_PHASES> microseconds = {};
+    std::chrono::steady_clock::duration unpacking = std::chrono::steady_clock::duration::zero();
+
+    void Reset() { *this = QueryProfile(); }
+
+    std::uint64_t operator[](const QueryPhase phase) const
+    {
+        return microseconds[static_cast<std::size_t>(phase)];
+    }
+};
+
+inline QueryProfile &GetQueryProfile()
+{
+    static thread_local QueryProfile profile;
+    return profile;
+}
+}
+}
+
+#endif // ENGINE_QUERY_METRICS_HPP
@@ -0,0 +1,84 @@
+#ifndef OSRM_ENGINE_ROUTE_CACHE_HPP
+#define OSRM_ENGINE_ROUTE_CACHE_HPP
+
+#include "engine/api/route_parameters.hpp"
+#include "util/json_container.hpp"
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Responses of recently requested routes, shared by all queries on a dataset. Clients that retry
+// or poll the same route get the response of the first request. Like the tile cache it lives with
+// the dataset, so a new dataset starts with an empty cache.
+//
+// Routes are keyed by all of their parameters. The cache holds responses up to a memory budget
+// and evicts them in least recently used order, responses that would take more than a small part
+// of the budget are not cached so that a few long routes do not evict all others.
+class RouteCache
+{
+  public:
+    // responses larger than this part of the budget are not admitted
+    static const constexpr std::size_t MAX_RESPONSE_FRACTION = 64;
+
+    explicit RouteCache(const std::size_t memory_budget);
+
+    RouteCache(const RouteCache &) = delete;
+    RouteCache &operator=(const RouteCache &) = delete;
+
+    // the parameters that determine the response in a canonical binary form
+    static std::string MakeKey(const api::RouteParameters &parameters);
+
+    // copies the cached response into the result, false if it is not cached
+    bool Find(const std::string &key, util::json::Object &result);
+    bool Find(const std::string &key, std::string &result);
+
+    // caches the response unless it is too large
+    void Insert(const std::string &key, const util::json::Object &result);
+    void Insert(const std::string &key, const std::string &result);
+
+    std::size_t GetMemoryUsage() const;
+    std::size_t GetNumberOfEntries() const;
+
+  private:
+    // only one of them is set, depending on the output format of the key
+    struct Response
+    {
+        util::json::Object json;
+        std::string pbf;
+    };
+
+    struct Entry
+    {
+        std::string key;
+        std::shared_ptr<const Response> response;
+        // estimated memory of the key and the response
+        std::size_t size;
+    };
+
+    using Entries = std::list<Entry>;
+
+    std::shared_ptr<const Response> FindResponse(const std::string &key);
+    void InsertResponse(const std::string &key,
+                        std::shared_ptr<const Response> response,
+                        const std::size_t response_size);
+
+    const std::size_t memory_budget;
+    mutable std::mutex mutex;
+    std::size_t memory_usage = 0;
+    // most recently used response first
+    Entries entries;
+    std::unordered_map<std::string, Entries::iterator> positions;
+};
+}
+}
+
+#endif // OSRM_ENGINE_ROUTE_CACHE_HPP
@@ -1,6 +1,7 @@
 #ifndef ALTERNATIVE_PATH_ROUTING_HPP
 #define ALTERNATIVE_PATH_ROUTING_HPP
 
+#include "engine/query_deadline.hpp"
 #include "engine/routing_algorithms/routing_base.hpp"
 #include "engine/search_engine_data.hpp"
 #include "util/integer_range.hpp"
@@ -9,6 +10,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <stack>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -24,6 +26,8 @@ namespace routing_algorithms
 const double VIAPATH_ALPHA = 0.10;
 const double VIAPATH_EPSILON = 0.15; // alternative at most 15% longer
 const double VIAPATH_GAMMA = 0.75;   // alternative shares at most 75% with the shortest.
+// via nodes with the best approximated length and sharing that are inspected in detail
+const std::size_t VIAPATH_MAX_CANDIDATES = 20;
 
 template <class DataFacadeT>
 class AlternativeRouting final
@@ -44,6 +48,9 @@ class AlternativeRouting final
         NodeID node;
         int length;
         int sharing;
+        // packed paths <s,..,v> and <v,..,t>, only set once the via path has been computed
+        std::vector<NodeID> packed_s_v_path;
+        std::vector<NodeID> packed_v_t_path;
 
         bool operator<(const RankedCandidateNode &other) const
         {
@@ -76,8 +83,6 @@ class AlternativeRouting final
 
         QueryHeap &forward_heap1 = *(engine_working_data.forward_heap_1);
         QueryHeap &reverse_heap1 = *(engine_working_data.reverse_heap_1);
-        QueryHeap &forward_heap2 = *(engine_working_data.forward_heap_2);
-        QueryHeap &reverse_heap2 = *(engine_working_data.reverse_heap_2);
 
         int upper_bound_to_shortest_path_weight = INVALID_EDGE_WEIGHT;
         NodeID middle_node = SPECIAL_NODEID;
@@ -124,8 +129,10 @@ class AlternativeRouting final
         }
 
         // search from s and t till new_min/(1+epsilon) > length_of_shortest_path
+        auto &deadline = GetQueryDeadline();
         while (0 < (forward_heap1.Size() + reverse_heap1.Size()))
         {
+            deadline.Check();
             if (0 < forward_heap1.Size())
             {
                 AlternativeRoutingStep<true>(facade,
@@ -242,7 +249,7 @@ class AlternativeRouting final
         // reverse_search_space.size() << ", marked " << approximated_reverse_sharing.size() << "
         // nodes";
 
-        std::vector<NodeID> preselected_node_list;
+        std::vector<RankedCandidateNode> preselected_candidates;
         for (const NodeID node : via_node_candidate_list)
         {
             if (node == middle_node)
@@ -267,10 +274,20 @@ class AlternativeRouting final
 
             if (length_passes && sharing_passes && stretch_passes)
             {
-                preselected_node_list.emplace_back(node);
+                preselected_candidates.emplace_back(node, approximated_length, approximated_sharing);
             }
         }
 
+        // only the most promising candidates are worth the searches for their via paths
+        if (preselected_candidates.size() > VIAPATH_MAX_CANDIDATES)
+        {
+            std::partial_sort(preselected_candidates.begin(),
+                              preselected_candidates.begin() + VIAPATH_MAX_CANDIDATES,
+                              preselected_candidates.end());
+            preselected_candidates.erase(preselected_candidates.begin() + VIAPATH_MAX_CANDIDATES,
+                                         preselected_candidates.end());
+        }
+
         std::vector<NodeID> &packed_shortest_path = packed_forward_path;
         if (!path_is_a_loop)
         {
@@ -282,44 +299,27 @@ class AlternativeRouting final
         std::vector<RankedCandidateNode> ranked_candidates_list;
 
         // prioritizing via nodes for deep inspection
-        for (const NodeID node : preselected_node_list)
-        {
-            int length_of_via_path = 0, sharing_of_via_path = 0;
-            ComputeLengthAndSharingOfViaPath(facade,
-                                             node,
-                                             &length_of_via_path,
-                                             &sharing_of_via_path,
-                                             packed_shortest_path,
-                                             min_edge_offset);
-            const int maximum_allowed_sharing =
-                static_cast<int>(upper_bound_to_shortest_path_weight * VIAPATH_GAMMA);
-            if (sharing_of_via_path <= maximum_allowed_sharing &&
-                length_of_via_path <= upper_bound_to_shortest_path_weight * (1 + VIAPATH_EPSILON))
+        for (auto &candidate : preselected_candidates)
+        {
+            if (ComputeViaPath(facade,
+                               packed_shortest_path,
+                               upper_bound_to_shortest_path_weight,
+                               min_edge_offset,
+                               candidate))
             {
-                ranked_candidates_list.emplace_back(node, length_of_via_path, sharing_of_via_path);
+                ranked_candidates_list.push_back(std::move(candidate));
             }
         }
         std::sort(ranked_candidates_list.begin(), ranked_candidates_list.end());
 
-        NodeID selected_via_node = SPECIAL_NODEID;
-        int length_of_via_path = INVALID_EDGE_WEIGHT;
-        NodeID s_v_middle = SPECIAL_NODEID, v_t_middle = SPECIAL_NODEID;
+        const RankedCandidateNode *selected_candidate = nullptr;
         for (const RankedCandidateNode &candidate : ranked_candidates_list)
         {
-            if (ViaNodeCandidatePassesTTest(facade,
-                                            forward_heap1,
-                                            reverse_heap1,
-                                            forward_heap2,
-                                            reverse_heap2,
-                                            candidate,
-                                            upper_bound_to_shortest_path_weight,
-                                            &length_of_via_path,
-                                            &s_v_middle,
-                                            &v_t_middle,
-                                            min_edge_offset))
+            if (ViaNodeCandidatePassesTTest(
+                    facade, candidate, upper_bound_to_shortest_path_weight, min_edge_offset))
             {
                 // select first admissable
-                selected_via_node = candidate.node;
+                selected_candidate = &candidate;
                 break;
             }
         }
@@ -347,17 +347,14 @@ class AlternativeRouting final
             raw_route_data.shortest_path_length = upper_bound_to_shortest_path_weight;
         }
 
-        if (SPECIAL_NODEID != selected_via_node)
+        if (selected_candidate != nullptr)
         {
-            std::vector<NodeID> packed_alternate_path;
-            // retrieve alternate path
-            RetrievePackedAlternatePath(forward_heap1,
-                                        reverse_heap1,
-                                        forward_heap2,
-                                        reverse_heap2,
-                                        s_v_middle,
-                                        v_t_middle,
-                                        packed_alternate_path);
+            // the via node is the last node of <s,..,v> and the first one of <v,..,t>
+            std::vector<NodeID> packed_alternate_path(selected_candidate->packed_s_v_path);
+            packed_alternate_path.pop_back();
+            packed_alternate_path.insert(packed_alternate_path.end(),
+                                         selected_candidate->packed_v_t_path.begin(),
+                                         selected_candidate->packed_v_t_path.end());
 
             raw_route_data.alt_source_traversed_in_reverse.push_back(
                 (packed_alternate_path.front() !=
@@ -373,7 +370,7 @@ class AlternativeRouting final
                               phantom_node_pair,
                               raw_route_data.unpacked_alternative);
 
-            raw_route_data.alternative_path_length = length_of_via_path;
+            raw_route_data.alternative_path_length = selected_candidate->length;
         }
         else
         {
@@ -382,38 +379,21 @@ class AlternativeRouting final
     }
 
   private:
-    // unpack alternate <s,..,v,..,t> by exploring search spaces from v
-    void RetrievePackedAlternatePath(const QueryHeap &forward_heap1,
-                                     const QueryHeap &reverse_heap1,
-                                     const QueryHeap &forward_heap2,
-                                     const QueryHeap &reverse_heap2,
-                                     const NodeID s_v_middle,
-                                     const NodeID v_t_middle,
-                                     std::vector<NodeID> &packed_path) const
+    // compute <s,..,v> and <v,..,t> with their length and sharing by exploring search spaces
+    // from v and intersecting against queues. only half-searches have to be done at this stage.
+    // returns false as soon as the via path is too long or shares too much with the shortest path
+    bool ComputeViaPath(const DataFacadeT &facade,
+                        const std::vector<NodeID> &packed_shortest_path,
+                        const int length_of_shortest_path,
+                        const EdgeWeight min_edge_offset,
+                        RankedCandidateNode &candidate)
     {
-        // fetch packed path [s,v)
-        std::vector<NodeID> packed_v_t_path;
-        super::RetrievePackedPathFromHeap(forward_heap1, reverse_heap2, s_v_middle, packed_path);
-        packed_path.pop_back(); // remove middle node. It's in both half-paths
-
-        // fetch patched path [v,t]
-        super::RetrievePackedPathFromHeap(
-            forward_heap2, reverse_heap1, v_t_middle, packed_v_t_path);
-
-        packed_path.insert(packed_path.end(), packed_v_t_path.begin(), packed_v_t_path.end());
-    }
+        const NodeID via_node = candidate.node;
+        const int maximum_allowed_length =
+            static_cast<int>(length_of_shortest_path * (1 + VIAPATH_EPSILON));
+        const int maximum_allowed_sharing =
+            static_cast<int>(length_of_shortest_path * VIAPATH_GAMMA);
 
-    // TODO: reorder parameters
-    // compute and unpack <s,..,v> and <v,..,t> by exploring search spaces
-    // from v and intersecting against queues. only half-searches have to be
-    // done at this stage
-    void ComputeLengthAndSharingOfViaPath(const DataFacadeT &facade,
-                                          const NodeID via_node,
-                                          int *real_length_of_via_path,
-                                          int *sharing_of_via_path,
-                                          const std::vector<NodeID> &packed_shortest_path,
-                                          const EdgeWeight min_edge_offset)
-    {
         engine_working_data.InitializeOrClearSecondThreadLocalStorage(facade.GetNumberOfNodes());
 
         QueryHeap &existing_forward_heap = *engine_working_data.forward_heap_1;
@@ -421,8 +401,11 @@ class AlternativeRouting final
         QueryHeap &new_forward_heap = *engine_working_data.forward_heap_2;
         QueryHeap &new_reverse_heap = *engine_working_data.reverse_heap_2;
 
-        std::vector<NodeID> packed_s_v_path;
-        std::vector<NodeID> packed_v_t_path;
+        std::vector<NodeID> &packed_s_v_path = candidate.packed_s_v_path;
+        std::vector<NodeID> &packed_v_t_path = candidate.packed_v_t_path;
+        packed_s_v_path.clear();
+        packed_v_t_path.clear();
+        int sharing_of_via_path = 0;
 
         std::vector<NodeID> partially_unpacked_shortest_path;
         std::vector<NodeID> partially_unpacked_via_path;
@@ -433,8 +416,10 @@ class AlternativeRouting final
         // compute path <s,..,v> by reusing forward search from s
         const bool constexpr STALLING_ENABLED = true;
         const bool constexpr DO_NOT_FORCE_LOOPS = false;
+        auto &deadline = GetQueryDeadline();
         while (!new_reverse_heap.Empty())
         {
+            deadline.Check();
             super::RoutingStep(facade,
                                new_reverse_heap,
                                existing_forward_heap,
@@ -446,12 +431,19 @@ class AlternativeRouting final
                                DO_NOT_FORCE_LOOPS,
                                DO_NOT_FORCE_LOOPS);
         }
+        // the path <v,..,t> can only add to the length
+        if (SPECIAL_NODEID == s_v_middle || upper_bound_s_v_path_length > maximum_allowed_length)
+        {
+            return false;
+        }
+
         // compute path <v,..,t> by reusing backward search from node t
         NodeID v_t_middle = SPECIAL_NODEID;
         int upper_bound_of_v_t_path_length = INVALID_EDGE_WEIGHT;
         new_forward_heap.Insert(via_node, 0, via_node);
         while (!new_forward_heap.Empty())
         {
+            deadline.Check();
             super::RoutingStep(facade,
                                new_forward_heap,
                                existing_reverse_heap,
@@ -463,11 +455,14 @@ class AlternativeRouting final
                                DO_NOT_FORCE_LOOPS,
                                DO_NOT_FORCE_LOOPS);
         }
-        *real_length_of_via_path = upper_bound_s_v_path_length + upper_bound_of_v_t_path_length;
-
-        if (SPECIAL_NODEID == s_v_middle || SPECIAL_NODEID == v_t_middle)
+        if (SPECIAL_NODEID == v_t_middle)
         {
-            return;
+            return false;
+        }
+        candidate.length = upper_bound_s_v_path_length + upper_bound_of_v_t_path_length;
+        if (candidate.length > maximum_allowed_length)
+        {
+            return false;
         }
 
         // retrieve packed paths
@@ -487,7 +482,7 @@ class AlternativeRouting final
             {
                 EdgeID edgeID = facade.FindEdgeInEitherDirection(packed_s_v_path[current_node],
                                                                  packed_s_v_path[current_node + 1]);
-                *sharing_of_via_path += facade.GetEdgeData(edgeID).weight;
+                sharing_of_via_path += facade.GetHotEdgeData(edgeID).weight;
             }
             else
             {
@@ -520,7 +515,7 @@ class AlternativeRouting final
             EdgeID selected_edge =
                 facade.FindEdgeInEitherDirection(partially_unpacked_via_path[current_node],
                                                  partially_unpacked_via_path[current_node + 1]);
-            *sharing_of_via_path += facade.GetEdgeData(selected_edge).weight;
+            sharing_of_via_path += facade.GetHotEdgeData(selected_edge).weight;
         }
 
         // Second, partially unpack v-->t in reverse order until paths deviate and note lengths
@@ -535,7 +530,7 @@ class AlternativeRouting final
             {
                 EdgeID edgeID = facade.FindEdgeInEitherDirection(
                     packed_v_t_path[via_path_index - 1], packed_v_t_path[via_path_index]);
-                *sharing_of_via_path += facade.GetEdgeData(edgeID).weight;
+                sharing_of_via_path += facade.GetHotEdgeData(edgeID).weight;
             }
             else
             {
@@ -567,15 +562,16 @@ class AlternativeRouting final
                 EdgeID edgeID = facade.FindEdgeInEitherDirection(
                     partially_unpacked_via_path[via_path_index - 1],
                     partially_unpacked_via_path[via_path_index]);
-                *sharing_of_via_path += facade.GetEdgeData(edgeID).weight;
+                sharing_of_via_path += facade.GetHotEdgeData(edgeID).weight;
             }
             else
             {
                 break;
             }
         }
-        // finished partial unpacking spree! Amount of sharing is stored to appropriate pointer
-        // variable
+        // finished partial unpacking spree!
+        candidate.sharing = sharing_of_via_path;
+        return sharing_of_via_path <= maximum_allowed_sharing;
     }
 
     // int approximateAmountOfSharing(
@@ -688,14 +684,15 @@ class AlternativeRouting final
             }
         }
 
-        for (auto edge : facade.GetAdjacentEdgeRange(node))
+        for (auto edge : is_forward_directed ? facade.GetForwardEdgeRange(node)
+                                             : facade.GetBackwardEdgeRange(node))
         {
-            const EdgeData &data = facade.GetEdgeData(edge);
+            const auto &data = facade.GetHotEdgeData(edge);
             const bool edge_is_forward_directed =
                 (is_forward_directed ? data.forward : data.backward);
             if (edge_is_forward_directed)
             {
-                const NodeID to = facade.GetTarget(edge);
+                const NodeID to = data.target;
                 const int edge_weight = data.weight;
 
                 BOOST_ASSERT(edge_weight > 0);
@@ -718,91 +715,17 @@ class AlternativeRouting final
         }
     }
 
-    // conduct T-Test
+    // conduct T-Test on the via path of the candidate
     bool ViaNodeCandidatePassesTTest(const DataFacadeT &facade,
-                                     QueryHeap &existing_forward_heap,
-                                     QueryHeap &existing_reverse_heap,
-                                     QueryHeap &new_forward_heap,
-                                     QueryHeap &new_reverse_heap,
                                      const RankedCandidateNode &candidate,
                                      const int length_of_shortest_path,
-                                     int *length_of_via_path,
-                                     NodeID *s_v_middle,
-                                     NodeID *v_t_middle,
                                      const EdgeWeight min_edge_offset) const
     {
-        new_forward_heap.Clear();
-        new_reverse_heap.Clear();
-        std::vector<NodeID> packed_s_v_path;
-        std::vector<NodeID> packed_v_t_path;
-
-        *s_v_middle = SPECIAL_NODEID;
-        int upper_bound_s_v_path_length = INVALID_EDGE_WEIGHT;
-        // compute path <s,..,v> by reusing forward search from s
-        new_reverse_heap.Insert(candidate.node, 0, candidate.node);
-        const bool constexpr STALLING_ENABLED = true;
-        const bool constexpr DO_NOT_FORCE_LOOPS = false;
-        while (new_reverse_heap.Size() > 0)
-        {
-            super::RoutingStep(facade,
-                               new_reverse_heap,
-                               existing_forward_heap,
-                               *s_v_middle,
-                               upper_bound_s_v_path_length,
-                               min_edge_offset,
-                               false,
-                               STALLING_ENABLED,
-                               DO_NOT_FORCE_LOOPS,
-                               DO_NOT_FORCE_LOOPS);
-        }
-
-        if (INVALID_EDGE_WEIGHT == upper_bound_s_v_path_length)
-        {
-            return false;
-        }
-
-        // compute path <v,..,t> by reusing backward search from t
-        *v_t_middle = SPECIAL_NODEID;
-        int upper_bound_of_v_t_path_length = INVALID_EDGE_WEIGHT;
-        new_forward_heap.Insert(candidate.node, 0, candidate.node);
-        while (new_forward_heap.Size() > 0)
-        {
-            super::RoutingStep(facade,
-                               new_forward_heap,
-                               existing_reverse_heap,
-                               *v_t_middle,
-                               upper_bound_of_v_t_path_length,
-                               min_edge_offset,
-                               true,
-                               STALLING_ENABLED,
-                               DO_NOT_FORCE_LOOPS,
-                               DO_NOT_FORCE_LOOPS);
-        }
-
-        if (INVALID_EDGE_WEIGHT == upper_bound_of_v_t_path_length)
-        {
-            return false;
-        }
-
-        *length_of_via_path = upper_bound_s_v_path_length + upper_bound_of_v_t_path_length;
-
-        // retrieve packed paths
-        super::RetrievePackedPathFromHeap(
-            existing_forward_heap, new_reverse_heap, *s_v_middle, packed_s_v_path);
-
-        super::RetrievePackedPathFromHeap(
-            new_forward_heap, existing_reverse_heap, *v_t_middle, packed_v_t_path);
-
-        NodeID s_P = *s_v_middle, t_P = *v_t_middle;
-        if (SPECIAL_NODEID == s_P)
-        {
-            return false;
-        }
+        const std::vector<NodeID> &packed_s_v_path = candidate.packed_s_v_path;
+        const std::vector<NodeID> &packed_v_t_path = candidate.packed_v_t_path;
+        BOOST_ASSERT(!packed_s_v_path.empty() && !packed_v_t_path.empty());
 
-        if (SPECIAL_NODEID == t_P)
-        {
-            return false;
-        }
+        NodeID s_P = packed_s_v_path.front(), t_P = packed_v_t_path.back();
         const int T_threshold = static_cast<int>(VIAPATH_EPSILON * length_of_shortest_path);
         int unpacked_until_weight = 0;
 
@@ -812,7 +735,7 @@ class AlternativeRouting final
         {
             const EdgeID current_edge_id =
                 facade.FindEdgeInEitherDirection(packed_s_v_path[i - 1], packed_s_v_path[i]);
-            const int length_of_current_edge = facade.GetEdgeData(current_edge_id).weight;
+            const int length_of_current_edge = facade.GetHotEdgeData(current_edge_id).weight;
             if ((length_of_current_edge + unpacked_until_weight) >= T_threshold)
             {
                 unpack_stack.emplace(packed_s_v_path[i - 1], packed_s_v_path[i]);
@@ -843,7 +766,8 @@ class AlternativeRouting final
                 const NodeID via_path_middle_node_id = current_edge_data.id;
                 const EdgeID second_segment_edge_id =
                     facade.FindEdgeInEitherDirection(via_path_middle_node_id, via_path_edge.second);
-                const int second_segment_length = facade.GetEdgeData(second_segment_edge_id).weight;
+                const int second_segment_length =
+                    facade.GetHotEdgeData(second_segment_edge_id).weight;
                 // attention: !unpacking in reverse!
                 // Check if second segment is the one to go over treshold? if yes add second segment
                 // to stack, else push first segment to stack and add weight of second one.
@@ -875,7 +799,7 @@ class AlternativeRouting final
         {
             const EdgeID edgeID =
                 facade.FindEdgeInEitherDirection(packed_v_t_path[i], packed_v_t_path[i + 1]);
-            int length_of_current_edge = facade.GetEdgeData(edgeID).weight;
+            int length_of_current_edge = facade.GetHotEdgeData(edgeID).weight;
             if (length_of_current_edge + unpacked_until_weight >= T_threshold)
             {
                 unpack_stack.emplace(packed_v_t_path[i], packed_v_t_path[i + 1]);
@@ -905,7 +829,7 @@ class AlternativeRouting final
                 const NodeID middleOfViaPath = current_edge_data.id;
                 EdgeID edgeIDOfFirstSegment =
                     facade.FindEdgeInEitherDirection(via_path_edge.first, middleOfViaPath);
-                int lengthOfFirstSegment = facade.GetEdgeData(edgeIDOfFirstSegment).weight;
+                int lengthOfFirstSegment = facade.GetHotEdgeData(edgeIDOfFirstSegment).weight;
                 // Check if first segment is the one to go over treshold? if yes first segment to
                 // stack, else push second segment to stack and add weight of first one.
                 if (unpacked_until_weight + lengthOfFirstSegment >= T_threshold)
@@ -932,14 +856,20 @@ class AlternativeRouting final
 
         QueryHeap &forward_heap3 = *engine_working_data.forward_heap_3;
         QueryHeap &reverse_heap3 = *engine_working_data.reverse_heap_3;
-        int upper_bound = INVALID_EDGE_WEIGHT;
+        // only a path that is at most as long as the one on the via path matters, so the search
+        // prunes everything beyond it
+        int upper_bound = t_test_path_length + 1;
         NodeID middle = SPECIAL_NODEID;
+        const bool constexpr STALLING_ENABLED = true;
+        const bool constexpr DO_NOT_FORCE_LOOPS = false;
 
         forward_heap3.Insert(s_P, 0, s_P);
         reverse_heap3.Insert(t_P, 0, t_P);
         // exploration from s and t until deletemin/(1+epsilon) > _lengt_oO_sShortest_path
+        auto &deadline = GetQueryDeadline();
         while ((forward_heap3.Size() + reverse_heap3.Size()) > 0)
         {
+            deadline.Check();
             if (!forward_heap3.Empty())
             {
                 super::RoutingStep(facade,
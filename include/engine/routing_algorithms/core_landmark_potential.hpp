@@ -0,0 +1,116 @@
+#ifndef OSRM_ENGINE_ROUTING_ALGORITHMS_CORE_LANDMARK_POTENTIAL_HPP
+#define OSRM_ENGINE_ROUTING_ALGORITHMS_CORE_LANDMARK_POTENTIAL_HPP
+
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+// Lower bound of the weight from a core node to the closest of a set of core targets, including
+// the weight of the rest of the path that every target comes with. By the triangle inequality a
+// landmark L bounds the weight from node v to target t by d(L, t) - d(L, v) and by
+// d(v, L) - d(t, L). The potential is the largest of these bounds over the landmarks, with the
+// bounds of all targets folded into two per landmark. Each bound is consistent, so an A* search
+// with the potential settles every node with the weight of its shortest path.
+template <typename DataFacadeT> class CoreLandmarkPotential
+{
+  public:
+    // the targets with the weights of the rest of their paths
+    CoreLandmarkPotential(const DataFacadeT &facade,
+                          const std::vector<std::pair<NodeID, EdgeWeight>> &targets)
+        : facade(facade), number_of_landmarks(facade.GetNumberOfCoreLandmarks()),
+          min_target_weight(INVALID_EDGE_WEIGHT),
+          from_landmark_bounds(number_of_landmarks, INVALID_EDGE_WEIGHT),
+          to_landmark_bounds(number_of_landmarks, std::numeric_limits<EdgeWeight>::min())
+    {
+        BOOST_ASSERT(!targets.empty());
+        for (const auto &target : targets)
+        {
+            min_target_weight = std::min(min_target_weight, target.second);
+            const auto weights = facade.GetCoreLandmarkWeights(target.first);
+            if (weights.empty())
+            {
+                // a target outside of the core is not bounded by the landmarks
+                number_of_landmarks = 0;
+                continue;
+            }
+            for (unsigned landmark = 0; landmark < number_of_landmarks; ++landmark)
+            {
+                const auto from_landmark = weights[landmark];
+                if (from_landmark != INVALID_EDGE_WEIGHT)
+                {
+                    from_landmark_bounds[landmark] = std::min(from_landmark_bounds[landmark],
+                                                              from_landmark + target.second);
+                }
+                const auto to_landmark = weights[number_of_landmarks + landmark];
+                if (to_landmark == INVALID_EDGE_WEIGHT)
+                {
+                    // a target that does not reach the landmark leaves no bound
+                    to_landmark_bounds[landmark] = INVALID_EDGE_WEIGHT;
+                }
+                else if (to_landmark_bounds[landmark] != INVALID_EDGE_WEIGHT)
+                {
+                    to_landmark_bounds[landmark] =
+                        std::max(to_landmark_bounds[landmark], to_landmark - target.second);
+                }
+            }
+        }
+    }
+
+    // INVALID_EDGE_WEIGHT if no target can be reached from the node
+    EdgeWeight operator()(const NodeID node) const
+    {
+        EdgeWeight potential = min_target_weight;
+        if (number_of_landmarks == 0)
+        {
+            return potential;
+        }
+        const auto weights = facade.GetCoreLandmarkWeights(node);
+        BOOST_ASSERT(weights.size() == 2 * number_of_landmarks);
+        for (unsigned landmark = 0; landmark < number_of_landmarks; ++landmark)
+        {
+            const auto from_landmark = weights[landmark];
+            if (from_landmark_bounds[landmark] != INVALID_EDGE_WEIGHT &&
+                from_landmark != INVALID_EDGE_WEIGHT)
+            {
+                potential = std::max(potential, from_landmark_bounds[landmark] - from_landmark);
+            }
+            if (to_landmark_bounds[landmark] != INVALID_EDGE_WEIGHT)
+            {
+                const auto to_landmark = weights[number_of_landmarks + landmark];
+                if (to_landmark == INVALID_EDGE_WEIGHT)
+                {
+                    // all targets reach the landmark, the node does not
+                    return INVALID_EDGE_WEIGHT;
+                }
+                potential = std::max(potential, to_landmark - to_landmark_bounds[landmark]);
+            }
+        }
+        return potential;
+    }
+
+  private:
+    const DataFacadeT &facade;
+    unsigned number_of_landmarks;
+    EdgeWeight min_target_weight;
+    // smallest d(L, t) plus the weight of t, INVALID_EDGE_WEIGHT if L reaches no target
+    std::vector<EdgeWeight> from_landmark_bounds;
+    // largest d(t, L) minus the weight of t, INVALID_EDGE_WEIGHT if a target does not reach L
+    std::vector<EdgeWeight> to_landmark_bounds;
+};
+}
+}
+}
+
+#endif // OSRM_ENGINE_ROUTING_ALGORITHMS_CORE_LANDMARK_POTENTIAL_HPP
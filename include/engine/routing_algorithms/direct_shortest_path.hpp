@@ -30,10 +30,14 @@ class DirectShortestPathRouting final
     using super = BasicRoutingInterface<DataFacadeT, DirectShortestPathRouting<DataFacadeT>>;
     using QueryHeap = SearchEngineData::QueryHeap;
     SearchEngineData &engine_working_data;
+    // in meters, routes at least this long search the core on two threads
+    const int parallel_search_distance;
 
   public:
-    DirectShortestPathRouting(SearchEngineData &engine_working_data)
-        : engine_working_data(engine_working_data)
+    DirectShortestPathRouting(SearchEngineData &engine_working_data,
+                              const int parallel_search_distance = 0)
+        : engine_working_data(engine_working_data),
+          parallel_search_distance(parallel_search_distance)
     {
     }
 
@@ -110,7 +114,10 @@ class DirectShortestPathRouting final
                                   weight,
                                   packed_leg,
                                   DO_NOT_FORCE_LOOPS,
-                                  DO_NOT_FORCE_LOOPS);
+                                  DO_NOT_FORCE_LOOPS,
+                                  INVALID_EDGE_WEIGHT,
+                                  super::IsLongSearch(
+                                      source_phantom, target_phantom, parallel_search_distance));
         }
         else
         {
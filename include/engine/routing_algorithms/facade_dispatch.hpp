@@ -0,0 +1,55 @@
+#ifndef OSRM_ENGINE_ROUTING_ALGORITHMS_FACADE_DISPATCH_HPP
+#define OSRM_ENGINE_ROUTING_ALGORITHMS_FACADE_DISPATCH_HPP
+
+#include "engine/datafacade/datafacade_base.hpp"
+#include "engine/datafacade/internal_datafacade.hpp"
+#include "engine/datafacade/shared_datafacade.hpp"
+
+#include "util/exception.hpp"
+
+#include <utility>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+// Holds an instance of a routing algorithm for each concrete facade and dispatches on the type
+// of the facade once per query. The search loops then call the graph accessors of a final class
+// which the compiler inlines, instead of calling through the virtual BaseDataFacade interface
+// for every relaxed edge.
+template <template <typename> class AlgorithmT> class FacadeDispatch
+{
+  public:
+    template <typename... Args>
+    explicit FacadeDispatch(Args &&... args)
+        : internal_algorithm(args...), shared_algorithm(args...)
+    {
+    }
+
+    template <typename... Args>
+    auto operator()(const datafacade::BaseDataFacade &facade, Args &&... args)
+    {
+        if (const auto shared_facade = dynamic_cast<const datafacade::SharedDataFacade *>(&facade))
+        {
+            return shared_algorithm(*shared_facade, std::forward<Args>(args)...);
+        }
+        if (const auto internal_facade =
+                dynamic_cast<const datafacade::InternalDataFacade *>(&facade))
+        {
+            return internal_algorithm(*internal_facade, std::forward<Args>(args)...);
+        }
+        throw util::exception("Routing algorithms only support the internal and shared facades");
+    }
+
+  private:
+    AlgorithmT<datafacade::InternalDataFacade> internal_algorithm;
+    AlgorithmT<datafacade::SharedDataFacade> shared_algorithm;
+};
+}
+}
+}
+
+#endif // OSRM_ENGINE_ROUTING_ALGORITHMS_FACADE_DISPATCH_HPP
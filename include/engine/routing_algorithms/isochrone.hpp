@@ -0,0 +1,208 @@
+#ifndef ISOCHRONE_ROUTING_HPP
+#define ISOCHRONE_ROUTING_HPP
+
+#include "engine/routing_algorithms/routing_base.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+// Weights from a phantom node to a set of target nodes up to a maximum weight (RPHAST). An
+// upward search from the phantom is followed by a downward sweep over the part of the hierarchy
+// above the targets only, instead of a search or a bucket per target.
+template <class DataFacadeT>
+class IsochroneRouting final
+    : public BasicRoutingInterface<DataFacadeT, IsochroneRouting<DataFacadeT>>
+{
+    using super = BasicRoutingInterface<DataFacadeT, IsochroneRouting<DataFacadeT>>;
+    using QueryHeap = SearchEngineData::ManyToManyQueryHeap;
+    SearchEngineData &engine_working_data;
+
+    static constexpr EdgeWeight SWEEP_INFINITY = std::numeric_limits<EdgeWeight>::max() / 2;
+
+  public:
+    IsochroneRouting(SearchEngineData &engine_working_data)
+        : engine_working_data(engine_working_data)
+    {
+    }
+
+    // Returns the weight of every target, weights above max_weight are not exact and
+    // INVALID_EDGE_WEIGHT marks unreachable targets.
+    std::vector<EdgeWeight> operator()(const DataFacadeT &facade,
+                                       const PhantomNode &phantom_node,
+                                       const std::vector<NodeID> &targets,
+                                       const EdgeWeight max_weight) const
+    {
+        const auto number_of_nodes = facade.GetNumberOfNodes();
+        engine_working_data.InitializeOrClearManyToManyThreadLocalStorage(number_of_nodes);
+        QueryHeap &query_heap = *(engine_working_data.many_to_many_heap);
+
+        UpwardSearch(facade, phantom_node, max_weight, query_heap);
+
+        // the higher nodes of the targets in sweep order, every node after its higher nodes
+        std::unordered_map<NodeID, std::uint32_t> local_index;
+        const auto sweep_order = SelectSweepOrder(facade, targets, local_index);
+
+        std::vector<EdgeWeight> weights;
+        weights.reserve(sweep_order.size());
+        for (const auto node : sweep_order)
+        {
+            const auto weight =
+                query_heap.WasInserted(node) ? query_heap.GetKey(node) : SWEEP_INFINITY;
+            if (facade.GetCoreSize() > 0 && facade.IsCoreNode(node))
+            {
+                // the upward search already went through the core in both directions
+                weights.push_back(weight);
+                continue;
+            }
+
+            // the edges from higher nodes down to a node are stored at the node
+            auto node_weight = weight;
+            for (const auto edge : facade.GetBackwardEdgeRange(node))
+            {
+                const auto &data = facade.GetHotEdgeData(edge);
+                const auto higher_node = data.target;
+                if (data.backward && higher_node != node)
+                {
+                    BOOST_ASSERT(local_index.count(higher_node) > 0);
+                    node_weight =
+                        std::min(node_weight, weights[local_index[higher_node]] + data.weight);
+                }
+            }
+            weights.push_back(node_weight);
+        }
+
+        std::vector<EdgeWeight> target_weights;
+        target_weights.reserve(targets.size());
+        for (const auto target : targets)
+        {
+            const auto weight = weights[local_index[target]];
+            target_weights.push_back(weight < SWEEP_INFINITY ? weight : INVALID_EDGE_WEIGHT);
+        }
+        return target_weights;
+    }
+
+  private:
+    // Dijkstra up the hierarchy and through the core, stopped at the first node beyond the
+    // maximum weight. Nodes on a shortest path of at most the maximum weight are settled.
+    void UpwardSearch(const DataFacadeT &facade,
+                      const PhantomNode &phantom_node,
+                      const EdgeWeight max_weight,
+                      QueryHeap &query_heap) const
+    {
+        query_heap.Clear();
+        if (phantom_node.forward_segment_id.enabled)
+        {
+            query_heap.Insert(phantom_node.forward_segment_id.id,
+                              -phantom_node.GetForwardWeightPlusOffset(),
+                              phantom_node.forward_segment_id.id);
+        }
+        if (phantom_node.reverse_segment_id.enabled)
+        {
+            query_heap.Insert(phantom_node.reverse_segment_id.id,
+                              -phantom_node.GetReverseWeightPlusOffset(),
+                              phantom_node.reverse_segment_id.id);
+        }
+
+        const bool has_core = facade.GetCoreSize() > 0;
+        while (!query_heap.Empty() && query_heap.MinKey() <= max_weight)
+        {
+            const NodeID node = query_heap.DeleteMin();
+            const EdgeWeight weight = query_heap.GetKey(node);
+
+            // stalled core nodes would keep their weight, no sweep reaches them
+            if ((has_core && facade.IsCoreNode(node)) ||
+                !super::StallAtNode(facade, query_heap, node, weight, true))
+            {
+                RelaxOutgoingEdges(facade, node, weight, query_heap);
+            }
+        }
+    }
+
+    void RelaxOutgoingEdges(const DataFacadeT &facade,
+                            const NodeID node,
+                            const EdgeWeight weight,
+                            QueryHeap &query_heap) const
+    {
+        for (const auto edge : facade.GetForwardEdgeRange(node))
+        {
+            const auto &data = facade.GetHotEdgeData(edge);
+            if (data.forward)
+            {
+                const NodeID to = data.target;
+                const EdgeWeight to_weight = weight + data.weight;
+
+                if (!query_heap.WasInserted(to))
+                {
+                    query_heap.Insert(to, to_weight, node);
+                }
+                else if (to_weight < query_heap.GetKey(to))
+                {
+                    query_heap.GetData(to) = {node};
+                    query_heap.DecreaseKey(to, to_weight);
+                }
+            }
+        }
+    }
+
+    // Depth first search from the targets over the edges to higher nodes, a node is finished
+    // after all of its higher nodes. Core nodes are not expanded, their weights are final.
+    std::vector<NodeID>
+    SelectSweepOrder(const DataFacadeT &facade,
+                     const std::vector<NodeID> &targets,
+                     std::unordered_map<NodeID, std::uint32_t> &local_index) const
+    {
+        const bool has_core = facade.GetCoreSize() > 0;
+        const std::uint32_t IN_PROGRESS = std::numeric_limits<std::uint32_t>::max();
+
+        std::vector<NodeID> sweep_order;
+        std::vector<std::pair<NodeID, EdgeID>> stack;
+        for (const auto target : targets)
+        {
+            if (!local_index.emplace(target, IN_PROGRESS).second)
+            {
+                continue;
+            }
+
+            stack.emplace_back(target, facade.BeginEdges(target));
+            while (!stack.empty())
+            {
+                const auto node = stack.back().first;
+                auto &edge = stack.back().second;
+                if ((!has_core || !facade.IsCoreNode(node)) && edge != facade.EndEdges(node))
+                {
+                    const auto &data = facade.GetHotEdgeData(edge++);
+                    const auto higher_node = data.target;
+                    if (data.backward && local_index.emplace(higher_node, IN_PROGRESS).second)
+                    {
+                        stack.emplace_back(higher_node, facade.BeginEdges(higher_node));
+                    }
+                    continue;
+                }
+
+                local_index[node] = sweep_order.size();
+                sweep_order.push_back(node);
+                stack.pop_back();
+            }
+        }
+        return sweep_order;
+    }
+};
+}
+}
+}
+
+#endif // ISOCHRONE_ROUTING_HPP
@@ -3,13 +3,30 @@
 
 #include "engine/routing_algorithms/routing_base.hpp"
 #include "engine/search_engine_data.hpp"
+#include "engine/search_space_cache.hpp"
+#include "engine/search_statistics.hpp"
+#include "util/coordinate_calculation.hpp"
+#include "util/integer_range.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/assert.hpp>
+#include <boost/range/iterator_range_core.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+#include <tbb/task_arena.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
 #include <limits>
 #include <memory>
+#include <numeric>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -19,143 +36,1471 @@ namespace engine
 namespace routing_algorithms
 {
 
+// The backward searches of the targets of a table. They do not depend on the sources, so the
+// buckets of a fixed set of targets can be kept and answer the tables of any sources to them on
+// the same facade with the forward searches alone.
+struct TargetBuckets
+{
+    struct NodeBucket
+    {
+        NodeID middle_node;
+        unsigned target_id; // essentially a row in the weight matrix
+        EdgeWeight weight;
+        EdgeDistance distance;
+        NodeBucket(const NodeID middle_node,
+                   const unsigned target_id,
+                   const EdgeWeight weight,
+                   const EdgeDistance distance)
+            : middle_node(middle_node), target_id(target_id), weight(weight), distance(distance)
+        {
+        }
+
+        // partial order by middle node only, buckets of one node form a contiguous range
+        bool operator<(const NodeBucket &rhs) const { return middle_node < rhs.middle_node; }
+
+        struct MiddleNodeCompare
+        {
+            bool operator()(const NodeBucket &lhs, const NodeID rhs) const
+            {
+                return lhs.middle_node < rhs;
+            }
+            bool operator()(const NodeID lhs, const NodeBucket &rhs) const
+            {
+                return lhs < rhs.middle_node;
+            }
+        };
+    };
+
+    // Targets whose backward searches stopped at core nodes, the forward searches continue into
+    // the core only if there are any
+    struct CoreTargets
+    {
+        std::vector<unsigned> columns;
+        // smallest weight of a backward search at a core node
+        EdgeWeight min_weight = std::numeric_limits<EdgeWeight>::max();
+    };
+
+    std::size_t number_of_targets = 0;
+    // All backward search spaces in one contiguous array, sorted by the settled node. The
+    // forward searches look up the buckets of a node with a binary search instead of hashing.
+    std::vector<NodeBucket> search_space_with_buckets;
+    CoreTargets core_targets;
+};
+
 template <class DataFacadeT>
 class ManyToManyRouting final
     : public BasicRoutingInterface<DataFacadeT, ManyToManyRouting<DataFacadeT>>
 {
     using super = BasicRoutingInterface<DataFacadeT, ManyToManyRouting<DataFacadeT>>;
-    using QueryHeap = SearchEngineData::QueryHeap;
+    using QueryHeap = SearchEngineData::ManyToManyQueryHeap;
+    using NodeBucket = TargetBuckets::NodeBucket;
+    using SearchSpaceWithBuckets = std::vector<NodeBucket>;
+    using CoreTargets = TargetBuckets::CoreTargets;
     SearchEngineData &engine_working_data;
 
-    struct NodeBucket
+    struct CoreEntryPoint
+    {
+        NodeID node;
+        EdgeWeight weight;
+        EdgeDistance distance;
+    };
+    using CoreEntryPoints = std::vector<CoreEntryPoint>;
+
+    // distances from the start of the forward and of the reverse segment to a phantom node
+    using PhantomDistances = std::pair<EdgeDistance, EdgeDistance>;
+
+    // rows and columns whose target is before the source on the same segment
+    using SameSegmentPairs = std::vector<std::pair<std::size_t, std::size_t>>;
+
+    // number of sources or targets from which on the searches of a phase run in parallel
+    static constexpr std::size_t PARALLEL_SEARCH_THRESHOLD = 256;
+    static constexpr std::size_t PARALLEL_GRAIN_SIZE = 16;
+    // number of settled core nodes after which the bound of a core search is tightened
+    static constexpr std::size_t CORE_BOUND_INTERVAL = 256;
+    // rough number of nodes an upward search settles on road networks
+    static constexpr std::size_t ESTIMATED_SEARCH_SPACE = 512;
+    // sources that share a downward sweep
+    static constexpr std::size_t SWEEP_LANES = 8;
+    // sources whose forward searches share a scan of the buckets
+    static constexpr std::size_t BUCKET_JOIN_LANES = 8;
+    // weight of nodes the sweep has not reached, small enough to add an edge weight to
+    static constexpr EdgeWeight SWEEP_INFINITY = std::numeric_limits<EdgeWeight>::max() / 2;
+    static constexpr std::uint32_t INVALID_SWEEP_INDEX = std::numeric_limits<std::uint32_t>::max();
+    // a sweep restricted to the nodes above the targets pays off once there are this many
+    // targets and this many targets per source
+    static constexpr std::size_t RESTRICTED_SWEEP_MIN_TARGETS = 256;
+    static constexpr std::size_t RESTRICTED_SWEEP_TARGETS_PER_SOURCE = 16;
+    // approximate tables with fewer sources are searched exactly, the clusters would be too small
+    static constexpr std::size_t APPROXIMATE_MIN_SOURCES = 64;
+    static constexpr std::size_t APPROXIMATE_SOURCES_PER_CLUSTER = 16;
+
+    // All nodes of the hierarchy in sweep order, the weights are indexed by node id
+    class FullSweepSpace
+    {
+      public:
+        FullSweepSpace(const DataFacadeT &facade, const std::vector<NodeID> &sweep_order)
+            : facade(facade), sweep_order(sweep_order)
+        {
+        }
+
+        std::size_t GetSize() const { return facade.GetNumberOfNodes(); }
+
+        std::uint32_t GetIndex(const NodeID node) const { return node; }
+
+        // the edges from higher nodes down to a node are stored at the node
+        template <std::size_t LANES> void Sweep(std::vector<EdgeWeight> &weights) const
+        {
+            for (const auto node : sweep_order)
+            {
+                EdgeWeight *const node_weights = &weights[node * LANES];
+                for (const auto edge : facade.GetBackwardEdgeRange(node))
+                {
+                    const auto &data = facade.GetHotEdgeData(edge);
+                    if (data.backward)
+                    {
+                        const auto higher_node = data.target;
+                        const EdgeWeight *const higher_weights = &weights[higher_node * LANES];
+                        for (std::size_t lane = 0; lane < LANES; ++lane)
+                        {
+                            node_weights[lane] =
+                                std::min(node_weights[lane], higher_weights[lane] + data.weight);
+                        }
+                    }
+                }
+            }
+        }
+
+      private:
+        const DataFacadeT &facade;
+        const std::vector<NodeID> &sweep_order;
+    };
+
+    // Only the nodes above the targets (RPHAST), indexed in sweep order, with the edges from
+    // their higher nodes copied into an adjacency array of their own. It is built once per
+    // table and shared by the sweeps of all sources.
+    struct RestrictedSweepSpace
+    {
+        std::size_t GetSize() const { return local_index.size(); }
+
+        std::uint32_t GetIndex(const NodeID node) const
+        {
+            const auto iter = local_index.find(node);
+            return iter == local_index.end() ? INVALID_SWEEP_INDEX : iter->second;
+        }
+
+        template <std::size_t LANES> void Sweep(std::vector<EdgeWeight> &weights) const
+        {
+            const auto number_of_nodes = static_cast<std::uint32_t>(GetSize());
+            for (std::uint32_t index = 0; index < number_of_nodes; ++index)
+            {
+                EdgeWeight *const node_weights = &weights[index * LANES];
+                for (auto edge = offsets[index]; edge < offsets[index + 1]; ++edge)
+                {
+                    const auto &higher_edge = edges[edge];
+                    const EdgeWeight *const higher_weights = &weights[higher_edge.first * LANES];
+                    for (std::size_t lane = 0; lane < LANES; ++lane)
+                    {
+                        node_weights[lane] = std::min(node_weights[lane],
+                                                      higher_weights[lane] + higher_edge.second);
+                    }
+                }
+            }
+        }
+
+        std::unordered_map<NodeID, std::uint32_t> local_index;
+        // edges of the node with local index i are edges[offsets[i]] to edges[offsets[i + 1]]
+        std::vector<std::uint32_t> offsets;
+        std::vector<std::pair<std::uint32_t, EdgeWeight>> edges;
+    };
+
+  public:
+    ManyToManyRouting(SearchEngineData &engine_working_data)
+        : engine_working_data(engine_working_data)
+    {
+    }
+
+    std::vector<EdgeWeight> operator()(const DataFacadeT &facade,
+                                       const std::vector<PhantomNode> &phantom_nodes,
+                                       const std::vector<std::size_t> &source_indices,
+                                       const std::vector<std::size_t> &target_indices) const
+    {
+        const std::size_t number_of_sources =
+            source_indices.empty() ? phantom_nodes.size() : source_indices.size();
+        const std::size_t number_of_targets =
+            target_indices.empty() ? phantom_nodes.size() : target_indices.size();
+
+        if (facade.GetCoreSize() > 0)
+        {
+            return BucketSearch(facade, phantom_nodes, source_indices, target_indices);
+        }
+
+        // Once the backward searches of the targets would settle more nodes than a sweep over
+        // the whole hierarchy per source, the distances to all nodes are cheaper (PHAST).
+        if (number_of_targets * ESTIMATED_SEARCH_SPACE >
+            number_of_sources * facade.GetNumberOfNodes())
+        {
+            const auto &sweep_order = facade.GetSweepOrder();
+            if (!sweep_order.empty())
+            {
+                return SweepSearch(facade,
+                                   FullSweepSpace(facade, sweep_order),
+                                   phantom_nodes,
+                                   source_indices,
+                                   target_indices);
+            }
+        }
+
+        // Many targets for few sources: sweeping the part of the hierarchy above the targets
+        // is cheaper than filling and scanning their buckets.
+        if (number_of_targets >= RESTRICTED_SWEEP_MIN_TARGETS &&
+            number_of_sources * RESTRICTED_SWEEP_TARGETS_PER_SOURCE <= number_of_targets)
+        {
+            RestrictedSweepSpace sweep_space;
+            if (SelectRestrictedSweepSpace(facade, phantom_nodes, target_indices, sweep_space))
+            {
+                return SweepSearch(
+                    facade, sweep_space, phantom_nodes, source_indices, target_indices);
+            }
+        }
+
+        return BucketSearch(facade, phantom_nodes, source_indices, target_indices);
+    }
+
+    // Same as above, but also fills in the distances in decimeters of the paths the weights
+    // belong to. The distances are summed up along the edges like the weights, which only the
+    // bucket search does.
+    std::vector<EdgeWeight> operator()(const DataFacadeT &facade,
+                                       const std::vector<PhantomNode> &phantom_nodes,
+                                       const std::vector<std::size_t> &source_indices,
+                                       const std::vector<std::size_t> &target_indices,
+                                       std::vector<EdgeDistance> &distance_table) const
+    {
+        return BucketSearch(
+            facade, phantom_nodes, source_indices, target_indices, &distance_table);
+    }
+
+    // Runs the backward searches of the targets once. The buckets hold the distances as well and
+    // answer the tables of any sources to these targets on this facade, see TargetSetSearch.
+    void operator()(const DataFacadeT &facade,
+                    const std::vector<PhantomNode> &target_phantom_nodes,
+                    TargetBuckets &target_buckets) const
+    {
+        const auto target_phantom = [&](const std::size_t column_idx) -> const PhantomNode & {
+            return target_phantom_nodes[column_idx];
+        };
+        const auto target_phantom_distances = [&](const std::size_t column_idx) {
+            return GetPhantomDistances(facade, target_phantom_nodes[column_idx]);
+        };
+        FillTargetBuckets(facade,
+                          target_phantom_nodes.size(),
+                          target_phantom,
+                          target_phantom_distances,
+                          true,
+                          target_buckets);
+    }
+
+    // The table from the sources to the targets of the buckets, which only runs the forward
+    // searches
+    std::vector<EdgeWeight> operator()(const DataFacadeT &facade,
+                                       const std::vector<PhantomNode> &phantom_nodes,
+                                       const std::vector<std::size_t> &source_indices,
+                                       const TargetBuckets &target_buckets) const
+    {
+        return TargetSetSearch(facade, phantom_nodes, source_indices, target_buckets, nullptr);
+    }
+
+    std::vector<EdgeWeight> operator()(const DataFacadeT &facade,
+                                       const std::vector<PhantomNode> &phantom_nodes,
+                                       const std::vector<std::size_t> &source_indices,
+                                       const TargetBuckets &target_buckets,
+                                       std::vector<EdgeDistance> &distance_table) const
+    {
+        return TargetSetSearch(
+            facade, phantom_nodes, source_indices, target_buckets, &distance_table);
+    }
+
+    // Weights that are at most max_error longer than the shortest ones, never shorter, see
+    // ApproximateSearch
+    std::vector<EdgeWeight> operator()(const DataFacadeT &facade,
+                                       const std::vector<PhantomNode> &phantom_nodes,
+                                       const std::vector<std::size_t> &source_indices,
+                                       const std::vector<std::size_t> &target_indices,
+                                       const double max_error) const
+    {
+        return ApproximateSearch(facade, phantom_nodes, source_indices, target_indices, max_error);
+    }
+
+  private:
+    std::vector<EdgeWeight> BucketSearch(const DataFacadeT &facade,
+                                         const std::vector<PhantomNode> &phantom_nodes,
+                                         const std::vector<std::size_t> &source_indices,
+                                         const std::vector<std::size_t> &target_indices,
+                                         std::vector<EdgeDistance> *distance_table = nullptr) const
+    {
+        const auto number_of_sources =
+            source_indices.empty() ? phantom_nodes.size() : source_indices.size();
+        const auto number_of_targets =
+            target_indices.empty() ? phantom_nodes.size() : target_indices.size();
+        const auto number_of_entries = number_of_sources * number_of_targets;
+        std::vector<EdgeWeight> result_table(number_of_entries,
+                                             std::numeric_limits<EdgeWeight>::max());
+
+        const auto source_phantom = [&](const std::size_t row_idx) -> const PhantomNode & {
+            return source_indices.empty() ? phantom_nodes[row_idx]
+                                          : phantom_nodes[source_indices[row_idx]];
+        };
+        const auto target_phantom = [&](const std::size_t column_idx) -> const PhantomNode & {
+            return target_indices.empty() ? phantom_nodes[column_idx]
+                                          : phantom_nodes[target_indices[column_idx]];
+        };
+        if (distance_table)
+        {
+            distance_table->assign(number_of_entries, INVALID_EDGE_DISTANCE);
+        }
+
+        // Square tables with the same sources and targets resolve the phantom distances only
+        // once for both phases, and the diagonal is known before any search runs.
+        const bool symmetric = source_indices == target_indices;
+        std::vector<PhantomDistances> target_distances;
+        std::vector<PhantomDistances> source_distances;
+        if (distance_table)
+        {
+            target_distances.reserve(number_of_targets);
+            for (const auto column_idx : util::irange<std::size_t>(0UL, number_of_targets))
+            {
+                target_distances.push_back(
+                    GetPhantomDistances(facade, target_phantom(column_idx)));
+            }
+            if (!symmetric)
+            {
+                source_distances.reserve(number_of_sources);
+                for (const auto row_idx : util::irange<std::size_t>(0UL, number_of_sources))
+                {
+                    source_distances.push_back(
+                        GetPhantomDistances(facade, source_phantom(row_idx)));
+                }
+            }
+        }
+        const auto target_phantom_distances = [&](const std::size_t column_idx) {
+            return distance_table ? target_distances[column_idx] : PhantomDistances{0, 0};
+        };
+        const auto source_phantom_distances = [&](const std::size_t row_idx) {
+            return distance_table ? (symmetric ? target_distances : source_distances)[row_idx]
+                                  : PhantomDistances{0, 0};
+        };
+        if (symmetric)
+        {
+            for (const auto index : util::irange<std::size_t>(0UL, number_of_sources))
+            {
+                result_table[index * number_of_targets + index] = 0;
+                if (distance_table)
+                {
+                    (*distance_table)[index * number_of_targets + index] = 0;
+                }
+            }
+        }
+
+        TargetBuckets target_buckets;
+        FillTargetBuckets(facade,
+                          number_of_targets,
+                          target_phantom,
+                          target_phantom_distances,
+                          distance_table != nullptr,
+                          target_buckets);
+        SearchSources(facade,
+                      number_of_sources,
+                      source_phantom,
+                      source_phantom_distances,
+                      target_buckets,
+                      result_table,
+                      distance_table);
+
+        return result_table;
+    }
+
+    // Sources close to each other share the row of one of them, their representative. The grid
+    // cells of their locations make up the clusters, about APPROXIMATE_SOURCES_PER_CLUSTER sources
+    // each.
+    //
+    // A route from s over r to t has to pass r in one direction, arriving and departing on the
+    // same segment of r, otherwise it makes a u-turn at r. So the weights are kept apart by the
+    // direction d of r: s gets min over d of w(s, r_d) + w(r_d, t), the weight of a route that
+    // exists and is never shorter than w(s, t). The shortest route leaves s in some direction x,
+    // w(s, t) = w(s_x, t), and w(r_d, t) <= w(r_d, s_x) + w(s_x, t) as the route from r_d
+    // arriving at s in direction x continues in that direction. The approximation is thus at most
+    // max over x of min over d of w(s, r_d) + w(r_d, s_x) longer than w(s, t). The entries of
+    // which this bound is more than max_error of the shortest weight they can stand for are
+    // searched exactly, by cluster. The exact searches then cover the targets close to the
+    // sources and the sources whose representative does not lead back to them.
+    std::vector<EdgeWeight> ApproximateSearch(const DataFacadeT &facade,
+                                              const std::vector<PhantomNode> &phantom_nodes,
+                                              const std::vector<std::size_t> &source_indices,
+                                              const std::vector<std::size_t> &target_indices,
+                                              const double max_error) const
+    {
+        const auto number_of_sources =
+            source_indices.empty() ? phantom_nodes.size() : source_indices.size();
+        if (number_of_sources < APPROXIMATE_MIN_SOURCES)
+        {
+            return BucketSearch(facade, phantom_nodes, source_indices, target_indices);
+        }
+        const auto number_of_targets =
+            target_indices.empty() ? phantom_nodes.size() : target_indices.size();
+
+        std::vector<std::size_t> rows(number_of_sources);
+        if (source_indices.empty())
+        {
+            std::iota(rows.begin(), rows.end(), 0);
+        }
+        else
+        {
+            std::copy(source_indices.begin(), source_indices.end(), rows.begin());
+        }
+        std::vector<std::size_t> columns(number_of_targets);
+        if (target_indices.empty())
+        {
+            std::iota(columns.begin(), columns.end(), 0);
+        }
+        else
+        {
+            std::copy(target_indices.begin(), target_indices.end(), columns.begin());
+        }
+
+        // square cells over the bounding box of the sources, the first source of a cell
+        // represents it
+        std::int64_t min_lon = std::numeric_limits<std::int64_t>::max();
+        std::int64_t min_lat = std::numeric_limits<std::int64_t>::max();
+        std::int64_t max_lon = std::numeric_limits<std::int64_t>::min();
+        std::int64_t max_lat = std::numeric_limits<std::int64_t>::min();
+        for (const auto row : rows)
+        {
+            const auto &location = phantom_nodes[row].location;
+            min_lon = std::min<std::int64_t>(min_lon, static_cast<int>(location.lon));
+            min_lat = std::min<std::int64_t>(min_lat, static_cast<int>(location.lat));
+            max_lon = std::max<std::int64_t>(max_lon, static_cast<int>(location.lon));
+            max_lat = std::max<std::int64_t>(max_lat, static_cast<int>(location.lat));
+        }
+        const double number_of_cells =
+            static_cast<double>(number_of_sources) / APPROXIMATE_SOURCES_PER_CLUSTER;
+        const auto cell_size = std::max<std::int64_t>(
+            1,
+            static_cast<std::int64_t>(std::ceil(std::sqrt(
+                static_cast<double>(max_lon - min_lon + 1) * (max_lat - min_lat + 1) /
+                number_of_cells))));
+
+        std::unordered_map<std::int64_t, std::size_t> cell_clusters;
+        std::vector<std::size_t> representatives;
+        std::vector<std::vector<std::size_t>> cluster_rows;
+        for (const auto row_idx : util::irange<std::size_t>(0UL, number_of_sources))
+        {
+            const auto &location = phantom_nodes[rows[row_idx]].location;
+            const auto x = (static_cast<int>(location.lon) - min_lon) / cell_size;
+            const auto y = (static_cast<int>(location.lat) - min_lat) / cell_size;
+            const auto cell =
+                cell_clusters.emplace(y * ((max_lon - min_lon) / cell_size + 1) + x,
+                                      representatives.size());
+            if (cell.second)
+            {
+                representatives.push_back(rows[row_idx]);
+                cluster_rows.emplace_back();
+            }
+            cluster_rows[cell.first->second].push_back(row_idx);
+        }
+        const auto number_of_clusters = representatives.size();
+
+        // The phantom nodes followed by copies of the ones of the representatives and the sources
+        // that only have their forward respectively their reverse direction enabled, two per
+        // phantom node. Directions that were disabled stay so, their copies reach nothing.
+        auto split_phantoms = phantom_nodes;
+        const auto split_representatives_begin = split_phantoms.size();
+        const auto split_sources_begin = split_representatives_begin + 2 * number_of_clusters;
+        const auto split = [&split_phantoms](PhantomNode phantom) {
+            const auto reverse_segment_id = phantom.reverse_segment_id;
+            phantom.reverse_segment_id.enabled = false;
+            split_phantoms.push_back(phantom);
+            phantom.reverse_segment_id = reverse_segment_id;
+            phantom.forward_segment_id.enabled = false;
+            split_phantoms.push_back(phantom);
+        };
+        for (const auto representative : representatives)
+        {
+            split(phantom_nodes[representative]);
+        }
+        for (const auto row : rows)
+        {
+            split(phantom_nodes[row]);
+        }
+        std::vector<std::size_t> split_representatives(2 * number_of_clusters);
+        std::iota(split_representatives.begin(),
+                  split_representatives.end(),
+                  split_representatives_begin);
+
+        // weights from the representatives in either direction to the targets
+        const auto representative_table =
+            BucketSearch(facade, split_phantoms, split_representatives, columns);
+
+        const EdgeWeight unreachable = std::numeric_limits<EdgeWeight>::max();
+        std::vector<EdgeWeight> result_table(number_of_sources * number_of_targets, unreachable);
+        // the rows and columns of every cluster whose entries are searched exactly
+        std::vector<std::vector<std::size_t>> exact_rows(number_of_clusters);
+        std::vector<std::vector<std::size_t>> exact_columns(number_of_clusters);
+        std::vector<bool> is_exact_column(number_of_targets);
+        for (const auto cluster : util::irange<std::size_t>(0UL, number_of_clusters))
+        {
+            const auto &cluster_row_indices = cluster_rows[cluster];
+            const std::vector<std::size_t> representative_directions = {
+                split_representatives[2 * cluster], split_representatives[2 * cluster + 1]};
+            std::vector<std::size_t> sources;
+            std::vector<std::size_t> source_directions;
+            for (const auto row_idx : cluster_row_indices)
+            {
+                sources.push_back(rows[row_idx]);
+                source_directions.push_back(split_sources_begin + 2 * row_idx);
+                source_directions.push_back(split_sources_begin + 2 * row_idx + 1);
+            }
+            // w(s, r_d) and w(r_d, s_x) for the sources of the cluster
+            const auto to_representative =
+                BucketSearch(facade, split_phantoms, sources, representative_directions);
+            const auto from_representative =
+                BucketSearch(facade, split_phantoms, representative_directions, source_directions);
+
+            std::fill(is_exact_column.begin(), is_exact_column.end(), false);
+            for (const auto source : util::irange<std::size_t>(0UL, sources.size()))
+            {
+                const auto row_idx = cluster_row_indices[source];
+                const auto &phantom = phantom_nodes[rows[row_idx]];
+                const auto arrival = [&](const std::size_t direction) {
+                    return to_representative[source * 2 + direction];
+                };
+                const auto departure = [&](const std::size_t direction, const std::size_t column) {
+                    return representative_table[(2 * cluster + direction) * number_of_targets +
+                                                column];
+                };
+
+                // the bound of the error for every direction the source can be left in
+                bool bounded = true;
+                std::int64_t error = 0;
+                for (const auto x : util::irange<std::size_t>(0UL, 2UL))
+                {
+                    if (!(x == 0 ? phantom.forward_segment_id.enabled
+                                 : phantom.reverse_segment_id.enabled))
+                    {
+                        continue;
+                    }
+                    std::int64_t direction_error = std::numeric_limits<std::int64_t>::max();
+                    for (const auto d : util::irange<std::size_t>(0UL, 2UL))
+                    {
+                        const auto back = from_representative[d * source_directions.size() +
+                                                              2 * source + x];
+                        if (arrival(d) != unreachable && back != unreachable)
+                        {
+                            direction_error =
+                                std::min(direction_error, std::int64_t{arrival(d)} + back);
+                        }
+                    }
+                    bounded = bounded &&
+                              direction_error != std::numeric_limits<std::int64_t>::max();
+                    error = std::max(error, direction_error);
+                }
+
+                bool has_exact_columns = false;
+                for (const auto column_idx : util::irange<std::size_t>(0UL, number_of_targets))
+                {
+                    std::int64_t approximation = std::numeric_limits<std::int64_t>::max();
+                    for (const auto d : util::irange<std::size_t>(0UL, 2UL))
+                    {
+                        if (arrival(d) != unreachable && departure(d, column_idx) != unreachable)
+                        {
+                            approximation = std::min(
+                                approximation,
+                                std::int64_t{arrival(d)} + departure(d, column_idx));
+                        }
+                    }
+                    if (bounded && approximation == std::numeric_limits<std::int64_t>::max())
+                    {
+                        // the route over the representative that the bound is made of would
+                        // reach the target
+                        continue;
+                    }
+                    if (bounded && error <= max_error * (approximation - error))
+                    {
+                        result_table[row_idx * number_of_targets + column_idx] =
+                            static_cast<EdgeWeight>(approximation);
+                        continue;
+                    }
+                    has_exact_columns = true;
+                    is_exact_column[column_idx] = true;
+                }
+                if (has_exact_columns)
+                {
+                    exact_rows[cluster].push_back(row_idx);
+                }
+            }
+            for (const auto column_idx : util::irange<std::size_t>(0UL, number_of_targets))
+            {
+                if (is_exact_column[column_idx])
+                {
+                    exact_columns[cluster].push_back(column_idx);
+                }
+            }
+        }
+
+        for (const auto cluster : util::irange<std::size_t>(0UL, number_of_clusters))
+        {
+            if (exact_rows[cluster].empty())
+            {
+                continue;
+            }
+            std::vector<std::size_t> sources;
+            for (const auto row_idx : exact_rows[cluster])
+            {
+                sources.push_back(rows[row_idx]);
+            }
+            std::vector<std::size_t> targets;
+            for (const auto column_idx : exact_columns[cluster])
+            {
+                targets.push_back(columns[column_idx]);
+            }
+            const auto exact_table = BucketSearch(facade, phantom_nodes, sources, targets);
+
+            // the entries that were already good enough keep their approximation
+            for (const auto source : util::irange<std::size_t>(0UL, sources.size()))
+            {
+                const auto row_idx = exact_rows[cluster][source];
+                for (const auto target : util::irange<std::size_t>(0UL, targets.size()))
+                {
+                    auto &entry =
+                        result_table[row_idx * number_of_targets + exact_columns[cluster][target]];
+                    if (entry == unreachable)
+                    {
+                        entry = exact_table[source * targets.size() + target];
+                    }
+                }
+            }
+        }
+
+        return result_table;
+    }
+
+    // The forward phase of the bucket search from the sources to the buckets of a target set
+    std::vector<EdgeWeight> TargetSetSearch(const DataFacadeT &facade,
+                                            const std::vector<PhantomNode> &phantom_nodes,
+                                            const std::vector<std::size_t> &source_indices,
+                                            const TargetBuckets &target_buckets,
+                                            std::vector<EdgeDistance> *distance_table) const
+    {
+        const auto number_of_sources =
+            source_indices.empty() ? phantom_nodes.size() : source_indices.size();
+        const auto number_of_entries = number_of_sources * target_buckets.number_of_targets;
+        std::vector<EdgeWeight> result_table(number_of_entries,
+                                             std::numeric_limits<EdgeWeight>::max());
+
+        const auto source_phantom = [&](const std::size_t row_idx) -> const PhantomNode & {
+            return source_indices.empty() ? phantom_nodes[row_idx]
+                                          : phantom_nodes[source_indices[row_idx]];
+        };
+        std::vector<PhantomDistances> source_distances;
+        if (distance_table)
+        {
+            distance_table->assign(number_of_entries, INVALID_EDGE_DISTANCE);
+            source_distances.reserve(number_of_sources);
+            for (const auto row_idx : util::irange<std::size_t>(0UL, number_of_sources))
+            {
+                source_distances.push_back(GetPhantomDistances(facade, source_phantom(row_idx)));
+            }
+        }
+        const auto source_phantom_distances = [&](const std::size_t row_idx) {
+            return distance_table ? source_distances[row_idx] : PhantomDistances{0, 0};
+        };
+
+        SearchSources(facade,
+                      number_of_sources,
+                      source_phantom,
+                      source_phantom_distances,
+                      target_buckets,
+                      result_table,
+                      distance_table);
+        return result_table;
+    }
+
+    // The backward phase of the bucket search, which settles the search space of every target
+    template <typename TargetPhantomT, typename TargetDistancesT>
+    void FillTargetBuckets(const DataFacadeT &facade,
+                           const std::size_t number_of_targets,
+                           const TargetPhantomT &target_phantom,
+                           const TargetDistancesT &target_phantom_distances,
+                           const bool with_distances,
+                           TargetBuckets &target_buckets) const
+    {
+        target_buckets.number_of_targets = number_of_targets;
+        auto &search_space_with_buckets = target_buckets.search_space_with_buckets;
+        search_space_with_buckets.clear();
+
+        // Every search uses the heap of the set its thread leased and the searches of one phase
+        // are independent, so large tables are split over the TBB worker threads.
+        if (number_of_targets < PARALLEL_SEARCH_THRESHOLD)
+        {
+            engine_working_data.InitializeOrClearManyToManyThreadLocalStorage(
+                facade.GetNumberOfNodes());
+            QueryHeap &query_heap = *(engine_working_data.many_to_many_heap);
+
+            for (const auto column_idx : util::irange<std::size_t>(0UL, number_of_targets))
+            {
+                BackwardSearch(facade,
+                               target_phantom(column_idx),
+                               target_phantom_distances(column_idx),
+                               with_distances,
+                               column_idx,
+                               query_heap,
+                               search_space_with_buckets);
+            }
+            std::sort(search_space_with_buckets.begin(), search_space_with_buckets.end());
+        }
+        else
+        {
+            tbb::enumerable_thread_specific<SearchSpaceWithBuckets> thread_buckets;
+            ParallelSearchStatistics statistics;
+            tbb::this_task_arena::isolate([&] {
+                tbb::parallel_for(
+                    tbb::blocked_range<std::size_t>(0, number_of_targets, PARALLEL_GRAIN_SIZE),
+                    [&](const tbb::blocked_range<std::size_t> &range) {
+                        SearchEngineData::Lease heap_lease(SearchEngineData::Lease::Task);
+                        engine_working_data.InitializeOrClearManyToManyThreadLocalStorage(
+                            facade.GetNumberOfNodes());
+                        QueryHeap &query_heap = *(engine_working_data.many_to_many_heap);
+                        auto &buckets = thread_buckets.local();
+
+                        statistics.Run([&] {
+                            for (auto column_idx = range.begin(); column_idx != range.end();
+                                 ++column_idx)
+                            {
+                                BackwardSearch(facade,
+                                               target_phantom(column_idx),
+                                               target_phantom_distances(column_idx),
+                                               with_distances,
+                                               column_idx,
+                                               query_heap,
+                                               buckets);
+                            }
+                        });
+                    });
+            });
+
+            std::size_t number_of_buckets = 0;
+            for (const auto &buckets : thread_buckets)
+            {
+                number_of_buckets += buckets.size();
+            }
+            search_space_with_buckets.reserve(number_of_buckets);
+            for (const auto &buckets : thread_buckets)
+            {
+                search_space_with_buckets.insert(
+                    search_space_with_buckets.end(), buckets.begin(), buckets.end());
+            }
+            tbb::this_task_arena::isolate([&] {
+                tbb::parallel_sort(search_space_with_buckets.begin(),
+                                   search_space_with_buckets.end());
+            });
+        }
+
+        // On a partially contracted dataset the searches do not expand core nodes, the settled
+        // core nodes are the points at which the searches enter the core.
+        target_buckets.core_targets = CoreTargets();
+        if (facade.GetCoreSize() > 0)
+        {
+            target_buckets.core_targets =
+                GetCoreTargets(facade, number_of_targets, search_space_with_buckets);
+        }
+    }
+
+    // The forward phase of the bucket search, which fills in the row of every source
+    template <typename SourcePhantomT, typename SourceDistancesT>
+    void SearchSources(const DataFacadeT &facade,
+                       const std::size_t number_of_sources,
+                       const SourcePhantomT &source_phantom,
+                       const SourceDistancesT &source_phantom_distances,
+                       const TargetBuckets &target_buckets,
+                       std::vector<EdgeWeight> &result_table,
+                       std::vector<EdgeDistance> *distance_table) const
+    {
+        // the result table needs no synchronization since every forward search owns its row
+        const auto number_of_targets = target_buckets.number_of_targets;
+
+        // Weight tables without core targets join the buckets for BUCKET_JOIN_LANES sources at
+        // once. Distances, core searches and cached search spaces need a search per source.
+        const bool batched = number_of_sources > 1 && !distance_table &&
+                             target_buckets.core_targets.columns.empty() &&
+                             !facade.GetSearchSpaceCache();
+        const auto number_of_units =
+            batched ? (number_of_sources + BUCKET_JOIN_LANES - 1) / BUCKET_JOIN_LANES
+                    : number_of_sources;
+        const auto search_unit = [&](const std::size_t unit, QueryHeap &query_heap) {
+            if (batched)
+            {
+                const auto first_row = unit * BUCKET_JOIN_LANES;
+                BatchForwardSearch<BUCKET_JOIN_LANES>(
+                    facade,
+                    first_row,
+                    std::min<std::size_t>(BUCKET_JOIN_LANES, number_of_sources - first_row),
+                    number_of_targets,
+                    source_phantom,
+                    query_heap,
+                    target_buckets.search_space_with_buckets,
+                    result_table);
+                return;
+            }
+            ForwardSearch(facade,
+                          source_phantom(unit),
+                          source_phantom_distances(unit),
+                          unit,
+                          number_of_targets,
+                          query_heap,
+                          target_buckets.search_space_with_buckets,
+                          target_buckets.core_targets,
+                          result_table,
+                          distance_table);
+        };
+
+        if (number_of_sources < PARALLEL_SEARCH_THRESHOLD)
+        {
+            engine_working_data.InitializeOrClearManyToManyThreadLocalStorage(
+                facade.GetNumberOfNodes());
+            QueryHeap &query_heap = *(engine_working_data.many_to_many_heap);
+
+            for (const auto unit : util::irange<std::size_t>(0UL, number_of_units))
+            {
+                search_unit(unit, query_heap);
+            }
+        }
+        else
+        {
+            const auto grain_size =
+                batched ? std::max<std::size_t>(1, PARALLEL_GRAIN_SIZE / BUCKET_JOIN_LANES)
+                        : PARALLEL_GRAIN_SIZE;
+            ParallelSearchStatistics statistics;
+            tbb::this_task_arena::isolate([&] {
+                tbb::parallel_for(
+                    tbb::blocked_range<std::size_t>(0, number_of_units, grain_size),
+                    [&](const tbb::blocked_range<std::size_t> &range) {
+                        SearchEngineData::Lease heap_lease(SearchEngineData::Lease::Task);
+                        engine_working_data.InitializeOrClearManyToManyThreadLocalStorage(
+                            facade.GetNumberOfNodes());
+                        QueryHeap &query_heap = *(engine_working_data.many_to_many_heap);
+
+                        statistics.Run([&] {
+                            for (auto unit = range.begin(); unit != range.end(); ++unit)
+                            {
+                                search_unit(unit, query_heap);
+                            }
+                        });
+                    });
+            });
+        }
+    }
+
+    // The forward searches of up to LANES sources, whose rows are first_row onwards. Their
+    // search spaces are merged by node, so the buckets of a node are found and scanned once for
+    // all of them. The weights of the lanes of a target are adjacent and taken the minimum of
+    // together, like the weights of the sweep.
+    template <std::size_t LANES, typename SourcePhantomT>
+    void BatchForwardSearch(const DataFacadeT &facade,
+                            const std::size_t first_row,
+                            const std::size_t number_of_rows,
+                            const std::size_t number_of_targets,
+                            const SourcePhantomT &source_phantom,
+                            QueryHeap &query_heap,
+                            const SearchSpaceWithBuckets &search_space_with_buckets,
+                            std::vector<EdgeWeight> &result_table) const
     {
-        unsigned target_id; // essentially a row in the weight matrix
-        EdgeWeight weight;
-        NodeBucket(const unsigned target_id, const EdgeWeight weight)
-            : target_id(target_id), weight(weight)
+        BOOST_ASSERT(number_of_rows <= LANES);
+        struct LaneNode
+        {
+            NodeID node;
+            std::uint32_t lane;
+            EdgeWeight weight;
+        };
+
+        // the buffers are reused by all batches of a thread
+        static thread_local SearchSpace search_space;
+        static thread_local std::vector<LaneNode> lane_nodes;
+        static thread_local std::vector<EdgeWeight> batch_table;
+
+        lane_nodes.clear();
+        for (const auto lane : util::irange<std::size_t>(0, number_of_rows))
         {
+            search_space.clear();
+            UpwardSearch(facade,
+                         source_phantom(first_row + lane),
+                         PhantomDistances{0, 0},
+                         false,
+                         query_heap,
+                         search_space);
+            for (const auto &settled_node : search_space)
+            {
+                lane_nodes.push_back({settled_node.node,
+                                      static_cast<std::uint32_t>(lane),
+                                      settled_node.weight});
+            }
         }
-    };
+        std::sort(lane_nodes.begin(),
+                  lane_nodes.end(),
+                  [](const LaneNode &lhs, const LaneNode &rhs) { return lhs.node < rhs.node; });
 
-    // FIXME This should be replaced by an std::unordered_multimap, though this needs benchmarking
-    using SearchSpaceWithBuckets = std::unordered_map<NodeID, std::vector<NodeBucket>>;
+        batch_table.assign(number_of_targets * LANES, EdgeWeight{SWEEP_INFINITY});
+        auto &deadline = GetQueryDeadline();
+        auto group = lane_nodes.begin();
+        while (group != lane_nodes.end())
+        {
+            deadline.Check();
+            const auto node = group->node;
+            std::array<EdgeWeight, LANES> node_weights;
+            node_weights.fill(SWEEP_INFINITY);
+            bool negative = false;
+            for (; group != lane_nodes.end() && group->node == node; ++group)
+            {
+                node_weights[group->lane] = group->weight;
+                negative |= group->weight < 0;
+            }
 
-  public:
-    ManyToManyRouting(SearchEngineData &engine_working_data)
-        : engine_working_data(engine_working_data)
-    {
+            // Only the segments a source starts on have negative weights. A target before the
+            // source on such a segment needs the loop around it, which ScanBuckets handles.
+            if (negative)
+            {
+                for (const auto lane : util::irange<std::size_t>(0, number_of_rows))
+                {
+                    if (node_weights[lane] < SWEEP_INFINITY)
+                    {
+                        ScanBuckets(facade,
+                                    node,
+                                    node_weights[lane],
+                                    0,
+                                    first_row + lane,
+                                    number_of_targets,
+                                    search_space_with_buckets,
+                                    result_table,
+                                    nullptr);
+                    }
+                }
+                continue;
+            }
+
+            const auto bucket_list = std::equal_range(search_space_with_buckets.begin(),
+                                                      search_space_with_buckets.end(),
+                                                      node,
+                                                      typename NodeBucket::MiddleNodeCompare());
+            for (const auto &bucket : boost::make_iterator_range(bucket_list))
+            {
+                EdgeWeight *const column_weights = &batch_table[bucket.target_id * LANES];
+                for (std::size_t lane = 0; lane < LANES; ++lane)
+                {
+                    column_weights[lane] =
+                        std::min(column_weights[lane], node_weights[lane] + bucket.weight);
+                }
+            }
+        }
+
+        for (const auto lane : util::irange<std::size_t>(0, number_of_rows))
+        {
+            const auto row_idx = first_row + lane;
+            for (const auto column_idx : util::irange<std::size_t>(0, number_of_targets))
+            {
+                const auto weight = batch_table[column_idx * LANES + lane];
+                auto &current_weight = result_table[row_idx * number_of_targets + column_idx];
+                if (weight < SWEEP_INFINITY && weight < current_weight)
+                {
+                    current_weight = weight;
+                }
+            }
+        }
     }
 
-    std::vector<EdgeWeight> operator()(const DataFacadeT &facade,
-                                       const std::vector<PhantomNode> &phantom_nodes,
-                                       const std::vector<std::size_t> &source_indices,
-                                       const std::vector<std::size_t> &target_indices) const
+    // One-to-all searches: the upward search of a source is followed by a sweep over the nodes
+    // from the top of the hierarchy down, which takes the weights of the higher neighbours of
+    // every node. The sweep handles up to SWEEP_LANES sources at once.
+    template <typename SweepSpaceT>
+    std::vector<EdgeWeight> SweepSearch(const DataFacadeT &facade,
+                                        const SweepSpaceT &sweep_space,
+                                        const std::vector<PhantomNode> &phantom_nodes,
+                                        const std::vector<std::size_t> &source_indices,
+                                        const std::vector<std::size_t> &target_indices) const
     {
         const auto number_of_sources =
             source_indices.empty() ? phantom_nodes.size() : source_indices.size();
         const auto number_of_targets =
             target_indices.empty() ? phantom_nodes.size() : target_indices.size();
-        const auto number_of_entries = number_of_sources * number_of_targets;
-        std::vector<EdgeWeight> result_table(number_of_entries,
+        std::vector<EdgeWeight> result_table(number_of_sources * number_of_targets,
                                              std::numeric_limits<EdgeWeight>::max());
 
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(facade.GetNumberOfNodes());
+        const auto sweep_batch = [&](const std::size_t batch, SameSegmentPairs &pairs) {
+            const auto first_row = batch * SWEEP_LANES;
+            const auto number_of_rows =
+                std::min<std::size_t>(SWEEP_LANES, number_of_sources - first_row);
+            if (number_of_rows == 1)
+            {
+                SweepBatch<1>(facade,
+                              sweep_space,
+                              phantom_nodes,
+                              source_indices,
+                              target_indices,
+                              first_row,
+                              number_of_rows,
+                              result_table,
+                              pairs);
+            }
+            else
+            {
+                SweepBatch<SWEEP_LANES>(facade,
+                                        sweep_space,
+                                        phantom_nodes,
+                                        source_indices,
+                                        target_indices,
+                                        first_row,
+                                        number_of_rows,
+                                        result_table,
+                                        pairs);
+            }
+        };
+
+        // every batch owns its rows of the result table
+        const auto number_of_batches = (number_of_sources + SWEEP_LANES - 1) / SWEEP_LANES;
+        tbb::enumerable_thread_specific<SameSegmentPairs> thread_pairs;
+        if (number_of_batches == 1)
+        {
+            sweep_batch(0, thread_pairs.local());
+        }
+        else
+        {
+            ParallelSearchStatistics statistics;
+            tbb::this_task_arena::isolate([&] {
+                tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_batches, 1),
+                                  [&](const tbb::blocked_range<std::size_t> &range) {
+                                      statistics.Run([&] {
+                                          for (auto batch = range.begin(); batch != range.end();
+                                               ++batch)
+                                          {
+                                              sweep_batch(batch, thread_pairs.local());
+                                          }
+                                      });
+                                  });
+            });
+        }
+
+        // The weights of the sweep are the shortest ones, for a target before the source on
+        // the same segment that is the negative one of staying on the segment. The buckets
+        // look for a way around the segment instead.
+        for (const auto &pairs : thread_pairs)
+        {
+            for (const auto &pair : pairs)
+            {
+                const auto source_index = source_indices.empty() ? pair.first
+                                                                 : source_indices[pair.first];
+                const auto target_index = target_indices.empty() ? pair.second
+                                                                 : target_indices[pair.second];
+                result_table[pair.first * number_of_targets + pair.second] =
+                    BucketSearch(facade, phantom_nodes, {source_index}, {target_index}).front();
+            }
+        }
+
+        return result_table;
+    }
+
+    template <std::size_t LANES, typename SweepSpaceT>
+    void SweepBatch(const DataFacadeT &facade,
+                    const SweepSpaceT &sweep_space,
+                    const std::vector<PhantomNode> &phantom_nodes,
+                    const std::vector<std::size_t> &source_indices,
+                    const std::vector<std::size_t> &target_indices,
+                    const std::size_t first_row,
+                    const std::size_t number_of_rows,
+                    std::vector<EdgeWeight> &result_table,
+                    SameSegmentPairs &same_segment_pairs) const
+    {
+        BOOST_ASSERT(number_of_rows <= LANES);
+        const auto number_of_nodes = facade.GetNumberOfNodes();
+        const auto number_of_targets =
+            target_indices.empty() ? phantom_nodes.size() : target_indices.size();
 
-        QueryHeap &query_heap = *(engine_working_data.forward_heap_1);
+        // the weights of all lanes of a node are adjacent, so the sweep updates them together
+        std::vector<EdgeWeight> weights(sweep_space.GetSize() * LANES, EdgeWeight{SWEEP_INFINITY});
 
-        SearchSpaceWithBuckets search_space_with_buckets;
+        engine_working_data.InitializeOrClearManyToManyThreadLocalStorage(number_of_nodes);
+        QueryHeap &query_heap = *(engine_working_data.many_to_many_heap);
+        auto &deadline = GetQueryDeadline();
+        for (const auto lane : util::irange<std::size_t>(0, number_of_rows))
+        {
+            const auto row_idx = first_row + lane;
+            const auto &phantom = source_indices.empty() ? phantom_nodes[row_idx]
+                                                         : phantom_nodes[source_indices[row_idx]];
 
-        unsigned column_idx = 0;
-        const auto search_target_phantom = [&](const PhantomNode &phantom) {
             query_heap.Clear();
-            // insert target(s) at weight 0
-
             if (phantom.forward_segment_id.enabled)
             {
                 query_heap.Insert(phantom.forward_segment_id.id,
-                                  phantom.GetForwardWeightPlusOffset(),
+                                  -phantom.GetForwardWeightPlusOffset(),
                                   phantom.forward_segment_id.id);
             }
             if (phantom.reverse_segment_id.enabled)
             {
                 query_heap.Insert(phantom.reverse_segment_id.id,
-                                  phantom.GetReverseWeightPlusOffset(),
+                                  -phantom.GetReverseWeightPlusOffset(),
                                   phantom.reverse_segment_id.id);
             }
 
-            // explore search space
             while (!query_heap.Empty())
             {
-                BackwardRoutingStep(facade, column_idx, query_heap, search_space_with_buckets);
+                deadline.Check();
+                const NodeID node = query_heap.DeleteMin();
+                const EdgeWeight weight = query_heap.GetKey(node);
+                OSRM_COUNT_SEARCH(settled_nodes, 1);
+                const auto index = sweep_space.GetIndex(node);
+                if (index != INVALID_SWEEP_INDEX)
+                {
+                    weights[index * LANES + lane] = weight;
+                }
+
+                if (!super::StallAtNode(facade, query_heap, node, weight, true))
+                {
+                    RelaxOutgoingEdges<true>(facade, node, weight, 0, false, query_heap);
+                }
             }
-            ++column_idx;
-        };
+        }
 
-        // for each source do forward search
-        unsigned row_idx = 0;
-        const auto search_source_phantom = [&](const PhantomNode &phantom) {
-            query_heap.Clear();
-            // insert target(s) at weight 0
+        sweep_space.template Sweep<LANES>(weights);
 
-            if (phantom.forward_segment_id.enabled)
+        for (const auto lane : util::irange<std::size_t>(0, number_of_rows))
+        {
+            const auto row_idx = first_row + lane;
+            for (const auto column_idx : util::irange<std::size_t>(0, number_of_targets))
             {
-                query_heap.Insert(phantom.forward_segment_id.id,
-                                  -phantom.GetForwardWeightPlusOffset(),
-                                  phantom.forward_segment_id.id);
+                const auto &phantom = target_indices.empty()
+                                          ? phantom_nodes[column_idx]
+                                          : phantom_nodes[target_indices[column_idx]];
+
+                EdgeWeight weight = std::numeric_limits<EdgeWeight>::max();
+                bool same_segment = false;
+                const auto add_candidate = [&](const NodeID node, const EdgeWeight offset) {
+                    const auto node_weight = weights[sweep_space.GetIndex(node) * LANES + lane];
+                    if (node_weight < SWEEP_INFINITY)
+                    {
+                        same_segment |= node_weight + offset < 0;
+                        weight = std::min(weight, node_weight + offset);
+                    }
+                };
+                if (phantom.forward_segment_id.enabled)
+                {
+                    add_candidate(phantom.forward_segment_id.id,
+                                  phantom.GetForwardWeightPlusOffset());
+                }
+                if (phantom.reverse_segment_id.enabled)
+                {
+                    add_candidate(phantom.reverse_segment_id.id,
+                                  phantom.GetReverseWeightPlusOffset());
+                }
+
+                if (same_segment)
+                {
+                    same_segment_pairs.emplace_back(row_idx, column_idx);
+                }
+                else
+                {
+                    result_table[row_idx * number_of_targets + column_idx] = weight;
+                }
             }
-            if (phantom.reverse_segment_id.enabled)
+        }
+    }
+
+    // Depth first search from the targets over the edges to higher nodes, a node is indexed
+    // after all of its higher nodes. Returns false if the edges are not a hierarchy.
+    bool SelectRestrictedSweepSpace(const DataFacadeT &facade,
+                                    const std::vector<PhantomNode> &phantom_nodes,
+                                    const std::vector<std::size_t> &target_indices,
+                                    RestrictedSweepSpace &sweep_space) const
+    {
+        const auto number_of_targets =
+            target_indices.empty() ? phantom_nodes.size() : target_indices.size();
+        auto &local_index = sweep_space.local_index;
+
+        std::vector<NodeID> sweep_order;
+        std::vector<std::pair<NodeID, EdgeID>> stack;
+        const auto select = [&](const NodeID target) {
+            if (!local_index.emplace(target, INVALID_SWEEP_INDEX).second)
             {
-                query_heap.Insert(phantom.reverse_segment_id.id,
-                                  -phantom.GetReverseWeightPlusOffset(),
-                                  phantom.reverse_segment_id.id);
+                return true;
             }
 
-            // explore search space
-            while (!query_heap.Empty())
+            stack.emplace_back(target, facade.BeginEdges(target));
+            while (!stack.empty())
             {
-                ForwardRoutingStep(facade,
-                                   row_idx,
-                                   number_of_targets,
-                                   query_heap,
-                                   search_space_with_buckets,
-                                   result_table);
+                const auto node = stack.back().first;
+                auto &edge = stack.back().second;
+                if (edge != facade.EndEdges(node))
+                {
+                    const auto &data = facade.GetHotEdgeData(edge++);
+                    const auto higher_node = data.target;
+                    if (!data.backward || higher_node == node)
+                    {
+                        continue;
+                    }
+                    const auto inserted = local_index.emplace(higher_node, INVALID_SWEEP_INDEX);
+                    if (inserted.second)
+                    {
+                        stack.emplace_back(higher_node, facade.BeginEdges(higher_node));
+                    }
+                    else if (inserted.first->second == INVALID_SWEEP_INDEX)
+                    {
+                        // the higher node is still on the stack
+                        return false;
+                    }
+                    continue;
+                }
+
+                local_index[node] = sweep_order.size();
+                sweep_order.push_back(node);
+                stack.pop_back();
             }
-            ++row_idx;
+            return true;
         };
 
-        if (target_indices.empty())
+        for (const auto column_idx : util::irange<std::size_t>(0, number_of_targets))
         {
-            for (const auto &phantom : phantom_nodes)
+            const auto &phantom = target_indices.empty()
+                                      ? phantom_nodes[column_idx]
+                                      : phantom_nodes[target_indices[column_idx]];
+            if ((phantom.forward_segment_id.enabled && !select(phantom.forward_segment_id.id)) ||
+                (phantom.reverse_segment_id.enabled && !select(phantom.reverse_segment_id.id)))
             {
-                search_target_phantom(phantom);
+                return false;
             }
         }
-        else
+
+        sweep_space.offsets.reserve(sweep_order.size() + 1);
+        sweep_space.offsets.push_back(0);
+        for (const auto node : sweep_order)
         {
-            for (const auto index : target_indices)
+            for (const auto edge : facade.GetBackwardEdgeRange(node))
             {
-                const auto &phantom = phantom_nodes[index];
-                search_target_phantom(phantom);
+                const auto &data = facade.GetHotEdgeData(edge);
+                const auto higher_node = data.target;
+                if (data.backward && higher_node != node)
+                {
+                    sweep_space.edges.emplace_back(local_index[higher_node], data.weight);
+                }
             }
+            sweep_space.offsets.push_back(sweep_space.edges.size());
         }
+        return true;
+    }
 
-        if (source_indices.empty())
+    // The counterparts of the weight offsets of a phantom node, the segments are measured like
+    // the edge-based nodes in the extractor
+    PhantomDistances GetPhantomDistances(const DataFacadeT &facade,
+                                         const PhantomNode &phantom) const
+    {
+        const auto geometry = facade.GetUncompressedForwardGeometry(phantom.packed_geometry_id);
+        double forward_distance = 0;
+        double total_distance = 0;
+        if (geometry.empty())
+        {
+            return {0, 0};
+        }
+        auto node = geometry.begin();
+        auto from = facade.GetCoordinateOfNode(*node);
+        for (std::size_t segment = 0; segment + 1 < geometry.size(); ++segment)
+        {
+            if (segment == phantom.fwd_segment_position)
+            {
+                forward_distance = total_distance + util::coordinate_calculation::haversineDistance(
+                                                        from, phantom.location);
+            }
+            const auto to = facade.GetCoordinateOfNode(*++node);
+            total_distance += util::coordinate_calculation::haversineDistance(from, to);
+            from = to;
+        }
+
+        const auto forward = static_cast<EdgeDistance>(std::round(10 * forward_distance));
+        const auto total = static_cast<EdgeDistance>(std::round(10 * total_distance));
+        return {forward, total - forward};
+    }
+
+    void BackwardSearch(const DataFacadeT &facade,
+                        const PhantomNode &phantom,
+                        const PhantomDistances &distances,
+                        const bool with_distances,
+                        const unsigned column_idx,
+                        QueryHeap &query_heap,
+                        SearchSpaceWithBuckets &search_space_with_buckets) const
+    {
+        query_heap.Clear();
+        // insert target(s) at weight 0
+
+        if (phantom.forward_segment_id.enabled)
+        {
+            query_heap.Insert(phantom.forward_segment_id.id,
+                              phantom.GetForwardWeightPlusOffset(),
+                              {phantom.forward_segment_id.id, distances.first});
+        }
+        if (phantom.reverse_segment_id.enabled)
+        {
+            query_heap.Insert(phantom.reverse_segment_id.id,
+                              phantom.GetReverseWeightPlusOffset(),
+                              {phantom.reverse_segment_id.id, distances.second});
+        }
+
+        // explore search space
+        auto &deadline = GetQueryDeadline();
+        while (!query_heap.Empty())
+        {
+            deadline.Check();
+            BackwardRoutingStep(
+                facade, column_idx, with_distances, query_heap, search_space_with_buckets);
+        }
+    }
+
+    void ForwardSearch(const DataFacadeT &facade,
+                       const PhantomNode &phantom,
+                       const PhantomDistances &distances,
+                       const unsigned row_idx,
+                       const unsigned number_of_targets,
+                       QueryHeap &query_heap,
+                       const SearchSpaceWithBuckets &search_space_with_buckets,
+                       const CoreTargets &core_targets,
+                       std::vector<EdgeWeight> &result_table,
+                       std::vector<EdgeDistance> *distance_table) const
+    {
+        // the entry points are reused by all searches of a thread
+        static thread_local CoreEntryPoints core_entry_points;
+        core_entry_points.clear();
+
+        auto &deadline = GetQueryDeadline();
+        auto *const search_space_cache = facade.GetSearchSpaceCache();
+        if (search_space_cache)
         {
-            for (const auto &phantom : phantom_nodes)
+            // The upward search does not depend on the targets, a cached search space is only
+            // joined with the buckets
+            const SearchSpaceCache::Key key{
+                phantom.forward_segment_id.enabled ? phantom.forward_segment_id.id
+                                                   : SPECIAL_NODEID,
+                phantom.reverse_segment_id.enabled ? phantom.reverse_segment_id.id
+                                                   : SPECIAL_NODEID,
+                phantom.forward_segment_id.enabled ? phantom.GetForwardWeightPlusOffset() : 0,
+                phantom.reverse_segment_id.enabled ? phantom.GetReverseWeightPlusOffset() : 0,
+                distance_table ? distances.first : INVALID_EDGE_DISTANCE,
+                distance_table ? distances.second : INVALID_EDGE_DISTANCE};
+            auto search_space = search_space_cache->Find(key);
+            if (!search_space)
+            {
+                auto settled_nodes = std::make_shared<SearchSpace>();
+                UpwardSearch(facade,
+                             phantom,
+                             distances,
+                             distance_table != nullptr,
+                             query_heap,
+                             *settled_nodes);
+                search_space = std::move(settled_nodes);
+                search_space_cache->Insert(key, search_space);
+            }
+
+            for (const auto &settled_node : *search_space)
             {
-                search_source_phantom(phantom);
+                deadline.Check();
+                ScanBuckets(facade,
+                            settled_node.node,
+                            settled_node.weight,
+                            settled_node.distance,
+                            row_idx,
+                            number_of_targets,
+                            search_space_with_buckets,
+                            result_table,
+                            distance_table);
+                if (facade.IsCoreNode(settled_node.node))
+                {
+                    core_entry_points.push_back(
+                        {settled_node.node, settled_node.weight, settled_node.distance});
+                }
             }
         }
         else
         {
-            for (const auto index : source_indices)
+            InsertSource(phantom, distances, query_heap);
+
+            // explore search space
+            while (!query_heap.Empty())
             {
-                const auto &phantom = phantom_nodes[index];
-                search_source_phantom(phantom);
+                deadline.Check();
+                ForwardRoutingStep(facade,
+                                   row_idx,
+                                   number_of_targets,
+                                   query_heap,
+                                   search_space_with_buckets,
+                                   core_entry_points,
+                                   result_table,
+                                   distance_table);
             }
         }
 
-        return result_table;
+        if (!core_entry_points.empty() && !core_targets.columns.empty())
+        {
+            CoreSearch(facade,
+                       row_idx,
+                       number_of_targets,
+                       query_heap,
+                       search_space_with_buckets,
+                       core_entry_points,
+                       core_targets,
+                       result_table,
+                       distance_table);
+        }
+    }
+
+    void InsertSource(const PhantomNode &phantom,
+                      const PhantomDistances &distances,
+                      QueryHeap &query_heap) const
+    {
+        query_heap.Clear();
+        // insert source(s) at weight 0
+
+        if (phantom.forward_segment_id.enabled)
+        {
+            query_heap.Insert(phantom.forward_segment_id.id,
+                              -phantom.GetForwardWeightPlusOffset(),
+                              {phantom.forward_segment_id.id, -distances.first});
+        }
+        if (phantom.reverse_segment_id.enabled)
+        {
+            query_heap.Insert(phantom.reverse_segment_id.id,
+                              -phantom.GetReverseWeightPlusOffset(),
+                              {phantom.reverse_segment_id.id, -distances.second});
+        }
+    }
+
+    // The upward search of a source on its own, which settles the same nodes as the forward
+    // search without looking at any buckets
+    void UpwardSearch(const DataFacadeT &facade,
+                      const PhantomNode &phantom,
+                      const PhantomDistances &distances,
+                      const bool with_distances,
+                      QueryHeap &query_heap,
+                      SearchSpace &search_space) const
+    {
+        InsertSource(phantom, distances, query_heap);
+
+        auto &deadline = GetQueryDeadline();
+        while (!query_heap.Empty())
+        {
+            deadline.Check();
+            const NodeID node = query_heap.DeleteMin();
+            const int weight = query_heap.GetKey(node);
+            OSRM_COUNT_SEARCH(settled_nodes, 1);
+            const EdgeDistance distance = query_heap.GetData(node).distance;
+            search_space.push_back({node, weight, distance});
+
+            if (facade.IsCoreNode(node) ||
+                super::StallAtNode(facade, query_heap, node, weight, true))
+            {
+                continue;
+            }
+            RelaxOutgoingEdges<true>(facade, node, weight, distance, with_distances, query_heap);
+        }
     }
 
     void ForwardRoutingStep(const DataFacadeT &facade,
@@ -163,128 +1508,254 @@ class ManyToManyRouting final
                             const unsigned number_of_targets,
                             QueryHeap &query_heap,
                             const SearchSpaceWithBuckets &search_space_with_buckets,
-                            std::vector<EdgeWeight> &result_table) const
+                            CoreEntryPoints &core_entry_points,
+                            std::vector<EdgeWeight> &result_table,
+                            std::vector<EdgeDistance> *distance_table) const
     {
         const NodeID node = query_heap.DeleteMin();
         const int source_weight = query_heap.GetKey(node);
+        OSRM_COUNT_SEARCH(settled_nodes, 1);
+        const EdgeDistance source_distance = query_heap.GetData(node).distance;
+
+        ScanBuckets(facade,
+                    node,
+                    source_weight,
+                    source_distance,
+                    row_idx,
+                    number_of_targets,
+                    search_space_with_buckets,
+                    result_table,
+                    distance_table);
+
+        if (facade.IsCoreNode(node))
+        {
+            core_entry_points.push_back({node, source_weight, source_distance});
+            return;
+        }
+        if (super::StallAtNode(facade, query_heap, node, source_weight, true))
+        {
+            return;
+        }
+        RelaxOutgoingEdges<true>(
+            facade, node, source_weight, source_distance, distance_table != nullptr, query_heap);
+    }
+
+    // Dijkstra on the core from the core nodes at which the upward search of the source stopped.
+    // The core is not contracted, so it is searched without stalling until no target reached
+    // through the core can get a smaller weight.
+    void CoreSearch(const DataFacadeT &facade,
+                    const unsigned row_idx,
+                    const unsigned number_of_targets,
+                    QueryHeap &query_heap,
+                    const SearchSpaceWithBuckets &search_space_with_buckets,
+                    const CoreEntryPoints &core_entry_points,
+                    const CoreTargets &core_targets,
+                    std::vector<EdgeWeight> &result_table,
+                    std::vector<EdgeDistance> *distance_table) const
+    {
+        query_heap.Clear();
+        for (const auto &entry_point : core_entry_points)
+        {
+            query_heap.Insert(entry_point.node,
+                              entry_point.weight,
+                              {entry_point.node, entry_point.distance});
+        }
+
+        // the largest weight of the row that the core can still improve
+        const auto row_bound = [&] {
+            EdgeWeight bound = std::numeric_limits<EdgeWeight>::min();
+            for (const auto column_idx : core_targets.columns)
+            {
+                bound = std::max(bound, result_table[row_idx * number_of_targets + column_idx]);
+            }
+            return bound;
+        };
+
+        auto bound = row_bound();
+        std::size_t number_of_settled_nodes = 0;
+        auto &deadline = GetQueryDeadline();
+        while (!query_heap.Empty() &&
+               static_cast<std::int64_t>(query_heap.MinKey()) + core_targets.min_weight < bound)
+        {
+            deadline.Check();
+            const NodeID node = query_heap.DeleteMin();
+            const int weight = query_heap.GetKey(node);
+            OSRM_COUNT_SEARCH(settled_nodes, 1);
+            const EdgeDistance distance = query_heap.GetData(node).distance;
+
+            ScanBuckets(facade,
+                        node,
+                        weight,
+                        distance,
+                        row_idx,
+                        number_of_targets,
+                        search_space_with_buckets,
+                        result_table,
+                        distance_table);
+            RelaxOutgoingEdges<true>(
+                facade, node, weight, distance, distance_table != nullptr, query_heap);
 
+            if (++number_of_settled_nodes % CORE_BOUND_INTERVAL == 0)
+            {
+                bound = row_bound();
+            }
+        }
+    }
+
+    void ScanBuckets(const DataFacadeT &facade,
+                     const NodeID node,
+                     const EdgeWeight source_weight,
+                     const EdgeDistance source_distance,
+                     const unsigned row_idx,
+                     const unsigned number_of_targets,
+                     const SearchSpaceWithBuckets &search_space_with_buckets,
+                     std::vector<EdgeWeight> &result_table,
+                     std::vector<EdgeDistance> *distance_table) const
+    {
         // check if each encountered node has an entry
-        const auto bucket_iterator = search_space_with_buckets.find(node);
-        // iterate bucket if there exists one
-        if (bucket_iterator != search_space_with_buckets.end())
+        const auto bucket_list = std::equal_range(search_space_with_buckets.begin(),
+                                                  search_space_with_buckets.end(),
+                                                  node,
+                                                  typename NodeBucket::MiddleNodeCompare());
+        for (const auto &current_bucket : boost::make_iterator_range(bucket_list))
         {
-            const std::vector<NodeBucket> &bucket_list = bucket_iterator->second;
-            for (const NodeBucket &current_bucket : bucket_list)
+            // get target id from bucket entry
+            const unsigned column_idx = current_bucket.target_id;
+            const int target_weight = current_bucket.weight;
+            const auto entry = row_idx * number_of_targets + column_idx;
+            auto &current_weight = result_table[entry];
+            // check if new weight is better
+            const EdgeWeight new_weight = source_weight + target_weight;
+            if (new_weight < 0)
             {
-                // get target id from bucket entry
-                const unsigned column_idx = current_bucket.target_id;
-                const int target_weight = current_bucket.weight;
-                auto &current_weight = result_table[row_idx * number_of_targets + column_idx];
-                // check if new weight is better
-                const EdgeWeight new_weight = source_weight + target_weight;
-                if (new_weight < 0)
+                const EdgeWeight loop_weight = super::GetLoopWeight(facade, node);
+                const int new_weight_with_loop = new_weight + loop_weight;
+                if (loop_weight != INVALID_EDGE_WEIGHT && new_weight_with_loop >= 0 &&
+                    new_weight_with_loop < current_weight)
                 {
-                    const EdgeWeight loop_weight = super::GetLoopWeight(facade, node);
-                    const int new_weight_with_loop = new_weight + loop_weight;
-                    if (loop_weight != INVALID_EDGE_WEIGHT && new_weight_with_loop >= 0)
+                    current_weight = new_weight_with_loop;
+                    if (distance_table)
                     {
-                        current_weight = std::min(current_weight, new_weight_with_loop);
+                        (*distance_table)[entry] = source_distance + current_bucket.distance +
+                                                   super::GetLoopDistance(facade, node);
                     }
                 }
-                else if (new_weight < current_weight)
+            }
+            else if (new_weight < current_weight)
+            {
+                current_weight = new_weight;
+                if (distance_table)
                 {
-                    result_table[row_idx * number_of_targets + column_idx] = new_weight;
+                    (*distance_table)[entry] = source_distance + current_bucket.distance;
                 }
             }
         }
-        if (StallAtNode<true>(facade, node, source_weight, query_heap))
+    }
+
+    CoreTargets GetCoreTargets(const DataFacadeT &facade,
+                               const unsigned number_of_targets,
+                               const SearchSpaceWithBuckets &search_space_with_buckets) const
+    {
+        CoreTargets core_targets;
+        std::vector<bool> reaches_core(number_of_targets, false);
+        for (const auto &bucket : search_space_with_buckets)
         {
-            return;
+            if (facade.IsCoreNode(bucket.middle_node))
+            {
+                reaches_core[bucket.target_id] = true;
+                core_targets.min_weight = std::min(core_targets.min_weight, bucket.weight);
+            }
+        }
+        for (const auto column_idx : util::irange<unsigned>(0, number_of_targets))
+        {
+            if (reaches_core[column_idx])
+            {
+                core_targets.columns.push_back(column_idx);
+            }
         }
-        RelaxOutgoingEdges<true>(facade, node, source_weight, query_heap);
+        return core_targets;
     }
 
     void BackwardRoutingStep(const DataFacadeT &facade,
                              const unsigned column_idx,
+                             const bool with_distances,
                              QueryHeap &query_heap,
                              SearchSpaceWithBuckets &search_space_with_buckets) const
     {
         const NodeID node = query_heap.DeleteMin();
         const int target_weight = query_heap.GetKey(node);
+        OSRM_COUNT_SEARCH(settled_nodes, 1);
+        const EdgeDistance target_distance = query_heap.GetData(node).distance;
 
         // store settled nodes in search space bucket
-        search_space_with_buckets[node].emplace_back(column_idx, target_weight);
+        search_space_with_buckets.emplace_back(node, column_idx, target_weight, target_distance);
+
+        // the core is only searched from the sources
+        if (facade.IsCoreNode(node))
+        {
+            return;
+        }
 
-        if (StallAtNode<false>(facade, node, target_weight, query_heap))
+        if (super::StallAtNode(facade, query_heap, node, target_weight, false))
         {
             return;
         }
 
-        RelaxOutgoingEdges<false>(facade, node, target_weight, query_heap);
+        RelaxOutgoingEdges<false>(
+            facade, node, target_weight, target_distance, with_distances, query_heap);
     }
 
     template <bool forward_direction>
     inline void RelaxOutgoingEdges(const DataFacadeT &facade,
                                    const NodeID node,
                                    const EdgeWeight weight,
+                                   const EdgeDistance distance,
+                                   const bool with_distances,
                                    QueryHeap &query_heap) const
     {
-        for (auto edge : facade.GetAdjacentEdgeRange(node))
+        for (auto edge : forward_direction ? facade.GetForwardEdgeRange(node)
+                                           : facade.GetBackwardEdgeRange(node))
         {
-            const auto &data = facade.GetEdgeData(edge);
+            const auto &data = facade.GetHotEdgeData(edge);
             const bool direction_flag = (forward_direction ? data.forward : data.backward);
             if (direction_flag)
             {
-                const NodeID to = facade.GetTarget(edge);
+                const NodeID to = data.target;
                 const int edge_weight = data.weight;
+                OSRM_COUNT_SEARCH(relaxed_edges, 1);
 
                 BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
                 const int to_weight = weight + edge_weight;
+                // the lengths are in the cold part of the edges, only distance tables read them
+                const EdgeDistance to_distance =
+                    with_distances ? distance + facade.GetEdgeData(edge).distance : 0;
 
                 // New Node discovered -> Add to Heap + Node Info Storage
                 if (!query_heap.WasInserted(to))
                 {
-                    query_heap.Insert(to, to_weight, node);
+                    query_heap.Insert(to, to_weight, {node, to_distance});
+                    OSRM_COUNT_SEARCH(heap_inserts, 1);
                 }
                 // Found a shorter Path -> Update weight
                 else if (to_weight < query_heap.GetKey(to))
                 {
                     // new parent
-                    query_heap.GetData(to).parent = node;
+                    query_heap.GetData(to) = {node, to_distance};
                     query_heap.DecreaseKey(to, to_weight);
+                    OSRM_COUNT_SEARCH(heap_decrease_keys, 1);
                 }
             }
         }
     }
-
-    // Stalling
-    template <bool forward_direction>
-    inline bool StallAtNode(const DataFacadeT &facade,
-                            const NodeID node,
-                            const EdgeWeight weight,
-                            QueryHeap &query_heap) const
-    {
-        for (auto edge : facade.GetAdjacentEdgeRange(node))
-        {
-            const auto &data = facade.GetEdgeData(edge);
-            const bool reverse_flag = ((!forward_direction) ? data.forward : data.backward);
-            if (reverse_flag)
-            {
-                const NodeID to = facade.GetTarget(edge);
-                const int edge_weight = data.weight;
-                BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
-                if (query_heap.WasInserted(to))
-                {
-                    if (query_heap.GetKey(to) + edge_weight < weight)
-                    {
-                        return true;
-                    }
-                }
-            }
-        }
-        return false;
-    }
 };
+
+// constants that are bound to references, e.g. by std::min, need a definition before C++17
+template <class DataFacadeT> constexpr std::size_t ManyToManyRouting<DataFacadeT>::SWEEP_LANES;
+template <class DataFacadeT> constexpr EdgeWeight ManyToManyRouting<DataFacadeT>::SWEEP_INFINITY;
+template <class DataFacadeT>
+constexpr std::uint32_t ManyToManyRouting<DataFacadeT>::INVALID_SWEEP_INDEX;
+template <class DataFacadeT>
+constexpr std::size_t ManyToManyRouting<DataFacadeT>::BUCKET_JOIN_LANES;
 }
 }
 }
@@ -4,19 +4,29 @@
 #include "engine/routing_algorithms/routing_base.hpp"
 
 #include "engine/map_matching/hidden_markov_model.hpp"
+#include "engine/map_matching/matching_state.hpp"
 #include "engine/map_matching/matching_confidence.hpp"
 #include "engine/map_matching/sub_matching.hpp"
+#include "engine/search_statistics.hpp"
 
 #include "extractor/profile_properties.hpp"
 #include "util/coordinate_calculation.hpp"
 #include "util/for_each_pair.hpp"
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
 #include <cstddef>
 
 #include <algorithm>
 #include <deque>
+#include <functional>
 #include <iomanip>
+#include <iterator>
+#include <limits>
 #include <numeric>
+#include <set>
 #include <utility>
 #include <vector>
 
@@ -29,12 +39,16 @@ namespace routing_algorithms
 
 using CandidateList = std::vector<PhantomNodeWithDistance>;
 using CandidateLists = std::vector<CandidateList>;
-using HMM = map_matching::HiddenMarkovModel<CandidateLists>;
+using HMM = map_matching::HiddenMarkovModel;
 using SubMatchingList = std::vector<map_matching::SubMatching>;
 
 constexpr static const unsigned MAX_BROKEN_STATES = 10;
 static const constexpr double MATCHING_BETA = 10;
 constexpr static const double MAX_DISTANCE_DELTA = 2000.;
+// network distance of a transition that was not computed yet
+constexpr static const double UNKNOWN_DISTANCE = -1.;
+// traces with fewer points are matched on one thread
+constexpr static const std::size_t PARALLEL_MATCHING_THRESHOLD = 256;
 
 // implements a hidden markov model map matching algorithm
 template <class DataFacadeT>
@@ -47,6 +61,8 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
     map_matching::TransitionLogProbability transition_log_probability;
     map_matching::MatchingConfidence confidence;
     extractor::ProfileProperties m_profile_properties;
+    // number of most probable states that are expanded per timestamp, -1 for all
+    const int beam_width;
 
     unsigned GetMedianSampleTime(const std::vector<unsigned> &timestamps) const
     {
@@ -63,11 +79,93 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
         return *median;
     }
 
+    // Points with the same candidates have the same transitions
+    static bool SameCandidates(const CandidateList &lhs, const CandidateList &rhs)
+    {
+        const auto same_phantom = [](const PhantomNodeWithDistance &lhs_candidate,
+                                     const PhantomNodeWithDistance &rhs_candidate) {
+            const auto &left = lhs_candidate.phantom_node;
+            const auto &right = rhs_candidate.phantom_node;
+            return left.forward_segment_id.id == right.forward_segment_id.id &&
+                   left.forward_segment_id.enabled == right.forward_segment_id.enabled &&
+                   left.reverse_segment_id.id == right.reverse_segment_id.id &&
+                   left.reverse_segment_id.enabled == right.reverse_segment_id.enabled &&
+                   left.forward_weight == right.forward_weight &&
+                   left.reverse_weight == right.reverse_weight &&
+                   left.forward_offset == right.forward_offset &&
+                   left.reverse_offset == right.reverse_offset &&
+                   left.fwd_segment_position == right.fwd_segment_position &&
+                   left.location == right.location && left.input_location == right.input_location;
+        };
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), same_phantom);
+    }
+
+    // the time between points the matching expects, 1 without timestamps
+    unsigned GetSampleTime(const std::vector<unsigned> &timestamps) const
+    {
+        if (timestamps.size() > 1)
+        {
+            return std::max(1u, GetMedianSampleTime(timestamps));
+        }
+        return 1u;
+    }
+
+    // Returns the positions of the points that are too late after the point before them for
+    // any transition, the matching splits the trace there
+    std::vector<std::size_t> GetTimeGaps(const std::vector<unsigned> &timestamps,
+                                         const unsigned median_sample_time) const
+    {
+        std::vector<std::size_t> gaps;
+        const auto max_broken_time = median_sample_time * MAX_BROKEN_STATES;
+        for (const auto t : util::irange<std::size_t>(1UL, timestamps.size()))
+        {
+            if (timestamps[t] - timestamps[t - 1] > max_broken_time)
+            {
+                gaps.push_back(t);
+            }
+        }
+        return gaps;
+    }
+
+    // Returns the smallest viterbi value a state of the given timestamp needs to be expanded,
+    // only the beam_width most probable unpruned states reach it. Ties are all expanded.
+    double GetBeamThreshold(const HMM &model,
+                            const std::size_t timestamp,
+                            std::vector<double> &unpruned_values) const
+    {
+        if (beam_width <= 0)
+        {
+            return -std::numeric_limits<double>::infinity();
+        }
+
+        unpruned_values.clear();
+        for (const auto index :
+             util::irange<std::size_t>(model.offsets[timestamp], model.offsets[timestamp + 1]))
+        {
+            if (!model.pruned[index])
+            {
+                unpruned_values.push_back(model.viterbi[index]);
+            }
+        }
+
+        if (unpruned_values.size() <= static_cast<std::size_t>(beam_width))
+        {
+            return -std::numeric_limits<double>::infinity();
+        }
+
+        const auto threshold = unpruned_values.begin() + (beam_width - 1);
+        std::nth_element(
+            unpruned_values.begin(), threshold, unpruned_values.end(), std::greater<double>());
+        return *threshold;
+    }
+
   public:
-    MapMatching(SearchEngineData &engine_working_data, const double default_gps_precision)
+    MapMatching(SearchEngineData &engine_working_data,
+                const double default_gps_precision,
+                const int beam_width = -1)
         : engine_working_data(engine_working_data),
           default_emission_log_probability(default_gps_precision),
-          transition_log_probability(MATCHING_BETA)
+          transition_log_probability(MATCHING_BETA), beam_width(beam_width)
     {
     }
 
@@ -83,18 +181,249 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
         BOOST_ASSERT(candidates_list.size() == trace_coordinates.size());
         BOOST_ASSERT(candidates_list.size() > 1);
 
-        const bool use_timestamps = trace_timestamps.size() > 1;
+        // all parts of a trace use the sample time of the whole trace
+        const auto median_sample_time = GetSampleTime(trace_timestamps);
+        const auto gaps = GetTimeGaps(trace_timestamps, median_sample_time);
+        if (candidates_list.size() < PARALLEL_MATCHING_THRESHOLD || gaps.empty())
+        {
+            MatchPart(facade,
+                      candidates_list,
+                      trace_coordinates,
+                      trace_timestamps,
+                      trace_gps_precision,
+                      median_sample_time,
+                      0,
+                      sub_matchings);
+            return sub_matchings;
+        }
 
-        const auto median_sample_time = [&] {
-            if (use_timestamps)
+        // The matching splits the trace at every gap in time. A part ends with the first point
+        // after its gap, as the whole trace it tries to match the points before the gap again
+        // once it reaches that point, and the next part starts there.
+        std::vector<std::size_t> part_begins = {0};
+        part_begins.insert(part_begins.end(), gaps.begin(), gaps.end());
+        std::vector<SubMatchingList> part_sub_matchings(part_begins.size());
+        {
+            ParallelSearchStatistics statistics;
+            tbb::this_task_arena::isolate([&] {
+                tbb::parallel_for(
+                    tbb::blocked_range<std::size_t>(0, part_begins.size(), 1),
+                    [&](const tbb::blocked_range<std::size_t> &range) {
+                        SearchEngineData::Lease heap_lease(SearchEngineData::Lease::Task);
+                        statistics.Run([&] {
+                            for (auto part = range.begin(); part != range.end(); ++part)
+                            {
+                                const auto begin = part_begins[part];
+                                const auto end = part + 1 < part_begins.size()
+                                                     ? part_begins[part + 1] + 1
+                                                     : candidates_list.size();
+                                MatchPart(facade,
+                                          Slice(candidates_list, begin, end),
+                                          Slice(trace_coordinates, begin, end),
+                                          Slice(trace_timestamps, begin, end),
+                                          Slice(trace_gps_precision, begin, end),
+                                          median_sample_time,
+                                          begin,
+                                          part_sub_matchings[part]);
+                            }
+                        });
+                    });
+            });
+        }
+
+        for (auto &part : part_sub_matchings)
+        {
+            std::move(part.begin(), part.end(), std::back_inserter(sub_matchings));
+        }
+        return sub_matchings;
+    }
+
+    // Continues the matching of a session with the points appended to it since the last call.
+    // Returns the parts of the sub matchings that can no longer change, indexed by the
+    // positions of their points in the trace, and drops the points before them. A cut sub
+    // matching continues with the last point of its returned part. If the window grows beyond
+    // max_window points the paths are cut at the most probable one.
+    SubMatchingList operator()(const DataFacadeT &facade,
+                               map_matching::MatchingState &session,
+                               const bool finish,
+                               const std::size_t max_window) const
+    {
+        SubMatchingList sub_matchings;
+
+        auto &model = session.model;
+        auto &state = session.viterbi;
+        const auto first_new_timestamp = model.NumberOfTimestamps();
+        model.Append(session.candidates_list);
+        ComputeEmissionLogProbabilities(
+            model, session.candidates_list, session.gps_precisions, first_new_timestamp);
+
+        Extend(facade,
+               model,
+               state,
+               session.candidates_list,
+               session.coordinates,
+               session.timestamps,
+               GetSampleTime(session.timestamps));
+        CollectSubMatchings(model,
+                            state,
+                            session.candidates_list,
+                            session.coordinates,
+                            session.offset,
+                            finish,
+                            sub_matchings);
+
+        const auto num_timestamps = model.NumberOfTimestamps();
+        if (finish)
+        {
+            session.tracepoints_end = session.NumberOfPoints();
+            return sub_matchings;
+        }
+
+        if (state.prev_unbroken_timestamps.empty())
+        {
+            // no point since the last sub matching could be matched
+            state.sub_matching_begin = std::max(state.sub_matching_begin, state.restart_timestamp);
+        }
+        else
+        {
+            if (CollectConvergedSubMatching(model,
+                                            state,
+                                            session.candidates_list,
+                                            session.coordinates,
+                                            session.offset,
+                                            sub_matchings))
             {
-                return std::max(1u, GetMedianSampleTime(trace_timestamps));
+                // the last point of the part is final as well
+                session.tracepoints_end = session.offset + state.sub_matching_begin + 1;
             }
-            else
+
+            if (num_timestamps - state.sub_matching_begin > max_window)
             {
-                return 1u;
+                ForceConvergence(model, state, num_timestamps - max_window / 2);
+                if (CollectConvergedSubMatching(model,
+                                                state,
+                                                session.candidates_list,
+                                                session.coordinates,
+                                                session.offset,
+                                                sub_matchings))
+                {
+                    session.tracepoints_end = session.offset + state.sub_matching_begin + 1;
+                }
             }
-        }();
+        }
+        session.tracepoints_end =
+            std::max(session.tracepoints_end, session.offset + state.sub_matching_begin);
+
+        session.DropFront(state.sub_matching_begin);
+
+        return sub_matchings;
+    }
+
+  private:
+    template <typename T>
+    static std::vector<T>
+    Slice(const std::vector<T> &values, const std::size_t begin, const std::size_t end)
+    {
+        if (values.empty())
+        {
+            return {};
+        }
+        return std::vector<T>(values.begin() + begin, values.begin() + end);
+    }
+
+    // Matches a trace, or the part of a trace that starts at the given position in it
+    void MatchPart(const DataFacadeT &facade,
+                   const CandidateLists &candidates_list,
+                   const std::vector<util::Coordinate> &trace_coordinates,
+                   const std::vector<unsigned> &trace_timestamps,
+                   const std::vector<boost::optional<double>> &trace_gps_precision,
+                   const unsigned median_sample_time,
+                   const std::size_t offset,
+                   SubMatchingList &sub_matchings) const
+    {
+        engine_working_data.InitializeMapMatchingThreadLocalStorage();
+        HMM &model = *engine_working_data.map_matching_model;
+        model.Initialize(candidates_list);
+        ComputeEmissionLogProbabilities(model, candidates_list, trace_gps_precision, 0);
+
+        map_matching::ViterbiState state;
+        Extend(facade,
+               model,
+               state,
+               candidates_list,
+               trace_coordinates,
+               trace_timestamps,
+               median_sample_time);
+        CollectSubMatchings(
+            model, state, candidates_list, trace_coordinates, offset, true, sub_matchings);
+    }
+
+    // Without a start the algorithm looks for one again once new points arrive, from the last
+    // timestamp if it has candidates: a start needs a timestamp to continue with
+    std::size_t GetRestartTimestamp(const HMM &model) const
+    {
+        const auto num_timestamps = model.NumberOfTimestamps();
+        if (num_timestamps > 0 && !model.breakage[num_timestamps - 1])
+        {
+            return num_timestamps - 1;
+        }
+        return num_timestamps;
+    }
+
+    void ComputeEmissionLogProbabilities(
+        HMM &model,
+        const CandidateLists &candidates_list,
+        const std::vector<boost::optional<double>> &trace_gps_precision,
+        const std::size_t first_timestamp) const
+    {
+        auto &emission_log_probabilities = model.emission_log_probabilities;
+        for (const auto t : util::irange<std::size_t>(first_timestamp, candidates_list.size()))
+        {
+            const auto emission_log_probability =
+                trace_gps_precision.empty() || !trace_gps_precision[t]
+                    ? default_emission_log_probability
+                    : map_matching::EmissionLogProbability(*trace_gps_precision[t]);
+            std::transform(candidates_list[t].begin(),
+                           candidates_list[t].end(),
+                           emission_log_probabilities.begin() + model.offsets[t],
+                           [&emission_log_probability](const PhantomNodeWithDistance &candidate) {
+                               return emission_log_probability(candidate.distance);
+                           });
+        }
+    }
+
+    // Runs the Viterbi algorithm over the timestamps it did not process yet
+    void Extend(const DataFacadeT &facade,
+                HMM &model,
+                map_matching::ViterbiState &state,
+                const CandidateLists &candidates_list,
+                const std::vector<util::Coordinate> &trace_coordinates,
+                const std::vector<unsigned> &trace_timestamps,
+                const unsigned median_sample_time) const
+    {
+        const auto num_timestamps = candidates_list.size();
+        auto &prev_unbroken_timestamps = state.prev_unbroken_timestamps;
+        if (prev_unbroken_timestamps.empty())
+        {
+            const auto initial_timestamp = state.restart_timestamp < num_timestamps
+                                               ? model.initialize(state.restart_timestamp)
+                                               : map_matching::INVALID_STATE;
+            if (initial_timestamp == map_matching::INVALID_STATE)
+            {
+                state.restart_timestamp = GetRestartTimestamp(model);
+                state.next_timestamp = num_timestamps;
+                return;
+            }
+            prev_unbroken_timestamps.reserve(num_timestamps);
+            prev_unbroken_timestamps.push_back(initial_timestamp);
+            state.next_timestamp = initial_timestamp + 1;
+        }
+        if (state.next_timestamp >= num_timestamps)
+        {
+            return;
+        }
+
+        const bool use_timestamps = trace_timestamps.size() > 1;
         const auto max_broken_time = median_sample_time * MAX_BROKEN_STATES;
         const auto max_distance_delta = [&] {
             if (use_timestamps)
@@ -107,57 +436,6 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
             }
         }();
 
-        std::vector<std::vector<double>> emission_log_probabilities(trace_coordinates.size());
-        if (trace_gps_precision.empty())
-        {
-            for (auto t = 0UL; t < candidates_list.size(); ++t)
-            {
-                emission_log_probabilities[t].resize(candidates_list[t].size());
-                std::transform(candidates_list[t].begin(),
-                               candidates_list[t].end(),
-                               emission_log_probabilities[t].begin(),
-                               [this](const PhantomNodeWithDistance &candidate) {
-                                   return default_emission_log_probability(candidate.distance);
-                               });
-            }
-        }
-        else
-        {
-            for (auto t = 0UL; t < candidates_list.size(); ++t)
-            {
-                emission_log_probabilities[t].resize(candidates_list[t].size());
-                if (trace_gps_precision[t])
-                {
-                    map_matching::EmissionLogProbability emission_log_probability(
-                        *trace_gps_precision[t]);
-                    std::transform(
-                        candidates_list[t].begin(),
-                        candidates_list[t].end(),
-                        emission_log_probabilities[t].begin(),
-                        [&emission_log_probability](const PhantomNodeWithDistance &candidate) {
-                            return emission_log_probability(candidate.distance);
-                        });
-                }
-                else
-                {
-                    std::transform(candidates_list[t].begin(),
-                                   candidates_list[t].end(),
-                                   emission_log_probabilities[t].begin(),
-                                   [this](const PhantomNodeWithDistance &candidate) {
-                                       return default_emission_log_probability(candidate.distance);
-                                   });
-                }
-            }
-        }
-
-        HMM model(candidates_list, emission_log_probabilities);
-
-        std::size_t initial_timestamp = model.initialize(0);
-        if (initial_timestamp == map_matching::INVALID_STATE)
-        {
-            return sub_matchings;
-        }
-
         engine_working_data.InitializeOrClearFirstThreadLocalStorage(facade.GetNumberOfNodes());
         engine_working_data.InitializeOrClearSecondThreadLocalStorage(facade.GetNumberOfNodes());
 
@@ -166,13 +444,33 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
         QueryHeap &forward_core_heap = *(engine_working_data.forward_heap_2);
         QueryHeap &reverse_core_heap = *(engine_working_data.reverse_heap_2);
 
-        std::size_t breakage_begin = map_matching::INVALID_STATE;
-        std::vector<std::size_t> split_points;
-        std::vector<std::size_t> prev_unbroken_timestamps;
-        prev_unbroken_timestamps.reserve(candidates_list.size());
-        prev_unbroken_timestamps.push_back(initial_timestamp);
-        for (auto t = initial_timestamp + 1; t < candidates_list.size(); ++t)
+        const auto &emission_log_probabilities = model.emission_log_probabilities;
+        // reused for all timestamps
+        std::vector<std::size_t> target_indices;
+        std::vector<PhantomNode> target_phantoms;
+        std::vector<double> network_distances;
+        std::vector<double> unpruned_values;
+
+        // Points that repeat the candidates of the point before them, e.g. of a stopped vehicle,
+        // make the same transitions again. The network distances between the candidates of the
+        // last two candidate lists are kept, by the first timestamps with these lists.
+        std::vector<std::size_t> candidates_begin(num_timestamps);
+        for (const auto t : util::irange<std::size_t>(0UL, num_timestamps))
         {
+            candidates_begin[t] =
+                t > 0 && SameCandidates(candidates_list[t - 1], candidates_list[t])
+                    ? candidates_begin[t - 1]
+                    : t;
+        }
+        auto cached_source = map_matching::INVALID_STATE;
+        auto cached_target = map_matching::INVALID_STATE;
+        std::vector<double> cached_distances;
+        std::vector<std::size_t> search_indices;
+        const auto &deadline = GetQueryDeadline();
+        for (auto t = state.next_timestamp; t < num_timestamps; ++t)
+        {
+            // every timestamp runs searches for all its candidates
+            deadline.CheckNow();
 
             const bool gap_in_trace = [&, use_timestamps]() {
                 // use temporal information if available to determine a split
@@ -192,71 +490,126 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                 BOOST_ASSERT(!prev_unbroken_timestamps.empty());
                 const std::size_t prev_unbroken_timestamp = prev_unbroken_timestamps.back();
 
-                const auto &prev_viterbi = model.viterbi[prev_unbroken_timestamp];
-                const auto &prev_pruned = model.pruned[prev_unbroken_timestamp];
+                const auto prev_offset = model.offsets[prev_unbroken_timestamp];
                 const auto &prev_unbroken_timestamps_list =
                     candidates_list[prev_unbroken_timestamp];
                 const auto &prev_coordinate = trace_coordinates[prev_unbroken_timestamp];
 
-                auto &current_viterbi = model.viterbi[t];
-                auto &current_pruned = model.pruned[t];
-                auto &current_parents = model.parents[t];
-                auto &current_lengths = model.path_distances[t];
+                const auto current_offset = model.offsets[t];
                 const auto &current_timestamps_list = candidates_list[t];
                 const auto &current_coordinate = trace_coordinates[t];
 
                 const auto haversine_distance = util::coordinate_calculation::haversineDistance(
                     prev_coordinate, current_coordinate);
-                // assumes minumum of 0.1 m/s
+
+                if (cached_source != candidates_begin[prev_unbroken_timestamp] ||
+                    cached_target != candidates_begin[t])
+                {
+                    cached_source = candidates_begin[prev_unbroken_timestamp];
+                    cached_target = candidates_begin[t];
+                    cached_distances.assign(
+                        prev_unbroken_timestamps_list.size() * current_timestamps_list.size(),
+                        UNKNOWN_DISTANCE);
+                }
+                // Transitions whose network distance is max_distance_delta longer than the
+                // haversine distance are pruned anyway. The searches stop at the duration of
+                // that distance at 4 m/s, slower paths count as not found.
                 const int duration_upper_bound =
                     ((haversine_distance + max_distance_delta) * 0.25) * 10;
 
                 // compute d_t for this timestamp and the next one
-                for (const auto s : util::irange<std::size_t>(0UL, prev_viterbi.size()))
+                const double beam_threshold =
+                    GetBeamThreshold(model, prev_unbroken_timestamp, unpruned_values);
+                for (const auto s :
+                     util::irange<std::size_t>(0UL, prev_unbroken_timestamps_list.size()))
                 {
-                    if (prev_pruned[s])
+                    const double prev_viterbi = model.viterbi[prev_offset + s];
+                    // skip hopeless states before running any search for them
+                    if (model.pruned[prev_offset + s] || prev_viterbi < beam_threshold)
                     {
                         continue;
                     }
 
+                    // only search for candidates that could still improve by this transition
+                    target_indices.clear();
+                    target_phantoms.clear();
+                    search_indices.clear();
                     for (const auto s_prime :
-                         util::irange<std::size_t>(0UL, current_viterbi.size()))
+                         util::irange<std::size_t>(0UL, current_timestamps_list.size()))
                     {
-                        const double emission_pr = emission_log_probabilities[t][s_prime];
-                        double new_value = prev_viterbi[s] + emission_pr;
-                        if (current_viterbi[s_prime] > new_value)
+                        const double emission_pr =
+                            emission_log_probabilities[current_offset + s_prime];
+                        const double new_value = prev_viterbi + emission_pr;
+                        if (model.viterbi[current_offset + s_prime] > new_value)
                         {
                             continue;
                         }
+                        target_indices.push_back(s_prime);
+                        if (cached_distances[s * current_timestamps_list.size() + s_prime] ==
+                            UNKNOWN_DISTANCE)
+                        {
+                            search_indices.push_back(s_prime);
+                            target_phantoms.push_back(
+                                current_timestamps_list[s_prime].phantom_node);
+                        }
+                    }
+
+                    if (target_indices.empty())
+                    {
+                        continue;
+                    }
 
+                    if (!search_indices.empty())
+                    {
                         forward_heap.Clear();
                         reverse_heap.Clear();
 
-                        double network_distance;
                         if (facade.GetCoreSize() > 0)
                         {
-                            forward_core_heap.Clear();
-                            reverse_core_heap.Clear();
-                            network_distance = super::GetNetworkDistanceWithCore(
-                                facade,
-                                forward_heap,
-                                reverse_heap,
-                                forward_core_heap,
-                                reverse_core_heap,
-                                prev_unbroken_timestamps_list[s].phantom_node,
-                                current_timestamps_list[s_prime].phantom_node,
-                                duration_upper_bound);
+                            network_distances.clear();
+                            for (const auto &target_phantom : target_phantoms)
+                            {
+                                forward_heap.Clear();
+                                reverse_heap.Clear();
+                                forward_core_heap.Clear();
+                                reverse_core_heap.Clear();
+                                network_distances.push_back(super::GetNetworkDistanceWithCore(
+                                    facade,
+                                    forward_heap,
+                                    reverse_heap,
+                                    forward_core_heap,
+                                    reverse_core_heap,
+                                    prev_unbroken_timestamps_list[s].phantom_node,
+                                    target_phantom,
+                                    duration_upper_bound));
+                            }
                         }
                         else
                         {
-                            network_distance = super::GetNetworkDistance(
+                            // one forward search for all candidates of this timestamp
+                            network_distances = super::GetNetworkDistances(
                                 facade,
                                 forward_heap,
                                 reverse_heap,
                                 prev_unbroken_timestamps_list[s].phantom_node,
-                                current_timestamps_list[s_prime].phantom_node);
+                                target_phantoms,
+                                duration_upper_bound);
                         }
 
+                        for (const auto index :
+                             util::irange<std::size_t>(0UL, search_indices.size()))
+                        {
+                            cached_distances[s * current_timestamps_list.size() +
+                                             search_indices[index]] = network_distances[index];
+                        }
+                    }
+
+                    for (const auto index : util::irange<std::size_t>(0UL, target_indices.size()))
+                    {
+                        const auto s_prime = target_indices[index];
+                        const auto network_distance =
+                            cached_distances[s * current_timestamps_list.size() + s_prime];
+
                         // get distance diff between loc1/2 and locs/s_prime
                         const auto d_t = std::abs(network_distance - haversine_distance);
 
@@ -266,15 +619,18 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                             continue;
                         }
 
+                        const auto current_index = current_offset + s_prime;
+                        const double emission_pr = emission_log_probabilities[current_index];
                         const double transition_pr = transition_log_probability(d_t);
-                        new_value += transition_pr;
+                        const double new_value = prev_viterbi + emission_pr + transition_pr;
 
-                        if (new_value > current_viterbi[s_prime])
+                        if (new_value > model.viterbi[current_index])
                         {
-                            current_viterbi[s_prime] = new_value;
-                            current_parents[s_prime] = std::make_pair(prev_unbroken_timestamp, s);
-                            current_lengths[s_prime] = network_distance;
-                            current_pruned[s_prime] = false;
+                            model.viterbi[current_index] = new_value;
+                            model.parents[current_index] =
+                                std::make_pair(prev_unbroken_timestamp, s);
+                            model.path_distances[current_index] = network_distance;
+                            model.pruned[current_index] = false;
                             model.breakage[t] = false;
                         }
                     }
@@ -283,9 +639,9 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                 if (model.breakage[t])
                 {
                     // save start of breakage -> we need this as split point
-                    if (t < breakage_begin)
+                    if (t < state.breakage_begin)
                     {
-                        breakage_begin = t;
+                        state.breakage_begin = t;
                     }
 
                     BOOST_ASSERT(prev_unbroken_timestamps.size() > 0);
@@ -304,19 +660,21 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
             if (trace_split || gap_in_trace)
             {
                 std::size_t split_index = t;
-                if (breakage_begin != map_matching::INVALID_STATE)
+                if (state.breakage_begin != map_matching::INVALID_STATE)
                 {
-                    split_index = breakage_begin;
-                    breakage_begin = map_matching::INVALID_STATE;
+                    split_index = state.breakage_begin;
+                    state.breakage_begin = map_matching::INVALID_STATE;
                 }
-                split_points.push_back(split_index);
+                state.split_points.push_back(split_index);
 
                 // note: this preserves everything before split_index
                 model.Clear(split_index);
                 std::size_t new_start = model.initialize(split_index);
-                // no new start was found -> stop viterbi calculation
+                // no new start was found -> stop viterbi calculation until new points arrive
                 if (new_start == map_matching::INVALID_STATE)
                 {
+                    prev_unbroken_timestamps.clear();
+                    state.restart_timestamp = GetRestartTimestamp(model);
                     break;
                 }
 
@@ -330,19 +688,29 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                 // iteration will actually be on new_start+1
             }
         }
+        state.next_timestamp = num_timestamps;
+    }
 
-        if (!prev_unbroken_timestamps.empty())
+    // Reconstructs the sub matchings that end at the split points and, if finished, the one the
+    // trace ends with
+    void CollectSubMatchings(const HMM &model,
+                             map_matching::ViterbiState &state,
+                             const CandidateLists &candidates_list,
+                             const std::vector<util::Coordinate> &trace_coordinates,
+                             const std::size_t offset,
+                             const bool finish,
+                             SubMatchingList &sub_matchings) const
+    {
+        if (finish && !state.prev_unbroken_timestamps.empty())
         {
-            split_points.push_back(prev_unbroken_timestamps.back() + 1);
+            state.split_points.push_back(state.prev_unbroken_timestamps.back() + 1);
         }
 
-        std::size_t sub_matching_begin = initial_timestamp;
-        for (const auto sub_matching_end : split_points)
+        auto &sub_matching_begin = state.sub_matching_begin;
+        for (const auto sub_matching_end : state.split_points)
         {
-            map_matching::SubMatching matching;
-
             std::size_t parent_timestamp_index = sub_matching_end - 1;
-            while (parent_timestamp_index >= sub_matching_begin &&
+            while (parent_timestamp_index > sub_matching_begin &&
                    model.breakage[parent_timestamp_index])
             {
                 --parent_timestamp_index;
@@ -353,75 +721,281 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
             }
 
             // matchings that only consist of one candidate are invalid
-            if (parent_timestamp_index - sub_matching_begin + 1 < 2)
+            if (parent_timestamp_index < sub_matching_begin + 1 ||
+                model.breakage[parent_timestamp_index])
             {
                 sub_matching_begin = sub_matching_end;
                 continue;
             }
 
             // loop through the columns, and only compare the last entry
-            const auto max_element_iter =
-                std::max_element(model.viterbi[parent_timestamp_index].begin(),
-                                 model.viterbi[parent_timestamp_index].end());
+            const auto parent_viterbi_begin =
+                model.viterbi.begin() + model.offsets[parent_timestamp_index];
+            const auto parent_viterbi_end =
+                model.viterbi.begin() + model.offsets[parent_timestamp_index + 1];
+            const auto max_element_iter = std::max_element(parent_viterbi_begin, parent_viterbi_end);
 
             std::size_t parent_candidate_index =
-                std::distance(model.viterbi[parent_timestamp_index].begin(), max_element_iter);
+                std::distance(parent_viterbi_begin, max_element_iter);
+
+            map_matching::SubMatching matching;
+            if (MakeSubMatching(model,
+                                candidates_list,
+                                trace_coordinates,
+                                sub_matching_begin,
+                                parent_timestamp_index,
+                                parent_candidate_index,
+                                offset,
+                                matching))
+            {
+                sub_matchings.push_back(std::move(matching));
+            }
+            sub_matching_begin = sub_matching_end;
+        }
+        state.split_points.clear();
+    }
+
+    // Follows the parents of a state back to the beginning of its sub matching
+    bool MakeSubMatching(const HMM &model,
+                         const CandidateLists &candidates_list,
+                         const std::vector<util::Coordinate> &trace_coordinates,
+                         const std::size_t sub_matching_begin,
+                         std::size_t parent_timestamp_index,
+                         std::size_t parent_candidate_index,
+                         const std::size_t offset,
+                         map_matching::SubMatching &matching) const
+    {
+        std::deque<std::pair<std::size_t, std::size_t>> reconstructed_indices;
+        while (parent_timestamp_index > sub_matching_begin)
+        {
+            if (model.breakage[parent_timestamp_index])
+            {
+                continue;
+            }
+
+            reconstructed_indices.emplace_front(parent_timestamp_index, parent_candidate_index);
+            const auto &next =
+                model.parents[model.Index(parent_timestamp_index, parent_candidate_index)];
+            // make sure we can never get stuck in this loop
+            if (parent_timestamp_index == next.first)
+            {
+                break;
+            }
+            parent_timestamp_index = next.first;
+            parent_candidate_index = next.second;
+        }
+        reconstructed_indices.emplace_front(parent_timestamp_index, parent_candidate_index);
+        if (reconstructed_indices.size() < 2)
+        {
+            return false;
+        }
+
+        auto matching_distance = 0.0;
+        auto trace_distance = 0.0;
+        matching.nodes.reserve(reconstructed_indices.size());
+        matching.indices.reserve(reconstructed_indices.size());
+        for (const auto idx : reconstructed_indices)
+        {
+            const auto timestamp_index = idx.first;
+            const auto location_index = idx.second;
+
+            matching.indices.push_back(offset + timestamp_index);
+            matching.nodes.push_back(
+                candidates_list[timestamp_index][location_index].phantom_node);
+            matching_distance +=
+                model.path_distances[model.Index(timestamp_index, location_index)];
+        }
+        util::for_each_pair(
+            reconstructed_indices,
+            [&trace_distance,
+             &trace_coordinates](const std::pair<std::size_t, std::size_t> &prev,
+                                 const std::pair<std::size_t, std::size_t> &curr) {
+                trace_distance += util::coordinate_calculation::haversineDistance(
+                    trace_coordinates[prev.first], trace_coordinates[curr.first]);
+            });
+
+        matching.confidence = confidence(trace_distance, matching_distance);
+
+        return true;
+    }
 
-            std::deque<std::pair<std::size_t, std::size_t>> reconstructed_indices;
-            while (parent_timestamp_index > sub_matching_begin)
+    // Finds the latest state that all paths the current sub matching can still end with go
+    // through. These end at the unbroken timestamps the algorithm can continue from, or at the
+    // last unbroken timestamps before the next possible split.
+    bool FindConvergence(const HMM &model,
+                         const map_matching::ViterbiState &state,
+                         std::size_t &timestamp,
+                         std::size_t &candidate) const
+    {
+        const auto last_unbroken_before = [&](std::size_t end) {
+            while (end > state.sub_matching_begin)
             {
-                if (model.breakage[parent_timestamp_index])
+                if (!model.breakage[--end])
                 {
-                    continue;
+                    return end;
                 }
+            }
+            return map_matching::INVALID_STATE;
+        };
+
+        std::vector<std::size_t> ends = state.prev_unbroken_timestamps;
+        ends.push_back(last_unbroken_before(model.NumberOfTimestamps()));
+        if (state.breakage_begin != map_matching::INVALID_STATE)
+        {
+            ends.push_back(last_unbroken_before(state.breakage_begin));
+        }
 
-                reconstructed_indices.emplace_front(parent_timestamp_index, parent_candidate_index);
-                const auto &next = model.parents[parent_timestamp_index][parent_candidate_index];
-                // make sure we can never get stuck in this loop
-                if (parent_timestamp_index == next.first)
+        std::set<std::pair<std::size_t, std::size_t>> states;
+        for (const auto end : ends)
+        {
+            if (end == map_matching::INVALID_STATE)
+            {
+                continue;
+            }
+            for (const auto s : util::irange<std::size_t>(0UL, model.NumberOfCandidates(end)))
+            {
+                if (!model.pruned[model.Index(end, s)])
                 {
-                    break;
+                    states.emplace(end, s);
                 }
-                parent_timestamp_index = next.first;
-                parent_candidate_index = next.second;
             }
-            reconstructed_indices.emplace_front(parent_timestamp_index, parent_candidate_index);
-            if (reconstructed_indices.size() < 2)
+        }
+
+        // replace the latest state by its parent until the paths meet
+        while (states.size() > 1)
+        {
+            const auto latest = *states.rbegin();
+            const auto &parent = model.parents[model.Index(latest.first, latest.second)];
+            // paths with different starts never meet
+            if (parent.first == latest.first)
             {
-                sub_matching_begin = sub_matching_end;
-                continue;
+                return false;
+            }
+            states.erase(std::prev(states.end()));
+            states.emplace(parent.first, parent.second);
+        }
+
+        if (states.empty())
+        {
+            return false;
+        }
+        timestamp = states.begin()->first;
+        candidate = states.begin()->second;
+        // a split at the breakage would change everything from its beginning on
+        return state.breakage_begin == map_matching::INVALID_STATE ||
+               timestamp < state.breakage_begin;
+    }
+
+    // Appends the part of the current sub matching up to the state all its paths go through,
+    // the sub matching continues from that state
+    bool CollectConvergedSubMatching(const HMM &model,
+                                     map_matching::ViterbiState &state,
+                                     const CandidateLists &candidates_list,
+                                     const std::vector<util::Coordinate> &trace_coordinates,
+                                     const std::size_t offset,
+                                     SubMatchingList &sub_matchings) const
+    {
+        std::size_t timestamp;
+        std::size_t candidate;
+        if (!FindConvergence(model, state, timestamp, candidate) ||
+            timestamp <= state.sub_matching_begin)
+        {
+            return false;
+        }
+
+        map_matching::SubMatching matching;
+        if (MakeSubMatching(model,
+                            candidates_list,
+                            trace_coordinates,
+                            state.sub_matching_begin,
+                            timestamp,
+                            candidate,
+                            offset,
+                            matching))
+        {
+            sub_matchings.push_back(std::move(matching));
+        }
+        state.sub_matching_begin = timestamp;
+        return true;
+    }
+
+    // Prunes all states that are not on the most probable path at or before max_timestamp, so
+    // that the paths of the current sub matching converge there
+    void ForceConvergence(HMM &model,
+                          map_matching::ViterbiState &state,
+                          const std::size_t max_timestamp) const
+    {
+        if (state.prev_unbroken_timestamps.empty())
+        {
+            return;
+        }
+
+        auto timestamp = state.prev_unbroken_timestamps.back();
+        const auto latest_viterbi_begin = model.viterbi.begin() + model.offsets[timestamp];
+        auto candidate = static_cast<std::size_t>(std::distance(
+            latest_viterbi_begin,
+            std::max_element(latest_viterbi_begin,
+                             model.viterbi.begin() + model.offsets[timestamp + 1])));
+        while (timestamp > max_timestamp || (state.breakage_begin != map_matching::INVALID_STATE &&
+                                             timestamp >= state.breakage_begin))
+        {
+            const auto &parent = model.parents[model.Index(timestamp, candidate)];
+            if (parent.first == timestamp)
+            {
+                return;
             }
+            timestamp = parent.first;
+            candidate = parent.second;
+        }
+        if (timestamp <= state.sub_matching_begin)
+        {
+            return;
+        }
+
+        const auto prune = [&model](const std::size_t index) {
+            model.viterbi[index] = map_matching::IMPOSSIBLE_LOG_PROB;
+            model.pruned[index] = true;
+        };
 
-            auto matching_distance = 0.0;
-            auto trace_distance = 0.0;
-            matching.nodes.reserve(reconstructed_indices.size());
-            matching.indices.reserve(reconstructed_indices.size());
-            for (const auto idx : reconstructed_indices)
+        std::vector<bool> kept(model.viterbi.size(), false);
+        for (const auto s : util::irange<std::size_t>(0UL, model.NumberOfCandidates(timestamp)))
+        {
+            if (s != candidate)
             {
-                const auto timestamp_index = idx.first;
-                const auto location_index = idx.second;
+                prune(model.Index(timestamp, s));
+            }
+        }
+        kept[model.Index(timestamp, candidate)] = true;
 
-                matching.indices.push_back(timestamp_index);
-                matching.nodes.push_back(
-                    candidates_list[timestamp_index][location_index].phantom_node);
-                matching_distance += model.path_distances[timestamp_index][location_index];
+        for (const auto t : util::irange<std::size_t>(timestamp + 1, model.NumberOfTimestamps()))
+        {
+            bool unbroken = false;
+            for (const auto s : util::irange<std::size_t>(0UL, model.NumberOfCandidates(t)))
+            {
+                const auto index = model.Index(t, s);
+                const auto &parent = model.parents[index];
+                if (!model.pruned[index] && parent.first != t &&
+                    kept[model.Index(parent.first, parent.second)])
+                {
+                    kept[index] = true;
+                    unbroken = true;
+                }
+                else
+                {
+                    prune(index);
+                }
             }
-            util::for_each_pair(
-                reconstructed_indices,
-                [&trace_distance,
-                 &trace_coordinates](const std::pair<std::size_t, std::size_t> &prev,
-                                     const std::pair<std::size_t, std::size_t> &curr) {
-                    trace_distance += util::coordinate_calculation::haversineDistance(
-                        trace_coordinates[prev.first], trace_coordinates[curr.first]);
-                });
-
-            matching.confidence = confidence(trace_distance, matching_distance);
-
-            sub_matchings.push_back(matching);
-            sub_matching_begin = sub_matching_end;
+            model.breakage[t] = !unbroken;
         }
 
-        return sub_matchings;
+        // the paths can only be continued after the cut
+        auto &prev_unbroken_timestamps = state.prev_unbroken_timestamps;
+        prev_unbroken_timestamps.erase(
+            std::remove_if(prev_unbroken_timestamps.begin(),
+                           prev_unbroken_timestamps.end(),
+                           [&](const std::size_t t) { return t < timestamp || model.breakage[t]; }),
+            prev_unbroken_timestamps.end());
+        BOOST_ASSERT(!prev_unbroken_timestamps.empty());
     }
 };
 }
@@ -0,0 +1,294 @@
+#ifndef OSRM_ENGINE_ROUTING_ALGORITHMS_MULTI_LEVEL_ROUTING_HPP
+#define OSRM_ENGINE_ROUTING_ALGORITHMS_MULTI_LEVEL_ROUTING_HPP
+
+#include "engine/internal_route_result.hpp"
+#include "engine/phantom_node.hpp"
+#include "engine/query_metrics.hpp"
+#include "engine/routing_algorithms/routing_base.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/integer_range.hpp"
+#include "util/multi_level_graph.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+// Bidirectional Dijkstra on the overlay of the multi-level graph between the nodes in the heaps.
+// The forward heap holds the sources with their negative offsets and the reverse heap the targets
+// with their offsets, like the searches on the hierarchy. Every node is expanded on the highest
+// level whose cell contains none of the endpoints, which are all sources and targets.
+//
+// Returns the weight of the shortest path, INVALID_EDGE_WEIGHT if there is none, and appends its
+// base arcs to the path. The head of an arc is its target, source is the node it starts at.
+template <typename HeapT>
+EdgeWeight searchMultiLevelGraph(const util::MultiLevelGraph &graph,
+                                 HeapT &forward_heap,
+                                 HeapT &reverse_heap,
+                                 HeapT &unpacking_heap,
+                                 const std::vector<NodeID> &endpoints,
+                                 NodeID &source,
+                                 std::vector<util::MultiLevelGraph::Arc> &path)
+{
+    const auto &partition = graph.GetPartition();
+    const auto query_level = [&](const NodeID node) {
+        return partition.GetQueryLevel(node, endpoints.begin(), endpoints.end());
+    };
+    const auto any_node = [](const NodeID) { return true; };
+
+    if (forward_heap.Empty() || reverse_heap.Empty())
+    {
+        return INVALID_EDGE_WEIGHT;
+    }
+    // a direction that ran out of nodes still bounds the weights it contributes from below
+    const auto forward_minimum = forward_heap.MinKey();
+    const auto reverse_minimum = reverse_heap.MinKey();
+
+    EdgeWeight weight = INVALID_EDGE_WEIGHT;
+    NodeID middle = SPECIAL_NODEID;
+    const auto step = [&](HeapT &heap, HeapT &other_heap, const bool forward) {
+        const auto node = heap.DeleteMin();
+        const auto node_weight = heap.GetKey(node);
+        if (other_heap.WasInserted(node))
+        {
+            // a negative weight is a target behind the source on the same segment
+            const auto new_weight = node_weight + other_heap.GetKey(node);
+            if (new_weight >= 0 && new_weight < weight)
+            {
+                weight = new_weight;
+                middle = node;
+            }
+        }
+        if (forward)
+        {
+            graph.RelaxNode<true>(heap, node, node_weight, query_level(node), any_node);
+        }
+        else
+        {
+            graph.RelaxNode<false>(heap, node, node_weight, query_level(node), any_node);
+        }
+    };
+
+    while (!forward_heap.Empty() || !reverse_heap.Empty())
+    {
+        const auto forward_bound = forward_heap.Empty() ? forward_minimum : forward_heap.MinKey();
+        const auto reverse_bound = reverse_heap.Empty() ? reverse_minimum : reverse_heap.MinKey();
+        if (weight != INVALID_EDGE_WEIGHT && forward_bound + reverse_bound >= weight)
+        {
+            break;
+        }
+        if (!forward_heap.Empty())
+        {
+            step(forward_heap, reverse_heap, true);
+        }
+        if (!reverse_heap.Empty())
+        {
+            step(reverse_heap, forward_heap, false);
+        }
+    }
+
+    if (middle == SPECIAL_NODEID)
+    {
+        return INVALID_EDGE_WEIGHT;
+    }
+
+    // the nodes the searches started at are their own parents
+    std::vector<std::pair<NodeID, util::MultiLevelHeapData>> forward_steps;
+    NodeID node = middle;
+    for (; forward_heap.GetData(node).parent != node; node = forward_heap.GetData(node).parent)
+    {
+        forward_steps.emplace_back(node, forward_heap.GetData(node));
+    }
+    source = node;
+    for (auto forward_step = forward_steps.rbegin(); forward_step != forward_steps.rend();
+         ++forward_step)
+    {
+        const auto &data = forward_step->second;
+        if (data.arc != SPECIAL_EDGEID)
+        {
+            path.push_back(graph.GetOutArc(data.arc));
+        }
+        else
+        {
+            graph.UnpackCliqueArc(
+                unpacking_heap, data.level, data.parent, forward_step->first, path);
+        }
+    }
+    for (node = middle; reverse_heap.GetData(node).parent != node;
+         node = reverse_heap.GetData(node).parent)
+    {
+        const auto &data = reverse_heap.GetData(node);
+        if (data.arc != SPECIAL_EDGEID)
+        {
+            const auto &arc = graph.GetInArc(data.arc);
+            path.push_back({data.parent, arc.weight, arc.edge_id});
+        }
+        else
+        {
+            graph.UnpackCliqueArc(unpacking_heap, data.level, node, data.parent, path);
+        }
+    }
+
+    return weight;
+}
+
+// Route queries on the multi-level overlay graph of the facade. The legs between waypoints are
+// searched one after the other. If u-turns at the waypoints are not allowed, a leg continues in
+// the direction the previous one arrived in, which does not revisit that choice if it turns out
+// to make the following leg longer.
+template <class DataFacadeT>
+class MultiLevelRouting final
+    : public BasicRoutingInterface<DataFacadeT, MultiLevelRouting<DataFacadeT>>
+{
+    using super = BasicRoutingInterface<DataFacadeT, MultiLevelRouting<DataFacadeT>>;
+    using QueryHeap = SearchEngineData::MultiLevelQueryHeap;
+    using EdgeData = typename DataFacadeT::EdgeData;
+    SearchEngineData &engine_working_data;
+
+  public:
+    MultiLevelRouting(SearchEngineData &engine_working_data)
+        : engine_working_data(engine_working_data)
+    {
+    }
+
+    void operator()(const DataFacadeT &facade,
+                    const std::vector<PhantomNodes> &phantom_nodes_vector,
+                    const boost::optional<bool> continue_straight_at_waypoint,
+                    InternalRouteResult &raw_route_data) const
+    {
+        const auto graph = facade.GetMultiLevelGraph();
+        BOOST_ASSERT(graph);
+        const bool allow_uturn_at_waypoint =
+            !(continue_straight_at_waypoint ? *continue_straight_at_waypoint
+                                            : facade.GetContinueStraightDefault());
+
+        engine_working_data.InitializeOrClearMultiLevelThreadLocalStorage(
+            graph->GetNumberOfNodes());
+        QueryHeap &forward_heap = *(engine_working_data.multi_level_forward_heap);
+        QueryHeap &reverse_heap = *(engine_working_data.multi_level_reverse_heap);
+        QueryHeap &unpacking_heap = *(engine_working_data.multi_level_unpacking_heap);
+
+        raw_route_data.shortest_path_length = 0;
+        raw_route_data.unpacked_path_segments.resize(phantom_nodes_vector.size());
+        std::vector<util::MultiLevelGraph::Arc> path;
+        std::vector<NodeID> endpoints;
+        for (const auto leg : util::irange<std::size_t>(0UL, phantom_nodes_vector.size()))
+        {
+            const auto &phantom_node_pair = phantom_nodes_vector[leg];
+            const auto &source_phantom = phantom_node_pair.source_phantom;
+            const auto &target_phantom = phantom_node_pair.target_phantom;
+            const bool restrict_source = leg > 0 && !allow_uturn_at_waypoint;
+            const bool arrived_in_reverse =
+                restrict_source && raw_route_data.target_traversed_in_reverse.back();
+
+            forward_heap.Clear();
+            reverse_heap.Clear();
+            endpoints.clear();
+            if (source_phantom.forward_segment_id.enabled &&
+                (!restrict_source || !arrived_in_reverse))
+            {
+                forward_heap.Insert(source_phantom.forward_segment_id.id,
+                                    -source_phantom.GetForwardWeightPlusOffset(),
+                                    {source_phantom.forward_segment_id.id, SPECIAL_EDGEID, 0});
+                endpoints.push_back(source_phantom.forward_segment_id.id);
+            }
+            if (source_phantom.reverse_segment_id.enabled &&
+                (!restrict_source || arrived_in_reverse))
+            {
+                forward_heap.Insert(source_phantom.reverse_segment_id.id,
+                                    -source_phantom.GetReverseWeightPlusOffset(),
+                                    {source_phantom.reverse_segment_id.id, SPECIAL_EDGEID, 0});
+                endpoints.push_back(source_phantom.reverse_segment_id.id);
+            }
+            if (target_phantom.forward_segment_id.enabled)
+            {
+                reverse_heap.Insert(target_phantom.forward_segment_id.id,
+                                    target_phantom.GetForwardWeightPlusOffset(),
+                                    {target_phantom.forward_segment_id.id, SPECIAL_EDGEID, 0});
+                endpoints.push_back(target_phantom.forward_segment_id.id);
+            }
+            if (target_phantom.reverse_segment_id.enabled)
+            {
+                reverse_heap.Insert(target_phantom.reverse_segment_id.id,
+                                    target_phantom.GetReverseWeightPlusOffset(),
+                                    {target_phantom.reverse_segment_id.id, SPECIAL_EDGEID, 0});
+                endpoints.push_back(target_phantom.reverse_segment_id.id);
+            }
+
+            path.clear();
+            NodeID source = SPECIAL_NODEID;
+            const auto weight = searchMultiLevelGraph(
+                *graph, forward_heap, reverse_heap, unpacking_heap, endpoints, source, path);
+            if (weight == INVALID_EDGE_WEIGHT)
+            {
+                raw_route_data.shortest_path_length = INVALID_EDGE_WEIGHT;
+                raw_route_data.alternative_path_length = INVALID_EDGE_WEIGHT;
+                raw_route_data.unpacked_path_segments.clear();
+                raw_route_data.source_traversed_in_reverse.clear();
+                raw_route_data.target_traversed_in_reverse.clear();
+                return;
+            }
+
+            const auto target = path.empty() ? source : path.back().head;
+            const bool start_traversed_in_reverse =
+                source != source_phantom.forward_segment_id.id;
+            const bool target_traversed_in_reverse =
+                target != target_phantom.forward_segment_id.id;
+            raw_route_data.shortest_path_length += weight;
+            raw_route_data.source_traversed_in_reverse.push_back(start_traversed_in_reverse);
+            raw_route_data.target_traversed_in_reverse.push_back(target_traversed_in_reverse);
+            UnpackLeg(facade,
+                      path,
+                      start_traversed_in_reverse,
+                      target_traversed_in_reverse,
+                      phantom_node_pair,
+                      raw_route_data.unpacked_path_segments[leg]);
+        }
+    }
+
+  private:
+    void UnpackLeg(const DataFacadeT &facade,
+                   const std::vector<util::MultiLevelGraph::Arc> &path,
+                   const bool start_traversed_in_reverse,
+                   const bool target_traversed_in_reverse,
+                   const PhantomNodes &phantom_node_pair,
+                   std::vector<PathData> &unpacked_path) const
+    {
+        const auto unpack_start = std::chrono::steady_clock::now();
+
+        // the geometry of the path is expanded from edges of the hierarchy
+        static thread_local std::vector<EdgeData> edges;
+        static thread_local std::vector<const EdgeData *> original_edges;
+        edges.resize(path.size());
+        original_edges.clear();
+        for (const auto index : util::irange<std::size_t>(0UL, path.size()))
+        {
+            edges[index].id = path[index].edge_id;
+            edges[index].weight = path[index].weight;
+            original_edges.push_back(&edges[index]);
+        }
+        super::UnpackOriginalEdges(facade,
+                                   original_edges,
+                                   start_traversed_in_reverse,
+                                   target_traversed_in_reverse,
+                                   phantom_node_pair,
+                                   unpacked_path);
+
+        GetQueryProfile().unpacking += std::chrono::steady_clock::now() - unpack_start;
+    }
+};
+}
+}
+}
+
+#endif // OSRM_ENGINE_ROUTING_ALGORITHMS_MULTI_LEVEL_ROUTING_HPP
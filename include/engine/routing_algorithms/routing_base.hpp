@@ -4,20 +4,36 @@
 #include "extractor/guidance/turn_instruction.hpp"
 #include "engine/edge_unpacker.hpp"
 #include "engine/internal_route_result.hpp"
+#include "engine/query_metrics.hpp"
 #include "engine/search_engine_data.hpp"
+#include "engine/routing_algorithms/core_landmark_potential.hpp"
+#include "engine/search_statistics.hpp"
+#include "util/array_view.hpp"
 #include "util/coordinate_calculation.hpp"
+#include "util/geometry_node_list.hpp"
 #include "util/guidance/turn_bearing.hpp"
+#include "util/integer_range.hpp"
+#include "util/probes.hpp"
+#include "util/segment_weight_list.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/assert.hpp>
 
+#include <tbb/concurrent_unordered_map.h>
+#include <tbb/parallel_invoke.h>
+#include <tbb/task_arena.h>
+
 #include <cstddef>
 #include <cstdint>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iterator>
+#include <limits>
+#include <mutex>
 #include <numeric>
-#include <stack>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -33,6 +49,8 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
 {
   private:
     using EdgeData = typename DataFacadeT::EdgeData;
+    // core node, weight and parent of the nodes where the searches enter the core
+    using CoreEntryPoint = std::tuple<NodeID, EdgeWeight, NodeID>;
 
   public:
     /*
@@ -77,7 +95,50 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
     {
         const NodeID node = forward_heap.DeleteMin();
         const std::int32_t weight = forward_heap.GetKey(node);
+        OSRM_COUNT_SEARCH(settled_nodes, 1);
+
+        MeetAtNode(facade,
+                   forward_heap,
+                   reverse_heap,
+                   node,
+                   weight,
+                   middle_node_id,
+                   upper_bound,
+                   forward_direction,
+                   force_loop_forward,
+                   force_loop_reverse);
+
+        // make sure we don't terminate too early if we initialize the weight
+        // for the nodes in the forward heap with the forward/reverse offset
+        BOOST_ASSERT(min_edge_offset <= 0);
+        if (weight + min_edge_offset > upper_bound)
+        {
+            forward_heap.DeleteAll();
+            return;
+        }
 
+        // Stalling
+        if (stalling && StallAtNode(facade, forward_heap, node, weight, forward_direction))
+        {
+            return;
+        }
+
+        RelaxOutgoingEdges(facade, forward_heap, node, weight, forward_direction);
+    }
+
+    // Updates the upper bound with the path over a node settled in forward_heap, if the search
+    // in the opposite direction has reached it.
+    void MeetAtNode(const DataFacadeT &facade,
+                    SearchEngineData::QueryHeap &forward_heap,
+                    SearchEngineData::QueryHeap &reverse_heap,
+                    const NodeID node,
+                    const std::int32_t weight,
+                    NodeID &middle_node_id,
+                    std::int32_t &upper_bound,
+                    const bool forward_direction,
+                    const bool force_loop_forward,
+                    const bool force_loop_reverse) const
+    {
         if (reverse_heap.WasInserted(node))
         {
             const std::int32_t new_weight = reverse_heap.GetKey(node) + weight;
@@ -91,14 +152,15 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                     new_weight < 0)
                 {
                     // check whether there is a loop present at the node
-                    for (const auto edge : facade.GetAdjacentEdgeRange(node))
+                    for (const auto edge : forward_direction ? facade.GetForwardEdgeRange(node)
+                                                             : facade.GetBackwardEdgeRange(node))
                     {
-                        const EdgeData &data = facade.GetEdgeData(edge);
+                        const auto &data = facade.GetHotEdgeData(edge);
                         bool forward_directionFlag =
                             (forward_direction ? data.forward : data.backward);
                         if (forward_directionFlag)
                         {
-                            const NodeID to = facade.GetTarget(edge);
+                            const NodeID to = data.target;
                             if (to == node)
                             {
                                 const EdgeWeight edge_weight = data.weight;
@@ -121,49 +183,24 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                 }
             }
         }
+    }
 
-        // make sure we don't terminate too early if we initialize the weight
-        // for the nodes in the forward heap with the forward/reverse offset
-        BOOST_ASSERT(min_edge_offset <= 0);
-        if (weight + min_edge_offset > upper_bound)
-        {
-            forward_heap.DeleteAll();
-            return;
-        }
-
-        // Stalling
-        if (stalling)
-        {
-            for (const auto edge : facade.GetAdjacentEdgeRange(node))
-            {
-                const EdgeData &data = facade.GetEdgeData(edge);
-                const bool reverse_flag = ((!forward_direction) ? data.forward : data.backward);
-                if (reverse_flag)
-                {
-                    const NodeID to = facade.GetTarget(edge);
-                    const EdgeWeight edge_weight = data.weight;
-
-                    BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
-
-                    if (forward_heap.WasInserted(to))
-                    {
-                        if (forward_heap.GetKey(to) + edge_weight < weight)
-                        {
-                            return;
-                        }
-                    }
-                }
-            }
-        }
-
-        for (const auto edge : facade.GetAdjacentEdgeRange(node))
+    void RelaxOutgoingEdges(const DataFacadeT &facade,
+                            SearchEngineData::QueryHeap &forward_heap,
+                            const NodeID node,
+                            const std::int32_t weight,
+                            const bool forward_direction) const
+    {
+        for (const auto edge : forward_direction ? facade.GetForwardEdgeRange(node)
+                                                 : facade.GetBackwardEdgeRange(node))
         {
-            const EdgeData &data = facade.GetEdgeData(edge);
+            const auto &data = facade.GetHotEdgeData(edge);
             bool forward_directionFlag = (forward_direction ? data.forward : data.backward);
             if (forward_directionFlag)
             {
-                const NodeID to = facade.GetTarget(edge);
+                const NodeID to = data.target;
                 const EdgeWeight edge_weight = data.weight;
+                OSRM_COUNT_SEARCH(relaxed_edges, 1);
 
                 BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
                 const int to_weight = weight + edge_weight;
@@ -172,27 +209,105 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                 if (!forward_heap.WasInserted(to))
                 {
                     forward_heap.Insert(to, to_weight, node);
+                    OSRM_COUNT_SEARCH(heap_inserts, 1);
                 }
                 // Found a shorter Path -> Update weight
                 else if (to_weight < forward_heap.GetKey(to))
                 {
                     // new parent
-                    forward_heap.GetData(to).parent = node;
+                    forward_heap.GetData(to) = {node};
                     forward_heap.DecreaseKey(to, to_weight);
+                    OSRM_COUNT_SEARCH(heap_decrease_keys, 1);
                 }
             }
         }
     }
 
+    // Stall-on-demand: a settled node that can be reached with a smaller weight over an edge from
+    // a higher node is not on a shortest up-down path with its weight and is not expanded. The
+    // smaller weight is propagated to the nodes in the heap that it reaches, the ones whose keys
+    // are larger are marked as stalled and are not expanded either once they are settled.
+    // Returns true if the node is stalled.
+    template <typename HeapT>
+    bool StallAtNode(const DataFacadeT &facade,
+                     HeapT &heap,
+                     const NodeID node,
+                     const EdgeWeight weight,
+                     const bool forward_direction) const
+    {
+        if (heap.GetData(node).stalled)
+        {
+            OSRM_COUNT_SEARCH(stalled_nodes, 1);
+            return true;
+        }
+
+        EdgeWeight stall_weight = weight;
+        for (const auto edge : forward_direction ? facade.GetBackwardEdgeRange(node)
+                                                 : facade.GetForwardEdgeRange(node))
+        {
+            const auto &data = facade.GetHotEdgeData(edge);
+            const bool reverse_flag = ((!forward_direction) ? data.forward : data.backward);
+            if (reverse_flag)
+            {
+                const NodeID to = data.target;
+                const EdgeWeight edge_weight = data.weight;
+
+                BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
+
+                if (heap.WasInserted(to))
+                {
+                    stall_weight = std::min(stall_weight, heap.GetKey(to) + edge_weight);
+                }
+            }
+        }
+        if (stall_weight == weight)
+        {
+            return false;
+        }
+
+        // the stack is reused by all queries of a thread
+        static thread_local std::vector<std::pair<NodeID, EdgeWeight>> stalled_nodes;
+        stalled_nodes.clear();
+        stalled_nodes.emplace_back(node, stall_weight);
+        while (!stalled_nodes.empty())
+        {
+            const auto stalled_node = stalled_nodes.back();
+            stalled_nodes.pop_back();
+
+            for (const auto edge : forward_direction
+                                       ? facade.GetForwardEdgeRange(stalled_node.first)
+                                       : facade.GetBackwardEdgeRange(stalled_node.first))
+            {
+                const auto &data = facade.GetHotEdgeData(edge);
+                const bool forward_flag = (forward_direction ? data.forward : data.backward);
+                if (forward_flag)
+                {
+                    const NodeID to = data.target;
+                    const EdgeWeight to_weight = stalled_node.second + data.weight;
+                    // the sources of the search keep their phantom offsets for forced loops
+                    if (heap.WasInserted(to) && !heap.WasRemoved(to) &&
+                        !heap.GetData(to).stalled && heap.GetData(to).parent != to &&
+                        to_weight < heap.GetKey(to))
+                    {
+                        heap.GetData(to).stalled = true;
+                        stalled_nodes.emplace_back(to, to_weight);
+                    }
+                }
+            }
+        }
+        OSRM_COUNT_SEARCH(stalled_nodes, 1);
+        return true;
+    }
+
     inline EdgeWeight GetLoopWeight(const DataFacadeT &facade, NodeID node) const
     {
         EdgeWeight loop_weight = INVALID_EDGE_WEIGHT;
-        for (auto edge : facade.GetAdjacentEdgeRange(node))
+        for (auto edge : facade.GetForwardEdgeRange(node))
         {
-            const auto &data = facade.GetEdgeData(edge);
+            const auto &data = facade.GetHotEdgeData(edge);
             if (data.forward)
             {
-                const NodeID to = facade.GetTarget(edge);
+                const NodeID to = data.target;
                 if (to == node)
                 {
                     loop_weight = std::min(loop_weight, data.weight);
@@ -202,6 +317,23 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         return loop_weight;
     }
 
+    // Length of the u-turn at a node that GetLoopWeight finds
+    inline EdgeDistance GetLoopDistance(const DataFacadeT &facade, NodeID node) const
+    {
+        EdgeWeight loop_weight = INVALID_EDGE_WEIGHT;
+        EdgeDistance loop_distance = INVALID_EDGE_DISTANCE;
+        for (auto edge : facade.GetForwardEdgeRange(node))
+        {
+            const auto &data = facade.GetEdgeData(edge);
+            if (data.forward && facade.GetTarget(edge) == node && data.weight < loop_weight)
+            {
+                loop_weight = data.weight;
+                loop_distance = data.distance;
+            }
+        }
+        return loop_distance;
+    }
+
     template <typename RandomIter>
     void UnpackPath(const DataFacadeT &facade,
                     RandomIter packed_path_begin,
@@ -210,6 +342,8 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                     std::vector<PathData> &unpacked_path) const
     {
         BOOST_ASSERT(std::distance(packed_path_begin, packed_path_end) > 0);
+        const auto unpack_start = std::chrono::steady_clock::now();
+        OSRM_PROBE(unpack__start);
 
         const bool start_traversed_in_reverse =
             (*packed_path_begin != phantom_node_pair.source_phantom.forward_segment_id.id);
@@ -222,92 +356,130 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             *std::prev(packed_path_end) == phantom_node_pair.target_phantom.forward_segment_id.id ||
             *std::prev(packed_path_end) == phantom_node_pair.target_phantom.reverse_segment_id.id);
 
-        UnpackCHPath(
-            facade,
-            packed_path_begin,
-            packed_path_end,
-            [this,
-             &facade,
-             &unpacked_path,
-             &phantom_node_pair,
-             &start_traversed_in_reverse,
-             &target_traversed_in_reverse](std::pair<NodeID, NodeID> & /* edge */,
-                                           const EdgeData &edge_data) {
-
-                BOOST_ASSERT_MSG(!edge_data.shortcut, "original edge flagged as shortcut");
-                const auto name_index = facade.GetNameIndexFromEdgeID(edge_data.id);
-                const auto turn_instruction = facade.GetTurnInstructionForEdgeID(edge_data.id);
-                const extractor::TravelMode travel_mode =
-                    (unpacked_path.empty() && start_traversed_in_reverse)
-                        ? phantom_node_pair.source_phantom.backward_travel_mode
-                        : facade.GetTravelModeForEdgeID(edge_data.id);
-
-                const auto geometry_index = facade.GetGeometryIndexForEdgeID(edge_data.id);
-                std::vector<NodeID> id_vector;
-                std::vector<EdgeWeight> weight_vector;
-                std::vector<DatasourceID> datasource_vector;
-                if (geometry_index.forward)
-                {
-                    id_vector = facade.GetUncompressedForwardGeometry(geometry_index.id);
-                    weight_vector = facade.GetUncompressedForwardWeights(geometry_index.id);
-                    datasource_vector = facade.GetUncompressedForwardDatasources(geometry_index.id);
-                }
-                else
-                {
-                    id_vector = facade.GetUncompressedReverseGeometry(geometry_index.id);
-                    weight_vector = facade.GetUncompressedReverseWeights(geometry_index.id);
-                    datasource_vector = facade.GetUncompressedReverseDatasources(geometry_index.id);
-                }
-                BOOST_ASSERT(id_vector.size() > 0);
-                BOOST_ASSERT(weight_vector.size() > 0);
-                BOOST_ASSERT(datasource_vector.size() > 0);
-
-                const auto total_weight =
-                    std::accumulate(weight_vector.begin(), weight_vector.end(), 0);
-
-                BOOST_ASSERT(weight_vector.size() == id_vector.size() - 1);
-                const bool is_first_segment = unpacked_path.empty();
-
-                const std::size_t start_index =
-                    (is_first_segment
-                         ? ((start_traversed_in_reverse)
-                                ? weight_vector.size() -
-                                      phantom_node_pair.source_phantom.fwd_segment_position - 1
-                                : phantom_node_pair.source_phantom.fwd_segment_position)
-                         : 0);
-                const std::size_t end_index = weight_vector.size();
-
-                BOOST_ASSERT(start_index >= 0);
-                BOOST_ASSERT(start_index < end_index);
-                for (std::size_t segment_idx = start_index; segment_idx < end_index; ++segment_idx)
-                {
-                    unpacked_path.push_back(
-                        PathData{id_vector[segment_idx + 1],
-                                 name_index,
-                                 weight_vector[segment_idx],
-                                 extractor::guidance::TurnInstruction::NO_TURN(),
-                                 {{0, INVALID_LANEID}, INVALID_LANE_DESCRIPTIONID},
-                                 travel_mode,
-                                 INVALID_ENTRY_CLASSID,
-                                 datasource_vector[segment_idx],
-                                 util::guidance::TurnBearing(0),
-                                 util::guidance::TurnBearing(0)});
-                }
-                BOOST_ASSERT(unpacked_path.size() > 0);
-                if (facade.hasLaneData(edge_data.id))
-                    unpacked_path.back().lane_data = facade.GetLaneData(edge_data.id);
-
-                unpacked_path.back().entry_classid = facade.GetEntryClassID(edge_data.id);
-                unpacked_path.back().turn_instruction = turn_instruction;
-                unpacked_path.back().duration_until_turn += (edge_data.weight - total_weight);
-                unpacked_path.back().pre_turn_bearing = facade.PreTurnBearing(edge_data.id);
-                unpacked_path.back().post_turn_bearing = facade.PostTurnBearing(edge_data.id);
-            });
+        // Unpack the shortcuts first, the geometry sizes of the original edges bound the length
+        // of the path so it is allocated once instead of growing along long routes. The buffer
+        // is reused by all queries of a thread.
+        static thread_local std::vector<const EdgeData *> original_edges;
+        original_edges.clear();
+        std::size_t number_of_segments = 0;
+        UnpackCHPath(facade,
+                     packed_path_begin,
+                     packed_path_end,
+                     [&facade, &number_of_segments](std::pair<NodeID, NodeID> & /* edge */,
+                                                    const EdgeData &edge_data) {
+                         const auto geometry_index =
+                             facade.GetGeometryIndexForEdgeID(edge_data.id);
+                         number_of_segments +=
+                             facade.GetUncompressedForwardWeights(geometry_index.id).size();
+                         original_edges.push_back(&edge_data);
+                     });
+        OSRM_COUNT_SEARCH(unpacked_edges, original_edges.size());
+        number_of_segments += facade
+                                  .GetUncompressedForwardWeights(
+                                      phantom_node_pair.target_phantom.packed_geometry_id)
+                                  .size();
+        unpacked_path.reserve(unpacked_path.size() + number_of_segments);
+
+        UnpackOriginalEdges(facade,
+                            original_edges,
+                            start_traversed_in_reverse,
+                            target_traversed_in_reverse,
+                            phantom_node_pair,
+                            unpacked_path);
+
+        GetQueryProfile().unpacking += std::chrono::steady_clock::now() - unpack_start;
+        OSRM_PROBE1(unpack__done, unpacked_path.size());
+    }
+
+    // Expands the original edges of the path between the phantom nodes of a leg into the
+    // segments of their geometries, followed by the segments up to the target phantom node
+    void UnpackOriginalEdges(const DataFacadeT &facade,
+                             const std::vector<const EdgeData *> &original_edges,
+                             const bool start_traversed_in_reverse,
+                             const bool target_traversed_in_reverse,
+                             const PhantomNodes &phantom_node_pair,
+                             std::vector<PathData> &unpacked_path) const
+    {
+        for (const EdgeData *original_edge : original_edges)
+        {
+            const EdgeData &edge_data = *original_edge;
+            BOOST_ASSERT_MSG(!edge_data.shortcut, "original edge flagged as shortcut");
+            const auto name_index = facade.GetNameIndexFromEdgeID(edge_data.id);
+            const auto turn_instruction = facade.GetTurnInstructionForEdgeID(edge_data.id);
+            const extractor::TravelMode travel_mode =
+                (unpacked_path.empty() && start_traversed_in_reverse)
+                    ? phantom_node_pair.source_phantom.backward_travel_mode
+                    : facade.GetTravelModeForEdgeID(edge_data.id);
+
+            const auto geometry_index = facade.GetGeometryIndexForEdgeID(edge_data.id);
+            util::GeometryNodeView id_vector;
+            util::SegmentWeightView weight_vector;
+            util::ArrayView<DatasourceID> datasource_vector;
+            if (geometry_index.forward)
+            {
+                id_vector = facade.GetUncompressedForwardGeometry(geometry_index.id);
+                weight_vector = facade.GetUncompressedForwardWeights(geometry_index.id);
+                datasource_vector = facade.GetUncompressedForwardDatasources(geometry_index.id);
+            }
+            else
+            {
+                id_vector = facade.GetUncompressedReverseGeometry(geometry_index.id);
+                weight_vector = facade.GetUncompressedReverseWeights(geometry_index.id);
+                datasource_vector = facade.GetUncompressedReverseDatasources(geometry_index.id);
+            }
+            BOOST_ASSERT(id_vector.size() > 0);
+            BOOST_ASSERT(weight_vector.size() > 0);
+            BOOST_ASSERT(datasource_vector.size() > 0);
+
+            const auto total_weight =
+                std::accumulate(weight_vector.begin(), weight_vector.end(), 0);
+
+            BOOST_ASSERT(weight_vector.size() == id_vector.size() - 1);
+            const bool is_first_segment = unpacked_path.empty();
+
+            const std::size_t start_index =
+                (is_first_segment
+                     ? ((start_traversed_in_reverse)
+                            ? weight_vector.size() -
+                                  phantom_node_pair.source_phantom.fwd_segment_position - 1
+                            : phantom_node_pair.source_phantom.fwd_segment_position)
+                     : 0);
+            const std::size_t end_index = weight_vector.size();
+
+            BOOST_ASSERT(start_index >= 0);
+            BOOST_ASSERT(start_index < end_index);
+            // the nodes are decoded one after the other instead of sought one by one
+            auto node = id_vector.begin() + start_index;
+            for (std::size_t segment_idx = start_index; segment_idx < end_index; ++segment_idx)
+            {
+                ++node;
+                unpacked_path.push_back(
+                    PathData{*node,
+                             name_index,
+                             weight_vector[segment_idx],
+                             extractor::guidance::TurnInstruction::NO_TURN(),
+                             {{0, INVALID_LANEID}, INVALID_LANE_DESCRIPTIONID},
+                             travel_mode,
+                             INVALID_ENTRY_CLASSID,
+                             datasource_vector[segment_idx],
+                             util::guidance::TurnBearing(0),
+                             util::guidance::TurnBearing(0)});
+            }
+            BOOST_ASSERT(unpacked_path.size() > 0);
+            if (facade.hasLaneData(edge_data.id))
+                unpacked_path.back().lane_data = facade.GetLaneData(edge_data.id);
+
+            unpacked_path.back().entry_classid = facade.GetEntryClassID(edge_data.id);
+            unpacked_path.back().turn_instruction = turn_instruction;
+            unpacked_path.back().duration_until_turn += (edge_data.weight - total_weight);
+            unpacked_path.back().pre_turn_bearing = facade.PreTurnBearing(edge_data.id);
+            unpacked_path.back().post_turn_bearing = facade.PostTurnBearing(edge_data.id);
+        }
 
         std::size_t start_index = 0, end_index = 0;
-        std::vector<unsigned> id_vector;
-        std::vector<EdgeWeight> weight_vector;
-        std::vector<DatasourceID> datasource_vector;
+        util::GeometryNodeView id_vector;
+        util::SegmentWeightView weight_vector;
+        util::ArrayView<DatasourceID> datasource_vector;
         const bool is_local_path = (phantom_node_pair.source_phantom.packed_geometry_id ==
                                     phantom_node_pair.target_phantom.packed_geometry_id) &&
                                    unpacked_path.empty();
@@ -356,13 +528,18 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         // t: fwd_segment 3
         // -> (U, v), (v, w), (w, x)
         // note that (x, t) is _not_ included but needs to be added later.
+        auto node = id_vector.begin() + start_index;
         for (std::size_t segment_idx = start_index; segment_idx != end_index;
              (start_index < end_index ? ++segment_idx : --segment_idx))
         {
             BOOST_ASSERT(segment_idx < id_vector.size() - 1);
             BOOST_ASSERT(phantom_node_pair.target_phantom.forward_travel_mode > 0);
+            if (start_index < end_index)
+                ++node;
+            else
+                --node;
             unpacked_path.push_back(PathData{
-                id_vector[start_index < end_index ? segment_idx + 1 : segment_idx - 1],
+                *node,
                 phantom_node_pair.target_phantom.name_id,
                 weight_vector[segment_idx],
                 extractor::guidance::TurnInstruction::NO_TURN(),
@@ -488,6 +665,7 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                 const bool force_loop_reverse,
                 const int duration_upper_bound = INVALID_EDGE_WEIGHT) const
     {
+        OSRM_PROBE(search__start);
         NodeID middle = SPECIAL_NODEID;
         weight = duration_upper_bound;
 
@@ -529,6 +707,8 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             }
         }
 
+        OSRM_PROBE1(search__done, weight);
+
         // No path found for both target nodes?
         if (duration_upper_bound <= weight || SPECIAL_NODEID == middle)
         {
@@ -562,6 +742,8 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
     // && source_phantom.GetForwardWeightPlusOffset() > target_phantom.GetForwardWeightPlusOffset())
     // requires
     // a force loop, if the heaps have been initialized with positive offsets.
+    // Without core landmarks the core can be searched in both directions at once on two threads,
+    // unless loops are forced.
     void SearchWithCore(const DataFacadeT &facade,
                         SearchEngineData::QueryHeap &forward_heap,
                         SearchEngineData::QueryHeap &reverse_heap,
@@ -571,12 +753,13 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                         std::vector<NodeID> &packed_leg,
                         const bool force_loop_forward,
                         const bool force_loop_reverse,
-                        int duration_upper_bound = INVALID_EDGE_WEIGHT) const
+                        int duration_upper_bound = INVALID_EDGE_WEIGHT,
+                        const bool search_core_in_parallel = false) const
     {
+        OSRM_PROBE(search__start);
         NodeID middle = SPECIAL_NODEID;
         weight = duration_upper_bound;
 
-        using CoreEntryPoint = std::tuple<NodeID, EdgeWeight, NodeID>;
         std::vector<CoreEntryPoint> forward_entry_points;
         std::vector<CoreEntryPoint> reverse_entry_points;
 
@@ -595,6 +778,7 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                 {
                     const NodeID node = forward_heap.DeleteMin();
                     const int key = forward_heap.GetKey(node);
+                    OSRM_COUNT_SEARCH(settled_nodes, 1);
                     forward_entry_points.emplace_back(node, key, forward_heap.GetData(node).parent);
                 }
                 else
@@ -617,6 +801,7 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                 {
                     const NodeID node = reverse_heap.DeleteMin();
                     const int key = reverse_heap.GetKey(node);
+                    OSRM_COUNT_SEARCH(settled_nodes, 1);
                     reverse_entry_points.emplace_back(node, key, reverse_heap.GetData(node).parent);
                 }
                 else
@@ -645,58 +830,115 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             core_heap.Insert(id, weight, parent);
         };
 
-        forward_core_heap.Clear();
-        for (const auto &p : forward_entry_points)
-        {
-            insertInCoreHeap(p, forward_core_heap);
-        }
-
         reverse_core_heap.Clear();
         for (const auto &p : reverse_entry_points)
         {
             insertInCoreHeap(p, reverse_core_heap);
         }
 
-        // get offset to account for offsets on phantom nodes on compressed edges
-        int min_core_edge_offset = 0;
-        if (forward_core_heap.Size() > 0)
+        forward_core_heap.Clear();
+        // With core landmarks the core is searched by A* towards the reverse entry points and the
+        // keys of forward_core_heap include the potentials of the nodes
+        EdgeWeight middle_potential = 0;
+        if (facade.GetNumberOfCoreLandmarks() > 0 && !forward_entry_points.empty() &&
+            !reverse_entry_points.empty())
         {
-            min_core_edge_offset = std::min(min_core_edge_offset, forward_core_heap.MinKey());
+            std::vector<std::pair<NodeID, EdgeWeight>> core_targets;
+            core_targets.reserve(reverse_entry_points.size());
+            for (const auto &p : reverse_entry_points)
+            {
+                core_targets.emplace_back(std::get<0>(p), std::get<1>(p));
+            }
+            const CoreLandmarkPotential<DataFacadeT> potential(facade, core_targets);
+
+            for (const auto &p : forward_entry_points)
+            {
+                const auto node_potential = potential(std::get<0>(p));
+                if (node_potential != INVALID_EDGE_WEIGHT)
+                {
+                    forward_core_heap.Insert(
+                        std::get<0>(p), std::get<1>(p) + node_potential, std::get<2>(p));
+                }
+            }
+
+            SearchCoreWithPotential(facade,
+                                    forward_core_heap,
+                                    reverse_core_heap,
+                                    potential,
+                                    middle,
+                                    weight,
+                                    force_loop_forward,
+                                    force_loop_reverse);
+            if (SPECIAL_NODEID != middle && facade.IsCoreNode(middle))
+            {
+                middle_potential = potential(middle);
+            }
         }
-        if (reverse_core_heap.Size() > 0 && reverse_core_heap.MinKey() < 0)
+        else
         {
-            min_core_edge_offset = std::min(min_core_edge_offset, reverse_core_heap.MinKey());
-        }
-        BOOST_ASSERT(min_core_edge_offset <= 0);
+            for (const auto &p : forward_entry_points)
+            {
+                insertInCoreHeap(p, forward_core_heap);
+            }
 
-        // run two-target Dijkstra routing step on core with termination criterion
-        const constexpr bool STALLING_DISABLED = false;
-        while (0 < forward_core_heap.Size() && 0 < reverse_core_heap.Size() &&
-               weight > (forward_core_heap.MinKey() + reverse_core_heap.MinKey()))
-        {
-            RoutingStep(facade,
-                        forward_core_heap,
-                        reverse_core_heap,
-                        middle,
-                        weight,
-                        min_core_edge_offset,
-                        true,
-                        STALLING_DISABLED,
-                        force_loop_forward,
-                        force_loop_reverse);
+            if (search_core_in_parallel && !force_loop_forward && !force_loop_reverse)
+            {
+                SearchCoreInParallel(facade,
+                                     forward_core_heap,
+                                     reverse_core_heap,
+                                     forward_entry_points,
+                                     reverse_entry_points,
+                                     middle,
+                                     weight);
+            }
+            else
+            {
+                // get offset to account for offsets on phantom nodes on compressed edges
+                int min_core_edge_offset = 0;
+                if (forward_core_heap.Size() > 0)
+                {
+                    min_core_edge_offset =
+                        std::min(min_core_edge_offset, forward_core_heap.MinKey());
+                }
+                if (reverse_core_heap.Size() > 0 && reverse_core_heap.MinKey() < 0)
+                {
+                    min_core_edge_offset =
+                        std::min(min_core_edge_offset, reverse_core_heap.MinKey());
+                }
+                BOOST_ASSERT(min_core_edge_offset <= 0);
 
-            RoutingStep(facade,
-                        reverse_core_heap,
-                        forward_core_heap,
-                        middle,
-                        weight,
-                        min_core_edge_offset,
-                        false,
-                        STALLING_DISABLED,
-                        force_loop_reverse,
-                        force_loop_forward);
+                // run two-target Dijkstra routing step on core with termination criterion
+                const constexpr bool STALLING_DISABLED = false;
+                while (0 < forward_core_heap.Size() && 0 < reverse_core_heap.Size() &&
+                       weight > (forward_core_heap.MinKey() + reverse_core_heap.MinKey()))
+                {
+                    RoutingStep(facade,
+                                forward_core_heap,
+                                reverse_core_heap,
+                                middle,
+                                weight,
+                                min_core_edge_offset,
+                                true,
+                                STALLING_DISABLED,
+                                force_loop_forward,
+                                force_loop_reverse);
+
+                    RoutingStep(facade,
+                                reverse_core_heap,
+                                forward_core_heap,
+                                middle,
+                                weight,
+                                min_core_edge_offset,
+                                false,
+                                STALLING_DISABLED,
+                                force_loop_reverse,
+                                force_loop_forward);
+                }
+            }
         }
 
+        OSRM_PROBE1(search__done, weight);
+
         // No path found for both target nodes?
         if (duration_upper_bound <= weight || SPECIAL_NODEID == middle)
         {
@@ -711,7 +953,8 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         // we need to unpack sub path from core heaps
         if (facade.IsCoreNode(middle))
         {
-            if (weight != forward_core_heap.GetKey(middle) + reverse_core_heap.GetKey(middle))
+            if (weight != forward_core_heap.GetKey(middle) - middle_potential +
+                              reverse_core_heap.GetKey(middle))
             {
                 // self loop
                 BOOST_ASSERT(forward_core_heap.GetData(middle).parent == middle &&
@@ -748,6 +991,234 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         }
     }
 
+    // A* search from the forward entry points of the core towards its reverse entry points, which
+    // only serve as targets. The keys of forward_core_heap are the weights of the nodes plus their
+    // potentials, the search stops once the smallest key bounds all paths over the nodes in the
+    // heap from below by the weight of the best path.
+    template <typename PotentialT>
+    void SearchCoreWithPotential(const DataFacadeT &facade,
+                                 SearchEngineData::QueryHeap &forward_core_heap,
+                                 SearchEngineData::QueryHeap &reverse_core_heap,
+                                 const PotentialT &potential,
+                                 NodeID &middle_node_id,
+                                 std::int32_t &upper_bound,
+                                 const bool force_loop_forward,
+                                 const bool force_loop_reverse) const
+    {
+        while (!forward_core_heap.Empty() && forward_core_heap.MinKey() < upper_bound)
+        {
+            const NodeID node = forward_core_heap.DeleteMin();
+            const std::int32_t weight = forward_core_heap.GetKey(node) - potential(node);
+            OSRM_COUNT_SEARCH(settled_nodes, 1);
+
+            MeetAtNode(facade,
+                       forward_core_heap,
+                       reverse_core_heap,
+                       node,
+                       weight,
+                       middle_node_id,
+                       upper_bound,
+                       true,
+                       force_loop_forward,
+                       force_loop_reverse);
+
+            for (const auto edge : facade.GetForwardEdgeRange(node))
+            {
+                const auto &data = facade.GetHotEdgeData(edge);
+                if (!data.forward)
+                {
+                    continue;
+                }
+                const NodeID to = data.target;
+                const auto to_potential = potential(to);
+                if (to_potential == INVALID_EDGE_WEIGHT)
+                {
+                    // the node does not reach the targets
+                    continue;
+                }
+                OSRM_COUNT_SEARCH(relaxed_edges, 1);
+
+                BOOST_ASSERT_MSG(data.weight > 0, "edge_weight invalid");
+                const std::int32_t to_key = weight + data.weight + to_potential;
+                if (!forward_core_heap.WasInserted(to))
+                {
+                    forward_core_heap.Insert(to, to_key, node);
+                    OSRM_COUNT_SEARCH(heap_inserts, 1);
+                }
+                else if (to_key < forward_core_heap.GetKey(to))
+                {
+                    forward_core_heap.GetData(to) = {node};
+                    forward_core_heap.DecreaseKey(to, to_key);
+                    OSRM_COUNT_SEARCH(heap_decrease_keys, 1);
+                }
+            }
+        }
+    }
+
+    // Bidirectional search of the core with the forward and the reverse search on a thread each.
+    // Every search only touches its own heap and publishes the weights of the nodes it reaches,
+    // which the other search reads. Both publish a weight before they read the one of the other
+    // search, so of two searches reaching a node the later one sees the weight of the earlier and
+    // the path over the node. A search stops once its smallest key plus the one published by the
+    // other search is no smaller than the best path. Loops at the middle node are not searched
+    // for, the searches are only run in parallel if none are forced.
+    void SearchCoreInParallel(const DataFacadeT &facade,
+                              SearchEngineData::QueryHeap &forward_core_heap,
+                              SearchEngineData::QueryHeap &reverse_core_heap,
+                              const std::vector<CoreEntryPoint> &forward_entry_points,
+                              const std::vector<CoreEntryPoint> &reverse_entry_points,
+                              NodeID &middle_node_id,
+                              std::int32_t &upper_bound) const
+    {
+        struct SharedWeight
+        {
+            SharedWeight() = default;
+            SharedWeight(const SharedWeight &other) : weight(other.weight.load()) {}
+
+            std::atomic<std::int32_t> weight{INVALID_EDGE_WEIGHT};
+        };
+        using SharedWeights = tbb::concurrent_unordered_map<NodeID, SharedWeight>;
+
+        SharedWeights forward_weights;
+        SharedWeights reverse_weights;
+        std::atomic<std::int32_t> shared_upper_bound{upper_bound};
+        std::mutex middle_mutex;
+
+        const auto meetAtNode = [&](const SharedWeights &other_weights,
+                                    const NodeID node,
+                                    const std::int32_t weight) {
+            const auto other = other_weights.find(node);
+            if (other == other_weights.end())
+            {
+                return;
+            }
+            const auto other_weight = other->second.weight.load(std::memory_order_relaxed);
+            if (other_weight == INVALID_EDGE_WEIGHT)
+            {
+                return;
+            }
+            // a negative weight needs a loop, source and target are on the same segment
+            const std::int32_t new_weight = weight + other_weight;
+            if (new_weight >= 0 && new_weight < shared_upper_bound.load())
+            {
+                std::lock_guard<std::mutex> lock(middle_mutex);
+                if (new_weight < shared_upper_bound.load())
+                {
+                    middle_node_id = node;
+                    shared_upper_bound.store(new_weight);
+                }
+            }
+        };
+
+        // the entry points are published before the searches start
+        for (const auto &p : forward_entry_points)
+        {
+            forward_weights[std::get<0>(p)].weight.store(std::get<1>(p));
+        }
+        for (const auto &p : reverse_entry_points)
+        {
+            reverse_weights[std::get<0>(p)].weight.store(std::get<1>(p));
+            meetAtNode(forward_weights, std::get<0>(p), std::get<1>(p));
+        }
+
+        const auto minKey = [](const SearchEngineData::QueryHeap &heap) {
+            return heap.Empty() ? INVALID_EDGE_WEIGHT : heap.MinKey();
+        };
+        std::atomic<std::int32_t> forward_min_key{minKey(forward_core_heap)};
+        std::atomic<std::int32_t> reverse_min_key{minKey(reverse_core_heap)};
+
+        const auto search = [&](SearchEngineData::QueryHeap &heap,
+                                SharedWeights &own_weights,
+                                const SharedWeights &other_weights,
+                                std::atomic<std::int32_t> &own_min_key,
+                                const std::atomic<std::int32_t> &other_min_key,
+                                const bool forward_direction) {
+            const auto reachNode = [&](const NodeID node, const std::int32_t weight) {
+                own_weights[node].weight.store(weight, std::memory_order_relaxed);
+                // orders the weight before the read of the other search's weight, with the
+                // fence of the other search one of them sees the weight of the other
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                meetAtNode(other_weights, node, weight);
+            };
+
+            while (!heap.Empty())
+            {
+                // a search that stopped published INVALID_EDGE_WEIGHT, all paths over the
+                // nodes it did not settle are bounded by the best one
+                own_min_key.store(heap.MinKey());
+                if (static_cast<std::int64_t>(heap.MinKey()) + other_min_key.load() >=
+                    shared_upper_bound.load())
+                {
+                    break;
+                }
+
+                const NodeID node = heap.DeleteMin();
+                const std::int32_t weight = heap.GetKey(node);
+                OSRM_COUNT_SEARCH(settled_nodes, 1);
+
+                for (const auto edge : forward_direction ? facade.GetForwardEdgeRange(node)
+                                                         : facade.GetBackwardEdgeRange(node))
+                {
+                    const auto &data = facade.GetHotEdgeData(edge);
+                    if (!(forward_direction ? data.forward : data.backward))
+                    {
+                        continue;
+                    }
+                    const NodeID to = data.target;
+                    OSRM_COUNT_SEARCH(relaxed_edges, 1);
+
+                    BOOST_ASSERT_MSG(data.weight > 0, "edge_weight invalid");
+                    const std::int32_t to_weight = weight + data.weight;
+                    if (!heap.WasInserted(to))
+                    {
+                        heap.Insert(to, to_weight, node);
+                        OSRM_COUNT_SEARCH(heap_inserts, 1);
+                        reachNode(to, to_weight);
+                    }
+                    else if (to_weight < heap.GetKey(to))
+                    {
+                        heap.GetData(to) = {node};
+                        heap.DecreaseKey(to, to_weight);
+                        OSRM_COUNT_SEARCH(heap_decrease_keys, 1);
+                        reachNode(to, to_weight);
+                    }
+                }
+            }
+            own_min_key.store(INVALID_EDGE_WEIGHT);
+        };
+
+        {
+            // The heaps of the query stay in use until the path is retrieved. While the thread
+            // waits for the other search it only runs tasks of this one, no other query that
+            // would clear them.
+            ParallelSearchStatistics statistics;
+            tbb::this_task_arena::isolate([&] {
+                tbb::parallel_invoke(
+                    [&] {
+                        statistics.Run([&] {
+                            search(forward_core_heap,
+                                   forward_weights,
+                                   reverse_weights,
+                                   forward_min_key,
+                                   reverse_min_key,
+                                   true);
+                        });
+                    },
+                    [&] {
+                        statistics.Run([&] {
+                            search(reverse_core_heap,
+                                   reverse_weights,
+                                   forward_weights,
+                                   reverse_min_key,
+                                   forward_min_key,
+                                   false);
+                        });
+                    });
+            });
+        }
+        upper_bound = shared_upper_bound.load();
+    }
+
     bool NeedsLoopForward(const PhantomNode &source_phantom,
                           const PhantomNode &target_phantom) const
     {
@@ -768,6 +1239,17 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                    target_phantom.GetReverseWeightPlusOffset();
     }
 
+    // Only long searches are worth searching the core on two threads, their length is predicted
+    // by the great circle distance between the locations. 0 disables the parallel searches.
+    bool IsLongSearch(const PhantomNode &source_phantom,
+                      const PhantomNode &target_phantom,
+                      const int parallel_search_distance) const
+    {
+        return parallel_search_distance > 0 &&
+               util::coordinate_calculation::greatCircleDistance(
+                   source_phantom.location, target_phantom.location) >= parallel_search_distance;
+    }
+
     double GetPathDistance(const DataFacadeT &facade,
                            const std::vector<NodeID> &packed_path,
                            const PhantomNode &source_phantom,
@@ -891,6 +1373,128 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         return distance;
     }
 
+    // One-to-many variant of GetNetworkDistance without core support: the upward search from
+    // the source is run to exhaustion only once and its search space is kept in forward_heap.
+    // Every target then only needs a reverse search against it, which saves the forward half
+    // of all but the first bidirectional search.
+    // Requires the heaps for be empty
+    std::vector<double> GetNetworkDistances(const DataFacadeT &facade,
+                                            SearchEngineData::QueryHeap &forward_heap,
+                                            SearchEngineData::QueryHeap &reverse_heap,
+                                            const PhantomNode &source_phantom,
+                                            const std::vector<PhantomNode> &target_phantoms,
+                                            int duration_upper_bound = INVALID_EDGE_WEIGHT) const
+    {
+        BOOST_ASSERT(forward_heap.Empty());
+        BOOST_ASSERT(reverse_heap.Empty());
+
+        std::vector<double> distances(target_phantoms.size(),
+                                      std::numeric_limits<double>::max());
+
+        if (source_phantom.forward_segment_id.enabled)
+        {
+            forward_heap.Insert(source_phantom.forward_segment_id.id,
+                                -source_phantom.GetForwardWeightPlusOffset(),
+                                source_phantom.forward_segment_id.id);
+        }
+        if (source_phantom.reverse_segment_id.enabled)
+        {
+            forward_heap.Insert(source_phantom.reverse_segment_id.id,
+                                -source_phantom.GetReverseWeightPlusOffset(),
+                                source_phantom.reverse_segment_id.id);
+        }
+        if (forward_heap.Empty())
+        {
+            return distances;
+        }
+
+        const auto min_edge_offset = std::min(0, forward_heap.MinKey());
+        BOOST_ASSERT(min_edge_offset <= 0);
+
+        const constexpr bool STALLING_ENABLED = true;
+        const bool constexpr DO_NOT_FORCE_LOOPS =
+            false; // prevents forcing of loops, since offsets are set correctly
+
+        // the reverse heap is empty, so this only settles the forward search space up to the
+        // bound, no path that leaves it can be shorter than the bound
+        NodeID middle = SPECIAL_NODEID;
+        std::int32_t weight = duration_upper_bound;
+        while (!forward_heap.Empty())
+        {
+            RoutingStep(facade,
+                        forward_heap,
+                        reverse_heap,
+                        middle,
+                        weight,
+                        min_edge_offset,
+                        true,
+                        STALLING_ENABLED,
+                        DO_NOT_FORCE_LOOPS,
+                        DO_NOT_FORCE_LOOPS);
+        }
+
+        std::vector<NodeID> packed_path;
+        for (const auto target_index : util::irange<std::size_t>(0UL, target_phantoms.size()))
+        {
+            const auto &target_phantom = target_phantoms[target_index];
+
+            reverse_heap.Clear();
+            if (target_phantom.forward_segment_id.enabled)
+            {
+                reverse_heap.Insert(target_phantom.forward_segment_id.id,
+                                    target_phantom.GetForwardWeightPlusOffset(),
+                                    target_phantom.forward_segment_id.id);
+            }
+            if (target_phantom.reverse_segment_id.enabled)
+            {
+                reverse_heap.Insert(target_phantom.reverse_segment_id.id,
+                                    target_phantom.GetReverseWeightPlusOffset(),
+                                    target_phantom.reverse_segment_id.id);
+            }
+
+            // the forward search space is complete up to the bound, the reverse search stops as
+            // soon as it cannot improve on the best meeting node or the bound anymore
+            middle = SPECIAL_NODEID;
+            weight = duration_upper_bound;
+            while (!reverse_heap.Empty())
+            {
+                RoutingStep(facade,
+                            reverse_heap,
+                            forward_heap,
+                            middle,
+                            weight,
+                            min_edge_offset,
+                            false,
+                            STALLING_ENABLED,
+                            DO_NOT_FORCE_LOOPS,
+                            DO_NOT_FORCE_LOOPS);
+            }
+
+            if (SPECIAL_NODEID == middle || duration_upper_bound <= weight)
+            {
+                continue;
+            }
+
+            packed_path.clear();
+            // make sure to correctly unpack loops
+            if (weight != forward_heap.GetKey(middle) + reverse_heap.GetKey(middle))
+            {
+                // self loop makes up the full path
+                packed_path.push_back(middle);
+                packed_path.push_back(middle);
+            }
+            else
+            {
+                RetrievePackedPathFromHeap(forward_heap, reverse_heap, middle, packed_path);
+            }
+
+            distances[target_index] =
+                GetPathDistance(facade, packed_path, source_phantom, target_phantom);
+        }
+
+        return distances;
+    }
+
     // Requires the heaps for be empty
     // If heaps should be adjusted to be initialized outside of this function,
     // the addition of force_loop parameters might be required
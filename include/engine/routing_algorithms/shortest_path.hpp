@@ -11,6 +11,11 @@
 #include <boost/assert.hpp>
 #include <boost/optional.hpp>
 
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+#include <cstddef>
+
 namespace osrm
 {
 namespace engine
@@ -25,11 +30,17 @@ class ShortestPathRouting final
     using super = BasicRoutingInterface<DataFacadeT, ShortestPathRouting<DataFacadeT>>;
     using QueryHeap = SearchEngineData::QueryHeap;
     SearchEngineData &engine_working_data;
+    // in meters, legs at least this long search the core on two threads
+    const int parallel_search_distance;
     const static constexpr bool DO_NOT_FORCE_LOOP = false;
+    // number of legs from which on they are unpacked in parallel
+    static constexpr std::size_t PARALLEL_LEG_THRESHOLD = 8;
 
   public:
-    ShortestPathRouting(SearchEngineData &engine_working_data)
-        : engine_working_data(engine_working_data)
+    ShortestPathRouting(SearchEngineData &engine_working_data,
+                        const int parallel_search_distance = 0)
+        : engine_working_data(engine_working_data),
+          parallel_search_distance(parallel_search_distance)
     {
     }
 
@@ -105,7 +116,10 @@ class ShortestPathRouting final
                                   new_total_weight,
                                   leg_packed_path,
                                   needs_loop_forwad,
-                                  needs_loop_backwards);
+                                  needs_loop_backwards,
+                                  INVALID_EDGE_WEIGHT,
+                                  super::IsLongSearch(
+                                      source_phantom, target_phantom, parallel_search_distance));
         }
         else
         {
@@ -145,6 +159,49 @@ class ShortestPathRouting final
                 std::vector<NodeID> &leg_packed_path_forward,
                 std::vector<NodeID> &leg_packed_path_reverse) const
     {
+        // without a core both searches can share the search from the source nodes
+        if (search_to_forward_node && search_to_reverse_node && facade.GetCoreSize() == 0)
+        {
+            forward_heap.Clear();
+            reverse_heap.Clear();
+            reverse_core_heap.Clear();
+            if (search_from_forward_node)
+            {
+                forward_heap.Insert(source_phantom.forward_segment_id.id,
+                                    total_weight_to_forward -
+                                        source_phantom.GetForwardWeightPlusOffset(),
+                                    source_phantom.forward_segment_id.id);
+            }
+            if (search_from_reverse_node)
+            {
+                forward_heap.Insert(source_phantom.reverse_segment_id.id,
+                                    total_weight_to_reverse -
+                                        source_phantom.GetReverseWeightPlusOffset(),
+                                    source_phantom.reverse_segment_id.id);
+            }
+            reverse_heap.Insert(target_phantom.forward_segment_id.id,
+                                target_phantom.GetForwardWeightPlusOffset(),
+                                target_phantom.forward_segment_id.id);
+            reverse_core_heap.Insert(target_phantom.reverse_segment_id.id,
+                                     target_phantom.GetReverseWeightPlusOffset(),
+                                     target_phantom.reverse_segment_id.id);
+            BOOST_ASSERT(forward_heap.Size() > 0);
+
+            SearchToBothNodes(facade,
+                              forward_heap,
+                              reverse_heap,
+                              reverse_core_heap,
+                              super::NeedsLoopForward(source_phantom, target_phantom),
+                              super::NeedsLoopBackwards(source_phantom, target_phantom),
+                              new_total_weight_to_forward,
+                              new_total_weight_to_reverse,
+                              leg_packed_path_forward,
+                              leg_packed_path_reverse);
+            return;
+        }
+
+        const bool search_core_in_parallel =
+            super::IsLongSearch(source_phantom, target_phantom, parallel_search_distance);
         if (search_to_forward_node)
         {
             forward_heap.Clear();
@@ -184,7 +241,9 @@ class ShortestPathRouting final
                                       new_total_weight_to_forward,
                                       leg_packed_path_forward,
                                       super::NeedsLoopForward(source_phantom, target_phantom),
-                                      DO_NOT_FORCE_LOOP);
+                                      DO_NOT_FORCE_LOOP,
+                                      INVALID_EDGE_WEIGHT,
+                                      search_core_in_parallel);
             }
             else
             {
@@ -235,7 +294,9 @@ class ShortestPathRouting final
                                       new_total_weight_to_reverse,
                                       leg_packed_path_reverse,
                                       DO_NOT_FORCE_LOOP,
-                                      super::NeedsLoopBackwards(source_phantom, target_phantom));
+                                      super::NeedsLoopBackwards(source_phantom, target_phantom),
+                                      INVALID_EDGE_WEIGHT,
+                                      search_core_in_parallel);
             }
             else
             {
@@ -250,6 +311,137 @@ class ShortestPathRouting final
         }
     }
 
+    // Bidirectional search from the source nodes to both nodes of the target at once. The
+    // forward search runs until neither path can improve and is checked against both reverse
+    // searches, so it is only done once per leg. Both results are the ones of a separate search
+    // to each node.
+    void SearchToBothNodes(const DataFacadeT &facade,
+                           QueryHeap &forward_heap,
+                           QueryHeap &reverse_heap_to_forward,
+                           QueryHeap &reverse_heap_to_reverse,
+                           const bool needs_loop_forward,
+                           const bool needs_loop_backwards,
+                           int &new_total_weight_to_forward,
+                           int &new_total_weight_to_reverse,
+                           std::vector<NodeID> &leg_packed_path_forward,
+                           std::vector<NodeID> &leg_packed_path_reverse) const
+    {
+        NodeID middle_to_forward = SPECIAL_NODEID;
+        NodeID middle_to_reverse = SPECIAL_NODEID;
+        new_total_weight_to_forward = INVALID_EDGE_WEIGHT;
+        new_total_weight_to_reverse = INVALID_EDGE_WEIGHT;
+
+        const auto min_edge_offset = std::min(0, forward_heap.MinKey());
+        BOOST_ASSERT(reverse_heap_to_forward.MinKey() >= 0);
+        BOOST_ASSERT(reverse_heap_to_reverse.MinKey() >= 0);
+
+        const constexpr bool STALLING_ENABLED = true;
+        while (0 < (forward_heap.Size() + reverse_heap_to_forward.Size() +
+                    reverse_heap_to_reverse.Size()))
+        {
+            if (!forward_heap.Empty())
+            {
+                const NodeID node = forward_heap.DeleteMin();
+                const int weight = forward_heap.GetKey(node);
+                OSRM_COUNT_SEARCH(settled_nodes, 1);
+
+                super::MeetAtNode(facade,
+                                  forward_heap,
+                                  reverse_heap_to_forward,
+                                  node,
+                                  weight,
+                                  middle_to_forward,
+                                  new_total_weight_to_forward,
+                                  true,
+                                  needs_loop_forward,
+                                  DO_NOT_FORCE_LOOP);
+                super::MeetAtNode(facade,
+                                  forward_heap,
+                                  reverse_heap_to_reverse,
+                                  node,
+                                  weight,
+                                  middle_to_reverse,
+                                  new_total_weight_to_reverse,
+                                  true,
+                                  DO_NOT_FORCE_LOOP,
+                                  needs_loop_backwards);
+
+                if (weight + min_edge_offset >
+                    std::max(new_total_weight_to_forward, new_total_weight_to_reverse))
+                {
+                    forward_heap.DeleteAll();
+                }
+                else if (!super::StallAtNode(facade, forward_heap, node, weight, true))
+                {
+                    super::RelaxOutgoingEdges(facade, forward_heap, node, weight, true);
+                }
+            }
+            if (!reverse_heap_to_forward.Empty())
+            {
+                super::RoutingStep(facade,
+                                   reverse_heap_to_forward,
+                                   forward_heap,
+                                   middle_to_forward,
+                                   new_total_weight_to_forward,
+                                   min_edge_offset,
+                                   false,
+                                   STALLING_ENABLED,
+                                   DO_NOT_FORCE_LOOP,
+                                   needs_loop_forward);
+            }
+            if (!reverse_heap_to_reverse.Empty())
+            {
+                super::RoutingStep(facade,
+                                   reverse_heap_to_reverse,
+                                   forward_heap,
+                                   middle_to_reverse,
+                                   new_total_weight_to_reverse,
+                                   min_edge_offset,
+                                   false,
+                                   STALLING_ENABLED,
+                                   needs_loop_backwards,
+                                   DO_NOT_FORCE_LOOP);
+            }
+        }
+
+        RetrieveLeg(forward_heap,
+                    reverse_heap_to_forward,
+                    middle_to_forward,
+                    new_total_weight_to_forward,
+                    leg_packed_path_forward);
+        RetrieveLeg(forward_heap,
+                    reverse_heap_to_reverse,
+                    middle_to_reverse,
+                    new_total_weight_to_reverse,
+                    leg_packed_path_reverse);
+    }
+
+    void RetrieveLeg(QueryHeap &forward_heap,
+                     QueryHeap &reverse_heap,
+                     const NodeID middle,
+                     int &weight,
+                     std::vector<NodeID> &leg_packed_path) const
+    {
+        if (SPECIAL_NODEID == middle || INVALID_EDGE_WEIGHT == weight)
+        {
+            weight = INVALID_EDGE_WEIGHT;
+            return;
+        }
+
+        // make sure to correctly unpack loops
+        if (weight != forward_heap.GetKey(middle) + reverse_heap.GetKey(middle))
+        {
+            leg_packed_path.push_back(middle);
+            leg_packed_path.push_back(middle);
+        }
+        else
+        {
+            super::RetrievePackedPathFromHeap(forward_heap, reverse_heap, middle, leg_packed_path);
+        }
+    }
+
+    // The legs are unpacked independently of each other, those of routes with many legs in
+    // parallel
     void UnpackLegs(const DataFacadeT &facade,
                     const std::vector<PhantomNodes> &phantom_nodes_vector,
                     const std::vector<NodeID> &total_packed_path,
@@ -257,21 +449,42 @@ class ShortestPathRouting final
                     const int shortest_path_length,
                     InternalRouteResult &raw_route_data) const
     {
-        raw_route_data.unpacked_path_segments.resize(packed_leg_begin.size() - 1);
+        const auto number_of_legs = packed_leg_begin.size() - 1;
+        raw_route_data.unpacked_path_segments.resize(number_of_legs);
 
         raw_route_data.shortest_path_length = shortest_path_length;
 
-        for (const auto current_leg : util::irange<std::size_t>(0UL, packed_leg_begin.size() - 1))
-        {
-            auto leg_begin = total_packed_path.begin() + packed_leg_begin[current_leg];
-            auto leg_end = total_packed_path.begin() + packed_leg_begin[current_leg + 1];
-            const auto &unpack_phantom_node_pair = phantom_nodes_vector[current_leg];
+        const auto unpack_leg = [&](const std::size_t current_leg) {
             super::UnpackPath(facade,
-                              leg_begin,
-                              leg_end,
-                              unpack_phantom_node_pair,
+                              total_packed_path.begin() + packed_leg_begin[current_leg],
+                              total_packed_path.begin() + packed_leg_begin[current_leg + 1],
+                              phantom_nodes_vector[current_leg],
                               raw_route_data.unpacked_path_segments[current_leg]);
+        };
+        if (number_of_legs < PARALLEL_LEG_THRESHOLD)
+        {
+            for (const auto current_leg : util::irange<std::size_t>(0UL, number_of_legs))
+            {
+                unpack_leg(current_leg);
+            }
+        }
+        else
+        {
+            ParallelSearchStatistics statistics;
+            // only the legs of this query run while the thread waits, see
+            // BasicRoutingInterface::SearchCoreInParallel
+            tbb::this_task_arena::isolate([&] {
+                tbb::parallel_for(
+                    std::size_t{0}, number_of_legs, [&](const std::size_t current_leg) {
+                        statistics.Run([&] { unpack_leg(current_leg); });
+                    });
+            });
+        }
 
+        for (const auto current_leg : util::irange<std::size_t>(0UL, number_of_legs))
+        {
+            auto leg_begin = total_packed_path.begin() + packed_leg_begin[current_leg];
+            auto leg_end = total_packed_path.begin() + packed_leg_begin[current_leg + 1];
             raw_route_data.source_traversed_in_reverse.push_back(
                 (*leg_begin !=
                  phantom_nodes_vector[current_leg].source_phantom.forward_segment_id.id));
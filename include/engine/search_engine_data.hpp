@@ -1,11 +1,17 @@
 #ifndef SEARCH_ENGINE_DATA_HPP
 #define SEARCH_ENGINE_DATA_HPP
 
-#include <boost/thread/tss.hpp>
-
+#include "engine/map_matching/hidden_markov_model.hpp"
 #include "util/binary_heap.hpp"
+#include "util/d_ary_heap.hpp"
+#include "util/multi_level_graph.hpp"
 #include "util/typedefs.hpp"
 
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <memory>
+
 namespace osrm
 {
 namespace engine
@@ -14,27 +20,148 @@ namespace engine
 struct HeapData
 {
     NodeID parent;
-    /* explicit */ HeapData(NodeID p) : parent(p) {}
+    // set by stall-on-demand, the node is not expanded once settled unless a shorter path is found
+    bool stalled;
+    /* explicit */ HeapData(NodeID p) : parent(p), stalled(false) {}
+};
+
+// The many-to-many search also carries the length of the path to a node along with its weight
+struct ManyToManyHeapData : HeapData
+{
+    EdgeDistance distance;
+    /* explicit */ ManyToManyHeapData(NodeID p) : HeapData(p), distance(0) {}
+    ManyToManyHeapData(NodeID p, EdgeDistance distance) : HeapData(p), distance(distance) {}
 };
 
 struct SearchEngineData
 {
-    using QueryHeap =
-        util::BinaryHeap<NodeID, NodeID, int, HeapData, util::UnorderedMapStorage<NodeID, int>>;
-    using SearchEngineHeapPtr = boost::thread_specific_ptr<QueryHeap>;
+    // The heaps are reused for every query, so we can afford a flat index array over all nodes
+    // that is cleared in constant time. CH searches are shallow and do a lot of decrease-keys,
+    // which a 4-ary heap handles with fewer cache misses.
+    using QueryHeap = util::DAryHeap<NodeID,
+                                     NodeID,
+                                     int,
+                                     HeapData,
+                                     util::TimestampedArrayStorage<NodeID, int>,
+                                     4>;
+
+    // The many-to-many search only uses a single heap that is cleared for every source
+    // and target, it selects its storage independently of the point-to-point heaps.
+    using ManyToManyQueryHeap = util::DAryHeap<NodeID,
+                                               NodeID,
+                                               int,
+                                               ManyToManyHeapData,
+                                               util::TimestampedArrayStorage<NodeID, int>,
+                                               4>;
+
+    // The searches on the multi-level overlay graph remember the arc or clique that reached a node
+    using MultiLevelQueryHeap = util::DAryHeap<NodeID,
+                                               NodeID,
+                                               int,
+                                               util::MultiLevelHeapData,
+                                               util::TimestampedArrayStorage<NodeID, int>,
+                                               4>;
+
+    // All heaps a query can use. The map matching keeps the state of its trace in buffers that
+    // grow to the longest trace.
+    struct HeapSet
+    {
+        std::unique_ptr<QueryHeap> forward_heap_1;
+        std::unique_ptr<QueryHeap> reverse_heap_1;
+        std::unique_ptr<QueryHeap> forward_heap_2;
+        std::unique_ptr<QueryHeap> reverse_heap_2;
+        std::unique_ptr<QueryHeap> forward_heap_3;
+        std::unique_ptr<QueryHeap> reverse_heap_3;
+        std::unique_ptr<ManyToManyQueryHeap> many_to_many_heap;
+        std::unique_ptr<MultiLevelQueryHeap> multi_level_forward_heap;
+        std::unique_ptr<MultiLevelQueryHeap> multi_level_reverse_heap;
+        std::unique_ptr<MultiLevelQueryHeap> multi_level_unpacking_heap;
+        std::unique_ptr<map_matching::HiddenMarkovModel> map_matching_model;
+    };
+
+    // Borrows a heap set from the process wide pool for the thread until it is destroyed. A task
+    // lease on a thread that holds a set uses that set: the query waits for its tasks in
+    // isolation, so the thread only runs tasks of that query meanwhile. Every query lease gets a
+    // set of its own and gives the thread back the set it held before at its end.
+    //
+    // With a limit on the number of heap sets, query leases wait until a set is free, except on
+    // a thread that holds one, which would wait for itself. The tasks a query splits its
+    // searches into never wait, as the query that waits for them holds a set itself, they take
+    // a new set if none is free and drop it again if the pool is full.
+    class Lease
+    {
+      public:
+        enum Kind
+        {
+            Query,
+            Task
+        };
+
+        explicit Lease(const Kind kind = Query);
+        ~Lease();
 
-    static SearchEngineHeapPtr forward_heap_1;
-    static SearchEngineHeapPtr reverse_heap_1;
-    static SearchEngineHeapPtr forward_heap_2;
-    static SearchEngineHeapPtr reverse_heap_2;
-    static SearchEngineHeapPtr forward_heap_3;
-    static SearchEngineHeapPtr reverse_heap_3;
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+
+      private:
+        std::unique_ptr<HeapSet> heap_set;
+        HeapSet *outer_heap_set;
+        Kind kind;
+    };
+
+    // The heap set of the lease of the current thread, nullptr without a lease
+    static HeapSet *GetHeapSet();
+
+    // At most `max_heap_sets` queries hold a heap set at once and at most that many idle sets
+    // are kept, 0 removes the limit and keeps a set for every query that ran concurrently
+    static void SetMaxHeapSets(const std::size_t max_heap_sets);
+
+    // The number of idle heap sets in the pool
+    static std::size_t GetNumberOfIdleHeapSets();
+
+    // Frees the idle heap sets, the sets of running queries return to the pool as usual
+    static void ClearIdleHeapSets();
+
+    // Refers to a heap of the set the current thread leased
+    template <typename HeapT, std::unique_ptr<HeapT> HeapSet::*member> struct HeapPtr
+    {
+        HeapT *get() const
+        {
+            const auto heap_set = GetHeapSet();
+            BOOST_ASSERT_MSG(heap_set, "the searches need a heap set lease");
+            return (heap_set->*member).get();
+        }
+        HeapT &operator*() const { return *get(); }
+        HeapT *operator->() const { return get(); }
+    };
+
+    static const HeapPtr<QueryHeap, &HeapSet::forward_heap_1> forward_heap_1;
+    static const HeapPtr<QueryHeap, &HeapSet::reverse_heap_1> reverse_heap_1;
+    static const HeapPtr<QueryHeap, &HeapSet::forward_heap_2> forward_heap_2;
+    static const HeapPtr<QueryHeap, &HeapSet::reverse_heap_2> reverse_heap_2;
+    static const HeapPtr<QueryHeap, &HeapSet::forward_heap_3> forward_heap_3;
+    static const HeapPtr<QueryHeap, &HeapSet::reverse_heap_3> reverse_heap_3;
+    static const HeapPtr<ManyToManyQueryHeap, &HeapSet::many_to_many_heap> many_to_many_heap;
+    static const HeapPtr<MultiLevelQueryHeap, &HeapSet::multi_level_forward_heap>
+        multi_level_forward_heap;
+    static const HeapPtr<MultiLevelQueryHeap, &HeapSet::multi_level_reverse_heap>
+        multi_level_reverse_heap;
+    static const HeapPtr<MultiLevelQueryHeap, &HeapSet::multi_level_unpacking_heap>
+        multi_level_unpacking_heap;
+    static const HeapPtr<map_matching::HiddenMarkovModel, &HeapSet::map_matching_model>
+        map_matching_model;
 
     void InitializeOrClearFirstThreadLocalStorage(const unsigned number_of_nodes);
 
     void InitializeOrClearSecondThreadLocalStorage(const unsigned number_of_nodes);
 
     void InitializeOrClearThirdThreadLocalStorage(const unsigned number_of_nodes);
+
+    void InitializeOrClearManyToManyThreadLocalStorage(const unsigned number_of_nodes);
+
+    void InitializeOrClearMultiLevelThreadLocalStorage(const unsigned number_of_nodes);
+
+    void InitializeMapMatchingThreadLocalStorage();
 };
 }
 }
@@ -0,0 +1,162 @@
+#ifndef OSRM_ENGINE_SEARCH_SPACE_CACHE_HPP
+#define OSRM_ENGINE_SEARCH_SPACE_CACHE_HPP
+
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <array>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+// A node settled by the upward search of a table source
+struct SettledNode
+{
+    NodeID node;
+    EdgeWeight weight;
+    EdgeDistance distance;
+};
+
+// The nodes in the order they were settled
+using SearchSpace = std::vector<SettledNode>;
+
+// Upward search spaces of recently used table sources, shared by all queries on a dataset.
+// Depots that are the sources of many tables skip their forward searches, their rows only scan
+// the buckets of the targets at the cached nodes. Like the tile cache it lives with the dataset,
+// a new dataset starts empty.
+//
+// A search space is cached with the segments it started from and their weights and distances.
+// The entries are spread over shards with a lock each, every shard evicts its entries in least
+// recently used order.
+class SearchSpaceCache
+{
+  public:
+    static const constexpr std::size_t NUMBER_OF_SHARDS = 16;
+
+    // The start of an upward search, the node of a disabled segment is SPECIAL_NODEID. The
+    // distances are INVALID_EDGE_DISTANCE for searches that do not sum them up.
+    struct Key
+    {
+        NodeID forward_node;
+        NodeID reverse_node;
+        EdgeWeight forward_weight;
+        EdgeWeight reverse_weight;
+        EdgeDistance forward_distance;
+        EdgeDistance reverse_distance;
+
+        bool operator==(const Key &other) const
+        {
+            return forward_node == other.forward_node && reverse_node == other.reverse_node &&
+                   forward_weight == other.forward_weight &&
+                   reverse_weight == other.reverse_weight &&
+                   forward_distance == other.forward_distance &&
+                   reverse_distance == other.reverse_distance;
+        }
+    };
+
+    explicit SearchSpaceCache(const std::size_t number_of_entries)
+    {
+        BOOST_ASSERT(number_of_entries > 0);
+        for (auto &shard : shards)
+        {
+            shard.number_of_entries = (number_of_entries + NUMBER_OF_SHARDS - 1) / NUMBER_OF_SHARDS;
+        }
+    }
+
+    SearchSpaceCache(const SearchSpaceCache &) = delete;
+    SearchSpaceCache &operator=(const SearchSpaceCache &) = delete;
+
+    // nullptr if the search space is not cached
+    std::shared_ptr<const SearchSpace> Find(const Key &key)
+    {
+        auto &shard = getShard(key);
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto position = shard.positions.find(key);
+        if (position == shard.positions.end())
+        {
+            return nullptr;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, position->second);
+        return position->second->second;
+    }
+
+    void Insert(const Key &key, std::shared_ptr<const SearchSpace> search_space)
+    {
+        auto &shard = getShard(key);
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto position = shard.positions.find(key);
+        if (position != shard.positions.end())
+        {
+            // another query searched from the same source in the meantime
+            shard.entries.splice(shard.entries.begin(), shard.entries, position->second);
+            return;
+        }
+
+        if (shard.entries.size() == shard.number_of_entries)
+        {
+            shard.positions.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+        }
+        shard.entries.emplace_front(key, std::move(search_space));
+        shard.positions.emplace(key, shard.entries.begin());
+    }
+
+    std::size_t GetNumberOfEntries() const
+    {
+        std::size_t number_of_entries = 0;
+        for (const auto &shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            number_of_entries += shard.entries.size();
+        }
+        return number_of_entries;
+    }
+
+  private:
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &key) const
+        {
+            std::size_t seed = 0;
+            boost::hash_combine(seed, key.forward_node);
+            boost::hash_combine(seed, key.reverse_node);
+            boost::hash_combine(seed, key.forward_weight);
+            boost::hash_combine(seed, key.reverse_weight);
+            boost::hash_combine(seed, key.forward_distance);
+            boost::hash_combine(seed, key.reverse_distance);
+            return seed;
+        }
+    };
+
+    using Entries = std::list<std::pair<Key, std::shared_ptr<const SearchSpace>>>;
+
+    struct Shard
+    {
+        std::size_t number_of_entries;
+        mutable std::mutex mutex;
+        // most recently used entry first
+        Entries entries;
+        std::unordered_map<Key, Entries::iterator, KeyHash> positions;
+    };
+
+    Shard &getShard(const Key &key) { return shards[KeyHash{}(key) % NUMBER_OF_SHARDS]; }
+
+    std::array<Shard, NUMBER_OF_SHARDS> shards;
+};
+}
+}
+
+#endif // OSRM_ENGINE_SEARCH_SPACE_CACHE_HPP
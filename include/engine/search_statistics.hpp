@@ -0,0 +1,105 @@
+#ifndef OSRM_ENGINE_SEARCH_STATISTICS_HPP
+#define OSRM_ENGINE_SEARCH_STATISTICS_HPP
+
+#include "engine/query_deadline.hpp"
+#include "util/allocation_statistics.hpp"
+
+#include <cstdint>
+#include <mutex>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Counters of the work of the searches of the routing algorithms. They are only counted in
+// builds with ENABLE_SEARCH_STATISTICS, every thread counts the queries it runs on its own.
+// Without it OSRM_COUNT_SEARCH compiles to nothing and the counters stay zero.
+struct SearchStatistics
+{
+    std::uint64_t settled_nodes = 0;
+    std::uint64_t relaxed_edges = 0;
+    std::uint64_t stalled_nodes = 0;
+    std::uint64_t heap_inserts = 0;
+    std::uint64_t heap_decrease_keys = 0;
+    std::uint64_t unpacked_edges = 0;
+
+    void Reset() { *this = SearchStatistics(); }
+
+    SearchStatistics &operator+=(const SearchStatistics &other)
+    {
+        settled_nodes += other.settled_nodes;
+        relaxed_edges += other.relaxed_edges;
+        stalled_nodes += other.stalled_nodes;
+        heap_inserts += other.heap_inserts;
+        heap_decrease_keys += other.heap_decrease_keys;
+        unpacked_edges += other.unpacked_edges;
+        return *this;
+    }
+};
+
+#ifdef OSRM_SEARCH_STATISTICS
+const constexpr bool SEARCH_STATISTICS_ENABLED = true;
+#else
+const constexpr bool SEARCH_STATISTICS_ENABLED = false;
+#endif
+
+// The counters of the searches on the calling thread
+inline SearchStatistics &GetSearchStatistics()
+{
+    static thread_local SearchStatistics statistics;
+    return statistics;
+}
+
+// Searches in the tasks of a parallel loop count on the threads that run them. The counts of the
+// tasks are collected and added to the thread that started the loop once it finished, which is
+// when this goes out of scope. The allocations of the tasks are collected the same way, and the
+// tasks stop at the deadline of the thread that started the loop.
+class ParallelSearchStatistics
+{
+  public:
+    ParallelSearchStatistics() : deadline(GetQueryDeadline()) {}
+    ParallelSearchStatistics(const ParallelSearchStatistics &) = delete;
+    ParallelSearchStatistics &operator=(const ParallelSearchStatistics &) = delete;
+
+    ~ParallelSearchStatistics() { GetSearchStatistics() += collected; }
+
+    template <typename TaskT> void Run(TaskT &&task)
+    {
+        allocations.Run([this, &task] {
+            QueryDeadlineScope deadline_scope(deadline);
+            if (!SEARCH_STATISTICS_ENABLED)
+            {
+                task();
+                return;
+            }
+
+            auto &statistics = GetSearchStatistics();
+            const auto before = statistics;
+            statistics.Reset();
+            task();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                collected += statistics;
+            }
+            statistics = before;
+        });
+    }
+
+  private:
+    util::ParallelAllocationStatistics allocations;
+    const QueryDeadline deadline;
+    std::mutex mutex;
+    SearchStatistics collected;
+};
+}
+}
+
+#ifdef OSRM_SEARCH_STATISTICS
+#define OSRM_COUNT_SEARCH(_COUNTER, _N)                                                            \
+    (::osrm::engine::GetSearchStatistics()._COUNTER += (_N))
+#else
+#define OSRM_COUNT_SEARCH(_COUNTER, _N) static_cast<void>(0)
+#endif
+
+#endif // OSRM_ENGINE_SEARCH_STATISTICS_HPP
@@ -0,0 +1,104 @@
+#ifndef OSRM_ENGINE_SHORTCUT_CACHE_HPP
+#define OSRM_ENGINE_SHORTCUT_CACHE_HPP
+
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Original edges of the CH shortcuts that routes unpack over and over, e.g. the shortcuts of the
+// top levels of the hierarchy on motorways. The cache is shared by all queries on a dataset.
+//
+// It has a fixed number of slots that a shortcut is hashed to. A slot is filled once and then
+// only read, so lookups are a single atomic load and the entries live as long as the cache.
+// Shortcuts that collide with a filled slot are unpacked as usual.
+class ShortcutCache
+{
+  public:
+    // shortcuts with fewer original edges are faster to unpack than to copy from the cache
+    static const constexpr std::size_t MIN_CACHED_EDGES = 16;
+    // bounds the memory of the cache to number of entries times this many edges
+    static const constexpr std::size_t MAX_CACHED_EDGES = 4096;
+
+    struct OriginalEdge
+    {
+        NodeID source;
+        NodeID target;
+        EdgeID edge;
+    };
+
+    struct Entry
+    {
+        EdgeID shortcut;
+        std::vector<OriginalEdge> original_edges;
+    };
+
+    explicit ShortcutCache(const std::size_t number_of_entries) : slots(number_of_entries)
+    {
+        BOOST_ASSERT(number_of_entries > 0);
+        for (auto &slot : slots)
+        {
+            slot.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~ShortcutCache()
+    {
+        for (auto &slot : slots)
+        {
+            delete slot.load(std::memory_order_relaxed);
+        }
+    }
+
+    ShortcutCache(const ShortcutCache &) = delete;
+    ShortcutCache &operator=(const ShortcutCache &) = delete;
+
+    // the original edges of the shortcut in path order, nullptr if it is not cached
+    const Entry *Find(const EdgeID shortcut) const
+    {
+        const auto *entry = slots[shortcut % slots.size()].load(std::memory_order_acquire);
+        if (entry != nullptr && entry->shortcut == shortcut)
+        {
+            return entry;
+        }
+        return nullptr;
+    }
+
+    // caches the original edges unless their number is out of bounds or the slot is taken
+    void Insert(const EdgeID shortcut, const std::vector<OriginalEdge> &original_edges)
+    {
+        if (original_edges.size() < MIN_CACHED_EDGES || original_edges.size() > MAX_CACHED_EDGES)
+        {
+            return;
+        }
+
+        auto &slot = slots[shortcut % slots.size()];
+        if (slot.load(std::memory_order_relaxed) != nullptr)
+        {
+            return;
+        }
+
+        std::unique_ptr<Entry> entry(new Entry{shortcut, original_edges});
+        const Entry *empty = nullptr;
+        if (slot.compare_exchange_strong(empty, entry.get(), std::memory_order_release))
+        {
+            entry.release();
+        }
+    }
+
+  private:
+    std::vector<std::atomic<const Entry *>> slots;
+};
+}
+}
+
+#endif // OSRM_ENGINE_SHORTCUT_CACHE_HPP
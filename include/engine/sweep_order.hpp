@@ -0,0 +1,27 @@
+#ifndef OSRM_ENGINE_SWEEP_ORDER_HPP
+#define OSRM_ENGINE_SWEEP_ORDER_HPP
+
+#include "util/typedefs.hpp"
+
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace datafacade
+{
+class BaseDataFacade;
+}
+
+// Nodes of the contraction hierarchy ordered from the top, every node comes after all higher
+// nodes it has an edge to. A downward sweep in this order sees the final weights of the higher
+// nodes of every node it visits, which is what one-to-all searches (PHAST) need.
+//
+// The order is derived from the edges, every edge of the hierarchy is stored at its lower node.
+// Datasets with a core have edges in both directions between core nodes and get an empty order.
+std::vector<NodeID> computeSweepOrder(const datafacade::BaseDataFacade &facade);
+}
+}
+
+#endif // OSRM_ENGINE_SWEEP_ORDER_HPP
@@ -0,0 +1,161 @@
+#ifndef OSRM_ENGINE_TARGET_SET_CACHE_HPP
+#define OSRM_ENGINE_TARGET_SET_CACHE_HPP
+
+#include "engine/api/base_parameters.hpp"
+#include "engine/datafacade/datafacade_base.hpp"
+#include "engine/phantom_node.hpp"
+#include "engine/routing_algorithms/many_to_many.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+// The targets of a set snapped to a dataset, with the buckets of their backward searches
+struct SnappedTargetSet
+{
+    std::vector<PhantomNode> phantom_nodes;
+    routing_algorithms::TargetBuckets buckets;
+};
+
+// Named target sets of the table service. Clients that send tables to the same few thousand
+// destinations over and over register them once, later tables to the set only run the forward
+// searches of their sources.
+//
+// A set keeps the coordinates, hints, radiuses and bearings it was registered with. It is snapped
+// and searched once per facade on its first use, the snapped set is dropped with the facade, so
+// a new dataset searches the set again. Registering a name again replaces its set, the sets are
+// evicted in least recently used order.
+class TargetSetCache
+{
+  public:
+    using Targets = std::shared_ptr<const api::BaseParameters>;
+    using SnappedTargets = std::shared_ptr<const SnappedTargetSet>;
+
+    explicit TargetSetCache(const std::size_t number_of_sets) : number_of_sets(number_of_sets)
+    {
+        BOOST_ASSERT(number_of_sets > 0);
+    }
+
+    TargetSetCache(const TargetSetCache &) = delete;
+    TargetSetCache &operator=(const TargetSetCache &) = delete;
+
+    void Register(const std::string &name, Targets targets)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto position = positions.find(name);
+        if (position != positions.end())
+        {
+            entries.erase(position->second);
+            positions.erase(position);
+        }
+        else if (entries.size() == number_of_sets)
+        {
+            positions.erase(entries.back().name);
+            entries.pop_back();
+        }
+        entries.push_front(Entry{name, std::move(targets), {}});
+        positions.emplace(name, entries.begin());
+    }
+
+    // the targets of the set, nullptr if no set of this name is registered
+    Targets FindTargets(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto position = positions.find(name);
+        if (position == positions.end())
+        {
+            return nullptr;
+        }
+        entries.splice(entries.begin(), entries, position->second);
+        return position->second->targets;
+    }
+
+    // the targets snapped to the facade, nullptr if they were not snapped to it yet
+    SnappedTargets Find(const std::string &name,
+                        const Targets &targets,
+                        const datafacade::BaseDataFacade &facade)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto position = positions.find(name);
+        if (position == positions.end() || position->second->targets != targets)
+        {
+            return nullptr;
+        }
+        for (const auto &snapped : position->second->snapped)
+        {
+            const auto snapped_facade = snapped.first.lock();
+            if (snapped_facade.get() == &facade)
+            {
+                return snapped.second;
+            }
+        }
+        return nullptr;
+    }
+
+    // Keeps the targets snapped to the facade unless the set was replaced in the meantime.
+    // The snapped targets of facades that were dropped are removed.
+    void Insert(const std::string &name,
+                const Targets &targets,
+                const std::shared_ptr<const datafacade::BaseDataFacade> &facade,
+                SnappedTargets snapped_targets)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto position = positions.find(name);
+        if (position == positions.end() || position->second->targets != targets)
+        {
+            return;
+        }
+        auto &snapped = position->second->snapped;
+        snapped.erase(std::remove_if(snapped.begin(),
+                                     snapped.end(),
+                                     [&facade](const SnappedFacade &snapped_facade) {
+                                         return snapped_facade.first.expired() ||
+                                                snapped_facade.first.lock() == facade;
+                                     }),
+                      snapped.end());
+        snapped.emplace_back(facade, std::move(snapped_targets));
+    }
+
+    std::size_t GetNumberOfSets() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+  private:
+    using SnappedFacade =
+        std::pair<std::weak_ptr<const datafacade::BaseDataFacade>, SnappedTargets>;
+
+    struct Entry
+    {
+        std::string name;
+        Targets targets;
+        // one per facade the set was used on, usually the facade of the current dataset
+        std::vector<SnappedFacade> snapped;
+    };
+
+    using Entries = std::list<Entry>;
+
+    const std::size_t number_of_sets;
+    mutable std::mutex mutex;
+    // most recently used set first
+    Entries entries;
+    std::unordered_map<std::string, Entries::iterator> positions;
+};
+}
+}
+
+#endif // OSRM_ENGINE_TARGET_SET_CACHE_HPP
@@ -0,0 +1,103 @@
+#ifndef OSRM_ENGINE_TILE_CACHE_HPP
+#define OSRM_ENGINE_TILE_CACHE_HPP
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Encoded vector tiles of the most recently requested z/x/y, shared by all queries on a dataset.
+// A tile only depends on the data of its dataset, so it stays valid as long as the cache lives
+// with the dataset and a new dataset starts with an empty cache.
+//
+// The tiles are evicted in least recently used order once the cache holds its number of tiles.
+class TileCache
+{
+  public:
+    explicit TileCache(const std::size_t number_of_tiles) : number_of_tiles(number_of_tiles)
+    {
+        BOOST_ASSERT(number_of_tiles > 0);
+    }
+
+    TileCache(const TileCache &) = delete;
+    TileCache &operator=(const TileCache &) = delete;
+
+    // copies the cached tile into the buffer, false if it is not cached
+    bool Find(const unsigned z, const unsigned x, const unsigned y, std::string &buffer)
+    {
+        std::shared_ptr<const std::string> tile;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto position = positions.find(makeKey(z, x, y));
+            if (position == positions.end())
+            {
+                return false;
+            }
+            // the tile becomes the most recently used one
+            tiles.splice(tiles.begin(), tiles, position->second);
+            tile = position->second->second;
+        }
+        // tiles are never changed once cached, so they can be copied without holding the lock
+        buffer = *tile;
+        return true;
+    }
+
+    void Insert(const unsigned z, const unsigned x, const unsigned y, const std::string &buffer)
+    {
+        const auto key = makeKey(z, x, y);
+        auto tile = std::make_shared<const std::string>(buffer);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto position = positions.find(key);
+        if (position != positions.end())
+        {
+            // another query rendered the same tile in the meantime
+            tiles.splice(tiles.begin(), tiles, position->second);
+            return;
+        }
+
+        if (tiles.size() == number_of_tiles)
+        {
+            positions.erase(tiles.back().first);
+            tiles.pop_back();
+        }
+        tiles.emplace_front(key, std::move(tile));
+        positions.emplace(key, tiles.begin());
+    }
+
+    std::size_t GetNumberOfTiles() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return tiles.size();
+    }
+
+  private:
+    // tiles have zoom levels below 20, so x and y need at most 20 bits
+    static std::uint64_t makeKey(const unsigned z, const unsigned x, const unsigned y)
+    {
+        return (std::uint64_t{z} << 48) | (std::uint64_t{x} << 24) | std::uint64_t{y};
+    }
+
+    using Tiles = std::list<std::pair<std::uint64_t, std::shared_ptr<const std::string>>>;
+
+    const std::size_t number_of_tiles;
+    mutable std::mutex mutex;
+    // most recently used tile first
+    Tiles tiles;
+    std::unordered_map<std::uint64_t, Tiles::iterator> positions;
+};
+}
+}
+
+#endif // OSRM_ENGINE_TILE_CACHE_HPP
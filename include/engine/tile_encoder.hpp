@@ -0,0 +1,295 @@
+#ifndef OSRM_ENGINE_TILE_ENCODER_HPP
+#define OSRM_ENGINE_TILE_ENCODER_HPP
+
+#include "util/integer_range.hpp"
+#include "util/string_view.hpp"
+#include "util/vector_tile.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace tile
+{
+
+// A point in the pixels of a tile, 0 to EXTENT on both axes inside the tile
+struct Point
+{
+    std::int32_t x;
+    std::int32_t y;
+};
+
+inline bool operator==(const Point lhs, const Point rhs)
+{
+    return lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+namespace detail
+{
+const constexpr std::uint32_t EMPTY_SLOT = 0xffffffff;
+
+inline std::uint64_t mixHash(std::uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    return value;
+}
+
+inline std::uint64_t hashValue(const std::int32_t value)
+{
+    return mixHash(static_cast<std::uint32_t>(value));
+}
+
+inline std::uint64_t hashValue(const float value)
+{
+    // 0.0 and -0.0 are equal and have to hash alike
+    std::uint32_t bits = 0;
+    if (value != 0.f)
+    {
+        std::memcpy(&bits, &value, sizeof(bits));
+    }
+    return mixHash(bits);
+}
+
+// FNV-1a
+inline std::uint64_t hashValue(const util::StringView value)
+{
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const auto character : value)
+    {
+        hash = (hash ^ static_cast<unsigned char>(character)) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+inline std::uint64_t hashValue(const std::string &value)
+{
+    return hashValue(util::StringView(value));
+}
+}
+
+// The values of an attribute of a layer. Features refer to a value by its offset in the values of
+// the layer, so every value is stored once and keeps the offset it was first used with.
+// The offsets are found in an open addressing hash table with linear probing, which is a single
+// flat allocation that is sized once for the expected number of values.
+template <typename T> class ValueTable
+{
+  public:
+    void Reserve(const std::size_t number_of_values)
+    {
+        values.reserve(number_of_values);
+        if (number_of_values * 2 > slots.size())
+        {
+            Rehash(number_of_values * 2);
+        }
+    }
+
+    // Returns the offset of the value, which is added if it was not used before. Strings can be
+    // looked up by a view, they are only copied when they are added.
+    template <typename Key> std::uint32_t Use(const Key &value)
+    {
+        if ((values.size() + 1) * 2 > slots.size())
+        {
+            Rehash((values.size() + 1) * 2);
+        }
+
+        const std::size_t mask = slots.size() - 1;
+        for (auto slot = detail::hashValue(value) & mask;; slot = (slot + 1) & mask)
+        {
+            if (slots[slot] == detail::EMPTY_SLOT)
+            {
+                const auto offset = static_cast<std::uint32_t>(values.size());
+                values.push_back(T(value));
+                slots[slot] = offset;
+                return offset;
+            }
+            if (values[slots[slot]] == value)
+            {
+                return slots[slot];
+            }
+        }
+    }
+
+    const std::vector<T> &Values() const { return values; }
+
+    std::size_t Size() const { return values.size(); }
+
+  private:
+    void Rehash(const std::size_t minimum_size)
+    {
+        std::size_t size = 16;
+        while (size < minimum_size)
+        {
+            size *= 2;
+        }
+        slots.assign(size, detail::EMPTY_SLOT);
+
+        const std::size_t mask = size - 1;
+        for (const auto offset : util::irange<std::uint32_t>(0, values.size()))
+        {
+            auto slot = detail::hashValue(values[offset]) & mask;
+            while (slots[slot] != detail::EMPTY_SLOT)
+            {
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = offset;
+        }
+    }
+
+    std::vector<T> values;
+    std::vector<std::uint32_t> slots;
+};
+
+// The lines of geometries clipped to a tile. Line i is points[offsets[i]] to points[offsets[i+1]].
+// The buffers are reused for all geometries of a tile, clearing keeps their capacity.
+struct ClippedLines
+{
+    ClippedLines() : offsets(1, 0) {}
+
+    void Clear()
+    {
+        points.clear();
+        offsets.resize(1);
+    }
+
+    std::size_t GetNumberOfLines() const { return offsets.size() - 1; }
+
+    bool Empty() const { return offsets.size() == 1; }
+
+    const Point *Begin(const std::size_t line) const { return points.data() + offsets[line]; }
+
+    const Point *End(const std::size_t line) const { return points.data() + offsets[line + 1]; }
+
+    std::vector<Point> points;
+    std::vector<std::size_t> offsets;
+};
+
+// Clips the segment to the tile and its buffer with the algorithm of Liang and Barsky. The
+// parameters of the clipped ends along the segment are 0 and 1 if the ends are inside.
+// Returns false if no part of the segment is inside.
+inline bool clipSegment(const double x0,
+                        const double y0,
+                        const double x1,
+                        const double y1,
+                        double &t0,
+                        double &t1)
+{
+    const constexpr double MIN = -util::vector_tile::BUFFER;
+    const constexpr double MAX = util::vector_tile::EXTENT + util::vector_tile::BUFFER;
+
+    const double dx = x1 - x0;
+    const double dy = y1 - y0;
+    const double p[4] = {-dx, dx, -dy, dy};
+    const double q[4] = {x0 - MIN, MAX - x0, y0 - MIN, MAX - y0};
+
+    t0 = 0.;
+    t1 = 1.;
+    for (const auto edge : {0, 1, 2, 3})
+    {
+        if (p[edge] == 0.)
+        {
+            // parallel to the edge and outside of it
+            if (q[edge] < 0.)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        const double t = q[edge] / p[edge];
+        if (p[edge] < 0.)
+        {
+            if (t > t1)
+            {
+                return false;
+            }
+            t0 = std::max(t0, t);
+        }
+        else
+        {
+            if (t < t0)
+            {
+                return false;
+            }
+            t1 = std::min(t1, t);
+        }
+    }
+    return true;
+}
+
+// Appends the parts of the line inside the tile and its buffer. A part ends where the line leaves
+// the tile and a new one starts where it enters it again. Clipped ends are truncated to pixels,
+// repeated points are dropped and so are parts that are left with a single point.
+inline void clipLine(const Point *first, const Point *last, ClippedLines &lines)
+{
+    const auto to_pixel = [](const std::int32_t from, const std::int32_t to, const double t) {
+        return t == 0. ? from
+                       : (t == 1. ? to : static_cast<std::int32_t>(from + t * (to - from)));
+    };
+    const auto add_point = [&lines](const Point point) {
+        if (lines.points.size() == lines.offsets.back() || !(lines.points.back() == point))
+        {
+            lines.points.push_back(point);
+        }
+    };
+    const auto end_part = [&lines]() {
+        if (lines.points.size() - lines.offsets.back() < 2)
+        {
+            lines.points.resize(lines.offsets.back());
+        }
+        else
+        {
+            lines.offsets.push_back(lines.points.size());
+        }
+    };
+
+    // the last point is the end of the previous segment, which is inside
+    bool in_part = false;
+    for (auto point = first; point != last && point + 1 != last; ++point)
+    {
+        const Point from = point[0];
+        const Point to = point[1];
+        double t0, t1;
+        if (!clipSegment(from.x, from.y, to.x, to.y, t0, t1))
+        {
+            if (in_part)
+            {
+                end_part();
+                in_part = false;
+            }
+            continue;
+        }
+
+        if (!in_part)
+        {
+            add_point(Point{to_pixel(from.x, to.x, t0), to_pixel(from.y, to.y, t0)});
+        }
+        add_point(Point{to_pixel(from.x, to.x, t1), to_pixel(from.y, to.y, t1)});
+
+        in_part = t1 == 1.;
+        if (!in_part)
+        {
+            end_part();
+        }
+    }
+    if (in_part)
+    {
+        end_part();
+    }
+}
+}
+}
+}
+
+#endif
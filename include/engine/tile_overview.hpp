@@ -0,0 +1,69 @@
+#ifndef OSRM_ENGINE_TILE_OVERVIEW_HPP
+#define OSRM_ENGINE_TILE_OVERVIEW_HPP
+
+#include "util/coordinate.hpp"
+#include "util/typedefs.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace datafacade
+{
+class BaseDataFacade;
+}
+
+// Road geometries for the debug tiles below the zoom levels that show every segment.
+//
+// A level only keeps the geometries between two intersections that are at least a few pixels
+// long on it, which leaves the long stretches of the major roads on the lowest levels. Each of
+// them is one line with the total weights and length of its segments and a simplified geometry,
+// so tiles of these levels do not need to look at the segments of the r-tree.
+class TileOverview
+{
+  public:
+    // levels of the overview, the regular tiles start one level above
+    static const constexpr unsigned MIN_ZOOM = 8;
+    static const constexpr unsigned MAX_ZOOM = 11;
+    // geometries that are shorter than this many pixels on a level are left out of it
+    static const constexpr double MIN_PIXELS = 4;
+
+    struct Line
+    {
+        std::vector<util::Coordinate> coordinates;
+        double length;
+        // 0 for directions that can not be used
+        EdgeWeight forward_weight;
+        EdgeWeight reverse_weight;
+        DatasourceID forward_datasource;
+        DatasourceID reverse_datasource;
+        NameID name_id;
+        bool is_tiny;
+    };
+
+    // collects the geometries of all segments of the dataset
+    explicit TileOverview(const datafacade::BaseDataFacade &facade);
+
+    // indexes of the lines that cross the tile, empty for tiles outside of the overview levels
+    const std::vector<std::uint32_t> &GetLines(unsigned z, unsigned x, unsigned y) const;
+
+    const Line &GetLine(const std::uint32_t index) const { return lines[index]; }
+
+    std::size_t GetNumberOfLines() const { return lines.size(); }
+
+  private:
+    void AddLine(Line line);
+
+    std::vector<Line> lines;
+    // line indexes per tile of each level, keyed by x and y
+    std::vector<std::unordered_map<std::uint64_t, std::vector<std::uint32_t>>> levels;
+};
+}
+}
+
+#endif // OSRM_ENGINE_TILE_OVERVIEW_HPP
@@ -1,6 +1,7 @@
 #ifndef TRIP_BRUTE_FORCE_HPP
 #define TRIP_BRUTE_FORCE_HPP
 
+#include "engine/query_deadline.hpp"
 #include "util/dist_table_wrapper.hpp"
 #include "util/simple_logger.hpp"
 #include "util/typedefs.hpp"
@@ -64,8 +65,10 @@ std::vector<NodeID> BruteForceTrip(const NodeIDIterator start,
                      "invalid node id");
     BOOST_ASSERT_MSG(*(std::min_element(std::begin(perm), std::end(perm))) >= 0, "invalid node id");
 
+    auto &deadline = GetQueryDeadline();
     do
     {
+        deadline.Check();
         const auto new_distance = ReturnDistance(dist_table, perm, min_route_dist, component_size);
         // we can use `<` instead of `<=` here, since all distances are `!=` INVALID_EDGE_WEIGHT
         // In case we really sum up to invalid edge weight for all permutations, keeping the very
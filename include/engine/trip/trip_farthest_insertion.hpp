@@ -1,6 +1,7 @@
 #ifndef TRIP_FARTHEST_INSERTION_HPP
 #define TRIP_FARTHEST_INSERTION_HPP
 
+#include "engine/query_deadline.hpp"
 #include "util/dist_table_wrapper.hpp"
 #include "util/typedefs.hpp"
 #include "util/typedefs.hpp"
@@ -24,7 +25,7 @@ namespace trip
 // given a route and a new location, find the best place of insertion and
 // check the distance of roundtrip when the new location is additionally visited
 using NodeIDIter = std::vector<NodeID>::iterator;
-std::pair<EdgeWeight, NodeIDIter>
+inline std::pair<EdgeWeight, NodeIDIter>
 GetShortestRoundTrip(const NodeID new_loc,
                      const util::DistTableWrapper<EdgeWeight> &dist_table,
                      const std::size_t number_of_locations,
@@ -98,8 +99,10 @@ std::vector<NodeID> FindRoute(const std::size_t &number_of_locations,
     route.push_back(start2);
 
     // add all other nodes missing (two nodes are already in the initial start trip)
+    auto &deadline = GetQueryDeadline();
     for (std::size_t j = 2; j < component_size; ++j)
     {
+        deadline.Check();
 
         auto farthest_distance = std::numeric_limits<int>::min();
         auto next_node = -1;
@@ -0,0 +1,151 @@
+#ifndef TRIP_HELD_KARP_HPP
+#define TRIP_HELD_KARP_HPP
+
+#include "engine/query_deadline.hpp"
+#include "util/dist_table_wrapper.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace trip
+{
+
+// the tables of the dynamic program grow with 2^n * n, 16 locations need about 2.5 MB
+const constexpr std::size_t HELD_KARP_MAX_LOCATIONS = 16;
+
+// computes the shortest round trip with the dynamic program of Held and Karp:
+// the shortest path from the first location through a subset of the other locations that ends at
+// one of them is the shortest such path through the subset without its end, extended by one leg.
+template <typename NodeIDIterator>
+std::vector<NodeID> HeldKarpTrip(const NodeIDIterator start,
+                                 const NodeIDIterator end,
+                                 const std::size_t number_of_locations,
+                                 const util::DistTableWrapper<EdgeWeight> &dist_table)
+{
+    (void)number_of_locations; // unused
+
+    const std::vector<NodeID> component(start, end);
+    const std::size_t component_size = component.size();
+
+    BOOST_ASSERT_MSG(component_size > 0, "no locations given");
+    BOOST_ASSERT_MSG(component_size <= HELD_KARP_MAX_LOCATIONS, "too many locations");
+
+    // every order of up to two locations is the same round trip
+    if (component_size <= 2)
+    {
+        return component;
+    }
+
+    // copy the durations of the component to a contiguous table to keep the lookups local
+    std::vector<EdgeWeight> table(component_size * component_size);
+    for (std::size_t from = 0; from < component_size; ++from)
+    {
+        for (std::size_t to = 0; to < component_size; ++to)
+        {
+            table[from * component_size + to] = dist_table(component[from], component[to]);
+        }
+    }
+
+    // the trip starts and ends at the first location, the subsets only hold the others.
+    // path_weights[subset * number_of_others + last] is the weight of the shortest path through
+    // all locations of the subset that ends at last, predecessors holds the location before last.
+    const std::size_t number_of_others = component_size - 1;
+    const std::size_t number_of_subsets = std::size_t{1} << number_of_others;
+    const auto first = static_cast<std::uint8_t>(number_of_others);
+    std::vector<EdgeWeight> path_weights(number_of_subsets * number_of_others,
+                                         INVALID_EDGE_WEIGHT);
+    std::vector<std::uint8_t> predecessors(number_of_subsets * number_of_others, first);
+
+    for (std::size_t last = 0; last < number_of_others; ++last)
+    {
+        path_weights[(std::size_t{1} << last) * number_of_others + last] = table[last + 1];
+    }
+
+    // extending a path only adds locations, so all paths through a subset are final before it is
+    // extended when the subsets are processed in increasing order
+    auto &deadline = GetQueryDeadline();
+    for (std::size_t subset = 1; subset < number_of_subsets; ++subset)
+    {
+        deadline.Check();
+        for (std::size_t last = 0; last < number_of_others; ++last)
+        {
+            const auto path_weight = path_weights[subset * number_of_others + last];
+            if (path_weight == INVALID_EDGE_WEIGHT)
+            {
+                continue;
+            }
+
+            const auto *const leg_weights = &table[(last + 1) * component_size + 1];
+            for (std::size_t next = 0; next < number_of_others; ++next)
+            {
+                const auto next_bit = std::size_t{1} << next;
+                if ((subset & next_bit) != 0 || leg_weights[next] == INVALID_EDGE_WEIGHT)
+                {
+                    continue;
+                }
+
+                const auto index = (subset | next_bit) * number_of_others + next;
+                const auto new_weight = path_weight + leg_weights[next];
+                if (new_weight < path_weights[index])
+                {
+                    path_weights[index] = new_weight;
+                    predecessors[index] = static_cast<std::uint8_t>(last);
+                }
+            }
+        }
+    }
+
+    // close the trip with the leg back to the first location
+    const std::size_t all_others = number_of_subsets - 1;
+    EdgeWeight min_trip_weight = INVALID_EDGE_WEIGHT;
+    std::size_t last_location = first;
+    for (std::size_t last = 0; last < number_of_others; ++last)
+    {
+        const auto path_weight = path_weights[all_others * number_of_others + last];
+        const auto leg_weight = table[(last + 1) * component_size];
+        if (path_weight == INVALID_EDGE_WEIGHT || leg_weight == INVALID_EDGE_WEIGHT)
+        {
+            continue;
+        }
+
+        if (path_weight + leg_weight < min_trip_weight)
+        {
+            min_trip_weight = path_weight + leg_weight;
+            last_location = last;
+        }
+    }
+
+    // all locations of a strongly connected component are reachable from each other
+    BOOST_ASSERT_MSG(last_location != first, "no round trip found");
+    if (last_location == first)
+    {
+        return component;
+    }
+
+    std::vector<NodeID> route(component_size);
+    route.front() = component.front();
+    std::size_t subset = all_others;
+    for (std::size_t position = number_of_others; position > 0; --position)
+    {
+        route[position] = component[last_location + 1];
+        const auto predecessor = predecessors[subset * number_of_others + last_location];
+        subset &= ~(std::size_t{1} << last_location);
+        last_location = predecessor;
+    }
+    BOOST_ASSERT(subset == 0 && last_location == first);
+
+    return route;
+}
+}
+}
+}
+
+#endif // TRIP_HELD_KARP_HPP
@@ -0,0 +1,187 @@
+#ifndef TRIP_LOCAL_SEARCH_HPP
+#define TRIP_LOCAL_SEARCH_HPP
+
+#include "util/dist_table_wrapper.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace trip
+{
+
+// moves are only tried towards this many of the closest locations of a location
+const constexpr std::size_t LOCAL_SEARCH_NEIGHBOURS = 8;
+// longest sequence of locations that is moved to another place of the trip at once
+const constexpr std::size_t LOCAL_SEARCH_MAX_SEGMENT = 3;
+
+// shortens a round trip with 2-opt and Or-opt moves until none of them improves it any more or the
+// deadline has passed. The durations are not symmetric, so 2-opt moves account for the legs of the
+// reversed part. The first location of the trip stays first.
+inline void ImproveTrip(std::vector<NodeID> &route,
+                        const util::DistTableWrapper<EdgeWeight> &dist_table,
+                        const std::chrono::steady_clock::time_point deadline)
+{
+    const std::size_t size = route.size();
+    if (size < 5)
+    {
+        return;
+    }
+
+    // the durations and the closest neighbours of the locations of the trip in contiguous tables,
+    // locations are referred to by their index in the original route
+    std::vector<EdgeWeight> table(size * size);
+    for (std::size_t from = 0; from < size; ++from)
+    {
+        for (std::size_t to = 0; to < size; ++to)
+        {
+            table[from * size + to] = dist_table(route[from], route[to]);
+            BOOST_ASSERT(table[from * size + to] != INVALID_EDGE_WEIGHT);
+        }
+    }
+    const auto weight = [&table, size](const std::size_t from, const std::size_t to) {
+        return static_cast<std::int64_t>(table[from * size + to]);
+    };
+
+    const std::size_t number_of_neighbours = std::min(LOCAL_SEARCH_NEIGHBOURS, size - 1);
+    std::vector<std::size_t> neighbours(size * number_of_neighbours);
+    std::vector<std::size_t> candidates(size - 1);
+    for (std::size_t from = 0; from < size; ++from)
+    {
+        std::iota(candidates.begin(), candidates.begin() + from, 0);
+        std::iota(candidates.begin() + from, candidates.end(), from + 1);
+        std::partial_sort(candidates.begin(),
+                          candidates.begin() + number_of_neighbours,
+                          candidates.end(),
+                          [&](const std::size_t lhs, const std::size_t rhs) {
+                              return table[from * size + lhs] < table[from * size + rhs];
+                          });
+        std::copy(candidates.begin(),
+                  candidates.begin() + number_of_neighbours,
+                  neighbours.begin() + from * number_of_neighbours);
+    }
+
+    // tour[i] is the location at position i, forward_prefix[i] and reverse_prefix[i] sum the
+    // durations of the legs before position i in the direction of the trip and against it
+    std::vector<std::size_t> tour(size);
+    std::iota(tour.begin(), tour.end(), 0);
+    std::vector<std::size_t> position(size);
+    std::vector<std::int64_t> forward_prefix(size + 1);
+    std::vector<std::int64_t> reverse_prefix(size + 1);
+    const auto update_tour = [&] {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            position[tour[i]] = i;
+            const auto next = tour[(i + 1) % size];
+            forward_prefix[i + 1] = forward_prefix[i] + weight(tour[i], next);
+            reverse_prefix[i + 1] = reverse_prefix[i] + weight(next, tour[i]);
+        }
+    };
+    update_tour();
+
+    // replaces the legs (a, b) and (c, d) by (a, c) and (b, d), which reverses b .. c
+    const auto try_two_opt = [&](const std::size_t i) {
+        const auto a = tour[i];
+        const auto b = tour[i + 1];
+        for (std::size_t k = 0; k < number_of_neighbours; ++k)
+        {
+            const auto c = neighbours[a * number_of_neighbours + k];
+            const auto j = position[c];
+            if (j <= i + 1)
+            {
+                continue;
+            }
+            const auto d = tour[(j + 1) % size];
+
+            const auto delta = weight(a, c) + weight(b, d) - weight(a, b) - weight(c, d) +
+                               (reverse_prefix[j] - reverse_prefix[i + 1]) -
+                               (forward_prefix[j] - forward_prefix[i + 1]);
+            if (delta < 0)
+            {
+                std::reverse(tour.begin() + i + 1, tour.begin() + j + 1);
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // moves the locations first .. last at position p between c and d
+    const auto try_or_opt = [&](const std::size_t p) {
+        for (std::size_t length = 1;
+             length <= LOCAL_SEARCH_MAX_SEGMENT && p + length <= size && size - length >= 3;
+             ++length)
+        {
+            const auto first = tour[p];
+            const auto last = tour[p + length - 1];
+            const auto previous = tour[p - 1];
+            const auto next = tour[(p + length) % size];
+            const auto removal_gain =
+                weight(previous, first) + weight(last, next) - weight(previous, next);
+
+            for (std::size_t k = 0; k < number_of_neighbours; ++k)
+            {
+                const auto d = neighbours[last * number_of_neighbours + k];
+                const auto q = position[d];
+                // d has to stay outside of the segment and must not follow it already
+                if ((q >= p && q <= p + length) || d == next)
+                {
+                    continue;
+                }
+                const auto c = tour[(q + size - 1) % size];
+
+                const auto insertion_cost = weight(c, first) + weight(last, d) - weight(c, d);
+                if (insertion_cost < removal_gain)
+                {
+                    const std::vector<std::size_t> segment(tour.begin() + p,
+                                                           tour.begin() + p + length);
+                    tour.erase(tour.begin() + p, tour.begin() + p + length);
+                    // the gap before the first location is the one at the end of the trip
+                    const auto insert_at =
+                        q == 0 ? tour.end() : std::find(tour.begin() + 1, tour.end(), d);
+                    tour.insert(insert_at, segment.begin(), segment.end());
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    bool improved = true;
+    while (improved && std::chrono::steady_clock::now() < deadline)
+    {
+        improved = false;
+        for (std::size_t i = 0; i + 1 < size; ++i)
+        {
+            if (try_two_opt(i) || (i > 0 && try_or_opt(i)))
+            {
+                improved = true;
+                update_tour();
+                if (std::chrono::steady_clock::now() >= deadline)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    std::vector<NodeID> improved_route(size);
+    std::transform(tour.begin(), tour.end(), improved_route.begin(), [&](const std::size_t index) {
+        return route[index];
+    });
+    route = std::move(improved_route);
+}
+}
+}
+}
+
+#endif // TRIP_LOCAL_SEARCH_HPP
@@ -1,6 +1,7 @@
 #ifndef TRIP_NEAREST_NEIGHBOUR_HPP
 #define TRIP_NEAREST_NEIGHBOUR_HPP
 
+#include "engine/query_deadline.hpp"
 #include "util/dist_table_wrapper.hpp"
 #include "util/simple_logger.hpp"
 #include "util/typedefs.hpp"
@@ -43,8 +44,10 @@ std::vector<NodeID> NearestNeighbourTrip(const NodeIDIterator &start,
     auto shortest_trip_distance = INVALID_EDGE_WEIGHT;
 
     // ALWAYS START AT ANOTHER STARTING POINT
+    auto &deadline = GetQueryDeadline();
     for (auto start_node = start; start_node != end; ++start_node)
     {
+        deadline.Check();
         NodeID curr_node = *start_node;
 
         std::vector<NodeID> curr_route;
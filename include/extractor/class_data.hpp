@@ -0,0 +1,65 @@
+#ifndef OSRM_EXTRACTOR_CLASS_DATA_HPP
+#define OSRM_EXTRACTOR_CLASS_DATA_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+// Bitmask of the classes of a road segment, set by the profile in way_function. Requests can
+// exclude classes that osrm-contract contracted a hierarchy without.
+using ClassData = std::uint8_t;
+
+const constexpr std::array<const char *, 5> CLASS_NAMES = {
+    {"toll", "motorway", "ferry", "restricted", "tunnel"}};
+static_assert(CLASS_NAMES.size() <= sizeof(ClassData) * 8, "classes do not fit into ClassData");
+
+// Class of the given name, 0 for unknown names
+inline ClassData getClass(const std::string &name)
+{
+    for (std::size_t index = 0; index < CLASS_NAMES.size(); ++index)
+    {
+        if (name == CLASS_NAMES[index])
+            return static_cast<ClassData>(1u << index);
+    }
+    return 0;
+}
+
+// Classes of the given names, 0 if one of the names is unknown
+inline ClassData getClasses(const std::vector<std::string> &names)
+{
+    ClassData classes = 0;
+    for (const auto &name : names)
+    {
+        const auto class_data = getClass(name);
+        if (class_data == 0)
+            return 0;
+        classes |= class_data;
+    }
+    return classes;
+}
+
+// Name of the metric osrm-contract --exclude writes the hierarchy without the classes to, it
+// does not depend on the order in which the classes are given
+inline std::string getExcludeMetricName(const ClassData classes)
+{
+    std::string name = "exclude";
+    for (std::size_t index = 0; index < CLASS_NAMES.size(); ++index)
+    {
+        if (classes & (1u << index))
+        {
+            name += '-';
+            name += CLASS_NAMES[index];
+        }
+    }
+    return name;
+}
+}
+}
+
+#endif // OSRM_EXTRACTOR_CLASS_DATA_HPP
@@ -1,6 +1,8 @@
 #ifndef GEOMETRY_COMPRESSOR_HPP_
 #define GEOMETRY_COMPRESSOR_HPP_
 
+#include "extractor/query_node.hpp"
+#include "util/array_view.hpp"
 #include "util/typedefs.hpp"
 
 #include <unordered_map>
@@ -24,6 +26,8 @@ class CompressedEdgeContainer
     };
 
     using OnewayEdgeBucket = std::vector<OnewayCompressedEdge>;
+    // The segments of a compressed edge, valid until the container is modified
+    using OnewayEdgeView = util::ArrayView<OnewayCompressedEdge>;
 
     CompressedEdgeContainer();
     void CompressEdge(const EdgeID surviving_edge_id,
@@ -35,6 +39,12 @@ class CompressedEdgeContainer
 
     void
     AddUncompressedEdge(const EdgeID edge_id, const NodeID target_node, const EdgeWeight weight);
+    // Adds the complete geometry of an edge that was compressed outside of the container
+    void AddCompressedEdge(const EdgeID edge_id, OnewayEdgeBucket geometry);
+    // Moves the geometries to the new ids of their edges, new_edge_ids[old_id] is the new id.
+    // This ends the compression: the geometries are packed into one array ordered by edge id,
+    // and no edges can be compressed or added afterwards.
+    void RenumberEdges(const std::vector<EdgeID> &new_edge_ids);
 
     void InitializeBothwayVector();
     unsigned ZipEdges(const unsigned f_edge_pos, const unsigned r_edge_pos);
@@ -44,10 +54,12 @@ class CompressedEdgeContainer
     bool HasZippedEntryForReverseID(const EdgeID edge_id) const;
     void PrintStatistics() const;
     void SerializeInternalVector(const std::string &path) const;
-    unsigned GetPositionForID(const EdgeID edge_id) const;
+    // Writes the length of every segment of the serialized geometries, see SegmentLength
+    void SerializeSegmentLengths(const std::string &path,
+                                 const std::vector<QueryNode> &internal_to_external_node_map) const;
     unsigned GetZippedPositionForForwardID(const EdgeID edge_id) const;
     unsigned GetZippedPositionForReverseID(const EdgeID edge_id) const;
-    const OnewayEdgeBucket &GetBucketReference(const EdgeID edge_id) const;
+    OnewayEdgeView GetBucketReference(const EdgeID edge_id) const;
     bool IsTrivial(const EdgeID edge_id) const;
     NodeID GetFirstEdgeTargetID(const EdgeID edge_id) const;
     NodeID GetLastEdgeTargetID(const EdgeID edge_id) const;
@@ -57,15 +69,26 @@ class CompressedEdgeContainer
     int free_list_maximum = 0;
 
     void IncreaseFreeList();
+    unsigned GetPositionForID(const EdgeID edge_id) const;
+
+    // while compressing, the geometries are buckets that are appended to and merged
     std::vector<OnewayEdgeBucket> m_compressed_oneway_geometries;
+    std::vector<unsigned> m_free_list;
+    std::unordered_map<EdgeID, unsigned> m_edge_id_to_list_index_map;
+
+    // once renumbered, the segments of edge e are m_segments[m_segment_offsets[e]] up to
+    // m_segments[m_segment_offsets[e + 1]], an edge without an entry has none
+    bool m_renumbered = false;
+    std::vector<unsigned> m_segment_offsets;
+    std::vector<OnewayCompressedEdge> m_segments;
+
     std::vector<unsigned> m_compressed_geometry_index;
     std::vector<NodeID> m_compressed_geometry_nodes;
     std::vector<EdgeWeight> m_compressed_geometry_fwd_weights;
     std::vector<EdgeWeight> m_compressed_geometry_rev_weights;
-    std::vector<unsigned> m_free_list;
-    std::unordered_map<EdgeID, unsigned> m_edge_id_to_list_index_map;
-    std::unordered_map<EdgeID, unsigned> m_forward_edge_id_to_zipped_index_map;
-    std::unordered_map<EdgeID, unsigned> m_reverse_edge_id_to_zipped_index_map;
+    // zipped geometry of every edge by its id, SPECIAL_GEOMETRYID if it has none
+    std::vector<unsigned> m_forward_zipped_index;
+    std::vector<unsigned> m_reverse_zipped_index;
 };
 }
 }
@@ -3,6 +3,7 @@
 #ifndef EDGE_BASED_GRAPH_FACTORY_HPP_
 #define EDGE_BASED_GRAPH_FACTORY_HPP_
 
+#include "extractor/class_data.hpp"
 #include "extractor/compressed_edge_container.hpp"
 #include "extractor/edge_based_edge.hpp"
 #include "extractor/edge_based_node.hpp"
@@ -83,7 +84,7 @@ class EdgeBasedGraphFactory
     EdgeBasedGraphFactory(const EdgeBasedGraphFactory &) = delete;
     EdgeBasedGraphFactory &operator=(const EdgeBasedGraphFactory &) = delete;
 
-    explicit EdgeBasedGraphFactory(std::shared_ptr<util::NodeBasedDynamicGraph> node_based_graph,
+    explicit EdgeBasedGraphFactory(std::shared_ptr<util::NodeBasedStaticGraph> node_based_graph,
                                    CompressedEdgeContainer &compressed_edge_container,
                                    const std::unordered_set<NodeID> &barrier_nodes,
                                    const std::unordered_set<NodeID> &traffic_lights,
@@ -100,13 +101,15 @@ class EdgeBasedGraphFactory
              const std::string &turn_lane_data_filename,
              const std::string &edge_segment_lookup_filename,
              const std::string &edge_penalty_filename,
-             const bool generate_edge_lookup);
+             const bool generate_edge_lookup,
+             const bool hilbert_node_order);
 
     // The following get access functions destroy the content in the factory
     void GetEdgeBasedEdges(util::DeallocatingVector<EdgeBasedEdge> &edges);
     void GetEdgeBasedNodes(std::vector<EdgeBasedNode> &nodes);
     void GetStartPointMarkers(std::vector<bool> &node_is_startpoint);
     void GetEdgeBasedNodeWeights(std::vector<EdgeWeight> &output_node_weights);
+    void GetEdgeBasedNodeClasses(std::vector<ClassData> &output_node_classes);
 
     // These access functions don't destroy the content
     const std::vector<BearingClassID> &GetBearingClassIds() const;
@@ -128,7 +131,7 @@ class EdgeBasedGraphFactory
                                           const double angle) const;
 
   private:
-    using EdgeData = util::NodeBasedDynamicGraph::EdgeData;
+    using EdgeData = util::NodeBasedStaticGraph::EdgeData;
 
     //! maps index from m_edge_based_node_list to ture/false if the node is an entry point to the
     //! graph
@@ -138,13 +141,20 @@ class EdgeBasedGraphFactory
     //! edge-based node
     std::vector<EdgeWeight> m_edge_based_node_weights;
 
+    //! lengths of the segments (node based) represented by the edge-based nodes, they only end
+    //! up in the distances of the edge-based edges
+    std::vector<EdgeDistance> m_edge_based_node_distances;
+
+    //! classes of the segment (node based) represented by the edge-based node
+    std::vector<ClassData> m_edge_based_node_classes;
+
     //! list of edge based nodes (compressed segments)
     std::vector<EdgeBasedNode> m_edge_based_node_list;
     util::DeallocatingVector<EdgeBasedEdge> m_edge_based_edge_list;
     EdgeID m_max_edge_id;
 
     const std::vector<QueryNode> &m_node_info_list;
-    std::shared_ptr<util::NodeBasedDynamicGraph> m_node_based_graph;
+    std::shared_ptr<util::NodeBasedStaticGraph> m_node_based_graph;
     std::shared_ptr<RestrictionMap const> m_restriction_map;
 
     const std::unordered_set<NodeID> &m_barrier_nodes;
@@ -159,7 +169,8 @@ class EdgeBasedGraphFactory
     guidance::LaneDescriptionMap &lane_description_map;
 
     void CompressGeometry();
-    unsigned RenumberEdges();
+    unsigned RenumberEdges(const bool hilbert_order);
+    EdgeDistance GetGeometryDistance(const NodeID node_u, const EdgeID edge) const;
     void GenerateEdgeExpandedNodes();
     void GenerateEdgeExpandedEdges(ScriptingEnvironment &scripting_environment,
                                    const std::string &original_edge_data_filename,
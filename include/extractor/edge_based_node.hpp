@@ -64,6 +64,69 @@ struct EdgeBasedNode
     TravelMode forward_travel_mode : 4;
     TravelMode backward_travel_mode : 4;
 };
+
+/// The part of an EdgeBasedNode that util::StaticRTree stores in its leaves, what the nearest
+/// queries need to filter the segments and measure their distances. The rest of the node is
+/// looked up in the EdgeBasedNodeData of its segment ids, which keeps more segments in a page.
+struct EdgeBasedNodeSegment
+{
+    EdgeBasedNodeSegment()
+        : forward_segment_id{SPECIAL_SEGMENTID, false},
+          reverse_segment_id{SPECIAL_SEGMENTID, false}, u(SPECIAL_NODEID), v(SPECIAL_NODEID),
+          packed_geometry_id(SPECIAL_GEOMETRYID), is_tiny_component(false),
+          fwd_segment_position(std::numeric_limits<unsigned short>::max())
+    {
+    }
+
+    explicit EdgeBasedNodeSegment(const EdgeBasedNode &node)
+        : forward_segment_id(node.forward_segment_id), reverse_segment_id(node.reverse_segment_id),
+          u(node.u), v(node.v), packed_geometry_id(node.packed_geometry_id),
+          is_tiny_component(node.component.is_tiny),
+          fwd_segment_position(node.fwd_segment_position)
+    {
+        BOOST_ASSERT(node.packed_geometry_id <= SPECIAL_GEOMETRYID);
+    }
+
+    SegmentID forward_segment_id;
+    SegmentID reverse_segment_id;
+    NodeID u;
+    NodeID v;
+    unsigned packed_geometry_id : 31;
+    bool is_tiny_component : 1;
+    unsigned short fwd_segment_position;
+};
+static_assert(sizeof(EdgeBasedNodeSegment) == 24, "EdgeBasedNodeSegment is not packed");
+
+/// The data of an edge-based node that its segments in util::StaticRTree leave out, by the id of
+/// the node. Both directions of a street share the name and the component.
+struct EdgeBasedNodeData
+{
+    unsigned name_id = 0;
+    unsigned component_id = INVALID_COMPONENTID;
+    TravelMode travel_mode = TRAVEL_MODE_INACCESSIBLE;
+};
+
+/// The EdgeBasedNode of a segment from the data of its forward and reverse nodes
+inline EdgeBasedNode makeEdgeBasedNode(const EdgeBasedNodeSegment &segment,
+                                       const EdgeBasedNodeData &forward_data,
+                                       const EdgeBasedNodeData &reverse_data)
+{
+    BOOST_ASSERT(segment.forward_segment_id.enabled || segment.reverse_segment_id.enabled);
+    const auto &data = segment.forward_segment_id.enabled ? forward_data : reverse_data;
+    return EdgeBasedNode{segment.forward_segment_id,
+                         segment.reverse_segment_id,
+                         segment.u,
+                         segment.v,
+                         data.name_id,
+                         segment.packed_geometry_id,
+                         segment.is_tiny_component,
+                         data.component_id,
+                         segment.fwd_segment_position,
+                         segment.forward_segment_id.enabled ? forward_data.travel_mode
+                                                            : TRAVEL_MODE_INACCESSIBLE,
+                         segment.reverse_segment_id.enabled ? reverse_data.travel_mode
+                                                            : TRAVEL_MODE_INACCESSIBLE};
+}
 }
 }
 
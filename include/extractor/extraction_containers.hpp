@@ -5,12 +5,15 @@
 #include "extractor/first_and_last_segment_of_way.hpp"
 #include "extractor/guidance/turn_lane_types.hpp"
 #include "extractor/internal_extractor_edge.hpp"
+#include "extractor/osm_node_id_map.hpp"
 #include "extractor/restriction.hpp"
 #include "extractor/scripting_environment.hpp"
 
+#include "util/coordinate.hpp"
+
 #include <cstdint>
 #include <stxxl/vector>
-#include <unordered_map>
+#include <vector>
 
 namespace osrm
 {
@@ -32,6 +35,9 @@ class ExtractionContainers
 #else
     const static unsigned stxxl_memory = ((sizeof(std::size_t) == 4) ? INT_MAX : UINT_MAX);
 #endif
+    // containers whose copy fits into this many bytes are sorted in memory in parallel
+    std::uint64_t in_memory_sort_bytes;
+
     void FlushVectors();
     void PrepareNodes();
     void PrepareRestrictions();
@@ -59,7 +65,9 @@ class ExtractionContainers
     // an adjacency array containing all turn lane masks
     STXXLRestrictionsVector restrictions_list;
     STXXLWayIDStartEndVector way_start_end_id_list;
-    std::unordered_map<OSMNodeID, NodeID> external_to_internal_node_id_map;
+    OSMNodeIDMap external_to_internal_node_id_map;
+    // coordinates of the used nodes by internal id, only kept until the edges are prepared
+    std::vector<util::Coordinate> internal_node_coordinates;
     unsigned max_internal_node_id;
 
     ExtractionContainers();
@@ -1,11 +1,16 @@
 #ifndef EXTRACTION_WAY_HPP
 #define EXTRACTION_WAY_HPP
 
+#include "extractor/class_data.hpp"
 #include "extractor/guidance/road_classification.hpp"
+#include "extractor/guidance/turn_lane_types.hpp"
 #include "extractor/travel_mode.hpp"
+#include "util/exception.hpp"
 #include "util/guidance/turn_lanes.hpp"
 #include "util/typedefs.hpp"
 
+#include <boost/optional.hpp>
+
 #include <string>
 #include <vector>
 
@@ -40,7 +45,10 @@ struct ExtractionWay
         backward_travel_mode = TRAVEL_MODE_INACCESSIBLE;
         turn_lanes_forward.clear();
         turn_lanes_backward.clear();
+        turn_lane_description_forward = boost::none;
+        turn_lane_description_backward = boost::none;
         road_classification = guidance::RoadClassification();
+        classes = 0;
     }
 
     // These accessors exists because it's not possible to take the address of a bitfield,
@@ -50,6 +58,16 @@ struct ExtractionWay
     void set_backward_mode(const TravelMode m) { backward_travel_mode = m; }
     TravelMode get_backward_mode() const { return backward_travel_mode; }
 
+    // Classes are named in the profile, see CLASS_NAMES
+    void set_class(const std::string &name)
+    {
+        const auto class_data = getClass(name);
+        if (class_data == 0)
+            throw util::exception("Unknown class " + name);
+        classes |= class_data;
+    }
+    bool has_class(const std::string &name) const { return classes & getClass(name); }
+
     double forward_speed;
     double backward_speed;
     double duration;
@@ -59,12 +77,16 @@ struct ExtractionWay
     std::string destinations;
     std::string turn_lanes_forward;
     std::string turn_lanes_backward;
+    // the turn lanes parsed into lane masks, if ExtractorCallbacks::ParseTurnLanes was called
+    boost::optional<guidance::TurnLaneDescription> turn_lane_description_forward;
+    boost::optional<guidance::TurnLaneDescription> turn_lane_description_backward;
     bool roundabout;
     bool is_access_restricted;
     bool is_startpoint;
     TravelMode forward_travel_mode : 4;
     TravelMode backward_travel_mode : 4;
     guidance::RoadClassification road_classification;
+    ClassData classes;
 };
 }
 }
@@ -36,6 +36,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "util/guidance/bearing_class.hpp"
 #include "util/guidance/entry_class.hpp"
 #include "util/guidance/turn_lanes.hpp"
+#include "util/phase_profiler.hpp"
 
 #include "util/typedefs.hpp"
 
@@ -70,7 +71,9 @@ class Extractor
     void FindComponents(unsigned max_edge_id,
                         const util::DeallocatingVector<EdgeBasedEdge> &edges,
                         std::vector<EdgeBasedNode> &nodes) const;
-    void BuildRTree(std::vector<EdgeBasedNode> node_based_edge_list,
+    void WriteEdgeBasedNodeData(const EdgeID max_edge_id,
+                                const std::vector<EdgeBasedNode> &node_based_edge_list) const;
+    void BuildRTree(const std::vector<EdgeBasedNode> &node_based_edge_list,
                     std::vector<bool> node_is_startpoint,
                     const std::vector<QueryNode> &internal_to_external_node_map);
     std::shared_ptr<RestrictionMap> LoadRestrictionMap();
@@ -98,6 +101,8 @@ class Extractor
     // example, that genereate a small separation between them. As a result, we might have to
     // augment the turn lane map during processing, further adding more types.
     guidance::LaneDescriptionMap turn_lane_map;
+
+    util::PhaseProfiler phase_profiler;
 };
 }
 }
@@ -74,6 +74,10 @@ class ExtractorCallbacks
     // warning: caller needs to take care of synchronization!
     void ProcessRestriction(const boost::optional<InputRestrictionContainer> &restriction);
 
+    // Parses the turn lane strings of a way. Ways can be parsed concurrently before they are
+    // processed, which only assigns the ids of their descriptions then.
+    static void ParseTurnLanes(ExtractionWay &parsed_way);
+
     // warning: caller needs to take care of synchronization!
     void ProcessWay(const osmium::Way &current_way, const ExtractionWay &result_way);
 
@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <array>
 #include <string>
+#include <vector>
 
 namespace osrm
 {
@@ -40,7 +41,7 @@ namespace extractor
 
 struct ExtractorConfig
 {
-    ExtractorConfig() noexcept : requested_num_threads(0) {}
+    ExtractorConfig() noexcept : requested_num_threads(0), hilbert_node_order(false) {}
     void UseDefaultOutputNames()
     {
         std::string basepath = input_path.string();
@@ -65,20 +66,25 @@ struct ExtractorConfig
         turn_lane_data_file_name = basepath + ".osrm.tld";
         timestamp_file_name = basepath + ".osrm.timestamp";
         geometry_output_path = basepath + ".osrm.geometry";
+        segment_lengths_output_path = basepath + ".osrm.segment_lengths";
         node_output_path = basepath + ".osrm.nodes";
         edge_output_path = basepath + ".osrm.edges";
         edge_graph_output_path = basepath + ".osrm.ebg";
+        edge_based_nodes_output_path = basepath + ".osrm.ebg_nodes";
         rtree_nodes_output_path = basepath + ".osrm.ramIndex";
         rtree_leafs_output_path = basepath + ".osrm.fileIndex";
         edge_segment_lookup_path = basepath + ".osrm.edge_segment_lookup";
         edge_penalty_path = basepath + ".osrm.edge_penalties";
         edge_based_node_weights_output_path = basepath + ".osrm.enw";
+        edge_based_node_classes_output_path = basepath + ".osrm.edge_classes";
         profile_properties_output_path = basepath + ".osrm.properties";
         intersection_class_data_output_path = basepath + ".osrm.icd";
     }
 
     boost::filesystem::path input_path;
     boost::filesystem::path profile_path;
+    // OSM change files applied to the input in order
+    std::vector<boost::filesystem::path> change_paths;
 
     std::string output_file_name;
     std::string restriction_file_name;
@@ -87,19 +93,26 @@ struct ExtractorConfig
     std::string turn_lane_descriptions_file_name;
     std::string timestamp_file_name;
     std::string geometry_output_path;
+    std::string segment_lengths_output_path;
     std::string edge_output_path;
     std::string edge_graph_output_path;
+    std::string edge_based_nodes_output_path;
     std::string edge_based_node_weights_output_path;
+    std::string edge_based_node_classes_output_path;
     std::string node_output_path;
     std::string rtree_nodes_output_path;
     std::string rtree_leafs_output_path;
     std::string profile_properties_output_path;
     std::string intersection_class_data_output_path;
+    // Writes the time, memory and I/O of the phases of the run as JSON to this file if set
+    std::string phase_report_path;
 
     unsigned requested_num_threads;
     unsigned small_component_size;
 
     bool generate_edge_lookup;
+    // Numbers the edge-based nodes along a Hilbert curve instead of in the order of the graph
+    bool hilbert_node_order;
     std::string edge_penalty_path;
     std::string edge_segment_lookup_path;
 };
@@ -20,7 +20,7 @@ namespace extractor
 // generate a visualisation of an intersection, printing the coordinates used for angle calculation
 struct IntersectionPrinter
 {
-    IntersectionPrinter(const util::NodeBasedDynamicGraph &node_based_graph,
+    IntersectionPrinter(const util::NodeBasedStaticGraph &node_based_graph,
                         const std::vector<extractor::QueryNode> &node_coordinates,
                         const extractor::guidance::CoordinateExtractor &coordinate_extractor);
 
@@ -31,7 +31,7 @@ struct IntersectionPrinter
                                  const boost::optional<util::json::Object> &node_style = {},
                                  const boost::optional<util::json::Object> &way_style = {}) const;
 
-    const util::NodeBasedDynamicGraph &node_based_graph;
+    const util::NodeBasedStaticGraph &node_based_graph;
     const std::vector<extractor::QueryNode> &node_coordinates;
     const extractor::guidance::CoordinateExtractor &coordinate_extractor;
 };
@@ -1,6 +1,7 @@
 #ifndef OSRM_EXTRACTOR_COORDINATE_EXTRACTOR_HPP_
 #define OSRM_EXTRACTOR_COORDINATE_EXTRACTOR_HPP_
 
+#include <cstdint>
 #include <vector>
 
 #include "extractor/compressed_edge_container.hpp"
@@ -21,7 +22,7 @@ namespace guidance
 class CoordinateExtractor
 {
   public:
-    CoordinateExtractor(const util::NodeBasedDynamicGraph &node_based_graph,
+    CoordinateExtractor(const util::NodeBasedStaticGraph &node_based_graph,
                         const extractor::CompressedEdgeContainer &compressed_geometries,
                         const std::vector<extractor::QueryNode> &node_coordinates);
 
@@ -36,6 +37,13 @@ class CoordinateExtractor
                                             const NodeID to_node,
                                             const std::uint8_t number_of_in_lanes) const;
 
+    /* Computes the coordinate along every road as seen from the intersections at both of its ends,
+     * with the lane counts of these intersections, in parallel. GetCoordinateAlongRoad returns
+     * them afterwards instead of extracting and analysing the geometry of a road again for every
+     * turn at its intersections. The graph must not change after the call.
+     */
+    void CacheCoordinatesAlongRoads();
+
     // instead of finding only a single coordinate, we can also list all coordinates along a road.
     OSRM_ATTR_WARN_UNUSED
     std::vector<util::Coordinate> GetCoordinatesAlongRoad(const NodeID intersection_node,
@@ -129,10 +137,26 @@ class CoordinateExtractor
                       const double rate) const;
 
   private:
-    const util::NodeBasedDynamicGraph &node_based_graph;
+    const util::NodeBasedStaticGraph &node_based_graph;
     const extractor::CompressedEdgeContainer &compressed_geometries;
     const std::vector<extractor::QueryNode> &node_coordinates;
 
+    // the coordinates along a road seen from its source and from its target, by edge
+    struct CachedRoadCoordinates
+    {
+        util::Coordinate from_source;
+        util::Coordinate from_target;
+    };
+    std::vector<CachedRoadCoordinates> cached_coordinates;
+    // the lane counts of the intersections the cached coordinates are computed for, by node
+    std::vector<std::uint8_t> cached_lanes;
+
+    util::Coordinate ComputeCoordinateAlongRoad(const NodeID intersection_node,
+                                                const EdgeID turn_edge,
+                                                const bool traversed_in_reverse,
+                                                const NodeID to_node,
+                                                const std::uint8_t intersection_lanes) const;
+
     double ComputeInterpolationFactor(const double desired_distance,
                                       const double distance_to_first,
                                       const double distance_to_second) const;
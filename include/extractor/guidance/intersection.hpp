@@ -92,7 +92,7 @@ struct Intersection final : public std::vector<ConnectedRoad>
 
     // given all possible turns, which is the highest connected number of lanes per turn. This value
     // is used, for example, during generation of intersections.
-    std::uint8_t getHighestConnectedLaneCount(const util::NodeBasedDynamicGraph &) const;
+    std::uint8_t getHighestConnectedLaneCount(const util::NodeBasedStaticGraph &) const;
 };
 
 Intersection::const_iterator findClosestTurn(const Intersection &intersection, const double angle);
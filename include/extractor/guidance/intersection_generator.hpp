@@ -7,9 +7,11 @@
 #include "extractor/query_node.hpp"
 #include "extractor/restriction_map.hpp"
 #include "util/attributes.hpp"
+#include "util/coordinate.hpp"
 #include "util/node_based_graph.hpp"
 #include "util/typedefs.hpp"
 
+#include <cstdint>
 #include <unordered_set>
 #include <vector>
 
@@ -19,6 +21,28 @@ namespace extractor
 {
 namespace guidance
 {
+// The parts of an intersection that do not depend on the road it is entered from: the roads
+// leaving the node and the coordinates along them that bearings and turn angles are computed
+// from. Only the angles and the allowed turns depend on the entry, so the shape of a node is
+// computed once for all roads entering it.
+struct IntersectionShape
+{
+    struct Road
+    {
+        EdgeID eid;
+        NodeID to_node;
+        // coordinate along the road, taking lanes into account
+        util::Coordinate coordinate;
+    };
+
+    NodeID node;
+    std::uint8_t lanes;
+    bool is_barrier;
+    // leaving the node is possible on one bidirectional road at most, u-turns are allowed there
+    bool is_dead_end;
+    std::vector<Road> roads;
+};
+
 // The Intersection Generator is given a turn location and generates an intersection representation
 // from it. For this all turn possibilities are analysed.
 // We consider turn restrictions to indicate possible turns. U-turns are generated based on profile
@@ -26,7 +50,7 @@ namespace guidance
 class IntersectionGenerator
 {
   public:
-    IntersectionGenerator(const util::NodeBasedDynamicGraph &node_based_graph,
+    IntersectionGenerator(const util::NodeBasedStaticGraph &node_based_graph,
                           const RestrictionMap &restriction_map,
                           const std::unordered_set<NodeID> &barrier_nodes,
                           const std::vector<QueryNode> &node_info_list,
@@ -54,14 +78,25 @@ class IntersectionGenerator
     OSRM_ATTR_WARN_UNUSED
     Intersection GetConnectedRoads(const NodeID from_node, const EdgeID via_eid) const;
 
+    // The same for the shape of the node reached via `via_eid`, to analyse all roads entering a
+    // node without recomputing its shape
+    OSRM_ATTR_WARN_UNUSED
+    Intersection GetConnectedRoads(const NodeID from_node,
+                                   const EdgeID via_eid,
+                                   const IntersectionShape &shape) const;
+
+    OSRM_ATTR_WARN_UNUSED
+    IntersectionShape ComputeIntersectionShape(const NodeID node) const;
+
   private:
-    const util::NodeBasedDynamicGraph &node_based_graph;
+    const util::NodeBasedStaticGraph &node_based_graph;
     const RestrictionMap &restriction_map;
     const std::unordered_set<NodeID> &barrier_nodes;
     const std::vector<QueryNode> &node_info_list;
 
-    // own state, used to find the correct coordinates along a road
-    const CoordinateExtractor coordinate_extractor;
+    // own state, used to find the correct coordinates along a road. The coordinates along all
+    // roads are cached when the generator is set up.
+    CoordinateExtractor coordinate_extractor;
 };
 
 } // namespace guidance
@@ -26,7 +26,7 @@ namespace guidance
 class IntersectionHandler
 {
   public:
-    IntersectionHandler(const util::NodeBasedDynamicGraph &node_based_graph,
+    IntersectionHandler(const util::NodeBasedStaticGraph &node_based_graph,
                         const std::vector<QueryNode> &node_info_list,
                         const util::NameTable &name_table,
                         const SuffixTable &street_name_suffix_table,
@@ -43,7 +43,7 @@ class IntersectionHandler
     operator()(const NodeID nid, const EdgeID via_eid, Intersection intersection) const = 0;
 
   protected:
-    const util::NodeBasedDynamicGraph &node_based_graph;
+    const util::NodeBasedStaticGraph &node_based_graph;
     const std::vector<QueryNode> &node_info_list;
     const util::NameTable &name_table;
     const SuffixTable &street_name_suffix_table;
@@ -36,7 +36,7 @@ namespace guidance
 class IntersectionNormalizer
 {
   public:
-    IntersectionNormalizer(const util::NodeBasedDynamicGraph &node_based_graph,
+    IntersectionNormalizer(const util::NodeBasedStaticGraph &node_based_graph,
                            const std::vector<extractor::QueryNode> &node_coordinates,
                            const util::NameTable &name_table,
                            const SuffixTable &street_name_suffix_table,
@@ -48,7 +48,7 @@ class IntersectionNormalizer
     Intersection operator()(const NodeID node_at_intersection, Intersection intersection) const;
 
   private:
-    const util::NodeBasedDynamicGraph &node_based_graph;
+    const util::NodeBasedStaticGraph &node_based_graph;
     const std::vector<extractor::QueryNode> &node_coordinates;
     const util::NameTable &name_table;
     const SuffixTable &street_name_suffix_table;
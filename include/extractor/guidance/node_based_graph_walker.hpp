@@ -28,7 +28,7 @@ namespace guidance
 class NodeBasedGraphWalker
 {
   public:
-    NodeBasedGraphWalker(const util::NodeBasedDynamicGraph &node_based_graph,
+    NodeBasedGraphWalker(const util::NodeBasedStaticGraph &node_based_graph,
                          const IntersectionGenerator &intersection_generator);
 
     /*
@@ -46,7 +46,7 @@ class NodeBasedGraphWalker
                                                             const selector_type &selector);
 
   private:
-    const util::NodeBasedDynamicGraph &node_based_graph;
+    const util::NodeBasedStaticGraph &node_based_graph;
     const IntersectionGenerator &intersection_generator;
 };
 
@@ -58,7 +58,7 @@ struct LengthLimitedCoordinateAccumulator
 {
     LengthLimitedCoordinateAccumulator(
         const extractor::guidance::CoordinateExtractor &coordinate_extractor,
-        const util::NodeBasedDynamicGraph &node_based_graph,
+        const util::NodeBasedStaticGraph &node_based_graph,
         const double max_length);
 
     /*
@@ -80,7 +80,7 @@ struct LengthLimitedCoordinateAccumulator
     void update(const NodeID from_node, const EdgeID via_edge, const NodeID to_node);
 
     const extractor::guidance::CoordinateExtractor &coordinate_extractor;
-    const util::NodeBasedDynamicGraph &node_based_graph;
+    const util::NodeBasedStaticGraph &node_based_graph;
     const double max_length;
     double accumulated_length;
     std::vector<util::Coordinate> coordinates;
@@ -107,7 +107,7 @@ struct SelectRoadByNameOnlyChoiceAndStraightness
     boost::optional<EdgeID> operator()(const NodeID nid,
                                        const EdgeID via_edge_id,
                                        const Intersection &intersection,
-                                       const util::NodeBasedDynamicGraph &node_based_graph) const;
+                                       const util::NodeBasedStaticGraph &node_based_graph) const;
 
     const NameID desired_name_id;
     const bool requires_entry;
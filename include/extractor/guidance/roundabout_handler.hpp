@@ -41,7 +41,7 @@ struct RoundaboutFlags
 class RoundaboutHandler : public IntersectionHandler
 {
   public:
-    RoundaboutHandler(const util::NodeBasedDynamicGraph &node_based_graph,
+    RoundaboutHandler(const util::NodeBasedStaticGraph &node_based_graph,
                       const std::vector<QueryNode> &node_info_list,
                       const CompressedEdgeContainer &compressed_edge_container,
                       const util::NameTable &name_table,
@@ -89,7 +89,7 @@ class RoundaboutHandler : public IntersectionHandler
     const CompressedEdgeContainer &compressed_edge_container;
     const ProfileProperties &profile_properties;
 
-    const CoordinateExtractor coordinate_extractor;
+    const CoordinateExtractor &coordinate_extractor;
 };
 
 } // namespace guidance
@@ -224,7 +224,7 @@ leastSquareRegression(const std::vector<util::Coordinate> &coordinates)
 }
 
 inline std::uint8_t getLaneCountAtIntersection(const NodeID intersection_node,
-                                               const util::NodeBasedDynamicGraph &node_based_graph)
+                                               const util::NodeBasedStaticGraph &node_based_graph)
 {
     std::uint8_t lanes = 0;
     for (const EdgeID onto_edge : node_based_graph.GetAdjacentEdgeRange(intersection_node))
@@ -38,7 +38,7 @@ class TurnAnalysis
 {
 
   public:
-    TurnAnalysis(const util::NodeBasedDynamicGraph &node_based_graph,
+    TurnAnalysis(const util::NodeBasedStaticGraph &node_based_graph,
                  const std::vector<QueryNode> &node_info_list,
                  const RestrictionMap &restriction_map,
                  const std::unordered_set<NodeID> &barrier_nodes,
@@ -55,6 +55,12 @@ class TurnAnalysis
     OSRM_ATTR_WARN_UNUSED
     Intersection operator()(const NodeID from_node, const EdgeID via_eid) const;
 
+    // The same for the shape of the node reached via `via_eid`, see IntersectionShape
+    OSRM_ATTR_WARN_UNUSED
+    Intersection operator()(const NodeID from_node,
+                            const EdgeID via_eid,
+                            const IntersectionShape &shape) const;
+
     /*
      * Post-Processing a generated intersection is useful for any intersection that was simply
      * generated using an intersection generator. In the normal use case, you don't have to call
@@ -71,7 +77,7 @@ class TurnAnalysis
     const IntersectionGenerator &GetIntersectionGenerator() const;
 
   private:
-    const util::NodeBasedDynamicGraph &node_based_graph;
+    const util::NodeBasedStaticGraph &node_based_graph;
     const IntersectionGenerator intersection_generator;
     const IntersectionNormalizer intersection_normalizer;
     const RoundaboutHandler roundabout_handler;
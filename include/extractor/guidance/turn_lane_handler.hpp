@@ -14,7 +14,6 @@
 #include "util/node_based_graph.hpp"
 #include "util/typedefs.hpp"
 
-#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <map>
@@ -69,27 +68,34 @@ class TurnLaneHandler
   public:
     typedef std::vector<TurnLaneData> LaneDataVector;
 
-    TurnLaneHandler(const util::NodeBasedDynamicGraph &node_based_graph,
-                    std::vector<std::uint32_t> &turn_lane_offsets,
-                    std::vector<TurnLaneType::Mask> &turn_lane_masks,
-                    LaneDescriptionMap &lane_description_map,
+    // The lane descriptions are only read. Descriptions combined for sliproads that are not among
+    // them are added to combined_lane_descriptions, numbered after the lane descriptions. Handlers
+    // with their own combined descriptions and id map can run concurrently.
+    TurnLaneHandler(const util::NodeBasedStaticGraph &node_based_graph,
+                    const std::vector<std::uint32_t> &turn_lane_offsets,
+                    const std::vector<TurnLaneType::Mask> &turn_lane_masks,
+                    const LaneDescriptionMap &lane_description_map,
+                    LaneDescriptionMap &combined_lane_descriptions,
                     const TurnAnalysis &turn_analysis,
                     LaneDataIdMap &id_map);
 
-    ~TurnLaneHandler();
-
     OSRM_ATTR_WARN_UNUSED
     Intersection assignTurnLanes(const NodeID at, const EdgeID via_edge, Intersection intersection);
 
+    std::size_t GetHandledCount() const { return count_handled; }
+    std::size_t GetCalledCount() const { return count_called; }
+
   private:
-    mutable std::atomic<std::size_t> count_handled;
-    mutable std::atomic<std::size_t> count_called;
+    // every thread uses a handler of its own, the counts need no synchronization
+    std::size_t count_handled;
+    std::size_t count_called;
     // we need to be able to look at previous intersections to, in some cases, find the correct turn
     // lanes for a turn
-    const util::NodeBasedDynamicGraph &node_based_graph;
-    std::vector<std::uint32_t> &turn_lane_offsets;
-    std::vector<TurnLaneType::Mask> &turn_lane_masks;
-    LaneDescriptionMap &lane_description_map;
+    const util::NodeBasedStaticGraph &node_based_graph;
+    const std::vector<std::uint32_t> &turn_lane_offsets;
+    const std::vector<TurnLaneType::Mask> &turn_lane_masks;
+    const LaneDescriptionMap &lane_description_map;
+    LaneDescriptionMap &combined_lane_descriptions;
     const TurnAnalysis &turn_analysis;
     LaneDataIdMap &id_map;
 
@@ -51,7 +51,8 @@ struct InternalExtractorEdge
                  TRAVEL_MODE_INACCESSIBLE,
                  false,
                  guidance::TurnLaneType::empty,
-                 guidance::RoadClassification())
+                 guidance::RoadClassification(),
+                 0)
     {
     }
 
@@ -67,7 +68,8 @@ struct InternalExtractorEdge
                                    TravelMode travel_mode,
                                    bool is_split,
                                    LaneDescriptionID lane_description,
-                                   guidance::RoadClassification road_classification)
+                                   guidance::RoadClassification road_classification,
+                                   ClassData classes)
         : result(source,
                  target,
                  name_id,
@@ -80,7 +82,8 @@ struct InternalExtractorEdge
                  travel_mode,
                  is_split,
                  lane_description,
-                 std::move(road_classification)),
+                 std::move(road_classification),
+                 classes),
           weight_data(std::move(weight_data))
     {
     }
@@ -107,7 +110,8 @@ struct InternalExtractorEdge
                                      TRAVEL_MODE_INACCESSIBLE,
                                      false,
                                      INVALID_LANE_DESCRIPTIONID,
-                                     guidance::RoadClassification());
+                                     guidance::RoadClassification(),
+                                     0);
     }
     static InternalExtractorEdge max_osm_value()
     {
@@ -123,7 +127,8 @@ struct InternalExtractorEdge
                                      TRAVEL_MODE_INACCESSIBLE,
                                      false,
                                      INVALID_LANE_DESCRIPTIONID,
-                                     guidance::RoadClassification());
+                                     guidance::RoadClassification(),
+                                     0);
     }
 
     static InternalExtractorEdge min_internal_value()
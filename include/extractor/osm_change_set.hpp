@@ -0,0 +1,50 @@
+#ifndef OSRM_EXTRACTOR_OSM_CHANGE_SET_HPP_
+#define OSRM_EXTRACTOR_OSM_CHANGE_SET_HPP_
+
+#include <boost/filesystem/path.hpp>
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+// The latest versions of the objects in a list of OSM change files (.osc), applied to the input
+// file while it is read. Input objects that were changed or deleted are skipped, the latest
+// versions of all changed objects that were not deleted are processed after the input.
+class OSMChangeSet final
+{
+  public:
+    explicit OSMChangeSet(const std::vector<boost::filesystem::path> &change_paths);
+
+    // check whether the input object was modified or deleted by a change
+    bool IsChanged(const osmium::OSMEntity &entity) const;
+
+    // moves the latest visible versions, ordered by type and id, out of the change set
+    osmium::memory::Buffer MoveOutVisibleObjects();
+
+    std::size_t GetNumberOfChanged() const { return changed_objects.size(); }
+    std::size_t GetNumberOfDeleted() const { return number_of_deleted; }
+    // the time of the latest change, invalid if the change files have no timestamps
+    osmium::Timestamp GetLatestTimestamp() const { return latest_timestamp; }
+
+  private:
+    std::vector<std::pair<osmium::item_type, osmium::object_id_type>> changed_objects;
+    osmium::memory::Buffer visible_objects;
+    std::size_t number_of_deleted;
+    osmium::Timestamp latest_timestamp;
+};
+
+} /* namespace extractor */
+} /* namespace osrm */
+
+#endif /* OSRM_EXTRACTOR_OSM_CHANGE_SET_HPP_ */
@@ -0,0 +1,99 @@
+#ifndef OSM_NODE_ID_MAP_HPP
+#define OSM_NODE_ID_MAP_HPP
+
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+/**
+ * Dense mapping of the OSM ids of the used nodes to internal node ids.
+ *
+ * The ids are appended in ascending order and the internal id of a node is its position.
+ * The ids are partitioned into buckets by their high bits after subtracting the smallest id,
+ * a lookup only binary searches the few ids of its bucket. Lookups are safe to do concurrently.
+ */
+class OSMNodeIDMap
+{
+    // average number of ids per bucket
+    static constexpr std::uint64_t IDS_PER_BUCKET = 4;
+
+  public:
+    void Reserve(const std::size_t size) { osm_node_ids.reserve(size); }
+
+    void PushBack(const OSMNodeID osm_node_id)
+    {
+        BOOST_ASSERT(osm_node_ids.empty() || osm_node_ids.back() < osm_node_id);
+        osm_node_ids.push_back(osm_node_id);
+    }
+
+    // Has to be called after the last id was pushed and before the first lookup
+    void BuildIndex()
+    {
+        bucket_offsets.clear();
+        if (osm_node_ids.empty())
+            return;
+
+        min_id = static_cast<std::uint64_t>(osm_node_ids.front());
+        const std::uint64_t range = static_cast<std::uint64_t>(osm_node_ids.back()) - min_id;
+
+        unsigned range_bits = 0;
+        while (range_bits < 64 && (range >> range_bits) != 0)
+            ++range_bits;
+        unsigned bucket_bits = 0;
+        while ((std::uint64_t{1} << bucket_bits) * IDS_PER_BUCKET < osm_node_ids.size())
+            ++bucket_bits;
+        shift = range_bits > bucket_bits ? range_bits - bucket_bits : 0;
+
+        // counting pass over the sorted ids, followed by the prefix sum of the bucket sizes
+        bucket_offsets.resize((range >> shift) + 2, 0);
+        for (const auto osm_node_id : osm_node_ids)
+            ++bucket_offsets[getBucket(osm_node_id) + 1];
+        std::partial_sum(bucket_offsets.begin(), bucket_offsets.end(), bucket_offsets.begin());
+    }
+
+    // Returns SPECIAL_NODEID for ids of nodes that are not used
+    NodeID Find(const OSMNodeID osm_node_id) const
+    {
+        if (bucket_offsets.empty() || static_cast<std::uint64_t>(osm_node_id) < min_id)
+            return SPECIAL_NODEID;
+
+        const auto bucket = getBucket(osm_node_id);
+        if (bucket + 1 >= bucket_offsets.size())
+            return SPECIAL_NODEID;
+
+        const auto begin = osm_node_ids.begin() + bucket_offsets[bucket];
+        const auto end = osm_node_ids.begin() + bucket_offsets[bucket + 1];
+        const auto iter = std::lower_bound(begin, end, osm_node_id);
+        if (iter == end || *iter != osm_node_id)
+            return SPECIAL_NODEID;
+
+        return static_cast<NodeID>(iter - osm_node_ids.begin());
+    }
+
+    std::size_t Size() const { return osm_node_ids.size(); }
+
+  private:
+    std::uint64_t getBucket(const OSMNodeID osm_node_id) const
+    {
+        return (static_cast<std::uint64_t>(osm_node_id) - min_id) >> shift;
+    }
+
+    std::vector<OSMNodeID> osm_node_ids;
+    std::vector<std::size_t> bucket_offsets;
+    std::uint64_t min_id = 0;
+    unsigned shift = 0;
+};
+}
+}
+
+#endif // OSM_NODE_ID_MAP_HPP
@@ -0,0 +1,465 @@
+#ifndef PARALLEL_SCC_HPP
+#define PARALLEL_SCC_HPP
+
+#include "util/simple_logger.hpp"
+#include "util/timing_util.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+/**
+ * Computes the strongly connected components of a graph in parallel, with the same interface
+ * as TarjanSCC. The component ids are deterministic but numbered differently.
+ *
+ * The unassigned nodes are split into weakly connected components by a concurrent union-find.
+ * Small weak components are searched by Tarjan's algorithm, one task per weak component.
+ * Large ones are split by the forward-backward algorithm: the nodes reachable from a pivot that
+ * also reach it form the component of the pivot. The rest goes into the next round.
+ * Everything is iterative and the memory stays linear in the size of the graph.
+ */
+template <typename GraphT> class ParallelSCC
+{
+    // weak components up to this size are searched by a single task
+    static constexpr std::size_t MAX_TARJAN_COMPONENT_SIZE = 1 << 16;
+    // frontiers up to this size are expanded serially
+    static constexpr std::size_t MAX_SERIAL_FRONTIER_SIZE = 1 << 10;
+
+    static constexpr std::uint8_t FORWARD_REACHED = 1;
+    static constexpr std::uint8_t BACKWARD_REACHED = 2;
+
+    struct TarjanFrame
+    {
+        NodeID node;
+        typename GraphT::EdgeIterator edge;
+        typename GraphT::EdgeIterator end;
+    };
+
+    std::vector<unsigned> components_index;
+    std::vector<NodeID> component_size_vector;
+    std::shared_ptr<const GraphT> m_graph;
+    std::size_t size_one_counter;
+
+    // the node of each strongly connected component that represents it, SPECIAL_NODEID while
+    // the node is not assigned to a component
+    std::vector<NodeID> representative;
+    std::vector<std::atomic<NodeID>> union_find_parent;
+    std::vector<unsigned> tarjan_index;
+    std::vector<unsigned> tarjan_low_link;
+    std::vector<std::atomic<std::uint8_t>> reached;
+    // incoming edges of every node, only built if a large weak component exists
+    std::vector<std::uint64_t> reverse_offsets;
+    std::vector<NodeID> reverse_sources;
+
+  public:
+    ParallelSCC(std::shared_ptr<const GraphT> graph)
+        : components_index(graph->GetNumberOfNodes(), SPECIAL_NODEID), m_graph(graph),
+          size_one_counter(0)
+    {
+        BOOST_ASSERT(m_graph->GetNumberOfNodes() > 0);
+    }
+
+    void Run()
+    {
+        TIMER_START(SCC_RUN);
+        const NodeID number_of_nodes = m_graph->GetNumberOfNodes();
+
+        representative.assign(number_of_nodes, SPECIAL_NODEID);
+        union_find_parent = std::vector<std::atomic<NodeID>>(number_of_nodes);
+        tarjan_index.assign(number_of_nodes, SPECIAL_NODEID);
+        tarjan_low_link.assign(number_of_nodes, SPECIAL_NODEID);
+
+        std::vector<NodeID> active_nodes(number_of_nodes);
+        tbb::parallel_for(tbb::blocked_range<NodeID>(0, number_of_nodes),
+                          [&](const tbb::blocked_range<NodeID> &range) {
+                              for (auto node = range.begin(); node != range.end(); ++node)
+                                  active_nodes[node] = node;
+                          });
+
+        std::vector<NodeID> next_active_nodes;
+        while (!active_nodes.empty())
+        {
+            // weak components as ranges of the grouped nodes
+            std::vector<NodeID> grouped_nodes;
+            std::vector<std::size_t> group_offsets;
+            groupWeakComponents(active_nodes, grouped_nodes, group_offsets);
+            active_nodes.clear();
+            active_nodes.shrink_to_fit();
+
+            const auto number_of_groups = group_offsets.size() - 1;
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_groups, 1),
+                              [&](const tbb::blocked_range<std::size_t> &range) {
+                                  for (auto group = range.begin(); group != range.end(); ++group)
+                                  {
+                                      const auto begin = group_offsets[group];
+                                      const auto end = group_offsets[group + 1];
+                                      if (end - begin <= MAX_TARJAN_COMPONENT_SIZE)
+                                          runTarjan(grouped_nodes, begin, end);
+                                  }
+                              });
+
+            next_active_nodes.clear();
+            for (std::size_t group = 0; group < number_of_groups; ++group)
+            {
+                const auto begin = group_offsets[group];
+                const auto end = group_offsets[group + 1];
+                if (end - begin <= MAX_TARJAN_COMPONENT_SIZE)
+                    continue;
+
+                splitLargeComponent(grouped_nodes, begin, end);
+                std::copy_if(grouped_nodes.begin() + begin,
+                             grouped_nodes.begin() + end,
+                             std::back_inserter(next_active_nodes),
+                             [&](const NodeID node) {
+                                 return representative[node] == SPECIAL_NODEID;
+                             });
+            }
+            active_nodes.swap(next_active_nodes);
+        }
+
+        numberComponents();
+
+        std::vector<NodeID>().swap(representative);
+        std::vector<std::atomic<NodeID>>().swap(union_find_parent);
+        std::vector<unsigned>().swap(tarjan_index);
+        std::vector<unsigned>().swap(tarjan_low_link);
+        std::vector<std::atomic<std::uint8_t>>().swap(reached);
+        std::vector<std::uint64_t>().swap(reverse_offsets);
+        std::vector<NodeID>().swap(reverse_sources);
+
+        TIMER_STOP(SCC_RUN);
+        util::SimpleLogger().Write() << "SCC run took: " << TIMER_MSEC(SCC_RUN) / 1000. << "s";
+    }
+
+    std::size_t GetNumberOfComponents() const { return component_size_vector.size(); }
+
+    std::size_t GetSizeOneCount() const { return size_one_counter; }
+
+    unsigned GetComponentSize(const unsigned component_id) const
+    {
+        return component_size_vector[component_id];
+    }
+
+    unsigned GetComponentID(const NodeID node) const { return components_index[node]; }
+
+  private:
+    NodeID findRoot(NodeID node)
+    {
+        while (true)
+        {
+            NodeID parent = union_find_parent[node].load();
+            if (parent == node)
+                return node;
+            const NodeID grand_parent = union_find_parent[parent].load();
+            // path halving, losing the race only costs a longer path
+            if (parent != grand_parent)
+                union_find_parent[node].compare_exchange_weak(parent, grand_parent);
+            node = grand_parent;
+        }
+    }
+
+    void unite(NodeID first, NodeID second)
+    {
+        while (true)
+        {
+            first = findRoot(first);
+            second = findRoot(second);
+            if (first == second)
+                return;
+            // roots always point to smaller ids, so no cycles can form
+            if (first < second)
+                std::swap(first, second);
+            NodeID expected = first;
+            if (union_find_parent[first].compare_exchange_strong(expected, second))
+                return;
+        }
+    }
+
+    // Groups the nodes by the weak components of the subgraph induced by them
+    void groupWeakComponents(const std::vector<NodeID> &nodes,
+                             std::vector<NodeID> &grouped_nodes,
+                             std::vector<std::size_t> &group_offsets)
+    {
+        const tbb::blocked_range<std::size_t> node_range(0, nodes.size());
+        tbb::parallel_for(node_range, [&](const tbb::blocked_range<std::size_t> &range) {
+            for (auto index = range.begin(); index != range.end(); ++index)
+                union_find_parent[nodes[index]].store(nodes[index]);
+        });
+        tbb::parallel_for(node_range, [&](const tbb::blocked_range<std::size_t> &range) {
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                const auto node = nodes[index];
+                for (const auto edge : m_graph->GetAdjacentEdgeRange(node))
+                {
+                    const auto target = m_graph->GetTarget(edge);
+                    if (representative[target] == SPECIAL_NODEID)
+                        unite(node, target);
+                }
+            }
+        });
+
+        std::vector<std::pair<NodeID, NodeID>> root_and_node(nodes.size());
+        tbb::parallel_for(node_range, [&](const tbb::blocked_range<std::size_t> &range) {
+            for (auto index = range.begin(); index != range.end(); ++index)
+                root_and_node[index] = std::make_pair(findRoot(nodes[index]), nodes[index]);
+        });
+        tbb::parallel_sort(root_and_node.begin(), root_and_node.end());
+
+        grouped_nodes.resize(nodes.size());
+        group_offsets.clear();
+        for (std::size_t index = 0; index < root_and_node.size(); ++index)
+        {
+            if (index == 0 || root_and_node[index].first != root_and_node[index - 1].first)
+                group_offsets.push_back(index);
+            grouped_nodes[index] = root_and_node[index].second;
+        }
+        group_offsets.push_back(root_and_node.size());
+    }
+
+    // Iterative Tarjan on one weak component. All edges to unassigned nodes stay inside of it,
+    // so concurrent searches on other weak components never touch the same nodes.
+    void runTarjan(const std::vector<NodeID> &grouped_nodes,
+                   const std::size_t begin,
+                   const std::size_t end)
+    {
+        std::vector<TarjanFrame> call_stack;
+        std::vector<NodeID> tarjan_stack;
+        unsigned index = 0;
+
+        const auto visit = [&](const NodeID node) {
+            tarjan_index[node] = index;
+            tarjan_low_link[node] = index;
+            ++index;
+            tarjan_stack.push_back(node);
+            call_stack.push_back({node, m_graph->BeginEdges(node), m_graph->EndEdges(node)});
+        };
+
+        for (auto position = begin; position != end; ++position)
+        {
+            if (tarjan_index[grouped_nodes[position]] != SPECIAL_NODEID)
+                continue;
+
+            visit(grouped_nodes[position]);
+            while (!call_stack.empty())
+            {
+                auto &frame = call_stack.back();
+                const auto node = frame.node;
+                if (frame.edge != frame.end)
+                {
+                    const auto target = m_graph->GetTarget(frame.edge);
+                    ++frame.edge;
+                    // nodes that are visited but not assigned yet are on the stack
+                    if (representative[target] != SPECIAL_NODEID)
+                        continue;
+                    if (tarjan_index[target] == SPECIAL_NODEID)
+                        visit(target);
+                    else
+                        tarjan_low_link[node] =
+                            std::min(tarjan_low_link[node], tarjan_index[target]);
+                    continue;
+                }
+
+                call_stack.pop_back();
+                if (tarjan_low_link[node] == tarjan_index[node])
+                {
+                    NodeID member;
+                    do
+                    {
+                        member = tarjan_stack.back();
+                        tarjan_stack.pop_back();
+                        representative[member] = node;
+                    } while (member != node);
+                }
+                if (!call_stack.empty())
+                {
+                    const auto parent = call_stack.back().node;
+                    tarjan_low_link[parent] =
+                        std::min(tarjan_low_link[parent], tarjan_low_link[node]);
+                }
+            }
+        }
+    }
+
+    void buildReverseEdges()
+    {
+        const NodeID number_of_nodes = m_graph->GetNumberOfNodes();
+        const tbb::blocked_range<NodeID> all_nodes(0, number_of_nodes);
+
+        std::vector<std::atomic<std::uint64_t>> cursor(number_of_nodes + 1);
+        tbb::parallel_for(all_nodes, [&](const tbb::blocked_range<NodeID> &range) {
+            for (auto node = range.begin(); node != range.end(); ++node)
+                cursor[node + 1].store(0);
+        });
+        cursor[0].store(0);
+        tbb::parallel_for(all_nodes, [&](const tbb::blocked_range<NodeID> &range) {
+            for (auto node = range.begin(); node != range.end(); ++node)
+                for (const auto edge : m_graph->GetAdjacentEdgeRange(node))
+                    cursor[m_graph->GetTarget(edge) + 1].fetch_add(1);
+        });
+
+        reverse_offsets.resize(number_of_nodes + 1);
+        std::uint64_t sum = 0;
+        for (NodeID node = 0; node <= number_of_nodes; ++node)
+        {
+            sum += cursor[node].load();
+            reverse_offsets[node] = sum;
+            cursor[node].store(sum);
+        }
+
+        reverse_sources.resize(sum);
+        tbb::parallel_for(all_nodes, [&](const tbb::blocked_range<NodeID> &range) {
+            for (auto node = range.begin(); node != range.end(); ++node)
+                for (const auto edge : m_graph->GetAdjacentEdgeRange(node))
+                    reverse_sources[cursor[m_graph->GetTarget(edge)].fetch_add(1)] = node;
+        });
+
+        reached = std::vector<std::atomic<std::uint8_t>>(number_of_nodes);
+        tbb::parallel_for(all_nodes, [&](const tbb::blocked_range<NodeID> &range) {
+            for (auto node = range.begin(); node != range.end(); ++node)
+                reached[node].store(0);
+        });
+    }
+
+    // Level synchronous search over the unassigned nodes, marking them with the flag
+    template <typename ForEachNeighbourT>
+    void markReachable(const NodeID source,
+                       const std::uint8_t flag,
+                       const ForEachNeighbourT &for_each_neighbour)
+    {
+        std::vector<NodeID> frontier(1, source);
+        reached[source].fetch_or(flag);
+
+        tbb::enumerable_thread_specific<std::vector<NodeID>> next_frontiers;
+        const auto expand = [&](const NodeID node, std::vector<NodeID> &next_frontier) {
+            for_each_neighbour(node, [&](const NodeID neighbour) {
+                if (representative[neighbour] == SPECIAL_NODEID &&
+                    !(reached[neighbour].fetch_or(flag) & flag))
+                    next_frontier.push_back(neighbour);
+            });
+        };
+
+        std::vector<NodeID> next_frontier;
+        while (!frontier.empty())
+        {
+            if (frontier.size() <= MAX_SERIAL_FRONTIER_SIZE)
+            {
+                for (const auto node : frontier)
+                    expand(node, next_frontier);
+            }
+            else
+            {
+                tbb::parallel_for(tbb::blocked_range<std::size_t>(0, frontier.size()),
+                                  [&](const tbb::blocked_range<std::size_t> &range) {
+                                      auto &local_frontier = next_frontiers.local();
+                                      for (auto index = range.begin(); index != range.end();
+                                           ++index)
+                                          expand(frontier[index], local_frontier);
+                                  });
+                for (auto &local_frontier : next_frontiers)
+                {
+                    next_frontier.insert(
+                        next_frontier.end(), local_frontier.begin(), local_frontier.end());
+                    local_frontier.clear();
+                }
+            }
+            frontier.swap(next_frontier);
+            next_frontier.clear();
+        }
+    }
+
+    // Assigns the strongly connected component of a pivot by a forward and a backward search
+    void splitLargeComponent(const std::vector<NodeID> &grouped_nodes,
+                             const std::size_t begin,
+                             const std::size_t end)
+    {
+        if (reverse_offsets.empty())
+            buildReverseEdges();
+
+        // most nodes of road networks are in one component, which well connected nodes are in
+        const auto pivot = *std::max_element(
+            grouped_nodes.begin() + begin,
+            grouped_nodes.begin() + end,
+            [&](const NodeID lhs, const NodeID rhs) {
+                return std::make_pair(getDegree(lhs), rhs) < std::make_pair(getDegree(rhs), lhs);
+            });
+
+        markReachable(pivot, FORWARD_REACHED, [&](const NodeID node, const auto &callback) {
+            for (const auto edge : m_graph->GetAdjacentEdgeRange(node))
+                callback(m_graph->GetTarget(edge));
+        });
+        markReachable(pivot, BACKWARD_REACHED, [&](const NodeID node, const auto &callback) {
+            for (auto edge = reverse_offsets[node]; edge != reverse_offsets[node + 1]; ++edge)
+                callback(reverse_sources[edge]);
+        });
+
+        // the searches never leave the weak component, so resetting its nodes suffices
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(begin, end),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              for (auto index = range.begin(); index != range.end(); ++index)
+                              {
+                                  const auto node = grouped_nodes[index];
+                                  if (reached[node].exchange(0) ==
+                                      (FORWARD_REACHED | BACKWARD_REACHED))
+                                      representative[node] = pivot;
+                              }
+                          });
+    }
+
+    std::uint64_t getDegree(const NodeID node) const
+    {
+        const std::uint64_t out_degree = m_graph->GetOutDegree(node);
+        const std::uint64_t in_degree = reverse_offsets[node + 1] - reverse_offsets[node];
+        return std::min(out_degree, in_degree);
+    }
+
+    // Numbers the components in the order of their representatives
+    void numberComponents()
+    {
+        const NodeID number_of_nodes = m_graph->GetNumberOfNodes();
+        component_size_vector.clear();
+        for (NodeID node = 0; node < number_of_nodes; ++node)
+        {
+            BOOST_ASSERT(representative[node] != SPECIAL_NODEID);
+            if (representative[node] == node)
+            {
+                components_index[node] = component_size_vector.size();
+                component_size_vector.push_back(0);
+            }
+        }
+
+        tbb::parallel_for(tbb::blocked_range<NodeID>(0, number_of_nodes),
+                          [&](const tbb::blocked_range<NodeID> &range) {
+                              for (auto node = range.begin(); node != range.end(); ++node)
+                                  if (representative[node] != node)
+                                      components_index[node] =
+                                          components_index[representative[node]];
+                          });
+        for (NodeID node = 0; node < number_of_nodes; ++node)
+            ++component_size_vector[components_index[node]];
+
+        size_one_counter = std::count_if(component_size_vector.begin(),
+                                         component_size_vector.end(),
+                                         [](unsigned value) { return 1 == value; });
+    }
+};
+}
+}
+
+#endif /* PARALLEL_SCC_HPP */
@@ -15,7 +15,8 @@ struct ProfileProperties
     ProfileProperties()
         : traffic_signal_penalty(0), u_turn_penalty(0),
           max_speed_for_map_matching(DEFAULT_MAX_SPEED), continue_straight_at_waypoint(true),
-          use_turn_restrictions(false), left_hand_driving(false)
+          use_turn_restrictions(false), left_hand_driving(false), cache_way_results(false),
+          sample_turn_function(false)
     {
     }
 
@@ -48,6 +49,10 @@ struct ProfileProperties
     bool continue_straight_at_waypoint;
     bool use_turn_restrictions;
     bool left_hand_driving;
+    //! way_function only depends on the tags, results are reused for ways with the same tags
+    bool cache_way_results;
+    //! turn_function only depends on the angle, it is sampled once instead of called per turn
+    bool sample_turn_function;
 };
 }
 }
@@ -8,10 +8,14 @@
 #include <boost/assert.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/spirit/include/qi.hpp>
 #include <boost/spirit/include/qi_int.hpp>
 
+#include <cstdint>
 #include <iterator>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 
 namespace osrm
@@ -34,6 +38,11 @@ struct RasterDatum
     RasterDatum(std::int32_t _datum) : datum(_datum) {}
 };
 
+/**
+    \brief Values of a raster source by column and row. ASCII grids are parsed into memory, tiled
+    rasters written by WriteTiledRaster are memory mapped and only the tiles that are queried
+    are read from disk.
+*/
 class RasterGrid
 {
   public:
@@ -41,6 +50,11 @@ class RasterGrid
     {
         xdim = _xdim;
         ydim = _ydim;
+        if (IsTiledRaster(filepath))
+        {
+            MapTiledRaster(filepath);
+            return;
+        }
         _data.reserve(ydim * xdim);
 
         boost::filesystem::ifstream stream(filepath, std::ios::binary);
@@ -87,14 +101,42 @@ class RasterGrid
     RasterGrid(RasterGrid &&) = default;
     RasterGrid &operator=(RasterGrid &&) = default;
 
-    std::int32_t operator()(std::size_t x, std::size_t y) { return _data[y * xdim + x]; }
-    std::int32_t operator()(std::size_t x, std::size_t y) const { return _data[(y)*xdim + (x)]; }
+    std::int32_t operator()(std::size_t x, std::size_t y) const
+    {
+        if (tiles == nullptr)
+        {
+            return _data[(y)*xdim + (x)];
+        }
+        const auto tile = (y >> tile_shift) * tiles_per_row + (x >> tile_shift);
+        return tiles[(tile << (2 * tile_shift)) + ((y & tile_mask) << tile_shift) +
+                     (x & tile_mask)];
+    }
+
+    static bool IsTiledRaster(const boost::filesystem::path &filepath);
 
   private:
+    void MapTiledRaster(const boost::filesystem::path &filepath);
+
     std::vector<std::int32_t> _data;
     std::size_t xdim, ydim;
+
+    // the mapping is shared by the copies of the grid
+    std::shared_ptr<boost::iostreams::mapped_file_source> tiled_file;
+    const std::int32_t *tiles = nullptr;
+    std::size_t tile_shift = 0;
+    std::size_t tile_mask = 0;
+    std::size_t tiles_per_row = 0;
 };
 
+// Converts an ASCII grid of ydim rows and xdim columns into a tiled raster with tiles of
+// tile_size rows and columns, a power of two. The grid is read in chunks and written by rows of
+// tiles, the whole grid is never held in memory.
+void WriteTiledRaster(const boost::filesystem::path &ascii_path,
+                      const boost::filesystem::path &tiled_path,
+                      std::size_t xdim,
+                      std::size_t ydim,
+                      std::size_t tile_size);
+
 /**
     \brief Stores raster source data in memory and provides lookup functions.
 */
@@ -129,6 +171,11 @@ class RasterSource
                  int _ymax);
 };
 
+/**
+    \brief Raster sources loaded by the profile. Queries only read the loaded sources and can run
+    on many threads, loading is serialized and has to happen before the queries, in
+    source_function.
+*/
 class SourceContainer
 {
   public:
@@ -147,6 +194,7 @@ class SourceContainer
     RasterDatum GetRasterInterpolateFromSource(unsigned int source_id, double lon, double lat);
 
   private:
+    std::mutex load_mutex;
     std::vector<RasterSource> LoadedSources;
     std::unordered_map<std::string, int> LoadedSourcePaths;
 };
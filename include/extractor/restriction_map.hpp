@@ -8,9 +8,11 @@
 
 #include <boost/assert.hpp>
 
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -72,13 +74,21 @@ namespace extractor
 /**
     \brief Efficent look up if an edge is the start + via node of a TurnRestriction
     EdgeBasedEdgeFactory decides by it if edges are inserted or geometry is compressed
+
+    The restrictions are kept in hash maps while the graph compression moves their start and
+    target nodes. Freeze() then packs them into flat arrays by via node for the lookups of the
+    edge expansion, which never change the map and may run on several threads at once.
 */
 class RestrictionMap
 {
   public:
-    RestrictionMap() : m_count(0) {}
+    RestrictionMap() : m_count(0), m_frozen(false) {}
     RestrictionMap(const std::vector<TurnRestriction> &restriction_list);
 
+    // Packs the restrictions into the flat layout and releases the hash maps. The Fixup
+    // functions can not be called afterwards.
+    void Freeze();
+
     // Replace end v with w in each turn restriction containing u as via node
     template <class GraphT>
     void FixupArrivingTurnRestriction(const NodeID node_u,
@@ -89,6 +99,7 @@ class RestrictionMap
         BOOST_ASSERT(node_u != SPECIAL_NODEID);
         BOOST_ASSERT(node_v != SPECIAL_NODEID);
         BOOST_ASSERT(node_w != SPECIAL_NODEID);
+        BOOST_ASSERT(!m_frozen);
 
         if (!IsViaNode(node_u))
         {
@@ -144,18 +155,34 @@ class RestrictionMap
     std::size_t size() const { return m_count; }
 
   private:
+    using TargetRange = std::pair<const RestrictionTarget *, const RestrictionTarget *>;
+
     // check of node is the start of any restriction
     bool IsSourceNode(const NodeID node) const;
 
+    // the targets of the restrictions that start with the edge (u, v), empty if there are none
+    TargetRange GetTargets(const NodeID node_u, const NodeID node_v) const;
+
     using EmanatingRestrictionsVector = std::vector<RestrictionTarget>;
 
     std::size_t m_count;
+    bool m_frozen;
     //! index -> list of (target, isOnly)
     std::vector<EmanatingRestrictionsVector> m_restriction_bucket_list;
     //! maps (start, via) -> bucket index
     std::unordered_map<RestrictionSource, unsigned> m_restriction_map;
     std::unordered_set<NodeID> m_restriction_start_nodes;
     std::unordered_set<NodeID> m_no_turn_via_node_set;
+
+    // The frozen restrictions by via node, then by start node. The starts of the restrictions
+    // over via node m_via_nodes[i] are m_start_nodes[m_via_offsets[i]] up to the next offset,
+    // the targets of start j are m_targets[m_target_offsets[j]] up to the next offset.
+    std::vector<bool> m_is_via_node;
+    std::vector<NodeID> m_via_nodes;
+    std::vector<std::uint32_t> m_via_offsets;
+    std::vector<NodeID> m_start_nodes;
+    std::vector<std::uint32_t> m_target_offsets;
+    std::vector<RestrictionTarget> m_targets;
 };
 }
 }
@@ -3,15 +3,21 @@
 
 #include "extractor/scripting_environment.hpp"
 
+#include "extractor/extraction_way.hpp"
 #include "extractor/raster_source.hpp"
 
 #include "util/lua_util.hpp"
 
+#include <osmium/osm/tag.hpp>
+
 #include <tbb/enumerable_thread_specific.h>
 
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 struct lua_State;
 
@@ -24,11 +30,28 @@ struct LuaScriptingContext final
 {
     void processNode(const osmium::Node &, ExtractionNode &result);
     void processWay(const osmium::Way &, ExtractionWay &result);
+    void callWayFunction(const osmium::Way &, ExtractionWay &result);
 
     ProfileProperties properties;
-    SourceContainer sources;
     util::LuaState state;
 
+    // tags of the node or way that is being processed, read by get_tag in the profile
+    const osmium::TagList *current_tags = nullptr;
+
+    // declared after the state they reference, so they are released before it is closed
+    luabind::object turn_function;
+    luabind::object node_function;
+    luabind::object way_function;
+    luabind::object segment_function;
+
+    // results of way_function by the tags of the way, if the profile sets cache_way_results
+    std::unordered_map<std::string, ExtractionWay> way_result_cache;
+    std::string way_cache_key;
+
+    // penalties of turn_function from -180 to 180 degrees, if the profile sets
+    // sample_turn_function
+    std::vector<std::int32_t> turn_function_samples;
+
     bool has_turn_penalty_function;
     bool has_node_function;
     bool has_way_function;
@@ -72,6 +95,7 @@ class LuaScriptingEnvironment final : public ScriptingEnvironment
     void InitContext(LuaScriptingContext &context);
     std::mutex init_mutex;
     std::string file_name;
+    SourceContainer sources;
     tbb::enumerable_thread_specific<std::unique_ptr<LuaScriptingContext>> script_contexts;
 };
 }
@@ -28,11 +28,15 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef OSRM_HPP
 #define OSRM_HPP
 
+#include "osrm/match_session.hpp"
 #include "osrm/osrm_fwd.hpp"
 #include "osrm/status.hpp"
 
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace osrm
 {
@@ -44,6 +48,7 @@ using engine::api::NearestParameters;
 using engine::api::TripParameters;
 using engine::api::MatchParameters;
 using engine::api::TileParameters;
+using engine::api::IsochroneParameters;
 
 /**
  * Represents a Open Source Routing Machine with access to its services.
@@ -56,12 +61,29 @@ using engine::api::TileParameters;
  *  - Trip: shortest round trip between coordinates
  *  - Match: snaps noisy coordinate traces to the road network
  *  - Tile: vector tiles with internal graph representation
+ *  - Isochrone: road network reachable from a coordinate within a duration
  *
  *  All services take service-specific parameters, fill a JSON object, and return a status code.
  */
 class OSRM final
 {
   public:
+    /**
+     * Receives the status and the result of the query at the given index of a batch.
+     * It is called from the threads that run the queries, concurrently and in no particular
+     * order, and may move the result out of the object.
+     */
+    using BatchCallback =
+        std::function<void(const std::size_t index, const Status status, json::Object &result)>;
+
+    /**
+     * Receives the status and the result of an asynchronous query.
+     * It is called from a thread of the instance and may move the result out of the object. It
+     * must not throw, errors of the query are reported as its status.
+     */
+    using AsyncCallback = std::function<void(const Status status, json::Object &result)>;
+    using AsyncTileCallback = std::function<void(const Status status, std::string &result)>;
+
     /**
      * Constructs an OSRM instance with user-configurable settings.
      *
@@ -85,6 +107,25 @@ class OSRM final
      */
     Status Route(const RouteParameters &parameters, json::Object &result) const;
 
+    /**
+     * Shortest path queries for coordinates, encoded as a protobuf message.
+     * Steps and annotations are not part of the message, see docs/http.md for the schema.
+     * \param parameters route query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status and RouteParameters
+     */
+    Status Route(const RouteParameters &parameters, std::string &result) const;
+
+    /**
+     * Shortest path queries for a batch of coordinate lists, run in parallel.
+     * All queries of the batch use the same dataset, even if a new one is loaded meanwhile.
+     * \param parameters route query specific parameters of every query
+     * \param callback called once per query with its index in parameters
+     * \see Status, RouteParameters and BatchCallback
+     */
+    void Route(const std::vector<RouteParameters> &parameters,
+               const BatchCallback &callback) const;
+
     /**
      * Distance tables for coordinates.
      *
@@ -94,6 +135,34 @@ class OSRM final
      */
     Status Table(const TableParameters &parameters, json::Object &result) const;
 
+    /**
+     * Distance tables for coordinates, streamed as JSON text instead of built as a JSON object.
+     * Preferable for large tables that are only serialized afterwards.
+     * \param parameters table query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status, TableParameters and json::Writer
+     */
+    Status Table(const TableParameters &parameters, json::Writer &result) const;
+
+    /**
+     * Distance tables for coordinates, encoded as a protobuf message or, for the binary output
+     * format, as the bare matrices. See docs/http.md for the layouts.
+     * \param parameters table query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status and TableParameters
+     */
+    Status Table(const TableParameters &parameters, std::string &result) const;
+
+    /**
+     * Distance tables for a batch of coordinate lists, run in parallel.
+     * All queries of the batch use the same dataset, even if a new one is loaded meanwhile.
+     * \param parameters table query specific parameters of every query
+     * \param callback called once per query with its index in parameters
+     * \see Status, TableParameters and BatchCallback
+     */
+    void Table(const std::vector<TableParameters> &parameters,
+               const BatchCallback &callback) const;
+
     /**
      * Nearest street segment for coordinate.
      *
@@ -121,6 +190,37 @@ class OSRM final
      */
     Status Match(const MatchParameters &parameters, json::Object &result) const;
 
+    /**
+     * Match: snaps the coordinates of a trace to the road network while they arrive.
+     * Appends the coordinates to the trace of the session. The result has the tracepoints of
+     * the coordinates whose match became final since the last query of the session, in the
+     * order of the trace, and the matchings they belong to. A matching that continues is cut at
+     * a final tracepoint, the next result continues it from there. Sessions use the dataset of
+     * their first query.
+     *
+     * \param session the trace, continued by every query
+     * \param parameters match query specific parameters for the new coordinates
+     * \return Status indicating success for the query or failure
+     * \see Status, MatchSession, MatchParameters and json::Object
+     */
+    Status Match(MatchSession &session,
+                 const MatchParameters &parameters,
+                 json::Object &result) const;
+
+    /**
+     * Match: appends the last coordinates of a trace, which may be none, and responds with the
+     * remaining tracepoints and matchings of the session. The session can start a new trace
+     * afterwards.
+     *
+     * \param session the trace to finish
+     * \param parameters match query specific parameters for the new coordinates
+     * \return Status indicating success for the query or failure
+     * \see Status, MatchSession, MatchParameters and json::Object
+     */
+    Status FinishMatch(MatchSession &session,
+                       const MatchParameters &parameters,
+                       json::Object &result) const;
+
     /**
      * Tile: vector tiles with internal graph representation
      *
@@ -130,6 +230,39 @@ class OSRM final
      */
     Status Tile(const TileParameters &parameters, std::string &result) const;
 
+    /**
+     * Isochrone: road network reachable from a coordinate within a duration
+     *
+     * \param parameters isochrone query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status, IsochroneParameters and json::Object
+     */
+    Status Isochrone(const IsochroneParameters &parameters, json::Object &result) const;
+
+    /**
+     * Asynchronous queries: return at once and run the query on the work-stealing threads of
+     * the instance, see EngineConfig::async_threads. The callback receives the result, the
+     * destructor waits for the queries that did not finish yet.
+     *
+     * \param parameters query specific parameters, copied for the query
+     * \param callback called once with the status and the result of the query
+     * \see Status, AsyncCallback and AsyncTileCallback
+     */
+    void Route(const RouteParameters &parameters, AsyncCallback callback) const;
+    void Table(const TableParameters &parameters, AsyncCallback callback) const;
+    void Nearest(const NearestParameters &parameters, AsyncCallback callback) const;
+    void Trip(const TripParameters &parameters, AsyncCallback callback) const;
+    void Match(const MatchParameters &parameters, AsyncCallback callback) const;
+    void Tile(const TileParameters &parameters, AsyncTileCallback callback) const;
+    void Isochrone(const IsochroneParameters &parameters, AsyncCallback callback) const;
+
+    /**
+     * Allocates the search heaps of the calling thread for the largest dataset of the instance.
+     * Otherwise every thread allocates them on its first queries, which makes these slower.
+     * Servers call it on their threads before they accept requests.
+     */
+    void WarmUpThread() const;
+
   private:
     std::unique_ptr<engine::Engine> engine_;
 };
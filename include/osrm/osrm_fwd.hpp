@@ -29,7 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define OSRM_FWD_HPP
 
 // OSRM API forward declarations for usage in interfaces. Exposes forward declarations for:
-// osrm::util::json::Object, osrm::engine::api::XParameters
+// osrm::util::json::Object, osrm::util::json::Writer, osrm::engine::api::XParameters
 
 namespace osrm
 {
@@ -39,6 +39,7 @@ namespace util
 namespace json
 {
 struct Object;
+class Writer;
 } // ns json
 } // ns util
 
@@ -52,10 +53,12 @@ struct NearestParameters;
 struct TripParameters;
 struct MatchParameters;
 struct TileParameters;
+struct IsochroneParameters;
 } // ns api
 
 class Engine;
 struct EngineConfig;
+class MatchSession;
 } // ns engine
 } // ns osrm
 
@@ -0,0 +1,398 @@
+#ifndef SERVER_API_LIST_PARSERS_HPP
+#define SERVER_API_LIST_PARSERS_HPP
+
+#include "engine/api/base_parameters.hpp"
+
+#include "engine/bearing.hpp"
+#include "engine/hint.hpp"
+#include "util/coordinate.hpp"
+
+#include <boost/fusion/include/at_c.hpp>
+#include <boost/optional.hpp>
+#include <boost/spirit/include/qi.hpp>
+
+#include <cctype>
+#include <cstdint>
+#include <limits>
+
+namespace osrm
+{
+namespace server
+{
+namespace api
+{
+
+namespace
+{
+namespace qi = boost::spirit::qi;
+}
+
+// Leaves the dot of a format suffix like ".json" or ".pbf" to the grammar
+template <typename T> struct no_trailing_dot_policy : qi::real_policies<T>
+{
+    template <typename Iterator> static bool parse_dot(Iterator &first, Iterator const &last)
+    {
+        if (first == last || *first != '.')
+            return false;
+
+        if (first + 1 != last && std::isalpha(static_cast<unsigned char>(*(first + 1))))
+            return false;
+
+        ++first;
+        return true;
+    }
+
+    template <typename Iterator> static bool parse_exp(Iterator &, const Iterator &)
+    {
+        return false;
+    }
+
+    template <typename Iterator, typename Attribute>
+    static bool parse_exp_n(Iterator &, const Iterator &, Attribute &)
+    {
+        return false;
+    }
+
+    template <typename Iterator, typename Attribute>
+    static bool parse_nan(Iterator &, const Iterator &, Attribute &)
+    {
+        return false;
+    }
+
+    template <typename Iterator, typename Attribute>
+    static bool parse_inf(Iterator &, const Iterator &, Attribute &)
+    {
+        return false;
+    }
+};
+
+// The parsers below read the coordinates and the lists of the base parameters without the
+// attributes of Spirit: every coordinate, radius, bearing and hint is parsed straight into the
+// parameters of the rule the parser is used in, which are its inherited attribute. They accept
+// the same input as the Spirit rules they replace and throw an expectation failure where these
+// did, the fuzz target list_parsers compares them.
+namespace detail
+{
+// Numbers with more digits can not be converted exactly with a single division
+const constexpr int MAX_EXACT_DIGITS = 15;
+
+// Parses a number of the form [+-]digits[.digits] like the real parsers of Spirit do, which
+// convert the digits to an integer and divide it by the power of ten of the fraction. Returns
+// false and leaves first as it is if the number needs the real parser: it has too many digits,
+// no digits at all or an exponent. With keep_suffix_dot the dot of a format suffix is left.
+template <typename Iterator>
+bool parseSimpleReal(Iterator &first,
+                     const Iterator last,
+                     const bool keep_suffix_dot,
+                     double &value)
+{
+    static const constexpr double powers_of_ten[MAX_EXACT_DIGITS + 1] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+    const auto is_digit = [](const char character) {
+        return character >= '0' && character <= '9';
+    };
+
+    auto iter = first;
+    const bool negative = iter != last && *iter == '-';
+    if (iter != last && (*iter == '-' || *iter == '+'))
+    {
+        ++iter;
+    }
+
+    std::uint64_t digits = 0;
+    int number_of_digits = 0;
+    for (; iter != last && is_digit(*iter); ++iter, ++number_of_digits)
+    {
+        digits = digits * 10 + (*iter - '0');
+    }
+
+    int fraction_digits = 0;
+    if (iter != last && *iter == '.' &&
+        !(keep_suffix_dot && iter + 1 != last &&
+          std::isalpha(static_cast<unsigned char>(*(iter + 1)))))
+    {
+        ++iter;
+        for (; iter != last && is_digit(*iter); ++iter, ++fraction_digits)
+        {
+            digits = digits * 10 + (*iter - '0');
+        }
+        number_of_digits += fraction_digits;
+    }
+
+    if (number_of_digits == 0 || number_of_digits > MAX_EXACT_DIGITS ||
+        (!keep_suffix_dot && iter != last && (*iter == 'e' || *iter == 'E')))
+    {
+        return false;
+    }
+
+    const auto magnitude = static_cast<double>(digits) / powers_of_ten[fraction_digits];
+    value = negative ? -magnitude : magnitude;
+    first = iter;
+    return true;
+}
+
+template <typename Iterator, typename Policies>
+bool parseReal(Iterator &first,
+               const Iterator last,
+               const qi::real_parser<double, Policies> &real_parser,
+               double &value)
+{
+    const bool keep_suffix_dot = std::is_same<Policies, no_trailing_dot_policy<double>>::value;
+    return parseSimpleReal(first, last, keep_suffix_dot, value) ||
+           qi::parse(first, last, real_parser, value);
+}
+
+// Parses a short like qi::short_ does, which fails on overflow
+template <typename Iterator> bool parseShort(Iterator &first, const Iterator last, short &value)
+{
+    auto iter = first;
+    const bool negative = iter != last && *iter == '-';
+    if (iter != last && (*iter == '-' || *iter == '+'))
+    {
+        ++iter;
+    }
+
+    const std::int32_t limit = negative ? -std::int32_t{std::numeric_limits<short>::min()}
+                                        : std::int32_t{std::numeric_limits<short>::max()};
+    std::int32_t magnitude = 0;
+    const auto digits_first = iter;
+    for (; iter != last && *iter >= '0' && *iter <= '9'; ++iter)
+    {
+        magnitude = magnitude * 10 + (*iter - '0');
+        if (magnitude > limit)
+        {
+            return false;
+        }
+    }
+    if (iter == digits_first)
+    {
+        return false;
+    }
+
+    value = static_cast<short>(negative ? -magnitude : magnitude);
+    first = iter;
+    return true;
+}
+
+template <typename Iterator>
+bool parseLiteral(Iterator &first, const Iterator last, const char *literal)
+{
+    auto iter = first;
+    for (; *literal != '\0'; ++iter, ++literal)
+    {
+        if (iter == last || *iter != *literal)
+        {
+            return false;
+        }
+    }
+    first = iter;
+    return true;
+}
+
+template <typename Iterator> bool parseSeparator(Iterator &first, const Iterator last)
+{
+    if (first != last && *first == ';')
+    {
+        ++first;
+        return true;
+    }
+    return false;
+}
+
+// Throws where the expectation operator of a Spirit rule would
+template <typename Iterator>
+[[noreturn]] void
+throwExpectationFailure(const Iterator first, const Iterator last, const char *what)
+{
+    boost::throw_exception(
+        qi::expectation_failure<Iterator>(first, last, boost::spirit::info(what)));
+}
+
+template <typename Iterator> void expect(Iterator &first, const Iterator last, const char character)
+{
+    if (first == last || *first != character)
+    {
+        throwExpectationFailure(first, last, "literal-char");
+    }
+    ++first;
+}
+
+// A Spirit parser that hands the parameters of its rule to the function object
+template <typename ParseFunction>
+struct ParametersParser : qi::primitive_parser<ParametersParser<ParseFunction>>
+{
+    template <typename Context, typename Iterator> struct attribute
+    {
+        using type = qi::unused_type;
+    };
+
+    template <typename Iterator, typename Context, typename Skipper, typename Attribute>
+    bool parse(Iterator &first,
+               const Iterator &last,
+               Context &context,
+               const Skipper &skipper,
+               Attribute &) const
+    {
+        qi::skip_over(first, last, skipper);
+        // the synthesized attribute of the rule is followed by its inherited attributes
+        engine::api::BaseParameters &parameters = boost::fusion::at_c<1>(context.attributes);
+        return ParseFunction{}(first, last, parameters);
+    }
+
+    template <typename Context> boost::spirit::info what(Context &) const
+    {
+        return boost::spirit::info(ParseFunction::name);
+    }
+};
+
+// (double_ > ',' > double_) % ';' with the real parser that keeps the dot of a format suffix
+struct ParseCoordinates
+{
+    static constexpr const char *name = "coordinates";
+
+    template <typename Iterator>
+    bool operator()(Iterator &first, const Iterator last, engine::api::BaseParameters &parameters)
+    {
+        static const qi::real_parser<double, no_trailing_dot_policy<double>> real_parser;
+
+        auto &coordinates = parameters.coordinates;
+        coordinates.clear();
+
+        auto iter = first;
+        auto element = iter;
+        do
+        {
+            double longitude, latitude;
+            if (!parseReal(iter, last, real_parser, longitude))
+            {
+                // a list ends before the separator of an element that does not parse
+                iter = element;
+                break;
+            }
+            expect(iter, last, ',');
+            if (!parseReal(iter, last, real_parser, latitude))
+            {
+                throwExpectationFailure(iter, last, "real");
+            }
+            coordinates.emplace_back(util::toFixed(util::FloatLongitude{longitude}),
+                                     util::toFixed(util::FloatLatitude{latitude}));
+            element = iter;
+        } while (parseSeparator(iter, last));
+
+        if (coordinates.empty())
+        {
+            return false;
+        }
+        first = iter;
+        return true;
+    }
+};
+
+// -(double_ | "unlimited") % ';'
+struct ParseRadiuses
+{
+    static constexpr const char *name = "radiuses";
+
+    template <typename Iterator>
+    bool operator()(Iterator &first, const Iterator last, engine::api::BaseParameters &parameters)
+    {
+        static const qi::real_parser<double, qi::real_policies<double>> real_parser;
+
+        parameters.radiuses.clear();
+        do
+        {
+            double radius;
+            if (parseReal(first, last, real_parser, radius))
+            {
+                parameters.radiuses.emplace_back(radius);
+            }
+            else if (parseLiteral(first, last, "unlimited"))
+            {
+                parameters.radiuses.emplace_back(std::numeric_limits<double>::infinity());
+            }
+            else
+            {
+                parameters.radiuses.emplace_back(boost::none);
+            }
+        } while (parseSeparator(first, last));
+        return true;
+    }
+};
+
+// -(short_ > ',' > short_) % ';'
+struct ParseBearings
+{
+    static constexpr const char *name = "bearings";
+
+    template <typename Iterator>
+    bool operator()(Iterator &first, const Iterator last, engine::api::BaseParameters &parameters)
+    {
+        do
+        {
+            short bearing, range;
+            if (parseShort(first, last, bearing))
+            {
+                expect(first, last, ',');
+                if (!parseShort(first, last, range))
+                {
+                    throwExpectationFailure(first, last, "short_");
+                }
+                parameters.bearings.push_back(engine::Bearing{bearing, range});
+            }
+            else
+            {
+                parameters.bearings.push_back(boost::none);
+            }
+        } while (parseSeparator(first, last));
+        return true;
+    }
+};
+
+// -repeat(ENCODED_HINT_SIZE)[char_("a-zA-Z0-9--_=")] % ';'
+struct ParseHints
+{
+    static constexpr const char *name = "hints";
+
+    template <typename Iterator>
+    bool operator()(Iterator &first, const Iterator last, engine::api::BaseParameters &parameters)
+    {
+        const auto is_base64 = [](const char character) {
+            return std::isalnum(static_cast<unsigned char>(character)) || character == '-' ||
+                   character == '_' || character == '=';
+        };
+
+        do
+        {
+            char encoded[engine::ENCODED_HINT_SIZE];
+            std::size_t size = 0;
+            auto iter = first;
+            for (; size < engine::ENCODED_HINT_SIZE && iter != last && is_base64(*iter);
+                 ++iter, ++size)
+            {
+                encoded[size] = *iter;
+            }
+
+            if (size == engine::ENCODED_HINT_SIZE)
+            {
+                parameters.hints.emplace_back(engine::Hint::FromBase64(encoded));
+                first = iter;
+            }
+            else
+            {
+                parameters.hints.emplace_back(boost::none);
+            }
+        } while (parseSeparator(first, last));
+        return true;
+    }
+};
+}
+
+using CoordinatesParser = detail::ParametersParser<detail::ParseCoordinates>;
+using RadiusesParser = detail::ParametersParser<detail::ParseRadiuses>;
+using BearingsParser = detail::ParametersParser<detail::ParseBearings>;
+using HintsParser = detail::ParametersParser<detail::ParseHints>;
+}
+}
+}
+
+#endif
@@ -34,10 +34,19 @@ struct RouteParametersGrammar : public BaseParametersGrammar<Iterator, Signature
             (qi::lit("continue_straight=") >
              (qi::lit("default") |
               qi::bool_[ph::bind(&engine::api::RouteParameters::continue_straight, qi::_r1) =
-                            qi::_1]));
+                            qi::_1])) |
+            (qi::lit("departure_time=") >
+             qi::ulong_long[ph::bind(&engine::api::RouteParameters::departure_time, qi::_r1) =
+                                qi::_1]);
 
-        root_rule = query_rule(qi::_r1) > -qi::lit(".json") >
-                    -('?' > (route_rule(qi::_r1) | base_rule(qi::_r1)) % '&');
+        output_format_type.add("json", engine::api::OutputFormatType::JSON)(
+            "pbf", engine::api::OutputFormatType::PBF);
+
+        root_rule =
+            query_rule(qi::_r1) >
+            -('.' > output_format_type[ph::bind(&engine::api::RouteParameters::output_format,
+                                                qi::_r1) = qi::_1]) >
+            -('?' > (route_rule(qi::_r1) | base_rule(qi::_r1)) % '&');
     }
 
     RouteParametersGrammar(qi::rule<Iterator, Signature> &root_rule_) : BaseGrammar(root_rule_)
@@ -50,12 +59,31 @@ struct RouteParametersGrammar : public BaseParametersGrammar<Iterator, Signature
             "full", engine::api::RouteParameters::OverviewType::Full)(
             "false", engine::api::RouteParameters::OverviewType::False);
 
+        annotations_type.add("duration", engine::api::RouteParameters::AnnotationsType::Duration)(
+            "nodes", engine::api::RouteParameters::AnnotationsType::Nodes)(
+            "distance", engine::api::RouteParameters::AnnotationsType::Distance)(
+            "datasources", engine::api::RouteParameters::AnnotationsType::Datasources);
+
+        annotations_list =
+            qi::eps[qi::_val = engine::api::RouteParameters::AnnotationsType::None] >>
+            (annotations_type[qi::_val |= qi::_1] % ',');
+
+        // true or false for all annotations or none, or a list of the ones to add
+        annotations_rule =
+            qi::lit("annotations=") >
+            (qi::bool_[ph::bind(&engine::api::RouteParameters::annotations, qi::_r1) = qi::_1,
+                       ph::bind(&engine::api::RouteParameters::annotations_type, qi::_r1) =
+                           engine::api::RouteParameters::AnnotationsType::All] |
+             annotations_list[ph::bind(&engine::api::RouteParameters::annotations, qi::_r1) =
+                                  true,
+                              ph::bind(&engine::api::RouteParameters::annotations_type, qi::_r1) =
+                                  qi::_1]);
+
         base_rule =
             BaseGrammar::base_rule(qi::_r1) |
             (qi::lit("steps=") >
              qi::bool_[ph::bind(&engine::api::RouteParameters::steps, qi::_r1) = qi::_1]) |
-            (qi::lit("annotations=") >
-             qi::bool_[ph::bind(&engine::api::RouteParameters::annotations, qi::_r1) = qi::_1]) |
+            annotations_rule(qi::_r1) |
             (qi::lit("geometries=") >
              geometries_type[ph::bind(&engine::api::RouteParameters::geometries, qi::_r1) =
                                  qi::_1]) |
@@ -72,9 +100,13 @@ struct RouteParametersGrammar : public BaseParametersGrammar<Iterator, Signature
   private:
     qi::rule<Iterator, Signature> root_rule;
     qi::rule<Iterator, Signature> route_rule;
+    qi::rule<Iterator, Signature> annotations_rule;
+    qi::rule<Iterator, engine::api::RouteParameters::AnnotationsType()> annotations_list;
 
     qi::symbols<char, engine::api::RouteParameters::GeometriesType> geometries_type;
     qi::symbols<char, engine::api::RouteParameters::OverviewType> overview_type;
+    qi::symbols<char, engine::api::RouteParameters::AnnotationsType> annotations_type;
+    qi::symbols<char, engine::api::OutputFormatType> output_format_type;
 };
 }
 }
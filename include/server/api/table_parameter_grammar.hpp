@@ -48,10 +48,48 @@ struct TableParametersGrammar final : public BaseParametersGrammar<Iterator, Sig
             (qi::lit("all") |
              (size_t_ % ';')[ph::bind(&engine::api::TableParameters::sources, qi::_r1) = qi::_1]);
 
-        table_rule = destinations_rule(qi::_r1) | sources_rule(qi::_r1);
+        annotations.add("duration", engine::api::TableParameters::AnnotationsType::Duration)(
+            "distance", engine::api::TableParameters::AnnotationsType::Distance);
 
-        root_rule = BaseGrammar::query_rule(qi::_r1) > -qi::lit(".json") >
-                    -('?' > (table_rule(qi::_r1) | BaseGrammar::base_rule(qi::_r1)) % '&');
+        // the listed annotations replace the default ones
+        annotations_list =
+            qi::eps[qi::_val = engine::api::TableParameters::AnnotationsType::None] >>
+            (annotations[qi::_val |= qi::_1] % ',');
+
+        annotations_rule =
+            qi::lit("annotations=") >
+            annotations_list[ph::bind(&engine::api::TableParameters::annotations, qi::_r1) =
+                                 qi::_1];
+
+        binary_values.add("float32", engine::api::TableParameters::BinaryValuesType::Float32)(
+            "int32", engine::api::TableParameters::BinaryValuesType::Int32);
+
+        binary_values_rule =
+            qi::lit("binary_values=") >
+            binary_values[ph::bind(&engine::api::TableParameters::binary_values, qi::_r1) =
+                              qi::_1];
+
+        target_set_rule = qi::lit("target_set=") >
+                          qi::as_string[+qi::char_("a-zA-Z0-9_-")][ph::bind(
+                              &engine::api::TableParameters::target_set, qi::_r1) = qi::_1];
+
+        approximate_rule =
+            qi::lit("approximate=") >
+            qi::bool_[ph::bind(&engine::api::TableParameters::approximate, qi::_r1) = qi::_1];
+
+        table_rule = destinations_rule(qi::_r1) | sources_rule(qi::_r1) |
+                     annotations_rule(qi::_r1) | binary_values_rule(qi::_r1) |
+                     target_set_rule(qi::_r1) | approximate_rule(qi::_r1);
+
+        output_format_type.add("json", engine::api::OutputFormatType::JSON)(
+            "pbf", engine::api::OutputFormatType::PBF)("bin",
+                                                       engine::api::OutputFormatType::Binary);
+
+        root_rule =
+            BaseGrammar::query_rule(qi::_r1) >
+            -('.' > output_format_type[ph::bind(&engine::api::TableParameters::output_format,
+                                                qi::_r1) = qi::_1]) >
+            -('?' > (table_rule(qi::_r1) | BaseGrammar::base_rule(qi::_r1)) % '&');
     }
 
   private:
@@ -59,7 +97,15 @@ struct TableParametersGrammar final : public BaseParametersGrammar<Iterator, Sig
     qi::rule<Iterator, Signature> table_rule;
     qi::rule<Iterator, Signature> sources_rule;
     qi::rule<Iterator, Signature> destinations_rule;
+    qi::rule<Iterator, Signature> annotations_rule;
+    qi::rule<Iterator, Signature> binary_values_rule;
+    qi::rule<Iterator, Signature> target_set_rule;
+    qi::rule<Iterator, Signature> approximate_rule;
     qi::rule<Iterator, std::size_t()> size_t_;
+    qi::rule<Iterator, engine::api::TableParameters::AnnotationsType()> annotations_list;
+    qi::symbols<char, engine::api::OutputFormatType> output_format_type;
+    qi::symbols<char, engine::api::TableParameters::AnnotationsType> annotations;
+    qi::symbols<char, engine::api::TableParameters::BinaryValuesType> binary_values;
 };
 }
 }
@@ -17,6 +17,10 @@ namespace api
 // Starts parsing and iter and modifies it until iter == end or parsing failed
 boost::optional<ParsedURL> parseURL(std::string::iterator &iter, const std::string::iterator end);
 
+// Same as above, parses the undecoded URL in place: only percent-escapes in the query are decoded
+boost::optional<ParsedURL> parseURL(std::string::const_iterator &iter,
+                                    const std::string::const_iterator end);
+
 inline boost::optional<ParsedURL> parseURL(std::string url_string)
 {
     auto iter = url_string.begin();
@@ -4,6 +4,7 @@
 #include "server/http/compression_type.hpp"
 #include "server/http/reply.hpp"
 #include "server/http/request.hpp"
+#include "server/http2/session.hpp"
 #include "server/request_parser.hpp"
 
 #include <boost/array.hpp>
@@ -11,6 +12,8 @@
 #include <boost/config.hpp>
 #include <boost/version.hpp>
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -33,37 +36,106 @@ namespace server
 
 class RequestHandler;
 
-/// Represents a single connection from a client.
-class Connection : public std::enable_shared_from_this<Connection>
+/// Represents a single connection from a client. Clients that open it with the HTTP/2 preface
+/// (h2c with prior knowledge) send their requests as concurrent streams, see http2::Session.
+/// SocketT is a TCP or, where supported, a unix domain stream socket; both are instantiated in
+/// connection.cpp.
+template <typename SocketT>
+class Connection : public std::enable_shared_from_this<Connection<SocketT>>
 {
   public:
-    explicit Connection(boost::asio::io_service &io_service, RequestHandler &handler);
+    Connection(boost::asio::io_service &io_service,
+               RequestHandler &handler,
+               const http::compression_settings &compression);
     Connection(const Connection &) = delete;
     Connection &operator=(const Connection &) = delete;
 
-    boost::asio::ip::tcp::socket &socket();
+    SocketT &socket();
 
     /// Start the first asynchronous operation for the connection.
     void start();
 
   private:
+    // persistent connections are closed after this many requests or idle seconds
+    static constexpr std::size_t MAX_KEEP_ALIVE_REQUESTS = 512;
+    static constexpr long KEEP_ALIVE_TIMEOUT_SECONDS = 5;
+    // HTTP/2 connections multiplex the requests of a client and are kept open longer
+    static constexpr long HTTP2_IDLE_TIMEOUT_SECONDS = 60;
+    // the buffers of a reply are reused for the next request unless they grew beyond this
+    static constexpr std::size_t MAX_RECYCLED_REPLY_SIZE = 8 * 1024 * 1024;
+
+    /// Read the next chunk of a request, arm the idle timer if no request is pending
+    void start_read(const bool wait_for_new_request);
+
     void handle_read(const boost::system::error_code &e, std::size_t bytes_transferred);
 
+    /// Parse buffered input and reply once a request is complete
+    void process_input(char *begin, char *end);
+
+    /// Read the body once the client got the "100 Continue"
+    void handle_continue(const boost::system::error_code &e);
+
+    /// Cancel the query of the request once the client closed the connection
+    void handle_disconnect(const boost::system::error_code &e,
+                           const std::shared_ptr<std::atomic<bool>> &cancelled);
+
+    /// Compress and send the reply once the request handler is done
+    void handle_reply();
+
+    /// Add the encoding and length headers and hand the reply to the request handler once more.
+    /// Returns the compression used, compressed content is left in compressed_output.
+    http::compression_type finish_reply(const http::request &request,
+                                        http::reply &reply,
+                                        http::compression_type compression_type);
+
+    /// Switch to HTTP/2 after its preface, the rest of the input are frames
+    void start_http2(const char *begin, const char *end);
+
+    /// Hand the requests of streams to the request handler as soon as they are complete
+    void process_http2_input(const char *begin, const char *end);
+
+    /// Queue the reply of a stream once the request handler is done
+    void handle_http2_reply(const std::uint32_t stream_id);
+
+    /// Send the frames the session queued unless a write is in progress
+    void write_http2_output();
+
+    void handle_http2_write(const boost::system::error_code &e);
+
     /// Handle completion of a write operation.
     void handle_write(const boost::system::error_code &e);
 
-    std::vector<char> compress_buffers(const std::vector<char> &uncompressed_data,
-                                       const http::compression_type compression_type);
+    /// Close idle persistent connections
+    void handle_timeout(const boost::system::error_code &e);
+
+    /// Compress into one or more chunks that are sent in order, large data in parallel
+    void compress_buffers(const std::vector<char> &uncompressed_data,
+                          const http::compression_type compression_type);
 
     boost::asio::io_service::strand strand;
-    boost::asio::ip::tcp::socket TCP_socket;
+    SocketT client_socket;
+    boost::asio::deadline_timer timer;
     RequestHandler &request_handler;
+    const http::compression_settings &compression;
     RequestParser request_parser;
     boost::array<char, 8192> incoming_data_buffer;
+    // pipelined input that was received together with the request being answered
+    char *pending_input_begin = nullptr;
+    char *pending_input_end = nullptr;
+    std::size_t processed_requests = 0;
+    bool keep_alive = false;
     http::request current_request;
     http::reply current_reply;
-    std::vector<char> compressed_output;
-    // Header compression_header;
+    http::compression_type compression_type = http::no_compression;
+    // input starts with a prefix of the HTTP/2 preface, which stays in incoming_data_buffer until
+    // the next read tells whether the connection is one
+    bool awaiting_preface = true;
+    std::size_t preface_bytes = 0;
+    std::unique_ptr<http2::Session> http2_session;
+    std::vector<char> http2_output;
+    bool http2_writing = false;
+    // gzip header, deflate chunks and gzip trailer of the reply content
+    std::vector<std::vector<char>> compressed_output;
     std::vector<boost::asio::const_buffer> output_buffer;
 };
 }
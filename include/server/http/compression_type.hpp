@@ -1,6 +1,8 @@
 #ifndef COMPRESSION_TYPE_HPP
 #define COMPRESSION_TYPE_HPP
 
+#include <cstddef>
+
 namespace osrm
 {
 namespace server
@@ -14,6 +16,15 @@ enum compression_type
     gzip_rfc1952,
     deflate_rfc1951
 };
+
+// Tuning of the gzip/deflate reply compression
+struct compression_settings
+{
+    // zlib compression level, from 1 (fastest) to 9 (smallest)
+    int level = 1;
+    // replies with less content are sent uncompressed
+    std::size_t min_size = 0;
+};
 }
 }
 }
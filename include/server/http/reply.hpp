@@ -2,9 +2,12 @@
 #define REPLY_HPP
 
 #include "server/http/header.hpp"
+#include "server/request_profile.hpp"
+#include "util/allocation_statistics.hpp"
 
 #include <boost/asio.hpp>
 
+#include <cstddef>
 #include <vector>
 
 namespace osrm
@@ -21,16 +24,25 @@ class reply
     {
         ok = 200,
         bad_request = 400,
-        internal_server_error = 500
+        internal_server_error = 500,
+        service_unavailable = 503
     } status;
 
     std::vector<header> headers;
     std::vector<boost::asio::const_buffer> to_buffers();
     std::vector<boost::asio::const_buffer> headers_to_buffers();
     std::vector<char> content;
+    // heap allocations of handling the request, only counted with ENABLE_ALLOCATION_TRACKING
+    util::AllocationStatistics allocations;
+    // where the time of handling the request went, for the slow query log
+    RequestProfile profile;
     static reply stock_reply(const status_type status);
     void set_size(const std::size_t size);
     void set_uncompressed_size();
+    void set_keep_alive(const bool keep_alive);
+    // Prepares the reply for the next request of a persistent connection. The content keeps its
+    // buffer unless it grew beyond max_content_capacity.
+    void reset(const std::size_t max_content_capacity);
 
     reply();
 
@@ -3,6 +3,9 @@
 
 #include <boost/asio.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <string>
 
 namespace osrm
@@ -15,9 +18,17 @@ namespace http
 struct request
 {
     std::string uri;
+    // the query of POST requests, whose URI only names service, version and profile
+    std::string body;
     std::string referrer;
     std::string agent;
     boost::asio::ip::address endpoint;
+    // whether the client wants to send further requests on the same connection
+    bool keep_alive = false;
+    // the time the client grants the query with the X-OSRM-Timeout header, zero without limit
+    std::chrono::milliseconds timeout{0};
+    // set by the connection once the client is gone before its reply was sent
+    std::shared_ptr<std::atomic<bool>> cancelled;
 };
 }
 }
@@ -0,0 +1,58 @@
+#ifndef SERVER_HTTP2_HPACK_HPP
+#define SERVER_HTTP2_HPACK_HPP
+
+#include "server/http/header.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+namespace http2
+{
+
+// Decodes the header blocks of one connection (RFC 7541). The dynamic table carries over from one
+// block to the next, so the blocks have to be decoded in the order they were received.
+class HeaderDecoder
+{
+  public:
+    // The default of SETTINGS_HEADER_TABLE_SIZE, we never announce another one
+    static constexpr std::size_t MAX_TABLE_SIZE = 4096;
+
+    // Fields that take more space, as counted for SETTINGS_MAX_HEADER_LIST_SIZE, fail the block
+    explicit HeaderDecoder(const std::size_t max_header_list_size);
+
+    // Appends the fields of the block to headers. A malformed block fails the whole connection,
+    // since the dynamic table is out of sync with the one of the client from then on.
+    bool Decode(const char *begin, const char *end, std::vector<http::header> &headers);
+
+  private:
+    bool GetField(const std::size_t index, http::header &field) const;
+    void Insert(const http::header &field);
+    void Evict(const std::size_t max_size);
+
+    const std::size_t max_header_list_size;
+    std::size_t max_table_size = MAX_TABLE_SIZE;
+    std::size_t table_size = 0;
+    // newest entries first, as indexed
+    std::deque<http::header> dynamic_table;
+};
+
+// Encodes the status and headers of a reply as literals without indexing, which leaves the dynamic
+// table of the client empty. Names are sent in lower case and the headers that only apply to
+// HTTP/1 connections are left out.
+void encodeHeaders(const unsigned status,
+                   const std::vector<http::header> &headers,
+                   std::vector<char> &block);
+
+// Decodes a string of the HPACK Huffman code, false if it is malformed
+bool decodeHuffman(const char *begin, const char *end, std::string &output);
+}
+}
+}
+
+#endif // SERVER_HTTP2_HPACK_HPP
@@ -0,0 +1,170 @@
+#ifndef SERVER_HTTP2_SESSION_HPP
+#define SERVER_HTTP2_SESSION_HPP
+
+#include "server/http/compression_type.hpp"
+#include "server/http/reply.hpp"
+#include "server/http/request.hpp"
+#include "server/http2/hpack.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+namespace http2
+{
+
+// The server side of an HTTP/2 connection (RFC 7540) with a client that knows that the server
+// speaks HTTP/2 in cleartext, from the client preface on. It turns the frames of the client into
+// requests and replies into frames, each stream carries one request. Reading and writing the
+// socket is left to the caller.
+class Session
+{
+  public:
+    // The first bytes clients with prior knowledge send
+    static const std::string CLIENT_PREFACE;
+    // Clients that open more streams at once get the further ones refused
+    static constexpr std::size_t MAX_CONCURRENT_STREAMS = 128;
+    // Clients that send larger header lists fail the connection
+    static constexpr std::size_t MAX_HEADER_LIST_SIZE = 64 * 1024;
+
+    // Queues the settings of the server, which have to be its first frame
+    Session();
+    Session(const Session &) = delete;
+    Session &operator=(const Session &) = delete;
+
+    // Consumes the frames in the input, which may end within a frame. Streams whose requests are
+    // complete are appended to complete_streams, they wait for SendReply from then on. Returns
+    // false once the connection failed, a GOAWAY that tells the client why is queued then.
+    bool Consume(const char *begin, const char *end, std::vector<std::uint32_t> &complete_streams);
+
+    // The request and reply of a complete stream stay in place until the reply was sent
+    http::request &GetRequest(const std::uint32_t stream_id);
+    http::reply &GetReply(const std::uint32_t stream_id);
+    http::compression_type GetCompression(const std::uint32_t stream_id) const;
+
+    // Queues the headers of the reply of a complete stream and its body as it is sent, that is
+    // compressed if the headers say so. The body is sent as far as the flow control windows of the
+    // client allow, the rest once it enlarges them.
+    void SendReply(const std::uint32_t stream_id, std::vector<char> body);
+
+    // Cancels the queries of all streams once the connection is gone, replies are dropped then
+    void Close();
+
+    bool HasOutput() const;
+    // Swaps the frames to send into output, the previous content of output is dropped
+    void TakeOutput(std::vector<char> &output);
+
+    // Whether requests are being received, answered or their replies are being sent
+    bool HasStreams() const;
+    // Whether the connection can be shut down once the output was sent
+    bool IsDone() const;
+
+  private:
+    enum class FrameType : std::uint8_t
+    {
+        data = 0x0,
+        headers = 0x1,
+        priority = 0x2,
+        rst_stream = 0x3,
+        settings = 0x4,
+        push_promise = 0x5,
+        ping = 0x6,
+        goaway = 0x7,
+        window_update = 0x8,
+        continuation = 0x9
+    };
+
+    enum class ErrorCode : std::uint32_t
+    {
+        protocol_error = 0x1,
+        flow_control_error = 0x3,
+        stream_closed = 0x5,
+        frame_size_error = 0x6,
+        refused_stream = 0x7,
+        compression_error = 0x9
+    };
+
+    struct Stream
+    {
+        http::request request;
+        http::reply reply;
+        http::compression_type compression = http::no_compression;
+        // the request was received, its query might be running
+        bool complete = false;
+        // the client reset the stream while its query was running
+        bool reset = false;
+        // the headers of the reply were sent, the body is sent as the windows allow
+        bool replying = false;
+        std::int64_t send_window = 0;
+        std::vector<char> body;
+        std::size_t sent = 0;
+    };
+
+    bool ProcessFrame(const FrameType type,
+                      const std::uint8_t flags,
+                      const std::uint32_t stream_id,
+                      const char *payload,
+                      const std::size_t length,
+                      std::vector<std::uint32_t> &complete_streams);
+    bool ProcessData(const std::uint8_t flags,
+                     const std::uint32_t stream_id,
+                     const char *payload,
+                     const std::size_t length,
+                     std::vector<std::uint32_t> &complete_streams);
+    bool ProcessHeaders(const std::uint8_t flags,
+                        const std::uint32_t stream_id,
+                        const char *payload,
+                        const std::size_t length,
+                        std::vector<std::uint32_t> &complete_streams);
+    bool ProcessHeaderBlock(std::vector<std::uint32_t> &complete_streams);
+    bool ProcessSettings(const std::uint8_t flags,
+                         const std::uint32_t stream_id,
+                         const char *payload,
+                         const std::size_t length);
+    bool ProcessWindowUpdate(const std::uint32_t stream_id,
+                             const char *payload,
+                             const std::size_t length);
+    void ResetStream(const std::map<std::uint32_t, Stream>::iterator stream);
+
+    // Queues a GOAWAY, cancels the queries of all streams and returns false
+    bool Fail(const ErrorCode error);
+
+    // Sends the bodies of the replies round robin, one frame per stream at a time
+    void SendData();
+
+    void WriteFrame(const FrameType type,
+                    const std::uint8_t flags,
+                    const std::uint32_t stream_id,
+                    const char *payload,
+                    const std::size_t length);
+    void WriteRstStream(const std::uint32_t stream_id, const ErrorCode error);
+    void WriteWindowUpdate(const std::uint32_t stream_id, const std::size_t increment);
+
+    HeaderDecoder header_decoder;
+    std::map<std::uint32_t, Stream> streams;
+    // an incomplete frame at the end of the input
+    std::vector<char> input;
+    std::vector<char> output;
+    // a header block that is continued by CONTINUATION frames, and the stream it belongs to
+    std::vector<char> header_block;
+    std::uint32_t header_block_stream = 0;
+    bool header_block_ends_stream = false;
+    std::uint32_t last_stream_id = 0;
+    bool settings_received = false;
+    bool goaway_received = false;
+    bool closed = false;
+    std::int64_t send_window;
+    std::int64_t initial_stream_send_window;
+    std::size_t max_send_frame_size;
+};
+}
+}
+}
+
+#endif // SERVER_HTTP2_SESSION_HPP
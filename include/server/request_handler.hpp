@@ -1,8 +1,14 @@
 #ifndef REQUEST_HANDLER_HPP
 #define REQUEST_HANDLER_HPP
 
+#include "server/api/parsed_url.hpp"
 #include "server/service_handler.hpp"
+#include "server/slow_query_log.hpp"
 
+#include <boost/optional.hpp>
+
+#include <chrono>
+#include <functional>
 #include <string>
 
 namespace osrm
@@ -26,10 +32,33 @@ class RequestHandler
 
     void RegisterServiceHandler(std::unique_ptr<ServiceHandlerInterface> service_handler);
 
-    void HandleRequest(const http::request &current_request, http::reply &current_reply);
+    void RegisterSlowQueryLog(std::unique_ptr<SlowQueryLog> slow_query_log);
+
+    // Queries stop after this time since their request arrived, or earlier if the client asks
+    // for it with the X-OSRM-Timeout header. Zero leaves the time to the clients.
+    void SetQueryTimeout(const std::chrono::steady_clock::duration timeout);
+
+    // Prepares the calling io thread for the queries of the service handler
+    void WarmUpThread();
+
+    // The reply might be computed on a worker pool of the service, reply_ready is called once
+    // current_reply is complete
+    void HandleRequest(const http::request &current_request,
+                       http::reply &current_reply,
+                       std::function<void()> reply_ready);
+
+    // Called once the reply of a request is complete and compressed
+    void FinishRequest(const http::request &current_request, const http::reply &current_reply);
 
   private:
+    void HandleQuery(const http::request &current_request,
+                     http::reply &current_reply,
+                     boost::optional<api::ParsedURL> maybe_parsed_url,
+                     const std::string &url_error);
+
     std::unique_ptr<ServiceHandlerInterface> service_handler;
+    std::unique_ptr<SlowQueryLog> slow_query_log;
+    std::chrono::steady_clock::duration query_timeout{0};
 };
 }
 }
@@ -4,6 +4,8 @@
 #include "server/http/compression_type.hpp"
 #include "server/http/header.hpp"
 
+#include <cstddef>
+#include <string>
 #include <tuple>
 
 namespace osrm
@@ -21,6 +23,11 @@ class RequestParser
   public:
     RequestParser();
 
+    // Larger request bodies are rejected
+    static constexpr std::size_t MAX_CONTENT_LENGTH = 32 * 1024 * 1024;
+    // Longer timeouts of the X-OSRM-Timeout header are cut to a day
+    static constexpr std::size_t MAX_TIMEOUT_MILLISECONDS = 24 * 60 * 60 * 1000;
+
     enum class RequestStatus : char
     {
         valid,
@@ -28,8 +35,16 @@ class RequestParser
         indeterminate
     };
 
+    // Consumes input until a request is complete or the input is exhausted. On return begin points
+    // past the consumed input, so pipelined requests following a complete one can be parsed next.
     std::tuple<RequestStatus, http::compression_type>
-    parse(http::request &current_request, char *begin, char *end);
+    parse(http::request &current_request, char *&begin, char *end);
+
+    // Prepares the parser for the next request on a persistent connection
+    void reset();
+
+    // True once after the headers of a request that waits for a "100 Continue" to send its body
+    bool await_continue();
 
   private:
     RequestStatus consume(http::request &current_request, const char input);
@@ -64,11 +79,18 @@ class RequestParser
         space_before_header_value,
         header_value,
         expecting_newline_2,
-        expecting_newline_3
+        expecting_newline_3,
+        body
     } state;
 
     http::header current_header;
     http::compression_type selected_compression;
+    unsigned http_version_major;
+    unsigned http_version_minor;
+    std::string connection_header;
+    std::size_t content_length;
+    bool expect_continue;
+    bool continue_pending;
 };
 }
 }
@@ -0,0 +1,36 @@
+#ifndef SERVER_REQUEST_PROFILE_HPP
+#define SERVER_REQUEST_PROFILE_HPP
+
+#include "engine/search_statistics.hpp"
+
+#include <chrono>
+
+namespace osrm
+{
+namespace server
+{
+
+// Where the time of handling a request went. The phases follow each other: parsing the URL on
+// the thread of the connection, waiting for a thread of the service, snapping the coordinates,
+// searching, unpacking the paths, assembling the route with its guidance, rendering the
+// response and compressing it. The counters of the searches are only counted in builds with
+// ENABLE_SEARCH_STATISTICS.
+struct RequestProfile
+{
+    using Duration = std::chrono::steady_clock::duration;
+
+    std::chrono::steady_clock::time_point start;
+    Duration parse = Duration::zero();
+    Duration queue = Duration::zero();
+    Duration snap = Duration::zero();
+    Duration search = Duration::zero();
+    Duration unpack = Duration::zero();
+    Duration guidance = Duration::zero();
+    Duration render = Duration::zero();
+    Duration compress = Duration::zero();
+    engine::SearchStatistics search_statistics;
+};
+}
+}
+
+#endif // SERVER_REQUEST_PROFILE_HPP
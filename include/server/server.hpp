@@ -4,22 +4,36 @@
 #include "server/connection.hpp"
 #include "server/request_handler.hpp"
 #include "server/service_handler.hpp"
+#include "server/slow_query_log.hpp"
 
+#include "util/exception.hpp"
 #include "util/integer_range.hpp"
+#include "util/numa.hpp"
 #include "util/simple_logger.hpp"
 
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
+#include <boost/thread/barrier.hpp>
 
 #include <zlib.h>
 
 #ifndef _WIN32
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
@@ -29,86 +43,288 @@ namespace osrm
 namespace server
 {
 
+// How the io threads of the server are set up
+struct ThreadSettings
+{
+    // one io_service and acceptor per thread instead of all threads sharing one, the kernel
+    // balances the connections between the acceptors with SO_REUSEPORT
+    bool acceptor_per_thread = false;
+    // pin the io threads to cores, only supported on Linux
+    bool pin_threads = false;
+    // spread the io threads over the NUMA nodes round robin, so queries use the dataset replica
+    // of every node
+    bool bind_numa_nodes = false;
+    // allocate the search heaps of every io thread before the acceptors listen
+    bool warm_up = false;
+};
+
 class Server
 {
   public:
     // Note: returns a shared instead of a unique ptr as it is captured in a lambda somewhere else
+    // A non-empty unix_socket_path listens on a unix domain socket instead of the address
     static std::shared_ptr<Server>
-    CreateServer(std::string &ip_address, int ip_port, unsigned requested_num_threads)
+    CreateServer(std::string &ip_address,
+                 int ip_port,
+                 unsigned requested_num_threads,
+                 const http::compression_settings &compression = http::compression_settings(),
+                 const ThreadSettings &threading = ThreadSettings(),
+                 const std::string &unix_socket_path = std::string())
     {
         util::SimpleLogger().Write() << "http 1.1 compression handled by zlib version "
-                                     << zlibVersion();
+                                     << zlibVersion() << ", level " << compression.level;
         const unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
         const unsigned real_num_threads = std::min(hardware_threads, requested_num_threads);
-        return std::make_shared<Server>(ip_address, ip_port, real_num_threads);
+        return std::make_shared<Server>(
+            ip_address, ip_port, real_num_threads, compression, threading, unix_socket_path);
     }
 
-    explicit Server(const std::string &address, const int port, const unsigned thread_pool_size)
-        : thread_pool_size(thread_pool_size), acceptor(io_service),
-          new_connection(std::make_shared<Connection>(io_service, request_handler))
+    explicit Server(const std::string &address,
+                    const int port,
+                    const unsigned thread_pool_size,
+                    const http::compression_settings &compression_ = http::compression_settings(),
+                    const ThreadSettings &threading_ = ThreadSettings(),
+                    const std::string &unix_socket_path_ = std::string())
+        : thread_pool_size(thread_pool_size), compression(compression_), threading(threading_),
+          unix_socket_path(unix_socket_path_)
     {
-        const auto port_string = std::to_string(port);
-
-        boost::asio::ip::tcp::resolver resolver(io_service);
-        boost::asio::ip::tcp::resolver::query query(address, port_string);
-        boost::asio::ip::tcp::endpoint endpoint = *resolver.resolve(query);
+        if (!unix_socket_path.empty())
+        {
+            ListenOnUnixSocket();
+            return;
+        }
 
-        acceptor.open(endpoint.protocol());
-#ifdef SO_REUSEPORT
-        const int option = 1;
-        setsockopt(acceptor.native_handle(), SOL_SOCKET, SO_REUSEPORT, &option, sizeof(option));
+#ifndef SO_REUSEPORT
+        if (threading.acceptor_per_thread)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "SO_REUSEPORT is not supported, all threads share one acceptor";
+            threading.acceptor_per_thread = false;
+        }
 #endif
-        acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
-        acceptor.bind(endpoint);
-        acceptor.listen();
+        const unsigned num_listeners = threading.acceptor_per_thread ? thread_pool_size : 1;
+        for (unsigned i = 0; i < num_listeners; ++i)
+        {
+            auto listener = std::make_unique<ProtocolListener<boost::asio::ip::tcp>>(
+                request_handler, compression);
+            boost::asio::ip::tcp::resolver resolver(listener->io_service);
+            boost::asio::ip::tcp::resolver::query query(address, std::to_string(port));
+            listener->Bind(*resolver.resolve(query), true);
+            listeners.push_back(std::move(listener));
+        }
 
-        util::SimpleLogger().Write() << "Listening on: " << acceptor.local_endpoint();
+        util::SimpleLogger().Write() << "Bound to: " << listeners.front()->LocalEndpoint()
+                                     << (num_listeners > 1 ? " with an acceptor per thread" : "");
+    }
 
-        acceptor.async_accept(
-            new_connection->socket(),
-            boost::bind(&Server::HandleAccept, this, boost::asio::placeholders::error));
+    ~Server()
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        if (!unix_socket_path.empty() && !listeners.empty())
+        {
+            ::unlink(unix_socket_path.c_str());
+        }
+#endif
     }
 
+    // The acceptors only listen once all io threads are set up and warmed up, until then
+    // connections are refused and load balancers do not send requests to a cold server
     void Run()
     {
+        // the threads wait to be pinned, then warm up, then for the acceptors to listen
+        boost::barrier barrier(thread_pool_size + 1);
         std::vector<std::shared_ptr<std::thread>> threads;
         for (unsigned i = 0; i < thread_pool_size; ++i)
         {
-            std::shared_ptr<std::thread> thread = std::make_shared<std::thread>(
-                boost::bind(&boost::asio::io_service::run, &io_service));
+            auto &io_service = listeners[i % listeners.size()]->io_service;
+            std::shared_ptr<std::thread> thread =
+                std::make_shared<std::thread>([this, &barrier, &io_service] {
+                    barrier.wait();
+                    if (threading.warm_up)
+                    {
+                        request_handler.WarmUpThread();
+                    }
+                    barrier.wait();
+                    barrier.wait();
+                    io_service.run();
+                });
+            if (threading.pin_threads)
+            {
+                PinToCore(*thread, i);
+            }
+            else if (threading.bind_numa_nodes)
+            {
+                util::bindToNumaNode(*thread, i % util::getNumaNodes().size());
+            }
             threads.push_back(thread);
         }
+
+        barrier.wait();
+        barrier.wait();
+        for (auto &listener : listeners)
+        {
+            listener->Listen();
+        }
+        util::SimpleLogger().Write() << "Listening on: " << listeners.front()->LocalEndpoint();
+        barrier.wait();
+
         for (auto thread : threads)
         {
             thread->join();
         }
     }
 
-    void Stop() { io_service.stop(); }
+    void Stop()
+    {
+        for (auto &listener : listeners)
+        {
+            listener->io_service.stop();
+        }
+    }
 
     void RegisterServiceHandler(std::unique_ptr<ServiceHandlerInterface> service_handler_)
     {
         request_handler.RegisterServiceHandler(std::move(service_handler_));
     }
 
+    void RegisterSlowQueryLog(std::unique_ptr<SlowQueryLog> slow_query_log)
+    {
+        request_handler.RegisterSlowQueryLog(std::move(slow_query_log));
+    }
+
+    void SetQueryTimeout(const std::chrono::steady_clock::duration timeout)
+    {
+        request_handler.SetQueryTimeout(timeout);
+    }
+
   private:
-    void HandleAccept(const boost::system::error_code &e)
+    // The io_service connections run on, and the acceptor that hands them to it
+    struct Listener
+    {
+        virtual ~Listener() = default;
+        virtual void Listen() = 0;
+        virtual std::string LocalEndpoint() const = 0;
+
+        boost::asio::io_service io_service;
+    };
+
+    // ProtocolT is boost::asio::ip::tcp or boost::asio::local::stream_protocol
+    template <typename ProtocolT> struct ProtocolListener final : Listener
     {
-        if (!e)
+        using ConnectionT = Connection<typename ProtocolT::socket>;
+
+        ProtocolListener(RequestHandler &request_handler,
+                         const http::compression_settings &compression)
+            : acceptor(io_service), request_handler(request_handler), compression(compression)
+        {
+        }
+
+        void Bind(const typename ProtocolT::endpoint &endpoint, const bool reuse)
+        {
+            acceptor.open(endpoint.protocol());
+            if (reuse)
+            {
+#ifdef SO_REUSEPORT
+                const int option = 1;
+                setsockopt(
+                    acceptor.native_handle(), SOL_SOCKET, SO_REUSEPORT, &option, sizeof(option));
+#endif
+                acceptor.set_option(boost::asio::socket_base::reuse_address(true));
+            }
+            acceptor.bind(endpoint);
+        }
+
+        void Listen() override
         {
-            new_connection->start();
-            new_connection = std::make_shared<Connection>(io_service, request_handler);
+            acceptor.listen();
+            Accept();
+        }
+
+        std::string LocalEndpoint() const override
+        {
+            std::ostringstream stream;
+            stream << acceptor.local_endpoint();
+            return stream.str();
+        }
+
+        void Accept()
+        {
+            new_connection = std::make_shared<ConnectionT>(io_service, request_handler, compression);
             acceptor.async_accept(
                 new_connection->socket(),
-                boost::bind(&Server::HandleAccept, this, boost::asio::placeholders::error));
+                boost::bind(
+                    &ProtocolListener::HandleAccept, this, boost::asio::placeholders::error));
+        }
+
+        void HandleAccept(const boost::system::error_code &e)
+        {
+            if (!e)
+            {
+                new_connection->start();
+                Accept();
+            }
         }
+
+        typename ProtocolT::acceptor acceptor;
+        std::shared_ptr<ConnectionT> new_connection;
+        RequestHandler &request_handler;
+        const http::compression_settings &compression;
+    };
+
+    // Sidecars on the same host skip the TCP stack and don't use up ephemeral ports. The kernel
+    // does not balance unix domain sockets between acceptors, all threads share one.
+    void ListenOnUnixSocket()
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        if (threading.acceptor_per_thread)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "a unix domain socket has one acceptor, all threads share it";
+            threading.acceptor_per_thread = false;
+        }
+
+        // the socket of a previous run that was not shut down cleanly, but no other file
+        struct stat status;
+        if (::lstat(unix_socket_path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+        {
+            ::unlink(unix_socket_path.c_str());
+        }
+
+        auto listener = std::make_unique<ProtocolListener<boost::asio::local::stream_protocol>>(
+            request_handler, compression);
+        listener->Bind(boost::asio::local::stream_protocol::endpoint(unix_socket_path), false);
+        listeners.push_back(std::move(listener));
+        util::SimpleLogger().Write() << "Bound to unix domain socket: " << unix_socket_path;
+#else
+        throw util::exception("unix domain sockets are not supported on this platform");
+#endif
+    }
+
+    static void PinToCore(std::thread &thread, const unsigned thread_index)
+    {
+#ifdef __linux__
+        const unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(thread_index % hardware_threads, &cpu_set);
+        if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set) != 0)
+        {
+            util::SimpleLogger().Write(logWARNING) << "could not pin thread " << thread_index;
+        }
+#else
+        (void)thread;
+        util::SimpleLogger().Write(logWARNING) << "pinning threads is only supported on Linux, "
+                                               << "thread " << thread_index << " is not pinned";
+#endif
     }
 
     unsigned thread_pool_size;
-    boost::asio::io_service io_service;
-    boost::asio::ip::tcp::acceptor acceptor;
-    std::shared_ptr<Connection> new_connection;
+    const http::compression_settings compression;
+    ThreadSettings threading;
+    const std::string unix_socket_path;
+    // outlives the connections of the listeners
     RequestHandler request_handler;
+    std::vector<std::unique_ptr<Listener>> listeners;
 };
 }
 }
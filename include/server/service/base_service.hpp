@@ -4,10 +4,13 @@
 #include "engine/status.hpp"
 #include "osrm/osrm.hpp"
 #include "util/coordinate.hpp"
+#include "util/json_writer.hpp"
 
 #include <variant/variant.hpp>
 
+#include <cstddef>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -17,20 +20,88 @@ namespace server
 namespace service
 {
 
+// A binary response that is neither JSON nor protobuf, served as application/octet-stream
+struct OctetStream
+{
+    std::string bytes;
+};
+
+// The buffers of the streamed and the binary results of the queries of a thread. They are handed
+// from one query to the next, so that responses of several megabytes are not allocated and
+// faulted in again for every query.
+struct ResultBuffers
+{
+    // larger buffers are released instead of kept for the next query
+    static constexpr std::size_t MAX_RECYCLED_CAPACITY = 8 * 1024 * 1024;
+
+    std::vector<char> json;
+    std::string bytes;
+};
+
+inline ResultBuffers &GetResultBuffers()
+{
+    static thread_local ResultBuffers buffers;
+    return buffers;
+}
+
+// Keeps the buffer of a result for the next query of the thread
+inline void recycleResultBuffer(std::vector<char> &&buffer)
+{
+    if (buffer.capacity() <= ResultBuffers::MAX_RECYCLED_CAPACITY &&
+        buffer.capacity() > GetResultBuffers().json.capacity())
+    {
+        GetResultBuffers().json = std::move(buffer);
+    }
+}
+
+inline void recycleResultBuffer(std::string &&buffer)
+{
+    if (buffer.capacity() <= ResultBuffers::MAX_RECYCLED_CAPACITY &&
+        buffer.capacity() > GetResultBuffers().bytes.capacity())
+    {
+        GetResultBuffers().bytes = std::move(buffer);
+    }
+}
+
 class BaseService
 {
   public:
-    using ResultT = mapbox::util::variant<util::json::Object, std::string>;
+    // JSON as a tree or already streamed into a buffer, a binary protobuf string or other bytes
+    using ResultT =
+        mapbox::util::variant<util::json::Object, util::json::Writer, std::string, OctetStream>;
 
     BaseService(OSRM &routing_machine) : routing_machine(routing_machine) {}
     virtual ~BaseService() = default;
 
-    virtual engine::Status
-    RunQuery(std::size_t prefix_length, std::string &query, ResultT &result) = 0;
+    // profile is the profile of the URL, it selects the dataset of the query
+    virtual engine::Status RunQuery(std::size_t prefix_length,
+                                    const std::string &profile,
+                                    std::string &query,
+                                    ResultT &result) = 0;
 
     virtual unsigned GetVersion() = 0;
 
   protected:
+    // Results that stream JSON or write bytes start from the buffers of the previous query
+    static util::json::Writer &MakeWriterResult(ResultT &result)
+    {
+        result = util::json::Writer(std::move(GetResultBuffers().json));
+        return result.get<util::json::Writer>();
+    }
+
+    static std::string &MakeBytesResult(ResultT &result)
+    {
+        result = TakeBytesBuffer();
+        return result.get<std::string>();
+    }
+
+    static std::string TakeBytesBuffer()
+    {
+        auto buffer = std::move(GetResultBuffers().bytes);
+        buffer.clear();
+        return buffer;
+    }
+
     OSRM &routing_machine;
 };
 }
@@ -22,8 +22,10 @@ class TableService final : public BaseService
   public:
     TableService(OSRM &routing_machine) : BaseService(routing_machine) {}
 
-    engine::Status
-    RunQuery(std::size_t prefix_length, std::string &query, ResultT &result) final override;
+    engine::Status RunQuery(std::size_t prefix_length,
+                            const std::string &profile,
+                            std::string &query,
+                            ResultT &result) final override;
 
     unsigned GetVersion() final override { return 1; }
 };
@@ -2,9 +2,13 @@
 #define SERVER_SERVICE_HANLDER_HPP
 
 #include "server/service/base_service.hpp"
+#include "server/worker_pool.hpp"
 
 #include "osrm/osrm.hpp"
 
+#include <functional>
+#include <memory>
+#include <string>
 #include <unordered_map>
 
 namespace osrm
@@ -29,6 +33,19 @@ class ServiceHandlerInterface
     virtual ~ServiceHandlerInterface() {}
     virtual engine::Status RunQuery(api::ParsedURL parsed_url,
                                     service::BaseService::ResultT &result) = 0;
+
+    // Runs a task that queries the given service, returns false if it was rejected
+    virtual bool Schedule(const std::string & /*service*/, std::function<void()> task)
+    {
+        task();
+        return true;
+    }
+
+    // Appends metrics in the Prometheus text format
+    virtual void WriteMetrics(std::string & /*output*/) {}
+
+    // Allocates what the queries of the calling thread need ahead of the first request
+    virtual void WarmUpThread() {}
 };
 
 class ServiceHandler final : public ServiceHandlerInterface
@@ -39,9 +56,26 @@ class ServiceHandler final : public ServiceHandlerInterface
 
     virtual engine::Status RunQuery(api::ParsedURL parsed_url, ResultT &result) override;
 
+    // Tasks of services without a worker pool run on the calling thread
+    virtual bool Schedule(const std::string &service, std::function<void()> task) override;
+
+    // Latency quantiles of every query phase since startup
+    virtual void WriteMetrics(std::string &output) override;
+
+    virtual void WarmUpThread() override;
+
+    // Runs the queries of a service on threads of its own, returns false for unknown services.
+    // With warm_up the threads are warmed up before it returns.
+    bool AddWorkerPool(const std::string &service,
+                       const std::size_t num_threads,
+                       const std::size_t max_queued_requests,
+                       const bool warm_up = false);
+
   private:
     std::unordered_map<std::string, std::unique_ptr<service::BaseService>> service_map;
     OSRM routing_machine;
+    // destroyed first, running tasks still use the routing machine
+    std::unordered_map<std::string, std::unique_ptr<WorkerPool>> worker_pools;
 };
 }
 }
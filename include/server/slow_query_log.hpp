@@ -0,0 +1,42 @@
+#ifndef SERVER_SLOW_QUERY_LOG_HPP
+#define SERVER_SLOW_QUERY_LOG_HPP
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+namespace osrm
+{
+namespace server
+{
+
+namespace http
+{
+class reply;
+struct request;
+}
+
+// Appends the requests that took longer than a threshold to a file, one JSON object per line
+// with the URL, the status, the time of every phase of the request and the counters of its
+// searches. Tail latencies can be tied to coordinates and areas of the dataset with it.
+class SlowQueryLog
+{
+  public:
+    // Throws if the file can not be opened
+    SlowQueryLog(const std::string &path, const std::chrono::steady_clock::duration threshold);
+    SlowQueryLog(const SlowQueryLog &) = delete;
+    SlowQueryLog &operator=(const SlowQueryLog &) = delete;
+
+    // Writes the request if it took longer than the threshold, called once its reply is complete
+    void Log(const http::request &request, const http::reply &reply);
+
+  private:
+    const std::chrono::steady_clock::duration threshold;
+    std::mutex mutex;
+    std::ofstream stream;
+};
+}
+}
+
+#endif // SERVER_SLOW_QUERY_LOG_HPP
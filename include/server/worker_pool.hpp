@@ -0,0 +1,89 @@
+#ifndef SERVER_WORKER_POOL_HPP
+#define SERVER_WORKER_POOL_HPP
+
+#include <boost/asio.hpp>
+#include <boost/thread/barrier.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+
+// Fixed number of threads that run the queries of one service. At most max_queued_tasks wait for
+// a free thread, further tasks are rejected right away instead of adding to the latency.
+class WorkerPool
+{
+  public:
+    // Every thread runs the initializer before its first task, the constructor waits for them
+    WorkerPool(const std::size_t num_threads,
+               const std::size_t max_queued_tasks,
+               std::function<void()> thread_initializer = {})
+        : work(std::make_unique<boost::asio::io_service::work>(io_service)),
+          max_pending_tasks(num_threads + max_queued_tasks), pending_tasks(0)
+    {
+        auto initialized = std::make_shared<boost::barrier>(static_cast<unsigned>(num_threads + 1));
+        threads.reserve(num_threads);
+        for (std::size_t i = 0; i < num_threads; ++i)
+        {
+            threads.emplace_back([this, initialized, thread_initializer] {
+                if (thread_initializer)
+                {
+                    thread_initializer();
+                }
+                initialized->wait();
+                io_service.run();
+            });
+        }
+        initialized->wait();
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    ~WorkerPool()
+    {
+        // queued tasks are dropped, running ones are finished
+        work.reset();
+        io_service.stop();
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    // Returns false if the queue is full, the task is not run then
+    bool TryPost(std::function<void()> task)
+    {
+        if (pending_tasks.fetch_add(1) >= max_pending_tasks)
+        {
+            pending_tasks.fetch_sub(1);
+            return false;
+        }
+
+        io_service.post([ this, task = std::move(task) ]() {
+            task();
+            pending_tasks.fetch_sub(1);
+        });
+        return true;
+    }
+
+  private:
+    boost::asio::io_service io_service;
+    std::unique_ptr<boost::asio::io_service::work> work;
+    std::vector<std::thread> threads;
+    const std::size_t max_pending_tasks;
+    // running and queued tasks
+    std::atomic<std::size_t> pending_tasks;
+};
+}
+}
+
+#endif // SERVER_WORKER_POOL_HPP
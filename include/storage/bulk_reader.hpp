@@ -0,0 +1,93 @@
+#ifndef OSRM_STORAGE_BULK_READER_HPP_
+#define OSRM_STORAGE_BULK_READER_HPP_
+
+#include <boost/filesystem/path.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace storage
+{
+namespace io
+{
+
+// Reads large parts of a file straight into memory with many reads in flight. The parts are
+// split into chunks that are read with O_DIRECT past the page cache, through io_uring where the
+// kernel supports it and with pread otherwise. Chunks that are not aligned to the blocks of the
+// file go through aligned bounce buffers. Small reads like headers go through the page cache.
+//
+//   BulkReader reader(path);
+//   const auto count = reader.Read<std::uint64_t>(0);
+//   reader.Queue(sizeof(count), buffer, count * sizeof(T));
+//   reader.Wait();
+class BulkReader
+{
+  public:
+    // size of the chunks and the number of chunks in flight
+    static const constexpr std::size_t CHUNK_SIZE = 1 << 20;
+    static const constexpr std::size_t QUEUE_DEPTH = 32;
+    // the alignment of direct reads, a multiple of the logical block size of common devices
+    static const constexpr std::size_t ALIGNMENT = 4096;
+
+    explicit BulkReader(const boost::filesystem::path &path);
+    ~BulkReader();
+
+    BulkReader(const BulkReader &) = delete;
+    BulkReader &operator=(const BulkReader &) = delete;
+
+    std::uint64_t GetSize() const { return file_size; }
+
+    // true if the chunks are read through io_uring and not with pread
+    bool UsesIOUring() const;
+
+    // Reads `size` bytes at `offset` at once, throws if the file ends before
+    void Read(const std::uint64_t offset, void *buffer, const std::size_t size);
+
+    template <typename T> T Read(const std::uint64_t offset)
+    {
+        T value;
+        Read(offset, &value, sizeof(T));
+        return value;
+    }
+
+    // Queues a read of `size` bytes at `offset`, the buffer has to stay valid until Wait()
+    void Queue(const std::uint64_t offset, void *buffer, const std::uint64_t size);
+
+    // Reads all queued parts and returns once they are in memory, throws if one failed
+    void Wait();
+
+  private:
+    struct Chunk
+    {
+        std::uint64_t offset;
+        char *buffer;
+        std::uint64_t size;
+    };
+    struct Slot;
+    struct Ring;
+
+    void Start(Slot &slot, const Chunk &chunk);
+    bool Complete(Slot &slot, const std::int64_t result);
+    void WaitWithPread(const std::vector<Chunk> &pending);
+    void WaitWithRing(const std::vector<Chunk> &pending);
+
+    std::string path;
+    int buffered_fd = -1;
+    int direct_fd = -1;
+    // cleared if the file system rejects direct reads, the rest goes through the page cache
+    bool direct_reads = false;
+    std::uint64_t file_size = 0;
+    std::vector<Chunk> chunks;
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::unique_ptr<Ring> ring;
+};
+}
+}
+}
+
+#endif
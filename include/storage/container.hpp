@@ -0,0 +1,80 @@
+#ifndef OSRM_STORAGE_CONTAINER_HPP_
+#define OSRM_STORAGE_CONTAINER_HPP_
+
+#include "storage/shared_datatype.hpp"
+#include "util/exception.hpp"
+#include "util/fingerprint.hpp"
+#include "util/io.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstdint>
+
+namespace osrm
+{
+namespace storage
+{
+
+// A dataset container is the header followed by the data and the metric block exactly as
+// osrm-datastore lays them out in shared memory, so it can be used without parsing or copying.
+struct ContainerHeader
+{
+    util::FingerPrint fingerprint;
+    SharedDataLayout layout;
+};
+
+// the data block starts page aligned
+const constexpr std::uint64_t CONTAINER_DATA_OFFSET = 4096;
+static_assert(sizeof(ContainerHeader) <= CONTAINER_DATA_OFFSET, "container header too large");
+
+// Private mapping of a container file: pages are shared with the page cache and stay read only
+// unless written to.
+class MappedContainer
+{
+  public:
+    explicit MappedContainer(const boost::filesystem::path &path)
+    {
+        if (!boost::filesystem::is_regular_file(path))
+        {
+            throw util::exception("Could not open " + path.string() + " for reading.");
+        }
+
+        file = boost::interprocess::file_mapping(path.string().c_str(),
+                                                 boost::interprocess::read_only);
+        region = boost::interprocess::mapped_region(file, boost::interprocess::copy_on_write);
+
+        if (region.get_size() < CONTAINER_DATA_OFFSET)
+        {
+            throw util::exception(path.string() + " is not a dataset container");
+        }
+        header = static_cast<ContainerHeader *>(region.get_address());
+        if (!util::checkFingerprint(header->fingerprint))
+        {
+            throw util::exception("Fingerprint of " + path.string() + " does not match");
+        }
+        if (region.get_size() < CONTAINER_DATA_OFFSET + header->layout.GetSizeOfLayout() +
+                                    header->layout.GetSizeOfMetric())
+        {
+            throw util::exception(path.string() + " is truncated");
+        }
+    }
+
+    SharedDataLayout *Layout() const { return &header->layout; }
+
+    char *Data() const { return static_cast<char *>(region.get_address()) + CONTAINER_DATA_OFFSET; }
+
+    // the metric block directly follows the data block
+    char *Metric() const { return Data() + header->layout.GetSizeOfLayout(); }
+
+  private:
+    boost::interprocess::file_mapping file;
+    boost::interprocess::mapped_region region;
+    ContainerHeader *header;
+};
+}
+}
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef OSRM_STORAGE_INSPECT_HPP
+#define OSRM_STORAGE_INSPECT_HPP
+
+#include <boost/filesystem/path.hpp>
+
+namespace osrm
+{
+namespace storage
+{
+
+// Lists the blocks of the current dataset in shared memory with their entries, their size and how
+// many of their bytes are resident in memory, followed by the metric blocks of the additional
+// metrics. Attaching the regions does not touch their pages, so the listing does not change
+// their residency.
+void listSharedMemory();
+
+// Lists the blocks of a container like the ones in shared memory. Mappings of a file are resident
+// as far as the file is in the page cache, which shows how much of the dataset a cold start
+// would have to read from disk.
+void listContainer(const boost::filesystem::path &path);
+}
+}
+
+#endif
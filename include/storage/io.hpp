@@ -2,16 +2,24 @@
 #define OSRM_STORAGE_IO_HPP_
 
 #include "contractor/query_edge.hpp"
+#include "engine/query_graph.hpp"
 #include "extractor/extractor.hpp"
 #include "extractor/original_edge_data.hpp"
 #include "extractor/query_node.hpp"
+#include "storage/bulk_reader.hpp"
+#include "util/coordinate_list.hpp"
 #include "util/fingerprint.hpp"
+#include "util/geometry_node_list.hpp"
+#include "util/segment_weight_list.hpp"
 #include "util/simple_logger.hpp"
+#include "util/speed_profile.hpp"
 #include "util/static_graph.hpp"
 
 #include <boost/filesystem/fstream.hpp>
 
+#include <algorithm>
 #include <tuple>
+#include <vector>
 
 namespace osrm
 {
@@ -52,23 +60,17 @@ static_assert(sizeof(HSGRHeader) == 20, "HSGRHeader is not packed");
 
 // Reads the checksum, number of nodes and number of edges written in the header file of a `.hsgr`
 // file and returns them in a HSGRHeader struct
-inline HSGRHeader readHSGRHeader(boost::filesystem::ifstream &input_stream)
+inline HSGRHeader readHSGRHeader(BulkReader &reader)
 {
     const util::FingerPrint fingerprint_valid = util::FingerPrint::GetValid();
-    util::FingerPrint fingerprint_loaded;
-    input_stream.read(reinterpret_cast<char *>(&fingerprint_loaded), sizeof(util::FingerPrint));
+    const auto fingerprint_loaded = reader.Read<util::FingerPrint>(0);
     if (!fingerprint_loaded.TestGraphUtil(fingerprint_valid))
     {
         util::SimpleLogger().Write(logWARNING) << ".hsgr was prepared with different build.\n"
                                                   "Reprocess to get rid of this warning.";
     }
 
-    HSGRHeader header;
-    input_stream.read(reinterpret_cast<char *>(&header.checksum), sizeof(header.checksum));
-    input_stream.read(reinterpret_cast<char *>(&header.number_of_nodes),
-                      sizeof(header.number_of_nodes));
-    input_stream.read(reinterpret_cast<char *>(&header.number_of_edges),
-                      sizeof(header.number_of_edges));
+    const auto header = reader.Read<HSGRHeader>(sizeof(util::FingerPrint));
 
     BOOST_ASSERT_MSG(0 != header.number_of_nodes, "number of nodes is zero");
     // number of edges can be zero, this is the case in a few test fixtures
@@ -76,20 +78,56 @@ inline HSGRHeader readHSGRHeader(boost::filesystem::ifstream &input_stream)
     return header;
 }
 
-// Reads the graph data of a `.hsgr` file into memory
-// Needs to be called after readHSGRHeader() to get the correct offset in the stream
-using NodeT = typename util::StaticGraph<contractor::QueryEdge::EdgeData>::NodeArrayEntry;
-using EdgeT = typename util::StaticGraph<contractor::QueryEdge::EdgeData>::EdgeArrayEntry;
-inline void readHSGR(boost::filesystem::ifstream &input_stream,
+// Reads the graph data of a `.hsgr` file into memory, the edges are split into the hot and the
+// cold part of the search graph a chunk at a time and ordered by their directions per node
+using NodeT = engine::QueryGraph<false>::NodeArrayEntry;
+using FileNodeT = engine::QueryGraph<false>::FileNodeEntry;
+using EdgeT = engine::QueryGraph<false>::FileEdgeEntry;
+const constexpr std::uint64_t HSGR_EDGE_CHUNK_SIZE = 1024 * 1024;
+inline void readHSGR(BulkReader &reader,
                      NodeT *node_buffer,
                      const std::uint64_t number_of_nodes,
-                     EdgeT *edge_buffer,
+                     engine::HotEdgeData *hot_edge_buffer,
+                     engine::ColdEdgeData *cold_edge_buffer,
                      const std::uint64_t number_of_edges)
 {
     BOOST_ASSERT(node_buffer);
-    BOOST_ASSERT(edge_buffer);
-    input_stream.read(reinterpret_cast<char *>(node_buffer), number_of_nodes * sizeof(NodeT));
-    input_stream.read(reinterpret_cast<char *>(edge_buffer), number_of_edges * sizeof(EdgeT));
+    BOOST_ASSERT(number_of_edges == 0 || (hot_edge_buffer && cold_edge_buffer));
+    const std::uint64_t nodes_offset = sizeof(util::FingerPrint) + sizeof(HSGRHeader);
+    std::vector<FileNodeT> file_nodes(number_of_nodes);
+    reader.Queue(nodes_offset, file_nodes.data(), number_of_nodes * sizeof(FileNodeT));
+    reader.Wait();
+
+    const std::uint64_t edges_offset = nodes_offset + number_of_nodes * sizeof(FileNodeT);
+    std::vector<EdgeT> chunk(std::min(number_of_edges, HSGR_EDGE_CHUNK_SIZE));
+    for (std::uint64_t first = 0; first < number_of_edges; first += chunk.size())
+    {
+        const auto count = std::min<std::uint64_t>(chunk.size(), number_of_edges - first);
+        reader.Queue(edges_offset + first * sizeof(EdgeT), chunk.data(), count * sizeof(EdgeT));
+        reader.Wait();
+        for (std::uint64_t index = 0; index < count; ++index)
+        {
+            engine::QueryGraph<false>::SplitEdge(
+                chunk[index], hot_edge_buffer[first + index], cold_edge_buffer[first + index]);
+        }
+    }
+
+    engine::QueryGraph<false>::EdgeBuffer buffer;
+    for (std::uint64_t node = 0; node + 1 < number_of_nodes; ++node)
+    {
+        engine::QueryGraph<false>::PartitionEdges(file_nodes[node].first_edge,
+                                                  file_nodes[node + 1].first_edge,
+                                                  hot_edge_buffer,
+                                                  cold_edge_buffer,
+                                                  node_buffer[node],
+                                                  buffer);
+    }
+    // the sentinel node marks the end of the edges of the last node
+    if (number_of_nodes > 0)
+    {
+        const auto end = file_nodes.back().first_edge;
+        node_buffer[number_of_nodes - 1] = {end, end, end};
+    }
 }
 
 // Loads properties from a `.properties` file into memory
@@ -111,6 +149,55 @@ inline void readTimestamp(boost::filesystem::ifstream &timestamp_input_stream,
     timestamp_input_stream.read(timestamp, timestamp_length * sizeof(char));
 }
 
+// Loads the lengths of the geometry segments from .segment_lengths into memory, they follow
+// their count
+inline void readSegmentLengths(BulkReader &reader,
+                               SegmentLength *segment_length_buffer,
+                               const std::uint64_t number_of_segment_lengths)
+{
+    BOOST_ASSERT(segment_length_buffer);
+    reader.Queue(sizeof(std::uint64_t),
+                 segment_length_buffer,
+                 number_of_segment_lengths * sizeof(SegmentLength));
+    reader.Wait();
+}
+
+// The factors of all speed profiles are followed by the segments that use them, both are
+// prefixed by their count
+struct SpeedProfilesHeader
+{
+    std::uint64_t number_of_factors;
+    std::uint64_t number_of_segments;
+};
+
+// Reads the counts of a `.speed_profiles` file, the stream is at the start of the file again
+inline SpeedProfilesHeader readSpeedProfilesHeader(boost::filesystem::ifstream &input_stream)
+{
+    SpeedProfilesHeader header{0, 0};
+    input_stream.read(reinterpret_cast<char *>(&header.number_of_factors),
+                      sizeof(header.number_of_factors));
+    input_stream.seekg(header.number_of_factors * sizeof(std::uint8_t), std::ios::cur);
+    input_stream.read(reinterpret_cast<char *>(&header.number_of_segments),
+                      sizeof(header.number_of_segments));
+    input_stream.seekg(0);
+    return header;
+}
+
+// Loads the speed profiles from .speed_profiles into memory
+// Needs to be called after readSpeedProfilesHeader() to get the counts
+inline void readSpeedProfiles(boost::filesystem::ifstream &input_stream,
+                              std::uint8_t *factors,
+                              const std::uint64_t number_of_factors,
+                              util::SpeedProfileSegment *segments,
+                              const std::uint64_t number_of_segments)
+{
+    input_stream.seekg(sizeof(std::uint64_t));
+    input_stream.read(reinterpret_cast<char *>(factors), number_of_factors * sizeof(std::uint8_t));
+    input_stream.seekg(sizeof(std::uint64_t), std::ios::cur);
+    input_stream.read(reinterpret_cast<char *>(segments),
+                      number_of_segments * sizeof(util::SpeedProfileSegment));
+}
+
 // Loads datasource_indexes from .datasource_indexes into memory
 // Needs to be called after readElementCount() to get the correct offset in the stream
 inline void readDatasourceIndexes(boost::filesystem::ifstream &datasource_indexes_input_stream,
@@ -177,6 +264,80 @@ void readNodes(boost::filesystem::ifstream &nodes_input_stream,
     }
 }
 
+// Reads the nodes of a `.nodes` file like readNodes(), the coordinates are compressed with the
+// encoder
+// Needs to be called after readElementCount() to get the correct offset in the stream
+template <typename OSMNodeIDVectorT>
+void readCompressedNodes(boost::filesystem::ifstream &nodes_input_stream,
+                         util::CoordinateEncoder &encoder,
+                         OSMNodeIDVectorT &osmnodeid_list,
+                         const std::uint64_t number_of_coordinates)
+{
+    extractor::QueryNode current_node;
+    for (std::uint64_t i = 0; i < number_of_coordinates; ++i)
+    {
+        nodes_input_stream.read((char *)&current_node, sizeof(extractor::QueryNode));
+        encoder.push_back(util::Coordinate(current_node.lon, current_node.lat));
+        osmnodeid_list.push_back(current_node.node_id);
+    }
+}
+
+// Counts the blocks and bytes of the compressed coordinates of a `.nodes` file
+// Needs to be called after readElementCount() to get the correct offset in the stream
+inline util::CoordinateEncoder
+countCompressedCoordinates(boost::filesystem::ifstream &nodes_input_stream,
+                           const std::uint64_t number_of_coordinates)
+{
+    util::CoordinateEncoder encoder;
+    extractor::QueryNode current_node;
+    for (std::uint64_t i = 0; i < number_of_coordinates; ++i)
+    {
+        nodes_input_stream.read((char *)&current_node, sizeof(extractor::QueryNode));
+        encoder.push_back(util::Coordinate(current_node.lon, current_node.lat));
+    }
+    return encoder;
+}
+
+// Passes `number_of_weights` weights at `offset` of a .geometry file to the encoder, a chunk at a
+// time
+inline void readSegmentWeights(BulkReader &reader,
+                               const std::uint64_t offset,
+                               const std::uint64_t number_of_weights,
+                               util::SegmentWeightEncoder &encoder)
+{
+    std::vector<EdgeWeight> chunk(std::min<std::uint64_t>(number_of_weights, 1 << 22));
+    for (std::uint64_t first = 0; first < number_of_weights; first += chunk.size())
+    {
+        const auto count = std::min<std::uint64_t>(chunk.size(), number_of_weights - first);
+        reader.Queue(offset + first * sizeof(EdgeWeight), chunk.data(), count * sizeof(EdgeWeight));
+        reader.Wait();
+        for (std::uint64_t i = 0; i < count; ++i)
+        {
+            encoder.push_back(chunk[i]);
+        }
+    }
+}
+
+// Passes `number_of_nodes` geometry nodes at `offset` of a .geometry file to the encoder, a chunk
+// at a time
+inline void readGeometryNodes(BulkReader &reader,
+                              const std::uint64_t offset,
+                              const std::uint64_t number_of_nodes,
+                              util::GeometryNodeEncoder &encoder)
+{
+    std::vector<NodeID> chunk(std::min<std::uint64_t>(number_of_nodes, 1 << 22));
+    for (std::uint64_t first = 0; first < number_of_nodes; first += chunk.size())
+    {
+        const auto count = std::min<std::uint64_t>(chunk.size(), number_of_nodes - first);
+        reader.Queue(offset + first * sizeof(NodeID), chunk.data(), count * sizeof(NodeID));
+        reader.Wait();
+        for (std::uint64_t i = 0; i < count; ++i)
+        {
+            encoder.push_back(chunk[i]);
+        }
+    }
+}
+
 // Reads datasource names out of .datasource_names files and metadata such as
 // the length and offset of each name
 struct DatasourceNamesData
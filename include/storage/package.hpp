@@ -0,0 +1,129 @@
+#ifndef OSRM_STORAGE_PACKAGE_HPP_
+#define OSRM_STORAGE_PACKAGE_HPP_
+
+#include "storage/bulk_reader.hpp"
+#include "storage/shared_datatype.hpp"
+#include "util/fingerprint.hpp"
+
+#include <boost/filesystem/path.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace storage
+{
+
+// A dataset package holds the data and the metric blocks of a container for distribution to
+// other hosts. Every block is split into the chunks its checksum is computed from, see
+// util::blockChecksum, and every chunk is stored as a frame of its own, compressed with zstd.
+// Frames carry the CRC32C of their chunk, so the checksums of the frames combine to the checksum
+// of their block and the blocks are verified while they are decompressed.
+//
+// A delta package is made against a base dataset, a frame of a chunk that did not change only
+// refers to the chunk of the base and a changed chunk is stored as a patch: its XOR with the
+// chunk of the base, which is mostly zeros after an update of a few weights and compresses to
+// little more than the changed bytes. A delta is applied to the dataset in shared memory.
+//
+// The header is followed by the index of the frames at PACKAGE_INDEX_OFFSET and the frames.
+enum class PackageCodec : std::uint32_t
+{
+    Stored = 0,
+    Zstd = 1,
+    // the chunk of the base
+    Unchanged = 2,
+    // the XOR with the chunk of the base, compressed with zstd
+    ZstdPatch = 3
+};
+
+struct PackageHeader
+{
+    util::FingerPrint fingerprint;
+    SharedDataLayout layout;
+    std::uint64_t number_of_frames;
+    // non-zero for a delta package, the base is the dataset of the base layout
+    std::uint64_t is_delta;
+    SharedDataLayout base_layout;
+};
+
+struct PackageFrame
+{
+    // position and size of the frame in the file
+    std::uint64_t offset;
+    std::uint64_t size;
+    // CRC32C of the chunk
+    std::uint32_t checksum;
+    PackageCodec codec;
+};
+
+const constexpr std::uint64_t PACKAGE_INDEX_OFFSET = 4096;
+static_assert(sizeof(PackageHeader) <= PACKAGE_INDEX_OFFSET, "package header too large");
+
+// The chunks of the blocks of a layout in the order of their frames
+struct PackageChunk
+{
+    SharedDataLayout::BlockID block;
+    // offset in the data or the metric region
+    std::uint64_t offset;
+    std::uint64_t size;
+};
+std::vector<PackageChunk> getPackageChunks(const SharedDataLayout &layout);
+
+// The dataset a delta package is made against or applied to, a region can be nullptr if no
+// chunk of it is needed
+struct PackageBase
+{
+    const SharedDataLayout *layout;
+    const char *data_memory;
+    const char *metric_memory;
+};
+
+// False if osrm is built without zstd, packages are then only stored uncompressed
+bool packageCompressionSupported();
+
+// Writes the data and the metric region of the layout to a package and returns its size. The
+// frames are compressed in parallel with the zstd level, 0 stores them as they are. With a base
+// a delta package is written. The package is written beside the path and then renamed.
+std::uint64_t writePackage(const boost::filesystem::path &path,
+                           const SharedDataLayout &layout,
+                           const char *data_memory,
+                           const char *metric_memory,
+                           const int level,
+                           const PackageBase &base = PackageBase{nullptr, nullptr, nullptr});
+
+// Reads a package straight into the regions of its layout:
+//
+//   PackageReader reader(path);
+//   const auto &layout = reader.GetLayout();
+//   reader.Read(allocate(layout.GetSizeOfLayout()), allocate(layout.GetSizeOfMetric()));
+class PackageReader
+{
+  public:
+    // Throws if the file is not a package of this version of osrm
+    explicit PackageReader(const boost::filesystem::path &path);
+
+    const SharedDataLayout &GetLayout() const { return header.layout; }
+
+    bool IsDelta() const { return header.is_delta != 0; }
+
+    // Decompresses the frames in parallel into the regions and verifies the blocks, a region can
+    // be nullptr to skip its blocks. A delta package takes the unchanged chunks from the base,
+    // which has to be the dataset it was made against. Throws if a block does not match its
+    // checksum.
+    void Read(char *data_memory,
+              char *metric_memory,
+              const PackageBase &base = PackageBase{nullptr, nullptr, nullptr});
+
+  private:
+    std::string path;
+    io::BulkReader reader;
+    PackageHeader header;
+    std::vector<PackageChunk> chunks;
+    std::vector<PackageFrame> frames;
+};
+}
+}
+
+#endif
@@ -12,10 +12,7 @@ namespace storage
 struct SharedBarriers
 {
 
-    SharedBarriers()
-        : current_regions_mutex(boost::interprocess::open_or_create, "current_regions"),
-          regions_1_mutex(boost::interprocess::open_or_create, "regions_1"),
-          regions_2_mutex(boost::interprocess::open_or_create, "regions_2")
+    SharedBarriers() : current_regions_mutex(boost::interprocess::open_or_create, "current_regions")
     {
     }
 
@@ -23,12 +20,9 @@ struct SharedBarriers
     {
         boost::interprocess::named_sharable_mutex::remove("current_regions");
     }
-    static void resetRegions1() { boost::interprocess::named_sharable_mutex::remove("regions_1"); }
-    static void resetRegions2() { boost::interprocess::named_sharable_mutex::remove("regions_2"); }
 
+    // guards the regions table, clients only hold it while attaching a new dataset
     boost::interprocess::named_upgradable_mutex current_regions_mutex;
-    boost::interprocess::named_sharable_mutex regions_1_mutex;
-    boost::interprocess::named_sharable_mutex regions_2_mutex;
 };
 }
 }
@@ -1,12 +1,16 @@
 #ifndef SHARED_DATA_TYPE_HPP
 #define SHARED_DATA_TYPE_HPP
 
+#include "util/crc32c.hpp"
 #include "util/exception.hpp"
 #include "util/simple_logger.hpp"
 
 #include <cstdint>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <string>
 
 namespace osrm
 {
@@ -22,8 +26,12 @@ const constexpr char *block_id_to_name[] = {"NAME_OFFSETS",
                                             "NAME_ID_LIST",
                                             "VIA_NODE_LIST",
                                             "GRAPH_NODE_LIST",
-                                            "GRAPH_EDGE_LIST",
+                                            "GRAPH_HOT_EDGE_LIST",
+                                            "GRAPH_COLD_EDGE_LIST",
                                             "COORDINATE_LIST",
+                                            "NUMBER_OF_COORDINATES",
+                                            "COORDINATE_BLOCKS",
+                                            "COORDINATE_DELTAS",
                                             "OSM_NODE_ID_LIST",
                                             "TURN_INSTRUCTION",
                                             "TRAVEL_MODE",
@@ -31,8 +39,13 @@ const constexpr char *block_id_to_name[] = {"NAME_OFFSETS",
                                             "R_SEARCH_TREE",
                                             "GEOMETRIES_INDEX",
                                             "GEOMETRIES_NODE_LIST",
+                                            "GEOMETRIES_NODE_BLOCKS",
+                                            "GEOMETRIES_NODE_DELTAS",
                                             "GEOMETRIES_FWD_WEIGHT_LIST",
                                             "GEOMETRIES_REV_WEIGHT_LIST",
+                                            "GEOMETRIES_FWD_WEIGHT_OVERFLOW",
+                                            "GEOMETRIES_REV_WEIGHT_OVERFLOW",
+                                            "GEOMETRIES_LENGTH_LIST",
                                             "HSGR_CHECKSUM",
                                             "TIMESTAMP",
                                             "FILE_INDEX_PATH",
@@ -52,7 +65,16 @@ const constexpr char *block_id_to_name[] = {"NAME_OFFSETS",
                                             "POST_TURN_BEARING",
                                             "TURN_LANE_DATA",
                                             "LANE_DESCRIPTION_OFFSETS",
-                                            "LANE_DESCRIPTION_MASKS"};
+                                            "LANE_DESCRIPTION_MASKS",
+                                            "SPEED_PROFILE_FACTORS",
+                                            "SPEED_PROFILE_SEGMENTS",
+                                            "NODE_RENUMBERING",
+                                            "GEOMETRIES_FWD_WEIGHT_OFFSETS",
+                                            "GEOMETRIES_REV_WEIGHT_OFFSETS",
+                                            "NUMBER_OF_CORE_LANDMARKS",
+                                            "CORE_LANDMARK_INDICES",
+                                            "CORE_LANDMARK_WEIGHTS",
+                                            "EDGE_BASED_NODE_DATA"};
 
 struct SharedDataLayout
 {
@@ -64,17 +86,28 @@ struct SharedDataLayout
         NAME_ID_LIST,
         VIA_NODE_LIST,
         GRAPH_NODE_LIST,
-        GRAPH_EDGE_LIST,
+        GRAPH_HOT_EDGE_LIST,
+        GRAPH_COLD_EDGE_LIST,
+        // either the coordinates or their compressed blocks and deltas hold entries
         COORDINATE_LIST,
+        NUMBER_OF_COORDINATES,
+        COORDINATE_BLOCKS,
+        COORDINATE_DELTAS,
         OSM_NODE_ID_LIST,
         TURN_INSTRUCTION,
         TRAVEL_MODE,
         ENTRY_CLASSID,
         R_SEARCH_TREE,
         GEOMETRIES_INDEX,
+        // either the nodes or their compressed blocks and deltas hold entries
         GEOMETRIES_NODE_LIST,
+        GEOMETRIES_NODE_BLOCKS,
+        GEOMETRIES_NODE_DELTAS,
         GEOMETRIES_FWD_WEIGHT_LIST,
         GEOMETRIES_REV_WEIGHT_LIST,
+        GEOMETRIES_FWD_WEIGHT_OVERFLOW,
+        GEOMETRIES_REV_WEIGHT_OVERFLOW,
+        GEOMETRIES_LENGTH_LIST,
         HSGR_CHECKSUM,
         TIMESTAMP,
         FILE_INDEX_PATH,
@@ -95,13 +128,26 @@ struct SharedDataLayout
         TURN_LANE_DATA,
         LANE_DESCRIPTION_OFFSETS,
         LANE_DESCRIPTION_MASKS,
+        SPEED_PROFILE_FACTORS,
+        SPEED_PROFILE_SEGMENTS,
+        NODE_RENUMBERING,
+        // optional, empty unless osrm-datastore --weight-offsets computes them
+        GEOMETRIES_FWD_WEIGHT_OFFSETS,
+        GEOMETRIES_REV_WEIGHT_OFFSETS,
+        // optional, empty unless osrm-contract --core-landmarks wrote them
+        NUMBER_OF_CORE_LANDMARKS,
+        CORE_LANDMARK_INDICES,
+        CORE_LANDMARK_WEIGHTS,
+        EDGE_BASED_NODE_DATA,
         NUM_BLOCKS
     };
 
     std::array<uint64_t, NUM_BLOCKS> num_entries;
     std::array<uint64_t, NUM_BLOCKS> entry_size;
+    // see util::blockChecksum, identical blocks of two datasets have the same checksum
+    std::array<uint32_t, NUM_BLOCKS> checksums;
 
-    SharedDataLayout() : num_entries(), entry_size() {}
+    SharedDataLayout() : num_entries(), entry_size(), checksums() {}
 
     template <typename T> inline void SetBlockSize(BlockID bid, uint64_t entries)
     {
@@ -125,21 +171,117 @@ struct SharedDataLayout
         return AlignBlockSize(num_entries[bid] * entry_size[bid]);
     }
 
-    inline uint64_t GetSizeOfLayout() const
+    // Blocks that change with the edge weights. They are stored in a memory region of their own,
+    // so that a metric update only replaces them and shares all other blocks.
+    static bool IsMetricBlock(BlockID bid)
     {
-        return GetBlockOffset(NUM_BLOCKS) + NUM_BLOCKS * 2 * sizeof(CANARY);
+        switch (bid)
+        {
+        case GRAPH_NODE_LIST:
+        case GRAPH_HOT_EDGE_LIST:
+        case GRAPH_COLD_EDGE_LIST:
+        case GEOMETRIES_FWD_WEIGHT_LIST:
+        case GEOMETRIES_REV_WEIGHT_LIST:
+        case GEOMETRIES_FWD_WEIGHT_OVERFLOW:
+        case GEOMETRIES_REV_WEIGHT_OVERFLOW:
+        case HSGR_CHECKSUM:
+        case CORE_MARKER:
+        case DATASOURCES_LIST:
+        case DATASOURCE_NAME_DATA:
+        case DATASOURCE_NAME_OFFSETS:
+        case DATASOURCE_NAME_LENGTHS:
+        case SPEED_PROFILE_FACTORS:
+        case SPEED_PROFILE_SEGMENTS:
+        case NODE_RENUMBERING:
+        case GEOMETRIES_FWD_WEIGHT_OFFSETS:
+        case GEOMETRIES_REV_WEIGHT_OFFSETS:
+        case NUMBER_OF_CORE_LANDMARKS:
+        case CORE_LANDMARK_INDICES:
+        case CORE_LANDMARK_WEIGHTS:
+            return true;
+        default:
+            return false;
+        }
     }
 
+    // Size of the region that holds all blocks but the metric ones
+    inline uint64_t GetSizeOfLayout() const { return GetSizeOfRegion(false); }
+
+    // Size of the region that holds the metric blocks
+    inline uint64_t GetSizeOfMetric() const { return GetSizeOfRegion(true); }
+
+    // Offset of the block in its region
     inline uint64_t GetBlockOffset(BlockID bid) const
     {
         uint64_t result = sizeof(CANARY);
         for (auto i = 0; i < bid; i++)
         {
-            result += GetBlockSize((BlockID)i) + 2 * sizeof(CANARY);
+            if (IsMetricBlock((BlockID)i) == IsMetricBlock(bid))
+            {
+                result += GetBlockSize((BlockID)i) + 2 * sizeof(CANARY);
+            }
         }
         return result;
     }
 
+    // True if both layouts hold the same blocks outside of the metric region
+    inline bool HasSameLayout(const SharedDataLayout &other) const
+    {
+        for (auto i = 0; i < NUM_BLOCKS; i++)
+        {
+            if (!IsMetricBlock((BlockID)i) &&
+                (num_entries[i] != other.num_entries[i] || entry_size[i] != other.entry_size[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // True if the blocks outside of the metric region hold the same data in both datasets
+    inline bool HasSameData(const SharedDataLayout &other) const
+    {
+        for (auto i = 0; i < NUM_BLOCKS; i++)
+        {
+            if (!IsMetricBlock((BlockID)i) && checksums[i] != other.checksums[i])
+            {
+                return false;
+            }
+        }
+        return HasSameLayout(other);
+    }
+
+    // Computes the checksums of the blocks in the given regions, a region can be nullptr to keep
+    // the checksums of its blocks
+    inline void ComputeChecksums(const char *data_memory, const char *metric_memory)
+    {
+        for (auto i = 0; i < NUM_BLOCKS; i++)
+        {
+            const char *memory = IsMetricBlock((BlockID)i) ? metric_memory : data_memory;
+            if (memory)
+            {
+                checksums[i] = util::blockChecksum(memory + GetBlockOffset((BlockID)i),
+                                                   GetBlockSize((BlockID)i));
+            }
+        }
+    }
+
+    // Throws if a block in the given regions does not match its checksum, a region can be
+    // nullptr to skip its blocks
+    inline void VerifyChecksums(const char *data_memory, const char *metric_memory) const
+    {
+        for (auto i = 0; i < NUM_BLOCKS; i++)
+        {
+            const char *memory = IsMetricBlock((BlockID)i) ? metric_memory : data_memory;
+            if (memory && util::blockChecksum(memory + GetBlockOffset((BlockID)i),
+                                              GetBlockSize((BlockID)i)) != checksums[i])
+            {
+                throw util::exception(std::string("Checksum of block does not match. (") +
+                                      block_id_to_name[i] + ")");
+            }
+        }
+    }
+
     template <typename T, bool WRITE_CANARY = false>
     inline T *GetBlockPtr(char *shared_memory, BlockID bid)
     {
@@ -171,8 +313,62 @@ struct SharedDataLayout
 
         return ptr;
     }
+
+  private:
+    inline uint64_t GetSizeOfRegion(const bool metric) const
+    {
+        uint64_t result = sizeof(CANARY);
+        for (auto i = 0; i < NUM_BLOCKS; i++)
+        {
+            if (IsMetricBlock((BlockID)i) == metric)
+            {
+                result += GetBlockSize((BlockID)i) + 2 * sizeof(CANARY);
+            }
+        }
+        return result;
+    }
 };
 
+// Additional metrics over the topology of a dataset, stored behind its layout in the layout
+// region. The layout of a metric only differs from the one of the dataset in the metric blocks,
+// which follow the metric blocks of the dataset in the metric region.
+struct SharedMetrics
+{
+    static const constexpr std::size_t MAX_METRICS = 8;
+    static const constexpr std::size_t MAX_NAME_LENGTH = 32;
+
+    struct Metric
+    {
+        char name[MAX_NAME_LENGTH];
+        // offset of the first metric block in the metric region
+        uint64_t offset;
+        SharedDataLayout layout;
+    };
+
+    SharedMetrics() : number_of_metrics(0) {}
+
+    // Returns the metric with the given name or nullptr if the dataset has none
+    Metric *Find(const std::string &name)
+    {
+        const auto end = metrics.begin() + number_of_metrics;
+        const auto found = std::find_if(
+            metrics.begin(), end, [&](const Metric &metric) { return name == metric.name; });
+        return found == end ? nullptr : &*found;
+    }
+
+    uint32_t number_of_metrics;
+    std::array<Metric, MAX_METRICS> metrics;
+};
+
+// The layout region holds the layout of the dataset followed by its additional metrics
+const constexpr std::size_t LAYOUT_REGION_SIZE = sizeof(SharedDataLayout) + sizeof(SharedMetrics);
+
+inline SharedMetrics *GetSharedMetrics(void *layout_region)
+{
+    return reinterpret_cast<SharedMetrics *>(static_cast<char *>(layout_region) +
+                                             sizeof(SharedDataLayout));
+}
+
 enum SharedDataType
 {
     CURRENT_REGIONS,
@@ -181,15 +377,23 @@ enum SharedDataType
     LAYOUT_2,
     DATA_2,
     LAYOUT_NONE,
-    DATA_NONE
+    DATA_NONE,
+    METRIC_1,
+    METRIC_2,
+    METRIC_NONE
 };
 
+// The layout and metric regions belong to the dataset, the data region can be shared by the
+// datasets of two consecutive metric updates. Clients poll the timestamp without locking and
+// only lock the table to read the regions once it changed.
 struct SharedDataTimestamp
 {
     SharedDataType layout;
     SharedDataType data;
-    unsigned timestamp;
+    SharedDataType metric;
+    std::atomic<unsigned> timestamp;
 };
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "the timestamp is shared between processes");
 
 inline std::string regionToString(const SharedDataType region)
 {
@@ -209,6 +413,12 @@ inline std::string regionToString(const SharedDataType region)
         return "LAYOUT_NONE";
     case DATA_NONE:
         return "DATA_NONE";
+    case METRIC_1:
+        return "METRIC_1";
+    case METRIC_2:
+        return "METRIC_2";
+    case METRIC_NONE:
+        return "METRIC_NONE";
     default:
         return "INVALID_REGION";
     }
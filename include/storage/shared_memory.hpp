@@ -2,6 +2,7 @@
 #define SHARED_MEMORY_HPP
 
 #include "util/exception.hpp"
+#include "util/huge_pages.hpp"
 #include "util/simple_logger.hpp"
 
 #include <boost/filesystem.hpp>
@@ -18,8 +19,9 @@
 #include <sys/shm.h>
 #endif
 
-// #include <cstring>
+#include <cerrno>
 #include <cstdint>
+#include <cstring>
 
 #include <algorithm>
 #include <exception>
@@ -48,11 +50,14 @@ class SharedMemory
     SharedMemory(const SharedMemory &) = delete;
     SharedMemory &operator=(const SharedMemory &) = delete;
 
+    // Huge pages are only requested when creating a region. A region of explicit huge pages is
+    // tried first, falling back to advising transparent huge pages.
     template <typename IdentifierT>
     SharedMemory(const boost::filesystem::path &lock_file,
                  const IdentifierT id,
                  const uint64_t size = 0,
-                 bool read_write = false)
+                 bool read_write = false,
+                 bool huge_pages = false)
         : key(lock_file.string().c_str(), id)
     {
         const auto access =
@@ -70,6 +75,13 @@ class SharedMemory
         // open or create
         else
         {
+            bool explicit_huge_pages = false;
+#ifdef __linux__
+            if (huge_pages)
+            {
+                explicit_huge_pages = CreateHugePageRegion(size);
+            }
+#endif
             shm = boost::interprocess::xsi_shared_memory(
                 boost::interprocess::open_or_create, key, size);
             util::SimpleLogger().Write(logDEBUG) << "opening/creating " << shm.get_shmid()
@@ -84,6 +96,11 @@ class SharedMemory
             }
 #endif
             region = boost::interprocess::mapped_region(shm, access);
+            if (huge_pages && !explicit_huge_pages &&
+                !util::adviseHugePages(region.get_address(), region.get_size()))
+            {
+                util::SimpleLogger().Write(logWARNING) << "huge pages are not supported";
+            }
         }
     }
 
@@ -111,6 +128,28 @@ class SharedMemory
     }
 
   private:
+#ifdef __linux__
+    // Creates the region backed by huge pages of the default size, which the kernel has to have
+    // reserved. Opening the region afterwards finds it by its key.
+    bool CreateHugePageRegion(const uint64_t size)
+    {
+        const auto page_size = util::getHugePageSize();
+        if (page_size == 0)
+        {
+            return false;
+        }
+        const auto huge_page_size = (size + page_size - 1) / page_size * page_size;
+        if (-1 == shmget(key.get_key(), huge_page_size, IPC_CREAT | SHM_HUGETLB | 0644))
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "could not allocate " << huge_page_size << " bytes of huge pages ("
+                << std::strerror(errno) << "), advising transparent huge pages instead";
+            return false;
+        }
+        return true;
+    }
+#endif
+
     static bool RegionExists(const boost::interprocess::xsi_key &key)
     {
         bool result = true;
@@ -154,7 +193,8 @@ class SharedMemory
     SharedMemory(const boost::filesystem::path &lock_file,
                  const int id,
                  const uint64_t size = 0,
-                 bool read_write = false)
+                 bool read_write = false,
+                 bool huge_pages = false)
     {
         sprintf(key, "%s.%d", "osrm.lock", id);
         auto access = read_write ? boost::interprocess::read_write : boost::interprocess::read_only;
@@ -172,6 +212,10 @@ class SharedMemory
                 boost::interprocess::open_or_create, key, boost::interprocess::read_write);
             shm.truncate(size);
             region = boost::interprocess::mapped_region(shm, access);
+            if (huge_pages)
+            {
+                util::SimpleLogger().Write(logWARNING) << "huge pages are not supported";
+            }
 
             util::SimpleLogger().Write(logDEBUG) << "writeable memory allocated " << size
                                                  << " bytes";
@@ -233,7 +277,10 @@ class SharedMemory
 
 template <typename IdentifierT, typename LockFileT = OSRMLockFile>
 std::unique_ptr<SharedMemory>
-makeSharedMemory(const IdentifierT &id, const uint64_t size = 0, bool read_write = false)
+makeSharedMemory(const IdentifierT &id,
+                 const uint64_t size = 0,
+                 bool read_write = false,
+                 bool huge_pages = false)
 {
     try
     {
@@ -249,7 +296,7 @@ makeSharedMemory(const IdentifierT &id, const uint64_t size = 0, bool read_write
                 boost::filesystem::ofstream ofs(lock_file());
             }
         }
-        return std::make_unique<SharedMemory>(lock_file(), id, size, read_write);
+        return std::make_unique<SharedMemory>(lock_file(), id, size, read_write, huge_pages);
     }
     catch (const boost::interprocess::interprocess_exception &e)
     {
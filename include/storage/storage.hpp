@@ -32,16 +32,27 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/filesystem/path.hpp>
 
+#include <functional>
 #include <string>
 
 namespace osrm
 {
 namespace storage
 {
+struct SharedDataLayout;
+
 class Storage
 {
   public:
-    Storage(StorageConfig config);
+    // Compressed coordinates take less memory but are slower to read, see util::CoordinateList.
+    // The weight offsets of the geometries take 8 bytes per segment and spare the phantom nodes
+    // the sums over the segments of their geometry, see util::toSegmentWeightOffsets.
+    // Compressed geometry nodes take less memory but are slower to read, see
+    // util::GeometryNodeList.
+    Storage(StorageConfig config,
+            const bool compress_coordinates = false,
+            const bool weight_offsets = false,
+            const bool compress_geometries = false);
 
     enum ReturnCode
     {
@@ -50,10 +61,56 @@ class Storage
         Retry
     };
 
-    ReturnCode Run(int max_wait);
+    enum DataSource
+    {
+        Files,
+        Container,
+        Package
+    };
+
+    // Loads the dataset into shared memory, either from the individual files, the container
+    // written by WriteContainer or the package written by WritePackage. A metric update only
+    // loads the blocks that depend on the edge weights and shares all other blocks with the
+    // current dataset. The data and metric blocks can be backed by huge pages to reduce TLB
+    // misses of the queries.
+    // Every block is checksummed: blocks read from a container or a package are verified against
+    // the checksums stored in it, and a full update whose data blocks match the current dataset
+    // shares them instead of keeping a second copy.
+    ReturnCode Run(int max_wait,
+                   const DataSource source = Files,
+                   const bool only_metric = false,
+                   const bool huge_pages = false);
+    // Writes the dataset to a container that can be memory mapped without parsing it
+    void WriteContainer();
+    // Writes the dataset to a package whose blocks are compressed with the zstd level, 0 stores
+    // them uncompressed. With a base package, a delta against its dataset is written, which only
+    // holds the changed parts of the blocks and is loaded onto the dataset in shared memory.
+    void WritePackage(const int level, const boost::filesystem::path &base_package = {});
 
   private:
+    // Returns the memory for the data or the metric block described by the layout. Returning
+    // nullptr for the data block keeps the data blocks of the current dataset.
+    using AllocateData = std::function<char *(const SharedDataLayout &)>;
+
+    // Sets the layout from the individual files and reads them into the data and metric block
+    void Populate(SharedDataLayout *shared_layout_ptr,
+                  const AllocateData &allocate_data,
+                  const AllocateData &allocate_metric);
+    void LoadContainer(SharedDataLayout *shared_layout_ptr,
+                       const AllocateData &allocate_data,
+                       const AllocateData &allocate_metric);
+    // a delta package is applied to the current dataset, if there is one
+    void LoadPackage(SharedDataLayout *shared_layout_ptr,
+                     const AllocateData &allocate_data,
+                     const AllocateData &allocate_metric,
+                     const SharedDataLayout *current_layout,
+                     const char *current_data,
+                     const char *current_metric);
+
     StorageConfig config;
+    bool compress_coordinates;
+    bool weight_offsets;
+    bool compress_geometries;
 };
 }
 }
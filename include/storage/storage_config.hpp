@@ -30,6 +30,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/filesystem/path.hpp>
 
+#include <string>
+#include <vector>
+
 namespace osrm
 {
 namespace storage
@@ -52,21 +55,43 @@ struct StorageConfig final
     StorageConfig(const boost::filesystem::path &base);
     bool IsValid() const;
 
+    /**
+     * Returns the configuration of an additional metric written by osrm-contract --metric. Only
+     * the files that depend on the edge weights differ, they are named <base>.<metric>.*.
+     */
+    StorageConfig GetMetricConfig(const std::string &metric) const;
+
     boost::filesystem::path ram_index_path;
     boost::filesystem::path file_index_path;
     boost::filesystem::path hsgr_data_path;
     boost::filesystem::path nodes_data_path;
     boost::filesystem::path edges_data_path;
+    boost::filesystem::path edge_based_nodes_data_path;
     boost::filesystem::path core_data_path;
+    // optional, the hierarchy is in the order of the edge-based nodes without it
+    boost::filesystem::path node_renumbering_path;
+    // optional, the core is searched without a goal direction without it
+    boost::filesystem::path core_landmarks_path;
     boost::filesystem::path geometries_path;
+    // optional, lengths are computed from the coordinates without it
+    boost::filesystem::path segment_lengths_path;
     boost::filesystem::path timestamp_path;
     boost::filesystem::path datasource_names_path;
     boost::filesystem::path datasource_indexes_path;
+    // optional, routes with a departure time use the static weights without it
+    boost::filesystem::path speed_profiles_path;
     boost::filesystem::path names_data_path;
     boost::filesystem::path properties_path;
     boost::filesystem::path intersection_class_path;
     boost::filesystem::path turn_lane_data_path;
     boost::filesystem::path turn_lane_description_path;
+    boost::filesystem::path container_path;
+    boost::filesystem::path package_path;
+    // optional, the overlay graph of osrm-contract --mld for the route queries of the MLD algorithm
+    boost::filesystem::path mld_graph_path;
+
+    // additional metrics loaded with the default one
+    std::vector<std::string> metrics;
 };
 }
 }
@@ -0,0 +1,244 @@
+#ifndef OSRM_UTIL_ALLOCATION_STATISTICS_HPP
+#define OSRM_UTIL_ALLOCATION_STATISTICS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+
+namespace osrm
+{
+namespace util
+{
+
+// Phases of the handling of a request that heap allocations are attributed to
+enum class AllocationPhase : std::uint8_t
+{
+    Other,
+    Parsing,
+    PhantomLookup,
+    Search,
+    Guidance,
+    JSON,
+    Compression
+};
+
+const constexpr std::size_t NUMBER_OF_ALLOCATION_PHASES = 7;
+
+inline const char *toString(const AllocationPhase phase)
+{
+    static const char *names[NUMBER_OF_ALLOCATION_PHASES] = {
+        "other", "parsing", "phantom lookup", "search", "guidance", "json", "compression"};
+    return names[static_cast<std::size_t>(phase)];
+}
+
+struct AllocationCounts
+{
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+};
+
+// Number and size of the heap allocations of every phase. They are only counted in builds with
+// ENABLE_ALLOCATION_TRACKING, which replaces the global operator new and counts the allocations
+// of zlib. Every thread counts into counters of its own, without the option they stay zero.
+struct AllocationStatistics
+{
+    std::array<AllocationCounts, NUMBER_OF_ALLOCATION_PHASES> phases;
+
+    AllocationCounts &operator[](const AllocationPhase phase)
+    {
+        return phases[static_cast<std::size_t>(phase)];
+    }
+
+    const AllocationCounts &operator[](const AllocationPhase phase) const
+    {
+        return phases[static_cast<std::size_t>(phase)];
+    }
+
+    AllocationCounts Total() const
+    {
+        AllocationCounts total;
+        for (const auto &counts : phases)
+        {
+            total.allocations += counts.allocations;
+            total.bytes += counts.bytes;
+        }
+        return total;
+    }
+
+    void Reset() { *this = AllocationStatistics(); }
+
+    AllocationStatistics &operator+=(const AllocationStatistics &other)
+    {
+        for (std::size_t phase = 0; phase < NUMBER_OF_ALLOCATION_PHASES; ++phase)
+        {
+            phases[phase].allocations += other.phases[phase].allocations;
+            phases[phase].bytes += other.phases[phase].bytes;
+        }
+        return *this;
+    }
+
+    AllocationStatistics &operator-=(const AllocationStatistics &other)
+    {
+        for (std::size_t phase = 0; phase < NUMBER_OF_ALLOCATION_PHASES; ++phase)
+        {
+            phases[phase].allocations -= other.phases[phase].allocations;
+            phases[phase].bytes -= other.phases[phase].bytes;
+        }
+        return *this;
+    }
+};
+
+// Writes the allocations and bytes of the phases that allocated, divided by a number of requests
+inline void writeAllocationStatistics(std::ostream &stream,
+                                      const AllocationStatistics &statistics,
+                                      const double requests = 1)
+{
+    bool first = true;
+    for (std::size_t phase = 0; phase < NUMBER_OF_ALLOCATION_PHASES; ++phase)
+    {
+        const auto &counts = statistics.phases[phase];
+        if (counts.allocations == 0)
+        {
+            continue;
+        }
+        stream << (first ? "" : ", ") << toString(static_cast<AllocationPhase>(phase)) << " "
+               << counts.allocations / requests << " (" << counts.bytes / requests << " B)";
+        first = false;
+    }
+    if (first)
+    {
+        stream << "none";
+    }
+}
+
+#ifdef OSRM_ALLOCATION_TRACKING
+const constexpr bool ALLOCATION_TRACKING_ENABLED = true;
+#else
+const constexpr bool ALLOCATION_TRACKING_ENABLED = false;
+#endif
+
+namespace detail
+{
+// Constant initialized, so that operator new can count into it on any thread at any time
+struct ThreadAllocationState
+{
+    AllocationStatistics statistics;
+    AllocationPhase phase = AllocationPhase::Other;
+};
+
+inline ThreadAllocationState &getThreadAllocationState()
+{
+    static thread_local ThreadAllocationState state;
+    return state;
+}
+}
+
+// The allocations of the calling thread so far
+inline AllocationStatistics &GetAllocationStatistics()
+{
+    return detail::getThreadAllocationState().statistics;
+}
+
+// Counts an allocation of the calling thread into its current phase
+inline void countAllocation(const std::size_t bytes)
+{
+    auto &state = detail::getThreadAllocationState();
+    auto &counts = state.statistics[state.phase];
+    counts.allocations += 1;
+    counts.bytes += bytes;
+}
+
+// The allocations of the calling thread count into a phase while this is in scope
+class AllocationPhaseScope
+{
+  public:
+    explicit AllocationPhaseScope(const AllocationPhase phase)
+        : previous(detail::getThreadAllocationState().phase)
+    {
+        if (ALLOCATION_TRACKING_ENABLED)
+        {
+            detail::getThreadAllocationState().phase = phase;
+        }
+    }
+    AllocationPhaseScope(const AllocationPhaseScope &) = delete;
+    AllocationPhaseScope &operator=(const AllocationPhaseScope &) = delete;
+
+    ~AllocationPhaseScope() { detail::getThreadAllocationState().phase = previous; }
+
+  private:
+    const AllocationPhase previous;
+};
+
+// Adds the allocations of the calling thread while this is in scope to the statistics of a
+// request, which can be handled by several threads one after another.
+class AllocationRecorder
+{
+  public:
+    explicit AllocationRecorder(AllocationStatistics &target)
+        : target(target), start(GetAllocationStatistics())
+    {
+    }
+    AllocationRecorder(const AllocationRecorder &) = delete;
+    AllocationRecorder &operator=(const AllocationRecorder &) = delete;
+
+    ~AllocationRecorder()
+    {
+        if (ALLOCATION_TRACKING_ENABLED)
+        {
+            auto allocations = GetAllocationStatistics();
+            allocations -= start;
+            target += allocations;
+        }
+    }
+
+  private:
+    AllocationStatistics &target;
+    const AllocationStatistics start;
+};
+
+// Tasks of a parallel loop allocate on the threads that run them. Their allocations count into
+// the phase of the thread that started the loop and are added to its counters once the loop
+// finished, which is when this goes out of scope.
+class ParallelAllocationStatistics
+{
+  public:
+    ParallelAllocationStatistics() : phase(detail::getThreadAllocationState().phase) {}
+    ParallelAllocationStatistics(const ParallelAllocationStatistics &) = delete;
+    ParallelAllocationStatistics &operator=(const ParallelAllocationStatistics &) = delete;
+
+    ~ParallelAllocationStatistics() { GetAllocationStatistics() += collected; }
+
+    template <typename TaskT> void Run(TaskT &&task)
+    {
+        if (!ALLOCATION_TRACKING_ENABLED)
+        {
+            task();
+            return;
+        }
+
+        auto &statistics = GetAllocationStatistics();
+        const auto before = statistics;
+        {
+            AllocationPhaseScope scope(phase);
+            task();
+        }
+        auto allocations = statistics;
+        allocations -= before;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            collected += allocations;
+        }
+        statistics = before;
+    }
+
+  private:
+    const AllocationPhase phase;
+    std::mutex mutex;
+    AllocationStatistics collected;
+};
+}
+}
+
+#endif // OSRM_UTIL_ALLOCATION_STATISTICS_HPP
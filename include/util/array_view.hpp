@@ -0,0 +1,100 @@
+#ifndef OSRM_UTIL_ARRAY_VIEW_HPP
+#define OSRM_UTIL_ARRAY_VIEW_HPP
+
+#include <boost/assert.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <cstddef>
+
+namespace osrm
+{
+namespace util
+{
+
+// Read only view of a contiguous slice of an array that traverses it either forwards or
+// backwards, without copying it. A view without an array reads default constructed values,
+// which covers data that is optional in a dataset.
+template <typename T> class ArrayView
+{
+  public:
+    class Iterator final : public boost::iterator_facade<Iterator,
+                                                         const T,
+                                                         boost::random_access_traversal_tag>
+    {
+      public:
+        Iterator() : base(nullptr), step(0), index(0) {}
+        Iterator(const T *base, const std::ptrdiff_t step, const std::ptrdiff_t index)
+            : base(base), step(step), index(index)
+        {
+        }
+
+      private:
+        friend class boost::iterator_core_access;
+
+        const T &dereference() const { return base[index * step]; }
+        bool equal(const Iterator &other) const { return index == other.index; }
+        void increment() { ++index; }
+        void decrement() { --index; }
+        void advance(const std::ptrdiff_t offset) { index += offset; }
+        std::ptrdiff_t distance_to(const Iterator &other) const { return other.index - index; }
+
+        const T *base;
+        std::ptrdiff_t step;
+        std::ptrdiff_t index;
+    };
+
+    ArrayView() : ArrayView(0) {}
+
+    // views [first, last), from last - 1 down to first if reversed
+    ArrayView(const T *first, const T *last, const bool reversed = false)
+        : base(reversed && first != last ? last - 1 : first), step(reversed ? -1 : 1),
+          length(static_cast<std::size_t>(last - first))
+    {
+        BOOST_ASSERT(first <= last);
+    }
+
+    // views length default constructed values
+    explicit ArrayView(const std::size_t length) : base(&DefaultValue()), step(0), length(length)
+    {
+    }
+
+    std::size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+
+    const T &operator[](const std::size_t index) const
+    {
+        BOOST_ASSERT(index < length);
+        return base[static_cast<std::ptrdiff_t>(index) * step];
+    }
+    const T &front() const { return (*this)[0]; }
+    const T &back() const { return (*this)[length - 1]; }
+
+    Iterator begin() const { return Iterator(base, step, 0); }
+    Iterator end() const { return Iterator(base, step, static_cast<std::ptrdiff_t>(length)); }
+
+    // views the same values in the opposite order
+    ArrayView Reversed() const
+    {
+        return ArrayView(length == 0 ? base : &back(), -step, length);
+    }
+
+  private:
+    ArrayView(const T *base, const std::ptrdiff_t step, const std::size_t length)
+        : base(base), step(step), length(length)
+    {
+    }
+
+    static const T &DefaultValue()
+    {
+        static const T value{};
+        return value;
+    }
+
+    const T *base;
+    std::ptrdiff_t step;
+    std::size_t length;
+};
+}
+}
+
+#endif // OSRM_UTIL_ARRAY_VIEW_HPP
@@ -32,6 +32,49 @@ template <typename NodeID, typename Key> class ArrayStorage
     std::vector<Key> positions;
 };
 
+// Flat index array like ArrayStorage, but every slot is tagged with the timestamp of the
+// search that wrote it. Clear() only bumps the timestamp, stale slots read as not inserted.
+template <typename NodeID, typename Key> class TimestampedArrayStorage
+{
+  public:
+    explicit TimestampedArrayStorage(size_t size)
+        : positions(size, 0), timestamps(size, 0), current_timestamp{1u}
+    {
+    }
+
+    Key &operator[](NodeID node)
+    {
+        BOOST_ASSERT(node < positions.size());
+        timestamps[node] = current_timestamp;
+        return positions[node];
+    }
+
+    Key peek_index(const NodeID node) const
+    {
+        BOOST_ASSERT(node < positions.size());
+        if (timestamps[node] == current_timestamp)
+        {
+            return positions[node];
+        }
+        return std::numeric_limits<Key>::max();
+    }
+
+    void Clear()
+    {
+        ++current_timestamp;
+        if (0 == current_timestamp)
+        {
+            std::fill(timestamps.begin(), timestamps.end(), 0);
+            current_timestamp = 1;
+        }
+    }
+
+  private:
+    std::vector<Key> positions;
+    std::vector<unsigned> timestamps;
+    unsigned current_timestamp;
+};
+
 template <typename NodeID, typename Key> class MapStorage
 {
   public:
@@ -111,6 +154,9 @@ class BinaryHeap
 
     std::size_t Size() const { return (heap.size() - 1); }
 
+    // number of nodes inserted since the last Clear(), i.e. the search space of a query
+    std::size_t NumberOfInsertedNodes() const { return inserted_nodes.size(); }
+
     bool Empty() const { return 0 == Size(); }
 
     void Insert(NodeID node, Weight weight, const Data &data)
@@ -1,10 +1,13 @@
 #ifndef CAST_HPP
 #define CAST_HPP
 
+#include <cmath>
+#include <cstdint>
 #include <iomanip>
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/trim.hpp>
@@ -42,6 +45,145 @@ template <typename T, int Precision = 6> inline std::string to_string_with_preci
 
     return rv;
 }
+
+namespace detail
+{
+// 64 x 64 -> 128 bit multiplication, as (high, low) words
+inline void multiply(const std::uint64_t lhs,
+                     const std::uint64_t rhs,
+                     std::uint64_t &high,
+                     std::uint64_t &low)
+{
+    const std::uint64_t lhs_low = lhs & 0xFFFFFFFF, lhs_high = lhs >> 32;
+    const std::uint64_t rhs_low = rhs & 0xFFFFFFFF, rhs_high = rhs >> 32;
+    const std::uint64_t low_low = lhs_low * rhs_low;
+    const std::uint64_t high_low = lhs_high * rhs_low;
+    const std::uint64_t low_high = lhs_low * rhs_high;
+    const std::uint64_t high_high = lhs_high * rhs_high;
+    const std::uint64_t middle = (low_low >> 32) + (high_low & 0xFFFFFFFF) + low_high;
+    high = high_high + (high_low >> 32) + (middle >> 32);
+    low = (middle << 32) | (low_low & 0xFFFFFFFF);
+}
+
+// Rounds fraction * 10^Precision to the nearest integer, ties to even, the same way printf does.
+// fraction has to be in [0, 1). Computed exactly on the binary representation.
+template <int Precision> inline std::uint64_t scale_fraction(const double fraction)
+{
+    std::uint64_t scale = 1;
+    for (int i = 0; i < Precision; ++i)
+        scale *= 10;
+
+    if (fraction == 0.)
+        return 0;
+
+    // fraction = mantissa * 2^-shift with an integral 53 bit mantissa
+    int exponent;
+    const double normalized = std::frexp(fraction, &exponent);
+    const auto mantissa = static_cast<std::uint64_t>(std::ldexp(normalized, 53));
+    const int shift = 53 - exponent;
+
+    // fraction * scale = (high, low) * 2^-shift, which is below 2^83
+    std::uint64_t high, low;
+    multiply(mantissa, scale, high, low);
+    if (shift >= 84)
+        return 0;
+
+    std::uint64_t quotient;
+    bool above_half, is_half;
+    if (shift == 64)
+    {
+        quotient = high;
+        above_half = low > (std::uint64_t{1} << 63);
+        is_half = low == (std::uint64_t{1} << 63);
+    }
+    else if (shift > 64)
+    {
+        const int high_shift = shift - 64;
+        quotient = high >> high_shift;
+        const std::uint64_t half_bit = std::uint64_t{1} << (high_shift - 1);
+        const std::uint64_t remainder = high & ((std::uint64_t{1} << high_shift) - 1);
+        above_half = remainder > half_bit || (remainder == half_bit && low != 0);
+        is_half = remainder == half_bit && low == 0;
+    }
+    else
+    {
+        // shift >= 53 since fraction < 1
+        quotient = (high << (64 - shift)) | (low >> shift);
+        const std::uint64_t half_bit = std::uint64_t{1} << (shift - 1);
+        const std::uint64_t remainder = low & ((std::uint64_t{1} << shift) - 1);
+        above_half = remainder > half_bit;
+        is_half = remainder == half_bit;
+    }
+
+    if (above_half || (is_half && (quotient & 1) != 0))
+        ++quotient;
+    return quotient;
+}
+}
+
+// Appends the same text as to_string_with_precision, without streams or allocations for all
+// values up to 2^53 in magnitude. Larger and non-finite values fall back to the stream.
+template <int Precision = 6>
+inline void append_with_precision(std::vector<char> &output, const double value)
+{
+    static_assert(0 < Precision && Precision <= 9, "precision needs to be within [1, 9]");
+
+    const double magnitude = std::abs(value);
+    if (!std::isfinite(value) || magnitude >= 9007199254740992.)
+    {
+        const auto fallback = to_string_with_precision<double, Precision>(value);
+        output.insert(output.end(), fallback.begin(), fallback.end());
+        return;
+    }
+
+    std::uint64_t scale = 1;
+    for (int i = 0; i < Precision; ++i)
+        scale *= 10;
+
+    const double integral_part = std::floor(magnitude);
+    auto integral = static_cast<std::uint64_t>(integral_part);
+    auto fractional = detail::scale_fraction<Precision>(magnitude - integral_part);
+    if (fractional == scale)
+    {
+        integral += 1;
+        fractional = 0;
+    }
+
+    // at most 16 integral digits, a sign, the separator and the fractional digits
+    char buffer[32];
+    char *end = buffer + sizeof(buffer);
+    char *begin = end;
+
+    // trailing zeros of the fraction are dropped, and the separator if nothing is left
+    int fractional_digits = Precision;
+    while (fractional_digits > 0 && fractional % 10 == 0)
+    {
+        fractional /= 10;
+        --fractional_digits;
+    }
+    if (fractional_digits > 0)
+    {
+        for (int i = 0; i < fractional_digits; ++i)
+        {
+            *--begin = static_cast<char>('0' + fractional % 10);
+            fractional /= 10;
+        }
+        *--begin = '.';
+    }
+
+    do
+    {
+        *--begin = static_cast<char>('0' + integral % 10);
+        integral /= 10;
+    } while (integral > 0);
+
+    if (std::signbit(value))
+    {
+        *--begin = '-';
+    }
+
+    output.insert(output.end(), begin, end);
+}
 }
 }
 }
@@ -0,0 +1,236 @@
+#ifndef COMPACT_DYNAMIC_GRAPH_HPP
+#define COMPACT_DYNAMIC_GRAPH_HPP
+
+#include "util/deallocating_vector.hpp"
+#include "util/dynamic_graph.hpp"
+#include "util/integer_range.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Mutable adjacency array for graphs that change in rounds, like the independent node sets of
+// the contractor. Every node owns a block of edges with an explicit capacity, deleting an edge
+// swaps it with the last one of its block. The insertions of a round reserve room for all new
+// edges of a node at once, so a block moves at most once per round. Instead of leaving moved
+// blocks behind for good like DynamicGraph, the abandoned slots are counted and the edge array
+// is compacted in place once they take up a quarter of it.
+template <typename EdgeDataT> class CompactDynamicGraph
+{
+  public:
+    using EdgeData = EdgeDataT;
+    using NodeIterator = std::uint32_t;
+    using EdgeIterator = std::uint32_t;
+    using EdgeRange = range<EdgeIterator>;
+    using InputEdge = typename DynamicGraph<EdgeDataT>::InputEdge;
+
+    /**
+     * Constructs a CompactDynamicGraph from a list of edges sorted by source node id.
+     */
+    template <class ContainerT>
+    CompactDynamicGraph(const NodeIterator nodes, const ContainerT &graph)
+        : number_of_nodes(nodes), number_of_edges(static_cast<EdgeIterator>(graph.size())),
+          number_of_unused_edges(0), node_array(nodes)
+    {
+        // we need to cast here because DeallocatingVector does not have a valid const iterator
+        BOOST_ASSERT(std::is_sorted(const_cast<ContainerT &>(graph).begin(),
+                                    const_cast<ContainerT &>(graph).end()));
+
+        edge_list.resize(number_of_edges);
+        EdgeIterator edge = 0;
+        for (const auto node : irange(0u, number_of_nodes))
+        {
+            node_array[node].first_edge = edge;
+            while (edge < number_of_edges && graph[edge].source == node)
+            {
+                edge_list[edge].target = graph[edge].target;
+                BOOST_ASSERT(edge_list[edge].target < number_of_nodes);
+                edge_list[edge].data = graph[edge].data;
+                ++edge;
+            }
+            node_array[node].edges = edge - node_array[node].first_edge;
+            node_array[node].capacity = node_array[node].edges;
+        }
+        BOOST_ASSERT(edge == number_of_edges);
+    }
+
+    unsigned GetNumberOfNodes() const { return number_of_nodes; }
+
+    unsigned GetNumberOfEdges() const { return number_of_edges; }
+
+    unsigned GetOutDegree(const NodeIterator n) const { return node_array[n].edges; }
+
+    NodeIterator GetTarget(const EdgeIterator e) const { return edge_list[e].target; }
+
+    EdgeDataT &GetEdgeData(const EdgeIterator e) { return edge_list[e].data; }
+
+    const EdgeDataT &GetEdgeData(const EdgeIterator e) const { return edge_list[e].data; }
+
+    EdgeIterator BeginEdges(const NodeIterator n) const { return node_array[n].first_edge; }
+
+    EdgeIterator EndEdges(const NodeIterator n) const
+    {
+        return node_array[n].first_edge + node_array[n].edges;
+    }
+
+    EdgeRange GetAdjacentEdgeRange(const NodeIterator node) const
+    {
+        return irange(BeginEdges(node), EndEdges(node));
+    }
+
+    // makes room for count more edges of a node. Invalidates edge iterators for the node
+    void ReserveEdges(const NodeIterator n, const unsigned count)
+    {
+        Node &node = node_array[n];
+        const unsigned required_capacity = node.edges + count;
+        if (required_capacity <= node.capacity)
+        {
+            return;
+        }
+
+        // leave some room for the next rounds, the node is likely to grow again
+        const unsigned new_capacity = required_capacity + required_capacity / 4 + 1;
+        const EdgeIterator new_first_edge = static_cast<EdgeIterator>(edge_list.size());
+        BOOST_ASSERT(edge_list.size() + new_capacity < std::numeric_limits<EdgeIterator>::max());
+        edge_list.resize(edge_list.size() + new_capacity);
+        for (const auto i : irange(0u, node.edges))
+        {
+            edge_list[new_first_edge + i] = edge_list[node.first_edge + i];
+        }
+        number_of_unused_edges += node.capacity;
+        node.first_edge = new_first_edge;
+        node.capacity = new_capacity;
+    }
+
+    // adds an edge. Invalidates edge iterators for the source node
+    EdgeIterator InsertEdge(const NodeIterator from, const NodeIterator to, const EdgeDataT &data)
+    {
+        ReserveEdges(from, 1);
+        Node &node = node_array[from];
+        Edge &edge = edge_list[node.first_edge + node.edges];
+        edge.target = to;
+        edge.data = data;
+        ++number_of_edges;
+        ++node.edges;
+        return EdgeIterator(node.first_edge + node.edges);
+    }
+
+    // removes all edges (source,target). Nodes can be handled in parallel.
+    int32_t DeleteEdgesTo(const NodeIterator source, const NodeIterator target)
+    {
+        int32_t deleted = 0;
+        for (EdgeIterator i = BeginEdges(source), iend = EndEdges(source); i < iend - deleted; ++i)
+        {
+            if (edge_list[i].target == target)
+            {
+                do
+                {
+                    deleted++;
+                    edge_list[i] = edge_list[iend - deleted];
+                } while (i < iend - deleted && edge_list[i].target == target);
+            }
+        }
+
+        number_of_edges -= deleted;
+        node_array[source].edges -= deleted;
+
+        return deleted;
+    }
+
+    // searches for a specific edge
+    EdgeIterator FindEdge(const NodeIterator from, const NodeIterator to) const
+    {
+        for (const auto i : irange(BeginEdges(from), EndEdges(from)))
+        {
+            if (to == edge_list[i].target)
+            {
+                return i;
+            }
+        }
+        return SPECIAL_EDGEID;
+    }
+
+    // moves all blocks together if abandoned blocks take up more than a quarter of the edge
+    // array. Invalidates all edge iterators
+    void CompactIfFragmented()
+    {
+        if (number_of_unused_edges * 4 <= edge_list.size())
+        {
+            return;
+        }
+
+        std::vector<NodeIterator> nodes_by_position(number_of_nodes);
+        std::iota(nodes_by_position.begin(), nodes_by_position.end(), 0);
+        std::sort(nodes_by_position.begin(),
+                  nodes_by_position.end(),
+                  [this](const NodeIterator lhs, const NodeIterator rhs) {
+                      // empty blocks can start where the next block starts
+                      return std::tie(node_array[lhs].first_edge, node_array[lhs].edges) <
+                             std::tie(node_array[rhs].first_edge, node_array[rhs].edges);
+                  });
+
+        // blocks only move towards the front, so they can be moved in place in the order of
+        // their position. The slack of the blocks is dropped as well.
+        EdgeIterator position = 0;
+        for (const auto n : nodes_by_position)
+        {
+            Node &node = node_array[n];
+            BOOST_ASSERT(position <= node.first_edge);
+            if (position != node.first_edge)
+            {
+                for (const auto i : irange(0u, node.edges))
+                {
+                    edge_list[position + i] = edge_list[node.first_edge + i];
+                }
+            }
+            node.first_edge = position;
+            node.capacity = node.edges;
+            position += node.edges;
+        }
+        BOOST_ASSERT(position == number_of_edges);
+        edge_list.resize(position);
+        number_of_unused_edges = 0;
+    }
+
+  private:
+    struct Node
+    {
+        // index of the first edge
+        EdgeIterator first_edge;
+        // amount of edges
+        unsigned edges;
+        // amount of edges that fit into the block of the node
+        unsigned capacity;
+    };
+
+    struct Edge
+    {
+        NodeIterator target;
+        EdgeDataT data;
+    };
+
+    NodeIterator number_of_nodes;
+    std::atomic_uint number_of_edges;
+    // slots of blocks that were moved to the end of the edge array
+    std::size_t number_of_unused_edges;
+
+    std::vector<Node> node_array;
+    DeallocatingVector<Edge> edge_list;
+};
+}
+}
+
+#endif // COMPACT_DYNAMIC_GRAPH_HPP
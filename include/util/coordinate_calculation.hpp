@@ -1,6 +1,7 @@
 #ifndef COORDINATE_CALCULATION
 #define COORDINATE_CALCULATION
 
+#include "util/array_view.hpp"
 #include "util/coordinate.hpp"
 
 #include <boost/optional.hpp>
@@ -50,6 +51,29 @@ double getLength(const std::vector<Coordinate> &coordinates, BinaryOperation op)
     return result;
 }
 
+// Batched variants from one coordinate to many, e.g. to the candidates of a trace or the
+// coordinates of a geometry. The sines and cosines are evaluated with polynomials in branch free
+// loops over the whole batch that compilers vectorize, instead of calls into libm per pair. Only
+// the final atan2 stays a scalar call. Element i of the result belongs to targets[i]. The bounds
+// of the errors against the scalar functions are checked in the unit tests.
+
+// Same as haversineDistance, within a relative error of 1e-10
+void haversineDistances(const Coordinate source,
+                        const ArrayView<Coordinate> targets,
+                        std::vector<double> &distances);
+
+// Same as greatCircleDistance, within a relative error of 1e-10
+void greatCircleDistances(const Coordinate source,
+                          const ArrayView<Coordinate> targets,
+                          std::vector<double> &distances);
+
+// Same as bearing, within 1e-4 degrees. The approximation reads the angles from the atan table of
+// computeAngle instead, which is within 0.03 degrees.
+void bearings(const Coordinate source,
+              const ArrayView<Coordinate> targets,
+              std::vector<double> &bearings,
+              const bool approximate = false);
+
 // Find the closest distance and location between coordinate and the line connecting source and
 // target:
 //             coordinate
@@ -0,0 +1,203 @@
+#ifndef OSRM_UTIL_COORDINATE_LIST_HPP
+#define OSRM_UTIL_COORDINATE_LIST_HPP
+
+#include "util/coordinate.hpp"
+#include "util/shared_memory_vector_wrapper.hpp"
+#include "util/varint.hpp"
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace osrm
+{
+namespace util
+{
+
+// Coordinates can be stored compressed in blocks of COORDINATE_BLOCK_SIZE nodes. The first
+// coordinate of a block is stored in full in the block index, every other coordinate as the
+// difference to the one before it, zigzag encoded and written as a varint of 7 bits per byte.
+// Nodes with consecutive ids are close to each other for the most part, so the differences of
+// both components usually take one or two bytes each instead of four.
+const constexpr std::size_t COORDINATE_BLOCK_SIZE = 16;
+
+struct CoordinateBlock
+{
+    Coordinate first;
+    // offset of the differences of the block in the delta bytes
+    std::uint64_t offset;
+};
+
+namespace detail
+{
+// Adds the next difference to the coordinate
+inline void readCoordinateDelta(const std::uint8_t *&bytes, Coordinate &coordinate)
+{
+    // the sums are computed unsigned, the differences wrap around like the encoder's did
+    const auto lon = static_cast<std::uint32_t>(static_cast<std::int32_t>(coordinate.lon)) +
+                     static_cast<std::uint32_t>(zigzagDecode(readVarint(bytes)));
+    const auto lat = static_cast<std::uint32_t>(static_cast<std::int32_t>(coordinate.lat)) +
+                     static_cast<std::uint32_t>(zigzagDecode(readVarint(bytes)));
+    coordinate = Coordinate{FixedLongitude{static_cast<std::int32_t>(lon)},
+                            FixedLatitude{static_cast<std::int32_t>(lat)}};
+}
+}
+
+// Writes the block index and the delta bytes of coordinates given in the order of their ids.
+// Without buffers it only counts the blocks and bytes, so that the buffers can be sized with a
+// first pass over the coordinates.
+class CoordinateEncoder
+{
+  public:
+    CoordinateEncoder() = default;
+    CoordinateEncoder(CoordinateBlock *blocks_, std::uint8_t *bytes_)
+        : blocks(blocks_), bytes(bytes_)
+    {
+    }
+
+    void push_back(const Coordinate coordinate)
+    {
+        if (number_of_coordinates % COORDINATE_BLOCK_SIZE == 0)
+        {
+            if (blocks)
+                blocks[number_of_blocks] = CoordinateBlock{coordinate, number_of_bytes};
+            ++number_of_blocks;
+        }
+        else
+        {
+            writeDelta(static_cast<std::int32_t>(coordinate.lon),
+                       static_cast<std::int32_t>(previous.lon));
+            writeDelta(static_cast<std::int32_t>(coordinate.lat),
+                       static_cast<std::int32_t>(previous.lat));
+        }
+        previous = coordinate;
+        ++number_of_coordinates;
+    }
+
+    std::uint64_t GetNumberOfCoordinates() const { return number_of_coordinates; }
+    std::uint64_t GetNumberOfBlocks() const { return number_of_blocks; }
+    std::uint64_t GetNumberOfBytes() const { return number_of_bytes; }
+
+  private:
+    void writeDelta(const std::int32_t value, const std::int32_t previous_value)
+    {
+        auto delta = detail::zigzagEncode(static_cast<std::int32_t>(
+            static_cast<std::uint32_t>(value) - static_cast<std::uint32_t>(previous_value)));
+        do
+        {
+            std::uint8_t byte = delta & 0x7f;
+            delta >>= 7;
+            if (delta != 0)
+                byte |= 0x80;
+            if (bytes)
+                bytes[number_of_bytes] = byte;
+            ++number_of_bytes;
+        } while (delta != 0);
+    }
+
+    CoordinateBlock *blocks = nullptr;
+    std::uint8_t *bytes = nullptr;
+    Coordinate previous;
+    std::uint64_t number_of_coordinates = 0;
+    std::uint64_t number_of_blocks = 0;
+    std::uint64_t number_of_bytes = 0;
+};
+
+// Coordinates of the nodes, either as a plain array or compressed in blocks. Random access to
+// a compressed coordinate seeks to its block and decodes at most COORDINATE_BLOCK_SIZE - 1
+// differences, decode() reads consecutive coordinates without seeking for every one.
+template <bool UseSharedMemory> class CoordinateList
+{
+  public:
+    CoordinateList() = default;
+
+    explicit CoordinateList(typename ShM<Coordinate, UseSharedMemory>::vector &coordinates_)
+        : number_of_coordinates(coordinates_.size())
+    {
+        using std::swap;
+        swap(coordinates, coordinates_);
+    }
+
+    CoordinateList(typename ShM<CoordinateBlock, UseSharedMemory>::vector &blocks_,
+                   typename ShM<std::uint8_t, UseSharedMemory>::vector &bytes_,
+                   const std::size_t number_of_coordinates_)
+        : number_of_coordinates(number_of_coordinates_)
+    {
+        BOOST_ASSERT(blocks_.size() ==
+                     (number_of_coordinates + COORDINATE_BLOCK_SIZE - 1) / COORDINATE_BLOCK_SIZE);
+        using std::swap;
+        swap(blocks, blocks_);
+        swap(bytes, bytes_);
+    }
+
+    std::size_t size() const { return number_of_coordinates; }
+
+    bool empty() const { return number_of_coordinates == 0; }
+
+    bool compressed() const { return !blocks.empty(); }
+
+    Coordinate operator[](const std::size_t index) const
+    {
+        BOOST_ASSERT(index < number_of_coordinates);
+        if (!compressed())
+        {
+            return coordinates[index];
+        }
+
+        const auto &block = blocks[index / COORDINATE_BLOCK_SIZE];
+        Coordinate coordinate = block.first;
+        const std::uint8_t *position = bytes.data() + block.offset;
+        for (auto count = index % COORDINATE_BLOCK_SIZE; count > 0; --count)
+        {
+            detail::readCoordinateDelta(position, coordinate);
+        }
+        return coordinate;
+    }
+
+    // Writes the coordinates [first, last) to `out`
+    template <typename OutputIter>
+    OutputIter decode(const std::size_t first, const std::size_t last, OutputIter out) const
+    {
+        BOOST_ASSERT(first <= last && last <= number_of_coordinates);
+        if (!compressed())
+        {
+            for (auto index = first; index < last; ++index)
+            {
+                *out++ = coordinates[index];
+            }
+            return out;
+        }
+
+        auto index = first;
+        while (index < last)
+        {
+            // seek to the first coordinate in the block, the rest of the block is read in order
+            const auto &block = blocks[index / COORDINATE_BLOCK_SIZE];
+            Coordinate coordinate = block.first;
+            const std::uint8_t *position = bytes.data() + block.offset;
+            for (auto count = index % COORDINATE_BLOCK_SIZE; count > 0; --count)
+            {
+                detail::readCoordinateDelta(position, coordinate);
+            }
+            *out++ = coordinate;
+            while (++index < last && index % COORDINATE_BLOCK_SIZE != 0)
+            {
+                detail::readCoordinateDelta(position, coordinate);
+                *out++ = coordinate;
+            }
+        }
+        return out;
+    }
+
+  private:
+    std::size_t number_of_coordinates = 0;
+    typename ShM<Coordinate, UseSharedMemory>::vector coordinates;
+    typename ShM<CoordinateBlock, UseSharedMemory>::vector blocks;
+    typename ShM<std::uint8_t, UseSharedMemory>::vector bytes;
+};
+}
+}
+
+#endif // OSRM_UTIL_COORDINATE_LIST_HPP
@@ -0,0 +1,29 @@
+#ifndef OSRM_UTIL_CRC32C_HPP
+#define OSRM_UTIL_CRC32C_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Size of the chunks of a block that are checksummed on their own
+const constexpr std::size_t CHECKSUM_CHUNK_SIZE = 1024 * 1024;
+
+// CRC32C (Castagnoli) of [data, data + size), continuing from the checksum of the preceding
+// bytes. Uses the SSE4.2 crc32 instruction where the cpu supports it.
+std::uint32_t crc32c(const char *data, const std::size_t size, const std::uint32_t crc = 0);
+
+// Checksum of a dataset block: the CRC32C of the CRC32Cs of its 1 MiB chunks, which are computed
+// in parallel. Blocks up to one chunk get their plain CRC32C.
+std::uint32_t blockChecksum(const char *data, const std::size_t size);
+
+// Checksum of a block from the CRC32Cs of its chunks, the same blockChecksum computes from the data
+std::uint32_t combineChunkChecksums(const std::vector<std::uint32_t> &chunk_checksums);
+}
+}
+
+#endif // OSRM_UTIL_CRC32C_HPP
@@ -0,0 +1,248 @@
+#ifndef D_ARY_HEAP_HPP
+#define D_ARY_HEAP_HPP
+
+#include "util/binary_heap.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Drop-in replacement for BinaryHeap with a configurable number of children per heap node.
+// The heap array only stores packed (weight, index) pairs, so all children of a node are
+// adjacent in memory and a DeleteMin touches roughly log_d(n) cache lines instead of log_2(n).
+// Shallow heaps also make Upheap cheaper, which is what DecreaseKey boils down to.
+template <typename NodeID,
+          typename Key,
+          typename Weight,
+          typename Data,
+          typename IndexStorage = ArrayStorage<NodeID, NodeID>,
+          unsigned Arity = 4>
+class DAryHeap
+{
+    static_assert(Arity >= 2, "a heap needs at least two children per node");
+
+  public:
+    using WeightType = Weight;
+    using DataType = Data;
+
+    explicit DAryHeap(size_t maxID) : max_id(maxID), node_index(maxID) { Clear(); }
+
+    DAryHeap(const DAryHeap &) = delete;
+    DAryHeap &operator=(const DAryHeap &) = delete;
+
+    void Clear()
+    {
+        heap.clear();
+        inserted_nodes.clear();
+        node_index.Clear();
+    }
+
+    std::size_t Size() const { return heap.size(); }
+
+    // number of node ids the heap can hold
+    std::size_t MaxID() const { return max_id; }
+
+    // number of nodes inserted since the last Clear(), i.e. the search space of a query
+    std::size_t NumberOfInsertedNodes() const { return inserted_nodes.size(); }
+
+    bool Empty() const { return heap.empty(); }
+
+    void Insert(NodeID node, Weight weight, const Data &data)
+    {
+        const Key index = static_cast<Key>(inserted_nodes.size());
+        const Key key = static_cast<Key>(heap.size());
+        heap.push_back(HeapElement{weight, index});
+        inserted_nodes.emplace_back(node, key, weight, data);
+        node_index[node] = index;
+        Upheap(key);
+        CheckHeap();
+    }
+
+    Data &GetData(NodeID node)
+    {
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].data;
+    }
+
+    Data const &GetData(NodeID node) const
+    {
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].data;
+    }
+
+    Weight &GetKey(NodeID node)
+    {
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].weight;
+    }
+
+    bool WasRemoved(const NodeID node) const
+    {
+        BOOST_ASSERT(WasInserted(node));
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].key == REMOVED_KEY;
+    }
+
+    bool WasInserted(const NodeID node) const
+    {
+        const auto index = node_index.peek_index(node);
+        if (index >= static_cast<decltype(index)>(inserted_nodes.size()))
+        {
+            return false;
+        }
+        return inserted_nodes[index].node == node;
+    }
+
+    NodeID Min() const
+    {
+        BOOST_ASSERT(!heap.empty());
+        return inserted_nodes[heap.front().index].node;
+    }
+
+    Weight MinKey() const
+    {
+        BOOST_ASSERT(!heap.empty());
+        return heap.front().weight;
+    }
+
+    NodeID DeleteMin()
+    {
+        BOOST_ASSERT(!heap.empty());
+        const Key removed_index = heap.front().index;
+        heap.front() = heap.back();
+        heap.pop_back();
+        if (!heap.empty())
+        {
+            Downheap(0);
+        }
+        inserted_nodes[removed_index].key = REMOVED_KEY;
+        CheckHeap();
+        return inserted_nodes[removed_index].node;
+    }
+
+    void DeleteAll()
+    {
+        for (const auto &element : heap)
+        {
+            inserted_nodes[element.index].key = REMOVED_KEY;
+        }
+        heap.clear();
+    }
+
+    void DecreaseKey(NodeID node, Weight weight)
+    {
+        BOOST_ASSERT(std::numeric_limits<NodeID>::max() != node);
+        const Key index = node_index.peek_index(node);
+        const Key key = inserted_nodes[index].key;
+        BOOST_ASSERT(key != REMOVED_KEY);
+        BOOST_ASSERT(weight <= heap[key].weight);
+
+        inserted_nodes[index].weight = weight;
+        heap[key].weight = weight;
+        Upheap(key);
+        CheckHeap();
+    }
+
+  private:
+    static constexpr Key REMOVED_KEY = std::numeric_limits<Key>::max();
+
+    class HeapNode
+    {
+      public:
+        HeapNode(NodeID n, Key k, Weight w, Data d) : node(n), key(k), weight(w), data(std::move(d))
+        {
+        }
+
+        NodeID node;
+        Key key;
+        Weight weight;
+        Data data;
+    };
+    struct HeapElement
+    {
+        Weight weight;
+        Key index;
+    };
+
+    std::size_t max_id;
+    std::vector<HeapNode> inserted_nodes;
+    std::vector<HeapElement> heap;
+    IndexStorage node_index;
+
+    void Downheap(std::size_t key)
+    {
+        const HeapElement dropping = heap[key];
+        const std::size_t heap_size = heap.size();
+        std::size_t first_child = key * Arity + 1;
+        while (first_child < heap_size)
+        {
+            const std::size_t last_child = std::min(first_child + Arity, heap_size);
+            std::size_t min_child = first_child;
+            for (std::size_t child = first_child + 1; child < last_child; ++child)
+            {
+                if (heap[child].weight < heap[min_child].weight)
+                {
+                    min_child = child;
+                }
+            }
+            if (dropping.weight <= heap[min_child].weight)
+            {
+                break;
+            }
+            heap[key] = heap[min_child];
+            inserted_nodes[heap[key].index].key = static_cast<Key>(key);
+            key = min_child;
+            first_child = key * Arity + 1;
+        }
+        heap[key] = dropping;
+        inserted_nodes[dropping.index].key = static_cast<Key>(key);
+    }
+
+    void Upheap(std::size_t key)
+    {
+        const HeapElement rising = heap[key];
+        while (key > 0)
+        {
+            const std::size_t parent = (key - 1) / Arity;
+            if (heap[parent].weight <= rising.weight)
+            {
+                break;
+            }
+            heap[key] = heap[parent];
+            inserted_nodes[heap[key].index].key = static_cast<Key>(key);
+            key = parent;
+        }
+        heap[key] = rising;
+        inserted_nodes[rising.index].key = static_cast<Key>(key);
+    }
+
+    void CheckHeap()
+    {
+#ifndef NDEBUG
+        for (std::size_t i = 1; i < heap.size(); ++i)
+        {
+            BOOST_ASSERT(heap[i].weight >= heap[(i - 1) / Arity].weight);
+        }
+#endif
+    }
+};
+
+template <typename NodeID,
+          typename Key,
+          typename Weight,
+          typename Data,
+          typename IndexStorage,
+          unsigned Arity>
+constexpr Key DAryHeap<NodeID, Key, Weight, Data, IndexStorage, Arity>::REMOVED_KEY;
+}
+}
+
+#endif // D_ARY_HEAP_HPP
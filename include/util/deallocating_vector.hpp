@@ -239,6 +239,18 @@ class DeallocatingVector
         bucket_list.emplace_back(new ElementT[ELEMENTS_PER_BLOCK]);
     }
 
+    // the buckets are owned by a single vector, they are moved but never shared
+    DeallocatingVector(const DeallocatingVector &) = delete;
+    DeallocatingVector &operator=(const DeallocatingVector &) = delete;
+
+    DeallocatingVector(DeallocatingVector &&other) : current_size(0) { swap(other); }
+    DeallocatingVector &operator=(DeallocatingVector &&other)
+    {
+        clear();
+        swap(other);
+        return *this;
+    }
+
     ~DeallocatingVector() { clear(); }
 
     friend void swap<>(DeallocatingVector<ElementT, ELEMENTS_PER_BLOCK> &lhs,
@@ -361,13 +373,51 @@ class DeallocatingVector
         return (bucket_list[_bucket][_index]);
     }
 
+    // Copies [first, last) to the end, filling a bucket at a time instead of checking the
+    // capacity for every element
     template <class InputIterator> void append(InputIterator first, const InputIterator last)
     {
-        InputIterator position = first;
-        while (position != last)
+        while (first != last)
+        {
+            if (current_size == capacity())
+            {
+                bucket_list.push_back(new ElementT[ELEMENTS_PER_BLOCK]);
+            }
+
+            ElementT *bucket = bucket_list[current_size / ELEMENTS_PER_BLOCK];
+            const std::size_t begin_index = current_size % ELEMENTS_PER_BLOCK;
+            std::size_t index = begin_index;
+            for (; index < ELEMENTS_PER_BLOCK && first != last; ++index, ++first)
+            {
+                bucket[index] = *first;
+            }
+            current_size += index - begin_index;
+        }
+    }
+
+    // Moves all elements of other to the end and leaves other empty. This makes it possible to
+    // fill vectors of their own in parallel and to concatenate them afterwards: if this vector
+    // ends on a bucket boundary, the buckets of other are taken over without copying.
+    void append(DeallocatingVector &&other)
+    {
+        if (current_size % ELEMENTS_PER_BLOCK == 0)
+        {
+            // free the empty buckets after the last element before taking over the ones of other
+            while (bucket_list.size() > current_size / ELEMENTS_PER_BLOCK)
+            {
+                delete[] bucket_list.back();
+                bucket_list.pop_back();
+            }
+            bucket_list.insert(
+                bucket_list.end(), other.bucket_list.begin(), other.bucket_list.end());
+            current_size += other.current_size;
+            other.bucket_list.clear();
+            other.current_size = 0;
+        }
+        else
         {
-            push_back(*position);
-            ++position;
+            append(other.begin(), other.end());
+            other.clear();
         }
     }
 };
@@ -68,7 +68,7 @@ inline void print(const extractor::guidance::Intersection &intersection)
     std::cout << std::flush;
 }
 
-inline void print(const NodeBasedDynamicGraph &node_based_graph,
+inline void print(const NodeBasedStaticGraph &node_based_graph,
                   const extractor::guidance::Intersection &intersection)
 {
     std::cout << "  Intersection:\n";
@@ -0,0 +1,370 @@
+#ifndef OSRM_UTIL_GEOMETRY_NODE_LIST_HPP
+#define OSRM_UTIL_GEOMETRY_NODE_LIST_HPP
+
+#include "util/shared_memory_vector_wrapper.hpp"
+#include "util/typedefs.hpp"
+#include "util/varint.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace osrm
+{
+namespace util
+{
+
+// The nodes of the geometries can be stored compressed in blocks of GEOMETRY_NODE_BLOCK_SIZE
+// nodes. The first node of a block is stored in full in the block index, every node as the
+// difference to the node before it, zigzag encoded varints like the compressed coordinates.
+// Consecutive nodes of a way were numbered in the order of the OSM nodes, their differences
+// usually take one or two bytes instead of four. As every node has its difference, geometries are
+// decoded forwards and backwards at the same cost.
+const constexpr std::size_t GEOMETRY_NODE_BLOCK_SIZE = 16;
+
+struct GeometryNodeBlock
+{
+    NodeID first;
+    // offset of the difference of the first node of the block in the delta bytes
+    std::uint64_t offset;
+};
+
+// Writes the block index and the delta bytes of the nodes of all geometries in the order of the
+// geometry list. Without buffers it only counts the blocks and bytes, so that the buffers can be
+// sized with a first pass over the nodes.
+class GeometryNodeEncoder
+{
+  public:
+    GeometryNodeEncoder() = default;
+    GeometryNodeEncoder(GeometryNodeBlock *blocks_, std::uint8_t *bytes_)
+        : blocks(blocks_), bytes(bytes_)
+    {
+    }
+
+    void push_back(const NodeID node)
+    {
+        if (number_of_nodes % GEOMETRY_NODE_BLOCK_SIZE == 0)
+        {
+            if (blocks)
+                blocks[number_of_nodes / GEOMETRY_NODE_BLOCK_SIZE] =
+                    GeometryNodeBlock{node, number_of_bytes};
+        }
+
+        // the differences wrap around, the decoder's sums do as well
+        auto delta = detail::zigzagEncode(static_cast<std::int32_t>(node - previous));
+        do
+        {
+            std::uint8_t byte = delta & 0x7f;
+            delta >>= 7;
+            if (delta != 0)
+                byte |= 0x80;
+            if (bytes)
+                bytes[number_of_bytes] = byte;
+            ++number_of_bytes;
+        } while (delta != 0);
+
+        previous = node;
+        ++number_of_nodes;
+    }
+
+    std::uint64_t GetNumberOfNodes() const { return number_of_nodes; }
+    std::uint64_t GetNumberOfBlocks() const
+    {
+        return (number_of_nodes + GEOMETRY_NODE_BLOCK_SIZE - 1) / GEOMETRY_NODE_BLOCK_SIZE;
+    }
+    std::uint64_t GetNumberOfBytes() const { return number_of_bytes; }
+
+  private:
+    GeometryNodeBlock *blocks = nullptr;
+    std::uint8_t *bytes = nullptr;
+    NodeID previous = 0;
+    std::uint64_t number_of_nodes = 0;
+    std::uint64_t number_of_bytes = 0;
+};
+
+// Read only view of the nodes of a geometry that traverses them either forwards or backwards,
+// like util::ArrayView but decoding compressed nodes when they are read. Its iterators decode
+// one difference per step, random access seeks to the block of the node.
+class GeometryNodeView
+{
+    // a node of the list and, if compressed, the end of its difference in the delta bytes
+    struct Cursor
+    {
+        std::size_t index;
+        NodeID node;
+        const std::uint8_t *position;
+    };
+
+  public:
+    class Iterator final : public boost::iterator_facade<Iterator,
+                                                         NodeID,
+                                                         boost::random_access_traversal_tag,
+                                                         NodeID>
+    {
+      public:
+        Iterator() : view(nullptr), index(0) {}
+        Iterator(const GeometryNodeView *view, const std::ptrdiff_t index)
+            : view(view), index(index)
+        {
+            Seek();
+        }
+
+      private:
+        friend class boost::iterator_core_access;
+
+        NodeID dereference() const
+        {
+            BOOST_ASSERT(index >= 0 && static_cast<std::size_t>(index) < view->length);
+            return cursor.node;
+        }
+        bool equal(const Iterator &other) const { return index == other.index; }
+        void increment()
+        {
+            ++index;
+            Step(index - 1);
+        }
+        void decrement()
+        {
+            --index;
+            Step(index + 1);
+        }
+        void advance(const std::ptrdiff_t offset)
+        {
+            index += offset;
+            Seek();
+        }
+        std::ptrdiff_t distance_to(const Iterator &other) const { return other.index - index; }
+
+        bool Valid(const std::ptrdiff_t position) const
+        {
+            return position >= 0 && static_cast<std::size_t>(position) < view->length;
+        }
+
+        // the neighbours follow from the cursor, other nodes are sought
+        void Step(const std::ptrdiff_t previous_index)
+        {
+            if (!Valid(index))
+            {
+                return;
+            }
+            if (!Valid(previous_index))
+            {
+                Seek();
+                return;
+            }
+            const bool forward = (index > previous_index) == (view->step > 0);
+            if (forward)
+            {
+                view->Next(cursor);
+            }
+            else
+            {
+                view->Previous(cursor);
+            }
+        }
+
+        void Seek()
+        {
+            if (Valid(index))
+            {
+                cursor = view->Seek(view->ListIndex(static_cast<std::size_t>(index)));
+            }
+        }
+
+        const GeometryNodeView *view;
+        std::ptrdiff_t index;
+        Cursor cursor;
+    };
+
+    GeometryNodeView() = default;
+
+    // views the nodes [first, last) of a plain list, from last - 1 down to first if reversed
+    GeometryNodeView(const NodeID *nodes,
+                     const std::size_t first,
+                     const std::size_t last,
+                     const bool reversed = false)
+        : GeometryNodeView(nodes, nullptr, nullptr, first, last, reversed)
+    {
+    }
+
+    // views the nodes [first, last) of a compressed list
+    GeometryNodeView(const GeometryNodeBlock *blocks,
+                     const std::uint8_t *bytes,
+                     const std::size_t first,
+                     const std::size_t last,
+                     const bool reversed = false)
+        : GeometryNodeView(nullptr, blocks, bytes, first, last, reversed)
+    {
+    }
+
+    std::size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+
+    NodeID operator[](const std::size_t index) const
+    {
+        BOOST_ASSERT(index < length);
+        return Seek(ListIndex(index)).node;
+    }
+    NodeID front() const { return (*this)[0]; }
+    NodeID back() const { return (*this)[length - 1]; }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, static_cast<std::ptrdiff_t>(length)); }
+
+    // Writes all nodes of the view to `out`, seeking only once
+    template <typename OutputIter> OutputIter decode(OutputIter out) const
+    {
+        if (length == 0)
+        {
+            return out;
+        }
+        auto cursor = Seek(ListIndex(0));
+        *out++ = cursor.node;
+        for (std::size_t index = 1; index < length; ++index)
+        {
+            if (step > 0)
+            {
+                Next(cursor);
+            }
+            else
+            {
+                Previous(cursor);
+            }
+            *out++ = cursor.node;
+        }
+        return out;
+    }
+
+  private:
+    GeometryNodeView(const NodeID *nodes,
+                     const GeometryNodeBlock *blocks,
+                     const std::uint8_t *bytes,
+                     const std::size_t first,
+                     const std::size_t last,
+                     const bool reversed)
+        : nodes(nodes), blocks(blocks), bytes(bytes),
+          base(reversed && first != last ? static_cast<std::ptrdiff_t>(last) - 1
+                                         : static_cast<std::ptrdiff_t>(first)),
+          step(reversed ? -1 : 1), length(last - first)
+    {
+        BOOST_ASSERT(first <= last);
+    }
+
+    std::size_t ListIndex(const std::size_t index) const
+    {
+        return static_cast<std::size_t>(base + static_cast<std::ptrdiff_t>(index) * step);
+    }
+
+    Cursor Seek(const std::size_t index) const
+    {
+        if (!blocks)
+        {
+            return Cursor{index, nodes[index], nullptr};
+        }
+        const auto &block = blocks[index / GEOMETRY_NODE_BLOCK_SIZE];
+        Cursor cursor{index - index % GEOMETRY_NODE_BLOCK_SIZE, block.first, bytes + block.offset};
+        // the first difference of the block is already part of its first node
+        detail::readVarint(cursor.position);
+        while (cursor.index != index)
+        {
+            Next(cursor);
+        }
+        return cursor;
+    }
+
+    void Next(Cursor &cursor) const
+    {
+        ++cursor.index;
+        if (!blocks)
+        {
+            cursor.node = nodes[cursor.index];
+            return;
+        }
+        cursor.node += static_cast<std::uint32_t>(detail::zigzagDecode(
+            detail::readVarint(cursor.position)));
+    }
+
+    void Previous(Cursor &cursor) const
+    {
+        BOOST_ASSERT(cursor.index > 0);
+        --cursor.index;
+        if (!blocks)
+        {
+            cursor.node = nodes[cursor.index];
+            return;
+        }
+        // steps back over the difference of the node the cursor was at, which starts in the same
+        // block or at the end of the one before
+        cursor.node -= static_cast<std::uint32_t>(
+            detail::zigzagDecode(detail::readVarintBackward(cursor.position, bytes)));
+    }
+
+    const NodeID *nodes = nullptr;
+    const GeometryNodeBlock *blocks = nullptr;
+    const std::uint8_t *bytes = nullptr;
+    std::ptrdiff_t base = 0;
+    std::ptrdiff_t step = 1;
+    std::size_t length = 0;
+};
+
+// Nodes of all geometries, either as a plain array or compressed in blocks
+template <bool UseSharedMemory> class GeometryNodeList
+{
+  public:
+    GeometryNodeList() = default;
+
+    explicit GeometryNodeList(typename ShM<NodeID, UseSharedMemory>::vector &nodes_)
+        : number_of_nodes(nodes_.size())
+    {
+        using std::swap;
+        swap(nodes, nodes_);
+    }
+
+    GeometryNodeList(typename ShM<GeometryNodeBlock, UseSharedMemory>::vector &blocks_,
+                     typename ShM<std::uint8_t, UseSharedMemory>::vector &bytes_,
+                     const std::size_t number_of_nodes_)
+        : number_of_nodes(number_of_nodes_)
+    {
+        BOOST_ASSERT(blocks_.size() == (number_of_nodes + GEOMETRY_NODE_BLOCK_SIZE - 1) /
+                                           GEOMETRY_NODE_BLOCK_SIZE);
+        using std::swap;
+        swap(blocks, blocks_);
+        swap(bytes, bytes_);
+    }
+
+    std::size_t size() const { return number_of_nodes; }
+
+    bool empty() const { return number_of_nodes == 0; }
+
+    bool compressed() const { return !blocks.empty(); }
+
+    NodeID operator[](const std::size_t index) const
+    {
+        BOOST_ASSERT(index < number_of_nodes);
+        return GetView(index, index + 1).front();
+    }
+
+    GeometryNodeView
+    GetView(const std::size_t first, const std::size_t last, const bool reversed = false) const
+    {
+        BOOST_ASSERT(last <= number_of_nodes);
+        if (compressed())
+        {
+            return GeometryNodeView(blocks.data(), bytes.data(), first, last, reversed);
+        }
+        return GeometryNodeView(nodes.data(), first, last, reversed);
+    }
+
+  private:
+    std::size_t number_of_nodes = 0;
+    typename ShM<NodeID, UseSharedMemory>::vector nodes;
+    typename ShM<GeometryNodeBlock, UseSharedMemory>::vector blocks;
+    typename ShM<std::uint8_t, UseSharedMemory>::vector bytes;
+};
+}
+}
+
+#endif // OSRM_UTIL_GEOMETRY_NODE_LIST_HPP
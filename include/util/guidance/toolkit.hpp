@@ -13,6 +13,7 @@
 #include "util/guidance/entry_class.hpp"
 #include "util/name_table.hpp"
 #include "util/simple_logger.hpp"
+#include "util/string_view.hpp"
 
 #include <algorithm>
 #include <string>
@@ -148,14 +149,15 @@ inline bool staysOnRoundabout(const extractor::guidance::TurnInstruction instruc
 // Name Change Logic
 // Used both during Extraction as well as during Post-Processing
 
-inline std::pair<std::string, std::string> getPrefixAndSuffix(const std::string &data)
+inline std::pair<std::string, std::string> getPrefixAndSuffix(const util::StringView data)
 {
     const auto suffix_pos = data.find_last_of(' ');
-    if (suffix_pos == std::string::npos)
+    if (suffix_pos == util::StringView::npos)
         return {};
 
     const auto prefix_pos = data.find_first_of(' ');
-    auto result = std::make_pair(data.substr(0, prefix_pos), data.substr(suffix_pos + 1));
+    auto result = std::make_pair(data.substr(0, prefix_pos).to_string(),
+                                 data.substr(suffix_pos + 1).to_string());
     boost::to_lower(result.first);
     boost::to_lower(result.second);
     return result;
@@ -163,13 +165,15 @@ inline std::pair<std::string, std::string> getPrefixAndSuffix(const std::string
 
 // Note: there is an overload without suffix checking below.
 // (that's the reason we template the suffix table here)
+// The names are compared as views, so that names of the name table or of route steps are not
+// copied for every comparison.
 template <typename SuffixTable>
-inline bool requiresNameAnnounced(const std::string &from_name,
-                                  const std::string &from_ref,
-                                  const std::string &from_pronunciation,
-                                  const std::string &to_name,
-                                  const std::string &to_ref,
-                                  const std::string &to_pronunciation,
+inline bool requiresNameAnnounced(const util::StringView from_name,
+                                  const util::StringView from_ref,
+                                  const util::StringView from_pronunciation,
+                                  const util::StringView to_name,
+                                  const util::StringView to_ref,
+                                  const util::StringView to_pronunciation,
                                   const SuffixTable &suffix_table)
 {
     // first is empty and the second is not
@@ -182,11 +186,11 @@ inline bool requiresNameAnnounced(const std::string &from_name,
 
     // check similarity of names
     const auto names_are_empty = from_name.empty() && to_name.empty();
-    const auto name_is_contained =
-        boost::starts_with(from_name, to_name) || boost::starts_with(to_name, from_name);
+    const auto name_is_contained = from_name.starts_with(to_name) || to_name.starts_with(from_name);
 
-    const auto checkForPrefixOrSuffixChange = [](
-        const std::string &first, const std::string &second, const SuffixTable &suffix_table) {
+    const auto checkForPrefixOrSuffixChange = [](const util::StringView first,
+                                                 const util::StringView second,
+                                                 const SuffixTable &suffix_table) {
 
         const auto first_prefix_and_suffixes = getPrefixAndSuffix(first);
         const auto second_prefix_and_suffixes = getPrefixAndSuffix(second);
@@ -208,11 +212,8 @@ inline bool requiresNameAnnounced(const std::string &from_name,
                 return false;
             if (!checkTable(second_prefix_and_suffixes.first))
                 return false;
-            return !first.compare(getOffset(first_prefix_and_suffixes.first),
-                                  std::string::npos,
-                                  second,
-                                  getOffset(second_prefix_and_suffixes.first),
-                                  std::string::npos);
+            return first.substr(getOffset(first_prefix_and_suffixes.first)) ==
+                   second.substr(getOffset(second_prefix_and_suffixes.first));
         }();
 
         const bool is_suffix_change = [&]() -> bool {
@@ -220,11 +221,9 @@ inline bool requiresNameAnnounced(const std::string &from_name,
                 return false;
             if (!checkTable(second_prefix_and_suffixes.second))
                 return false;
-            return !first.compare(0,
-                                  first.length() - getOffset(first_prefix_and_suffixes.second),
-                                  second,
-                                  0,
-                                  second.length() - getOffset(second_prefix_and_suffixes.second));
+            return first.substr(0, first.length() - getOffset(first_prefix_and_suffixes.second)) ==
+                   second.substr(0,
+                                 second.length() - getOffset(second_prefix_and_suffixes.second));
         }();
 
         return is_prefix_change || is_suffix_change;
@@ -237,7 +236,8 @@ inline bool requiresNameAnnounced(const std::string &from_name,
     const auto refs_are_empty = from_ref.empty() && to_ref.empty();
     const auto ref_is_contained =
         from_ref.empty() || to_ref.empty() ||
-        (from_ref.find(to_ref) != std::string::npos || to_ref.find(from_ref) != std::string::npos);
+        (from_ref.find(to_ref) != util::StringView::npos ||
+         to_ref.find(from_ref) != util::StringView::npos);
     const auto ref_is_removed = !from_ref.empty() && to_ref.empty();
 
     const auto obvious_change =
@@ -255,12 +255,12 @@ inline bool requiresNameAnnounced(const std::string &from_name,
 }
 
 // Overload without suffix checking
-inline bool requiresNameAnnounced(const std::string &from_name,
-                                  const std::string &from_ref,
-                                  const std::string &from_pronunciation,
-                                  const std::string &to_name,
-                                  const std::string &to_ref,
-                                  const std::string &to_pronunciation)
+inline bool requiresNameAnnounced(const util::StringView from_name,
+                                  const util::StringView from_ref,
+                                  const util::StringView from_pronunciation,
+                                  const util::StringView to_name,
+                                  const util::StringView to_ref,
+                                  const util::StringView to_pronunciation)
 {
     // Dummy since we need to provide a SuffixTable but do not have the data for it.
     // (Guidance Post-Processing does not keep the suffix table around at the moment)
@@ -0,0 +1,26 @@
+#ifndef OSRM_UTIL_HUGE_PAGES_HPP
+#define OSRM_UTIL_HUGE_PAGES_HPP
+
+#include <cstddef>
+
+namespace osrm
+{
+namespace util
+{
+
+// Returns the size of the default huge pages in bytes, 0 if the platform has none
+std::size_t getHugePageSize();
+
+// Advises the kernel to back the huge page aligned part of [begin, begin + size) with
+// transparent huge pages. Memory advised before it is first touched gets huge pages right away,
+// memory that already is in use is collapsed into huge pages in the background.
+// Returns false if the platform does not support it.
+bool adviseHugePages(void *begin, const std::size_t size);
+
+// Returns how many bytes of [begin, begin + size) are backed by huge pages, either transparent
+// ones or huge pages of a huge page file system. Returns 0 on platforms without huge pages.
+std::size_t getHugePageBackedBytes(const void *begin, const std::size_t size);
+}
+}
+
+#endif // OSRM_UTIL_HUGE_PAGES_HPP
@@ -28,15 +28,20 @@ inline bool writeFingerprint(std::ostream &stream)
     return static_cast<bool>(stream);
 }
 
+inline bool checkFingerprint(const FingerPrint &fingerprint)
+{
+    const auto valid = FingerPrint::GetValid();
+    // compare the compilation state stored in the fingerprint
+    return valid.IsMagicNumberOK(fingerprint) && valid.TestContractor(fingerprint) &&
+           valid.TestGraphUtil(fingerprint) && valid.TestRTree(fingerprint) &&
+           valid.TestQueryObjects(fingerprint);
+}
+
 inline bool readAndCheckFingerprint(std::istream &stream)
 {
     FingerPrint fingerprint;
-    const auto valid = FingerPrint::GetValid();
     stream.read(reinterpret_cast<char *>(&fingerprint), sizeof(fingerprint));
-    // compare the compilation state stored in the fingerprint
-    return static_cast<bool>(stream) && valid.IsMagicNumberOK(fingerprint) &&
-           valid.TestContractor(fingerprint) && valid.TestGraphUtil(fingerprint) &&
-           valid.TestRTree(fingerprint) && valid.TestQueryObjects(fingerprint);
+    return static_cast<bool>(stream) && checkFingerprint(fingerprint);
 }
 
 template <typename simple_type>
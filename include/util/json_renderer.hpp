@@ -89,11 +89,7 @@ struct ArrayRenderer
         out.push_back('\"');
     }
 
-    void operator()(const Number &number) const
-    {
-        const std::string number_string = cast::to_string_with_precision(number.value);
-        out.insert(out.end(), number_string.begin(), number_string.end());
-    }
+    void operator()(const Number &number) const { cast::append_with_precision(out, number.value); }
 
     void operator()(const Object &object) const
     {
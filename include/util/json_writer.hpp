@@ -0,0 +1,190 @@
+#ifndef JSON_WRITER_HPP
+#define JSON_WRITER_HPP
+
+#include "util/cast.hpp"
+#include "util/json_renderer.hpp"
+#include "util/string_util.hpp"
+
+#include "osrm/json_container.hpp"
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+namespace json
+{
+
+// Streams JSON text directly into a byte buffer, without building a json::Value tree first.
+// Produces the same text as the ArrayRenderer would for the equivalent tree.
+// Separators are inserted automatically, keys and values just have to be written in order:
+//
+//   Writer writer;
+//   writer.BeginObject();
+//   writer.Key("code");
+//   writer.String("Ok");
+//   writer.EndObject();
+class Writer
+{
+  public:
+    Writer() = default;
+
+    // Writes into the buffer of a previous response, which keeps its capacity
+    explicit Writer(std::vector<char> buffer_) : buffer(std::move(buffer_)) { buffer.clear(); }
+
+    void Reserve(const std::size_t capacity) { buffer.reserve(capacity); }
+
+    void BeginObject()
+    {
+        BeginValue();
+        buffer.push_back('{');
+        has_elements.push_back(false);
+    }
+
+    void EndObject()
+    {
+        BOOST_ASSERT(!has_elements.empty());
+        BOOST_ASSERT(!after_key);
+        has_elements.pop_back();
+        buffer.push_back('}');
+    }
+
+    void BeginArray()
+    {
+        BeginValue();
+        buffer.push_back('[');
+        has_elements.push_back(false);
+    }
+
+    void EndArray()
+    {
+        BOOST_ASSERT(!has_elements.empty());
+        has_elements.pop_back();
+        buffer.push_back(']');
+    }
+
+    // Has to be followed by exactly one value
+    void Key(const std::string &key)
+    {
+        BeginValue();
+        buffer.push_back('\"');
+        buffer.insert(buffer.end(), key.begin(), key.end());
+        buffer.push_back('\"');
+        buffer.push_back(':');
+        after_key = true;
+    }
+
+    void String(const std::string &value)
+    {
+        BeginValue();
+        buffer.push_back('\"');
+        const auto escaped_value = escape_JSON(value);
+        buffer.insert(buffer.end(), escaped_value.begin(), escaped_value.end());
+        buffer.push_back('\"');
+    }
+
+    void Number(const double value)
+    {
+        BeginValue();
+        cast::append_with_precision(buffer, value);
+    }
+
+    // Writes the same text as Number(value / 10.) for the tenths durations and distances are
+    // computed in, without going through a double
+    void Tenths(const std::int64_t value)
+    {
+        BeginValue();
+        std::uint64_t magnitude = value < 0 ? 0 - static_cast<std::uint64_t>(value) : value;
+
+        char digits[24];
+        char *end = digits + sizeof(digits);
+        char *begin = end;
+        if (magnitude % 10 != 0)
+        {
+            *--begin = static_cast<char>('0' + magnitude % 10);
+            *--begin = '.';
+        }
+        magnitude /= 10;
+        do
+        {
+            *--begin = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (value < 0)
+        {
+            *--begin = '-';
+        }
+        buffer.insert(buffer.end(), begin, end);
+    }
+
+    void True() { Literal("true"); }
+
+    void False() { Literal("false"); }
+
+    void Null() { Literal("null"); }
+
+    // Renders a tree in place, for small parts of a response that are easier to build as a tree
+    void Write(const Value &value)
+    {
+        BeginValue();
+        mapbox::util::apply_visitor(ArrayRenderer(buffer), value);
+    }
+
+    std::vector<char> &GetBuffer()
+    {
+        BOOST_ASSERT(has_elements.empty());
+        return buffer;
+    }
+
+    const std::vector<char> &GetBuffer() const
+    {
+        BOOST_ASSERT(has_elements.empty());
+        return buffer;
+    }
+
+  private:
+    void Literal(const char *literal)
+    {
+        BeginValue();
+        while (*literal != '\0')
+        {
+            buffer.push_back(*literal++);
+        }
+    }
+
+    // Inserts the separator before the next element of the innermost container
+    void BeginValue()
+    {
+        if (after_key)
+        {
+            after_key = false;
+            return;
+        }
+        if (!has_elements.empty())
+        {
+            if (has_elements.back())
+            {
+                buffer.push_back(',');
+            }
+            has_elements.back() = true;
+        }
+    }
+
+    std::vector<char> buffer;
+    // one entry per open object or array
+    std::vector<bool> has_elements;
+    bool after_key = false;
+};
+
+} // namespace json
+} // namespace util
+} // namespace osrm
+
+#endif // JSON_WRITER_HPP
@@ -0,0 +1,139 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Buckets of all histograms summed up, to compute quantiles from
+struct LatencySummary
+{
+    std::vector<std::uint64_t> counts;
+    std::uint64_t count = 0;
+    std::uint64_t sum = 0;
+
+    // Upper bound of the bucket that holds the quantile, 0 if nothing was recorded
+    std::uint64_t Quantile(const double quantile) const;
+};
+
+// HDR-style histogram of durations in microseconds. Every power of two is split into
+// SUB_BUCKETS buckets, so the relative error stays below 1/SUB_BUCKETS from 1us to days.
+// Only a single thread may record, but any thread may collect at the same time.
+class LatencyHistogram
+{
+  public:
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+    static constexpr std::uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    // durations of 2^MAX_EXPONENT us (12 days) and longer land in the last bucket
+    static constexpr unsigned MAX_EXPONENT = 40;
+    static constexpr std::size_t NUM_BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+    LatencyHistogram()
+    {
+        for (auto &count : counts)
+        {
+            count.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    void Record(const std::uint64_t microseconds)
+    {
+        // there is only one writer, so no read-modify-write instructions are needed
+        auto &count = counts[BucketIndex(microseconds)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum.store(sum.load(std::memory_order_relaxed) + microseconds, std::memory_order_relaxed);
+    }
+
+    void Collect(LatencySummary &summary) const
+    {
+        summary.counts.resize(NUM_BUCKETS, 0);
+        for (std::size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+        {
+            const auto count = counts[bucket].load(std::memory_order_relaxed);
+            summary.counts[bucket] += count;
+            summary.count += count;
+        }
+        summary.sum += sum.load(std::memory_order_relaxed);
+    }
+
+    static std::size_t BucketIndex(const std::uint64_t microseconds)
+    {
+        // the first two sub bucket ranges hold one duration per bucket
+        if (microseconds < 2 * SUB_BUCKETS)
+        {
+            return static_cast<std::size_t>(microseconds);
+        }
+
+        unsigned exponent = SUB_BUCKET_BITS;
+        while (exponent < MAX_EXPONENT && (microseconds >> (exponent + 1)) != 0)
+        {
+            ++exponent;
+        }
+        if ((microseconds >> (exponent + 1)) != 0)
+        {
+            return NUM_BUCKETS - 1;
+        }
+
+        const auto mantissa = microseconds >> (exponent - SUB_BUCKET_BITS);
+        BOOST_ASSERT(mantissa >= SUB_BUCKETS && mantissa < 2 * SUB_BUCKETS);
+        return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + (mantissa - SUB_BUCKETS);
+    }
+
+    // Largest duration that falls into the bucket
+    static std::uint64_t BucketUpperBound(const std::size_t bucket)
+    {
+        BOOST_ASSERT(bucket < NUM_BUCKETS);
+        if (bucket < 2 * SUB_BUCKETS)
+        {
+            return bucket;
+        }
+
+        const auto shift = bucket / SUB_BUCKETS - 1;
+        const auto mantissa = bucket % SUB_BUCKETS + SUB_BUCKETS;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+  private:
+    std::array<std::atomic<std::uint64_t>, NUM_BUCKETS> counts;
+    std::atomic<std::uint64_t> sum{0};
+};
+
+inline std::uint64_t LatencySummary::Quantile(const double quantile) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    const auto rank = std::max<std::uint64_t>(
+        1, static_cast<std::uint64_t>(std::ceil(quantile * static_cast<double>(count))));
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < counts.size(); ++bucket)
+    {
+        seen += counts[bucket];
+        if (seen >= rank)
+        {
+            return LatencyHistogram::BucketUpperBound(bucket);
+        }
+    }
+    return LatencyHistogram::BucketUpperBound(counts.size() - 1);
+}
+
+} // namespace util
+} // namespace osrm
+
+#endif // LATENCY_HISTOGRAM_HPP
@@ -0,0 +1,355 @@
+#ifndef OSRM_UTIL_MULTI_LEVEL_GRAPH_HPP
+#define OSRM_UTIL_MULTI_LEVEL_GRAPH_HPP
+
+#include "util/integer_range.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <iosfwd>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Nested cells of the nodes of a graph on a number of levels, every cell of a level is a union of
+// cells of the level below. Level 0 are the nodes themselves. The cells of a node on all levels
+// are packed into one 64 bit word.
+class MultiLevelPartition
+{
+  public:
+    using LevelID = std::uint8_t;
+    using CellID = std::uint32_t;
+
+    MultiLevelPartition() = default;
+
+    // level_cells[l][node] is the cell of the node on level l + 1, the cells have to be nested
+    explicit MultiLevelPartition(const std::vector<std::vector<CellID>> &level_cells);
+
+    std::size_t GetNumberOfNodes() const { return cells.size(); }
+
+    LevelID GetNumberOfLevels() const { return static_cast<LevelID>(level_offsets.size()); }
+
+    CellID GetNumberOfCells(const LevelID level) const
+    {
+        BOOST_ASSERT(level > 0 && level <= GetNumberOfLevels());
+        return level_cell_counts[level - 1];
+    }
+
+    CellID GetCell(const LevelID level, const NodeID node) const
+    {
+        BOOST_ASSERT(level > 0 && level <= GetNumberOfLevels());
+        BOOST_ASSERT(node < cells.size());
+        return static_cast<CellID>((cells[node] >> level_offsets[level - 1]) &
+                                   level_masks[level - 1]);
+    }
+
+    // Highest level on which the cell of the node contains none of the nodes in [begin, end),
+    // 0 if it shares its cell on the lowest level with one of them
+    template <typename NodeIter>
+    LevelID GetQueryLevel(const NodeID node, NodeIter begin, const NodeIter end) const
+    {
+        LevelID level = GetNumberOfLevels();
+        for (; begin != end && level > 0; ++begin)
+        {
+            // sharing a cell on a level means sharing it on all levels above
+            while (level > 0 && GetCell(level, node) == GetCell(level, *begin))
+            {
+                --level;
+            }
+        }
+        return level;
+    }
+
+    bool Write(std::ostream &stream) const;
+    bool Read(std::istream &stream);
+
+  private:
+    void ComputeMasks();
+
+    std::vector<std::uint64_t> cells;
+    std::vector<CellID> level_cell_counts;
+    std::vector<std::uint8_t> level_offsets;
+    std::vector<std::uint64_t> level_masks;
+};
+
+// How a node was reached by a search on the overlay: a base arc or an arc of the clique of the
+// cell on the level
+struct MultiLevelHeapData
+{
+    NodeID parent;
+    // index of the base arc in the arcs the search used, SPECIAL_EDGEID for a clique arc
+    EdgeID arc;
+    MultiLevelPartition::LevelID level;
+};
+
+// Graph with an overlay over the cells of a multi-level partition. The boundary nodes of a cell
+// have arcs to or from nodes outside of it, the clique of the cell holds the weights of the
+// shortest paths inside the cell between all of them. A search only needs the arcs inside the
+// cells of the sources and targets, elsewhere it uses the cliques and the arcs between cells on
+// the highest level that contains none of them.
+//
+// The cliques are computed bottom up from the cliques of the level below, which only depends on
+// the weights of the arcs and can be redone quickly after they changed.
+class MultiLevelGraph
+{
+  public:
+    using LevelID = MultiLevelPartition::LevelID;
+    using CellID = MultiLevelPartition::CellID;
+
+    struct Arc
+    {
+        // the target of an outgoing arc, the source of an incoming one
+        NodeID head;
+        EdgeWeight weight;
+        // id of the edge-based edge, it identifies the turn
+        NodeID edge_id;
+    };
+
+    MultiLevelGraph() = default;
+
+    // The edges have a source, target, weight, edge_id and the flags forward and backward, an edge
+    // in the backward direction is an arc from its target to its source. The cliques are left
+    // without weights until they are customized.
+    template <typename EdgeContainerT>
+    MultiLevelGraph(MultiLevelPartition partition_, const EdgeContainerT &edges)
+        : partition(std::move(partition_))
+    {
+        const auto number_of_nodes = static_cast<NodeID>(partition.GetNumberOfNodes());
+        out_first_arc.assign(number_of_nodes + 1, 0);
+        in_first_arc.assign(number_of_nodes + 1, 0);
+        for (const auto index : irange<std::size_t>(0, edges.size()))
+        {
+            const auto &edge = edges[index];
+            BOOST_ASSERT(edge.source < number_of_nodes && edge.target < number_of_nodes);
+            if (edge.forward)
+            {
+                ++out_first_arc[edge.source + 1];
+                ++in_first_arc[edge.target + 1];
+            }
+            if (edge.backward)
+            {
+                ++out_first_arc[edge.target + 1];
+                ++in_first_arc[edge.source + 1];
+            }
+        }
+        std::partial_sum(out_first_arc.begin(), out_first_arc.end(), out_first_arc.begin());
+        std::partial_sum(in_first_arc.begin(), in_first_arc.end(), in_first_arc.begin());
+
+        out_arcs.resize(out_first_arc.back());
+        in_arcs.resize(in_first_arc.back());
+        auto out_position = out_first_arc;
+        auto in_position = in_first_arc;
+        const auto add_arc = [&](const NodeID from, const NodeID to, const EdgeWeight weight,
+                                 const NodeID edge_id) {
+            out_arcs[out_position[from]++] = Arc{to, weight, edge_id};
+            in_arcs[in_position[to]++] = Arc{from, weight, edge_id};
+        };
+        for (const auto index : irange<std::size_t>(0, edges.size()))
+        {
+            const auto &edge = edges[index];
+            if (edge.forward)
+            {
+                add_arc(edge.source, edge.target, edge.weight, edge.edge_id);
+            }
+            if (edge.backward)
+            {
+                add_arc(edge.target, edge.source, edge.weight, edge.edge_id);
+            }
+        }
+
+        BuildCells();
+    }
+
+    const MultiLevelPartition &GetPartition() const { return partition; }
+
+    NodeID GetNumberOfNodes() const { return static_cast<NodeID>(out_first_arc.size() - 1); }
+
+    range<EdgeID> GetOutArcs(const NodeID node) const
+    {
+        return irange(out_first_arc[node], out_first_arc[node + 1]);
+    }
+    range<EdgeID> GetInArcs(const NodeID node) const
+    {
+        return irange(in_first_arc[node], in_first_arc[node + 1]);
+    }
+    const Arc &GetOutArc(const EdgeID arc) const { return out_arcs[arc]; }
+    const Arc &GetInArc(const EdgeID arc) const { return in_arcs[arc]; }
+
+    // Sorted boundary nodes of the cell
+    std::pair<const NodeID *, const NodeID *> GetBoundaryNodes(const LevelID level,
+                                                                const CellID cell) const
+    {
+        const auto index = CellIndex(level, cell);
+        return std::make_pair(boundary_nodes.data() + boundary_offsets[index],
+                              boundary_nodes.data() + boundary_offsets[index + 1]);
+    }
+
+    // Index of the node in the boundary nodes of its cell, SPECIAL_NODEID for inner nodes
+    NodeID GetBoundaryIndex(const LevelID level, const NodeID node) const
+    {
+        const auto boundary = GetBoundaryNodes(level, partition.GetCell(level, node));
+        const auto position = std::lower_bound(boundary.first, boundary.second, node);
+        return position != boundary.second && *position == node
+                   ? static_cast<NodeID>(position - boundary.first)
+                   : SPECIAL_NODEID;
+    }
+
+    // Weights of the clique of the cell, the row of a boundary node holds the weights from it to
+    // the others. INVALID_EDGE_WEIGHT if there is no path inside the cell.
+    const EdgeWeight *GetCliqueWeights(const LevelID level, const CellID cell) const
+    {
+        return clique_weights.data() + clique_offsets[CellIndex(level, cell)];
+    }
+    EdgeWeight *GetCliqueWeights(const LevelID level, const CellID cell)
+    {
+        return clique_weights.data() + clique_offsets[CellIndex(level, cell)];
+    }
+
+    // Relaxes the arcs of the node on the overlay of the level: the clique of its cell and the
+    // arcs leaving the cell on levels above 0, all arcs on level 0. A node on a level above 0 has
+    // to be a boundary node of its cell. Heads are only relaxed if they pass the filter.
+    template <bool FORWARD, typename HeapT, typename FilterT>
+    void RelaxNode(HeapT &heap,
+                   const NodeID node,
+                   const EdgeWeight weight,
+                   const LevelID level,
+                   const FilterT &filter) const
+    {
+        const auto relax = [&heap, weight](
+            const NodeID head, const EdgeWeight arc_weight, const MultiLevelHeapData &data) {
+            const EdgeWeight head_weight = weight + arc_weight;
+            if (!heap.WasInserted(head))
+            {
+                heap.Insert(head, head_weight, data);
+            }
+            else if (head_weight < heap.GetKey(head))
+            {
+                heap.GetData(head) = data;
+                heap.DecreaseKey(head, head_weight);
+            }
+        };
+
+        const auto cell = level > 0 ? partition.GetCell(level, node) : 0;
+        if (level > 0)
+        {
+            const auto boundary = GetBoundaryNodes(level, cell);
+            const auto size = static_cast<NodeID>(boundary.second - boundary.first);
+            const auto index = GetBoundaryIndex(level, node);
+            BOOST_ASSERT(index != SPECIAL_NODEID);
+            const auto weights = GetCliqueWeights(level, cell);
+            for (const auto other : irange<NodeID>(0, size))
+            {
+                const auto clique_weight =
+                    FORWARD ? weights[index * size + other] : weights[other * size + index];
+                if (other != index && clique_weight != INVALID_EDGE_WEIGHT &&
+                    filter(boundary.first[other]))
+                {
+                    relax(boundary.first[other], clique_weight, {node, SPECIAL_EDGEID, level});
+                }
+            }
+        }
+        for (const auto arc : FORWARD ? GetOutArcs(node) : GetInArcs(node))
+        {
+            const auto &data = FORWARD ? out_arcs[arc] : in_arcs[arc];
+            if ((level == 0 || partition.GetCell(level, data.head) != cell) && filter(data.head))
+            {
+                relax(data.head, data.weight, {node, arc, 0});
+            }
+        }
+    }
+
+    // Runs a forward search from the nodes in the heap inside the cell of the level on the
+    // overlay of the level below it, until it settled a node for which stop returns true
+    template <typename HeapT, typename StopT>
+    void SearchCell(HeapT &heap, const LevelID level, const CellID cell, const StopT &stop) const
+    {
+        BOOST_ASSERT(level > 0);
+        const auto in_cell = [this, level, cell](const NodeID head) {
+            return partition.GetCell(level, head) == cell;
+        };
+        while (!heap.Empty())
+        {
+            const auto node = heap.DeleteMin();
+            if (stop(node))
+            {
+                return;
+            }
+            RelaxNode<true>(heap, node, heap.GetKey(node), level - 1, in_cell);
+        }
+    }
+
+    // Appends the base arcs of the shortest path of the clique arc between two boundary nodes of
+    // a cell of the level, the head of an arc is its target
+    template <typename HeapT>
+    void UnpackCliqueArc(HeapT &heap,
+                         const LevelID level,
+                         const NodeID from,
+                         const NodeID to,
+                         std::vector<Arc> &path) const
+    {
+        BOOST_ASSERT(partition.GetCell(level, from) == partition.GetCell(level, to));
+        heap.Clear();
+        heap.Insert(from, 0, {from, SPECIAL_EDGEID, 0});
+        SearchCell(heap, level, partition.GetCell(level, from), [to](const NodeID node) {
+            return node == to;
+        });
+        BOOST_ASSERT(heap.WasInserted(to));
+
+        // the heap is reused by the clique arcs of the path
+        std::vector<std::pair<NodeID, MultiLevelHeapData>> steps;
+        for (NodeID node = to; node != from; node = heap.GetData(node).parent)
+        {
+            steps.emplace_back(node, heap.GetData(node));
+        }
+        for (auto step = steps.rbegin(); step != steps.rend(); ++step)
+        {
+            const auto &data = step->second;
+            if (data.arc != SPECIAL_EDGEID)
+            {
+                path.push_back(out_arcs[data.arc]);
+            }
+            else
+            {
+                UnpackCliqueArc(heap, data.level, data.parent, step->first, path);
+            }
+        }
+    }
+
+    bool Write(std::ostream &stream) const;
+    bool Read(std::istream &stream);
+
+  private:
+    std::size_t CellIndex(const LevelID level, const CellID cell) const
+    {
+        BOOST_ASSERT(level > 0 && level <= partition.GetNumberOfLevels());
+        return level_first_cell[level - 1] + cell;
+    }
+
+    void BuildCells();
+
+    MultiLevelPartition partition;
+
+    std::vector<EdgeID> out_first_arc;
+    std::vector<Arc> out_arcs;
+    std::vector<EdgeID> in_first_arc;
+    std::vector<Arc> in_arcs;
+
+    // the cells of all levels are numbered consecutively from the lowest level
+    std::vector<std::uint32_t> level_first_cell;
+    std::vector<std::uint32_t> boundary_offsets;
+    std::vector<NodeID> boundary_nodes;
+    std::vector<std::uint64_t> clique_offsets;
+    std::vector<EdgeWeight> clique_weights;
+};
+}
+}
+
+#endif // OSRM_UTIL_MULTI_LEVEL_GRAPH_HPP
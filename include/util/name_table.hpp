@@ -3,6 +3,7 @@
 
 #include "util/range_table.hpp"
 #include "util/shared_memory_vector_wrapper.hpp"
+#include "util/string_view.hpp"
 
 #include <string>
 
@@ -28,9 +29,10 @@ class NameTable
     // The following functions are a subset of what is available.
     // See the data facades for they provide full access to this serialized string data.
     // (at time of writing this: get{Name,Ref,Pronunciation,Destinations}ForID(name_id);)
-    std::string GetNameForID(const unsigned name_id) const;
-    std::string GetRefForID(const unsigned name_id) const;
-    std::string GetPronunciationForID(const unsigned name_id) const;
+    // The views point into the table and stay valid as long as it does.
+    StringView GetNameForID(const unsigned name_id) const;
+    StringView GetRefForID(const unsigned name_id) const;
+    StringView GetPronunciationForID(const unsigned name_id) const;
 };
 } // namespace util
 } // namespace osrm
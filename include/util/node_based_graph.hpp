@@ -5,10 +5,13 @@
 #include "extractor/node_based_edge.hpp"
 #include "util/dynamic_graph.hpp"
 #include "util/graph_utils.hpp"
+#include "util/static_graph.hpp"
 
 #include <tbb/parallel_sort.h>
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 namespace osrm
 {
@@ -21,7 +24,7 @@ struct NodeBasedEdgeData
         : distance(INVALID_EDGE_WEIGHT), edge_id(SPECIAL_NODEID),
           name_id(std::numeric_limits<unsigned>::max()), access_restricted(false), reversed(false),
           roundabout(false), travel_mode(TRAVEL_MODE_INACCESSIBLE),
-          lane_description_id(INVALID_LANE_DESCRIPTIONID)
+          lane_description_id(INVALID_LANE_DESCRIPTIONID), classes(0)
     {
     }
 
@@ -36,7 +39,8 @@ struct NodeBasedEdgeData
                       const LaneDescriptionID lane_description_id)
         : distance(distance), edge_id(edge_id), name_id(name_id),
           access_restricted(access_restricted), reversed(reversed), roundabout(roundabout),
-          startpoint(startpoint), travel_mode(travel_mode), lane_description_id(lane_description_id)
+          startpoint(startpoint), travel_mode(travel_mode),
+          lane_description_id(lane_description_id), classes(0)
     {
     }
 
@@ -50,13 +54,14 @@ struct NodeBasedEdgeData
     extractor::TravelMode travel_mode : 4;
     LaneDescriptionID lane_description_id;
     extractor::guidance::RoadClassification road_classification;
+    extractor::ClassData classes;
 
     bool IsCompatibleTo(const NodeBasedEdgeData &other) const
     {
         return (reversed == other.reversed) && (roundabout == other.roundabout) &&
                (startpoint == other.startpoint) && (access_restricted == other.access_restricted) &&
                (travel_mode == other.travel_mode) &&
-               (road_classification == other.road_classification);
+               (road_classification == other.road_classification) && (classes == other.classes);
     }
 
     bool CanCombineWith(const NodeBasedEdgeData &other) const
@@ -66,6 +71,7 @@ struct NodeBasedEdgeData
 };
 
 using NodeBasedDynamicGraph = DynamicGraph<NodeBasedEdgeData>;
+using NodeBasedStaticGraph = StaticGraph<NodeBasedEdgeData>;
 
 /// Factory method to create NodeBasedDynamicGraph from NodeBasedEdges
 /// Since DynamicGraph expects directed edges, we need to insert
@@ -88,6 +94,7 @@ NodeBasedDynamicGraphFromEdges(NodeID number_of_nodes,
             output_edge.data.startpoint = input_edge.startpoint;
             output_edge.data.road_classification = input_edge.road_classification;
             output_edge.data.lane_description_id = input_edge.lane_description_id;
+            output_edge.data.classes = input_edge.classes;
         });
 
     tbb::parallel_sort(edges_list.begin(), edges_list.end());
@@ -96,6 +103,42 @@ NodeBasedDynamicGraphFromEdges(NodeID number_of_nodes,
 
     return graph;
 }
+
+/// Freezes the compressed NodeBasedDynamicGraph for the guidance and the edge expansion, which
+/// only read it. The static graph stores the edges of a node in one block without the slack and
+/// the deleted edges of the dynamic graph, so the edge ids are dense. new_edge_ids maps the edge
+/// ids of the dynamic graph to the ones of the static graph, SPECIAL_EDGEID for unused slots.
+inline std::shared_ptr<NodeBasedStaticGraph>
+NodeBasedStaticGraphFromDynamic(const NodeBasedDynamicGraph &dynamic_graph,
+                                std::vector<EdgeID> &new_edge_ids)
+{
+    const auto number_of_nodes = dynamic_graph.GetNumberOfNodes();
+
+    std::vector<NodeBasedStaticGraph::NodeArrayEntry> nodes;
+    std::vector<NodeBasedStaticGraph::EdgeArrayEntry> edges;
+    nodes.reserve(number_of_nodes + 1);
+    edges.reserve(dynamic_graph.GetNumberOfEdges());
+
+    EdgeID max_dynamic_edge_id = 0;
+    for (const auto node : irange(0u, number_of_nodes))
+    {
+        max_dynamic_edge_id = std::max(max_dynamic_edge_id, dynamic_graph.EndEdges(node));
+    }
+    new_edge_ids.assign(max_dynamic_edge_id, SPECIAL_EDGEID);
+
+    for (const auto node : irange(0u, number_of_nodes))
+    {
+        nodes.push_back({static_cast<EdgeID>(edges.size())});
+        for (const auto edge : dynamic_graph.GetAdjacentEdgeRange(node))
+        {
+            new_edge_ids[edge] = static_cast<EdgeID>(edges.size());
+            edges.push_back({dynamic_graph.GetTarget(edge), dynamic_graph.GetEdgeData(edge)});
+        }
+    }
+    nodes.push_back({static_cast<EdgeID>(edges.size())});
+
+    return std::make_shared<NodeBasedStaticGraph>(nodes, edges);
+}
 }
 }
 
@@ -0,0 +1,29 @@
+#ifndef OSRM_UTIL_NUMA_HPP
+#define OSRM_UTIL_NUMA_HPP
+
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// The cpus of every NUMA node of the host, read from sysfs on Linux. Hosts without NUMA support
+// are reported as a single node holding all cpus.
+const std::vector<std::vector<unsigned>> &getNumaNodes();
+
+// Returns the NUMA node of the cpu the calling thread currently runs on
+unsigned getCurrentNumaNode();
+
+// Restricts the thread to the cpus of the node, returns false if that is not supported
+bool bindToNumaNode(std::thread &thread, const unsigned node);
+
+// Runs the task on a thread bound to the node and waits for it. Memory first touched by the task
+// is allocated on that node, so data copied or loaded by it is local to the node's cpus.
+void runOnNumaNode(const unsigned node, const std::function<void()> &task);
+}
+}
+
+#endif // OSRM_UTIL_NUMA_HPP
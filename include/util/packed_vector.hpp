@@ -4,7 +4,10 @@
 #include "util/shared_memory_vector_wrapper.hpp"
 #include "util/typedefs.hpp"
 
-#include <cmath>
+#include <boost/assert.hpp>
+
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 
 namespace osrm
@@ -17,105 +20,81 @@ namespace util
  * will predictably be containable within 33 bits for a long time, the following packs
  * 64-bit OSM IDs as 33-bit numbers within a 64-bit vector.
  *
- * NOTE: this type is templated for future use, but will require a slight refactor to
- * configure BITSIZE and ELEMSIZE
+ * Element i occupies the BITSIZE bits starting at bit i * BITSIZE counted from the most
+ * significant bit of the first word. The vector keeps one word more than the elements need,
+ * so that every element can be read from two consecutive words with shifts only: there are
+ * no branches on whether an element is split between two words.
  */
-template <typename T, bool UseSharedMemory = false> class PackedVector
+template <typename T, bool UseSharedMemory = false, std::size_t BITSIZE = 33> class PackedVector
 {
-    static const constexpr std::size_t BITSIZE = 33;
+    static_assert(BITSIZE > 0 && BITSIZE < 64, "BITSIZE needs to be in [1, 63]");
+
     static const constexpr std::size_t ELEMSIZE = 64;
-    static const constexpr std::size_t PACKSIZE = BITSIZE * ELEMSIZE;
+    static const constexpr std::uint64_t ELEMENT_MASK = (std::uint64_t{1} << BITSIZE) - 1;
+    // mask of an element that starts at the most significant bit of a word
+    static const constexpr std::uint64_t TOP_MASK = ELEMENT_MASK << (ELEMSIZE - BITSIZE);
 
   public:
     /**
      * Returns the size of the packed vector datastructure with `elements` packed elements (the size
-     * of
-     * its underlying uint64 vector)
+     * of its underlying uint64 vector), including the padding word
      */
     inline static std::size_t elements_to_blocks(std::size_t elements)
     {
-        return std::ceil(static_cast<double>(elements) * BITSIZE / ELEMSIZE);
+        return (elements * BITSIZE + ELEMSIZE - 1) / ELEMSIZE + 1;
     }
 
     void push_back(T incoming_node_id)
     {
-        std::uint64_t node_id = static_cast<std::uint64_t>(incoming_node_id);
-
-        // mask incoming values, just in case they are > bitsize
-        const std::uint64_t incoming_mask = static_cast<std::uint64_t>(pow(2, BITSIZE)) - 1;
-        node_id = node_id & incoming_mask;
-
-        const std::size_t available = (PACKSIZE - BITSIZE * num_elements) % ELEMSIZE;
-
-        if (available == 0)
-        {
-            // insert ID at the left side of this element
-            std::uint64_t at_left = node_id << (ELEMSIZE - BITSIZE);
-
-            add_last_elem(at_left);
-        }
-        else if (available >= BITSIZE)
-        {
-            // insert ID somewhere in the middle of this element; ID can be contained
-            // entirely within one element
-            const std::uint64_t shifted = node_id << (available - BITSIZE);
-
-            replace_last_elem(vec_back() | shifted);
-        }
-        else
-        {
-            // ID will be split between the end of this element and the beginning
-            // of the next element
-            const std::uint64_t left = node_id >> (BITSIZE - available);
-
-            std::uint64_t right = node_id << (ELEMSIZE - (BITSIZE - available));
-
-            replace_last_elem(vec_back() | left);
-            add_last_elem(right);
-        }
-
+        const auto index = num_elements;
+        grow(elements_to_blocks(index + 1));
         num_elements++;
+        set(index, incoming_node_id);
     }
 
-    T at(const std::size_t &a_index) const
+    // Sets an element that was pushed before, values are masked to BITSIZE bits
+    void set(const std::size_t index, T incoming_node_id)
     {
-        BOOST_ASSERT(a_index < num_elements);
-
-        const std::size_t pack_group = trunc(a_index / ELEMSIZE);
-        const std::size_t pack_index = (a_index + ELEMSIZE) % ELEMSIZE;
-        const std::size_t left_index = (PACKSIZE - BITSIZE * pack_index) % ELEMSIZE;
-
-        const bool back_half = pack_index >= BITSIZE;
-        const std::size_t index = pack_group * BITSIZE + trunc(pack_index / BITSIZE) +
-                                  trunc((pack_index - back_half) / 2);
+        BOOST_ASSERT(index < num_elements);
+
+        const std::uint64_t top_value =
+            (static_cast<std::uint64_t>(incoming_node_id) & ELEMENT_MASK) << (ELEMSIZE - BITSIZE);
+        const std::size_t offset = index * BITSIZE;
+        const std::size_t word = offset / ELEMSIZE;
+        const std::size_t shift = offset % ELEMSIZE;
+        BOOST_ASSERT(word + 1 < vec.size());
+
+        // the bits that do not fit into the first word are shifted into the top of the second
+        // one, two shifts so that a shift of 0 does not become a shift by 64
+        vec[word] = (vec[word] & ~(TOP_MASK >> shift)) | (top_value >> shift);
+        vec[word + 1] = (vec[word + 1] & ~((TOP_MASK << (ELEMSIZE - 1 - shift)) << 1)) |
+                        ((top_value << (ELEMSIZE - 1 - shift)) << 1);
+    }
 
-        BOOST_ASSERT(index < vec.size());
-        const std::uint64_t elem = static_cast<std::uint64_t>(vec.at(index));
+    T at(const std::size_t index) const
+    {
+        BOOST_ASSERT(index < num_elements);
+        return T{get(index * BITSIZE)};
+    }
 
-        if (left_index == 0)
-        {
-            // ID is at the far left side of this element
-            return T{elem >> (ELEMSIZE - BITSIZE)};
-        }
-        else if (left_index >= BITSIZE)
+    /**
+     * Decodes the elements [first, last) to `out`, walking the words with a running bit offset
+     * instead of computing the position of every element
+     */
+    template <typename OutputIter>
+    OutputIter decode(const std::size_t first, const std::size_t last, OutputIter out) const
+    {
+        BOOST_ASSERT(first <= last && last <= num_elements);
+        std::size_t word = first * BITSIZE / ELEMSIZE;
+        std::size_t shift = first * BITSIZE % ELEMSIZE;
+        for (std::size_t index = first; index < last; ++index)
         {
-            // ID is entirely contained within this element
-            const std::uint64_t at_right = elem >> (left_index - BITSIZE);
-            const std::uint64_t left_mask = static_cast<std::uint64_t>(pow(2, BITSIZE)) - 1;
-            return T{at_right & left_mask};
-        }
-        else
-        {
-            // ID is split between this and the next element
-            const std::uint64_t left_mask = static_cast<std::uint64_t>(pow(2, left_index)) - 1;
-            const std::uint64_t left_side = (elem & left_mask) << (BITSIZE - left_index);
-
-            BOOST_ASSERT(index < vec.size() - 1);
-            const std::uint64_t next_elem = static_cast<std::uint64_t>(vec.at(index + 1));
-
-            const std::uint64_t right_side = next_elem >> (ELEMSIZE - (BITSIZE - left_index));
-            return T{left_side | right_side};
+            *out++ = T{read(word, shift)};
+            shift += BITSIZE;
+            word += shift / ELEMSIZE;
+            shift %= ELEMSIZE;
         }
+        return out;
     }
 
     std::size_t size() const { return num_elements; }
@@ -136,12 +115,14 @@ template <typename T, bool UseSharedMemory = false> class PackedVector
     template <bool enabled = UseSharedMemory>
     void set_number_of_entries(typename std::enable_if<enabled, std::size_t>::type count)
     {
+        BOOST_ASSERT(elements_to_blocks(count) <= vec.size());
         num_elements = count;
     }
 
     std::size_t capacity() const
     {
-        return std::floor(static_cast<double>(vec.capacity()) * ELEMSIZE / BITSIZE);
+        // one word is padding
+        return vec.capacity() == 0 ? 0 : (vec.capacity() - 1) * ELEMSIZE / BITSIZE;
     }
 
   private:
@@ -149,43 +130,36 @@ template <typename T, bool UseSharedMemory = false> class PackedVector
 
     std::size_t num_elements = 0;
 
-    signed cursor = -1;
-
-    template <bool enabled = UseSharedMemory>
-    void replace_last_elem(typename std::enable_if<enabled, std::uint64_t>::type last_elem)
+    // Element at the given bit offset
+    std::uint64_t get(const std::size_t offset) const
     {
-        vec[cursor] = last_elem;
+        return read(offset / ELEMSIZE, offset % ELEMSIZE);
     }
 
-    template <bool enabled = UseSharedMemory>
-    void replace_last_elem(typename std::enable_if<!enabled, std::uint64_t>::type last_elem)
+    std::uint64_t read(const std::size_t word, const std::size_t shift) const
     {
-        vec.back() = last_elem;
+        BOOST_ASSERT(word + 1 < vec.size());
+        const std::uint64_t high = static_cast<std::uint64_t>(vec[word]) << shift;
+        const std::uint64_t low = (static_cast<std::uint64_t>(vec[word + 1]) >> 1) >>
+                                  (ELEMSIZE - 1 - shift);
+        return (high | low) >> (ELEMSIZE - BITSIZE);
     }
 
     template <bool enabled = UseSharedMemory>
-    void add_last_elem(typename std::enable_if<enabled, std::uint64_t>::type last_elem)
+    void grow(const std::size_t blocks, typename std::enable_if<enabled>::type * = nullptr)
     {
-        vec[cursor + 1] = last_elem;
-        cursor++;
+        // the shared memory block is sized with elements_to_blocks before it is filled
+        BOOST_ASSERT(blocks <= vec.size());
+        (void)blocks;
     }
 
     template <bool enabled = UseSharedMemory>
-    void add_last_elem(typename std::enable_if<!enabled, std::uint64_t>::type last_elem)
+    void grow(const std::size_t blocks, typename std::enable_if<!enabled>::type * = nullptr)
     {
-        vec.push_back(last_elem);
-    }
-
-    template <bool enabled = UseSharedMemory>
-    std::uint64_t vec_back(typename std::enable_if<enabled>::type * = nullptr)
-    {
-        return vec[cursor];
-    }
-
-    template <bool enabled = UseSharedMemory>
-    std::uint64_t vec_back(typename std::enable_if<!enabled>::type * = nullptr)
-    {
-        return vec.back();
+        if (vec.size() < blocks)
+        {
+            vec.resize(blocks, 0);
+        }
     }
 };
 }
@@ -0,0 +1,59 @@
+#ifndef PAGE_FAULT_COUNTER_HPP
+#define PAGE_FAULT_COUNTER_HPP
+
+#include <cstdint>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace osrm
+{
+namespace util
+{
+
+// Returns the number of major page faults (faults that had to read from disk) so far.
+// Counts the calling thread where the platform supports it, the whole process otherwise.
+// Returns 0 on platforms without getrusage.
+inline std::uint64_t getMajorPageFaults()
+{
+#if defined(__unix__) || defined(__APPLE__)
+#ifdef RUSAGE_THREAD
+    const int who = RUSAGE_THREAD;
+#else
+    const int who = RUSAGE_SELF;
+#endif
+    struct rusage usage;
+    if (::getrusage(who, &usage) == 0)
+    {
+        return static_cast<std::uint64_t>(usage.ru_majflt);
+    }
+#endif
+    return 0;
+}
+
+// Returns the largest resident set size of the process so far in bytes, or 0 on platforms
+// without getrusage.
+inline std::uint64_t getMaxResidentBytes()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#ifdef __APPLE__
+        return static_cast<std::uint64_t>(usage.ru_maxrss);
+#else
+        // kilobytes everywhere else
+        return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+#endif
+    return 0;
+}
+
+#define MAJOR_FAULTS_START(_X) const auto _X##_faults_start = osrm::util::getMajorPageFaults()
+#define MAJOR_FAULTS_COUNT(_X) (osrm::util::getMajorPageFaults() - _X##_faults_start)
+}
+}
+
+#endif // PAGE_FAULT_COUNTER_HPP
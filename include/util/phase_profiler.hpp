@@ -0,0 +1,235 @@
+#ifndef OSRM_UTIL_PHASE_PROFILER_HPP
+#define OSRM_UTIL_PHASE_PROFILER_HPP
+
+#include "util/exception.hpp"
+#include "util/json_writer.hpp"
+#include "util/page_fault_counter.hpp"
+
+#include <boost/assert.hpp>
+
+#include <stxxl/bits/mng/block_manager.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace osrm
+{
+namespace util
+{
+
+namespace detail
+{
+// Returns the value of the line "<key>: <value>" of a /proc file, or 0 if there is none
+inline std::uint64_t readProcValue(const char *path, const std::string &key)
+{
+    std::ifstream stream(path);
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        if (line.size() > key.size() && line.compare(0, key.size(), key) == 0 &&
+            line[key.size()] == ':')
+        {
+            return std::strtoull(line.c_str() + key.size() + 1, nullptr, 10);
+        }
+    }
+    return 0;
+}
+
+// Resets the peak resident set size of the process to its current size, which is only possible
+// on Linux. Returns false if it could not be reset.
+inline bool resetPeakResidentBytes()
+{
+#ifdef __linux__
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.close();
+    return !clear_refs.fail();
+#else
+    return false;
+#endif
+}
+
+// CPU time of all threads of the process so far, user and system time
+inline double getCPUSeconds()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+               (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    }
+#endif
+    return 0;
+}
+}
+
+// Measures the wall time, CPU time, peak memory, I/O and stxxl disk space of the phases of a
+// preprocessing run and writes them as JSON, to size the machines the preprocessing runs on.
+// Phases are measured one after another between Start and Stop, they can not be nested.
+//
+// The peak resident set size is the peak within the phase where the kernel allows resetting it
+// (Linux), the peak of the process up to the end of the phase otherwise. Bytes read and written
+// count all reads and writes of the process, including the ones served from the page cache,
+// and are only available on Linux. The stxxl disk space can not be reset, peak_disk_bytes is
+// the peak of the run up to the end of the phase.
+class PhaseProfiler
+{
+  public:
+    struct Phase
+    {
+        std::string name;
+        double wall_seconds;
+        double cpu_seconds;
+        std::uint64_t peak_resident_bytes;
+        std::uint64_t read_bytes;
+        std::uint64_t written_bytes;
+        std::uint64_t disk_bytes;
+        std::uint64_t peak_disk_bytes;
+    };
+
+    PhaseProfiler() : run_start(Sample()) {}
+
+    void Start(std::string name)
+    {
+        BOOST_ASSERT_MSG(!running, "phases can not be nested");
+        running = true;
+        peak_is_reset = detail::resetPeakResidentBytes();
+        phase_name = std::move(name);
+        phase_start = Sample();
+    }
+
+    void Stop()
+    {
+        BOOST_ASSERT(running);
+        running = false;
+        const auto end = Sample();
+
+        Phase phase;
+        phase.name = std::move(phase_name);
+        phase.wall_seconds = std::chrono::duration<double>(end.wall - phase_start.wall).count();
+        phase.cpu_seconds = end.cpu_seconds - phase_start.cpu_seconds;
+        phase.peak_resident_bytes = peak_is_reset ? end.peak_resident_bytes
+                                                  : util::getMaxResidentBytes();
+        phase.read_bytes = end.read_bytes - phase_start.read_bytes;
+        phase.written_bytes = end.written_bytes - phase_start.written_bytes;
+        phase.disk_bytes = end.disk_bytes;
+        phase.peak_disk_bytes = end.peak_disk_bytes;
+        phases.push_back(std::move(phase));
+    }
+
+    const std::vector<Phase> &GetPhases() const { return phases; }
+
+    // Writes the phases and the totals of the run so far as a JSON object
+    void Write(std::ostream &stream) const
+    {
+        const auto end = Sample();
+        // resetting the peak of a phase also resets the peak of the process
+        std::uint64_t peak_resident_bytes = util::getMaxResidentBytes();
+        for (const auto &phase : phases)
+        {
+            peak_resident_bytes = std::max(peak_resident_bytes, phase.peak_resident_bytes);
+        }
+
+        json::Writer writer;
+        writer.BeginObject();
+        writer.Key("phases");
+        writer.BeginArray();
+        for (const auto &phase : phases)
+        {
+            writer.BeginObject();
+            writer.Key("name");
+            writer.String(phase.name);
+            writer.Key("wall_seconds");
+            writer.Number(phase.wall_seconds);
+            writer.Key("cpu_seconds");
+            writer.Number(phase.cpu_seconds);
+            writer.Key("peak_resident_bytes");
+            writer.Number(phase.peak_resident_bytes);
+            writer.Key("read_bytes");
+            writer.Number(phase.read_bytes);
+            writer.Key("written_bytes");
+            writer.Number(phase.written_bytes);
+            writer.Key("disk_bytes");
+            writer.Number(phase.disk_bytes);
+            writer.Key("peak_disk_bytes");
+            writer.Number(phase.peak_disk_bytes);
+            writer.EndObject();
+        }
+        writer.EndArray();
+        writer.Key("total");
+        writer.BeginObject();
+        writer.Key("wall_seconds");
+        writer.Number(std::chrono::duration<double>(end.wall - run_start.wall).count());
+        writer.Key("cpu_seconds");
+        writer.Number(end.cpu_seconds - run_start.cpu_seconds);
+        writer.Key("peak_resident_bytes");
+        writer.Number(peak_resident_bytes);
+        writer.Key("read_bytes");
+        writer.Number(end.read_bytes - run_start.read_bytes);
+        writer.Key("written_bytes");
+        writer.Number(end.written_bytes - run_start.written_bytes);
+        writer.Key("peak_disk_bytes");
+        writer.Number(end.peak_disk_bytes);
+        writer.EndObject();
+        writer.EndObject();
+
+        const auto &buffer = writer.GetBuffer();
+        stream.write(buffer.data(), buffer.size());
+        stream << std::endl;
+    }
+
+    void Write(const std::string &path) const
+    {
+        std::ofstream stream(path);
+        if (!stream)
+        {
+            throw exception("Could not open " + path);
+        }
+        Write(stream);
+    }
+
+  private:
+    struct Sample
+    {
+        Sample()
+            : wall(std::chrono::steady_clock::now()), cpu_seconds(detail::getCPUSeconds()),
+              peak_resident_bytes(detail::readProcValue("/proc/self/status", "VmHWM") * 1024),
+              read_bytes(detail::readProcValue("/proc/self/io", "rchar")),
+              written_bytes(detail::readProcValue("/proc/self/io", "wchar"))
+        {
+            const auto *block_manager = stxxl::block_manager::get_instance();
+            disk_bytes = block_manager->get_current_allocation();
+            peak_disk_bytes = block_manager->get_maximum_allocation();
+        }
+
+        std::chrono::steady_clock::time_point wall;
+        double cpu_seconds;
+        std::uint64_t peak_resident_bytes;
+        std::uint64_t read_bytes;
+        std::uint64_t written_bytes;
+        std::uint64_t disk_bytes;
+        std::uint64_t peak_disk_bytes;
+    };
+
+    Sample run_start;
+    Sample phase_start;
+    std::vector<Phase> phases;
+    std::string phase_name;
+    bool running = false;
+    bool peak_is_reset = false;
+};
+}
+}
+
+#endif // OSRM_UTIL_PHASE_PROFILER_HPP
@@ -0,0 +1,29 @@
+#ifndef UTIL_PROBES_HPP
+#define UTIL_PROBES_HPP
+
+// Static probes at the phases of a query, for tracing the requests of a running osrm-routed
+// with perf, bpftrace or SystemTap. Builds with -DENABLE_PROBES=ON place them as USDT probes
+// of the provider osrm, a single nop each until a tracer attaches. Other builds compile them
+// away. The arguments are integers only:
+//
+//   query__start(type), query__done(type, status)       a query of the engine, by QueryType
+//   phase__done(type, phase, microseconds)              a phase of a plugin, by QueryPhase
+//   search__start(), search__done(weight)               a search of a leg, weight is the
+//                                                       upper bound if there is no path
+//   unpack__start(), unpack__done(path_size)            unpacking a packed path
+//   render__start(), render__done(bytes)                rendering a response of osrm-routed
+#ifdef OSRM_PROBES
+#include <sys/sdt.h>
+
+#define OSRM_PROBE(name) DTRACE_PROBE(osrm, name)
+#define OSRM_PROBE1(name, arg1) DTRACE_PROBE1(osrm, name, arg1)
+#define OSRM_PROBE2(name, arg1, arg2) DTRACE_PROBE2(osrm, name, arg1, arg2)
+#define OSRM_PROBE3(name, arg1, arg2, arg3) DTRACE_PROBE3(osrm, name, arg1, arg2, arg3)
+#else
+#define OSRM_PROBE(name)
+#define OSRM_PROBE1(name, arg1)
+#define OSRM_PROBE2(name, arg1, arg2)
+#define OSRM_PROBE3(name, arg1, arg2, arg3)
+#endif
+
+#endif // UTIL_PROBES_HPP
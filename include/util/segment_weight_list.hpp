@@ -0,0 +1,320 @@
+#ifndef OSRM_UTIL_SEGMENT_WEIGHT_LIST_HPP
+#define OSRM_UTIL_SEGMENT_WEIGHT_LIST_HPP
+
+#include "util/shared_memory_vector_wrapper.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace osrm
+{
+namespace util
+{
+
+// The weights of the segments of the geometries are stored in 16 bits each. Almost all segments
+// take less than 6553 seconds, the weights that do not fit are marked and stored in an overflow
+// table sorted by the index of their segment. Segments that cannot be traversed in a direction
+// have a code of their own, they are too frequent for the overflow table.
+const constexpr std::uint16_t SEGMENT_WEIGHT_INVALID = 0xffff;
+const constexpr std::uint16_t SEGMENT_WEIGHT_OVERFLOW = 0xfffe;
+
+struct SegmentWeightOverflow
+{
+    std::uint32_t index;
+    EdgeWeight weight;
+};
+
+namespace detail
+{
+inline EdgeWeight decodeSegmentWeight(const std::uint16_t *values,
+                                      const SegmentWeightOverflow *overflows_begin,
+                                      const SegmentWeightOverflow *overflows_end,
+                                      const std::size_t index)
+{
+    const auto value = values[index];
+    if (value < SEGMENT_WEIGHT_OVERFLOW)
+    {
+        return value;
+    }
+    if (value == SEGMENT_WEIGHT_INVALID)
+    {
+        return INVALID_EDGE_WEIGHT;
+    }
+    const auto overflow = std::lower_bound(
+        overflows_begin,
+        overflows_end,
+        index,
+        [](const SegmentWeightOverflow &entry, const std::size_t index) {
+            return entry.index < index;
+        });
+    BOOST_ASSERT(overflow != overflows_end && overflow->index == index);
+    return overflow->weight;
+}
+}
+
+// Writes the packed weights and the overflow table of weights given in the order of their
+// segments. Without buffers it only counts the overflows, so that the table can be sized with a
+// first pass over the weights.
+class SegmentWeightEncoder
+{
+  public:
+    SegmentWeightEncoder() = default;
+    SegmentWeightEncoder(std::uint16_t *values_, SegmentWeightOverflow *overflows_)
+        : values(values_), overflows(overflows_)
+    {
+    }
+
+    void push_back(const EdgeWeight weight)
+    {
+        std::uint16_t value;
+        if (weight == INVALID_EDGE_WEIGHT)
+        {
+            value = SEGMENT_WEIGHT_INVALID;
+        }
+        else if (weight >= 0 && weight < SEGMENT_WEIGHT_OVERFLOW)
+        {
+            value = static_cast<std::uint16_t>(weight);
+        }
+        else
+        {
+            value = SEGMENT_WEIGHT_OVERFLOW;
+            if (overflows)
+            {
+                overflows[number_of_overflows] =
+                    SegmentWeightOverflow{static_cast<std::uint32_t>(number_of_weights), weight};
+            }
+            ++number_of_overflows;
+        }
+        if (values)
+        {
+            values[number_of_weights] = value;
+        }
+        ++number_of_weights;
+    }
+
+    std::uint64_t GetNumberOfWeights() const { return number_of_weights; }
+    std::uint64_t GetNumberOfOverflows() const { return number_of_overflows; }
+
+  private:
+    std::uint16_t *values = nullptr;
+    SegmentWeightOverflow *overflows = nullptr;
+    std::uint64_t number_of_weights = 0;
+    std::uint64_t number_of_overflows = 0;
+};
+
+// Read only view of the weights of a geometry that traverses them either forwards or backwards,
+// like util::ArrayView but decoding the weights when they are read
+class SegmentWeightView
+{
+  public:
+    class Iterator final : public boost::iterator_facade<Iterator,
+                                                         EdgeWeight,
+                                                         boost::random_access_traversal_tag,
+                                                         EdgeWeight>
+    {
+      public:
+        Iterator() : view(nullptr), index(0) {}
+        Iterator(const SegmentWeightView *view, const std::ptrdiff_t index)
+            : view(view), index(index)
+        {
+        }
+
+      private:
+        friend class boost::iterator_core_access;
+
+        EdgeWeight dereference() const { return (*view)[index]; }
+        bool equal(const Iterator &other) const { return index == other.index; }
+        void increment() { ++index; }
+        void decrement() { --index; }
+        void advance(const std::ptrdiff_t offset) { index += offset; }
+        std::ptrdiff_t distance_to(const Iterator &other) const { return other.index - index; }
+
+        const SegmentWeightView *view;
+        std::ptrdiff_t index;
+    };
+
+    SegmentWeightView() = default;
+
+    // views the weights [first, last) of the list, from last - 1 down to first if reversed
+    SegmentWeightView(const std::uint16_t *values,
+                      const SegmentWeightOverflow *overflows_begin,
+                      const SegmentWeightOverflow *overflows_end,
+                      const std::size_t first,
+                      const std::size_t last,
+                      const bool reversed = false)
+        : values(values), overflows_begin(overflows_begin), overflows_end(overflows_end),
+          base(reversed && first != last ? static_cast<std::ptrdiff_t>(last) - 1
+                                         : static_cast<std::ptrdiff_t>(first)),
+          step(reversed ? -1 : 1), length(last - first)
+    {
+        BOOST_ASSERT(first <= last);
+    }
+
+    std::size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+
+    EdgeWeight operator[](const std::size_t index) const
+    {
+        BOOST_ASSERT(index < length);
+        return detail::decodeSegmentWeight(
+            values,
+            overflows_begin,
+            overflows_end,
+            static_cast<std::size_t>(base + static_cast<std::ptrdiff_t>(index) * step));
+    }
+    EdgeWeight front() const { return (*this)[0]; }
+    EdgeWeight back() const { return (*this)[length - 1]; }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, static_cast<std::ptrdiff_t>(length)); }
+
+    // Writes all weights of the view to `out`, looking up the overflow table once instead of for
+    // every weight that overflows
+    template <typename OutputIter> OutputIter decode(OutputIter out) const
+    {
+        if (length == 0)
+        {
+            return out;
+        }
+        const auto lowest = static_cast<std::size_t>(
+            step > 0 ? base : base - static_cast<std::ptrdiff_t>(length) + 1);
+        const auto first_overflow = std::lower_bound(
+            overflows_begin,
+            overflows_end,
+            lowest,
+            [](const SegmentWeightOverflow &entry, const std::size_t index) {
+                return entry.index < index;
+            });
+        // the overflows of the view are consecutive in the table, a reversed view reads them
+        // from the back
+        auto forward_overflow = first_overflow;
+        auto backward_overflow = std::lower_bound(
+            first_overflow,
+            overflows_end,
+            lowest + length,
+            [](const SegmentWeightOverflow &entry, const std::size_t index) {
+                return entry.index < index;
+            });
+
+        for (std::size_t index = 0; index < length; ++index)
+        {
+            const auto value = values[base + static_cast<std::ptrdiff_t>(index) * step];
+            if (value < SEGMENT_WEIGHT_OVERFLOW)
+            {
+                *out++ = value;
+            }
+            else if (value == SEGMENT_WEIGHT_INVALID)
+            {
+                *out++ = INVALID_EDGE_WEIGHT;
+            }
+            else if (step > 0)
+            {
+                BOOST_ASSERT(forward_overflow != overflows_end);
+                *out++ = (forward_overflow++)->weight;
+            }
+            else
+            {
+                BOOST_ASSERT(backward_overflow != first_overflow);
+                *out++ = (--backward_overflow)->weight;
+            }
+        }
+        return out;
+    }
+
+  private:
+    const std::uint16_t *values = nullptr;
+    const SegmentWeightOverflow *overflows_begin = nullptr;
+    const SegmentWeightOverflow *overflows_end = nullptr;
+    std::ptrdiff_t base = 0;
+    std::ptrdiff_t step = 1;
+    std::size_t length = 0;
+};
+
+// Replaces the weights of the segments of all geometries by their offsets in their geometry, so
+// that a phantom node needs no sum over the segments before it. The geometries are given by the
+// consecutive indices like the geometry index of the dataset. Afterwards forward[i] is the sum of
+// the forward weights of the geometry up to its node i, as the forward weight of segment k is
+// stored at the index of its second node. reverse[i] is the sum of the reverse weights from node i
+// to the end of the geometry, as the reverse weight of segment k is stored at its first node.
+inline void toSegmentWeightOffsets(const unsigned *indices_begin,
+                                   const unsigned *indices_end,
+                                   EdgeWeight *forward,
+                                   EdgeWeight *reverse)
+{
+    for (auto index = indices_begin; index != indices_end && index + 1 != indices_end; ++index)
+    {
+        const auto first = index[0];
+        const auto last = index[1];
+        if (first == last)
+        {
+            continue;
+        }
+
+        EdgeWeight forward_offset = 0;
+        for (auto node = first; node + 1 < last; ++node)
+        {
+            const auto weight = forward[node + 1];
+            forward[node] = forward_offset;
+            forward_offset += weight;
+        }
+        forward[last - 1] = forward_offset;
+
+        EdgeWeight reverse_offset = 0;
+        reverse[last - 1] = reverse_offset;
+        for (auto node = last - 1; node > first; --node)
+        {
+            reverse_offset += reverse[node - 1];
+            reverse[node - 1] = reverse_offset;
+        }
+    }
+}
+
+// Packed weights of the segments of all geometries with their overflow table
+template <bool UseSharedMemory> class SegmentWeightList
+{
+  public:
+    SegmentWeightList() = default;
+
+    SegmentWeightList(typename ShM<std::uint16_t, UseSharedMemory>::vector &values_,
+                      typename ShM<SegmentWeightOverflow, UseSharedMemory>::vector &overflows_)
+    {
+        using std::swap;
+        swap(values, values_);
+        swap(overflows, overflows_);
+    }
+
+    std::size_t size() const { return values.size(); }
+
+    EdgeWeight operator[](const std::size_t index) const
+    {
+        BOOST_ASSERT(index < values.size());
+        return detail::decodeSegmentWeight(
+            values.data(), overflows.data(), overflows.data() + overflows.size(), index);
+    }
+
+    SegmentWeightView
+    GetView(const std::size_t first, const std::size_t last, const bool reversed = false) const
+    {
+        BOOST_ASSERT(last <= values.size());
+        return SegmentWeightView(values.data(),
+                                 overflows.data(),
+                                 overflows.data() + overflows.size(),
+                                 first,
+                                 last,
+                                 reversed);
+    }
+
+  private:
+    typename ShM<std::uint16_t, UseSharedMemory>::vector values;
+    typename ShM<SegmentWeightOverflow, UseSharedMemory>::vector overflows;
+};
+}
+}
+
+#endif // OSRM_UTIL_SEGMENT_WEIGHT_LIST_HPP
@@ -111,6 +111,8 @@ template <typename DataT> class SharedMemoryWrapper
 
     bool empty() const { return 0 == size(); }
 
+    DataT *data() const { return m_ptr; }
+
     DataT &operator[](const unsigned index)
     {
         BOOST_ASSERT_MSG(index < m_size, "invalid size");
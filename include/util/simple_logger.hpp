@@ -26,14 +26,22 @@ class LogPolicy
 
     bool IsMute() const;
 
+    // Hands the lines to a writer thread instead of writing them on the thread that logs, for
+    // servers whose threads would otherwise serialize on the output. Lines are written within
+    // milliseconds and all of them before the process exits normally.
+    void EnableAsyncOutput();
+
+    bool IsAsync() const;
+
     static LogPolicy &GetInstance();
 
     LogPolicy(const LogPolicy &) = delete;
     LogPolicy &operator=(const LogPolicy &) = delete;
 
   private:
-    LogPolicy() : m_is_mute(true) {}
+    LogPolicy() : m_is_mute(true), m_is_async(false) {}
     std::atomic<bool> m_is_mute;
+    std::atomic<bool> m_is_async;
 };
 
 class SimpleLogger
@@ -42,12 +50,13 @@ class SimpleLogger
     SimpleLogger();
 
     virtual ~SimpleLogger();
-    std::mutex &get_mutex();
+    // Lines of levels that are not logged are neither formatted nor written
     std::ostringstream &Write(LogLevel l = logINFO) noexcept;
 
   private:
     std::ostringstream os;
     LogLevel level;
+    bool enabled;
 };
 }
 }
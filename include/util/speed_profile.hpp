@@ -0,0 +1,55 @@
+#ifndef OSRM_UTIL_SPEED_PROFILE_HPP
+#define OSRM_UTIL_SPEED_PROFILE_HPP
+
+#include "util/typedefs.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+
+namespace osrm
+{
+namespace util
+{
+
+// A speed profile holds the speed of a road segment for every quarter hour of a day (UTC) in
+// percent of the speed its static weight was computed from, so that the static duration of the
+// segment divided by the factor of a slot is its duration at that time of day. Profiles are
+// shared by all segments with the same factors.
+const constexpr std::size_t SPEED_PROFILE_SLOTS = 96;
+const constexpr std::uint32_t SPEED_PROFILE_SLOT_LENGTH = 24 * 60 * 60 / SPEED_PROFILE_SLOTS;
+// the factor of segments without a profile
+const constexpr std::uint8_t SPEED_PROFILE_STATIC_FACTOR = 100;
+
+// Assigns a profile to the direction of the road segment from one node based node to the next
+struct SpeedProfileSegment
+{
+    NodeID from;
+    NodeID to;
+    // index of the first factor of the profile
+    std::uint32_t offset;
+
+    bool operator<(const SpeedProfileSegment &other) const
+    {
+        return std::tie(from, to) < std::tie(other.from, other.to);
+    }
+};
+
+// Slot of a UNIX timestamp in seconds
+inline std::size_t getSpeedProfileSlot(const std::uint64_t time)
+{
+    return (time % (24 * 60 * 60)) / SPEED_PROFILE_SLOT_LENGTH;
+}
+
+// Duration at the given factor of a static duration, rounded down so that the durations keep
+// their order
+inline EdgeWeight applySpeedProfileFactor(const EdgeWeight duration, const std::uint8_t factor)
+{
+    BOOST_ASSERT(factor > 0);
+    return static_cast<EdgeWeight>(static_cast<std::int64_t>(duration) *
+                                   SPEED_PROFILE_STATIC_FACTOR / factor);
+}
+}
+}
+
+#endif // OSRM_UTIL_SPEED_PROFILE_HPP
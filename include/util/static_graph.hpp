@@ -116,6 +116,19 @@ template <typename EdgeDataT, bool UseSharedMemory = false> class StaticGraph
 
     unsigned GetOutDegree(const NodeIterator n) const { return EndEdges(n) - BeginEdges(n); }
 
+    unsigned GetDirectedOutDegree(const NodeIterator n) const
+    {
+        unsigned degree = 0;
+        for (const auto edge : irange(BeginEdges(n), EndEdges(n)))
+        {
+            if (!GetEdgeData(edge).reversed)
+            {
+                ++degree;
+            }
+        }
+        return degree;
+    }
+
     inline NodeIterator GetTarget(const EdgeIterator e) const
     {
         return NodeIterator(edge_array[e].target);
@@ -21,13 +21,21 @@
 #include <boost/format.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_sort.h>
 
 #include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 #include <memory>
+#include <numeric>
 #include <queue>
 #include <string>
 #include <vector>
@@ -62,10 +70,20 @@ class StaticRTree
     using EdgeData = EdgeDataT;
     using CoordinateList = CoordinateListT;
 
-    static_assert(LEAF_PAGE_SIZE >= sizeof(uint32_t) + sizeof(EdgeDataT), "page size is too small");
+    // Directions of the usable segments in a subtree, bit i is set if a segment can be used in a
+    // direction with a rounded bearing in [i * 360 / BEARING_CLASS_COUNT, (i+1) * 360 / ...).
+    using BearingClasses = std::uint32_t;
+    static constexpr std::uint32_t BEARING_CLASS_COUNT = 32;
+    static constexpr BearingClasses ALL_BEARING_CLASSES = ~BearingClasses{0};
+
+    static_assert(LEAF_PAGE_SIZE >=
+                      sizeof(uint32_t) + sizeof(BearingClasses) + sizeof(Rectangle) +
+                          sizeof(EdgeDataT),
+                  "page size is too small");
     static_assert(((LEAF_PAGE_SIZE - 1) & LEAF_PAGE_SIZE) == 0, "page size is not a power of 2");
     static constexpr std::uint32_t LEAF_NODE_SIZE =
-        (LEAF_PAGE_SIZE - sizeof(uint32_t) - sizeof(Rectangle)) / sizeof(EdgeDataT);
+        (LEAF_PAGE_SIZE - sizeof(uint32_t) - sizeof(BearingClasses) - sizeof(Rectangle)) /
+        sizeof(EdgeDataT);
 
     struct CandidateSegment
     {
@@ -83,16 +101,18 @@ class StaticRTree
 
     struct TreeNode
     {
-        TreeNode() : child_count(0) {}
+        TreeNode() : child_count(0), bearing_classes(0) {}
         std::uint32_t child_count;
+        BearingClasses bearing_classes;
         Rectangle minimum_bounding_rectangle;
         TreeIndex children[BRANCHING_FACTOR];
     };
 
     struct ALIGNED(LEAF_PAGE_SIZE) LeafNode
     {
-        LeafNode() : object_count(0), objects() {}
+        LeafNode() : object_count(0), bearing_classes(0), objects() {}
         std::uint32_t object_count;
+        BearingClasses bearing_classes;
         Rectangle minimum_bounding_rectangle;
         std::array<EdgeDataT, LEAF_NODE_SIZE> objects;
     };
@@ -152,9 +172,31 @@ class StaticRTree
         Coordinate fixed_projected_coordinate;
     };
 
+    // Child bounding box stored as 16 bit offsets relative to the box of its parent. Bounds are
+    // rounded outwards, so the decoded box always contains the exact one.
+    struct QuantizedRectangle
+    {
+        std::uint16_t min_lon;
+        std::uint16_t max_lon;
+        std::uint16_t min_lat;
+        std::uint16_t max_lat;
+    };
+    static constexpr std::uint64_t QUANTIZATION_STEPS = std::numeric_limits<std::uint16_t>::max();
+
+    // leaves packed in parallel before they are written to the leaf file during construction
+    static constexpr std::uint64_t LEAF_WRITE_BUFFER_SIZE = 32 * 1024 * 1024;
+
     typename ShM<TreeNode, UseSharedMemory>::vector m_search_tree;
     const CoordinateListT &m_coordinate_list;
 
+    // Quantized child boxes of the upper tree levels, BRANCHING_FACTOR entries per tree node.
+    // These are the nodes with tree nodes as children, which come first in m_search_tree.
+    // Exploring a node only touches its own entries instead of the header of every child.
+    std::vector<QuantizedRectangle> m_quantized_children;
+    // bearing classes of the same children
+    std::vector<BearingClasses> m_quantized_children_bearing_classes;
+    std::uint32_t m_quantized_node_count = 0;
+
     boost::iostreams::mapped_file_source m_leaves_region;
     // read-only view of leaves
     typename ShM<const LeafNode, true>::vector m_leaves;
@@ -202,133 +244,112 @@ class StaticRTree
                 }
             });
 
-        // open leaf file
-        boost::filesystem::ofstream leaf_node_file(leaf_node_filename, std::ios::binary);
-
         // sort the hilbert-value representatives
         tbb::parallel_sort(input_wrapper_vector.begin(), input_wrapper_vector.end());
-        std::vector<TreeNode> tree_nodes_in_level;
 
-        // pack M elements into leaf node, write to leaf file and add child index to the parent node
-        uint64_t wrapped_element_index = 0;
-        for (std::uint32_t node_index = 0; wrapped_element_index < element_count; ++node_index)
-        {
-            TreeNode current_node;
-            for (std::uint32_t leaf_index = 0;
-                 leaf_index < BRANCHING_FACTOR && wrapped_element_index < element_count;
-                 ++leaf_index)
-            {
-                LeafNode current_leaf;
-                Rectangle &rectangle = current_leaf.minimum_bounding_rectangle;
-                for (std::uint32_t object_index = 0;
-                     object_index < LEAF_NODE_SIZE && wrapped_element_index < element_count;
-                     ++object_index, ++wrapped_element_index)
-                {
-                    const std::uint32_t input_object_index =
-                        input_wrapper_vector[wrapped_element_index].m_array_index;
-                    const EdgeDataT &object = input_data_vector[input_object_index];
-
-                    current_leaf.object_count += 1;
-                    current_leaf.objects[object_index] = object;
-
-                    Coordinate projected_u{
-                        web_mercator::fromWGS84(Coordinate{m_coordinate_list[object.u]})};
-                    Coordinate projected_v{
-                        web_mercator::fromWGS84(Coordinate{m_coordinate_list[object.v]})};
-
-                    BOOST_ASSERT(std::abs(toFloating(projected_u.lon).operator double()) <= 180.);
-                    BOOST_ASSERT(std::abs(toFloating(projected_u.lat).operator double()) <= 180.);
-                    BOOST_ASSERT(std::abs(toFloating(projected_v.lon).operator double()) <= 180.);
-                    BOOST_ASSERT(std::abs(toFloating(projected_v.lat).operator double()) <= 180.);
-
-                    rectangle.min_lon =
-                        std::min(rectangle.min_lon, std::min(projected_u.lon, projected_v.lon));
-                    rectangle.max_lon =
-                        std::max(rectangle.max_lon, std::max(projected_u.lon, projected_v.lon));
-
-                    rectangle.min_lat =
-                        std::min(rectangle.min_lat, std::min(projected_u.lat, projected_v.lat));
-                    rectangle.max_lat =
-                        std::max(rectangle.max_lat, std::max(projected_u.lat, projected_v.lat));
-
-                    BOOST_ASSERT(rectangle.IsValid());
-                }
-
-                // append the leaf node to the current tree node
-                current_node.child_count += 1;
-                current_node.children[leaf_index] =
-                    TreeIndex{node_index * BRANCHING_FACTOR + leaf_index, true};
-                current_node.minimum_bounding_rectangle.MergeBoundingBoxes(
-                    current_leaf.minimum_bounding_rectangle);
+        const std::uint64_t leaf_count = (element_count + LEAF_NODE_SIZE - 1) / LEAF_NODE_SIZE;
+        BOOST_ASSERT_MSG(0 < leaf_count, "tree empty");
 
-                // write leaf_node to leaf node file
-                leaf_node_file.write((char *)&current_leaf, sizeof(current_leaf));
-            }
-
-            tree_nodes_in_level.emplace_back(current_node);
+        // number of tree nodes per level, from the parents of the leaves up to the root
+        std::vector<std::uint64_t> level_sizes(1, (leaf_count + BRANCHING_FACTOR - 1) /
+                                                      BRANCHING_FACTOR);
+        while (1 < level_sizes.back())
+        {
+            level_sizes.push_back((level_sizes.back() + BRANCHING_FACTOR - 1) / BRANCHING_FACTOR);
         }
-        leaf_node_file.flush();
-        leaf_node_file.close();
-
-        std::uint32_t processing_level = 0;
-        while (1 < tree_nodes_in_level.size())
+        std::vector<std::uint64_t> level_offsets(level_sizes.size() + 1, 0);
+        std::partial_sum(level_sizes.begin(), level_sizes.end(), level_offsets.begin() + 1);
+        const std::uint64_t search_tree_size = level_offsets.back();
+
+        // The levels are stored from the root down with the nodes of each level in reverse
+        // order, so the root is at index 0 and the parents of the leaves come last.
+        const auto tree_position = [&](const std::size_t level, const std::uint64_t index) {
+            return search_tree_size - 1 - (level_offsets[level] + index);
+        };
+        m_search_tree.resize(search_tree_size);
+
+        // Pack the leaves and their parents in parallel batches, each batch of leaves is written
+        // to the leaf file before the next one is packed.
+        boost::filesystem::ofstream leaf_node_file(leaf_node_filename, std::ios::binary);
+        const std::uint64_t parents_per_batch = std::max<std::uint64_t>(
+            1, LEAF_WRITE_BUFFER_SIZE / (BRANCHING_FACTOR * sizeof(LeafNode)));
+        std::vector<char> leaf_buffer(parents_per_batch * BRANCHING_FACTOR * sizeof(LeafNode));
+        for (std::uint64_t first_parent = 0; first_parent < level_sizes.front();
+             first_parent += parents_per_batch)
         {
-            std::vector<TreeNode> tree_nodes_in_next_level;
-            std::uint32_t processed_tree_nodes_in_level = 0;
-            while (processed_tree_nodes_in_level < tree_nodes_in_level.size())
-            {
-                TreeNode parent_node;
-                // pack BRANCHING_FACTOR elements into tree_nodes each
-                for (std::uint32_t current_child_node_index = 0;
-                     current_child_node_index < BRANCHING_FACTOR;
-                     ++current_child_node_index)
-                {
-                    if (processed_tree_nodes_in_level < tree_nodes_in_level.size())
+            const std::uint64_t last_parent =
+                std::min(first_parent + parents_per_batch, level_sizes.front());
+            const std::uint64_t first_leaf = first_parent * BRANCHING_FACTOR;
+            const std::uint64_t last_leaf = std::min(last_parent * BRANCHING_FACTOR, leaf_count);
+
+            tbb::parallel_for(
+                tbb::blocked_range<std::uint64_t>(first_parent, last_parent, 1),
+                [&](const tbb::blocked_range<std::uint64_t> &range) {
+                    for (auto parent_index = range.begin(); parent_index != range.end();
+                         ++parent_index)
                     {
-                        TreeNode &current_child_node =
-                            tree_nodes_in_level[processed_tree_nodes_in_level];
-                        // add tree node to parent entry
-                        parent_node.children[current_child_node_index] =
-                            TreeIndex{m_search_tree.size(), false};
-                        m_search_tree.emplace_back(current_child_node);
-                        // merge MBRs
-                        parent_node.minimum_bounding_rectangle.MergeBoundingBoxes(
-                            current_child_node.minimum_bounding_rectangle);
-                        // increase counters
-                        ++parent_node.child_count;
-                        ++processed_tree_nodes_in_level;
+                        TreeNode &parent_node = m_search_tree[tree_position(0, parent_index)];
+                        for (std::uint32_t leaf_index = 0; leaf_index < BRANCHING_FACTOR;
+                             ++leaf_index)
+                        {
+                            const std::uint64_t leaf_id =
+                                parent_index * BRANCHING_FACTOR + leaf_index;
+                            if (leaf_id >= leaf_count)
+                                break;
+
+                            const LeafNode current_leaf =
+                                PackLeaf(input_data_vector, input_wrapper_vector, leaf_id);
+
+                            parent_node.child_count += 1;
+                            parent_node.children[leaf_index] = TreeIndex{leaf_id, true};
+                            parent_node.minimum_bounding_rectangle.MergeBoundingBoxes(
+                                current_leaf.minimum_bounding_rectangle);
+                            parent_node.bearing_classes |= current_leaf.bearing_classes;
+
+                            std::memcpy(&leaf_buffer[(leaf_id - first_leaf) * sizeof(LeafNode)],
+                                        &current_leaf,
+                                        sizeof(LeafNode));
+                        }
                     }
-                }
-                tree_nodes_in_next_level.emplace_back(parent_node);
-            }
-            tree_nodes_in_level.swap(tree_nodes_in_next_level);
-            ++processing_level;
+                });
+
+            leaf_node_file.write(leaf_buffer.data(), (last_leaf - first_leaf) * sizeof(LeafNode));
         }
-        BOOST_ASSERT_MSG(tree_nodes_in_level.size() == 1, "tree broken, more than one root node");
-        // last remaining entry is the root node, store it
-        m_search_tree.emplace_back(tree_nodes_in_level[0]);
+        leaf_node_file.flush();
+        leaf_node_file.close();
 
-        // reverse and renumber tree to have root at index 0
-        std::reverse(m_search_tree.begin(), m_search_tree.end());
+        std::vector<char>().swap(leaf_buffer);
+        std::vector<WrappedInputElement>().swap(input_wrapper_vector);
 
-        std::uint32_t search_tree_size = m_search_tree.size();
-        tbb::parallel_for(
-            tbb::blocked_range<std::uint32_t>(0, search_tree_size),
-            [this, &search_tree_size](const tbb::blocked_range<std::uint32_t> &range) {
-                for (std::uint32_t i = range.begin(), end = range.end(); i != end; ++i)
-                {
-                    TreeNode &current_tree_node = this->m_search_tree[i];
-                    for (std::uint32_t j = 0; j < current_tree_node.child_count; ++j)
+        // every parent packs BRANCHING_FACTOR consecutive nodes of the level below
+        for (std::size_t level = 1; level < level_sizes.size(); ++level)
+        {
+            tbb::parallel_for(
+                tbb::blocked_range<std::uint64_t>(0, level_sizes[level]),
+                [&](const tbb::blocked_range<std::uint64_t> &range) {
+                    for (auto parent_index = range.begin(); parent_index != range.end();
+                         ++parent_index)
                     {
-                        if (!current_tree_node.children[j].is_leaf)
+                        TreeNode &parent_node = m_search_tree[tree_position(level, parent_index)];
+                        for (std::uint32_t child_index = 0; child_index < BRANCHING_FACTOR;
+                             ++child_index)
                         {
-                            const std::uint32_t old_id = current_tree_node.children[j].index;
-                            const std::uint32_t new_id = search_tree_size - old_id - 1;
-                            current_tree_node.children[j].index = new_id;
+                            const std::uint64_t child_id =
+                                parent_index * BRANCHING_FACTOR + child_index;
+                            if (child_id >= level_sizes[level - 1])
+                                break;
+
+                            const auto child_position = tree_position(level - 1, child_id);
+                            parent_node.child_count += 1;
+                            parent_node.children[child_index] = TreeIndex{child_position, false};
+                            parent_node.minimum_bounding_rectangle.MergeBoundingBoxes(
+                                m_search_tree[child_position].minimum_bounding_rectangle);
+                            parent_node.bearing_classes |=
+                                m_search_tree[child_position].bearing_classes;
                         }
                     }
-                }
-            });
+                });
+        }
 
         // open tree file
         boost::filesystem::ofstream tree_node_file(tree_node_filename, std::ios::binary);
@@ -338,6 +359,7 @@ class StaticRTree
         tree_node_file.write((char *)&size_of_tree, sizeof(size_of_tree));
         tree_node_file.write((char *)&m_search_tree[0], sizeof(TreeNode) * size_of_tree);
 
+        QuantizeUpperLevels();
         MapLeafNodesFile(leaf_node_filename);
     }
 
@@ -362,6 +384,7 @@ class StaticRTree
         m_search_tree.resize(tree_size);
         storage::io::readRamIndex(tree_node_file, &m_search_tree[0], tree_size);
 
+        QuantizeUpperLevels();
         MapLeafNodesFile(leaf_file);
     }
 
@@ -371,6 +394,7 @@ class StaticRTree
                          const CoordinateListT &coordinate_list)
         : m_search_tree(tree_node_ptr, number_of_nodes), m_coordinate_list(coordinate_list)
     {
+        QuantizeUpperLevels();
         MapLeafNodesFile(leaf_file);
     }
 
@@ -390,6 +414,24 @@ class StaticRTree
         }
     }
 
+    // Asks the operating system to read the whole leaf file ahead of time, so first queries do
+    // not stall on page faults. The read-ahead happens asynchronously in the kernel.
+    void PrefetchLeafNodes() const
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        if (m_leaves_region.size() == 0)
+        {
+            return;
+        }
+        // mapped regions are always page-aligned
+        void *leaves_begin = const_cast<char *>(m_leaves_region.data());
+        if (::posix_madvise(leaves_begin, m_leaves_region.size(), POSIX_MADV_WILLNEED) != 0)
+        {
+            throw exception("Prefetching the leaf nodes of the r-tree failed");
+        }
+#endif
+    }
+
     /* Returns all features inside the bounding box.
        Rectangle needs to be projected!*/
     std::vector<EdgeDataT> SearchInBox(const Rectangle &search_rectangle) const
@@ -446,9 +488,7 @@ class StaticRTree
                 for (std::uint32_t i = 0; i < current_tree_node.child_count; ++i)
                 {
                     const TreeIndex child_id = current_tree_node.children[i];
-                    const auto &child_rectangle =
-                        child_id.is_leaf ? m_leaves[child_id.index].minimum_bounding_rectangle
-                                         : m_search_tree[child_id.index].minimum_bounding_rectangle;
+                    const auto child_rectangle = GetChildRectangle(current_tree_index, i);
 
                     if (child_rectangle.Intersects(projected_rectangle))
                     {
@@ -476,13 +516,113 @@ class StaticRTree
     std::vector<EdgeDataT> Nearest(const Coordinate input_coordinate,
                                    const FilterT filter,
                                    const TerminationT terminate) const
+    {
+        TraversalQueue traversal_queue;
+        return Nearest(
+            input_coordinate, ALL_BEARING_CLASSES, filter, terminate, traversal_queue);
+    }
+
+    // Variant of Nearest that skips subtrees without segments in the given bearing classes.
+    // The filter still has to check the bearings, the classes only rule out whole leaves.
+    template <typename FilterT, typename TerminationT>
+    std::vector<EdgeDataT> Nearest(const Coordinate input_coordinate,
+                                   const BearingClasses bearing_classes,
+                                   const FilterT filter,
+                                   const TerminationT terminate) const
+    {
+        TraversalQueue traversal_queue;
+        return Nearest(input_coordinate, bearing_classes, filter, terminate, traversal_queue);
+    }
+
+    // Bearing classes of all directions that util::bearing::CheckInBounds accepts
+    static BearingClasses GetBearingClasses(const int filter_bearing,
+                                            const int filter_bearing_range)
+    {
+        BearingClasses bearing_classes = 0;
+        for (int value = 0; value < 360; ++value)
+        {
+            if (bearing::CheckInBounds(value, filter_bearing, filter_bearing_range))
+            {
+                bearing_classes |= GetBearingClass(value);
+            }
+        }
+        return bearing_classes;
+    }
+
+    // Batched variant of Nearest: the queries are answered in the Hilbert order of their
+    // coordinates, so consecutive queries mostly visit the same tree nodes and leaf pages
+    // while these are still cached. All queries share the storage of one traversal queue.
+    // Filter and terminator additionally get the index of the query as first argument.
+    // The results are returned in the order of the input coordinates.
+    template <typename FilterT, typename TerminationT>
+    std::vector<std::vector<EdgeDataT>> Nearest(const std::vector<Coordinate> &input_coordinates,
+                                                const FilterT filter,
+                                                const TerminationT terminate) const
+    {
+        std::vector<WrappedInputElement> query_order;
+        query_order.reserve(input_coordinates.size());
+        for (const auto index : irange<std::size_t>(0UL, input_coordinates.size()))
+        {
+            const Coordinate projected_coordinate{
+                web_mercator::fromWGS84(input_coordinates[index])};
+            query_order.emplace_back(hilbertCode(projected_coordinate),
+                                     static_cast<std::uint32_t>(index));
+        }
+        std::sort(query_order.begin(), query_order.end());
+
+        std::vector<std::vector<EdgeDataT>> results(input_coordinates.size());
+        TraversalQueue traversal_queue;
+        for (const auto &query : query_order)
+        {
+            const auto index = query.m_array_index;
+            traversal_queue.clear();
+            results[index] = Nearest(
+                input_coordinates[index],
+                ALL_BEARING_CLASSES,
+                [&filter, index](const CandidateSegment &candidate) {
+                    return filter(index, candidate);
+                },
+                [&terminate, index](const std::size_t num_results,
+                                    const CandidateSegment &candidate) {
+                    return terminate(index, num_results, candidate);
+                },
+                traversal_queue);
+        }
+
+        return results;
+    }
+
+    std::vector<std::vector<EdgeDataT>> Nearest(const std::vector<Coordinate> &input_coordinates,
+                                                const std::size_t max_results) const
+    {
+        return Nearest(
+            input_coordinates,
+            [](const std::size_t, const CandidateSegment &) { return std::make_pair(true, true); },
+            [max_results](const std::size_t,
+                          const std::size_t num_results,
+                          const CandidateSegment &) { return num_results >= max_results; });
+    }
+
+  private:
+    // std::priority_queue that can be emptied without giving up its storage
+    struct TraversalQueue : std::priority_queue<QueryCandidate>
+    {
+        void clear() { this->c.clear(); }
+    };
+
+    template <typename FilterT, typename TerminationT>
+    std::vector<EdgeDataT> Nearest(const Coordinate input_coordinate,
+                                   const BearingClasses bearing_classes,
+                                   const FilterT filter,
+                                   const TerminationT terminate,
+                                   TraversalQueue &traversal_queue) const
     {
         std::vector<EdgeDataT> results;
         auto projected_coordinate = web_mercator::fromWGS84(input_coordinate);
         Coordinate fixed_projected_coordinate{projected_coordinate};
 
         // initialize queue with root element
-        std::priority_queue<QueryCandidate> traversal_queue;
+        BOOST_ASSERT(traversal_queue.empty());
         traversal_queue.push(QueryCandidate{0, TreeIndex{}});
 
         while (!traversal_queue.empty())
@@ -502,8 +642,10 @@ class StaticRTree
                 }
                 else
                 {
-                    ExploreTreeNode(
-                        current_tree_index, fixed_projected_coordinate, traversal_queue);
+                    ExploreTreeNode(current_tree_index,
+                                    fixed_projected_coordinate,
+                                    bearing_classes,
+                                    traversal_queue);
                 }
             }
             else
@@ -537,7 +679,6 @@ class StaticRTree
         return results;
     }
 
-  private:
     template <typename QueueT>
     void ExploreLeafNode(const TreeIndex &leaf_id,
                          const Coordinate &projected_input_coordinate_fixed,
@@ -545,45 +686,277 @@ class StaticRTree
                          QueueT &traversal_queue) const
     {
         const LeafNode &current_leaf_node = m_leaves[leaf_id.index];
+        const std::uint32_t object_count = current_leaf_node.object_count;
 
-        // current object represents a block on disk
-        for (const auto i : irange(0u, current_leaf_node.object_count))
+        // Decode the leaf into a structure of arrays first. The projection below is then a set of
+        // branch-free loops over plain doubles that the compiler can vectorize for the target.
+        // This mirrors coordinate_calculation::projectPointOnSegment and squaredEuclideanDistance.
+        std::array<double, LEAF_NODE_SIZE> source_x, source_y, target_x, target_y;
+        for (const auto i : irange(0u, object_count))
         {
             const auto &current_edge = current_leaf_node.objects[i];
             const auto projected_u = web_mercator::fromWGS84(m_coordinate_list[current_edge.u]);
             const auto projected_v = web_mercator::fromWGS84(m_coordinate_list[current_edge.v]);
+            source_x[i] = static_cast<double>(projected_u.lon);
+            source_y[i] = static_cast<double>(projected_u.lat);
+            target_x[i] = static_cast<double>(projected_v.lon);
+            target_y[i] = static_cast<double>(projected_v.lat);
+        }
 
-            FloatCoordinate projected_nearest;
-            std::tie(std::ignore, projected_nearest) =
-                coordinate_calculation::projectPointOnSegment(
-                    projected_u, projected_v, projected_input_coordinate);
+        const auto input_x = static_cast<double>(projected_input_coordinate.lon);
+        const auto input_y = static_cast<double>(projected_input_coordinate.lat);
+        std::array<double, LEAF_NODE_SIZE> nearest_x, nearest_y;
+        for (std::uint32_t i = 0; i < object_count; ++i)
+        {
+            const double slope_x = target_x[i] - source_x[i];
+            const double slope_y = target_y[i] - source_y[i];
+            const double unnormed_ratio =
+                slope_x * (input_x - source_x[i]) + slope_y * (input_y - source_y[i]);
+            const double squared_length = slope_x * slope_x + slope_y * slope_y;
+            // degenerate segments project onto their source
+            const bool is_degenerate = squared_length < std::numeric_limits<double>::epsilon();
+            const double normed_ratio = is_degenerate ? 0. : unnormed_ratio / squared_length;
+            const double clamped_ratio = std::min(1., std::max(0., normed_ratio));
+            nearest_x[i] = (1.0 - clamped_ratio) * source_x[i] + target_x[i] * clamped_ratio;
+            nearest_y[i] = (1.0 - clamped_ratio) * source_y[i] + target_y[i] * clamped_ratio;
+        }
 
-            const auto squared_distance = coordinate_calculation::squaredEuclideanDistance(
-                projected_input_coordinate_fixed, projected_nearest);
-            // distance must be non-negative
-            BOOST_ASSERT(0. <= squared_distance);
-            traversal_queue.push(
-                QueryCandidate{squared_distance, leaf_id, i, Coordinate{projected_nearest}});
+        const auto input_fixed_x = static_cast<std::int32_t>(projected_input_coordinate_fixed.lon);
+        const auto input_fixed_y = static_cast<std::int32_t>(projected_input_coordinate_fixed.lat);
+        std::array<std::int32_t, LEAF_NODE_SIZE> nearest_fixed_x, nearest_fixed_y;
+        std::array<std::uint64_t, LEAF_NODE_SIZE> squared_distances;
+        for (std::uint32_t i = 0; i < object_count; ++i)
+        {
+            nearest_fixed_x[i] = static_cast<std::int32_t>(nearest_x[i] * COORDINATE_PRECISION);
+            nearest_fixed_y[i] = static_cast<std::int32_t>(nearest_y[i] * COORDINATE_PRECISION);
+            const std::uint64_t dx = static_cast<std::int32_t>(input_fixed_x - nearest_fixed_x[i]);
+            const std::uint64_t dy = static_cast<std::int32_t>(input_fixed_y - nearest_fixed_y[i]);
+            squared_distances[i] = dx * dx + dy * dy;
+        }
+
+        for (const auto i : irange(0u, object_count))
+        {
+            traversal_queue.push(QueryCandidate{squared_distances[i],
+                                                leaf_id,
+                                                i,
+                                                Coordinate{FixedLongitude{nearest_fixed_x[i]},
+                                                           FixedLatitude{nearest_fixed_y[i]}}});
         }
     }
 
     template <class QueueT>
     void ExploreTreeNode(const TreeIndex &parent_id,
                          const Coordinate &fixed_projected_input_coordinate,
+                         const BearingClasses bearing_classes,
                          QueueT &traversal_queue) const
     {
         const TreeNode &parent = m_search_tree[parent_id.index];
         for (std::uint32_t i = 0; i < parent.child_count; ++i)
         {
             const TreeIndex child_id = parent.children[i];
-            const auto &child_rectangle =
-                child_id.is_leaf ? m_leaves[child_id.index].minimum_bounding_rectangle
-                                 : m_search_tree[child_id.index].minimum_bounding_rectangle;
+            // none of the segments below the child can pass the bearing filter
+            if (bearing_classes != ALL_BEARING_CLASSES &&
+                (GetChildBearingClasses(parent_id, i) & bearing_classes) == 0)
+            {
+                continue;
+            }
+            const auto child_rectangle = GetChildRectangle(parent_id, i);
             const auto squared_lower_bound_to_element =
                 child_rectangle.GetMinSquaredDist(fixed_projected_input_coordinate);
             traversal_queue.push(QueryCandidate{squared_lower_bound_to_element, child_id});
         }
     }
+
+    // Returns the (possibly enlarged) bounding box of the child in the given slot of a tree node
+    Rectangle GetChildRectangle(const TreeIndex &parent_id, const std::uint32_t child_slot) const
+    {
+        BOOST_ASSERT(!parent_id.is_leaf);
+        const TreeNode &parent = m_search_tree[parent_id.index];
+        const TreeIndex child_id = parent.children[child_slot];
+        if (parent_id.index < m_quantized_node_count)
+        {
+            const auto &bounds = parent.minimum_bounding_rectangle;
+            const auto &quantized =
+                m_quantized_children[parent_id.index * BRANCHING_FACTOR + child_slot];
+            const auto min_lon = static_cast<std::int32_t>(bounds.min_lon);
+            const auto max_lon = static_cast<std::int32_t>(bounds.max_lon);
+            const auto min_lat = static_cast<std::int32_t>(bounds.min_lat);
+            const auto max_lat = static_cast<std::int32_t>(bounds.max_lat);
+            return Rectangle{FixedLongitude{DequantizeLower(quantized.min_lon, min_lon, max_lon)},
+                             FixedLongitude{DequantizeUpper(quantized.max_lon, min_lon, max_lon)},
+                             FixedLatitude{DequantizeLower(quantized.min_lat, min_lat, max_lat)},
+                             FixedLatitude{DequantizeUpper(quantized.max_lat, min_lat, max_lat)}};
+        }
+        return child_id.is_leaf ? m_leaves[child_id.index].minimum_bounding_rectangle
+                                : m_search_tree[child_id.index].minimum_bounding_rectangle;
+    }
+
+    BearingClasses GetChildBearingClasses(const TreeIndex &parent_id,
+                                          const std::uint32_t child_slot) const
+    {
+        BOOST_ASSERT(!parent_id.is_leaf);
+        if (parent_id.index < m_quantized_node_count)
+        {
+            return m_quantized_children_bearing_classes[parent_id.index * BRANCHING_FACTOR +
+                                                        child_slot];
+        }
+        const TreeIndex child_id = m_search_tree[parent_id.index].children[child_slot];
+        return child_id.is_leaf ? m_leaves[child_id.index].bearing_classes
+                                : m_search_tree[child_id.index].bearing_classes;
+    }
+
+    static BearingClasses GetBearingClass(const int value)
+    {
+        const auto normalized_bearing = (value % 360 + 360) % 360;
+        return BearingClasses{1} << (normalized_bearing * BEARING_CLASS_COUNT / 360);
+    }
+
+    // Same bearings as in the bearing filter of engine::GeospatialQuery
+    BearingClasses GetSegmentBearingClasses(const EdgeDataT &object) const
+    {
+        const double forward_bearing = coordinate_calculation::bearing(
+            Coordinate{m_coordinate_list[object.u]}, Coordinate{m_coordinate_list[object.v]});
+        const double backward_bearing =
+            (forward_bearing + 180) > 360 ? (forward_bearing - 180) : (forward_bearing + 180);
+
+        BearingClasses bearing_classes = 0;
+        if (object.forward_segment_id.enabled)
+        {
+            bearing_classes |= GetBearingClass(static_cast<int>(std::round(forward_bearing)));
+        }
+        if (object.reverse_segment_id.enabled)
+        {
+            bearing_classes |= GetBearingClass(static_cast<int>(std::round(backward_bearing)));
+        }
+        return bearing_classes;
+    }
+
+    // Packs the objects of the leaf_id-th leaf in Hilbert order and computes their bounding box
+    LeafNode PackLeaf(const std::vector<EdgeDataT> &input_data_vector,
+                      const std::vector<WrappedInputElement> &input_wrapper_vector,
+                      const std::uint64_t leaf_id) const
+    {
+        LeafNode current_leaf;
+        Rectangle &rectangle = current_leaf.minimum_bounding_rectangle;
+        const std::uint64_t first_element = leaf_id * LEAF_NODE_SIZE;
+        const std::uint64_t last_element =
+            std::min<std::uint64_t>(first_element + LEAF_NODE_SIZE, input_wrapper_vector.size());
+        for (std::uint64_t element_index = first_element; element_index < last_element;
+             ++element_index)
+        {
+            const std::uint32_t input_object_index =
+                input_wrapper_vector[element_index].m_array_index;
+            const EdgeDataT &object = input_data_vector[input_object_index];
+
+            current_leaf.objects[current_leaf.object_count] = object;
+            current_leaf.object_count += 1;
+            current_leaf.bearing_classes |= GetSegmentBearingClasses(object);
+
+            Coordinate projected_u{
+                web_mercator::fromWGS84(Coordinate{m_coordinate_list[object.u]})};
+            Coordinate projected_v{
+                web_mercator::fromWGS84(Coordinate{m_coordinate_list[object.v]})};
+
+            BOOST_ASSERT(std::abs(toFloating(projected_u.lon).operator double()) <= 180.);
+            BOOST_ASSERT(std::abs(toFloating(projected_u.lat).operator double()) <= 180.);
+            BOOST_ASSERT(std::abs(toFloating(projected_v.lon).operator double()) <= 180.);
+            BOOST_ASSERT(std::abs(toFloating(projected_v.lat).operator double()) <= 180.);
+
+            rectangle.min_lon =
+                std::min(rectangle.min_lon, std::min(projected_u.lon, projected_v.lon));
+            rectangle.max_lon =
+                std::max(rectangle.max_lon, std::max(projected_u.lon, projected_v.lon));
+
+            rectangle.min_lat =
+                std::min(rectangle.min_lat, std::min(projected_u.lat, projected_v.lat));
+            rectangle.max_lat =
+                std::max(rectangle.max_lat, std::max(projected_u.lat, projected_v.lat));
+
+            BOOST_ASSERT(rectangle.IsValid());
+        }
+        return current_leaf;
+    }
+
+    void QuantizeUpperLevels()
+    {
+        // the tree is stored top-down, so all nodes with tree node children form a prefix
+        m_quantized_node_count = 0;
+        while (m_quantized_node_count < m_search_tree.size() &&
+               m_search_tree[m_quantized_node_count].child_count > 0 &&
+               !m_search_tree[m_quantized_node_count].children[0].is_leaf)
+        {
+            ++m_quantized_node_count;
+        }
+
+        m_quantized_children.resize(m_quantized_node_count * BRANCHING_FACTOR);
+        m_quantized_children_bearing_classes.resize(m_quantized_node_count * BRANCHING_FACTOR);
+        for (const auto node_index : irange(0u, m_quantized_node_count))
+        {
+            const TreeNode &node = m_search_tree[node_index];
+            const auto &bounds = node.minimum_bounding_rectangle;
+            const auto min_lon = static_cast<std::int32_t>(bounds.min_lon);
+            const auto max_lon = static_cast<std::int32_t>(bounds.max_lon);
+            const auto min_lat = static_cast<std::int32_t>(bounds.min_lat);
+            const auto max_lat = static_cast<std::int32_t>(bounds.max_lat);
+            for (const auto child_slot : irange(0u, node.child_count))
+            {
+                BOOST_ASSERT(!node.children[child_slot].is_leaf);
+                const auto &child =
+                    m_search_tree[node.children[child_slot].index].minimum_bounding_rectangle;
+                m_quantized_children_bearing_classes[node_index * BRANCHING_FACTOR + child_slot] =
+                    m_search_tree[node.children[child_slot].index].bearing_classes;
+                auto &quantized = m_quantized_children[node_index * BRANCHING_FACTOR + child_slot];
+                quantized.min_lon =
+                    QuantizeLower(static_cast<std::int32_t>(child.min_lon), min_lon, max_lon);
+                quantized.max_lon =
+                    QuantizeUpper(static_cast<std::int32_t>(child.max_lon), min_lon, max_lon);
+                quantized.min_lat =
+                    QuantizeLower(static_cast<std::int32_t>(child.min_lat), min_lat, max_lat);
+                quantized.max_lat =
+                    QuantizeUpper(static_cast<std::int32_t>(child.max_lat), min_lat, max_lat);
+            }
+        }
+    }
+
+    static std::uint64_t Offset(const std::int32_t value, const std::int32_t origin)
+    {
+        BOOST_ASSERT(origin <= value);
+        return static_cast<std::uint64_t>(static_cast<std::int64_t>(value) - origin);
+    }
+
+    static std::uint16_t
+    QuantizeLower(const std::int32_t value, const std::int32_t min, const std::int32_t max)
+    {
+        const auto extent = Offset(max, min);
+        if (extent == 0)
+            return 0;
+        return static_cast<std::uint16_t>(Offset(value, min) * QUANTIZATION_STEPS / extent);
+    }
+
+    static std::uint16_t
+    QuantizeUpper(const std::int32_t value, const std::int32_t min, const std::int32_t max)
+    {
+        const auto extent = Offset(max, min);
+        if (extent == 0)
+            return 0;
+        return static_cast<std::uint16_t>(
+            (Offset(value, min) * QUANTIZATION_STEPS + extent - 1) / extent);
+    }
+
+    static std::int32_t
+    DequantizeLower(const std::uint16_t value, const std::int32_t min, const std::int32_t max)
+    {
+        const auto offset = value * Offset(max, min) / QUANTIZATION_STEPS;
+        return static_cast<std::int32_t>(min + static_cast<std::int64_t>(offset));
+    }
+
+    static std::int32_t
+    DequantizeUpper(const std::uint16_t value, const std::int32_t min, const std::int32_t max)
+    {
+        const auto offset =
+            (value * Offset(max, min) + QUANTIZATION_STEPS - 1) / QUANTIZATION_STEPS;
+        return static_cast<std::int32_t>(min + static_cast<std::int64_t>(offset));
+    }
 };
 
 //[1] "On Packing R-Trees"; I. Kamel, C. Faloutsos; 1993; DOI: 10.1145/170088.170403
@@ -0,0 +1,18 @@
+#ifndef OSRM_UTIL_STRING_VIEW_HPP
+#define OSRM_UTIL_STRING_VIEW_HPP
+
+#include <boost/utility/string_ref.hpp>
+
+namespace osrm
+{
+namespace util
+{
+
+// Read only view of a string that is owned by someone else, e.g. a name in the names blob of the
+// data facades. It stays valid only as long as the owner does.
+using StringView = boost::string_ref;
+
+} // namespace util
+} // namespace osrm
+
+#endif /* OSRM_UTIL_STRING_VIEW_HPP */
@@ -0,0 +1,95 @@
+#ifndef SYSTEM_MEMORY_HPP
+#define SYSTEM_MEMORY_HPP
+
+#include <boost/optional.hpp>
+
+#include <cstdint>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace osrm
+{
+namespace util
+{
+
+// Returns the memory in bytes that can be allocated without swapping: MemAvailable of
+// /proc/meminfo on Linux, the free physical pages where only those are known, 0 if unknown.
+inline std::uint64_t getAvailableMemory()
+{
+#ifdef __linux__
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    std::uint64_t kilobytes;
+    std::string unit;
+    while (meminfo >> key >> kilobytes >> unit)
+    {
+        if (key == "MemAvailable:")
+        {
+            return kilobytes * 1024;
+        }
+    }
+#endif
+#if defined(_SC_AVPHYS_PAGES) && defined(_SC_PAGESIZE)
+    const auto pages = ::sysconf(_SC_AVPHYS_PAGES);
+    const auto page_size = ::sysconf(_SC_PAGESIZE);
+    if (pages > 0 && page_size > 0)
+    {
+        return static_cast<std::uint64_t>(pages) * static_cast<std::uint64_t>(page_size);
+    }
+#endif
+    return 0;
+}
+
+// Returns how many bytes of the mapped range are resident: in memory for anonymous and shared
+// memory, in the page cache for mappings of files. Pages at the ends of the range count with
+// the part of them in the range. None if the residency can not be queried.
+inline boost::optional<std::uint64_t> getResidentMemory(const void *address,
+                                                        const std::uint64_t size)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    if (size == 0)
+    {
+        return std::uint64_t{0};
+    }
+    const auto page_size = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+    const auto begin = reinterpret_cast<std::uintptr_t>(address);
+    const auto end = begin + size;
+    const auto first_page = begin - begin % page_size;
+#ifdef __APPLE__
+    std::vector<char> pages((end - first_page + page_size - 1) / page_size);
+#else
+    std::vector<unsigned char> pages((end - first_page + page_size - 1) / page_size);
+#endif
+    if (::mincore(reinterpret_cast<void *>(first_page), end - first_page, pages.data()) != 0)
+    {
+        return boost::none;
+    }
+
+    std::uint64_t resident = 0;
+    for (std::size_t page = 0; page < pages.size(); ++page)
+    {
+        if (pages[page] & 1)
+        {
+            const auto page_begin = first_page + page * page_size;
+            resident += std::min(page_begin + page_size, end) - std::max(page_begin, begin);
+        }
+    }
+    return resident;
+#else
+    (void)address;
+    (void)size;
+    return boost::none;
+#endif
+}
+}
+}
+
+#endif // SYSTEM_MEMORY_HPP
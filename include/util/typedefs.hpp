@@ -58,6 +58,8 @@ using NodeID = std::uint32_t;
 using EdgeID = std::uint32_t;
 using NameID = std::uint32_t;
 using EdgeWeight = std::int32_t;
+// Length of an edge or a path of the hierarchy in decimeters
+using EdgeDistance = std::int32_t;
 
 using LaneID = std::uint8_t;
 static const LaneID INVALID_LANEID = std::numeric_limits<LaneID>::max();
@@ -83,9 +85,15 @@ static const NameID INVALID_NAMEID = std::numeric_limits<NameID>::max();
 static const NameID EMPTY_NAMEID = 0;
 static const unsigned INVALID_COMPONENTID = 0;
 static const EdgeWeight INVALID_EDGE_WEIGHT = std::numeric_limits<EdgeWeight>::max();
+static const EdgeDistance INVALID_EDGE_DISTANCE = std::numeric_limits<EdgeDistance>::max();
 
 using DatasourceID = std::uint8_t;
 
+// Length of a segment of a compressed geometry in decimeters
+using SegmentLength = std::uint16_t;
+// Marks segments that are too long for a SegmentLength, their length has to be computed
+static const SegmentLength INVALID_SEGMENT_LENGTH = std::numeric_limits<SegmentLength>::max();
+
 struct SegmentID
 {
     SegmentID(const NodeID id_, const bool enabled_) : id{id_}, enabled{enabled_}
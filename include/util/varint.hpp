@@ -0,0 +1,56 @@
+#ifndef OSRM_UTIL_VARINT_HPP
+#define OSRM_UTIL_VARINT_HPP
+
+#include <boost/assert.hpp>
+
+#include <cstdint>
+
+namespace osrm
+{
+namespace util
+{
+namespace detail
+{
+
+// Differences are zigzag encoded, so that small negative ones take few bytes as well, and written
+// as varints of 7 bits per byte. All but the last byte of a varint have their high bit set.
+inline std::uint32_t zigzagEncode(const std::int32_t value)
+{
+    return (static_cast<std::uint32_t>(value) << 1) ^ static_cast<std::uint32_t>(value >> 31);
+}
+
+inline std::int32_t zigzagDecode(const std::uint32_t value)
+{
+    return static_cast<std::int32_t>(value >> 1) ^ -static_cast<std::int32_t>(value & 1);
+}
+
+inline std::uint32_t readVarint(const std::uint8_t *&bytes)
+{
+    std::uint32_t value = 0;
+    for (std::uint32_t shift = 0;; shift += 7)
+    {
+        const std::uint8_t byte = *bytes++;
+        value |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return value;
+    }
+}
+
+// Reads the varint that ends right before `bytes` and moves `bytes` to its first byte. The varint
+// starts at `lower` at the earliest.
+inline std::uint32_t readVarintBackward(const std::uint8_t *&bytes, const std::uint8_t *lower)
+{
+    BOOST_ASSERT(bytes > lower);
+    auto first = bytes - 1;
+    while (first > lower && (first[-1] & 0x80) != 0)
+    {
+        --first;
+    }
+    bytes = first;
+    return readVarint(first);
+}
+}
+}
+}
+
+#endif // OSRM_UTIL_VARINT_HPP
@@ -5,6 +5,8 @@
 
 #include <boost/math/constants/constants.hpp>
 
+#include <cstdint>
+
 namespace osrm
 {
 namespace util
@@ -134,6 +136,17 @@ inline FloatCoordinate fromWGS84(const FloatCoordinate &wgs84_coordinate)
     return {wgs84_coordinate.lon, FloatLatitude{latToYapprox(wgs84_coordinate.lat)}};
 }
 
+// Projects the coordinates [first, last) to out one after the other, like fromWGS84
+template <typename InputIter, typename OutputIter>
+OutputIter fromWGS84(InputIter first, const InputIter last, OutputIter out)
+{
+    for (; first != last; ++first, ++out)
+    {
+        *out = fromWGS84(FloatCoordinate(*first));
+    }
+    return out;
+}
+
 inline FloatCoordinate toWGS84(const FloatCoordinate &mercator_coordinate)
 {
     return {mercator_coordinate.lon, yToLat(static_cast<double>(mercator_coordinate.lat))};
@@ -170,6 +183,43 @@ inline void xyzToMercator(
     maxx = static_cast<double>(clamp(util::FloatLongitude{maxx})) * DEGREE_TO_PX;
     maxy = latToY(clamp(util::FloatLatitude{maxy})) * DEGREE_TO_PX;
 }
+
+// Projects coordinates into the pixels of a WMS tile (z,x,y), from 0 at the west and the north
+// border to extent at the east and the south border. The bounds and the scale of the tile are
+// computed once: a longitude is projected from its fixed value with a single multiply-add and a
+// latitude with the approximation of latToY.
+class TileProjection
+{
+  public:
+    TileProjection(const int x, const int y, const int z, const double extent)
+    {
+        double min_x, min_y, max_x, max_y;
+        xyzToMercator(x, y, z, min_x, min_y, max_x, max_y);
+
+        const double x_scale = extent / (max_x - min_x);
+        const double y_scale = extent / (max_y - min_y);
+        lon_scale = DEGREE_TO_PX / COORDINATE_PRECISION * x_scale;
+        lon_offset = -min_x * x_scale;
+        lat_scale = -DEGREE_TO_PX * y_scale;
+        lat_offset = max_y * y_scale;
+    }
+
+    double X(const FixedLongitude lon) const
+    {
+        return static_cast<std::int32_t>(lon) * lon_scale + lon_offset;
+    }
+
+    double Y(const FixedLatitude lat) const
+    {
+        return latToYapprox(toFloating(lat)) * lat_scale + lat_offset;
+    }
+
+  private:
+    double lon_scale;
+    double lon_offset;
+    double lat_scale;
+    double lat_offset;
+};
 }
 }
 }
@@ -97,6 +97,7 @@ properties.u_turn_penalty                = 20
 properties.max_speed_for_map_matching    = 110/3.6 -- kmph -> m/s
 properties.use_turn_restrictions         = false
 properties.continue_straight_at_waypoint = false
+properties.sample_turn_function          = true
 
 local obey_oneway               = true
 local ignore_areas              = true
@@ -151,6 +151,10 @@ properties.max_speed_for_map_matching      = 180/3.6 -- 180kmph -> m/s
 properties.use_turn_restrictions           = true
 properties.continue_straight_at_waypoint   = true
 properties.left_hand_driving               = false
+-- way_function only reads the tags of a way, ways with the same tags share their result
+properties.cache_way_results               = true
+-- turn_function only depends on the angle, it is sampled once instead of called for every turn
+properties.sample_turn_function            = true
 
 local side_road_speed_multiplier = 0.8
 
@@ -214,10 +218,10 @@ function node_function (node, result)
       result.barrier = true
     end
   else
-    local barrier = node:get_value_by_key("barrier")
+    local barrier = get_tag("barrier")
     if barrier and "" ~= barrier then
       --  make an exception for rising bollard barriers
-      local bollard = node:get_value_by_key("bollard")
+      local bollard = get_tag("bollard")
       local rising_bollard = bollard and "rising" == bollard
 
       if not barrier_whitelist[barrier] and not rising_bollard then
@@ -227,16 +231,16 @@ function node_function (node, result)
   end
 
   -- check if node is a traffic light
-  local tag = node:get_value_by_key("highway")
+  local tag = get_tag("highway")
   if tag and "traffic_signals" == tag then
     result.traffic_lights = true
   end
 end
 
 function way_function (way, result)
-  local highway = way:get_value_by_key("highway")
-  local route = way:get_value_by_key("route")
-  local bridge = way:get_value_by_key("bridge")
+  local highway = get_tag("highway")
+  local route = get_tag("route")
+  local bridge = get_tag("bridge")
 
   if not ((highway and highway ~= "") or (route and route ~= "") or (bridge and bridge ~= "")) then
     return
@@ -247,14 +251,14 @@ function way_function (way, result)
   result.backward_mode = mode.driving
 
   -- we dont route over areas
-  local area = way:get_value_by_key("area")
+  local area = get_tag("area")
   if ignore_areas and area and "yes" == area then
     return
   end
 
   -- respect user-preference for HOV-only ways
   if ignore_hov_ways then
-    local hov = way:get_value_by_key("hov")
+    local hov = get_tag("hov")
     if hov and "designated" == hov then
       return
     end
@@ -273,9 +277,9 @@ function way_function (way, result)
       return all
     end
 
-    local hov_lanes = way:get_value_by_key("hov:lanes")
-    local hov_lanes_forward = way:get_value_by_key("hov:lanes:forward")
-    local hov_lanes_backward = way:get_value_by_key("hov:lanes:backward")
+    local hov_lanes = get_tag("hov:lanes")
+    local hov_lanes_forward = get_tag("hov:lanes:forward")
+    local hov_lanes_backward = get_tag("hov:lanes:backward")
 
     local hov_all_designated = hov_lanes and hov_lanes ~= ""
                                and has_all_designated_hov_lanes(hov_lanes)
@@ -287,7 +291,7 @@ function way_function (way, result)
                                         and has_all_designated_hov_lanes(hov_lanes_backward)
 
     -- forward/backward lane depend on a way's direction
-    local oneway = way:get_value_by_key("oneway")
+    local oneway = get_tag("oneway")
     local reverse = oneway and oneway == "-1"
 
     if hov_all_designated or hov_all_designated_forward then
@@ -309,25 +313,28 @@ function way_function (way, result)
   end -- hov handling
 
   -- respect user-preference for toll=yes ways
-  local toll = way:get_value_by_key("toll")
+  local toll = get_tag("toll")
   if ignore_toll_ways and toll and "yes" == toll then
     return
   end
+  if toll and "yes" == toll then
+    result:set_class("toll")
+  end
 
   -- Reversible oneways change direction with low frequency (think twice a day):
   -- do not route over these at all at the moment because of time dependence.
   -- Note: alternating (high frequency) oneways are handled below with penalty.
-  local oneway = way:get_value_by_key("oneway")
+  local oneway = get_tag("oneway")
   if oneway and "reversible" == oneway then
     return
   end
 
-  local impassable = way:get_value_by_key("impassable")
+  local impassable = get_tag("impassable")
   if impassable and "yes" == impassable then
     return
   end
 
-  local status = way:get_value_by_key("status")
+  local status = get_tag("status")
   if status and "impassable" == status then
     return
   end
@@ -342,7 +349,7 @@ function way_function (way, result)
   local route_speed = speed_profile[route]
   if (route_speed and route_speed > 0) then
     highway = route
-    local duration  = way:get_value_by_key("duration")
+    local duration  = get_tag("duration")
     if duration and durationIsValid(duration) then
       result.duration = max( parseDuration(duration), 1 )
     end
@@ -350,14 +357,15 @@ function way_function (way, result)
     result.backward_mode = mode.ferry
     result.forward_speed = route_speed
     result.backward_speed = route_speed
+    result:set_class("ferry")
   end
 
   -- handling movable bridges
   local bridge_speed = speed_profile[bridge]
-  local capacity_car = way:get_value_by_key("capacity:car")
+  local capacity_car = get_tag("capacity:car")
   if (bridge_speed and bridge_speed > 0) and (capacity_car ~= 0) then
     highway = bridge
-    local duration  = way:get_value_by_key("duration")
+    local duration  = get_tag("duration")
     if duration and durationIsValid(duration) then
       result.duration = max( parseDuration(duration), 1 )
     end
@@ -370,9 +378,18 @@ function way_function (way, result)
     return
   end
 
+  -- classes that requests can exclude, see osrm-contract --exclude
+  if "motorway" == highway or "motorway_link" == highway then
+    result:set_class("motorway")
+  end
+  local tunnel = get_tag("tunnel")
+  if tunnel and "no" ~= tunnel then
+    result:set_class("tunnel")
+  end
+
   if result.forward_speed == -1 then
     local highway_speed = speed_profile[highway]
-    local max_speed = parse_maxspeed( way:get_value_by_key("maxspeed") )
+    local max_speed = parse_maxspeed( get_tag("maxspeed") )
     -- Set the avg speed on the way if it is accessible by road class
     if highway_speed then
       if max_speed and max_speed > highway_speed then
@@ -402,7 +419,7 @@ function way_function (way, result)
   end
 
   -- reduce speed on special side roads
-  local sideway = way:get_value_by_key("side_road")
+  local sideway = get_tag("side_road")
   if "yes" == sideway or
   "rotary" == sideway then
     result.forward_speed = result.forward_speed * side_road_speed_multiplier
@@ -410,9 +427,9 @@ function way_function (way, result)
   end
 
   -- reduce speed on bad surfaces
-  local surface = way:get_value_by_key("surface")
-  local tracktype = way:get_value_by_key("tracktype")
-  local smoothness = way:get_value_by_key("smoothness")
+  local surface = get_tag("surface")
+  local tracktype = get_tag("tracktype")
+  local smoothness = get_tag("smoothness")
 
   if surface and surface_speeds[surface] then
     result.forward_speed = math.min(surface_speeds[surface], result.forward_speed)
@@ -431,13 +448,13 @@ function way_function (way, result)
   set_classification(highway,result,way)
 
   -- parse the remaining tags
-  local name = way:get_value_by_key("name")
-  local pronunciation = way:get_value_by_key("name:pronunciation")
-  local ref = way:get_value_by_key("ref")
-  local junction = way:get_value_by_key("junction")
+  local name = get_tag("name")
+  local pronunciation = get_tag("name:pronunciation")
+  local ref = get_tag("ref")
+  local junction = get_tag("junction")
   -- local barrier = way:get_value_by_key("barrier", "")
   -- local cycleway = way:get_value_by_key("cycleway", "")
-  local service = way:get_value_by_key("service")
+  local service = get_tag("service")
 
   -- Set the name that will be used for instructions
   local has_ref = ref and "" ~= ref
@@ -482,12 +499,14 @@ function way_function (way, result)
   -- Set access restriction flag if access is allowed under certain restrictions only
   if access ~= "" and access_tag_restricted[access] then
     result.is_access_restricted = true
+    result:set_class("restricted")
   end
 
   if service and service ~= "" then
     -- Set access restriction flag if service is allowed under certain restrictions only
     if service_tag_restricted[service] then
       result.is_access_restricted = true
+      result:set_class("restricted")
     end
 
     -- Set don't allow access to certain service roads
@@ -521,8 +540,8 @@ function way_function (way, result)
   end
 
   -- Override speed settings if explicit forward/backward maxspeeds are given
-  local maxspeed_forward = parse_maxspeed(way:get_value_by_key("maxspeed:forward"))
-  local maxspeed_backward = parse_maxspeed(way:get_value_by_key("maxspeed:backward"))
+  local maxspeed_forward = parse_maxspeed(get_tag("maxspeed:forward"))
+  local maxspeed_backward = parse_maxspeed(get_tag("maxspeed:backward"))
   if maxspeed_forward and maxspeed_forward > 0 then
     if mode.inaccessible ~= result.forward_mode and mode.inaccessible ~= result.backward_mode then
       result.backward_speed = result.forward_speed
@@ -534,9 +553,9 @@ function way_function (way, result)
   end
 
   -- Override speed settings if advisory forward/backward maxspeeds are given
-  local advisory_speed = parse_maxspeed(way:get_value_by_key("maxspeed:advisory"))
-  local advisory_forward = parse_maxspeed(way:get_value_by_key("maxspeed:advisory:forward"))
-  local advisory_backward = parse_maxspeed(way:get_value_by_key("maxspeed:advisory:backward"))
+  local advisory_speed = parse_maxspeed(get_tag("maxspeed:advisory"))
+  local advisory_forward = parse_maxspeed(get_tag("maxspeed:advisory:forward"))
+  local advisory_backward = parse_maxspeed(get_tag("maxspeed:advisory:backward"))
   -- apply bi-directional advisory speed first
   if advisory_speed and advisory_speed > 0 then
     if mode.inaccessible ~= result.forward_mode then
@@ -559,12 +578,12 @@ function way_function (way, result)
   local width = math.huge
   local lanes = math.huge
   if result.forward_speed > 0 or result.backward_speed > 0 then
-    local width_string = way:get_value_by_key("width")
+    local width_string = get_tag("width")
     if width_string and tonumber(width_string:match("%d*")) then
       width = tonumber(width_string:match("%d*"))
     end
 
-    local lanes_string = way:get_value_by_key("lanes")
+    local lanes_string = get_tag("lanes")
     if lanes_string and tonumber(lanes_string:match("%d*")) then
       lanes = tonumber(lanes_string:match("%d*"))
     end
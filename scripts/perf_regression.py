@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+
+"""Performance regression harness on a fixed dataset.
+
+Extracts and contracts an OSM extract with a profile, runs query-bench on the result and
+compares the timings against a stored baseline. Metrics that got worse by more than their
+tolerance are regressions, the script then exits with 1. Without a baseline the run is stored
+as the baseline.
+
+The phases of osrm-extract and osrm-contract come from their --phase-report, the queries from
+the per case lines of query-bench. Query timings are the median of --runs runs of query-bench.
+
+The baseline is a JSON object with the metrics of a run and optional tolerances, as relative
+changes by glob patterns of metric names; the first matching pattern counts:
+
+    {"tolerances": {"query.*.p99_ms": 0.25, "*": 0.1}, "metrics": {...}}
+"""
+
+import argparse
+import fnmatch
+import json
+import os
+import re
+import shutil
+import statistics
+import subprocess
+import sys
+
+DEFAULT_TOLERANCES = {
+    "*.peak_resident_bytes": 0.05,
+    "query.*.p99_ms": 0.25,
+    "query.*.max_ms": None,
+    "*": 0.10,
+}
+
+# route short +steps    1 threads    1000 queries  p50     0.512 ms  p90 ...
+QUERY_LINE = re.compile(
+    r"^(?P<name>.+?)\s+(?P<threads>\d+) threads\s+(?P<count>\d+) queries\s+"
+    r"p50\s+(?P<p50>[\d.]+) ms\s+p90\s+(?P<p90>[\d.]+) ms\s+p99\s+(?P<p99>[\d.]+) ms\s+"
+    r"max\s+(?P<max>[\d.]+) ms\s+(?P<qps>[\d.]+) q/s"
+)
+
+
+def higher_is_better(metric):
+    return metric.endswith(".qps")
+
+
+def tolerance_of(metric, tolerances):
+    for pattern, tolerance in tolerances.items():
+        if fnmatch.fnmatchcase(metric, pattern):
+            return tolerance
+    return None
+
+
+def run(command, log):
+    log.write("$ " + " ".join(command) + "\n")
+    log.flush()
+    output = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                            universal_newlines=True)
+    log.write(output.stdout)
+    if output.returncode != 0:
+        sys.exit("{} failed with {}, see {}".format(command[0], output.returncode, log.name))
+    return output.stdout
+
+
+def phase_metrics(tool, report_path):
+    with open(report_path) as report_file:
+        report = json.load(report_file)
+    metrics = {}
+    for phase in report["phases"]:
+        metrics["{}.{}.wall_seconds".format(tool, phase["name"])] = phase["wall_seconds"]
+    metrics[tool + ".total.wall_seconds"] = report["total"]["wall_seconds"]
+    metrics[tool + ".total.cpu_seconds"] = report["total"]["cpu_seconds"]
+    metrics[tool + ".total.peak_resident_bytes"] = report["total"]["peak_resident_bytes"]
+    return metrics
+
+
+def query_metrics(outputs):
+    samples = {}
+    for output in outputs:
+        for line in output.splitlines():
+            match = QUERY_LINE.match(line)
+            if not match:
+                continue
+            case = "query.{} {}t".format(match.group("name").strip(), match.group("threads"))
+            for field, suffix in (("p50", "p50_ms"), ("p90", "p90_ms"), ("p99", "p99_ms"),
+                                  ("max", "max_ms"), ("qps", "qps")):
+                samples.setdefault(case + "." + suffix, []).append(float(match.group(field)))
+    return {metric: statistics.median(values) for metric, values in samples.items()}
+
+
+def compare(baseline, metrics, tolerances):
+    rows = []
+    for metric in sorted(set(baseline) | set(metrics)):
+        if metric not in metrics:
+            rows.append((metric, baseline[metric], None, None, None, "missing"))
+            continue
+        if metric not in baseline:
+            rows.append((metric, None, metrics[metric], None, None, "new"))
+            continue
+        before, after = baseline[metric], metrics[metric]
+        change = (after - before) / before if before else 0.0
+        tolerance = tolerance_of(metric, tolerances)
+        worse = -change if higher_is_better(metric) else change
+        if tolerance is None:
+            status = "info"
+        elif worse > tolerance:
+            status = "REGRESSION"
+        elif worse < -tolerance:
+            status = "improved"
+        else:
+            status = "ok"
+        rows.append((metric, before, after, change, tolerance, status))
+    return rows
+
+
+def write_report(rows, path):
+    width = max([len(row[0]) for row in rows] + [6])
+    lines = ["{:<{}} {:>14} {:>14} {:>9} {:>9}  {}".format(
+        "metric", width, "baseline", "current", "change", "tolerance", "status")]
+    for metric, before, after, change, tolerance, status in rows:
+        lines.append("{:<{}} {:>14} {:>14} {:>9} {:>9}  {}".format(
+            metric, width,
+            "-" if before is None else "{:.6g}".format(before),
+            "-" if after is None else "{:.6g}".format(after),
+            "-" if change is None else "{:+.1%}".format(change),
+            "-" if tolerance is None else "{:.0%}".format(tolerance),
+            status))
+    text = "\n".join(lines)
+    print(text)
+
+    with open(path, "w") as report_file:
+        json.dump([{"metric": metric, "baseline": before, "current": after, "change": change,
+                    "tolerance": tolerance, "status": status}
+                   for metric, before, after, change, tolerance, status in rows],
+                  report_file, indent=2)
+
+
+# The executable given on the command line, or the one in the build directory
+def tool(arguments, name):
+    path = getattr(arguments, name.replace("-", "_"))
+    if path:
+        return path
+    for directory in (arguments.build_dir, os.path.join(arguments.build_dir, "src", "benchmarks")):
+        if os.path.isfile(os.path.join(directory, name)):
+            return os.path.join(directory, name)
+    sys.exit("{} not found in {}".format(name, arguments.build_dir))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--build-dir", default="build",
+                        help="build directory with osrm-extract, osrm-contract and query-bench")
+    parser.add_argument("--osrm-extract", help="osrm-extract, instead of the one of --build-dir")
+    parser.add_argument("--osrm-contract", help="osrm-contract, instead of the one of --build-dir")
+    parser.add_argument("--query-bench", help="query-bench, instead of the one of --build-dir")
+    parser.add_argument("--data", required=True, help="OSM extract, e.g. a .osm.pbf")
+    parser.add_argument("--profile", required=True, help="profile to extract with")
+    parser.add_argument("--work-dir", required=True,
+                        help="directory for the dataset, the logs and the report")
+    parser.add_argument("--baseline", required=True,
+                        help="baseline to compare with, written if it does not exist")
+    parser.add_argument("--update-baseline", action="store_true",
+                        help="store this run as the baseline instead of comparing")
+    parser.add_argument("--queries", type=int, default=1000, help="queries per case")
+    parser.add_argument("--seed", type=int, default=1337, help="seed of the queries")
+    parser.add_argument("--threads", type=int, nargs="+", default=[1],
+                        help="thread counts query-bench runs with")
+    parser.add_argument("--runs", type=int, default=3,
+                        help="runs of query-bench, the median of every metric counts")
+    parser.add_argument("--skip-preprocessing", action="store_true",
+                        help="reuse the dataset of the last run, without extract and contract "
+                             "timings")
+    arguments = parser.parse_args()
+
+    if not os.path.isfile(arguments.data):
+        sys.exit("{} not found, `make -C test/data monaco.osm.pbf` downloads the default "
+                 "extract".format(arguments.data))
+
+    os.makedirs(arguments.work_dir, exist_ok=True)
+    data_name = os.path.basename(arguments.data)
+    for extension in (".osm.pbf", ".osm.bz2", ".osm"):
+        if data_name.endswith(extension):
+            data_name = data_name[:-len(extension)]
+            break
+    dataset = os.path.join(arguments.work_dir, data_name + ".osrm")
+
+    metrics = {}
+    with open(os.path.join(arguments.work_dir, "perf-regression.log"), "w") as log:
+        if not arguments.skip_preprocessing:
+            input_copy = os.path.join(arguments.work_dir, os.path.basename(arguments.data))
+            shutil.copyfile(arguments.data, input_copy)
+
+            extract_report = os.path.join(arguments.work_dir, "extract-phases.json")
+            run([tool(arguments, "osrm-extract"), input_copy, "-p", arguments.profile,
+                 "--phase-report", extract_report], log)
+            metrics.update(phase_metrics("extract", extract_report))
+
+            contract_report = os.path.join(arguments.work_dir, "contract-phases.json")
+            run([tool(arguments, "osrm-contract"), dataset, "--phase-report", contract_report], log)
+            metrics.update(phase_metrics("contract", contract_report))
+
+        outputs = []
+        for _ in range(arguments.runs):
+            command = [tool(arguments, "query-bench"), dataset, str(arguments.queries),
+                       str(arguments.seed)] + [str(threads) for threads in arguments.threads]
+            outputs.append(run(command, log))
+        metrics.update(query_metrics(outputs))
+
+    if arguments.update_baseline or not os.path.isfile(arguments.baseline):
+        tolerances = DEFAULT_TOLERANCES
+        if os.path.isfile(arguments.baseline):
+            with open(arguments.baseline) as baseline_file:
+                tolerances = json.load(baseline_file).get("tolerances", DEFAULT_TOLERANCES)
+        with open(arguments.baseline, "w") as baseline_file:
+            # the order of the tolerances matters, the metrics are sorted for readable diffs
+            json.dump({"tolerances": tolerances, "metrics": dict(sorted(metrics.items()))},
+                      baseline_file, indent=2)
+        print("stored {} metrics as the baseline {}".format(len(metrics), arguments.baseline))
+        return 0
+
+    with open(arguments.baseline) as baseline_file:
+        baseline = json.load(baseline_file)
+    # preprocessing metrics are only compared if they were measured
+    baseline_metrics = {metric: value for metric, value in baseline["metrics"].items()
+                        if not arguments.skip_preprocessing or metric.startswith("query.")}
+    rows = compare(baseline_metrics, metrics, baseline.get("tolerances", DEFAULT_TOLERANCES))
+    write_report(rows, os.path.join(arguments.work_dir, "perf-regression-report.json"))
+
+    regressions = [row for row in rows if row[5] in ("REGRESSION", "missing")]
+    if regressions:
+        print("{} of {} metrics regressed or are missing".format(len(regressions), len(rows)))
+        return 1
+    print("no regressions in {} metrics".format(len(rows)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,112 @@
+#ifndef OSRM_BENCHMARKS_MICRO_BENCHMARK_HPP
+#define OSRM_BENCHMARKS_MICRO_BENCHMARK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace benchmarks
+{
+
+// Nanoseconds per operation over the repetitions of a micro benchmark
+struct MicroBenchmarkSummary
+{
+    double min;
+    double median;
+    double mean;
+    double stddev;
+};
+
+inline MicroBenchmarkSummary summarize(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    const auto size = samples.size();
+    const auto mean = std::accumulate(samples.begin(), samples.end(), 0.) / size;
+    double squares = 0;
+    for (const auto sample : samples)
+    {
+        squares += (sample - mean) * (sample - mean);
+    }
+
+    MicroBenchmarkSummary summary;
+    summary.min = samples.front();
+    summary.median =
+        size % 2 == 1 ? samples[size / 2] : (samples[size / 2 - 1] + samples[size / 2]) / 2;
+    summary.mean = mean;
+    summary.stddev = size > 1 ? std::sqrt(squares / (size - 1)) : 0.;
+    return summary;
+}
+
+// Runs micro benchmarks a number of times without measuring them to warm up caches and the
+// allocator, then measures a number of repetitions and prints the time per operation. The median
+// is the number to compare, the spread shows how much to trust it.
+//
+// A benchmark returns a checksum of its results, they are summed up and printed at the end so
+// that the compiler can not drop the work that is measured.
+class MicroBenchmarkRunner
+{
+  public:
+    MicroBenchmarkRunner(const unsigned warmup, const unsigned repetitions, std::string filter)
+        : warmup(warmup), repetitions(std::max(repetitions, 1u)), filter(std::move(filter))
+    {
+    }
+
+    // Whether a benchmark is selected by the filter, to skip setting up unselected ones
+    bool Selected(const std::string &name) const
+    {
+        return name.find(filter) != std::string::npos;
+    }
+
+    // Measures `run`, which does `operations` operations per call
+    template <typename RunT>
+    void Run(const std::string &name, const std::uint64_t operations, RunT &&run)
+    {
+        if (!Selected(name))
+        {
+            return;
+        }
+
+        for (unsigned iteration = 0; iteration < warmup; ++iteration)
+        {
+            checksum += run();
+        }
+
+        std::vector<double> samples;
+        samples.reserve(repetitions);
+        for (unsigned iteration = 0; iteration < repetitions; ++iteration)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            checksum += run();
+            const auto stop = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration<double, std::nano>(stop - start).count() /
+                              std::max<std::uint64_t>(operations, 1));
+        }
+
+        const auto summary = summarize(std::move(samples));
+        std::cout << std::left << std::setw(56) << name << std::right << std::fixed
+                  << std::setprecision(2) << " median " << std::setw(10) << summary.median
+                  << " ns/op  mean " << std::setw(10) << summary.mean << " +- " << std::setw(8)
+                  << summary.stddev << "  min " << std::setw(10) << summary.min << std::endl;
+    }
+
+    std::uint64_t GetChecksum() const { return checksum; }
+
+  private:
+    const unsigned warmup;
+    const unsigned repetitions;
+    const std::string filter;
+    std::uint64_t checksum = 0;
+};
+}
+}
+
+#endif // OSRM_BENCHMARKS_MICRO_BENCHMARK_HPP
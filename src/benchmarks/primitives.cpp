@@ -0,0 +1,446 @@
+#include "engine/douglas_peucker.hpp"
+#include "engine/polyline_compressor.hpp"
+#include "util/binary_heap.hpp"
+#include "util/coordinate.hpp"
+#include "util/d_ary_heap.hpp"
+#include "util/packed_vector.hpp"
+#include "util/range_table.hpp"
+#include "util/static_graph.hpp"
+#include "util/typedefs.hpp"
+#include "util/xor_fast_hash_storage.hpp"
+
+#include "micro_benchmark.hpp"
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace benchmarks
+{
+
+// Choosen by a fair W20 dice roll (this value is completely arbitrary)
+constexpr unsigned RANDOM_SEED = 13;
+
+// Road graphs have about three edges per node
+constexpr unsigned AVERAGE_DEGREE = 3;
+// Nodes are renumbered for locality, the neighbours of a node have close IDs
+constexpr unsigned NEIGHBOUR_SPREAD = 1000;
+// Settled nodes per repetition of the heap benchmarks, split into searches of a size
+constexpr unsigned SETTLED_NODES_PER_REPETITION = 200000;
+// XORFastHashStorage has 2^16 cells, searches have to insert less than half of that
+constexpr unsigned MAX_XOR_STORAGE_SETTLED_NODES = 10000;
+
+inline std::uint32_t mix(std::uint32_t value)
+{
+    value ^= value >> 16;
+    value *= 0x7feb352d;
+    value ^= value >> 15;
+    value *= 0x846ca68b;
+    value ^= value >> 16;
+    return value;
+}
+
+// The neighbours and edge weights of a node, derived from its ID so that all heaps see the same
+// graph without storing it
+inline NodeID getNeighbour(const NodeID node, const unsigned edge, const NodeID number_of_nodes)
+{
+    const auto hash = mix(node * AVERAGE_DEGREE + edge);
+    return (node + number_of_nodes - NEIGHBOUR_SPREAD + hash % (2 * NEIGHBOUR_SPREAD + 1)) %
+           number_of_nodes;
+}
+
+inline int getWeight(const NodeID node, const unsigned edge)
+{
+    return 1 + mix(node * AVERAGE_DEGREE + edge) % 97;
+}
+
+// Dijkstra searches that stop after settling a number of nodes, which is the access pattern the
+// routing algorithms have on their heaps: inserts, decrease-keys and delete-mins mixed
+template <typename HeapT>
+std::uint64_t runSearches(HeapT &heap,
+                          const std::vector<NodeID> &sources,
+                          const unsigned settled_nodes,
+                          const NodeID number_of_nodes)
+{
+    std::uint64_t checksum = 0;
+    for (const auto source : sources)
+    {
+        heap.Clear();
+        heap.Insert(source, 0, source);
+        for (unsigned settled = 0; settled < settled_nodes && !heap.Empty(); ++settled)
+        {
+            const int weight = heap.MinKey();
+            const NodeID node = heap.DeleteMin();
+            checksum += weight;
+            for (unsigned edge = 0; edge < AVERAGE_DEGREE; ++edge)
+            {
+                const auto target = getNeighbour(node, edge, number_of_nodes);
+                const int target_weight = weight + getWeight(node, edge);
+                if (!heap.WasInserted(target))
+                {
+                    heap.Insert(target, target_weight, node);
+                }
+                else if (target_weight < heap.GetKey(target))
+                {
+                    heap.GetData(target) = node;
+                    heap.DecreaseKey(target, target_weight);
+                }
+            }
+        }
+    }
+    return checksum;
+}
+
+template <typename HeapT>
+void benchmarkHeap(MicroBenchmarkRunner &runner,
+                   const std::string &name,
+                   const NodeID number_of_nodes,
+                   const std::vector<unsigned> &search_sizes)
+{
+    if (!runner.Selected(name))
+    {
+        return;
+    }
+
+    HeapT heap(number_of_nodes);
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<NodeID> node_udist(0, number_of_nodes - 1);
+    for (const auto settled_nodes : search_sizes)
+    {
+        std::vector<NodeID> sources(std::max(1u, SETTLED_NODES_PER_REPETITION / settled_nodes));
+        for (auto &source : sources)
+        {
+            source = node_udist(mt_rand);
+        }
+
+        runner.Run(name + " settle " + std::to_string(settled_nodes),
+                   sources.size() * settled_nodes,
+                   [&] { return runSearches(heap, sources, settled_nodes, number_of_nodes); });
+    }
+}
+
+void benchmarkHeaps(MicroBenchmarkRunner &runner, const NodeID number_of_nodes)
+{
+    const std::vector<unsigned> search_sizes = {100, 1000, 10000, 100000};
+    std::vector<unsigned> small_search_sizes;
+    std::copy_if(search_sizes.begin(),
+                 search_sizes.end(),
+                 std::back_inserter(small_search_sizes),
+                 [](const unsigned size) { return size <= MAX_XOR_STORAGE_SETTLED_NODES; });
+
+    benchmarkHeap<
+        util::BinaryHeap<NodeID, NodeID, int, NodeID, util::ArrayStorage<NodeID, NodeID>>>(
+        runner, "BinaryHeap<ArrayStorage>", number_of_nodes, search_sizes);
+    benchmarkHeap<util::BinaryHeap<NodeID,
+                                   NodeID,
+                                   int,
+                                   NodeID,
+                                   util::TimestampedArrayStorage<NodeID, NodeID>>>(
+        runner, "BinaryHeap<TimestampedArrayStorage>", number_of_nodes, search_sizes);
+    benchmarkHeap<util::BinaryHeap<NodeID, NodeID, int, NodeID, util::MapStorage<NodeID, NodeID>>>(
+        runner, "BinaryHeap<MapStorage>", number_of_nodes, search_sizes);
+    benchmarkHeap<
+        util::BinaryHeap<NodeID, NodeID, int, NodeID, util::UnorderedMapStorage<NodeID, NodeID>>>(
+        runner, "BinaryHeap<UnorderedMapStorage>", number_of_nodes, search_sizes);
+    benchmarkHeap<
+        util::BinaryHeap<NodeID, NodeID, int, NodeID, util::XORFastHashStorage<NodeID, NodeID>>>(
+        runner, "BinaryHeap<XORFastHashStorage>", number_of_nodes, small_search_sizes);
+    // the heap of the routing searches, as a reference
+    benchmarkHeap<util::DAryHeap<NodeID,
+                                 NodeID,
+                                 int,
+                                 NodeID,
+                                 util::TimestampedArrayStorage<NodeID, NodeID>,
+                                 4>>(
+        runner, "DAryHeap<TimestampedArrayStorage, 4>", number_of_nodes, search_sizes);
+}
+
+struct EdgeData
+{
+    EdgeData() : weight(0) {}
+    EdgeData(const int weight) : weight(weight) {}
+    int weight;
+};
+
+void benchmarkStaticGraph(MicroBenchmarkRunner &runner, const NodeID number_of_nodes)
+{
+    if (!runner.Selected("StaticGraph"))
+    {
+        return;
+    }
+
+    using Graph = util::StaticGraph<EdgeData>;
+    std::vector<Graph::InputEdge> edges;
+    edges.reserve(number_of_nodes * AVERAGE_DEGREE);
+    for (NodeID node = 0; node < number_of_nodes; ++node)
+    {
+        for (unsigned edge = 0; edge < AVERAGE_DEGREE; ++edge)
+        {
+            edges.emplace_back(
+                node, getNeighbour(node, edge, number_of_nodes), getWeight(node, edge));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    const Graph graph(number_of_nodes, edges);
+    edges.clear();
+    edges.shrink_to_fit();
+
+    runner.Run("StaticGraph scan all edges", graph.GetNumberOfEdges(), [&] {
+        std::uint64_t checksum = 0;
+        for (NodeID node = 0; node < number_of_nodes; ++node)
+        {
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
+            {
+                checksum += graph.GetTarget(edge) + graph.GetEdgeData(edge).weight;
+            }
+        }
+        return checksum;
+    });
+
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<NodeID> node_udist(0, number_of_nodes - 1);
+    std::vector<NodeID> nodes(1000000);
+    for (auto &node : nodes)
+    {
+        node = node_udist(mt_rand);
+    }
+    runner.Run("StaticGraph adjacent edges of random nodes", nodes.size(), [&] {
+        std::uint64_t checksum = 0;
+        for (const auto node : nodes)
+        {
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
+            {
+                checksum += graph.GetTarget(edge) + graph.GetEdgeData(edge).weight;
+            }
+        }
+        return checksum;
+    });
+    runner.Run("StaticGraph FindEdge of random edges", nodes.size(), [&] {
+        std::uint64_t checksum = 0;
+        for (const auto node : nodes)
+        {
+            checksum +=
+                graph.FindEdge(node, getNeighbour(node, node % AVERAGE_DEGREE, number_of_nodes));
+        }
+        return checksum;
+    });
+}
+
+void benchmarkPackedVector(MicroBenchmarkRunner &runner, const std::size_t number_of_elements)
+{
+    if (!runner.Selected("PackedVector"))
+    {
+        return;
+    }
+
+    // OSM node IDs are about 2^32 today
+    std::mt19937_64 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<std::uint64_t> id_udist(0, (std::uint64_t{1} << 33) - 1);
+    std::vector<std::uint64_t> values(number_of_elements);
+    for (auto &value : values)
+    {
+        value = id_udist(mt_rand);
+    }
+
+    util::PackedVector<std::uint64_t> packed;
+    runner.Run("PackedVector push_back", values.size(), [&] {
+        packed = util::PackedVector<std::uint64_t>();
+        for (const auto value : values)
+        {
+            packed.push_back(value);
+        }
+        return packed.size();
+    });
+
+    std::uniform_int_distribution<std::size_t> index_udist(0, number_of_elements - 1);
+    std::vector<std::size_t> indices(1000000);
+    for (auto &index : indices)
+    {
+        index = index_udist(mt_rand);
+    }
+    runner.Run("PackedVector at random index", indices.size(), [&] {
+        std::uint64_t checksum = 0;
+        for (const auto index : indices)
+        {
+            checksum += packed.at(index);
+        }
+        return checksum;
+    });
+
+    std::vector<std::uint64_t> decoded(number_of_elements);
+    runner.Run("PackedVector decode all", number_of_elements, [&] {
+        packed.decode(0, number_of_elements, decoded.begin());
+        return decoded.back();
+    });
+}
+
+void benchmarkRangeTable(MicroBenchmarkRunner &runner, const std::size_t number_of_ranges)
+{
+    if (!runner.Selected("RangeTable"))
+    {
+        return;
+    }
+
+    // lengths like the ones of names: mostly short, some empty
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<unsigned> length_udist(0, 40);
+    std::vector<unsigned> lengths(number_of_ranges);
+    for (auto &length : lengths)
+    {
+        length = length_udist(mt_rand);
+    }
+    const util::RangeTable<16, false> table(lengths);
+
+    std::uniform_int_distribution<unsigned> id_udist(0, number_of_ranges - 1);
+    std::vector<unsigned> ids(1000000);
+    for (auto &id : ids)
+    {
+        id = id_udist(mt_rand);
+    }
+    runner.Run("RangeTable GetRange of random ids", ids.size(), [&] {
+        std::uint64_t checksum = 0;
+        for (const auto id : ids)
+        {
+            const auto range = table.GetRange(id);
+            checksum += range.front() + range.size();
+        }
+        return checksum;
+    });
+}
+
+// Geometries like the ones of routes: steps of up to about 100m in a random direction
+std::vector<util::Coordinate> makeGeometry(std::mt19937 &mt_rand, const std::size_t size)
+{
+    std::uniform_int_distribution<int> step_udist(-1000, 1000);
+    std::vector<util::Coordinate> geometry;
+    geometry.reserve(size);
+    int longitude = 13400000;
+    int latitude = 52500000;
+    for (std::size_t index = 0; index < size; ++index)
+    {
+        longitude += step_udist(mt_rand);
+        latitude += step_udist(mt_rand);
+        geometry.emplace_back(util::FixedLongitude{longitude}, util::FixedLatitude{latitude});
+    }
+    return geometry;
+}
+
+void benchmarkGeometries(MicroBenchmarkRunner &runner)
+{
+    if (!runner.Selected("polyline") && !runner.Selected("douglasPeucker"))
+    {
+        return;
+    }
+
+    std::mt19937 mt_rand(RANDOM_SEED);
+    for (const std::size_t size : {10, 100, 1000, 10000})
+    {
+        // the same number of coordinates for every size
+        std::vector<std::vector<util::Coordinate>> geometries(
+            std::max<std::size_t>(1, 100000 / size));
+        for (auto &geometry : geometries)
+        {
+            geometry = makeGeometry(mt_rand, size);
+        }
+        const auto coordinates = geometries.size() * size;
+        const auto suffix = " " + std::to_string(size) + " coordinates";
+
+        std::vector<std::string> polylines(geometries.size());
+        runner.Run("encodePolyline" + suffix, coordinates, [&] {
+            std::uint64_t checksum = 0;
+            for (std::size_t index = 0; index < geometries.size(); ++index)
+            {
+                polylines[index] =
+                    engine::encodePolyline(geometries[index].begin(), geometries[index].end());
+                checksum += polylines[index].size();
+            }
+            return checksum;
+        });
+        runner.Run("decodePolyline" + suffix, coordinates, [&] {
+            std::uint64_t checksum = 0;
+            for (const auto &polyline : polylines)
+            {
+                checksum += engine::decodePolyline(polyline).size();
+            }
+            return checksum;
+        });
+
+        for (const unsigned zoom_level : {5, 12, 18})
+        {
+            runner.Run("douglasPeucker z" + std::to_string(zoom_level) + suffix, coordinates, [&] {
+                std::uint64_t checksum = 0;
+                for (const auto &geometry : geometries)
+                {
+                    checksum += engine::douglasPeucker(geometry, zoom_level).size();
+                }
+                return checksum;
+            });
+        }
+    }
+}
+}
+}
+
+int main(int argc, char *argv[]) try
+{
+    using boost::program_options::value;
+    unsigned number_of_nodes;
+    unsigned warmup;
+    unsigned repetitions;
+    std::string filter;
+
+    boost::program_options::options_description options("Options");
+    options.add_options()("help,h", "Show this help message") //
+        ("nodes",
+         value<unsigned>(&number_of_nodes)->default_value(4000000),
+         "Number of nodes of the graphs and heaps, elements of the vectors and tables") //
+        ("warmup",
+         value<unsigned>(&warmup)->default_value(1),
+         "Unmeasured runs of every benchmark before the measured ones") //
+        ("repetitions,r",
+         value<unsigned>(&repetitions)->default_value(5),
+         "Measured runs of every benchmark") //
+        ("filter,f",
+         value<std::string>(&filter)->default_value(""),
+         "Only run the benchmarks whose name contains this");
+
+    boost::program_options::variables_map option_variables;
+    boost::program_options::store(boost::program_options::parse_command_line(argc, argv, options),
+                                  option_variables);
+    if (option_variables.count("help"))
+    {
+        std::cout << options << std::endl;
+        return EXIT_SUCCESS;
+    }
+    boost::program_options::notify(option_variables);
+
+    if (number_of_nodes < 2 * osrm::benchmarks::NEIGHBOUR_SPREAD + 1)
+    {
+        std::cerr << "At least " << 2 * osrm::benchmarks::NEIGHBOUR_SPREAD + 1 << " nodes needed"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    osrm::benchmarks::MicroBenchmarkRunner runner(warmup, repetitions, filter);
+    osrm::benchmarks::benchmarkHeaps(runner, number_of_nodes);
+    osrm::benchmarks::benchmarkStaticGraph(runner, number_of_nodes);
+    osrm::benchmarks::benchmarkPackedVector(runner, number_of_nodes);
+    osrm::benchmarks::benchmarkRangeTable(runner, number_of_nodes);
+    osrm::benchmarks::benchmarkGeometries(runner);
+    std::cout << "checksum " << runner.GetChecksum() << std::endl;
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    std::cerr << "[error] " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
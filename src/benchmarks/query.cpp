@@ -0,0 +1,512 @@
+#include "engine/search_engine_data.hpp"
+#include "engine/search_statistics.hpp"
+#include "extractor/query_node.hpp"
+#include "util/allocation_statistics.hpp"
+#include "util/coordinate_calculation.hpp"
+#include "util/timing_util.hpp"
+
+#include "osrm/match_parameters.hpp"
+#include "osrm/nearest_parameters.hpp"
+#include "osrm/route_parameters.hpp"
+#include "osrm/table_parameters.hpp"
+#include "osrm/tile_parameters.hpp"
+#include "osrm/trip_parameters.hpp"
+
+#include "osrm/coordinate.hpp"
+#include "osrm/engine_config.hpp"
+#include "osrm/json_container.hpp"
+
+#include "osrm/osrm.hpp"
+#include "osrm/status.hpp"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/math/constants/constants.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdlib>
+
+// Benchmarks the services of the routing machine on queries generated from the nodes of a
+// dataset. The queries are drawn with a fixed seed before they are timed, so that runs on the same
+// dataset are comparable. Every case reports the percentiles of the latencies and the throughput
+// for each number of threads, route cases also the search space of their bidirectional search.
+// Builds with ENABLE_SEARCH_STATISTICS print the mean counts of the searches of every case too.
+
+namespace osrm
+{
+namespace benchmarks
+{
+
+constexpr unsigned DEFAULT_RANDOM_SEED = 1337;
+constexpr std::size_t DEFAULT_NUMBER_OF_QUERIES = 1000;
+
+// the radius around the origin of short routes, trips and traces
+constexpr double SHORT_DISTANCE = 5000.;
+
+std::vector<util::Coordinate> loadCoordinates(const boost::filesystem::path &nodes_file)
+{
+    boost::filesystem::ifstream nodes_input_stream(nodes_file, std::ios::binary);
+    if (!nodes_input_stream)
+    {
+        throw std::runtime_error("Could not open " + nodes_file.string() + " for reading.");
+    }
+
+    std::uint64_t coordinate_count = 0;
+    nodes_input_stream.read((char *)&coordinate_count, sizeof(std::uint64_t));
+    std::vector<util::Coordinate> coordinates(coordinate_count);
+    extractor::QueryNode current_node;
+    for (std::uint64_t i = 0; i < coordinate_count; ++i)
+    {
+        nodes_input_stream.read((char *)&current_node, sizeof(extractor::QueryNode));
+        coordinates[i] = util::Coordinate(current_node.lon, current_node.lat);
+    }
+    if (coordinates.empty())
+    {
+        throw std::runtime_error(nodes_file.string() + " has no nodes.");
+    }
+    return coordinates;
+}
+
+// Draws origins and destinations from the nodes of the dataset
+class QueryGenerator
+{
+  public:
+    QueryGenerator(std::vector<util::Coordinate> coordinates_, const unsigned seed)
+        : coordinates(std::move(coordinates_)), generator(seed)
+    {
+    }
+
+    util::Coordinate Any()
+    {
+        std::uniform_int_distribution<std::size_t> index(0, coordinates.size() - 1);
+        return coordinates[index(generator)];
+    }
+
+    // A location at most `radius` meters away from `origin`, off the network in general
+    util::Coordinate Near(const util::Coordinate origin, const double radius)
+    {
+        using namespace boost::math::constants;
+        std::uniform_real_distribution<double> direction(0., two_pi<double>());
+        std::uniform_real_distribution<double> fraction(0., 1.);
+        const auto angle = direction(generator);
+        const auto distance = radius * std::sqrt(fraction(generator));
+        const auto latitude = static_cast<double>(toFloating(origin.lat));
+        const auto degrees_per_meter = static_cast<double>(
+            1. / (util::coordinate_calculation::detail::EARTH_RADIUS * degree<double>()));
+        const auto lat = latitude + distance * std::cos(angle) * degrees_per_meter;
+        const auto lon = static_cast<double>(toFloating(origin.lon)) +
+                         distance * std::sin(angle) * degrees_per_meter /
+                             std::max(0.01, std::cos(latitude * degree<double>()));
+        return util::Coordinate(util::FloatLongitude{std::max(-180., std::min(180., lon))},
+                                util::FloatLatitude{std::max(-85., std::min(85., lat))});
+    }
+
+    std::vector<util::Coordinate> Cluster(const std::size_t count, const double radius)
+    {
+        std::vector<util::Coordinate> cluster{Any()};
+        while (cluster.size() < count)
+        {
+            cluster.push_back(Near(cluster.front(), radius));
+        }
+        return cluster;
+    }
+
+  private:
+    std::vector<util::Coordinate> coordinates;
+    std::mt19937 generator;
+};
+
+// Nodes inserted into the heaps of the last bidirectional search on this thread
+std::size_t searchSpace()
+{
+    const auto &forward_heap = engine::SearchEngineData::forward_heap_1;
+    const auto &reverse_heap = engine::SearchEngineData::reverse_heap_1;
+    if (forward_heap.get() == nullptr || reverse_heap.get() == nullptr)
+    {
+        return 0;
+    }
+    return forward_heap->NumberOfInsertedNodes() + reverse_heap->NumberOfInsertedNodes();
+}
+
+struct Options
+{
+    std::size_t number_of_queries = DEFAULT_NUMBER_OF_QUERIES;
+    unsigned seed = DEFAULT_RANDOM_SEED;
+    std::vector<unsigned> thread_counts;
+};
+
+// Runs `query(i)` for every i in [0, count) on each number of threads, the query returns whether
+// it succeeded
+void runCase(const std::string &name,
+             const std::size_t count,
+             const Options &options,
+             const bool report_search_space,
+             const std::function<bool(std::size_t)> &query)
+{
+    if (count == 0)
+    {
+        std::cout << name << ": no queries" << std::endl;
+        return;
+    }
+
+    for (const auto thread_count : options.thread_counts)
+    {
+        std::vector<double> latencies(count);
+        std::vector<std::size_t> search_spaces(count);
+        std::vector<engine::SearchStatistics> statistics(count);
+        std::vector<util::AllocationStatistics> allocations(count);
+        std::atomic<std::size_t> next_query{0};
+        std::atomic<std::size_t> failures{0};
+
+        const auto worker = [&] {
+            // the queries of the thread nest into its lease, which keeps their heaps readable
+            engine::SearchEngineData::Lease heap_lease;
+            for (auto index = next_query++; index < count; index = next_query++)
+            {
+                const auto allocations_before = util::GetAllocationStatistics();
+                TIMER_START(query);
+                const auto ok = query(index);
+                TIMER_STOP(query);
+                allocations[index] = util::GetAllocationStatistics();
+                allocations[index] -= allocations_before;
+                latencies[index] = TIMER_MSEC(query);
+                search_spaces[index] = report_search_space ? searchSpace() : 0;
+                statistics[index] = engine::GetSearchStatistics();
+                if (!ok)
+                {
+                    ++failures;
+                }
+            }
+        };
+
+        TIMER_START(run);
+        std::vector<std::thread> threads;
+        for (unsigned thread = 0; thread < thread_count; ++thread)
+        {
+            threads.emplace_back(worker);
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        TIMER_STOP(run);
+
+        std::sort(latencies.begin(), latencies.end());
+        const auto percentile = [&latencies](const double p) {
+            return latencies[std::min(latencies.size() - 1,
+                                      static_cast<std::size_t>(p * latencies.size()))];
+        };
+
+        std::cout << std::left << std::setw(28) << name << std::right << std::setw(3)
+                  << thread_count << " threads  " << std::setw(6) << count << " queries  "
+                  << std::fixed << std::setprecision(3) << "p50 " << std::setw(9)
+                  << percentile(0.5) << " ms  p90 " << std::setw(9) << percentile(0.9)
+                  << " ms  p99 " << std::setw(9) << percentile(0.99) << " ms  max " << std::setw(9)
+                  << latencies.back() << " ms  " << std::setprecision(1) << std::setw(9)
+                  << count / TIMER_SEC(run) << " q/s";
+        if (report_search_space)
+        {
+            std::sort(search_spaces.begin(), search_spaces.end());
+            std::cout << "  search space p50 " << search_spaces[search_spaces.size() / 2];
+        }
+        if (failures > 0)
+        {
+            std::cout << "  (" << failures << " failed)";
+        }
+        std::cout << std::endl;
+
+        if (engine::SEARCH_STATISTICS_ENABLED)
+        {
+            engine::SearchStatistics total;
+            for (const auto &query_statistics : statistics)
+            {
+                total += query_statistics;
+            }
+            std::cout << "    per query: " << std::setprecision(1)
+                      << total.settled_nodes / static_cast<double>(count) << " settled, "
+                      << total.relaxed_edges / static_cast<double>(count) << " relaxed, "
+                      << total.stalled_nodes / static_cast<double>(count) << " stalled, "
+                      << total.heap_inserts / static_cast<double>(count) << " inserts, "
+                      << total.heap_decrease_keys / static_cast<double>(count)
+                      << " decrease-keys, " << total.unpacked_edges / static_cast<double>(count)
+                      << " unpacked edges" << std::endl;
+        }
+
+        if (util::ALLOCATION_TRACKING_ENABLED)
+        {
+            util::AllocationStatistics total;
+            for (const auto &query_allocations : allocations)
+            {
+                total += query_allocations;
+            }
+            std::cout << "    allocations per query: " << std::setprecision(1);
+            util::writeAllocationStatistics(std::cout, total, static_cast<double>(count));
+            std::cout << std::endl;
+        }
+    }
+}
+
+void benchmarkRoutes(const OSRM &osrm, QueryGenerator &generator, const Options &options)
+{
+    const auto count = options.number_of_queries;
+    std::vector<std::vector<util::Coordinate>> short_routes, long_routes;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        short_routes.push_back(generator.Cluster(2, SHORT_DISTANCE));
+        long_routes.push_back({generator.Any(), generator.Any()});
+    }
+
+    const auto route = [&osrm](const std::vector<util::Coordinate> &coordinates,
+                               const bool steps,
+                               const bool alternatives) {
+        RouteParameters params;
+        params.coordinates = coordinates;
+        params.steps = steps;
+        params.alternatives = alternatives;
+        json::Object result;
+        return osrm.Route(params, result) == Status::Ok;
+    };
+
+    for (const auto steps : {false, true})
+    {
+        for (const auto alternatives : {false, true})
+        {
+            const std::string flags = std::string(steps ? " +steps" : "") +
+                                      std::string(alternatives ? " +alternatives" : "");
+            runCase("route short" + flags, count, options, true, [&](const std::size_t i) {
+                return route(short_routes[i], steps, alternatives);
+            });
+            runCase("route long" + flags, count, options, true, [&](const std::size_t i) {
+                return route(long_routes[i], steps, alternatives);
+            });
+        }
+    }
+}
+
+void benchmarkTables(const OSRM &osrm, QueryGenerator &generator, const Options &options)
+{
+    const std::vector<std::pair<std::size_t, std::size_t>> sizes = {
+        {1, 100}, {10, 10}, {10, 100}, {100, 100}, {250, 250}};
+    for (const auto &size : sizes)
+    {
+        // larger tables get fewer queries, at least 10
+        const auto count = std::max<std::size_t>(
+            10, std::min(options.number_of_queries,
+                         options.number_of_queries * 100 / (size.first * size.second)));
+
+        std::vector<TableParameters> queries(count);
+        for (auto &params : queries)
+        {
+            params.coordinates = generator.Cluster(size.first + size.second, 10 * SHORT_DISTANCE);
+            for (std::size_t i = 0; i < size.first; ++i)
+            {
+                params.sources.push_back(i);
+            }
+            for (std::size_t i = 0; i < size.second; ++i)
+            {
+                params.destinations.push_back(size.first + i);
+            }
+        }
+
+        runCase("table " + std::to_string(size.first) + "x" + std::to_string(size.second),
+                count,
+                options,
+                false,
+                [&](const std::size_t i) {
+                    json::Object result;
+                    return osrm.Table(queries[i], result) == Status::Ok;
+                });
+    }
+}
+
+void benchmarkNearest(const OSRM &osrm, QueryGenerator &generator, const Options &options)
+{
+    const auto count = options.number_of_queries;
+    for (const unsigned number_of_results : {1, 10})
+    {
+        std::vector<NearestParameters> queries(count);
+        for (auto &params : queries)
+        {
+            params.coordinates.push_back(generator.Near(generator.Any(), 100.));
+            params.number_of_results = number_of_results;
+        }
+
+        runCase("nearest " + std::to_string(number_of_results),
+                count,
+                options,
+                false,
+                [&](const std::size_t i) {
+                    json::Object result;
+                    return osrm.Nearest(queries[i], result) == Status::Ok;
+                });
+    }
+}
+
+void benchmarkTrips(const OSRM &osrm, QueryGenerator &generator, const Options &options)
+{
+    for (const std::size_t size : {5, 25})
+    {
+        const auto count = std::max<std::size_t>(10, options.number_of_queries / size);
+        std::vector<TripParameters> queries(count);
+        for (auto &params : queries)
+        {
+            params.coordinates = generator.Cluster(size, SHORT_DISTANCE);
+        }
+
+        runCase("trip " + std::to_string(size), count, options, false, [&](const std::size_t i) {
+            json::Object result;
+            return osrm.Trip(queries[i], result) == Status::Ok;
+        });
+    }
+}
+
+// Traces follow the geometries of routes between random locations, with a point every few
+// coordinates of the geometry
+void benchmarkMatch(const OSRM &osrm, QueryGenerator &generator, const Options &options)
+{
+    const auto count = std::max<std::size_t>(10, options.number_of_queries / 10);
+    std::vector<MatchParameters> queries;
+    for (std::size_t attempt = 0; queries.size() < count && attempt < 10 * count; ++attempt)
+    {
+        RouteParameters route;
+        route.coordinates = generator.Cluster(2, SHORT_DISTANCE);
+        route.geometries = RouteParameters::GeometriesType::GeoJSON;
+        route.overview = RouteParameters::OverviewType::Full;
+        json::Object result;
+        if (osrm.Route(route, result) != Status::Ok)
+        {
+            continue;
+        }
+
+        const auto &geometry = result.values.at("routes")
+                                   .get<json::Array>()
+                                   .values.front()
+                                   .get<json::Object>()
+                                   .values.at("geometry")
+                                   .get<json::Object>()
+                                   .values.at("coordinates")
+                                   .get<json::Array>()
+                                   .values;
+        MatchParameters params;
+        params.overview = RouteParameters::OverviewType::False;
+        for (std::size_t i = 0; i < geometry.size() && params.coordinates.size() < 100; i += 3)
+        {
+            const auto &position = geometry[i].get<json::Array>().values;
+            params.coordinates.emplace_back(
+                util::FloatLongitude{position[0].get<json::Number>().value},
+                util::FloatLatitude{position[1].get<json::Number>().value});
+        }
+        if (params.coordinates.size() >= 2)
+        {
+            queries.push_back(std::move(params));
+        }
+    }
+
+    runCase("match", queries.size(), options, false, [&](const std::size_t i) {
+        json::Object result;
+        return osrm.Match(queries[i], result) == Status::Ok;
+    });
+}
+
+void benchmarkTiles(const OSRM &osrm, QueryGenerator &generator, const Options &options)
+{
+    const auto count = std::max<std::size_t>(10, options.number_of_queries / 10);
+    for (const unsigned zoom : {14, 17})
+    {
+        std::vector<TileParameters> queries;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            using namespace boost::math::constants;
+            const auto location = generator.Any();
+            const auto tiles = static_cast<double>(1u << zoom);
+            const auto lon = static_cast<double>(toFloating(location.lon));
+            const auto lat = static_cast<double>(toFloating(location.lat)) * degree<double>();
+            const auto x = (lon + 180.) / 360. * tiles;
+            const auto y =
+                (1. - std::log(std::tan(lat) + 1. / std::cos(lat)) / pi<double>()) / 2. * tiles;
+            queries.push_back(TileParameters{
+                std::min(static_cast<unsigned>(x), static_cast<unsigned>(tiles) - 1),
+                std::min(static_cast<unsigned>(std::max(0., y)), static_cast<unsigned>(tiles) - 1),
+                zoom});
+        }
+
+        runCase("tile z" + std::to_string(zoom), count, options, false, [&](const std::size_t i) {
+            std::string result;
+            return osrm.Tile(queries[i], result) == Status::Ok;
+        });
+    }
+}
+}
+}
+
+int main(int argc, const char *argv[]) try
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " data.osrm [number of queries [random seed [thread counts...]]]\n";
+        return EXIT_FAILURE;
+    }
+
+    using namespace osrm;
+
+    benchmarks::Options options;
+    if (argc > 2)
+    {
+        options.number_of_queries = std::stoul(argv[2]);
+    }
+    if (argc > 3)
+    {
+        options.seed = std::stoul(argv[3]);
+    }
+    for (int arg = 4; arg < argc; ++arg)
+    {
+        options.thread_counts.push_back(std::stoul(argv[arg]));
+    }
+    if (options.thread_counts.empty())
+    {
+        options.thread_counts.push_back(1);
+        if (std::thread::hardware_concurrency() > 1)
+        {
+            options.thread_counts.push_back(std::thread::hardware_concurrency());
+        }
+    }
+
+    // Configure based on a .osrm base path, and no datasets in shared mem from osrm-datastore
+    EngineConfig config;
+    config.storage_config = {argv[1]};
+    config.use_shared_memory = false;
+
+    OSRM osrm{config};
+
+    benchmarks::QueryGenerator generator(
+        benchmarks::loadCoordinates(config.storage_config.nodes_data_path), options.seed);
+
+    std::cout << "Seed " << options.seed << ", " << options.number_of_queries
+              << " queries per case" << std::endl;
+
+    benchmarks::benchmarkRoutes(osrm, generator, options);
+    benchmarks::benchmarkTables(osrm, generator, options);
+    benchmarks::benchmarkNearest(osrm, generator, options);
+    benchmarks::benchmarkTrips(osrm, generator, options);
+    benchmarks::benchmarkMatch(osrm, generator, options);
+    benchmarks::benchmarkTiles(osrm, generator, options);
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
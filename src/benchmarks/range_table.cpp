@@ -0,0 +1,72 @@
+#include "util/range_table.hpp"
+#include "util/timing_util.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace benchmarks
+{
+
+// Choosen by a fair W20 dice roll (this value is completely arbitrary)
+constexpr unsigned RANDOM_SEED = 13;
+
+template <unsigned BLOCK_SIZE>
+void benchmarkBlockSize(const std::vector<unsigned> &lengths, const std::vector<unsigned> &queries)
+{
+    const util::RangeTable<BLOCK_SIZE, false> table(lengths);
+    const auto table_bytes = lengths.size() / (BLOCK_SIZE + 1) * (BLOCK_SIZE + sizeof(unsigned));
+
+    std::uint64_t checksum = 0;
+    TIMER_START(query);
+    for (const auto id : queries)
+    {
+        const auto range = table.GetRange(id);
+        checksum += range.front() + range.size();
+    }
+    TIMER_STOP(query);
+
+    std::cout << "Block size " << BLOCK_SIZE << " (" << table_bytes / 1024 << " KiB): took "
+              << TIMER_MSEC(query) << "ms  ->  " << TIMER_NSEC(query) / queries.size()
+              << " ns/lookup (checksum " << checksum << ")" << std::endl;
+}
+
+void benchmark(const unsigned num_ranges, const unsigned num_queries)
+{
+    // lengths like the ones of names: mostly short, some empty
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<unsigned> length_udist(0, 40);
+    std::vector<unsigned> lengths(num_ranges);
+    for (auto &length : lengths)
+    {
+        length = length_udist(mt_rand);
+    }
+
+    std::uniform_int_distribution<unsigned> id_udist(0, num_ranges - 1);
+    std::vector<unsigned> queries(num_queries);
+    for (auto &id : queries)
+    {
+        id = id_udist(mt_rand);
+    }
+
+    benchmarkBlockSize<8>(lengths, queries);
+    benchmarkBlockSize<16>(lengths, queries);
+    benchmarkBlockSize<32>(lengths, queries);
+    benchmarkBlockSize<64>(lengths, queries);
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned num_ranges = argc > 1 ? std::stoul(argv[1]) : 10000000;
+    const unsigned num_queries = argc > 2 ? std::stoul(argv[2]) : 10000000;
+
+    osrm::benchmarks::benchmark(num_ranges, num_queries);
+
+    return 0;
+}
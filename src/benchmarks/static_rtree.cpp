@@ -25,7 +25,7 @@ constexpr int32_t WORLD_MAX_LAT = 90 * COORDINATE_PRECISION;
 constexpr int32_t WORLD_MIN_LON = -180 * COORDINATE_PRECISION;
 constexpr int32_t WORLD_MAX_LON = 180 * COORDINATE_PRECISION;
 
-using RTreeLeaf = extractor::EdgeBasedNode;
+using RTreeLeaf = extractor::EdgeBasedNodeSegment;
 using BenchStaticRTree =
     util::StaticRTree<RTreeLeaf, util::ShM<util::Coordinate, false>::vector, false>;
 
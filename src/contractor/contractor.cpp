@@ -1,6 +1,10 @@
 #include "contractor/contractor.hpp"
+#include "contractor/core_landmarks.hpp"
 #include "contractor/crc32_processor.hpp"
+#include "contractor/customizable_contractor.hpp"
+#include "contractor/geographic_partition.hpp"
 #include "contractor/graph_contractor.hpp"
+#include "contractor/multi_level_customizer.hpp"
 
 #include "extractor/compressed_edge_container.hpp"
 #include "extractor/edge_based_graph_factory.hpp"
@@ -10,7 +14,11 @@
 #include "util/graph_loader.hpp"
 #include "util/integer_range.hpp"
 #include "util/io.hpp"
+#include "util/json_writer.hpp"
+#include "util/multi_level_graph.hpp"
+#include "util/phase_profiler.hpp"
 #include "util/simple_logger.hpp"
+#include "util/speed_profile.hpp"
 #include "util/static_graph.hpp"
 #include "util/static_rtree.hpp"
 #include "util/string_util.hpp"
@@ -19,6 +27,7 @@
 
 #include <boost/assert.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
 #include <boost/functional/hash.hpp>
 #include <boost/interprocess/file_mapping.hpp>
 #include <boost/interprocess/mapped_region.hpp>
@@ -31,14 +40,20 @@
 #include <tbb/parallel_for_each.h>
 #include <tbb/parallel_invoke.h>
 #include <tbb/parallel_sort.h>
-#include <tbb/spin_mutex.h>
+
+#include <stxxl/sort>
 
 #include <algorithm>
+#include <array>
 #include <bitset>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iterator>
+#include <limits>
+#include <map>
 #include <memory>
+#include <numeric>
 #include <thread>
 #include <tuple>
 #include <vector>
@@ -123,7 +138,7 @@ int Contractor::Run()
 #else
     static_assert(sizeof(extractor::NodeBasedEdge) == 24,
                   "changing extractor::NodeBasedEdge type has influence on memory consumption!");
-    static_assert(sizeof(extractor::EdgeBasedEdge) == 16,
+    static_assert(sizeof(extractor::EdgeBasedEdge) == 20,
                   "changing EdgeBasedEdge type has influence on memory consumption!");
 #endif
 
@@ -131,8 +146,34 @@ int Contractor::Run()
     {
         throw util::exception("Core factor must be between 0.0 to 1.0 (inclusive)");
     }
+    if (config.customizable && config.core_factor < 1.0)
+    {
+        throw util::exception("A customizable hierarchy contracts all nodes, it has no core");
+    }
+    if (config.core_landmarks > 0 && config.core_factor == 1.0)
+    {
+        throw util::exception("Core landmarks need a core, contract with --core below 1.0");
+    }
+    if (config.multi_level && (config.customizable || config.cell >= 0))
+    {
+        throw util::exception("A multi-level overlay graph is neither a customizable hierarchy "
+                              "nor the shard of a cell");
+    }
+
+    // all metrics of a dataset are contracted in the node order of the default metric
+    const auto &order_path =
+        config.multi_level
+            ? config.mld_partition_path
+            : (config.customizable ? config.rank_output_path : config.level_output_path);
+    if (!config.metric.empty() && config.cell < 0 && !boost::filesystem::exists(order_path))
+    {
+        throw util::exception("The metric " + config.metric + " needs the node order in " +
+                              order_path + ", contract the default metric first");
+    }
 
     TIMER_START(preparing);
+    util::PhaseProfiler phase_profiler;
+    phase_profiler.Start("loading");
 
     util::SimpleLogger().Write() << "Loading edge-expanded graph representation";
 
@@ -146,47 +187,108 @@ int Contractor::Run()
                                                config.turn_penalty_lookup_paths,
                                                config.node_based_graph_path,
                                                config.geometry_path,
+                                               config.geometry_output_path,
                                                config.datasource_names_path,
                                                config.datasource_indexes_path,
                                                config.rtree_leaf_path,
-                                               config.log_edge_updates_factor);
+                                               config.log_edge_updates_factor,
+                                               config.cache_lookup_files);
+    WriteSpeedProfiles();
+    if (config.excluded_classes != 0)
+    {
+        ExcludeClasses(edge_based_edge_list);
+    }
+    if (config.cell >= 0)
+    {
+        ExtractShard(edge_based_edge_list);
+    }
+
+    phase_profiler.Stop();
+
+    if (config.multi_level)
+    {
+        phase_profiler.Start("customization");
+        BuildMultiLevelGraph(max_edge_id, edge_based_edge_list);
+        phase_profiler.Stop();
+        TIMER_STOP(preparing);
+        util::SimpleLogger().Write() << "Preprocessing : " << TIMER_SEC(preparing) << " seconds";
+        util::SimpleLogger().Write() << "finished preprocessing";
+        if (!config.phase_report_path.empty())
+        {
+            phase_profiler.Write(config.phase_report_path);
+        }
+        return 0;
+    }
 
     // Contracting the edge-expanded graph
 
     TIMER_START(contraction);
+    phase_profiler.Start("contraction");
     std::vector<bool> is_core_node;
     std::vector<float> node_levels;
-    if (config.use_cached_priority)
-    {
-        ReadNodeLevels(node_levels);
-    }
-
-    util::SimpleLogger().Write() << "Reading node weights.";
-    std::vector<EdgeWeight> node_weights;
-    std::string node_file_name = config.osrm_input_path.string() + ".enw";
-    if (util::deserializeVector(node_file_name, node_weights))
+    stxxl::vector<QueryEdge> contracted_edge_list;
+    if (config.customizable)
     {
-        util::SimpleLogger().Write() << "Done reading node weights.";
+        CustomizeGraph(max_edge_id, edge_based_edge_list, contracted_edge_list);
     }
     else
     {
-        throw util::exception("Failed reading node weights.");
-    }
+        if (config.use_cached_priority)
+        {
+            ReadNodeLevels(node_levels);
+        }
 
-    util::DeallocatingVector<QueryEdge> contracted_edge_list;
-    ContractGraph(max_edge_id,
-                  edge_based_edge_list,
-                  contracted_edge_list,
-                  std::move(node_weights),
-                  is_core_node,
-                  node_levels);
+        util::SimpleLogger().Write() << "Reading node weights.";
+        std::vector<EdgeWeight> node_weights;
+        std::string node_file_name = config.osrm_input_path.string() + ".enw";
+        if (util::deserializeVector(node_file_name, node_weights))
+        {
+            util::SimpleLogger().Write() << "Done reading node weights.";
+        }
+        else
+        {
+            throw util::exception("Failed reading node weights.");
+        }
+
+        ContractGraph(max_edge_id,
+                      edge_based_edge_list,
+                      contracted_edge_list,
+                      std::move(node_weights),
+                      is_core_node,
+                      node_levels);
+    }
+    phase_profiler.Stop();
     TIMER_STOP(contraction);
 
     util::SimpleLogger().Write() << "Contraction took " << TIMER_SEC(contraction) << " sec";
 
+    if (config.renumber_nodes)
+    {
+        RenumberNodes(max_edge_id, contracted_edge_list, is_core_node);
+    }
+    else if (boost::filesystem::exists(config.renumbering_output_path))
+    {
+        // the hierarchy of a previous run was stored in another order
+        boost::filesystem::remove(config.renumbering_output_path);
+    }
+
+    if (config.core_landmarks > 0 && !is_core_node.empty())
+    {
+        phase_profiler.Start("core_landmarks");
+        WriteCoreLandmarks(contracted_edge_list, is_core_node);
+        phase_profiler.Stop();
+    }
+    else if (boost::filesystem::exists(config.core_landmarks_output_path))
+    {
+        // the landmarks of a previous run belong to another core
+        boost::filesystem::remove(config.core_landmarks_output_path);
+    }
+
+    phase_profiler.Start("write_contracted_graph");
     std::size_t number_of_used_edges = WriteContractedGraph(max_edge_id, contracted_edge_list);
+    phase_profiler.Stop();
     WriteCoreNodeMarker(std::move(is_core_node));
-    if (!config.use_cached_priority)
+    if (!config.use_cached_priority && !config.customizable)
     {
         WriteNodeLevels(std::move(node_levels));
     }
@@ -200,6 +302,11 @@ int Contractor::Run()
 
     util::SimpleLogger().Write() << "finished preprocessing";
 
+    if (!config.phase_report_path.empty())
+    {
+        phase_profiler.Write(config.phase_report_path);
+    }
+
     return 0;
 }
 
@@ -234,6 +341,25 @@ struct SegmentSpeedSource final
     }
 };
 
+struct SpeedProfileSource final
+{
+    // speed in km/h for every slot, 0 keeps the static speed
+    std::array<std::uint8_t, util::SPEED_PROFILE_SLOTS> speeds;
+    std::uint8_t source;
+};
+
+struct SegmentSpeedProfileSource final
+{
+    Segment segment;
+    SpeedProfileSource profile_source;
+    // < operator is overloaded here to return a > comparison to be used by the
+    // std::lower_bound() call in the find() function
+    bool operator<(const SegmentSpeedProfileSource &other) const
+    {
+        return std::tie(segment.from, segment.to) > std::tie(other.segment.from, other.segment.to);
+    }
+};
+
 struct Turn final
 {
     OSMNodeID from, via, to;
@@ -262,6 +388,7 @@ struct TurnPenaltySource final
 };
 using TurnPenaltySourceFlatMap = std::vector<TurnPenaltySource>;
 using SegmentSpeedSourceFlatMap = std::vector<SegmentSpeedSource>;
+using SegmentSpeedProfileSourceFlatMap = std::vector<SegmentSpeedProfileSource>;
 
 // Find is a binary Search over a flattened key,val Segment storage
 // It takes the flat map and a Segment/PenaltySource object that has an overloaded
@@ -278,188 +405,464 @@ auto find(const FlatMap &map, const SegmentKey &key)
     return last;
 }
 
-// Functions for parsing files and creating lookup tables
+// Speed tables of at least this size are joined with the sorted segments instead of searched
+const constexpr std::size_t MERGE_JOIN_MIN_SPEEDS = 1024 * 1024;
+const constexpr std::size_t MERGE_JOIN_GRAIN_SIZE = 64 * 1024;
 
-SegmentSpeedSourceFlatMap
-parse_segment_lookup_from_csv_files(const std::vector<std::string> &segment_speed_filenames)
+// Memory for sorting the contracted edges and edges per write when serializing them
+const constexpr std::size_t CONTRACTED_EDGE_SORT_MEMORY = 1024 * 1024 * 1024;
+const constexpr std::size_t CONTRACTED_EDGE_CHUNK_SIZE = 64 * 1024;
+
+// Needed for STXXL comparison - STXXL requires max_value(), min_value(), so we can not use
+// std::less<QueryEdge>{}
+struct QueryEdgeSTXXLLess
 {
-    // TODO: shares code with turn penalty lookup parse function
+    using value_type = QueryEdge;
+    value_type min_value() const { return QueryEdge(0, 0, QueryEdge::EdgeData()); }
+    value_type max_value() const
+    {
+        return QueryEdge(SPECIAL_NODEID, SPECIAL_NODEID, QueryEdge::EdgeData());
+    }
+    bool operator()(const value_type &lhs, const value_type &rhs) const { return lhs < rhs; }
+};
 
-    using Mutex = tbb::spin_mutex;
+// Writes the statistics of a contraction round as one line of JSON
+void writeRoundStatistics(std::ostream &stream, const GraphContractor::RoundStatistics &statistics)
+{
+    util::json::Writer writer;
+    writer.BeginObject();
+    writer.Key("round");
+    writer.Number(statistics.round);
+    writer.Key("remaining_nodes");
+    writer.Number(statistics.remaining_nodes);
+    writer.Key("independent_nodes");
+    writer.Number(statistics.independent_nodes);
+    writer.Key("witness_searches");
+    writer.Number(statistics.witness_searches);
+    writer.Key("shortcuts");
+    writer.Number(statistics.shortcuts);
+    writer.Key("edges");
+    writer.Number(statistics.edges);
+    writer.Key("max_resident_bytes");
+    writer.Number(statistics.max_resident_bytes);
+    writer.Key("flushed");
+    if (statistics.flushed)
+    {
+        writer.True();
+    }
+    else
+    {
+        writer.False();
+    }
+    writer.Key("phase_ms");
+    writer.BeginObject();
+    writer.Key("flush");
+    writer.Number(statistics.flush_ms);
+    writer.Key("independent_set");
+    writer.Number(statistics.independent_set_ms);
+    writer.Key("contraction");
+    writer.Number(statistics.contraction_ms);
+    writer.Key("deletion");
+    writer.Number(statistics.deletion_ms);
+    writer.Key("insertion");
+    writer.Number(statistics.insertion_ms);
+    writer.Key("priority_update");
+    writer.Number(statistics.priority_update_ms);
+    writer.EndObject();
+    writer.EndObject();
+
+    const auto &buffer = writer.GetBuffer();
+    stream.write(buffer.data(), buffer.size());
+    stream << std::endl;
+}
 
-    // Loaded and parsed in parallel, at the end we combine results in a flattened map-ish view
-    SegmentSpeedSourceFlatMap flatten;
-    Mutex flatten_mutex;
+// New id of every node of the hierarchy. The nodes are grouped by their height above the bottom
+// of the hierarchy, highest first, since all upward searches end among the few top nodes.
+// Within a height the nodes follow a depth first search along the upward edges, so that nodes
+// whose searches share a part of the hierarchy are stored next to each other. The core nodes
+// are connected in both directions and are put on top.
+std::vector<NodeID> computeNodeRenumbering(const NodeID number_of_nodes,
+                                           const stxxl::vector<QueryEdge> &contracted_edge_list)
+{
+    // upward edges of every node as an adjacency array
+    std::vector<std::uint32_t> offsets(number_of_nodes + 1, 0);
+    for (const QueryEdge &edge : contracted_edge_list)
+    {
+        if (edge.source != edge.target)
+            ++offsets[edge.source + 1];
+    }
+    for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+    {
+        offsets[node + 1] += offsets[node];
+    }
+    std::vector<NodeID> targets(offsets.back());
+    std::vector<std::uint32_t> number_of_lower_nodes(number_of_nodes, 0);
+    {
+        auto next_target = offsets;
+        for (const QueryEdge &edge : contracted_edge_list)
+        {
+            if (edge.source != edge.target)
+            {
+                targets[next_target[edge.source]++] = edge.target;
+                ++number_of_lower_nodes[edge.target];
+            }
+        }
+    }
 
-    const auto parse_segment_speed_file = [&](const std::size_t idx) {
-        const auto file_id = idx + 1; // starts at one, zero means we assigned the weight
-        const auto filename = segment_speed_filenames[idx];
+    // heights in topological order, nodes on cycles are left in the core
+    std::vector<std::uint32_t> heights(number_of_nodes, 0);
+    std::vector<NodeID> queue;
+    queue.reserve(number_of_nodes);
+    for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+    {
+        if (number_of_lower_nodes[node] == 0)
+            queue.push_back(node);
+    }
+    std::uint32_t max_height = 0;
+    for (std::size_t index = 0; index < queue.size(); ++index)
+    {
+        const auto node = queue[index];
+        max_height = std::max(max_height, heights[node]);
+        for (auto edge = offsets[node]; edge < offsets[node + 1]; ++edge)
+        {
+            const auto target = targets[edge];
+            heights[target] = std::max(heights[target], heights[node] + 1);
+            if (--number_of_lower_nodes[target] == 0)
+                queue.push_back(target);
+        }
+    }
+    if (queue.size() < number_of_nodes)
+    {
+        for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+        {
+            if (number_of_lower_nodes[node] > 0)
+                heights[node] = max_height + 1;
+        }
+    }
+    queue.clear();
 
-        std::ifstream segment_speed_file{filename, std::ios::binary};
-        if (!segment_speed_file)
-            throw util::exception{"Unable to open segment speed file " + filename};
+    // preorder of a depth first search along the upward edges
+    std::vector<NodeID> preorder(number_of_nodes, SPECIAL_NODEID);
+    NodeID next_index = 0;
+    std::vector<NodeID> &stack = queue;
+    for (const auto start : util::irange<NodeID>(0, number_of_nodes))
+    {
+        if (preorder[start] != SPECIAL_NODEID)
+            continue;
+        stack.push_back(start);
+        while (!stack.empty())
+        {
+            const auto node = stack.back();
+            stack.pop_back();
+            if (preorder[node] != SPECIAL_NODEID)
+                continue;
+            preorder[node] = next_index++;
+            // the first target is visited first
+            for (auto edge = offsets[node + 1]; edge > offsets[node]; --edge)
+            {
+                if (preorder[targets[edge - 1]] == SPECIAL_NODEID)
+                    stack.push_back(targets[edge - 1]);
+            }
+        }
+    }
 
-        SegmentSpeedSourceFlatMap local;
+    std::vector<NodeID> order(number_of_nodes);
+    std::iota(order.begin(), order.end(), 0);
+    tbb::parallel_sort(order.begin(), order.end(), [&](const NodeID lhs, const NodeID rhs) {
+        return heights[lhs] > heights[rhs] ||
+               (heights[lhs] == heights[rhs] && preorder[lhs] < preorder[rhs]);
+    });
 
-        std::uint64_t from_node_id{};
-        std::uint64_t to_node_id{};
-        unsigned speed{};
+    std::vector<NodeID> renumbering(number_of_nodes);
+    for (const auto index : util::irange<NodeID>(0, number_of_nodes))
+    {
+        renumbering[order[index]] = index;
+    }
+    return renumbering;
+}
 
-        for (std::string line; std::getline(segment_speed_file, line);)
-        {
-            using namespace boost::spirit::qi;
+// Functions for parsing files and creating lookup tables
 
-            auto it = begin(line);
-            const auto last = end(line);
+// Files are split into chunks of about this size at line boundaries and parsed in parallel
+const constexpr std::size_t LOOKUP_FILE_CHUNK_SIZE = 8 * 1024 * 1024;
 
-            // The ulong_long -> uint64_t will likely break on 32bit platforms
-            const auto ok =
-                parse(it,
-                      last,                                                                  //
-                      (ulong_long >> ',' >> ulong_long >> ',' >> uint_ >> *(',' >> *char_)), //
-                      from_node_id,
-                      to_node_id,
-                      speed); //
+// Merges runs that are sorted by sort_by into one sorted run. Equal values keep the order of
+// their runs, so the merge is stable like sorting all runs at once.
+template <typename FlatMap, typename SortBy>
+FlatMap merge_sorted_runs(std::vector<FlatMap> &runs,
+                          const std::size_t first,
+                          const std::size_t last,
+                          const SortBy &sort_by)
+{
+    if (first == last)
+        return {};
+    if (last - first == 1)
+        return std::move(runs[first]);
+
+    const auto middle = first + (last - first) / 2;
+    FlatMap lhs, rhs;
+    tbb::parallel_invoke([&] { lhs = merge_sorted_runs(runs, first, middle, sort_by); },
+                         [&] { rhs = merge_sorted_runs(runs, middle, last, sort_by); });
+
+    FlatMap merged;
+    merged.reserve(lhs.size() + rhs.size());
+    std::merge(std::make_move_iterator(begin(lhs)),
+               std::make_move_iterator(end(lhs)),
+               std::make_move_iterator(begin(rhs)),
+               std::make_move_iterator(end(rhs)),
+               std::back_inserter(merged),
+               sort_by);
+    return merged;
+}
 
-            if (!ok || it != last)
-                throw util::exception{"Segment speed file " + filename + " malformed"};
+// Parses a lookup file in parallel chunks that start and end at line boundaries, every chunk is
+// sorted on its own. Returns the sorted runs in the order of the chunks.
+template <typename FlatMap, typename ParseLine, typename SortBy>
+std::vector<FlatMap> parse_lookup_file(const std::string &filename,
+                                       const std::string &description,
+                                       const ParseLine &parse_line,
+                                       const SortBy &sort_by)
+{
+    if (!boost::filesystem::exists(filename))
+        throw util::exception{"Unable to open " + description + " file " + filename};
+    if (boost::filesystem::file_size(filename) == 0)
+        return {};
+
+    const boost::interprocess::file_mapping mapping{filename.c_str(),
+                                                    boost::interprocess::read_only};
+    boost::interprocess::mapped_region region{mapping, boost::interprocess::read_only};
+    region.advise(boost::interprocess::mapped_region::advice_sequential);
+
+    const auto data = static_cast<const char *>(region.get_address());
+    const auto data_end = data + region.get_size();
+
+    // every chunk besides the first begins right after a newline
+    std::vector<const char *> chunk_begins{data};
+    while (chunk_begins.back() + LOOKUP_FILE_CHUNK_SIZE < data_end)
+    {
+        const auto newline = static_cast<const char *>(std::memchr(
+            chunk_begins.back() + LOOKUP_FILE_CHUNK_SIZE,
+            '\n',
+            data_end - (chunk_begins.back() + LOOKUP_FILE_CHUNK_SIZE)));
+        if (newline == nullptr || newline + 1 == data_end)
+            break;
+        chunk_begins.push_back(newline + 1);
+    }
+    chunk_begins.push_back(data_end);
 
-            SegmentSpeedSource val{{OSMNodeID{from_node_id}, OSMNodeID{to_node_id}},
-                                   {speed, static_cast<std::uint8_t>(file_id)}};
+    std::vector<FlatMap> runs(chunk_begins.size() - 1);
+    tbb::parallel_for(std::size_t{0}, runs.size(), [&](const std::size_t chunk) {
+        auto &run = runs[chunk];
+        const auto chunk_end = chunk_begins[chunk + 1];
+        for (auto line = chunk_begins[chunk]; line != chunk_end;)
+        {
+            const auto newline =
+                static_cast<const char *>(std::memchr(line, '\n', chunk_end - line));
+            const auto line_end = newline ? newline : chunk_end;
+
+            typename FlatMap::value_type value;
+            if (!parse_line(line, line_end, value))
+                throw util::exception{"Malformed " + description + " file " + filename +
+                                      " at byte " + std::to_string(line - data)};
+            run.push_back(std::move(value));
 
-            local.push_back(std::move(val));
+            line = newline ? newline + 1 : chunk_end;
         }
+        std::stable_sort(begin(run), end(run), sort_by);
+    });
 
-        util::SimpleLogger().Write() << "Loaded speed file " << filename << " with " << local.size()
-                                     << " speeds";
+    return runs;
+}
 
-        {
-            Mutex::scoped_lock _{flatten_mutex};
+// Parses the lookup files of the speeds or penalties, sorts them on their key and keeps the
+// value of the file that was given last. The lines of every file are parsed in parallel chunks.
+//
+// A binary copy <file>.bin of every parsed file can be kept, it is used instead of the file as
+// long as it is not older than it, which skips the text parsing on repeated updates.
+template <typename FlatMap, typename ParseLine, typename SourceOf>
+FlatMap parse_lookup_from_csv_files(const std::vector<std::string> &filenames,
+                                    const std::string &description,
+                                    const bool cache_lookup_files,
+                                    const ParseLine &parse_line,
+                                    const SourceOf &source_of)
+{
+    using Value = typename FlatMap::value_type;
 
-            flatten.insert(end(flatten),
-                           std::make_move_iterator(begin(local)),
-                           std::make_move_iterator(end(local)));
-        }
+    // The records compare greater on their key, so files later on get a higher precedence.
+    // Records of the same file keep their order, the first line of a key wins.
+    const auto sort_by = [&](const Value &lhs, const Value &rhs) {
+        return lhs < rhs || (!(rhs < lhs) && source_of(lhs) > source_of(rhs));
     };
 
-    tbb::parallel_for(std::size_t{0}, segment_speed_filenames.size(), parse_segment_speed_file);
-
-    // With flattened map-ish view of all the files, sort and unique them on from,to,source
-    // The greater '>' is used here since we want to give files later on higher precedence
-    const auto sort_by = [](const SegmentSpeedSource &lhs, const SegmentSpeedSource &rhs) {
-        return std::tie(lhs.segment.from, lhs.segment.to, lhs.speed_source.source) >
-               std::tie(rhs.segment.from, rhs.segment.to, rhs.speed_source.source);
+    // Unique only on the key to take the source precedence into account and remove duplicates
+    const auto unique_by = [](const Value &lhs, const Value &rhs) {
+        return lhs.segment == rhs.segment;
     };
 
-    std::stable_sort(begin(flatten), end(flatten), sort_by);
+    std::vector<FlatMap> runs;
+    for (const auto idx : util::irange<std::size_t>(0, filenames.size()))
+    {
+        const auto file_id = idx + 1; // starts at one, zero means we assigned the weight
+        const auto &filename = filenames[idx];
+        const auto cache_filename = filename + ".bin";
+
+        FlatMap cached;
+        if (cache_lookup_files && boost::filesystem::exists(filename) &&
+            boost::filesystem::exists(cache_filename) &&
+            boost::filesystem::last_write_time(cache_filename) >=
+                boost::filesystem::last_write_time(filename) &&
+            util::deserializeVector(cache_filename, cached))
+        {
+            for (auto &value : cached)
+                source_of(value) = static_cast<std::uint8_t>(file_id);
+
+            util::SimpleLogger().Write() << "Loaded " << description << " file " << filename
+                                         << " from " << cache_filename << " with "
+                                         << cached.size() << " values";
+            runs.push_back(std::move(cached));
+            continue;
+        }
 
-    // Unique only on from,to to take the source precedence into account and remove duplicates
-    const auto unique_by = [](const SegmentSpeedSource &lhs, const SegmentSpeedSource &rhs) {
-        return std::tie(lhs.segment.from, lhs.segment.to) ==
-               std::tie(rhs.segment.from, rhs.segment.to);
-    };
+        auto file_runs = parse_lookup_file<FlatMap>(
+            filename,
+            description,
+            [&](const char *first, const char *last, Value &value) {
+                source_of(value) = static_cast<std::uint8_t>(file_id);
+                return parse_line(first, last, value);
+            },
+            sort_by);
+
+        auto file_values = merge_sorted_runs(file_runs, 0, file_runs.size(), sort_by);
+        util::SimpleLogger().Write() << "Loaded " << description << " file " << filename
+                                     << " with " << file_values.size() << " values";
 
-    const auto it = std::unique(begin(flatten), end(flatten), unique_by);
+        if (cache_lookup_files)
+        {
+            file_values.erase(std::unique(begin(file_values), end(file_values), unique_by),
+                              end(file_values));
+            if (!util::serializeVector(cache_filename, file_values))
+                throw util::exception{"Unable to write " + description + " file cache " +
+                                      cache_filename};
+        }
+        runs.push_back(std::move(file_values));
+    }
 
-    flatten.erase(it, end(flatten));
+    auto map = merge_sorted_runs(runs, 0, runs.size(), sort_by);
+    map.erase(std::unique(begin(map), end(map), unique_by), end(map));
 
-    util::SimpleLogger().Write() << "In total loaded " << segment_speed_filenames.size()
-                                 << " speed file(s) with a total of " << flatten.size()
-                                 << " unique values";
+    util::SimpleLogger().Write() << "In total loaded " << filenames.size() << " " << description
+                                 << " file(s) with a total of " << map.size() << " unique values";
 
-    return flatten;
+    return map;
 }
 
-TurnPenaltySourceFlatMap
-parse_turn_penalty_lookup_from_csv_files(const std::vector<std::string> &turn_penalty_filenames)
+SegmentSpeedSourceFlatMap
+parse_segment_lookup_from_csv_files(const std::vector<std::string> &segment_speed_filenames,
+                                    const bool cache_lookup_files)
 {
-    using Mutex = tbb::spin_mutex;
+    const auto parse_line = [](const char *first, const char *last, SegmentSpeedSource &value) {
+        using namespace boost::spirit::qi;
 
-    // TODO: shares code with turn penalty lookup parse function
-    TurnPenaltySourceFlatMap map;
-    Mutex flatten_mutex;
+        std::uint64_t from_node_id{};
+        std::uint64_t to_node_id{};
 
-    const auto parse_turn_penalty_file = [&](const std::size_t idx) {
-        const auto file_id = idx + 1; // starts at one, zero means we assigned the weight
-        const auto filename = turn_penalty_filenames[idx];
+        // The ulong_long -> uint64_t will likely break on 32bit platforms
+        const auto ok =
+            parse(first,
+                  last,                                                                  //
+                  (ulong_long >> ',' >> ulong_long >> ',' >> uint_ >> *(',' >> *char_)), //
+                  from_node_id,
+                  to_node_id,
+                  value.speed_source.speed); //
+
+        value.segment = {OSMNodeID{from_node_id}, OSMNodeID{to_node_id}};
+        return ok && first == last;
+    };
 
-        std::ifstream turn_penalty_file{filename, std::ios::binary};
-        if (!turn_penalty_file)
-            throw util::exception{"Unable to open turn penalty file " + filename};
+    return parse_lookup_from_csv_files<SegmentSpeedSourceFlatMap>(
+        segment_speed_filenames,
+        "segment speed",
+        cache_lookup_files,
+        parse_line,
+        [](auto &value) -> auto & { return value.speed_source.source; });
+}
 
-        TurnPenaltySourceFlatMap local;
+SegmentSpeedProfileSourceFlatMap parse_segment_speed_profile_lookup_from_csv_files(
+    const std::vector<std::string> &segment_speed_profile_filenames, const bool cache_lookup_files)
+{
+    const auto parse_line = [](
+        const char *first, const char *last, SegmentSpeedProfileSource &value) {
+        using namespace boost::spirit::qi;
 
         std::uint64_t from_node_id{};
-        std::uint64_t via_node_id{};
         std::uint64_t to_node_id{};
-        double penalty{};
-
-        for (std::string line; std::getline(turn_penalty_file, line);)
+        std::vector<unsigned> speeds;
+
+        // The ulong_long -> uint64_t will likely break on 32bit platforms
+        const auto ok = parse(first,
+                              last, //
+                              (ulong_long >> ',' >> ulong_long >> +(',' >> uint_)), //
+                              from_node_id,
+                              to_node_id,
+                              speeds); //
+
+        // the slots of a line are spread evenly over the slots of the profile
+        if (!ok || first != last || util::SPEED_PROFILE_SLOTS % speeds.size() != 0 ||
+            std::any_of(speeds.begin(), speeds.end(), [](const unsigned speed) {
+                return speed > std::numeric_limits<std::uint8_t>::max();
+            }))
         {
-            using namespace boost::spirit::qi;
-
-            auto it = begin(line);
-            const auto last = end(line);
-
-            // The ulong_long -> uint64_t will likely break on 32bit platforms
-            const auto ok = parse(it,
-                                  last, //
-                                  (ulong_long >> ',' >> ulong_long >> ',' >> ulong_long >> ',' >>
-                                   double_ >> *(',' >> *char_)), //
-                                  from_node_id,
-                                  via_node_id,
-                                  to_node_id,
-                                  penalty); //
-
-            if (!ok || it != last)
-                throw util::exception{"Turn penalty file " + filename + " malformed"};
-
-            TurnPenaltySource val{
-                {OSMNodeID{from_node_id}, OSMNodeID{via_node_id}, OSMNodeID{to_node_id}},
-                {penalty, static_cast<std::uint8_t>(file_id)}};
-            local.push_back(std::move(val));
+            return false;
         }
-
-        util::SimpleLogger().Write() << "Loaded penalty file " << filename << " with "
-                                     << local.size() << " turn penalties";
-
+        const auto slots_per_speed = util::SPEED_PROFILE_SLOTS / speeds.size();
+        for (const auto slot : util::irange<std::size_t>(0, util::SPEED_PROFILE_SLOTS))
         {
-            Mutex::scoped_lock _{flatten_mutex};
-
-            map.insert(end(map),
-                       std::make_move_iterator(begin(local)),
-                       std::make_move_iterator(end(local)));
+            value.profile_source.speeds[slot] = speeds[slot / slots_per_speed];
         }
-    };
 
-    tbb::parallel_for(std::size_t{0}, turn_penalty_filenames.size(), parse_turn_penalty_file);
-
-    // With flattened map-ish view of all the files, sort and unique them on from,to,source
-    // The greater '>' is used here since we want to give files later on higher precedence
-    const auto sort_by = [](const TurnPenaltySource &lhs, const TurnPenaltySource &rhs) {
-        return std::tie(
-                   lhs.segment.from, lhs.segment.via, lhs.segment.to, lhs.penalty_source.source) >
-               std::tie(
-                   rhs.segment.from, rhs.segment.via, rhs.segment.to, rhs.penalty_source.source);
+        value.segment = {OSMNodeID{from_node_id}, OSMNodeID{to_node_id}};
+        return true;
     };
 
-    std::stable_sort(begin(map), end(map), sort_by);
-
-    // Unique only on from,to to take the source precedence into account and remove duplicates
-    const auto unique_by = [](const TurnPenaltySource &lhs, const TurnPenaltySource &rhs) {
-        return std::tie(lhs.segment.from, lhs.segment.via, lhs.segment.to) ==
-               std::tie(rhs.segment.from, rhs.segment.via, rhs.segment.to);
-    };
+    return parse_lookup_from_csv_files<SegmentSpeedProfileSourceFlatMap>(
+        segment_speed_profile_filenames,
+        "segment speed profile",
+        cache_lookup_files,
+        parse_line,
+        [](auto &value) -> auto & { return value.profile_source.source; });
+}
 
-    const auto it = std::unique(begin(map), end(map), unique_by);
+TurnPenaltySourceFlatMap
+parse_turn_penalty_lookup_from_csv_files(const std::vector<std::string> &turn_penalty_filenames,
+                                         const bool cache_lookup_files)
+{
+    const auto parse_line = [](const char *first, const char *last, TurnPenaltySource &value) {
+        using namespace boost::spirit::qi;
 
-    map.erase(it, end(map));
+        std::uint64_t from_node_id{};
+        std::uint64_t via_node_id{};
+        std::uint64_t to_node_id{};
 
-    util::SimpleLogger().Write() << "In total loaded " << turn_penalty_filenames.size()
-                                 << " turn penalty file(s) with a total of " << map.size()
-                                 << " unique values";
+        // The ulong_long -> uint64_t will likely break on 32bit platforms
+        const auto ok = parse(first,
+                              last, //
+                              (ulong_long >> ',' >> ulong_long >> ',' >> ulong_long >> ',' >>
+                               double_ >> *(',' >> *char_)), //
+                              from_node_id,
+                              via_node_id,
+                              to_node_id,
+                              value.penalty_source.penalty); //
+
+        value.segment = {OSMNodeID{from_node_id}, OSMNodeID{via_node_id}, OSMNodeID{to_node_id}};
+        return ok && first == last;
+    };
 
-    return map;
+    return parse_lookup_from_csv_files<TurnPenaltySourceFlatMap>(
+        turn_penalty_filenames,
+        "turn penalty",
+        cache_lookup_files,
+        parse_line,
+        [](auto &value) -> auto & { return value.penalty_source.source; });
 }
 } // anon ns
 
@@ -472,10 +875,12 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
     const std::vector<std::string> &turn_penalty_filenames,
     const std::string &nodes_filename,
     const std::string &geometry_filename,
+    const std::string &geometry_output_filename,
     const std::string &datasource_names_filename,
     const std::string &datasource_indexes_filename,
     const std::string &rtree_leaf_filename,
-    const double log_edge_updates_factor)
+    const double log_edge_updates_factor,
+    const bool cache_lookup_files)
 {
     if (segment_speed_filenames.size() > 255 || turn_penalty_filenames.size() > 255)
         throw util::exception("Limit of 255 segment speed and turn penalty files each reached");
@@ -542,12 +947,14 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
 
     const auto parse_segment_speeds = [&] {
         if (update_edge_weights)
-            segment_speed_lookup = parse_segment_lookup_from_csv_files(segment_speed_filenames);
+            segment_speed_lookup =
+                parse_segment_lookup_from_csv_files(segment_speed_filenames, cache_lookup_files);
     };
 
     const auto parse_turn_penalties = [&] {
         if (update_turn_penalties)
-            turn_penalty_lookup = parse_turn_penalty_lookup_from_csv_files(turn_penalty_filenames);
+            turn_penalty_lookup = parse_turn_penalty_lookup_from_csv_files(turn_penalty_filenames,
+                                                                           cache_lookup_files);
     };
 
     // If we update the edge weights, this file will hold the datasource information for each
@@ -643,7 +1050,7 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
         // Now, we iterate over all the segments stored in the StaticRTree, updating
         // the packed geometry weights in the `.geometries` file (note: we do not
         // update the RTree itself, we just use the leaf nodes to iterate over all segments)
-        using LeafNode = util::StaticRTree<extractor::EdgeBasedNode>::LeafNode;
+        using LeafNode = util::StaticRTree<extractor::EdgeBasedNodeSegment>::LeafNode;
 
         using boost::interprocess::mapped_region;
 
@@ -662,80 +1069,144 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
             counters_type(num_counters, 0));
         const constexpr auto LUA_SOURCE = 0;
 
-        tbb::parallel_for_each(first, last, [&](const LeafNode &current_node) {
-            auto &counters = segment_speeds_counters.local();
-            for (size_t i = 0; i < current_node.object_count; i++)
-            {
-                const auto &leaf_object = current_node.objects[i];
-                extractor::QueryNode *u;
-                extractor::QueryNode *v;
-
-                const unsigned forward_begin =
-                    m_geometry_indices.at(leaf_object.packed_geometry_id);
-                const auto current_fwd_weight =
-                    m_geometry_fwd_weight_list[forward_begin + leaf_object.fwd_segment_position];
-
-                u = &(internal_to_external_node_map
-                          [m_geometry_node_list[forward_begin + leaf_object.fwd_segment_position]]);
-                v = &(internal_to_external_node_map
-                          [m_geometry_node_list[forward_begin + leaf_object.fwd_segment_position +
-                                                1]]);
-
-                const double segment_length = util::coordinate_calculation::greatCircleDistance(
-                    util::Coordinate{u->lon, u->lat}, util::Coordinate{v->lon, v->lat});
-
-                auto forward_speed_iter = find(
-                    segment_speed_lookup, SegmentSpeedSource{{u->node_id, v->node_id}, {0, 0}});
-                if (forward_speed_iter != segment_speed_lookup.end())
-                {
-                    const auto new_segment_weight = getNewWeight(forward_speed_iter,
-                                                                 segment_length,
-                                                                 segment_speed_filenames,
-                                                                 current_fwd_weight,
-                                                                 log_edge_updates_factor);
-
-                    m_geometry_fwd_weight_list[forward_begin + 1 +
-                                               leaf_object.fwd_segment_position] =
-                        new_segment_weight;
-                    m_geometry_datasource[forward_begin + 1 + leaf_object.fwd_segment_position] =
-                        forward_speed_iter->speed_source.source;
-
-                    // count statistics for logging
-                    counters[forward_speed_iter->speed_source.source] += 1;
-                }
-                else
+        // Sets the weight of the segment that starts at position in the direction of the
+        // forward or reverse weights from its speed
+        const auto update_segment_weight = [&](const std::uint32_t position,
+                                               const bool reverse,
+                                               decltype(segment_speed_lookup.cbegin()) speed_iter) {
+            const auto &u = internal_to_external_node_map[m_geometry_node_list[position]];
+            const auto &v = internal_to_external_node_map[m_geometry_node_list[position + 1]];
+            const double segment_length = util::coordinate_calculation::greatCircleDistance(
+                util::Coordinate{u.lon, u.lat}, util::Coordinate{v.lon, v.lat});
+
+            auto &weights = reverse ? m_geometry_rev_weight_list : m_geometry_fwd_weight_list;
+            const auto weight_position = reverse ? position : position + 1;
+            weights[weight_position] = getNewWeight(speed_iter,
+                                                    segment_length,
+                                                    segment_speed_filenames,
+                                                    weights[position],
+                                                    log_edge_updates_factor);
+            m_geometry_datasource[weight_position] = speed_iter->speed_source.source;
+        };
+
+        if (segment_speed_lookup.size() < MERGE_JOIN_MIN_SPEEDS)
+        {
+            tbb::parallel_for_each(first, last, [&](const LeafNode &current_node) {
+                auto &counters = segment_speeds_counters.local();
+                for (size_t i = 0; i < current_node.object_count; i++)
                 {
-                    // count statistics for logging
-                    counters[LUA_SOURCE] += 1;
-                }
+                    const auto &leaf_object = current_node.objects[i];
+                    const std::uint32_t position =
+                        m_geometry_indices.at(leaf_object.packed_geometry_id) +
+                        leaf_object.fwd_segment_position;
+                    const auto &u = internal_to_external_node_map[m_geometry_node_list[position]];
+                    const auto &v =
+                        internal_to_external_node_map[m_geometry_node_list[position + 1]];
+
+                    const auto forward_speed_iter = find(
+                        segment_speed_lookup, SegmentSpeedSource{{u.node_id, v.node_id}, {0, 0}});
+                    if (forward_speed_iter != segment_speed_lookup.end())
+                    {
+                        update_segment_weight(position, false, forward_speed_iter);
+                        // count statistics for logging
+                        counters[forward_speed_iter->speed_source.source] += 1;
+                    }
+                    else
+                    {
+                        // count statistics for logging
+                        counters[LUA_SOURCE] += 1;
+                    }
 
-                const auto current_rev_weight =
-                    m_geometry_rev_weight_list[forward_begin + leaf_object.fwd_segment_position];
+                    const auto reverse_speed_iter = find(
+                        segment_speed_lookup, SegmentSpeedSource{{v.node_id, u.node_id}, {0, 0}});
+                    if (reverse_speed_iter != segment_speed_lookup.end())
+                    {
+                        update_segment_weight(position, true, reverse_speed_iter);
+                        // count statistics for logging
+                        counters[reverse_speed_iter->speed_source.source] += 1;
+                    }
+                    else
+                    {
+                        counters[LUA_SOURCE] += 1;
+                    }
+                }
+            }); // parallel_for_each
+        }
+        else
+        {
+            // A binary search per segment in a large speed table is a cache miss on almost every
+            // step. Instead both directions of all segments are sorted in the order of the speed
+            // table and joined with it by streaming over both.
+            struct SegmentLookup
+            {
+                Segment segment;
+                std::uint32_t position;
+                bool reverse;
+            };
 
-                const auto reverse_speed_iter = find(
-                    segment_speed_lookup, SegmentSpeedSource{{v->node_id, u->node_id}, {0, 0}});
+            std::size_t number_of_segments = 0;
+            for (auto current_node = first; current_node != last; ++current_node)
+            {
+                number_of_segments += current_node->object_count;
+            }
 
-                if (reverse_speed_iter != segment_speed_lookup.end())
-                {
-                    const auto new_segment_weight = getNewWeight(reverse_speed_iter,
-                                                                 segment_length,
-                                                                 segment_speed_filenames,
-                                                                 current_rev_weight,
-                                                                 log_edge_updates_factor);
-                    m_geometry_rev_weight_list[forward_begin + leaf_object.fwd_segment_position] =
-                        new_segment_weight;
-                    m_geometry_datasource[forward_begin + leaf_object.fwd_segment_position] =
-                        reverse_speed_iter->speed_source.source;
-
-                    // count statistics for logging
-                    counters[reverse_speed_iter->speed_source.source] += 1;
-                }
-                else
+            std::vector<SegmentLookup> segment_lookups;
+            segment_lookups.reserve(2 * number_of_segments);
+            for (auto current_node = first; current_node != last; ++current_node)
+            {
+                for (size_t i = 0; i < current_node->object_count; i++)
                 {
-                    counters[LUA_SOURCE] += 1;
+                    const auto &leaf_object = current_node->objects[i];
+                    const std::uint32_t position =
+                        m_geometry_indices.at(leaf_object.packed_geometry_id) +
+                        leaf_object.fwd_segment_position;
+                    const auto &from =
+                        internal_to_external_node_map[m_geometry_node_list[position]];
+                    const auto &to =
+                        internal_to_external_node_map[m_geometry_node_list[position + 1]];
+                    segment_lookups.push_back({{from.node_id, to.node_id}, position, false});
+                    segment_lookups.push_back({{to.node_id, from.node_id}, position, true});
                 }
             }
-        }); // parallel_for_each
+
+            tbb::parallel_sort(segment_lookups.begin(),
+                               segment_lookups.end(),
+                               [](const SegmentLookup &lhs, const SegmentLookup &rhs) {
+                                   return std::tie(lhs.segment.from, lhs.segment.to) >
+                                          std::tie(rhs.segment.from, rhs.segment.to);
+                               });
+
+            tbb::parallel_for(
+                tbb::blocked_range<std::size_t>(0, segment_lookups.size(), MERGE_JOIN_GRAIN_SIZE),
+                [&](const tbb::blocked_range<std::size_t> &range) {
+                    auto &counters = segment_speeds_counters.local();
+                    auto speed_iter = std::lower_bound(
+                        segment_speed_lookup.cbegin(),
+                        segment_speed_lookup.cend(),
+                        SegmentSpeedSource{segment_lookups[range.begin()].segment, {0, 0}});
+                    for (auto i = range.begin(), end = range.end(); i != end; ++i)
+                    {
+                        const auto &lookup = segment_lookups[i];
+                        const SegmentSpeedSource key{lookup.segment, {0, 0}};
+                        while (speed_iter != segment_speed_lookup.cend() && *speed_iter < key)
+                        {
+                            ++speed_iter;
+                        }
+
+                        if (speed_iter != segment_speed_lookup.cend() &&
+                            speed_iter->segment == lookup.segment)
+                        {
+                            update_segment_weight(lookup.position, lookup.reverse, speed_iter);
+                            // count statistics for logging
+                            counters[speed_iter->speed_source.source] += 1;
+                        }
+                        else
+                        {
+                            counters[LUA_SOURCE] += 1;
+                        }
+                    }
+                });
+        }
 
         counters_type merged_counters(num_counters, 0);
         for (const auto &counters : segment_speeds_counters)
@@ -765,13 +1236,21 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
 
     const auto maybe_save_geometries = [&] {
         if (!(update_edge_weights || update_turn_penalties))
+        {
+            // a metric without updates keeps the weights of the geometries it started from
+            if (geometry_output_filename != geometry_filename)
+            {
+                boost::filesystem::remove(geometry_output_filename);
+                boost::filesystem::copy_file(geometry_filename, geometry_output_filename);
+            }
             return;
+        }
 
         // Now save out the updated compressed geometries
-        std::ofstream geometry_stream(geometry_filename, std::ios::binary);
+        std::ofstream geometry_stream(geometry_output_filename, std::ios::binary);
         if (!geometry_stream)
         {
-            throw util::exception("Failed to open " + geometry_filename + " for writing");
+            throw util::exception("Failed to open " + geometry_output_filename + " for writing");
         }
         const unsigned number_of_indices = m_geometry_indices.size();
         const unsigned number_of_compressed_geometries = m_geometry_node_list.size();
@@ -823,110 +1302,122 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
 
     tbb::parallel_invoke(maybe_save_geometries, save_datasource_indexes, save_datastore_names);
 
-    auto penaltyblock = reinterpret_cast<const extractor::lookup::PenaltyBlock *>(
+    const auto penalty_blocks = reinterpret_cast<const extractor::lookup::PenaltyBlock *>(
         edge_penalty_region.get_address());
-    auto edge_segment_byte_ptr = reinterpret_cast<const char *>(edge_segment_region.get_address());
-    auto edge_based_edge_ptr = reinterpret_cast<extractor::EdgeBasedEdge *>(
-        reinterpret_cast<char *>(edge_based_graph_region.get_address()) +
+    const auto edge_based_edges = reinterpret_cast<const extractor::EdgeBasedEdge *>(
+        reinterpret_cast<const char *>(edge_based_graph_region.get_address()) +
         sizeof(EdgeBasedGraphHeader));
 
-    const auto edge_based_edge_last = reinterpret_cast<extractor::EdgeBasedEdge *>(
-        reinterpret_cast<char *>(edge_based_graph_region.get_address()) +
-        sizeof(EdgeBasedGraphHeader) +
-        sizeof(extractor::EdgeBasedEdge) * graph_header.number_of_edges);
+    if (!(update_edge_weights || update_turn_penalties))
+    {
+        for (const auto edge : util::irange<std::uint64_t>(0, graph_header.number_of_edges))
+        {
+            edge_based_edge_list.emplace_back(edge_based_edges[edge]);
+        }
+        util::SimpleLogger().Write() << "Done reading edges";
+        return graph_header.max_edge_id;
+    }
 
-    while (edge_based_edge_ptr != edge_based_edge_last)
+    // The segments of an edge follow the ones of the edge before it, a serial pass over their
+    // headers finds where they start so that the edges can be updated independently of each other
+    std::vector<const char *> edge_segments(graph_header.number_of_edges);
+    auto edge_segment_byte_ptr = reinterpret_cast<const char *>(edge_segment_region.get_address());
+    for (const auto edge : util::irange<std::uint64_t>(0, graph_header.number_of_edges))
     {
-        // Make a copy of the data from the memory map
-        extractor::EdgeBasedEdge inbuffer = *edge_based_edge_ptr;
-        edge_based_edge_ptr++;
+        edge_segments[edge] = edge_segment_byte_ptr;
+        const auto header =
+            reinterpret_cast<const extractor::lookup::SegmentHeaderBlock *>(edge_segment_byte_ptr);
+        edge_segment_byte_ptr += sizeof(extractor::lookup::SegmentHeaderBlock) +
+                                 sizeof(extractor::lookup::SegmentBlock) *
+                                     (header->num_osm_nodes - 1);
+    }
 
-        if (update_edge_weights || update_turn_penalties)
+    // the new weight of an edge, INVALID_EDGE_WEIGHT if one of its segments has a speed of zero
+    const auto update_edge_weight = [&](const std::uint64_t edge) -> EdgeWeight {
+        const auto header =
+            reinterpret_cast<const extractor::lookup::SegmentHeaderBlock *>(edge_segments[edge]);
+        const auto segmentblocks = reinterpret_cast<const extractor::lookup::SegmentBlock *>(
+            edge_segments[edge] + sizeof(extractor::lookup::SegmentHeaderBlock));
+
+        auto previous_osm_node_id = header->previous_osm_node_id;
+        EdgeWeight new_weight = 0;
+        int compressed_edge_nodes = static_cast<int>(header->num_osm_nodes);
+
+        const auto num_segments = header->num_osm_nodes - 1;
+        for (auto i : util::irange<std::size_t>(0, num_segments))
         {
-            bool skip_this_edge = false;
-            auto header = reinterpret_cast<const extractor::lookup::SegmentHeaderBlock *>(
-                edge_segment_byte_ptr);
-            edge_segment_byte_ptr += sizeof(extractor::lookup::SegmentHeaderBlock);
-
-            auto previous_osm_node_id = header->previous_osm_node_id;
-            EdgeWeight new_weight = 0;
-            int compressed_edge_nodes = static_cast<int>(header->num_osm_nodes);
-
-            auto segmentblocks =
-                reinterpret_cast<const extractor::lookup::SegmentBlock *>(edge_segment_byte_ptr);
-            edge_segment_byte_ptr +=
-                sizeof(extractor::lookup::SegmentBlock) * (header->num_osm_nodes - 1);
-
-            const auto num_segments = header->num_osm_nodes - 1;
-            for (auto i : util::irange<std::size_t>(0, num_segments))
+            auto speed_iter =
+                find(segment_speed_lookup,
+                     SegmentSpeedSource{
+                         previous_osm_node_id, segmentblocks[i].this_osm_node_id, {0, 0}});
+            if (speed_iter != segment_speed_lookup.end())
             {
-                auto speed_iter =
-                    find(segment_speed_lookup,
-                         SegmentSpeedSource{
-                             previous_osm_node_id, segmentblocks[i].this_osm_node_id, {0, 0}});
-                if (speed_iter != segment_speed_lookup.end())
+                if (speed_iter->speed_source.speed > 0)
                 {
-                    if (speed_iter->speed_source.speed > 0)
-                    {
-                        const auto new_segment_weight = distanceAndSpeedToWeight(
-                            segmentblocks[i].segment_length, speed_iter->speed_source.speed);
-                        new_weight += new_segment_weight;
-                    }
-                    else
-                    {
-                        // If we hit a 0-speed edge, then it's effectively not traversible.
-                        // We don't want to include it in the edge_based_edge_list, so
-                        // we set a flag and `continue` the parent loop as soon as we can.
-                        // This would be a perfect place to use `goto`, but Patrick vetoed it.
-                        skip_this_edge = true;
-                        break;
-                    }
+                    const auto new_segment_weight = distanceAndSpeedToWeight(
+                        segmentblocks[i].segment_length, speed_iter->speed_source.speed);
+                    new_weight += new_segment_weight;
                 }
                 else
                 {
-                    // If no lookup found, use the original weight value for this segment
-                    new_weight += segmentblocks[i].segment_weight;
+                    // If we hit a 0-speed edge, then it's effectively not traversible.
+                    // We don't want to include it in the edge_based_edge_list.
+                    return INVALID_EDGE_WEIGHT;
                 }
-
-                previous_osm_node_id = segmentblocks[i].this_osm_node_id;
             }
-
-            // We found a zero-speed edge, so we'll skip this whole edge-based-edge which
-            // effectively removes it from the routing network.
-            if (skip_this_edge)
+            else
             {
-                penaltyblock++;
-                continue;
+                // If no lookup found, use the original weight value for this segment
+                new_weight += segmentblocks[i].segment_weight;
             }
 
-            auto turn_iter =
-                find(turn_penalty_lookup,
-                     TurnPenaltySource{
-                         penaltyblock->from_id, penaltyblock->via_id, penaltyblock->to_id, {0, 0}});
-            if (turn_iter != turn_penalty_lookup.end())
-            {
-                int new_turn_weight = static_cast<int>(turn_iter->penalty_source.penalty * 10);
+            previous_osm_node_id = segmentblocks[i].this_osm_node_id;
+        }
 
-                if (new_turn_weight + new_weight < compressed_edge_nodes)
-                {
-                    util::SimpleLogger().Write(logWARNING)
-                        << "turn penalty " << turn_iter->penalty_source.penalty << " for turn "
-                        << penaltyblock->from_id << ", " << penaltyblock->via_id << ", "
-                        << penaltyblock->to_id << " is too negative: clamping turn weight to "
-                        << compressed_edge_nodes;
-                }
+        const auto &penaltyblock = penalty_blocks[edge];
+        auto turn_iter = find(
+            turn_penalty_lookup,
+            TurnPenaltySource{
+                penaltyblock.from_id, penaltyblock.via_id, penaltyblock.to_id, {0, 0}});
+        if (turn_iter != turn_penalty_lookup.end())
+        {
+            int new_turn_weight = static_cast<int>(turn_iter->penalty_source.penalty * 10);
 
-                inbuffer.weight = std::max(new_turn_weight + new_weight, compressed_edge_nodes);
-            }
-            else
+            if (new_turn_weight + new_weight < compressed_edge_nodes)
             {
-                inbuffer.weight = penaltyblock->fixed_penalty + new_weight;
+                util::SimpleLogger().Write(logWARNING)
+                    << "turn penalty " << turn_iter->penalty_source.penalty << " for turn "
+                    << penaltyblock.from_id << ", " << penaltyblock.via_id << ", "
+                    << penaltyblock.to_id << " is too negative: clamping turn weight to "
+                    << compressed_edge_nodes;
             }
 
-            // Increment the pointer
-            penaltyblock++;
+            return std::max(new_turn_weight + new_weight, compressed_edge_nodes);
         }
+        return penaltyblock.fixed_penalty + new_weight;
+    };
 
+    // the lookups of the edges run in parallel over the mapped files, the edges are then
+    // appended in order
+    std::vector<EdgeWeight> edge_weights(graph_header.number_of_edges);
+    tbb::parallel_for(tbb::blocked_range<std::uint64_t>(0, graph_header.number_of_edges),
+                      [&](const tbb::blocked_range<std::uint64_t> &range) {
+                          for (auto edge = range.begin(); edge != range.end(); ++edge)
+                          {
+                              edge_weights[edge] = update_edge_weight(edge);
+                          }
+                      });
+
+    for (const auto edge : util::irange<std::uint64_t>(0, graph_header.number_of_edges))
+    {
+        // We found a zero-speed edge, so we'll skip this whole edge-based-edge which
+        // effectively removes it from the routing network.
+        if (edge_weights[edge] == INVALID_EDGE_WEIGHT)
+        {
+            continue;
+        }
+        extractor::EdgeBasedEdge inbuffer = edge_based_edges[edge];
+        inbuffer.weight = edge_weights[edge];
         edge_based_edge_list.emplace_back(std::move(inbuffer));
     }
 
@@ -944,6 +1435,58 @@ void Contractor::ReadNodeLevels(std::vector<float> &node_levels) const
     order_input_stream.read((char *)node_levels.data(), sizeof(float) * node_levels.size());
 }
 
+void Contractor::ReadNodeRanks(std::vector<NodeID> &node_ranks) const
+{
+    if (!util::deserializeVector(config.rank_output_path, node_ranks))
+    {
+        throw util::exception("Could not read the node order from " + config.rank_output_path);
+    }
+}
+
+void Contractor::WriteNodeRanks(const std::vector<NodeID> &node_ranks) const
+{
+    if (!util::serializeVector(config.rank_output_path, node_ranks))
+    {
+        throw util::exception("Could not write the node order to " + config.rank_output_path);
+    }
+}
+
+void Contractor::WriteCustomizedMetric(const CustomizableContractor::Metric &metric) const
+{
+    boost::filesystem::ofstream metric_stream(config.metric_output_path, std::ios::binary);
+    util::writeFingerprint(metric_stream);
+    metric_stream.write(reinterpret_cast<const char *>(&metric.checksum), sizeof(metric.checksum));
+    if (!util::serializeVector(metric_stream, metric.edge_up) ||
+        !util::serializeVector(metric_stream, metric.edge_down) ||
+        !util::serializeVector(metric_stream, metric.up) ||
+        !util::serializeVector(metric_stream, metric.down) ||
+        !util::serializeVector(metric_stream, metric.loop))
+    {
+        throw util::exception("Could not write the metric to " + config.metric_output_path);
+    }
+}
+
+// A missing or unreadable metric is not an error, the graph is customized from scratch then
+bool Contractor::ReadCustomizedMetric(CustomizableContractor::Metric &metric) const
+{
+    if (!boost::filesystem::exists(config.metric_output_path))
+    {
+        return false;
+    }
+
+    boost::filesystem::ifstream metric_stream(config.metric_output_path, std::ios::binary);
+    if (!util::readAndCheckFingerprint(metric_stream))
+    {
+        return false;
+    }
+    metric_stream.read(reinterpret_cast<char *>(&metric.checksum), sizeof(metric.checksum));
+    return metric_stream && util::deserializeVector(metric_stream, metric.edge_up) &&
+           util::deserializeVector(metric_stream, metric.edge_down) &&
+           util::deserializeVector(metric_stream, metric.up) &&
+           util::deserializeVector(metric_stream, metric.down) &&
+           util::deserializeVector(metric_stream, metric.loop);
+}
+
 void Contractor::WriteNodeLevels(std::vector<float> &&in_node_levels) const
 {
     std::vector<float> node_levels(std::move(in_node_levels));
@@ -955,6 +1498,276 @@ void Contractor::WriteNodeLevels(std::vector<float> &&in_node_levels) const
     order_output_stream.write((char *)node_levels.data(), sizeof(float) * node_levels.size());
 }
 
+// Writes the speed profiles of the segments in the lookup files, relative to the static weights
+// of the segments. Without lookup files the dataset has no profiles.
+// Removes the edges from and to the edge-based nodes of the excluded classes. The hierarchy is
+// contracted in the order of the default metric without them.
+void Contractor::ExcludeClasses(
+    util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list) const
+{
+    std::vector<extractor::ClassData> node_classes;
+    if (!util::deserializeVector(config.edge_based_node_classes_path, node_classes))
+    {
+        throw util::exception("Failed reading the classes of the edge-based nodes from " +
+                              config.edge_based_node_classes_path);
+    }
+
+    const auto is_excluded = [&](const NodeID node) {
+        BOOST_ASSERT(node < node_classes.size());
+        return (node_classes[node] & config.excluded_classes) != 0;
+    };
+
+    std::size_t number_of_kept_edges = 0;
+    for (const auto index : util::irange<std::size_t>(0, edge_based_edge_list.size()))
+    {
+        const auto &edge = edge_based_edge_list[index];
+        if (!is_excluded(edge.source) && !is_excluded(edge.target))
+        {
+            edge_based_edge_list[number_of_kept_edges++] = edge;
+        }
+    }
+
+    util::SimpleLogger().Write() << "Excluded "
+                                 << edge_based_edge_list.size() - number_of_kept_edges << " of "
+                                 << edge_based_edge_list.size() << " edges for the metric "
+                                 << extractor::getExcludeMetricName(config.excluded_classes);
+    edge_based_edge_list.resize(number_of_kept_edges);
+}
+
+// Keeps the edges between the nodes of the shard of the cell and writes the overlay edges between
+// the border nodes of the cell. The shard keeps the ids of the whole graph, the nodes outside of it
+// are left without edges.
+void Contractor::ExtractShard(
+    util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list) const
+{
+    const auto partition = readPartition(config.partition_path);
+    const auto cell = static_cast<CellID>(config.cell);
+    if (cell >= partition.NumberOfCells())
+    {
+        throw util::exception("The partition in " + config.partition_path + " has " +
+                              std::to_string(partition.NumberOfCells()) + " cells, there is no " +
+                              std::to_string(cell));
+    }
+    const auto number_of_nodes = static_cast<NodeID>(partition.node_cells.size());
+    const auto border_nodes = getBorderNodes(partition, cell, edge_based_edge_list);
+
+    const auto is_shard_node = partition.GetShardNodes(cell);
+    std::size_t number_of_kept_edges = 0;
+    for (const auto index : util::irange<std::size_t>(0, edge_based_edge_list.size()))
+    {
+        const auto &edge = edge_based_edge_list[index];
+        if (is_shard_node[edge.source] && is_shard_node[edge.target])
+        {
+            edge_based_edge_list[number_of_kept_edges++] = edge;
+        }
+    }
+
+    util::SimpleLogger().Write() << "Kept " << number_of_kept_edges << " of "
+                                 << edge_based_edge_list.size() << " edges for the shard of cell "
+                                 << cell;
+    edge_based_edge_list.resize(number_of_kept_edges);
+
+    TIMER_START(overlay);
+    const auto overlay_edges =
+        computeOverlayEdges(number_of_nodes, border_nodes, edge_based_edge_list);
+    TIMER_STOP(overlay);
+    util::SimpleLogger().Write() << "Computed " << overlay_edges.size() << " overlay edges between "
+                                 << border_nodes.size() << " border nodes in "
+                                 << TIMER_SEC(overlay) << "s";
+
+    boost::filesystem::ofstream overlay_stream(config.overlay_output_path, std::ios::binary);
+    if (!util::serializeVector(overlay_stream, overlay_edges))
+    {
+        throw util::exception("Could not write the overlay edges to " +
+                              config.overlay_output_path);
+    }
+}
+
+// Builds the overlay graph over the edges in a partition of the edge-based nodes into nested
+// geographic cells and customizes the cliques of the cells. The partition only depends on the
+// locations of the nodes, with --level-cache the one of a previous run is reused.
+void Contractor::BuildMultiLevelGraph(
+    const EdgeID max_edge_id,
+    util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list) const
+{
+    const NodeID number_of_nodes = max_edge_id + 1;
+
+    util::MultiLevelPartition partition;
+    if (config.use_cached_priority)
+    {
+        boost::filesystem::ifstream partition_stream(config.mld_partition_path, std::ios::binary);
+        if (!partition_stream || !partition.Read(partition_stream))
+        {
+            throw util::exception("Could not read the partition from " +
+                                  config.mld_partition_path);
+        }
+        if (partition.GetNumberOfNodes() != number_of_nodes)
+        {
+            throw util::exception("The partition in " + config.mld_partition_path +
+                                  " does not match the graph, rerun without --level-cache");
+        }
+    }
+    else
+    {
+        TIMER_START(partition);
+        auto coordinates =
+            readEdgeBasedNodeCoordinates(config.node_based_graph_path, config.rtree_leaf_path);
+        coordinates.resize(number_of_nodes);
+        partition =
+            util::MultiLevelPartition(partitionIntoLevels(coordinates, config.mld_cell_sizes));
+        TIMER_STOP(partition);
+        util::SimpleLogger().Write() << "Partitioning took " << TIMER_SEC(partition) << " sec";
+
+        boost::filesystem::ofstream partition_stream(config.mld_partition_path, std::ios::binary);
+        if (!partition.Write(partition_stream))
+        {
+            throw util::exception("Could not write the partition to " +
+                                  config.mld_partition_path);
+        }
+    }
+    for (const auto level : util::irange<util::MultiLevelPartition::LevelID>(
+             1, partition.GetNumberOfLevels() + 1))
+    {
+        util::SimpleLogger().Write() << "Level " << static_cast<int>(level) << ": "
+                                     << partition.GetNumberOfCells(level) << " cells";
+    }
+
+    util::MultiLevelGraph graph(std::move(partition), edge_based_edge_list);
+    edge_based_edge_list.clear();
+
+    TIMER_START(customization);
+    customizeMultiLevelGraph(graph);
+    TIMER_STOP(customization);
+    util::SimpleLogger().Write() << "Customization took " << TIMER_SEC(customization) << " sec";
+
+    boost::filesystem::ofstream graph_stream(config.mld_graph_output_path, std::ios::binary);
+    if (!graph.Write(graph_stream))
+    {
+        throw util::exception("Could not write the overlay graph to " +
+                              config.mld_graph_output_path);
+    }
+}
+
+void Contractor::WriteSpeedProfiles() const
+{
+    const auto &filenames = config.segment_speed_profile_lookup_paths;
+    if (filenames.size() > 255)
+        throw util::exception("Limit of 255 segment speed profile files reached");
+
+    std::vector<std::uint8_t> factors;
+    std::vector<util::SpeedProfileSegment> segments;
+    if (!filenames.empty())
+    {
+        const auto profile_lookup =
+            parse_segment_speed_profile_lookup_from_csv_files(filenames, config.cache_lookup_files);
+
+        boost::filesystem::ifstream nodes_input_stream(config.node_based_graph_path,
+                                                       std::ios::binary);
+        if (!nodes_input_stream)
+        {
+            throw util::exception("Failed to open " + config.node_based_graph_path);
+        }
+        std::uint64_t number_of_nodes = 0;
+        nodes_input_stream.read((char *)&number_of_nodes, sizeof(std::uint64_t));
+        std::vector<extractor::QueryNode> internal_to_external_node_map(number_of_nodes);
+        nodes_input_stream.read((char *)internal_to_external_node_map.data(),
+                                number_of_nodes * sizeof(extractor::QueryNode));
+
+        // the profiles are relative to the weights after the speed updates
+        std::ifstream geometry_stream(config.geometry_output_path, std::ios::binary);
+        if (!geometry_stream)
+        {
+            throw util::exception("Failed to open " + config.geometry_output_path);
+        }
+        unsigned number_of_indices = 0;
+        unsigned number_of_compressed_geometries = 0;
+        geometry_stream.read((char *)&number_of_indices, sizeof(unsigned));
+        std::vector<unsigned> geometry_indices(number_of_indices);
+        geometry_stream.read((char *)geometry_indices.data(), number_of_indices * sizeof(unsigned));
+        geometry_stream.read((char *)&number_of_compressed_geometries, sizeof(unsigned));
+        std::vector<NodeID> geometry_nodes(number_of_compressed_geometries);
+        std::vector<EdgeWeight> geometry_fwd_weights(number_of_compressed_geometries);
+        std::vector<EdgeWeight> geometry_rev_weights(number_of_compressed_geometries);
+        geometry_stream.read((char *)geometry_nodes.data(),
+                             number_of_compressed_geometries * sizeof(NodeID));
+        geometry_stream.read((char *)geometry_fwd_weights.data(),
+                             number_of_compressed_geometries * sizeof(EdgeWeight));
+        geometry_stream.read((char *)geometry_rev_weights.data(),
+                             number_of_compressed_geometries * sizeof(EdgeWeight));
+
+        // identical profiles are stored once
+        using Factors = std::array<std::uint8_t, util::SPEED_PROFILE_SLOTS>;
+        std::map<Factors, std::uint32_t> profile_offsets;
+        const auto add_segment = [&](const NodeID from, const NodeID to, const EdgeWeight weight) {
+            const auto &u = internal_to_external_node_map[from];
+            const auto &v = internal_to_external_node_map[to];
+            const auto profile_iter = find(profile_lookup,
+                                           SegmentSpeedProfileSource{{u.node_id, v.node_id}, {}});
+            if (profile_iter == profile_lookup.end() || weight <= 0 ||
+                weight == INVALID_EDGE_WEIGHT)
+            {
+                return;
+            }
+
+            const double segment_length = util::coordinate_calculation::greatCircleDistance(
+                util::Coordinate{u.lon, u.lat}, util::Coordinate{v.lon, v.lat});
+            Factors profile;
+            for (const auto slot : util::irange<std::size_t>(0, util::SPEED_PROFILE_SLOTS))
+            {
+                const auto speed = profile_iter->profile_source.speeds[slot];
+                const auto factor =
+                    speed > 0 ? std::round(100. * weight /
+                                           distanceAndSpeedToWeight(segment_length, speed))
+                              : util::SPEED_PROFILE_STATIC_FACTOR;
+                profile[slot] = static_cast<std::uint8_t>(std::max(1., std::min(255., factor)));
+            }
+
+            const auto inserted = profile_offsets.emplace(profile, factors.size());
+            if (inserted.second)
+            {
+                factors.insert(factors.end(), profile.begin(), profile.end());
+            }
+            segments.push_back({from, to, inserted.first->second});
+        };
+
+        for (const auto geometry : util::irange<std::size_t>(0, number_of_indices - 1))
+        {
+            const auto begin = geometry_indices[geometry];
+            const auto end = geometry_indices[geometry + 1];
+            for (auto position = begin; position + 1 < end; ++position)
+            {
+                add_segment(geometry_nodes[position],
+                            geometry_nodes[position + 1],
+                            geometry_fwd_weights[position + 1]);
+                add_segment(geometry_nodes[position + 1],
+                            geometry_nodes[position],
+                            geometry_rev_weights[position]);
+            }
+        }
+
+        tbb::parallel_sort(segments.begin(), segments.end());
+        segments.erase(std::unique(segments.begin(),
+                                   segments.end(),
+                                   [](const util::SpeedProfileSegment &lhs,
+                                      const util::SpeedProfileSegment &rhs) {
+                                       return !(lhs < rhs) && !(rhs < lhs);
+                                   }),
+                       segments.end());
+
+        util::SimpleLogger().Write() << "Used " << profile_offsets.size()
+                                     << " distinct speed profiles for " << segments.size()
+                                     << " segments";
+    }
+
+    boost::filesystem::ofstream profiles_stream(config.speed_profiles_path, std::ios::binary);
+    if (!util::serializeVector(profiles_stream, factors) ||
+        !util::serializeVector(profiles_stream, segments))
+    {
+        throw util::exception("Could not write the speed profiles to " +
+                              config.speed_profiles_path);
+    }
+}
+
 void Contractor::WriteCoreNodeMarker(std::vector<bool> &&in_is_core_node) const
 {
     std::vector<bool> is_core_node(std::move(in_is_core_node));
@@ -972,69 +1785,115 @@ void Contractor::WriteCoreNodeMarker(std::vector<bool> &&in_is_core_node) const
                                     sizeof(char) * unpacked_bool_flags.size());
 }
 
+// Moves every node of the hierarchy to its new id. The middle nodes of shortcuts and the core
+// markers move with them, the ids of the edge-based nodes map to the new ids in the renumbering
+// file.
+void Contractor::RenumberNodes(const unsigned max_node_id,
+                               stxxl::vector<QueryEdge> &contracted_edge_list,
+                               std::vector<bool> &is_core_node) const
+{
+    TIMER_START(renumbering);
+    const auto renumbering = computeNodeRenumbering(max_node_id + 1, contracted_edge_list);
+
+    for (QueryEdge &edge : contracted_edge_list)
+    {
+        edge.source = renumbering[edge.source];
+        edge.target = renumbering[edge.target];
+        if (edge.data.shortcut)
+        {
+            edge.data.id = renumbering[edge.data.id];
+        }
+    }
+
+    if (!is_core_node.empty())
+    {
+        std::vector<bool> renumbered_core_nodes(is_core_node.size(), false);
+        for (const auto node : util::irange<std::size_t>(0, is_core_node.size()))
+        {
+            renumbered_core_nodes[renumbering[node]] = is_core_node[node];
+        }
+        is_core_node.swap(renumbered_core_nodes);
+    }
+
+    if (!util::serializeVector(config.renumbering_output_path, renumbering))
+    {
+        throw util::exception("Could not write the node renumbering to " +
+                              config.renumbering_output_path);
+    }
+    TIMER_STOP(renumbering);
+    util::SimpleLogger().Write() << "Renumbering nodes took " << TIMER_SEC(renumbering) << " sec";
+}
+
+// The landmarks are computed on the edges between core nodes in the final order of the nodes
+void Contractor::WriteCoreLandmarks(const stxxl::vector<QueryEdge> &contracted_edge_list,
+                                    const std::vector<bool> &is_core_node) const
+{
+    TIMER_START(landmarks);
+    std::vector<QueryEdge> core_edges;
+    for (const auto &edge : contracted_edge_list)
+    {
+        if (is_core_node[edge.source] && is_core_node[edge.target])
+        {
+            core_edges.push_back(edge);
+        }
+    }
+
+    const auto landmarks = computeCoreLandmarks(is_core_node, core_edges, config.core_landmarks);
+    writeCoreLandmarks(config.core_landmarks_output_path, landmarks);
+    TIMER_STOP(landmarks);
+    util::SimpleLogger().Write() << "Computing " << landmarks.number_of_landmarks
+                                 << " core landmarks took " << TIMER_SEC(landmarks) << " sec";
+}
+
 std::size_t
 Contractor::WriteContractedGraph(unsigned max_node_id,
-                                 const util::DeallocatingVector<QueryEdge> &contracted_edge_list)
+                                 stxxl::vector<QueryEdge> &contracted_edge_list)
 {
     // Sorting contracted edges in a way that the static query graph can read some in in-place.
-    tbb::parallel_sort(contracted_edge_list.begin(), contracted_edge_list.end());
+    // The edges stay in external memory, the sort and both passes below only hold a few blocks.
+    stxxl::sort(contracted_edge_list.begin(),
+                contracted_edge_list.end(),
+                QueryEdgeSTXXLLess(),
+                CONTRACTED_EDGE_SORT_MEMORY);
     const std::uint64_t contracted_edge_count = contracted_edge_list.size();
+    const auto &sorted_edge_list = contracted_edge_list;
     util::SimpleLogger().Write() << "Serializing compacted graph of " << contracted_edge_count
                                  << " edges";
 
-    const util::FingerPrint fingerprint = util::FingerPrint::GetValid();
-    boost::filesystem::ofstream hsgr_output_stream(config.graph_output_path, std::ios::binary);
-    hsgr_output_stream.write((char *)&fingerprint, sizeof(util::FingerPrint));
-    const NodeID max_used_node_id = [&contracted_edge_list] {
-        NodeID tmp_max = 0;
-        for (const QueryEdge &edge : contracted_edge_list)
-        {
-            BOOST_ASSERT(SPECIAL_NODEID != edge.source);
-            BOOST_ASSERT(SPECIAL_NODEID != edge.target);
-            tmp_max = std::max(tmp_max, edge.source);
-            tmp_max = std::max(tmp_max, edge.target);
-        }
-        return tmp_max;
-    }();
-
-    util::SimpleLogger().Write(logDEBUG) << "input graph has " << (max_node_id + 1) << " nodes";
-    util::SimpleLogger().Write(logDEBUG) << "contracted graph has " << (max_used_node_id + 1)
-                                         << " nodes";
-
+    util::SimpleLogger().Write() << "Building node array";
     std::vector<util::StaticGraph<EdgeData>::NodeArrayEntry> node_array;
     // make sure we have at least one sentinel
     node_array.resize(max_node_id + 2);
 
-    util::SimpleLogger().Write() << "Building node array";
-    util::StaticGraph<EdgeData>::EdgeIterator edge = 0;
-    util::StaticGraph<EdgeData>::EdgeIterator position = 0;
-    util::StaticGraph<EdgeData>::EdgeIterator last_edge;
-
-    // initializing 'first_edge'-field of nodes:
-    for (const auto node : util::irange(0u, max_used_node_id + 1))
+    // the first edge of a node is the number of edges of lower nodes, sentinels get all edges
+    IteratorbasedCRC32 crc32_calculator;
+    unsigned edges_crc32 = 0;
+    NodeID max_used_node_id = 0;
+    for (const QueryEdge &edge : sorted_edge_list)
     {
-        last_edge = edge;
-        while ((edge < contracted_edge_count) && (contracted_edge_list[edge].source == node))
-        {
-            ++edge;
-        }
-        node_array[node].first_edge = position; //=edge
-        position += edge - last_edge;           // remove
+        BOOST_ASSERT(SPECIAL_NODEID != edge.source);
+        BOOST_ASSERT(SPECIAL_NODEID != edge.target);
+        BOOST_ASSERT(edge.source <= max_node_id);
+        max_used_node_id = std::max(max_used_node_id, std::max(edge.source, edge.target));
+        ++node_array[edge.source + 1].first_edge;
+        edges_crc32 = crc32_calculator(&edge, &edge + 1);
     }
-
-    for (const auto sentinel_counter :
-         util::irange<unsigned>(max_used_node_id + 1, node_array.size()))
+    for (const auto node : util::irange<std::size_t>(1, node_array.size()))
     {
-        // sentinel element, guarded against underflow
-        node_array[sentinel_counter].first_edge = contracted_edge_count;
+        node_array[node].first_edge += node_array[node - 1].first_edge;
     }
 
-    util::SimpleLogger().Write() << "Serializing node array";
+    util::SimpleLogger().Write(logDEBUG) << "input graph has " << (max_node_id + 1) << " nodes";
+    util::SimpleLogger().Write(logDEBUG) << "contracted graph has " << (max_used_node_id + 1)
+                                         << " nodes";
 
-    RangebasedCRC32 crc32_calculator;
-    const unsigned edges_crc32 = crc32_calculator(contracted_edge_list);
+    util::SimpleLogger().Write() << "Serializing node array";
     util::SimpleLogger().Write() << "Writing CRC32: " << edges_crc32;
 
+    const util::FingerPrint fingerprint = util::FingerPrint::GetValid();
+    boost::filesystem::ofstream hsgr_output_stream(config.graph_output_path, std::ios::binary);
+    hsgr_output_stream.write((char *)&fingerprint, sizeof(util::FingerPrint));
+
     const std::uint64_t node_array_size = node_array.size();
     // serialize crc32, aka checksum
     hsgr_output_stream.write((char *)&edges_crc32, sizeof(unsigned));
@@ -1050,20 +1909,28 @@ Contractor::WriteContractedGraph(unsigned max_node_id,
                                      node_array_size);
     }
 
-    // serialize all edges
+    // serialize all edges, a chunk at a time
     util::SimpleLogger().Write() << "Building edge array";
     std::size_t number_of_used_edges = 0;
 
+    std::vector<util::StaticGraph<EdgeData>::EdgeArrayEntry> edge_chunk;
+    edge_chunk.reserve(CONTRACTED_EDGE_CHUNK_SIZE);
+    const auto write_edge_chunk = [&] {
+        hsgr_output_stream.write((char *)edge_chunk.data(),
+                                 sizeof(util::StaticGraph<EdgeData>::EdgeArrayEntry) *
+                                     edge_chunk.size());
+        edge_chunk.clear();
+    };
+
     util::StaticGraph<EdgeData>::EdgeArrayEntry current_edge;
-    for (const auto edge : util::irange<std::size_t>(0UL, contracted_edge_list.size()))
+    for (const QueryEdge &edge : sorted_edge_list)
     {
         // some self-loops are required for oneway handling. Need to assertthat we only keep these
         // (TODO)
         // no eigen loops
-        // BOOST_ASSERT(contracted_edge_list[edge].source != contracted_edge_list[edge].target ||
-        // node_represents_oneway[contracted_edge_list[edge].source]);
-        current_edge.target = contracted_edge_list[edge].target;
-        current_edge.data = contracted_edge_list[edge].data;
+        // BOOST_ASSERT(edge.source != edge.target || node_represents_oneway[edge.source]);
+        current_edge.target = edge.target;
+        current_edge.data = edge.data;
 
         // every target needs to be valid
         BOOST_ASSERT(current_edge.target <= max_used_node_id);
@@ -1071,21 +1938,23 @@ Contractor::WriteContractedGraph(unsigned max_node_id,
         if (current_edge.data.weight <= 0)
         {
             util::SimpleLogger().Write(logWARNING)
-                << "Edge: " << edge << ",source: " << contracted_edge_list[edge].source
-                << ", target: " << contracted_edge_list[edge].target
-                << ", weight: " << current_edge.data.weight;
+                << "Edge: " << number_of_used_edges << ",source: " << edge.source
+                << ", target: " << edge.target << ", weight: " << current_edge.data.weight;
 
             util::SimpleLogger().Write(logWARNING) << "Failed at adjacency list of node "
-                                                   << contracted_edge_list[edge].source << "/"
-                                                   << node_array.size() - 1;
+                                                   << edge.source << "/" << node_array.size() - 1;
             return 1;
         }
 #endif
-        hsgr_output_stream.write((char *)&current_edge,
-                                 sizeof(util::StaticGraph<EdgeData>::EdgeArrayEntry));
+        edge_chunk.push_back(current_edge);
+        if (edge_chunk.size() == CONTRACTED_EDGE_CHUNK_SIZE)
+        {
+            write_edge_chunk();
+        }
 
         ++number_of_used_edges;
     }
+    write_edge_chunk();
 
     return number_of_used_edges;
 }
@@ -1096,7 +1965,7 @@ Contractor::WriteContractedGraph(unsigned max_node_id,
 void Contractor::ContractGraph(
     const EdgeID max_edge_id,
     util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
-    util::DeallocatingVector<QueryEdge> &contracted_edge_list,
+    stxxl::vector<QueryEdge> &contracted_edge_list,
     std::vector<EdgeWeight> &&node_weights,
     std::vector<bool> &is_core_node,
     std::vector<float> &inout_node_levels) const
@@ -1106,10 +1975,81 @@ void Contractor::ContractGraph(
 
     GraphContractor graph_contractor(
         max_edge_id + 1, edge_based_edge_list, std::move(node_levels), std::move(node_weights));
-    graph_contractor.Run(config.core_factor);
+
+    GraphContractor::RoundCallback on_round;
+    boost::filesystem::ofstream telemetry_stream;
+    if (!config.contraction_telemetry_path.empty())
+    {
+        telemetry_stream.open(config.contraction_telemetry_path);
+        if (!telemetry_stream)
+        {
+            throw util::exception("Could not open " + config.contraction_telemetry_path);
+        }
+        on_round = [&telemetry_stream](const GraphContractor::RoundStatistics &statistics) {
+            writeRoundStatistics(telemetry_stream, statistics);
+        };
+    }
+    graph_contractor.Run(config.core_factor, on_round);
     graph_contractor.GetEdges(contracted_edge_list);
     graph_contractor.GetCoreMarker(is_core_node);
     graph_contractor.GetNodeLevels(inout_node_levels);
 }
+
+/**
+ \brief Build the customizable hierarchy, reusing the node order of a previous run if requested.
+ */
+void Contractor::CustomizeGraph(
+    const EdgeID max_edge_id,
+    util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
+    stxxl::vector<QueryEdge> &contracted_edge_list) const
+{
+    const NodeID number_of_nodes = max_edge_id + 1;
+
+    std::vector<NodeID> node_ranks;
+    if (config.use_cached_priority)
+    {
+        ReadNodeRanks(node_ranks);
+        if (node_ranks.size() != number_of_nodes)
+        {
+            throw util::exception("The node order in " + config.rank_output_path +
+                                  " does not match the graph, rerun without --level-cache");
+        }
+    }
+    else
+    {
+        TIMER_START(order);
+        node_ranks =
+            CustomizableContractor::ComputeNodeRanks(number_of_nodes, edge_based_edge_list);
+        TIMER_STOP(order);
+        util::SimpleLogger().Write() << "Nested dissection order took " << TIMER_SEC(order)
+                                     << " sec";
+        WriteNodeRanks(node_ranks);
+    }
+
+    CustomizableContractor customizable_contractor(
+        number_of_nodes, edge_based_edge_list, std::move(node_ranks));
+
+    // with a cached order the arcs are the same as in the previous run, only the part of the
+    // hierarchy above changed edges has to be customized again
+    TIMER_START(customization);
+    CustomizableContractor::Metric previous_metric;
+    if (config.use_cached_priority && ReadCustomizedMetric(previous_metric))
+    {
+        const auto customized_nodes = customizable_contractor.Customize(
+            edge_based_edge_list, std::move(previous_metric));
+        util::SimpleLogger().Write() << "Customized " << customized_nodes << " of "
+                                     << number_of_nodes << " nodes again";
+    }
+    else
+    {
+        customizable_contractor.Customize(edge_based_edge_list);
+    }
+    TIMER_STOP(customization);
+    util::SimpleLogger().Write() << "Customization took " << TIMER_SEC(customization) << " sec";
+
+    edge_based_edge_list.clear();
+    WriteCustomizedMetric(customizable_contractor.GetMetric());
+    customizable_contractor.GetEdges(contracted_edge_list);
+}
 }
 }
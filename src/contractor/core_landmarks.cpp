@@ -0,0 +1,235 @@
+#include "contractor/core_landmarks.hpp"
+
+#include "util/d_ary_heap.hpp"
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+#include "util/io.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <numeric>
+
+namespace osrm
+{
+namespace contractor
+{
+
+namespace
+{
+struct LandmarkHeapData
+{
+};
+using LandmarkHeap = util::DAryHeap<NodeID,
+                                    NodeID,
+                                    EdgeWeight,
+                                    LandmarkHeapData,
+                                    util::TimestampedArrayStorage<NodeID, NodeID>>;
+
+// The arcs of the core in one direction by their tail, indexed by core index
+struct CoreArcs
+{
+    struct Arc
+    {
+        NodeID target;
+        EdgeWeight weight;
+    };
+
+    std::vector<std::uint32_t> offsets;
+    std::vector<Arc> arcs;
+};
+
+// Arcs from source to target for the edges with the forward flag and from target to source for
+// the ones with the backward flag, reversed if the arcs towards the nodes are asked for
+CoreArcs makeCoreArcs(const std::vector<NodeID> &core_indices,
+                      const NodeID number_of_core_nodes,
+                      const std::vector<QueryEdge> &edges,
+                      const bool reversed)
+{
+    const auto isCoreEdge = [&](const QueryEdge &edge) {
+        return core_indices[edge.source] != SPECIAL_NODEID &&
+               core_indices[edge.target] != SPECIAL_NODEID;
+    };
+
+    CoreArcs core_arcs;
+    core_arcs.offsets.resize(number_of_core_nodes + 1, 0);
+    for (const auto &edge : edges)
+    {
+        if (!isCoreEdge(edge))
+        {
+            continue;
+        }
+        const auto from = core_indices[reversed ? edge.target : edge.source];
+        const auto to = core_indices[reversed ? edge.source : edge.target];
+        core_arcs.offsets[from + 1] += edge.data.forward ? 1 : 0;
+        core_arcs.offsets[to + 1] += edge.data.backward ? 1 : 0;
+    }
+    std::partial_sum(core_arcs.offsets.begin(), core_arcs.offsets.end(), core_arcs.offsets.begin());
+
+    core_arcs.arcs.resize(core_arcs.offsets.back());
+    auto positions = core_arcs.offsets;
+    for (const auto &edge : edges)
+    {
+        if (!isCoreEdge(edge))
+        {
+            continue;
+        }
+        const auto from = core_indices[reversed ? edge.target : edge.source];
+        const auto to = core_indices[reversed ? edge.source : edge.target];
+        if (edge.data.forward)
+        {
+            core_arcs.arcs[positions[from]++] = {to, edge.data.weight};
+        }
+        if (edge.data.backward)
+        {
+            core_arcs.arcs[positions[to]++] = {from, edge.data.weight};
+        }
+    }
+    return core_arcs;
+}
+
+// Weights of the shortest paths from the landmark to all core nodes over the arcs
+std::vector<EdgeWeight>
+searchFromLandmark(LandmarkHeap &heap, const CoreArcs &core_arcs, const NodeID landmark)
+{
+    std::vector<EdgeWeight> weights(core_arcs.offsets.size() - 1, INVALID_EDGE_WEIGHT);
+    heap.Clear();
+    heap.Insert(landmark, 0, {});
+    while (!heap.Empty())
+    {
+        const auto node = heap.DeleteMin();
+        const auto weight = heap.GetKey(node);
+        weights[node] = weight;
+        for (const auto arc : util::irange(core_arcs.offsets[node], core_arcs.offsets[node + 1]))
+        {
+            const auto target = core_arcs.arcs[arc].target;
+            const auto target_weight = weight + core_arcs.arcs[arc].weight;
+            if (!heap.WasInserted(target))
+            {
+                heap.Insert(target, target_weight, {});
+            }
+            else if (target_weight < heap.GetKey(target))
+            {
+                heap.DecreaseKey(target, target_weight);
+            }
+        }
+    }
+    return weights;
+}
+}
+
+CoreLandmarks computeCoreLandmarks(const std::vector<bool> &is_core_node,
+                                   const std::vector<QueryEdge> &edges,
+                                   const std::uint32_t number_of_landmarks)
+{
+    CoreLandmarks landmarks;
+    landmarks.core_indices.resize(is_core_node.size(), SPECIAL_NODEID);
+    NodeID number_of_core_nodes = 0;
+    for (const auto node : util::irange<std::size_t>(0, is_core_node.size()))
+    {
+        if (is_core_node[node])
+        {
+            landmarks.core_indices[node] = number_of_core_nodes++;
+        }
+    }
+    if (number_of_core_nodes == 0 || number_of_landmarks == 0)
+    {
+        return landmarks;
+    }
+
+    const auto forward_arcs =
+        makeCoreArcs(landmarks.core_indices, number_of_core_nodes, edges, false);
+    const auto backward_arcs =
+        makeCoreArcs(landmarks.core_indices, number_of_core_nodes, edges, true);
+
+    // The next landmark is the core node with the largest weight from its closest landmark. Nodes
+    // that no landmark reaches are only picked if all reached ones are landmarks, that way small
+    // islands of the core do not take the landmarks of the large component.
+    LandmarkHeap heap(number_of_core_nodes);
+    std::vector<NodeID> landmark_nodes;
+    std::vector<std::vector<EdgeWeight>> weights_from_landmarks;
+    auto closest_landmark_weights = searchFromLandmark(heap, forward_arcs, 0);
+    while (landmark_nodes.size() < number_of_landmarks)
+    {
+        NodeID next_landmark = SPECIAL_NODEID;
+        EdgeWeight next_landmark_weight = 0;
+        for (const auto node : util::irange<NodeID>(0, number_of_core_nodes))
+        {
+            const auto weight = closest_landmark_weights[node];
+            if (weight != INVALID_EDGE_WEIGHT && weight > next_landmark_weight)
+            {
+                next_landmark = node;
+                next_landmark_weight = weight;
+            }
+        }
+        if (next_landmark == SPECIAL_NODEID)
+        {
+            const auto unreached = std::find(closest_landmark_weights.begin(),
+                                             closest_landmark_weights.end(),
+                                             INVALID_EDGE_WEIGHT);
+            if (unreached == closest_landmark_weights.end())
+            {
+                // every core node is a landmark
+                break;
+            }
+            next_landmark = static_cast<NodeID>(unreached - closest_landmark_weights.begin());
+        }
+
+        landmark_nodes.push_back(next_landmark);
+        weights_from_landmarks.push_back(searchFromLandmark(heap, forward_arcs, next_landmark));
+        if (landmark_nodes.size() == 1)
+        {
+            closest_landmark_weights = weights_from_landmarks.back();
+        }
+        else
+        {
+            std::transform(closest_landmark_weights.begin(),
+                           closest_landmark_weights.end(),
+                           weights_from_landmarks.back().begin(),
+                           closest_landmark_weights.begin(),
+                           [](const EdgeWeight lhs, const EdgeWeight rhs) {
+                               return std::min(lhs, rhs);
+                           });
+        }
+    }
+
+    // the searches towards the landmarks are independent of each other
+    std::vector<std::vector<EdgeWeight>> weights_to_landmarks(landmark_nodes.size());
+    tbb::parallel_for(std::size_t{0}, landmark_nodes.size(), [&](const std::size_t landmark) {
+        LandmarkHeap backward_heap(number_of_core_nodes);
+        weights_to_landmarks[landmark] =
+            searchFromLandmark(backward_heap, backward_arcs, landmark_nodes[landmark]);
+    });
+
+    landmarks.number_of_landmarks = static_cast<std::uint32_t>(landmark_nodes.size());
+    const std::size_t stride = 2 * landmarks.number_of_landmarks;
+    landmarks.weights.resize(number_of_core_nodes * stride);
+    for (const auto node : util::irange<NodeID>(0, number_of_core_nodes))
+    {
+        for (const auto landmark : util::irange<std::size_t>(0, landmark_nodes.size()))
+        {
+            landmarks.weights[node * stride + landmark] = weights_from_landmarks[landmark][node];
+            landmarks.weights[node * stride + landmarks.number_of_landmarks + landmark] =
+                weights_to_landmarks[landmark][node];
+        }
+    }
+    return landmarks;
+}
+
+void writeCoreLandmarks(const std::string &path, const CoreLandmarks &landmarks)
+{
+    boost::filesystem::ofstream stream(path, std::ios::binary);
+    util::writeFingerprint(stream);
+    stream.write(reinterpret_cast<const char *>(&landmarks.number_of_landmarks),
+                 sizeof(landmarks.number_of_landmarks));
+    if (!util::serializeVector(stream, landmarks.core_indices) ||
+        !util::serializeVector(stream, landmarks.weights))
+    {
+        throw util::exception("Failed to write the core landmarks to " + path);
+    }
+}
+}
+}
@@ -0,0 +1,602 @@
+#include "contractor/customizable_contractor.hpp"
+
+#include "util/crc32c.hpp"
+#include "util/integer_range.hpp"
+#include "util/simple_logger.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace osrm
+{
+namespace contractor
+{
+
+namespace
+{
+// parts up to this size are not split any further
+const constexpr std::size_t MIN_DISSECTION_SIZE = 8;
+const constexpr std::uint32_t UNREACHED = std::numeric_limits<std::uint32_t>::max();
+
+// Undirected adjacency array of the graph without loops and parallel edges
+struct UndirectedGraph
+{
+    UndirectedGraph(const NodeID number_of_nodes, CustomizableContractor::EdgeList &edges)
+        : first_edge(number_of_nodes + 1, 0)
+    {
+        std::vector<std::pair<NodeID, NodeID>> pairs;
+        pairs.reserve(2 * edges.size());
+        for (const auto &edge : edges)
+        {
+            if (edge.source != edge.target)
+            {
+                pairs.emplace_back(edge.source, edge.target);
+                pairs.emplace_back(edge.target, edge.source);
+            }
+        }
+        tbb::parallel_sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+        targets.reserve(pairs.size());
+        for (const auto &pair : pairs)
+        {
+            ++first_edge[pair.first + 1];
+            targets.push_back(pair.second);
+        }
+        for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+        {
+            first_edge[node + 1] += first_edge[node];
+        }
+    }
+
+    template <typename CallbackT> void ForEachNeighbour(const NodeID node, CallbackT callback) const
+    {
+        for (auto edge = first_edge[node]; edge != first_edge[node + 1]; ++edge)
+        {
+            callback(targets[edge]);
+        }
+    }
+
+    std::vector<EdgeID> first_edge;
+    std::vector<NodeID> targets;
+};
+
+// Nodes of the graph that get the ranks [first_rank, first_rank + nodes.size())
+struct DissectionPart
+{
+    std::vector<NodeID> nodes;
+    NodeID first_rank;
+};
+
+inline bool isSameMetric(const CustomizableContractor::ArcMetric &lhs,
+                         const CustomizableContractor::ArcMetric &rhs)
+{
+    return lhs.weight == rhs.weight && lhs.distance == rhs.distance && lhs.via == rhs.via &&
+           lhs.edge_id == rhs.edge_id;
+}
+
+inline std::int64_t sum(const CustomizableContractor::ArcMetric &first,
+                        const CustomizableContractor::ArcMetric &second)
+{
+    if (first.weight == INVALID_EDGE_WEIGHT || second.weight == INVALID_EDGE_WEIGHT)
+    {
+        return std::numeric_limits<std::int64_t>::max();
+    }
+    return static_cast<std::int64_t>(first.weight) + second.weight;
+}
+
+// Takes the path over the first and the second arc if it is shorter
+inline bool relaxMetric(CustomizableContractor::ArcMetric &metric,
+                        const CustomizableContractor::ArcMetric &first,
+                        const CustomizableContractor::ArcMetric &second,
+                        const NodeID via)
+{
+    const auto new_weight = sum(first, second);
+    if (new_weight < metric.weight)
+    {
+        metric.weight = static_cast<EdgeWeight>(new_weight);
+        metric.distance = first.distance + second.distance;
+        metric.via = via;
+        return true;
+    }
+    return false;
+}
+}
+
+std::vector<NodeID> CustomizableContractor::ComputeNodeRanks(const NodeID number_of_nodes,
+                                                             EdgeList &edges)
+{
+    const UndirectedGraph graph(number_of_nodes, edges);
+
+    std::vector<NodeID> ranks(number_of_nodes, SPECIAL_NODEID);
+    // parts are identified by a tag, every node carries the tag of the part it is in
+    std::vector<std::uint32_t> node_tags(number_of_nodes, 0);
+    std::vector<std::uint32_t> distances(number_of_nodes, UNREACHED);
+    std::uint32_t next_tag = 0;
+
+    std::vector<DissectionPart> parts;
+    parts.push_back({{}, 0});
+    parts.back().nodes.resize(number_of_nodes);
+    std::iota(parts.back().nodes.begin(), parts.back().nodes.end(), 0);
+
+    std::vector<NodeID> queue;
+    // breadth first search inside the part, returns the visited nodes in the order of their
+    // distance to the start
+    const auto search = [&](const NodeID start, const std::uint32_t tag) {
+        queue.clear();
+        queue.push_back(start);
+        distances[start] = 0;
+        for (std::size_t index = 0; index < queue.size(); ++index)
+        {
+            const auto node = queue[index];
+            graph.ForEachNeighbour(node, [&](const NodeID neighbour) {
+                if (node_tags[neighbour] == tag && distances[neighbour] == UNREACHED)
+                {
+                    distances[neighbour] = distances[node] + 1;
+                    queue.push_back(neighbour);
+                }
+            });
+        }
+    };
+    const auto reset_distances = [&](const std::vector<NodeID> &nodes) {
+        for (const auto node : nodes)
+        {
+            distances[node] = UNREACHED;
+        }
+    };
+    const auto assign_ranks = [&](const std::vector<NodeID> &nodes, NodeID first_rank) {
+        for (const auto node : nodes)
+        {
+            ranks[node] = first_rank++;
+        }
+    };
+
+    while (!parts.empty())
+    {
+        auto part = std::move(parts.back());
+        parts.pop_back();
+
+        if (part.nodes.size() <= MIN_DISSECTION_SIZE)
+        {
+            assign_ranks(part.nodes, part.first_rank);
+            continue;
+        }
+
+        const auto tag = ++next_tag;
+        for (const auto node : part.nodes)
+        {
+            node_tags[node] = tag;
+        }
+
+        // disconnected parts are split into their components without a separator
+        search(part.nodes.front(), tag);
+        if (queue.size() < part.nodes.size())
+        {
+            auto first_rank = part.first_rank;
+            std::vector<NodeID> component(queue);
+            for (const auto node : part.nodes)
+            {
+                if (distances[node] == UNREACHED)
+                {
+                    search(node, tag);
+                    parts.push_back({queue, first_rank});
+                    first_rank += queue.size();
+                }
+            }
+            parts.push_back({std::move(component), first_rank});
+            reset_distances(part.nodes);
+            continue;
+        }
+
+        // the last node reached is far from the start, its search has many small levels
+        const auto peripheral_node = queue.back();
+        reset_distances(part.nodes);
+        search(peripheral_node, tag);
+
+        const auto number_of_levels = distances[queue.back()] + 1;
+        std::vector<std::size_t> level_sizes(number_of_levels, 0);
+        for (const auto node : queue)
+        {
+            ++level_sizes[distances[node]];
+        }
+
+        // the smallest level that leaves between a quarter and three quarters on either side,
+        // the level that holds the median node if there is none
+        const auto size = part.nodes.size();
+        std::uint32_t separator_level = 0;
+        std::size_t nodes_below = 0;
+        std::size_t best_size = std::numeric_limits<std::size_t>::max();
+        for (const auto level : util::irange<std::uint32_t>(0, number_of_levels))
+        {
+            const auto nodes_above = size - nodes_below - level_sizes[level];
+            if (4 * nodes_below >= size && 4 * nodes_above >= size &&
+                level_sizes[level] < best_size)
+            {
+                separator_level = level;
+                best_size = level_sizes[level];
+            }
+            if (best_size == std::numeric_limits<std::size_t>::max() && 2 * nodes_below < size &&
+                2 * (nodes_below + level_sizes[level]) >= size)
+            {
+                separator_level = level;
+            }
+            nodes_below += level_sizes[level];
+        }
+
+        std::vector<NodeID> lower_part, upper_part, separator;
+        for (const auto node : queue)
+        {
+            const auto distance = distances[node];
+            (distance < separator_level ? lower_part
+                                        : distance > separator_level ? upper_part : separator)
+                .push_back(node);
+        }
+        reset_distances(part.nodes);
+
+        // a part without a balanced separator, like a dense cluster, is contracted as a whole
+        if (lower_part.empty() && upper_part.empty())
+        {
+            assign_ranks(part.nodes, part.first_rank);
+            continue;
+        }
+
+        const NodeID upper_first_rank = part.first_rank + lower_part.size();
+        assign_ranks(separator, upper_first_rank + upper_part.size());
+        parts.push_back({std::move(lower_part), part.first_rank});
+        parts.push_back({std::move(upper_part), upper_first_rank});
+    }
+
+    BOOST_ASSERT(std::find(ranks.begin(), ranks.end(), SPECIAL_NODEID) == ranks.end());
+    return ranks;
+}
+
+CustomizableContractor::CustomizableContractor(const NodeID number_of_nodes,
+                                               EdgeList &edges,
+                                               std::vector<NodeID> node_ranks_)
+    : node_ranks(std::move(node_ranks_)), rank_nodes(number_of_nodes)
+{
+    BOOST_ASSERT(node_ranks.size() == number_of_nodes);
+    for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+    {
+        rank_nodes[node_ranks[node]] = node;
+    }
+
+    std::vector<std::vector<NodeID>> upper_neighbours(number_of_nodes);
+    for (const auto &edge : edges)
+    {
+        if (edge.source != edge.target)
+        {
+            const auto source_rank = node_ranks[edge.source];
+            const auto target_rank = node_ranks[edge.target];
+            upper_neighbours[std::min(source_rank, target_rank)].push_back(
+                std::max(source_rank, target_rank));
+        }
+    }
+
+    // Contracting a node connects all of its upper neighbours. It is enough to connect the lowest
+    // one to the others, it passes them on to its own upper neighbours once it is contracted.
+    first_arc.reserve(number_of_nodes + 1);
+    for (const auto rank : util::irange<NodeID>(0, number_of_nodes))
+    {
+        auto &neighbours = upper_neighbours[rank];
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        if (neighbours.size() > 1)
+        {
+            auto &parent_neighbours = upper_neighbours[neighbours.front()];
+            parent_neighbours.insert(
+                parent_neighbours.end(), neighbours.begin() + 1, neighbours.end());
+        }
+
+        first_arc.push_back(arc_head.size());
+        arc_head.insert(arc_head.end(), neighbours.begin(), neighbours.end());
+        std::vector<NodeID>().swap(neighbours);
+    }
+    first_arc.push_back(arc_head.size());
+
+    first_lower_arc.resize(number_of_nodes + 1, 0);
+    for (const auto head : arc_head)
+    {
+        ++first_lower_arc[head + 1];
+    }
+    for (const auto rank : util::irange<NodeID>(0, number_of_nodes))
+    {
+        first_lower_arc[rank + 1] += first_lower_arc[rank];
+    }
+    lower_arcs.resize(arc_head.size());
+    lower_arc_tails.resize(arc_head.size());
+    {
+        auto next_lower_arc = first_lower_arc;
+        for (const auto rank : util::irange<NodeID>(0, number_of_nodes))
+        {
+            for (auto arc = first_arc[rank]; arc != first_arc[rank + 1]; ++arc)
+            {
+                const auto index = next_lower_arc[arc_head[arc]]++;
+                lower_arcs[index] = arc;
+                lower_arc_tails[index] = rank;
+            }
+        }
+    }
+
+    std::vector<std::uint32_t> node_levels(number_of_nodes, 0);
+    for (const auto rank : util::irange<NodeID>(0, number_of_nodes))
+    {
+        for (auto arc = first_arc[rank]; arc != first_arc[rank + 1]; ++arc)
+        {
+            node_levels[arc_head[arc]] =
+                std::max(node_levels[arc_head[arc]], node_levels[rank] + 1);
+        }
+        if (node_levels[rank] >= levels.size())
+        {
+            levels.resize(node_levels[rank] + 1);
+        }
+        levels[node_levels[rank]].push_back(rank);
+    }
+
+    util::SimpleLogger().Write() << "chordal supergraph has " << arc_head.size() << " arcs and "
+                                 << levels.size() << " levels";
+
+    const auto checksum_of = [](const auto &values, const std::uint32_t crc) {
+        return util::crc32c(reinterpret_cast<const char *>(values.data()),
+                            values.size() * sizeof(values.front()),
+                            crc);
+    };
+    metric.checksum = checksum_of(arc_head, checksum_of(first_arc, checksum_of(rank_nodes, 0)));
+}
+
+void CustomizableContractor::SetEdgeMetric(EdgeList &edges)
+{
+    const ArcMetric no_path{INVALID_EDGE_WEIGHT, 0, SPECIAL_NODEID, SPECIAL_EDGEID};
+    metric.edge_up.assign(arc_head.size(), no_path);
+    metric.edge_down.assign(arc_head.size(), no_path);
+
+    const auto find_arc = [this](const NodeID tail, const NodeID head) {
+        const auto begin = arc_head.begin() + first_arc[tail];
+        const auto end = arc_head.begin() + first_arc[tail + 1];
+        const auto iter = std::lower_bound(begin, end, head);
+        BOOST_ASSERT(iter != end && *iter == head);
+        return static_cast<EdgeID>(iter - arc_head.begin());
+    };
+    // parallel edges keep the smallest weight, ties keep the smallest edge id
+    const auto set_edge = [](ArcMetric &arc_metric,
+                             const EdgeWeight weight,
+                             const EdgeDistance distance,
+                             const NodeID edge_id) {
+        if (weight < arc_metric.weight ||
+            (weight == arc_metric.weight && edge_id < arc_metric.edge_id))
+        {
+            arc_metric = ArcMetric{weight, distance, SPECIAL_NODEID, edge_id};
+        }
+    };
+
+    for (const auto &edge : edges)
+    {
+        if (edge.source == edge.target)
+        {
+            continue;
+        }
+        const auto source_rank = node_ranks[edge.source];
+        const auto target_rank = node_ranks[edge.target];
+        const auto is_upward = source_rank < target_rank;
+        const auto arc =
+            find_arc(std::min(source_rank, target_rank), std::max(source_rank, target_rank));
+        const auto weight = std::max<EdgeWeight>(edge.weight, 1);
+        if (edge.forward)
+        {
+            set_edge(is_upward ? metric.edge_up[arc] : metric.edge_down[arc],
+                     weight,
+                     edge.distance,
+                     edge.edge_id);
+        }
+        if (edge.backward)
+        {
+            set_edge(is_upward ? metric.edge_down[arc] : metric.edge_up[arc],
+                     weight,
+                     edge.distance,
+                     edge.edge_id);
+        }
+    }
+}
+
+// The arcs of a node only get shorter through lower triangles, paths over a lower node whose arcs
+// are final already. Every node only writes its own arcs, starting from its original edges.
+void CustomizableContractor::CustomizeNode(const NodeID rank)
+{
+    auto &up_metric = metric.up;
+    auto &down_metric = metric.down;
+    std::copy(metric.edge_up.begin() + first_arc[rank],
+              metric.edge_up.begin() + first_arc[rank + 1],
+              up_metric.begin() + first_arc[rank]);
+    std::copy(metric.edge_down.begin() + first_arc[rank],
+              metric.edge_down.begin() + first_arc[rank + 1],
+              down_metric.begin() + first_arc[rank]);
+    auto &loop = metric.loop[rank];
+    loop = ArcMetric{INVALID_EDGE_WEIGHT, 0, SPECIAL_NODEID, SPECIAL_EDGEID};
+
+    for (auto index = first_lower_arc[rank]; index != first_lower_arc[rank + 1]; ++index)
+    {
+        const auto arc_to_rank = lower_arcs[index];
+        const auto lower_rank = lower_arc_tails[index];
+
+        // rank -> lower_rank -> rank
+        relaxMetric(loop, down_metric[arc_to_rank], up_metric[arc_to_rank], lower_rank);
+
+        // the higher neighbours of the lower node are neighbours of this node as well and both
+        // lists are sorted, one pass over them finds all triangles
+        auto arc_from_rank = first_arc[rank];
+        for (auto arc_to_head = arc_to_rank + 1; arc_to_head != first_arc[lower_rank + 1];
+             ++arc_to_head)
+        {
+            const auto head = arc_head[arc_to_head];
+            while (arc_head[arc_from_rank] != head)
+            {
+                ++arc_from_rank;
+                BOOST_ASSERT(arc_from_rank < first_arc[rank + 1]);
+            }
+            // rank -> lower_rank -> head and back
+            auto &up = up_metric[arc_from_rank];
+            auto &down = down_metric[arc_from_rank];
+            relaxMetric(up, down_metric[arc_to_rank], up_metric[arc_to_head], lower_rank);
+            relaxMetric(down, down_metric[arc_to_head], up_metric[arc_to_rank], lower_rank);
+        }
+    }
+}
+
+void CustomizableContractor::Customize(EdgeList &edges)
+{
+    SetEdgeMetric(edges);
+    metric.up.resize(arc_head.size());
+    metric.down.resize(arc_head.size());
+    metric.loop.resize(rank_nodes.size());
+
+    for (const auto &level : levels)
+    {
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, level.size()),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              for (auto index = range.begin(); index != range.end(); ++index)
+                              {
+                                  CustomizeNode(level[index]);
+                              }
+                          });
+    }
+}
+
+std::size_t CustomizableContractor::Customize(EdgeList &edges, Metric previous)
+{
+    if (previous.checksum != metric.checksum || previous.up.size() != arc_head.size() ||
+        previous.down.size() != arc_head.size() || previous.loop.size() != rank_nodes.size() ||
+        previous.edge_up.size() != arc_head.size() || previous.edge_down.size() != arc_head.size())
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "previous metric does not match the arcs, customizing all nodes";
+        Customize(edges);
+        return rank_nodes.size();
+    }
+
+    SetEdgeMetric(edges);
+    metric.up = std::move(previous.up);
+    metric.down = std::move(previous.down);
+    metric.loop = std::move(previous.loop);
+
+    // a node whose arcs changed invalidates the triangles of its higher neighbours. They are on
+    // higher levels, so every level only reads the flags of lower ones.
+    std::vector<std::uint8_t> is_changed(rank_nodes.size(), 0);
+    std::atomic<std::size_t> number_of_customized_nodes{0};
+    const auto needs_customization = [&](const NodeID rank) {
+        for (auto arc = first_arc[rank]; arc != first_arc[rank + 1]; ++arc)
+        {
+            if (!isSameMetric(metric.edge_up[arc], previous.edge_up[arc]) ||
+                !isSameMetric(metric.edge_down[arc], previous.edge_down[arc]))
+            {
+                return true;
+            }
+        }
+        for (auto index = first_lower_arc[rank]; index != first_lower_arc[rank + 1]; ++index)
+        {
+            if (is_changed[lower_arc_tails[index]])
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    for (const auto &level : levels)
+    {
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, level.size()),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                std::size_t customized_nodes = 0;
+                std::vector<ArcMetric> old_up, old_down;
+                for (auto index = range.begin(); index != range.end(); ++index)
+                {
+                    const auto rank = level[index];
+                    if (!needs_customization(rank))
+                    {
+                        continue;
+                    }
+
+                    old_up.assign(metric.up.begin() + first_arc[rank],
+                                  metric.up.begin() + first_arc[rank + 1]);
+                    old_down.assign(metric.down.begin() + first_arc[rank],
+                                    metric.down.begin() + first_arc[rank + 1]);
+                    CustomizeNode(rank);
+                    ++customized_nodes;
+
+                    // the loop is only used by queries, it does not affect other nodes
+                    is_changed[rank] = !std::equal(old_up.begin(),
+                                                   old_up.end(),
+                                                   metric.up.begin() + first_arc[rank],
+                                                   isSameMetric) ||
+                                       !std::equal(old_down.begin(),
+                                                   old_down.end(),
+                                                   metric.down.begin() + first_arc[rank],
+                                                   isSameMetric);
+                }
+                number_of_customized_nodes += customized_nodes;
+            });
+    }
+
+    return number_of_customized_nodes;
+}
+
+void CustomizableContractor::GetEdges(stxxl::vector<QueryEdge> &edges) const
+{
+    const auto make_data = [this](
+        const ArcMetric &metric, const bool forward, const bool backward) {
+        QueryEdge::EdgeData data;
+        data.weight = metric.weight;
+        data.distance = metric.distance;
+        data.shortcut = metric.via != SPECIAL_NODEID;
+        data.id = data.shortcut ? rank_nodes[metric.via] : metric.edge_id;
+        data.forward = forward;
+        data.backward = backward;
+        return data;
+    };
+
+    for (const auto rank : util::irange<NodeID>(0, rank_nodes.size()))
+    {
+        const auto node = rank_nodes[rank];
+        for (auto arc = first_arc[rank]; arc != first_arc[rank + 1]; ++arc)
+        {
+            const auto head = rank_nodes[arc_head[arc]];
+            const auto &up = metric.up[arc];
+            const auto &down = metric.down[arc];
+            const auto has_up = up.weight != INVALID_EDGE_WEIGHT;
+            const auto has_down = down.weight != INVALID_EDGE_WEIGHT;
+            if (has_up && has_down && isSameMetric(up, down))
+            {
+                edges.push_back(QueryEdge(node, head, make_data(up, true, true)));
+                continue;
+            }
+            if (has_up)
+            {
+                edges.push_back(QueryEdge(node, head, make_data(up, true, false)));
+            }
+            if (has_down)
+            {
+                edges.push_back(QueryEdge(node, head, make_data(down, false, true)));
+            }
+        }
+
+        // u-turns are stored as a pair of one directional loops like contracted ones
+        const auto &loop = metric.loop[rank];
+        if (loop.weight != INVALID_EDGE_WEIGHT)
+        {
+            edges.push_back(QueryEdge(node, node, make_data(loop, true, false)));
+            edges.push_back(QueryEdge(node, node, make_data(loop, false, true)));
+        }
+    }
+}
+}
+}
@@ -0,0 +1,532 @@
+#include "contractor/geographic_partition.hpp"
+
+#include "extractor/edge_based_node.hpp"
+#include "extractor/query_node.hpp"
+#include "util/d_ary_heap.hpp"
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+#include "util/io.hpp"
+#include "util/static_rtree.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_invoke.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <numeric>
+
+namespace osrm
+{
+namespace contractor
+{
+
+namespace
+{
+// meters of one degree of latitude
+const constexpr double METERS_PER_DEGREE = 111320.;
+// the overlap in longitude is computed at this latitude at most
+const constexpr double MAX_OVERLAP_LATITUDE = 85.;
+
+struct OverlayHeapData
+{
+};
+using OverlayHeap = util::DAryHeap<NodeID,
+                                   NodeID,
+                                   EdgeWeight,
+                                   OverlayHeapData,
+                                   util::TimestampedArrayStorage<NodeID, NodeID>>;
+
+std::int32_t fixedLongitude(const util::Coordinate coordinate)
+{
+    return static_cast<std::int32_t>(coordinate.lon);
+}
+
+std::int32_t fixedLatitude(const util::Coordinate coordinate)
+{
+    return static_cast<std::int32_t>(coordinate.lat);
+}
+
+// Assigns the home nodes in [begin, end) to the cells [first_cell, first_cell + number_of_cells)
+// and the guests, nodes of other regions within the overlap, to their shards
+void bisect(const std::vector<util::Coordinate> &coordinates,
+            const std::vector<NodeID>::iterator begin,
+            const std::vector<NodeID>::iterator end,
+            const std::vector<NodeID> &guests,
+            const CellID first_cell,
+            const CellID number_of_cells,
+            const double overlap_meters,
+            std::vector<CellID> &node_cells,
+            std::vector<std::vector<NodeID>> &shards)
+{
+    if (number_of_cells == 1)
+    {
+        auto &shard = shards[first_cell];
+        shard.reserve(std::distance(begin, end) + guests.size());
+        for (auto node = begin; node != end; ++node)
+        {
+            node_cells[*node] = first_cell;
+            shard.push_back(*node);
+        }
+        shard.insert(shard.end(), guests.begin(), guests.end());
+        std::sort(shard.begin(), shard.end());
+        return;
+    }
+
+    std::int32_t min_lon = std::numeric_limits<std::int32_t>::max();
+    std::int32_t max_lon = std::numeric_limits<std::int32_t>::min();
+    std::int32_t min_lat = std::numeric_limits<std::int32_t>::max();
+    std::int32_t max_lat = std::numeric_limits<std::int32_t>::min();
+    for (auto node = begin; node != end; ++node)
+    {
+        min_lon = std::min(min_lon, fixedLongitude(coordinates[*node]));
+        max_lon = std::max(max_lon, fixedLongitude(coordinates[*node]));
+        min_lat = std::min(min_lat, fixedLatitude(coordinates[*node]));
+        max_lat = std::max(max_lat, fixedLatitude(coordinates[*node]));
+    }
+
+    // the extent of a degree of longitude shrinks towards the poles
+    const double max_abs_latitude =
+        begin == end ? 0.
+                     : std::min(MAX_OVERLAP_LATITUDE,
+                                std::max(std::abs(min_lat), std::abs(max_lat)) /
+                                    COORDINATE_PRECISION);
+    const double longitude_scale = std::cos(max_abs_latitude * M_PI / 180.);
+    const bool split_longitude = begin != end && static_cast<double>(max_lon - min_lon) *
+                                                         longitude_scale >
+                                                     static_cast<double>(max_lat - min_lat);
+    const auto value = [&](const NodeID node) {
+        return split_longitude ? fixedLongitude(coordinates[node])
+                               : fixedLatitude(coordinates[node]);
+    };
+    const double overlap_degrees =
+        overlap_meters / METERS_PER_DEGREE / (split_longitude ? longitude_scale : 1.);
+    const auto overlap = static_cast<std::int64_t>(overlap_degrees * COORDINATE_PRECISION);
+
+    // the nodes are divided in the ratio of the cells of both sides
+    const CellID left_cells = number_of_cells / 2;
+    const auto split = begin + std::distance(begin, end) * left_cells / number_of_cells;
+    std::nth_element(begin, split, end, [&](const NodeID lhs, const NodeID rhs) {
+        return value(lhs) < value(rhs);
+    });
+    const std::int64_t split_value =
+        split == end ? std::numeric_limits<std::int32_t>::max() : value(*split);
+
+    std::vector<NodeID> left_guests;
+    std::vector<NodeID> right_guests;
+    for (const auto node : guests)
+    {
+        if (value(node) < split_value + overlap)
+        {
+            left_guests.push_back(node);
+        }
+        if (value(node) >= split_value - overlap)
+        {
+            right_guests.push_back(node);
+        }
+    }
+    for (auto node = begin; node != split; ++node)
+    {
+        if (value(*node) >= split_value - overlap)
+        {
+            right_guests.push_back(*node);
+        }
+    }
+    for (auto node = split; node != end; ++node)
+    {
+        if (value(*node) < split_value + overlap)
+        {
+            left_guests.push_back(*node);
+        }
+    }
+
+    tbb::parallel_invoke(
+        [&] {
+            bisect(coordinates,
+                   begin,
+                   split,
+                   left_guests,
+                   first_cell,
+                   left_cells,
+                   overlap_meters,
+                   node_cells,
+                   shards);
+        },
+        [&] {
+            bisect(coordinates,
+                   split,
+                   end,
+                   right_guests,
+                   first_cell + left_cells,
+                   number_of_cells - left_cells,
+                   overlap_meters,
+                   node_cells,
+                   shards);
+        });
+}
+
+// Assigns the cells of the levels the region is the largest one for, then splits it further
+// for the levels below
+void bisectLevels(const std::vector<util::Coordinate> &coordinates,
+                  const std::vector<NodeID>::iterator begin,
+                  const std::vector<NodeID>::iterator end,
+                  const std::vector<std::size_t> &max_cell_sizes,
+                  const std::size_t unassigned_levels,
+                  std::vector<std::vector<CellID>> &level_cells,
+                  std::vector<CellID> &next_cells)
+{
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    auto levels = unassigned_levels;
+    while (levels > 0 && size <= max_cell_sizes[levels - 1])
+    {
+        --levels;
+        const auto cell = next_cells[levels]++;
+        for (auto node = begin; node != end; ++node)
+        {
+            level_cells[levels][*node] = cell;
+        }
+    }
+    if (levels == 0)
+    {
+        return;
+    }
+
+    std::int32_t min_lon = std::numeric_limits<std::int32_t>::max();
+    std::int32_t max_lon = std::numeric_limits<std::int32_t>::min();
+    std::int32_t min_lat = std::numeric_limits<std::int32_t>::max();
+    std::int32_t max_lat = std::numeric_limits<std::int32_t>::min();
+    for (auto node = begin; node != end; ++node)
+    {
+        min_lon = std::min(min_lon, fixedLongitude(coordinates[*node]));
+        max_lon = std::max(max_lon, fixedLongitude(coordinates[*node]));
+        min_lat = std::min(min_lat, fixedLatitude(coordinates[*node]));
+        max_lat = std::max(max_lat, fixedLatitude(coordinates[*node]));
+    }
+    const double max_abs_latitude =
+        std::min(MAX_OVERLAP_LATITUDE,
+                 std::max(std::abs(min_lat), std::abs(max_lat)) / COORDINATE_PRECISION);
+    const bool split_longitude =
+        static_cast<double>(max_lon - min_lon) * std::cos(max_abs_latitude * M_PI / 180.) >
+        static_cast<double>(max_lat - min_lat);
+
+    const auto split = begin + size / 2;
+    std::nth_element(begin, split, end, [&](const NodeID lhs, const NodeID rhs) {
+        return split_longitude ? fixedLongitude(coordinates[lhs]) < fixedLongitude(coordinates[rhs])
+                               : fixedLatitude(coordinates[lhs]) < fixedLatitude(coordinates[rhs]);
+    });
+    bisectLevels(coordinates, begin, split, max_cell_sizes, levels, level_cells, next_cells);
+    bisectLevels(coordinates, split, end, max_cell_sizes, levels, level_cells, next_cells);
+}
+}
+
+std::vector<bool> GeographicPartition::GetShardNodes(const CellID cell) const
+{
+    BOOST_ASSERT(cell < NumberOfCells());
+    std::vector<bool> is_shard_node(node_cells.size(), false);
+    for (const auto index : util::irange(shard_offsets[cell], shard_offsets[cell + 1]))
+    {
+        is_shard_node[shard_nodes[index]] = true;
+    }
+    return is_shard_node;
+}
+
+std::vector<util::Coordinate> readEdgeBasedNodeCoordinates(const std::string &nodes_path,
+                                                           const std::string &rtree_leaf_path)
+{
+    boost::filesystem::ifstream nodes_stream(nodes_path, std::ios::binary);
+    if (!nodes_stream)
+    {
+        throw util::exception("Failed to open " + nodes_path);
+    }
+    std::uint64_t number_of_nodes = 0;
+    nodes_stream.read(reinterpret_cast<char *>(&number_of_nodes), sizeof(number_of_nodes));
+    std::vector<extractor::QueryNode> nodes(number_of_nodes);
+    nodes_stream.read(reinterpret_cast<char *>(nodes.data()),
+                      number_of_nodes * sizeof(extractor::QueryNode));
+    if (!nodes_stream)
+    {
+        throw util::exception("Failed to read the nodes from " + nodes_path);
+    }
+
+    using LeafNode = util::StaticRTree<extractor::EdgeBasedNodeSegment>::LeafNode;
+    const boost::interprocess::file_mapping mapping{rtree_leaf_path.c_str(),
+                                                    boost::interprocess::read_only};
+    boost::interprocess::mapped_region region{mapping, boost::interprocess::read_only};
+    region.advise(boost::interprocess::mapped_region::advice_sequential);
+    const auto first = static_cast<const LeafNode *>(region.get_address());
+    const auto last = first + region.get_size() / sizeof(LeafNode);
+
+    std::vector<util::Coordinate> coordinates;
+    const auto set_coordinate = [&](const NodeID node,
+                                    const extractor::EdgeBasedNodeSegment &segment) {
+        if (node >= coordinates.size())
+        {
+            coordinates.resize(node + 1);
+        }
+        // the first segment of a node decides, any segment for nodes where it is missing
+        if (segment.fwd_segment_position == 0 || !coordinates[node].IsValid())
+        {
+            BOOST_ASSERT(segment.u < nodes.size());
+            coordinates[node] = util::Coordinate(nodes[segment.u]);
+        }
+    };
+    for (auto leaf = first; leaf != last; ++leaf)
+    {
+        for (const auto index : util::irange<std::uint32_t>(0, leaf->object_count))
+        {
+            const auto &segment = leaf->objects[index];
+            if (segment.forward_segment_id.enabled)
+            {
+                set_coordinate(segment.forward_segment_id.id, segment);
+            }
+            if (segment.reverse_segment_id.enabled)
+            {
+                set_coordinate(segment.reverse_segment_id.id, segment);
+            }
+        }
+    }
+    return coordinates;
+}
+
+GeographicPartition partitionByCoordinates(const std::vector<util::Coordinate> &coordinates,
+                                           const CellID number_of_cells,
+                                           const double overlap_meters)
+{
+    BOOST_ASSERT(number_of_cells > 0);
+    GeographicPartition partition;
+    partition.node_cells.resize(coordinates.size(), INVALID_CELL_ID);
+
+    std::vector<NodeID> located_nodes;
+    located_nodes.reserve(coordinates.size());
+    for (const auto node : util::irange<NodeID>(0, coordinates.size()))
+    {
+        if (coordinates[node].IsValid())
+        {
+            located_nodes.push_back(node);
+        }
+    }
+
+    std::vector<std::vector<NodeID>> shards(number_of_cells);
+    bisect(coordinates,
+           located_nodes.begin(),
+           located_nodes.end(),
+           {},
+           0,
+           number_of_cells,
+           overlap_meters,
+           partition.node_cells,
+           shards);
+
+    partition.shard_offsets.reserve(number_of_cells + 1);
+    partition.shard_offsets.push_back(0);
+    for (const auto &shard : shards)
+    {
+        partition.shard_offsets.push_back(partition.shard_offsets.back() + shard.size());
+    }
+    partition.shard_nodes.reserve(partition.shard_offsets.back());
+    for (const auto &shard : shards)
+    {
+        partition.shard_nodes.insert(partition.shard_nodes.end(), shard.begin(), shard.end());
+    }
+    return partition;
+}
+
+std::vector<std::vector<CellID>>
+partitionIntoLevels(const std::vector<util::Coordinate> &coordinates,
+                    const std::vector<std::size_t> &max_cell_sizes)
+{
+    BOOST_ASSERT(std::is_sorted(max_cell_sizes.begin(), max_cell_sizes.end()));
+    BOOST_ASSERT(max_cell_sizes.empty() || max_cell_sizes.front() > 0);
+
+    // nodes without a location have no edges, any cell will do for them
+    std::vector<util::Coordinate> located_coordinates(coordinates);
+    for (auto &coordinate : located_coordinates)
+    {
+        if (!coordinate.IsValid())
+        {
+            coordinate = util::Coordinate(util::FixedLongitude{0}, util::FixedLatitude{0});
+        }
+    }
+
+    std::vector<NodeID> nodes(coordinates.size());
+    std::iota(nodes.begin(), nodes.end(), 0);
+    std::vector<std::vector<CellID>> level_cells(max_cell_sizes.size(),
+                                                 std::vector<CellID>(coordinates.size(), 0));
+    std::vector<CellID> next_cells(max_cell_sizes.size(), 0);
+    bisectLevels(located_coordinates,
+                 nodes.begin(),
+                 nodes.end(),
+                 max_cell_sizes,
+                 max_cell_sizes.size(),
+                 level_cells,
+                 next_cells);
+    return level_cells;
+}
+
+void writePartition(const std::string &path, const GeographicPartition &partition)
+{
+    boost::filesystem::ofstream stream(path, std::ios::binary);
+    if (!util::serializeVector(stream, partition.node_cells) ||
+        !util::serializeVector(stream, partition.shard_offsets) ||
+        !util::serializeVector(stream, partition.shard_nodes))
+    {
+        throw util::exception("Failed to write the partition to " + path);
+    }
+}
+
+GeographicPartition readPartition(const std::string &path)
+{
+    GeographicPartition partition;
+    boost::filesystem::ifstream stream(path, std::ios::binary);
+    if (!stream || !util::deserializeVector(stream, partition.node_cells) ||
+        !util::deserializeVector(stream, partition.shard_offsets) ||
+        !util::deserializeVector(stream, partition.shard_nodes) ||
+        partition.shard_offsets.empty() ||
+        partition.shard_offsets.back() != partition.shard_nodes.size())
+    {
+        throw util::exception("Failed to read the partition from " + path +
+                              ", run osrm-partition first");
+    }
+    return partition;
+}
+
+std::vector<NodeID>
+getBorderNodes(const GeographicPartition &partition,
+               const CellID cell,
+               const util::DeallocatingVector<extractor::EdgeBasedEdge> &edges)
+{
+    const auto &node_cells = partition.node_cells;
+    std::vector<bool> is_border_node(node_cells.size(), false);
+    for (const auto index : util::irange<std::size_t>(0, edges.size()))
+    {
+        const auto &edge = edges[index];
+        BOOST_ASSERT(edge.source < node_cells.size() && edge.target < node_cells.size());
+        if (node_cells[edge.source] == node_cells[edge.target])
+        {
+            continue;
+        }
+        if (node_cells[edge.source] == cell)
+        {
+            is_border_node[edge.source] = true;
+        }
+        if (node_cells[edge.target] == cell)
+        {
+            is_border_node[edge.target] = true;
+        }
+    }
+
+    std::vector<NodeID> border_nodes;
+    for (const auto node : util::irange<NodeID>(0, is_border_node.size()))
+    {
+        if (is_border_node[node])
+        {
+            border_nodes.push_back(node);
+        }
+    }
+    return border_nodes;
+}
+
+std::vector<OverlayEdge>
+computeOverlayEdges(const NodeID number_of_nodes,
+                    const std::vector<NodeID> &border_nodes,
+                    const util::DeallocatingVector<extractor::EdgeBasedEdge> &edges)
+{
+    // the arcs of the edges in the directions they can be used, by their tail
+    struct Arc
+    {
+        NodeID target;
+        EdgeWeight weight;
+    };
+    std::vector<std::uint32_t> offsets(number_of_nodes + 1, 0);
+    for (const auto index : util::irange<std::size_t>(0, edges.size()))
+    {
+        const auto &edge = edges[index];
+        offsets[edge.source + 1] += edge.forward ? 1 : 0;
+        offsets[edge.target + 1] += edge.backward ? 1 : 0;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<Arc> arcs(offsets.back());
+    {
+        auto positions = offsets;
+        for (const auto index : util::irange<std::size_t>(0, edges.size()))
+        {
+            const auto &edge = edges[index];
+            if (edge.forward)
+            {
+                arcs[positions[edge.source]++] = {edge.target, edge.weight};
+            }
+            if (edge.backward)
+            {
+                arcs[positions[edge.target]++] = {edge.source, edge.weight};
+            }
+        }
+    }
+
+    std::vector<bool> is_border_node(number_of_nodes, false);
+    for (const auto node : border_nodes)
+    {
+        is_border_node[node] = true;
+    }
+
+    // every search stops once it settled all other border nodes
+    std::vector<std::vector<OverlayEdge>> border_edges(border_nodes.size());
+    tbb::enumerable_thread_specific<std::shared_ptr<OverlayHeap>> heaps;
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, border_nodes.size()),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          auto &heap_ptr = heaps.local();
+                          if (!heap_ptr)
+                          {
+                              heap_ptr = std::make_shared<OverlayHeap>(number_of_nodes);
+                          }
+                          auto &heap = *heap_ptr;
+                          for (auto index = range.begin(); index != range.end(); ++index)
+                          {
+                              const auto source = border_nodes[index];
+                              auto &source_edges = border_edges[index];
+                              heap.Clear();
+                              heap.Insert(source, 0, {});
+                              while (!heap.Empty() &&
+                                     source_edges.size() + 1 < border_nodes.size())
+                              {
+                                  const auto node = heap.DeleteMin();
+                                  const auto weight = heap.GetKey(node);
+                                  if (node != source && is_border_node[node])
+                                  {
+                                      source_edges.push_back({source, node, weight});
+                                  }
+                                  for (const auto arc :
+                                       util::irange(offsets[node], offsets[node + 1]))
+                                  {
+                                      const auto target = arcs[arc].target;
+                                      const auto target_weight = weight + arcs[arc].weight;
+                                      if (!heap.WasInserted(target))
+                                      {
+                                          heap.Insert(target, target_weight, {});
+                                      }
+                                      else if (target_weight < heap.GetKey(target))
+                                      {
+                                          heap.DecreaseKey(target, target_weight);
+                                      }
+                                  }
+                              }
+                          }
+                      });
+
+    std::vector<OverlayEdge> overlay_edges;
+    for (const auto &source_edges : border_edges)
+    {
+        overlay_edges.insert(overlay_edges.end(), source_edges.begin(), source_edges.end());
+    }
+    return overlay_edges;
+}
+}
+}
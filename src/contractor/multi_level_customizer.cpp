@@ -0,0 +1,75 @@
+#include "contractor/multi_level_customizer.hpp"
+
+#include "util/d_ary_heap.hpp"
+#include "util/integer_range.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include <memory>
+
+namespace osrm
+{
+namespace contractor
+{
+
+namespace
+{
+using CustomizationHeap = util::DAryHeap<NodeID,
+                                         NodeID,
+                                         EdgeWeight,
+                                         util::MultiLevelHeapData,
+                                         util::TimestampedArrayStorage<NodeID, NodeID>>;
+}
+
+void customizeMultiLevelGraph(util::MultiLevelGraph &graph)
+{
+    const auto &partition = graph.GetPartition();
+    const auto number_of_nodes = graph.GetNumberOfNodes();
+    tbb::enumerable_thread_specific<std::shared_ptr<CustomizationHeap>> heaps;
+
+    // the cliques of a level only depend on the cliques of the level below
+    for (const auto level : util::irange<util::MultiLevelGraph::LevelID>(
+             1, partition.GetNumberOfLevels() + 1))
+    {
+        tbb::parallel_for(
+            tbb::blocked_range<util::MultiLevelGraph::CellID>(0, partition.GetNumberOfCells(level)),
+            [&](const tbb::blocked_range<util::MultiLevelGraph::CellID> &range) {
+                auto &heap_ptr = heaps.local();
+                if (!heap_ptr)
+                {
+                    heap_ptr = std::make_shared<CustomizationHeap>(number_of_nodes);
+                }
+                auto &heap = *heap_ptr;
+
+                for (auto cell = range.begin(); cell != range.end(); ++cell)
+                {
+                    const auto boundary = graph.GetBoundaryNodes(level, cell);
+                    const auto size = static_cast<std::size_t>(boundary.second - boundary.first);
+                    auto weights = graph.GetCliqueWeights(level, cell);
+                    for (const auto from : util::irange<std::size_t>(0, size))
+                    {
+                        const auto source = boundary.first[from];
+                        heap.Clear();
+                        heap.Insert(source, 0, {source, SPECIAL_EDGEID, 0});
+                        std::size_t settled_boundary_nodes = 0;
+                        graph.SearchCell(heap, level, cell, [&](const NodeID node) {
+                            return graph.GetBoundaryIndex(level, node) != SPECIAL_NODEID &&
+                                   ++settled_boundary_nodes == size;
+                        });
+                        for (const auto to : util::irange<std::size_t>(0, size))
+                        {
+                            const auto node = boundary.first[to];
+                            weights[from * size + to] =
+                                heap.WasInserted(node) && heap.WasRemoved(node)
+                                    ? heap.GetKey(node)
+                                    : INVALID_EDGE_WEIGHT;
+                        }
+                    }
+                }
+            });
+    }
+}
+}
+}
@@ -0,0 +1,97 @@
+#include "engine/api/binary_factory.hpp"
+
+#include <boost/assert.hpp>
+
+#include <cstring>
+#include <limits>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+namespace binary
+{
+
+namespace
+{
+inline char *writeWord(char *out, const std::uint32_t word)
+{
+    out[0] = static_cast<char>(word & 0xff);
+    out[1] = static_cast<char>((word >> 8) & 0xff);
+    out[2] = static_cast<char>((word >> 16) & 0xff);
+    out[3] = static_cast<char>((word >> 24) & 0xff);
+    return out + sizeof(std::uint32_t);
+}
+
+static_assert(std::numeric_limits<float>::is_iec559 && sizeof(float) == sizeof(std::uint32_t),
+              "float32 values are written as IEEE 754 single precision");
+
+// Values are written in place, the buffer is sized for all matrices up front
+char *writeMatrix(char *out,
+                  const TableValueType value_type,
+                  const std::vector<EdgeWeight> &values,
+                  const EdgeWeight invalid_value)
+{
+    if (value_type == TableValueType::Int32)
+    {
+        for (const auto value : values)
+        {
+            out = writeWord(out, static_cast<std::uint32_t>(value == invalid_value ? -1 : value));
+        }
+        return out;
+    }
+
+    for (const auto value : values)
+    {
+        const float converted =
+            value == invalid_value ? std::numeric_limits<float>::quiet_NaN() : value / 10.f;
+        std::uint32_t word;
+        std::memcpy(&word, &converted, sizeof(word));
+        out = writeWord(out, word);
+    }
+    return out;
+}
+}
+
+void writeTables(std::string &buffer,
+                 const TableValueType value_type,
+                 const std::size_t number_of_rows,
+                 const std::size_t number_of_columns,
+                 const std::vector<EdgeWeight> *durations,
+                 const std::vector<EdgeDistance> *distances)
+{
+    const std::size_t number_of_values = number_of_rows * number_of_columns;
+    BOOST_ASSERT(!durations || durations->size() == number_of_values);
+    BOOST_ASSERT(!distances || distances->size() == number_of_values);
+    const std::size_t number_of_matrices = (durations ? 1 : 0) + (distances ? 1 : 0);
+
+    const auto offset = buffer.size();
+    buffer.resize(offset + TABLE_HEADER_SIZE +
+                  number_of_matrices * number_of_values * sizeof(std::uint32_t));
+    char *out = &buffer[offset];
+
+    std::memcpy(out, TABLE_MAGIC, sizeof(TABLE_MAGIC));
+    out += sizeof(TABLE_MAGIC);
+    out = writeWord(out, TABLE_VERSION);
+    out = writeWord(out, static_cast<std::uint32_t>(value_type));
+    out = writeWord(out, static_cast<std::uint32_t>(number_of_rows));
+    out = writeWord(out, static_cast<std::uint32_t>(number_of_columns));
+    out = writeWord(out,
+                    (durations ? TABLE_DURATIONS : 0u) | (distances ? TABLE_DISTANCES : 0u));
+
+    if (durations)
+    {
+        out = writeMatrix(out, value_type, *durations, INVALID_EDGE_WEIGHT);
+    }
+    if (distances)
+    {
+        out = writeMatrix(out, value_type, *distances, INVALID_EDGE_DISTANCE);
+    }
+    BOOST_ASSERT(out == &buffer[0] + buffer.size());
+}
+}
+}
+}
+}
@@ -242,19 +242,19 @@ util::json::Object makeRouteStep(guidance::RouteStep step, util::json::Value geo
     util::json::Object route_step;
     route_step.values["distance"] = std::round(step.distance * 10) / 10.;
     route_step.values["duration"] = std::round(step.duration * 10) / 10.;
-    route_step.values["name"] = std::move(step.name);
+    route_step.values["name"] = std::string(step.name);
     if (!step.ref.empty())
-        route_step.values["ref"] = std::move(step.ref);
+        route_step.values["ref"] = std::string(step.ref);
     if (!step.pronunciation.empty())
-        route_step.values["pronunciation"] = std::move(step.pronunciation);
+        route_step.values["pronunciation"] = std::string(step.pronunciation);
     if (!step.destinations.empty())
-        route_step.values["destinations"] = std::move(step.destinations);
+        route_step.values["destinations"] = std::string(step.destinations);
     if (!step.rotary_name.empty())
     {
-        route_step.values["rotary_name"] = std::move(step.rotary_name);
+        route_step.values["rotary_name"] = std::string(step.rotary_name);
         if (!step.rotary_pronunciation.empty())
         {
-            route_step.values["rotary_pronunciation"] = std::move(step.rotary_pronunciation);
+            route_step.values["rotary_pronunciation"] = std::string(step.rotary_pronunciation);
         }
     }
 
@@ -288,11 +288,17 @@ util::json::Object makeRoute(const guidance::Route &route,
     return json_route;
 }
 
-util::json::Object makeWaypoint(const util::Coordinate location, std::string name, const Hint &hint)
+util::json::Object makeWaypoint(const util::Coordinate location, std::string name)
 {
     util::json::Object waypoint;
     waypoint.values["location"] = detail::coordinateToLonLat(location);
     waypoint.values["name"] = std::move(name);
+    return waypoint;
+}
+
+util::json::Object makeWaypoint(const util::Coordinate location, std::string name, const Hint &hint)
+{
+    auto waypoint = makeWaypoint(location, std::move(name));
     waypoint.values["hint"] = hint.ToBase64();
     return waypoint;
 }
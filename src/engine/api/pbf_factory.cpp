@@ -0,0 +1,125 @@
+#include "engine/api/pbf_factory.hpp"
+
+#include "engine/hint.hpp"
+
+#include <boost/assert.hpp>
+#include <protozero/pbf_reader.hpp>
+
+#include <cmath>
+#include <cstdint>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+namespace pbf
+{
+
+void writeError(std::string &buffer, const std::string &code, const std::string &message)
+{
+    protozero::pbf_writer response_writer{buffer};
+    response_writer.add_string(tag::RESPONSE_CODE, code);
+    response_writer.add_string(tag::RESPONSE_MESSAGE, message);
+}
+
+bool readError(const std::string &buffer, std::string &code, std::string &message)
+{
+    try
+    {
+        protozero::pbf_reader response_reader{buffer};
+        while (response_reader.next())
+        {
+            switch (response_reader.tag())
+            {
+            case tag::RESPONSE_CODE:
+                code = response_reader.get_string();
+                break;
+            case tag::RESPONSE_MESSAGE:
+                message = response_reader.get_string();
+                break;
+            default:
+                response_reader.skip();
+            }
+        }
+    }
+    catch (const protozero::exception &)
+    {
+        return false;
+    }
+    return !code.empty();
+}
+
+void writeWaypoint(protozero::pbf_writer &parent,
+                   const protozero::pbf_tag_type field,
+                   const util::Coordinate location,
+                   const std::string &name,
+                   const Hint *hint)
+{
+    protozero::pbf_writer waypoint_writer{parent, field};
+    waypoint_writer.add_string(tag::WAYPOINT_NAME, name);
+    waypoint_writer.add_sint32(tag::WAYPOINT_LONGITUDE, static_cast<std::int32_t>(location.lon));
+    waypoint_writer.add_sint32(tag::WAYPOINT_LATITUDE, static_cast<std::int32_t>(location.lat));
+    if (hint)
+    {
+        char encoded[ENCODED_HINT_SIZE];
+        hint->ToBase64(encoded);
+        waypoint_writer.add_string(tag::WAYPOINT_HINT, encoded, ENCODED_HINT_SIZE);
+    }
+}
+
+void writeGeometry(protozero::pbf_writer &route_writer,
+                   const std::vector<util::Coordinate> &coordinates)
+{
+    protozero::packed_field_sint32 geometry{route_writer, tag::ROUTE_GEOMETRY};
+    std::int32_t previous_lon = 0;
+    std::int32_t previous_lat = 0;
+    for (const auto &coordinate : coordinates)
+    {
+        const auto lon = static_cast<std::int32_t>(coordinate.lon);
+        const auto lat = static_cast<std::int32_t>(coordinate.lat);
+        geometry.add_element(lon - previous_lon);
+        geometry.add_element(lat - previous_lat);
+        previous_lon = lon;
+        previous_lat = lat;
+    }
+}
+
+void writeRouteLeg(protozero::pbf_writer &route_writer, const guidance::RouteLeg &leg)
+{
+    protozero::pbf_writer leg_writer{route_writer, tag::ROUTE_LEGS};
+    leg_writer.add_double(tag::LEG_DISTANCE, std::round(leg.distance * 10) / 10.);
+    leg_writer.add_double(tag::LEG_DURATION, std::round(leg.duration * 10) / 10.);
+    leg_writer.add_string(tag::LEG_SUMMARY, leg.summary);
+}
+
+void writeRouteSummary(protozero::pbf_writer &route_writer, const guidance::Route &route)
+{
+    route_writer.add_double(tag::ROUTE_DISTANCE, std::round(route.distance * 10) / 10.);
+    route_writer.add_double(tag::ROUTE_DURATION, std::round(route.duration * 10) / 10.);
+}
+
+void writeDurations(protozero::pbf_writer &response_writer,
+                    const std::vector<EdgeWeight> &durations)
+{
+    protozero::packed_field_sint32 durations_field{response_writer, tag::RESPONSE_DURATIONS};
+    for (const auto duration : durations)
+    {
+        durations_field.add_element(duration == INVALID_EDGE_WEIGHT ? NO_DURATION : duration);
+    }
+}
+
+void writeDistances(protozero::pbf_writer &response_writer,
+                    const std::vector<EdgeDistance> &distances)
+{
+    protozero::packed_field_sint32 distances_field{response_writer, tag::RESPONSE_DISTANCES};
+    for (const auto distance : distances)
+    {
+        distances_field.add_element(distance == INVALID_EDGE_DISTANCE ? NO_DISTANCE : distance);
+    }
+}
+}
+}
+}
+}
@@ -8,27 +8,74 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <iterator>
-#include <stack>
+#include <limits>
 #include <utility>
+#include <vector>
 
 namespace osrm
 {
 namespace engine
 {
 
-// Normed to the thresholds table
-std::uint64_t fastPerpendicularDistance(const util::FloatCoordinate &projected_start,
-                                        const util::FloatCoordinate &projected_target,
-                                        const util::FloatCoordinate &projected)
+namespace
 {
-    util::FloatCoordinate projected_point_on_segment;
-    std::tie(std::ignore, projected_point_on_segment) =
-        util::coordinate_calculation::projectPointOnSegment(
-            projected_start, projected_target, projected);
-    auto squared_distance = util::coordinate_calculation::squaredEuclideanDistance(
-        projected, projected_point_on_segment);
-    return squared_distance;
+// The points of a range are all measured against the segment between its borders, so the slope
+// of the segment is computed once per range instead of for every point. The distances are
+// squared and in fixed coordinates, normed to the thresholds table.
+class SegmentDistance
+{
+  public:
+    SegmentDistance(const util::FloatCoordinate &projected_start,
+                    const util::FloatCoordinate &projected_target)
+        : start_lon(static_cast<double>(projected_start.lon)),
+          start_lat(static_cast<double>(projected_start.lat)),
+          slope_lon(static_cast<double>(projected_target.lon - projected_start.lon)),
+          slope_lat(static_cast<double>(projected_target.lat - projected_start.lat)),
+          target_lon(static_cast<double>(projected_target.lon)),
+          target_lat(static_cast<double>(projected_target.lat)),
+          squared_length(slope_lon * slope_lon + slope_lat * slope_lat),
+          is_degenerated(squared_length < std::numeric_limits<double>::epsilon())
+    {
+    }
+
+    // same as projecting the point with coordinate_calculation::projectPointOnSegment and
+    // measuring the squared euclidean distance of the fixed coordinates
+    std::uint64_t operator()(const util::FloatCoordinate &projected,
+                             const util::Coordinate &fixed_projected) const
+    {
+        double on_segment_lon = start_lon;
+        double on_segment_lat = start_lat;
+        if (!is_degenerated)
+        {
+            const double unnormed_ratio =
+                slope_lon * (static_cast<double>(projected.lon) - start_lon) +
+                slope_lat * (static_cast<double>(projected.lat) - start_lat);
+            const double ratio = std::min(1., std::max(0., unnormed_ratio / squared_length));
+            on_segment_lon = (1.0 - ratio) * start_lon + target_lon * ratio;
+            on_segment_lat = (1.0 - ratio) * start_lat + target_lat * ratio;
+        }
+
+        const std::uint64_t dx = static_cast<std::int32_t>(
+            static_cast<std::int32_t>(fixed_projected.lon) -
+            static_cast<std::int32_t>(on_segment_lon * COORDINATE_PRECISION));
+        const std::uint64_t dy = static_cast<std::int32_t>(
+            static_cast<std::int32_t>(fixed_projected.lat) -
+            static_cast<std::int32_t>(on_segment_lat * COORDINATE_PRECISION));
+        return dx * dx + dy * dy;
+    }
+
+  private:
+    const double start_lon;
+    const double start_lat;
+    const double slope_lon;
+    const double slope_lat;
+    const double target_lon;
+    const double target_lat;
+    const double squared_length;
+    const bool is_degenerated;
+};
 }
 
 std::vector<util::Coordinate> douglasPeucker(std::vector<util::Coordinate>::const_iterator begin,
@@ -44,69 +91,66 @@ std::vector<util::Coordinate> douglasPeucker(std::vector<util::Coordinate>::cons
         return {};
     }
 
-    std::vector<util::FloatCoordinate> projected_coordinates(size);
-    std::transform(begin, end, projected_coordinates.begin(), [](const util::Coordinate coord) {
-        return util::web_mercator::fromWGS84(coord);
-    });
+    // the buffers are reused by all simplifications of a thread
+    static thread_local std::vector<util::FloatCoordinate> projected_coordinates;
+    static thread_local std::vector<util::Coordinate> fixed_projected_coordinates;
+    static thread_local std::vector<char> is_necessary;
+    using GeometryRange = std::pair<std::size_t, std::size_t>;
+    static thread_local std::vector<GeometryRange> recursion_stack;
+
+    projected_coordinates.resize(size);
+    util::web_mercator::fromWGS84(begin, end, projected_coordinates.begin());
+    fixed_projected_coordinates.assign(projected_coordinates.begin(), projected_coordinates.end());
 
-    std::vector<bool> is_necessary(size, false);
+    is_necessary.assign(size, false);
     BOOST_ASSERT(is_necessary.size() >= 2);
     is_necessary.front() = true;
     is_necessary.back() = true;
-    using GeometryRange = std::pair<std::size_t, std::size_t>;
-
-    std::stack<GeometryRange> recursion_stack;
+    std::size_t simplified_size = 2;
 
-    recursion_stack.emplace(0UL, size - 1);
+    const auto threshold = detail::DOUGLAS_PEUCKER_THRESHOLDS[zoom_level];
+    recursion_stack.clear();
+    recursion_stack.emplace_back(0UL, size - 1);
 
     // mark locations as 'necessary' by divide-and-conquer
     while (!recursion_stack.empty())
     {
         // pop next element
-        const GeometryRange pair = recursion_stack.top();
-        recursion_stack.pop();
+        const GeometryRange pair = recursion_stack.back();
+        recursion_stack.pop_back();
         // sanity checks
         BOOST_ASSERT_MSG(is_necessary[pair.first], "left border must be necessary");
         BOOST_ASSERT_MSG(is_necessary[pair.second], "right border must be necessary");
         BOOST_ASSERT_MSG(pair.second < size, "right border outside of geometry");
         BOOST_ASSERT_MSG(pair.first <= pair.second, "left border on the wrong side");
 
-        std::uint64_t max_distance = 0;
+        std::uint64_t max_distance = threshold;
         auto farthest_entry_index = pair.second;
 
-        // sweep over range to find the maximum
-        for (auto idx = pair.first + 1; idx != pair.second; ++idx)
+        // sweep over range to find the maximum that violates the zoom level dependent threshold
+        const SegmentDistance segment_distance(projected_coordinates[pair.first],
+                                               projected_coordinates[pair.second]);
+        for (auto idx = pair.first + 1; idx < pair.second; ++idx)
         {
-            using namespace util::coordinate_calculation;
-            const auto distance = fastPerpendicularDistance(projected_coordinates[pair.first],
-                                                            projected_coordinates[pair.second],
-                                                            projected_coordinates[idx]);
-            // found new feasible maximum?
-            if (distance > max_distance &&
-                distance > detail::DOUGLAS_PEUCKER_THRESHOLDS[zoom_level])
+            const auto distance =
+                segment_distance(projected_coordinates[idx], fixed_projected_coordinates[idx]);
+            if (distance > max_distance)
             {
                 farthest_entry_index = idx;
                 max_distance = distance;
             }
         }
 
-        // check if maximum violates a zoom level dependent threshold
-        if (max_distance > detail::DOUGLAS_PEUCKER_THRESHOLDS[zoom_level])
+        if (farthest_entry_index != pair.second)
         {
             //  mark idx as necessary
             is_necessary[farthest_entry_index] = true;
-            if (pair.first < farthest_entry_index)
-            {
-                recursion_stack.emplace(pair.first, farthest_entry_index);
-            }
-            if (farthest_entry_index < pair.second)
-            {
-                recursion_stack.emplace(farthest_entry_index, pair.second);
-            }
+            ++simplified_size;
+            recursion_stack.emplace_back(pair.first, farthest_entry_index);
+            recursion_stack.emplace_back(farthest_entry_index, pair.second);
         }
     }
 
-    auto simplified_size = std::count(is_necessary.begin(), is_necessary.end(), true);
     std::vector<util::Coordinate> simplified_geometry;
     simplified_geometry.reserve(simplified_size);
     for (auto idx : util::irange<std::size_t>(0UL, size))
@@ -1,48 +1,359 @@
 #include "engine/engine.hpp"
 #include "engine/api/route_parameters.hpp"
+#include "engine/api/tile_parameters.hpp"
 #include "engine/engine_config.hpp"
+#include "engine/query_deadline.hpp"
+#include "engine/query_metrics.hpp"
+#include "engine/search_engine_data.hpp"
+#include "engine/search_statistics.hpp"
 #include "engine/status.hpp"
+#include "extractor/class_data.hpp"
 
 #include "engine/datafacade/internal_datafacade.hpp"
 #include "engine/datafacade/shared_datafacade.hpp"
 
 #include "storage/shared_barriers.hpp"
+#include "util/allocation_statistics.hpp"
+#include "util/integer_range.hpp"
+#include "util/numa.hpp"
+#include "util/probes.hpp"
 #include "util/simple_logger.hpp"
+#include "util/timing_util.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/interprocess/sync/named_condition.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
 #include <boost/interprocess/sync/sharable_lock.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <algorithm>
 #include <fstream>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace
 {
+// Requests excluding classes use the metric osrm-contract --exclude contracted without them
+std::string getMetric(const osrm::engine::api::BaseParameters &parameters)
+{
+    if (!parameters.exclude.empty())
+    {
+        return osrm::extractor::getExcludeMetricName(
+            osrm::extractor::getClasses(parameters.exclude));
+    }
+    return parameters.metric;
+}
+
+// tiles always show the default metric
+std::string getMetric(const osrm::engine::api::TileParameters &) { return {}; }
+
+// Builds with ENABLE_SEARCH_STATISTICS add the counts of the searches of a query to its JSON
+// response, the other formats are left as they are
+void addSearchStatistics(osrm::util::json::Object &result)
+{
+    const auto &statistics = osrm::engine::GetSearchStatistics();
+    osrm::util::json::Object json_statistics;
+    json_statistics.values["settled_nodes"] = static_cast<double>(statistics.settled_nodes);
+    json_statistics.values["relaxed_edges"] = static_cast<double>(statistics.relaxed_edges);
+    json_statistics.values["stalled_nodes"] = static_cast<double>(statistics.stalled_nodes);
+    json_statistics.values["heap_inserts"] = static_cast<double>(statistics.heap_inserts);
+    json_statistics.values["heap_decrease_keys"] =
+        static_cast<double>(statistics.heap_decrease_keys);
+    json_statistics.values["unpacked_edges"] = static_cast<double>(statistics.unpacked_edges);
+    result.values["statistics"] = std::move(json_statistics);
+}
+
+template <typename ResultT> void addSearchStatistics(ResultT &) {}
+
+// Queries that run past the deadline of their thread or are cancelled get an error response
+// instead of their partial results
+template <typename PluginT, typename FacadeT, typename ParameterT, typename ResultT>
+osrm::engine::Status handleRequest(PluginT &plugin,
+                                   const FacadeT &facade,
+                                   const ParameterT &parameters,
+                                   ResultT &result)
+{
+    // the searches of the query use a heap set of the pool, waiting for one if all are in use
+    osrm::engine::SearchEngineData::Lease heap_lease;
+    try
+    {
+        // the deadline might have passed while the query was queued or waited for the heaps
+        osrm::engine::GetQueryDeadline().CheckNow();
+        return plugin.HandleRequest(facade, parameters, result);
+    }
+    catch (const osrm::engine::QueryCancelled &cancelled)
+    {
+        result = ResultT();
+        return plugin.Error(cancelled.Code(), cancelled.what(), result);
+    }
+}
+
 // Abstracted away the query locking into a template function
 // Works the same for every plugin.
 template <typename ParameterT, typename PluginT, typename ResultT>
-osrm::engine::Status
-RunQuery(const std::unique_ptr<osrm::engine::DataWatchdog> &watchdog,
-         const std::shared_ptr<osrm::engine::datafacade::BaseDataFacade> &facade,
-         const ParameterT &parameters,
-         PluginT &plugin,
-         ResultT &result)
+osrm::engine::Status RunQuery(const osrm::engine::Engine &engine,
+                              const ParameterT &parameters,
+                              PluginT &plugin,
+                              ResultT &result,
+                              const osrm::engine::QueryType query_type)
 {
+    using osrm::engine::QueryMetrics;
+    using osrm::engine::QueryPhase;
+
+    TIMER_START(query);
+    const auto &dataset = engine.GetDataset(parameters.profile);
+    const auto &watchdog = dataset.watchdog;
+    const auto &facades = dataset.immutable_data_facades;
+    // the plugins attribute the allocations of other phases themselves
+    osrm::util::AllocationPhaseScope allocation_phase(osrm::util::AllocationPhase::Search);
+    osrm::engine::Status status;
+    const auto &metric = getMetric(parameters);
+    osrm::engine::GetSearchStatistics().Reset();
+    osrm::engine::GetQueryProfile().Reset();
+    OSRM_PROBE1(query__start, static_cast<int>(query_type));
     if (watchdog)
     {
-        BOOST_ASSERT(!facade);
-        auto lock_and_facade = watchdog->GetDataFacade();
+        BOOST_ASSERT(facades.empty());
+        // the facade keeps its dataset alive until the query finished
+        const auto current_facade = watchdog->GetDataFacade(metric);
+        if (!current_facade)
+        {
+            return plugin.Error("InvalidMetric", "The dataset has no metric " + metric, result);
+        }
 
-        return plugin.HandleRequest(lock_and_facade.second, parameters, result);
+        status = handleRequest(plugin, current_facade, parameters, result);
     }
+    else
+    {
+        BOOST_ASSERT(!facades.empty());
+        // additional metrics are only loaded into shared memory
+        if (!metric.empty())
+        {
+            return plugin.Error("InvalidMetric", "The dataset has no metric " + metric, result);
+        }
+        // with NUMA replicas use the copy of the node the query runs on
+        const auto &facade =
+            facades.size() > 1 ? facades[osrm::util::getCurrentNumaNode() % facades.size()]
+                               : facades.front();
+
+        status = handleRequest(plugin, facade, parameters, result);
+    }
+    TIMER_STOP(query);
+    QueryMetrics::GetInstance().Record(query_type, QueryPhase::Total, query_stop - query_start);
+    OSRM_PROBE2(query__done, static_cast<int>(query_type), static_cast<int>(status));
 
-    BOOST_ASSERT(facade);
+    if (osrm::engine::SEARCH_STATISTICS_ENABLED && status == osrm::engine::Status::Ok)
+    {
+        addSearchStatistics(result);
+    }
 
-    return plugin.HandleRequest(facade, parameters, result);
+    return status;
+}
+
+// Lets RunQuery pass the queries of a match session to the match plugin
+struct MatchSessionPlugin
+{
+    const osrm::engine::plugins::MatchPlugin &plugin;
+    osrm::engine::MatchSession &session;
+    const bool finish;
+
+    osrm::engine::Status
+    HandleRequest(const std::shared_ptr<osrm::engine::datafacade::BaseDataFacade> facade,
+                  const osrm::engine::api::MatchParameters &parameters,
+                  osrm::util::json::Object &result) const
+    {
+        return plugin.HandleRequest(facade, session, parameters, finish, result);
+    }
+
+    osrm::engine::Status Error(const std::string &code,
+                               const std::string &message,
+                               osrm::util::json::Object &result) const
+    {
+        return plugin.Error(code, message, result);
+    }
+};
+
+// Runs the queries of a batch in parallel on one snapshot of the datasets. The facade of every
+// metric is looked up once for the whole batch instead of once per query, and the thread local
+// heaps of the plugins are reused by all queries that run on the same thread.
+template <typename ParameterT, typename PluginT, typename CallbackT>
+void RunBatchQuery(const osrm::engine::Engine &engine,
+                   const std::vector<ParameterT> &parameters,
+                   PluginT &plugin,
+                   const CallbackT &callback,
+                   const osrm::engine::QueryType query_type)
+{
+    using osrm::engine::QueryMetrics;
+    using osrm::engine::QueryPhase;
+
+    // the facades keep their dataset alive until the batch finished, only the default dataset
+    // has a watchdog
+    std::unordered_map<std::string, std::shared_ptr<osrm::engine::datafacade::BaseDataFacade>>
+        metric_facades;
+    for (const auto &item : parameters)
+    {
+        const auto &watchdog = engine.GetDataset(item.profile).watchdog;
+        const auto &metric = getMetric(item);
+        if (watchdog && metric_facades.find(metric) == metric_facades.end())
+        {
+            metric_facades.emplace(metric, watchdog->GetDataFacade(metric));
+        }
+    }
+
+    // the queries of the batch share the deadline of the thread that runs it
+    const auto deadline = osrm::engine::GetQueryDeadline();
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, parameters.size(), 1),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            osrm::engine::QueryDeadlineScope deadline_scope(deadline);
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                TIMER_START(query);
+                OSRM_PROBE1(query__start, static_cast<int>(query_type));
+                const auto &item = parameters[index];
+                const auto &metric = getMetric(item);
+                const auto &dataset = engine.GetDataset(item.profile);
+                const auto &facades = dataset.immutable_data_facades;
+                osrm::util::json::Object result;
+                osrm::engine::Status status;
+                if (dataset.watchdog)
+                {
+                    const auto &current_facade = metric_facades.at(metric);
+                    status = current_facade ? handleRequest(plugin, current_facade, item, result)
+                                            : plugin.Error("InvalidMetric",
+                                                           "The dataset has no metric " + metric,
+                                                           result);
+                }
+                else if (!metric.empty())
+                {
+                    // additional metrics are only loaded into shared memory
+                    status = plugin.Error(
+                        "InvalidMetric", "The dataset has no metric " + metric, result);
+                }
+                else
+                {
+                    const auto &facade =
+                        facades.size() > 1
+                            ? facades[osrm::util::getCurrentNumaNode() % facades.size()]
+                            : facades.front();
+                    status = handleRequest(plugin, facade, item, result);
+                }
+                TIMER_STOP(query);
+                QueryMetrics::GetInstance().Record(
+                    query_type, QueryPhase::Total, query_stop - query_start);
+                OSRM_PROBE2(query__done, static_cast<int>(query_type), static_cast<int>(status));
+
+                callback(index, status, result);
+            }
+        });
+}
+
+// Loads a dataset from its container or its files, with a copy per NUMA node with replicas
+std::vector<std::shared_ptr<osrm::engine::datafacade::BaseDataFacade>>
+loadDataFacades(const osrm::engine::EngineConfig &config,
+                const osrm::storage::StorageConfig &storage_config)
+{
+    using namespace osrm::engine;
+    using osrm::util::irange;
+
+    std::vector<std::shared_ptr<datafacade::BaseDataFacade>> facades;
+    if (config.use_container)
+    {
+        const auto facade =
+            std::make_shared<datafacade::SharedDataFacade>(storage_config.container_path);
+        if (!config.numa_replicas)
+        {
+            facades.push_back(facade);
+        }
+        else
+        {
+            // copies the mapped container into memory local to each node
+            for (const auto node : irange<std::size_t>(0, osrm::util::getNumaNodes().size()))
+            {
+                osrm::util::runOnNumaNode(node, [&] {
+                    facades.push_back(datafacade::SharedDataFacade::Replicate(*facade));
+                });
+            }
+        }
+    }
+    else
+    {
+        if (!storage_config.IsValid())
+        {
+            throw osrm::util::exception("Invalid file paths given!");
+        }
+        const auto replicas = config.numa_replicas ? osrm::util::getNumaNodes().size() : 1;
+        for (const auto node : irange<std::size_t>(0, replicas))
+        {
+            // loading on a thread of the node places the dataset in its local memory
+            const auto load = [&] {
+                const auto facade =
+                    std::make_shared<datafacade::InternalDataFacade>(storage_config,
+                                                                     config.prefetch_rtree_leaves,
+                                                                     config.use_huge_pages,
+                                                                     config.lazy_blocks,
+                                                                     config.compress_coordinates,
+                                                                     config.weight_offsets,
+                                                                     config.compress_geometries);
+                if (config.algorithm == EngineConfig::Algorithm::MLD)
+                {
+                    facade->LoadMultiLevelGraph(storage_config.mld_graph_path);
+                }
+                facades.push_back(facade);
+            };
+            if (config.numa_replicas)
+            {
+                osrm::util::runOnNumaNode(node, load);
+            }
+            else
+            {
+                load();
+            }
+        }
+    }
+
+    for (const auto &facade : facades)
+    {
+        facade->EnableShortcutCache(config.shortcut_cache_size);
+        facade->EnableTileCache(config.tile_cache_size);
+        facade->EnablePhantomNodeCache(config.phantom_node_cache_size);
+        facade->EnableRouteCache(config.route_cache_size * 1024 * 1024);
+        facade->EnableSearchSpaceCache(config.search_space_cache_size);
+    }
+    return facades;
+}
+
+// Errors of the engine reach the callback of an asynchronous query like the errors of a plugin,
+// there is no caller they could be thrown to
+void setInternalError(osrm::util::json::Object &result, const std::string &message)
+{
+    result = osrm::util::json::Object();
+    result.values["code"] = "InternalError";
+    result.values["message"] = message;
+}
+
+void setInternalError(std::string &result, const std::string &) { result.clear(); }
+
+template <typename ResultT, typename QueryT, typename CallbackT>
+void runAsyncQuery(const QueryT &query, const CallbackT &callback)
+{
+    ResultT result;
+    osrm::engine::Status status;
+    try
+    {
+        status = query(result);
+    }
+    catch (const std::exception &error)
+    {
+        setInternalError(result, error.what());
+        status = osrm::engine::Status::Error;
+    }
+    callback(status, result);
 }
 
 } // anon. ns
@@ -55,14 +366,22 @@ namespace engine
 Engine::Engine(const EngineConfig &config)
     : lock(config.use_shared_memory ? std::make_unique<storage::SharedBarriers>()
                                     : std::unique_ptr<storage::SharedBarriers>()),
-      route_plugin(config.max_locations_viaroute),       //
-      table_plugin(config.max_locations_distance_table), //
-      nearest_plugin(config.max_results_nearest),        //
-      trip_plugin(config.max_locations_trip),            //
-      match_plugin(config.max_locations_map_matching),   //
-      tile_plugin()                                      //
-
+      route_plugin(config.max_locations_viaroute, config.parallel_search_distance), //
+      table_plugin(config.max_locations_distance_table, config.max_target_sets),    //
+      nearest_plugin(config.max_results_nearest),                                   //
+      trip_plugin(config.max_locations_trip, config.trip_improvement_time),         //
+      match_plugin(config.max_locations_map_matching, config.matching_beam_width),  //
+      tile_plugin(),                                                                //
+      isochrone_plugin(config.max_isochrone_duration),                              //
+      async_arena(config.async_threads > 0 ? static_cast<int>(config.async_threads)
+                                           : tbb::task_arena::automatic,
+                  0)
 {
+    if (config.max_heap_sets > 0)
+    {
+        SearchEngineData::SetMaxHeapSets(config.max_heap_sets);
+    }
+
     if (config.use_shared_memory)
     {
         if (!DataWatchdog::TryConnect())
@@ -71,48 +390,242 @@ Engine::Engine(const EngineConfig &config)
                 "No shared memory blocks found, have you forgotten to run osrm-datastore?");
         }
 
-        watchdog = std::make_unique<DataWatchdog>();
-        BOOST_ASSERT(watchdog);
+        default_dataset.watchdog =
+            std::make_unique<DataWatchdog>(config.numa_replicas,
+                                           config.shortcut_cache_size,
+                                           config.tile_cache_size,
+                                           config.phantom_node_cache_size,
+                                           config.route_cache_size * 1024 * 1024,
+                                           config.search_space_cache_size);
+        BOOST_ASSERT(default_dataset.watchdog);
     }
     else
     {
-        if (!config.storage_config.IsValid())
+        default_dataset.immutable_data_facades = loadDataFacades(config, config.storage_config);
+    }
+
+    for (const auto &profile : config.profiles)
+    {
+        util::SimpleLogger().Write() << "loading the dataset of the profile " << profile.first;
+        profile_datasets[profile.first].immutable_data_facades =
+            loadDataFacades(config, profile.second);
+    }
+}
+
+Engine::~Engine()
+{
+    std::unique_lock<std::mutex> pending_lock(async_mutex);
+    async_finished.wait(pending_lock, [this] { return async_pending == 0; });
+}
+
+void Engine::WarmUpThread() const
+{
+    unsigned number_of_nodes = 0;
+    unsigned number_of_multi_level_nodes = 0;
+    const auto add_facade = [&](const std::shared_ptr<datafacade::BaseDataFacade> &facade) {
+        number_of_nodes = std::max(number_of_nodes, facade->GetNumberOfNodes());
+        if (const auto graph = facade->GetMultiLevelGraph())
+        {
+            number_of_multi_level_nodes =
+                std::max<unsigned>(number_of_multi_level_nodes, graph->GetNumberOfNodes());
+        }
+    };
+    const auto add_dataset = [&](const Dataset &dataset) {
+        if (dataset.watchdog)
+        {
+            add_facade(dataset.watchdog->GetDataFacade());
+        }
+        for (const auto &facade : dataset.immutable_data_facades)
+        {
+            add_facade(facade);
+        }
+    };
+    add_dataset(default_dataset);
+    for (const auto &profile_dataset : profile_datasets)
+    {
+        add_dataset(profile_dataset.second);
+    }
+
+    // the heaps of a set are shared by the searches of all plugins, the warm set goes back to the
+    // pool for the next query
+    SearchEngineData::Lease heap_lease;
+    SearchEngineData heaps;
+    heaps.InitializeOrClearFirstThreadLocalStorage(number_of_nodes);
+    heaps.InitializeOrClearSecondThreadLocalStorage(number_of_nodes);
+    heaps.InitializeOrClearThirdThreadLocalStorage(number_of_nodes);
+    heaps.InitializeOrClearManyToManyThreadLocalStorage(number_of_nodes);
+    heaps.InitializeMapMatchingThreadLocalStorage();
+    if (number_of_multi_level_nodes > 0)
+    {
+        heaps.InitializeOrClearMultiLevelThreadLocalStorage(number_of_multi_level_nodes);
+    }
+}
+
+const Engine::Dataset &Engine::GetDataset(const std::string &profile) const
+{
+    if (!profile_datasets.empty())
+    {
+        const auto iter = profile_datasets.find(profile);
+        if (iter != profile_datasets.end())
         {
-            throw util::exception("Invalid file paths given!");
+            return iter->second;
         }
-        immutable_data_facade =
-            std::make_shared<datafacade::InternalDataFacade>(config.storage_config);
     }
+    return default_dataset;
 }
 
 Status Engine::Route(const api::RouteParameters &params, util::json::Object &result) const
 {
-    return RunQuery(watchdog, immutable_data_facade, params, route_plugin, result);
+    return RunQuery(*this, params, route_plugin, result, QueryType::Route);
+}
+
+Status Engine::Route(const api::RouteParameters &params, std::string &result) const
+{
+    return RunQuery(*this, params, route_plugin, result, QueryType::Route);
+}
+
+void Engine::Route(const std::vector<api::RouteParameters> &params,
+                   const BatchCallback &callback) const
+{
+    RunBatchQuery(*this, params, route_plugin, callback, QueryType::Route);
 }
 
 Status Engine::Table(const api::TableParameters &params, util::json::Object &result) const
 {
-    return RunQuery(watchdog, immutable_data_facade, params, table_plugin, result);
+    return RunQuery(*this, params, table_plugin, result, QueryType::Table);
+}
+
+Status Engine::Table(const api::TableParameters &params, util::json::Writer &result) const
+{
+    return RunQuery(*this, params, table_plugin, result, QueryType::Table);
+}
+
+Status Engine::Table(const api::TableParameters &params, std::string &result) const
+{
+    return RunQuery(*this, params, table_plugin, result, QueryType::Table);
+}
+
+void Engine::Table(const std::vector<api::TableParameters> &params,
+                   const BatchCallback &callback) const
+{
+    RunBatchQuery(*this, params, table_plugin, callback, QueryType::Table);
 }
 
 Status Engine::Nearest(const api::NearestParameters &params, util::json::Object &result) const
 {
-    return RunQuery(watchdog, immutable_data_facade, params, nearest_plugin, result);
+    return RunQuery(*this, params, nearest_plugin, result, QueryType::Nearest);
 }
 
 Status Engine::Trip(const api::TripParameters &params, util::json::Object &result) const
 {
-    return RunQuery(watchdog, immutable_data_facade, params, trip_plugin, result);
+    return RunQuery(*this, params, trip_plugin, result, QueryType::Trip);
 }
 
 Status Engine::Match(const api::MatchParameters &params, util::json::Object &result) const
 {
-    return RunQuery(watchdog, immutable_data_facade, params, match_plugin, result);
+    return RunQuery(*this, params, match_plugin, result, QueryType::Match);
+}
+
+Status Engine::Match(MatchSession &session,
+                     const api::MatchParameters &params,
+                     util::json::Object &result) const
+{
+    MatchSessionPlugin plugin{match_plugin, session, false};
+    return RunQuery(*this, params, plugin, result, QueryType::Match);
+}
+
+Status Engine::FinishMatch(MatchSession &session,
+                           const api::MatchParameters &params,
+                           util::json::Object &result) const
+{
+    MatchSessionPlugin plugin{match_plugin, session, true};
+    return RunQuery(*this, params, plugin, result, QueryType::Match);
 }
 
 Status Engine::Tile(const api::TileParameters &params, std::string &result) const
 {
-    return RunQuery(watchdog, immutable_data_facade, params, tile_plugin, result);
+    return RunQuery(*this, params, tile_plugin, result, QueryType::Tile);
+}
+
+Status Engine::Isochrone(const api::IsochroneParameters &params, util::json::Object &result) const
+{
+    return RunQuery(*this, params, isochrone_plugin, result, QueryType::Isochrone);
+}
+
+void Engine::RunAsync(std::function<void()> task) const
+{
+    {
+        std::lock_guard<std::mutex> pending_lock(async_mutex);
+        ++async_pending;
+    }
+    // the query keeps the deadline of the thread that started it
+    async_arena.enqueue([ this, task = std::move(task), deadline = GetQueryDeadline() ] {
+        {
+            QueryDeadlineScope deadline_scope(deadline);
+            task();
+        }
+        std::lock_guard<std::mutex> pending_lock(async_mutex);
+        if (--async_pending == 0)
+        {
+            async_finished.notify_all();
+        }
+    });
+}
+
+void Engine::Route(const api::RouteParameters &params, AsyncCallback callback) const
+{
+    RunAsync([this, params, callback = std::move(callback)] {
+        runAsyncQuery<util::json::Object>(
+            [&](util::json::Object &result) { return Route(params, result); }, callback);
+    });
+}
+
+void Engine::Table(const api::TableParameters &params, AsyncCallback callback) const
+{
+    RunAsync([this, params, callback = std::move(callback)] {
+        runAsyncQuery<util::json::Object>(
+            [&](util::json::Object &result) { return Table(params, result); }, callback);
+    });
+}
+
+void Engine::Nearest(const api::NearestParameters &params, AsyncCallback callback) const
+{
+    RunAsync([this, params, callback = std::move(callback)] {
+        runAsyncQuery<util::json::Object>(
+            [&](util::json::Object &result) { return Nearest(params, result); }, callback);
+    });
+}
+
+void Engine::Trip(const api::TripParameters &params, AsyncCallback callback) const
+{
+    RunAsync([this, params, callback = std::move(callback)] {
+        runAsyncQuery<util::json::Object>(
+            [&](util::json::Object &result) { return Trip(params, result); }, callback);
+    });
+}
+
+void Engine::Match(const api::MatchParameters &params, AsyncCallback callback) const
+{
+    RunAsync([this, params, callback = std::move(callback)] {
+        runAsyncQuery<util::json::Object>(
+            [&](util::json::Object &result) { return Match(params, result); }, callback);
+    });
+}
+
+void Engine::Tile(const api::TileParameters &params, AsyncTileCallback callback) const
+{
+    RunAsync([this, params, callback = std::move(callback)] {
+        runAsyncQuery<std::string>([&](std::string &result) { return Tile(params, result); },
+                                   callback);
+    });
+}
+
+void Engine::Isochrone(const api::IsochroneParameters &params, AsyncCallback callback) const
+{
+    RunAsync([this, params, callback = std::move(callback)] {
+        runAsyncQuery<util::json::Object>(
+            [&](util::json::Object &result) { return Isochrone(params, result); }, callback);
+    });
 }
 
 } // engine ns
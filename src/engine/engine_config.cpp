@@ -1,5 +1,9 @@
 #include "engine/engine_config.hpp"
 
+#include <boost/filesystem/operations.hpp>
+
+#include <algorithm>
+
 namespace osrm
 {
 namespace engine
@@ -23,9 +27,29 @@ bool EngineConfig::IsValid() const
                               unlimited_or_more_than(max_locations_map_matching, 2) &&
                               unlimited_or_more_than(max_locations_trip, 2) &&
                               unlimited_or_more_than(max_locations_viaroute, 2) &&
-                              unlimited_or_more_than(max_results_nearest, 0);
+                              unlimited_or_more_than(max_results_nearest, 0) &&
+                              unlimited_or_more_than(max_isochrone_duration, 0) &&
+                              unlimited_or_more_than(matching_beam_width, 0) &&
+                              trip_improvement_time >= 0 && parallel_search_distance >= 0;
+
+    const bool container_valid =
+        use_container && boost::filesystem::is_regular_file(storage_config.container_path);
+
+    const bool profiles_valid =
+        std::all_of(profiles.begin(), profiles.end(), [this](const auto &profile) {
+            return !profile.first.empty() &&
+                   (use_container
+                        ? boost::filesystem::is_regular_file(profile.second.container_path)
+                        : profile.second.IsValid());
+        });
+
+    // the overlay graph is not part of shared memory or containers
+    const bool algorithm_valid =
+        algorithm == Algorithm::CH || (!use_shared_memory && !use_container);
 
-    return ((use_shared_memory && all_path_are_empty) || storage_config.IsValid()) && limits_valid;
+    return ((use_shared_memory && all_path_are_empty) || container_valid ||
+            storage_config.IsValid()) &&
+           limits_valid && profiles_valid && algorithm_valid;
 }
 }
 }
@@ -168,7 +168,7 @@ std::vector<RouteStep> anticipateLaneChange(std::vector<RouteStep> steps,
             // step as invalid, scheduled for later removal.
             if (collapsable(previous, current))
             {
-                previous = elongate(previous, current);
+                previous = elongate(std::move(previous), current);
                 current.maneuver.instruction = TurnInstruction::NO_TURN();
             }
         });
@@ -20,6 +20,7 @@
 #include <cmath>
 #include <cstddef>
 #include <limits>
+#include <string>
 #include <utility>
 
 using TurnInstruction = osrm::extractor::guidance::TurnInstruction;
@@ -57,7 +58,6 @@ inline void forwardStepSignage(RouteStep &destination, const RouteStep &origin)
     destination.name = origin.name;
     destination.pronunciation = origin.pronunciation;
     destination.destinations = origin.destinations;
-    destination.destinations = origin.destinations;
     destination.ref = origin.ref;
 }
 
@@ -127,6 +127,10 @@ double turn_angle(const double entry_bearing, const double exit_bearing)
 // Treats e.g. "Name (Ref)" -> "Name" changes still as same name.
 bool isNoticeableNameChange(const RouteStep &lhs, const RouteStep &rhs)
 {
+    // steps on the same name id share their names, no need to compare them
+    if (lhs.name_id == rhs.name_id)
+        return false;
+
     // TODO: rotary_name is not handled at the moment.
     return util::guidance::requiresNameAnnounced(
         lhs.name, lhs.ref, lhs.pronunciation, rhs.name, rhs.ref, rhs.pronunciation);
@@ -270,7 +274,7 @@ void closeOffRoundabout(const bool on_roundabout,
                      steps[1].maneuver.instruction.type == TurnType::UseLane);
         steps[0].geometry_end = 1;
         steps[1].geometry_begin = 0;
-        steps[1] = forwardInto(steps[1], steps[0]);
+        steps[1] = forwardInto(std::move(steps[1]), steps[0]);
         steps[1].intersections.erase(steps[1].intersections.begin()); // otherwise we copy the
                                                                       // source
         if (leavesRoundabout(steps[1].maneuver.instruction))
@@ -302,20 +306,24 @@ void closeOffRoundabout(const bool on_roundabout,
     BOOST_ASSERT(!steps[step_index].intersections.empty());
     // the very first intersection in the steps represents the location of the turn. Following
     // intersections are locations passed along the way
-    const auto exit_intersection = steps[step_index].intersections.front();
+    const auto &exit_intersection = steps[step_index].intersections.front();
     const auto exit_bearing = exit_intersection.bearings[exit_intersection.out];
-    const auto destination_copy = step;
     if (step_index > 1)
     {
+        // the exit step is invalidated below, only its signage is kept for the entry
+        RouteStep exit_signage;
+        forwardStepSignage(exit_signage, step);
+
         // The very first route-step is head, so we cannot iterate past that one
         for (std::size_t propagation_index = step_index - 1; propagation_index > 0;
              --propagation_index)
         {
             auto &propagation_step = steps[propagation_index];
-            propagation_step = forwardInto(propagation_step, steps[propagation_index + 1]);
+            propagation_step =
+                forwardInto(std::move(propagation_step), steps[propagation_index + 1]);
             if (entersRoundabout(propagation_step.maneuver.instruction))
             {
-                const auto entry_intersection = propagation_step.intersections.front();
+                const auto &entry_intersection = propagation_step.intersections.front();
 
                 // remember rotary name
                 if (propagation_step.maneuver.instruction.type == TurnType::EnterRotary ||
@@ -335,12 +343,11 @@ void closeOffRoundabout(const bool on_roundabout,
                                        entry_intersection.bearings[entry_intersection.in]),
                                    exit_bearing);
 
-                    auto bearings = propagation_step.intersections.front().bearings;
                     propagation_step.maneuver.instruction.direction_modifier =
                         util::guidance::getTurnDirection(angle);
                 }
 
-                forwardStepSignage(propagation_step, destination_copy);
+                forwardStepSignage(propagation_step, exit_signage);
                 invalidateStep(steps[propagation_index + 1]);
                 break;
             }
@@ -386,12 +393,12 @@ bool isUTurn(const RouteStep &in_step, const RouteStep &out_step, const RouteSte
 
 double findTotalTurnAngle(const RouteStep &entry_step, const RouteStep &exit_step)
 {
-    const auto exit_intersection = exit_step.intersections.front();
+    const auto &exit_intersection = exit_step.intersections.front();
     const auto exit_step_exit_bearing = exit_intersection.bearings[exit_intersection.out];
     const auto exit_step_entry_bearing =
         util::bearing::reverseBearing(exit_intersection.bearings[exit_intersection.in]);
 
-    const auto entry_intersection = entry_step.intersections.front();
+    const auto &entry_intersection = entry_step.intersections.front();
     const auto entry_step_entry_bearing =
         util::bearing::reverseBearing(entry_intersection.bearings[entry_intersection.in]);
     const auto entry_step_exit_bearing = entry_intersection.bearings[entry_intersection.out];
@@ -1307,9 +1314,9 @@ void trimShortSegments(std::vector<RouteStep> &steps, LegGeometry &geometry)
     // To catch these cases correctly, we have to perform trimming prior to the post-processing
 
     BOOST_ASSERT(geometry.locations.size() >= steps.size());
-    // Look for distances under 1m
+    // Look for distances under 1m, the equirectangular approximation is exact enough for that
     const bool zero_length_step = steps.front().distance <= 1 && steps.size() > 2;
-    const bool duplicated_coordinate = util::coordinate_calculation::haversineDistance(
+    const bool duplicated_coordinate = util::coordinate_calculation::greatCircleDistance(
                                            geometry.locations[0], geometry.locations[1]) <= 1;
     if (zero_length_step || duplicated_coordinate)
     {
@@ -1323,10 +1330,17 @@ void trimShortSegments(std::vector<RouteStep> &steps, LegGeometry &geometry)
             // fixup the coordinates/annotations/ids
             geometry.locations.erase(geometry.locations.begin(),
                                      geometry.locations.begin() + offset);
-            geometry.annotations.erase(geometry.annotations.begin(),
-                                       geometry.annotations.begin() + offset);
-            geometry.osm_node_ids.erase(geometry.osm_node_ids.begin(),
-                                        geometry.osm_node_ids.begin() + offset);
+            // the annotations and the ids are only assembled if they were requested
+            if (!geometry.annotations.empty())
+            {
+                geometry.annotations.erase(geometry.annotations.begin(),
+                                           geometry.annotations.begin() + offset);
+            }
+            if (!geometry.osm_node_ids.empty())
+            {
+                geometry.osm_node_ids.erase(geometry.osm_node_ids.begin(),
+                                            geometry.osm_node_ids.begin() + offset);
+            }
         }
 
         // We have to adjust the first step both for its name and the bearings
@@ -1418,8 +1432,14 @@ void trimShortSegments(std::vector<RouteStep> &steps, LegGeometry &geometry)
         geometry.segment_offsets.pop_back();
         // remove all the last coordinates from the geometry
         geometry.locations.resize(geometry.segment_offsets.back() + 1);
-        geometry.annotations.resize(geometry.segment_offsets.back() + 1);
-        geometry.osm_node_ids.resize(geometry.segment_offsets.back() + 1);
+        if (!geometry.annotations.empty())
+        {
+            geometry.annotations.resize(geometry.segment_offsets.back() + 1);
+        }
+        if (!geometry.osm_node_ids.empty())
+        {
+            geometry.osm_node_ids.resize(geometry.segment_offsets.back() + 1);
+        }
 
         BOOST_ASSERT(geometry.segment_distances.back() <= 1);
         geometry.segment_distances.pop_back();
@@ -1448,14 +1468,17 @@ void trimShortSegments(std::vector<RouteStep> &steps, LegGeometry &geometry)
         next_to_last_step.mode = new_next_to_last.mode;
         // the geometry indices of the last step are already correct;
     }
-    else if (util::coordinate_calculation::haversineDistance(
+    else if (util::coordinate_calculation::greatCircleDistance(
                  geometry.locations[geometry.locations.size() - 2],
                  geometry.locations[geometry.locations.size() - 1]) <= 1)
     {
         // correct steps but duplicated coordinate in the end.
         // This can happen if the last coordinate snaps to a node in the unpacked geometry
         geometry.locations.pop_back();
-        geometry.annotations.pop_back();
+        if (!geometry.annotations.empty())
+        {
+            geometry.annotations.pop_back();
+        }
         geometry.segment_offsets.back()--;
         // since the last geometry includes the location of arrival, the arrival instruction
         // geometry overlaps with the previous segment
@@ -1500,7 +1523,8 @@ std::vector<RouteStep> assignRelativeLocations(std::vector<RouteStep> steps,
     BOOST_ASSERT(steps.size() >= 2);
     BOOST_ASSERT(leg_geometry.locations.size() >= 2);
     const constexpr double MINIMAL_RELATIVE_DISTANCE = 5., MAXIMAL_RELATIVE_DISTANCE = 300.;
-    const auto distance_to_start = util::coordinate_calculation::haversineDistance(
+    // these short distances are only compared against the range, no need for haversine precision
+    const auto distance_to_start = util::coordinate_calculation::greatCircleDistance(
         source_node.input_location, leg_geometry.locations[0]);
     const auto initial_modifier =
         distance_to_start >= MINIMAL_RELATIVE_DISTANCE &&
@@ -1511,7 +1535,7 @@ std::vector<RouteStep> assignRelativeLocations(std::vector<RouteStep> steps,
 
     steps.front().maneuver.instruction.direction_modifier = initial_modifier;
 
-    const auto distance_from_end = util::coordinate_calculation::haversineDistance(
+    const auto distance_from_end = util::coordinate_calculation::greatCircleDistance(
         target_node.input_location, leg_geometry.locations.back());
     const auto final_modifier =
         distance_from_end >= MINIMAL_RELATIVE_DISTANCE &&
@@ -4,8 +4,6 @@
 
 #include <boost/assert.hpp>
 
-#include <algorithm>
-#include <iterator>
 #include <ostream>
 #include <tuple>
 
@@ -25,27 +23,29 @@ bool Hint::IsValid(const util::Coordinate new_input_coordinates,
 
 std::string Hint::ToBase64() const
 {
-    auto base64 = encodeBase64Bytewise(*this);
-
-    // Make safe for usage as GET parameter in URLs
-    std::replace(begin(base64), end(base64), '+', '-');
-    std::replace(begin(base64), end(base64), '/', '_');
+    // Safe for usage as GET parameter in URLs
+    return encodeBase64Bytewise(*this, Base64Alphabet::URLSafe);
+}
 
-    return base64;
+void Hint::ToBase64(char *base64Hint) const
+{
+    encodeBase64(reinterpret_cast<const unsigned char *>(this),
+                 sizeof(Hint),
+                 base64Hint,
+                 Base64Alphabet::URLSafe);
 }
 
 Hint Hint::FromBase64(const std::string &base64Hint)
 {
     BOOST_ASSERT_MSG(base64Hint.size() == ENCODED_HINT_SIZE, "Hint has invalid size");
 
-    // We need mutability but don't want to change the API
-    auto encoded = base64Hint;
-
-    // Reverses above encoding we need for GET parameters in URL
-    std::replace(begin(encoded), end(encoded), '-', '+');
-    std::replace(begin(encoded), end(encoded), '_', '/');
+    // the decoder takes the URL safe characters of the above encoding as they are
+    return decodeBase64Bytewise<Hint>(base64Hint);
+}
 
-    return decodeBase64Bytewise<Hint>(encoded);
+Hint Hint::FromBase64(const char *base64Hint)
+{
+    return decodeBase64Bytewise<Hint>(base64Hint, base64Hint + ENCODED_HINT_SIZE);
 }
 
 bool operator==(const Hint &lhs, const Hint &rhs)
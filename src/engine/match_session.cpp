@@ -0,0 +1,19 @@
+#include "engine/match_session.hpp"
+#include "engine/map_matching/matching_state.hpp"
+
+namespace osrm
+{
+namespace engine
+{
+
+MatchSession::MatchSession() : state(std::make_unique<map_matching::MatchingState>()) {}
+MatchSession::~MatchSession() = default;
+
+MatchSession::MatchSession(MatchSession &&) noexcept = default;
+MatchSession &MatchSession::operator=(MatchSession &&) noexcept = default;
+
+std::size_t MatchSession::NumberOfCoordinates() const { return state->NumberOfPoints(); }
+
+std::size_t MatchSession::NumberOfTracepoints() const { return state->tracepoints_end; }
+}
+}
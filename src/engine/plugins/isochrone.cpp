@@ -0,0 +1,200 @@
+#include "engine/plugins/isochrone.hpp"
+
+#include "engine/api/isochrone_api.hpp"
+#include "engine/api/isochrone_parameters.hpp"
+#include "engine/routing_algorithms/isochrone.hpp"
+#include "util/coordinate_calculation.hpp"
+
+#include <chrono>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+namespace osrm
+{
+namespace engine
+{
+namespace plugins
+{
+
+namespace
+{
+// Fractions of a segment reachable within the maximum weight, given the weight of the start of
+// the segment and of traversing it. Parts of the segment of the phantom node behind it start
+// at a negative weight and are not reachable.
+bool reachableFractions(const EdgeWeight start_weight,
+                        const EdgeWeight segment_weight,
+                        const EdgeWeight max_weight,
+                        std::pair<double, double> &fractions)
+{
+    if (start_weight == INVALID_EDGE_WEIGHT || segment_weight == INVALID_EDGE_WEIGHT ||
+        start_weight > max_weight || start_weight + segment_weight < 0)
+    {
+        return false;
+    }
+    if (segment_weight == 0)
+    {
+        fractions = {0., 1.};
+        return start_weight >= 0;
+    }
+
+    fractions.first = std::max(0., -static_cast<double>(start_weight) / segment_weight);
+    fractions.second =
+        std::min(1., static_cast<double>(max_weight - start_weight) / segment_weight);
+    return fractions.first < fractions.second;
+}
+
+// Corners of a box around the coordinate that holds all points closer than the radius
+std::pair<util::Coordinate, util::Coordinate> boundingBox(const util::Coordinate coordinate,
+                                                          const double radius)
+{
+    using namespace util::coordinate_calculation::detail;
+
+    const double lat = static_cast<double>(util::toFloating(coordinate.lat));
+    const double lon = static_cast<double>(util::toFloating(coordinate.lon));
+    const double lat_delta = static_cast<double>(radius / EARTH_RADIUS * RAD_TO_DEGREE);
+    const double lon_delta =
+        lat_delta / std::max(0.01, std::cos(static_cast<double>(lat * DEGREE_TO_RAD)));
+
+    return {util::Coordinate{util::FloatLongitude{std::max(-180., lon - lon_delta)},
+                             util::FloatLatitude{std::max(-90., lat - lat_delta)}},
+            util::Coordinate{util::FloatLongitude{std::min(180., lon + lon_delta)},
+                             util::FloatLatitude{std::min(90., lat + lat_delta)}}};
+}
+}
+
+IsochronePlugin::IsochronePlugin(const int max_isochrone_duration)
+    : isochrone(heaps), max_isochrone_duration(max_isochrone_duration)
+{
+}
+
+Status IsochronePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
+                                      const api::IsochroneParameters &params,
+                                      util::json::Object &result) const
+{
+    BOOST_ASSERT(params.IsValid());
+
+    if (!CheckAllCoordinates(params.coordinates))
+        return Error("InvalidOptions", "Coordinates are invalid", result);
+
+    if (max_isochrone_duration > 0 &&
+        params.duration > static_cast<unsigned>(max_isochrone_duration))
+    {
+        return Error("TooBig",
+                     "Duration " + std::to_string(params.duration) +
+                         " is higher than current maximum (" +
+                         std::to_string(max_isochrone_duration) + ")",
+                     result);
+    }
+
+    auto phase_start = std::chrono::steady_clock::now();
+    const auto phantom_node_pairs = GetPhantomNodes(*facade, params);
+    if (phantom_node_pairs.size() != 1)
+    {
+        return Error("NoSegment", "Could not find a matching segment for coordinate", result);
+    }
+    const auto phantom_node = SnapPhantomNodes(phantom_node_pairs).front();
+
+    // nothing beyond the distance covered at the maximum speed of the profile is reachable
+    const auto radius = params.duration * facade->GetMapMatchingMaxSpeed();
+    const auto box = boundingBox(phantom_node.location, radius);
+    const auto edges = facade->GetEdgesInBox(box.first, box.second);
+    phase_start = RecordPhase(QueryType::Isochrone, QueryPhase::PhantomLookup, phase_start);
+
+    std::vector<NodeID> targets;
+    targets.reserve(2 * edges.size());
+    for (const auto &edge : edges)
+    {
+        if (edge.forward_segment_id.enabled)
+            targets.push_back(edge.forward_segment_id.id);
+        if (edge.reverse_segment_id.enabled)
+            targets.push_back(edge.reverse_segment_id.id);
+    }
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+
+    // weights are in deciseconds
+    const EdgeWeight max_weight = params.duration * 10;
+    const auto weights = isochrone(*facade, phantom_node, targets, max_weight);
+    const auto weight_of = [&](const SegmentID segment_id) {
+        if (!segment_id.enabled)
+            return INVALID_EDGE_WEIGHT;
+        const auto target = std::lower_bound(targets.begin(), targets.end(), segment_id.id);
+        BOOST_ASSERT(target != targets.end() && *target == segment_id.id);
+        return weights[target - targets.begin()];
+    };
+    phase_start = RecordPhase(QueryType::Isochrone, QueryPhase::Search, phase_start);
+
+    std::vector<api::IsochroneAPI::Segment> segments;
+    for (const auto &edge : edges)
+    {
+        const auto forward_weights = facade->GetUncompressedForwardWeights(edge.packed_geometry_id);
+        const auto reverse_weights = facade->GetUncompressedReverseWeights(edge.packed_geometry_id);
+        const auto forward_position = edge.fwd_segment_position;
+        const auto reverse_position = reverse_weights.size() - forward_position - 1;
+
+        // the fractions of both directions are measured from u towards v
+        std::vector<std::pair<double, double>> reachable;
+        std::pair<double, double> fractions;
+
+        const auto forward_weight = weight_of(edge.forward_segment_id);
+        if (forward_weight != INVALID_EDGE_WEIGHT)
+        {
+            EdgeWeight offset = 0;
+            for (std::size_t i = 0; i < forward_position; ++i)
+                offset += forward_weights[i];
+            if (reachableFractions(forward_weight + offset,
+                                   forward_weights[forward_position],
+                                   max_weight,
+                                   fractions))
+            {
+                reachable.push_back(fractions);
+            }
+        }
+
+        const auto reverse_weight = weight_of(edge.reverse_segment_id);
+        if (reverse_weight != INVALID_EDGE_WEIGHT)
+        {
+            EdgeWeight offset = 0;
+            for (std::size_t i = 0; i < reverse_position; ++i)
+                offset += reverse_weights[i];
+            if (reachableFractions(reverse_weight + offset,
+                                   reverse_weights[reverse_position],
+                                   max_weight,
+                                   fractions))
+            {
+                reachable.push_back({1. - fractions.second, 1. - fractions.first});
+            }
+        }
+
+        if (reachable.size() == 2 && reachable[0].second >= reachable[1].first &&
+            reachable[1].second >= reachable[0].first)
+        {
+            reachable = {{std::min(reachable[0].first, reachable[1].first),
+                          std::max(reachable[0].second, reachable[1].second)}};
+        }
+
+        const auto from = facade->GetCoordinateOfNode(edge.u);
+        const auto to = facade->GetCoordinateOfNode(edge.v);
+        for (const auto &part : reachable)
+        {
+            segments.emplace_back(
+                util::coordinate_calculation::interpolateLinear(part.first, from, to),
+                util::coordinate_calculation::interpolateLinear(part.second, from, to));
+        }
+    }
+
+    api::IsochroneAPI isochrone_api(*facade, params);
+    isochrone_api.MakeResponse(phantom_node, segments, result);
+    RecordPhase(QueryType::Isochrone, QueryPhase::Assembly, phase_start);
+
+    return Status::Ok;
+}
+}
+}
+}
@@ -4,7 +4,9 @@
 #include "engine/api/match_api.hpp"
 #include "engine/api/match_parameters.hpp"
 #include "engine/map_matching/bayes_classifier.hpp"
+#include "engine/map_matching/matching_state.hpp"
 #include "engine/map_matching/sub_matching.hpp"
+#include "engine/query_deadline.hpp"
 #include "util/coordinate_calculation.hpp"
 #include "util/integer_range.hpp"
 #include "util/json_util.hpp"
@@ -13,6 +15,7 @@
 #include <cstdlib>
 
 #include <algorithm>
+#include <chrono>
 #include <functional>
 #include <iterator>
 #include <memory>
@@ -108,6 +111,39 @@ void filterCandidates(const std::vector<util::Coordinate> &coordinates,
     }
 }
 
+// assuming radius is the standard deviation of a normal distribution
+// that models GPS noise (in this model), x3 should give us the correct
+// search radius with > 99% confidence
+std::vector<double> getSearchRadiuses(const api::MatchParameters &parameters)
+{
+    std::vector<double> search_radiuses;
+    if (parameters.radiuses.empty())
+    {
+        search_radiuses.resize(parameters.coordinates.size(),
+                               MatchPlugin::DEFAULT_GPS_PRECISION * MatchPlugin::RADIUS_MULTIPLIER);
+    }
+    else
+    {
+        search_radiuses.resize(parameters.coordinates.size());
+        std::transform(parameters.radiuses.begin(),
+                       parameters.radiuses.end(),
+                       search_radiuses.begin(),
+                       [](const boost::optional<double> &maybe_radius) {
+                           if (maybe_radius)
+                           {
+                               return *maybe_radius * MatchPlugin::RADIUS_MULTIPLIER;
+                           }
+                           else
+                           {
+                               return MatchPlugin::DEFAULT_GPS_PRECISION *
+                                      MatchPlugin::RADIUS_MULTIPLIER;
+                           }
+
+                       });
+    }
+    return search_radiuses;
+}
+
 Status MatchPlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
                                   const api::MatchParameters &parameters,
                                   util::json::Object &json_result) const
@@ -137,37 +173,13 @@ Status MatchPlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFaca
             "InvalidValue", "Timestamps need to be monotonically increasing.", json_result);
     }
 
-    // assuming radius is the standard deviation of a normal distribution
-    // that models GPS noise (in this model), x3 should give us the correct
-    // search radius with > 99% confidence
-    std::vector<double> search_radiuses;
-    if (parameters.radiuses.empty())
-    {
-        search_radiuses.resize(parameters.coordinates.size(),
-                               DEFAULT_GPS_PRECISION * RADIUS_MULTIPLIER);
-    }
-    else
-    {
-        search_radiuses.resize(parameters.coordinates.size());
-        std::transform(parameters.radiuses.begin(),
-                       parameters.radiuses.end(),
-                       search_radiuses.begin(),
-                       [](const boost::optional<double> &maybe_radius) {
-                           if (maybe_radius)
-                           {
-                               return *maybe_radius * RADIUS_MULTIPLIER;
-                           }
-                           else
-                           {
-                               return DEFAULT_GPS_PRECISION * RADIUS_MULTIPLIER;
-                           }
-
-                       });
-    }
+    const auto search_radiuses = getSearchRadiuses(parameters);
 
+    auto phase_start = std::chrono::steady_clock::now();
     auto candidates_lists = GetPhantomNodesInRange(*facade, parameters, search_radiuses);
 
     filterCandidates(parameters.coordinates, candidates_lists);
+    phase_start = RecordPhase(QueryType::Match, QueryPhase::PhantomLookup, phase_start);
     if (std::all_of(candidates_lists.begin(),
                     candidates_lists.end(),
                     [](const std::vector<PhantomNodeWithDistance> &candidates) {
@@ -191,7 +203,146 @@ Status MatchPlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFaca
         return Error("NoMatch", "Could not match the trace.", json_result);
     }
 
-    std::vector<InternalRouteResult> sub_routes(sub_matchings.size());
+    std::vector<InternalRouteResult> sub_routes;
+    RouteSubMatchings(*facade, sub_matchings, sub_routes);
+    phase_start = RecordPhase(QueryType::Match, QueryPhase::Search, phase_start);
+
+    api::MatchAPI match_api{*facade, parameters};
+    match_api.MakeResponse(sub_matchings, sub_routes, json_result);
+    RecordPhase(QueryType::Match, QueryPhase::Assembly, phase_start);
+
+    return Status::Ok;
+}
+
+Status MatchPlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
+                                  MatchSession &session,
+                                  const api::MatchParameters &parameters,
+                                  const bool finish,
+                                  util::json::Object &json_result) const
+{
+    // a push can not stop half way through the session, its searches ignore the deadline
+    QueryDeadlineScope deadline_scope(QueryDeadline{});
+    auto &state = *session.state;
+    const auto &coordinates = parameters.coordinates;
+    const auto &timestamps = parameters.timestamps;
+
+    if (coordinates.empty() && !finish)
+    {
+        return Error("InvalidOptions", "Coordinates are invalid", json_result);
+    }
+    // a push may consist of a single coordinate, unlike a trace
+    if (!static_cast<const api::BaseParameters &>(parameters).IsValid() ||
+        (!timestamps.empty() && timestamps.size() != coordinates.size()))
+    {
+        return Error("InvalidOptions",
+                     "Number of bearings, radiuses, hints or timestamps does not match number "
+                     "of coordinates",
+                     json_result);
+    }
+
+    // enforce maximum number of locations for performance reasons
+    if (max_locations_map_matching > 0 &&
+        static_cast<int>(coordinates.size()) > max_locations_map_matching)
+    {
+        return Error("TooBig", "Too many trace coordinates", json_result);
+    }
+
+    if (!CheckAllCoordinates(coordinates))
+    {
+        return Error("InvalidValue", "Invalid coordinate value.", json_result);
+    }
+
+    const bool first_push = state.NumberOfPoints() == 0;
+    if (!coordinates.empty())
+    {
+        if (!first_push && timestamps.empty() == state.use_timestamps)
+        {
+            return Error("InvalidValue",
+                         "Timestamps need to be given for all or none of the coordinates.",
+                         json_result);
+        }
+
+        const auto time_increases_monotonically =
+            std::is_sorted(timestamps.rbegin(), timestamps.rend(), std::greater<>{}) &&
+            (first_push || timestamps.empty() || timestamps.front() >= state.last_timestamp);
+        if (!time_increases_monotonically)
+        {
+            return Error(
+                "InvalidValue", "Timestamps need to be monotonically increasing.", json_result);
+        }
+    }
+
+    // the session keeps the dataset of its first points alive
+    if (!state.facade)
+    {
+        state.facade = facade;
+    }
+    const auto &session_facade = *state.facade;
+
+    auto phase_start = std::chrono::steady_clock::now();
+    if (!coordinates.empty())
+    {
+        if (first_push)
+        {
+            state.use_timestamps = !timestamps.empty();
+        }
+        if (state.use_timestamps)
+        {
+            state.last_timestamp = timestamps.back();
+        }
+
+        auto candidates_lists =
+            GetPhantomNodesInRange(session_facade, parameters, getSearchRadiuses(parameters));
+        filterCandidates(coordinates, candidates_lists);
+        std::move(candidates_lists.begin(),
+                  candidates_lists.end(),
+                  std::back_inserter(state.candidates_list));
+        state.coordinates.insert(state.coordinates.end(), coordinates.begin(), coordinates.end());
+        state.timestamps.insert(state.timestamps.end(), timestamps.begin(), timestamps.end());
+        if (parameters.radiuses.empty())
+        {
+            state.gps_precisions.resize(state.coordinates.size());
+        }
+        else
+        {
+            state.gps_precisions.insert(
+                state.gps_precisions.end(), parameters.radiuses.begin(), parameters.radiuses.end());
+        }
+        phase_start = RecordPhase(QueryType::Match, QueryPhase::PhantomLookup, phase_start);
+    }
+
+    // the first tracepoint that was not in a response yet
+    const auto first_tracepoint = state.tracepoints_end;
+    const auto max_window = max_locations_map_matching > 0
+                                ? static_cast<std::size_t>(max_locations_map_matching)
+                                : DEFAULT_SESSION_WINDOW;
+    SubMatchingList sub_matchings = map_matching(session_facade, state, finish, max_window);
+
+    std::vector<InternalRouteResult> sub_routes;
+    RouteSubMatchings(session_facade, sub_matchings, sub_routes);
+    phase_start = RecordPhase(QueryType::Match, QueryPhase::Search, phase_start);
+
+    api::MatchAPI match_api{session_facade, parameters};
+    match_api.MakeResponse(sub_matchings,
+                           sub_routes,
+                           first_tracepoint,
+                           state.tracepoints_end - first_tracepoint,
+                           json_result);
+    RecordPhase(QueryType::Match, QueryPhase::Assembly, phase_start);
+
+    if (finish)
+    {
+        state = map_matching::MatchingState();
+    }
+
+    return Status::Ok;
+}
+
+void MatchPlugin::RouteSubMatchings(const datafacade::BaseDataFacade &facade,
+                                    const SubMatchingList &sub_matchings,
+                                    std::vector<InternalRouteResult> &sub_routes) const
+{
+    sub_routes.resize(sub_matchings.size());
     for (auto index : util::irange<std::size_t>(0UL, sub_matchings.size()))
     {
         BOOST_ASSERT(sub_matchings[index].nodes.size() > 1);
@@ -210,15 +361,12 @@ Status MatchPlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFaca
         // force uturns to be on, since we split the phantom nodes anyway and only have
         // bi-directional
         // phantom nodes for possible uturns
-        shortest_path(
-            *facade, sub_routes[index].segment_end_coordinates, {false}, sub_routes[index]);
+        shortest_path(facade,
+                      sub_routes[index].segment_end_coordinates,
+                      boost::optional<bool>(false),
+                      sub_routes[index]);
         BOOST_ASSERT(sub_routes[index].shortest_path_length != INVALID_EDGE_WEIGHT);
     }
-
-    api::MatchAPI match_api{*facade, parameters};
-    match_api.MakeResponse(sub_matchings, sub_routes, json_result);
-
-    return Status::Ok;
 }
 }
 }
@@ -4,6 +4,7 @@
 #include "engine/phantom_node.hpp"
 #include "util/integer_range.hpp"
 
+#include <chrono>
 #include <cstddef>
 #include <string>
 
@@ -42,7 +43,9 @@ Status NearestPlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFa
         return Error("InvalidOptions", "Only one input coordinate is supported", json_result);
     }
 
+    auto phase_start = std::chrono::steady_clock::now();
     auto phantom_nodes = GetPhantomNodes(*facade, params, params.number_of_results);
+    phase_start = RecordPhase(QueryType::Nearest, QueryPhase::PhantomLookup, phase_start);
 
     if (phantom_nodes.front().size() == 0)
     {
@@ -52,6 +55,7 @@ Status NearestPlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFa
 
     api::NearestAPI nearest_api(*facade, params);
     nearest_api.MakeResponse(phantom_nodes, json_result);
+    RecordPhase(QueryType::Nearest, QueryPhase::Assembly, phase_start);
 
     return Status::Ok;
 }
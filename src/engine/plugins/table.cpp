@@ -5,12 +5,15 @@
 #include "engine/routing_algorithms/many_to_many.hpp"
 #include "engine/search_engine_data.hpp"
 #include "util/json_container.hpp"
+#include "util/json_writer.hpp"
 #include "util/string_util.hpp"
 
+#include <chrono>
 #include <cstdlib>
 
 #include <algorithm>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <vector>
 
@@ -23,14 +26,38 @@ namespace engine
 namespace plugins
 {
 
-TablePlugin::TablePlugin(const int max_locations_distance_table)
-    : distance_table(heaps), max_locations_distance_table(max_locations_distance_table)
+TablePlugin::TablePlugin(const int max_locations_distance_table, const std::size_t max_target_sets)
+    : distance_table(heaps), max_locations_distance_table(max_locations_distance_table),
+      target_sets(max_target_sets > 0 ? std::make_unique<TargetSetCache>(max_target_sets)
+                                      : nullptr)
 {
 }
 
 Status TablePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
                                   const api::TableParameters &params,
                                   util::json::Object &result) const
+{
+    return HandleTableRequest(facade, params, result);
+}
+
+Status TablePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
+                                  const api::TableParameters &params,
+                                  util::json::Writer &result) const
+{
+    return HandleTableRequest(facade, params, result);
+}
+
+Status TablePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
+                                  const api::TableParameters &params,
+                                  std::string &result) const
+{
+    return HandleTableRequest(facade, params, result);
+}
+
+template <typename ResultT>
+Status TablePlugin::HandleTableRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
+                                       const api::TableParameters &params,
+                                       ResultT &result) const
 {
     BOOST_ASSERT(params.IsValid());
 
@@ -45,12 +72,33 @@ Status TablePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFaca
             "InvalidOptions", "Number of bearings does not match number of coordinates", result);
     }
 
+    // Destinations with the name of a set register them as the set, without destinations the
+    // targets of the registered set are used
+    TargetSetCache::Targets targets;
+    if (!params.target_set.empty())
+    {
+        if (!target_sets)
+        {
+            return Error("InvalidOptions", "Target sets are disabled", result);
+        }
+        if (params.UsesTargetSet())
+        {
+            targets = target_sets->FindTargets(params.target_set);
+            if (!targets)
+            {
+                return Error("NoTargetSet", "No target set of this name is registered", result);
+            }
+        }
+    }
+
     // Empty sources or destinations means the user wants all of them included, respectively
     // The ManyToMany routing algorithm we dispatch to below already handles this perfectly.
     const auto num_sources =
         params.sources.empty() ? params.coordinates.size() : params.sources.size();
     const auto num_destinations =
-        params.destinations.empty() ? params.coordinates.size() : params.destinations.size();
+        targets ? targets->coordinates.size()
+                : (params.destinations.empty() ? params.coordinates.size()
+                                               : params.destinations.size());
 
     if (max_locations_distance_table > 0 &&
         ((num_sources * num_destinations) >
@@ -59,20 +107,139 @@ Status TablePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFaca
         return Error("TooBig", "Too many table coordinates", result);
     }
 
+    // registers the destinations, a set of the same name is replaced
+    if (!params.target_set.empty() && !targets)
+    {
+        auto registered_targets = std::make_shared<api::BaseParameters>();
+        for (const auto index : params.destinations)
+        {
+            registered_targets->coordinates.push_back(params.coordinates[index]);
+            if (!params.hints.empty())
+            {
+                registered_targets->hints.push_back(params.hints[index]);
+            }
+            if (!params.radiuses.empty())
+            {
+                registered_targets->radiuses.push_back(params.radiuses[index]);
+            }
+            if (!params.bearings.empty())
+            {
+                registered_targets->bearings.push_back(params.bearings[index]);
+            }
+        }
+        targets = std::move(registered_targets);
+        target_sets->Register(params.target_set, targets);
+    }
+
+    auto phase_start = std::chrono::steady_clock::now();
     auto snapped_phantoms = SnapPhantomNodes(GetPhantomNodes(*facade, params));
-    auto result_table =
-        distance_table(*facade, snapped_phantoms, params.sources, params.destinations);
+    phase_start = RecordPhase(QueryType::Table, QueryPhase::PhantomLookup, phase_start);
+
+    const bool with_distances =
+        params.annotations & api::TableParameters::AnnotationsType::Distance;
+    std::vector<EdgeDistance> result_distances;
+    std::vector<EdgeWeight> result_table;
+    TargetSetCache::SnappedTargets snapped_targets;
+    if (targets)
+    {
+        snapped_targets = GetSnappedTargets(facade, params, targets, snapped_phantoms);
+        result_table = with_distances ? distance_table(*facade,
+                                                       snapped_phantoms,
+                                                       params.sources,
+                                                       snapped_targets->buckets,
+                                                       result_distances)
+                                      : distance_table(*facade,
+                                                       snapped_phantoms,
+                                                       params.sources,
+                                                       snapped_targets->buckets);
+    }
+    else if (params.approximate)
+    {
+        const double max_error = api::TableParameters::APPROXIMATE_MAX_ERROR;
+        result_table = distance_table(
+            *facade, snapped_phantoms, params.sources, params.destinations, max_error);
+    }
+    else
+    {
+        result_table =
+            with_distances
+                ? distance_table(*facade,
+                                 snapped_phantoms,
+                                 params.sources,
+                                 params.destinations,
+                                 result_distances)
+                : distance_table(*facade, snapped_phantoms, params.sources, params.destinations);
+    }
+    phase_start = RecordPhase(QueryType::Table, QueryPhase::Search, phase_start);
 
     if (result_table.empty())
     {
         return Error("NoTable", "No table found", result);
     }
 
-    api::TableAPI table_api{*facade, params};
-    table_api.MakeResponse(result_table, snapped_phantoms, result);
+    if (params.UsesTargetSet())
+    {
+        // the waypoints of the targets follow the ones of the coordinates
+        api::TableParameters set_params = params;
+        if (set_params.sources.empty())
+        {
+            set_params.sources.resize(snapped_phantoms.size());
+            std::iota(set_params.sources.begin(), set_params.sources.end(), 0);
+        }
+        set_params.destinations.resize(snapped_targets->phantom_nodes.size());
+        std::iota(set_params.destinations.begin(),
+                  set_params.destinations.end(),
+                  snapped_phantoms.size());
+        snapped_phantoms.insert(snapped_phantoms.end(),
+                                snapped_targets->phantom_nodes.begin(),
+                                snapped_targets->phantom_nodes.end());
+
+        api::TableAPI table_api{*facade, set_params};
+        table_api.MakeResponse(result_table, result_distances, snapped_phantoms, result);
+    }
+    else
+    {
+        api::TableAPI table_api{*facade, params};
+        table_api.MakeResponse(result_table, result_distances, snapped_phantoms, result);
+    }
+    RecordPhase(QueryType::Table, QueryPhase::Assembly, phase_start);
 
     return Status::Ok;
 }
+
+TargetSetCache::SnappedTargets
+TablePlugin::GetSnappedTargets(const std::shared_ptr<datafacade::BaseDataFacade> &facade,
+                               const api::TableParameters &params,
+                               const TargetSetCache::Targets &targets,
+                               const std::vector<PhantomNode> &snapped_phantoms) const
+{
+    auto snapped_targets = target_sets->Find(params.target_set, targets, *facade);
+    if (snapped_targets)
+    {
+        return snapped_targets;
+    }
+
+    // Concurrent first uses of a set search it each, one of them is kept
+    auto snapped_set = std::make_shared<SnappedTargetSet>();
+    if (params.UsesTargetSet())
+    {
+        snapped_set->phantom_nodes = SnapPhantomNodes(GetPhantomNodes(*facade, *targets));
+    }
+    else
+    {
+        // the destinations were snapped with the coordinates of the registering request
+        snapped_set->phantom_nodes.reserve(params.destinations.size());
+        for (const auto index : params.destinations)
+        {
+            snapped_set->phantom_nodes.push_back(snapped_phantoms[index]);
+        }
+    }
+    distance_table(*facade, snapped_set->phantom_nodes, snapped_set->buckets);
+
+    snapped_targets = std::move(snapped_set);
+    target_sets->Insert(params.target_set, targets, facade, snapped_targets);
+    return snapped_targets;
+}
 }
 }
 }
@@ -1,20 +1,21 @@
 #include "engine/plugins/tile.hpp"
+#include "engine/douglas_peucker.hpp"
 #include "engine/edge_unpacker.hpp"
 #include "engine/plugins/plugin_base.hpp"
+#include "engine/tile_encoder.hpp"
+#include "engine/tile_overview.hpp"
 
+#include "util/array_view.hpp"
 #include "util/coordinate_calculation.hpp"
+#include "util/integer_range.hpp"
 #include "util/vector_tile.hpp"
 #include "util/web_mercator.hpp"
 
-#include <boost/geometry.hpp>
-#include <boost/geometry/geometries/geometries.hpp>
-#include <boost/geometry/geometries/point_xy.hpp>
-#include <boost/geometry/multi/geometries/multi_linestring.hpp>
-
 #include <protozero/pbf_writer.hpp>
 #include <protozero/varint.hpp>
 
 #include <algorithm>
+#include <iterator>
 #include <numeric>
 #include <string>
 #include <unordered_map>
@@ -33,44 +34,6 @@ namespace plugins
 {
 namespace
 {
-// TODO: Port all this encoding logic to https://github.com/mapbox/vector-tile, which wasn't
-// available when this code was originally written.
-
-// Simple container class for WGS84 coordinates
-template <typename T> struct Point final
-{
-    Point(T _x, T _y) : x(_x), y(_y) {}
-
-    const T x;
-    const T y;
-};
-
-// Simple container to hold a bounding box
-struct BBox final
-{
-    BBox(const double _minx, const double _miny, const double _maxx, const double _maxy)
-        : minx(_minx), miny(_miny), maxx(_maxx), maxy(_maxy)
-    {
-    }
-
-    double width() const { return maxx - minx; }
-    double height() const { return maxy - miny; }
-
-    const double minx;
-    const double miny;
-    const double maxx;
-    const double maxy;
-};
-
-// Simple container for integer coordinates (i.e. pixel coords)
-struct point_type_i final
-{
-    point_type_i(std::int64_t _x, std::int64_t _y) : x(_x), y(_y) {}
-
-    const std::int64_t x;
-    const std::int64_t y;
-};
-
 // Used to accumulate all the information we want in the tile about
 // a turn.
 struct TurnData final
@@ -90,33 +53,17 @@ struct TurnData final
     const std::size_t weight_offset;
 };
 
-using FixedPoint = Point<std::int32_t>;
-using FloatPoint = Point<double>;
-
-using FixedLine = std::vector<FixedPoint>;
-using FloatLine = std::vector<FloatPoint>;
-
 constexpr const static int MIN_ZOOM_FOR_TURNS = 15;
 
-// We use boost::geometry to clip lines/points that are outside or cross the boundary
-// of the tile we're rendering.  We need these types defined to use boosts clipping
-// logic
-typedef boost::geometry::model::point<double, 2, boost::geometry::cs::cartesian> point_t;
-typedef boost::geometry::model::linestring<point_t> linestring_t;
-typedef boost::geometry::model::box<point_t> box_t;
-typedef boost::geometry::model::multi_linestring<linestring_t> multi_linestring_t;
-const static box_t clip_box(point_t(-util::vector_tile::BUFFER, -util::vector_tile::BUFFER),
-                            point_t(util::vector_tile::EXTENT + util::vector_tile::BUFFER,
-                                    util::vector_tile::EXTENT + util::vector_tile::BUFFER));
-
 // from mapnik-vector-tile
 // Encodes a linestring using protobuf zigzag encoding
-inline bool encodeLinestring(const FixedLine &line,
+inline bool encodeLinestring(const tile::Point *first,
+                             const tile::Point *last,
                              protozero::packed_field_uint32 &geometry,
                              std::int32_t &start_x,
                              std::int32_t &start_y)
 {
-    const std::size_t line_size = line.size();
+    const std::size_t line_size = last - first;
     if (line_size < 2)
     {
         return false;
@@ -124,7 +71,7 @@ inline bool encodeLinestring(const FixedLine &line,
 
     const unsigned lineto_count = static_cast<const unsigned>(line_size) - 1;
 
-    auto pt = line.begin();
+    auto pt = first;
     const constexpr int MOVETO_COMMAND = 9;
     geometry.add_element(MOVETO_COMMAND); // move_to | (1 << 3)
     geometry.add_element(protozero::encode_zigzag32(pt->x - start_x));
@@ -136,7 +83,7 @@ inline bool encodeLinestring(const FixedLine &line,
     geometry.add_element((lineto_count << 3u) | 2u);
     // Now that we've issued the LINETO REPEAT N command, we append
     // N coordinate pairs immediately after the command.
-    for (++pt; pt != line.end(); ++pt)
+    for (++pt; pt != last; ++pt)
     {
         const std::int32_t dx = pt->x - start_x;
         const std::int32_t dy = pt->y - start_y;
@@ -150,7 +97,7 @@ inline bool encodeLinestring(const FixedLine &line,
 
 // from mapnik-vctor-tile
 // Encodes a point
-inline void encodePoint(const FixedPoint &pt, protozero::packed_field_uint32 &geometry)
+inline void encodePoint(const tile::Point pt, protozero::packed_field_uint32 &geometry)
 {
     const constexpr int MOVETO_COMMAND = 9;
     geometry.add_element(MOVETO_COMMAND);
@@ -162,88 +109,206 @@ inline void encodePoint(const FixedPoint &pt, protozero::packed_field_uint32 &ge
 }
 
 /**
- * Returnx the x1,y1,x2,y2 pixel coordinates of a line in a given
- * tile.
+ * Converts lon/lat into coordinates inside a Mercator projection tile (x/y pixel values)
  *
- * @param start the first coordinate of the line
- * @param target the last coordinate of the line
- * @param tile_bbox the boundaries of the tile, in mercator coordinates
- * @return a FixedLine with coordinates relative to the tile_bbox.
+ * @param point the lon/lat you want the tile coords for
+ * @param projection the projection into the tile
+ * @return a point (x,y) on the tile
  */
-FixedLine coordinatesToTileLine(const util::Coordinate start,
-                                const util::Coordinate target,
-                                const BBox &tile_bbox)
+tile::Point coordinatesToTilePoint(const util::Coordinate point,
+                                   const util::web_mercator::TileProjection &projection)
 {
-    FloatLine geo_line;
-    geo_line.emplace_back(static_cast<double>(util::toFloating(start.lon)),
-                          static_cast<double>(util::toFloating(start.lat)));
-    geo_line.emplace_back(static_cast<double>(util::toFloating(target.lon)),
-                          static_cast<double>(util::toFloating(target.lat)));
+    return tile::Point{static_cast<std::int32_t>(std::round(projection.X(point.lon))),
+                       static_cast<std::int32_t>(std::round(projection.Y(point.lat)))};
+}
 
-    linestring_t unclipped_line;
+/**
+ * Projects a geometry into a tile.
+ *
+ * @param coordinates the lon/lat coordinates of the geometry
+ * @param projection the projection into the tile
+ * @param points the pixel coordinates of the geometry, the buffer is reused for all geometries
+ */
+void coordinatesToTilePoints(const std::vector<util::Coordinate> &coordinates,
+                             const util::web_mercator::TileProjection &projection,
+                             std::vector<tile::Point> &points)
+{
+    points.resize(coordinates.size());
+    std::transform(coordinates.begin(),
+                   coordinates.end(),
+                   points.begin(),
+                   [&projection](const util::Coordinate coordinate) {
+                       return coordinatesToTilePoint(coordinate, projection);
+                   });
+}
 
-    for (auto const &pt : geo_line)
+/**
+ * Encodes a tile of the overview levels from the lines of the tile overview.
+ *
+ * The tile has the same "speeds" layer with the same attributes as the tiles of the higher
+ * levels, only each feature is a geometry between two intersections instead of a segment.
+ */
+void encodeOverviewTile(const datafacade::BaseDataFacade &facade,
+                        const api::TileParameters &parameters,
+                        std::string &pbf_buffer)
+{
+    const auto &overview = facade.GetTileOverview();
+    const auto &line_indexes = overview.GetLines(parameters.z, parameters.x, parameters.y);
+
+    // Projects coordinates into the pixels of the tile
+    const util::web_mercator::TileProjection projection(
+        parameters.x, parameters.y, parameters.z, util::vector_tile::EXTENT);
+
+    // The same tables for the attribute values as in the regular tiles
+    tile::ValueTable<EdgeWeight> weight_values;
+    tile::ValueTable<std::string> name_values;
+    weight_values.Reserve(line_indexes.size() * 2);
+    name_values.Reserve(line_indexes.size());
+    std::vector<std::uint32_t> name_offsets;
+    name_offsets.reserve(line_indexes.size());
+    DatasourceID max_datasource_id = 0;
+
+    for (const auto index : line_indexes)
     {
-        double px_merc = pt.x * util::web_mercator::DEGREE_TO_PX;
-        double py_merc = util::web_mercator::latToY(util::FloatLatitude{pt.y}) *
-                         util::web_mercator::DEGREE_TO_PX;
-        // convert lon/lat to tile coordinates
-        const auto px = std::round(
-            ((px_merc - tile_bbox.minx) * util::web_mercator::TILE_SIZE / tile_bbox.width()) *
-            util::vector_tile::EXTENT / util::web_mercator::TILE_SIZE);
-        const auto py = std::round(
-            ((tile_bbox.maxy - py_merc) * util::web_mercator::TILE_SIZE / tile_bbox.height()) *
-            util::vector_tile::EXTENT / util::web_mercator::TILE_SIZE);
-
-        boost::geometry::append(unclipped_line, point_t(px, py));
+        const auto &line = overview.GetLine(index);
+        weight_values.Use(line.forward_weight);
+        weight_values.Use(line.reverse_weight);
+        max_datasource_id = std::max(max_datasource_id, line.forward_datasource);
+        max_datasource_id = std::max(max_datasource_id, line.reverse_datasource);
+        name_offsets.push_back(name_values.Use(facade.GetNameForID(line.name_id)));
     }
 
-    multi_linestring_t clipped_line;
+    pbf_buffer.reserve(pbf_buffer.size() + line_indexes.size() * 64);
+    protozero::pbf_writer tile_writer{pbf_buffer};
+    {
+        protozero::pbf_writer line_layer_writer(tile_writer, util::vector_tile::LAYER_TAG);
+        line_layer_writer.add_uint32(util::vector_tile::VERSION_TAG, 2);
+        line_layer_writer.add_string(util::vector_tile::NAME_TAG, "speeds");
+        line_layer_writer.add_uint32(util::vector_tile::EXTENT_TAG, util::vector_tile::EXTENT);
+
+        unsigned id = 1;
+        const auto encode_tile_lines = [&](const tile::ClippedLines &tile_lines,
+                                           const TileOverview::Line &line,
+                                           const std::uint32_t name_offset,
+                                           const EdgeWeight weight,
+                                           const DatasourceID datasource) {
+            if (tile_lines.Empty())
+            {
+                return;
+            }
 
-    boost::geometry::intersection(clip_box, unclipped_line, clipped_line);
+            const auto speed_kmh =
+                static_cast<std::uint32_t>(std::round(line.length / weight * 10 * 3.6));
 
-    FixedLine tile_line;
+            protozero::pbf_writer feature_writer(line_layer_writer,
+                                                 util::vector_tile::FEATURE_TAG);
+            feature_writer.add_enum(util::vector_tile::GEOMETRY_TAG,
+                                    util::vector_tile::GEOMETRY_TYPE_LINE);
+            feature_writer.add_uint64(util::vector_tile::ID_TAG, id++);
+            {
+                // key and value offsets as in the regular tiles
+                protozero::packed_field_uint32 field(feature_writer,
+                                                     util::vector_tile::FEATURE_ATTRIBUTES_TAG);
+                field.add_element(0);
+                field.add_element(std::min(speed_kmh, 127u));
+                field.add_element(1);
+                field.add_element(128 + (line.is_tiny ? 0 : 1));
+                field.add_element(2);
+                field.add_element(130 + datasource);
+                field.add_element(3);
+                field.add_element(130 + max_datasource_id + 1 + weight_values.Use(weight));
+                field.add_element(4);
+                field.add_element(130 + max_datasource_id + 1 + weight_values.Size() +
+                                  name_offset);
+            }
+            {
+                // the parts of a clipped geometry are written as one multi-linestring
+                protozero::packed_field_uint32 geometry(
+                    feature_writer, util::vector_tile::FEATURE_GEOMETRIES_TAG);
+                std::int32_t start_x = 0;
+                std::int32_t start_y = 0;
+                for (const auto part : util::irange<std::size_t>(0, tile_lines.GetNumberOfLines()))
+                {
+                    encodeLinestring(
+                        tile_lines.Begin(part), tile_lines.End(part), geometry, start_x, start_y);
+                }
+            }
+        };
 
-    // b::g::intersection might return a line with one point if the
-    // original line was very short and coords were dupes
-    if (!clipped_line.empty() && clipped_line[0].size() == 2)
-    {
-        if (clipped_line[0].size() == 2)
+        // the projected and the clipped geometries, reused for all lines
+        std::vector<tile::Point> points;
+        tile::ClippedLines tile_lines;
+        for (const auto line_number : util::irange<std::size_t>(0, line_indexes.size()))
         {
-            for (const auto &p : clipped_line[0])
+            const auto &line = overview.GetLine(line_indexes[line_number]);
+            // the lines are simplified for the highest overview level
+            if (parameters.z < TileOverview::MAX_ZOOM)
             {
-                tile_line.emplace_back(p.get<0>(), p.get<1>());
+                coordinatesToTilePoints(
+                    douglasPeucker(line.coordinates, parameters.z), projection, points);
+            }
+            else
+            {
+                coordinatesToTilePoints(line.coordinates, projection, points);
             }
-        }
-    }
-
-    return tile_line;
-}
-
-/**
- * Converts lon/lat into coordinates inside a Mercator projection tile (x/y pixel values)
- *
- * @param point the lon/lat you want the tile coords for
- * @param tile_bbox the mercator boundaries of the tile
- * @return a point (x,y) on the tile defined by tile_bbox
- */
-FixedPoint coordinatesToTilePoint(const util::Coordinate point, const BBox &tile_bbox)
-{
-    const FloatPoint geo_point{static_cast<double>(util::toFloating(point.lon)),
-                               static_cast<double>(util::toFloating(point.lat))};
 
-    const double px_merc = geo_point.x * util::web_mercator::DEGREE_TO_PX;
-    const double py_merc = util::web_mercator::latToY(util::FloatLatitude{geo_point.y}) *
-                           util::web_mercator::DEGREE_TO_PX;
+            if (line.forward_weight != 0)
+            {
+                tile_lines.Clear();
+                tile::clipLine(points.data(), points.data() + points.size(), tile_lines);
+                encode_tile_lines(tile_lines,
+                                  line,
+                                  name_offsets[line_number],
+                                  line.forward_weight,
+                                  line.forward_datasource);
+            }
+            if (line.reverse_weight != 0)
+            {
+                std::reverse(points.begin(), points.end());
+                tile_lines.Clear();
+                tile::clipLine(points.data(), points.data() + points.size(), tile_lines);
+                encode_tile_lines(tile_lines,
+                                  line,
+                                  name_offsets[line_number],
+                                  line.reverse_weight,
+                                  line.reverse_datasource);
+            }
+        }
 
-    const auto px = static_cast<std::int32_t>(std::round(
-        ((px_merc - tile_bbox.minx) * util::web_mercator::TILE_SIZE / tile_bbox.width()) *
-        util::vector_tile::EXTENT / util::web_mercator::TILE_SIZE));
-    const auto py = static_cast<std::int32_t>(std::round(
-        ((tile_bbox.maxy - py_merc) * util::web_mercator::TILE_SIZE / tile_bbox.height()) *
-        util::vector_tile::EXTENT / util::web_mercator::TILE_SIZE));
+        line_layer_writer.add_string(util::vector_tile::KEY_TAG, "speed");
+        line_layer_writer.add_string(util::vector_tile::KEY_TAG, "is_small");
+        line_layer_writer.add_string(util::vector_tile::KEY_TAG, "datasource");
+        line_layer_writer.add_string(util::vector_tile::KEY_TAG, "duration");
+        line_layer_writer.add_string(util::vector_tile::KEY_TAG, "name");
 
-    return FixedPoint{px, py};
+        for (std::size_t i = 0; i < 128; i++)
+        {
+            protozero::pbf_writer values_writer(line_layer_writer, util::vector_tile::VARIANT_TAG);
+            values_writer.add_uint64(util::vector_tile::VARIANT_TYPE_UINT64, i);
+        }
+        for (const bool is_small : {true, false})
+        {
+            protozero::pbf_writer values_writer(line_layer_writer, util::vector_tile::VARIANT_TAG);
+            values_writer.add_bool(util::vector_tile::VARIANT_TYPE_BOOL, is_small);
+        }
+        for (std::size_t i = 0; i <= max_datasource_id; i++)
+        {
+            protozero::pbf_writer values_writer(line_layer_writer, util::vector_tile::VARIANT_TAG);
+            values_writer.add_string(util::vector_tile::VARIANT_TYPE_STRING,
+                                     facade.GetDatasourceName(i));
+        }
+        for (const auto value : weight_values.Values())
+        {
+            protozero::pbf_writer values_writer(line_layer_writer, util::vector_tile::VARIANT_TAG);
+            // the weights are the totals of the segments, in deciseconds
+            values_writer.add_double(util::vector_tile::VARIANT_TYPE_DOUBLE, value / 10.);
+        }
+        for (const auto &name : name_values.Values())
+        {
+            protozero::pbf_writer values_writer(line_layer_writer, util::vector_tile::VARIANT_TAG);
+            values_writer.add_string(util::vector_tile::VARIANT_TYPE_STRING, name);
+        }
+    }
 }
 
 } // namespace
@@ -254,6 +319,23 @@ Status TilePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
 {
     BOOST_ASSERT(parameters.IsValid());
 
+    auto *const tile_cache = facade->GetTileCache();
+    if (tile_cache && tile_cache->Find(parameters.z, parameters.x, parameters.y, pbf_buffer))
+    {
+        return Status::Ok;
+    }
+
+    // Lower levels are drawn from the tile overview instead of the single segments
+    if (parameters.z <= TileOverview::MAX_ZOOM)
+    {
+        encodeOverviewTile(*facade, parameters, pbf_buffer);
+        if (tile_cache)
+        {
+            tile_cache->Insert(parameters.z, parameters.x, parameters.y, pbf_buffer);
+        }
+        return Status::Ok;
+    }
+
     double min_lon, min_lat, max_lon, max_lat;
 
     // Convert the z,x,y mercator tile coordinates into WGS84 lon/lat values
@@ -276,87 +358,26 @@ Status TilePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
 
     // Vector tiles encode properties as references to a common lookup table.
     // When we add a property to a "feature", we actually attach the index of the value
-    // rather than the value itself.  Thus, we need to keep a list of the unique
-    // values we need, and we add this list to the tile as a lookup table.  This
-    // vector holds all the actual used values, the feature refernce offsets in
-    // this vector.
-    // for integer values
-    std::vector<int> used_line_ints;
-    // While constructing the tile, we keep track of which integers we have in our table
-    // and their offsets, so multiple features can re-use the same values
-    std::unordered_map<int, std::size_t> line_int_offsets;
-
+    // rather than the value itself.  Thus, we need to keep a table of the unique
+    // values we need, and we add this table to the tile as a lookup table.  The
+    // tables keep the offset of every value, so multiple features can re-use the same values.
+    // for the weights of the lines
+    tile::ValueTable<EdgeWeight> line_int_values;
     // Same idea for street names - one lookup table for names for all features
-    std::vector<std::string> names;
-    std::unordered_map<std::string, std::size_t> name_offsets;
-
+    tile::ValueTable<std::string> name_values;
     // And again for integer values used by points.
-    std::vector<int> used_point_ints;
-    std::unordered_map<int, std::size_t> point_int_offsets;
-
+    tile::ValueTable<int> point_int_values;
     // And again for float values used by points
-    std::vector<float> used_point_floats;
-    std::unordered_map<float, std::size_t> point_float_offsets;
+    tile::ValueTable<float> point_float_values;
+
+    line_int_values.Reserve(edges.size() * 2);
+    name_values.Reserve(edges.size());
 
-    std::uint8_t max_datasource_id = 0;
+    DatasourceID max_datasource_id = 0;
 
     // This is where we accumulate information on turns
     std::vector<TurnData> all_turn_data;
 
-    // Helper function for adding a new value to the line_ints lookup table.  Returns
-    // the index of the value in the table, adding the value if it doesn't already
-    // exist
-    const auto use_line_value = [&used_line_ints, &line_int_offsets](const int value) {
-        const auto found = line_int_offsets.find(value);
-
-        if (found == line_int_offsets.end())
-        {
-            used_line_ints.push_back(value);
-            line_int_offsets[value] = used_line_ints.size() - 1;
-        }
-
-        return;
-    };
-
-    // Same again
-    const auto use_point_int_value = [&used_point_ints, &point_int_offsets](const int value) {
-        const auto found = point_int_offsets.find(value);
-        std::size_t offset;
-
-        if (found == point_int_offsets.end())
-        {
-            used_point_ints.push_back(value);
-            offset = used_point_ints.size() - 1;
-            point_int_offsets[value] = offset;
-        }
-        else
-        {
-            offset = found->second;
-        }
-
-        return offset;
-    };
-
-    // And a third time, should probably template this....
-    const auto use_point_float_value = [&used_point_floats,
-                                        &point_float_offsets](const float value) {
-        const auto found = point_float_offsets.find(value);
-        std::size_t offset;
-
-        if (found == point_float_offsets.end())
-        {
-            used_point_floats.push_back(value);
-            offset = used_point_floats.size() - 1;
-            point_float_offsets[value] = offset;
-        }
-        else
-        {
-            offset = found->second;
-        }
-
-        return offset;
-    };
-
     // If we're zooming into 16 or higher, include turn data.  Why?  Because turns make the map
     // really cramped, so we don't bother including the data for tiles that span a large area.
     if (parameters.z >= MIN_ZOOM_FOR_TURNS)
@@ -434,7 +455,7 @@ Status TilePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
         //  uv is the "approach"
         //  vw is the "exit"
         std::vector<contractor::QueryEdge::EdgeData> unpacked_shortcut;
-        std::vector<EdgeWeight> approach_weight_vector;
+        util::SegmentWeightView approach_weight_vector;
         // Look at every node in the directed graph we created
         for (const auto &startnode : directed_graph)
         {
@@ -543,7 +564,7 @@ Status TilePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
                         // Add the angle to the values table for the vector tile, and get the
                         // index
                         // of that value in the table
-                        const auto angle_in_index = use_point_int_value(angle_in);
+                        const auto angle_in_index = point_int_values.Use(angle_in);
 
                         // Calculate the bearing leading away from the intersection
                         const auto exit_bearing = static_cast<int>(
@@ -562,12 +583,12 @@ Status TilePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
 
                         // Add the turn angle value to the value lookup table for the vector
                         // tile.
-                        const auto turn_angle_index = use_point_int_value(turn_angle);
+                        const auto turn_angle_index = point_int_values.Use(turn_angle);
                         // And, same for the actual turn cost value - it goes in the lookup
                         // table,
                         // not directly on the feature itself.
-                        const auto turn_cost_index = use_point_float_value(
-                            turn_cost / 10.0); // Note conversion to float here
+                        const auto turn_cost_index = point_float_values.Use(
+                            static_cast<float>(turn_cost / 10.0)); // Note conversion to float
 
                         // Save everything we need to later add all the points to the tile.
                         // We need the coordinate of the intersection, the angle in, the turn
@@ -580,18 +601,56 @@ Status TilePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
         }
     }
 
+    // Projects coordinates into the pixels of the tile
+    const util::web_mercator::TileProjection projection(
+        parameters.x, parameters.y, parameters.z, util::vector_tile::EXTENT);
+
     // Vector tiles encode feature properties as indexes into a lookup table.  So, we need
     // to "pre-loop" over all the edges to create the lookup tables.  Once we have those, we
     // can then encode the features, and we'll know the indexes that feature properties
-    // need to refer to.
+    // need to refer to.  The pre-loop keeps everything the features need, so the geometries
+    // and weights of the segments are only looked up once.
+    struct SegmentAttributes
+    {
+        tile::Point source;
+        tile::Point target;
+        double length;
+        EdgeWeight forward_weight;
+        EdgeWeight reverse_weight;
+        std::uint32_t forward_weight_offset;
+        std::uint32_t reverse_weight_offset;
+        std::uint32_t name_offset;
+        DatasourceID forward_datasource;
+        DatasourceID reverse_datasource;
+    };
+    std::vector<SegmentAttributes> segments;
+    segments.reserve(edges.size());
     for (const auto &edge : edges)
     {
-
+        // Get coordinates for start/end nodes of segment (NodeIDs u and v)
+        const auto a = facade->GetCoordinateOfNode(edge.u);
+        const auto b = facade->GetCoordinateOfNode(edge.v);
+        // The length in meters, precomputed unless the segment is too long for it
+        const auto forward_length_vector =
+            facade->GetUncompressedForwardLengths(edge.packed_geometry_id);
+        const double length =
+            !forward_length_vector.empty() &&
+                    forward_length_vector[edge.fwd_segment_position] != INVALID_SEGMENT_LENGTH
+                ? forward_length_vector[edge.fwd_segment_position] / 10.
+                : osrm::util::coordinate_calculation::haversineDistance(a, b);
+
+        const auto forward_weight_vector =
+            facade->GetUncompressedForwardWeights(edge.packed_geometry_id);
+        const auto reverse_weight_vector =
+            facade->GetUncompressedReverseWeights(edge.packed_geometry_id);
         const auto forward_datasource_vector =
             facade->GetUncompressedForwardDatasources(edge.packed_geometry_id);
         const auto reverse_datasource_vector =
             facade->GetUncompressedReverseDatasources(edge.packed_geometry_id);
 
+        const auto forward_weight = forward_weight_vector[edge.fwd_segment_position];
+        const auto reverse_weight =
+            reverse_weight_vector[reverse_weight_vector.size() - edge.fwd_segment_position - 1];
         BOOST_ASSERT(edge.fwd_segment_position < forward_datasource_vector.size());
         const auto forward_datasource = forward_datasource_vector[edge.fwd_segment_position];
         BOOST_ASSERT(edge.fwd_segment_position < reverse_datasource_vector.size());
@@ -602,18 +661,26 @@ Status TilePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
         // data to the layer attribute values
         max_datasource_id = std::max(max_datasource_id, forward_datasource);
         max_datasource_id = std::max(max_datasource_id, reverse_datasource);
+
+        const auto reverse_weight_offset = line_int_values.Use(reverse_weight);
+        const auto forward_weight_offset = line_int_values.Use(forward_weight);
+        // the name is only copied if the tile does not have it yet
+        const auto name_offset = name_values.Use(facade->GetNameForID(edge.name_id));
+
+        segments.push_back(SegmentAttributes{coordinatesToTilePoint(a, projection),
+                                             coordinatesToTilePoint(b, projection),
+                                             length,
+                                             forward_weight,
+                                             reverse_weight,
+                                             forward_weight_offset,
+                                             reverse_weight_offset,
+                                             name_offset,
+                                             forward_datasource,
+                                             reverse_datasource});
     }
 
-    // Convert tile coordinates into mercator coordinates
-    double min_mercator_lon, min_mercator_lat, max_mercator_lon, max_mercator_lat;
-    util::web_mercator::xyzToMercator(parameters.x,
-                                      parameters.y,
-                                      parameters.z,
-                                      min_mercator_lon,
-                                      min_mercator_lat,
-                                      max_mercator_lon,
-                                      max_mercator_lat);
-    const BBox tile_bbox{min_mercator_lon, min_mercator_lat, max_mercator_lon, max_mercator_lat};
+    // A feature takes around 30 bytes, the values and the turns are few in comparison
+    pbf_buffer.reserve(pbf_buffer.size() + edges.size() * 2 * 32);
 
     // Protobuf serializes blocks when objects go out of scope, hence
     // the extra scoping below.
@@ -633,168 +700,112 @@ Status TilePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
             line_layer_writer.add_uint32(util::vector_tile::EXTENT_TAG,
                                          util::vector_tile::EXTENT); // extent
 
-            // Because we need to know the indexes into the vector tile lookup table,
-            // we need to do an initial pass over the data and create the complete
-            // index of used values.
-            for (const auto &edge : edges)
-            {
-                const auto forward_weight_vector =
-                    facade->GetUncompressedForwardWeights(edge.packed_geometry_id);
-                const auto reverse_weight_vector =
-                    facade->GetUncompressedReverseWeights(edge.packed_geometry_id);
-                const auto forward_weight = forward_weight_vector[edge.fwd_segment_position];
-                const auto reverse_weight = reverse_weight_vector[reverse_weight_vector.size() -
-                                                                  edge.fwd_segment_position - 1];
-                use_line_value(reverse_weight);
-                use_line_value(forward_weight);
-            }
-
             // Begin the layer features block
             {
                 // Each feature gets a unique id, starting at 1
                 unsigned id = 1;
-                for (const auto &edge : edges)
-                {
-                    // Get coordinates for start/end nodes of segment (NodeIDs u and v)
-                    const auto a = facade->GetCoordinateOfNode(edge.u);
-                    const auto b = facade->GetCoordinateOfNode(edge.v);
-                    // Calculate the length in meters
-                    const double length =
-                        osrm::util::coordinate_calculation::haversineDistance(a, b);
-
-                    const auto forward_weight_vector =
-                        facade->GetUncompressedForwardWeights(edge.packed_geometry_id);
-                    const auto reverse_weight_vector =
-                        facade->GetUncompressedReverseWeights(edge.packed_geometry_id);
-                    const auto forward_datasource_vector =
-                        facade->GetUncompressedForwardDatasources(edge.packed_geometry_id);
-                    const auto reverse_datasource_vector =
-                        facade->GetUncompressedReverseDatasources(edge.packed_geometry_id);
-                    const auto forward_weight = forward_weight_vector[edge.fwd_segment_position];
-                    const auto reverse_weight =
-                        reverse_weight_vector[reverse_weight_vector.size() -
-                                              edge.fwd_segment_position - 1];
-                    const auto forward_datasource =
-                        forward_datasource_vector[edge.fwd_segment_position];
-                    const auto reverse_datasource =
-                        reverse_datasource_vector[reverse_datasource_vector.size() -
-                                                  edge.fwd_segment_position - 1];
-
-                    std::string name = facade->GetNameForID(edge.name_id);
-                    const auto name_offset = [&name, &names, &name_offsets]() {
-                        auto iter = name_offsets.find(name);
-                        if (iter == name_offsets.end())
-                        {
-                            auto offset = names.size();
-                            name_offsets[name] = offset;
-                            names.push_back(std::move(name));
-                            return offset;
-                        }
-                        return iter->second;
-                    }();
-
-                    const auto encode_tile_line = [&line_layer_writer,
-                                                   &edge,
-                                                   &id,
-                                                   &max_datasource_id,
-                                                   &used_line_ints](const FixedLine &tile_line,
-                                                                    const std::uint32_t speed_kmh,
-                                                                    const std::size_t duration,
-                                                                    const DatasourceID datasource,
-                                                                    const std::size_t name_idx,
-                                                                    std::int32_t &start_x,
-                                                                    std::int32_t &start_y) {
-                        // Here, we save the two attributes for our feature: the speed and
-                        // the is_small boolean.  We only serve up speeds from 0-139, so all we
-                        // do is save the first
-                        protozero::pbf_writer feature_writer(line_layer_writer,
-                                                             util::vector_tile::FEATURE_TAG);
-                        // Field 3 is the "geometry type" field.  Value 2 is "line"
-                        feature_writer.add_enum(
-                            util::vector_tile::GEOMETRY_TAG,
-                            util::vector_tile::GEOMETRY_TYPE_LINE); // geometry type
-                        // Field 1 for the feature is the "id" field.
-                        feature_writer.add_uint64(util::vector_tile::ID_TAG, id++); // id
-                        {
-                            // When adding attributes to a feature, we have to write
-                            // pairs of numbers.  The first value is the index in the
-                            // keys array (written later), and the second value is the
-                            // index into the "values" array (also written later).  We're
-                            // not writing the actual speed or bool value here, we're saving
-                            // an index into the "values" array.  This means many features
-                            // can share the same value data, leading to smaller tiles.
-                            protozero::packed_field_uint32 field(
-                                feature_writer, util::vector_tile::FEATURE_ATTRIBUTES_TAG);
-
-                            field.add_element(0); // "speed" tag key offset
-                            field.add_element(
-                                std::min(speed_kmh, 127u)); // save the speed value, capped at 127
-                            field.add_element(1);           // "is_small" tag key offset
-                            field.add_element(128 +
-                                              (edge.component.is_tiny ? 0 : 1)); // is_small feature
-                            field.add_element(2);                // "datasource" tag key offset
-                            field.add_element(130 + datasource); // datasource value offset
-                            field.add_element(3);                // "duration" tag key offset
-                            field.add_element(130 + max_datasource_id + 1 +
-                                              duration); // duration value offset
-                            field.add_element(4);        // "name" tag key offset
-
-                            field.add_element(130 + max_datasource_id + 1 + used_line_ints.size() +
-                                              name_idx); // name value offset
-                        }
-                        {
-
-                            // Encode the geometry for the feature
-                            protozero::packed_field_uint32 geometry(
-                                feature_writer, util::vector_tile::FEATURE_GEOMETRIES_TAG);
-                            encodeLinestring(tile_line, geometry, start_x, start_y);
-                        }
-                    };
+                // The clipped segment, reused for all features
+                tile::ClippedLines tile_line;
+
+                const auto encode_tile_line = [&line_layer_writer,
+                                               &id,
+                                               &max_datasource_id,
+                                               &line_int_values,
+                                               &tile_line](const bool is_tiny,
+                                                           const std::uint32_t speed_kmh,
+                                                           const std::size_t duration,
+                                                           const DatasourceID datasource,
+                                                           const std::size_t name_idx) {
+                    // Here, we save the two attributes for our feature: the speed and
+                    // the is_small boolean.  We only serve up speeds from 0-139, so all we
+                    // do is save the first
+                    protozero::pbf_writer feature_writer(line_layer_writer,
+                                                         util::vector_tile::FEATURE_TAG);
+                    // Field 3 is the "geometry type" field.  Value 2 is "line"
+                    feature_writer.add_enum(util::vector_tile::GEOMETRY_TAG,
+                                            util::vector_tile::GEOMETRY_TYPE_LINE); // geometry type
+                    // Field 1 for the feature is the "id" field.
+                    feature_writer.add_uint64(util::vector_tile::ID_TAG, id++); // id
+                    {
+                        // When adding attributes to a feature, we have to write
+                        // pairs of numbers.  The first value is the index in the
+                        // keys array (written later), and the second value is the
+                        // index into the "values" array (also written later).  We're
+                        // not writing the actual speed or bool value here, we're saving
+                        // an index into the "values" array.  This means many features
+                        // can share the same value data, leading to smaller tiles.
+                        protozero::packed_field_uint32 field(
+                            feature_writer, util::vector_tile::FEATURE_ATTRIBUTES_TAG);
 
-                    // If this is a valid forward edge, go ahead and add it to the tile
-                    if (forward_weight != 0 && edge.forward_segment_id.enabled)
+                        field.add_element(0); // "speed" tag key offset
+                        field.add_element(
+                            std::min(speed_kmh, 127u)); // save the speed value, capped at 127
+                        field.add_element(1);           // "is_small" tag key offset
+                        field.add_element(128 + (is_tiny ? 0 : 1)); // is_small feature
+                        field.add_element(2);                       // "datasource" tag key offset
+                        field.add_element(130 + datasource);        // datasource value offset
+                        field.add_element(3);                       // "duration" tag key offset
+                        field.add_element(130 + max_datasource_id + 1 +
+                                          duration); // duration value offset
+                        field.add_element(4);        // "name" tag key offset
+
+                        field.add_element(130 + max_datasource_id + 1 + line_int_values.Size() +
+                                          name_idx); // name value offset
+                    }
                     {
+                        // Encode the geometry for the feature
+                        protozero::packed_field_uint32 geometry(
+                            feature_writer, util::vector_tile::FEATURE_GEOMETRIES_TAG);
                         std::int32_t start_x = 0;
                         std::int32_t start_y = 0;
+                        encodeLinestring(
+                            tile_line.Begin(0), tile_line.End(0), geometry, start_x, start_y);
+                    }
+                };
 
+                for (const auto index : util::irange<std::size_t>(0, edges.size()))
+                {
+                    const auto &edge = edges[index];
+                    const auto &segment = segments[index];
+
+                    // If this is a valid forward edge, go ahead and add it to the tile
+                    if (segment.forward_weight != 0 && edge.forward_segment_id.enabled)
+                    {
                         // Calculate the speed for this line
-                        std::uint32_t speed_kmh =
-                            static_cast<std::uint32_t>(round(length / forward_weight * 10 * 3.6));
+                        std::uint32_t speed_kmh = static_cast<std::uint32_t>(
+                            round(segment.length / segment.forward_weight * 10 * 3.6));
 
-                        auto tile_line = coordinatesToTileLine(a, b, tile_bbox);
-                        if (!tile_line.empty())
+                        const tile::Point line[] = {segment.source, segment.target};
+                        tile_line.Clear();
+                        tile::clipLine(std::begin(line), std::end(line), tile_line);
+                        if (!tile_line.Empty())
                         {
-                            encode_tile_line(tile_line,
+                            encode_tile_line(edge.component.is_tiny,
                                              speed_kmh,
-                                             line_int_offsets[forward_weight],
-                                             forward_datasource,
-                                             name_offset,
-                                             start_x,
-                                             start_y);
+                                             segment.forward_weight_offset,
+                                             segment.forward_datasource,
+                                             segment.name_offset);
                         }
                     }
 
                     // Repeat the above for the coordinates reversed and using the `reverse`
                     // properties
-                    if (reverse_weight != 0 && edge.reverse_segment_id.enabled)
+                    if (segment.reverse_weight != 0 && edge.reverse_segment_id.enabled)
                     {
-                        std::int32_t start_x = 0;
-                        std::int32_t start_y = 0;
-
                         // Calculate the speed for this line
-                        std::uint32_t speed_kmh =
-                            static_cast<std::uint32_t>(round(length / reverse_weight * 10 * 3.6));
+                        std::uint32_t speed_kmh = static_cast<std::uint32_t>(
+                            round(segment.length / segment.reverse_weight * 10 * 3.6));
 
-                        auto tile_line = coordinatesToTileLine(b, a, tile_bbox);
-                        if (!tile_line.empty())
+                        const tile::Point line[] = {segment.target, segment.source};
+                        tile_line.Clear();
+                        tile::clipLine(std::begin(line), std::end(line), tile_line);
+                        if (!tile_line.Empty())
                         {
-                            encode_tile_line(tile_line,
+                            encode_tile_line(edge.component.is_tiny,
                                              speed_kmh,
-                                             line_int_offsets[reverse_weight],
-                                             reverse_datasource,
-                                             name_offset,
-                                             start_x,
-                                             start_y);
+                                             segment.reverse_weight_offset,
+                                             segment.reverse_datasource,
+                                             segment.name_offset);
                         }
                     }
                 }
@@ -841,7 +852,7 @@ Status TilePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
                 values_writer.add_string(util::vector_tile::VARIANT_TYPE_STRING,
                                          facade->GetDatasourceName(i));
             }
-            for (auto value : used_line_ints)
+            for (const auto value : line_int_values.Values())
             {
                 // Writing field type 4 == variant type
                 protozero::pbf_writer values_writer(line_layer_writer,
@@ -852,7 +863,7 @@ Status TilePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
                 values_writer.add_double(util::vector_tile::VARIANT_TYPE_DOUBLE, value / 10.);
             }
 
-            for (const auto &name : names)
+            for (const auto &name : name_values.Values())
             {
                 // Writing field type 4 == variant type
                 protozero::pbf_writer values_writer(line_layer_writer,
@@ -881,8 +892,8 @@ Status TilePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
                 int id = 1;
 
                 // Helper function to encode a new point feature on a vector tile.
-                const auto encode_tile_point = [&point_layer_writer, &used_point_ints, &id](
-                    const FixedPoint &tile_point, const TurnData &point_turn_data) {
+                const auto encode_tile_point = [&point_layer_writer, &point_int_values, &id](
+                    const tile::Point tile_point, const TurnData &point_turn_data) {
                     protozero::pbf_writer feature_writer(point_layer_writer,
                                                          util::vector_tile::FEATURE_TAG);
                     // Field 3 is the "geometry type" field.  Value 1 is "point"
@@ -901,7 +912,7 @@ Status TilePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
                         field.add_element(1); // "turn_angle" tag key offset
                         field.add_element(point_turn_data.turn_angle_offset);
                         field.add_element(2); // "cost" tag key offset
-                        field.add_element(used_point_ints.size() + point_turn_data.weight_offset);
+                        field.add_element(point_int_values.Size() + point_turn_data.weight_offset);
                     }
                     {
                         // Add the geometry as the last field in this feature
@@ -914,8 +925,11 @@ Status TilePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
                 // Loop over all the turns we found and add them as features to the layer
                 for (const auto &turndata : all_turn_data)
                 {
-                    const auto tile_point = coordinatesToTilePoint(turndata.coordinate, tile_bbox);
-                    if (!boost::geometry::within(point_t(tile_point.x, tile_point.y), clip_box))
+                    const auto tile_point = coordinatesToTilePoint(turndata.coordinate, projection);
+                    if (tile_point.x <= -util::vector_tile::BUFFER ||
+                        tile_point.y <= -util::vector_tile::BUFFER ||
+                        tile_point.x >= util::vector_tile::EXTENT + util::vector_tile::BUFFER ||
+                        tile_point.y >= util::vector_tile::EXTENT + util::vector_tile::BUFFER)
                     {
                         continue;
                     }
@@ -930,13 +944,13 @@ Status TilePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
             point_layer_writer.add_string(util::vector_tile::KEY_TAG, "cost");
 
             // Now, save the lists of integers and floats that our features refer to.
-            for (const auto &value : used_point_ints)
+            for (const auto value : point_int_values.Values())
             {
                 protozero::pbf_writer values_writer(point_layer_writer,
                                                     util::vector_tile::VARIANT_TAG);
                 values_writer.add_sint64(util::vector_tile::VARIANT_TYPE_SINT64, value);
             }
-            for (const auto &value : used_point_floats)
+            for (const auto value : point_float_values.Values())
             {
                 protozero::pbf_writer values_writer(point_layer_writer,
                                                     util::vector_tile::VARIANT_TAG);
@@ -947,6 +961,11 @@ Status TilePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
     // protozero serializes data during object destructors, so once the scope closes,
     // our result buffer will have all the tile data encoded into it.
 
+    if (tile_cache)
+    {
+        tile_cache->Insert(parameters.z, parameters.x, parameters.y, pbf_buffer);
+    }
+
     return Status::Ok;
 }
 }
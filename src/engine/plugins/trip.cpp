@@ -4,8 +4,9 @@
 
 #include "engine/api/trip_api.hpp"
 #include "engine/api/trip_parameters.hpp"
-#include "engine/trip/trip_brute_force.hpp"
 #include "engine/trip/trip_farthest_insertion.hpp"
+#include "engine/trip/trip_held_karp.hpp"
+#include "engine/trip/trip_local_search.hpp"
 #include "engine/trip/trip_nearest_neighbour.hpp"
 #include "util/dist_table_wrapper.hpp" // to access the dist table more easily
 #include "util/json_container.hpp"
@@ -13,10 +14,15 @@
 
 #include <boost/assert.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <iterator>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <utility>
 #include <vector>
@@ -114,6 +120,58 @@ SCC_Component SplitUnaccessibleLocations(const std::size_t number_of_locations,
     return SCC_Component(std::move(components), std::move(range));
 }
 
+// copies the durations between the locations of a component into a contiguous table of its own,
+// location i of the new table is the i-th location of the component
+util::DistTableWrapper<EdgeWeight>
+SliceComponentTable(const std::vector<NodeID>::const_iterator component_begin,
+                    const std::vector<NodeID>::const_iterator component_end,
+                    const util::DistTableWrapper<EdgeWeight> &result_table)
+{
+    const std::size_t component_size = std::distance(component_begin, component_end);
+    std::vector<EdgeWeight> component_table;
+    component_table.reserve(component_size * component_size);
+    for (auto from = component_begin; from != component_end; ++from)
+    {
+        for (auto to = component_begin; to != component_end; ++to)
+        {
+            component_table.push_back(result_table(*from, *to));
+        }
+    }
+    return util::DistTableWrapper<EdgeWeight>(std::move(component_table), component_size);
+}
+
+// solves small components exactly and approximates larger ones, optionally improving the
+// approximation until the deadline
+template <typename NodeIDIterator>
+std::vector<NodeID> ComputeTrip(const NodeIDIterator component_begin,
+                                const NodeIDIterator component_end,
+                                const std::size_t number_of_locations,
+                                const util::DistTableWrapper<EdgeWeight> &result_table,
+                                const bool improve,
+                                const std::chrono::steady_clock::time_point deadline)
+{
+    const std::size_t component_size = std::distance(component_begin, component_end);
+    BOOST_ASSERT_MSG(component_size > 0, "invalid component size");
+
+    if (component_size == 1)
+    {
+        return std::vector<NodeID>(component_begin, component_end);
+    }
+    if (component_size <= trip::HELD_KARP_MAX_LOCATIONS)
+    {
+        return trip::HeldKarpTrip(
+            component_begin, component_end, number_of_locations, result_table);
+    }
+
+    auto trip = trip::FarthestInsertionTrip(
+        component_begin, component_end, number_of_locations, result_table);
+    if (improve)
+    {
+        trip::ImproveTrip(trip, result_table, deadline);
+    }
+    return trip;
+}
+
 InternalRouteResult TripPlugin::ComputeRoute(const datafacade::BaseDataFacade &facade,
                                              const std::vector<PhantomNode> &snapped_phantoms,
                                              const std::vector<NodeID> &trip) const
@@ -135,7 +193,8 @@ InternalRouteResult TripPlugin::ComputeRoute(const datafacade::BaseDataFacade &f
     }
     BOOST_ASSERT(min_route.segment_end_coordinates.size() == trip.size());
 
-    shortest_path(facade, min_route.segment_end_coordinates, {false}, min_route);
+    shortest_path(
+        facade, min_route.segment_end_coordinates, boost::optional<bool>(false), min_route);
 
     BOOST_ASSERT_MSG(min_route.shortest_path_length < INVALID_EDGE_WEIGHT, "unroutable route");
     return min_route;
@@ -159,6 +218,7 @@ Status TripPlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
         return Error("InvalidValue", "Invalid coordinate value.", json_result);
     }
 
+    auto phase_start = std::chrono::steady_clock::now();
     auto phantom_node_pairs = GetPhantomNodes(*facade, parameters);
     if (phantom_node_pairs.size() != parameters.coordinates.size())
     {
@@ -170,59 +230,70 @@ Status TripPlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
     BOOST_ASSERT(phantom_node_pairs.size() == parameters.coordinates.size());
 
     auto snapped_phantoms = SnapPhantomNodes(phantom_node_pairs);
+    phase_start = RecordPhase(QueryType::Trip, QueryPhase::PhantomLookup, phase_start);
 
     const auto number_of_locations = snapped_phantoms.size();
 
     // compute the duration table of all phantom nodes
     const auto result_table = util::DistTableWrapper<EdgeWeight>(
-        duration_table(*facade, snapped_phantoms, {}, {}), number_of_locations);
+        duration_table(
+            *facade, snapped_phantoms, std::vector<std::size_t>(), std::vector<std::size_t>()),
+        number_of_locations);
 
     if (result_table.size() == 0)
     {
         return Status::Error;
     }
 
-    const constexpr std::size_t BF_MAX_FEASABLE = 10;
     BOOST_ASSERT_MSG(result_table.size() == number_of_locations * number_of_locations,
                      "Distance Table has wrong size");
 
     // get scc components
     SCC_Component scc = SplitUnaccessibleLocations(number_of_locations, result_table);
 
-    std::vector<std::vector<NodeID>> trips;
-    trips.reserve(scc.GetNumberOfComponents());
-    // run Trip computation for every SCC
-    for (std::size_t k = 0; k < scc.GetNumberOfComponents(); ++k)
-    {
-        const auto component_size = scc.range[k + 1] - scc.range[k];
-
-        BOOST_ASSERT_MSG(component_size > 0, "invalid component size");
-
-        std::vector<NodeID> scc_route;
-        auto route_begin = std::begin(scc.component) + scc.range[k];
-        auto route_end = std::begin(scc.component) + scc.range[k + 1];
-
-        if (component_size > 1)
-        {
-
-            if (component_size < BF_MAX_FEASABLE)
-            {
-                scc_route =
-                    trip::BruteForceTrip(route_begin, route_end, number_of_locations, result_table);
-            }
-            else
+    // run Trip computation for every SCC, the components of a split request are solved in
+    // parallel on their own compact tables
+    const auto improve = trip_improvement_time.count() > 0;
+    const auto improvement_deadline = std::chrono::steady_clock::now() + trip_improvement_time;
+    std::vector<std::vector<NodeID>> trips(scc.GetNumberOfComponents());
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, scc.GetNumberOfComponents(), 1),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            for (auto k = range.begin(); k != range.end(); ++k)
             {
-                scc_route = trip::FarthestInsertionTrip(
-                    route_begin, route_end, number_of_locations, result_table);
+                const auto component_begin = scc.component.cbegin() + scc.range[k];
+                const auto component_end = scc.component.cbegin() + scc.range[k + 1];
+                const std::size_t component_size = scc.range[k + 1] - scc.range[k];
+
+                if (component_size == 1 || component_size == number_of_locations)
+                {
+                    trips[k] = ComputeTrip(component_begin,
+                                           component_end,
+                                           number_of_locations,
+                                           result_table,
+                                           improve,
+                                           improvement_deadline);
+                    continue;
+                }
+
+                const auto component_table =
+                    SliceComponentTable(component_begin, component_end, result_table);
+                std::vector<NodeID> component_ids(component_size);
+                std::iota(component_ids.begin(), component_ids.end(), 0);
+                const auto component_trip = ComputeTrip(component_ids.begin(),
+                                                        component_ids.end(),
+                                                        component_size,
+                                                        component_table,
+                                                        improve,
+                                                        improvement_deadline);
+
+                trips[k].reserve(component_size);
+                for (const auto id : component_trip)
+                {
+                    trips[k].push_back(component_begin[id]);
+                }
             }
-        }
-        else
-        {
-            scc_route = std::vector<NodeID>(route_begin, route_end);
-        }
-
-        trips.push_back(std::move(scc_route));
-    }
+        });
     if (trips.empty())
     {
         return Error("NoTrips", "Cannot find trips", json_result);
@@ -235,9 +306,11 @@ Status TripPlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacad
     {
         routes.push_back(ComputeRoute(*facade, snapped_phantoms, trip));
     }
+    phase_start = RecordPhase(QueryType::Trip, QueryPhase::Search, phase_start);
 
     api::TripAPI trip_api{*facade, parameters};
     trip_api.MakeResponse(trips, routes, snapped_phantoms, json_result);
+    RecordPhase(QueryType::Trip, QueryPhase::Assembly, phase_start);
 
     return Status::Ok;
 }
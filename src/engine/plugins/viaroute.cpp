@@ -6,12 +6,16 @@
 #include "util/for_each_pair.hpp"
 #include "util/integer_range.hpp"
 #include "util/json_container.hpp"
+#include "util/speed_profile.hpp"
 
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
 
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -21,8 +25,82 @@ namespace engine
 namespace plugins
 {
 
-ViaRoutePlugin::ViaRoutePlugin(int max_locations_viaroute)
-    : shortest_path(heaps), alternative_path(heaps), direct_shortest_path(heaps),
+namespace
+{
+// Nodes of the segment of a phantom node in the direction it is traversed
+std::pair<NodeID, NodeID> phantomSegment(const datafacade::BaseDataFacade &facade,
+                                         const PhantomNode &phantom,
+                                         const bool traversed_in_reverse)
+{
+    const auto geometry = facade.GetUncompressedForwardGeometry(phantom.packed_geometry_id);
+    BOOST_ASSERT(phantom.fwd_segment_position + 1u < geometry.size());
+    const auto first = geometry[phantom.fwd_segment_position];
+    const auto second = geometry[phantom.fwd_segment_position + 1];
+    return traversed_in_reverse ? std::make_pair(second, first) : std::make_pair(first, second);
+}
+
+// Re-times the legs of the route with the speed profiles of the segments at the time they are
+// reached when leaving at the departure time. The path itself is the one of the static weights.
+// The phantom weights are scaled like the segments they lie on, so that the legs assemble to
+// consistent durations.
+void applySpeedProfiles(const datafacade::BaseDataFacade &facade,
+                        const std::uint64_t departure_time,
+                        InternalRouteResult &raw_route)
+{
+    // weights are in deciseconds
+    std::int64_t elapsed = 0;
+    const auto factor_of = [&](const NodeID from, const NodeID to) {
+        const auto profile = facade.GetSpeedProfile(from, to);
+        if (profile.empty())
+            return util::SPEED_PROFILE_STATIC_FACTOR;
+        return profile[util::getSpeedProfileSlot(departure_time + elapsed / 10)];
+    };
+
+    for (const auto leg : util::irange<std::size_t>(0UL, raw_route.unpacked_path_segments.size()))
+    {
+        auto &phantoms = raw_route.segment_end_coordinates[leg];
+        auto &path = raw_route.unpacked_path_segments[leg];
+        const bool source_traversed_in_reverse = raw_route.source_traversed_in_reverse[leg];
+        const bool target_traversed_in_reverse = raw_route.target_traversed_in_reverse[leg];
+        auto &source_weight = source_traversed_in_reverse ? phantoms.source_phantom.reverse_weight
+                                                          : phantoms.source_phantom.forward_weight;
+        auto &target_weight = target_traversed_in_reverse ? phantoms.target_phantom.reverse_weight
+                                                          : phantoms.target_phantom.forward_weight;
+
+        const auto source_segment =
+            phantomSegment(facade, phantoms.source_phantom, source_traversed_in_reverse);
+        const auto source_factor = factor_of(source_segment.first, source_segment.second);
+        source_weight = util::applySpeedProfileFactor(source_weight, source_factor);
+
+        if (path.empty())
+        {
+            // source and target lie on the same segment
+            target_weight = util::applySpeedProfileFactor(target_weight, source_factor);
+            elapsed += target_weight - source_weight;
+            continue;
+        }
+
+        auto from = source_segment.first;
+        for (auto &path_data : path)
+        {
+            path_data.duration_until_turn = util::applySpeedProfileFactor(
+                path_data.duration_until_turn, factor_of(from, path_data.turn_via_node));
+            elapsed += path_data.duration_until_turn;
+            from = path_data.turn_via_node;
+        }
+
+        const auto target_segment =
+            phantomSegment(facade, phantoms.target_phantom, target_traversed_in_reverse);
+        target_weight = util::applySpeedProfileFactor(
+            target_weight, factor_of(target_segment.first, target_segment.second));
+        elapsed += target_weight;
+    }
+}
+}
+
+ViaRoutePlugin::ViaRoutePlugin(int max_locations_viaroute, int parallel_search_distance)
+    : shortest_path(heaps, parallel_search_distance), alternative_path(heaps),
+      direct_shortest_path(heaps, parallel_search_distance), multi_level_path(heaps),
       max_locations_viaroute(max_locations_viaroute)
 {
 }
@@ -30,9 +108,38 @@ ViaRoutePlugin::ViaRoutePlugin(int max_locations_viaroute)
 Status ViaRoutePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
                                      const api::RouteParameters &route_parameters,
                                      util::json::Object &json_result) const
+{
+    return HandleRouteRequest(facade, route_parameters, json_result);
+}
+
+Status ViaRoutePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
+                                     const api::RouteParameters &route_parameters,
+                                     std::string &pbf_result) const
+{
+    return HandleRouteRequest(facade, route_parameters, pbf_result);
+}
+
+template <typename ResultT>
+Status
+ViaRoutePlugin::HandleRouteRequest(const std::shared_ptr<datafacade::BaseDataFacade> facade,
+                                   const api::RouteParameters &route_parameters,
+                                   ResultT &result) const
 {
     BOOST_ASSERT(route_parameters.IsValid());
 
+    auto *const route_cache = facade->GetRouteCache();
+    std::string route_cache_key;
+    if (route_cache)
+    {
+        route_cache_key = RouteCache::MakeKey(route_parameters);
+        const bool cached = route_cache->Find(route_cache_key, result);
+        QueryMetrics::GetInstance().RecordRouteCacheLookup(cached);
+        if (cached)
+        {
+            return Status::Ok;
+        }
+    }
+
     if (max_locations_viaroute > 0 &&
         (static_cast<int>(route_parameters.coordinates.size()) > max_locations_viaroute))
     {
@@ -40,25 +147,27 @@ Status ViaRoutePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataF
                      "Number of entries " + std::to_string(route_parameters.coordinates.size()) +
                          " is higher than current maximum (" +
                          std::to_string(max_locations_viaroute) + ")",
-                     json_result);
+                     result);
     }
 
     if (!CheckAllCoordinates(route_parameters.coordinates))
     {
-        return Error("InvalidValue", "Invalid coordinate value.", json_result);
+        return Error("InvalidValue", "Invalid coordinate value.", result);
     }
 
+    auto phase_start = std::chrono::steady_clock::now();
     auto phantom_node_pairs = GetPhantomNodes(*facade, route_parameters);
     if (phantom_node_pairs.size() != route_parameters.coordinates.size())
     {
         return Error("NoSegment",
                      std::string("Could not find a matching segment for coordinate ") +
                          std::to_string(phantom_node_pairs.size()),
-                     json_result);
+                     result);
     }
     BOOST_ASSERT(phantom_node_pairs.size() == route_parameters.coordinates.size());
 
     auto snapped_phantoms = SnapPhantomNodes(phantom_node_pairs);
+    phase_start = RecordPhase(QueryType::Route, QueryPhase::PhantomLookup, phase_start);
 
     const bool continue_straight_at_waypoint = route_parameters.continue_straight
                                                    ? *route_parameters.continue_straight
@@ -84,9 +193,19 @@ Status ViaRoutePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataF
     };
     util::for_each_pair(snapped_phantoms, build_phantom_pairs);
 
-    if (1 == raw_route.segment_end_coordinates.size())
+    // the overlay graph is only loaded for the MLD algorithm, which finds no alternatives
+    if (facade->GetMultiLevelGraph())
+    {
+        multi_level_path(*facade,
+                         raw_route.segment_end_coordinates,
+                         route_parameters.continue_straight,
+                         raw_route);
+    }
+    else if (1 == raw_route.segment_end_coordinates.size())
     {
-        if (route_parameters.alternatives && facade->GetCoreSize() == 0)
+        // alternatives share the phantom nodes of the route, which are re-timed along it
+        if (route_parameters.alternatives && facade->GetCoreSize() == 0 &&
+            !route_parameters.departure_time)
         {
             alternative_path(*facade, raw_route.segment_end_coordinates.front(), raw_route);
         }
@@ -103,12 +222,25 @@ Status ViaRoutePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataF
                       raw_route);
     }
 
+    phase_start = RecordPhase(QueryType::Route, QueryPhase::Search, phase_start);
+
     // we can only know this after the fact, different SCC ids still
     // allow for connection in one direction.
     if (raw_route.is_valid())
     {
+        if (route_parameters.departure_time)
+        {
+            applySpeedProfiles(*facade, *route_parameters.departure_time, raw_route);
+        }
+
         api::RouteAPI route_api{*facade, route_parameters};
-        route_api.MakeResponse(raw_route, json_result);
+        route_api.MakeResponse(raw_route, result);
+        RecordPhase(QueryType::Route, QueryPhase::Assembly, phase_start);
+
+        if (route_cache)
+        {
+            route_cache->Insert(route_cache_key, result);
+        }
     }
     else
     {
@@ -121,11 +253,11 @@ Status ViaRoutePlugin::HandleRequest(const std::shared_ptr<datafacade::BaseDataF
 
         if (not_in_same_component)
         {
-            return Error("NoRoute", "Impossible route between points", json_result);
+            return Error("NoRoute", "Impossible route between points", result);
         }
         else
         {
-            return Error("NoRoute", "No route found between points", json_result);
+            return Error("NoRoute", "No route found between points", result);
         }
     }
 
@@ -1,90 +1,114 @@
 #include "engine/polyline_compressor.hpp"
 
-#include <algorithm>
 #include <boost/assert.hpp>
+
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
-#include <cstdlib>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
 
 namespace osrm
 {
 namespace engine
 {
-namespace detail // anonymous to keep TU local
+namespace
 {
+// a 32 bit number is encoded in at most 7 chunks of 5 bits
+const constexpr std::size_t MAX_ENCODED_NUMBER_SIZE = 7;
 
-std::string encode(int number_to_encode)
+// Writes the number as zig-zag encoded chunks of 5 bits and returns the end of the output.
+inline char *encodeNumber(const std::int32_t number, char *output)
 {
-    std::string output;
-    while (number_to_encode >= 0x20)
+    // the sign moves into the lowest bit, so small negative numbers stay short
+    std::uint32_t value =
+        (static_cast<std::uint32_t>(number) << 1) ^ static_cast<std::uint32_t>(number >> 31);
+    while (value >= 0x20)
     {
-        const int next_value = (0x20 | (number_to_encode & 0x1f)) + 63;
-        output += static_cast<char>(next_value);
-        number_to_encode >>= 5;
+        *output++ = static_cast<char>((0x20 | (value & 0x1f)) + 63);
+        value >>= 5;
     }
-
-    number_to_encode += 63;
-    output += static_cast<char>(number_to_encode);
+    *output++ = static_cast<char>(value + 63);
     return output;
 }
 
-std::string encode(std::vector<int> &numbers)
+// Reads the next number, the polyline has to continue at index.
+inline std::int32_t decodeNumber(const std::string &polyline, std::size_t &index)
 {
-    std::string output;
-    for (auto &number : numbers)
+    if (index >= polyline.size())
     {
-        bool isNegative = number < 0;
+        throw std::out_of_range("Polyline ends within a coordinate");
+    }
 
-        if (isNegative)
+    std::uint32_t result = 0;
+    unsigned shift = 0;
+    int chunk;
+    do
+    {
+        chunk = polyline[index++] - 63;
+        if (shift < 32)
         {
-            const unsigned binary = std::llabs(number);
-            const unsigned twos = (~binary) + 1u;
-            number = twos;
+            result |= static_cast<std::uint32_t>(chunk & 0x1f) << shift;
         }
+        shift += 5;
+    } while (chunk >= 0x20 && index < polyline.size());
 
-        number <<= 1u;
+    const auto number = static_cast<std::int32_t>(result >> 1);
+    return (result & 1) != 0 ? ~number : number;
+}
+}
 
-        if (isNegative)
-        {
-            number = ~number;
-        }
+namespace detail
+{
+std::string encode(CoordVectorForwardIter begin,
+                   CoordVectorForwardIter end,
+                   const double coordinate_to_polyline)
+{
+    const auto size = std::distance(begin, end);
+    if (size == 0)
+    {
+        return {};
     }
-    for (const int number : numbers)
+    BOOST_ASSERT(size > 0);
+
+    // written in place into an upper bound of the size and trimmed afterwards
+    std::string output(static_cast<std::size_t>(size) * 2 * MAX_ENCODED_NUMBER_SIZE, '\0');
+    char *position = &output[0];
+    std::int32_t current_lat = 0;
+    std::int32_t current_lon = 0;
+    for (auto coordinate = begin; coordinate != end; ++coordinate)
     {
-        output += encode(number);
+        const std::int32_t lat =
+            std::round(static_cast<std::int32_t>(coordinate->lat) * coordinate_to_polyline);
+        const std::int32_t lon =
+            std::round(static_cast<std::int32_t>(coordinate->lon) * coordinate_to_polyline);
+        position = encodeNumber(lat - current_lat, position);
+        position = encodeNumber(lon - current_lon, position);
+        current_lat = lat;
+        current_lon = lon;
     }
+    output.resize(static_cast<std::size_t>(position - output.data()));
     return output;
 }
 }
 
 std::vector<util::Coordinate> decodePolyline(const std::string &geometry_string)
 {
+    // every number ends in a chunk without the continuation bit
+    const auto number_of_numbers =
+        std::count_if(geometry_string.begin(), geometry_string.end(), [](const char chunk) {
+            return chunk - 63 < 0x20;
+        });
     std::vector<util::Coordinate> new_coordinates;
-    int index = 0, len = geometry_string.size();
-    int lat = 0, lng = 0;
+    new_coordinates.reserve(number_of_numbers / 2);
 
-    while (index < len)
+    std::size_t index = 0;
+    std::int32_t lat = 0, lng = 0;
+    while (index < geometry_string.size())
     {
-        int b, shift = 0, result = 0;
-        do
-        {
-            b = geometry_string.at(index++) - 63;
-            result |= (b & 0x1f) << shift;
-            shift += 5;
-        } while (b >= 0x20 && index < len);
-        int dlat = ((result & 1) != 0 ? ~(result >> 1) : (result >> 1));
-        lat += dlat;
-
-        shift = 0;
-        result = 0;
-        do
-        {
-            b = geometry_string.at(index++) - 63;
-            result |= (b & 0x1f) << shift;
-            shift += 5;
-        } while (b >= 0x20 && index < len);
-        int dlng = ((result & 1) != 0 ? ~(result >> 1) : (result >> 1));
-        lng += dlng;
+        lat += decodeNumber(geometry_string, index);
+        lng += decodeNumber(geometry_string, index);
 
         util::Coordinate p;
         p.lat =
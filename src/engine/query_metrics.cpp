@@ -0,0 +1,113 @@
+#include "engine/query_metrics.hpp"
+
+#include <boost/assert.hpp>
+
+namespace osrm
+{
+namespace engine
+{
+
+constexpr std::size_t QueryMetrics::NUM_QUERY_TYPES;
+constexpr std::size_t QueryMetrics::NUM_QUERY_PHASES;
+
+QueryMetrics &QueryMetrics::GetInstance()
+{
+    static QueryMetrics instance;
+    return instance;
+}
+
+QueryMetrics::ThreadHistograms &QueryMetrics::LocalHistograms()
+{
+    // there is only one instance, so a single thread local pointer is enough
+    thread_local ThreadHistograms *local_histograms = nullptr;
+    if (!local_histograms)
+    {
+        std::lock_guard<std::mutex> lock(threads_mutex);
+        threads.push_back(std::make_unique<ThreadHistograms>());
+        local_histograms = threads.back().get();
+    }
+    return *local_histograms;
+}
+
+void QueryMetrics::Record(const QueryType type,
+                          const QueryPhase phase,
+                          const std::uint64_t microseconds)
+{
+    const auto type_index = static_cast<std::size_t>(type);
+    const auto phase_index = static_cast<std::size_t>(phase);
+    BOOST_ASSERT(type_index < NUM_QUERY_TYPES && phase_index < NUM_QUERY_PHASES);
+    LocalHistograms()[type_index][phase_index].Record(microseconds);
+    GetQueryProfile().microseconds[phase_index] += microseconds;
+}
+
+util::LatencySummary QueryMetrics::Collect(const QueryType type, const QueryPhase phase) const
+{
+    const auto type_index = static_cast<std::size_t>(type);
+    const auto phase_index = static_cast<std::size_t>(phase);
+    BOOST_ASSERT(type_index < NUM_QUERY_TYPES && phase_index < NUM_QUERY_PHASES);
+
+    util::LatencySummary summary;
+    std::lock_guard<std::mutex> lock(threads_mutex);
+    for (const auto &histograms : threads)
+    {
+        (*histograms)[type_index][phase_index].Collect(summary);
+    }
+    return summary;
+}
+
+const char *QueryMetrics::ToString(const QueryType type)
+{
+    switch (type)
+    {
+    case QueryType::Route:
+        return "route";
+    case QueryType::Table:
+        return "table";
+    case QueryType::Nearest:
+        return "nearest";
+    case QueryType::Trip:
+        return "trip";
+    case QueryType::Match:
+        return "match";
+    case QueryType::Tile:
+        return "tile";
+    case QueryType::Isochrone:
+        return "isochrone";
+    }
+    BOOST_ASSERT_MSG(false, "unknown query type");
+    return "";
+}
+
+const char *QueryMetrics::ToString(const QueryPhase phase)
+{
+    switch (phase)
+    {
+    case QueryPhase::Total:
+        return "total";
+    case QueryPhase::PhantomLookup:
+        return "phantom_lookup";
+    case QueryPhase::Search:
+        return "search";
+    case QueryPhase::Assembly:
+        return "assembly";
+    case QueryPhase::Serialization:
+        return "serialization";
+    }
+    BOOST_ASSERT_MSG(false, "unknown query phase");
+    return "";
+}
+
+bool QueryMetrics::FromString(const std::string &service, QueryType &type)
+{
+    for (std::size_t index = 0; index < NUM_QUERY_TYPES; ++index)
+    {
+        if (service == ToString(static_cast<QueryType>(index)))
+        {
+            type = static_cast<QueryType>(index);
+            return true;
+        }
+    }
+    return false;
+}
+}
+}
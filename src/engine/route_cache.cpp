@@ -0,0 +1,223 @@
+#include "engine/route_cache.hpp"
+
+#include <boost/assert.hpp>
+
+#include <type_traits>
+
+namespace osrm
+{
+namespace engine
+{
+
+namespace
+{
+template <typename T> void appendBytes(std::string &key, const T &value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "only plain values can be appended");
+    key.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// a rough estimate of the heap memory of a response, map nodes and strings included
+struct EstimateSize
+{
+    std::size_t operator()(const util::json::String &string) const
+    {
+        return sizeof(util::json::Value) + string.value.capacity();
+    }
+
+    std::size_t operator()(const util::json::Object &object) const
+    {
+        std::size_t size = sizeof(util::json::Value) + sizeof(util::json::Object);
+        for (const auto &value : object.values)
+        {
+            // the key and the map node with its two pointers
+            size += value.first.capacity() + 2 * sizeof(void *);
+            size += mapbox::util::apply_visitor(*this, value.second);
+        }
+        return size;
+    }
+
+    std::size_t operator()(const util::json::Array &array) const
+    {
+        std::size_t size = sizeof(util::json::Value) + sizeof(util::json::Array);
+        for (const auto &value : array.values)
+        {
+            size += mapbox::util::apply_visitor(*this, value);
+        }
+        return size;
+    }
+
+    template <typename T> std::size_t operator()(const T &) const
+    {
+        return sizeof(util::json::Value);
+    }
+};
+}
+
+RouteCache::RouteCache(const std::size_t memory_budget) : memory_budget(memory_budget)
+{
+    BOOST_ASSERT(memory_budget > 0);
+}
+
+std::string RouteCache::MakeKey(const api::RouteParameters &parameters)
+{
+    std::string key;
+    key.reserve(16 + parameters.metric.size() + parameters.coordinates.size() * 24);
+
+    appendBytes(key, parameters.output_format);
+    appendBytes(key, parameters.steps);
+    appendBytes(key, parameters.alternatives);
+    appendBytes(key, parameters.annotations);
+    appendBytes(key, parameters.annotations_type);
+    appendBytes(key, parameters.generate_hints);
+    appendBytes(key, parameters.geometries);
+    appendBytes(key, parameters.overview);
+    // unset, false or true
+    appendBytes(key,
+                static_cast<char>(parameters.continue_straight
+                                      ? (*parameters.continue_straight ? 2 : 1)
+                                      : 0));
+    appendBytes(key, parameters.metric.size());
+    key += parameters.metric;
+    appendBytes(key, static_cast<bool>(parameters.departure_time));
+    if (parameters.departure_time)
+    {
+        appendBytes(key, *parameters.departure_time);
+    }
+
+    appendBytes(key, parameters.coordinates.size());
+    for (std::size_t index = 0; index < parameters.coordinates.size(); ++index)
+    {
+        appendBytes(key, parameters.coordinates[index]);
+
+        const auto *hint = parameters.hints.empty() || !parameters.hints[index]
+                               ? nullptr
+                               : parameters.hints[index].get_ptr();
+        appendBytes(key, hint != nullptr);
+        if (hint)
+        {
+            appendBytes(key, *hint);
+        }
+
+        const auto *radius = parameters.radiuses.empty() || !parameters.radiuses[index]
+                                 ? nullptr
+                                 : parameters.radiuses[index].get_ptr();
+        appendBytes(key, radius != nullptr);
+        if (radius)
+        {
+            appendBytes(key, *radius);
+        }
+
+        const auto *bearing = parameters.bearings.empty() || !parameters.bearings[index]
+                                  ? nullptr
+                                  : parameters.bearings[index].get_ptr();
+        appendBytes(key, bearing != nullptr);
+        if (bearing)
+        {
+            appendBytes(key, *bearing);
+        }
+    }
+
+    return key;
+}
+
+bool RouteCache::Find(const std::string &key, util::json::Object &result)
+{
+    const auto response = FindResponse(key);
+    if (!response)
+    {
+        return false;
+    }
+    // responses are never changed once cached, so they can be copied without holding the lock
+    result = response->json;
+    return true;
+}
+
+bool RouteCache::Find(const std::string &key, std::string &result)
+{
+    const auto response = FindResponse(key);
+    if (!response)
+    {
+        return false;
+    }
+    result = response->pbf;
+    return true;
+}
+
+void RouteCache::Insert(const std::string &key, const util::json::Object &result)
+{
+    const auto response_size = sizeof(Response) + EstimateSize{}(result);
+    if (response_size > memory_budget / MAX_RESPONSE_FRACTION)
+    {
+        return;
+    }
+    auto response = std::make_shared<Response>();
+    response->json = result;
+    InsertResponse(key, std::move(response), response_size);
+}
+
+void RouteCache::Insert(const std::string &key, const std::string &result)
+{
+    const auto response_size = sizeof(Response) + result.size();
+    if (response_size > memory_budget / MAX_RESPONSE_FRACTION)
+    {
+        return;
+    }
+    auto response = std::make_shared<Response>();
+    response->pbf = result;
+    InsertResponse(key, std::move(response), response_size);
+}
+
+std::size_t RouteCache::GetMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return memory_usage;
+}
+
+std::size_t RouteCache::GetNumberOfEntries() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+std::shared_ptr<const RouteCache::Response> RouteCache::FindResponse(const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto position = positions.find(key);
+    if (position == positions.end())
+    {
+        return {};
+    }
+    // the response becomes the most recently used one
+    entries.splice(entries.begin(), entries, position->second);
+    return position->second->response;
+}
+
+void RouteCache::InsertResponse(const std::string &key,
+                                std::shared_ptr<const Response> response,
+                                const std::size_t response_size)
+{
+    // the key is held by the entry and the index
+    const auto size = response_size + 2 * key.capacity() + sizeof(Entry);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto position = positions.find(key);
+    if (position != positions.end())
+    {
+        // another query computed the same route in the meantime
+        entries.splice(entries.begin(), entries, position->second);
+        return;
+    }
+
+    while (!entries.empty() && memory_usage + size > memory_budget)
+    {
+        memory_usage -= entries.back().size;
+        positions.erase(entries.back().key);
+        entries.pop_back();
+    }
+    entries.push_front(Entry{key, std::move(response), size});
+    positions.emplace(key, entries.begin());
+    memory_usage += size;
+}
+}
+}
@@ -2,78 +2,227 @@
 
 #include "util/binary_heap.hpp"
 
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
 namespace osrm
 {
 namespace engine
 {
 
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::forward_heap_1;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::reverse_heap_1;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::forward_heap_2;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::reverse_heap_2;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::forward_heap_3;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::reverse_heap_3;
+const SearchEngineData::HeapPtr<SearchEngineData::QueryHeap,
+                                &SearchEngineData::HeapSet::forward_heap_1>
+    SearchEngineData::forward_heap_1{};
+const SearchEngineData::HeapPtr<SearchEngineData::QueryHeap,
+                                &SearchEngineData::HeapSet::reverse_heap_1>
+    SearchEngineData::reverse_heap_1{};
+const SearchEngineData::HeapPtr<SearchEngineData::QueryHeap,
+                                &SearchEngineData::HeapSet::forward_heap_2>
+    SearchEngineData::forward_heap_2{};
+const SearchEngineData::HeapPtr<SearchEngineData::QueryHeap,
+                                &SearchEngineData::HeapSet::reverse_heap_2>
+    SearchEngineData::reverse_heap_2{};
+const SearchEngineData::HeapPtr<SearchEngineData::QueryHeap,
+                                &SearchEngineData::HeapSet::forward_heap_3>
+    SearchEngineData::forward_heap_3{};
+const SearchEngineData::HeapPtr<SearchEngineData::QueryHeap,
+                                &SearchEngineData::HeapSet::reverse_heap_3>
+    SearchEngineData::reverse_heap_3{};
+const SearchEngineData::HeapPtr<SearchEngineData::ManyToManyQueryHeap,
+                                &SearchEngineData::HeapSet::many_to_many_heap>
+    SearchEngineData::many_to_many_heap{};
+const SearchEngineData::HeapPtr<SearchEngineData::MultiLevelQueryHeap,
+                                &SearchEngineData::HeapSet::multi_level_forward_heap>
+    SearchEngineData::multi_level_forward_heap{};
+const SearchEngineData::HeapPtr<SearchEngineData::MultiLevelQueryHeap,
+                                &SearchEngineData::HeapSet::multi_level_reverse_heap>
+    SearchEngineData::multi_level_reverse_heap{};
+const SearchEngineData::HeapPtr<SearchEngineData::MultiLevelQueryHeap,
+                                &SearchEngineData::HeapSet::multi_level_unpacking_heap>
+    SearchEngineData::multi_level_unpacking_heap{};
+const SearchEngineData::HeapPtr<map_matching::HiddenMarkovModel,
+                                &SearchEngineData::HeapSet::map_matching_model>
+    SearchEngineData::map_matching_model{};
 
-void SearchEngineData::InitializeOrClearFirstThreadLocalStorage(const unsigned number_of_nodes)
+namespace
+{
+// The idle heap sets and the number of queries that hold one
+struct HeapPool
+{
+    std::mutex mutex;
+    std::condition_variable released;
+    std::vector<std::unique_ptr<SearchEngineData::HeapSet>> idle;
+    std::size_t active_queries = 0;
+    std::size_t max_heap_sets = 0;
+};
+
+HeapPool &getHeapPool()
+{
+    static HeapPool pool;
+    return pool;
+}
+
+thread_local SearchEngineData::HeapSet *current_heap_set = nullptr;
+
+// The heaps of a set serve the queries of all datasets of the engine, a heap is replaced by a
+// larger one for a dataset with more nodes than it can hold
+template <typename HeapT>
+void initializeOrClearHeap(std::unique_ptr<HeapT> &heap, const unsigned number_of_nodes)
 {
-    if (forward_heap_1.get())
+    if (heap && heap->MaxID() >= number_of_nodes)
     {
-        forward_heap_1->Clear();
+        heap->Clear();
     }
     else
     {
-        forward_heap_1.reset(new QueryHeap(number_of_nodes));
+        heap.reset(new HeapT(number_of_nodes));
+    }
+}
+
+SearchEngineData::HeapSet &getLeasedHeapSet()
+{
+    const auto heap_set = SearchEngineData::GetHeapSet();
+    BOOST_ASSERT_MSG(heap_set, "the searches need a heap set lease");
+    return *heap_set;
+}
+}
+
+SearchEngineData::Lease::Lease(const Kind kind) : outer_heap_set(current_heap_set), kind(kind)
+{
+    if (kind == Task && outer_heap_set)
+    {
+        return;
     }
 
-    if (reverse_heap_1.get())
+    auto &pool = getHeapPool();
     {
-        reverse_heap_1->Clear();
+        std::unique_lock<std::mutex> lock(pool.mutex);
+        if (kind == Query)
+        {
+            pool.released.wait(lock, [this, &pool] {
+                return outer_heap_set || pool.max_heap_sets == 0 ||
+                       pool.active_queries < pool.max_heap_sets;
+            });
+            ++pool.active_queries;
+        }
+        if (!pool.idle.empty())
+        {
+            heap_set = std::move(pool.idle.back());
+            pool.idle.pop_back();
+        }
     }
-    else
+    // the heaps of a new set are allocated by the first search that needs them
+    if (!heap_set)
     {
-        reverse_heap_1.reset(new QueryHeap(number_of_nodes));
+        heap_set.reset(new HeapSet);
     }
+    current_heap_set = heap_set.get();
 }
 
-void SearchEngineData::InitializeOrClearSecondThreadLocalStorage(const unsigned number_of_nodes)
+SearchEngineData::Lease::~Lease()
 {
-    if (forward_heap_2.get())
-    {
-        forward_heap_2->Clear();
-    }
-    else
+    if (!heap_set)
     {
-        forward_heap_2.reset(new QueryHeap(number_of_nodes));
+        return;
     }
+    BOOST_ASSERT(current_heap_set == heap_set.get());
+    current_heap_set = outer_heap_set;
 
-    if (reverse_heap_2.get())
+    auto &pool = getHeapPool();
     {
-        reverse_heap_2->Clear();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (kind == Query)
+        {
+            --pool.active_queries;
+        }
+        if (pool.max_heap_sets == 0 || pool.idle.size() < pool.max_heap_sets)
+        {
+            pool.idle.push_back(std::move(heap_set));
+        }
     }
-    else
+    if (kind == Query)
     {
-        reverse_heap_2.reset(new QueryHeap(number_of_nodes));
+        pool.released.notify_one();
     }
+    // a set the pool did not take back is freed here, outside of the lock
 }
 
-void SearchEngineData::InitializeOrClearThirdThreadLocalStorage(const unsigned number_of_nodes)
+SearchEngineData::HeapSet *SearchEngineData::GetHeapSet() { return current_heap_set; }
+
+void SearchEngineData::SetMaxHeapSets(const std::size_t max_heap_sets)
 {
-    if (forward_heap_3.get())
-    {
-        forward_heap_3->Clear();
-    }
-    else
+    auto &pool = getHeapPool();
+    std::vector<std::unique_ptr<HeapSet>> dropped;
     {
-        forward_heap_3.reset(new QueryHeap(number_of_nodes));
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.max_heap_sets = max_heap_sets;
+        while (max_heap_sets > 0 && pool.idle.size() > max_heap_sets)
+        {
+            dropped.push_back(std::move(pool.idle.back()));
+            pool.idle.pop_back();
+        }
     }
+    pool.released.notify_all();
+}
 
-    if (reverse_heap_3.get())
+std::size_t SearchEngineData::GetNumberOfIdleHeapSets()
+{
+    auto &pool = getHeapPool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    return pool.idle.size();
+}
+
+void SearchEngineData::ClearIdleHeapSets()
+{
+    auto &pool = getHeapPool();
+    std::vector<std::unique_ptr<HeapSet>> dropped;
     {
-        reverse_heap_3->Clear();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        dropped.swap(pool.idle);
     }
-    else
+}
+
+void SearchEngineData::InitializeOrClearFirstThreadLocalStorage(const unsigned number_of_nodes)
+{
+    auto &heap_set = getLeasedHeapSet();
+    initializeOrClearHeap(heap_set.forward_heap_1, number_of_nodes);
+    initializeOrClearHeap(heap_set.reverse_heap_1, number_of_nodes);
+}
+
+void SearchEngineData::InitializeOrClearSecondThreadLocalStorage(const unsigned number_of_nodes)
+{
+    auto &heap_set = getLeasedHeapSet();
+    initializeOrClearHeap(heap_set.forward_heap_2, number_of_nodes);
+    initializeOrClearHeap(heap_set.reverse_heap_2, number_of_nodes);
+}
+
+void SearchEngineData::InitializeOrClearThirdThreadLocalStorage(const unsigned number_of_nodes)
+{
+    auto &heap_set = getLeasedHeapSet();
+    initializeOrClearHeap(heap_set.forward_heap_3, number_of_nodes);
+    initializeOrClearHeap(heap_set.reverse_heap_3, number_of_nodes);
+}
+
+void SearchEngineData::InitializeOrClearManyToManyThreadLocalStorage(const unsigned number_of_nodes)
+{
+    initializeOrClearHeap(getLeasedHeapSet().many_to_many_heap, number_of_nodes);
+}
+
+void SearchEngineData::InitializeOrClearMultiLevelThreadLocalStorage(const unsigned number_of_nodes)
+{
+    auto &heap_set = getLeasedHeapSet();
+    initializeOrClearHeap(heap_set.multi_level_forward_heap, number_of_nodes);
+    initializeOrClearHeap(heap_set.multi_level_reverse_heap, number_of_nodes);
+    initializeOrClearHeap(heap_set.multi_level_unpacking_heap, number_of_nodes);
+}
+
+void SearchEngineData::InitializeMapMatchingThreadLocalStorage()
+{
+    auto &heap_set = getLeasedHeapSet();
+    if (!heap_set.map_matching_model)
     {
-        reverse_heap_3.reset(new QueryHeap(number_of_nodes));
+        heap_set.map_matching_model.reset(new map_matching::HiddenMarkovModel());
     }
 }
 }
@@ -0,0 +1,93 @@
+#include "engine/sweep_order.hpp"
+#include "engine/datafacade/datafacade_base.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace osrm
+{
+namespace engine
+{
+
+std::vector<NodeID> computeSweepOrder(const datafacade::BaseDataFacade &facade)
+{
+    if (facade.GetCoreSize() > 0)
+    {
+        return {};
+    }
+
+    const auto number_of_nodes = facade.GetNumberOfNodes();
+    const NodeID UNKNOWN_DEPTH = SPECIAL_NODEID;
+    const NodeID IN_PROGRESS = SPECIAL_NODEID - 1;
+
+    // number of edges on the longest path from the node up to a node without higher neighbours
+    std::vector<NodeID> depths(number_of_nodes, UNKNOWN_DEPTH);
+    NodeID max_depth = 0;
+
+    // depth first search over the upward edges with the next edge of every node on the stack
+    std::vector<std::pair<NodeID, EdgeID>> stack;
+    for (NodeID root = 0; root < number_of_nodes; ++root)
+    {
+        if (depths[root] != UNKNOWN_DEPTH)
+        {
+            continue;
+        }
+
+        depths[root] = IN_PROGRESS;
+        stack.emplace_back(root, facade.BeginEdges(root));
+        while (!stack.empty())
+        {
+            const auto node = stack.back().first;
+            auto &edge = stack.back().second;
+            if (edge != facade.EndEdges(node))
+            {
+                const auto higher_node = facade.GetTarget(edge++);
+                if (depths[higher_node] == UNKNOWN_DEPTH)
+                {
+                    depths[higher_node] = IN_PROGRESS;
+                    stack.emplace_back(higher_node, facade.BeginEdges(higher_node));
+                }
+                else if (depths[higher_node] == IN_PROGRESS && higher_node != node)
+                {
+                    // edges in both directions, this is not a hierarchy
+                    return {};
+                }
+                continue;
+            }
+
+            NodeID depth = 0;
+            for (const auto upward_edge : facade.GetAdjacentEdgeRange(node))
+            {
+                const auto higher_node = facade.GetTarget(upward_edge);
+                if (higher_node != node)
+                {
+                    BOOST_ASSERT(depths[higher_node] < IN_PROGRESS);
+                    depth = std::max(depth, depths[higher_node] + 1);
+                }
+            }
+            depths[node] = depth;
+            max_depth = std::max(max_depth, depth);
+            stack.pop_back();
+        }
+    }
+
+    // counting sort by depth
+    std::vector<NodeID> offsets(max_depth + 2, 0);
+    for (const auto depth : depths)
+    {
+        ++offsets[depth + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    std::vector<NodeID> order(number_of_nodes);
+    for (NodeID node = 0; node < number_of_nodes; ++node)
+    {
+        order[offsets[depths[node]]++] = node;
+    }
+    return order;
+}
+}
+}
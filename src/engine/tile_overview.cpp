@@ -0,0 +1,189 @@
+#include "engine/tile_overview.hpp"
+#include "engine/datafacade/datafacade_base.hpp"
+#include "engine/douglas_peucker.hpp"
+
+#include "util/coordinate_calculation.hpp"
+#include "util/web_mercator.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace osrm
+{
+namespace engine
+{
+
+namespace
+{
+// the dataset is read in boxes of this level, so only the segments of one box are held at once
+const constexpr unsigned COLLECTION_ZOOM = 8;
+
+std::uint64_t makeKey(const unsigned x, const unsigned y)
+{
+    return (std::uint64_t{x} << 32) | std::uint64_t{y};
+}
+
+unsigned lonToTile(const util::FixedLongitude lon, const unsigned z)
+{
+    const auto tiles = 1u << z;
+    const auto x = static_cast<int>(
+        std::floor((static_cast<double>(util::toFloating(lon)) + 180.) / 360. * tiles));
+    return static_cast<unsigned>(std::max(0, std::min<int>(x, tiles - 1)));
+}
+
+unsigned latToTile(const util::FixedLatitude lat, const unsigned z)
+{
+    const auto tiles = 1u << z;
+    const auto y = static_cast<int>(std::floor(
+        (180. - util::web_mercator::latToY(util::toFloating(lat))) / 360. * tiles));
+    return static_cast<unsigned>(std::max(0, std::min<int>(y, tiles - 1)));
+}
+
+double metersPerPixel(const util::FixedLatitude lat, const unsigned z)
+{
+    const double circumference =
+        2 * M_PI * static_cast<double>(util::coordinate_calculation::detail::EARTH_RADIUS);
+    return circumference * std::cos(static_cast<double>(util::toFloating(lat)) * M_PI / 180.) /
+           (util::web_mercator::TILE_SIZE * (1u << z));
+}
+}
+
+TileOverview::TileOverview(const datafacade::BaseDataFacade &facade)
+    : levels(MAX_ZOOM - MIN_ZOOM + 1)
+{
+    const auto number_of_boxes = 1u << COLLECTION_ZOOM;
+    for (unsigned box_x = 0; box_x < number_of_boxes; ++box_x)
+    {
+        for (unsigned box_y = 0; box_y < number_of_boxes; ++box_y)
+        {
+            double min_lon, min_lat, max_lon, max_lat;
+            util::web_mercator::xyzToWGS84(
+                box_x, box_y, COLLECTION_ZOOM, min_lon, min_lat, max_lon, max_lat);
+            const util::Coordinate southwest{util::FloatLongitude{min_lon},
+                                             util::FloatLatitude{min_lat}};
+            const util::Coordinate northeast{util::FloatLongitude{max_lon},
+                                             util::FloatLatitude{max_lat}};
+
+            for (const auto &edge : facade.GetEdgesInBox(southwest, northeast))
+            {
+                // a geometry is collected with its first segment
+                if (edge.fwd_segment_position != 0)
+                {
+                    continue;
+                }
+
+                const auto node_ids = facade.GetUncompressedForwardGeometry(edge.packed_geometry_id);
+                BOOST_ASSERT(node_ids.size() >= 2);
+
+                // in the box that holds its first node, the boxes only share their borders
+                const auto start = facade.GetCoordinateOfNode(node_ids.front());
+                if (start.lon < southwest.lon || start.lon >= northeast.lon ||
+                    start.lat < southwest.lat || start.lat >= northeast.lat)
+                {
+                    continue;
+                }
+
+                Line line;
+                line.coordinates.reserve(node_ids.size());
+                for (const auto node_id : node_ids)
+                {
+                    line.coordinates.push_back(facade.GetCoordinateOfNode(node_id));
+                }
+
+                const auto lengths = facade.GetUncompressedForwardLengths(edge.packed_geometry_id);
+                line.length = 0;
+                for (std::size_t segment = 0; segment + 1 < line.coordinates.size(); ++segment)
+                {
+                    line.length +=
+                        !lengths.empty() && lengths[segment] != INVALID_SEGMENT_LENGTH
+                            ? lengths[segment] / 10.
+                            : util::coordinate_calculation::haversineDistance(
+                                  line.coordinates[segment], line.coordinates[segment + 1]);
+                }
+
+                const auto forward_weights =
+                    facade.GetUncompressedForwardWeights(edge.packed_geometry_id);
+                const auto reverse_weights =
+                    facade.GetUncompressedReverseWeights(edge.packed_geometry_id);
+                line.forward_weight =
+                    edge.forward_segment_id.enabled
+                        ? std::accumulate(forward_weights.begin(), forward_weights.end(), 0)
+                        : 0;
+                line.reverse_weight =
+                    edge.reverse_segment_id.enabled
+                        ? std::accumulate(reverse_weights.begin(), reverse_weights.end(), 0)
+                        : 0;
+                line.forward_datasource =
+                    facade.GetUncompressedForwardDatasources(edge.packed_geometry_id).front();
+                line.reverse_datasource =
+                    facade.GetUncompressedReverseDatasources(edge.packed_geometry_id).back();
+                line.name_id = edge.name_id;
+                line.is_tiny = edge.component.is_tiny;
+
+                AddLine(std::move(line));
+            }
+        }
+    }
+}
+
+void TileOverview::AddLine(Line line)
+{
+    // the lowest level the line is long enough for
+    const auto latitude = line.coordinates.front().lat;
+    auto min_zoom = MIN_ZOOM;
+    while (min_zoom <= MAX_ZOOM && line.length < MIN_PIXELS * metersPerPixel(latitude, min_zoom))
+    {
+        ++min_zoom;
+    }
+    if (min_zoom > MAX_ZOOM)
+    {
+        return;
+    }
+
+    line.coordinates = douglasPeucker(line.coordinates, MAX_ZOOM);
+
+    util::FixedLongitude min_lon = line.coordinates.front().lon, max_lon = min_lon;
+    util::FixedLatitude min_lat = line.coordinates.front().lat, max_lat = min_lat;
+    for (const auto &coordinate : line.coordinates)
+    {
+        min_lon = std::min(min_lon, coordinate.lon);
+        max_lon = std::max(max_lon, coordinate.lon);
+        min_lat = std::min(min_lat, coordinate.lat);
+        max_lat = std::max(max_lat, coordinate.lat);
+    }
+
+    const auto index = static_cast<std::uint32_t>(lines.size());
+    lines.push_back(std::move(line));
+
+    for (auto z = min_zoom; z <= MAX_ZOOM; ++z)
+    {
+        auto &tiles = levels[z - MIN_ZOOM];
+        // tile rows grow southwards
+        for (auto x = lonToTile(min_lon, z), max_x = lonToTile(max_lon, z); x <= max_x; ++x)
+        {
+            for (auto y = latToTile(max_lat, z), max_y = latToTile(min_lat, z); y <= max_y; ++y)
+            {
+                tiles[makeKey(x, y)].push_back(index);
+            }
+        }
+    }
+}
+
+const std::vector<std::uint32_t> &
+TileOverview::GetLines(const unsigned z, const unsigned x, const unsigned y) const
+{
+    static const std::vector<std::uint32_t> no_lines;
+    if (z < MIN_ZOOM || z > MAX_ZOOM)
+    {
+        return no_lines;
+    }
+
+    const auto &tiles = levels[z - MIN_ZOOM];
+    const auto lines_of_tile = tiles.find(makeKey(x, y));
+    return lines_of_tile == tiles.end() ? no_lines : lines_of_tile->second;
+}
+}
+}
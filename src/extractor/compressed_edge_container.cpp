@@ -1,12 +1,21 @@
 #include "extractor/compressed_edge_container.hpp"
+#include "util/coordinate_calculation.hpp"
 #include "util/simple_logger.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <limits>
+#include <numeric>
 #include <string>
+#include <utility>
 
 #include <iostream>
 
@@ -33,24 +42,30 @@ void CompressedEdgeContainer::IncreaseFreeList()
 
 bool CompressedEdgeContainer::HasEntryForID(const EdgeID edge_id) const
 {
+    if (m_renumbered)
+    {
+        return edge_id + 1 < m_segment_offsets.size() &&
+               m_segment_offsets[edge_id] != m_segment_offsets[edge_id + 1];
+    }
     auto iter = m_edge_id_to_list_index_map.find(edge_id);
     return iter != m_edge_id_to_list_index_map.end();
 }
 
 bool CompressedEdgeContainer::HasZippedEntryForForwardID(const EdgeID edge_id) const
 {
-    auto iter = m_forward_edge_id_to_zipped_index_map.find(edge_id);
-    return iter != m_forward_edge_id_to_zipped_index_map.end();
+    return edge_id < m_forward_zipped_index.size() &&
+           m_forward_zipped_index[edge_id] != SPECIAL_GEOMETRYID;
 }
 
 bool CompressedEdgeContainer::HasZippedEntryForReverseID(const EdgeID edge_id) const
 {
-    auto iter = m_reverse_edge_id_to_zipped_index_map.find(edge_id);
-    return iter != m_reverse_edge_id_to_zipped_index_map.end();
+    return edge_id < m_reverse_zipped_index.size() &&
+           m_reverse_zipped_index[edge_id] != SPECIAL_GEOMETRYID;
 }
 
 unsigned CompressedEdgeContainer::GetPositionForID(const EdgeID edge_id) const
 {
+    BOOST_ASSERT(!m_renumbered);
     auto map_iterator = m_edge_id_to_list_index_map.find(edge_id);
     BOOST_ASSERT(map_iterator != m_edge_id_to_list_index_map.end());
     BOOST_ASSERT(map_iterator->second < m_compressed_oneway_geometries.size());
@@ -59,18 +74,14 @@ unsigned CompressedEdgeContainer::GetPositionForID(const EdgeID edge_id) const
 
 unsigned CompressedEdgeContainer::GetZippedPositionForForwardID(const EdgeID edge_id) const
 {
-    auto map_iterator = m_forward_edge_id_to_zipped_index_map.find(edge_id);
-    BOOST_ASSERT(map_iterator != m_forward_edge_id_to_zipped_index_map.end());
-    BOOST_ASSERT(map_iterator->second < m_compressed_geometry_nodes.size());
-    return map_iterator->second;
+    BOOST_ASSERT(HasZippedEntryForForwardID(edge_id));
+    return m_forward_zipped_index[edge_id];
 }
 
 unsigned CompressedEdgeContainer::GetZippedPositionForReverseID(const EdgeID edge_id) const
 {
-    auto map_iterator = m_reverse_edge_id_to_zipped_index_map.find(edge_id);
-    BOOST_ASSERT(map_iterator != m_reverse_edge_id_to_zipped_index_map.end());
-    BOOST_ASSERT(map_iterator->second < m_compressed_geometry_nodes.size());
-    return map_iterator->second;
+    BOOST_ASSERT(HasZippedEntryForReverseID(edge_id));
+    return m_reverse_zipped_index[edge_id];
 }
 
 void CompressedEdgeContainer::SerializeInternalVector(const std::string &path) const
@@ -103,6 +114,46 @@ void CompressedEdgeContainer::SerializeInternalVector(const std::string &path) c
                               sizeof(EdgeWeight) * m_compressed_geometry_rev_weights.size());
 }
 
+void CompressedEdgeContainer::SerializeSegmentLengths(
+    const std::string &path, const std::vector<QueryNode> &internal_to_external_node_map) const
+{
+    // the lengths are indexed like the forward weights, the first node of a geometry has none
+    std::vector<SegmentLength> lengths(m_compressed_geometry_nodes.size(), INVALID_SEGMENT_LENGTH);
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, m_compressed_geometry_index.size()),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            for (auto geometry = range.begin(); geometry != range.end(); ++geometry)
+            {
+                const std::size_t begin = m_compressed_geometry_index[geometry];
+                const std::size_t end = geometry + 1 < m_compressed_geometry_index.size()
+                                            ? m_compressed_geometry_index[geometry + 1]
+                                            : m_compressed_geometry_nodes.size();
+                for (auto index = begin + 1; index < end; ++index)
+                {
+                    const auto &from =
+                        internal_to_external_node_map[m_compressed_geometry_nodes[index - 1]];
+                    const auto &to =
+                        internal_to_external_node_map[m_compressed_geometry_nodes[index]];
+                    const auto length =
+                        std::round(10 * util::coordinate_calculation::haversineDistance(
+                                            util::Coordinate{from.lon, from.lat},
+                                            util::Coordinate{to.lon, to.lat}));
+                    if (length < INVALID_SEGMENT_LENGTH)
+                    {
+                        lengths[index] = static_cast<SegmentLength>(length);
+                    }
+                }
+            }
+        });
+
+    boost::filesystem::ofstream lengths_out_stream(path, std::ios::binary);
+    const std::uint64_t number_of_lengths = lengths.size();
+    lengths_out_stream.write(reinterpret_cast<const char *>(&number_of_lengths),
+                             sizeof(number_of_lengths));
+    lengths_out_stream.write(reinterpret_cast<const char *>(lengths.data()),
+                             sizeof(SegmentLength) * lengths.size());
+}
+
 // Adds info for a compressed edge to the container.   edge_id_2
 // has been removed from the graph, so we have to save These edges/nodes
 // have already been trimmed from the graph, this function just stores
@@ -118,6 +169,7 @@ void CompressedEdgeContainer::CompressEdge(const EdgeID edge_id_1,
                                            const EdgeWeight weight1,
                                            const EdgeWeight weight2)
 {
+    BOOST_ASSERT(!m_renumbered);
     // remove super-trivial geometries
     BOOST_ASSERT(SPECIAL_EDGEID != edge_id_1);
     BOOST_ASSERT(SPECIAL_EDGEID != edge_id_2);
@@ -200,6 +252,7 @@ void CompressedEdgeContainer::AddUncompressedEdge(const EdgeID edge_id,
                                                   const NodeID target_node_id,
                                                   const EdgeWeight weight)
 {
+    BOOST_ASSERT(!m_renumbered);
     // remove super-trivial geometries
     BOOST_ASSERT(SPECIAL_EDGEID != edge_id);
     BOOST_ASSERT(SPECIAL_NODEID != target_node_id);
@@ -238,66 +291,162 @@ void CompressedEdgeContainer::AddUncompressedEdge(const EdgeID edge_id,
     }
 }
 
+void CompressedEdgeContainer::AddCompressedEdge(const EdgeID edge_id, OnewayEdgeBucket geometry)
+{
+    BOOST_ASSERT(!m_renumbered);
+    BOOST_ASSERT(SPECIAL_EDGEID != edge_id);
+    BOOST_ASSERT(!HasEntryForID(edge_id));
+    BOOST_ASSERT(geometry.size() > 1);
+
+    if (0 == m_free_list.size())
+    {
+        // make sure there is a place to put the entries
+        IncreaseFreeList();
+    }
+    BOOST_ASSERT(!m_free_list.empty());
+    const unsigned edge_bucket_id = m_free_list.back();
+    m_free_list.pop_back();
+    m_edge_id_to_list_index_map[edge_id] = edge_bucket_id;
+    m_compressed_oneway_geometries[edge_bucket_id] = std::move(geometry);
+}
+
+void CompressedEdgeContainer::RenumberEdges(const std::vector<EdgeID> &new_edge_ids)
+{
+    BOOST_ASSERT(!m_renumbered);
+    // the zipped geometries are added with the final edge ids
+    BOOST_ASSERT(m_compressed_geometry_index.empty());
+
+    // the bucket of every renumbered edge
+    std::vector<unsigned> buckets;
+    for (const auto &entry : m_edge_id_to_list_index_map)
+    {
+        BOOST_ASSERT(entry.first < new_edge_ids.size());
+        const auto new_edge_id = new_edge_ids[entry.first];
+        BOOST_ASSERT(new_edge_id != SPECIAL_EDGEID);
+        if (new_edge_id >= buckets.size())
+        {
+            buckets.resize(new_edge_id + 1, std::numeric_limits<unsigned>::max());
+        }
+        buckets[new_edge_id] = entry.second;
+    }
+
+    m_segment_offsets.resize(buckets.size() + 1);
+    m_segment_offsets[0] = 0;
+    std::transform(buckets.begin(),
+                   buckets.end(),
+                   m_segment_offsets.begin() + 1,
+                   [&](const unsigned bucket) -> unsigned {
+                       return bucket == std::numeric_limits<unsigned>::max()
+                                  ? 0
+                                  : m_compressed_oneway_geometries[bucket].size();
+                   });
+    std::partial_sum(
+        m_segment_offsets.begin(), m_segment_offsets.end(), m_segment_offsets.begin());
+
+    m_segments.resize(m_segment_offsets.back());
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, buckets.size()),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          for (auto edge_id = range.begin(); edge_id != range.end(); ++edge_id)
+                          {
+                              if (buckets[edge_id] == std::numeric_limits<unsigned>::max())
+                                  continue;
+                              const auto &bucket = m_compressed_oneway_geometries[buckets[edge_id]];
+                              std::copy(bucket.begin(),
+                                        bucket.end(),
+                                        m_segments.begin() + m_segment_offsets[edge_id]);
+                          }
+                      });
+
+    m_renumbered = true;
+    std::vector<OnewayEdgeBucket>().swap(m_compressed_oneway_geometries);
+    std::vector<unsigned>().swap(m_free_list);
+    std::unordered_map<EdgeID, unsigned>().swap(m_edge_id_to_list_index_map);
+}
+
 void CompressedEdgeContainer::InitializeBothwayVector()
 {
-    m_compressed_geometry_index.reserve(m_compressed_oneway_geometries.size());
-    m_compressed_geometry_nodes.reserve(m_compressed_oneway_geometries.size());
-    m_compressed_geometry_fwd_weights.reserve(m_compressed_oneway_geometries.size());
-    m_compressed_geometry_rev_weights.reserve(m_compressed_oneway_geometries.size());
+    // every geometry has one node more than the segments of either of its edges
+    const auto number_of_edges = m_renumbered ? m_segment_offsets.size() - 1 : 0;
+    const auto number_of_segments = m_renumbered ? m_segments.size() : 0;
+    m_compressed_geometry_index.reserve(number_of_edges / 2);
+    m_compressed_geometry_nodes.reserve(number_of_segments / 2 + number_of_edges / 2);
+    m_compressed_geometry_fwd_weights.reserve(number_of_segments / 2 + number_of_edges / 2);
+    m_compressed_geometry_rev_weights.reserve(number_of_segments / 2 + number_of_edges / 2);
+    m_forward_zipped_index.assign(number_of_edges, SPECIAL_GEOMETRYID);
+    m_reverse_zipped_index.assign(number_of_edges, SPECIAL_GEOMETRYID);
 }
 
 unsigned CompressedEdgeContainer::ZipEdges(const EdgeID f_edge_id, const EdgeID r_edge_id)
 {
-    const auto &forward_bucket = GetBucketReference(f_edge_id);
-    const auto &reverse_bucket = GetBucketReference(r_edge_id);
+    const auto forward_bucket = GetBucketReference(f_edge_id);
+    // the reverse edge traverses the geometry backwards
+    const auto reverse_bucket = GetBucketReference(r_edge_id).Reversed();
 
     BOOST_ASSERT(forward_bucket.size() == reverse_bucket.size());
 
     const unsigned zipped_geometry_id = m_compressed_geometry_index.size();
-    m_forward_edge_id_to_zipped_index_map[f_edge_id] = zipped_geometry_id;
-    m_reverse_edge_id_to_zipped_index_map[r_edge_id] = zipped_geometry_id;
+    for (const auto edge_id : {f_edge_id, r_edge_id})
+    {
+        if (edge_id >= m_forward_zipped_index.size())
+        {
+            m_forward_zipped_index.resize(edge_id + 1, SPECIAL_GEOMETRYID);
+            m_reverse_zipped_index.resize(edge_id + 1, SPECIAL_GEOMETRYID);
+        }
+    }
+    m_forward_zipped_index[f_edge_id] = zipped_geometry_id;
+    m_reverse_zipped_index[r_edge_id] = zipped_geometry_id;
 
     m_compressed_geometry_index.emplace_back(m_compressed_geometry_nodes.size());
 
-    const auto &first_node = reverse_bucket.back();
-
-    m_compressed_geometry_nodes.emplace_back(first_node.node_id);
+    // nodes:           r[n-1] f[0] .. f[n-1]
+    // forward weights: invalid f[0] .. f[n-1]
+    // reverse weights: r[n-1] .. r[0] invalid
+    m_compressed_geometry_nodes.emplace_back(reverse_bucket.front().node_id);
     m_compressed_geometry_fwd_weights.emplace_back(INVALID_EDGE_WEIGHT);
-    m_compressed_geometry_rev_weights.emplace_back(first_node.weight);
-
-    for (std::size_t i = 0; i < forward_bucket.size() - 1; ++i)
+    for (const auto &segment : forward_bucket)
     {
-        const auto &fwd_node = forward_bucket.at(i);
-        const auto &rev_node = reverse_bucket.at(reverse_bucket.size() - 2 - i);
-
-        BOOST_ASSERT(fwd_node.node_id == rev_node.node_id);
-
-        m_compressed_geometry_nodes.emplace_back(fwd_node.node_id);
-        m_compressed_geometry_fwd_weights.emplace_back(fwd_node.weight);
-        m_compressed_geometry_rev_weights.emplace_back(rev_node.weight);
+        m_compressed_geometry_nodes.emplace_back(segment.node_id);
+        m_compressed_geometry_fwd_weights.emplace_back(segment.weight);
+    }
+    for (const auto &segment : reverse_bucket)
+    {
+        m_compressed_geometry_rev_weights.emplace_back(segment.weight);
     }
-
-    const auto &last_node = forward_bucket.back();
-
-    m_compressed_geometry_nodes.emplace_back(last_node.node_id);
-    m_compressed_geometry_fwd_weights.emplace_back(last_node.weight);
     m_compressed_geometry_rev_weights.emplace_back(INVALID_EDGE_WEIGHT);
 
+    BOOST_ASSERT(std::equal(forward_bucket.begin(),
+                            forward_bucket.end() - 1,
+                            reverse_bucket.begin() + 1,
+                            [](const OnewayCompressedEdge &lhs, const OnewayCompressedEdge &rhs) {
+                                return lhs.node_id == rhs.node_id;
+                            }));
+
     return zipped_geometry_id;
 }
 
 void CompressedEdgeContainer::PrintStatistics() const
 {
-    const uint64_t compressed_edges = m_compressed_oneway_geometries.size();
-    BOOST_ASSERT(0 == compressed_edges % 2);
-    BOOST_ASSERT(m_compressed_oneway_geometries.size() + m_free_list.size() > 0);
-
+    uint64_t compressed_edges = 0;
     uint64_t compressed_geometries = 0;
     uint64_t longest_chain_length = 0;
-    for (const std::vector<OnewayCompressedEdge> &current_vector : m_compressed_oneway_geometries)
+    const auto count = [&](const std::size_t chain_length) {
+        compressed_edges += chain_length > 0;
+        compressed_geometries += chain_length;
+        longest_chain_length = std::max(longest_chain_length, (uint64_t)chain_length);
+    };
+    if (m_renumbered)
     {
-        compressed_geometries += current_vector.size();
-        longest_chain_length = std::max(longest_chain_length, (uint64_t)current_vector.size());
+        for (std::size_t edge_id = 0; edge_id + 1 < m_segment_offsets.size(); ++edge_id)
+        {
+            count(m_segment_offsets[edge_id + 1] - m_segment_offsets[edge_id]);
+        }
+    }
+    else
+    {
+        for (const auto &current_vector : m_compressed_oneway_geometries)
+        {
+            count(current_vector.size());
+        }
     }
 
     util::SimpleLogger().Write()
@@ -310,11 +459,17 @@ void CompressedEdgeContainer::PrintStatistics() const
         << (float)compressed_geometries / std::max((uint64_t)1, compressed_edges);
 }
 
-const CompressedEdgeContainer::OnewayEdgeBucket &
+CompressedEdgeContainer::OnewayEdgeView
 CompressedEdgeContainer::GetBucketReference(const EdgeID edge_id) const
 {
-    const unsigned index = m_edge_id_to_list_index_map.at(edge_id);
-    return m_compressed_oneway_geometries.at(index);
+    if (m_renumbered)
+    {
+        BOOST_ASSERT(HasEntryForID(edge_id));
+        return {m_segments.data() + m_segment_offsets[edge_id],
+                m_segments.data() + m_segment_offsets[edge_id + 1]};
+    }
+    const auto &bucket = m_compressed_oneway_geometries.at(m_edge_id_to_list_index_map.at(edge_id));
+    return {bucket.data(), bucket.data() + bucket.size()};
 }
 
 // Since all edges are technically in the compressed geometry container,
@@ -5,6 +5,7 @@
 #include "util/coordinate_calculation.hpp"
 #include "util/exception.hpp"
 #include "util/guidance/turn_bearing.hpp"
+#include "util/hilbert_value.hpp"
 #include "util/integer_range.hpp"
 #include "util/percent.hpp"
 #include "util/simple_logger.hpp"
@@ -19,14 +20,21 @@
 #include <boost/assert.hpp>
 #include <boost/numeric/conversion/cast.hpp>
 
+#include <tbb/pipeline.h>
+#include <tbb/task_scheduler_init.h>
+
 #include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <iomanip>
 #include <limits>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace osrm
 {
@@ -35,7 +43,7 @@ namespace extractor
 // Configuration to find representative candidate for turn angle calculations
 
 EdgeBasedGraphFactory::EdgeBasedGraphFactory(
-    std::shared_ptr<util::NodeBasedDynamicGraph> node_based_graph,
+    std::shared_ptr<util::NodeBasedStaticGraph> node_based_graph,
     CompressedEdgeContainer &compressed_edge_container,
     const std::unordered_set<NodeID> &barrier_nodes,
     const std::unordered_set<NodeID> &traffic_lights,
@@ -91,6 +99,12 @@ void EdgeBasedGraphFactory::GetEdgeBasedNodeWeights(std::vector<EdgeWeight> &out
     swap(m_edge_based_node_weights, output_node_weights);
 }
 
+void EdgeBasedGraphFactory::GetEdgeBasedNodeClasses(std::vector<ClassData> &output_node_classes)
+{
+    using std::swap; // Koenig swap
+    swap(m_edge_based_node_classes, output_node_classes);
+}
+
 EdgeID EdgeBasedGraphFactory::GetHighestEdgeID() { return m_max_edge_id; }
 
 void EdgeBasedGraphFactory::InsertEdgeBasedNode(const NodeID node_u, const NodeID node_v)
@@ -192,14 +206,17 @@ void EdgeBasedGraphFactory::Run(ScriptingEnvironment &scripting_environment,
                                 const std::string &turn_lane_data_filename,
                                 const std::string &edge_segment_lookup_filename,
                                 const std::string &edge_penalty_filename,
-                                const bool generate_edge_lookup)
+                                const bool generate_edge_lookup,
+                                const bool hilbert_node_order)
 {
     TIMER_START(renumber);
-    m_max_edge_id = RenumberEdges() - 1;
+    m_max_edge_id = RenumberEdges(hilbert_node_order) - 1;
     TIMER_STOP(renumber);
 
     TIMER_START(generate_nodes);
     m_edge_based_node_weights.reserve(m_max_edge_id + 1);
+    m_edge_based_node_classes.reserve(m_max_edge_id + 1);
+    m_edge_based_node_distances.reserve(m_max_edge_id + 1);
     GenerateEdgeExpandedNodes();
     TIMER_STOP(generate_nodes);
 
@@ -220,41 +237,93 @@ void EdgeBasedGraphFactory::Run(ScriptingEnvironment &scripting_environment,
 }
 
 /// Renumbers all _forward_ edges and sets the edge_id.
-/// A specific numbering is not important. Any unique ID will do.
+/// A specific numbering is not important. Any unique ID will do. With hilbert_order the ids
+/// follow a Hilbert curve through the centers of the edges, so that close edge-based nodes
+/// get close ids and are close in every array indexed by them.
 /// Returns the number of edge based nodes.
-unsigned EdgeBasedGraphFactory::RenumberEdges()
+unsigned EdgeBasedGraphFactory::RenumberEdges(const bool hilbert_order)
 {
-    // renumber edge based node of outgoing edges
-    unsigned numbered_edges_count = 0;
+    struct ForwardEdge
+    {
+        std::uint64_t hilbert_code;
+        NodeID node;
+        EdgeID edge;
+    };
+
+    // only number incoming edges
+    std::vector<ForwardEdge> forward_edges;
     for (const auto current_node : util::irange(0u, m_node_based_graph->GetNumberOfNodes()))
     {
         for (const auto current_edge : m_node_based_graph->GetAdjacentEdgeRange(current_node))
         {
-            EdgeData &edge_data = m_node_based_graph->GetEdgeData(current_edge);
-
-            // only number incoming edges
-            if (edge_data.reversed)
+            if (!m_node_based_graph->GetEdgeData(current_edge).reversed)
             {
-                continue;
+                forward_edges.push_back({0, current_node, current_edge});
             }
+        }
+    }
 
-            // oneway streets always require this self-loop. Other streets only if a u-turn plus
-            // traversal
-            // of the street takes longer than the loop
-            m_edge_based_node_weights.push_back(edge_data.distance +
-                                                profile_properties.u_turn_penalty);
-
-            BOOST_ASSERT(numbered_edges_count < m_node_based_graph->GetNumberOfEdges());
-            edge_data.edge_id = numbered_edges_count;
-            ++numbered_edges_count;
-
-            BOOST_ASSERT(SPECIAL_NODEID != edge_data.edge_id);
+    if (hilbert_order)
+    {
+        for (auto &forward_edge : forward_edges)
+        {
+            const auto &from = m_node_info_list[forward_edge.node];
+            const auto &to = m_node_info_list[m_node_based_graph->GetTarget(forward_edge.edge)];
+            forward_edge.hilbert_code =
+                util::hilbertCode(util::coordinate_calculation::centroid(
+                    util::Coordinate{from.lon, from.lat}, util::Coordinate{to.lon, to.lat}));
         }
+        // the edges break ties, so the numbering does not depend on the sort
+        std::sort(forward_edges.begin(),
+                  forward_edges.end(),
+                  [](const ForwardEdge &lhs, const ForwardEdge &rhs) {
+                      return std::tie(lhs.hilbert_code, lhs.edge) <
+                             std::tie(rhs.hilbert_code, rhs.edge);
+                  });
+    }
+
+    // renumber edge based node of outgoing edges
+    unsigned numbered_edges_count = 0;
+    for (const auto &forward_edge : forward_edges)
+    {
+        EdgeData &edge_data = m_node_based_graph->GetEdgeData(forward_edge.edge);
+
+        // oneway streets always require this self-loop. Other streets only if a u-turn plus
+        // traversal
+        // of the street takes longer than the loop
+        m_edge_based_node_weights.push_back(edge_data.distance +
+                                            profile_properties.u_turn_penalty);
+        m_edge_based_node_classes.push_back(edge_data.classes);
+        m_edge_based_node_distances.push_back(
+            GetGeometryDistance(forward_edge.node, forward_edge.edge));
+
+        BOOST_ASSERT(numbered_edges_count < m_node_based_graph->GetNumberOfEdges());
+        edge_data.edge_id = numbered_edges_count;
+        ++numbered_edges_count;
+
+        BOOST_ASSERT(SPECIAL_NODEID != edge_data.edge_id);
     }
 
     return numbered_edges_count;
 }
 
+/// Length of the compressed geometry of a node-based edge, it is the same in both directions.
+EdgeDistance EdgeBasedGraphFactory::GetGeometryDistance(const NodeID node_u,
+                                                        const EdgeID edge) const
+{
+    double distance = 0;
+    NodeID previous = node_u;
+    for (const auto &segment : m_compressed_edge_container.GetBucketReference(edge))
+    {
+        const auto &from = m_node_info_list[previous];
+        const auto &to = m_node_info_list[segment.node_id];
+        distance += util::coordinate_calculation::haversineDistance(
+            util::Coordinate{from.lon, from.lat}, util::Coordinate{to.lon, to.lat});
+        previous = segment.node_id;
+    }
+    return static_cast<EdgeDistance>(std::round(10 * distance));
+}
+
 /// Creates the nodes in the edge expanded graph from edges in the node-based graph.
 void EdgeBasedGraphFactory::GenerateEdgeExpandedNodes()
 {
@@ -303,7 +372,77 @@ void EdgeBasedGraphFactory::GenerateEdgeExpandedNodes()
                                  << " nodes in edge-expanded graph";
 }
 
+namespace
+{
+// Node-based nodes whose turns are generated by one task
+const constexpr std::uint32_t EDGE_EXPANSION_CHUNK_SIZE = 4096;
+
+// Returns the id of a class, numbering new classes in the order they are first seen
+template <typename MapT>
+typename MapT::mapped_type getClassID(MapT &class_hash, const typename MapT::key_type &class_)
+{
+    const auto itr = class_hash.find(class_);
+    if (itr != class_hash.end())
+    {
+        return itr->second;
+    }
+    const auto id = static_cast<typename MapT::mapped_type>(class_hash.size());
+    class_hash.emplace(class_, id);
+    return id;
+}
+
+// Appends the bytes of a lookup record
+template <typename T> void appendRecord(std::string &records, const T &record)
+{
+    records.append(reinterpret_cast<const char *>(&record), sizeof(record));
+}
+
+// The turns of a range of node-based nodes. Entry classes, bearing classes, lane data and combined
+// lane descriptions are numbered locally in the order they are first seen, the merge renumbers
+// them into the ids the serial generation would have assigned.
+struct EdgeExpansionChunk
+{
+    NodeID begin;
+    NodeID end;
+
+    // the edge ids are local to the chunk
+    std::vector<EdgeBasedEdge> edge_based_edges;
+    std::vector<OriginalEdgeData> original_edge_data;
+    std::string segment_lookup;
+    std::string penalty_lookup;
+
+    std::unordered_map<util::guidance::EntryClass, EntryClassID> entry_class_hash;
+    std::unordered_map<util::guidance::BearingClass, BearingClassID> bearing_class_hash;
+    // target node-based node and its local bearing class, in the order they were assigned
+    std::vector<std::pair<NodeID, BearingClassID>> bearing_classes;
+    guidance::LaneDataIdMap lane_data_map;
+    guidance::LaneDescriptionMap combined_lane_descriptions;
+
+    std::size_t node_based_edges = 0;
+    std::size_t lanes_handled = 0;
+    std::size_t lanes_called = 0;
+};
+
+// Inverts a local numbering into the classes in the order of their ids
+template <typename MapT>
+std::vector<typename MapT::key_type> getClassesByID(const MapT &class_hash)
+{
+    std::vector<typename MapT::key_type> classes(class_hash.size());
+    for (const auto &pair : class_hash)
+    {
+        BOOST_ASSERT(pair.second < classes.size());
+        classes[pair.second] = pair.first;
+    }
+    return classes;
+}
+} // namespace
+
 /// Actually it also generates OriginalEdgeData and serializes them...
+///
+/// The turns are generated by the node they pass, so the shape of an intersection is computed
+/// once for all roads entering it. The intersections of every node are analysed independently,
+/// so chunks of nodes are processed in parallel into buffers of their own. The chunks are merged in order, which makes the result
+/// independent of the number of threads.
 void EdgeBasedGraphFactory::GenerateEdgeExpandedEdges(
     ScriptingEnvironment &scripting_environment,
     const std::string &original_edge_data_filename,
@@ -341,238 +480,375 @@ void EdgeBasedGraphFactory::GenerateEdgeExpandedEdges(
     // Loop over all turns and generate new set of edges.
     // Three nested loop look super-linear, but we are dealing with a (kind of)
     // linear number of turns only.
-    util::Percent progress(m_node_based_graph->GetNumberOfNodes());
+    const auto number_of_nodes = m_node_based_graph->GetNumberOfNodes();
+    util::Percent progress(number_of_nodes);
     SuffixTable street_name_suffix_table(scripting_environment);
-    guidance::TurnAnalysis turn_analysis(*m_node_based_graph,
-                                         m_node_info_list,
-                                         *m_restriction_map,
-                                         m_barrier_nodes,
-                                         m_compressed_edge_container,
-                                         name_table,
-                                         street_name_suffix_table,
-                                         profile_properties);
+    const guidance::TurnAnalysis turn_analysis(*m_node_based_graph,
+                                               m_node_info_list,
+                                               *m_restriction_map,
+                                               m_barrier_nodes,
+                                               m_compressed_edge_container,
+                                               name_table,
+                                               street_name_suffix_table,
+                                               profile_properties);
 
     guidance::LaneDataIdMap lane_data_map;
-    guidance::lanes::TurnLaneHandler turn_lane_handler(*m_node_based_graph,
-                                                       turn_lane_offsets,
-                                                       turn_lane_masks,
-                                                       lane_description_map,
-                                                       turn_analysis,
-                                                       lane_data_map);
-
-    bearing_class_by_node_based_node.resize(m_node_based_graph->GetNumberOfNodes(),
+    // the lane descriptions are read concurrently, descriptions combined for sliproads are only
+    // added once all turns are generated
+    const auto number_of_lane_descriptions = lane_description_map.size();
+    std::vector<guidance::TurnLaneDescription> combined_lane_descriptions;
+    guidance::LaneDescriptionMap combined_lane_description_ids;
+    std::size_t lanes_handled = 0;
+    std::size_t lanes_called = 0;
+
+    bearing_class_by_node_based_node.resize(number_of_nodes,
                                             std::numeric_limits<std::uint32_t>::max());
 
-    for (const auto node_u : util::irange(0u, m_node_based_graph->GetNumberOfNodes()))
-    {
-        progress.PrintStatus(node_u);
-        for (const EdgeID edge_from_u : m_node_based_graph->GetAdjacentEdgeRange(node_u))
+    const auto generate_chunk = [&](EdgeExpansionChunk &chunk) {
+        guidance::lanes::TurnLaneHandler turn_lane_handler(*m_node_based_graph,
+                                                           turn_lane_offsets,
+                                                           turn_lane_masks,
+                                                           lane_description_map,
+                                                           chunk.combined_lane_descriptions,
+                                                           turn_analysis,
+                                                           chunk.lane_data_map);
+
+        // the roads entering a node and the nodes they come from
+        std::vector<std::pair<NodeID, EdgeID>> entry_edges;
+        for (const auto node_v : util::irange(chunk.begin, chunk.end))
         {
-            if (m_node_based_graph->GetEdgeData(edge_from_u).reversed)
+            // the graph stores every road in both directions, the roads entering node_v leave
+            // its neighbours
+            entry_edges.clear();
+            for (const EdgeID edge_from_v : m_node_based_graph->GetAdjacentEdgeRange(node_v))
+            {
+                const NodeID node_u = m_node_based_graph->GetTarget(edge_from_v);
+                const auto is_known_neighbour = std::any_of(
+                    entry_edges.begin(), entry_edges.end(), [node_u](const auto &entry_edge) {
+                        return entry_edge.first == node_u;
+                    });
+                if (is_known_neighbour)
+                {
+                    continue;
+                }
+                for (const EdgeID edge_from_u : m_node_based_graph->GetAdjacentEdgeRange(node_u))
+                {
+                    if (m_node_based_graph->GetTarget(edge_from_u) == node_v &&
+                        !m_node_based_graph->GetEdgeData(edge_from_u).reversed)
+                    {
+                        entry_edges.emplace_back(node_u, edge_from_u);
+                    }
+                }
+            }
+            if (entry_edges.empty())
             {
                 continue;
             }
 
-            const NodeID node_v = m_node_based_graph->GetTarget(edge_from_u);
-            ++node_based_edge_counter;
-            auto intersection = turn_analysis(node_u, edge_from_u);
-            BOOST_ASSERT(intersection.valid());
+            // the shape of the intersection is the same for all roads entering it
+            const auto shape =
+                turn_analysis.GetIntersectionGenerator().ComputeIntersectionShape(node_v);
 
-            intersection =
-                turn_lane_handler.assignTurnLanes(node_u, edge_from_u, std::move(intersection));
+            for (const auto &entry_edge : entry_edges)
+            {
+                const NodeID node_u = entry_edge.first;
+                const EdgeID edge_from_u = entry_edge.second;
+                ++chunk.node_based_edges;
+                auto intersection = turn_analysis(node_u, edge_from_u, shape);
+                BOOST_ASSERT(intersection.valid());
 
-            const auto possible_turns = turn_analysis.transformIntersectionIntoTurns(intersection);
+                intersection = turn_lane_handler.assignTurnLanes(
+                    node_u, edge_from_u, std::move(intersection));
 
-            // the entry class depends on the turn, so we have to classify the interesction for
-            // every edge
-            const auto turn_classification = classifyIntersection(intersection);
+                const auto possible_turns =
+                    turn_analysis.transformIntersectionIntoTurns(intersection);
 
-            const auto entry_class_id = [&](const util::guidance::EntryClass entry_class) {
-                if (0 == entry_class_hash.count(entry_class))
-                {
-                    const auto id = static_cast<std::uint16_t>(entry_class_hash.size());
-                    entry_class_hash[entry_class] = id;
-                    return id;
-                }
-                else
-                {
-                    return entry_class_hash.find(entry_class)->second;
-                }
-            }(turn_classification.first);
+                // the entry class depends on the turn, so we have to classify the interesction for
+                // every edge
+                const auto turn_classification = classifyIntersection(intersection);
 
-            const auto bearing_class_id = [&](const util::guidance::BearingClass bearing_class) {
-                if (0 == bearing_class_hash.count(bearing_class))
-                {
-                    const auto id = static_cast<std::uint32_t>(bearing_class_hash.size());
-                    bearing_class_hash[bearing_class] = id;
-                    return id;
-                }
-                else
+                const auto entry_class_id =
+                    getClassID(chunk.entry_class_hash, turn_classification.first);
+
+                const auto bearing_class_id =
+                    getClassID(chunk.bearing_class_hash, turn_classification.second);
+                chunk.bearing_classes.emplace_back(node_v, bearing_class_id);
+
+                for (const auto turn : possible_turns)
                 {
-                    return bearing_class_hash.find(bearing_class)->second;
-                }
-            }(turn_classification.second);
-            bearing_class_by_node_based_node[node_v] = bearing_class_id;
+                    // only add an edge if turn is not prohibited
+                    const EdgeData &edge_data1 = m_node_based_graph->GetEdgeData(edge_from_u);
+                    const EdgeData &edge_data2 = m_node_based_graph->GetEdgeData(turn.eid);
 
-            for (const auto turn : possible_turns)
-            {
-                // only add an edge if turn is not prohibited
-                const EdgeData &edge_data1 = m_node_based_graph->GetEdgeData(edge_from_u);
-                const EdgeData &edge_data2 = m_node_based_graph->GetEdgeData(turn.eid);
+                    BOOST_ASSERT(edge_data1.edge_id != edge_data2.edge_id);
+                    BOOST_ASSERT(!edge_data1.reversed);
+                    BOOST_ASSERT(!edge_data2.reversed);
 
-                BOOST_ASSERT(edge_data1.edge_id != edge_data2.edge_id);
-                BOOST_ASSERT(!edge_data1.reversed);
-                BOOST_ASSERT(!edge_data2.reversed);
+                    // the following is the core of the loop.
+                    unsigned distance = edge_data1.distance;
+                    if (m_traffic_lights.find(node_v) != m_traffic_lights.end())
+                    {
+                        distance += profile_properties.traffic_signal_penalty;
+                    }
 
-                // the following is the core of the loop.
-                unsigned distance = edge_data1.distance;
-                if (m_traffic_lights.find(node_v) != m_traffic_lights.end())
-                {
-                    distance += profile_properties.traffic_signal_penalty;
-                }
+                    const int32_t turn_penalty =
+                        scripting_environment.GetTurnPenalty(180. - turn.angle);
 
-                const int32_t turn_penalty =
-                    scripting_environment.GetTurnPenalty(180. - turn.angle);
+                    const auto turn_instruction = turn.instruction;
 
-                const auto turn_instruction = turn.instruction;
+                    if (turn_instruction.direction_modifier == guidance::DirectionModifier::UTurn)
+                    {
+                        distance += profile_properties.u_turn_penalty;
+                    }
 
-                if (turn_instruction.direction_modifier == guidance::DirectionModifier::UTurn)
-                {
-                    distance += profile_properties.u_turn_penalty;
-                }
+                    // don't add turn penalty if it is not an actual turn. This heuristic is
+                    // necessary since OSRM cannot handle looping roads/parallel roads
+                    if (turn_instruction.type != guidance::TurnType::NoTurn)
+                        distance += turn_penalty;
+
+                    const bool is_encoded_forwards =
+                        m_compressed_edge_container.HasZippedEntryForForwardID(edge_from_u);
+                    const bool is_encoded_backwards =
+                        m_compressed_edge_container.HasZippedEntryForReverseID(edge_from_u);
+                    BOOST_ASSERT(is_encoded_forwards || is_encoded_backwards);
+                    if (is_encoded_forwards)
+                    {
+                        chunk.original_edge_data.emplace_back(
+                            GeometryID{m_compressed_edge_container.GetZippedPositionForForwardID(
+                                           edge_from_u),
+                                       true},
+                            edge_data1.name_id,
+                            turn.lane_data_id,
+                            turn_instruction,
+                            entry_class_id,
+                            edge_data1.travel_mode,
+                            util::guidance::TurnBearing(intersection[0].bearing),
+                            util::guidance::TurnBearing(turn.bearing));
+                    }
+                    else if (is_encoded_backwards)
+                    {
+                        chunk.original_edge_data.emplace_back(
+                            GeometryID{m_compressed_edge_container.GetZippedPositionForReverseID(
+                                           edge_from_u),
+                                       false},
+                            edge_data1.name_id,
+                            turn.lane_data_id,
+                            turn_instruction,
+                            entry_class_id,
+                            edge_data1.travel_mode,
+                            util::guidance::TurnBearing(intersection[0].bearing),
+                            util::guidance::TurnBearing(turn.bearing));
+                    }
 
-                // don't add turn penalty if it is not an actual turn. This heuristic is necessary
-                // since OSRM cannot handle looping roads/parallel roads
-                if (turn_instruction.type != guidance::TurnType::NoTurn)
-                    distance += turn_penalty;
-
-                const bool is_encoded_forwards =
-                    m_compressed_edge_container.HasZippedEntryForForwardID(edge_from_u);
-                const bool is_encoded_backwards =
-                    m_compressed_edge_container.HasZippedEntryForReverseID(edge_from_u);
-                BOOST_ASSERT(is_encoded_forwards || is_encoded_backwards);
-                if (is_encoded_forwards)
-                {
-                    original_edge_data_vector.emplace_back(
-                        GeometryID{
-                            m_compressed_edge_container.GetZippedPositionForForwardID(edge_from_u),
-                            true},
-                        edge_data1.name_id,
-                        turn.lane_data_id,
-                        turn_instruction,
-                        entry_class_id,
-                        edge_data1.travel_mode,
-                        util::guidance::TurnBearing(intersection[0].bearing),
-                        util::guidance::TurnBearing(turn.bearing));
-                }
-                else if (is_encoded_backwards)
-                {
-                    original_edge_data_vector.emplace_back(
-                        GeometryID{
-                            m_compressed_edge_container.GetZippedPositionForReverseID(edge_from_u),
-                            false},
-                        edge_data1.name_id,
-                        turn.lane_data_id,
-                        turn_instruction,
-                        entry_class_id,
-                        edge_data1.travel_mode,
-                        util::guidance::TurnBearing(intersection[0].bearing),
-                        util::guidance::TurnBearing(turn.bearing));
+                    BOOST_ASSERT(SPECIAL_NODEID != edge_data1.edge_id);
+                    BOOST_ASSERT(SPECIAL_NODEID != edge_data2.edge_id);
+
+                    chunk.edge_based_edges.emplace_back(
+                        edge_data1.edge_id,
+                        edge_data2.edge_id,
+                        chunk.edge_based_edges.size(),
+                        distance,
+                        m_edge_based_node_distances[edge_data1.edge_id],
+                        true,
+                        false);
+
+                    // Here is where we write out the mapping between the edge-expanded edges, and
+                    // the node-based edges that are originally used to calculate the `distance`
+                    // for the edge-expanded edges.  About 40 lines back, there is:
+                    //
+                    //                 unsigned distance = edge_data1.distance;
+                    //
+                    // This tells us that the weight for an edge-expanded-edge is based on the
+                    // weight of the *source* node-based edge.  Therefore, we will look up the
+                    // individual segments of the source node-based edge, and write out a mapping
+                    // between those and the edge-based-edge ID.
+                    // External programs can then use this mapping to quickly perform
+                    // updates to the edge-expanded-edge based directly on its ID.
+                    if (generate_edge_lookup)
+                    {
+                        const auto node_based_edges =
+                            m_compressed_edge_container.GetBucketReference(edge_from_u);
+                        NodeID previous = node_u;
+
+                        const unsigned node_count = node_based_edges.size() + 1;
+                        const QueryNode &first_node = m_node_info_list[previous];
+
+                        lookup::SegmentHeaderBlock header = {node_count, first_node.node_id};
+
+                        appendRecord(chunk.segment_lookup, header);
+
+                        for (auto target_node : node_based_edges)
+                        {
+                            const QueryNode &from = m_node_info_list[previous];
+                            const QueryNode &to = m_node_info_list[target_node.node_id];
+                            const double segment_length =
+                                util::coordinate_calculation::greatCircleDistance(from, to);
+
+                            lookup::SegmentBlock nodeblock = {
+                                to.node_id, segment_length, target_node.weight};
+
+                            appendRecord(chunk.segment_lookup, nodeblock);
+                            previous = target_node.node_id;
+                        }
+
+                        // We also now write out the mapping between the edge-expanded edges and
+                        // the original nodes. Since each edge represents a possible maneuver,
+                        // external programs can use this to quickly perform updates to edge
+                        // weights in order to penalize certain turns.
+
+                        // If this edge is 'trivial' -- where the compressed edge corresponds
+                        // exactly to an original OSM segment -- we can pull the turn's preceding
+                        // node ID directly with `node_u`; otherwise, we need to look up the node
+                        // immediately preceding the turn from the compressed edge container.
+                        const bool isTrivial = m_compressed_edge_container.IsTrivial(edge_from_u);
+
+                        const auto &from_node =
+                            isTrivial ? m_node_info_list[node_u]
+                                      : m_node_info_list[m_compressed_edge_container
+                                                             .GetLastEdgeSourceID(edge_from_u)];
+                        const auto &via_node =
+                            m_node_info_list[m_compressed_edge_container.GetLastEdgeTargetID(
+                                edge_from_u)];
+                        const auto &to_node =
+                            m_node_info_list[m_compressed_edge_container.GetFirstEdgeTargetID(
+                                turn.eid)];
+
+                        const unsigned fixed_penalty = distance - edge_data1.distance;
+                        lookup::PenaltyBlock penaltyblock = {
+                            fixed_penalty, from_node.node_id, via_node.node_id, to_node.node_id};
+                        appendRecord(chunk.penalty_lookup, penaltyblock);
+                    }
                 }
+            }
+        }
 
-                ++original_edges_counter;
+        chunk.lanes_handled = turn_lane_handler.GetHandledCount();
+        chunk.lanes_called = turn_lane_handler.GetCalledCount();
+    };
 
-                if (original_edge_data_vector.size() > 1024 * 1024 * 10)
-                {
-                    FlushVectorToStream(edge_data_file, original_edge_data_vector);
-                }
+    const auto merge_chunk = [&](EdgeExpansionChunk &chunk) {
+        progress.PrintStatus(chunk.end - 1);
+        node_based_edge_counter += chunk.node_based_edges;
+        lanes_handled += chunk.lanes_handled;
+        lanes_called += chunk.lanes_called;
 
-                BOOST_ASSERT(SPECIAL_NODEID != edge_data1.edge_id);
-                BOOST_ASSERT(SPECIAL_NODEID != edge_data2.edge_id);
-
-                // NOTE: potential overflow here if we hit 2^32 routable edges
-                BOOST_ASSERT(m_edge_based_edge_list.size() <= std::numeric_limits<NodeID>::max());
-                m_edge_based_edge_list.emplace_back(edge_data1.edge_id,
-                                                    edge_data2.edge_id,
-                                                    m_edge_based_edge_list.size(),
-                                                    distance,
-                                                    true,
-                                                    false);
-
-                // Here is where we write out the mapping between the edge-expanded edges, and
-                // the node-based edges that are originally used to calculate the `distance`
-                // for the edge-expanded edges.  About 40 lines back, there is:
-                //
-                //                 unsigned distance = edge_data1.distance;
-                //
-                // This tells us that the weight for an edge-expanded-edge is based on the weight
-                // of the *source* node-based edge.  Therefore, we will look up the individual
-                // segments of the source node-based edge, and write out a mapping between
-                // those and the edge-based-edge ID.
-                // External programs can then use this mapping to quickly perform
-                // updates to the edge-expanded-edge based directly on its ID.
-                if (generate_edge_lookup)
-                {
-                    const auto node_based_edges =
-                        m_compressed_edge_container.GetBucketReference(edge_from_u);
-                    NodeID previous = node_u;
+        std::vector<EntryClassID> entry_class_ids;
+        for (const auto &entry_class : getClassesByID(chunk.entry_class_hash))
+        {
+            entry_class_ids.push_back(getClassID(entry_class_hash, entry_class));
+        }
 
-                    const unsigned node_count = node_based_edges.size() + 1;
-                    const QueryNode &first_node = m_node_info_list[previous];
+        std::vector<BearingClassID> bearing_class_ids;
+        for (const auto &bearing_class : getClassesByID(chunk.bearing_class_hash))
+        {
+            bearing_class_ids.push_back(getClassID(bearing_class_hash, bearing_class));
+        }
+        for (const auto &node_and_class : chunk.bearing_classes)
+        {
+            bearing_class_by_node_based_node[node_and_class.first] =
+                bearing_class_ids[node_and_class.second];
+        }
 
-                    lookup::SegmentHeaderBlock header = {node_count, first_node.node_id};
+        // combined descriptions of the chunk are numbered after the lane descriptions
+        std::vector<LaneDescriptionID> combined_description_ids;
+        for (const auto &description : getClassesByID(chunk.combined_lane_descriptions))
+        {
+            const auto id = getClassID(combined_lane_description_ids, description);
+            if (id == combined_lane_descriptions.size())
+            {
+                combined_lane_descriptions.push_back(description);
+            }
+            combined_description_ids.push_back(
+                boost::numeric_cast<LaneDescriptionID>(number_of_lane_descriptions + id));
+        }
 
-                    edge_segment_file.write(reinterpret_cast<const char *>(&header),
-                                            sizeof(header));
+        std::vector<LaneDataID> lane_data_ids;
+        for (auto lane_data : getClassesByID(chunk.lane_data_map))
+        {
+            if (lane_data.second != INVALID_LANE_DESCRIPTIONID &&
+                lane_data.second >= number_of_lane_descriptions)
+            {
+                lane_data.second =
+                    combined_description_ids[lane_data.second - number_of_lane_descriptions];
+            }
+            lane_data_ids.push_back(getClassID(lane_data_map, lane_data));
+        }
 
-                    for (auto target_node : node_based_edges)
-                    {
-                        const QueryNode &from = m_node_info_list[previous];
-                        const QueryNode &to = m_node_info_list[target_node.node_id];
-                        const double segment_length =
-                            util::coordinate_calculation::greatCircleDistance(from, to);
+        for (auto original_edge_data : chunk.original_edge_data)
+        {
+            original_edge_data.entry_classid = entry_class_ids[original_edge_data.entry_classid];
+            if (original_edge_data.lane_data_id != INVALID_LANE_DATAID)
+            {
+                original_edge_data.lane_data_id = lane_data_ids[original_edge_data.lane_data_id];
+            }
+            original_edge_data_vector.push_back(original_edge_data);
+        }
+        original_edges_counter += chunk.original_edge_data.size();
 
-                        lookup::SegmentBlock nodeblock = {
-                            to.node_id, segment_length, target_node.weight};
+        if (original_edge_data_vector.size() > 1024 * 1024 * 10)
+        {
+            FlushVectorToStream(edge_data_file, original_edge_data_vector);
+        }
 
-                        edge_segment_file.write(reinterpret_cast<const char *>(&nodeblock),
-                                                sizeof(nodeblock));
-                        previous = target_node.node_id;
-                    }
+        const auto first_edge_id = m_edge_based_edge_list.size();
+        // NOTE: potential overflow here if we hit 2^32 routable edges
+        BOOST_ASSERT(first_edge_id + chunk.edge_based_edges.size() <=
+                     std::numeric_limits<NodeID>::max());
+        for (auto &edge : chunk.edge_based_edges)
+        {
+            edge.edge_id += first_edge_id;
+        }
+        m_edge_based_edge_list.append(chunk.edge_based_edges.begin(),
+                                      chunk.edge_based_edges.end());
 
-                    // We also now write out the mapping between the edge-expanded edges and the
-                    // original nodes. Since each edge represents a possible maneuver, external
-                    // programs can use this to quickly perform updates to edge weights in order
-                    // to penalize certain turns.
-
-                    // If this edge is 'trivial' -- where the compressed edge corresponds
-                    // exactly to an original OSM segment -- we can pull the turn's preceding
-                    // node ID directly with `node_u`; otherwise, we need to look up the node
-                    // immediately preceding the turn from the compressed edge container.
-                    const bool isTrivial = m_compressed_edge_container.IsTrivial(edge_from_u);
-
-                    const auto &from_node =
-                        isTrivial
-                            ? m_node_info_list[node_u]
-                            : m_node_info_list[m_compressed_edge_container.GetLastEdgeSourceID(
-                                  edge_from_u)];
-                    const auto &via_node =
-                        m_node_info_list[m_compressed_edge_container.GetLastEdgeTargetID(
-                            edge_from_u)];
-                    const auto &to_node =
-                        m_node_info_list[m_compressed_edge_container.GetFirstEdgeTargetID(
-                            turn.eid)];
-
-                    const unsigned fixed_penalty = distance - edge_data1.distance;
-                    lookup::PenaltyBlock penaltyblock = {
-                        fixed_penalty, from_node.node_id, via_node.node_id, to_node.node_id};
-                    edge_penalty_file.write(reinterpret_cast<const char *>(&penaltyblock),
-                                            sizeof(penaltyblock));
-                }
-            }
+        if (generate_edge_lookup)
+        {
+            edge_segment_file.write(chunk.segment_lookup.data(), chunk.segment_lookup.size());
+            edge_penalty_file.write(chunk.penalty_lookup.data(), chunk.penalty_lookup.size());
         }
+    };
+
+    // Reading the node ranges and merging the chunks is serial and in order, at most a few chunks
+    // per thread are in flight.
+    NodeID next_chunk_begin = 0;
+    tbb::parallel_pipeline(
+        2 * tbb::task_scheduler_init::default_num_threads(),
+        tbb::make_filter<void, std::shared_ptr<EdgeExpansionChunk>>(
+            tbb::filter::serial_in_order,
+            [&](tbb::flow_control &control) -> std::shared_ptr<EdgeExpansionChunk> {
+                if (next_chunk_begin >= number_of_nodes)
+                {
+                    control.stop();
+                    return nullptr;
+                }
+                auto chunk = std::make_shared<EdgeExpansionChunk>();
+                chunk->begin = next_chunk_begin;
+                chunk->end = std::min(number_of_nodes, next_chunk_begin + EDGE_EXPANSION_CHUNK_SIZE);
+                next_chunk_begin = chunk->end;
+                return chunk;
+            }) &
+            tbb::make_filter<std::shared_ptr<EdgeExpansionChunk>,
+                             std::shared_ptr<EdgeExpansionChunk>>(
+                tbb::filter::parallel,
+                [&](std::shared_ptr<EdgeExpansionChunk> chunk) {
+                    generate_chunk(*chunk);
+                    return chunk;
+                }) &
+            tbb::make_filter<std::shared_ptr<EdgeExpansionChunk>, void>(
+                tbb::filter::serial_in_order,
+                [&](std::shared_ptr<EdgeExpansionChunk> chunk) { merge_chunk(*chunk); }));
+
+    for (const auto &description : combined_lane_descriptions)
+    {
+        const auto id = boost::numeric_cast<LaneDescriptionID>(lane_description_map.size());
+        BOOST_ASSERT(lane_description_map.count(description) == 0);
+        lane_description_map[description] = id;
     }
 
+    util::SimpleLogger().Write() << "Handled: " << lanes_handled << " of " << lanes_called
+                                 << " lanes: " << (double)(lanes_handled * 100) / (lanes_called)
+                                 << " %.";
+
     util::SimpleLogger().Write() << "Created " << entry_class_hash.size() << " entry classes and "
                                  << bearing_class_hash.size() << " Bearing Classes";
 
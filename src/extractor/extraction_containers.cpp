@@ -8,6 +8,7 @@
 #include "util/fingerprint.hpp"
 #include "util/io.hpp"
 #include "util/simple_logger.hpp"
+#include "util/system_memory.hpp"
 #include "util/timing_util.hpp"
 
 #include <boost/assert.hpp>
@@ -18,9 +19,14 @@
 
 #include <stxxl/sort>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
 #include <chrono>
 #include <limits>
 #include <mutex>
+#include <vector>
 
 namespace
 {
@@ -36,31 +42,10 @@ struct OSMNodeIDSTXXLLess
     value_type min_value() { return MIN_OSM_NODEID; }
 };
 
-struct CmpEdgeByOSMStartID
-{
-    using value_type = oe::InternalExtractorEdge;
-    bool operator()(const value_type &lhs, const value_type &rhs) const
-    {
-        return lhs.result.osm_source_id < rhs.result.osm_source_id;
-    }
-
-    value_type max_value() { return value_type::max_osm_value(); }
-    value_type min_value() { return value_type::min_osm_value(); }
-};
-
-struct CmpEdgeByOSMTargetID
-{
-    using value_type = oe::InternalExtractorEdge;
-    bool operator()(const value_type &lhs, const value_type &rhs) const
-    {
-        return lhs.result.osm_target_id < rhs.result.osm_target_id;
-    }
-
-    value_type max_value() { return value_type::max_osm_value(); }
-    value_type min_value() { return value_type::min_osm_value(); }
-};
-
-struct CmpEdgeByInternalSourceTargetAndName
+// Compares the names through the name offsets and characters. With a mutex the name data is an
+// stxxl vector that has to be accessed by one thread at a time, without the name data is in
+// memory and safe to read concurrently.
+template <typename NameDataT, typename NameOffsetsT> struct CmpEdgeByInternalSourceTargetAndName
 {
     using value_type = oe::InternalExtractorEdge;
     bool operator()(const value_type &lhs, const value_type &rhs) const
@@ -86,9 +71,13 @@ struct CmpEdgeByInternalSourceTargetAndName
         if (rhs.result.name_id == EMPTY_NAMEID)
             return true;
 
-        std::lock_guard<std::mutex> lock(mutex);
+        std::unique_lock<std::mutex> lock;
+        if (mutex)
+        {
+            lock = std::unique_lock<std::mutex>(*mutex);
+        }
         BOOST_ASSERT(!name_offsets.empty() && name_offsets.back() == name_data.size());
-        const oe::ExtractionContainers::STXXLNameCharData::const_iterator data = name_data.begin();
+        const typename NameDataT::const_iterator data = name_data.begin();
         return std::lexicographical_compare(data + name_offsets[lhs.result.name_id],
                                             data + name_offsets[lhs.result.name_id + 1],
                                             data + name_offsets[rhs.result.name_id],
@@ -98,10 +87,41 @@ struct CmpEdgeByInternalSourceTargetAndName
     value_type max_value() { return value_type::max_internal_value(); }
     value_type min_value() { return value_type::min_internal_value(); }
 
-    std::mutex &mutex;
-    const oe::ExtractionContainers::STXXLNameCharData &name_data;
-    const oe::ExtractionContainers::STXXLNameOffsets &name_offsets;
+    std::mutex *mutex;
+    const NameDataT &name_data;
+    const NameOffsetsT &name_offsets;
 };
+
+// Whether a copy of the vector fits into the memory for in-memory sorting
+template <typename VectorT> bool fitsInMemory(const VectorT &vector, const std::uint64_t memory)
+{
+    return vector.size() * sizeof(typename VectorT::value_type) <= memory;
+}
+
+// Sorts a copy of the vector in memory in parallel and writes it back in one sequential pass
+template <typename VectorT, typename CompareT> void sortInMemory(VectorT &vector, CompareT compare)
+{
+    std::vector<typename VectorT::value_type> sorted(vector.begin(), vector.end());
+    tbb::parallel_sort(sorted.begin(), sorted.end(), compare);
+    std::copy(sorted.begin(), sorted.end(), vector.begin());
+}
+
+// Sorts in memory if a copy of the vector fits, with the external stxxl sort otherwise
+template <typename VectorT, typename CompareT>
+void sortVector(VectorT &vector,
+                CompareT compare,
+                const std::uint64_t in_memory_sort_bytes,
+                const unsigned stxxl_memory)
+{
+    if (fitsInMemory(vector, in_memory_sort_bytes))
+    {
+        sortInMemory(vector, compare);
+    }
+    else
+    {
+        stxxl::sort(vector.begin(), vector.end(), compare, stxxl_memory);
+    }
+}
 }
 
 namespace osrm
@@ -111,7 +131,7 @@ namespace extractor
 
 static const int WRITE_BLOCK_BUFFER_SIZE = 8000;
 
-ExtractionContainers::ExtractionContainers()
+ExtractionContainers::ExtractionContainers() : in_memory_sort_bytes(0)
 {
     // Check if stxxl can be instantiated
     stxxl::vector<unsigned> dummy_vector;
@@ -158,6 +178,11 @@ void ExtractionContainers::PrepareData(ScriptingEnvironment &scripting_environme
 
     FlushVectors();
 
+    // a sorted copy of a container has to fit next to the other allocations of the extractor
+    in_memory_sort_bytes = util::getAvailableMemory() / 2;
+    util::SimpleLogger().Write() << "sorting containers of up to " << in_memory_sort_bytes
+                                 << " bytes in memory";
+
     PrepareNodes();
     WriteNodes(file_out_stream);
     PrepareEdges(scripting_environment);
@@ -218,8 +243,7 @@ void ExtractionContainers::PrepareNodes()
 {
     std::cout << "[extractor] Sorting used nodes        ... " << std::flush;
     TIMER_START(sorting_used_nodes);
-    stxxl::sort(
-        used_node_id_list.begin(), used_node_id_list.end(), OSMNodeIDSTXXLLess(), stxxl_memory);
+    sortVector(used_node_id_list, OSMNodeIDSTXXLLess(), in_memory_sort_bytes, stxxl_memory);
     TIMER_STOP(sorting_used_nodes);
     std::cout << "ok, after " << TIMER_SEC(sorting_used_nodes) << "s" << std::endl;
 
@@ -232,16 +256,15 @@ void ExtractionContainers::PrepareNodes()
 
     std::cout << "[extractor] Sorting all nodes         ... " << std::flush;
     TIMER_START(sorting_nodes);
-    stxxl::sort(all_nodes_list.begin(),
-                all_nodes_list.end(),
-                ExternalMemoryNodeSTXXLCompare(),
-                stxxl_memory);
+    sortVector(
+        all_nodes_list, ExternalMemoryNodeSTXXLCompare(), in_memory_sort_bytes, stxxl_memory);
     TIMER_STOP(sorting_nodes);
     std::cout << "ok, after " << TIMER_SEC(sorting_nodes) << "s" << std::endl;
 
     std::cout << "[extractor] Building node id map      ... " << std::flush;
     TIMER_START(id_map);
-    external_to_internal_node_id_map.reserve(used_node_id_list.size());
+    external_to_internal_node_id_map.Reserve(used_node_id_list.size());
+    internal_node_coordinates.reserve(used_node_id_list.size());
     auto node_iter = all_nodes_list.begin();
     auto ref_iter = used_node_id_list.begin();
     const auto all_nodes_list_end = all_nodes_list.end();
@@ -266,7 +289,9 @@ void ExtractionContainers::PrepareNodes()
             continue;
         }
         BOOST_ASSERT(node_iter->node_id == *ref_iter);
-        external_to_internal_node_id_map[*ref_iter] = static_cast<NodeID>(internal_id++);
+        external_to_internal_node_id_map.PushBack(*ref_iter);
+        internal_node_coordinates.emplace_back(node_iter->lon, node_iter->lat);
+        ++internal_id;
         node_iter++;
         ref_iter++;
     }
@@ -276,129 +301,59 @@ void ExtractionContainers::PrepareNodes()
                               "supports 2^32 unique nodes");
     }
     max_internal_node_id = boost::numeric_cast<NodeID>(internal_id);
+    external_to_internal_node_id_map.BuildIndex();
     TIMER_STOP(id_map);
     std::cout << "ok, after " << TIMER_SEC(id_map) << "s" << std::endl;
 }
 
 void ExtractionContainers::PrepareEdges(ScriptingEnvironment &scripting_environment)
 {
-    // Sort edges by start.
-    std::cout << "[extractor] Sorting edges by start    ... " << std::flush;
-    TIMER_START(sort_edges_by_start);
-    stxxl::sort(all_edges_list.begin(), all_edges_list.end(), CmpEdgeByOSMStartID(), stxxl_memory);
-    TIMER_STOP(sort_edges_by_start);
-    std::cout << "ok, after " << TIMER_SEC(sort_edges_by_start) << "s" << std::endl;
-
-    std::cout << "[extractor] Setting start coords      ... " << std::flush;
-    TIMER_START(set_start_coords);
-    // Traverse list of edges and nodes in parallel and set start coord
-    auto node_iterator = all_nodes_list.begin();
-    auto edge_iterator = all_edges_list.begin();
-
-    const auto all_edges_list_end = all_edges_list.end();
-    const auto all_nodes_list_end = all_nodes_list.end();
+    // Resolve both end points through the node id map, no sorting by OSM ids needed
+    std::cout << "[extractor] Computing edge weights    ... " << std::flush;
+    TIMER_START(compute_weights);
+    const auto resolveEdge = [this, &scripting_environment](InternalExtractorEdge &edge) {
+        auto &result = edge.result;
 
-    while (edge_iterator != all_edges_list_end && node_iterator != all_nodes_list_end)
-    {
-        if (edge_iterator->result.osm_source_id < node_iterator->node_id)
-        {
-            util::SimpleLogger().Write(LogLevel::logDEBUG) << "Found invalid node reference "
-                                                           << edge_iterator->result.source;
-            edge_iterator->result.source = SPECIAL_NODEID;
-            ++edge_iterator;
-            continue;
-        }
-        if (edge_iterator->result.osm_source_id > node_iterator->node_id)
+        // Edges without corresponding nodes are invalid. This happens when using osmosis with
+        // bbox or polygon to extract smaller areas.
+        const NodeID source = external_to_internal_node_id_map.Find(result.osm_source_id);
+        if (source == SPECIAL_NODEID)
         {
-            node_iterator++;
-            continue;
+            util::SimpleLogger().Write(LogLevel::logDEBUG)
+                << "Found invalid node reference "
+                << static_cast<std::uint64_t>(result.osm_source_id);
+            result.source = SPECIAL_NODEID;
+            return;
         }
 
         // remove loops
-        if (edge_iterator->result.osm_source_id == edge_iterator->result.osm_target_id)
+        if (result.osm_source_id == result.osm_target_id)
         {
-            edge_iterator->result.source = SPECIAL_NODEID;
-            edge_iterator->result.target = SPECIAL_NODEID;
-            ++edge_iterator;
-            continue;
+            result.source = SPECIAL_NODEID;
+            result.target = SPECIAL_NODEID;
+            return;
         }
 
-        BOOST_ASSERT(edge_iterator->result.osm_source_id == node_iterator->node_id);
-
-        // assign new node id
-        auto id_iter = external_to_internal_node_id_map.find(node_iterator->node_id);
-        BOOST_ASSERT(id_iter != external_to_internal_node_id_map.end());
-        edge_iterator->result.source = id_iter->second;
+        result.source = source;
+        edge.source_coordinate = internal_node_coordinates[source];
 
-        edge_iterator->source_coordinate.lat = node_iterator->lat;
-        edge_iterator->source_coordinate.lon = node_iterator->lon;
-        ++edge_iterator;
-    }
-
-    // Remove all remaining edges. They are invalid because there are no corresponding nodes for
-    // them. This happens when using osmosis with bbox or polygon to extract smaller areas.
-    auto markSourcesInvalid = [](InternalExtractorEdge &edge) {
-        util::SimpleLogger().Write(LogLevel::logDEBUG) << "Found invalid node reference "
-                                                       << edge.result.source;
-        edge.result.source = SPECIAL_NODEID;
-        edge.result.osm_source_id = SPECIAL_OSM_NODEID;
-    };
-    std::for_each(edge_iterator, all_edges_list_end, markSourcesInvalid);
-    TIMER_STOP(set_start_coords);
-    std::cout << "ok, after " << TIMER_SEC(set_start_coords) << "s" << std::endl;
-
-    // Sort Edges by target
-    std::cout << "[extractor] Sorting edges by target   ... " << std::flush;
-    TIMER_START(sort_edges_by_target);
-    stxxl::sort(all_edges_list.begin(), all_edges_list.end(), CmpEdgeByOSMTargetID(), stxxl_memory);
-    TIMER_STOP(sort_edges_by_target);
-    std::cout << "ok, after " << TIMER_SEC(sort_edges_by_target) << "s" << std::endl;
-
-    // Compute edge weights
-    std::cout << "[extractor] Computing edge weights    ... " << std::flush;
-    TIMER_START(compute_weights);
-    node_iterator = all_nodes_list.begin();
-    edge_iterator = all_edges_list.begin();
-    const auto all_edges_list_end_ = all_edges_list.end();
-    const auto all_nodes_list_end_ = all_nodes_list.end();
-
-    while (edge_iterator != all_edges_list_end_ && node_iterator != all_nodes_list_end_)
-    {
-        // skip all invalid edges
-        if (edge_iterator->result.source == SPECIAL_NODEID)
-        {
-            ++edge_iterator;
-            continue;
-        }
-
-        if (edge_iterator->result.osm_target_id < node_iterator->node_id)
+        const NodeID target = external_to_internal_node_id_map.Find(result.osm_target_id);
+        if (target == SPECIAL_NODEID)
         {
             util::SimpleLogger().Write(LogLevel::logDEBUG)
                 << "Found invalid node reference "
-                << static_cast<uint64_t>(edge_iterator->result.osm_target_id);
-            edge_iterator->result.target = SPECIAL_NODEID;
-            ++edge_iterator;
-            continue;
-        }
-        if (edge_iterator->result.osm_target_id > node_iterator->node_id)
-        {
-            ++node_iterator;
-            continue;
+                << static_cast<std::uint64_t>(result.osm_target_id);
+            result.target = SPECIAL_NODEID;
+            return;
         }
+        const util::Coordinate target_coordinate = internal_node_coordinates[target];
 
-        BOOST_ASSERT(edge_iterator->result.osm_target_id == node_iterator->node_id);
-        BOOST_ASSERT(edge_iterator->weight_data.speed >= 0);
-        BOOST_ASSERT(edge_iterator->source_coordinate.lat !=
-                     util::FixedLatitude{std::numeric_limits<std::int32_t>::min()});
-        BOOST_ASSERT(edge_iterator->source_coordinate.lon !=
-                     util::FixedLongitude{std::numeric_limits<std::int32_t>::min()});
-
+        BOOST_ASSERT(edge.weight_data.speed >= 0);
         const double distance = util::coordinate_calculation::greatCircleDistance(
-            edge_iterator->source_coordinate,
-            util::Coordinate(node_iterator->lon, node_iterator->lat));
+            edge.source_coordinate, target_coordinate);
 
         scripting_environment.ProcessSegment(
-            edge_iterator->source_coordinate, *node_iterator, distance, edge_iterator->weight_data);
+            edge.source_coordinate, target_coordinate, distance, edge.weight_data);
 
         const double weight = [distance](const InternalExtractorEdge::WeightData &data) {
             switch (data.type)
@@ -414,49 +369,74 @@ void ExtractionContainers::PrepareEdges(ScriptingEnvironment &scripting_environm
                 util::exception("invalid weight type");
             }
             return -1.0;
-        }(edge_iterator->weight_data);
-
-        auto &edge = edge_iterator->result;
-        edge.weight = std::max(1, static_cast<int>(std::floor(weight + .5)));
+        }(edge.weight_data);
 
-        // assign new node id
-        auto id_iter = external_to_internal_node_id_map.find(node_iterator->node_id);
-        BOOST_ASSERT(id_iter != external_to_internal_node_id_map.end());
-        edge.target = id_iter->second;
+        result.weight = std::max(1, static_cast<int>(std::floor(weight + .5)));
+        result.target = target;
 
         // orient edges consistently: source id < target id
         // important for multi-edge removal
-        if (edge.source > edge.target)
+        if (result.source > result.target)
         {
-            std::swap(edge.source, edge.target);
+            std::swap(result.source, result.target);
 
             // std::swap does not work with bit-fields
-            bool temp = edge.forward;
-            edge.forward = edge.backward;
-            edge.backward = temp;
+            bool temp = result.forward;
+            result.forward = result.backward;
+            result.backward = temp;
         }
-        ++edge_iterator;
-    }
-
-    // Remove all remaining edges. They are invalid because there are no corresponding nodes for
-    // them. This happens when using osmosis with bbox or polygon to extract smaller areas.
-    auto markTargetsInvalid = [](InternalExtractorEdge &edge) {
-        util::SimpleLogger().Write(LogLevel::logDEBUG) << "Found invalid node reference "
-                                                       << edge.result.target;
-        edge.result.target = SPECIAL_NODEID;
     };
-    std::for_each(edge_iterator, all_edges_list_end_, markTargetsInvalid);
+
+    // The edges are independent of each other. They are copied into memory a chunk at a time,
+    // resolved in parallel with a segment_function context per thread, and written back in order.
+    // Edges that fit in memory make up a single chunk.
+    const std::uint64_t chunk_size = std::max<std::uint64_t>(
+        in_memory_sort_bytes / sizeof(InternalExtractorEdge), std::uint64_t{1} << 16);
+    std::vector<InternalExtractorEdge> edges;
+    for (std::uint64_t first = 0; first < all_edges_list.size(); first += chunk_size)
+    {
+        const auto last = std::min<std::uint64_t>(first + chunk_size, all_edges_list.size());
+        edges.assign(all_edges_list.begin() + first, all_edges_list.begin() + last);
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, edges.size()),
+                          [&edges, &resolveEdge](const tbb::blocked_range<std::size_t> &range) {
+                              for (auto index = range.begin(); index != range.end(); ++index)
+                              {
+                                  resolveEdge(edges[index]);
+                              }
+                          });
+        std::copy(edges.begin(), edges.end(), all_edges_list.begin() + first);
+    }
+    std::vector<InternalExtractorEdge>().swap(edges);
+    // the coordinates are part of the edges from now on
+    std::vector<util::Coordinate>().swap(internal_node_coordinates);
     TIMER_STOP(compute_weights);
     std::cout << "ok, after " << TIMER_SEC(compute_weights) << "s" << std::endl;
 
     // Sort edges by start.
     std::cout << "[extractor] Sorting edges by renumbered start ... " << std::flush;
     TIMER_START(sort_edges_by_renumbered_start);
-    std::mutex name_data_mutex;
-    stxxl::sort(all_edges_list.begin(),
-                all_edges_list.end(),
-                CmpEdgeByInternalSourceTargetAndName{name_data_mutex, name_char_data, name_offsets},
-                stxxl_memory);
+    // the names are compared concurrently when they are copied into memory along with the edges
+    const auto names_bytes = name_char_data.size() * sizeof(STXXLNameCharData::value_type) +
+                             name_offsets.size() * sizeof(STXXLNameOffsets::value_type);
+    if (names_bytes <= in_memory_sort_bytes &&
+        fitsInMemory(all_edges_list, in_memory_sort_bytes - names_bytes))
+    {
+        const std::vector<unsigned char> name_data(name_char_data.begin(), name_char_data.end());
+        const std::vector<unsigned> name_data_offsets(name_offsets.begin(), name_offsets.end());
+        sortInMemory(all_edges_list,
+                     CmpEdgeByInternalSourceTargetAndName<std::vector<unsigned char>,
+                                                          std::vector<unsigned>>{
+                         nullptr, name_data, name_data_offsets});
+    }
+    else
+    {
+        std::mutex name_data_mutex;
+        stxxl::sort(all_edges_list.begin(),
+                    all_edges_list.end(),
+                    CmpEdgeByInternalSourceTargetAndName<STXXLNameCharData, STXXLNameOffsets>{
+                        &name_data_mutex, name_char_data, name_offsets},
+                    stxxl_memory);
+    }
     TIMER_STOP(sort_edges_by_renumbered_start);
     std::cout << "ok, after " << TIMER_SEC(sort_edges_by_renumbered_start) << "s" << std::endl;
 
@@ -665,20 +645,18 @@ void ExtractionContainers::PrepareRestrictions()
 {
     std::cout << "[extractor] Sorting used ways         ... " << std::flush;
     TIMER_START(sort_ways);
-    stxxl::sort(way_start_end_id_list.begin(),
-                way_start_end_id_list.end(),
-                FirstAndLastSegmentOfWayStxxlCompare(),
-                stxxl_memory);
+    sortVector(way_start_end_id_list,
+               FirstAndLastSegmentOfWayStxxlCompare(),
+               in_memory_sort_bytes,
+               stxxl_memory);
     TIMER_STOP(sort_ways);
     std::cout << "ok, after " << TIMER_SEC(sort_ways) << "s" << std::endl;
 
     std::cout << "[extractor] Sorting " << restrictions_list.size() << " restriction. by from... "
               << std::flush;
     TIMER_START(sort_restrictions);
-    stxxl::sort(restrictions_list.begin(),
-                restrictions_list.end(),
-                CmpRestrictionContainerByFrom(),
-                stxxl_memory);
+    sortVector(
+        restrictions_list, CmpRestrictionContainerByFrom(), in_memory_sort_bytes, stxxl_memory);
     TIMER_STOP(sort_restrictions);
     std::cout << "ok, after " << TIMER_SEC(sort_restrictions) << "s" << std::endl;
 
@@ -717,8 +695,7 @@ void ExtractionContainers::PrepareRestrictions()
         const OSMNodeID via_node_id = OSMNodeID{restrictions_iterator->restriction.via.node};
 
         // check if via is actually valid, if not invalidate
-        auto via_id_iter = external_to_internal_node_id_map.find(via_node_id);
-        if (via_id_iter == external_to_internal_node_id_map.end())
+        if (external_to_internal_node_id_map.Find(via_node_id) == SPECIAL_NODEID)
         {
             util::SimpleLogger().Write(LogLevel::logDEBUG)
                 << "Restriction references invalid node: "
@@ -731,9 +708,9 @@ void ExtractionContainers::PrepareRestrictions()
         if (way_start_and_end_iterator->first_segment_source_id == via_node_id)
         {
             // assign new from node id
-            auto id_iter = external_to_internal_node_id_map.find(
+            const NodeID from_id = external_to_internal_node_id_map.Find(
                 way_start_and_end_iterator->first_segment_target_id);
-            if (id_iter == external_to_internal_node_id_map.end())
+            if (from_id == SPECIAL_NODEID)
             {
                 util::SimpleLogger().Write(LogLevel::logDEBUG)
                     << "Way references invalid node: "
@@ -743,14 +720,14 @@ void ExtractionContainers::PrepareRestrictions()
                 ++way_start_and_end_iterator;
                 continue;
             }
-            restrictions_iterator->restriction.from.node = id_iter->second;
+            restrictions_iterator->restriction.from.node = from_id;
         }
         else if (way_start_and_end_iterator->last_segment_target_id == via_node_id)
         {
             // assign new from node id
-            auto id_iter = external_to_internal_node_id_map.find(
+            const NodeID from_id = external_to_internal_node_id_map.Find(
                 way_start_and_end_iterator->last_segment_source_id);
-            if (id_iter == external_to_internal_node_id_map.end())
+            if (from_id == SPECIAL_NODEID)
             {
                 util::SimpleLogger().Write(LogLevel::logDEBUG)
                     << "Way references invalid node: "
@@ -760,7 +737,7 @@ void ExtractionContainers::PrepareRestrictions()
                 ++way_start_and_end_iterator;
                 continue;
             }
-            restrictions_iterator->restriction.from.node = id_iter->second;
+            restrictions_iterator->restriction.from.node = from_id;
         }
         ++restrictions_iterator;
     }
@@ -770,10 +747,8 @@ void ExtractionContainers::PrepareRestrictions()
 
     std::cout << "[extractor] Sorting restrictions. by to  ... " << std::flush;
     TIMER_START(sort_restrictions_to);
-    stxxl::sort(restrictions_list.begin(),
-                restrictions_list.end(),
-                CmpRestrictionContainerByTo(),
-                stxxl_memory);
+    sortVector(
+        restrictions_list, CmpRestrictionContainerByTo(), in_memory_sort_bytes, stxxl_memory);
     TIMER_STOP(sort_restrictions_to);
     std::cout << "ok, after " << TIMER_SEC(sort_restrictions_to) << "s" << std::endl;
 
@@ -815,15 +790,15 @@ void ExtractionContainers::PrepareRestrictions()
         const OSMNodeID via_node_id = OSMNodeID{restrictions_iterator->restriction.via.node};
 
         // assign new via node id
-        auto via_id_iter = external_to_internal_node_id_map.find(via_node_id);
-        BOOST_ASSERT(via_id_iter != external_to_internal_node_id_map.end());
-        restrictions_iterator->restriction.via.node = via_id_iter->second;
+        const NodeID via_id = external_to_internal_node_id_map.Find(via_node_id);
+        BOOST_ASSERT(via_id != SPECIAL_NODEID);
+        restrictions_iterator->restriction.via.node = via_id;
 
         if (way_start_and_end_iterator->first_segment_source_id == via_node_id)
         {
-            auto to_id_iter = external_to_internal_node_id_map.find(
+            const NodeID to_id = external_to_internal_node_id_map.Find(
                 way_start_and_end_iterator->first_segment_target_id);
-            if (to_id_iter == external_to_internal_node_id_map.end())
+            if (to_id == SPECIAL_NODEID)
             {
                 util::SimpleLogger().Write(LogLevel::logDEBUG)
                     << "Way references invalid node: "
@@ -833,13 +808,13 @@ void ExtractionContainers::PrepareRestrictions()
                 ++way_start_and_end_iterator;
                 continue;
             }
-            restrictions_iterator->restriction.to.node = to_id_iter->second;
+            restrictions_iterator->restriction.to.node = to_id;
         }
         else if (way_start_and_end_iterator->last_segment_target_id == via_node_id)
         {
-            auto to_id_iter = external_to_internal_node_id_map.find(
+            const NodeID to_id = external_to_internal_node_id_map.Find(
                 way_start_and_end_iterator->last_segment_source_id);
-            if (to_id_iter == external_to_internal_node_id_map.end())
+            if (to_id == SPECIAL_NODEID)
             {
                 util::SimpleLogger().Write(LogLevel::logDEBUG)
                     << "Way references invalid node: "
@@ -849,7 +824,7 @@ void ExtractionContainers::PrepareRestrictions()
                 ++way_start_and_end_iterator;
                 continue;
             }
-            restrictions_iterator->restriction.to.node = to_id_iter->second;
+            restrictions_iterator->restriction.to.node = to_id;
         }
         ++restrictions_iterator;
     }
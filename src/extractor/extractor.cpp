@@ -5,6 +5,7 @@
 #include "extractor/extraction_node.hpp"
 #include "extractor/extraction_way.hpp"
 #include "extractor/extractor_callbacks.hpp"
+#include "extractor/osm_change_set.hpp"
 #include "extractor/restriction_parser.hpp"
 #include "extractor/scripting_environment.hpp"
 
@@ -24,7 +25,7 @@
 // Keep debug include to make sure the debug header is in sync with types.
 #include "util/debug.hpp"
 
-#include "extractor/tarjan_scc.hpp"
+#include "extractor/parallel_scc.hpp"
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
@@ -33,6 +34,7 @@
 #include <osmium/io/any_input.hpp>
 
 #include <tbb/concurrent_vector.h>
+#include <tbb/pipeline.h>
 #include <tbb/task_scheduler_init.h>
 
 #include <cstdlib>
@@ -59,6 +61,18 @@ namespace extractor
 
 namespace
 {
+// A buffer of the input file on its way through the parsing pipeline
+struct ParsedBuffer
+{
+    osmium::memory::Buffer buffer;
+    std::vector<osmium::memory::Buffer::const_iterator> osm_elements;
+    tbb::concurrent_vector<std::pair<std::size_t, ExtractionNode>> resulting_nodes;
+    tbb::concurrent_vector<std::pair<std::size_t, ExtractionWay>> resulting_ways;
+    tbb::concurrent_vector<boost::optional<InputRestrictionContainer>> resulting_restrictions;
+    // holds the latest versions of changed objects instead of a buffer of the input file
+    bool from_changes = false;
+};
+
 std::tuple<std::vector<std::uint32_t>, std::vector<guidance::TurnLaneType::Mask>>
 transformTurnLaneMapIntoArrays(const guidance::LaneDescriptionMap &turn_lane_map)
 {
@@ -136,6 +150,7 @@ int Extractor::run(ScriptingEnvironment &scripting_environment)
 
         util::SimpleLogger().Write() << "Parsing in progress..";
         TIMER_START(parsing);
+        phase_profiler.Start("parsing");
 
         // setup raster sources
         scripting_environment.SetupSources();
@@ -155,57 +170,124 @@ int Extractor::run(ScriptingEnvironment &scripting_environment)
         }
         util::SimpleLogger().Write() << "timestamp: " << timestamp;
 
-        boost::filesystem::ofstream timestamp_out(config.timestamp_file_name);
-        timestamp_out.write(timestamp.c_str(), timestamp.length());
-
-        // initialize vectors holding parsed objects
-        tbb::concurrent_vector<std::pair<std::size_t, ExtractionNode>> resulting_nodes;
-        tbb::concurrent_vector<std::pair<std::size_t, ExtractionWay>> resulting_ways;
-        tbb::concurrent_vector<boost::optional<InputRestrictionContainer>> resulting_restrictions;
-
-        // setup restriction parser
-        const RestrictionParser restriction_parser(scripting_environment);
-
-        while (const osmium::memory::Buffer buffer = reader.read())
+        // changes are applied while reading, instead of writing a merged input file first
+        std::unique_ptr<OSMChangeSet> change_set;
+        if (!config.change_paths.empty())
         {
-            // create a vector of iterators into the buffer
-            std::vector<osmium::memory::Buffer::const_iterator> osm_elements;
-            for (auto iter = std::begin(buffer), end = std::end(buffer); iter != end; ++iter)
+            TIMER_START(read_changes);
+            change_set = std::make_unique<OSMChangeSet>(config.change_paths);
+            TIMER_STOP(read_changes);
+            util::SimpleLogger().Write()
+                << "Applying " << change_set->GetNumberOfChanged() << " changed objects ("
+                << change_set->GetNumberOfDeleted() << " deleted) from "
+                << config.change_paths.size() << " change files, read in "
+                << TIMER_SEC(read_changes) << "s";
+
+            if (change_set->GetLatestTimestamp().valid())
             {
-                osm_elements.push_back(iter);
+                timestamp = change_set->GetLatestTimestamp().to_iso();
+                util::SimpleLogger().Write() << "timestamp of the latest change: " << timestamp;
             }
+        }
 
-            // clear resulting vectors
-            resulting_nodes.clear();
-            resulting_ways.clear();
-            resulting_restrictions.clear();
+        boost::filesystem::ofstream timestamp_out(config.timestamp_file_name);
+        timestamp_out.write(timestamp.c_str(), timestamp.length());
 
-            scripting_environment.ProcessElements(osm_elements,
-                                                  restriction_parser,
-                                                  resulting_nodes,
-                                                  resulting_ways,
-                                                  resulting_restrictions);
+        // setup restriction parser
+        const RestrictionParser restriction_parser(scripting_environment);
 
-            number_of_nodes += resulting_nodes.size();
-            // put parsed objects thru extractor callbacks
-            for (const auto &result : resulting_nodes)
-            {
-                extractor_callbacks->ProcessNode(
-                    static_cast<const osmium::Node &>(*(osm_elements[result.first])),
-                    result.second);
-            }
-            number_of_ways += resulting_ways.size();
-            for (const auto &result : resulting_ways)
-            {
-                extractor_callbacks->ProcessWay(
-                    static_cast<const osmium::Way &>(*(osm_elements[result.first])), result.second);
-            }
-            number_of_relations += resulting_restrictions.size();
-            for (const auto &result : resulting_restrictions)
-            {
-                extractor_callbacks->ProcessRestriction(result);
-            }
-        }
+        // Reading, Lua processing and inserting into the containers overlap across buffers. The
+        // first and last stage are serial and in order, so the output does not depend on timing.
+        // At most a few buffers per thread are in flight.
+        const auto max_buffers_in_flight = 2 * number_of_threads;
+        bool changes_read = false;
+        tbb::parallel_pipeline(
+            max_buffers_in_flight,
+            tbb::make_filter<void, std::shared_ptr<ParsedBuffer>>(
+                tbb::filter::serial_in_order,
+                [&](tbb::flow_control &control) -> std::shared_ptr<ParsedBuffer> {
+                    auto parsed = std::make_shared<ParsedBuffer>();
+                    parsed->buffer = reader.read();
+                    if (!parsed->buffer)
+                    {
+                        // the changed objects follow the last buffer of the input file
+                        if (!change_set || changes_read)
+                        {
+                            control.stop();
+                            return nullptr;
+                        }
+                        parsed->buffer = change_set->MoveOutVisibleObjects();
+                        parsed->from_changes = true;
+                        changes_read = true;
+                    }
+                    // create a vector of iterators into the buffer
+                    const auto &buffer = parsed->buffer;
+                    for (auto iter = std::begin(buffer), end = std::end(buffer); iter != end; ++iter)
+                    {
+                        parsed->osm_elements.push_back(iter);
+                    }
+                    return parsed;
+                }) &
+                tbb::make_filter<std::shared_ptr<ParsedBuffer>, std::shared_ptr<ParsedBuffer>>(
+                    tbb::filter::parallel,
+                    [&](std::shared_ptr<ParsedBuffer> parsed) {
+                        if (change_set && !parsed->from_changes)
+                        {
+                            auto &osm_elements = parsed->osm_elements;
+                            osm_elements.erase(
+                                std::remove_if(osm_elements.begin(),
+                                               osm_elements.end(),
+                                               [&](const auto &element) {
+                                                   return change_set->IsChanged(*element);
+                                               }),
+                                osm_elements.end());
+                        }
+                        scripting_environment.ProcessElements(parsed->osm_elements,
+                                                              restriction_parser,
+                                                              parsed->resulting_nodes,
+                                                              parsed->resulting_ways,
+                                                              parsed->resulting_restrictions);
+                        // the elements of a buffer are processed in parallel too
+                        const auto by_element = [](const auto &lhs, const auto &rhs) {
+                            return lhs.first < rhs.first;
+                        };
+                        std::sort(parsed->resulting_nodes.begin(),
+                                  parsed->resulting_nodes.end(),
+                                  by_element);
+                        std::sort(
+                            parsed->resulting_ways.begin(), parsed->resulting_ways.end(), by_element);
+                        // only the ids of the turn lane descriptions are assigned in order
+                        for (auto &result : parsed->resulting_ways)
+                        {
+                            ExtractorCallbacks::ParseTurnLanes(result.second);
+                        }
+                        return parsed;
+                    }) &
+                tbb::make_filter<std::shared_ptr<ParsedBuffer>, void>(
+                    tbb::filter::serial_in_order, [&](std::shared_ptr<ParsedBuffer> parsed) {
+                        const auto &osm_elements = parsed->osm_elements;
+                        number_of_nodes += parsed->resulting_nodes.size();
+                        // put parsed objects thru extractor callbacks
+                        for (const auto &result : parsed->resulting_nodes)
+                        {
+                            extractor_callbacks->ProcessNode(
+                                static_cast<const osmium::Node &>(*(osm_elements[result.first])),
+                                result.second);
+                        }
+                        number_of_ways += parsed->resulting_ways.size();
+                        for (const auto &result : parsed->resulting_ways)
+                        {
+                            extractor_callbacks->ProcessWay(
+                                static_cast<const osmium::Way &>(*(osm_elements[result.first])),
+                                result.second);
+                        }
+                        number_of_relations += parsed->resulting_restrictions.size();
+                        for (const auto &result : parsed->resulting_restrictions)
+                        {
+                            extractor_callbacks->ProcessRestriction(result);
+                        }
+                    }));
+        phase_profiler.Stop();
         TIMER_STOP(parsing);
         util::SimpleLogger().Write() << "Parsing finished after " << TIMER_SEC(parsing)
                                      << " seconds";
@@ -225,10 +307,12 @@ int Extractor::run(ScriptingEnvironment &scripting_environment)
             return 1;
         }
 
+        phase_profiler.Start("prepare_data");
         extraction_containers.PrepareData(scripting_environment,
                                           config.output_file_name,
                                           config.restriction_file_name,
                                           config.names_file_name);
+        phase_profiler.Stop();
 
         WriteProfileProperties(config.profile_properties_output_path,
                                scripting_environment.GetProfileProperties());
@@ -275,18 +359,24 @@ int Extractor::run(ScriptingEnvironment &scripting_environment)
         util::SimpleLogger().Write() << "Computing strictly connected components ...";
         FindComponents(max_edge_id, edge_based_edge_list, edge_based_node_list);
 
+        util::SimpleLogger().Write() << "Writing edge-based node data ...";
+        WriteEdgeBasedNodeData(max_edge_id, edge_based_node_list);
+
         util::SimpleLogger().Write() << "Building r-tree ...";
         TIMER_START(rtree);
-        BuildRTree(std::move(edge_based_node_list),
+        phase_profiler.Start("rtree");
+        BuildRTree(edge_based_node_list,
                    std::move(node_is_startpoint),
                    internal_to_external_node_map);
-
+        phase_profiler.Stop();
         TIMER_STOP(rtree);
 
         util::SimpleLogger().Write() << "Writing node map ...";
         WriteNodeMapping(internal_to_external_node_map);
 
+        phase_profiler.Start("write_edge_based_graph");
         WriteEdgeBasedGraph(config.edge_graph_output_path, max_edge_id, edge_based_edge_list);
+        phase_profiler.Stop();
 
         util::SimpleLogger().Write()
             << "Expansion  : " << (number_of_node_based_nodes / TIMER_SEC(expansion))
@@ -295,6 +385,11 @@ int Extractor::run(ScriptingEnvironment &scripting_environment)
                                      << "./osrm-contract " << config.output_file_name << std::endl;
     }
 
+    if (!config.phase_report_path.empty())
+    {
+        phase_profiler.Write(config.phase_report_path);
+    }
+
     return 0;
 }
 
@@ -372,7 +467,7 @@ void Extractor::FindComponents(unsigned max_edge_id,
 
     auto uncontractor_graph = std::make_shared<UncontractedGraph>(max_edge_id + 1, edges);
 
-    TarjanSCC<UncontractedGraph> component_search(
+    ParallelSCC<UncontractedGraph> component_search(
         std::const_pointer_cast<const UncontractedGraph>(uncontractor_graph));
     component_search.Run();
 
@@ -462,7 +557,7 @@ Extractor::BuildEdgeExpandedGraph(ScriptingEnvironment &scripting_environment,
     std::unordered_set<NodeID> traffic_lights;
 
     auto restriction_map = LoadRestrictionMap();
-    auto node_based_graph =
+    auto dynamic_node_based_graph =
         LoadNodeBasedGraph(barrier_nodes, traffic_lights, internal_to_external_node_map);
 
     CompressedEdgeContainer compressed_edge_container;
@@ -470,9 +565,20 @@ Extractor::BuildEdgeExpandedGraph(ScriptingEnvironment &scripting_environment,
     graph_compressor.Compress(barrier_nodes,
                               traffic_lights,
                               *restriction_map,
-                              *node_based_graph,
+                              *dynamic_node_based_graph,
                               compressed_edge_container);
 
+    // the guidance and the edge expansion only read the compressed graph and the restrictions
+    restriction_map->Freeze();
+    std::shared_ptr<util::NodeBasedStaticGraph> node_based_graph;
+    {
+        std::vector<EdgeID> new_edge_ids;
+        node_based_graph =
+            util::NodeBasedStaticGraphFromDynamic(*dynamic_node_based_graph, new_edge_ids);
+        dynamic_node_based_graph.reset();
+        compressed_edge_container.RenumberEdges(new_edge_ids);
+    }
+
     util::NameTable name_table(config.names_file_name);
 
     // could use some additional capacity? To avoid a copy during processing, though small data so
@@ -494,20 +600,30 @@ Extractor::BuildEdgeExpandedGraph(ScriptingEnvironment &scripting_environment,
         turn_lane_masks,
         turn_lane_map);
 
+    phase_profiler.Start("edge_expansion");
     edge_based_graph_factory.Run(scripting_environment,
                                  config.edge_output_path,
                                  config.turn_lane_data_file_name,
                                  config.edge_segment_lookup_path,
                                  config.edge_penalty_path,
-                                 config.generate_edge_lookup);
+                                 config.generate_edge_lookup,
+                                 config.hilbert_node_order);
+    phase_profiler.Stop();
 
     WriteTurnLaneData(config.turn_lane_descriptions_file_name);
     compressed_edge_container.SerializeInternalVector(config.geometry_output_path);
+    compressed_edge_container.SerializeSegmentLengths(config.segment_lengths_output_path,
+                                                      internal_to_external_node_map);
 
     edge_based_graph_factory.GetEdgeBasedEdges(edge_based_edge_list);
     edge_based_graph_factory.GetEdgeBasedNodes(node_based_edge_list);
     edge_based_graph_factory.GetStartPointMarkers(node_is_startpoint);
     edge_based_graph_factory.GetEdgeBasedNodeWeights(edge_based_node_weights);
+
+    // osrm-contract --exclude contracts hierarchies without the edge-based nodes of some classes
+    std::vector<ClassData> edge_based_node_classes;
+    edge_based_graph_factory.GetEdgeBasedNodeClasses(edge_based_node_classes);
+    util::serializeVector(config.edge_based_node_classes_output_path, edge_based_node_classes);
     auto max_edge_id = edge_based_graph_factory.GetHighestEdgeID();
 
     const std::size_t number_of_node_based_nodes = node_based_graph->GetNumberOfNodes();
@@ -535,12 +651,43 @@ void Extractor::WriteNodeMapping(const std::vector<QueryNode> &internal_to_exter
     }
 }
 
+/**
+    \brief Writes the data of the edge-based nodes that their segments in the rtree leave out
+
+    Saves the name, component and travel mode of every edge-based node into '.ebg_nodes'.
+ */
+void Extractor::WriteEdgeBasedNodeData(const EdgeID max_edge_id,
+                                       const std::vector<EdgeBasedNode> &node_based_edge_list) const
+{
+    std::vector<EdgeBasedNodeData> node_data(max_edge_id + 1);
+    for (const auto &node : node_based_edge_list)
+    {
+        if (node.forward_segment_id.enabled)
+        {
+            BOOST_ASSERT(node.forward_segment_id.id <= max_edge_id);
+            node_data[node.forward_segment_id.id] = {
+                node.name_id, node.component.id, node.forward_travel_mode};
+        }
+        if (node.reverse_segment_id.enabled)
+        {
+            BOOST_ASSERT(node.reverse_segment_id.id <= max_edge_id);
+            node_data[node.reverse_segment_id.id] = {
+                node.name_id, node.component.id, node.backward_travel_mode};
+        }
+    }
+    if (!util::serializeVector(config.edge_based_nodes_output_path, node_data))
+    {
+        throw util::exception("Failed to write " + config.edge_based_nodes_output_path);
+    }
+}
+
 /**
     \brief Building rtree-based nearest-neighbor data structure
 
-    Saves tree into '.ramIndex' and leaves into '.fileIndex'.
+    Saves tree into '.ramIndex' and leaves into '.fileIndex'. The leaves only hold the segments
+    of the edge-based nodes, see EdgeBasedNodeSegment.
  */
-void Extractor::BuildRTree(std::vector<EdgeBasedNode> node_based_edge_list,
+void Extractor::BuildRTree(const std::vector<EdgeBasedNode> &node_based_edge_list,
                            std::vector<bool> node_is_startpoint,
                            const std::vector<QueryNode> &internal_to_external_node_map)
 {
@@ -551,31 +698,28 @@ void Extractor::BuildRTree(std::vector<EdgeBasedNode> node_based_edge_list,
     BOOST_ASSERT(node_is_startpoint.size() == node_based_edge_list.size());
 
     // Filter node based edges based on startpoint
-    auto out_iter = node_based_edge_list.begin();
-    auto in_iter = node_based_edge_list.begin();
+    std::vector<EdgeBasedNodeSegment> segments;
+    segments.reserve(std::count(node_is_startpoint.begin(), node_is_startpoint.end(), true));
     for (auto index : util::irange<std::size_t>(0UL, node_is_startpoint.size()))
     {
-        BOOST_ASSERT(in_iter != node_based_edge_list.end());
         if (node_is_startpoint[index])
         {
-            *out_iter = *in_iter;
-            out_iter++;
+            segments.emplace_back(node_based_edge_list[index]);
         }
-        in_iter++;
     }
-    auto new_size = out_iter - node_based_edge_list.begin();
-    if (new_size == 0)
+    if (segments.empty())
     {
         throw util::exception("There are no snappable edges left after processing.  Are you "
                               "setting travel modes correctly in the profile?  Cannot continue.");
     }
-    node_based_edge_list.resize(new_size);
+    node_is_startpoint.clear();
 
     TIMER_START(construction);
-    util::StaticRTree<EdgeBasedNode, std::vector<QueryNode>> rtree(node_based_edge_list,
-                                                                   config.rtree_nodes_output_path,
-                                                                   config.rtree_leafs_output_path,
-                                                                   internal_to_external_node_map);
+    util::StaticRTree<EdgeBasedNodeSegment, std::vector<QueryNode>> rtree(
+        segments,
+        config.rtree_nodes_output_path,
+        config.rtree_leafs_output_path,
+        internal_to_external_node_map);
 
     TIMER_STOP(construction);
     util::SimpleLogger().Write() << "finished r-tree construction in " << TIMER_SEC(construction)
@@ -31,6 +31,81 @@ namespace extractor
 using TurnLaneDescription = guidance::TurnLaneDescription;
 namespace TurnLaneType = guidance::TurnLaneType;
 
+namespace
+{
+// Parses a turn lane string of a way into the masks of its lanes, an empty description if the
+// string has unsupported tags
+TurnLaneDescription parseTurnLaneString(const std::string &lane_string)
+{
+    if (lane_string.empty())
+        return {};
+
+    TurnLaneDescription lane_description;
+
+    typedef boost::tokenizer<boost::char_separator<char>> tokenizer;
+    boost::char_separator<char> sep("|", "", boost::keep_empty_tokens);
+    boost::char_separator<char> inner_sep(";", "");
+    tokenizer tokens(lane_string, sep);
+
+    const constexpr std::size_t num_osm_tags = 11;
+    const constexpr char *osm_lane_strings[num_osm_tags] = {"none",
+                                                            "through",
+                                                            "sharp_left",
+                                                            "left",
+                                                            "slight_left",
+                                                            "slight_right",
+                                                            "right",
+                                                            "sharp_right",
+                                                            "reverse",
+                                                            "merge_to_left",
+                                                            "merge_to_right"};
+
+    const constexpr TurnLaneType::Mask masks_by_osm_string[num_osm_tags + 1] = {
+        TurnLaneType::none,
+        TurnLaneType::straight,
+        TurnLaneType::sharp_left,
+        TurnLaneType::left,
+        TurnLaneType::slight_left,
+        TurnLaneType::slight_right,
+        TurnLaneType::right,
+        TurnLaneType::sharp_right,
+        TurnLaneType::uturn,
+        TurnLaneType::merge_to_left,
+        TurnLaneType::merge_to_right,
+        TurnLaneType::empty}; // fallback, if string not found
+
+    for (auto iter = tokens.begin(); iter != tokens.end(); ++iter)
+    {
+        tokenizer inner_tokens(*iter, inner_sep);
+        guidance::TurnLaneType::Mask lane_mask = inner_tokens.begin() == inner_tokens.end()
+                                                     ? TurnLaneType::none
+                                                     : TurnLaneType::empty;
+        for (auto token_itr = inner_tokens.begin(); token_itr != inner_tokens.end(); ++token_itr)
+        {
+            auto position =
+                std::find(osm_lane_strings, osm_lane_strings + num_osm_tags, *token_itr);
+            const auto translated_mask =
+                masks_by_osm_string[std::distance(osm_lane_strings, position)];
+            if (translated_mask == TurnLaneType::empty)
+            {
+                // if we have unsupported tags, don't handle them
+                util::SimpleLogger().Write(logDEBUG) << "Unsupported lane tag found: \""
+                                                     << *token_itr << "\"";
+                return {};
+            }
+
+            // In case of multiple times the same lane indicators withn a lane, as in
+            // "left;left|.."  or-ing the masks generates a single "left" enum.
+            // Which is fine since this is data issue and we can't represent it anyway.
+            lane_mask |= translated_mask;
+        }
+        // add the lane to the description
+        lane_description.push_back(lane_mask);
+    }
+    return lane_description;
+}
+}
+
 ExtractorCallbacks::ExtractorCallbacks(ExtractionContainers &extraction_containers)
     : external_memory(extraction_containers)
 {
@@ -69,6 +144,21 @@ void ExtractorCallbacks::ProcessRestriction(
         //                           "y" : "n");
     }
 }
+
+void ExtractorCallbacks::ParseTurnLanes(ExtractionWay &parsed_way)
+{
+    if (!parsed_way.turn_lanes_forward.empty())
+    {
+        parsed_way.turn_lane_description_forward =
+            parseTurnLaneString(parsed_way.turn_lanes_forward);
+    }
+    if (!parsed_way.turn_lanes_backward.empty())
+    {
+        parsed_way.turn_lane_description_backward =
+            parseTurnLaneString(parsed_way.turn_lanes_backward);
+    }
+}
+
 /**
  * Takes the geometry contained in the ```input_way``` and the tags computed
  * by the lua profile inside ```parsed_way``` and computes all edge segments.
@@ -142,82 +232,15 @@ void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const Extracti
 
     // FIXME this need to be moved into the profiles
     const guidance::RoadClassification road_classification = parsed_way.road_classification;
-    const auto laneStringToDescription = [](const std::string &lane_string) -> TurnLaneDescription {
-        if (lane_string.empty())
-            return {};
-
-        TurnLaneDescription lane_description;
-
-        typedef boost::tokenizer<boost::char_separator<char>> tokenizer;
-        boost::char_separator<char> sep("|", "", boost::keep_empty_tokens);
-        boost::char_separator<char> inner_sep(";", "");
-        tokenizer tokens(lane_string, sep);
-
-        const constexpr std::size_t num_osm_tags = 11;
-        const constexpr char *osm_lane_strings[num_osm_tags] = {"none",
-                                                                "through",
-                                                                "sharp_left",
-                                                                "left",
-                                                                "slight_left",
-                                                                "slight_right",
-                                                                "right",
-                                                                "sharp_right",
-                                                                "reverse",
-                                                                "merge_to_left",
-                                                                "merge_to_right"};
-
-        const constexpr TurnLaneType::Mask masks_by_osm_string[num_osm_tags + 1] = {
-            TurnLaneType::none,
-            TurnLaneType::straight,
-            TurnLaneType::sharp_left,
-            TurnLaneType::left,
-            TurnLaneType::slight_left,
-            TurnLaneType::slight_right,
-            TurnLaneType::right,
-            TurnLaneType::sharp_right,
-            TurnLaneType::uturn,
-            TurnLaneType::merge_to_left,
-            TurnLaneType::merge_to_right,
-            TurnLaneType::empty}; // fallback, if string not found
-
-        for (auto iter = tokens.begin(); iter != tokens.end(); ++iter)
-        {
-            tokenizer inner_tokens(*iter, inner_sep);
-            guidance::TurnLaneType::Mask lane_mask = inner_tokens.begin() == inner_tokens.end()
-                                                         ? TurnLaneType::none
-                                                         : TurnLaneType::empty;
-            for (auto token_itr = inner_tokens.begin(); token_itr != inner_tokens.end();
-                 ++token_itr)
-            {
-                auto position =
-                    std::find(osm_lane_strings, osm_lane_strings + num_osm_tags, *token_itr);
-                const auto translated_mask =
-                    masks_by_osm_string[std::distance(osm_lane_strings, position)];
-                if (translated_mask == TurnLaneType::empty)
-                {
-                    // if we have unsupported tags, don't handle them
-                    util::SimpleLogger().Write(logDEBUG) << "Unsupported lane tag found: \""
-                                                         << *token_itr << "\"";
-                    return {};
-                }
-
-                // In case of multiple times the same lane indicators withn a lane, as in
-                // "left;left|.."  or-ing the masks generates a single "left" enum.
-                // Which is fine since this is data issue and we can't represent it anyway.
-                lane_mask |= translated_mask;
-            }
-            // add the lane to the description
-            lane_description.push_back(lane_mask);
-        }
-        return lane_description;
-    };
 
     // convert the lane description into an ID and, if necessary, remembr the description in the
     // description_map
-    const auto requestId = [&](const std::string &lane_string) {
+    const auto requestId = [&](const std::string &lane_string,
+                               const boost::optional<TurnLaneDescription> &parsed_description) {
         if (lane_string.empty())
             return INVALID_LANE_DESCRIPTIONID;
-        TurnLaneDescription lane_description = laneStringToDescription(std::move(lane_string));
+        const TurnLaneDescription lane_description =
+            parsed_description ? *parsed_description : parseTurnLaneString(lane_string);
 
         const auto lane_description_itr = lane_description_map.find(lane_description);
         if (lane_description_itr == lane_description_map.end())
@@ -236,8 +259,10 @@ void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const Extracti
     // Deduplicates street names, refs, destinations, pronunciation based on the string_map.
     // In case we do not already store the key, inserts (key, id) tuple and return id.
     // Otherwise fetches the id based on the name and returns it without insertion.
-    const auto turn_lane_id_forward = requestId(parsed_way.turn_lanes_forward);
-    const auto turn_lane_id_backward = requestId(parsed_way.turn_lanes_backward);
+    const auto turn_lane_id_forward =
+        requestId(parsed_way.turn_lanes_forward, parsed_way.turn_lane_description_forward);
+    const auto turn_lane_id_backward =
+        requestId(parsed_way.turn_lanes_backward, parsed_way.turn_lane_description_backward);
 
     const constexpr auto MAX_STRING_LENGTH = 255u;
     // Get the unique identifier for the street name, destination, and ref
@@ -332,7 +357,8 @@ void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const Extracti
                                           parsed_way.backward_travel_mode,
                                           false,
                                           turn_lane_id_backward,
-                                          road_classification));
+                                          road_classification,
+                                          parsed_way.classes));
             });
 
         external_memory.way_start_end_id_list.push_back(
@@ -364,7 +390,8 @@ void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const Extracti
                                           parsed_way.forward_travel_mode,
                                           split_edge,
                                           turn_lane_id_forward,
-                                          road_classification));
+                                          road_classification,
+                                          parsed_way.classes));
             });
         if (split_edge)
         {
@@ -386,7 +413,8 @@ void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const Extracti
                         parsed_way.backward_travel_mode,
                         true,
                         turn_lane_id_backward,
-                        road_classification));
+                        road_classification,
+                        parsed_way.classes));
                 });
         }
 
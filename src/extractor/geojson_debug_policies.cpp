@@ -10,7 +10,7 @@ namespace extractor
 {
 
 IntersectionPrinter::IntersectionPrinter(
-    const util::NodeBasedDynamicGraph &node_based_graph,
+    const util::NodeBasedStaticGraph &node_based_graph,
     const std::vector<extractor::QueryNode> &node_coordinates,
     const extractor::guidance::CoordinateExtractor &coordinate_extractor)
     : node_based_graph(node_based_graph), node_coordinates(node_coordinates),
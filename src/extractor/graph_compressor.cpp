@@ -4,15 +4,153 @@
 #include "extractor/restriction_map.hpp"
 #include "util/dynamic_graph.hpp"
 #include "util/node_based_graph.hpp"
-#include "util/percent.hpp"
 
 #include "util/simple_logger.hpp"
 
+#include <boost/assert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/concurrent_vector.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 namespace osrm
 {
 namespace extractor
 {
 
+namespace
+{
+using EdgeGeometry = std::pair<EdgeID, CompressedEdgeContainer::OnewayEdgeBucket>;
+
+// A maximal path of nodes that are compressible on their own, between two nodes that are not.
+struct CompressibleChain
+{
+    NodeID source;
+    NodeID target;
+    // the interior nodes in order from source to target
+    std::vector<NodeID> nodes;
+    // the serial order compresses the interior node with the largest id last
+    NodeID last_node;
+    bool endpoints_adjacent;
+    // chains that can interact with other chains are compressed node by node in serial order
+    bool serial;
+    // whether the last node gets compressed as well, it is kept if source and target are adjacent
+    bool collapse;
+    std::vector<EdgeGeometry> geometries;
+
+    std::pair<NodeID, NodeID> Endpoints() const
+    {
+        return std::minmax(source, target);
+    }
+};
+
+// Merges a path of edges into its first edge, with the same result as compressing the nodes
+// between them one by one: the first edge gets the summed distance, the last valid lane
+// description and the target of the last edge, its geometry holds the target and distance of
+// every edge of the path.
+void mergePath(util::NodeBasedDynamicGraph &graph,
+               const std::vector<EdgeID> &path,
+               std::vector<EdgeGeometry> &geometries)
+{
+    BOOST_ASSERT(!path.empty());
+    if (path.size() < 2)
+        return;
+
+    CompressedEdgeContainer::OnewayEdgeBucket geometry;
+    geometry.reserve(path.size());
+    int distance = 0;
+    LaneDescriptionID lane_description_id = INVALID_LANE_DESCRIPTIONID;
+    for (const auto edge : path)
+    {
+        const auto &data = graph.GetEdgeData(edge);
+        geometry.push_back({graph.GetTarget(edge), data.distance});
+        distance += data.distance;
+        if (data.lane_description_id != INVALID_LANE_DESCRIPTIONID)
+            lane_description_id = data.lane_description_id;
+    }
+
+    const EdgeID surviving_edge = path.front();
+    auto &data = graph.GetEdgeData(surviving_edge);
+    data.distance = distance;
+    data.lane_description_id = lane_description_id;
+    graph.SetTarget(surviving_edge, graph.GetTarget(path.back()));
+    geometries.emplace_back(surviving_edge, std::move(geometry));
+}
+
+// Compresses all interior nodes of a chain but the kept one (SPECIAL_NODEID for none). Only
+// touches the edges of the interior nodes and the edges of source and target into the chain,
+// which belong to no other chain. Deleting the edges of the compressed nodes is left to the
+// caller.
+void compressChain(util::NodeBasedDynamicGraph &graph,
+                   CompressibleChain &chain,
+                   const NodeID kept_node)
+{
+    const auto otherEdge = [&graph](const NodeID node, const NodeID neighbor) {
+        const EdgeID first = graph.BeginEdges(node);
+        return graph.GetTarget(first) == neighbor ? first + 1 : first;
+    };
+
+    const std::size_t size = chain.nodes.size();
+    // to_target[i] leads from the i-th node towards target, to_source[i] towards source
+    std::vector<EdgeID> to_target(size + 1);
+    std::vector<EdgeID> to_source(size + 1);
+    to_target[0] = graph.FindEdge(chain.source, chain.nodes.front());
+    to_source[size] = graph.FindEdge(chain.target, chain.nodes.back());
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        const NodeID previous = i == 0 ? chain.source : chain.nodes[i - 1];
+        to_target[i + 1] = otherEdge(chain.nodes[i], previous);
+        const NodeID next = i + 1 == size ? chain.target : chain.nodes[i + 1];
+        to_source[i] = otherEdge(chain.nodes[i], next);
+    }
+
+    // splits the chain at the kept node into two paths per direction
+    std::size_t split = size;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        if (chain.nodes[i] == kept_node)
+            split = i;
+    }
+
+    const auto mergeRange = [&](const std::vector<EdgeID> &edges,
+                                const std::size_t first,
+                                const std::size_t last,
+                                const bool reversed) {
+        std::vector<EdgeID> path;
+        path.reserve(last - first + 1);
+        if (reversed)
+        {
+            for (std::size_t i = last + 1; i-- > first;)
+                path.push_back(edges[i]);
+        }
+        else
+        {
+            for (std::size_t i = first; i <= last; ++i)
+                path.push_back(edges[i]);
+        }
+        mergePath(graph, path, chain.geometries);
+    };
+
+    if (split == size)
+    {
+        mergeRange(to_target, 0, size, false);
+        mergeRange(to_source, 0, size, true);
+    }
+    else
+    {
+        mergeRange(to_target, 0, split, false);
+        mergeRange(to_source, 0, split, true);
+        mergeRange(to_target, split + 1, size, false);
+        mergeRange(to_source, split + 1, size, true);
+    }
+}
+}
+
 void GraphCompressor::Compress(const std::unordered_set<NodeID> &barrier_nodes,
                                const std::unordered_set<NodeID> &traffic_lights,
                                RestrictionMap &restriction_map,
@@ -22,11 +160,183 @@ void GraphCompressor::Compress(const std::unordered_set<NodeID> &barrier_nodes,
     const unsigned original_number_of_nodes = graph.GetNumberOfNodes();
     const unsigned original_number_of_edges = graph.GetNumberOfEdges();
 
-    util::Percent progress(original_number_of_nodes);
+    // Whether a node can be compressed judging by itself and its two edges. Compressing a node
+    // keeps the attributes of the combined edges, so this does not change while compressing.
+    // What does change is whether the two neighbours are adjacent, which is checked per chain.
+    const auto isCompressible = [&](const NodeID node_v) {
+        if (2 != graph.GetOutDegree(node_v) ||
+            barrier_nodes.end() != barrier_nodes.find(node_v) ||
+            restriction_map.IsViaNode(node_v) ||
+            traffic_lights.end() != traffic_lights.find(node_v))
+        {
+            return false;
+        }
+
+        const bool reverse_edge_order = graph.GetEdgeData(graph.BeginEdges(node_v)).reversed;
+        const EdgeID forward_e2 = graph.BeginEdges(node_v) + reverse_edge_order;
+        const EdgeID reverse_e2 = graph.BeginEdges(node_v) + 1 - reverse_edge_order;
+        const NodeID node_w = graph.GetTarget(forward_e2);
+        const NodeID node_u = graph.GetTarget(reverse_e2);
+        const EdgeID forward_e1 = graph.FindEdge(node_u, node_v);
+        const EdgeID reverse_e1 = graph.FindEdge(node_w, node_v);
+        BOOST_ASSERT(SPECIAL_EDGEID != forward_e1);
+        BOOST_ASSERT(SPECIAL_EDGEID != reverse_e1);
+
+        const EdgeData &fwd_edge_data1 = graph.GetEdgeData(forward_e1);
+        const EdgeData &rev_edge_data1 = graph.GetEdgeData(reverse_e1);
+        const EdgeData &fwd_edge_data2 = graph.GetEdgeData(forward_e2);
+        const EdgeData &rev_edge_data2 = graph.GetEdgeData(reverse_e2);
+        return fwd_edge_data1.name_id == rev_edge_data1.name_id &&
+               fwd_edge_data2.name_id == rev_edge_data2.name_id &&
+               fwd_edge_data1.CanCombineWith(fwd_edge_data2) &&
+               rev_edge_data1.CanCombineWith(rev_edge_data2);
+    };
+
+    std::vector<char> compressible(original_number_of_nodes);
+    tbb::parallel_for(tbb::blocked_range<NodeID>(0, original_number_of_nodes),
+                      [&](const tbb::blocked_range<NodeID> &range) {
+                          for (auto node = range.begin(); node != range.end(); ++node)
+                          {
+                              compressible[node] = isCompressible(node);
+                          }
+                      });
+
+    // Walks every chain from both ends, the walk from the end with the smaller endpoint records
+    // it. Cycles of compressible nodes have no end and are left to the serial compression.
+    tbb::concurrent_vector<CompressibleChain> chains;
+    tbb::parallel_for(
+        tbb::blocked_range<NodeID>(0, original_number_of_nodes),
+        [&](const tbb::blocked_range<NodeID> &range) {
+            for (auto node = range.begin(); node != range.end(); ++node)
+            {
+                if (!compressible[node])
+                    continue;
+
+                for (const auto start_edge : graph.GetAdjacentEdgeRange(node))
+                {
+                    const NodeID source = graph.GetTarget(start_edge);
+                    if (compressible[source])
+                        continue;
+
+                    CompressibleChain chain;
+                    chain.source = source;
+                    chain.nodes.push_back(node);
+                    // back_edge is the edge of the current node to the previous one
+                    NodeID current = node;
+                    EdgeID back_edge = start_edge;
+                    while (true)
+                    {
+                        const EdgeID first = graph.BeginEdges(current);
+                        const NodeID next = graph.GetTarget(back_edge == first ? first + 1 : first);
+                        if (!compressible[next])
+                        {
+                            chain.target = next;
+                            break;
+                        }
+                        back_edge = graph.FindEdge(next, current);
+                        current = next;
+                        chain.nodes.push_back(current);
+                    }
+
+                    const bool is_recorded =
+                        chain.source != chain.target
+                            ? chain.source < chain.target
+                            : (chain.nodes.size() > 1
+                                   ? chain.nodes.front() < chain.nodes.back()
+                                   : start_edge == graph.BeginEdges(node));
+                    if (!is_recorded)
+                        continue;
+
+                    chain.last_node = *std::max_element(chain.nodes.begin(), chain.nodes.end());
+                    chain.endpoints_adjacent =
+                        graph.FindEdgeInEitherDirection(chain.source, chain.target) !=
+                        SPECIAL_EDGEID;
+                    // Only via nodes get their restrictions fixed up, a chain between two other
+                    // nodes never touches the restriction map.
+                    chain.serial = chain.source == chain.target ||
+                                   restriction_map.IsViaNode(chain.source) ||
+                                   restriction_map.IsViaNode(chain.target);
+                    chain.collapse = false;
+                    chains.push_back(std::move(chain));
+                }
+            }
+        });
+
+    // Chains between the same endpoints block each other: the one the serial order finishes
+    // first collapses into an edge between the endpoints, the others keep their last node.
+    std::vector<CompressibleChain> sorted_chains(std::make_move_iterator(chains.begin()),
+                                                 std::make_move_iterator(chains.end()));
+    chains.clear();
+    tbb::parallel_sort(sorted_chains.begin(),
+                       sorted_chains.end(),
+                       [](const CompressibleChain &lhs, const CompressibleChain &rhs) {
+                           return std::make_pair(lhs.Endpoints(), lhs.last_node) <
+                                  std::make_pair(rhs.Endpoints(), rhs.last_node);
+                       });
+    for (auto group_begin = sorted_chains.begin(); group_begin != sorted_chains.end();)
+    {
+        const auto group_end = std::find_if(
+            group_begin, sorted_chains.end(), [&group_begin](const CompressibleChain &chain) {
+                return chain.Endpoints() != group_begin->Endpoints();
+            });
+        const bool serial = std::any_of(group_begin, group_end, [](const CompressibleChain &chain) {
+            return chain.serial;
+        });
+        for (auto chain = group_begin; chain != group_end; ++chain)
+        {
+            chain->serial = serial;
+        }
+        group_begin->collapse = !group_begin->endpoints_adjacent;
+        group_begin = group_end;
+    }
+
+    // nodes of cycles and of serial chains are compressed one by one below
+    std::vector<char> &serial_nodes = compressible;
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, sorted_chains.size()),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          for (auto index = range.begin(); index != range.end(); ++index)
+                          {
+                              auto &chain = sorted_chains[index];
+                              if (chain.serial)
+                                  continue;
+                              for (const auto node : chain.nodes)
+                              {
+                                  serial_nodes[node] = false;
+                              }
+                              compressChain(graph,
+                                            chain,
+                                            chain.collapse ? SPECIAL_NODEID : chain.last_node);
+                          }
+                      });
+
+    // the geometries of all chains are added and the edges of compressed nodes deleted in order
+    for (auto &chain : sorted_chains)
+    {
+        if (chain.serial)
+            continue;
+        for (auto &geometry : chain.geometries)
+        {
+            geometry_compressor.AddCompressedEdge(geometry.first, std::move(geometry.second));
+        }
+        for (const auto node_v : chain.nodes)
+        {
+            if (!chain.collapse && node_v == chain.last_node)
+                continue;
+            const bool reverse_edge_order = graph.GetEdgeData(graph.BeginEdges(node_v)).reversed;
+            const EdgeID forward_e2 = graph.BeginEdges(node_v) + reverse_edge_order;
+            const EdgeID reverse_e2 = graph.BeginEdges(node_v) + 1 - reverse_edge_order;
+            graph.DeleteEdge(node_v, forward_e2);
+            graph.DeleteEdge(node_v, reverse_e2);
+        }
+    }
+    std::vector<CompressibleChain>().swap(sorted_chains);
 
     for (const NodeID node_v : util::irange(0u, original_number_of_nodes))
     {
-        progress.PrintStatus(node_v);
+        if (!serial_nodes[node_v])
+        {
+            continue;
+        }
 
         // only contract degree 2 vertices
         if (2 != graph.GetOutDegree(node_v))
@@ -2,6 +2,8 @@
 #include "extractor/guidance/constants.hpp"
 #include "extractor/guidance/toolkit.hpp"
 
+#include "util/integer_range.hpp"
+
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
@@ -13,6 +15,9 @@
 
 #include <boost/range/algorithm/transform.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 namespace osrm
 {
 namespace extractor
@@ -41,7 +46,7 @@ const constexpr std::uint16_t ASSUMED_LANE_COUNT = 2;
 }
 
 CoordinateExtractor::CoordinateExtractor(
-    const util::NodeBasedDynamicGraph &node_based_graph,
+    const util::NodeBasedStaticGraph &node_based_graph,
     const extractor::CompressedEdgeContainer &compressed_geometries,
     const std::vector<extractor::QueryNode> &node_coordinates)
     : node_based_graph(node_based_graph), compressed_geometries(compressed_geometries),
@@ -49,12 +54,62 @@ CoordinateExtractor::CoordinateExtractor(
 {
 }
 
+void CoordinateExtractor::CacheCoordinatesAlongRoads()
+{
+    const auto number_of_nodes = node_based_graph.GetNumberOfNodes();
+    std::vector<std::uint8_t> lanes(number_of_nodes);
+    // the edge ids of the graph can have gaps
+    EdgeID number_of_edges = 0;
+    for (const auto node : util::irange(0u, number_of_nodes))
+    {
+        lanes[node] = getLaneCountAtIntersection(node, node_based_graph);
+        number_of_edges = std::max(number_of_edges, node_based_graph.EndEdges(node));
+    }
+
+    std::vector<CachedRoadCoordinates> coordinates(number_of_edges);
+    const auto cache_roads_of_nodes = [&](const tbb::blocked_range<NodeID> &range) {
+        for (auto node = range.begin(); node != range.end(); ++node)
+        {
+            for (const auto edge : node_based_graph.GetAdjacentEdgeRange(node))
+            {
+                const auto to_node = node_based_graph.GetTarget(edge);
+                coordinates[edge] = {
+                    ComputeCoordinateAlongRoad(node, edge, false, to_node, lanes[node]),
+                    ComputeCoordinateAlongRoad(node, edge, true, to_node, lanes[to_node])};
+            }
+        }
+    };
+    tbb::parallel_for(tbb::blocked_range<NodeID>(0, number_of_nodes), cache_roads_of_nodes);
+
+    cached_coordinates = std::move(coordinates);
+    cached_lanes = std::move(lanes);
+}
+
 util::Coordinate
 CoordinateExtractor::GetCoordinateAlongRoad(const NodeID intersection_node,
                                             const EdgeID turn_edge,
                                             const bool traversed_in_reverse,
                                             const NodeID to_node,
                                             const std::uint8_t intersection_lanes) const
+{
+    // the cache holds the coordinates for the lane counts of the intersections at the ends of the
+    // road, the turn happens at to_node if the road is traversed in reverse
+    if (turn_edge < cached_coordinates.size() && to_node == node_based_graph.GetTarget(turn_edge) &&
+        intersection_lanes == cached_lanes[traversed_in_reverse ? to_node : intersection_node])
+    {
+        const auto &cached = cached_coordinates[turn_edge];
+        return traversed_in_reverse ? cached.from_target : cached.from_source;
+    }
+    return ComputeCoordinateAlongRoad(
+        intersection_node, turn_edge, traversed_in_reverse, to_node, intersection_lanes);
+}
+
+util::Coordinate
+CoordinateExtractor::ComputeCoordinateAlongRoad(const NodeID intersection_node,
+                                                const EdgeID turn_edge,
+                                                const bool traversed_in_reverse,
+                                                const NodeID to_node,
+                                                const std::uint8_t intersection_lanes) const
 {
     const auto considered_lanes =
         (intersection_lanes == 0) ? ASSUMED_LANE_COUNT : intersection_lanes;
@@ -351,8 +406,9 @@ CoordinateExtractor::GetCoordinatesAlongRoad(const NodeID intersection_node,
         // traversed_in_reverse
         if (traversed_in_reverse)
         {
-            std::transform(geometry.rbegin(),
-                           geometry.rend(),
+            const auto reversed_geometry = geometry.Reversed();
+            std::transform(reversed_geometry.begin(),
+                           reversed_geometry.end(),
                            std::back_inserter(result),
                            compressedGeometryToCoordinate);
             result.push_back(node_coordinates[intersection_node]);
@@ -94,7 +94,7 @@ bool Intersection::valid() const
 }
 
 std::uint8_t
-Intersection::getHighestConnectedLaneCount(const util::NodeBasedDynamicGraph &graph) const
+Intersection::getHighestConnectedLaneCount(const util::NodeBasedStaticGraph &graph) const
 {
     BOOST_ASSERT(valid()); // non empty()
 
@@ -22,7 +22,7 @@ namespace guidance
 {
 
 IntersectionGenerator::IntersectionGenerator(
-    const util::NodeBasedDynamicGraph &node_based_graph,
+    const util::NodeBasedStaticGraph &node_based_graph,
     const RestrictionMap &restriction_map,
     const std::unordered_set<NodeID> &barrier_nodes,
     const std::vector<QueryNode> &node_info_list,
@@ -31,6 +31,7 @@ IntersectionGenerator::IntersectionGenerator(
       barrier_nodes(barrier_nodes), node_info_list(node_info_list),
       coordinate_extractor(node_based_graph, compressed_edge_container, node_info_list)
 {
+    coordinate_extractor.CacheCoordinatesAlongRoads();
 }
 
 Intersection IntersectionGenerator::operator()(const NodeID from_node, const EdgeID via_eid) const
@@ -53,11 +54,56 @@ Intersection IntersectionGenerator::operator()(const NodeID from_node, const Edg
 // marked as invalid and only needed for intersection classification.
 Intersection IntersectionGenerator::GetConnectedRoads(const NodeID from_node,
                                                       const EdgeID via_eid) const
+{
+    return GetConnectedRoads(
+        from_node, via_eid, ComputeIntersectionShape(node_based_graph.GetTarget(via_eid)));
+}
+
+IntersectionShape IntersectionGenerator::ComputeIntersectionShape(const NodeID node) const
+{
+    IntersectionShape shape;
+    shape.node = node;
+    shape.lanes = getLaneCountAtIntersection(node, node_based_graph);
+    shape.is_barrier = barrier_nodes.find(node) != barrier_nodes.end();
+
+    const auto out_degree = node_based_graph.GetOutDegree(node);
+    shape.roads.reserve(out_degree);
+    std::size_t number_of_emmiting_bidirectional_edges = 0;
+    for (const EdgeID onto_edge : node_based_graph.GetAdjacentEdgeRange(node))
+    {
+        BOOST_ASSERT(onto_edge != SPECIAL_EDGEID);
+        const NodeID to_node = node_based_graph.GetTarget(onto_edge);
+        // the default distance we lookahead on a road. This distance prevents small mapping
+        // errors to impact the turn angles.
+        shape.roads.push_back({onto_edge,
+                               to_node,
+                               coordinate_extractor.GetCoordinateAlongRoad(
+                                   node, onto_edge, !INVERT, to_node, shape.lanes)});
+
+        // u-turns are only relevant for dead-end streets, they are never allowed at barriers
+        if (out_degree > 1 && !shape.is_barrier)
+        {
+            const auto reverse_edge = node_based_graph.FindEdge(to_node, node);
+            BOOST_ASSERT(reverse_edge != SPECIAL_EDGEID);
+            if (!node_based_graph.GetEdgeData(reverse_edge).reversed)
+            {
+                ++number_of_emmiting_bidirectional_edges;
+            }
+        }
+    }
+    shape.is_dead_end = number_of_emmiting_bidirectional_edges <= 1;
+    return shape;
+}
+
+Intersection IntersectionGenerator::GetConnectedRoads(const NodeID from_node,
+                                                      const EdgeID via_eid,
+                                                      const IntersectionShape &shape) const
 {
     Intersection intersection;
     const NodeID turn_node = node_based_graph.GetTarget(via_eid);
+    BOOST_ASSERT(shape.node == turn_node);
     // reserve enough items (+ the possibly missing u-turn edge)
-    intersection.reserve(node_based_graph.GetOutDegree(turn_node) + 1);
+    intersection.reserve(shape.roads.size() + 1);
     const NodeID only_restriction_to_node = [&]() {
         // If only restrictions refer to invalid ways somewhere far away, we rather ignore the
         // restriction than to not route over the intersection at all.
@@ -73,18 +119,22 @@ Intersection IntersectionGenerator::GetConnectedRoads(const NodeID from_node,
         // Ignore broken only restrictions.
         return SPECIAL_NODEID;
     }();
-    const bool is_barrier_node = barrier_nodes.find(turn_node) != barrier_nodes.end();
+    const bool is_barrier_node = shape.is_barrier;
 
     bool has_uturn_edge = false;
     bool uturn_could_be_valid = false;
     const util::Coordinate turn_coordinate = node_info_list[turn_node];
 
-    const auto intersection_lanes = getLaneCountAtIntersection(turn_node, node_based_graph);
+    // The first coordinate (the origin) can depend on the number of lanes turning onto,
+    // just as the target coordinate can. Here we compute the corrected coordinate for the
+    // incoming edge.
+    const auto first_coordinate = coordinate_extractor.GetCoordinateAlongRoad(
+        from_node, via_eid, INVERT, turn_node, shape.lanes);
 
-    for (const EdgeID onto_edge : node_based_graph.GetAdjacentEdgeRange(turn_node))
+    for (const auto &road : shape.roads)
     {
-        BOOST_ASSERT(onto_edge != SPECIAL_EDGEID);
-        const NodeID to_node = node_based_graph.GetTarget(onto_edge);
+        const EdgeID onto_edge = road.eid;
+        const NodeID to_node = road.to_node;
         const auto &onto_data = node_based_graph.GetEdgeData(onto_edge);
 
         bool turn_is_valid =
@@ -102,45 +152,21 @@ Intersection IntersectionGenerator::GetConnectedRoads(const NodeID from_node,
         auto angle = 0.;
         double bearing = 0.;
 
-        // The first coordinate (the origin) can depend on the number of lanes turning onto,
-        // just as the target coordinate can. Here we compute the corrected coordinate for the
-        // incoming edge.
-        const auto first_coordinate = coordinate_extractor.GetCoordinateAlongRoad(
-            from_node, via_eid, INVERT, turn_node, intersection_lanes);
-
         if (from_node == to_node)
         {
             bearing = util::coordinate_calculation::bearing(turn_coordinate, first_coordinate);
             uturn_could_be_valid = turn_is_valid;
             if (turn_is_valid && !is_barrier_node)
             {
-                // we only add u-turns for dead-end streets.
-                if (node_based_graph.GetOutDegree(turn_node) > 1)
-                {
-                    auto number_of_emmiting_bidirectional_edges = 0;
-                    for (auto edge : node_based_graph.GetAdjacentEdgeRange(turn_node))
-                    {
-                        auto target = node_based_graph.GetTarget(edge);
-                        auto reverse_edge = node_based_graph.FindEdge(target, turn_node);
-                        BOOST_ASSERT(reverse_edge != SPECIAL_EDGEID);
-                        if (!node_based_graph.GetEdgeData(reverse_edge).reversed)
-                        {
-                            ++number_of_emmiting_bidirectional_edges;
-                        }
-                    }
-                    // is a dead-end, only possible road is to go back
-                    turn_is_valid = number_of_emmiting_bidirectional_edges <= 1;
-                }
+                // we only add u-turns for dead-end streets, the only possible road is to go back
+                turn_is_valid = shape.is_dead_end;
             }
             has_uturn_edge = true;
             BOOST_ASSERT(angle >= 0. && angle < std::numeric_limits<double>::epsilon());
         }
         else
         {
-            // the default distance we lookahead on a road. This distance prevents small mapping
-            // errors to impact the turn angles.
-            const auto third_coordinate = coordinate_extractor.GetCoordinateAlongRoad(
-                turn_node, onto_edge, !INVERT, to_node, intersection_lanes);
+            const auto &third_coordinate = road.coordinate;
 
             angle = util::coordinate_calculation::computeAngle(
                 first_coordinate, turn_coordinate, third_coordinate);
@@ -9,7 +9,7 @@
 #include <algorithm>
 #include <cstddef>
 
-using EdgeData = osrm::util::NodeBasedDynamicGraph::EdgeData;
+using EdgeData = osrm::util::NodeBasedStaticGraph::EdgeData;
 using osrm::util::guidance::getTurnDirection;
 
 namespace osrm
@@ -27,7 +27,7 @@ inline bool requiresAnnouncement(const EdgeData &from, const EdgeData &to)
 }
 }
 
-IntersectionHandler::IntersectionHandler(const util::NodeBasedDynamicGraph &node_based_graph,
+IntersectionHandler::IntersectionHandler(const util::NodeBasedStaticGraph &node_based_graph,
                                          const std::vector<QueryNode> &node_info_list,
                                          const util::NameTable &name_table,
                                          const SuffixTable &street_name_suffix_table,
@@ -10,7 +10,7 @@ namespace guidance
 {
 
 IntersectionNormalizer::IntersectionNormalizer(
-    const util::NodeBasedDynamicGraph &node_based_graph,
+    const util::NodeBasedStaticGraph &node_based_graph,
     const std::vector<extractor::QueryNode> &node_coordinates,
     const util::NameTable &name_table,
     const SuffixTable &street_name_suffix_table,
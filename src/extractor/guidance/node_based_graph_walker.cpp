@@ -9,7 +9,7 @@ namespace guidance
 {
 
 // ---------------------------------------------------------------------------------
-NodeBasedGraphWalker::NodeBasedGraphWalker(const util::NodeBasedDynamicGraph &node_based_graph,
+NodeBasedGraphWalker::NodeBasedGraphWalker(const util::NodeBasedStaticGraph &node_based_graph,
                                            const IntersectionGenerator &intersection_generator)
     : node_based_graph(node_based_graph), intersection_generator(intersection_generator)
 {
@@ -17,7 +17,7 @@ NodeBasedGraphWalker::NodeBasedGraphWalker(const util::NodeBasedDynamicGraph &no
 
 LengthLimitedCoordinateAccumulator::LengthLimitedCoordinateAccumulator(
     const extractor::guidance::CoordinateExtractor &coordinate_extractor,
-    const util::NodeBasedDynamicGraph &node_based_graph,
+    const util::NodeBasedStaticGraph &node_based_graph,
     const double max_length)
     : coordinate_extractor(coordinate_extractor), node_based_graph(node_based_graph),
       max_length(max_length), accumulated_length(0)
@@ -59,7 +59,7 @@ boost::optional<EdgeID> SelectRoadByNameOnlyChoiceAndStraightness::
 operator()(const NodeID /*nid*/,
            const EdgeID /*via_edge_id*/,
            const Intersection &intersection,
-           const util::NodeBasedDynamicGraph &node_based_graph) const
+           const util::NodeBasedStaticGraph &node_based_graph) const
 {
     BOOST_ASSERT(!intersection.empty());
     const auto comparator = [this, &node_based_graph](const ConnectedRoad &lhs,
@@ -9,7 +9,7 @@
 
 #include <boost/assert.hpp>
 
-using EdgeData = osrm::util::NodeBasedDynamicGraph::EdgeData;
+using EdgeData = osrm::util::NodeBasedStaticGraph::EdgeData;
 using osrm::util::guidance::getTurnDirection;
 using osrm::util::guidance::angularDeviation;
 
@@ -21,7 +21,7 @@ namespace guidance
 {
 
 SliproadHandler::SliproadHandler(const IntersectionGenerator &intersection_generator,
-                                 const util::NodeBasedDynamicGraph &node_based_graph,
+                                 const util::NodeBasedStaticGraph &node_based_graph,
                                  const std::vector<QueryNode> &node_info_list,
                                  const util::NameTable &name_table,
                                  const SuffixTable &street_name_suffix_table)
@@ -164,7 +164,7 @@ operator()(const NodeID, const EdgeID source_edge_id, Intersection intersection)
         return intersection;
 
     // Threshold check, if the intersection is too far away, don't bother continuing
-    const auto coordinate_extractor = intersection_generator.GetCoordinateExtractor();
+    const auto &coordinate_extractor = intersection_generator.GetCoordinateExtractor();
     const auto next_road_length = util::coordinate_calculation::getLength(
         coordinate_extractor.GetForwardCoordinatesAlongRoad(
             node_based_graph.GetTarget(source_edge_id), next_road.eid),
@@ -24,14 +24,14 @@ namespace extractor
 namespace guidance
 {
 
-using EdgeData = util::NodeBasedDynamicGraph::EdgeData;
+using EdgeData = util::NodeBasedStaticGraph::EdgeData;
 
 bool requiresAnnouncement(const EdgeData &from, const EdgeData &to)
 {
     return !from.CanCombineWith(to);
 }
 
-TurnAnalysis::TurnAnalysis(const util::NodeBasedDynamicGraph &node_based_graph,
+TurnAnalysis::TurnAnalysis(const util::NodeBasedStaticGraph &node_based_graph,
                            const std::vector<QueryNode> &node_info_list,
                            const RestrictionMap &restriction_map,
                            const std::unordered_set<NodeID> &barrier_nodes,
@@ -129,6 +129,14 @@ Intersection TurnAnalysis::operator()(const NodeID from_nid, const EdgeID via_ei
     return PostProcess(from_nid, via_eid, intersection_generator(from_nid, via_eid));
 }
 
+Intersection TurnAnalysis::operator()(const NodeID from_nid,
+                                      const EdgeID via_eid,
+                                      const IntersectionShape &shape) const
+{
+    return PostProcess(
+        from_nid, via_eid, intersection_generator.GetConnectedRoads(from_nid, via_eid, shape));
+}
+
 Intersection TurnAnalysis::PostProcess(const NodeID from_node,
                                        const EdgeID via_eid,
                                        Intersection intersection) const
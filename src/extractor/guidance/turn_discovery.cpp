@@ -16,7 +16,7 @@ bool findPreviousIntersection(const NodeID node_v,
                               const EdgeID via_edge,
                               const Intersection intersection,
                               const IntersectionGenerator &intersection_generator,
-                              const util::NodeBasedDynamicGraph &node_based_graph,
+                              const util::NodeBasedStaticGraph &node_based_graph,
                               // output parameters
                               NodeID &result_node,
                               EdgeID &result_via_edge,
@@ -36,7 +36,7 @@ bool findPreviousIntersection(const NodeID node_v,
      */
     const constexpr double COMBINE_DISTANCE_CUTOFF = 30;
 
-    const auto coordinate_extractor = intersection_generator.GetCoordinateExtractor();
+    const auto &coordinate_extractor = intersection_generator.GetCoordinateExtractor();
     const auto via_edge_length = util::coordinate_calculation::getLength(
         coordinate_extractor.GetForwardCoordinatesAlongRoad(node_v, via_edge),
         &util::coordinate_calculation::haversineDistance);
@@ -10,7 +10,7 @@
 
 #include <boost/assert.hpp>
 
-using EdgeData = osrm::util::NodeBasedDynamicGraph::EdgeData;
+using EdgeData = osrm::util::NodeBasedStaticGraph::EdgeData;
 using osrm::util::guidance::getTurnDirection;
 using osrm::util::guidance::angularDeviation;
 
@@ -33,7 +33,7 @@ bool isEndOfRoad(const ConnectedRoad &,
 }
 }
 
-TurnHandler::TurnHandler(const util::NodeBasedDynamicGraph &node_based_graph,
+TurnHandler::TurnHandler(const util::NodeBasedStaticGraph &node_based_graph,
                          const std::vector<QueryNode> &node_info_list,
                          const util::NameTable &name_table,
                          const SuffixTable &street_name_suffix_table,
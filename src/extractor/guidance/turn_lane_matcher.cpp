@@ -198,7 +198,7 @@ bool canMatchTrivially(const Intersection &intersection, const LaneDataVector &l
 
 Intersection triviallyMatchLanesToTurns(Intersection intersection,
                                         const LaneDataVector &lane_data,
-                                        const util::NodeBasedDynamicGraph &node_based_graph,
+                                        const util::NodeBasedStaticGraph &node_based_graph,
                                         const LaneDescriptionID lane_string_id,
                                         LaneDataIdMap &lane_data_to_id)
 {
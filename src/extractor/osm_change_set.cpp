@@ -0,0 +1,90 @@
+#include "extractor/osm_change_set.hpp"
+
+#include <osmium/io/any_input.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+
+#include <algorithm>
+
+namespace osrm
+{
+namespace extractor
+{
+
+namespace
+{
+// initial size of the buffer of visible objects, it grows as needed
+const constexpr std::size_t VISIBLE_OBJECTS_BUFFER_SIZE = 1024 * 1024;
+
+bool isOSMObject(const osmium::OSMEntity &entity)
+{
+    return entity.type() == osmium::item_type::node || entity.type() == osmium::item_type::way ||
+           entity.type() == osmium::item_type::relation;
+}
+}
+
+OSMChangeSet::OSMChangeSet(const std::vector<boost::filesystem::path> &change_paths)
+    : visible_objects(VISIBLE_OBJECTS_BUFFER_SIZE, osmium::memory::Buffer::auto_grow::yes),
+      number_of_deleted(0)
+{
+    // the versions are needed to find the latest one of objects changed more than once
+    std::vector<osmium::memory::Buffer> buffers;
+    std::vector<const osmium::OSMObject *> objects;
+    for (const auto &change_path : change_paths)
+    {
+        const osmium::io::File change_file(change_path.string());
+        osmium::io::Reader reader(change_file, osmium::io::read_meta::yes);
+        while (osmium::memory::Buffer buffer = reader.read())
+        {
+            for (const auto &entity : buffer)
+            {
+                if (isOSMObject(entity))
+                {
+                    objects.push_back(static_cast<const osmium::OSMObject *>(&entity));
+                }
+            }
+            // moving the buffer keeps its data in place
+            buffers.push_back(std::move(buffer));
+        }
+        reader.close();
+    }
+
+    // the latest version of every object comes first
+    std::sort(objects.begin(), objects.end(), osmium::object_order_type_id_reverse_version());
+    objects.erase(std::unique(objects.begin(), objects.end(), osmium::object_equal_type_id()),
+                  objects.end());
+
+    changed_objects.reserve(objects.size());
+    for (const auto *object : objects)
+    {
+        changed_objects.emplace_back(object->type(), object->id());
+        latest_timestamp = std::max(latest_timestamp, object->timestamp());
+        if (object->visible())
+        {
+            visible_objects.add_item(*object);
+            visible_objects.commit();
+        }
+        else
+        {
+            ++number_of_deleted;
+        }
+    }
+    std::sort(changed_objects.begin(), changed_objects.end());
+}
+
+bool OSMChangeSet::IsChanged(const osmium::OSMEntity &entity) const
+{
+    if (!isOSMObject(entity))
+    {
+        return false;
+    }
+    const auto &object = static_cast<const osmium::OSMObject &>(entity);
+    return std::binary_search(changed_objects.begin(),
+                              changed_objects.end(),
+                              std::make_pair(object.type(), object.id()));
+}
+
+osmium::memory::Buffer OSMChangeSet::MoveOutVisibleObjects() { return std::move(visible_objects); }
+
+} /* namespace extractor */
+} /* namespace osrm */
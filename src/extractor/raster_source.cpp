@@ -3,13 +3,220 @@
 #include "util/simple_logger.hpp"
 #include "util/timing_util.hpp"
 
+#include <algorithm>
+#include <cctype>
 #include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
 
 namespace osrm
 {
 namespace extractor
 {
 
+namespace
+{
+// A tiled raster is this header followed by the tiles in rows, each tile its values in rows.
+// Tiles at the right and bottom edge are padded to the full tile size. All numbers are in the
+// byte order of the machine that wrote the file.
+struct TiledRasterHeader
+{
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t tile_size;
+    std::uint64_t xdim;
+    std::uint64_t ydim;
+};
+static_assert(sizeof(TiledRasterHeader) == 32, "tiled raster header has padding");
+
+// "OSRMRAST" in little endian byte order
+const constexpr std::uint64_t TILED_RASTER_MAGIC = 0x545341524d52534fULL;
+const constexpr std::uint32_t TILED_RASTER_VERSION = 1;
+
+std::size_t TileShift(const std::size_t tile_size)
+{
+    std::size_t shift = 0;
+    while ((std::size_t{1} << shift) < tile_size)
+    {
+        ++shift;
+    }
+    return shift;
+}
+
+std::size_t NumberOfTiles(const std::size_t size, const std::size_t tile_size)
+{
+    return (size + tile_size - 1) / tile_size;
+}
+}
+
+bool RasterGrid::IsTiledRaster(const boost::filesystem::path &filepath)
+{
+    boost::filesystem::ifstream stream(filepath, std::ios::binary);
+    TiledRasterHeader header;
+    stream.read(reinterpret_cast<char *>(&header), sizeof(header));
+    return stream.gcount() == sizeof(header) && header.magic == TILED_RASTER_MAGIC;
+}
+
+void RasterGrid::MapTiledRaster(const boost::filesystem::path &filepath)
+{
+    tiled_file = std::make_shared<boost::iostreams::mapped_file_source>(filepath.string());
+    if (!tiled_file->is_open())
+    {
+        throw util::exception("Unable to map raster file.");
+    }
+
+    TiledRasterHeader header;
+    std::memcpy(&header, tiled_file->data(), sizeof(header));
+    if (header.version != TILED_RASTER_VERSION)
+    {
+        throw util::exception("Tiled raster source has version " +
+                              std::to_string(header.version) + ", expected " +
+                              std::to_string(TILED_RASTER_VERSION));
+    }
+    if (header.xdim != xdim || header.ydim != ydim)
+    {
+        throw util::exception("Tiled raster source has " + std::to_string(header.ydim) +
+                              " rows and " + std::to_string(header.xdim) + " columns, not " +
+                              std::to_string(ydim) + " and " + std::to_string(xdim));
+    }
+    if (header.tile_size == 0 || (header.tile_size & (header.tile_size - 1)) != 0)
+    {
+        throw util::exception("Tiled raster source has an invalid tile size.");
+    }
+
+    tile_shift = TileShift(header.tile_size);
+    tile_mask = header.tile_size - 1;
+    tiles_per_row = NumberOfTiles(xdim, header.tile_size);
+    const auto number_of_values =
+        (tiles_per_row * NumberOfTiles(ydim, header.tile_size)) << (2 * tile_shift);
+    if (tiled_file->size() != sizeof(header) + number_of_values * sizeof(std::int32_t))
+    {
+        throw util::exception("Tiled raster source is truncated.");
+    }
+    tiles = reinterpret_cast<const std::int32_t *>(tiled_file->data() + sizeof(header));
+}
+
+void WriteTiledRaster(const boost::filesystem::path &ascii_path,
+                      const boost::filesystem::path &tiled_path,
+                      const std::size_t xdim,
+                      const std::size_t ydim,
+                      const std::size_t tile_size)
+{
+    if (xdim == 0 || ydim == 0)
+    {
+        throw util::exception("Raster source needs at least one row and column.");
+    }
+    if (tile_size == 0 || (tile_size & (tile_size - 1)) != 0)
+    {
+        throw util::exception("Tile size has to be a power of two.");
+    }
+
+    boost::filesystem::ifstream input(ascii_path, std::ios::binary);
+    if (!input)
+    {
+        throw util::exception("Unable to open raster file " + ascii_path.string());
+    }
+    boost::filesystem::ofstream output(tiled_path, std::ios::binary);
+    if (!output)
+    {
+        throw util::exception("Unable to open " + tiled_path.string() + " for writing");
+    }
+
+    const TiledRasterHeader header{TILED_RASTER_MAGIC,
+                                   TILED_RASTER_VERSION,
+                                   static_cast<std::uint32_t>(tile_size),
+                                   xdim,
+                                   ydim};
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    const auto shift = TileShift(tile_size);
+    const auto mask = tile_size - 1;
+    // one row of tiles, filled by the rows of the grid it covers
+    std::vector<std::int32_t> tile_row(NumberOfTiles(xdim, tile_size) << (2 * shift));
+    std::size_t x = 0, y = 0;
+    const auto write_tile_row = [&] {
+        output.write(reinterpret_cast<const char *>(tile_row.data()),
+                     static_cast<std::streamsize>(tile_row.size() * sizeof(std::int32_t)));
+        std::fill(tile_row.begin(), tile_row.end(), 0);
+    };
+    const auto add_value = [&](const std::int32_t value) {
+        if (y == ydim)
+        {
+            throw util::exception("Raster source has more than " + std::to_string(ydim) +
+                                  " rows of " + std::to_string(xdim) + " values.");
+        }
+        tile_row[((x >> shift) << (2 * shift)) + ((y & mask) << shift) + (x & mask)] = value;
+        if (++x == xdim)
+        {
+            x = 0;
+            ++y;
+            if ((y & mask) == 0 || y == ydim)
+            {
+                write_tile_row();
+            }
+        }
+    };
+
+    // the values are parsed by hand, a number can span the chunks that are read
+    std::vector<char> chunk(1 << 20);
+    bool in_number = false, negative = false;
+    std::int64_t number = 0;
+    while (input)
+    {
+        input.read(chunk.data(), chunk.size());
+        const auto chunk_end = chunk.begin() + input.gcount();
+        for (auto itr = chunk.begin(); itr != chunk_end; ++itr)
+        {
+            const auto c = *itr;
+            if (c >= '0' && c <= '9')
+            {
+                number = number * 10 + (c - '0');
+                if (number > std::numeric_limits<std::int32_t>::max())
+                {
+                    throw util::exception("Raster source has a value out of range.");
+                }
+                in_number = true;
+            }
+            else if (c == '-' && !in_number && !negative)
+            {
+                negative = true;
+            }
+            else if (std::isspace(static_cast<unsigned char>(c)) && (in_number || !negative))
+            {
+                if (in_number)
+                {
+                    add_value(static_cast<std::int32_t>(negative ? -number : number));
+                }
+                in_number = negative = false;
+                number = 0;
+            }
+            else
+            {
+                throw util::exception("Failed to parse raster source correctly.");
+            }
+        }
+    }
+    if (negative && !in_number)
+    {
+        throw util::exception("Failed to parse raster source correctly.");
+    }
+    if (in_number)
+    {
+        add_value(static_cast<std::int32_t>(negative ? -number : number));
+    }
+    if (y != ydim)
+    {
+        throw util::exception("Raster source has fewer than " + std::to_string(ydim) +
+                              " rows of " + std::to_string(xdim) + " values.");
+    }
+    if (!output)
+    {
+        throw util::exception("Failed to write " + tiled_path.string());
+    }
+}
+
 RasterSource::RasterSource(RasterGrid _raster_data,
                            std::size_t _width,
                            std::size_t _height,
@@ -75,7 +282,7 @@ RasterDatum RasterSource::GetRasterInterpolate(const int lon, const int lat) con
                                       raster_data(right, bottom) * (fromLeft * fromTop))};
 }
 
-// Load raster source into memory
+// Load raster source into memory, or map it if it is tiled
 int SourceContainer::LoadRasterSource(const std::string &path_string,
                                       double xmin,
                                       double xmax,
@@ -89,6 +296,7 @@ int SourceContainer::LoadRasterSource(const std::string &path_string,
     const auto _ymin = static_cast<std::int32_t>(util::toFixed(util::FloatLatitude{ymin}));
     const auto _ymax = static_cast<std::int32_t>(util::toFixed(util::FloatLatitude{ymax}));
 
+    std::lock_guard<std::mutex> lock(load_mutex);
     const auto itr = LoadedSourcePaths.find(path_string);
     if (itr != LoadedSourcePaths.end())
     {
@@ -1,11 +1,17 @@
 #include "extractor/restriction_map.hpp"
 
+#include <boost/range/iterator_range.hpp>
+
+#include <algorithm>
+#include <tuple>
+
 namespace osrm
 {
 namespace extractor
 {
 
-RestrictionMap::RestrictionMap(const std::vector<TurnRestriction> &restriction_list) : m_count(0)
+RestrictionMap::RestrictionMap(const std::vector<TurnRestriction> &restriction_list)
+    : m_count(0), m_frozen(false)
 {
     // decompose restriction consisting of a start, via and end node into a
     // a pair of starting edge and a list of all end nodes
@@ -53,11 +59,105 @@ RestrictionMap::RestrictionMap(const std::vector<TurnRestriction> &restriction_l
     }
 }
 
+void RestrictionMap::Freeze()
+{
+    BOOST_ASSERT(!m_frozen);
+
+    // (via, start, bucket) of every restriction start, the buckets keep the order of their
+    // targets, which decides the is_only restriction returned
+    std::vector<std::tuple<NodeID, NodeID, unsigned>> sources;
+    sources.reserve(m_restriction_map.size());
+    for (const auto &entry : m_restriction_map)
+    {
+        sources.emplace_back(entry.first.via_node, entry.first.start_node, entry.second);
+    }
+    std::sort(sources.begin(), sources.end());
+
+    m_start_nodes.reserve(sources.size());
+    m_target_offsets.reserve(sources.size() + 1);
+    for (const auto &source : sources)
+    {
+        const auto via_node = std::get<0>(source);
+        if (m_via_nodes.empty() || m_via_nodes.back() != via_node)
+        {
+            m_via_nodes.push_back(via_node);
+            m_via_offsets.push_back(static_cast<std::uint32_t>(m_start_nodes.size()));
+        }
+        m_start_nodes.push_back(std::get<1>(source));
+        m_target_offsets.push_back(static_cast<std::uint32_t>(m_targets.size()));
+        const auto &bucket = m_restriction_bucket_list[std::get<2>(source)];
+        m_targets.insert(m_targets.end(), bucket.begin(), bucket.end());
+    }
+    m_via_offsets.push_back(static_cast<std::uint32_t>(m_start_nodes.size()));
+    m_target_offsets.push_back(static_cast<std::uint32_t>(m_targets.size()));
+
+    const auto max_via_node =
+        std::max_element(m_no_turn_via_node_set.begin(), m_no_turn_via_node_set.end());
+    if (max_via_node != m_no_turn_via_node_set.end())
+    {
+        m_is_via_node.resize(*max_via_node + 1, false);
+        for (const auto node : m_no_turn_via_node_set)
+        {
+            m_is_via_node[node] = true;
+        }
+    }
+
+    decltype(m_restriction_bucket_list)().swap(m_restriction_bucket_list);
+    decltype(m_restriction_map)().swap(m_restriction_map);
+    decltype(m_restriction_start_nodes)().swap(m_restriction_start_nodes);
+    decltype(m_no_turn_via_node_set)().swap(m_no_turn_via_node_set);
+    m_frozen = true;
+}
+
 bool RestrictionMap::IsViaNode(const NodeID node) const
 {
+    if (m_frozen)
+    {
+        return node < m_is_via_node.size() && m_is_via_node[node];
+    }
     return m_no_turn_via_node_set.find(node) != m_no_turn_via_node_set.end();
 }
 
+RestrictionMap::TargetRange RestrictionMap::GetTargets(const NodeID node_u,
+                                                       const NodeID node_v) const
+{
+    if (m_frozen)
+    {
+        if (!IsViaNode(node_v))
+        {
+            return {nullptr, nullptr};
+        }
+        const auto via = std::lower_bound(m_via_nodes.begin(), m_via_nodes.end(), node_v);
+        if (via == m_via_nodes.end() || *via != node_v)
+        {
+            return {nullptr, nullptr};
+        }
+        const auto via_index = via - m_via_nodes.begin();
+        const auto starts_begin = m_start_nodes.begin() + m_via_offsets[via_index];
+        const auto starts_end = m_start_nodes.begin() + m_via_offsets[via_index + 1];
+        const auto start = std::lower_bound(starts_begin, starts_end, node_u);
+        if (start == starts_end || *start != node_u)
+        {
+            return {nullptr, nullptr};
+        }
+        const auto start_index = start - m_start_nodes.begin();
+        return {m_targets.data() + m_target_offsets[start_index],
+                m_targets.data() + m_target_offsets[start_index + 1]};
+    }
+
+    if (!IsSourceNode(node_u))
+    {
+        return {nullptr, nullptr};
+    }
+    const auto restriction_iter = m_restriction_map.find({node_u, node_v});
+    if (restriction_iter == m_restriction_map.end())
+    {
+        return {nullptr, nullptr};
+    }
+    const auto &bucket = m_restriction_bucket_list.at(restriction_iter->second);
+    return {bucket.data(), bucket.data() + bucket.size()};
+}
+
 // Replaces start edge (v, w) with (u, w). Only start node changes.
 void RestrictionMap::FixupStartingTurnRestriction(const NodeID node_u,
                                                   const NodeID node_v,
@@ -66,6 +166,7 @@ void RestrictionMap::FixupStartingTurnRestriction(const NodeID node_u,
     BOOST_ASSERT(node_u != SPECIAL_NODEID);
     BOOST_ASSERT(node_v != SPECIAL_NODEID);
     BOOST_ASSERT(node_w != SPECIAL_NODEID);
+    BOOST_ASSERT(!m_frozen);
 
     if (!IsSourceNode(node_v))
     {
@@ -92,25 +193,13 @@ NodeID RestrictionMap::CheckForEmanatingIsOnlyTurn(const NodeID node_u, const No
     BOOST_ASSERT(node_u != SPECIAL_NODEID);
     BOOST_ASSERT(node_v != SPECIAL_NODEID);
 
-    if (!IsSourceNode(node_u))
-    {
-        return SPECIAL_NODEID;
-    }
-
-    const auto restriction_iter = m_restriction_map.find({node_u, node_v});
-    if (restriction_iter != m_restriction_map.end())
-    {
-        const unsigned index = restriction_iter->second;
-        const auto &bucket = m_restriction_bucket_list.at(index);
-        for (const RestrictionTarget &restriction_target : bucket)
-        {
-            if (restriction_target.is_only)
-            {
-                return restriction_target.target_node;
-            }
-        }
-    }
-    return SPECIAL_NODEID;
+    const auto targets = GetTargets(node_u, node_v);
+    const auto only_target = std::find_if(targets.first,
+                                          targets.second,
+                                          [](const RestrictionTarget &restriction_target) {
+                                              return restriction_target.is_only;
+                                          });
+    return only_target == targets.second ? SPECIAL_NODEID : only_target->target_node;
 }
 
 // Checks if turn <u,v,w> is actually a turn restriction.
@@ -122,21 +211,9 @@ bool RestrictionMap::CheckIfTurnIsRestricted(const NodeID node_u,
     BOOST_ASSERT(node_v != SPECIAL_NODEID);
     BOOST_ASSERT(node_w != SPECIAL_NODEID);
 
-    if (!IsSourceNode(node_u))
-    {
-        return false;
-    }
-
-    const auto restriction_iter = m_restriction_map.find({node_u, node_v});
-    if (restriction_iter == m_restriction_map.end())
-    {
-        return false;
-    }
-
-    const unsigned index = restriction_iter->second;
-    const auto &bucket = m_restriction_bucket_list.at(index);
-
-    for (const RestrictionTarget &restriction_target : bucket)
+    const auto targets = GetTargets(node_u, node_v);
+    for (const RestrictionTarget &restriction_target :
+         boost::make_iterator_range(targets.first, targets.second))
     {
         if (node_w == restriction_target.target_node && // target found
             !restriction_target.is_only)                // and not an only_-restr.
@@ -21,6 +21,8 @@
 
 #include <tbb/parallel_for.h>
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <sstream>
 
@@ -30,6 +32,12 @@ namespace extractor
 {
 namespace
 {
+// the cache of way results of a context is cleared once it holds that many distinct tag sets
+const constexpr std::size_t MAX_CACHED_WAY_RESULTS = 1 << 16;
+
+// turn_function is sampled that often per degree if the profile sets sample_turn_function
+const constexpr int TURN_FUNCTION_SAMPLES_PER_DEGREE = 10;
+
 // wrapper method as luabind doesn't automatically overload funcs w/ default parameters
 template <class T>
 auto get_value_by_key(T const &object, const char *key) -> decltype(object.get_value_by_key(key))
@@ -51,6 +59,47 @@ template <class T> double lonToDouble(T const &object)
 // simply wrap it
 auto get_nodes_for_way(const osmium::Way &way) -> decltype(way.nodes()) { return way.nodes(); }
 
+// Returns the value of a tag of the node or way that is being processed or an empty string.
+// Bound as a plain C function it skips the overload resolution and argument conversions of a
+// luabind call to get_value_by_key, the keys are strings interned by lua already.
+int luaGetTag(lua_State *state)
+{
+    const auto *context =
+        static_cast<const LuaScriptingContext *>(lua_touserdata(state, lua_upvalueindex(1)));
+    const char *key = luaL_checkstring(state, 1);
+    const char *value =
+        context->current_tags ? context->current_tags->get_value_by_key(key) : nullptr;
+    lua_pushstring(state, value ? value : "");
+    return 1;
+}
+
+// Returns the global function <name> of the profile or an invalid object
+luabind::object getLuaFunction(lua_State *state, const char *name)
+{
+    if (!util::luaFunctionExists(state, name))
+        return luabind::object();
+    return luabind::globals(state)[name];
+}
+
+// Calls turn_function of the profile, a failing call counts as no penalty
+int32_t callTurnFunction(const LuaScriptingContext &context, const double angle)
+{
+    BOOST_ASSERT(context.state != nullptr);
+    try
+    {
+        // call lua profile to compute turn penalty
+        const double penalty = luabind::call_function<double>(context.turn_function, angle);
+        BOOST_ASSERT(penalty < std::numeric_limits<int32_t>::max());
+        BOOST_ASSERT(penalty > std::numeric_limits<int32_t>::min());
+        return boost::numeric_cast<int32_t>(penalty);
+    }
+    catch (const luabind::error &er)
+    {
+        util::SimpleLogger().Write(logWARNING) << er.what();
+    }
+    return 0;
+}
+
 // Error handler
 int luaErrorCallback(lua_State *state)
 {
@@ -137,7 +186,9 @@ void LuaScriptingEnvironment::InitContext(LuaScriptingContext &context)
              .def_readwrite("use_turn_restrictions", &ProfileProperties::use_turn_restrictions)
              .def_readwrite("continue_straight_at_waypoint",
                             &ProfileProperties::continue_straight_at_waypoint)
-             .def_readwrite("left_hand_driving", &ProfileProperties::left_hand_driving),
+             .def_readwrite("left_hand_driving", &ProfileProperties::left_hand_driving)
+             .def_readwrite("cache_way_results", &ProfileProperties::cache_way_results)
+             .def_readwrite("sample_turn_function", &ProfileProperties::sample_turn_function),
 
          luabind::class_<std::vector<std::string>>("vector").def(
              "Add",
@@ -192,6 +243,8 @@ void LuaScriptingEnvironment::InitContext(LuaScriptingContext &context)
              .def_readwrite("turn_lanes_forward", &ExtractionWay::turn_lanes_forward)
              .def_readwrite("turn_lanes_backward", &ExtractionWay::turn_lanes_backward)
              .def_readwrite("road_classification", &ExtractionWay::road_classification)
+             .def("set_class", &ExtractionWay::set_class)
+             .def("has_class", &ExtractionWay::has_class)
              .property(
                  "forward_mode", &ExtractionWay::get_forward_mode, &ExtractionWay::set_forward_mode)
              .property("backward_mode",
@@ -226,7 +279,13 @@ void LuaScriptingEnvironment::InitContext(LuaScriptingContext &context)
              .def("invalid_data", &RasterDatum::get_invalid)];
 
     luabind::globals(context.state)["properties"] = &context.properties;
-    luabind::globals(context.state)["sources"] = &context.sources;
+    // the sources are shared by the contexts, the ones loaded in source_function on one thread
+    // are queried by the segment functions of all threads
+    luabind::globals(context.state)["sources"] = &sources;
+
+    lua_pushlightuserdata(context.state, &context);
+    lua_pushcclosure(context.state, &luaGetTag, 1);
+    lua_setglobal(context.state, "get_tag");
 
     if (0 != luaL_dofile(context.state, file_name.c_str()))
     {
@@ -236,10 +295,27 @@ void LuaScriptingEnvironment::InitContext(LuaScriptingContext &context)
         throw util::exception("ERROR occurred in profile script:\n" + error_stream.str());
     }
 
-    context.has_turn_penalty_function = util::luaFunctionExists(context.state, "turn_function");
-    context.has_node_function = util::luaFunctionExists(context.state, "node_function");
-    context.has_way_function = util::luaFunctionExists(context.state, "way_function");
-    context.has_segment_function = util::luaFunctionExists(context.state, "segment_function");
+    // the functions called per element are looked up once instead of by name on every call
+    context.turn_function = getLuaFunction(context.state, "turn_function");
+    context.node_function = getLuaFunction(context.state, "node_function");
+    context.way_function = getLuaFunction(context.state, "way_function");
+    context.segment_function = getLuaFunction(context.state, "segment_function");
+    context.has_turn_penalty_function = context.turn_function.is_valid();
+    context.has_node_function = context.node_function.is_valid();
+    context.has_way_function = context.way_function.is_valid();
+    context.has_segment_function = context.segment_function.is_valid();
+
+    // a turn_function that only depends on the angle is called once per sample instead of once
+    // per turn, turns look up the sample closest to their angle
+    if (context.has_turn_penalty_function && context.properties.sample_turn_function)
+    {
+        context.turn_function_samples.resize(360 * TURN_FUNCTION_SAMPLES_PER_DEGREE + 1);
+        for (std::size_t sample = 0; sample < context.turn_function_samples.size(); ++sample)
+        {
+            context.turn_function_samples[sample] = callTurnFunction(
+                context, -180. + static_cast<double>(sample) / TURN_FUNCTION_SAMPLES_PER_DEGREE);
+        }
+    }
 }
 
 const ProfileProperties &LuaScriptingEnvironment::GetProfileProperties()
@@ -249,11 +325,12 @@ const ProfileProperties &LuaScriptingEnvironment::GetProfileProperties()
 
 LuaScriptingContext &LuaScriptingEnvironment::GetLuaContext()
 {
-    std::lock_guard<std::mutex> lock(init_mutex);
+    // the contexts are thread local, only setting up a new one is serialized
     bool initialized = false;
     auto &ref = script_contexts.local(initialized);
     if (!initialized)
     {
+        std::lock_guard<std::mutex> lock(init_mutex);
         ref = std::make_unique<LuaScriptingContext>();
         InitContext(*ref);
     }
@@ -360,22 +437,16 @@ void LuaScriptingEnvironment::SetupSources()
 int32_t LuaScriptingEnvironment::GetTurnPenalty(const double angle)
 {
     auto &context = GetLuaContext();
+    if (!context.turn_function_samples.empty())
+    {
+        const auto sample =
+            std::lround((std::min(std::max(angle, -180.), 180.) + 180.) *
+                        TURN_FUNCTION_SAMPLES_PER_DEGREE);
+        return context.turn_function_samples[sample];
+    }
     if (context.has_turn_penalty_function)
     {
-        BOOST_ASSERT(context.state != nullptr);
-        try
-        {
-            // call lua profile to compute turn penalty
-            const double penalty =
-                luabind::call_function<double>(context.state, "turn_function", angle);
-            BOOST_ASSERT(penalty < std::numeric_limits<int32_t>::max());
-            BOOST_ASSERT(penalty > std::numeric_limits<int32_t>::min());
-            return boost::numeric_cast<int32_t>(penalty);
-        }
-        catch (const luabind::error &er)
-        {
-            util::SimpleLogger().Write(logWARNING) << er.what();
-        }
+        return callTurnFunction(context, angle);
     }
     return 0;
 }
@@ -389,8 +460,7 @@ void LuaScriptingEnvironment::ProcessSegment(const osrm::util::Coordinate &sourc
     if (context.has_segment_function)
     {
         BOOST_ASSERT(context.state != nullptr);
-        luabind::call_function<void>(context.state,
-                                     "segment_function",
+        luabind::call_function<void>(context.segment_function,
                                      boost::cref(source),
                                      boost::cref(target),
                                      distance,
@@ -401,13 +471,50 @@ void LuaScriptingEnvironment::ProcessSegment(const osrm::util::Coordinate &sourc
 void LuaScriptingContext::processNode(const osmium::Node &node, ExtractionNode &result)
 {
     BOOST_ASSERT(state != nullptr);
-    luabind::call_function<void>(state, "node_function", boost::cref(node), boost::ref(result));
+    current_tags = &node.tags();
+    luabind::call_function<void>(node_function, boost::cref(node), boost::ref(result));
+    current_tags = nullptr;
 }
 
 void LuaScriptingContext::processWay(const osmium::Way &way, ExtractionWay &result)
+{
+    if (!properties.cache_way_results)
+    {
+        callWayFunction(way, result);
+        return;
+    }
+
+    // the key holds all keys and values, ways only share a result if their tags are identical
+    way_cache_key.clear();
+    for (const auto &tag : way.tags())
+    {
+        way_cache_key.append(tag.key());
+        way_cache_key.push_back('\0');
+        way_cache_key.append(tag.value());
+        way_cache_key.push_back('\0');
+    }
+
+    const auto cached = way_result_cache.find(way_cache_key);
+    if (cached != way_result_cache.end())
+    {
+        result = cached->second;
+        return;
+    }
+
+    callWayFunction(way, result);
+    if (way_result_cache.size() >= MAX_CACHED_WAY_RESULTS)
+    {
+        way_result_cache.clear();
+    }
+    way_result_cache.emplace(way_cache_key, result);
+}
+
+void LuaScriptingContext::callWayFunction(const osmium::Way &way, ExtractionWay &result)
 {
     BOOST_ASSERT(state != nullptr);
-    luabind::call_function<void>(state, "way_function", boost::cref(way), boost::ref(result));
+    current_tags = &way.tags();
+    luabind::call_function<void>(way_function, boost::cref(way), boost::ref(result));
+    current_tags = nullptr;
 }
 }
 }
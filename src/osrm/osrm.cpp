@@ -1,4 +1,5 @@
 #include "osrm/osrm.hpp"
+#include "engine/api/isochrone_parameters.hpp"
 #include "engine/api/match_parameters.hpp"
 #include "engine/api/nearest_parameters.hpp"
 #include "engine/api/route_parameters.hpp"
@@ -9,6 +10,8 @@
 #include "engine/status.hpp"
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace osrm
 {
@@ -20,6 +23,8 @@ OSRM::~OSRM() = default;
 OSRM::OSRM(OSRM &&) noexcept = default;
 OSRM &OSRM::operator=(OSRM &&) noexcept = default;
 
+void OSRM::WarmUpThread() const { engine_->WarmUpThread(); }
+
 // Forward to implementation
 
 engine::Status OSRM::Route(const engine::api::RouteParameters &params,
@@ -28,11 +33,38 @@ engine::Status OSRM::Route(const engine::api::RouteParameters &params,
     return engine_->Route(params, result);
 }
 
+engine::Status OSRM::Route(const engine::api::RouteParameters &params, std::string &result) const
+{
+    return engine_->Route(params, result);
+}
+
+void OSRM::Route(const std::vector<engine::api::RouteParameters> &params,
+                 const BatchCallback &callback) const
+{
+    engine_->Route(params, callback);
+}
+
 engine::Status OSRM::Table(const engine::api::TableParameters &params, json::Object &result) const
 {
     return engine_->Table(params, result);
 }
 
+engine::Status OSRM::Table(const engine::api::TableParameters &params, json::Writer &result) const
+{
+    return engine_->Table(params, result);
+}
+
+engine::Status OSRM::Table(const engine::api::TableParameters &params, std::string &result) const
+{
+    return engine_->Table(params, result);
+}
+
+void OSRM::Table(const std::vector<engine::api::TableParameters> &params,
+                 const BatchCallback &callback) const
+{
+    engine_->Table(params, callback);
+}
+
 engine::Status OSRM::Nearest(const engine::api::NearestParameters &params,
                              json::Object &result) const
 {
@@ -49,9 +81,64 @@ engine::Status OSRM::Match(const engine::api::MatchParameters &params, json::Obj
     return engine_->Match(params, result);
 }
 
+engine::Status OSRM::Match(engine::MatchSession &session,
+                           const engine::api::MatchParameters &params,
+                           json::Object &result) const
+{
+    return engine_->Match(session, params, result);
+}
+
+engine::Status OSRM::FinishMatch(engine::MatchSession &session,
+                                 const engine::api::MatchParameters &params,
+                                 json::Object &result) const
+{
+    return engine_->FinishMatch(session, params, result);
+}
+
 engine::Status OSRM::Tile(const engine::api::TileParameters &params, std::string &result) const
 {
     return engine_->Tile(params, result);
 }
 
+engine::Status OSRM::Isochrone(const engine::api::IsochroneParameters &params,
+                               json::Object &result) const
+{
+    return engine_->Isochrone(params, result);
+}
+
+void OSRM::Route(const engine::api::RouteParameters &params, AsyncCallback callback) const
+{
+    engine_->Route(params, std::move(callback));
+}
+
+void OSRM::Table(const engine::api::TableParameters &params, AsyncCallback callback) const
+{
+    engine_->Table(params, std::move(callback));
+}
+
+void OSRM::Nearest(const engine::api::NearestParameters &params, AsyncCallback callback) const
+{
+    engine_->Nearest(params, std::move(callback));
+}
+
+void OSRM::Trip(const engine::api::TripParameters &params, AsyncCallback callback) const
+{
+    engine_->Trip(params, std::move(callback));
+}
+
+void OSRM::Match(const engine::api::MatchParameters &params, AsyncCallback callback) const
+{
+    engine_->Match(params, std::move(callback));
+}
+
+void OSRM::Tile(const engine::api::TileParameters &params, AsyncTileCallback callback) const
+{
+    engine_->Tile(params, std::move(callback));
+}
+
+void OSRM::Isochrone(const engine::api::IsochroneParameters &params, AsyncCallback callback) const
+{
+    engine_->Isochrone(params, std::move(callback));
+}
+
 } // ns osrm
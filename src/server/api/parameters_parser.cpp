@@ -1,5 +1,6 @@
 #include "server/api/parameters_parser.hpp"
 
+#include "server/api/isochrone_parameter_grammar.hpp"
 #include "server/api/match_parameter_grammar.hpp"
 #include "server/api/nearest_parameter_grammar.hpp"
 #include "server/api/route_parameters_grammar.hpp"
@@ -7,6 +8,8 @@
 #include "server/api/tile_parameter_grammar.hpp"
 #include "server/api/trip_parameter_grammar.hpp"
 
+#include "util/allocation_statistics.hpp"
+
 #include <type_traits>
 
 namespace osrm
@@ -26,7 +29,8 @@ using is_grammar_t =
                                std::is_same<NearestParametersGrammar<>, T>::value ||
                                std::is_same<TripParametersGrammar<>, T>::value ||
                                std::is_same<MatchParametersGrammar<>, T>::value ||
-                               std::is_same<TileParametersGrammar<>, T>::value>;
+                               std::is_same<TileParametersGrammar<>, T>::value ||
+                               std::is_same<IsochroneParametersGrammar<>, T>::value>;
 
 template <typename ParameterT,
           typename GrammarT,
@@ -38,6 +42,7 @@ boost::optional<ParameterT> parseParameters(std::string::iterator &iter,
     using It = std::decay<decltype(iter)>::type;
 
     static const GrammarT grammar;
+    util::AllocationPhaseScope allocation_phase(util::AllocationPhase::Parsing);
 
     try
     {
@@ -111,6 +116,14 @@ boost::optional<engine::api::TileParameters> parseParameters(std::string::iterat
     return detail::parseParameters<engine::api::TileParameters, TileParametersGrammar<>>(iter, end);
 }
 
+template <>
+boost::optional<engine::api::IsochroneParameters> parseParameters(std::string::iterator &iter,
+                                                                  const std::string::iterator end)
+{
+    return detail::parseParameters<engine::api::IsochroneParameters,
+                                   IsochroneParametersGrammar<>>(iter, end);
+}
+
 } // ns api
 } // ns server
 } // ns osrm
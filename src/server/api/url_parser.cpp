@@ -1,5 +1,6 @@
 #include "server/api/url_parser.hpp"
 #include "engine/polyline_compressor.hpp"
+#include "util/allocation_statistics.hpp"
 
 #include <boost/fusion/include/adapt_struct.hpp>
 #include <boost/spirit/include/phoenix.hpp>
@@ -8,6 +9,7 @@
 
 #include <string>
 #include <type_traits>
+#include <utility>
 
 BOOST_FUSION_ADAPT_STRUCT(osrm::server::api::ParsedURL,
                           (std::string, service)(unsigned, version)(std::string,
@@ -27,7 +29,8 @@ struct URLParser final : qi::grammar<Iterator, Into>
         using boost::spirit::repository::qi::iter_pos;
 
         alpha_numeral = qi::char_("a-zA-Z0-9");
-        percent_encoding = qi::char_('%') > qi::uint_parser<char, 16, 2, 2>()[qi::_val = qi::_1];
+        percent_encoding =
+            qi::char_('%') > qi::uint_parser<unsigned char, 16, 2, 2>()[qi::_val = qi::_1];
         polyline_chars = qi::char_("a-zA-Z0-9_.--[]{}@?|\\~`^") | percent_encoding;
         all_chars = polyline_chars | qi::char_("=,;:&().");
 
@@ -59,30 +62,22 @@ struct URLParser final : qi::grammar<Iterator, Into>
     qi::rule<Iterator, char()> percent_encoding;
 };
 
-} // anon.
-
-namespace osrm
-{
-namespace server
-{
-namespace api
+template <typename Iterator>
+boost::optional<osrm::server::api::ParsedURL> parseURLImpl(Iterator &iter, const Iterator end)
 {
-
-boost::optional<ParsedURL> parseURL(std::string::iterator &iter, const std::string::iterator end)
-{
-    using It = std::decay<decltype(iter)>::type;
-
-    static URLParser<It, ParsedURL(It)> const parser;
+    using osrm::server::api::ParsedURL;
+    static URLParser<Iterator, ParsedURL(Iterator)> const parser;
+    osrm::util::AllocationPhaseScope allocation_phase(osrm::util::AllocationPhase::Parsing);
     ParsedURL out;
 
     try
     {
-        const auto ok = boost::spirit::qi::parse(iter, end, parser(boost::phoenix::val(iter)), out);
+        const auto ok = qi::parse(iter, end, parser(ph::val(iter)), out);
 
         if (ok && iter == end)
-            return boost::make_optional(out);
+            return boost::optional<ParsedURL>(std::move(out));
     }
-    catch (const qi::expectation_failure<It> &failure)
+    catch (const qi::expectation_failure<Iterator> &failure)
     {
         // The grammar above using expectation parsers ">" does not automatically increment the
         // iterator to the failing position. Extract the position from the exception ourselves.
@@ -92,6 +87,26 @@ boost::optional<ParsedURL> parseURL(std::string::iterator &iter, const std::stri
     return boost::none;
 }
 
+} // anon.
+
+namespace osrm
+{
+namespace server
+{
+namespace api
+{
+
+boost::optional<ParsedURL> parseURL(std::string::iterator &iter, const std::string::iterator end)
+{
+    return parseURLImpl(iter, end);
+}
+
+boost::optional<ParsedURL> parseURL(std::string::const_iterator &iter,
+                                    const std::string::const_iterator end)
+{
+    return parseURLImpl(iter, end);
+}
+
 } // api
 } // server
 } // osrm
@@ -1,13 +1,25 @@
 #include "server/connection.hpp"
 #include "server/request_handler.hpp"
 #include "server/request_parser.hpp"
+#include "util/allocation_statistics.hpp"
+#include "util/integer_range.hpp"
+#include "util/simple_logger.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/bind.hpp>
-#include <boost/iostreams/filter/gzip.hpp>
-#include <boost/iostreams/filtering_stream.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <iterator>
+#include <new>
 #include <string>
 #include <vector>
 
@@ -16,134 +28,584 @@ namespace osrm
 namespace server
 {
 
-Connection::Connection(boost::asio::io_service &io_service, RequestHandler &handler)
-    : strand(io_service), TCP_socket(io_service), request_handler(handler)
+namespace
+{
+// replies are deflated in chunks of this size, which are compressed in parallel
+const constexpr std::size_t COMPRESSION_CHUNK_SIZE = 256 * 1024;
+// deflate refers back at most this far, chunks are primed with the input preceding them
+const constexpr std::size_t DEFLATE_WINDOW_SIZE = 32 * 1024;
+// zlib's default memory level for deflate
+const constexpr int DEFLATE_MEMORY_LEVEL = 8;
+
+// zlib allocates with malloc, builds with ENABLE_ALLOCATION_TRACKING count its allocations too
+voidpf countingAlloc(voidpf, uInt items, uInt size)
+{
+    util::countAllocation(static_cast<std::size_t>(items) * size);
+    return std::calloc(items, size);
+}
+
+void countingFree(voidpf, voidpf address) { std::free(address); }
+
+// Compresses [begin, end) into a raw deflate stream. All but the last chunk are terminated by a
+// sync flush, which ends them on a byte boundary: the concatenated chunks form a single stream.
+void deflateChunk(const char *dictionary_begin,
+                  const char *begin,
+                  const char *end,
+                  const int level,
+                  const bool last_chunk,
+                  std::vector<char> &output)
+{
+    z_stream stream;
+    stream.zalloc = util::ALLOCATION_TRACKING_ENABLED ? countingAlloc : Z_NULL;
+    stream.zfree = util::ALLOCATION_TRACKING_ENABLED ? countingFree : Z_NULL;
+    stream.opaque = Z_NULL;
+    if (deflateInit2(
+            &stream, level, Z_DEFLATED, -MAX_WBITS, DEFLATE_MEMORY_LEVEL, Z_DEFAULT_STRATEGY) !=
+        Z_OK)
+    {
+        throw std::bad_alloc();
+    }
+
+    if (dictionary_begin != begin)
+    {
+        deflateSetDictionary(&stream,
+                             reinterpret_cast<const Bytef *>(dictionary_begin),
+                             static_cast<uInt>(begin - dictionary_begin));
+    }
+
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(begin));
+    stream.avail_in = static_cast<uInt>(end - begin);
+
+    // the bound holds for Z_FINISH, a sync flush might need a few bytes more
+    output.resize(deflateBound(&stream, stream.avail_in) + 16);
+    std::size_t written = 0;
+    int status = Z_OK;
+    do
+    {
+        if (written == output.size())
+        {
+            output.resize(2 * output.size());
+        }
+        stream.next_out = reinterpret_cast<Bytef *>(output.data() + written);
+        stream.avail_out = static_cast<uInt>(output.size() - written);
+        status = deflate(&stream, last_chunk ? Z_FINISH : Z_SYNC_FLUSH);
+        written = output.size() - stream.avail_out;
+    } while (stream.avail_out == 0 && status != Z_STREAM_END);
+    BOOST_ASSERT(status == (last_chunk ? Z_STREAM_END : Z_OK));
+
+    output.resize(written);
+    deflateEnd(&stream);
+}
+
+const std::string CONTINUE_STATUS_LINE = "HTTP/1.1 100 Continue\r\n\r\n";
+
+void appendLittleEndian(std::vector<char> &buffer, const std::uint32_t value)
+{
+    for (const auto shift : {0, 8, 16, 24})
+    {
+        buffer.push_back(static_cast<char>((value >> shift) & 0xff));
+    }
+}
+
+boost::asio::ip::address remoteAddress(boost::asio::ip::tcp::socket &socket)
+{
+    boost::system::error_code ignore_error;
+    return socket.remote_endpoint(ignore_error).address();
+}
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+// clients of unix domain sockets run on the same host
+boost::asio::ip::address remoteAddress(boost::asio::local::stream_protocol::socket &)
 {
+    return boost::asio::ip::address_v4::loopback();
+}
+#endif
 }
 
-boost::asio::ip::tcp::socket &Connection::socket() { return TCP_socket; }
+template <typename SocketT> constexpr std::size_t Connection<SocketT>::MAX_KEEP_ALIVE_REQUESTS;
+template <typename SocketT> constexpr long Connection<SocketT>::KEEP_ALIVE_TIMEOUT_SECONDS;
+template <typename SocketT> constexpr long Connection<SocketT>::HTTP2_IDLE_TIMEOUT_SECONDS;
+template <typename SocketT> constexpr std::size_t Connection<SocketT>::MAX_RECYCLED_REPLY_SIZE;
+
+template <typename SocketT>
+Connection<SocketT>::Connection(boost::asio::io_service &io_service,
+                                RequestHandler &handler,
+                                const http::compression_settings &compression)
+    : strand(io_service), client_socket(io_service), timer(io_service), request_handler(handler),
+      compression(compression)
+{
+}
+
+template <typename SocketT> SocketT &Connection<SocketT>::socket() { return client_socket; }
 
 /// Start the first asynchronous operation for the connection.
-void Connection::start()
+template <typename SocketT> void Connection<SocketT>::start() { start_read(false); }
+
+template <typename SocketT> void Connection<SocketT>::start_read(const bool wait_for_new_request)
 {
-    TCP_socket.async_read_some(
-        boost::asio::buffer(incoming_data_buffer),
+    if (wait_for_new_request)
+    {
+        timer.expires_from_now(boost::posix_time::seconds(
+            http2_session ? HTTP2_IDLE_TIMEOUT_SECONDS : KEEP_ALIVE_TIMEOUT_SECONDS));
+        timer.async_wait(strand.wrap(boost::bind(&Connection::handle_timeout,
+                                                 this->shared_from_this(),
+                                                 boost::asio::placeholders::error)));
+    }
+
+    client_socket.async_read_some(
+        boost::asio::buffer(incoming_data_buffer.data() + preface_bytes,
+                            incoming_data_buffer.size() - preface_bytes),
         strand.wrap(boost::bind(&Connection::handle_read,
                                 this->shared_from_this(),
                                 boost::asio::placeholders::error,
                                 boost::asio::placeholders::bytes_transferred)));
 }
 
-void Connection::handle_read(const boost::system::error_code &error, std::size_t bytes_transferred)
+template <typename SocketT>
+void Connection<SocketT>::handle_read(const boost::system::error_code &error,
+                                      std::size_t bytes_transferred)
 {
+    // disarms a pending idle timeout, see handle_timeout
+    timer.expires_at(boost::posix_time::pos_infin);
+
     if (error)
     {
+        // the client is gone, the queries of its streams are cancelled
+        if (http2_session)
+        {
+            http2_session->Close();
+        }
+        return;
+    }
+
+    char *begin = incoming_data_buffer.data();
+    char *end = begin + preface_bytes + bytes_transferred;
+    if (http2_session)
+    {
+        process_http2_input(begin, end);
         return;
     }
 
+    // clients with prior knowledge of HTTP/2 start with its preface instead of a request
+    if (awaiting_preface)
+    {
+        const auto &preface = http2::Session::CLIENT_PREFACE;
+        const auto length = std::min<std::size_t>(end - begin, preface.size());
+        if (std::equal(begin, begin + length, preface.begin()))
+        {
+            if (length == preface.size())
+            {
+                preface_bytes = 0;
+                start_http2(begin + length, end);
+            }
+            else
+            {
+                preface_bytes = length;
+                start_read(false);
+            }
+            return;
+        }
+        awaiting_preface = false;
+        preface_bytes = 0;
+    }
+
+    process_input(begin, end);
+}
+
+template <typename SocketT> void Connection<SocketT>::process_input(char *begin, char *end)
+{
     // no error detected, let's parse the request
-    http::compression_type compression_type(http::no_compression);
     RequestParser::RequestStatus result;
-    std::tie(result, compression_type) =
-        request_parser.parse(current_request,
-                             incoming_data_buffer.data(),
-                             incoming_data_buffer.data() + bytes_transferred);
+    std::tie(result, compression_type) = request_parser.parse(current_request, begin, end);
 
     // the request has been parsed
     if (result == RequestParser::RequestStatus::valid)
     {
-        current_request.endpoint = TCP_socket.remote_endpoint().address();
-        request_handler.HandleRequest(current_request, current_reply);
+        current_request.endpoint = remoteAddress(client_socket);
+        current_request.cancelled = std::make_shared<std::atomic<bool>>(false);
+        pending_input_begin = begin;
+        pending_input_end = end;
 
-        // compress the result w/ gzip/deflate if requested
-        switch (compression_type)
+        // further input is only read once the reply was sent, until then the socket becomes
+        // readable if the client is gone. Clients that pipeline requests can't be watched.
+        if (pending_input_begin == pending_input_end)
         {
-        case http::deflate_rfc1951:
-            // use deflate for compression
-            current_reply.headers.insert(current_reply.headers.begin(),
-                                         {"Content-Encoding", "deflate"});
-            compressed_output = compress_buffers(current_reply.content, compression_type);
-            current_reply.set_size(static_cast<unsigned>(compressed_output.size()));
-            output_buffer = current_reply.headers_to_buffers();
-            output_buffer.push_back(boost::asio::buffer(compressed_output));
-            break;
-        case http::gzip_rfc1952:
-            // use gzip for compression
-            current_reply.headers.insert(current_reply.headers.begin(),
-                                         {"Content-Encoding", "gzip"});
-            compressed_output = compress_buffers(current_reply.content, compression_type);
-            current_reply.set_size(static_cast<unsigned>(compressed_output.size()));
-            output_buffer = current_reply.headers_to_buffers();
-            output_buffer.push_back(boost::asio::buffer(compressed_output));
-            break;
-        case http::no_compression:
-            // don't use any compression
-            current_reply.set_uncompressed_size();
-            output_buffer = current_reply.to_buffers();
-            break;
+            client_socket.async_read_some(boost::asio::null_buffers(),
+                                       strand.wrap(boost::bind(&Connection::handle_disconnect,
+                                                               this->shared_from_this(),
+                                                               boost::asio::placeholders::error,
+                                                               current_request.cancelled)));
         }
-        // write result to stream
-        boost::asio::async_write(TCP_socket,
-                                 output_buffer,
-                                 strand.wrap(boost::bind(&Connection::handle_write,
-                                                         this->shared_from_this(),
-                                                         boost::asio::placeholders::error)));
+
+        // the reply might be computed on another thread, it is sent from within the strand
+        request_handler.HandleRequest(
+            current_request,
+            current_reply,
+            strand.wrap(boost::bind(&Connection::handle_reply, this->shared_from_this())));
     }
     else if (result == RequestParser::RequestStatus::invalid)
-    { // request is not parseable
+    { // request is not parseable, the rest of the stream can't be trusted either
+        keep_alive = false;
         current_reply = http::reply::stock_reply(http::reply::bad_request);
 
-        boost::asio::async_write(TCP_socket,
+        boost::asio::async_write(client_socket,
                                  current_reply.to_buffers(),
                                  strand.wrap(boost::bind(&Connection::handle_write,
                                                          this->shared_from_this(),
                                                          boost::asio::placeholders::error)));
     }
+    else if (request_parser.await_continue())
+    {
+        // the client holds back the body until we agree to receive it
+        boost::asio::async_write(client_socket,
+                                 boost::asio::buffer(CONTINUE_STATUS_LINE),
+                                 strand.wrap(boost::bind(&Connection::handle_continue,
+                                                         this->shared_from_this(),
+                                                         boost::asio::placeholders::error)));
+    }
     else
     {
         // we don't have a result yet, so continue reading
-        TCP_socket.async_read_some(
-            boost::asio::buffer(incoming_data_buffer),
-            strand.wrap(boost::bind(&Connection::handle_read,
-                                    this->shared_from_this(),
-                                    boost::asio::placeholders::error,
-                                    boost::asio::placeholders::bytes_transferred)));
+        start_read(false);
     }
 }
 
-/// Handle completion of a write operation.
-void Connection::handle_write(const boost::system::error_code &error)
+template <typename SocketT>
+void Connection<SocketT>::handle_continue(const boost::system::error_code &error)
 {
     if (!error)
+    {
+        start_read(false);
+    }
+}
+
+template <typename SocketT>
+void Connection<SocketT>::handle_disconnect(const boost::system::error_code &error,
+                                            const std::shared_ptr<std::atomic<bool>> &cancelled)
+{
+    // the reply was sent before anything happened on the socket
+    if (error == boost::asio::error::operation_aborted)
+    {
+        return;
+    }
+
+    // a readable socket without data was closed by the client
+    boost::system::error_code available_error;
+    if (!error && client_socket.available(available_error) > 0 && !available_error)
+    {
+        return;
+    }
+    cancelled->store(true, std::memory_order_relaxed);
+}
+
+template <typename SocketT> void Connection<SocketT>::handle_reply()
+{
+    // stops watching for a disconnect of the client
+    boost::system::error_code ignore_error;
+    client_socket.cancel(ignore_error);
+
+    ++processed_requests;
+    keep_alive = current_request.keep_alive && processed_requests < MAX_KEEP_ALIVE_REQUESTS;
+    current_reply.set_keep_alive(keep_alive);
+
+    if (finish_reply(current_request, current_reply, compression_type) == http::no_compression)
+    {
+        output_buffer = current_reply.to_buffers();
+    }
+    else
+    {
+        output_buffer = current_reply.headers_to_buffers();
+        for (const auto &chunk : compressed_output)
+        {
+            output_buffer.push_back(boost::asio::buffer(chunk));
+        }
+    }
+
+    // write result to stream
+    boost::asio::async_write(client_socket,
+                             output_buffer,
+                             strand.wrap(boost::bind(&Connection::handle_write,
+                                                     this->shared_from_this(),
+                                                     boost::asio::placeholders::error)));
+}
+
+template <typename SocketT>
+http::compression_type Connection<SocketT>::finish_reply(const http::request &request,
+                                                         http::reply &reply,
+                                                         http::compression_type compression_type)
+{
+    // small replies are not worth the compression latency
+    if (reply.content.size() < compression.min_size)
+    {
+        compression_type = http::no_compression;
+    }
+
+    // compress the result w/ gzip/deflate if requested
+    switch (compression_type)
+    {
+    case http::deflate_rfc1951:
+        // use deflate for compression
+        reply.headers.insert(reply.headers.begin(), {"Content-Encoding", "deflate"});
+        break;
+    case http::gzip_rfc1952:
+        // use gzip for compression
+        reply.headers.insert(reply.headers.begin(), {"Content-Encoding", "gzip"});
+        break;
+    case http::no_compression:
+        // don't use any compression
+        reply.set_uncompressed_size();
+        break;
+    }
+
+    if (compression_type != http::no_compression)
+    {
+        {
+            util::AllocationRecorder recorder(reply.allocations);
+            util::AllocationPhaseScope phase(util::AllocationPhase::Compression);
+            const auto compression_start = std::chrono::steady_clock::now();
+            compress_buffers(reply.content, compression_type);
+            reply.profile.compress = std::chrono::steady_clock::now() - compression_start;
+        }
+        std::size_t compressed_size = 0;
+        for (const auto &chunk : compressed_output)
+        {
+            compressed_size += chunk.size();
+        }
+        reply.set_size(compressed_size);
+    }
+
+    // the allocations of the request are complete once its reply is compressed
+    if (util::ALLOCATION_TRACKING_ENABLED && !std::getenv("DISABLE_ACCESS_LOGGING"))
+    {
+        util::SimpleLogger logger;
+        auto &stream = logger.Write();
+        stream << "allocations of " << request.uri << ": ";
+        util::writeAllocationStatistics(stream, reply.allocations);
+    }
+    request_handler.FinishRequest(request, reply);
+    return compression_type;
+}
+
+template <typename SocketT>
+void Connection<SocketT>::start_http2(const char *begin, const char *end)
+{
+    // the settings of the server are queued right away
+    http2_session = std::make_unique<http2::Session>();
+    process_http2_input(begin, end);
+}
+
+template <typename SocketT>
+void Connection<SocketT>::process_http2_input(const char *begin, const char *end)
+{
+    std::vector<std::uint32_t> complete_streams;
+    if (http2_session->Consume(begin, end, complete_streams))
+    {
+        const auto endpoint = remoteAddress(client_socket);
+        for (const auto stream_id : complete_streams)
+        {
+            auto &request = http2_session->GetRequest(stream_id);
+            request.endpoint = endpoint;
+            // the replies are sent in the order their queries finish
+            request_handler.HandleRequest(request,
+                                          http2_session->GetReply(stream_id),
+                                          strand.wrap(boost::bind(&Connection::handle_http2_reply,
+                                                                  this->shared_from_this(),
+                                                                  stream_id)));
+        }
+
+        // further streams are read while the queries run, the client might reset them as well
+        if (!http2_session->IsDone())
+        {
+            start_read(!http2_session->HasStreams());
+        }
+    }
+    write_http2_output();
+}
+
+template <typename SocketT>
+void Connection<SocketT>::handle_http2_reply(const std::uint32_t stream_id)
+{
+    auto &reply = http2_session->GetReply(stream_id);
+    std::vector<char> body;
+    if (finish_reply(http2_session->GetRequest(stream_id),
+                     reply,
+                     http2_session->GetCompression(stream_id)) == http::no_compression)
+    {
+        body = std::move(reply.content);
+    }
+    else
+    {
+        for (const auto &chunk : compressed_output)
+        {
+            body.insert(body.end(), chunk.begin(), chunk.end());
+        }
+    }
+    http2_session->SendReply(stream_id, std::move(body));
+    write_http2_output();
+}
+
+template <typename SocketT> void Connection<SocketT>::write_http2_output()
+{
+    if (http2_writing)
+    {
+        return;
+    }
+    if (!http2_session->HasOutput())
+    {
+        if (http2_session->IsDone())
+        {
+            boost::system::error_code ignore_error;
+            client_socket.shutdown(boost::asio::socket_base::shutdown_both, ignore_error);
+        }
+        return;
+    }
+
+    // frames queued during the write are sent with the next one
+    http2_session->TakeOutput(http2_output);
+    http2_writing = true;
+    boost::asio::async_write(client_socket,
+                             boost::asio::buffer(http2_output),
+                             strand.wrap(boost::bind(&Connection::handle_http2_write,
+                                                     this->shared_from_this(),
+                                                     boost::asio::placeholders::error)));
+}
+
+template <typename SocketT>
+void Connection<SocketT>::handle_http2_write(const boost::system::error_code &error)
+{
+    http2_writing = false;
+    if (error)
+    {
+        http2_session->Close();
+        return;
+    }
+    write_http2_output();
+
+    // the last reply was sent, the read that is still pending waits for new streams
+    if (!http2_writing && !http2_session->HasStreams() && !http2_session->IsDone())
+    {
+        timer.expires_from_now(boost::posix_time::seconds(HTTP2_IDLE_TIMEOUT_SECONDS));
+        timer.async_wait(strand.wrap(boost::bind(&Connection::handle_timeout,
+                                                 this->shared_from_this(),
+                                                 boost::asio::placeholders::error)));
+    }
+}
+
+/// Handle completion of a write operation.
+template <typename SocketT>
+void Connection<SocketT>::handle_write(const boost::system::error_code &error)
+{
+    if (error)
+    {
+        return;
+    }
+
+    if (!keep_alive)
     {
         // Initiate graceful connection closure.
         boost::system::error_code ignore_error;
-        TCP_socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignore_error);
+        client_socket.shutdown(boost::asio::socket_base::shutdown_both, ignore_error);
+        return;
+    }
+
+    // prepare for the next request on this connection, which reuses the buffers of the reply
+    current_request = http::request();
+    current_reply.reset(MAX_RECYCLED_REPLY_SIZE);
+    if (compressed_output.size() * COMPRESSION_CHUNK_SIZE > MAX_RECYCLED_REPLY_SIZE)
+    {
+        std::vector<std::vector<char>>().swap(compressed_output);
+    }
+    request_parser.reset();
+
+    // answer pipelined requests in the order they were received
+    if (pending_input_begin != pending_input_end)
+    {
+        process_input(pending_input_begin, pending_input_end);
+    }
+    else
+    {
+        start_read(true);
     }
 }
 
-std::vector<char> Connection::compress_buffers(const std::vector<char> &uncompressed_data,
-                                               const http::compression_type compression_type)
+template <typename SocketT>
+void Connection<SocketT>::handle_timeout(const boost::system::error_code &error)
 {
-    boost::iostreams::gzip_params compression_parameters;
-
-    // there's a trade-off between speed and size. speed wins
-    compression_parameters.level = boost::iostreams::zlib::best_speed;
-    // check which compression flavor is used
-    if (http::deflate_rfc1951 == compression_type)
+    // the timer was cancelled or re-armed because data arrived in the meantime
+    if (error == boost::asio::error::operation_aborted ||
+        timer.expires_at() > boost::asio::deadline_timer::traits_type::now())
     {
-        compression_parameters.noheader = true;
+        return;
     }
 
-    std::vector<char> compressed_data;
-    // plug data into boost's compression stream
-    boost::iostreams::filtering_ostream gzip_stream;
-    gzip_stream.push(boost::iostreams::gzip_compressor(compression_parameters));
-    gzip_stream.push(boost::iostreams::back_inserter(compressed_data));
-    gzip_stream.write(&uncompressed_data[0], uncompressed_data.size());
-    boost::iostreams::close(gzip_stream);
+    boost::system::error_code ignore_error;
+    client_socket.shutdown(boost::asio::socket_base::shutdown_both, ignore_error);
+    client_socket.close(ignore_error);
+}
+
+template <typename SocketT>
+void Connection<SocketT>::compress_buffers(const std::vector<char> &uncompressed_data,
+                                           const http::compression_type compression_type)
+{
+    const auto data_size = uncompressed_data.size();
+    const auto number_of_chunks =
+        std::max<std::size_t>(1, (data_size + COMPRESSION_CHUNK_SIZE - 1) / COMPRESSION_CHUNK_SIZE);
 
-    return compressed_data;
+    // gzip wraps the deflate stream into a header and a trailer with a checksum
+    const bool use_gzip = http::gzip_rfc1952 == compression_type;
+    const std::size_t first_chunk = use_gzip ? 1 : 0;
+    compressed_output.resize(number_of_chunks + 2 * first_chunk);
+    std::vector<uLong> checksums(number_of_chunks);
+
+    const char *data = uncompressed_data.data();
+    util::ParallelAllocationStatistics allocations;
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, number_of_chunks),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            allocations.Run([&] {
+                for (auto chunk = range.begin(); chunk != range.end(); ++chunk)
+                {
+                    const auto begin = chunk * COMPRESSION_CHUNK_SIZE;
+                    const auto end = std::min(begin + COMPRESSION_CHUNK_SIZE, data_size);
+                    const auto dictionary_begin = begin - std::min(begin, DEFLATE_WINDOW_SIZE);
+                    deflateChunk(data + dictionary_begin,
+                                 data + begin,
+                                 data + end,
+                                 compression.level,
+                                 chunk + 1 == number_of_chunks,
+                                 compressed_output[first_chunk + chunk]);
+                    if (use_gzip)
+                    {
+                        checksums[chunk] = crc32(crc32(0, Z_NULL, 0),
+                                                 reinterpret_cast<const Bytef *>(data + begin),
+                                                 static_cast<uInt>(end - begin));
+                    }
+                }
+            });
+        });
+
+    if (use_gzip)
+    {
+        // magic number, deflate, no flags, no modification time, no extra flags, unix
+        compressed_output.front() = {'\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, 3};
+
+        auto checksum = checksums.front();
+        for (const auto chunk : util::irange<std::size_t>(1, number_of_chunks))
+        {
+            const auto chunk_size =
+                std::min(COMPRESSION_CHUNK_SIZE, data_size - chunk * COMPRESSION_CHUNK_SIZE);
+            checksum = crc32_combine(checksum, checksums[chunk], static_cast<z_off_t>(chunk_size));
+        }
+        auto &trailer = compressed_output.back();
+        trailer.clear();
+        appendLittleEndian(trailer, static_cast<std::uint32_t>(checksum));
+        appendLittleEndian(trailer, static_cast<std::uint32_t>(data_size));
+    }
 }
+
+template class Connection<boost::asio::ip::tcp::socket>;
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+template class Connection<boost::asio::local::stream_protocol::socket>;
+#endif
 }
 }
@@ -1,6 +1,7 @@
 #include "server/http/reply.hpp"
 
 #include <string>
+#include <utility>
 
 namespace osrm
 {
@@ -13,11 +14,14 @@ const char ok_html[] = "";
 const char bad_request_html[] = "";
 const char internal_server_error_html[] =
     "{\"code\": \"InternalError\",\"message\":\"Internal Server Error\"}";
+const char service_unavailable_html[] =
+    "{\"code\": \"TooBusy\",\"message\":\"Too many queued requests for this service\"}";
 const char seperators[] = {':', ' '};
 const char crlf[] = {'\r', '\n'};
-const std::string http_ok_string = "HTTP/1.0 200 OK\r\n";
-const std::string http_bad_request_string = "HTTP/1.0 400 Bad Request\r\n";
-const std::string http_internal_server_error_string = "HTTP/1.0 500 Internal Server Error\r\n";
+const std::string http_ok_string = "HTTP/1.1 200 OK\r\n";
+const std::string http_bad_request_string = "HTTP/1.1 400 Bad Request\r\n";
+const std::string http_internal_server_error_string = "HTTP/1.1 500 Internal Server Error\r\n";
+const std::string http_service_unavailable_string = "HTTP/1.1 503 Service Unavailable\r\n";
 
 void reply::set_size(const std::size_t size)
 {
@@ -32,6 +36,28 @@ void reply::set_size(const std::size_t size)
 
 void reply::set_uncompressed_size() { set_size(content.size()); }
 
+void reply::set_keep_alive(const bool keep_alive)
+{
+    for (header &h : headers)
+    {
+        if ("Connection" == h.name)
+        {
+            h.value = keep_alive ? "keep-alive" : "close";
+        }
+    }
+}
+
+void reply::reset(const std::size_t max_content_capacity)
+{
+    auto recycled_content = std::move(content);
+    *this = reply();
+    if (recycled_content.capacity() <= max_content_capacity)
+    {
+        recycled_content.clear();
+        content = std::move(recycled_content);
+    }
+}
+
 std::vector<boost::asio::const_buffer> reply::to_buffers()
 {
     std::vector<boost::asio::const_buffer> buffers;
@@ -87,6 +113,10 @@ std::string reply::status_to_string(const reply::status_type status)
     {
         return bad_request_html;
     }
+    if (reply::service_unavailable == status)
+    {
+        return service_unavailable_html;
+    }
     return internal_server_error_html;
 }
 
@@ -100,12 +130,16 @@ boost::asio::const_buffer reply::status_to_buffer(const reply::status_type statu
     {
         return boost::asio::buffer(http_internal_server_error_string);
     }
+    if (reply::service_unavailable == status)
+    {
+        return boost::asio::buffer(http_service_unavailable_string);
+    }
     return boost::asio::buffer(http_bad_request_string);
 }
 
 reply::reply() : status(ok)
 {
-    // We do not currently support keep alive. Always set 'Connection: close'.
+    // Connections are closed unless the connection decides to keep them alive
     headers.emplace_back("Connection", "close");
 }
 }
@@ -0,0 +1,451 @@
+#include "server/http2/hpack.hpp"
+
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+namespace osrm
+{
+namespace server
+{
+namespace http2
+{
+
+namespace
+{
+struct StaticEntry
+{
+    const char *name;
+    const char *value;
+};
+
+// RFC 7541, Appendix A, the indices start at 1
+const StaticEntry STATIC_TABLE[] = {{":authority", ""},
+                                    {":method", "GET"},
+                                    {":method", "POST"},
+                                    {":path", "/"},
+                                    {":path", "/index.html"},
+                                    {":scheme", "http"},
+                                    {":scheme", "https"},
+                                    {":status", "200"},
+                                    {":status", "204"},
+                                    {":status", "206"},
+                                    {":status", "304"},
+                                    {":status", "400"},
+                                    {":status", "404"},
+                                    {":status", "500"},
+                                    {"accept-charset", ""},
+                                    {"accept-encoding", "gzip, deflate"},
+                                    {"accept-language", ""},
+                                    {"accept-ranges", ""},
+                                    {"accept", ""},
+                                    {"access-control-allow-origin", ""},
+                                    {"age", ""},
+                                    {"allow", ""},
+                                    {"authorization", ""},
+                                    {"cache-control", ""},
+                                    {"content-disposition", ""},
+                                    {"content-encoding", ""},
+                                    {"content-language", ""},
+                                    {"content-length", ""},
+                                    {"content-location", ""},
+                                    {"content-range", ""},
+                                    {"content-type", ""},
+                                    {"cookie", ""},
+                                    {"date", ""},
+                                    {"etag", ""},
+                                    {"expect", ""},
+                                    {"expires", ""},
+                                    {"from", ""},
+                                    {"host", ""},
+                                    {"if-match", ""},
+                                    {"if-modified-since", ""},
+                                    {"if-none-match", ""},
+                                    {"if-range", ""},
+                                    {"if-unmodified-since", ""},
+                                    {"last-modified", ""},
+                                    {"link", ""},
+                                    {"location", ""},
+                                    {"max-forwards", ""},
+                                    {"proxy-authenticate", ""},
+                                    {"proxy-authorization", ""},
+                                    {"range", ""},
+                                    {"referer", ""},
+                                    {"refresh", ""},
+                                    {"retry-after", ""},
+                                    {"server", ""},
+                                    {"set-cookie", ""},
+                                    {"strict-transport-security", ""},
+                                    {"transfer-encoding", ""},
+                                    {"user-agent", ""},
+                                    {"vary", ""},
+                                    {"via", ""},
+                                    {"www-authenticate", ""}};
+const constexpr std::size_t STATIC_TABLE_SIZE = sizeof(STATIC_TABLE) / sizeof(STATIC_TABLE[0]);
+
+// indices of the static table
+const constexpr std::size_t STATUS_200 = 8;
+const constexpr std::size_t STATUS_400 = 12;
+const constexpr std::size_t STATUS_500 = 14;
+
+// the size of a table entry is the size of its name and value plus this overhead
+const constexpr std::size_t ENTRY_OVERHEAD = 32;
+
+const constexpr unsigned MAX_CODE_LENGTH = 30;
+const constexpr unsigned EOS = 256;
+
+// Code lengths of the bytes and of EOS (RFC 7541, Appendix B). The code is canonical, codes of the
+// same length are consecutive in the order of their symbols, so the lengths define it.
+const unsigned char HUFFMAN_CODE_LENGTHS[EOS + 1] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28,
+    30, 28, 28, 28, 28, 28, 28, 28, 28, 28, 6,  10, 10, 12, 13, 6,  8,  11, 10, 10, 8,  11,
+    8,  6,  6,  6,  5,  5,  5,  6,  6,  6,  6,  6,  6,  6,  7,  8,  15, 6,  12, 10, 13, 6,
+    7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,
+    8,  7,  8,  13, 19, 13, 14, 6,  15, 5,  6,  5,  6,  5,  6,  6,  6,  5,  7,  7,  6,  6,
+    6,  5,  6,  7,  6,  5,  5,  6,  7,  7,  7,  7,  7,  15, 11, 14, 13, 28, 20, 22, 20, 20,
+    22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23, 24, 24, 22, 23, 24, 23, 23, 23, 23, 21,
+    22, 23, 22, 23, 23, 24, 22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23, 26, 26, 20, 19, 22, 23,
+    22, 25, 26, 26, 26, 27, 27, 26, 24, 25, 19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26,
+    28, 27, 27, 27, 20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23, 26, 27,
+    26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26, 30};
+
+// The number of codes of each length and the symbols ordered by their codes
+struct HuffmanTable
+{
+    HuffmanTable()
+    {
+        count.fill(0);
+        for (const auto length : HUFFMAN_CODE_LENGTHS)
+        {
+            ++count[length];
+        }
+        std::array<std::uint16_t, MAX_CODE_LENGTH + 1> offsets;
+        offsets[0] = 0;
+        for (unsigned length = 1; length <= MAX_CODE_LENGTH; ++length)
+        {
+            offsets[length] = offsets[length - 1] + count[length - 1];
+        }
+        for (unsigned symbol = 0; symbol <= EOS; ++symbol)
+        {
+            symbols[offsets[HUFFMAN_CODE_LENGTHS[symbol]]++] = symbol;
+        }
+    }
+
+    std::array<std::uint16_t, MAX_CODE_LENGTH + 1> count;
+    std::array<std::uint16_t, EOS + 1> symbols;
+};
+
+// Decodes an integer whose first byte holds prefix_bits bits of it
+bool decodeInteger(const unsigned char *&position,
+                   const unsigned char *end,
+                   const unsigned prefix_bits,
+                   std::size_t &value)
+{
+    if (position == end)
+    {
+        return false;
+    }
+    const std::size_t max_prefix = (1u << prefix_bits) - 1;
+    value = *position++ & max_prefix;
+    if (value < max_prefix)
+    {
+        return true;
+    }
+    // the sizes and lengths we accept fit into far fewer bits
+    for (unsigned shift = 0; position != end && shift <= 28; shift += 7)
+    {
+        const auto byte = *position++;
+        value += static_cast<std::size_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool decodeString(const unsigned char *&position, const unsigned char *end, std::string &output)
+{
+    if (position == end)
+    {
+        return false;
+    }
+    const bool huffman = (*position & 0x80) != 0;
+    std::size_t length = 0;
+    if (!decodeInteger(position, end, 7, length) ||
+        length > static_cast<std::size_t>(end - position))
+    {
+        return false;
+    }
+    const auto begin = reinterpret_cast<const char *>(position);
+    position += length;
+    output.clear();
+    if (huffman)
+    {
+        return decodeHuffman(begin, begin + length, output);
+    }
+    output.assign(begin, length);
+    return true;
+}
+
+void encodeInteger(std::size_t value,
+                   const unsigned prefix_bits,
+                   const unsigned char flags,
+                   std::vector<char> &block)
+{
+    const std::size_t max_prefix = (1u << prefix_bits) - 1;
+    if (value < max_prefix)
+    {
+        block.push_back(static_cast<char>(flags | value));
+        return;
+    }
+    block.push_back(static_cast<char>(flags | max_prefix));
+    value -= max_prefix;
+    while (value >= 0x80)
+    {
+        block.push_back(static_cast<char>(0x80 | (value & 0x7f)));
+        value >>= 7;
+    }
+    block.push_back(static_cast<char>(value));
+}
+
+void encodeString(const std::string &value, std::vector<char> &block)
+{
+    encodeInteger(value.size(), 7, 0, block);
+    block.insert(block.end(), value.begin(), value.end());
+}
+
+bool isConnectionHeader(const std::string &name)
+{
+    return name == "connection" || name == "keep-alive" || name == "proxy-connection" ||
+           name == "transfer-encoding" || name == "upgrade";
+}
+}
+
+constexpr std::size_t HeaderDecoder::MAX_TABLE_SIZE;
+
+HeaderDecoder::HeaderDecoder(const std::size_t max_header_list_size)
+    : max_header_list_size(max_header_list_size)
+{
+}
+
+bool HeaderDecoder::Decode(const char *begin, const char *end, std::vector<http::header> &headers)
+{
+    auto position = reinterpret_cast<const unsigned char *>(begin);
+    const auto block_end = reinterpret_cast<const unsigned char *>(end);
+    std::size_t header_list_size = 0;
+    bool has_fields = false;
+    while (position != block_end)
+    {
+        const auto first_byte = *position;
+        std::size_t index = 0;
+        if ((first_byte & 0x80) != 0)
+        {
+            // indexed field
+            if (!decodeInteger(position, block_end, 7, index))
+            {
+                return false;
+            }
+            headers.emplace_back("", "");
+            if (!GetField(index, headers.back()))
+            {
+                return false;
+            }
+        }
+        else if ((first_byte & 0xe0) == 0x20)
+        {
+            // dynamic table size updates precede the fields of a block
+            if (has_fields || !decodeInteger(position, block_end, 5, index) ||
+                index > MAX_TABLE_SIZE)
+            {
+                return false;
+            }
+            max_table_size = index;
+            Evict(max_table_size);
+            continue;
+        }
+        else
+        {
+            // literals with incremental indexing index their name in six bits, the ones without
+            // indexing and the never indexed ones in four
+            const bool with_indexing = (first_byte & 0xc0) == 0x40;
+            if (!decodeInteger(position, block_end, with_indexing ? 6 : 4, index))
+            {
+                return false;
+            }
+            headers.emplace_back("", "");
+            auto &field = headers.back();
+            if (index == 0 ? !decodeString(position, block_end, field.name)
+                           : !GetField(index, field))
+            {
+                return false;
+            }
+            if (!decodeString(position, block_end, field.value))
+            {
+                return false;
+            }
+            if (with_indexing)
+            {
+                Insert(field);
+            }
+        }
+
+        has_fields = true;
+        header_list_size +=
+            headers.back().name.size() + headers.back().value.size() + ENTRY_OVERHEAD;
+        if (header_list_size > max_header_list_size)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HeaderDecoder::GetField(const std::size_t index, http::header &field) const
+{
+    if (index == 0)
+    {
+        return false;
+    }
+    if (index <= STATIC_TABLE_SIZE)
+    {
+        field.name = STATIC_TABLE[index - 1].name;
+        field.value = STATIC_TABLE[index - 1].value;
+        return true;
+    }
+    if (index - STATIC_TABLE_SIZE > dynamic_table.size())
+    {
+        return false;
+    }
+    field = dynamic_table[index - STATIC_TABLE_SIZE - 1];
+    return true;
+}
+
+void HeaderDecoder::Insert(const http::header &field)
+{
+    const auto entry_size = field.name.size() + field.value.size() + ENTRY_OVERHEAD;
+    // an entry larger than the table empties it
+    if (entry_size > max_table_size)
+    {
+        Evict(0);
+        return;
+    }
+    Evict(max_table_size - entry_size);
+    dynamic_table.emplace_front(field.name, field.value);
+    table_size += entry_size;
+}
+
+void HeaderDecoder::Evict(const std::size_t max_size)
+{
+    while (table_size > max_size)
+    {
+        const auto &oldest = dynamic_table.back();
+        table_size -= oldest.name.size() + oldest.value.size() + ENTRY_OVERHEAD;
+        dynamic_table.pop_back();
+    }
+}
+
+void encodeHeaders(const unsigned status,
+                   const std::vector<http::header> &headers,
+                   std::vector<char> &block)
+{
+    switch (status)
+    {
+    case 200:
+        encodeInteger(STATUS_200, 7, 0x80, block);
+        break;
+    case 400:
+        encodeInteger(STATUS_400, 7, 0x80, block);
+        break;
+    case 500:
+        encodeInteger(STATUS_500, 7, 0x80, block);
+        break;
+    default:
+        // literal without indexing that takes the name of an indexed status
+        encodeInteger(STATUS_200, 4, 0, block);
+        encodeString(std::to_string(status), block);
+        break;
+    }
+
+    for (const auto &header : headers)
+    {
+        const auto name = boost::algorithm::to_lower_copy(header.name);
+        if (isConnectionHeader(name))
+        {
+            continue;
+        }
+        const auto entry =
+            std::find_if(std::begin(STATIC_TABLE),
+                         std::end(STATIC_TABLE),
+                         [&name](const StaticEntry &entry) { return name == entry.name; });
+        if (entry != std::end(STATIC_TABLE))
+        {
+            encodeInteger(std::distance(std::begin(STATIC_TABLE), entry) + 1, 4, 0, block);
+        }
+        else
+        {
+            block.push_back(0);
+            encodeString(name, block);
+        }
+        encodeString(header.value, block);
+    }
+}
+
+bool decodeHuffman(const char *begin, const char *end, std::string &output)
+{
+    static const HuffmanTable table;
+
+    // the code read so far and the first code and symbol index of its length
+    std::uint32_t code = 0;
+    std::uint32_t first_code = 0;
+    unsigned first_index = 0;
+    unsigned length = 0;
+    // the last symbol is padded with the most significant bits of EOS, which are all ones
+    bool only_ones = true;
+    for (auto position = begin; position != end; ++position)
+    {
+        const auto byte = static_cast<unsigned char>(*position);
+        for (int shift = 7; shift >= 0; --shift)
+        {
+            const unsigned bit = (byte >> shift) & 1;
+            code |= bit;
+            only_ones = only_ones && bit == 1;
+            ++length;
+
+            const unsigned count = table.count[length];
+            if (code < first_code + count)
+            {
+                const auto symbol = table.symbols[first_index + code - first_code];
+                if (symbol == EOS)
+                {
+                    return false;
+                }
+                output.push_back(static_cast<char>(symbol));
+                code = 0;
+                first_code = 0;
+                first_index = 0;
+                length = 0;
+                only_ones = true;
+            }
+            else
+            {
+                if (length == MAX_CODE_LENGTH)
+                {
+                    return false;
+                }
+                first_index += count;
+                first_code = (first_code + count) << 1;
+                code <<= 1;
+            }
+        }
+    }
+    return length < 8 && only_ones;
+}
+}
+}
+}
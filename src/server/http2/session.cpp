@@ -0,0 +1,753 @@
+#include "server/http2/session.hpp"
+#include "server/request_parser.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+namespace osrm
+{
+namespace server
+{
+namespace http2
+{
+
+namespace
+{
+const constexpr std::size_t FRAME_HEADER_SIZE = 9;
+// the frame size and windows all connections start with
+const constexpr std::size_t DEFAULT_MAX_FRAME_SIZE = 16384;
+const constexpr std::size_t MAX_MAX_FRAME_SIZE = (1 << 24) - 1;
+const constexpr std::int64_t DEFAULT_WINDOW_SIZE = 65535;
+const constexpr std::int64_t MAX_WINDOW_SIZE = 0x7fffffff;
+
+const constexpr std::uint8_t FLAG_END_STREAM = 0x1;
+const constexpr std::uint8_t FLAG_ACK = 0x1;
+const constexpr std::uint8_t FLAG_END_HEADERS = 0x4;
+const constexpr std::uint8_t FLAG_PADDED = 0x8;
+const constexpr std::uint8_t FLAG_PRIORITY = 0x20;
+
+const constexpr std::uint16_t SETTINGS_ENABLE_PUSH = 0x2;
+const constexpr std::uint16_t SETTINGS_MAX_CONCURRENT_STREAMS = 0x3;
+const constexpr std::uint16_t SETTINGS_INITIAL_WINDOW_SIZE = 0x4;
+const constexpr std::uint16_t SETTINGS_MAX_FRAME_SIZE = 0x5;
+const constexpr std::uint16_t SETTINGS_MAX_HEADER_LIST_SIZE = 0x6;
+
+std::uint32_t readUint32(const char *data)
+{
+    const auto bytes = reinterpret_cast<const unsigned char *>(data);
+    return (std::uint32_t{bytes[0]} << 24) | (std::uint32_t{bytes[1]} << 16) |
+           (std::uint32_t{bytes[2]} << 8) | std::uint32_t{bytes[3]};
+}
+
+void appendUint32(std::vector<char> &buffer, const std::uint32_t value)
+{
+    for (const auto shift : {24, 16, 8, 0})
+    {
+        buffer.push_back(static_cast<char>((value >> shift) & 0xff));
+    }
+}
+
+void appendSetting(std::vector<char> &buffer, const std::uint16_t id, const std::uint32_t value)
+{
+    buffer.push_back(static_cast<char>(id >> 8));
+    buffer.push_back(static_cast<char>(id & 0xff));
+    appendUint32(buffer, value);
+}
+
+// Removes the padding of DATA and HEADERS frames, false if it is longer than the frame
+bool removePadding(const std::uint8_t flags, const char *&payload, std::size_t &length)
+{
+    if ((flags & FLAG_PADDED) == 0)
+    {
+        return true;
+    }
+    if (length == 0)
+    {
+        return false;
+    }
+    const std::size_t padding = static_cast<unsigned char>(payload[0]);
+    if (padding >= length)
+    {
+        return false;
+    }
+    payload += 1;
+    length -= 1 + padding;
+    return true;
+}
+
+// Decimal values of headers like Content-Length, false if they are no number or exceed max_value
+bool parseNumber(const std::string &value, const std::size_t max_value, std::size_t &number)
+{
+    if (value.empty())
+    {
+        return false;
+    }
+    number = 0;
+    for (const char digit : value)
+    {
+        if (digit < '0' || digit > '9' || number > max_value)
+        {
+            return false;
+        }
+        number = number * 10 + (digit - '0');
+    }
+    return number <= max_value;
+}
+}
+
+const std::string Session::CLIENT_PREFACE = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr std::size_t Session::MAX_CONCURRENT_STREAMS;
+constexpr std::size_t Session::MAX_HEADER_LIST_SIZE;
+
+Session::Session()
+    : header_decoder(MAX_HEADER_LIST_SIZE), send_window(DEFAULT_WINDOW_SIZE),
+      initial_stream_send_window(DEFAULT_WINDOW_SIZE), max_send_frame_size(DEFAULT_MAX_FRAME_SIZE)
+{
+    std::vector<char> settings;
+    appendSetting(settings, SETTINGS_MAX_CONCURRENT_STREAMS, MAX_CONCURRENT_STREAMS);
+    appendSetting(settings, SETTINGS_MAX_HEADER_LIST_SIZE, MAX_HEADER_LIST_SIZE);
+    WriteFrame(FrameType::settings, 0, 0, settings.data(), settings.size());
+}
+
+bool Session::Consume(const char *begin,
+                      const char *end,
+                      std::vector<std::uint32_t> &complete_streams)
+{
+    if (closed)
+    {
+        return false;
+    }
+
+    input.insert(input.end(), begin, end);
+    std::size_t position = 0;
+    bool valid = true;
+    while (valid && input.size() - position >= FRAME_HEADER_SIZE)
+    {
+        const auto header = input.data() + position;
+        const auto bytes = reinterpret_cast<const unsigned char *>(header);
+        const std::size_t length = (bytes[0] << 16) | (bytes[1] << 8) | bytes[2];
+        if (length > DEFAULT_MAX_FRAME_SIZE)
+        {
+            valid = Fail(ErrorCode::frame_size_error);
+            break;
+        }
+        if (input.size() - position - FRAME_HEADER_SIZE < length)
+        {
+            break;
+        }
+        valid = ProcessFrame(static_cast<FrameType>(header[3]),
+                             static_cast<std::uint8_t>(header[4]),
+                             readUint32(header + 5) & 0x7fffffff,
+                             header + FRAME_HEADER_SIZE,
+                             length,
+                             complete_streams);
+        position += FRAME_HEADER_SIZE + length;
+    }
+
+    if (valid)
+    {
+        input.erase(input.begin(), input.begin() + position);
+    }
+    else
+    {
+        input.clear();
+    }
+    return valid;
+}
+
+bool Session::ProcessFrame(const FrameType type,
+                           const std::uint8_t flags,
+                           const std::uint32_t stream_id,
+                           const char *payload,
+                           const std::size_t length,
+                           std::vector<std::uint32_t> &complete_streams)
+{
+    // a header block is only continued by the frames that directly follow it
+    if (header_block_stream != 0 &&
+        (type != FrameType::continuation || stream_id != header_block_stream))
+    {
+        return Fail(ErrorCode::protocol_error);
+    }
+    // the client preface ends with the settings of the client
+    if (!settings_received && type != FrameType::settings)
+    {
+        return Fail(ErrorCode::protocol_error);
+    }
+
+    switch (type)
+    {
+    case FrameType::data:
+        return ProcessData(flags, stream_id, payload, length, complete_streams);
+    case FrameType::headers:
+        return ProcessHeaders(flags, stream_id, payload, length, complete_streams);
+    case FrameType::priority:
+        // streams are answered as their queries finish, priorities don't change that
+        if (stream_id == 0)
+        {
+            return Fail(ErrorCode::protocol_error);
+        }
+        return length == 5 || Fail(ErrorCode::frame_size_error);
+    case FrameType::rst_stream:
+    {
+        if (stream_id == 0 || stream_id > last_stream_id)
+        {
+            return Fail(ErrorCode::protocol_error);
+        }
+        if (length != 4)
+        {
+            return Fail(ErrorCode::frame_size_error);
+        }
+        const auto stream = streams.find(stream_id);
+        if (stream != streams.end())
+        {
+            ResetStream(stream);
+        }
+        return true;
+    }
+    case FrameType::settings:
+        return ProcessSettings(flags, stream_id, payload, length);
+    case FrameType::push_promise:
+        // only servers push
+        return Fail(ErrorCode::protocol_error);
+    case FrameType::ping:
+        if (stream_id != 0)
+        {
+            return Fail(ErrorCode::protocol_error);
+        }
+        if (length != 8)
+        {
+            return Fail(ErrorCode::frame_size_error);
+        }
+        if ((flags & FLAG_ACK) == 0)
+        {
+            WriteFrame(FrameType::ping, FLAG_ACK, 0, payload, length);
+        }
+        return true;
+    case FrameType::goaway:
+        if (stream_id != 0)
+        {
+            return Fail(ErrorCode::protocol_error);
+        }
+        if (length < 8)
+        {
+            return Fail(ErrorCode::frame_size_error);
+        }
+        // the open streams are still answered
+        goaway_received = true;
+        return true;
+    case FrameType::window_update:
+        return ProcessWindowUpdate(stream_id, payload, length);
+    case FrameType::continuation:
+        if (header_block_stream == 0)
+        {
+            return Fail(ErrorCode::protocol_error);
+        }
+        header_block.insert(header_block.end(), payload, payload + length);
+        if (header_block.size() > MAX_HEADER_LIST_SIZE)
+        {
+            return Fail(ErrorCode::protocol_error);
+        }
+        return (flags & FLAG_END_HEADERS) == 0 || ProcessHeaderBlock(complete_streams);
+    default:
+        // frames of unknown types are ignored
+        return true;
+    }
+}
+
+bool Session::ProcessData(const std::uint8_t flags,
+                          const std::uint32_t stream_id,
+                          const char *payload,
+                          const std::size_t length,
+                          std::vector<std::uint32_t> &complete_streams)
+{
+    if (stream_id == 0 || stream_id > last_stream_id)
+    {
+        return Fail(ErrorCode::protocol_error);
+    }
+    auto data = payload;
+    auto data_length = length;
+    if (!removePadding(flags, data, data_length))
+    {
+        return Fail(ErrorCode::protocol_error);
+    }
+
+    // the bodies are limited by their size instead of the windows, which are enlarged right away
+    if (length > 0)
+    {
+        WriteWindowUpdate(0, length);
+    }
+
+    const auto stream = streams.find(stream_id);
+    // frames of streams that were reset can still be on their way
+    if (stream == streams.end())
+    {
+        return true;
+    }
+    if (stream->second.complete)
+    {
+        WriteRstStream(stream_id, ErrorCode::stream_closed);
+        ResetStream(stream);
+        return true;
+    }
+
+    auto &request = stream->second.request;
+    if (request.body.size() + data_length > RequestParser::MAX_CONTENT_LENGTH)
+    {
+        WriteRstStream(stream_id, ErrorCode::refused_stream);
+        streams.erase(stream);
+        return true;
+    }
+    request.body.append(data, data_length);
+
+    if ((flags & FLAG_END_STREAM) != 0)
+    {
+        stream->second.complete = true;
+        complete_streams.push_back(stream_id);
+    }
+    else if (length > 0)
+    {
+        WriteWindowUpdate(stream_id, length);
+    }
+    return true;
+}
+
+bool Session::ProcessHeaders(const std::uint8_t flags,
+                             const std::uint32_t stream_id,
+                             const char *payload,
+                             const std::size_t length,
+                             std::vector<std::uint32_t> &complete_streams)
+{
+    // clients open the streams with odd ids
+    if (stream_id % 2 == 0)
+    {
+        return Fail(ErrorCode::protocol_error);
+    }
+    auto fragment = payload;
+    auto fragment_length = length;
+    if (!removePadding(flags, fragment, fragment_length))
+    {
+        return Fail(ErrorCode::protocol_error);
+    }
+    if ((flags & FLAG_PRIORITY) != 0)
+    {
+        if (fragment_length < 5)
+        {
+            return Fail(ErrorCode::frame_size_error);
+        }
+        fragment += 5;
+        fragment_length -= 5;
+    }
+
+    header_block.assign(fragment, fragment + fragment_length);
+    header_block_stream = stream_id;
+    header_block_ends_stream = (flags & FLAG_END_STREAM) != 0;
+    return (flags & FLAG_END_HEADERS) == 0 || ProcessHeaderBlock(complete_streams);
+}
+
+bool Session::ProcessHeaderBlock(std::vector<std::uint32_t> &complete_streams)
+{
+    const auto stream_id = header_block_stream;
+    header_block_stream = 0;
+
+    // every block is decoded, it might change the dynamic table
+    std::vector<http::header> fields;
+    if (!header_decoder.Decode(
+            header_block.data(), header_block.data() + header_block.size(), fields))
+    {
+        return Fail(ErrorCode::compression_error);
+    }
+
+    const auto existing_stream = streams.find(stream_id);
+    if (existing_stream != streams.end())
+    {
+        // trailers, which have to end the request
+        if (existing_stream->second.complete || !header_block_ends_stream)
+        {
+            return Fail(ErrorCode::protocol_error);
+        }
+        existing_stream->second.complete = true;
+        complete_streams.push_back(stream_id);
+        return true;
+    }
+    // trailers of a stream that was reset
+    if (stream_id <= last_stream_id)
+    {
+        return true;
+    }
+
+    last_stream_id = stream_id;
+    if (streams.size() >= MAX_CONCURRENT_STREAMS)
+    {
+        WriteRstStream(stream_id, ErrorCode::refused_stream);
+        return true;
+    }
+
+    auto &stream = streams[stream_id];
+    stream.send_window = initial_stream_send_window;
+    auto &request = stream.request;
+    request.cancelled = std::make_shared<std::atomic<bool>>(false);
+    bool has_method = false;
+    bool has_path = false;
+    bool valid = true;
+    std::size_t content_length = 0;
+    for (const auto &field : fields)
+    {
+        if (field.name == ":method")
+        {
+            has_method = true;
+        }
+        else if (field.name == ":path")
+        {
+            has_path = true;
+            request.uri = field.value;
+        }
+        else if (field.name == "accept-encoding")
+        {
+            // giving gzip precedence over deflate
+            if (boost::icontains(field.value, "deflate"))
+            {
+                stream.compression = http::deflate_rfc1951;
+            }
+            if (boost::icontains(field.value, "gzip"))
+            {
+                stream.compression = http::gzip_rfc1952;
+            }
+        }
+        else if (field.name == "referer")
+        {
+            request.referrer = field.value;
+        }
+        else if (field.name == "user-agent")
+        {
+            request.agent = field.value;
+        }
+        else if (field.name == "content-length")
+        {
+            valid = valid &&
+                    parseNumber(field.value, RequestParser::MAX_CONTENT_LENGTH, content_length);
+        }
+        else if (field.name == "x-osrm-timeout")
+        {
+            // milliseconds the client is willing to wait for the reply, longer ones are cut
+            std::size_t timeout = 0;
+            valid = valid && parseNumber(field.value, std::numeric_limits<std::size_t>::max() / 10,
+                                         timeout);
+            request.timeout = std::chrono::milliseconds(
+                std::min<std::size_t>(timeout, RequestParser::MAX_TIMEOUT_MILLISECONDS));
+        }
+    }
+
+    if (!valid || !has_method || !has_path)
+    {
+        WriteRstStream(stream_id, ErrorCode::protocol_error);
+        streams.erase(stream_id);
+        return true;
+    }
+    request.body.reserve(content_length);
+    if (header_block_ends_stream)
+    {
+        stream.complete = true;
+        complete_streams.push_back(stream_id);
+    }
+    return true;
+}
+
+bool Session::ProcessSettings(const std::uint8_t flags,
+                              const std::uint32_t stream_id,
+                              const char *payload,
+                              const std::size_t length)
+{
+    if (stream_id != 0)
+    {
+        return Fail(ErrorCode::protocol_error);
+    }
+    if ((flags & FLAG_ACK) != 0)
+    {
+        return length == 0 || Fail(ErrorCode::frame_size_error);
+    }
+    if (length % 6 != 0)
+    {
+        return Fail(ErrorCode::frame_size_error);
+    }
+
+    for (std::size_t offset = 0; offset < length; offset += 6)
+    {
+        const auto id = static_cast<std::uint16_t>(
+            (static_cast<unsigned char>(payload[offset]) << 8) |
+            static_cast<unsigned char>(payload[offset + 1]));
+        const std::uint32_t value = readUint32(payload + offset + 2);
+        switch (id)
+        {
+        case SETTINGS_ENABLE_PUSH:
+            if (value > 1)
+            {
+                return Fail(ErrorCode::protocol_error);
+            }
+            break;
+        case SETTINGS_INITIAL_WINDOW_SIZE:
+        {
+            if (value > MAX_WINDOW_SIZE)
+            {
+                return Fail(ErrorCode::flow_control_error);
+            }
+            // changes the windows of the open streams by the difference
+            const auto delta = static_cast<std::int64_t>(value) - initial_stream_send_window;
+            for (auto &stream : streams)
+            {
+                stream.second.send_window += delta;
+                if (stream.second.send_window > MAX_WINDOW_SIZE)
+                {
+                    return Fail(ErrorCode::flow_control_error);
+                }
+            }
+            initial_stream_send_window = value;
+            break;
+        }
+        case SETTINGS_MAX_FRAME_SIZE:
+            if (value < DEFAULT_MAX_FRAME_SIZE || value > MAX_MAX_FRAME_SIZE)
+            {
+                return Fail(ErrorCode::protocol_error);
+            }
+            max_send_frame_size = value;
+            break;
+        default:
+            // the table size only limits the dynamic table we don't use, unknown ones are ignored
+            break;
+        }
+    }
+
+    settings_received = true;
+    WriteFrame(FrameType::settings, FLAG_ACK, 0, nullptr, 0);
+    SendData();
+    return true;
+}
+
+bool Session::ProcessWindowUpdate(const std::uint32_t stream_id,
+                                  const char *payload,
+                                  const std::size_t length)
+{
+    if (length != 4)
+    {
+        return Fail(ErrorCode::frame_size_error);
+    }
+    const std::int64_t increment = readUint32(payload) & 0x7fffffff;
+    if (increment == 0 || stream_id > last_stream_id)
+    {
+        return Fail(ErrorCode::protocol_error);
+    }
+
+    if (stream_id == 0)
+    {
+        send_window += increment;
+        if (send_window > MAX_WINDOW_SIZE)
+        {
+            return Fail(ErrorCode::flow_control_error);
+        }
+    }
+    else
+    {
+        const auto stream = streams.find(stream_id);
+        if (stream == streams.end())
+        {
+            return true;
+        }
+        stream->second.send_window += increment;
+        if (stream->second.send_window > MAX_WINDOW_SIZE)
+        {
+            return Fail(ErrorCode::flow_control_error);
+        }
+    }
+    SendData();
+    return true;
+}
+
+void Session::ResetStream(const std::map<std::uint32_t, Stream>::iterator stream)
+{
+    // a running query still writes to the reply, the stream goes once it is done
+    if (stream->second.complete && !stream->second.replying)
+    {
+        stream->second.request.cancelled->store(true, std::memory_order_relaxed);
+        stream->second.reset = true;
+    }
+    else
+    {
+        streams.erase(stream);
+    }
+}
+
+bool Session::Fail(const ErrorCode error)
+{
+    std::vector<char> payload;
+    appendUint32(payload, last_stream_id);
+    appendUint32(payload, static_cast<std::uint32_t>(error));
+    WriteFrame(FrameType::goaway, 0, 0, payload.data(), payload.size());
+
+    closed = true;
+    for (auto &stream : streams)
+    {
+        if (stream.second.request.cancelled)
+        {
+            stream.second.request.cancelled->store(true, std::memory_order_relaxed);
+        }
+    }
+    return false;
+}
+
+http::request &Session::GetRequest(const std::uint32_t stream_id)
+{
+    BOOST_ASSERT(streams.count(stream_id) == 1);
+    return streams.find(stream_id)->second.request;
+}
+
+http::reply &Session::GetReply(const std::uint32_t stream_id)
+{
+    BOOST_ASSERT(streams.count(stream_id) == 1);
+    return streams.find(stream_id)->second.reply;
+}
+
+http::compression_type Session::GetCompression(const std::uint32_t stream_id) const
+{
+    BOOST_ASSERT(streams.count(stream_id) == 1);
+    return streams.find(stream_id)->second.compression;
+}
+
+void Session::SendReply(const std::uint32_t stream_id, std::vector<char> body)
+{
+    const auto stream_iter = streams.find(stream_id);
+    BOOST_ASSERT(stream_iter != streams.end());
+    auto &stream = stream_iter->second;
+    BOOST_ASSERT(stream.complete && !stream.replying);
+    if (closed || stream.reset)
+    {
+        streams.erase(stream_iter);
+        return;
+    }
+
+    // the header block is split into frames the client accepts
+    std::vector<char> block;
+    encodeHeaders(stream.reply.status, stream.reply.headers, block);
+    std::size_t offset = 0;
+    do
+    {
+        const auto size = std::min(block.size() - offset, max_send_frame_size);
+        const auto type = offset == 0 ? FrameType::headers : FrameType::continuation;
+        std::uint8_t flags = offset + size == block.size() ? FLAG_END_HEADERS : 0;
+        if (offset == 0 && body.empty())
+        {
+            flags |= FLAG_END_STREAM;
+        }
+        WriteFrame(type, flags, stream_id, block.data() + offset, size);
+        offset += size;
+    } while (offset < block.size());
+
+    if (body.empty())
+    {
+        streams.erase(stream_iter);
+        return;
+    }
+    stream.body = std::move(body);
+    stream.replying = true;
+    SendData();
+}
+
+void Session::SendData()
+{
+    bool sent_data = true;
+    while (sent_data && send_window > 0)
+    {
+        sent_data = false;
+        auto stream = streams.begin();
+        while (stream != streams.end() && send_window > 0)
+        {
+            auto &state = stream->second;
+            if (!state.replying || state.send_window <= 0)
+            {
+                ++stream;
+                continue;
+            }
+            const auto remaining = state.body.size() - state.sent;
+            const auto size = static_cast<std::size_t>(
+                std::min({static_cast<std::int64_t>(remaining),
+                          state.send_window,
+                          send_window,
+                          static_cast<std::int64_t>(max_send_frame_size)}));
+            const bool last_frame = size == remaining;
+            WriteFrame(FrameType::data,
+                       last_frame ? FLAG_END_STREAM : 0,
+                       stream->first,
+                       state.body.data() + state.sent,
+                       size);
+            state.sent += size;
+            state.send_window -= size;
+            send_window -= size;
+            sent_data = true;
+            stream = last_frame ? streams.erase(stream) : std::next(stream);
+        }
+    }
+}
+
+void Session::Close()
+{
+    closed = true;
+    output.clear();
+    for (auto &stream : streams)
+    {
+        if (stream.second.request.cancelled)
+        {
+            stream.second.request.cancelled->store(true, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool Session::HasOutput() const { return !output.empty(); }
+
+void Session::TakeOutput(std::vector<char> &output_)
+{
+    output_.clear();
+    output_.swap(output);
+}
+
+bool Session::HasStreams() const { return !streams.empty() || header_block_stream != 0; }
+
+bool Session::IsDone() const { return closed || (goaway_received && !HasStreams()); }
+
+void Session::WriteFrame(const FrameType type,
+                         const std::uint8_t flags,
+                         const std::uint32_t stream_id,
+                         const char *payload,
+                         const std::size_t length)
+{
+    BOOST_ASSERT(length <= MAX_MAX_FRAME_SIZE);
+    output.push_back(static_cast<char>((length >> 16) & 0xff));
+    output.push_back(static_cast<char>((length >> 8) & 0xff));
+    output.push_back(static_cast<char>(length & 0xff));
+    output.push_back(static_cast<char>(type));
+    output.push_back(static_cast<char>(flags));
+    appendUint32(output, stream_id);
+    output.insert(output.end(), payload, payload + length);
+}
+
+void Session::WriteRstStream(const std::uint32_t stream_id, const ErrorCode error)
+{
+    std::vector<char> payload;
+    appendUint32(payload, static_cast<std::uint32_t>(error));
+    WriteFrame(FrameType::rst_stream, 0, stream_id, payload.data(), payload.size());
+}
+
+void Session::WriteWindowUpdate(const std::uint32_t stream_id, const std::size_t increment)
+{
+    std::vector<char> payload;
+    appendUint32(payload, static_cast<std::uint32_t>(increment));
+    WriteFrame(FrameType::window_update, 0, stream_id, payload.data(), payload.size());
+}
+}
+}
+}
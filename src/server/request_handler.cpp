@@ -5,12 +5,19 @@
 #include "server/http/reply.hpp"
 #include "server/http/request.hpp"
 
+#include "util/allocation_statistics.hpp"
 #include "util/json_renderer.hpp"
+#include "util/json_writer.hpp"
+#include "util/page_fault_counter.hpp"
+#include "util/probes.hpp"
 #include "util/simple_logger.hpp"
 #include "util/string_util.hpp"
 #include "util/typedefs.hpp"
 #include "util/timing_util.hpp"
 
+#include "engine/query_deadline.hpp"
+#include "engine/query_metrics.hpp"
+#include "engine/search_statistics.hpp"
 #include "engine/status.hpp"
 #include "osrm/osrm.hpp"
 #include "util/json_container.hpp"
@@ -22,6 +29,7 @@
 #include <ctime>
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <iterator>
 #include <string>
@@ -37,37 +45,193 @@ void RequestHandler::RegisterServiceHandler(
     service_handler = std::move(service_handler_);
 }
 
-void RequestHandler::HandleRequest(const http::request &current_request, http::reply &current_reply)
+void RequestHandler::RegisterSlowQueryLog(std::unique_ptr<SlowQueryLog> slow_query_log_)
 {
+    slow_query_log = std::move(slow_query_log_);
+}
+
+void RequestHandler::SetQueryTimeout(const std::chrono::steady_clock::duration timeout)
+{
+    query_timeout = timeout;
+}
+
+void RequestHandler::WarmUpThread()
+{
+    if (service_handler)
+    {
+        service_handler->WarmUpThread();
+    }
+}
+
+void RequestHandler::FinishRequest(const http::request &current_request,
+                                   const http::reply &current_reply)
+{
+    if (slow_query_log)
+    {
+        slow_query_log->Log(current_request, current_reply);
+    }
+}
+
+void RequestHandler::HandleRequest(const http::request &current_request,
+                                   http::reply &current_reply,
+                                   std::function<void()> reply_ready)
+{
+    current_reply.profile.start = std::chrono::steady_clock::now();
+
     if (!service_handler)
     {
         current_reply = http::reply::stock_reply(http::reply::internal_server_error);
         util::SimpleLogger().Write(logWARNING) << "No service handler registered." << std::endl;
+        reply_ready();
         return;
     }
 
-    // parse command
+    if (current_request.uri == "/metrics")
+    {
+        std::string metrics;
+        service_handler->WriteMetrics(metrics);
+        current_reply.content.assign(metrics.begin(), metrics.end());
+        current_reply.headers.emplace_back("Content-Type", "text/plain; version=0.0.4");
+        current_reply.headers.emplace_back("Content-Length",
+                                           std::to_string(current_reply.content.size()));
+        reply_ready();
+        return;
+    }
+
+    // the URL is parsed on the thread of the connection, the query might run on another one
+    const auto allocations_before_parsing = util::GetAllocationStatistics();
+
+    // parse command straight from the request, the grammar only decodes escapes in the query.
+    // POST requests append the query in their body to the URI, which costs a copy of the body.
+    std::string post_url;
+    if (!current_request.body.empty())
+    {
+        post_url.reserve(current_request.uri.size() + 1 + current_request.body.size());
+        post_url = current_request.uri;
+        if (post_url.empty() || post_url.back() != '/')
+        {
+            post_url.push_back('/');
+        }
+        post_url.append(current_request.body);
+    }
+    const auto &request_string = current_request.body.empty() ? current_request.uri : post_url;
+    util::SimpleLogger().Write(logDEBUG) << "req: " << current_request.uri;
+
+    auto api_iterator = request_string.cbegin();
+    auto maybe_parsed_url = api::parseURL(api_iterator, request_string.cend());
+    std::string url_error;
+    if (api_iterator != request_string.cend())
+    {
+        maybe_parsed_url = boost::none;
+    }
+    if (!maybe_parsed_url)
+    {
+        const std::size_t position = std::distance(request_string.cbegin(), api_iterator);
+        const auto context_begin =
+            request_string.begin() + ((position < 3) ? 0 : (position - 3UL));
+        BOOST_ASSERT(context_begin >= request_string.begin());
+        const auto context_end =
+            request_string.begin() + std::min<std::size_t>(position + 3UL, request_string.size());
+        BOOST_ASSERT(context_end <= request_string.end());
+        std::string context(context_begin, context_end);
+
+        url_error = "URL string malformed close to position " + std::to_string(position) +
+                    ": \"" + context + "\"";
+    }
+    const auto service = maybe_parsed_url ? maybe_parsed_url->service : std::string();
+    current_reply.profile.parse = std::chrono::steady_clock::now() - current_reply.profile.start;
+
+    if (util::ALLOCATION_TRACKING_ENABLED)
+    {
+        auto parsing_allocations = util::GetAllocationStatistics();
+        parsing_allocations -= allocations_before_parsing;
+        current_reply.allocations += parsing_allocations;
+    }
+
+    // the service decides on which thread the query runs
+    const bool scheduled = service_handler->Schedule(
+        service,
+        [ this, &current_request, &current_reply, reply_ready,
+          maybe_parsed_url = std::move(maybe_parsed_url), url_error = std::move(url_error) ]()
+            mutable {
+                HandleQuery(
+                    current_request, current_reply, std::move(maybe_parsed_url), url_error);
+                reply_ready();
+            });
+
+    if (!scheduled)
+    {
+        current_reply = http::reply::stock_reply(http::reply::service_unavailable);
+        util::SimpleLogger().Write(logWARNING) << "[server busy] too many queued " << service
+                                               << " requests, uri: " << current_request.uri;
+        reply_ready();
+    }
+}
+
+void RequestHandler::HandleQuery(const http::request &current_request,
+                                 http::reply &current_reply,
+                                 boost::optional<api::ParsedURL> maybe_parsed_url,
+                                 const std::string &url_error)
+{
     try
     {
+        util::AllocationRecorder allocation_recorder(current_reply.allocations);
         TIMER_START(request_duration);
-        std::string request_string;
-        util::URIDecode(current_request.uri, request_string);
-        util::SimpleLogger().Write(logDEBUG) << "req: " << request_string;
-
-        auto api_iterator = request_string.begin();
-        auto maybe_parsed_url = api::parseURL(api_iterator, request_string.end());
+        auto &profile = current_reply.profile;
+        profile.queue = request_duration_start - profile.start - profile.parse;
+        MAJOR_FAULTS_START(request);
         ServiceHandler::ResultT result;
 
+        // only successful queries of known services count into the serialization metrics
+        engine::QueryType query_type;
+        bool record_serialization = false;
+
         // check if the was an error with the request
-        if (maybe_parsed_url && api_iterator == request_string.end())
+        if (maybe_parsed_url)
         {
+            record_serialization =
+                engine::QueryMetrics::FromString(maybe_parsed_url->service, query_type);
+
+            // the shorter timeout of the server and the client counts from the arrival of the
+            // request, the searches stop there or once the client is gone
+            auto timeout = query_timeout;
+            if (current_request.timeout > std::chrono::milliseconds::zero() &&
+                (timeout == RequestProfile::Duration::zero() || current_request.timeout < timeout))
+            {
+                timeout = current_request.timeout;
+            }
+            const auto deadline = timeout == RequestProfile::Duration::zero()
+                                      ? engine::QueryDeadline::Clock::time_point::max()
+                                      : profile.start + timeout;
 
-            const engine::Status status =
-                service_handler->RunQuery(*std::move(maybe_parsed_url), result);
+            // services can reject a query before it reaches the engine, which resets these
+            engine::GetQueryProfile().Reset();
+            engine::GetSearchStatistics().Reset();
+            engine::Status status;
+            {
+                engine::QueryDeadlineScope deadline_scope(
+                    engine::QueryDeadline(deadline, current_request.cancelled));
+                status = service_handler->RunQuery(*std::move(maybe_parsed_url), result);
+            }
+
+            const auto &query_profile = engine::GetQueryProfile();
+            profile.snap =
+                std::chrono::microseconds(query_profile[engine::QueryPhase::PhantomLookup]);
+            profile.unpack = query_profile.unpacking;
+            profile.search = std::max<RequestProfile::Duration>(
+                std::chrono::microseconds(query_profile[engine::QueryPhase::Search]) -
+                    query_profile.unpacking,
+                RequestProfile::Duration::zero());
+            profile.guidance =
+                std::chrono::microseconds(query_profile[engine::QueryPhase::Assembly]);
+            profile.search_statistics = engine::GetSearchStatistics();
             if (status != engine::Status::Ok)
             {
-                // 4xx bad request return code
-                current_reply.status = http::reply::bad_request;
+                // 4xx bad request return code, 5xx if the query ran out of time
+                current_reply.status = std::chrono::steady_clock::now() >= deadline
+                                           ? http::reply::service_unavailable
+                                           : http::reply::bad_request;
+                record_serialization = false;
             }
             else
             {
@@ -76,45 +240,68 @@ void RequestHandler::HandleRequest(const http::request &current_request, http::r
         }
         else
         {
-            const auto position = std::distance(request_string.begin(), api_iterator);
-            BOOST_ASSERT(position >= 0);
-            const auto context_begin =
-                request_string.begin() + ((position < 3) ? 0 : (position - 3UL));
-            BOOST_ASSERT(context_begin >= request_string.begin());
-            const auto context_end = request_string.begin() +
-                                     std::min<std::size_t>(position + 3UL, request_string.size());
-            BOOST_ASSERT(context_end <= request_string.end());
-            std::string context(context_begin, context_end);
-
             current_reply.status = http::reply::bad_request;
             result = util::json::Object();
             auto &json_result = result.get<util::json::Object>();
             json_result.values["code"] = "InvalidUrl";
-            json_result.values["message"] = "URL string malformed close to position " +
-                                            std::to_string(position) + ": \"" + context + "\"";
+            json_result.values["message"] = url_error;
         }
 
         current_reply.headers.emplace_back("Access-Control-Allow-Origin", "*");
-        current_reply.headers.emplace_back("Access-Control-Allow-Methods", "GET");
+        current_reply.headers.emplace_back("Access-Control-Allow-Methods", "GET, POST");
         current_reply.headers.emplace_back("Access-Control-Allow-Headers",
                                            "X-Requested-With, Content-Type");
-        if (result.is<util::json::Object>())
+        TIMER_START(serialization);
+        OSRM_PROBE(render__start);
         {
-            current_reply.headers.emplace_back("Content-Type", "application/json; charset=UTF-8");
-            current_reply.headers.emplace_back("Content-Disposition",
-                                               "inline; filename=\"response.json\"");
+            util::AllocationPhaseScope allocation_phase(util::AllocationPhase::JSON);
+            if (result.is<util::json::Object>())
+            {
+                current_reply.headers.emplace_back("Content-Type",
+                                                   "application/json; charset=UTF-8");
+                current_reply.headers.emplace_back("Content-Disposition",
+                                                   "inline; filename=\"response.json\"");
 
-            util::json::render(current_reply.content, result.get<util::json::Object>());
+                util::json::render(current_reply.content, result.get<util::json::Object>());
+            }
+            else if (result.is<util::json::Writer>())
+            {
+                current_reply.headers.emplace_back("Content-Type",
+                                                   "application/json; charset=UTF-8");
+                current_reply.headers.emplace_back("Content-Disposition",
+                                                   "inline; filename=\"response.json\"");
+
+                // the buffer of the previous reply of the connection goes to the next query
+                auto &buffer = result.get<util::json::Writer>().GetBuffer();
+                current_reply.content.swap(buffer);
+                service::recycleResultBuffer(std::move(buffer));
+            }
+            else if (result.is<service::OctetStream>())
+            {
+                auto &bytes = result.get<service::OctetStream>().bytes;
+                current_reply.content.assign(bytes.cbegin(), bytes.cend());
+                service::recycleResultBuffer(std::move(bytes));
+
+                current_reply.headers.emplace_back("Content-Type", "application/octet-stream");
+            }
+            else
+            {
+                BOOST_ASSERT(result.is<std::string>());
+                auto &bytes = result.get<std::string>();
+                current_reply.content.assign(bytes.cbegin(), bytes.cend());
+                service::recycleResultBuffer(std::move(bytes));
+
+                current_reply.headers.emplace_back("Content-Type", "application/x-protobuf");
+            }
         }
-        else
+        TIMER_STOP(serialization);
+        OSRM_PROBE1(render__done, current_reply.content.size());
+        profile.render = serialization_stop - serialization_start;
+        if (record_serialization)
         {
-            BOOST_ASSERT(result.is<std::string>());
-            current_reply.content.resize(result.get<std::string>().size());
-            std::copy(result.get<std::string>().cbegin(),
-                      result.get<std::string>().cend(),
-                      current_reply.content.begin());
-
-            current_reply.headers.emplace_back("Content-Type", "application/x-protobuf");
+            engine::QueryMetrics::GetInstance().Record(query_type,
+                                                       engine::QueryPhase::Serialization,
+                                                       serialization_stop - serialization_start);
         }
 
         // set headers
@@ -136,6 +323,7 @@ void RequestHandler::HandleRequest(const http::request &current_request, http::r
             time_t ltime;
             struct tm *time_stamp;
             TIMER_STOP(request_duration);
+            const auto major_page_faults = MAJOR_FAULTS_COUNT(request);
 
             ltime = time(nullptr);
             time_stamp = localtime(&ltime);
@@ -151,12 +339,21 @@ void RequestHandler::HandleRequest(const http::request &current_request, http::r
                 << current_request.referrer << (0 == current_request.referrer.length() ? "- " : " ")
                 << current_request.agent << (0 == current_request.agent.length() ? "- " : " ")
                 << current_reply.status << " " //
-                << request_string;
+                << current_request.uri;
+
+            // cold data shows up as page faults, e.g. lazily mapped r-tree leaves after startup
+            if (major_page_faults > 0)
+            {
+                util::SimpleLogger().Write() << major_page_faults
+                                             << " major page faults while handling the request";
+            }
         }
     }
     catch (const std::exception &e)
     {
+        const auto profile = current_reply.profile;
         current_reply = http::reply::stock_reply(http::reply::internal_server_error);
+        current_reply.profile = profile;
         util::SimpleLogger().Write(logWARNING) << "[server error] code: " << e.what()
                                                << ", uri: " << current_request.uri;
     }
@@ -6,6 +6,8 @@
 
 #include <boost/algorithm/string/predicate.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <string>
 
 namespace osrm
@@ -15,15 +17,53 @@ namespace server
 
 RequestParser::RequestParser()
     : state(internal_state::method_start), current_header({"", ""}),
-      selected_compression(http::no_compression)
+      selected_compression(http::no_compression), http_version_major(0), http_version_minor(0),
+      content_length(0), expect_continue(false), continue_pending(false)
 {
 }
 
+constexpr std::size_t RequestParser::MAX_CONTENT_LENGTH;
+constexpr std::size_t RequestParser::MAX_TIMEOUT_MILLISECONDS;
+
+void RequestParser::reset()
+{
+    state = internal_state::method_start;
+    current_header.clear();
+    selected_compression = http::no_compression;
+    http_version_major = 0;
+    http_version_minor = 0;
+    connection_header.clear();
+    content_length = 0;
+    expect_continue = false;
+    continue_pending = false;
+}
+
+bool RequestParser::await_continue()
+{
+    const bool pending = continue_pending;
+    continue_pending = false;
+    return pending;
+}
+
 std::tuple<RequestParser::RequestStatus, http::compression_type>
-RequestParser::parse(http::request &current_request, char *begin, char *end)
+RequestParser::parse(http::request &current_request, char *&begin, char *end)
 {
     while (begin != end)
     {
+        // the body is copied as a whole instead of char by char
+        if (state == internal_state::body)
+        {
+            const std::size_t missing = content_length - current_request.body.size();
+            const std::size_t available = std::min<std::size_t>(missing, end - begin);
+            current_request.body.append(begin, available);
+            begin += available;
+            if (current_request.body.size() == content_length)
+            {
+                return std::make_tuple(RequestStatus::valid, selected_compression);
+            }
+            continue;
+        }
+
         RequestStatus result = consume(current_request, *begin++);
         if (result != RequestStatus::indeterminate)
         {
@@ -116,6 +156,7 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
     case internal_state::http_version_major_start:
         if (is_digit(input))
         {
+            http_version_major = input - '0';
             state = internal_state::http_version_major;
             return RequestStatus::indeterminate;
         }
@@ -128,12 +169,14 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
         }
         if (is_digit(input))
         {
+            http_version_major = http_version_major * 10 + (input - '0');
             return RequestStatus::indeterminate;
         }
         return RequestStatus::invalid;
     case internal_state::http_version_minor_start:
         if (is_digit(input))
         {
+            http_version_minor = input - '0';
             state = internal_state::http_version_minor;
             return RequestStatus::indeterminate;
         }
@@ -146,6 +189,7 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
         }
         if (is_digit(input))
         {
+            http_version_minor = http_version_minor * 10 + (input - '0');
             return RequestStatus::indeterminate;
         }
         return RequestStatus::invalid;
@@ -180,6 +224,56 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
             current_request.agent = current_header.value;
         }
 
+        if (boost::iequals(current_header.name, "Connection"))
+        {
+            connection_header = current_header.value;
+        }
+
+        if (boost::iequals(current_header.name, "Content-Length"))
+        {
+            if (current_header.value.empty())
+            {
+                return RequestStatus::invalid;
+            }
+            content_length = 0;
+            for (const char digit : current_header.value)
+            {
+                if (!is_digit(digit) || content_length > MAX_CONTENT_LENGTH)
+                {
+                    return RequestStatus::invalid;
+                }
+                content_length = content_length * 10 + (digit - '0');
+            }
+            if (content_length > MAX_CONTENT_LENGTH)
+            {
+                return RequestStatus::invalid;
+            }
+        }
+
+        // milliseconds the client is willing to wait for the reply
+        if (boost::iequals(current_header.name, "X-OSRM-Timeout"))
+        {
+            if (current_header.value.empty())
+            {
+                return RequestStatus::invalid;
+            }
+            std::size_t timeout = 0;
+            for (const char digit : current_header.value)
+            {
+                if (!is_digit(digit))
+                {
+                    return RequestStatus::invalid;
+                }
+                timeout = std::min(timeout * 10 + (digit - '0'), MAX_TIMEOUT_MILLISECONDS);
+            }
+            current_request.timeout = std::chrono::milliseconds(timeout);
+        }
+
+        if (boost::iequals(current_header.name, "Expect"))
+        {
+            expect_continue = boost::icontains(current_header.value, "100-continue");
+        }
+
         if (input == '\r')
         {
             state = internal_state::expecting_newline_3;
@@ -248,7 +342,27 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
         }
         return RequestStatus::invalid;
     default: // expecting_newline_3
-        return input == '\n' ? RequestStatus::valid : RequestStatus::invalid;
+        if (input != '\n')
+        {
+            return RequestStatus::invalid;
+        }
+        // HTTP/1.1 connections are persistent unless closed, HTTP/1.0 ones only on request
+        if (http_version_major > 1 || (http_version_major == 1 && http_version_minor >= 1))
+        {
+            current_request.keep_alive = !boost::icontains(connection_header, "close");
+        }
+        else
+        {
+            current_request.keep_alive = boost::icontains(connection_header, "keep-alive");
+        }
+        if (content_length > 0)
+        {
+            current_request.body.reserve(content_length);
+            continue_pending = expect_continue;
+            state = internal_state::body;
+            return RequestStatus::indeterminate;
+        }
+        return RequestStatus::valid;
     }
 }
 
@@ -41,8 +41,10 @@ std::string getWrongOptionHelp(const engine::api::MatchParameters &parameters)
 }
 } // anon. ns
 
-engine::Status
-MatchService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &result)
+engine::Status MatchService::RunQuery(std::size_t prefix_length,
+                                      const std::string &profile,
+                                      std::string &query,
+                                      ResultT &result)
 {
     result = util::json::Object();
     auto &json_result = result.get<util::json::Object>();
@@ -67,6 +69,7 @@ MatchService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &r
         return engine::Status::Error;
     }
     BOOST_ASSERT(parameters->IsValid());
+    parameters->profile = profile;
 
     return BaseService::routing_machine.Match(*parameters, json_result);
 }
@@ -40,8 +40,10 @@ std::string getWrongOptionHelp(const engine::api::NearestParameters &parameters)
 }
 } // anon. ns
 
-engine::Status
-NearestService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &result)
+engine::Status NearestService::RunQuery(std::size_t prefix_length,
+                                        const std::string &profile,
+                                        std::string &query,
+                                        ResultT &result)
 {
     result = util::json::Object();
     auto &json_result = result.get<util::json::Object>();
@@ -66,6 +68,7 @@ NearestService::RunQuery(std::size_t prefix_length, std::string &query, ResultT
         return engine::Status::Error;
     }
     BOOST_ASSERT(parameters->IsValid());
+    parameters->profile = profile;
 
     return BaseService::routing_machine.Nearest(*parameters, json_result);
 }
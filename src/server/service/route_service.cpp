@@ -37,8 +37,10 @@ std::string getWrongOptionHelp(const engine::api::RouteParameters &parameters)
 }
 } // anon. ns
 
-engine::Status
-RouteService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &result)
+engine::Status RouteService::RunQuery(std::size_t prefix_length,
+                                      const std::string &profile,
+                                      std::string &query,
+                                      ResultT &result)
 {
     result = util::json::Object();
     auto &json_result = result.get<util::json::Object>();
@@ -63,6 +65,20 @@ RouteService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &r
         return engine::Status::Error;
     }
     BOOST_ASSERT(parameters->IsValid());
+    parameters->profile = profile;
+
+    if (parameters->output_format == engine::api::OutputFormatType::PBF)
+    {
+        if (parameters->steps || parameters->annotations)
+        {
+            json_result.values["code"] = "InvalidOptions";
+            json_result.values["message"] =
+                "Steps and annotations are only supported by the json format.";
+            return engine::Status::Error;
+        }
+
+        return BaseService::routing_machine.Route(*parameters, MakeBytesResult(result));
+    }
 
     return BaseService::routing_machine.Route(*parameters, json_result);
 }
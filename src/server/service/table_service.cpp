@@ -1,9 +1,11 @@
 #include "server/service/table_service.hpp"
 
 #include "server/api/parameters_parser.hpp"
+#include "engine/api/pbf_factory.hpp"
 #include "engine/api/table_parameters.hpp"
 
 #include "util/json_container.hpp"
+#include "util/json_writer.hpp"
 
 #include <boost/format.hpp>
 
@@ -58,8 +60,10 @@ std::string getWrongOptionHelp(const engine::api::TableParameters &parameters)
 }
 } // anon. ns
 
-engine::Status
-TableService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &result)
+engine::Status TableService::RunQuery(std::size_t prefix_length,
+                                      const std::string &profile,
+                                      std::string &query,
+                                      ResultT &result)
 {
     result = util::json::Object();
     auto &json_result = result.get<util::json::Object>();
@@ -84,8 +88,37 @@ TableService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &r
         return engine::Status::Error;
     }
     BOOST_ASSERT(parameters->IsValid());
+    parameters->profile = profile;
 
-    return BaseService::routing_machine.Table(*parameters, json_result);
+    if (parameters->output_format == engine::api::OutputFormatType::Binary)
+    {
+        auto buffer = TakeBytesBuffer();
+        const auto status = BaseService::routing_machine.Table(*parameters, buffer);
+        if (status == engine::Status::Ok)
+        {
+            result = OctetStream{std::move(buffer)};
+            return status;
+        }
+
+        // the engine reports errors of binary tables as protobuf, they are sent as JSON
+        std::string code, message;
+        if (!engine::api::pbf::readError(buffer, code, message))
+        {
+            code = "InternalError";
+            message = "Internal Server Error";
+        }
+        json_result.values["code"] = std::move(code);
+        json_result.values["message"] = std::move(message);
+        return status;
+    }
+
+    if (parameters->output_format == engine::api::OutputFormatType::PBF)
+    {
+        return BaseService::routing_machine.Table(*parameters, MakeBytesResult(result));
+    }
+
+    // tables can get large, stream them directly instead of building a json::Object first
+    return BaseService::routing_machine.Table(*parameters, MakeWriterResult(result));
 }
 }
 }
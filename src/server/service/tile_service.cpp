@@ -15,7 +15,10 @@ namespace server
 namespace service
 {
 
-engine::Status TileService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &result)
+engine::Status TileService::RunQuery(std::size_t prefix_length,
+                                     const std::string &profile,
+                                     std::string &query,
+                                     ResultT &result)
 {
     auto query_iterator = query.begin();
     auto parameters =
@@ -41,10 +44,9 @@ engine::Status TileService::RunQuery(std::size_t prefix_length, std::string &que
         return engine::Status::Error;
     }
     BOOST_ASSERT(parameters->IsValid());
+    parameters->profile = profile;
 
-    result = std::string();
-    auto &string_result = result.get<std::string>();
-    return BaseService::routing_machine.Tile(*parameters, string_result);
+    return BaseService::routing_machine.Tile(*parameters, MakeBytesResult(result));
 }
 }
 }
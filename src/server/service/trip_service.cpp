@@ -39,7 +39,10 @@ std::string getWrongOptionHelp(const engine::api::TripParameters &parameters)
 }
 } // anon. ns
 
-engine::Status TripService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &result)
+engine::Status TripService::RunQuery(std::size_t prefix_length,
+                                     const std::string &profile,
+                                     std::string &query,
+                                     ResultT &result)
 {
     result = util::json::Object();
     auto &json_result = result.get<util::json::Object>();
@@ -66,6 +69,7 @@ engine::Status TripService::RunQuery(std::size_t prefix_length, std::string &que
         return engine::Status::Error;
     }
     BOOST_ASSERT(parameters->IsValid());
+    parameters->profile = profile;
 
     return BaseService::routing_machine.Trip(*parameters, json_result);
 }
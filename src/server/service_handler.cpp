@@ -1,5 +1,6 @@
 #include "server/service_handler.hpp"
 
+#include "server/service/isochrone_service.hpp"
 #include "server/service/match_service.hpp"
 #include "server/service/nearest_service.hpp"
 #include "server/service/route_service.hpp"
@@ -7,15 +8,26 @@
 #include "server/service/tile_service.hpp"
 #include "server/service/trip_service.hpp"
 
+#include "engine/query_metrics.hpp"
 #include "server/api/parsed_url.hpp"
 #include "util/json_util.hpp"
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <utility>
 
 namespace osrm
 {
 namespace server
 {
+namespace
+{
+const std::pair<const char *, double> QUANTILES[] = {
+    {"0.5", 0.5}, {"0.9", 0.9}, {"0.99", 0.99}, {"0.999", 0.999}};
+}
+
 ServiceHandler::ServiceHandler(osrm::EngineConfig &config) : routing_machine(config)
 {
     service_map["route"] = std::make_unique<service::RouteService>(routing_machine);
@@ -24,6 +36,7 @@ ServiceHandler::ServiceHandler(osrm::EngineConfig &config) : routing_machine(con
     service_map["trip"] = std::make_unique<service::TripService>(routing_machine);
     service_map["match"] = std::make_unique<service::MatchService>(routing_machine);
     service_map["tile"] = std::make_unique<service::TileService>(routing_machine);
+    service_map["isochrone"] = std::make_unique<service::IsochroneService>(routing_machine);
 }
 
 engine::Status ServiceHandler::RunQuery(api::ParsedURL parsed_url,
@@ -49,7 +62,95 @@ engine::Status ServiceHandler::RunQuery(api::ParsedURL parsed_url,
         return engine::Status::Error;
     }
 
-    return service->RunQuery(parsed_url.prefix_length, parsed_url.query, result);
+    return service->RunQuery(
+        parsed_url.prefix_length, parsed_url.profile, parsed_url.query, result);
+}
+
+bool ServiceHandler::Schedule(const std::string &service, std::function<void()> task)
+{
+    const auto pool_iter = worker_pools.find(service);
+    if (pool_iter == worker_pools.end())
+    {
+        task();
+        return true;
+    }
+
+    return pool_iter->second->TryPost(std::move(task));
+}
+
+void ServiceHandler::WriteMetrics(std::string &output)
+{
+    const auto &metrics = engine::QueryMetrics::GetInstance();
+    const auto to_seconds = [](const std::uint64_t microseconds) {
+        // microseconds are exact with six decimals
+        return std::to_string(static_cast<double>(microseconds) / 1000000.);
+    };
+
+    output += "# HELP osrm_query_duration_seconds Duration of the query phases since startup.\n";
+    output += "# TYPE osrm_query_duration_seconds summary\n";
+    for (std::size_t type_index = 0; type_index < engine::QueryMetrics::NUM_QUERY_TYPES;
+         ++type_index)
+    {
+        for (std::size_t phase_index = 0; phase_index < engine::QueryMetrics::NUM_QUERY_PHASES;
+             ++phase_index)
+        {
+            const auto type = static_cast<engine::QueryType>(type_index);
+            const auto phase = static_cast<engine::QueryPhase>(phase_index);
+            const auto summary = metrics.Collect(type, phase);
+            if (summary.count == 0)
+            {
+                continue;
+            }
+
+            const auto labels = std::string("service=\"") + engine::QueryMetrics::ToString(type) +
+                                "\",phase=\"" + engine::QueryMetrics::ToString(phase) + "\"";
+            for (const auto &quantile : QUANTILES)
+            {
+                output += "osrm_query_duration_seconds{" + labels + ",quantile=\"" +
+                          quantile.first + "\"} " + to_seconds(summary.Quantile(quantile.second)) +
+                          "\n";
+            }
+            output += "osrm_query_duration_seconds_sum{" + labels + "} " +
+                      to_seconds(summary.sum) + "\n";
+            output += "osrm_query_duration_seconds_count{" + labels + "} " +
+                      std::to_string(summary.count) + "\n";
+        }
+    }
+
+    const auto route_cache_hits = metrics.GetRouteCacheHits();
+    const auto route_cache_misses = metrics.GetRouteCacheMisses();
+    if (route_cache_hits + route_cache_misses > 0)
+    {
+        output += "# HELP osrm_route_cache_lookups_total Lookups of the route response cache since "
+                  "startup.\n";
+        output += "# TYPE osrm_route_cache_lookups_total counter\n";
+        output += "osrm_route_cache_lookups_total{result=\"hit\"} " +
+                  std::to_string(route_cache_hits) + "\n";
+        output += "osrm_route_cache_lookups_total{result=\"miss\"} " +
+                  std::to_string(route_cache_misses) + "\n";
+    }
+}
+
+void ServiceHandler::WarmUpThread() { routing_machine.WarmUpThread(); }
+
+bool ServiceHandler::AddWorkerPool(const std::string &service,
+                                   const std::size_t num_threads,
+                                   const std::size_t max_queued_requests,
+                                   const bool warm_up)
+{
+    if (service_map.find(service) == service_map.end() || num_threads == 0)
+    {
+        return false;
+    }
+
+    std::function<void()> thread_initializer;
+    if (warm_up)
+    {
+        thread_initializer = [this] { routing_machine.WarmUpThread(); };
+    }
+    worker_pools[service] = std::make_unique<WorkerPool>(
+        num_threads, max_queued_requests, std::move(thread_initializer));
+    return true;
 }
 }
 }
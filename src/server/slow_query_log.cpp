@@ -0,0 +1,112 @@
+#include "server/slow_query_log.hpp"
+#include "server/http/reply.hpp"
+#include "server/http/request.hpp"
+
+#include "engine/search_statistics.hpp"
+#include "util/exception.hpp"
+#include "util/json_writer.hpp"
+
+namespace osrm
+{
+namespace server
+{
+
+namespace
+{
+double toMilliseconds(const std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+}
+
+SlowQueryLog::SlowQueryLog(const std::string &path,
+                           const std::chrono::steady_clock::duration threshold)
+    : threshold(threshold), stream(path, std::ios::app)
+{
+    if (!stream)
+    {
+        throw util::exception("Could not open slow query log " + path);
+    }
+}
+
+void SlowQueryLog::Log(const http::request &request, const http::reply &reply)
+{
+    const auto &profile = reply.profile;
+    // replies that were not handled by the request handler, e.g. to malformed requests
+    if (profile.start == std::chrono::steady_clock::time_point())
+    {
+        return;
+    }
+    const auto total = std::chrono::steady_clock::now() - profile.start;
+    if (total < threshold)
+    {
+        return;
+    }
+
+    util::json::Writer writer;
+    writer.BeginObject();
+    writer.Key("time");
+    writer.Number(std::chrono::duration<double>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count());
+    writer.Key("uri");
+    writer.String(request.uri);
+    if (!request.body.empty())
+    {
+        writer.Key("body");
+        writer.String(request.body);
+    }
+    writer.Key("status");
+    writer.Number(reply.status);
+    writer.Key("total_ms");
+    writer.Number(toMilliseconds(total));
+    writer.Key("phases_ms");
+    writer.BeginObject();
+    writer.Key("parse");
+    writer.Number(toMilliseconds(profile.parse));
+    writer.Key("queue");
+    writer.Number(toMilliseconds(profile.queue));
+    writer.Key("snap");
+    writer.Number(toMilliseconds(profile.snap));
+    writer.Key("search");
+    writer.Number(toMilliseconds(profile.search));
+    writer.Key("unpack");
+    writer.Number(toMilliseconds(profile.unpack));
+    writer.Key("guidance");
+    writer.Number(toMilliseconds(profile.guidance));
+    writer.Key("render");
+    writer.Number(toMilliseconds(profile.render));
+    writer.Key("compress");
+    writer.Number(toMilliseconds(profile.compress));
+    writer.EndObject();
+    if (engine::SEARCH_STATISTICS_ENABLED)
+    {
+        const auto &statistics = profile.search_statistics;
+        writer.Key("search");
+        writer.BeginObject();
+        writer.Key("settled_nodes");
+        writer.Number(statistics.settled_nodes);
+        writer.Key("relaxed_edges");
+        writer.Number(statistics.relaxed_edges);
+        writer.Key("stalled_nodes");
+        writer.Number(statistics.stalled_nodes);
+        writer.Key("heap_inserts");
+        writer.Number(statistics.heap_inserts);
+        writer.Key("heap_decrease_keys");
+        writer.Number(statistics.heap_decrease_keys);
+        writer.Key("unpacked_edges");
+        writer.Number(statistics.unpacked_edges);
+        writer.EndObject();
+    }
+    writer.EndObject();
+
+    auto &buffer = writer.GetBuffer();
+    buffer.push_back('\n');
+
+    // slow requests are rare, every line is flushed so that none is lost if the server dies
+    std::lock_guard<std::mutex> lock(mutex);
+    stream.write(buffer.data(), buffer.size());
+    stream.flush();
+}
+}
+}
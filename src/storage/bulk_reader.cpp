@@ -0,0 +1,502 @@
+#include "storage/bulk_reader.hpp"
+
+#include "util/exception.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#include <malloc.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#if defined(OSRM_HAVE_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+// the headers of old C libraries lack the numbers of the io_uring system calls
+#if defined(OSRM_HAVE_IO_URING) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define OSRM_USE_IO_URING
+#endif
+
+namespace osrm
+{
+namespace storage
+{
+namespace io
+{
+
+namespace
+{
+// Reads up to `size` bytes at `offset`, returns the number of bytes read or the negative errno
+std::int64_t
+readAt(const int fd, const std::uint64_t offset, char *buffer, const std::uint64_t size)
+{
+#ifdef _WIN32
+    if (_lseeki64(fd, offset, SEEK_SET) < 0)
+    {
+        return -errno;
+    }
+    const auto result =
+        _read(fd, buffer, static_cast<unsigned>(std::min<std::uint64_t>(size, 1 << 30)));
+#else
+    ssize_t result;
+    do
+    {
+        result = ::pread(fd, buffer, size, offset);
+    } while (result < 0 && errno == EINTR);
+#endif
+    return result < 0 ? -errno : result;
+}
+
+void closeFile(const int fd)
+{
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+char *allocateAligned(const std::size_t size, const std::size_t alignment)
+{
+#ifdef _WIN32
+    return static_cast<char *>(_aligned_malloc(size, alignment));
+#else
+    void *pointer = nullptr;
+    return 0 == ::posix_memalign(&pointer, alignment, size) ? static_cast<char *>(pointer)
+                                                           : nullptr;
+#endif
+}
+
+struct AlignedDeleter
+{
+    void operator()(char *pointer) const
+    {
+#ifdef _WIN32
+        _aligned_free(pointer);
+#else
+        std::free(pointer);
+#endif
+    }
+};
+}
+
+// A chunk in flight. Unaligned chunks are read into the bounce buffer and copied out once they
+// are complete. At the end of the file `remaining` asks for more than is `needed`.
+struct BulkReader::Slot
+{
+    Chunk chunk;
+    int fd;
+    std::uint64_t offset;
+    char *target;
+    std::uint64_t remaining;
+    std::uint64_t needed;
+    bool bounced;
+    std::unique_ptr<char, AlignedDeleter> bounce;
+#ifndef _WIN32
+    struct iovec iov;
+#endif
+};
+
+#ifdef OSRM_USE_IO_URING
+// The submission and completion queues of an io_uring, set up without liburing. The slots are
+// passed as the user data of their reads.
+struct BulkReader::Ring
+{
+    int fd = -1;
+    void *sq_ring = MAP_FAILED;
+    std::size_t sq_ring_size = 0;
+    void *cq_ring = MAP_FAILED;
+    std::size_t cq_ring_size = 0;
+    io_uring_sqe *sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    std::size_t sqes_size = 0;
+
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    io_uring_cqe *cqes;
+
+    // Returns nullptr if the kernel does not support io_uring or a sandbox forbids it
+    static std::unique_ptr<Ring> Create(const unsigned entries)
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        std::unique_ptr<Ring> ring(new Ring);
+        ring->fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (ring->fd < 0)
+        {
+            return nullptr;
+        }
+
+        ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring->sq_ring = ::mmap(nullptr,
+                               ring->sq_ring_size,
+                               PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE,
+                               ring->fd,
+                               IORING_OFF_SQ_RING);
+        ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        ring->cq_ring = ::mmap(nullptr,
+                               ring->cq_ring_size,
+                               PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE,
+                               ring->fd,
+                               IORING_OFF_CQ_RING);
+        ring->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        ring->sqes = static_cast<io_uring_sqe *>(::mmap(nullptr,
+                                                        ring->sqes_size,
+                                                        PROT_READ | PROT_WRITE,
+                                                        MAP_SHARED | MAP_POPULATE,
+                                                        ring->fd,
+                                                        IORING_OFF_SQES));
+        if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED ||
+            ring->sqes == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+        const auto sq = static_cast<char *>(ring->sq_ring);
+        ring->sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        ring->sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        ring->sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        const auto cq = static_cast<char *>(ring->cq_ring);
+        ring->cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        ring->cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        ring->cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        ring->cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        return ring;
+    }
+
+    ~Ring()
+    {
+        if (sqes != MAP_FAILED)
+            ::munmap(sqes, sqes_size);
+        if (cq_ring != MAP_FAILED)
+            ::munmap(cq_ring, cq_ring_size);
+        if (sq_ring != MAP_FAILED)
+            ::munmap(sq_ring, sq_ring_size);
+        if (fd >= 0)
+            ::close(fd);
+    }
+
+    // The queue has an entry for every slot, so it never overflows
+    void Prepare(const Slot &slot, const std::size_t index)
+    {
+        const auto tail = *sq_tail;
+        const auto entry = tail & *sq_mask;
+        auto &sqe = sqes[entry];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = slot.fd;
+        sqe.off = slot.offset;
+        sqe.addr = reinterpret_cast<std::uint64_t>(&slot.iov);
+        sqe.len = 1;
+        sqe.user_data = index;
+        sq_array[entry] = entry;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    // Submits the prepared reads and waits for at least one completion
+    void Enter(const unsigned to_submit)
+    {
+        while (
+            ::syscall(__NR_io_uring_enter, fd, to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0) <
+            0)
+        {
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                throw util::exception(std::string("io_uring_enter failed: ") +
+                                      std::strerror(errno));
+            }
+        }
+    }
+
+    template <typename CallbackT> void ForEachCompletion(CallbackT &&callback)
+    {
+        auto head = *cq_head;
+        const auto tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head)
+        {
+            const auto &cqe = cqes[head & *cq_mask];
+            callback(static_cast<std::size_t>(cqe.user_data), cqe.res);
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+};
+#else
+struct BulkReader::Ring
+{
+};
+#endif
+
+BulkReader::BulkReader(const boost::filesystem::path &path_) : path(path_.string())
+{
+#ifdef _WIN32
+    buffered_fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    buffered_fd = ::open(path.c_str(), O_RDONLY);
+#endif
+    if (buffered_fd < 0)
+    {
+        throw util::exception("Could not open " + path + " for reading.");
+    }
+    file_size = boost::filesystem::file_size(path_);
+
+#ifdef O_DIRECT
+    // file systems like tmpfs do not support direct reads, those files are read like headers
+    direct_fd = ::open(path.c_str(), O_RDONLY | O_DIRECT);
+    direct_reads = direct_fd >= 0;
+#endif
+
+    slots.resize(QUEUE_DEPTH);
+    for (auto &slot : slots)
+    {
+        slot.reset(new Slot);
+    }
+#ifdef OSRM_USE_IO_URING
+    ring = Ring::Create(QUEUE_DEPTH);
+#endif
+}
+
+BulkReader::~BulkReader()
+{
+    ring.reset();
+    if (direct_fd >= 0)
+    {
+        closeFile(direct_fd);
+    }
+    closeFile(buffered_fd);
+}
+
+bool BulkReader::UsesIOUring() const { return static_cast<bool>(ring); }
+
+void BulkReader::Read(const std::uint64_t offset, void *buffer, const std::size_t size)
+{
+    auto target = static_cast<char *>(buffer);
+    std::uint64_t done = 0;
+    while (done < size)
+    {
+        const auto result = readAt(buffered_fd, offset + done, target + done, size - done);
+        if (result <= 0)
+        {
+            throw util::exception("Could not read " + std::to_string(size) + " bytes at " +
+                                  std::to_string(offset) + " of " + path);
+        }
+        done += result;
+    }
+}
+
+void BulkReader::Queue(const std::uint64_t offset, void *buffer, const std::uint64_t size)
+{
+    if (offset + size > file_size)
+    {
+        throw util::exception(path + " ends before the " + std::to_string(size) +
+                              " bytes at " + std::to_string(offset));
+    }
+    // the chunks end at multiples of the chunk size, so they fit into the bounce buffers even
+    // with the alignment added to both ends
+    auto target = static_cast<char *>(buffer);
+    for (std::uint64_t begin = offset; begin < offset + size;)
+    {
+        const auto end = std::min(offset + size, (begin / CHUNK_SIZE + 1) * CHUNK_SIZE);
+        chunks.push_back({begin, target + (begin - offset), end - begin});
+        begin = end;
+    }
+}
+
+void BulkReader::Start(Slot &slot, const Chunk &chunk)
+{
+    slot.chunk = chunk;
+    slot.bounced = false;
+    const bool aligned = chunk.offset % ALIGNMENT == 0 && chunk.size % ALIGNMENT == 0 &&
+                         reinterpret_cast<std::uintptr_t>(chunk.buffer) % ALIGNMENT == 0;
+    if (!direct_reads)
+    {
+        slot.fd = buffered_fd;
+        slot.offset = chunk.offset;
+        slot.target = chunk.buffer;
+        slot.remaining = slot.needed = chunk.size;
+    }
+    else if (aligned)
+    {
+        slot.fd = direct_fd;
+        slot.offset = chunk.offset;
+        slot.target = chunk.buffer;
+        slot.remaining = slot.needed = chunk.size;
+    }
+    else
+    {
+        if (!slot.bounce)
+        {
+            slot.bounce.reset(allocateAligned(CHUNK_SIZE, ALIGNMENT));
+            if (!slot.bounce)
+            {
+                throw util::exception("Could not allocate the buffers to read " + path);
+            }
+        }
+        const auto begin = chunk.offset / ALIGNMENT * ALIGNMENT;
+        const auto end = (chunk.offset + chunk.size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        BOOST_ASSERT(end - begin <= CHUNK_SIZE);
+        slot.fd = direct_fd;
+        slot.offset = begin;
+        slot.target = slot.bounce.get();
+        slot.remaining = end - begin;
+        slot.needed = chunk.offset + chunk.size - begin;
+        slot.bounced = true;
+    }
+#ifndef _WIN32
+    slot.iov.iov_base = slot.target;
+    slot.iov.iov_len = slot.remaining;
+#endif
+}
+
+bool BulkReader::Complete(Slot &slot, const std::int64_t result)
+{
+    if (result == -EINVAL && slot.fd == direct_fd)
+    {
+        // the file system rejected the direct read, the chunk is read again through the cache
+        direct_reads = false;
+        Start(slot, slot.chunk);
+        return true;
+    }
+    if (result < 0)
+    {
+        throw util::exception("Could not read " + path + ": " +
+                              std::strerror(static_cast<int>(-result)));
+    }
+    if (result == 0)
+    {
+        throw util::exception(path + " ended while it was read");
+    }
+
+    const auto count = static_cast<std::uint64_t>(result);
+    slot.offset += count;
+    slot.target += count;
+    slot.remaining -= count;
+    slot.needed = slot.needed > count ? slot.needed - count : 0;
+#ifndef _WIN32
+    slot.iov.iov_base = slot.target;
+    slot.iov.iov_len = slot.remaining;
+#endif
+    if (slot.needed > 0)
+    {
+        return true;
+    }
+    if (slot.bounced)
+    {
+        std::memcpy(slot.chunk.buffer,
+                    slot.bounce.get() + slot.chunk.offset % ALIGNMENT,
+                    slot.chunk.size);
+    }
+    return false;
+}
+
+void BulkReader::WaitWithPread(const std::vector<Chunk> &pending)
+{
+    auto &slot = *slots.front();
+    for (const auto &chunk : pending)
+    {
+        Start(slot, chunk);
+        while (Complete(slot, readAt(slot.fd, slot.offset, slot.target, slot.remaining)))
+        {
+        }
+    }
+}
+
+#ifdef OSRM_USE_IO_URING
+void BulkReader::WaitWithRing(const std::vector<Chunk> &pending)
+{
+    std::vector<std::size_t> free_slots(slots.size());
+    for (std::size_t index = 0; index < slots.size(); ++index)
+    {
+        free_slots[index] = index;
+    }
+
+    // the buffers belong to the caller, so all reads in flight are reaped before an error is
+    // thrown
+    std::exception_ptr error;
+    std::size_t next = 0;
+    std::size_t in_flight = 0;
+    unsigned to_submit = 0;
+    const auto submit = [&](const std::size_t index) {
+        ring->Prepare(*slots[index], index);
+        ++to_submit;
+        ++in_flight;
+    };
+    while (in_flight > 0 || (!error && next < pending.size()))
+    {
+        while (!error && next < pending.size() && !free_slots.empty())
+        {
+            const auto index = free_slots.back();
+            free_slots.pop_back();
+            Start(*slots[index], pending[next++]);
+            submit(index);
+        }
+
+        ring->Enter(to_submit);
+        to_submit = 0;
+        ring->ForEachCompletion([&](const std::size_t index, const std::int32_t result) {
+            --in_flight;
+            bool again = false;
+            if (!error)
+            {
+                try
+                {
+                    again = Complete(*slots[index], result);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+            }
+            if (again)
+            {
+                submit(index);
+            }
+            else
+            {
+                free_slots.push_back(index);
+            }
+        });
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+#else
+void BulkReader::WaitWithRing(const std::vector<Chunk> &pending) { WaitWithPread(pending); }
+#endif
+
+void BulkReader::Wait()
+{
+    std::vector<Chunk> pending;
+    pending.swap(chunks);
+    if (ring)
+    {
+        WaitWithRing(pending);
+    }
+    else
+    {
+        WaitWithPread(pending);
+    }
+}
+}
+}
+}
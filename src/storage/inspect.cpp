@@ -0,0 +1,157 @@
+#include "storage/inspect.hpp"
+
+#include "storage/container.hpp"
+#include "storage/shared_barriers.hpp"
+#include "storage/shared_datatype.hpp"
+#include "storage/shared_memory.hpp"
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+#include "util/simple_logger.hpp"
+#include "util/system_memory.hpp"
+
+#include <boost/interprocess/sync/named_upgradable_mutex.hpp>
+#include <boost/interprocess/sync/sharable_lock.hpp>
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace osrm
+{
+namespace storage
+{
+
+namespace
+{
+struct Totals
+{
+    std::uint64_t bytes = 0;
+    std::uint64_t resident = 0;
+    bool known = true;
+};
+
+std::string formatResidency(const boost::optional<std::uint64_t> &resident,
+                            const std::uint64_t bytes)
+{
+    if (!resident)
+    {
+        return "unknown";
+    }
+    std::ostringstream out;
+    out << *resident << " (" << std::fixed << std::setprecision(1)
+        << (bytes == 0 ? 100. : 100. * *resident / bytes) << "%)";
+    return out.str();
+}
+
+void writeRow(const std::string &name,
+              const std::string &region,
+              const std::string &entries,
+              const std::string &entry_size,
+              const std::string &bytes,
+              const std::string &resident)
+{
+    std::ostringstream row;
+    row << std::left << std::setw(40) << name << std::setw(8) << region << std::right
+        << std::setw(14) << entries << std::setw(8) << entry_size << std::setw(16) << bytes
+        << "  " << resident;
+    util::SimpleLogger().Write() << row.str();
+}
+
+// Lists the blocks of a layout, the ones of the data region only unless it is given
+void listBlocks(const SharedDataLayout &layout,
+                const char *data_memory,
+                const char *metric_memory,
+                Totals &totals)
+{
+    writeRow("block", "region", "entries", "size", "bytes", "resident bytes");
+    for (const auto index : util::irange<int>(0, SharedDataLayout::NUM_BLOCKS))
+    {
+        const auto block = static_cast<SharedDataLayout::BlockID>(index);
+        const bool is_metric = SharedDataLayout::IsMetricBlock(block);
+        const char *memory = is_metric ? metric_memory : data_memory;
+        if (!memory)
+        {
+            continue;
+        }
+
+        const auto bytes = layout.GetBlockSize(block);
+        const auto resident =
+            util::getResidentMemory(memory + layout.GetBlockOffset(block), bytes);
+        totals.bytes += bytes;
+        totals.known = totals.known && resident;
+        totals.resident += resident.get_value_or(0);
+
+        writeRow(block_id_to_name[index],
+                 is_metric ? "metric" : "data",
+                 std::to_string(layout.num_entries[index]),
+                 std::to_string(layout.entry_size[index]),
+                 std::to_string(bytes),
+                 formatResidency(resident, bytes));
+    }
+}
+
+void writeTotals(const Totals &totals)
+{
+    writeRow("total",
+             "",
+             "",
+             "",
+             std::to_string(totals.bytes),
+             formatResidency(totals.known ? boost::make_optional(totals.resident) : boost::none,
+                             totals.bytes));
+}
+}
+
+void listSharedMemory()
+{
+    if (!SharedMemory::RegionExists(CURRENT_REGIONS))
+    {
+        throw util::exception("No dataset in shared memory, load one with osrm-datastore");
+    }
+
+    SharedBarriers barriers;
+    // osrm-datastore does not remove the regions of the current dataset while we hold this
+    const boost::interprocess::sharable_lock<boost::interprocess::named_upgradable_mutex> lock(
+        barriers.current_regions_mutex);
+
+    const auto current_regions = makeSharedMemory(CURRENT_REGIONS);
+    const auto timestamp = static_cast<const SharedDataTimestamp *>(current_regions->Ptr());
+    if (timestamp->layout == LAYOUT_NONE)
+    {
+        throw util::exception("No dataset in shared memory, load one with osrm-datastore");
+    }
+
+    const auto layout_memory = makeSharedMemory(timestamp->layout);
+    const auto data_memory = makeSharedMemory(timestamp->data);
+    const auto metric_memory = makeSharedMemory(timestamp->metric);
+    const auto layout = static_cast<const SharedDataLayout *>(layout_memory->Ptr());
+    const auto metric_region = static_cast<const char *>(metric_memory->Ptr());
+
+    util::SimpleLogger().Write() << "Dataset " << timestamp->timestamp.load() << " in "
+                                 << regionToString(timestamp->data) << " and "
+                                 << regionToString(timestamp->metric);
+    Totals totals;
+    listBlocks(*layout, static_cast<const char *>(data_memory->Ptr()), metric_region, totals);
+
+    const auto metrics = GetSharedMetrics(layout_memory->Ptr());
+    for (const auto index : util::irange<std::uint32_t>(0, metrics->number_of_metrics))
+    {
+        const auto &metric = metrics->metrics[index];
+        util::SimpleLogger().Write() << "Metric " << metric.name;
+        listBlocks(metric.layout, nullptr, metric_region + metric.offset, totals);
+    }
+    writeTotals(totals);
+}
+
+void listContainer(const boost::filesystem::path &path)
+{
+    const MappedContainer container(path);
+
+    util::SimpleLogger().Write() << "Container " << path.string();
+    Totals totals;
+    listBlocks(*container.Layout(), container.Data(), container.Metric(), totals);
+    writeTotals(totals);
+}
+}
+}
@@ -0,0 +1,436 @@
+#include "storage/package.hpp"
+
+#include "util/crc32c.hpp"
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+#include "util/io.hpp"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_invoke.h>
+
+#ifdef OSRM_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace osrm
+{
+namespace storage
+{
+
+namespace
+{
+// frames are compressed and decompressed in batches, while the previous batch is written or the
+// next one is read
+const constexpr std::size_t FRAMES_PER_BATCH = 256;
+
+char *regionOf(const SharedDataLayout::BlockID block, char *data_memory, char *metric_memory)
+{
+    return SharedDataLayout::IsMetricBlock(block) ? metric_memory : data_memory;
+}
+
+// The chunk at the same place of the block in the base, nullptr if the block of the base has
+// another size or the base does not hold its region
+const char *baseChunk(const PackageBase &base,
+                      const SharedDataLayout &layout,
+                      const PackageChunk &chunk)
+{
+    if (!base.layout || base.layout->GetBlockSize(chunk.block) != layout.GetBlockSize(chunk.block))
+    {
+        return nullptr;
+    }
+    const char *memory =
+        SharedDataLayout::IsMetricBlock(chunk.block) ? base.metric_memory : base.data_memory;
+    if (!memory)
+    {
+        return nullptr;
+    }
+    return memory + base.layout->GetBlockOffset(chunk.block) + chunk.offset -
+           layout.GetBlockOffset(chunk.block);
+}
+
+// Fills the buffer with the frame of the chunk and returns its codec. A chunk that equals the
+// chunk of the base is not stored and a changed one is compressed as a patch, a chunk that does
+// not get smaller is stored as it is.
+PackageCodec compressChunk(const char *chunk,
+                           const char *base_chunk,
+                           const std::size_t size,
+                           const int level,
+                           std::vector<char> &buffer)
+{
+    if (base_chunk && std::memcmp(chunk, base_chunk, size) == 0)
+    {
+        buffer.clear();
+        return PackageCodec::Unchanged;
+    }
+#ifdef OSRM_HAVE_ZSTD
+    if (level > 0)
+    {
+        const char *input = chunk;
+        thread_local std::vector<char> patch;
+        if (base_chunk)
+        {
+            patch.resize(size);
+            std::transform(chunk, chunk + size, base_chunk, patch.begin(), std::bit_xor<char>());
+            input = patch.data();
+        }
+
+        thread_local std::unique_ptr<ZSTD_CCtx, std::size_t (*)(ZSTD_CCtx *)> context(
+            ZSTD_createCCtx(), ZSTD_freeCCtx);
+        buffer.resize(ZSTD_compressBound(size));
+        const auto result =
+            ZSTD_compressCCtx(context.get(), buffer.data(), buffer.size(), input, size, level);
+        if (ZSTD_isError(result))
+        {
+            throw util::exception(std::string("Could not compress a frame: ") +
+                                  ZSTD_getErrorName(result));
+        }
+        if (result < size)
+        {
+            buffer.resize(result);
+            return base_chunk ? PackageCodec::ZstdPatch : PackageCodec::Zstd;
+        }
+    }
+#else
+    (void)level;
+#endif
+    buffer.assign(chunk, chunk + size);
+    return PackageCodec::Stored;
+}
+
+// Returns false if the frame does not decompress to a chunk of the size, the base chunk is only
+// used by the frames of a delta
+bool decompressFrame(const PackageFrame &frame,
+                     const char *buffer,
+                     const char *base_chunk,
+                     char *chunk,
+                     const std::size_t size)
+{
+    switch (frame.codec)
+    {
+    case PackageCodec::Stored:
+        if (frame.size != size)
+        {
+            return false;
+        }
+        std::memcpy(chunk, buffer, size);
+        return true;
+    case PackageCodec::Unchanged:
+        std::memcpy(chunk, base_chunk, size);
+        return true;
+    case PackageCodec::Zstd:
+    case PackageCodec::ZstdPatch:
+    {
+#ifdef OSRM_HAVE_ZSTD
+        thread_local std::unique_ptr<ZSTD_DCtx, std::size_t (*)(ZSTD_DCtx *)> context(
+            ZSTD_createDCtx(), ZSTD_freeDCtx);
+        const auto result = ZSTD_decompressDCtx(context.get(), chunk, size, buffer, frame.size);
+        if (ZSTD_isError(result) || result != size)
+        {
+            return false;
+        }
+        if (frame.codec == PackageCodec::ZstdPatch)
+        {
+            std::transform(chunk, chunk + size, base_chunk, chunk, std::bit_xor<char>());
+        }
+        return true;
+#else
+        throw util::exception("osrm was built without zstd and cannot read compressed packages");
+#endif
+    }
+    }
+    return false;
+}
+
+// Runs the stages of a pipeline over the batches of frames, the first stage of a batch runs
+// concurrently with the second stage of the batch before it
+template <typename FirstStage, typename SecondStage>
+void runBatches(const std::size_t number_of_frames,
+                const FirstStage &first_stage,
+                const SecondStage &second_stage)
+{
+    const auto number_of_batches = (number_of_frames + FRAMES_PER_BATCH - 1) / FRAMES_PER_BATCH;
+    const auto range = [number_of_frames](const std::size_t batch) {
+        return std::make_pair(batch * FRAMES_PER_BATCH,
+                              std::min(number_of_frames, (batch + 1) * FRAMES_PER_BATCH));
+    };
+    for (std::size_t batch = 0; batch <= number_of_batches; ++batch)
+    {
+        tbb::parallel_invoke(
+            [&] {
+                if (batch < number_of_batches)
+                {
+                    const auto frames = range(batch);
+                    first_stage(batch % 2, frames.first, frames.second);
+                }
+            },
+            [&] {
+                if (batch > 0)
+                {
+                    const auto frames = range(batch - 1);
+                    second_stage((batch - 1) % 2, frames.first, frames.second);
+                }
+            });
+    }
+}
+}
+
+std::vector<PackageChunk> getPackageChunks(const SharedDataLayout &layout)
+{
+    std::vector<PackageChunk> chunks;
+    for (auto index = 0; index < SharedDataLayout::NUM_BLOCKS; ++index)
+    {
+        const auto block = static_cast<SharedDataLayout::BlockID>(index);
+        const auto block_offset = layout.GetBlockOffset(block);
+        const auto block_size = layout.GetBlockSize(block);
+        for (std::uint64_t offset = 0; offset < block_size; offset += util::CHECKSUM_CHUNK_SIZE)
+        {
+            chunks.push_back(
+                {block,
+                 block_offset + offset,
+                 std::min<std::uint64_t>(util::CHECKSUM_CHUNK_SIZE, block_size - offset)});
+        }
+    }
+    return chunks;
+}
+
+bool packageCompressionSupported()
+{
+#ifdef OSRM_HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::uint64_t writePackage(const boost::filesystem::path &path,
+                           const SharedDataLayout &layout,
+                           const char *data_memory,
+                           const char *metric_memory,
+                           const int level,
+                           const PackageBase &base)
+{
+    if (level > 0 && !packageCompressionSupported())
+    {
+        throw util::exception("osrm was built without zstd, packages can only be written with "
+                              "a compression level of 0");
+    }
+
+    PackageHeader header;
+    header.fingerprint = util::FingerPrint::GetValid();
+    header.layout = layout;
+    const auto chunks = getPackageChunks(layout);
+    header.number_of_frames = chunks.size();
+    header.is_delta = base.layout != nullptr;
+    header.base_layout = base.layout ? *base.layout : SharedDataLayout();
+    std::vector<PackageFrame> frames(chunks.size());
+
+    const boost::filesystem::path temporary_path = path.string() + ".tmp";
+    boost::filesystem::ofstream package_stream(temporary_path, std::ios::binary | std::ios::trunc);
+    if (!package_stream)
+    {
+        throw util::exception("Could not open " + temporary_path.string() + " for writing.");
+    }
+
+    std::uint64_t offset = PACKAGE_INDEX_OFFSET + frames.size() * sizeof(PackageFrame);
+    package_stream.seekp(offset);
+    std::vector<std::vector<char>> buffers[2] = {std::vector<std::vector<char>>(FRAMES_PER_BATCH),
+                                                 std::vector<std::vector<char>>(FRAMES_PER_BATCH)};
+    const auto compress_frame = [&](const std::size_t index, std::vector<char> &buffer) {
+        const auto &chunk = chunks[index];
+        const char *memory =
+            SharedDataLayout::IsMetricBlock(chunk.block) ? metric_memory : data_memory;
+        frames[index].checksum = util::crc32c(memory + chunk.offset, chunk.size);
+        frames[index].codec = compressChunk(
+            memory + chunk.offset, baseChunk(base, layout, chunk), chunk.size, level, buffer);
+        frames[index].size = buffer.size();
+    };
+    const auto compress =
+        [&](const std::size_t batch, const std::size_t begin, const std::size_t end) {
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(begin, end),
+                              [&](const tbb::blocked_range<std::size_t> &range) {
+                                  for (auto index = range.begin(); index != range.end(); ++index)
+                                  {
+                                      compress_frame(index, buffers[batch][index - begin]);
+                                  }
+                              });
+        };
+    const auto write =
+        [&](const std::size_t batch, const std::size_t begin, const std::size_t end) {
+            for (auto index = begin; index != end; ++index)
+            {
+                frames[index].offset = offset;
+                package_stream.write(buffers[batch][index - begin].data(), frames[index].size);
+                offset += frames[index].size;
+            }
+        };
+    runBatches(frames.size(), compress, write);
+
+    package_stream.seekp(0);
+    package_stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    package_stream.seekp(PACKAGE_INDEX_OFFSET);
+    package_stream.write(reinterpret_cast<const char *>(frames.data()),
+                         frames.size() * sizeof(PackageFrame));
+    package_stream.close();
+    if (!package_stream)
+    {
+        throw util::exception("Could not write " + temporary_path.string());
+    }
+
+    boost::filesystem::rename(temporary_path, path);
+    return offset;
+}
+
+PackageReader::PackageReader(const boost::filesystem::path &path_)
+    : path(path_.string()), reader(path_)
+{
+    if (reader.GetSize() < PACKAGE_INDEX_OFFSET)
+    {
+        throw util::exception(path + " is not a dataset package");
+    }
+    reader.Read(0, &header, sizeof(header));
+    if (!util::checkFingerprint(header.fingerprint))
+    {
+        throw util::exception("Fingerprint of " + path + " does not match");
+    }
+
+    chunks = getPackageChunks(header.layout);
+    if (header.number_of_frames != chunks.size() ||
+        PACKAGE_INDEX_OFFSET + chunks.size() * sizeof(PackageFrame) > reader.GetSize())
+    {
+        throw util::exception(path + " is corrupted");
+    }
+    frames.resize(chunks.size());
+    reader.Read(PACKAGE_INDEX_OFFSET, frames.data(), frames.size() * sizeof(PackageFrame));
+    for (const auto &frame : frames)
+    {
+        if (frame.offset > reader.GetSize() || frame.size > reader.GetSize() - frame.offset)
+        {
+            throw util::exception(path + " is truncated");
+        }
+    }
+}
+
+void PackageReader::Read(char *data_memory, char *metric_memory, const PackageBase &base)
+{
+    // the chunks of a delta are at the same places in the blocks of the base
+    if (IsDelta())
+    {
+        if (!base.layout)
+        {
+            throw util::exception(path + " is a delta package and needs the dataset it was made "
+                                         "against");
+        }
+        for (auto index = 0; index < SharedDataLayout::NUM_BLOCKS; ++index)
+        {
+            const auto block = static_cast<SharedDataLayout::BlockID>(index);
+            if (base.layout->GetBlockSize(block) != header.base_layout.GetBlockSize(block))
+            {
+                throw util::exception(std::string("The dataset differs from the base of ") +
+                                      path + " (" + block_id_to_name[block] + ")");
+            }
+        }
+    }
+
+    // the frames of the regions to fill
+    std::vector<std::size_t> selected_frames;
+    for (const auto index : util::irange<std::size_t>(0, frames.size()))
+    {
+        if (regionOf(chunks[index].block, data_memory, metric_memory))
+        {
+            selected_frames.push_back(index);
+        }
+    }
+
+    std::vector<char> buffers[2];
+    std::vector<std::uint64_t> frame_offsets[2];
+    const auto read = [&](const std::size_t batch, const std::size_t begin, const std::size_t end) {
+        auto &offsets = frame_offsets[batch];
+        offsets.clear();
+        std::uint64_t size = 0;
+        for (auto selected = begin; selected != end; ++selected)
+        {
+            offsets.push_back(size);
+            size += frames[selected_frames[selected]].size;
+        }
+        buffers[batch].resize(size);
+        for (auto selected = begin; selected != end; ++selected)
+        {
+            const auto &frame = frames[selected_frames[selected]];
+            if (frame.size > 0)
+            {
+                reader.Queue(
+                    frame.offset, buffers[batch].data() + offsets[selected - begin], frame.size);
+            }
+        }
+        reader.Wait();
+    };
+    const auto decompress_frame = [&](const std::size_t index, const char *buffer) {
+        const auto &chunk = chunks[index];
+        char *target = regionOf(chunk.block, data_memory, metric_memory) + chunk.offset;
+        const auto codec = frames[index].codec;
+        const bool from_base = codec == PackageCodec::Unchanged || codec == PackageCodec::ZstdPatch;
+        const char *base_chunk = from_base ? baseChunk(base, header.layout, chunk) : nullptr;
+        if (from_base && !base_chunk)
+        {
+            throw util::exception(std::string("The dataset lacks the base of ") + path + " (" +
+                                  block_id_to_name[chunk.block] + ")");
+        }
+        if (!decompressFrame(frames[index], buffer, base_chunk, target, chunk.size) ||
+            util::crc32c(target, chunk.size) != frames[index].checksum)
+        {
+            throw util::exception(std::string(from_base ? "The dataset differs from the base of "
+                                                        : "Checksum of block does not match in ") +
+                                  path + " (" + block_id_to_name[chunk.block] + ")");
+        }
+    };
+    const auto decompress =
+        [&](const std::size_t batch, const std::size_t begin, const std::size_t end) {
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(begin, end),
+                              [&](const tbb::blocked_range<std::size_t> &range) {
+                                  for (auto selected = range.begin(); selected != range.end();
+                                       ++selected)
+                                  {
+                                      decompress_frame(selected_frames[selected],
+                                                       buffers[batch].data() +
+                                                           frame_offsets[batch][selected - begin]);
+                                  }
+                              });
+        };
+    runBatches(selected_frames.size(), read, decompress);
+
+    // the frames are verified, their checksums have to add up to the ones of the blocks
+    std::vector<std::uint32_t> chunk_checksums;
+    auto index = 0UL;
+    for (auto block_index = 0; block_index < SharedDataLayout::NUM_BLOCKS; ++block_index)
+    {
+        const auto block = static_cast<SharedDataLayout::BlockID>(block_index);
+        chunk_checksums.clear();
+        for (; index < chunks.size() && chunks[index].block == block; ++index)
+        {
+            chunk_checksums.push_back(frames[index].checksum);
+        }
+        char *memory = regionOf(block, data_memory, metric_memory);
+        if (!memory)
+        {
+            continue;
+        }
+        if (util::combineChunkChecksums(chunk_checksums) != header.layout.checksums[block])
+        {
+            throw util::exception(std::string("Checksum of block does not match. (") +
+                                  block_id_to_name[block] + ") in " + path);
+        }
+        header.layout.GetBlockPtr<char, true>(memory, block);
+    }
+}
+}
+}
@@ -1,26 +1,35 @@
 #include "storage/storage.hpp"
 #include "contractor/query_edge.hpp"
 #include "extractor/compressed_edge_container.hpp"
+#include "extractor/edge_based_node.hpp"
 #include "extractor/guidance/turn_instruction.hpp"
 #include "extractor/original_edge_data.hpp"
 #include "extractor/profile_properties.hpp"
 #include "extractor/query_node.hpp"
 #include "extractor/travel_mode.hpp"
+#include "storage/container.hpp"
 #include "storage/io.hpp"
+#include "storage/package.hpp"
 #include "storage/shared_barriers.hpp"
 #include "storage/shared_datatype.hpp"
 #include "storage/shared_memory.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
 #include "util/coordinate.hpp"
+#include "util/coordinate_list.hpp"
 #include "util/exception.hpp"
 #include "util/fingerprint.hpp"
+#include "util/huge_pages.hpp"
 #include "util/io.hpp"
+#include "util/geometry_node_list.hpp"
 #include "util/packed_vector.hpp"
 #include "util/range_table.hpp"
+#include "util/segment_weight_list.hpp"
 #include "util/shared_memory_vector_wrapper.hpp"
 #include "util/simple_logger.hpp"
+#include "util/speed_profile.hpp"
 #include "util/static_graph.hpp"
 #include "util/static_rtree.hpp"
+#include "util/timing_util.hpp"
 #include "util/typedefs.hpp"
 
 #ifdef __linux__
@@ -29,18 +38,23 @@
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
 #include <boost/interprocess/exceptions.hpp>
-#include <boost/interprocess/sync/named_sharable_mutex.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/interprocess/sync/named_upgradable_mutex.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
 #include <boost/interprocess/sync/upgradable_lock.hpp>
-#include <boost/iostreams/seek.hpp>
+
+#include <tbb/parallel_invoke.h>
 
 #include <cstdint>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <new>
 #include <string>
 
@@ -49,52 +63,506 @@ namespace osrm
 namespace storage
 {
 
-using RTreeLeaf = engine::datafacade::BaseDataFacade::RTreeLeaf;
 using RTreeNode =
-    util::StaticRTree<RTreeLeaf, util::ShM<util::Coordinate, true>::vector, true>::TreeNode;
-using QueryGraph = util::StaticGraph<contractor::QueryEdge::EdgeData>;
+    util::StaticRTree<extractor::EdgeBasedNodeSegment, util::CoordinateList<true>, true>::TreeNode;
+using QueryGraph = engine::QueryGraph<true>;
+
+Storage::Storage(StorageConfig config_,
+                 const bool compress_coordinates_,
+                 const bool weight_offsets_,
+                 const bool compress_geometries_)
+    : config(std::move(config_)), compress_coordinates(compress_coordinates_),
+      weight_offsets(weight_offsets_), compress_geometries(compress_geometries_)
+{
+}
+
+namespace
+{
+// Logs when a block loader starts and how long it took, loaders run concurrently
+template <typename LoaderT> auto reportProgress(const char *name, LoaderT loader)
+{
+    return [name, loader] {
+        util::SimpleLogger().Write() << "loading " << name;
+        TIMER_START(load);
+        loader();
+        TIMER_STOP(load);
+        util::SimpleLogger().Write() << "loaded " << name << " in " << TIMER_SEC(load) << "s";
+    };
+}
+
+// Sets the sizes of the blocks that depend on the edge weights from the files of a metric. The
+// weight offsets are only computed if asked for.
+void setMetricBlockSizes(SharedDataLayout &layout,
+                         const StorageConfig &config,
+                         const bool weight_offsets)
+{
+    io::BulkReader hsgr_reader(config.hsgr_data_path);
+    const auto hsgr_header = io::readHSGRHeader(hsgr_reader);
+    layout.SetBlockSize<unsigned>(SharedDataLayout::HSGR_CHECKSUM, 1);
+    layout.SetBlockSize<QueryGraph::NodeArrayEntry>(SharedDataLayout::GRAPH_NODE_LIST,
+                                                    hsgr_header.number_of_nodes);
+    layout.SetBlockSize<engine::HotEdgeData>(SharedDataLayout::GRAPH_HOT_EDGE_LIST,
+                                             hsgr_header.number_of_edges);
+    layout.SetBlockSize<engine::ColdEdgeData>(SharedDataLayout::GRAPH_COLD_EDGE_LIST,
+                                              hsgr_header.number_of_edges);
+
+    // load core marker size
+    boost::filesystem::ifstream core_marker_file(config.core_data_path, std::ios::binary);
+    if (!core_marker_file)
+    {
+        throw util::exception("Could not open " + config.core_data_path.string() + " for reading.");
+    }
+
+    uint32_t number_of_core_markers = 0;
+    core_marker_file.read((char *)&number_of_core_markers, sizeof(uint32_t));
+    layout.SetBlockSize<unsigned>(SharedDataLayout::CORE_MARKER, number_of_core_markers);
+
+    // the node renumbering is optional, hierarchies in the order of the extraction have none
+    boost::filesystem::ifstream renumbering_input_stream(config.node_renumbering_path,
+                                                         std::ios::binary);
+    std::uint64_t number_of_renumbered_nodes = 0;
+    if (renumbering_input_stream)
+    {
+        if (!util::readAndCheckFingerprint(renumbering_input_stream))
+        {
+            throw util::exception("Fingerprint of " + config.node_renumbering_path.string() +
+                                  " does not match or could not read from file");
+        }
+        number_of_renumbered_nodes = io::readElementCount(renumbering_input_stream);
+    }
+    layout.SetBlockSize<NodeID>(SharedDataLayout::NODE_RENUMBERING, number_of_renumbered_nodes);
+
+    // the core landmarks are optional, the core is searched without a goal direction without them
+    boost::filesystem::ifstream landmarks_input_stream(config.core_landmarks_path,
+                                                       std::ios::binary);
+    std::uint64_t number_of_core_indices = 0;
+    std::uint64_t number_of_landmark_weights = 0;
+    if (landmarks_input_stream)
+    {
+        if (!util::readAndCheckFingerprint(landmarks_input_stream))
+        {
+            throw util::exception("Fingerprint of " + config.core_landmarks_path.string() +
+                                  " does not match or could not read from file");
+        }
+        landmarks_input_stream.seekg(sizeof(std::uint32_t), std::ios::cur);
+        number_of_core_indices = io::readElementCount(landmarks_input_stream);
+        landmarks_input_stream.seekg(number_of_core_indices * sizeof(NodeID), std::ios::cur);
+        number_of_landmark_weights = io::readElementCount(landmarks_input_stream);
+        if (number_of_core_indices != number_of_core_markers)
+        {
+            throw util::exception("The core landmarks " + config.core_landmarks_path.string() +
+                                  " do not belong to the core of the hierarchy");
+        }
+    }
+    layout.SetBlockSize<std::uint32_t>(SharedDataLayout::NUMBER_OF_CORE_LANDMARKS, 1);
+    layout.SetBlockSize<NodeID>(SharedDataLayout::CORE_LANDMARK_INDICES, number_of_core_indices);
+    layout.SetBlockSize<EdgeWeight>(SharedDataLayout::CORE_LANDMARK_WEIGHTS,
+                                    number_of_landmark_weights);
+
+    // the weights are stored with the geometries
+    io::BulkReader geometry_reader(config.geometries_path);
+    const auto number_of_geometries_indices = geometry_reader.Read<unsigned>(0);
+    const auto nodes_offset = (1 + std::uint64_t{number_of_geometries_indices}) * sizeof(unsigned);
+    const auto number_of_compressed_geometries = geometry_reader.Read<unsigned>(nodes_offset);
+    layout.SetBlockSize<std::uint16_t>(SharedDataLayout::GEOMETRIES_FWD_WEIGHT_LIST,
+                                       number_of_compressed_geometries);
+    layout.SetBlockSize<std::uint16_t>(SharedDataLayout::GEOMETRIES_REV_WEIGHT_LIST,
+                                       number_of_compressed_geometries);
+    // the weights are packed to 16 bits, the ones that do not fit go to the overflow tables
+    const auto weights_offset =
+        nodes_offset + sizeof(unsigned) + number_of_compressed_geometries * sizeof(NodeID);
+    util::SegmentWeightEncoder fwd_weight_counter, rev_weight_counter;
+    io::readSegmentWeights(
+        geometry_reader, weights_offset, number_of_compressed_geometries, fwd_weight_counter);
+    io::readSegmentWeights(geometry_reader,
+                           weights_offset + number_of_compressed_geometries * sizeof(EdgeWeight),
+                           number_of_compressed_geometries,
+                           rev_weight_counter);
+    layout.SetBlockSize<util::SegmentWeightOverflow>(
+        SharedDataLayout::GEOMETRIES_FWD_WEIGHT_OVERFLOW,
+        fwd_weight_counter.GetNumberOfOverflows());
+    layout.SetBlockSize<util::SegmentWeightOverflow>(
+        SharedDataLayout::GEOMETRIES_REV_WEIGHT_OVERFLOW,
+        rev_weight_counter.GetNumberOfOverflows());
+    const auto number_of_weight_offsets = weight_offsets ? number_of_compressed_geometries : 0;
+    layout.SetBlockSize<EdgeWeight>(SharedDataLayout::GEOMETRIES_FWD_WEIGHT_OFFSETS,
+                                    number_of_weight_offsets);
+    layout.SetBlockSize<EdgeWeight>(SharedDataLayout::GEOMETRIES_REV_WEIGHT_OFFSETS,
+                                    number_of_weight_offsets);
+
+    // load datasource sizes.  This file is optional, and it's non-fatal if it doesn't
+    // exist.
+    boost::filesystem::ifstream geometry_datasource_input_stream(config.datasource_indexes_path,
+                                                                 std::ios::binary);
+    if (!geometry_datasource_input_stream)
+    {
+        throw util::exception("Could not open " + config.datasource_indexes_path.string() +
+                              " for reading.");
+    }
+    const auto number_of_compressed_datasources =
+        io::readElementCount(geometry_datasource_input_stream);
+    layout.SetBlockSize<uint8_t>(SharedDataLayout::DATASOURCES_LIST,
+                                 number_of_compressed_datasources);
+
+    // Load datasource name sizes.  This file is optional, and it's non-fatal if it doesn't
+    // exist
+
+    boost::filesystem::ifstream datasource_names_input_stream(config.datasource_names_path,
+                                                              std::ios::binary);
+    if (!datasource_names_input_stream)
+    {
+        throw util::exception("Could not open " + config.datasource_names_path.string() +
+                              " for reading.");
+    }
+    const io::DatasourceNamesData datasource_names_data =
+        io::readDatasourceNames(datasource_names_input_stream);
+
+    layout.SetBlockSize<char>(SharedDataLayout::DATASOURCE_NAME_DATA,
+                              datasource_names_data.names.size());
+    layout.SetBlockSize<std::size_t>(SharedDataLayout::DATASOURCE_NAME_OFFSETS,
+                                     datasource_names_data.offsets.size());
+    layout.SetBlockSize<std::size_t>(SharedDataLayout::DATASOURCE_NAME_LENGTHS,
+                                     datasource_names_data.lengths.size());
+
+    // the speed profiles are optional, datasets without them have empty blocks
+    boost::filesystem::ifstream speed_profiles_input_stream(config.speed_profiles_path,
+                                                            std::ios::binary);
+    const auto speed_profiles_header =
+        speed_profiles_input_stream ? io::readSpeedProfilesHeader(speed_profiles_input_stream)
+                                    : io::SpeedProfilesHeader{0, 0};
+    layout.SetBlockSize<std::uint8_t>(SharedDataLayout::SPEED_PROFILE_FACTORS,
+                                      speed_profiles_header.number_of_factors);
+    layout.SetBlockSize<util::SpeedProfileSegment>(SharedDataLayout::SPEED_PROFILE_SEGMENTS,
+                                                   speed_profiles_header.number_of_segments);
+}
+
+// Reads the files of a metric into the blocks set up by setMetricBlockSizes. All loaders read
+// different files into disjoint blocks, so they run concurrently.
+void loadMetricBlocks(SharedDataLayout &layout, char *metric_memory_ptr, const StorageConfig &config)
+{
+    const auto load_weights = [&] {
+        // the weights follow the index and the nodes of the geometries
+        io::BulkReader weights_reader(config.geometries_path);
+        const auto number_of_geometries_indices = weights_reader.Read<unsigned>(0);
+        const auto number_of_weights =
+            layout.num_entries[SharedDataLayout::GEOMETRIES_FWD_WEIGHT_LIST];
+        const auto weights_offset = 2 * sizeof(unsigned) +
+                                    number_of_geometries_indices * sizeof(unsigned) +
+                                    number_of_weights * sizeof(NodeID);
+        util::SegmentWeightEncoder fwd_weight_encoder(
+            layout.GetBlockPtr<std::uint16_t, true>(metric_memory_ptr,
+                                                    SharedDataLayout::GEOMETRIES_FWD_WEIGHT_LIST),
+            layout.GetBlockPtr<util::SegmentWeightOverflow, true>(
+                metric_memory_ptr, SharedDataLayout::GEOMETRIES_FWD_WEIGHT_OVERFLOW));
+        io::readSegmentWeights(
+            weights_reader, weights_offset, number_of_weights, fwd_weight_encoder);
+        util::SegmentWeightEncoder rev_weight_encoder(
+            layout.GetBlockPtr<std::uint16_t, true>(metric_memory_ptr,
+                                                    SharedDataLayout::GEOMETRIES_REV_WEIGHT_LIST),
+            layout.GetBlockPtr<util::SegmentWeightOverflow, true>(
+                metric_memory_ptr, SharedDataLayout::GEOMETRIES_REV_WEIGHT_OVERFLOW));
+        io::readSegmentWeights(weights_reader,
+                               weights_offset + number_of_weights * sizeof(EdgeWeight),
+                               number_of_weights,
+                               rev_weight_encoder);
+        BOOST_ASSERT(fwd_weight_encoder.GetNumberOfOverflows() ==
+                     layout.num_entries[SharedDataLayout::GEOMETRIES_FWD_WEIGHT_OVERFLOW]);
+        BOOST_ASSERT(rev_weight_encoder.GetNumberOfOverflows() ==
+                     layout.num_entries[SharedDataLayout::GEOMETRIES_REV_WEIGHT_OVERFLOW]);
+
+        // the offsets are decoded from the packed weights, the geometry index is read again as
+        // the data blocks may be shared with the current dataset
+        if (layout.num_entries[SharedDataLayout::GEOMETRIES_FWD_WEIGHT_OFFSETS] > 0)
+        {
+            std::vector<unsigned> geometry_indices(number_of_geometries_indices);
+            weights_reader.Queue(sizeof(unsigned),
+                                 geometry_indices.data(),
+                                 number_of_geometries_indices * sizeof(unsigned));
+            weights_reader.Wait();
+
+            const auto decode_weights = [&](const SharedDataLayout::BlockID values_block,
+                                            const SharedDataLayout::BlockID overflows_block,
+                                            const SharedDataLayout::BlockID offsets_block) {
+                const auto overflows = layout.GetBlockPtr<util::SegmentWeightOverflow>(
+                    metric_memory_ptr, overflows_block);
+                const auto offsets =
+                    layout.GetBlockPtr<EdgeWeight, true>(metric_memory_ptr, offsets_block);
+                util::SegmentWeightView(
+                    layout.GetBlockPtr<std::uint16_t>(metric_memory_ptr, values_block),
+                    overflows,
+                    overflows + layout.num_entries[overflows_block],
+                    0,
+                    number_of_weights)
+                    .decode(offsets);
+                return offsets;
+            };
+            util::toSegmentWeightOffsets(
+                geometry_indices.data(),
+                geometry_indices.data() + geometry_indices.size(),
+                decode_weights(SharedDataLayout::GEOMETRIES_FWD_WEIGHT_LIST,
+                               SharedDataLayout::GEOMETRIES_FWD_WEIGHT_OVERFLOW,
+                               SharedDataLayout::GEOMETRIES_FWD_WEIGHT_OFFSETS),
+                decode_weights(SharedDataLayout::GEOMETRIES_REV_WEIGHT_LIST,
+                               SharedDataLayout::GEOMETRIES_REV_WEIGHT_OVERFLOW,
+                               SharedDataLayout::GEOMETRIES_REV_WEIGHT_OFFSETS));
+        }
+
+        // load datasource information (if it exists)
+        boost::filesystem::ifstream geometry_datasource_input_stream(
+            config.datasource_indexes_path, std::ios::binary);
+        const auto number_of_compressed_datasources =
+            io::readElementCount(geometry_datasource_input_stream);
+        uint8_t *datasources_list_ptr = layout.GetBlockPtr<uint8_t, true>(
+            metric_memory_ptr, SharedDataLayout::DATASOURCES_LIST);
+        if (layout.GetBlockSize(SharedDataLayout::DATASOURCES_LIST) > 0)
+        {
+            io::readDatasourceIndexes(geometry_datasource_input_stream,
+                                      datasources_list_ptr,
+                                      number_of_compressed_datasources);
+        }
+
+        // load datasource name information (if it exists)
+        boost::filesystem::ifstream datasource_names_input_stream(config.datasource_names_path,
+                                                                  std::ios::binary);
+        const io::DatasourceNamesData datasource_names_data =
+            io::readDatasourceNames(datasource_names_input_stream);
+
+        char *datasource_name_data_ptr = layout.GetBlockPtr<char, true>(
+            metric_memory_ptr, SharedDataLayout::DATASOURCE_NAME_DATA);
+        if (layout.GetBlockSize(SharedDataLayout::DATASOURCE_NAME_DATA) > 0)
+        {
+            std::copy(datasource_names_data.names.begin(),
+                      datasource_names_data.names.end(),
+                      datasource_name_data_ptr);
+        }
+
+        auto datasource_name_offsets_ptr = layout.GetBlockPtr<std::uint32_t, true>(
+            metric_memory_ptr, SharedDataLayout::DATASOURCE_NAME_OFFSETS);
+        if (layout.GetBlockSize(SharedDataLayout::DATASOURCE_NAME_OFFSETS) > 0)
+        {
+            std::copy(datasource_names_data.offsets.begin(),
+                      datasource_names_data.offsets.end(),
+                      datasource_name_offsets_ptr);
+        }
+
+        auto datasource_name_lengths_ptr = layout.GetBlockPtr<std::uint32_t, true>(
+            metric_memory_ptr, SharedDataLayout::DATASOURCE_NAME_LENGTHS);
+        if (layout.GetBlockSize(SharedDataLayout::DATASOURCE_NAME_LENGTHS) > 0)
+        {
+            std::copy(datasource_names_data.lengths.begin(),
+                      datasource_names_data.lengths.end(),
+                      datasource_name_lengths_ptr);
+        }
+    };
+
+    const auto load_core_markers = [&] {
+        // load core markers
+        boost::filesystem::ifstream core_marker_file(config.core_data_path, std::ios::binary);
+        uint32_t number_of_core_markers = 0;
+        core_marker_file.read((char *)&number_of_core_markers, sizeof(uint32_t));
+        std::vector<char> unpacked_core_markers(number_of_core_markers);
+        core_marker_file.read((char *)unpacked_core_markers.data(),
+                              sizeof(char) * number_of_core_markers);
 
-Storage::Storage(StorageConfig config_) : config(std::move(config_)) {}
+        unsigned *core_marker_ptr =
+            layout.GetBlockPtr<unsigned, true>(metric_memory_ptr, SharedDataLayout::CORE_MARKER);
+
+        for (auto i = 0u; i < number_of_core_markers; ++i)
+        {
+            BOOST_ASSERT(unpacked_core_markers[i] == 0 || unpacked_core_markers[i] == 1);
+
+            if (unpacked_core_markers[i] == 1)
+            {
+                const unsigned bucket = i / 32;
+                const unsigned offset = i % 32;
+                const unsigned value = [&] {
+                    unsigned return_value = 0;
+                    if (0 != offset)
+                    {
+                        return_value = core_marker_ptr[bucket];
+                    }
+                    return return_value;
+                }();
+
+                core_marker_ptr[bucket] = (value | (1u << offset));
+            }
+        }
+    };
+
+    const auto load_graph = [&] {
+        io::BulkReader hsgr_reader(config.hsgr_data_path);
+        const auto hsgr_header = io::readHSGRHeader(hsgr_reader);
+
+        // hsgr checksum
+        unsigned *checksum_ptr =
+            layout.GetBlockPtr<unsigned, true>(metric_memory_ptr, SharedDataLayout::HSGR_CHECKSUM);
+        *checksum_ptr = hsgr_header.checksum;
+
+        // load the nodes of the search graph
+        QueryGraph::NodeArrayEntry *graph_node_list_ptr =
+            layout.GetBlockPtr<QueryGraph::NodeArrayEntry, true>(metric_memory_ptr,
+                                                                 SharedDataLayout::GRAPH_NODE_LIST);
+
+        // load the edges of the search graph
+        auto graph_hot_edge_list_ptr = layout.GetBlockPtr<engine::HotEdgeData, true>(
+            metric_memory_ptr, SharedDataLayout::GRAPH_HOT_EDGE_LIST);
+        auto graph_cold_edge_list_ptr = layout.GetBlockPtr<engine::ColdEdgeData, true>(
+            metric_memory_ptr, SharedDataLayout::GRAPH_COLD_EDGE_LIST);
+
+        io::readHSGR(hsgr_reader,
+                     graph_node_list_ptr,
+                     hsgr_header.number_of_nodes,
+                     graph_hot_edge_list_ptr,
+                     graph_cold_edge_list_ptr,
+                     hsgr_header.number_of_edges);
+    };
+
+    const auto load_node_renumbering = [&] {
+        if (layout.num_entries[SharedDataLayout::NODE_RENUMBERING] > 0)
+        {
+            boost::filesystem::ifstream renumbering_input_stream(config.node_renumbering_path,
+                                                                 std::ios::binary);
+            util::readAndCheckFingerprint(renumbering_input_stream);
+            io::readElementCount(renumbering_input_stream);
+            auto renumbering_ptr = layout.GetBlockPtr<NodeID, true>(
+                metric_memory_ptr, SharedDataLayout::NODE_RENUMBERING);
+            renumbering_input_stream.read(
+                reinterpret_cast<char *>(renumbering_ptr),
+                layout.num_entries[SharedDataLayout::NODE_RENUMBERING] * sizeof(NodeID));
+        }
+    };
+
+    const auto load_core_landmarks = [&] {
+        auto number_of_landmarks_ptr = layout.GetBlockPtr<std::uint32_t, true>(
+            metric_memory_ptr, SharedDataLayout::NUMBER_OF_CORE_LANDMARKS);
+        *number_of_landmarks_ptr = 0;
+        if (layout.num_entries[SharedDataLayout::CORE_LANDMARK_INDICES] > 0)
+        {
+            boost::filesystem::ifstream landmarks_input_stream(config.core_landmarks_path,
+                                                               std::ios::binary);
+            util::readAndCheckFingerprint(landmarks_input_stream);
+            landmarks_input_stream.read(reinterpret_cast<char *>(number_of_landmarks_ptr),
+                                        sizeof(std::uint32_t));
+            io::readElementCount(landmarks_input_stream);
+            auto indices_ptr = layout.GetBlockPtr<NodeID, true>(
+                metric_memory_ptr, SharedDataLayout::CORE_LANDMARK_INDICES);
+            landmarks_input_stream.read(
+                reinterpret_cast<char *>(indices_ptr),
+                layout.num_entries[SharedDataLayout::CORE_LANDMARK_INDICES] * sizeof(NodeID));
+            io::readElementCount(landmarks_input_stream);
+            auto weights_ptr = layout.GetBlockPtr<EdgeWeight, true>(
+                metric_memory_ptr, SharedDataLayout::CORE_LANDMARK_WEIGHTS);
+            landmarks_input_stream.read(
+                reinterpret_cast<char *>(weights_ptr),
+                layout.num_entries[SharedDataLayout::CORE_LANDMARK_WEIGHTS] * sizeof(EdgeWeight));
+        }
+    };
+
+    const auto load_speed_profiles = [&] {
+        auto factors_ptr = layout.GetBlockPtr<std::uint8_t, true>(
+            metric_memory_ptr, SharedDataLayout::SPEED_PROFILE_FACTORS);
+        auto segments_ptr = layout.GetBlockPtr<util::SpeedProfileSegment, true>(
+            metric_memory_ptr, SharedDataLayout::SPEED_PROFILE_SEGMENTS);
+        if (layout.num_entries[SharedDataLayout::SPEED_PROFILE_SEGMENTS] > 0)
+        {
+            boost::filesystem::ifstream speed_profiles_input_stream(config.speed_profiles_path,
+                                                                    std::ios::binary);
+            io::readSpeedProfiles(speed_profiles_input_stream,
+                                  factors_ptr,
+                                  layout.num_entries[SharedDataLayout::SPEED_PROFILE_FACTORS],
+                                  segments_ptr,
+                                  layout.num_entries[SharedDataLayout::SPEED_PROFILE_SEGMENTS]);
+        }
+    };
+
+    tbb::parallel_invoke(reportProgress("weights", load_weights),
+                         reportProgress("core markers", load_core_markers),
+                         reportProgress("node renumbering", load_node_renumbering),
+                         reportProgress("core landmarks", load_core_landmarks),
+                         reportProgress("graph", load_graph),
+                         reportProgress("speed profiles", load_speed_profiles));
+}
+
+// A metric has to match the nodes and the segments of the dataset it is loaded with
+bool hasSameTopology(const SharedDataLayout &layout, const SharedDataLayout &metric_layout)
+{
+    const auto same = [&](const SharedDataLayout::BlockID bid) {
+        return layout.num_entries[bid] == metric_layout.num_entries[bid];
+    };
+    return same(SharedDataLayout::GRAPH_NODE_LIST) &&
+           same(SharedDataLayout::GEOMETRIES_FWD_WEIGHT_LIST);
+}
+}
 
 struct RegionsLayout
 {
     SharedDataType current_layout_region;
     SharedDataType current_data_region;
-    boost::interprocess::named_sharable_mutex &current_regions_mutex;
+    SharedDataType current_metric_region;
     SharedDataType old_layout_region;
-    SharedDataType old_data_region;
-    boost::interprocess::named_sharable_mutex &old_regions_mutex;
+    SharedDataType old_metric_region;
+    // data region the current dataset does not use
+    SharedDataType free_data_region;
 };
 
-RegionsLayout getRegionsLayout(SharedBarriers &barriers)
+RegionsLayout getRegionsLayout()
 {
     if (SharedMemory::RegionExists(CURRENT_REGIONS))
     {
         auto shared_regions = makeSharedMemory(CURRENT_REGIONS);
         const auto shared_timestamp =
             static_cast<const SharedDataTimestamp *>(shared_regions->Ptr());
-        if (shared_timestamp->data == DATA_1)
+        // the data region is not tied to the layout, metric updates keep using the current one
+        const auto free_data_region = shared_timestamp->data == DATA_1 ? DATA_2 : DATA_1;
+        if (shared_timestamp->layout == LAYOUT_1)
         {
-            BOOST_ASSERT(shared_timestamp->layout == LAYOUT_1);
+            BOOST_ASSERT(shared_timestamp->metric == METRIC_1);
             return RegionsLayout{LAYOUT_1,
-                                 DATA_1,
-                                 barriers.regions_1_mutex,
+                                 shared_timestamp->data,
+                                 METRIC_1,
                                  LAYOUT_2,
-                                 DATA_2,
-                                 barriers.regions_2_mutex};
+                                 METRIC_2,
+                                 free_data_region};
         }
 
-        BOOST_ASSERT(shared_timestamp->data == DATA_2);
         BOOST_ASSERT(shared_timestamp->layout == LAYOUT_2);
+        BOOST_ASSERT(shared_timestamp->metric == METRIC_2);
+        return RegionsLayout{LAYOUT_2,
+                             shared_timestamp->data,
+                             METRIC_2,
+                             LAYOUT_1,
+                             METRIC_1,
+                             free_data_region};
     }
 
-    return RegionsLayout{
-        LAYOUT_2, DATA_2, barriers.regions_2_mutex, LAYOUT_1, DATA_1, barriers.regions_1_mutex};
+    return RegionsLayout{LAYOUT_NONE, DATA_NONE, METRIC_NONE, LAYOUT_1, METRIC_1, DATA_1};
 }
 
-Storage::ReturnCode Storage::Run(int max_wait)
+Storage::ReturnCode Storage::Run(int max_wait,
+                                 const DataSource source,
+                                 const bool only_metric,
+                                 const bool huge_pages)
 {
-    BOOST_ASSERT_MSG(config.IsValid(), "Invalid storage config");
+    const bool from_container = source != Files;
+    BOOST_ASSERT_MSG(from_container || config.IsValid(), "Invalid storage config");
+    BOOST_ASSERT_MSG(!from_container || !only_metric, "Containers hold the whole dataset");
+    BOOST_ASSERT_MSG(!from_container || config.metrics.empty(),
+                     "Containers only hold the default metric");
+
+    if (config.metrics.size() > SharedMetrics::MAX_METRICS)
+    {
+        throw util::exception("At most " + std::to_string(SharedMetrics::MAX_METRICS) +
+                              " additional metrics can be loaded");
+    }
+    for (const auto &metric : config.metrics)
+    {
+        if (metric.empty() || metric.size() >= SharedMetrics::MAX_NAME_LENGTH)
+        {
+            throw util::exception("Metric names have 1 to " +
+                                  std::to_string(SharedMetrics::MAX_NAME_LENGTH - 1) +
+                                  " characters");
+        }
+    }
 
     util::LogPolicy::GetInstance().Unmute();
 
@@ -127,65 +595,247 @@ Storage::ReturnCode Storage::Run(int max_wait)
     }
 #endif
 
-    auto regions_layout = getRegionsLayout(barriers);
+    const auto regions_layout = getRegionsLayout();
     const SharedDataType layout_region = regions_layout.old_layout_region;
-    const SharedDataType data_region = regions_layout.old_data_region;
+    const SharedDataType metric_region = regions_layout.old_metric_region;
+    // a metric update shares the data region with the current dataset, so does a full update whose
+    // data blocks did not change
+    SharedDataType data_region =
+        only_metric ? regions_layout.current_data_region : regions_layout.free_data_region;
 
-    if (max_wait > 0)
+    if (only_metric && regions_layout.current_layout_region == LAYOUT_NONE)
     {
-        util::SimpleLogger().Write() << "Waiting for " << max_wait
-                                     << " second for all queries on the old dataset to finish:";
+        util::SimpleLogger().Write(logWARNING) << "No dataset in shared memory to update";
+        return ReturnCode::Error;
     }
-    else
+
+    // Queries never lock the regions, so they are not waited for. Removing a region that is still
+    // attached only detaches its key: readers keep using it until they unmap it, and the key is
+    // free for the new dataset right away.
+    // since we can't change the size of a shared memory regions we delete and reallocate
+    if (SharedMemory::RegionExists(layout_region) && !SharedMemory::Remove(layout_region))
+    {
+        throw util::exception("Could not remove " + regionToString(layout_region));
+    }
+    if (SharedMemory::RegionExists(metric_region) && !SharedMemory::Remove(metric_region))
     {
-        util::SimpleLogger().Write() << "Waiting for all queries on the old dataset to finish:";
+        throw util::exception("Could not remove " + regionToString(metric_region));
+    }
+    // only the old dataset might use the free data region, both kinds of updates drop it
+    const auto free_data_region = regions_layout.free_data_region;
+    if (SharedMemory::RegionExists(free_data_region) && !SharedMemory::Remove(free_data_region))
+    {
+        throw util::exception("Could not remove " + regionToString(free_data_region));
     }
 
-    boost::interprocess::scoped_lock<boost::interprocess::named_sharable_mutex> regions_lock(
-        regions_layout.old_regions_mutex, boost::interprocess::defer_lock);
+    std::unique_ptr<SharedMemory> current_layout_memory;
+    const SharedDataLayout *current_layout = nullptr;
+    if (regions_layout.current_layout_region != LAYOUT_NONE)
+    {
+        current_layout_memory = makeSharedMemory(regions_layout.current_layout_region);
+        current_layout = static_cast<const SharedDataLayout *>(current_layout_memory->Ptr());
+    }
 
-    if (max_wait > 0)
+    // Allocate a memory layout in shared memory
+    auto layout_memory = makeSharedMemory(layout_region, LAYOUT_REGION_SIZE, true);
+    auto shared_layout_ptr = new (layout_memory->Ptr()) SharedDataLayout();
+    auto shared_metrics_ptr = new (GetSharedMetrics(layout_memory->Ptr())) SharedMetrics();
+    if (only_metric)
     {
-        if (!regions_lock.timed_lock(boost::posix_time::microsec_clock::universal_time() +
-                                     boost::posix_time::seconds(max_wait)))
+        // the shared data blocks are not loaded again, only the metric checksums are computed
+        shared_layout_ptr->checksums = current_layout->checksums;
+    }
+
+    const auto share_data = [&](const SharedDataLayout &layout) {
+        util::SimpleLogger().Write() << "sharing " << layout.GetSizeOfLayout()
+                                     << " bytes of data with the current dataset";
+        data_region = regions_layout.current_data_region;
+    };
+
+    std::unique_ptr<SharedMemory> shared_memory;
+    const auto allocate_shared_memory = [&](const SharedDataLayout &layout) -> char * {
+        if (only_metric)
         {
-            util::SimpleLogger().Write(logWARNING) << "Queries did not finish in " << max_wait
-                                                   << " seconds. Claiming the lock by force.";
-            // WARNING: if queries are still using the old dataset they might crash
-            if (regions_layout.old_layout_region == LAYOUT_1)
+            if (!layout.HasSameLayout(*current_layout))
             {
-                BOOST_ASSERT(regions_layout.old_data_region == DATA_1);
-                barriers.resetRegions1();
+                throw util::exception("The dataset changed beyond the metric, a full update of "
+                                      "the shared memory is needed");
             }
-            else
+            share_data(layout);
+            return nullptr;
+        }
+        // containers and packages carry the checksums of their blocks, unchanged data is not
+        // loaded again
+        if (from_container && current_layout && layout.HasSameData(*current_layout))
+        {
+            share_data(layout);
+            return nullptr;
+        }
+
+        util::SimpleLogger().Write() << "allocating shared memory of " << layout.GetSizeOfLayout()
+                                     << " bytes";
+        shared_memory =
+            makeSharedMemory(data_region, layout.GetSizeOfLayout(), true, huge_pages);
+        return static_cast<char *>(shared_memory->Ptr());
+    };
+
+    std::unique_ptr<SharedMemory> metric_memory;
+    uint64_t metric_region_size = 0;
+    const auto allocate_metric_memory = [&](const SharedDataLayout &layout) {
+        // the blocks of the additional metrics follow the metric blocks of the dataset
+        metric_region_size = layout.GetSizeOfMetric();
+        for (const auto &name : config.metrics)
+        {
+            auto &metric = shared_metrics_ptr->metrics[shared_metrics_ptr->number_of_metrics++];
+            std::fill(metric.name, metric.name + SharedMetrics::MAX_NAME_LENGTH, 0);
+            std::copy(name.begin(), name.end(), metric.name);
+            metric.offset = metric_region_size;
+            metric.layout = layout;
+            setMetricBlockSizes(metric.layout, config.GetMetricConfig(name), weight_offsets);
+            if (!hasSameTopology(layout, metric.layout))
             {
-                BOOST_ASSERT(regions_layout.old_layout_region == LAYOUT_2);
-                BOOST_ASSERT(regions_layout.old_data_region == DATA_2);
-                barriers.resetRegions2();
+                throw util::exception("The metric " + name +
+                                      " was not contracted for the topology of the dataset");
             }
+            metric_region_size += metric.layout.GetSizeOfMetric();
+        }
 
-            return ReturnCode::Retry;
+        util::SimpleLogger().Write() << "allocating shared memory of " << metric_region_size
+                                     << " bytes for " << (config.metrics.size() + 1)
+                                     << " metrics";
+        metric_memory = makeSharedMemory(metric_region, metric_region_size, true, huge_pages);
+        return static_cast<char *>(metric_memory->Ptr());
+    };
+
+    if (source == Container)
+    {
+        LoadContainer(shared_layout_ptr, allocate_shared_memory, allocate_metric_memory);
+    }
+    else if (source == Package)
+    {
+        // a delta package takes the unchanged parts of the blocks from the current dataset
+        std::unique_ptr<SharedMemory> current_data_memory;
+        std::unique_ptr<SharedMemory> current_metric_memory;
+        if (current_layout)
+        {
+            current_data_memory = makeSharedMemory(regions_layout.current_data_region);
+            current_metric_memory = makeSharedMemory(regions_layout.current_metric_region);
         }
+        LoadPackage(shared_layout_ptr,
+                    allocate_shared_memory,
+                    allocate_metric_memory,
+                    current_layout,
+                    current_data_memory ? static_cast<char *>(current_data_memory->Ptr()) : nullptr,
+                    current_metric_memory ? static_cast<char *>(current_metric_memory->Ptr())
+                                          : nullptr);
     }
     else
     {
-        regions_lock.lock();
+        Populate(shared_layout_ptr, allocate_shared_memory, allocate_metric_memory);
+
+        // the additional metrics share the data blocks including their checksums
+        std::for_each(shared_metrics_ptr->metrics.begin(),
+                      shared_metrics_ptr->metrics.begin() + shared_metrics_ptr->number_of_metrics,
+                      [&](SharedMetrics::Metric &metric) {
+                          util::SimpleLogger().Write() << "loading metric " << metric.name;
+                          char *metric_memory_ptr =
+                              static_cast<char *>(metric_memory->Ptr()) + metric.offset;
+                          loadMetricBlocks(
+                              metric.layout, metric_memory_ptr, config.GetMetricConfig(metric.name));
+                          metric.layout.checksums = shared_layout_ptr->checksums;
+                          metric.layout.ComputeChecksums(nullptr, metric_memory_ptr);
+                      });
+
+        // the checksums are only known once the files are loaded, drop the copy of unchanged data
+        if (shared_memory && current_layout && shared_layout_ptr->HasSameData(*current_layout))
+        {
+            shared_memory.reset();
+            if (!SharedMemory::Remove(data_region))
+            {
+                throw util::exception("Could not remove " + regionToString(data_region));
+            }
+            share_data(*shared_layout_ptr);
+        }
     }
-    util::SimpleLogger().Write() << "Ok.";
 
-    // since we can't change the size of a shared memory regions we delete and reallocate
-    if (SharedMemory::RegionExists(layout_region) && !SharedMemory::Remove(layout_region))
+    if (huge_pages)
     {
-        throw util::exception("Could not remove " + regionToString(layout_region));
+        const auto report = [](const char *name, const void *begin, const std::size_t size) {
+            util::SimpleLogger().Write() << util::getHugePageBackedBytes(begin, size) << " of "
+                                         << size << " bytes of the " << name
+                                         << " are backed by huge pages";
+        };
+        if (shared_memory)
+        {
+            report("data", shared_memory->Ptr(), shared_layout_ptr->GetSizeOfLayout());
+        }
+        report("metrics", metric_memory->Ptr(), metric_region_size);
     }
-    if (SharedMemory::RegionExists(data_region) && !SharedMemory::Remove(data_region))
+
+    auto data_type_memory = makeSharedMemory(CURRENT_REGIONS, sizeof(SharedDataTimestamp), true);
+    SharedDataTimestamp *data_timestamp_ptr =
+        static_cast<SharedDataTimestamp *>(data_type_memory->Ptr());
+
     {
-        throw util::exception("Could not remove " + regionToString(data_region));
+        boost::interprocess::scoped_lock<boost::interprocess::named_upgradable_mutex>
+            current_regions_exclusive_lock;
+
+        if (max_wait > 0)
+        {
+            util::SimpleLogger().Write() << "Waiting for " << max_wait
+                                         << " seconds to write new dataset timestamp";
+            auto end_time = boost::posix_time::microsec_clock::universal_time() +
+                            boost::posix_time::seconds(max_wait);
+            current_regions_exclusive_lock =
+                boost::interprocess::scoped_lock<boost::interprocess::named_upgradable_mutex>(
+                    std::move(current_regions_lock), end_time);
+
+            if (!current_regions_exclusive_lock.owns())
+            {
+                util::SimpleLogger().Write(logWARNING) << "Aquiring the lock timed out after "
+                                                       << max_wait
+                                                       << " seconds. Claiming the lock by force.";
+                current_regions_lock.unlock();
+                current_regions_lock.release();
+                storage::SharedBarriers::resetCurrentRegions();
+                return ReturnCode::Retry;
+            }
+        }
+        else
+        {
+            util::SimpleLogger().Write() << "Waiting to write new dataset timestamp";
+            current_regions_exclusive_lock =
+                boost::interprocess::scoped_lock<boost::interprocess::named_upgradable_mutex>(
+                    std::move(current_regions_lock));
+        }
+
+        util::SimpleLogger().Write() << "Ok.";
+        data_timestamp_ptr->layout = layout_region;
+        data_timestamp_ptr->data = data_region;
+        data_timestamp_ptr->metric = metric_region;
+        data_timestamp_ptr->timestamp += 1;
+
+        // clients only attach the regions of the newest dataset, so the previous one is freed as
+        // soon as its last query finished
+        if (regions_layout.current_layout_region != LAYOUT_NONE)
+        {
+            SharedMemory::Remove(regions_layout.current_layout_region);
+            SharedMemory::Remove(regions_layout.current_metric_region);
+            if (regions_layout.current_data_region != data_region)
+            {
+                SharedMemory::Remove(regions_layout.current_data_region);
+            }
+        }
     }
+    util::SimpleLogger().Write() << "All data loaded.";
 
-    // Allocate a memory layout in shared memory
-    auto layout_memory = makeSharedMemory(layout_region, sizeof(SharedDataLayout), true);
-    auto shared_layout_ptr = new (layout_memory->Ptr()) SharedDataLayout();
+    return ReturnCode::Ok;
+}
+
+void Storage::Populate(SharedDataLayout *shared_layout_ptr,
+                       const AllocateData &allocate_data,
+                       const AllocateData &allocate_metric)
+{
     auto absolute_file_index_path = boost::filesystem::absolute(config.file_index_path);
 
     shared_layout_ptr->SetBlockSize<char>(SharedDataLayout::FILE_INDEX_PATH,
@@ -250,18 +900,19 @@ Storage::ReturnCode Storage::Run(int max_wait)
     shared_layout_ptr->SetBlockSize<EntryClassID>(SharedDataLayout::ENTRY_CLASSID,
                                                   number_of_original_edges);
 
-    boost::filesystem::ifstream hsgr_input_stream(config.hsgr_data_path, std::ios::binary);
-    if (!hsgr_input_stream)
+    setMetricBlockSizes(*shared_layout_ptr, config, weight_offsets);
+
+    // the data of the edge-based nodes that the segments in the r-tree leave out
+    boost::filesystem::ifstream edge_based_nodes_input_stream(config.edge_based_nodes_data_path,
+                                                              std::ios::binary);
+    if (!util::readAndCheckFingerprint(edge_based_nodes_input_stream))
     {
-        throw util::exception("Could not open " + config.hsgr_data_path.string() + " for reading.");
+        throw util::exception("Fingerprint of " + config.edge_based_nodes_data_path.string() +
+                              " does not match or could not read from file");
     }
-
-    const auto hsgr_header = io::readHSGRHeader(hsgr_input_stream);
-    shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::HSGR_CHECKSUM, 1);
-    shared_layout_ptr->SetBlockSize<QueryGraph::NodeArrayEntry>(SharedDataLayout::GRAPH_NODE_LIST,
-                                                                hsgr_header.number_of_nodes);
-    shared_layout_ptr->SetBlockSize<QueryGraph::EdgeArrayEntry>(SharedDataLayout::GRAPH_EDGE_LIST,
-                                                                hsgr_header.number_of_edges);
+    const auto number_of_edge_based_nodes = io::readElementCount(edge_based_nodes_input_stream);
+    shared_layout_ptr->SetBlockSize<extractor::EdgeBasedNodeData>(
+        SharedDataLayout::EDGE_BASED_NODE_DATA, number_of_edge_based_nodes);
 
     // load rsearch tree size
     boost::filesystem::ifstream tree_node_file(config.ram_index_path, std::ios::binary);
@@ -283,18 +934,6 @@ Storage::ReturnCode Storage::Run(int max_wait)
     const auto timestamp_size = io::readNumberOfBytes(timestamp_stream);
     shared_layout_ptr->SetBlockSize<char>(SharedDataLayout::TIMESTAMP, timestamp_size);
 
-    // load core marker size
-    boost::filesystem::ifstream core_marker_file(config.core_data_path, std::ios::binary);
-    if (!core_marker_file)
-    {
-        throw util::exception("Could not open " + config.core_data_path.string() + " for reading.");
-    }
-
-    uint32_t number_of_core_markers = 0;
-    core_marker_file.read((char *)&number_of_core_markers, sizeof(uint32_t));
-    shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::CORE_MARKER,
-                                              number_of_core_markers);
-
     // load coordinate size
     boost::filesystem::ifstream nodes_input_stream(config.nodes_data_path, std::ios::binary);
     if (!nodes_input_stream)
@@ -302,8 +941,28 @@ Storage::ReturnCode Storage::Run(int max_wait)
         throw util::exception("Could not open " + config.core_data_path.string() + " for reading.");
     }
     const auto coordinate_list_size = io::readElementCount(nodes_input_stream);
-    shared_layout_ptr->SetBlockSize<util::Coordinate>(SharedDataLayout::COORDINATE_LIST,
-                                                      coordinate_list_size);
+    shared_layout_ptr->SetBlockSize<std::uint64_t>(SharedDataLayout::NUMBER_OF_COORDINATES, 1);
+    if (compress_coordinates)
+    {
+        // a first pass over the nodes sizes the compressed blocks
+        const auto nodes_position = nodes_input_stream.tellg();
+        const auto encoder =
+            io::countCompressedCoordinates(nodes_input_stream, coordinate_list_size);
+        nodes_input_stream.seekg(nodes_position);
+        shared_layout_ptr->SetBlockSize<util::Coordinate>(SharedDataLayout::COORDINATE_LIST, 0);
+        shared_layout_ptr->SetBlockSize<util::CoordinateBlock>(SharedDataLayout::COORDINATE_BLOCKS,
+                                                               encoder.GetNumberOfBlocks());
+        shared_layout_ptr->SetBlockSize<std::uint8_t>(SharedDataLayout::COORDINATE_DELTAS,
+                                                      encoder.GetNumberOfBytes());
+    }
+    else
+    {
+        shared_layout_ptr->SetBlockSize<util::Coordinate>(SharedDataLayout::COORDINATE_LIST,
+                                                          coordinate_list_size);
+        shared_layout_ptr->SetBlockSize<util::CoordinateBlock>(SharedDataLayout::COORDINATE_BLOCKS,
+                                                               0);
+        shared_layout_ptr->SetBlockSize<std::uint8_t>(SharedDataLayout::COORDINATE_DELTAS, 0);
+    }
     // we'll read a list of OSM node IDs from the same data, so set the block size for the same
     // number of items:
     shared_layout_ptr->SetBlockSize<std::uint64_t>(
@@ -311,61 +970,54 @@ Storage::ReturnCode Storage::Run(int max_wait)
         util::PackedVector<OSMNodeID>::elements_to_blocks(coordinate_list_size));
 
     // load geometries sizes
-    boost::filesystem::ifstream geometry_input_stream(config.geometries_path, std::ios::binary);
-    if (!geometry_input_stream)
-    {
-        throw util::exception("Could not open " + config.geometries_path.string() +
-                              " for reading.");
-    }
-    unsigned number_of_geometries_indices = 0;
-    unsigned number_of_compressed_geometries = 0;
-
-    geometry_input_stream.read((char *)&number_of_geometries_indices, sizeof(unsigned));
+    io::BulkReader geometry_reader(config.geometries_path);
+    const auto number_of_geometries_indices = geometry_reader.Read<unsigned>(0);
     shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::GEOMETRIES_INDEX,
                                               number_of_geometries_indices);
-    boost::iostreams::seek(
-        geometry_input_stream, number_of_geometries_indices * sizeof(unsigned), BOOST_IOS::cur);
-    geometry_input_stream.read((char *)&number_of_compressed_geometries, sizeof(unsigned));
-    shared_layout_ptr->SetBlockSize<NodeID>(SharedDataLayout::GEOMETRIES_NODE_LIST,
-                                            number_of_compressed_geometries);
-    shared_layout_ptr->SetBlockSize<EdgeWeight>(SharedDataLayout::GEOMETRIES_FWD_WEIGHT_LIST,
-                                                number_of_compressed_geometries);
-    shared_layout_ptr->SetBlockSize<EdgeWeight>(SharedDataLayout::GEOMETRIES_REV_WEIGHT_LIST,
+    const auto geometry_nodes_offset =
+        (1 + std::uint64_t{number_of_geometries_indices}) * sizeof(unsigned);
+    const auto number_of_compressed_geometries =
+        geometry_reader.Read<unsigned>(geometry_nodes_offset);
+    if (compress_geometries)
+    {
+        // a first pass over the nodes sizes the compressed blocks
+        util::GeometryNodeEncoder counter;
+        io::readGeometryNodes(geometry_reader,
+                              geometry_nodes_offset + sizeof(unsigned),
+                              number_of_compressed_geometries,
+                              counter);
+        shared_layout_ptr->SetBlockSize<NodeID>(SharedDataLayout::GEOMETRIES_NODE_LIST, 0);
+        shared_layout_ptr->SetBlockSize<util::GeometryNodeBlock>(
+            SharedDataLayout::GEOMETRIES_NODE_BLOCKS, counter.GetNumberOfBlocks());
+        shared_layout_ptr->SetBlockSize<std::uint8_t>(SharedDataLayout::GEOMETRIES_NODE_DELTAS,
+                                                      counter.GetNumberOfBytes());
+    }
+    else
+    {
+        shared_layout_ptr->SetBlockSize<NodeID>(SharedDataLayout::GEOMETRIES_NODE_LIST,
                                                 number_of_compressed_geometries);
+        shared_layout_ptr->SetBlockSize<util::GeometryNodeBlock>(
+            SharedDataLayout::GEOMETRIES_NODE_BLOCKS, 0);
+        shared_layout_ptr->SetBlockSize<std::uint8_t>(SharedDataLayout::GEOMETRIES_NODE_DELTAS, 0);
+    }
 
-    // load datasource sizes.  This file is optional, and it's non-fatal if it doesn't
-    // exist.
-    boost::filesystem::ifstream geometry_datasource_input_stream(config.datasource_indexes_path,
-                                                                 std::ios::binary);
-    if (!geometry_datasource_input_stream)
+    // The segment lengths are optional, without them they are computed from the coordinates
+    std::unique_ptr<io::BulkReader> segment_lengths_reader;
+    if (boost::filesystem::exists(config.segment_lengths_path))
     {
-        throw util::exception("Could not open " + config.datasource_indexes_path.string() +
-                              " for reading.");
+        segment_lengths_reader = std::make_unique<io::BulkReader>(config.segment_lengths_path);
     }
-    const auto number_of_compressed_datasources =
-        io::readElementCount(geometry_datasource_input_stream);
-    shared_layout_ptr->SetBlockSize<uint8_t>(SharedDataLayout::DATASOURCES_LIST,
-                                             number_of_compressed_datasources);
-
-    // Load datasource name sizes.  This file is optional, and it's non-fatal if it doesn't
-    // exist
-
-    boost::filesystem::ifstream datasource_names_input_stream(config.datasource_names_path,
-                                                              std::ios::binary);
-    if (!datasource_names_input_stream)
+    const std::uint64_t number_of_segment_lengths =
+        segment_lengths_reader ? segment_lengths_reader->Read<std::uint64_t>(0) : 0;
+    if (number_of_segment_lengths != 0 &&
+        number_of_segment_lengths != number_of_compressed_geometries)
     {
-        throw util::exception("Could not open " + config.datasource_names_path.string() +
-                              " for reading.");
+        throw util::exception(config.segment_lengths_path.string() +
+                              " does not match the geometries of the dataset.");
     }
-    const io::DatasourceNamesData datasource_names_data =
-        io::readDatasourceNames(datasource_names_input_stream);
+    shared_layout_ptr->SetBlockSize<SegmentLength>(SharedDataLayout::GEOMETRIES_LENGTH_LIST,
+                                                   number_of_segment_lengths);
 
-    shared_layout_ptr->SetBlockSize<char>(SharedDataLayout::DATASOURCE_NAME_DATA,
-                                          datasource_names_data.names.size());
-    shared_layout_ptr->SetBlockSize<std::size_t>(SharedDataLayout::DATASOURCE_NAME_OFFSETS,
-                                                 datasource_names_data.offsets.size());
-    shared_layout_ptr->SetBlockSize<std::size_t>(SharedDataLayout::DATASOURCE_NAME_LENGTHS,
-                                                 datasource_names_data.lengths.size());
     boost::filesystem::ifstream intersection_stream(config.intersection_class_path,
                                                     std::ios::binary);
 
@@ -436,391 +1088,505 @@ Storage::ReturnCode Storage::Run(int max_wait)
     shared_layout_ptr->SetBlockSize<util::guidance::EntryClass>(SharedDataLayout::ENTRY_CLASS,
                                                                 entry_class_table.size());
 
-    // allocate shared memory block
-    util::SimpleLogger().Write() << "allocating shared memory of "
-                                 << shared_layout_ptr->GetSizeOfLayout() << " bytes";
-    auto shared_memory = makeSharedMemory(data_region, shared_layout_ptr->GetSizeOfLayout(), true);
-    char *shared_memory_ptr = static_cast<char *>(shared_memory->Ptr());
+    // allocate the data blocks, without data blocks only the metric is loaded
+    char *shared_memory_ptr = allocate_data(*shared_layout_ptr);
+    char *metric_memory_ptr = allocate_metric(*shared_layout_ptr);
 
     // read actual data into shared memory object //
 
-    // hsgr checksum
-    unsigned *checksum_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-        shared_memory_ptr, SharedDataLayout::HSGR_CHECKSUM);
-    *checksum_ptr = hsgr_header.checksum;
-
-    // ram index file name
-    char *file_index_path_ptr = shared_layout_ptr->GetBlockPtr<char, true>(
-        shared_memory_ptr, SharedDataLayout::FILE_INDEX_PATH);
-    // make sure we have 0 ending
-    std::fill(file_index_path_ptr,
-              file_index_path_ptr +
-                  shared_layout_ptr->GetBlockSize(SharedDataLayout::FILE_INDEX_PATH),
-              0);
-    std::copy(absolute_file_index_path.string().begin(),
-              absolute_file_index_path.string().end(),
-              file_index_path_ptr);
-
-    // Loading street names
-    unsigned *name_offsets_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-        shared_memory_ptr, SharedDataLayout::NAME_OFFSETS);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_OFFSETS) > 0)
-    {
-        name_stream.read((char *)name_offsets_ptr,
-                         shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_OFFSETS));
-    }
-
-    unsigned *name_blocks_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-        shared_memory_ptr, SharedDataLayout::NAME_BLOCKS);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_BLOCKS) > 0)
-    {
-        name_stream.read((char *)name_blocks_ptr,
-                         shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_BLOCKS));
-    }
-
-    char *name_char_ptr = shared_layout_ptr->GetBlockPtr<char, true>(
-        shared_memory_ptr, SharedDataLayout::NAME_CHAR_LIST);
-    unsigned temp_length = 0;
-    name_stream.read((char *)&temp_length, sizeof(unsigned));
-
-    BOOST_ASSERT_MSG(shared_layout_ptr->AlignBlockSize(temp_length) ==
-                         shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_CHAR_LIST),
-                     "Name file corrupted!");
-
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_CHAR_LIST) > 0)
-    {
-        name_stream.read(name_char_ptr,
-                         shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_CHAR_LIST));
-    }
-    name_stream.close();
-
-    // make sure do write canary...
-    auto *turn_lane_data_ptr =
-        shared_layout_ptr->GetBlockPtr<util::guidance::LaneTupleIdPair, true>(
-            shared_memory_ptr, SharedDataLayout::TURN_LANE_DATA);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::TURN_LANE_DATA) > 0)
-    {
-        lane_data_stream.read(reinterpret_cast<char *>(turn_lane_data_ptr),
-                              shared_layout_ptr->GetBlockSize(SharedDataLayout::TURN_LANE_DATA));
-    }
-    lane_data_stream.close();
-
-    auto *turn_lane_offset_ptr = shared_layout_ptr->GetBlockPtr<std::uint32_t, true>(
-        shared_memory_ptr, SharedDataLayout::LANE_DESCRIPTION_OFFSETS);
-    if (!lane_description_offsets.empty())
-    {
-        BOOST_ASSERT(shared_layout_ptr->GetBlockSize(SharedDataLayout::LANE_DESCRIPTION_OFFSETS) >=
-                     sizeof(lane_description_offsets[0]) * lane_description_offsets.size());
-        std::copy(
-            lane_description_offsets.begin(), lane_description_offsets.end(), turn_lane_offset_ptr);
-        std::vector<std::uint32_t> tmp;
-        lane_description_offsets.swap(tmp);
-    }
+    const auto load_names = [&] {
+        // Loading street names
+        unsigned *name_offsets_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+            shared_memory_ptr, SharedDataLayout::NAME_OFFSETS);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_OFFSETS) > 0)
+        {
+            name_stream.read((char *)name_offsets_ptr,
+                             shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_OFFSETS));
+        }
 
-    auto *turn_lane_mask_ptr =
-        shared_layout_ptr->GetBlockPtr<extractor::guidance::TurnLaneType::Mask, true>(
-            shared_memory_ptr, SharedDataLayout::LANE_DESCRIPTION_MASKS);
-    if (!lane_description_masks.empty())
-    {
-        BOOST_ASSERT(shared_layout_ptr->GetBlockSize(SharedDataLayout::LANE_DESCRIPTION_MASKS) >=
-                     sizeof(lane_description_masks[0]) * lane_description_masks.size());
-        std::copy(lane_description_masks.begin(), lane_description_masks.end(), turn_lane_mask_ptr);
-        std::vector<extractor::guidance::TurnLaneType::Mask> tmp;
-        lane_description_masks.swap(tmp);
-    }
+        unsigned *name_blocks_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+            shared_memory_ptr, SharedDataLayout::NAME_BLOCKS);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_BLOCKS) > 0)
+        {
+            name_stream.read((char *)name_blocks_ptr,
+                             shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_BLOCKS));
+        }
 
-    // load original edge information
-    GeometryID *via_geometry_ptr = shared_layout_ptr->GetBlockPtr<GeometryID, true>(
-        shared_memory_ptr, SharedDataLayout::VIA_NODE_LIST);
+        char *name_char_ptr = shared_layout_ptr->GetBlockPtr<char, true>(
+            shared_memory_ptr, SharedDataLayout::NAME_CHAR_LIST);
+        unsigned temp_length = 0;
+        name_stream.read((char *)&temp_length, sizeof(unsigned));
 
-    unsigned *name_id_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-        shared_memory_ptr, SharedDataLayout::NAME_ID_LIST);
+        BOOST_ASSERT_MSG(shared_layout_ptr->AlignBlockSize(temp_length) ==
+                             shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_CHAR_LIST),
+                         "Name file corrupted!");
 
-    extractor::TravelMode *travel_mode_ptr =
-        shared_layout_ptr->GetBlockPtr<extractor::TravelMode, true>(shared_memory_ptr,
-                                                                    SharedDataLayout::TRAVEL_MODE);
-    util::guidance::TurnBearing *pre_turn_bearing_ptr =
-        shared_layout_ptr->GetBlockPtr<util::guidance::TurnBearing, true>(
-            shared_memory_ptr, SharedDataLayout::PRE_TURN_BEARING);
-    util::guidance::TurnBearing *post_turn_bearing_ptr =
-        shared_layout_ptr->GetBlockPtr<util::guidance::TurnBearing, true>(
-            shared_memory_ptr, SharedDataLayout::POST_TURN_BEARING);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_CHAR_LIST) > 0)
+        {
+            name_stream.read(name_char_ptr,
+                             shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_CHAR_LIST));
+        }
+        name_stream.close();
+    };
+
+    const auto load_turn_lanes = [&] {
+        // make sure do write canary...
+        auto *turn_lane_data_ptr =
+            shared_layout_ptr->GetBlockPtr<util::guidance::LaneTupleIdPair, true>(
+                shared_memory_ptr, SharedDataLayout::TURN_LANE_DATA);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::TURN_LANE_DATA) > 0)
+        {
+            lane_data_stream.read(
+                reinterpret_cast<char *>(turn_lane_data_ptr),
+                shared_layout_ptr->GetBlockSize(SharedDataLayout::TURN_LANE_DATA));
+        }
+        lane_data_stream.close();
 
-    LaneDataID *lane_data_id_ptr = shared_layout_ptr->GetBlockPtr<LaneDataID, true>(
-        shared_memory_ptr, SharedDataLayout::LANE_DATA_ID);
+        auto *turn_lane_offset_ptr = shared_layout_ptr->GetBlockPtr<std::uint32_t, true>(
+            shared_memory_ptr, SharedDataLayout::LANE_DESCRIPTION_OFFSETS);
+        if (!lane_description_offsets.empty())
+        {
+            BOOST_ASSERT(
+                shared_layout_ptr->GetBlockSize(SharedDataLayout::LANE_DESCRIPTION_OFFSETS) >=
+                sizeof(lane_description_offsets[0]) * lane_description_offsets.size());
+            std::copy(lane_description_offsets.begin(),
+                      lane_description_offsets.end(),
+                      turn_lane_offset_ptr);
+            std::vector<std::uint32_t> tmp;
+            lane_description_offsets.swap(tmp);
+        }
 
-    extractor::guidance::TurnInstruction *turn_instructions_ptr =
-        shared_layout_ptr->GetBlockPtr<extractor::guidance::TurnInstruction, true>(
-            shared_memory_ptr, SharedDataLayout::TURN_INSTRUCTION);
+        auto *turn_lane_mask_ptr =
+            shared_layout_ptr->GetBlockPtr<extractor::guidance::TurnLaneType::Mask, true>(
+                shared_memory_ptr, SharedDataLayout::LANE_DESCRIPTION_MASKS);
+        if (!lane_description_masks.empty())
+        {
+            BOOST_ASSERT(
+                shared_layout_ptr->GetBlockSize(SharedDataLayout::LANE_DESCRIPTION_MASKS) >=
+                sizeof(lane_description_masks[0]) * lane_description_masks.size());
+            std::copy(
+                lane_description_masks.begin(), lane_description_masks.end(), turn_lane_mask_ptr);
+            std::vector<extractor::guidance::TurnLaneType::Mask> tmp;
+            lane_description_masks.swap(tmp);
+        }
+    };
+
+    const auto load_edges = [&] {
+        // load original edge information
+        GeometryID *via_geometry_ptr = shared_layout_ptr->GetBlockPtr<GeometryID, true>(
+            shared_memory_ptr, SharedDataLayout::VIA_NODE_LIST);
+
+        unsigned *name_id_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+            shared_memory_ptr, SharedDataLayout::NAME_ID_LIST);
+
+        extractor::TravelMode *travel_mode_ptr =
+            shared_layout_ptr->GetBlockPtr<extractor::TravelMode, true>(
+                shared_memory_ptr, SharedDataLayout::TRAVEL_MODE);
+        util::guidance::TurnBearing *pre_turn_bearing_ptr =
+            shared_layout_ptr->GetBlockPtr<util::guidance::TurnBearing, true>(
+                shared_memory_ptr, SharedDataLayout::PRE_TURN_BEARING);
+        util::guidance::TurnBearing *post_turn_bearing_ptr =
+            shared_layout_ptr->GetBlockPtr<util::guidance::TurnBearing, true>(
+                shared_memory_ptr, SharedDataLayout::POST_TURN_BEARING);
+
+        LaneDataID *lane_data_id_ptr = shared_layout_ptr->GetBlockPtr<LaneDataID, true>(
+            shared_memory_ptr, SharedDataLayout::LANE_DATA_ID);
+
+        extractor::guidance::TurnInstruction *turn_instructions_ptr =
+            shared_layout_ptr->GetBlockPtr<extractor::guidance::TurnInstruction, true>(
+                shared_memory_ptr, SharedDataLayout::TURN_INSTRUCTION);
+
+        EntryClassID *entry_class_id_ptr = shared_layout_ptr->GetBlockPtr<EntryClassID, true>(
+            shared_memory_ptr, SharedDataLayout::ENTRY_CLASSID);
+
+        io::readEdges(edges_input_stream,
+                      via_geometry_ptr,
+                      name_id_ptr,
+                      turn_instructions_ptr,
+                      lane_data_id_ptr,
+                      travel_mode_ptr,
+                      entry_class_id_ptr,
+                      pre_turn_bearing_ptr,
+                      post_turn_bearing_ptr,
+                      number_of_original_edges);
+        edges_input_stream.close();
+    };
+
+    const auto load_geometries = [&] {
+        // load compressed geometry, the index and the nodes are read at once
+        unsigned *geometries_index_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+            shared_memory_ptr, SharedDataLayout::GEOMETRIES_INDEX);
+        geometry_reader.Queue(sizeof(unsigned),
+                              geometries_index_ptr,
+                              number_of_geometries_indices * sizeof(unsigned));
+
+        if (compress_geometries)
+        {
+            util::GeometryNodeEncoder encoder(
+                shared_layout_ptr->GetBlockPtr<util::GeometryNodeBlock, true>(
+                    shared_memory_ptr, SharedDataLayout::GEOMETRIES_NODE_BLOCKS),
+                shared_layout_ptr->GetBlockPtr<std::uint8_t, true>(
+                    shared_memory_ptr, SharedDataLayout::GEOMETRIES_NODE_DELTAS));
+            io::readGeometryNodes(geometry_reader,
+                                  geometry_nodes_offset + sizeof(unsigned),
+                                  number_of_compressed_geometries,
+                                  encoder);
+            BOOST_ASSERT(encoder.GetNumberOfBytes() ==
+                         shared_layout_ptr->num_entries[SharedDataLayout::GEOMETRIES_NODE_DELTAS]);
+        }
+        else
+        {
+            NodeID *geometries_node_id_list_ptr = shared_layout_ptr->GetBlockPtr<NodeID, true>(
+                shared_memory_ptr, SharedDataLayout::GEOMETRIES_NODE_LIST);
+            geometry_reader.Queue(geometry_nodes_offset + sizeof(unsigned),
+                                  geometries_node_id_list_ptr,
+                                  number_of_compressed_geometries * sizeof(NodeID));
+        }
+        geometry_reader.Wait();
+    };
 
-    EntryClassID *entry_class_id_ptr = shared_layout_ptr->GetBlockPtr<EntryClassID, true>(
-        shared_memory_ptr, SharedDataLayout::ENTRY_CLASSID);
+    const auto load_segment_lengths = [&] {
+        SegmentLength *segment_lengths_ptr = shared_layout_ptr->GetBlockPtr<SegmentLength, true>(
+            shared_memory_ptr, SharedDataLayout::GEOMETRIES_LENGTH_LIST);
+        if (number_of_segment_lengths > 0)
+        {
+            io::readSegmentLengths(
+                *segment_lengths_reader, segment_lengths_ptr, number_of_segment_lengths);
+        }
+    };
+
+    const auto load_nodes = [&] {
+        // Loading list of coordinates
+        util::Coordinate *coordinates_ptr = shared_layout_ptr->GetBlockPtr<util::Coordinate, true>(
+            shared_memory_ptr, SharedDataLayout::COORDINATE_LIST);
+        auto number_of_coordinates_ptr = shared_layout_ptr->GetBlockPtr<std::uint64_t, true>(
+            shared_memory_ptr, SharedDataLayout::NUMBER_OF_COORDINATES);
+        *number_of_coordinates_ptr = coordinate_list_size;
+        auto coordinate_blocks_ptr = shared_layout_ptr->GetBlockPtr<util::CoordinateBlock, true>(
+            shared_memory_ptr, SharedDataLayout::COORDINATE_BLOCKS);
+        auto coordinate_deltas_ptr = shared_layout_ptr->GetBlockPtr<std::uint8_t, true>(
+            shared_memory_ptr, SharedDataLayout::COORDINATE_DELTAS);
+        std::uint64_t *osmnodeid_ptr = shared_layout_ptr->GetBlockPtr<std::uint64_t, true>(
+            shared_memory_ptr, SharedDataLayout::OSM_NODE_ID_LIST);
+        util::PackedVector<OSMNodeID, true> osmnodeid_list;
+        osmnodeid_list.reset(osmnodeid_ptr,
+                             shared_layout_ptr->num_entries[SharedDataLayout::OSM_NODE_ID_LIST]);
+        if (compress_coordinates)
+        {
+            util::CoordinateEncoder encoder(coordinate_blocks_ptr, coordinate_deltas_ptr);
+            io::readCompressedNodes(
+                nodes_input_stream, encoder, osmnodeid_list, coordinate_list_size);
+        }
+        else
+        {
+            io::readNodes(
+                nodes_input_stream, coordinates_ptr, osmnodeid_list, coordinate_list_size);
+        }
+        nodes_input_stream.close();
+    };
+
+    const auto load_edge_based_nodes = [&] {
+        auto node_data_ptr = shared_layout_ptr->GetBlockPtr<extractor::EdgeBasedNodeData, true>(
+            shared_memory_ptr, SharedDataLayout::EDGE_BASED_NODE_DATA);
+        edge_based_nodes_input_stream.read(reinterpret_cast<char *>(node_data_ptr),
+                                           number_of_edge_based_nodes *
+                                               sizeof(extractor::EdgeBasedNodeData));
+        edge_based_nodes_input_stream.close();
+    };
+
+    const auto load_search_tree = [&] {
+        // store search tree portion of rtree
+        RTreeNode *rtree_ptrtest = shared_layout_ptr->GetBlockPtr<RTreeNode, true>(
+            shared_memory_ptr, SharedDataLayout::R_SEARCH_TREE);
+        io::readRamIndex(tree_node_file, rtree_ptrtest, tree_size);
+    };
+
+    const auto load_metadata = [&] {
+        // ram index file name
+        char *file_index_path_ptr = shared_layout_ptr->GetBlockPtr<char, true>(
+            shared_memory_ptr, SharedDataLayout::FILE_INDEX_PATH);
+        // make sure we have 0 ending
+        std::fill(file_index_path_ptr,
+                  file_index_path_ptr +
+                      shared_layout_ptr->GetBlockSize(SharedDataLayout::FILE_INDEX_PATH),
+                  0);
+        std::copy(absolute_file_index_path.string().begin(),
+                  absolute_file_index_path.string().end(),
+                  file_index_path_ptr);
+
+        // store timestamp
+        char *timestamp_ptr = shared_layout_ptr->GetBlockPtr<char, true>(
+            shared_memory_ptr, SharedDataLayout::TIMESTAMP);
+        io::readTimestamp(timestamp_stream, timestamp_ptr, timestamp_size);
+
+        // load profile properties
+        extractor::ProfileProperties *profile_properties_ptr =
+            shared_layout_ptr->GetBlockPtr<extractor::ProfileProperties, true>(
+                shared_memory_ptr, SharedDataLayout::PROPERTIES);
+        boost::filesystem::ifstream profile_properties_stream(config.properties_path);
+        if (!profile_properties_stream)
+        {
+            util::exception("Could not open " + config.properties_path.string() + " for reading!");
+        }
+        io::readProperties(profile_properties_stream,
+                           profile_properties_ptr,
+                           sizeof(extractor::ProfileProperties));
+    };
+
+    const auto load_intersection_classes = [&] {
+        // load intersection classes
+        if (!bearing_class_id_table.empty())
+        {
+            auto bearing_id_ptr = shared_layout_ptr->GetBlockPtr<BearingClassID, true>(
+                shared_memory_ptr, SharedDataLayout::BEARING_CLASSID);
+            std::copy(bearing_class_id_table.begin(), bearing_class_id_table.end(), bearing_id_ptr);
+        }
 
-    io::readEdges(edges_input_stream,
-                  via_geometry_ptr,
-                  name_id_ptr,
-                  turn_instructions_ptr,
-                  lane_data_id_ptr,
-                  travel_mode_ptr,
-                  entry_class_id_ptr,
-                  pre_turn_bearing_ptr,
-                  post_turn_bearing_ptr,
-                  number_of_original_edges);
-    edges_input_stream.close();
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::BEARING_OFFSETS) > 0)
+        {
+            auto *bearing_offsets_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+                shared_memory_ptr, SharedDataLayout::BEARING_OFFSETS);
+            std::copy(
+                bearing_offsets_data.begin(), bearing_offsets_data.end(), bearing_offsets_ptr);
+        }
 
-    // load compressed geometry
-    unsigned temporary_value;
-    unsigned *geometries_index_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-        shared_memory_ptr, SharedDataLayout::GEOMETRIES_INDEX);
-    geometry_input_stream.seekg(0, geometry_input_stream.beg);
-    geometry_input_stream.read((char *)&temporary_value, sizeof(unsigned));
-    BOOST_ASSERT(temporary_value ==
-                 shared_layout_ptr->num_entries[SharedDataLayout::GEOMETRIES_INDEX]);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::BEARING_BLOCKS) > 0)
+        {
+            auto *bearing_blocks_ptr =
+                shared_layout_ptr->GetBlockPtr<typename util::RangeTable<16, true>::BlockT, true>(
+                    shared_memory_ptr, SharedDataLayout::BEARING_BLOCKS);
+            std::copy(bearing_blocks_data.begin(), bearing_blocks_data.end(), bearing_blocks_ptr);
+        }
 
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_INDEX) > 0)
-    {
-        geometry_input_stream.read(
-            (char *)geometries_index_ptr,
-            shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_INDEX));
-    }
-    NodeID *geometries_node_id_list_ptr = shared_layout_ptr->GetBlockPtr<NodeID, true>(
-        shared_memory_ptr, SharedDataLayout::GEOMETRIES_NODE_LIST);
+        if (!bearing_class_table.empty())
+        {
+            auto bearing_class_ptr = shared_layout_ptr->GetBlockPtr<DiscreteBearing, true>(
+                shared_memory_ptr, SharedDataLayout::BEARING_VALUES);
+            std::copy(bearing_class_table.begin(), bearing_class_table.end(), bearing_class_ptr);
+        }
 
-    geometry_input_stream.read((char *)&temporary_value, sizeof(unsigned));
-    BOOST_ASSERT(temporary_value ==
-                 shared_layout_ptr->num_entries[SharedDataLayout::GEOMETRIES_NODE_LIST]);
+        if (!entry_class_table.empty())
+        {
+            auto entry_class_ptr = shared_layout_ptr->GetBlockPtr<util::guidance::EntryClass, true>(
+                shared_memory_ptr, SharedDataLayout::ENTRY_CLASS);
+            std::copy(entry_class_table.begin(), entry_class_table.end(), entry_class_ptr);
+        }
+    };
 
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_NODE_LIST) > 0)
-    {
-        geometry_input_stream.read(
-            (char *)geometries_node_id_list_ptr,
-            shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_NODE_LIST));
-    }
-    EdgeWeight *geometries_fwd_weight_list_ptr = shared_layout_ptr->GetBlockPtr<EdgeWeight, true>(
-        shared_memory_ptr, SharedDataLayout::GEOMETRIES_FWD_WEIGHT_LIST);
+    const auto load_metric = [&] {
+        loadMetricBlocks(*shared_layout_ptr, metric_memory_ptr, config);
+    };
 
-    BOOST_ASSERT(temporary_value ==
-                 shared_layout_ptr->num_entries[SharedDataLayout::GEOMETRIES_FWD_WEIGHT_LIST]);
+    const auto compute_checksums = [&] {
+        TIMER_START(checksums);
+        shared_layout_ptr->ComputeChecksums(shared_memory_ptr, metric_memory_ptr);
+        TIMER_STOP(checksums);
+        util::SimpleLogger().Write() << "computed block checksums in " << TIMER_SEC(checksums)
+                                     << "s";
+    };
 
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_FWD_WEIGHT_LIST) > 0)
+    if (!shared_memory_ptr)
     {
-        geometry_input_stream.read(
-            (char *)geometries_fwd_weight_list_ptr,
-            shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_FWD_WEIGHT_LIST));
+        load_metric();
+        compute_checksums();
+        return;
     }
-    EdgeWeight *geometries_rev_weight_list_ptr = shared_layout_ptr->GetBlockPtr<EdgeWeight, true>(
-        shared_memory_ptr, SharedDataLayout::GEOMETRIES_REV_WEIGHT_LIST);
 
-    BOOST_ASSERT(temporary_value ==
-                 shared_layout_ptr->num_entries[SharedDataLayout::GEOMETRIES_REV_WEIGHT_LIST]);
+    tbb::parallel_invoke(reportProgress("names", load_names),
+                         reportProgress("turn lanes", load_turn_lanes),
+                         reportProgress("edges", load_edges),
+                         reportProgress("geometries", load_geometries),
+                         reportProgress("segment lengths", load_segment_lengths),
+                         reportProgress("nodes", load_nodes),
+                         reportProgress("edge-based nodes", load_edge_based_nodes),
+                         reportProgress("search tree", load_search_tree),
+                         reportProgress("metadata", load_metadata),
+                         reportProgress("intersection classes", load_intersection_classes),
+                         load_metric);
+    compute_checksums();
+}
 
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_REV_WEIGHT_LIST) > 0)
+void Storage::LoadContainer(SharedDataLayout *shared_layout_ptr,
+                            const AllocateData &allocate_data,
+                            const AllocateData &allocate_metric)
+{
+    util::SimpleLogger().Write() << "load container from: " << config.container_path;
+    boost::filesystem::ifstream container_stream(config.container_path, std::ios::binary);
+    if (!container_stream)
     {
-        geometry_input_stream.read(
-            (char *)geometries_rev_weight_list_ptr,
-            shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_REV_WEIGHT_LIST));
+        throw util::exception("Could not open " + config.container_path.string() +
+                              " for reading.");
     }
 
-    // load datasource information (if it exists)
-    uint8_t *datasources_list_ptr = shared_layout_ptr->GetBlockPtr<uint8_t, true>(
-        shared_memory_ptr, SharedDataLayout::DATASOURCES_LIST);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCES_LIST) > 0)
+    ContainerHeader header;
+    container_stream.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!container_stream || !util::checkFingerprint(header.fingerprint))
     {
-        io::readDatasourceIndexes(geometry_datasource_input_stream,
-                                  datasources_list_ptr,
-                                  number_of_compressed_datasources);
+        throw util::exception("Fingerprint of " + config.container_path.string() +
+                              " does not match or could not read from file");
     }
+    *shared_layout_ptr = header.layout;
 
-    // load datasource name information (if it exists)
-
-    char *datasource_name_data_ptr = shared_layout_ptr->GetBlockPtr<char, true>(
-        shared_memory_ptr, SharedDataLayout::DATASOURCE_NAME_DATA);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCE_NAME_DATA) > 0)
+    // the data and the metric block are stored as is, so a single read fills each
+    char *shared_memory_ptr = allocate_data(*shared_layout_ptr);
+    char *metric_memory_ptr = allocate_metric(*shared_layout_ptr);
+    container_stream.seekg(CONTAINER_DATA_OFFSET);
+    if (shared_memory_ptr)
     {
-        std::copy(datasource_names_data.names.begin(),
-                  datasource_names_data.names.end(),
-                  datasource_name_data_ptr);
+        container_stream.read(shared_memory_ptr, shared_layout_ptr->GetSizeOfLayout());
     }
-
-    auto datasource_name_offsets_ptr = shared_layout_ptr->GetBlockPtr<std::uint32_t, true>(
-        shared_memory_ptr, SharedDataLayout::DATASOURCE_NAME_OFFSETS);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCE_NAME_OFFSETS) > 0)
+    else
     {
-        std::copy(datasource_names_data.offsets.begin(),
-                  datasource_names_data.offsets.end(),
-                  datasource_name_offsets_ptr);
+        container_stream.seekg(shared_layout_ptr->GetSizeOfLayout(), std::ios::cur);
     }
-
-    auto datasource_name_lengths_ptr = shared_layout_ptr->GetBlockPtr<std::uint32_t, true>(
-        shared_memory_ptr, SharedDataLayout::DATASOURCE_NAME_LENGTHS);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCE_NAME_LENGTHS) > 0)
+    container_stream.read(metric_memory_ptr, shared_layout_ptr->GetSizeOfMetric());
+    if (!container_stream)
     {
-        std::copy(datasource_names_data.lengths.begin(),
-                  datasource_names_data.lengths.end(),
-                  datasource_name_lengths_ptr);
+        throw util::exception("Failed to read data from " + config.container_path.string());
     }
 
-    // Loading list of coordinates
-    util::Coordinate *coordinates_ptr = shared_layout_ptr->GetBlockPtr<util::Coordinate, true>(
-        shared_memory_ptr, SharedDataLayout::COORDINATE_LIST);
-    std::uint64_t *osmnodeid_ptr = shared_layout_ptr->GetBlockPtr<std::uint64_t, true>(
-        shared_memory_ptr, SharedDataLayout::OSM_NODE_ID_LIST);
-    util::PackedVector<OSMNodeID, true> osmnodeid_list;
-    osmnodeid_list.reset(osmnodeid_ptr,
-                         shared_layout_ptr->num_entries[SharedDataLayout::OSM_NODE_ID_LIST]);
-    io::readNodes(nodes_input_stream, coordinates_ptr, osmnodeid_list, coordinate_list_size);
-    nodes_input_stream.close();
-
-    // store timestamp
-    char *timestamp_ptr =
-        shared_layout_ptr->GetBlockPtr<char, true>(shared_memory_ptr, SharedDataLayout::TIMESTAMP);
-    io::readTimestamp(timestamp_stream, timestamp_ptr, timestamp_size);
-
-    // store search tree portion of rtree
-    RTreeNode *rtree_ptrtest = shared_layout_ptr->GetBlockPtr<RTreeNode, true>(
-        shared_memory_ptr, SharedDataLayout::R_SEARCH_TREE);
-    io::readRamIndex(tree_node_file, rtree_ptrtest, tree_size);
-
-    // load core markers
-    std::vector<char> unpacked_core_markers(number_of_core_markers);
-    core_marker_file.read((char *)unpacked_core_markers.data(),
-                          sizeof(char) * number_of_core_markers);
-
-    unsigned *core_marker_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-        shared_memory_ptr, SharedDataLayout::CORE_MARKER);
+    TIMER_START(verify);
+    shared_layout_ptr->VerifyChecksums(shared_memory_ptr, metric_memory_ptr);
+    TIMER_STOP(verify);
+    util::SimpleLogger().Write() << "verified block checksums in " << TIMER_SEC(verify) << "s";
+}
 
-    for (auto i = 0u; i < number_of_core_markers; ++i)
+void Storage::LoadPackage(SharedDataLayout *shared_layout_ptr,
+                          const AllocateData &allocate_data,
+                          const AllocateData &allocate_metric,
+                          const SharedDataLayout *current_layout,
+                          const char *current_data,
+                          const char *current_metric)
+{
+    util::SimpleLogger().Write() << "load package from: " << config.package_path;
+    PackageReader package_reader(config.package_path);
+    *shared_layout_ptr = package_reader.GetLayout();
+    if (package_reader.IsDelta())
     {
-        BOOST_ASSERT(unpacked_core_markers[i] == 0 || unpacked_core_markers[i] == 1);
-
-        if (unpacked_core_markers[i] == 1)
+        if (!current_layout)
         {
-            const unsigned bucket = i / 32;
-            const unsigned offset = i % 32;
-            const unsigned value = [&] {
-                unsigned return_value = 0;
-                if (0 != offset)
-                {
-                    return_value = core_marker_ptr[bucket];
-                }
-                return return_value;
-            }();
-
-            core_marker_ptr[bucket] = (value | (1u << offset));
+            throw util::exception("No dataset in shared memory to apply the delta package to");
         }
+        util::SimpleLogger().Write() << "applying the delta package to the current dataset";
     }
 
-    // load the nodes of the search graph
-    QueryGraph::NodeArrayEntry *graph_node_list_ptr =
-        shared_layout_ptr->GetBlockPtr<QueryGraph::NodeArrayEntry, true>(
-            shared_memory_ptr, SharedDataLayout::GRAPH_NODE_LIST);
-
-    // load the edges of the search graph
-    QueryGraph::EdgeArrayEntry *graph_edge_list_ptr =
-        shared_layout_ptr->GetBlockPtr<QueryGraph::EdgeArrayEntry, true>(
-            shared_memory_ptr, SharedDataLayout::GRAPH_EDGE_LIST);
-
-    io::readHSGR(hsgr_input_stream,
-                 graph_node_list_ptr,
-                 hsgr_header.number_of_nodes,
-                 graph_edge_list_ptr,
-                 hsgr_header.number_of_edges);
-    hsgr_input_stream.close();
-
-    // load profile properties
-    extractor::ProfileProperties *profile_properties_ptr =
-        shared_layout_ptr->GetBlockPtr<extractor::ProfileProperties, true>(
-            shared_memory_ptr, SharedDataLayout::PROPERTIES);
-    boost::filesystem::ifstream profile_properties_stream(config.properties_path);
-    if (!profile_properties_stream)
-    {
-        util::exception("Could not open " + config.properties_path.string() + " for reading!");
-    }
-    io::readProperties(
-        profile_properties_stream, profile_properties_ptr, sizeof(extractor::ProfileProperties));
+    // the frames are decompressed straight into shared memory and verified on the way
+    char *shared_memory_ptr = allocate_data(*shared_layout_ptr);
+    char *metric_memory_ptr = allocate_metric(*shared_layout_ptr);
+    TIMER_START(unpack);
+    package_reader.Read(shared_memory_ptr,
+                        metric_memory_ptr,
+                        PackageBase{current_layout, current_data, current_metric});
+    TIMER_STOP(unpack);
+    util::SimpleLogger().Write() << "unpacked and verified the blocks in " << TIMER_SEC(unpack)
+                                 << "s";
+}
 
-    // load intersection classes
-    if (!bearing_class_id_table.empty())
-    {
-        auto bearing_id_ptr = shared_layout_ptr->GetBlockPtr<BearingClassID, true>(
-            shared_memory_ptr, SharedDataLayout::BEARING_CLASSID);
-        std::copy(bearing_class_id_table.begin(), bearing_class_id_table.end(), bearing_id_ptr);
-    }
+void Storage::WriteContainer()
+{
+    BOOST_ASSERT_MSG(config.IsValid(), "Invalid storage config");
 
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::BEARING_OFFSETS) > 0)
-    {
-        auto *bearing_offsets_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-            shared_memory_ptr, SharedDataLayout::BEARING_OFFSETS);
-        std::copy(bearing_offsets_data.begin(), bearing_offsets_data.end(), bearing_offsets_ptr);
-    }
+    util::LogPolicy::GetInstance().Unmute();
 
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::BEARING_BLOCKS) > 0)
+    // write to a temporary file first, processes that map the old container keep using it
+    const boost::filesystem::path temporary_path = config.container_path.string() + ".tmp";
+    std::unique_ptr<boost::interprocess::mapped_region> region;
+    const auto allocate_file = [&](const SharedDataLayout &layout) {
+        const auto container_size =
+            CONTAINER_DATA_OFFSET + layout.GetSizeOfLayout() + layout.GetSizeOfMetric();
+        util::SimpleLogger().Write() << "writing container of " << container_size
+                                     << " bytes to: " << config.container_path;
+        {
+            boost::filesystem::ofstream container_stream(temporary_path,
+                                                         std::ios::binary | std::ios::trunc);
+            if (!container_stream)
+            {
+                throw util::exception("Could not open " + temporary_path.string() +
+                                      " for writing.");
+            }
+        }
+        boost::filesystem::resize_file(temporary_path, container_size);
+
+        boost::interprocess::file_mapping file(temporary_path.string().c_str(),
+                                               boost::interprocess::read_write);
+        region = std::make_unique<boost::interprocess::mapped_region>(
+            file, boost::interprocess::read_write);
+        return static_cast<char *>(region->get_address()) + CONTAINER_DATA_OFFSET;
+    };
+
+    // the metric block directly follows the data block
+    const auto allocate_metric = [&](const SharedDataLayout &layout) {
+        return static_cast<char *>(region->get_address()) + CONTAINER_DATA_OFFSET +
+               layout.GetSizeOfLayout();
+    };
+
+    SharedDataLayout layout;
+    Populate(&layout, allocate_file, allocate_metric);
+
+    auto header = static_cast<ContainerHeader *>(region->get_address());
+    header->fingerprint = util::FingerPrint::GetValid();
+    header->layout = layout;
+    if (!region->flush())
     {
-        auto *bearing_blocks_ptr =
-            shared_layout_ptr->GetBlockPtr<typename util::RangeTable<16, true>::BlockT, true>(
-                shared_memory_ptr, SharedDataLayout::BEARING_BLOCKS);
-        std::copy(bearing_blocks_data.begin(), bearing_blocks_data.end(), bearing_blocks_ptr);
+        throw util::exception("Could not write " + temporary_path.string());
     }
+    region.reset();
 
-    if (!bearing_class_table.empty())
-    {
-        auto bearing_class_ptr = shared_layout_ptr->GetBlockPtr<DiscreteBearing, true>(
-            shared_memory_ptr, SharedDataLayout::BEARING_VALUES);
-        std::copy(bearing_class_table.begin(), bearing_class_table.end(), bearing_class_ptr);
-    }
+    boost::filesystem::rename(temporary_path, config.container_path);
+    util::SimpleLogger().Write() << "All data written.";
+}
 
-    if (!entry_class_table.empty())
-    {
-        auto entry_class_ptr = shared_layout_ptr->GetBlockPtr<util::guidance::EntryClass, true>(
-            shared_memory_ptr, SharedDataLayout::ENTRY_CLASS);
-        std::copy(entry_class_table.begin(), entry_class_table.end(), entry_class_ptr);
-    }
+void Storage::WritePackage(const int level, const boost::filesystem::path &base_package)
+{
+    BOOST_ASSERT_MSG(config.IsValid(), "Invalid storage config");
 
-    auto data_type_memory = makeSharedMemory(CURRENT_REGIONS, sizeof(SharedDataTimestamp), true);
-    SharedDataTimestamp *data_timestamp_ptr =
-        static_cast<SharedDataTimestamp *>(data_type_memory->Ptr());
+    util::LogPolicy::GetInstance().Unmute();
 
+    // the regions are zeroed so that the padding of the blocks does not differ between packages
+    std::unique_ptr<char[]> data_memory;
+    std::unique_ptr<char[]> metric_memory;
+    const auto allocate_data = [&](const SharedDataLayout &layout) {
+        data_memory.reset(new char[layout.GetSizeOfLayout()]());
+        return data_memory.get();
+    };
+    const auto allocate_metric = [&](const SharedDataLayout &layout) {
+        metric_memory.reset(new char[layout.GetSizeOfMetric()]());
+        return metric_memory.get();
+    };
+
+    SharedDataLayout layout;
+    Populate(&layout, allocate_data, allocate_metric);
+
+    // a delta is made against the dataset of a full package
+    std::unique_ptr<PackageReader> base_reader;
+    std::unique_ptr<char[]> base_data_memory;
+    std::unique_ptr<char[]> base_metric_memory;
+    PackageBase base{nullptr, nullptr, nullptr};
+    if (!base_package.empty())
     {
-        boost::interprocess::scoped_lock<boost::interprocess::named_upgradable_mutex>
-            current_regions_exclusive_lock;
-
-        if (max_wait > 0)
+        util::SimpleLogger().Write() << "load base package from: " << base_package;
+        base_reader = std::make_unique<PackageReader>(base_package);
+        if (base_reader->IsDelta())
         {
-            util::SimpleLogger().Write() << "Waiting for " << max_wait
-                                         << " seconds to write new dataset timestamp";
-            auto end_time = boost::posix_time::microsec_clock::universal_time() +
-                            boost::posix_time::seconds(max_wait);
-            current_regions_exclusive_lock =
-                boost::interprocess::scoped_lock<boost::interprocess::named_upgradable_mutex>(
-                    std::move(current_regions_lock), end_time);
-
-            if (!current_regions_exclusive_lock.owns())
-            {
-                util::SimpleLogger().Write(logWARNING) << "Aquiring the lock timed out after "
-                                                       << max_wait
-                                                       << " seconds. Claiming the lock by force.";
-                current_regions_lock.unlock();
-                current_regions_lock.release();
-                storage::SharedBarriers::resetCurrentRegions();
-                return ReturnCode::Retry;
-            }
-        }
-        else
-        {
-            util::SimpleLogger().Write() << "Waiting to write new dataset timestamp";
-            current_regions_exclusive_lock =
-                boost::interprocess::scoped_lock<boost::interprocess::named_upgradable_mutex>(
-                    std::move(current_regions_lock));
+            throw util::exception("The base of a delta package has to be a full package");
         }
-
-        util::SimpleLogger().Write() << "Ok.";
-        data_timestamp_ptr->layout = layout_region;
-        data_timestamp_ptr->data = data_region;
-        data_timestamp_ptr->timestamp += 1;
+        const auto &base_layout = base_reader->GetLayout();
+        base_data_memory.reset(new char[base_layout.GetSizeOfLayout()]);
+        base_metric_memory.reset(new char[base_layout.GetSizeOfMetric()]);
+        base_reader->Read(base_data_memory.get(), base_metric_memory.get());
+        base = PackageBase{&base_layout, base_data_memory.get(), base_metric_memory.get()};
     }
-    util::SimpleLogger().Write() << "All data loaded.";
 
-    return ReturnCode::Ok;
+    util::SimpleLogger().Write() << "writing " << (base.layout ? "delta " : "") << "package of "
+                                 << layout.GetSizeOfLayout() + layout.GetSizeOfMetric()
+                                 << " bytes to: " << config.package_path;
+    TIMER_START(package);
+    const auto package_size = writePackage(
+        config.package_path, layout, data_memory.get(), metric_memory.get(), level, base);
+    TIMER_STOP(package);
+    util::SimpleLogger().Write() << "compressed to " << package_size << " bytes in "
+                                 << TIMER_SEC(package) << "s";
+    util::SimpleLogger().Write() << "All data written.";
 }
 }
 }
@@ -11,24 +11,59 @@ namespace storage
 StorageConfig::StorageConfig(const boost::filesystem::path &base)
     : ram_index_path{base.string() + ".ramIndex"}, file_index_path{base.string() + ".fileIndex"},
       hsgr_data_path{base.string() + ".hsgr"}, nodes_data_path{base.string() + ".nodes"},
-      edges_data_path{base.string() + ".edges"}, core_data_path{base.string() + ".core"},
-      geometries_path{base.string() + ".geometry"}, timestamp_path{base.string() + ".timestamp"},
+      edges_data_path{base.string() + ".edges"},
+      edge_based_nodes_data_path{base.string() + ".ebg_nodes"},
+      core_data_path{base.string() + ".core"},
+      node_renumbering_path{base.string() + ".renumbering"},
+      core_landmarks_path{base.string() + ".landmarks"},
+      geometries_path{base.string() + ".geometry"},
+      segment_lengths_path{base.string() + ".segment_lengths"},
+      timestamp_path{base.string() + ".timestamp"},
       datasource_names_path{base.string() + ".datasource_names"},
       datasource_indexes_path{base.string() + ".datasource_indexes"},
+      speed_profiles_path{base.string() + ".speed_profiles"},
       names_data_path{base.string() + ".names"}, properties_path{base.string() + ".properties"},
       intersection_class_path{base.string() + ".icd"}, turn_lane_data_path{base.string() + ".tld"},
-      turn_lane_description_path{base.string() + ".tls"}
+      turn_lane_description_path{base.string() + ".tls"},
+      container_path{base.string() + ".container"}, package_path{base.string() + ".package"},
+      mld_graph_path{base.string() + ".mldgr"}
 {
 }
 
+namespace
+{
+// <base>.hsgr becomes <base>.<metric>.hsgr
+boost::filesystem::path metricPath(const boost::filesystem::path &path, const std::string &metric)
+{
+    return path.parent_path() / (path.stem().string() + "." + metric + path.extension().string());
+}
+}
+
+StorageConfig StorageConfig::GetMetricConfig(const std::string &metric) const
+{
+    StorageConfig metric_config = *this;
+    metric_config.hsgr_data_path = metricPath(hsgr_data_path, metric);
+    metric_config.core_data_path = metricPath(core_data_path, metric);
+    metric_config.node_renumbering_path = metricPath(node_renumbering_path, metric);
+    metric_config.core_landmarks_path = metricPath(core_landmarks_path, metric);
+    metric_config.geometries_path = metricPath(geometries_path, metric);
+    metric_config.datasource_names_path = metricPath(datasource_names_path, metric);
+    metric_config.datasource_indexes_path = metricPath(datasource_indexes_path, metric);
+    metric_config.speed_profiles_path = metricPath(speed_profiles_path, metric);
+    metric_config.mld_graph_path = metricPath(mld_graph_path, metric);
+    metric_config.metrics.clear();
+    return metric_config;
+}
+
 bool StorageConfig::IsValid() const
 {
-    const constexpr auto num_files = 13;
+    const constexpr auto num_files = 14;
     const boost::filesystem::path paths[num_files] = {ram_index_path,
                                                       file_index_path,
                                                       hsgr_data_path,
                                                       nodes_data_path,
                                                       edges_data_path,
+                                                      edge_based_nodes_data_path,
                                                       core_data_path,
                                                       geometries_path,
                                                       timestamp_path,
@@ -48,6 +83,11 @@ bool StorageConfig::IsValid() const
         }
     }
 
+    for (const auto &metric : metrics)
+    {
+        success = GetMetricConfig(metric).IsValid() && success;
+    }
+
     return success;
 }
 }
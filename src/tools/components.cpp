@@ -1,14 +1,26 @@
-#include "extractor/tarjan_scc.hpp"
+#include "extractor/external_memory_node.hpp"
+#include "extractor/node_based_edge.hpp"
+#include "extractor/parallel_scc.hpp"
+#include "extractor/query_node.hpp"
 #include "util/coordinate_calculation.hpp"
-#include "util/dynamic_graph.hpp"
 #include "util/exception.hpp"
 #include "util/fingerprint.hpp"
-#include "util/graph_loader.hpp"
+#include "util/integer_range.hpp"
+#include "util/percent.hpp"
 #include "util/simple_logger.hpp"
 #include "util/static_graph.hpp"
+#include "util/timing_util.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+#include <tbb/pipeline.h>
+#include <tbb/task_scheduler_init.h>
 
 #if defined(__APPLE__) || defined(_WIN32)
 #include <gdal.h>
@@ -20,9 +32,13 @@
 
 #include "osrm/coordinate.hpp"
 
-#include <fstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <memory>
+#include <numeric>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -41,6 +57,12 @@ struct TarjanEdgeData
 using TarjanGraph = util::StaticGraph<TarjanEdgeData>;
 using TarjanEdge = TarjanGraph::InputEdge;
 
+// the graph is loaded and written out in chunks of that many nodes respectively edges
+const constexpr std::size_t CHUNK_SIZE = 1 << 16;
+
+// edges of components with less nodes are written out
+const constexpr unsigned MAX_OUTPUT_COMPONENT_SIZE = 1000;
+
 void deleteFileIfExists(const std::string &file_name)
 {
     if (boost::filesystem::exists(file_name))
@@ -49,55 +71,130 @@ void deleteFileIfExists(const std::string &file_name)
     }
 }
 
+// Reads a value of the mapped file, which is not necessarily aligned
+template <typename T> T readMapped(const char *position)
+{
+    T value;
+    std::memcpy(&value, position, sizeof(T));
+    return value;
+}
+
+// Maps the .osrm file instead of streaming it through a buffer: the nodes and edges are converted
+// in parallel chunks straight from the page cache and only the converted copies are kept in memory.
 std::size_t loadGraph(const char *path,
                       std::vector<extractor::QueryNode> &coordinate_list,
                       std::vector<TarjanEdge> &graph_edge_list)
 {
-    std::ifstream input_stream(path, std::ifstream::in | std::ifstream::binary);
-    if (!input_stream.is_open())
+    if (!boost::filesystem::is_regular_file(path))
     {
         throw util::exception("Cannot open osrm file");
     }
-
-    // load graph data
-    std::vector<extractor::NodeBasedEdge> edge_list;
-    std::vector<NodeID> traffic_light_node_list;
-    std::vector<NodeID> barrier_node_list;
-
-    auto number_of_nodes = util::loadNodesFromFile(
-        input_stream, barrier_node_list, traffic_light_node_list, coordinate_list);
-
-    util::loadEdgesFromFile(input_stream, edge_list);
-
-    traffic_light_node_list.clear();
-    traffic_light_node_list.shrink_to_fit();
-
-    // Building an node-based graph
-    for (const auto &input_edge : edge_list)
-    {
-        if (input_edge.source == input_edge.target)
+    const boost::interprocess::file_mapping mapping{path, boost::interprocess::read_only};
+    boost::interprocess::mapped_region region{mapping, boost::interprocess::read_only};
+    region.advise(boost::interprocess::mapped_region::advice_sequential);
+    const char *position = static_cast<const char *>(region.get_address());
+    const char *const end = position + region.get_size();
+
+    const auto require = [&](const std::uint64_t bytes) {
+        if (static_cast<std::uint64_t>(end - position) < bytes)
         {
-            continue;
+            throw util::exception(std::string(path) + " is truncated");
         }
+    };
 
-        if (input_edge.forward)
+    require(sizeof(util::FingerPrint) + sizeof(NodeID));
+    const auto fingerprint_loaded = readMapped<util::FingerPrint>(position);
+    if (!fingerprint_loaded.TestContractor(util::FingerPrint::GetValid()))
+    {
+        util::SimpleLogger().Write(logWARNING) << ".osrm was prepared with different build.\n"
+                                                  "Reprocess to get rid of this warning.";
+    }
+    position += sizeof(util::FingerPrint);
+
+    const auto number_of_nodes = readMapped<NodeID>(position);
+    position += sizeof(NodeID);
+    util::SimpleLogger().Write() << "Importing n = " << number_of_nodes << " nodes ";
+    require(number_of_nodes * sizeof(extractor::ExternalMemoryNode) + sizeof(unsigned));
+    const char *const nodes = position;
+    position += number_of_nodes * sizeof(extractor::ExternalMemoryNode);
+
+    coordinate_list.resize(number_of_nodes);
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_nodes, CHUNK_SIZE),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          for (auto node = range.begin(); node != range.end(); ++node)
+                          {
+                              coordinate_list[node] = readMapped<extractor::ExternalMemoryNode>(
+                                  nodes + node * sizeof(extractor::ExternalMemoryNode));
+                          }
+                      });
+
+    const auto number_of_edges = readMapped<unsigned>(position);
+    position += sizeof(unsigned);
+    util::SimpleLogger().Write() << " and " << number_of_edges << " edges ";
+    require(number_of_edges * sizeof(extractor::NodeBasedEdge));
+    const char *const edges = position;
+    const auto readEdge = [&](const std::size_t edge) {
+        return readMapped<extractor::NodeBasedEdge>(edges +
+                                                    edge * sizeof(extractor::NodeBasedEdge));
+    };
+
+    // every input edge yields up to two directed edges, the chunks find out where theirs go first
+    const auto number_of_chunks = (number_of_edges + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<std::size_t> chunk_offsets(number_of_chunks + 1, 0);
+    tbb::parallel_for(std::size_t{0}, number_of_chunks, [&](const std::size_t chunk) {
+        const auto last = std::min<std::size_t>(number_of_edges, (chunk + 1) * CHUNK_SIZE);
+        for (auto edge = chunk * CHUNK_SIZE; edge < last; ++edge)
         {
-            graph_edge_list.emplace_back(input_edge.source,
-                                         input_edge.target,
-                                         (std::max)(input_edge.weight, 1),
-                                         input_edge.name_id);
+            const auto input_edge = readEdge(edge);
+            if (input_edge.source != input_edge.target)
+            {
+                chunk_offsets[chunk + 1] += input_edge.forward + input_edge.backward;
+            }
         }
-        if (input_edge.backward)
+    });
+    std::partial_sum(chunk_offsets.begin(), chunk_offsets.end(), chunk_offsets.begin());
+
+    // Building an node-based graph
+    graph_edge_list.resize(chunk_offsets.back(), TarjanEdge(SPECIAL_NODEID, SPECIAL_NODEID));
+    tbb::parallel_for(std::size_t{0}, number_of_chunks, [&](const std::size_t chunk) {
+        const auto last = std::min<std::size_t>(number_of_edges, (chunk + 1) * CHUNK_SIZE);
+        auto output = graph_edge_list.begin() + chunk_offsets[chunk];
+        for (auto edge = chunk * CHUNK_SIZE; edge < last; ++edge)
         {
-            graph_edge_list.emplace_back(input_edge.target,
-                                         input_edge.source,
-                                         (std::max)(input_edge.weight, 1),
-                                         input_edge.name_id);
+            const auto input_edge = readEdge(edge);
+            if (input_edge.source == input_edge.target)
+            {
+                continue;
+            }
+
+            if (input_edge.forward)
+            {
+                *output++ = TarjanEdge(input_edge.source,
+                                       input_edge.target,
+                                       (std::max)(input_edge.weight, 1),
+                                       input_edge.name_id);
+            }
+            if (input_edge.backward)
+            {
+                *output++ = TarjanEdge(input_edge.target,
+                                       input_edge.source,
+                                       (std::max)(input_edge.weight, 1),
+                                       input_edge.name_id);
+            }
         }
-    }
+    });
 
     return number_of_nodes;
 }
+
+// The edges of a chunk of nodes that are written out and the length of all its edges
+struct OutputChunk
+{
+    NodeID begin;
+    NodeID end;
+    std::vector<std::pair<NodeID, NodeID>> segments;
+    std::uint64_t network_length = 0;
+};
 }
 }
 
@@ -123,7 +220,7 @@ int main(int argc, char *argv[])
 
     osrm::util::SimpleLogger().Write() << "Starting SCC graph traversal";
 
-    auto tarjan = std::make_unique<osrm::extractor::TarjanSCC<osrm::tools::TarjanGraph>>(graph);
+    auto tarjan = std::make_unique<osrm::extractor::ParallelSCC<osrm::tools::TarjanGraph>>(graph);
     tarjan->Run();
     osrm::util::SimpleLogger().Write() << "identified: " << tarjan->GetNumberOfComponents()
                                        << " many components";
@@ -166,53 +263,97 @@ int main(int argc, char *argv[])
     osrm::util::SimpleLogger().Write() << "shapefile setup took "
                                        << TIMER_MSEC(SCC_RUN_SETUP) / 1000. << "s";
 
-    uint64_t total_network_length = 0;
-    osrm::util::Percent percentage(graph->GetNumberOfNodes());
-    TIMER_START(SCC_OUTPUT);
-    for (const NodeID source : osrm::util::irange(0u, graph->GetNumberOfNodes()))
-    {
-        percentage.PrintIncrement();
-        for (const auto current_edge : graph->GetAdjacentEdgeRange(source))
+    // Chunks of nodes are collected in parallel and written out in order as they are done, GDAL
+    // only sees a single thread. At most a few chunks per thread are in flight.
+    const auto collect_chunk = [&](osrm::tools::OutputChunk &chunk) {
+        for (const NodeID source : osrm::util::irange(chunk.begin, chunk.end))
         {
-            const auto target = graph->GetTarget(current_edge);
-
-            if (source < target || SPECIAL_EDGEID == graph->FindEdge(target, source))
+            for (const auto current_edge : graph->GetAdjacentEdgeRange(source))
             {
-                total_network_length +=
-                    100 * osrm::util::coordinate_calculation::greatCircleDistance(
-                              coordinate_list[source], coordinate_list[target]);
+                const auto target = graph->GetTarget(current_edge);
 
-                BOOST_ASSERT(current_edge != SPECIAL_EDGEID);
-                BOOST_ASSERT(source != SPECIAL_NODEID);
-                BOOST_ASSERT(target != SPECIAL_NODEID);
+                if (source < target || SPECIAL_EDGEID == graph->FindEdge(target, source))
+                {
+                    chunk.network_length +=
+                        100 * osrm::util::coordinate_calculation::greatCircleDistance(
+                                  coordinate_list[source], coordinate_list[target]);
 
-                const unsigned size_of_containing_component =
-                    std::min(tarjan->GetComponentSize(tarjan->GetComponentID(source)),
-                             tarjan->GetComponentSize(tarjan->GetComponentID(target)));
+                    BOOST_ASSERT(current_edge != SPECIAL_EDGEID);
+                    BOOST_ASSERT(source != SPECIAL_NODEID);
+                    BOOST_ASSERT(target != SPECIAL_NODEID);
 
-                // edges that end on bollard nodes may actually be in two distinct components
-                if (size_of_containing_component < 1000)
-                {
-                    OGRLineString line_string;
-                    line_string.addPoint(
-                        static_cast<double>(osrm::util::toFloating(coordinate_list[source].lon)),
-                        static_cast<double>(osrm::util::toFloating(coordinate_list[source].lat)));
-                    line_string.addPoint(
-                        static_cast<double>(osrm::util::toFloating(coordinate_list[target].lon)),
-                        static_cast<double>(osrm::util::toFloating(coordinate_list[target].lat)));
-
-                    OGRFeature *po_feature = OGRFeature::CreateFeature(po_layer->GetLayerDefn());
-
-                    po_feature->SetGeometry(&line_string);
-                    if (OGRERR_NONE != po_layer->CreateFeature(po_feature))
+                    const unsigned size_of_containing_component =
+                        std::min(tarjan->GetComponentSize(tarjan->GetComponentID(source)),
+                                 tarjan->GetComponentSize(tarjan->GetComponentID(target)));
+
+                    // edges that end on bollard nodes may actually be in two distinct components
+                    if (size_of_containing_component < osrm::tools::MAX_OUTPUT_COMPONENT_SIZE)
                     {
-                        throw osrm::util::exception("Failed to create feature in shapefile.");
+                        chunk.segments.emplace_back(source, target);
                     }
-                    OGRFeature::DestroyFeature(po_feature);
                 }
             }
         }
-    }
+    };
+
+    uint64_t total_network_length = 0;
+    const auto write_chunk = [&](const osrm::tools::OutputChunk &chunk) {
+        for (const auto &segment : chunk.segments)
+        {
+            const auto &source = coordinate_list[segment.first];
+            const auto &target = coordinate_list[segment.second];
+            OGRLineString line_string;
+            line_string.addPoint(static_cast<double>(osrm::util::toFloating(source.lon)),
+                                 static_cast<double>(osrm::util::toFloating(source.lat)));
+            line_string.addPoint(static_cast<double>(osrm::util::toFloating(target.lon)),
+                                 static_cast<double>(osrm::util::toFloating(target.lat)));
+
+            OGRFeature *po_feature = OGRFeature::CreateFeature(po_layer->GetLayerDefn());
+
+            po_feature->SetGeometry(&line_string);
+            if (OGRERR_NONE != po_layer->CreateFeature(po_feature))
+            {
+                throw osrm::util::exception("Failed to create feature in shapefile.");
+            }
+            OGRFeature::DestroyFeature(po_feature);
+        }
+        total_network_length += chunk.network_length;
+    };
+
+    const NodeID number_of_graph_nodes = graph->GetNumberOfNodes();
+    osrm::util::Percent percentage(number_of_graph_nodes);
+    TIMER_START(SCC_OUTPUT);
+    NodeID next_chunk_begin = 0;
+    tbb::parallel_pipeline(
+        2 * tbb::task_scheduler_init::default_num_threads(),
+        tbb::make_filter<void, std::shared_ptr<osrm::tools::OutputChunk>>(
+            tbb::filter::serial_in_order,
+            [&](tbb::flow_control &control) -> std::shared_ptr<osrm::tools::OutputChunk> {
+                if (next_chunk_begin >= number_of_graph_nodes)
+                {
+                    control.stop();
+                    return nullptr;
+                }
+                auto chunk = std::make_shared<osrm::tools::OutputChunk>();
+                chunk->begin = next_chunk_begin;
+                chunk->end = static_cast<NodeID>(std::min<std::size_t>(
+                    number_of_graph_nodes, next_chunk_begin + osrm::tools::CHUNK_SIZE));
+                next_chunk_begin = chunk->end;
+                return chunk;
+            }) &
+            tbb::make_filter<std::shared_ptr<osrm::tools::OutputChunk>,
+                             std::shared_ptr<osrm::tools::OutputChunk>>(
+                tbb::filter::parallel,
+                [&](std::shared_ptr<osrm::tools::OutputChunk> chunk) {
+                    collect_chunk(*chunk);
+                    return chunk;
+                }) &
+            tbb::make_filter<std::shared_ptr<osrm::tools::OutputChunk>, void>(
+                tbb::filter::serial_in_order,
+                [&](std::shared_ptr<osrm::tools::OutputChunk> chunk) {
+                    write_chunk(*chunk);
+                    percentage.PrintAddition(chunk->end - chunk->begin);
+                }));
     OGRSpatialReference::DestroySpatialReference(po_srs);
     OGRDataSource::DestroyDataSource(po_datasource);
     TIMER_STOP(SCC_OUTPUT);
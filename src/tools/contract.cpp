@@ -1,18 +1,28 @@
 #include "contractor/contractor.hpp"
 #include "contractor/contractor_config.hpp"
+#include "extractor/class_data.hpp"
 #include "util/simple_logger.hpp"
 #include "util/version.hpp"
 
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 #include <boost/program_options/errors.hpp>
 
 #include <tbb/task_scheduler_init.h>
 
+#include <cctype>
 #include <cstdlib>
+
+#include <algorithm>
 #include <exception>
+#include <functional>
 #include <new>
 #include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 using namespace osrm;
 
@@ -25,6 +35,9 @@ enum class return_code : unsigned
 
 return_code parseArguments(int argc, char *argv[], contractor::ContractorConfig &contractor_config)
 {
+    std::string excluded_classes;
+    std::string mld_cell_sizes;
+
     // declare a group of options that will be allowed only on command line
     boost::program_options::options_description generic_options("Options");
     generic_options.add_options()("version,v", "Show version")("help,h", "Show this help message");
@@ -39,6 +52,11 @@ return_code parseArguments(int argc, char *argv[], contractor::ContractorConfig
         "core,k",
         boost::program_options::value<double>(&contractor_config.core_factor)->default_value(1.0),
         "Percentage of the graph (in vertices) to contract [0..1]")(
+        "core-landmarks",
+        boost::program_options::value<unsigned>(&contractor_config.core_landmarks)
+            ->default_value(0),
+        "Number of landmarks of the core left by --core, queries search the core towards the "
+        "target with their weights. Takes 8 bytes per landmark and core node.")(
         "segment-speed-file",
         boost::program_options::value<std::vector<std::string>>(
             &contractor_config.segment_speed_lookup_paths)
@@ -49,10 +67,64 @@ return_code parseArguments(int argc, char *argv[], contractor::ContractorConfig
             &contractor_config.turn_penalty_lookup_paths)
             ->composing(),
         "Lookup files containing from_, to_, via_nodes, and turn penalties to adjust turn weights")(
+        "segment-speed-profile-file",
+        boost::program_options::value<std::vector<std::string>>(
+            &contractor_config.segment_speed_profile_lookup_paths)
+            ->composing(),
+        "Lookup files containing nodeA, nodeB and the speeds of the segment in equal time slots "
+        "of a day from midnight UTC, their number divides 96, for routes with a departure_time")(
+        "cache-lookup-files",
+        boost::program_options::value<bool>(&contractor_config.cache_lookup_files)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Keep a binary copy <file>.bin of every parsed speed and penalty file and use it instead "
+        "of the file until the file changes")(
+        "contraction-telemetry",
+        boost::program_options::value<std::string>(&contractor_config.contraction_telemetry_path),
+        "Write the node counts, witness searches, shortcuts, memory and phase timings of every "
+        "contraction round as JSON lines to this file")(
+        "phase-report",
+        boost::program_options::value<std::string>(&contractor_config.phase_report_path),
+        "Write the wall and CPU time, peak memory, bytes read and written and stxxl disk space "
+        "of the phases of the run as JSON to this file")(
         "level-cache,o",
         boost::program_options::value<bool>(&contractor_config.use_cached_priority)
             ->default_value(false),
         "Use .level file to retain the contaction level for each node from the last run.")(
+        "cch",
+        boost::program_options::value<bool>(&contractor_config.customizable)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Contract in a metric independent nested dissection order, rerun with --level-cache to "
+        "only customize new weights")(
+        "renumber-nodes",
+        boost::program_options::value<bool>(&contractor_config.renumber_nodes)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Store the nodes of the hierarchy ordered by their level and by a depth first search, "
+        "searches touch fewer cache lines")(
+        "mld",
+        boost::program_options::value<bool>(&contractor_config.multi_level)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Build a multi-level overlay graph for osrm-routed --algorithm mld instead of a "
+        "hierarchy, rerun with --level-cache to only customize new weights")(
+        "mld-cell-sizes",
+        boost::program_options::value<std::string>(&mld_cell_sizes),
+        "Comma separated maximum numbers of nodes in the cells of the levels of the multi-level "
+        "overlay graph from the lowest up, 128,4096,65536,2097152 by default")(
+        "metric",
+        boost::program_options::value<std::string>(&contractor_config.metric),
+        "Contract an additional metric in the node order of the default one and write it to "
+        "<input.osrm>.<metric>.*, the metric is selected with the metric parameter of a request")(
+        "exclude",
+        boost::program_options::value<std::string>(&excluded_classes),
+        "Contract a metric without the roads of the comma separated classes of the profile, "
+        "requests excluding the same classes use it")(
+        "cell",
+        boost::program_options::value<int>(&contractor_config.cell)->default_value(-1),
+        "Contract the shard of a cell of the partition in <input.osrm>.cells written by "
+        "osrm-partition on its own and write it to <input.osrm>.cell<n>.*")(
         "edge-weight-updates-over-factor",
         boost::program_options::value<double>(&contractor_config.log_edge_updates_factor)
             ->default_value(0.0),
@@ -116,6 +188,46 @@ return_code parseArguments(int argc, char *argv[], contractor::ContractorConfig
         return return_code::fail;
     }
 
+    if (!mld_cell_sizes.empty())
+    {
+        std::vector<std::string> sizes;
+        boost::split(sizes, mld_cell_sizes, boost::is_any_of(","));
+        contractor_config.mld_cell_sizes.clear();
+        try
+        {
+            for (const auto &size : sizes)
+            {
+                contractor_config.mld_cell_sizes.push_back(std::stoul(size));
+            }
+        }
+        catch (const std::logic_error &)
+        {
+            util::SimpleLogger().Write(logWARNING) << "Invalid cell size in " << mld_cell_sizes;
+            return return_code::fail;
+        }
+        const auto &cell_sizes = contractor_config.mld_cell_sizes;
+        if (cell_sizes.front() == 0 ||
+            std::adjacent_find(cell_sizes.begin(), cell_sizes.end(), std::greater_equal<>()) !=
+                cell_sizes.end())
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "The cell sizes have to be positive and increase from level to level";
+            return return_code::fail;
+        }
+    }
+
+    if (!excluded_classes.empty())
+    {
+        std::vector<std::string> class_names;
+        boost::split(class_names, excluded_classes, boost::is_any_of(","));
+        contractor_config.excluded_classes = extractor::getClasses(class_names);
+        if (contractor_config.excluded_classes == 0)
+        {
+            util::SimpleLogger().Write(logWARNING) << "Unknown class in " << excluded_classes;
+            return return_code::fail;
+        }
+    }
+
     return return_code::ok;
 }
 
@@ -137,6 +249,45 @@ int main(int argc, char *argv[]) try
     }
 
     contractor_config.UseDefaultOutputNames();
+    if (contractor_config.excluded_classes != 0)
+    {
+        if (!contractor_config.metric.empty())
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "A metric excluding classes is named after them, --exclude and --metric "
+                   "can not be combined";
+            return EXIT_FAILURE;
+        }
+        contractor_config.metric =
+            extractor::getExcludeMetricName(contractor_config.excluded_classes);
+    }
+    if (!contractor_config.metric.empty())
+    {
+        // the name becomes part of the file names and of the requests
+        const auto &metric = contractor_config.metric;
+        if (!std::all_of(metric.begin(), metric.end(), [](const char c) {
+                return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-';
+            }))
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "Metric names only consist of letters, digits, '_' and '-'";
+            return EXIT_FAILURE;
+        }
+        contractor_config.UseMetricOutputNames();
+        // the metric shares the node order of the default one
+        contractor_config.use_cached_priority = true;
+    }
+    if (contractor_config.cell >= 0)
+    {
+        if (!contractor_config.metric.empty())
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "A shard is contracted in an order of its own, --cell can not be combined "
+                   "with --metric or --exclude";
+            return EXIT_FAILURE;
+        }
+        contractor_config.UseCellOutputNames();
+    }
 
     if (1 > contractor_config.requested_num_threads)
     {
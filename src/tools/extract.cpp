@@ -12,6 +12,7 @@
 #include <cstdlib>
 #include <exception>
 #include <new>
+#include <vector>
 
 using namespace osrm;
 
@@ -39,11 +40,27 @@ return_code parseArguments(int argc, char *argv[], extractor::ExtractorConfig &e
         boost::program_options::value<unsigned int>(&extractor_config.requested_num_threads)
             ->default_value(tbb::task_scheduler_init::default_num_threads()),
         "Number of threads to use")(
+        "changes",
+        boost::program_options::value<std::vector<boost::filesystem::path>>(
+            &extractor_config.change_paths)
+            ->composing(),
+        "OSM change file (.osc, .osc.gz) applied to the input while reading it, can be given "
+        "multiple times and the latest version of every object is used")(
         "generate-edge-lookup",
         boost::program_options::value<bool>(&extractor_config.generate_edge_lookup)
             ->implicit_value(true)
             ->default_value(false),
         "Generate a lookup table for internal edge-expanded-edge IDs to OSM node pairs")(
+        "hilbert-node-order",
+        boost::program_options::value<bool>(&extractor_config.hilbert_node_order)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Number the edge-based nodes along a Hilbert curve, so that nodes that are close on the "
+        "map are close in the data files")(
+        "phase-report",
+        boost::program_options::value<std::string>(&extractor_config.phase_report_path),
+        "Write the wall and CPU time, peak memory, bytes read and written and stxxl disk space "
+        "of the phases of the run as JSON to this file")(
         "small-component-size",
         boost::program_options::value<unsigned int>(&extractor_config.small_component_size)
             ->default_value(1000),
@@ -143,6 +160,16 @@ int main(int argc, char *argv[]) try
         return EXIT_FAILURE;
     }
 
+    for (const auto &change_path : extractor_config.change_paths)
+    {
+        if (!boost::filesystem::is_regular_file(change_path))
+        {
+            util::SimpleLogger().Write(logWARNING) << "Change file " << change_path.string()
+                                                   << " not found!";
+            return EXIT_FAILURE;
+        }
+    }
+
     if (!boost::filesystem::is_regular_file(extractor_config.profile_path))
     {
         util::SimpleLogger().Write(logWARNING)
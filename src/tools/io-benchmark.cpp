@@ -1,9 +1,18 @@
+#include "engine/query_graph.hpp"
+#include "extractor/edge_based_node.hpp"
+#include "storage/io.hpp"
+#include "util/coordinate_list.hpp"
 #include "util/exception.hpp"
+#include "util/fingerprint.hpp"
+#include "util/integer_range.hpp"
 #include "util/simple_logger.hpp"
+#include "util/static_rtree.hpp"
 #include "util/timing_util.hpp"
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/program_options.hpp>
 
 #include <cmath>
 #include <cstdio>
@@ -11,12 +20,20 @@
 #ifdef __linux__
 #include <malloc.h>
 #endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
 
 #include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <fstream>
 #include <iomanip>
 #include <numeric>
 #include <random>
+#include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace osrm
@@ -28,7 +45,7 @@ const unsigned NUMBER_OF_ELEMENTS = 268435456;
 
 struct Statistics
 {
-    double min, max, med, mean, dev;
+    double min, max, med, p90, p99, mean, dev;
 };
 
 void runStatistics(std::vector<double> &timings_vector, Statistics &stats)
@@ -37,6 +54,8 @@ void runStatistics(std::vector<double> &timings_vector, Statistics &stats)
     stats.min = timings_vector.front();
     stats.max = timings_vector.back();
     stats.med = timings_vector[timings_vector.size() / 2];
+    stats.p90 = timings_vector[timings_vector.size() * 90 / 100];
+    stats.p99 = timings_vector[timings_vector.size() * 99 / 100];
     double primary_sum = std::accumulate(timings_vector.begin(), timings_vector.end(), 0.0);
     stats.mean = primary_sum / timings_vector.size();
 
@@ -44,271 +63,609 @@ void runStatistics(std::vector<double> &timings_vector, Statistics &stats)
         timings_vector.begin(), timings_vector.end(), timings_vector.begin(), 0.0);
     stats.dev = std::sqrt(primary_sq_sum / timings_vector.size() - (stats.mean * stats.mean));
 }
-}
-}
 
-boost::filesystem::path test_path;
-
-int main(int argc, char *argv[])
+// Writes 1GB of random data to the test file, the device benchmark reads it back
+void createTestFile(const boost::filesystem::path &test_path)
 {
-
-#ifdef __FreeBSD__
-    osrm::util::SimpleLogger().Write() << "Not supported on FreeBSD";
-    return 0;
-#endif
-#ifdef _WIN32
-    osrm::util::SimpleLogger().Write() << "Not supported on Windows";
-    return 0;
-#else
-
-    osrm::util::LogPolicy::GetInstance().Unmute();
-    if (1 == argc)
+    if (boost::filesystem::exists(test_path))
     {
-        osrm::util::SimpleLogger().Write(logWARNING) << "usage: " << argv[0] << " /path/on/device";
-        return -1;
+        throw util::exception("Data file already exists");
     }
 
-    test_path = boost::filesystem::path(argv[1]);
-    test_path /= "osrm.tst";
-    osrm::util::SimpleLogger().Write(logDEBUG) << "temporary file: " << test_path.string();
-
-    // create files for testing
-    if (2 == argc)
-    {
-        // create file to test
-        if (boost::filesystem::exists(test_path))
-        {
-            throw osrm::util::exception("Data file already exists");
-        }
-
-        int *random_array = new int[osrm::tools::NUMBER_OF_ELEMENTS];
-        std::generate(random_array, random_array + osrm::tools::NUMBER_OF_ELEMENTS, std::rand);
+    int *random_array = new int[NUMBER_OF_ELEMENTS];
+    std::generate(random_array, random_array + NUMBER_OF_ELEMENTS, std::rand);
 #ifdef __APPLE__
-        FILE *fd = fopen(test_path.string().c_str(), "w");
-        fcntl(fileno(fd), F_NOCACHE, 1);
-        fcntl(fileno(fd), F_RDAHEAD, 0);
-        TIMER_START(write_1gb);
-        write(fileno(fd), (char *)random_array, osrm::tools::NUMBER_OF_ELEMENTS * sizeof(unsigned));
-        TIMER_STOP(write_1gb);
-        fclose(fd);
+    FILE *fd = fopen(test_path.string().c_str(), "w");
+    fcntl(fileno(fd), F_NOCACHE, 1);
+    fcntl(fileno(fd), F_RDAHEAD, 0);
+    TIMER_START(write_1gb);
+    write(fileno(fd), (char *)random_array, NUMBER_OF_ELEMENTS * sizeof(unsigned));
+    TIMER_STOP(write_1gb);
+    fclose(fd);
 #endif
 #ifdef __linux__
-        int file_desc =
-            open(test_path.string().c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_SYNC, S_IRWXU);
-        if (-1 == file_desc)
-        {
-            throw osrm::util::exception("Could not open random data file");
-        }
-        TIMER_START(write_1gb);
-        int ret =
-            write(file_desc, random_array, osrm::tools::NUMBER_OF_ELEMENTS * sizeof(unsigned));
-        if (0 > ret)
-        {
-            throw osrm::util::exception("could not write random data file");
-        }
-        TIMER_STOP(write_1gb);
-        close(file_desc);
-#endif
-        delete[] random_array;
-        osrm::util::SimpleLogger().Write(logDEBUG) << "writing raw 1GB took "
-                                                   << TIMER_SEC(write_1gb) << "s";
-        osrm::util::SimpleLogger().Write() << "raw write performance: " << std::setprecision(5)
-                                           << std::fixed << 1024 * 1024 / TIMER_SEC(write_1gb)
-                                           << "MB/sec";
-
-        osrm::util::SimpleLogger().Write(logDEBUG)
-            << "finished creation of random data. Flush disk cache now!";
+    int file_desc =
+        open(test_path.string().c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_SYNC, S_IRWXU);
+    if (-1 == file_desc)
+    {
+        throw util::exception("Could not open random data file");
     }
-    else
+    TIMER_START(write_1gb);
+    int ret =
+        write(file_desc, random_array, NUMBER_OF_ELEMENTS * sizeof(unsigned));
+    if (0 > ret)
     {
-        // Run Non-Cached I/O benchmarks
-        if (!boost::filesystem::exists(test_path))
-        {
-            throw osrm::util::exception("data file does not exist");
-        }
+        throw util::exception("could not write random data file");
+    }
+    TIMER_STOP(write_1gb);
+    close(file_desc);
+#endif
+    delete[] random_array;
+    util::SimpleLogger().Write(logDEBUG) << "writing raw 1GB took "
+                                               << TIMER_SEC(write_1gb) << "s";
+    util::SimpleLogger().Write() << "raw write performance: " << std::setprecision(5)
+                                       << std::fixed << 1024 * 1024 / TIMER_SEC(write_1gb)
+                                       << "MB/sec";
+
+    util::SimpleLogger().Write(logDEBUG)
+        << "finished creation of random data. Flush disk cache now!";
+}
+
+// Reads the test file sequentially, then 1000 random and 1000 consecutive blocks of 4KB
+// bypassing the page cache
+int runDeviceBenchmark(const boost::filesystem::path &test_path)
+{
+    // Run Non-Cached I/O benchmarks
+    if (!boost::filesystem::exists(test_path))
+    {
+        throw util::exception("data file does not exist");
+    }
 
-        // volatiles do not get optimized
-        osrm::tools::Statistics stats;
+    // volatiles do not get optimized
+    Statistics stats;
 
 #ifdef __APPLE__
-        volatile unsigned single_block[1024];
-        char *raw_array = new char[osrm::tools::NUMBER_OF_ELEMENTS * sizeof(unsigned)];
-        FILE *fd = fopen(test_path.string().c_str(), "r");
-        fcntl(fileno(fd), F_NOCACHE, 1);
-        fcntl(fileno(fd), F_RDAHEAD, 0);
+    volatile unsigned single_block[1024];
+    char *raw_array = new char[NUMBER_OF_ELEMENTS * sizeof(unsigned)];
+    FILE *fd = fopen(test_path.string().c_str(), "r");
+    fcntl(fileno(fd), F_NOCACHE, 1);
+    fcntl(fileno(fd), F_RDAHEAD, 0);
 #endif
 #ifdef __linux__
-        char *single_block = (char *)memalign(512, 1024 * sizeof(unsigned));
+    char *single_block = (char *)memalign(512, 1024 * sizeof(unsigned));
 
-        int file_desc = open(test_path.string().c_str(), O_RDONLY | O_DIRECT | O_SYNC);
-        if (-1 == file_desc)
-        {
-            osrm::util::SimpleLogger().Write(logDEBUG) << "opened, error: " << strerror(errno);
-            return -1;
-        }
-        char *raw_array = (char *)memalign(512, osrm::tools::NUMBER_OF_ELEMENTS * sizeof(unsigned));
+    int file_desc = open(test_path.string().c_str(), O_RDONLY | O_DIRECT | O_SYNC);
+    if (-1 == file_desc)
+    {
+        util::SimpleLogger().Write(logDEBUG) << "opened, error: " << strerror(errno);
+        return -1;
+    }
+    char *raw_array = (char *)memalign(512, NUMBER_OF_ELEMENTS * sizeof(unsigned));
 #endif
-        TIMER_START(read_1gb);
+    TIMER_START(read_1gb);
 #ifdef __APPLE__
-        read(fileno(fd), raw_array, osrm::tools::NUMBER_OF_ELEMENTS * sizeof(unsigned));
-        close(fileno(fd));
-        fd = fopen(test_path.string().c_str(), "r");
+    read(fileno(fd), raw_array, NUMBER_OF_ELEMENTS * sizeof(unsigned));
+    close(fileno(fd));
+    fd = fopen(test_path.string().c_str(), "r");
 #endif
 #ifdef __linux__
-        int ret = read(file_desc, raw_array, osrm::tools::NUMBER_OF_ELEMENTS * sizeof(unsigned));
-        osrm::util::SimpleLogger().Write(logDEBUG) << "read " << ret
-                                                   << " bytes, error: " << strerror(errno);
-        close(file_desc);
-        file_desc = open(test_path.string().c_str(), O_RDONLY | O_DIRECT | O_SYNC);
-        osrm::util::SimpleLogger().Write(logDEBUG) << "opened, error: " << strerror(errno);
+    int ret = read(file_desc, raw_array, NUMBER_OF_ELEMENTS * sizeof(unsigned));
+    util::SimpleLogger().Write(logDEBUG) << "read " << ret
+                                               << " bytes, error: " << strerror(errno);
+    close(file_desc);
+    file_desc = open(test_path.string().c_str(), O_RDONLY | O_DIRECT | O_SYNC);
+    util::SimpleLogger().Write(logDEBUG) << "opened, error: " << strerror(errno);
 #endif
-        TIMER_STOP(read_1gb);
+    TIMER_STOP(read_1gb);
 
-        osrm::util::SimpleLogger().Write(logDEBUG) << "reading raw 1GB took " << TIMER_SEC(read_1gb)
-                                                   << "s";
-        osrm::util::SimpleLogger().Write() << "raw read performance: " << std::setprecision(5)
-                                           << std::fixed << 1024 * 1024 / TIMER_SEC(read_1gb)
-                                           << "MB/sec";
+    util::SimpleLogger().Write(logDEBUG) << "reading raw 1GB took " << TIMER_SEC(read_1gb)
+                                               << "s";
+    util::SimpleLogger().Write() << "raw read performance: " << std::setprecision(5)
+                                       << std::fixed << 1024 * 1024 / TIMER_SEC(read_1gb)
+                                       << "MB/sec";
 
-        std::vector<double> timing_results_raw_random;
-        osrm::util::SimpleLogger().Write(logDEBUG) << "running 1000 random I/Os of 4KB";
+    std::vector<double> timing_results_raw_random;
+    util::SimpleLogger().Write(logDEBUG) << "running 1000 random I/Os of 4KB";
 
 #ifdef __APPLE__
-        fseek(fd, 0, SEEK_SET);
+    fseek(fd, 0, SEEK_SET);
 #endif
 #ifdef __linux__
-        lseek(file_desc, 0, SEEK_SET);
+    lseek(file_desc, 0, SEEK_SET);
 #endif
-        // make 1000 random access, time each I/O seperately
-        unsigned number_of_blocks = (osrm::tools::NUMBER_OF_ELEMENTS * sizeof(unsigned) - 1) / 4096;
-        std::random_device rd;
-        std::default_random_engine e1(rd());
-        std::uniform_int_distribution<unsigned> uniform_dist(0, number_of_blocks - 1);
-        for (unsigned i = 0; i < 1000; ++i)
-        {
-            unsigned block_to_read = uniform_dist(e1);
-            off_t current_offset = block_to_read * 4096;
-            TIMER_START(random_access);
+    // make 1000 random access, time each I/O seperately
+    unsigned number_of_blocks = (NUMBER_OF_ELEMENTS * sizeof(unsigned) - 1) / 4096;
+    std::random_device rd;
+    std::default_random_engine e1(rd());
+    std::uniform_int_distribution<unsigned> uniform_dist(0, number_of_blocks - 1);
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        unsigned block_to_read = uniform_dist(e1);
+        off_t current_offset = block_to_read * 4096;
+        TIMER_START(random_access);
 #ifdef __APPLE__
-            int ret1 = fseek(fd, current_offset, SEEK_SET);
-            int ret2 = read(fileno(fd), (char *)&single_block[0], 4096);
+        int ret1 = fseek(fd, current_offset, SEEK_SET);
+        int ret2 = read(fileno(fd), (char *)&single_block[0], 4096);
 #endif
 
 #ifdef __FreeBSD__
-            int ret1 = 0;
-            int ret2 = 0;
+        int ret1 = 0;
+        int ret2 = 0;
 #endif
 
 #ifdef __linux__
-            int ret1 = lseek(file_desc, current_offset, SEEK_SET);
-            int ret2 = read(file_desc, (char *)single_block, 4096);
+        int ret1 = lseek(file_desc, current_offset, SEEK_SET);
+        int ret2 = read(file_desc, (char *)single_block, 4096);
 #endif
-            TIMER_STOP(random_access);
-            if (((off_t)-1) == ret1)
-            {
-                osrm::util::SimpleLogger().Write(logWARNING) << "offset: " << current_offset;
-                osrm::util::SimpleLogger().Write(logWARNING) << "seek error " << strerror(errno);
-                throw osrm::util::exception("seek error");
-            }
-            if (-1 == ret2)
-            {
-                osrm::util::SimpleLogger().Write(logWARNING) << "offset: " << current_offset;
-                osrm::util::SimpleLogger().Write(logWARNING) << "read error " << strerror(errno);
-                throw osrm::util::exception("read error");
-            }
-            timing_results_raw_random.push_back(TIMER_SEC(random_access));
+        TIMER_STOP(random_access);
+        if (((off_t)-1) == ret1)
+        {
+            util::SimpleLogger().Write(logWARNING) << "offset: " << current_offset;
+            util::SimpleLogger().Write(logWARNING) << "seek error " << strerror(errno);
+            throw util::exception("seek error");
         }
-
-        // Do statistics
-        osrm::util::SimpleLogger().Write(logDEBUG) << "running raw random I/O statistics";
-        std::ofstream random_csv("random.csv", std::ios::trunc);
-        for (unsigned i = 0; i < timing_results_raw_random.size(); ++i)
+        if (-1 == ret2)
         {
-            random_csv << i << ", " << timing_results_raw_random[i] << std::endl;
+            util::SimpleLogger().Write(logWARNING) << "offset: " << current_offset;
+            util::SimpleLogger().Write(logWARNING) << "read error " << strerror(errno);
+            throw util::exception("read error");
         }
-        osrm::tools::runStatistics(timing_results_raw_random, stats);
+        timing_results_raw_random.push_back(TIMER_SEC(random_access));
+    }
 
-        osrm::util::SimpleLogger().Write() << "raw random I/O: " << std::setprecision(5)
-                                           << std::fixed << "min: " << stats.min << "ms, "
-                                           << "mean: " << stats.mean << "ms, "
-                                           << "med: " << stats.med << "ms, "
-                                           << "max: " << stats.max << "ms, "
-                                           << "dev: " << stats.dev << "ms";
+    // Do statistics
+    util::SimpleLogger().Write(logDEBUG) << "running raw random I/O statistics";
+    std::ofstream random_csv("random.csv", std::ios::trunc);
+    for (unsigned i = 0; i < timing_results_raw_random.size(); ++i)
+    {
+        random_csv << i << ", " << timing_results_raw_random[i] << std::endl;
+    }
+    runStatistics(timing_results_raw_random, stats);
 
-        std::vector<double> timing_results_raw_seq;
+    util::SimpleLogger().Write() << "raw random I/O: " << std::setprecision(5)
+                                       << std::fixed << "min: " << stats.min << "ms, "
+                                       << "mean: " << stats.mean << "ms, "
+                                       << "med: " << stats.med << "ms, "
+                                       << "max: " << stats.max << "ms, "
+                                       << "dev: " << stats.dev << "ms";
+
+    std::vector<double> timing_results_raw_seq;
 #ifdef __APPLE__
-        fseek(fd, 0, SEEK_SET);
+    fseek(fd, 0, SEEK_SET);
 #endif
 #ifdef __linux__
-        lseek(file_desc, 0, SEEK_SET);
+    lseek(file_desc, 0, SEEK_SET);
 #endif
 
-        // read every 100th block
-        for (unsigned i = 0; i < 1000; ++i)
-        {
-            off_t current_offset = i * 4096;
-            TIMER_START(read_every_100);
+    // read every 100th block
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        off_t current_offset = i * 4096;
+        TIMER_START(read_every_100);
 #ifdef __APPLE__
-            int ret1 = fseek(fd, current_offset, SEEK_SET);
-            int ret2 = read(fileno(fd), (char *)&single_block, 4096);
+        int ret1 = fseek(fd, current_offset, SEEK_SET);
+        int ret2 = read(fileno(fd), (char *)&single_block, 4096);
 #endif
 
 #ifdef __FreeBSD__
-            int ret1 = 0;
-            int ret2 = 0;
+        int ret1 = 0;
+        int ret2 = 0;
 #endif
 
 #ifdef __linux__
-            int ret1 = lseek(file_desc, current_offset, SEEK_SET);
+        int ret1 = lseek(file_desc, current_offset, SEEK_SET);
 
-            int ret2 = read(file_desc, (char *)single_block, 4096);
+        int ret2 = read(file_desc, (char *)single_block, 4096);
 #endif
-            TIMER_STOP(read_every_100);
-            if (((off_t)-1) == ret1)
-            {
-                osrm::util::SimpleLogger().Write(logWARNING) << "offset: " << current_offset;
-                osrm::util::SimpleLogger().Write(logWARNING) << "seek error " << strerror(errno);
-                throw osrm::util::exception("seek error");
-            }
-            if (-1 == ret2)
-            {
-                osrm::util::SimpleLogger().Write(logWARNING) << "offset: " << current_offset;
-                osrm::util::SimpleLogger().Write(logWARNING) << "read error " << strerror(errno);
-                throw osrm::util::exception("read error");
-            }
-            timing_results_raw_seq.push_back(TIMER_SEC(read_every_100));
+        TIMER_STOP(read_every_100);
+        if (((off_t)-1) == ret1)
+        {
+            util::SimpleLogger().Write(logWARNING) << "offset: " << current_offset;
+            util::SimpleLogger().Write(logWARNING) << "seek error " << strerror(errno);
+            throw util::exception("seek error");
         }
+        if (-1 == ret2)
+        {
+            util::SimpleLogger().Write(logWARNING) << "offset: " << current_offset;
+            util::SimpleLogger().Write(logWARNING) << "read error " << strerror(errno);
+            throw util::exception("read error");
+        }
+        timing_results_raw_seq.push_back(TIMER_SEC(read_every_100));
+    }
 #ifdef __APPLE__
-        fclose(fd);
-        // free(single_element);
-        free(raw_array);
+    fclose(fd);
+    // free(single_element);
+    free(raw_array);
 // free(single_block);
 #endif
 #ifdef __linux__
+    close(file_desc);
+#endif
+    // Do statistics
+    util::SimpleLogger().Write(logDEBUG) << "running sequential I/O statistics";
+    // print simple statistics: min, max, median, variance
+    std::ofstream seq_csv("sequential.csv", std::ios::trunc);
+    for (unsigned i = 0; i < timing_results_raw_seq.size(); ++i)
+    {
+        seq_csv << i << ", " << timing_results_raw_seq[i] << std::endl;
+    }
+    runStatistics(timing_results_raw_seq, stats);
+    util::SimpleLogger().Write() << "raw sequential I/O: " << std::setprecision(5)
+                                       << std::fixed << "min: " << stats.min << "ms, "
+                                       << "mean: " << stats.mean << "ms, "
+                                       << "med: " << stats.med << "ms, "
+                                       << "max: " << stats.max << "ms, "
+                                       << "dev: " << stats.dev << "ms";
+
+    if (boost::filesystem::exists(test_path))
+    {
+        boost::filesystem::remove(test_path);
+        util::SimpleLogger().Write(logDEBUG) << "removing temporary files";
+    }
+    return EXIT_SUCCESS;
+}
+
+// Page faults of the process and bytes it read from storage, which includes the pages of
+// memory mapped files. The bytes are only known on Linux.
+struct IOCounters
+{
+    std::uint64_t major_faults = 0;
+    std::uint64_t minor_faults = 0;
+    std::uint64_t read_bytes = 0;
+
+    static IOCounters Now()
+    {
+        IOCounters counters;
+#if defined(__unix__) || defined(__APPLE__)
+        struct rusage usage;
+        if (::getrusage(RUSAGE_SELF, &usage) == 0)
+        {
+            counters.major_faults = usage.ru_majflt;
+            counters.minor_faults = usage.ru_minflt;
+        }
+#endif
+        std::ifstream io_stream("/proc/self/io");
+        std::string key;
+        std::uint64_t value;
+        while (io_stream >> key >> value)
+        {
+            if (key == "read_bytes:")
+            {
+                counters.read_bytes = value;
+            }
+        }
+        return counters;
+    }
+};
+
+// Drops the cached pages of a file so that the accesses read it from the device. Pages that
+// are mapped by a process stay cached, tmpfs keeps all of them.
+void evictFile(const boost::filesystem::path &path)
+{
+#ifdef __linux__
+    const int file_desc = open(path.string().c_str(), O_RDONLY);
+    if (-1 == file_desc || 0 != posix_fadvise(file_desc, 0, 0, POSIX_FADV_DONTNEED))
+    {
+        util::SimpleLogger().Write(logWARNING) << "could not evict " << path.string()
+                                               << " from the page cache";
+    }
+    if (-1 != file_desc)
+    {
         close(file_desc);
+    }
+#else
+    util::SimpleLogger().Write(logWARNING) << "can not evict " << path.string()
+                                           << " from the page cache on this platform";
 #endif
-        // Do statistics
-        osrm::util::SimpleLogger().Write(logDEBUG) << "running sequential I/O statistics";
-        // print simple statistics: min, max, median, variance
-        std::ofstream seq_csv("sequential.csv", std::ios::trunc);
-        for (unsigned i = 0; i < timing_results_raw_seq.size(); ++i)
+}
+
+// Times every access and reports the latencies with the page faults and bytes read per access
+template <typename AccessT>
+void runAccesses(const std::string &name, const unsigned number_of_accesses, AccessT &&access)
+{
+    std::vector<double> timings;
+    timings.reserve(number_of_accesses);
+
+    const auto before = IOCounters::Now();
+    for (unsigned index = 0; index < number_of_accesses; ++index)
+    {
+        TIMER_START(access);
+        access(index);
+        TIMER_STOP(access);
+        timings.push_back(TIMER_USEC(access));
+    }
+    const auto after = IOCounters::Now();
+
+    Statistics stats;
+    runStatistics(timings, stats);
+    const double accesses = number_of_accesses;
+    util::SimpleLogger().Write()
+        << name << ": " << std::setprecision(2) << std::fixed << "mean: " << stats.mean << "us, "
+        << "med: " << stats.med << "us, "
+        << "p90: " << stats.p90 << "us, "
+        << "p99: " << stats.p99 << "us, "
+        << "max: " << stats.max << "us, "
+        << "major faults: " << (after.major_faults - before.major_faults) / accesses << ", "
+        << "minor faults: " << (after.minor_faults - before.minor_faults) / accesses << ", "
+        << "read: " << (after.read_bytes - before.read_bytes) / accesses / 1024. << "KB"
+        << " per access";
+}
+
+struct DatasetOptions
+{
+    unsigned number_of_queries;
+    unsigned max_search_nodes;
+    unsigned path_segments;
+    unsigned seed;
+    bool warm;
+};
+
+// Replays the accesses of queries to the files of a dataset that osrm-routed reads from disk
+// or could map instead of loading them:
+//  - r-tree: nearest segment queries at random coordinates, the upper levels of the tree are
+//    in memory and the leaves are read from the mapped .fileIndex like osrm-routed does
+//  - .hsgr: the search spaces of the hierarchy from random nodes, following the edges of every
+//    node up the hierarchy, which is what a search scans
+//  - .geometry: the geometries of the segments around the query coordinates, read like
+//    unpacking a path reads the geometries of its segments
+// Unless warm, every file is evicted from the page cache before its accesses.
+void runDatasetBenchmark(const boost::filesystem::path &base, const DatasetOptions &options)
+{
+    const std::string base_path = base.string();
+    const boost::filesystem::path nodes_path = base_path + ".nodes";
+    const boost::filesystem::path ram_index_path = base_path + ".ramIndex";
+    const boost::filesystem::path file_index_path = base_path + ".fileIndex";
+    const boost::filesystem::path hsgr_path = base_path + ".hsgr";
+    const boost::filesystem::path geometry_path = base_path + ".geometry";
+    for (const auto &path :
+         {nodes_path, ram_index_path, file_index_path, hsgr_path, geometry_path})
+    {
+        if (!boost::filesystem::exists(path))
         {
-            seq_csv << i << ", " << timing_results_raw_seq[i] << std::endl;
+            throw util::exception(path.string() + " does not exist");
         }
-        osrm::tools::runStatistics(timing_results_raw_seq, stats);
-        osrm::util::SimpleLogger().Write() << "raw sequential I/O: " << std::setprecision(5)
-                                           << std::fixed << "min: " << stats.min << "ms, "
-                                           << "mean: " << stats.mean << "ms, "
-                                           << "med: " << stats.med << "ms, "
-                                           << "max: " << stats.max << "ms, "
-                                           << "dev: " << stats.dev << "ms";
-
-        if (boost::filesystem::exists(test_path))
+    }
+
+    // the coordinates are always in memory
+    boost::filesystem::ifstream nodes_stream(nodes_path, std::ios::binary);
+    const auto number_of_coordinates = storage::io::readElementCount(nodes_stream);
+    if (number_of_coordinates == 0)
+    {
+        throw util::exception(nodes_path.string() + " has no nodes");
+    }
+    std::vector<util::Coordinate> coordinates(number_of_coordinates);
+    std::vector<OSMNodeID> osm_node_ids;
+    storage::io::readNodes(nodes_stream, coordinates.data(), osm_node_ids, number_of_coordinates);
+    util::CoordinateList<false> coordinate_list(coordinates);
+
+    std::mt19937 generator(options.seed);
+    std::uniform_int_distribution<std::uint64_t> coordinate_distribution(
+        0, number_of_coordinates - 1);
+    std::vector<util::Coordinate> query_coordinates(options.number_of_queries);
+    for (auto &coordinate : query_coordinates)
+    {
+        coordinate = coordinates[coordinate_distribution(generator)];
+    }
+
+    std::uint64_t checksum = 0;
+
+    using RTree =
+        util::StaticRTree<extractor::EdgeBasedNodeSegment, util::CoordinateList<false>, false>;
+    std::vector<std::vector<unsigned>> path_geometries(options.number_of_queries);
+    {
+        if (!options.warm)
         {
-            boost::filesystem::remove(test_path);
-            osrm::util::SimpleLogger().Write(logDEBUG) << "removing temporary files";
+            evictFile(file_index_path);
+        }
+        const RTree rtree(ram_index_path, file_index_path, coordinate_list);
+        runAccesses("r-tree leaves", options.number_of_queries, [&](const unsigned index) {
+            checksum += rtree.Nearest(query_coordinates[index], 1).size();
+        });
+
+        // the segments around a coordinate stand in for the segments of a path through it
+        for (const auto index : util::irange(0u, options.number_of_queries))
+        {
+            for (const auto &segment :
+                 rtree.Nearest(query_coordinates[index], options.path_segments))
+            {
+                path_geometries[index].push_back(segment.packed_geometry_id);
+            }
         }
     }
-    return EXIT_SUCCESS;
+
+    {
+        if (!options.warm)
+        {
+            evictFile(hsgr_path);
+        }
+        using NodeT = engine::QueryGraph<false>::FileNodeEntry;
+        using EdgeT = engine::QueryGraph<false>::FileEdgeEntry;
+        boost::iostreams::mapped_file_source hsgr_region(hsgr_path);
+        if (hsgr_region.size() < sizeof(util::FingerPrint) + sizeof(storage::io::HSGRHeader))
+        {
+            throw util::exception(hsgr_path.string() + " is truncated");
+        }
+        const char *hsgr_data = hsgr_region.data() + sizeof(util::FingerPrint);
+        const auto header = *reinterpret_cast<const storage::io::HSGRHeader *>(hsgr_data);
+        const auto *nodes = reinterpret_cast<const NodeT *>(hsgr_data + sizeof(header));
+        const auto *edges = reinterpret_cast<const EdgeT *>(nodes + header.number_of_nodes);
+        if (hsgr_region.size() < sizeof(util::FingerPrint) + sizeof(header) +
+                                     header.number_of_nodes * sizeof(NodeT) +
+                                     header.number_of_edges * sizeof(EdgeT) ||
+            header.number_of_nodes < 2)
+        {
+            throw util::exception(hsgr_path.string() + " is truncated");
+        }
+
+        // the last entry of the node array is a sentinel
+        std::uniform_int_distribution<NodeID> node_distribution(0, header.number_of_nodes - 2);
+        std::vector<NodeID> start_nodes(options.number_of_queries);
+        for (auto &node : start_nodes)
+        {
+            node = node_distribution(generator);
+        }
+
+        std::vector<NodeID> queue;
+        std::unordered_set<NodeID> visited;
+        runAccesses("hsgr searches", options.number_of_queries, [&](const unsigned index) {
+            queue.assign(1, start_nodes[index]);
+            visited.clear();
+            visited.insert(start_nodes[index]);
+            for (std::size_t position = 0;
+                 position < queue.size() && position < options.max_search_nodes;
+                 ++position)
+            {
+                const auto node = queue[position];
+                for (auto edge = nodes[node].first_edge; edge < nodes[node + 1].first_edge; ++edge)
+                {
+                    checksum += edges[edge].data.weight;
+                    if (visited.insert(edges[edge].target).second)
+                    {
+                        queue.push_back(edges[edge].target);
+                    }
+                }
+            }
+        });
+    }
+
+    {
+        if (!options.warm)
+        {
+            evictFile(geometry_path);
+        }
+        boost::iostreams::mapped_file_source geometry_region(geometry_path);
+        const auto *geometry_data = reinterpret_cast<const unsigned *>(geometry_region.data());
+        const auto number_of_indices = geometry_data[0];
+        const auto *indices = geometry_data + 1;
+        const auto number_of_geometries = indices[number_of_indices];
+        const auto *geometry_nodes =
+            reinterpret_cast<const NodeID *>(indices + number_of_indices + 1);
+        const auto *forward_weights =
+            reinterpret_cast<const EdgeWeight *>(geometry_nodes + number_of_geometries);
+        const auto *reverse_weights = forward_weights + number_of_geometries;
+
+        runAccesses("geometry unpacking", options.number_of_queries, [&](const unsigned index) {
+            for (const auto geometry : path_geometries[index])
+            {
+                if (geometry + 1 >= number_of_indices)
+                {
+                    continue;
+                }
+                for (auto position = indices[geometry]; position < indices[geometry + 1];
+                     ++position)
+                {
+                    checksum += geometry_nodes[position] + forward_weights[position] +
+                                reverse_weights[position];
+                }
+            }
+        });
+    }
+
+    util::SimpleLogger().Write(logDEBUG) << "checksum: " << checksum;
+}
+}
+}
+
+int main(int argc, char *argv[]) try
+{
+#ifdef __FreeBSD__
+    osrm::util::SimpleLogger().Write() << "Not supported on FreeBSD";
+    return 0;
 #endif
+#ifdef _WIN32
+    osrm::util::SimpleLogger().Write() << "Not supported on Windows";
+    return 0;
+#else
+    using namespace osrm;
+    util::LogPolicy::GetInstance().Unmute();
+
+    using boost::program_options::value;
+    boost::filesystem::path path;
+    bool create = false;
+    tools::DatasetOptions options;
+
+    boost::program_options::options_description generic_options("Options");
+    generic_options.add_options()("help,h", "Show this help message");
+
+    boost::program_options::options_description config_options("Configuration");
+    config_options.add_options() //
+        ("create",
+         value<bool>(&create)->implicit_value(true)->default_value(false),
+         "Write the 1GB test file of the device benchmark to the directory") //
+        ("queries,n",
+         value<unsigned>(&options.number_of_queries)->default_value(1000),
+         "Number of queries replayed against a dataset") //
+        ("search-nodes",
+         value<unsigned>(&options.max_search_nodes)->default_value(10000),
+         "Largest number of nodes a replayed search of the hierarchy scans") //
+        ("path-segments",
+         value<unsigned>(&options.path_segments)->default_value(100),
+         "Number of segments whose geometries a replayed path unpacks") //
+        ("seed", value<unsigned>(&options.seed)->default_value(42), "Seed of the queries") //
+        ("warm",
+         value<bool>(&options.warm)->implicit_value(true)->default_value(false),
+         "Keep the dataset files in the page cache instead of evicting them first");
+
+    boost::program_options::options_description hidden_options("Hidden options");
+    hidden_options.add_options()(
+        "path", value<boost::filesystem::path>(&path), "directory on the device or .osrm dataset");
+
+    boost::program_options::positional_options_description positional_options;
+    positional_options.add("path", 1);
+
+    boost::program_options::options_description cmdline_options;
+    cmdline_options.add(generic_options).add(config_options).add(hidden_options);
+
+    boost::program_options::options_description visible_options(
+        boost::filesystem::path(argv[0]).filename().string() +
+        " </path/on/device | data.osrm> [<options>]");
+    visible_options.add(generic_options).add(config_options);
+
+    boost::program_options::variables_map option_variables;
+    try
+    {
+        boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+                                          .options(cmdline_options)
+                                          .positional(positional_options)
+                                          .run(),
+                                      option_variables);
+    }
+    catch (const boost::program_options::error &e)
+    {
+        util::SimpleLogger().Write(logWARNING) << "[error] " << e.what();
+        return EXIT_FAILURE;
+    }
+
+    if (option_variables.count("help") || !option_variables.count("path"))
+    {
+        util::SimpleLogger().Write() << visible_options;
+        return option_variables.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    boost::program_options::notify(option_variables);
+
+    if (!boost::filesystem::is_directory(path))
+    {
+        if (options.number_of_queries == 0)
+        {
+            util::SimpleLogger().Write(logWARNING) << "[error] at least one query is needed";
+            return EXIT_FAILURE;
+        }
+        tools::runDatasetBenchmark(path, options);
+        return EXIT_SUCCESS;
+    }
+
+    const auto test_path = path / "osrm.tst";
+    util::SimpleLogger().Write(logDEBUG) << "temporary file: " << test_path.string();
+    if (create)
+    {
+        tools::createTestFile(test_path);
+        return EXIT_SUCCESS;
+    }
+    return tools::runDeviceBenchmark(test_path);
+#endif
+}
+catch (const std::exception &e)
+{
+    osrm::util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    return EXIT_FAILURE;
 }
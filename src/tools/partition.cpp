@@ -0,0 +1,128 @@
+#include "contractor/geographic_partition.hpp"
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+#include "util/simple_logger.hpp"
+#include "util/timing_util.hpp"
+#include "util/version.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+
+using namespace osrm;
+
+// Splits the edge-based nodes of a dataset into geographic cells for osrm-contract --cell. Every
+// shard contains the nodes of its cell and those of the neighbouring cells up to the overlap.
+
+int main(int argc, char *argv[]) try
+{
+    util::LogPolicy::GetInstance().Unmute();
+
+    boost::filesystem::path input_path;
+    unsigned number_of_cells = 0;
+    double overlap = 0;
+
+    boost::program_options::options_description generic_options("Options");
+    generic_options.add_options()("version,v", "Show version")("help,h", "Show this help message");
+
+    boost::program_options::options_description config_options("Configuration");
+    config_options.add_options()(
+        "cells",
+        boost::program_options::value<unsigned>(&number_of_cells)->default_value(16),
+        "Number of cells")("overlap",
+                           boost::program_options::value<double>(&overlap)->default_value(5000),
+                           "Meters the shard of a cell extends into its neighbours");
+
+    boost::program_options::options_description hidden_options("Hidden options");
+    hidden_options.add_options()(
+        "input", boost::program_options::value<boost::filesystem::path>(&input_path), "Input");
+
+    boost::program_options::positional_options_description positional_options;
+    positional_options.add("input", 1);
+
+    boost::program_options::options_description cmdline_options;
+    cmdline_options.add(generic_options).add(config_options).add(hidden_options);
+
+    boost::program_options::options_description visible_options(
+        boost::filesystem::path(argv[0]).filename().string() + " <input.osrm> [options]");
+    visible_options.add(generic_options).add(config_options);
+
+    boost::program_options::variables_map option_variables;
+    try
+    {
+        boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+                                          .options(cmdline_options)
+                                          .positional(positional_options)
+                                          .run(),
+                                      option_variables);
+        if (option_variables.count("version"))
+        {
+            util::SimpleLogger().Write() << OSRM_VERSION;
+            return EXIT_SUCCESS;
+        }
+        if (option_variables.count("help") || !option_variables.count("input"))
+        {
+            util::SimpleLogger().Write() << visible_options;
+            return EXIT_SUCCESS;
+        }
+        boost::program_options::notify(option_variables);
+    }
+    catch (const boost::program_options::error &e)
+    {
+        util::SimpleLogger().Write(logWARNING) << "[error] " << e.what();
+        return EXIT_FAILURE;
+    }
+
+    if (number_of_cells < 1 || overlap < 0)
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "There has to be at least one cell and the overlap can not be negative";
+        return EXIT_FAILURE;
+    }
+
+    const auto base = input_path.string();
+    util::SimpleLogger().Write() << "Reading the locations of the edge-based nodes ...";
+    const auto coordinates =
+        contractor::readEdgeBasedNodeCoordinates(base + ".nodes", base + ".fileIndex");
+
+    TIMER_START(partition);
+    const auto partition =
+        contractor::partitionByCoordinates(coordinates, number_of_cells, overlap);
+    TIMER_STOP(partition);
+
+    const auto unlocated_nodes = std::count(partition.node_cells.begin(),
+                                            partition.node_cells.end(),
+                                            contractor::INVALID_CELL_ID);
+    if (unlocated_nodes > 0)
+    {
+        util::SimpleLogger().Write(logWARNING) << unlocated_nodes
+                                               << " nodes have no location and no cell";
+    }
+    for (const auto cell : util::irange<contractor::CellID>(0, partition.NumberOfCells()))
+    {
+        util::SimpleLogger().Write() << "Cell " << cell << ": "
+                                     << partition.shard_offsets[cell + 1] -
+                                            partition.shard_offsets[cell]
+                                     << " nodes in its shard";
+    }
+
+    contractor::writePartition(base + ".cells", partition);
+    util::SimpleLogger().Write() << "Partitioned " << partition.node_cells.size()
+                                 << " nodes into " << number_of_cells << " cells in "
+                                 << TIMER_SEC(partition) << "s";
+
+    return EXIT_SUCCESS;
+}
+catch (const util::exception &e)
+{
+    util::SimpleLogger().Write(logWARNING) << "[error] " << e.what();
+    return EXIT_FAILURE;
+}
+catch (const std::exception &e)
+{
+    util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,109 @@
+#include "extractor/raster_source.hpp"
+#include "util/exception.hpp"
+#include "util/simple_logger.hpp"
+#include "util/timing_util.hpp"
+#include "util/version.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <cstdlib>
+#include <exception>
+
+using namespace osrm;
+
+// Converts an ASCII grid raster source into a tiled raster. Profiles load the tiled file with
+// sources:load like the ASCII grid, with the same number of rows and columns.
+
+int main(int argc, char *argv[]) try
+{
+    util::LogPolicy::GetInstance().Unmute();
+
+    boost::filesystem::path input_path, output_path;
+    std::size_t rows = 0, columns = 0, tile_size = 0;
+
+    boost::program_options::options_description generic_options("Options");
+    generic_options.add_options()("version,v", "Show version")("help,h", "Show this help message");
+
+    boost::program_options::options_description config_options("Configuration");
+    config_options.add_options()(
+        "rows",
+        boost::program_options::value<std::size_t>(&rows)->required(),
+        "Number of rows of the raster source, as given to sources:load")(
+        "columns",
+        boost::program_options::value<std::size_t>(&columns)->required(),
+        "Number of columns of the raster source, as given to sources:load")(
+        "tile-size",
+        boost::program_options::value<std::size_t>(&tile_size)->default_value(256),
+        "Number of rows and columns of a tile, a power of two");
+
+    boost::program_options::options_description hidden_options("Hidden options");
+    hidden_options.add_options()(
+        "input", boost::program_options::value<boost::filesystem::path>(&input_path), "ASCII grid")(
+        "output", boost::program_options::value<boost::filesystem::path>(&output_path), "Output");
+
+    boost::program_options::positional_options_description positional_options;
+    positional_options.add("input", 1).add("output", 1);
+
+    boost::program_options::options_description cmdline_options;
+    cmdline_options.add(generic_options).add(config_options).add(hidden_options);
+
+    boost::program_options::options_description visible_options(
+        boost::filesystem::path(argv[0]).filename().string() +
+        " <input.asc> <output.raster> --rows <rows> --columns <columns> [options]");
+    visible_options.add(generic_options).add(config_options);
+
+    boost::program_options::variables_map option_variables;
+    try
+    {
+        boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+                                          .options(cmdline_options)
+                                          .positional(positional_options)
+                                          .run(),
+                                      option_variables);
+        if (option_variables.count("version"))
+        {
+            util::SimpleLogger().Write() << OSRM_VERSION;
+            return EXIT_SUCCESS;
+        }
+        if (option_variables.count("help") || !option_variables.count("input") ||
+            !option_variables.count("output"))
+        {
+            util::SimpleLogger().Write() << visible_options;
+            return EXIT_SUCCESS;
+        }
+        boost::program_options::notify(option_variables);
+    }
+    catch (const boost::program_options::error &e)
+    {
+        util::SimpleLogger().Write(logWARNING) << "[error] " << e.what();
+        return EXIT_FAILURE;
+    }
+
+    if (!boost::filesystem::is_regular_file(input_path))
+    {
+        util::SimpleLogger().Write(logWARNING) << "Input file " << input_path.string()
+                                               << " not found!";
+        return EXIT_FAILURE;
+    }
+
+    util::SimpleLogger().Write() << "Converting " << input_path.string() << " with " << rows
+                                 << " rows and " << columns << " columns into tiles of "
+                                 << tile_size << " values square ...";
+    TIMER_START(convert);
+    extractor::WriteTiledRaster(input_path, output_path, columns, rows, tile_size);
+    TIMER_STOP(convert);
+    util::SimpleLogger().Write() << "ok, after " << TIMER_SEC(convert) << "s";
+
+    return EXIT_SUCCESS;
+}
+catch (const util::exception &e)
+{
+    util::SimpleLogger().Write(logWARNING) << "[error] " << e.what();
+    return EXIT_FAILURE;
+}
+catch (const std::exception &e)
+{
+    util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,506 @@
+#include "util/simple_logger.hpp"
+
+#include <boost/asio.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cstdlib>
+
+// Replays the requests of a log against osrm-routed at a target rate. The requests are scheduled
+// at fixed intervals and their latencies are measured from the time they were scheduled, not
+// from the time a connection got around to sending them. Otherwise a stalled server would delay
+// the requests that measure it and hide the stall (coordinated omission).
+
+namespace osrm
+{
+namespace tools
+{
+
+// Latencies in microseconds with a precision of 1/64 of their magnitude
+class LatencyHistogram
+{
+    static const constexpr unsigned SUB_BUCKETS = 64;
+
+  public:
+    void Record(const std::uint64_t microseconds)
+    {
+        const auto index = BucketIndex(microseconds);
+        if (index >= counts.size())
+        {
+            counts.resize(index + 1, 0);
+        }
+        ++counts[index];
+        ++count;
+        maximum = std::max(maximum, microseconds);
+    }
+
+    void Merge(const LatencyHistogram &other)
+    {
+        if (other.counts.size() > counts.size())
+        {
+            counts.resize(other.counts.size(), 0);
+        }
+        for (std::size_t index = 0; index < other.counts.size(); ++index)
+        {
+            counts[index] += other.counts[index];
+        }
+        count += other.count;
+        maximum = std::max(maximum, other.maximum);
+    }
+
+    std::uint64_t Count() const { return count; }
+    std::uint64_t Maximum() const { return maximum; }
+
+    // the upper end of the bucket that holds the quantile
+    std::uint64_t Quantile(const double quantile) const
+    {
+        const auto rank = static_cast<std::uint64_t>(quantile * count);
+        std::uint64_t seen = 0;
+        for (std::size_t index = 0; index < counts.size(); ++index)
+        {
+            seen += counts[index];
+            if (seen > rank)
+            {
+                return std::min(maximum, BucketEnd(index));
+            }
+        }
+        return maximum;
+    }
+
+  private:
+    static std::size_t BucketIndex(const std::uint64_t value)
+    {
+        if (value < 2 * SUB_BUCKETS)
+        {
+            return value;
+        }
+        unsigned shift = 0;
+        while ((value >> shift) >= 2 * SUB_BUCKETS)
+        {
+            ++shift;
+        }
+        return SUB_BUCKETS * (shift + 1) + ((value >> shift) - SUB_BUCKETS);
+    }
+
+    static std::uint64_t BucketEnd(const std::size_t index)
+    {
+        if (index < 2 * SUB_BUCKETS)
+        {
+            return index;
+        }
+        const auto shift = index / SUB_BUCKETS - 1;
+        const auto base = (index % SUB_BUCKETS) + SUB_BUCKETS;
+        return ((base + 1) << shift) - 1;
+    }
+
+    std::vector<std::uint64_t> counts;
+    std::uint64_t count = 0;
+    std::uint64_t maximum = 0;
+};
+
+// Finds the path of a request in a line of a log. Lines of JSON objects give it as "path", "url"
+// or "uri", other lines are logs of osrm-routed or web servers, or bare paths, whose last word
+// that starts with a slash is the path.
+std::string parseRequestPath(const std::string &line)
+{
+    const auto first = line.find_first_not_of(" \t");
+    if (first == std::string::npos)
+    {
+        return {};
+    }
+
+    if (line[first] == '{')
+    {
+        for (const auto key : {"\"path\"", "\"url\"", "\"uri\""})
+        {
+            const auto key_position = line.find(key);
+            if (key_position == std::string::npos)
+            {
+                continue;
+            }
+            const auto begin = line.find('"', line.find(':', key_position) + 1);
+            const auto end = line.find('"', begin + 1);
+            if (begin != std::string::npos && end != std::string::npos)
+            {
+                return line.substr(begin + 1, end - begin - 1);
+            }
+        }
+        return {};
+    }
+
+    std::string path;
+    std::istringstream words(line);
+    std::string word;
+    while (words >> word)
+    {
+        if (!word.empty() && word.front() == '"')
+        {
+            word.erase(0, 1);
+        }
+        if (!word.empty() && word.front() == '/')
+        {
+            path = word;
+        }
+    }
+    return path;
+}
+
+std::vector<std::string> loadRequests(const boost::filesystem::path &log_path)
+{
+    boost::filesystem::ifstream log_stream(log_path);
+    if (!log_stream)
+    {
+        throw std::runtime_error("Could not open " + log_path.string() + " for reading.");
+    }
+
+    std::vector<std::string> requests;
+    std::string line;
+    while (std::getline(log_stream, line))
+    {
+        auto path = parseRequestPath(line);
+        if (!path.empty())
+        {
+            requests.push_back(std::move(path));
+        }
+    }
+    return requests;
+}
+
+struct ReplayOptions
+{
+    std::string host;
+    std::string port;
+    double rate;
+    unsigned connections;
+    std::size_t number_of_requests;
+    bool keep_alive;
+    std::string accept_encoding;
+};
+
+struct ConnectionResults
+{
+    LatencyHistogram latencies;
+    LatencyHistogram service_times;
+    std::map<unsigned, std::uint64_t> statuses;
+    std::uint64_t connection_errors = 0;
+    std::uint64_t connects = 0;
+    std::uint64_t bytes = 0;
+};
+
+// A blocking HTTP/1.1 client on one connection, it reconnects when the server closed it
+class Client
+{
+  public:
+    Client(const ReplayOptions &options)
+        : options(options), resolver(io_service), socket(io_service)
+    {
+    }
+
+    // returns the status of the response, throws on connection errors
+    unsigned Get(const std::string &path, ConnectionResults &results)
+    {
+        if (!socket.is_open())
+        {
+            boost::asio::connect(socket, resolver.resolve({options.host, options.port}));
+            socket.set_option(boost::asio::ip::tcp::no_delay(true));
+            ++results.connects;
+        }
+
+        std::string request = "GET " + path + " HTTP/1.1\r\nHost: " + options.host + "\r\n";
+        request += options.keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+        if (!options.accept_encoding.empty())
+        {
+            request += "Accept-Encoding: " + options.accept_encoding + "\r\n";
+        }
+        request += "\r\n";
+        boost::asio::write(socket, boost::asio::buffer(request));
+
+        const auto header_size = boost::asio::read_until(socket, buffer, "\r\n\r\n");
+        std::string header(boost::asio::buffers_begin(buffer.data()),
+                           boost::asio::buffers_begin(buffer.data()) + header_size);
+        buffer.consume(header_size);
+
+        unsigned status = 0;
+        std::istringstream header_stream(header);
+        std::string version;
+        header_stream >> version >> status;
+
+        std::string lower_header = header;
+        std::transform(
+            lower_header.begin(), lower_header.end(), lower_header.begin(), [](const char c) {
+                return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            });
+        // HTTP/1.1 keeps connections alive unless either side closes them
+        const auto close =
+            !options.keep_alive || lower_header.find("connection: close") != std::string::npos;
+
+        const auto length_position = lower_header.find("content-length:");
+        boost::system::error_code error;
+        if (length_position != std::string::npos)
+        {
+            const auto content_length =
+                std::stoull(lower_header.substr(length_position + sizeof("content-length:") - 1));
+            if (buffer.size() < content_length)
+            {
+                boost::asio::read(
+                    socket, buffer, boost::asio::transfer_exactly(content_length - buffer.size()));
+            }
+            results.bytes += content_length;
+            buffer.consume(content_length);
+        }
+        else
+        {
+            // without a length the body ends with the connection
+            boost::asio::read(socket, buffer, boost::asio::transfer_all(), error);
+            if (error && error != boost::asio::error::eof)
+            {
+                throw boost::system::system_error(error);
+            }
+            results.bytes += buffer.size();
+            buffer.consume(buffer.size());
+        }
+
+        if (close || error == boost::asio::error::eof)
+        {
+            Close();
+        }
+        return status;
+    }
+
+    void Close()
+    {
+        boost::system::error_code ignored;
+        socket.close(ignored);
+        buffer.consume(buffer.size());
+    }
+
+  private:
+    const ReplayOptions &options;
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::resolver resolver;
+    boost::asio::ip::tcp::socket socket;
+    boost::asio::streambuf buffer;
+};
+
+void printLatencies(const std::string &name, const LatencyHistogram &histogram)
+{
+    std::cout << std::left << std::setw(14) << name << std::right << std::fixed
+              << std::setprecision(3);
+    const std::vector<std::pair<const char *, double>> quantiles = {
+        {"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p99.9", 0.999}};
+    for (const auto &quantile : quantiles)
+    {
+        std::cout << "  " << quantile.first << " " << std::setw(9)
+                  << histogram.Quantile(quantile.second) / 1000. << " ms";
+    }
+    std::cout << "  max " << std::setw(9) << histogram.Maximum() / 1000. << " ms" << std::endl;
+}
+
+void replay(const std::vector<std::string> &requests, const ReplayOptions &options)
+{
+    using clock = std::chrono::steady_clock;
+
+    const auto interval = options.rate > 0
+                              ? std::chrono::duration_cast<clock::duration>(
+                                    std::chrono::duration<double>(1. / options.rate))
+                              : clock::duration::zero();
+    std::atomic<std::size_t> next_request{0};
+    std::vector<ConnectionResults> results(options.connections);
+
+    // starts once all connections are set up
+    const auto start = clock::now() + std::chrono::milliseconds(100);
+    const auto connection = [&](ConnectionResults &connection_results) {
+        Client client(options);
+        for (auto index = next_request++; index < options.number_of_requests;
+             index = next_request++)
+        {
+            // a closed loop sends every request as soon as the connection is free
+            const auto scheduled = options.rate > 0
+                                       ? start + interval * static_cast<clock::rep>(index)
+                                       : clock::now();
+            std::this_thread::sleep_until(scheduled);
+
+            const auto sent = clock::now();
+            try
+            {
+                const auto status = client.Get(requests[index % requests.size()],
+                                               connection_results);
+                ++connection_results.statuses[status];
+            }
+            catch (const std::exception &)
+            {
+                ++connection_results.connection_errors;
+                client.Close();
+            }
+            const auto done = clock::now();
+
+            connection_results.latencies.Record(
+                std::chrono::duration_cast<std::chrono::microseconds>(done - scheduled).count());
+            connection_results.service_times.Record(
+                std::chrono::duration_cast<std::chrono::microseconds>(done - sent).count());
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (auto &connection_results : results)
+    {
+        threads.emplace_back(connection, std::ref(connection_results));
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    const auto seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    ConnectionResults total;
+    for (const auto &connection_results : results)
+    {
+        total.latencies.Merge(connection_results.latencies);
+        total.service_times.Merge(connection_results.service_times);
+        for (const auto &status : connection_results.statuses)
+        {
+            total.statuses[status.first] += status.second;
+        }
+        total.connection_errors += connection_results.connection_errors;
+        total.connects += connection_results.connects;
+        total.bytes += connection_results.bytes;
+    }
+
+    std::cout << options.number_of_requests << " requests over " << options.connections
+              << " connections in " << std::fixed << std::setprecision(2) << seconds << " s, "
+              << std::setprecision(1) << options.number_of_requests / seconds << " requests/s";
+    if (options.rate > 0)
+    {
+        std::cout << " (target " << options.rate << ")";
+    }
+    std::cout << ", " << total.connects << " connects, " << total.bytes / seconds / 1024.
+              << " KiB/s" << std::endl;
+    for (const auto &status : total.statuses)
+    {
+        std::cout << "  status " << status.first << ": " << status.second << std::endl;
+    }
+    if (total.connection_errors > 0)
+    {
+        std::cout << "  connection errors: " << total.connection_errors << std::endl;
+    }
+    printLatencies("latency", total.latencies);
+    printLatencies("service time", total.service_times);
+}
+}
+}
+
+int main(int argc, const char *argv[]) try
+{
+    using namespace osrm;
+    util::LogPolicy::GetInstance().Unmute();
+
+    using boost::program_options::value;
+    boost::filesystem::path log_path;
+    tools::ReplayOptions options;
+    bool no_keep_alive = false;
+
+    boost::program_options::options_description generic_options("Options");
+    generic_options.add_options()("help,h", "Show this help message");
+
+    boost::program_options::options_description config_options("Configuration");
+    config_options.add_options() //
+        ("host", value<std::string>(&options.host)->default_value("127.0.0.1"), "Server host") //
+        ("port,p", value<std::string>(&options.port)->default_value("5000"), "Server port") //
+        ("rate,r",
+         value<double>(&options.rate)->default_value(0),
+         "Requests per second, 0 sends every request as soon as a connection is free") //
+        ("connections,c",
+         value<unsigned>(&options.connections)->default_value(8),
+         "Number of concurrent connections") //
+        ("requests,n",
+         value<std::size_t>(&options.number_of_requests)->default_value(0),
+         "Number of requests to send, repeating the log if it is shorter. 0 sends the log once") //
+        ("no-keep-alive",
+         value<bool>(&no_keep_alive)->implicit_value(true)->default_value(false),
+         "Open a new connection for every request") //
+        ("accept-encoding",
+         value<std::string>(&options.accept_encoding)->default_value(""),
+         "Accept-Encoding header of the requests, e.g. gzip");
+
+    boost::program_options::options_description hidden_options("Hidden options");
+    hidden_options.add_options()(
+        "log", value<boost::filesystem::path>(&log_path), "log of the requests to replay");
+
+    boost::program_options::positional_options_description positional_options;
+    positional_options.add("log", 1);
+
+    boost::program_options::options_description cmdline_options;
+    cmdline_options.add(generic_options).add(config_options).add(hidden_options);
+
+    boost::program_options::options_description visible_options(
+        boost::filesystem::path(argv[0]).filename().string() + " <requests.log> [<options>]");
+    visible_options.add(generic_options).add(config_options);
+
+    boost::program_options::variables_map option_variables;
+    try
+    {
+        boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+                                          .options(cmdline_options)
+                                          .positional(positional_options)
+                                          .run(),
+                                      option_variables);
+    }
+    catch (const boost::program_options::error &e)
+    {
+        util::SimpleLogger().Write(logWARNING) << "[error] " << e.what();
+        return EXIT_FAILURE;
+    }
+
+    if (option_variables.count("help") || !option_variables.count("log"))
+    {
+        util::SimpleLogger().Write() << visible_options;
+        return option_variables.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    boost::program_options::notify(option_variables);
+    options.keep_alive = !no_keep_alive;
+
+    if (options.connections == 0)
+    {
+        util::SimpleLogger().Write(logWARNING) << "[error] at least one connection is needed";
+        return EXIT_FAILURE;
+    }
+
+    const auto requests = tools::loadRequests(log_path);
+    if (requests.empty())
+    {
+        util::SimpleLogger().Write(logWARNING) << "[error] no requests found in " << log_path;
+        return EXIT_FAILURE;
+    }
+    if (options.number_of_requests == 0)
+    {
+        options.number_of_requests = requests.size();
+    }
+    util::SimpleLogger().Write() << "Replaying " << options.number_of_requests << " of "
+                                 << requests.size() << " requests against " << options.host
+                                 << ":" << options.port;
+
+    tools::replay(requests, options);
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    osrm::util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    return EXIT_FAILURE;
+}
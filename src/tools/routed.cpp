@@ -6,6 +6,7 @@
 #include "osrm/osrm.hpp"
 #include "osrm/storage_config.hpp"
 
+#include <boost/algorithm/string.hpp>
 #include <boost/any.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
@@ -25,6 +26,7 @@
 #include <new>
 #include <string>
 #include <thread>
+#include <vector>
 
 #ifdef _WIN32
 boost::function0<void> console_ctrl_function;
@@ -57,14 +59,42 @@ inline unsigned generateServerProgramOptions(const int argc,
                                              boost::filesystem::path &base_path,
                                              std::string &ip_address,
                                              int &ip_port,
+                                             std::string &unix_socket,
                                              int &requested_num_threads,
                                              bool &use_shared_memory,
+                                             bool &prefetch_rtree_leaves,
+                                             bool &use_huge_pages,
+                                             bool &lazy_blocks,
+                                             bool &compress_coordinates,
+                                             bool &weight_offsets,
+                                             bool &compress_geometries,
+                                             bool &use_container,
+                                             bool &numa_replicas,
+                                             std::size_t &shortcut_cache_size,
+                                             std::size_t &tile_cache_size,
+                                             std::size_t &phantom_node_cache_size,
+                                             std::size_t &route_cache_size,
+                                             std::size_t &max_target_sets,
+                                             std::size_t &search_space_cache_size,
+                                             std::size_t &max_heap_sets,
                                              bool &trial,
                                              int &max_locations_trip,
                                              int &max_locations_viaroute,
                                              int &max_locations_distance_table,
                                              int &max_locations_map_matching,
-                                             int &max_results_nearest)
+                                             int &max_results_nearest,
+                                             int &max_isochrone_duration,
+                                             int &matching_beam_width,
+                                             int &trip_improvement_time,
+                                             int &parallel_search_distance,
+                                             server::http::compression_settings &compression,
+                                             std::vector<std::string> &worker_pools,
+                                             std::vector<std::string> &profiles,
+                                             server::ThreadSettings &threading,
+                                             std::string &slow_query_log,
+                                             double &slow_query_threshold,
+                                             double &query_timeout,
+                                             std::string &algorithm)
 {
     using boost::program_options::value;
     using boost::filesystem::path;
@@ -84,12 +114,39 @@ inline unsigned generateServerProgramOptions(const int argc,
         ("port,p",
          value<int>(&ip_port)->default_value(5000),
          "TCP/IP port") //
+        ("unix-socket",
+         value<std::string>(&unix_socket),
+         "Listen on a unix domain socket at this path instead of the IP address and port") //
         ("threads,t",
          value<int>(&requested_num_threads)->default_value(8),
          "Number of threads to use") //
         ("shared-memory,s",
          value<bool>(&use_shared_memory)->implicit_value(true)->default_value(false),
          "Load data from shared memory") //
+        ("prefetch-rtree-leaves",
+         value<bool>(&prefetch_rtree_leaves)->implicit_value(true)->default_value(false),
+         "Read the r-tree leaves ahead on startup instead of on first use") //
+        ("huge-pages",
+         value<bool>(&use_huge_pages)->implicit_value(true)->default_value(false),
+         "Advise transparent huge pages for the graph and geometry data not in shared memory") //
+        ("lazy-blocks",
+         value<bool>(&lazy_blocks)->implicit_value(true)->default_value(false),
+         "Load names, lane tags, intersection classes and datasources on first use") //
+        ("compress-coordinates",
+         value<bool>(&compress_coordinates)->implicit_value(true)->default_value(false),
+         "Store the coordinates delta encoded in blocks, which takes less memory but is slower "
+         "to read") //
+        ("weight-offsets",
+         value<bool>(&weight_offsets)->implicit_value(true)->default_value(false),
+         "Store the offsets of the segments in their geometry, which takes 8 bytes per segment "
+         "but spares snapping the sums over the segments of long geometries") //
+        ("compress-geometries",
+         value<bool>(&compress_geometries)->implicit_value(true)->default_value(false),
+         "Store the nodes of the geometries delta encoded in blocks, which takes less memory but "
+         "is slower to read") //
+        ("container",
+         value<bool>(&use_container)->implicit_value(true)->default_value(false),
+         "Memory map the dataset container written by osrm-datastore --write-container") //
         ("max-viaroute-size",
          value<int>(&max_locations_viaroute)->default_value(500),
          "Max. locations supported in viaroute query") //
@@ -104,7 +161,90 @@ inline unsigned generateServerProgramOptions(const int argc,
          "Max. locations supported in map matching query") //
         ("max-nearest-size",
          value<int>(&max_results_nearest)->default_value(100),
-         "Max. results supported in nearest query");
+         "Max. results supported in nearest query") //
+        ("max-isochrone-duration",
+         value<int>(&max_isochrone_duration)->default_value(3600),
+         "Max. duration in seconds supported in isochrone query") //
+        ("matching-beam-width",
+         value<int>(&matching_beam_width)->default_value(-1),
+         "Max. candidates per trace point expanded in map matching, -1 for all") //
+        ("trip-improvement-time",
+         value<int>(&trip_improvement_time)->default_value(0),
+         "Milliseconds spent improving trips of more than 16 locations by local search, 0 "
+         "disables it") //
+        ("parallel-search-distance",
+         value<int>(&parallel_search_distance)->default_value(0),
+         "Meters between the locations of routes whose core is searched in both directions at "
+         "once on two threads, 0 disables it") //
+        ("compression-level",
+         value<int>(&compression.level)->default_value(1),
+         "Level of gzip/deflate reply compression, from 1 (fastest) to 9 (smallest)") //
+        ("compression-min-size",
+         value<std::size_t>(&compression.min_size)->default_value(0),
+         "Replies smaller than this many bytes are sent uncompressed") //
+        ("worker-pool",
+         value<std::vector<std::string>>(&worker_pools)->composing(),
+         "Run a service on its own threads, as <service>:<threads>[:<max queued requests>]. "
+         "Requests beyond the queue limit are rejected with 503") //
+        ("profile",
+         value<std::vector<std::string>>(&profiles)->composing(),
+         "Serve the dataset of another profile, as <profile>=<base.osrm>. Requests select it "
+         "by the profile of their URL, other profiles use the default dataset") //
+        ("acceptor-per-thread",
+         value<bool>(&threading.acceptor_per_thread)->implicit_value(true)->default_value(false),
+         "Run an acceptor on every thread, connections are balanced by the kernel") //
+        ("pin-threads",
+         value<bool>(&threading.pin_threads)->implicit_value(true)->default_value(false),
+         "Pin every thread to a core") //
+        ("warm-up",
+         value<bool>(&threading.warm_up)->implicit_value(true)->default_value(false),
+         "Read the r-tree leaves and allocate the search heaps of all threads before the port "
+         "accepts connections") //
+        ("numa-replicas",
+         value<bool>(&numa_replicas)->implicit_value(true)->default_value(false),
+         "Keep a copy of the dataset in the memory of every NUMA node") //
+        ("shortcut-cache-size",
+         value<std::size_t>(&shortcut_cache_size)->default_value(0),
+         "Number of frequently unpacked shortcuts whose original edges are cached, 0 disables "
+         "the cache") //
+        ("tile-cache-size",
+         value<std::size_t>(&tile_cache_size)->default_value(0),
+         "Number of recently requested debug tiles that are cached, 0 disables the cache") //
+        ("phantom-node-cache-size",
+         value<std::size_t>(&phantom_node_cache_size)->default_value(0),
+         "Number of recently requested coordinates whose snapped phantom nodes are cached, 0 "
+         "disables the cache") //
+        ("route-cache-size",
+         value<std::size_t>(&route_cache_size)->default_value(0),
+         "Megabytes of memory for the responses of recently requested routes, 0 disables the "
+         "cache") //
+        ("max-target-sets",
+         value<std::size_t>(&max_target_sets)->default_value(0),
+         "Number of target sets registered by table queries whose backward searches are kept, 0 "
+         "disables target sets") //
+        ("search-space-cache-size",
+         value<std::size_t>(&search_space_cache_size)->default_value(0),
+         "Number of recently used table sources whose upward searches are cached, 0 disables the "
+         "cache") //
+        ("max-heap-sets",
+         value<std::size_t>(&max_heap_sets)->default_value(0),
+         "Number of queries that search at the same time with pooled heaps, the others wait for "
+         "a free set, 0 for no limit") //
+        ("slow-query-log",
+         value<std::string>(&slow_query_log),
+         "Append the requests slower than --slow-query-threshold to this file, as JSON lines with "
+         "the time of their phases and the counters of their searches") //
+        ("slow-query-threshold",
+         value<double>(&slow_query_threshold)->default_value(100),
+         "Milliseconds after which a request counts as slow") //
+        ("query-timeout",
+         value<double>(&query_timeout)->default_value(0),
+         "Milliseconds after which a query is stopped with a Timeout error, clients can ask for "
+         "less with the X-OSRM-Timeout header. 0 leaves the timeout to the clients.") //
+        ("algorithm",
+         value<std::string>(&algorithm)->default_value("ch"),
+         "Algorithm of the route queries: ch or mld, which searches the overlay graph of "
+         "osrm-contract --mld. The other services always use the contraction hierarchy.");
 
     // hidden options, will be allowed on command line, but will not be shown to the user
     boost::program_options::options_description hidden_options("Hidden options");
@@ -154,6 +294,24 @@ inline unsigned generateServerProgramOptions(const int argc,
 
     boost::program_options::notify(option_variables);
 
+    if (compression.level < 1 || compression.level > 9)
+    {
+        util::SimpleLogger().Write(logWARNING) << "[error] compression level has to be in 1..9";
+        return INIT_FAILED;
+    }
+
+    if (algorithm != "ch" && algorithm != "mld")
+    {
+        util::SimpleLogger().Write(logWARNING) << "[error] algorithm has to be ch or mld";
+        return INIT_FAILED;
+    }
+    if (algorithm == "mld" && (use_shared_memory || use_container))
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "[error] the mld algorithm only loads the dataset from files";
+        return INIT_FAILED;
+    }
+
     if (!use_shared_memory && option_variables.count("base"))
     {
         return INIT_OK_START_ENGINE;
@@ -175,10 +333,21 @@ inline unsigned generateServerProgramOptions(const int argc,
 int main(int argc, const char *argv[]) try
 {
     util::LogPolicy::GetInstance().Unmute();
+    // the access log of all request threads goes through a writer thread of its own
+    util::LogPolicy::GetInstance().EnableAsyncOutput();
 
     bool trial_run = false;
     std::string ip_address;
     int ip_port, requested_thread_num;
+    std::string unix_socket;
+    server::http::compression_settings compression;
+    std::vector<std::string> worker_pools;
+    std::vector<std::string> profiles;
+    server::ThreadSettings threading;
+    std::string slow_query_log;
+    double slow_query_threshold;
+    double query_timeout;
+    std::string algorithm;
 
     EngineConfig config;
     boost::filesystem::path base_path;
@@ -187,14 +356,42 @@ int main(int argc, const char *argv[]) try
                                                               base_path,
                                                               ip_address,
                                                               ip_port,
+                                                              unix_socket,
                                                               requested_thread_num,
                                                               config.use_shared_memory,
+                                                              config.prefetch_rtree_leaves,
+                                                              config.use_huge_pages,
+                                                              config.lazy_blocks,
+                                                              config.compress_coordinates,
+                                                              config.weight_offsets,
+                                                              config.compress_geometries,
+                                                              config.use_container,
+                                                              config.numa_replicas,
+                                                              config.shortcut_cache_size,
+                                                              config.tile_cache_size,
+                                                              config.phantom_node_cache_size,
+                                                              config.route_cache_size,
+                                                              config.max_target_sets,
+                                                              config.search_space_cache_size,
+                                                              config.max_heap_sets,
                                                               trial_run,
                                                               config.max_locations_trip,
                                                               config.max_locations_viaroute,
                                                               config.max_locations_distance_table,
                                                               config.max_locations_map_matching,
-                                                              config.max_results_nearest);
+                                                              config.max_results_nearest,
+                                                              config.max_isochrone_duration,
+                                                              config.matching_beam_width,
+                                                              config.trip_improvement_time,
+                                                              config.parallel_search_distance,
+                                                              compression,
+                                                              worker_pools,
+                                                              profiles,
+                                                              threading,
+                                                              slow_query_log,
+                                                              slow_query_threshold,
+                                                              query_timeout,
+                                                              algorithm);
     if (init_result == INIT_OK_DO_NOT_START_ENGINE)
     {
         return EXIT_SUCCESS;
@@ -203,10 +400,37 @@ int main(int argc, const char *argv[]) try
     {
         return EXIT_FAILURE;
     }
+    config.algorithm =
+        algorithm == "mld" ? EngineConfig::Algorithm::MLD : EngineConfig::Algorithm::CH;
+    // the io threads have to run on all nodes to make use of the replicas
+    threading.bind_numa_nodes = config.numa_replicas;
+    config.prefetch_rtree_leaves = config.prefetch_rtree_leaves || threading.warm_up;
     if (!base_path.empty())
     {
         config.storage_config = storage::StorageConfig(base_path);
     }
+    for (const auto &profile : profiles)
+    {
+        const auto separator = profile.find('=');
+        if (separator == 0 || separator == std::string::npos || separator + 1 == profile.size())
+        {
+            util::SimpleLogger().Write(logWARNING) << "[error] invalid profile " << profile;
+            return EXIT_FAILURE;
+        }
+        const auto name = profile.substr(0, separator);
+        const storage::StorageConfig profile_config(profile.substr(separator + 1));
+        const auto found = config.use_container
+                               ? boost::filesystem::is_regular_file(profile_config.container_path)
+                               : profile_config.IsValid();
+        if (!found)
+        {
+            util::SimpleLogger().Write(logWARNING) << "[error] the dataset of the profile " << name
+                                                   << " is not found";
+            return EXIT_FAILURE;
+        }
+        config.profiles[name] = profile_config;
+        util::SimpleLogger().Write() << "profile: " << profile;
+    }
     if (!config.IsValid())
     {
         if (base_path.empty() != config.use_shared_memory)
@@ -215,6 +439,12 @@ int main(int argc, const char *argv[]) try
         }
         else
         {
+            if (config.use_container &&
+                !boost::filesystem::is_regular_file(config.storage_config.container_path))
+            {
+                util::SimpleLogger().Write(logWARNING) << config.storage_config.container_path
+                                                       << " is not found";
+            }
             if (!boost::filesystem::is_regular_file(config.storage_config.ram_index_path))
             {
                 util::SimpleLogger().Write(logWARNING) << config.storage_config.ram_index_path
@@ -240,6 +470,12 @@ int main(int argc, const char *argv[]) try
                 util::SimpleLogger().Write(logWARNING) << config.storage_config.edges_data_path
                                                        << " is not found";
             }
+            if (!boost::filesystem::is_regular_file(
+                    config.storage_config.edge_based_nodes_data_path))
+            {
+                util::SimpleLogger().Write(logWARNING)
+                    << config.storage_config.edge_based_nodes_data_path << " is not found";
+            }
             if (!boost::filesystem::is_regular_file(config.storage_config.core_data_path))
             {
                 util::SimpleLogger().Write(logWARNING) << config.storage_config.core_data_path
@@ -306,8 +542,15 @@ int main(int argc, const char *argv[]) try
     }
 
     util::SimpleLogger().Write() << "Threads: " << requested_thread_num;
-    util::SimpleLogger().Write() << "IP address: " << ip_address;
-    util::SimpleLogger().Write() << "IP port: " << ip_port;
+    if (unix_socket.empty())
+    {
+        util::SimpleLogger().Write() << "IP address: " << ip_address;
+        util::SimpleLogger().Write() << "IP port: " << ip_port;
+    }
+    else
+    {
+        util::SimpleLogger().Write() << "Unix domain socket: " << unix_socket;
+    }
 
 #ifndef _WIN32
     int sig = 0;
@@ -317,11 +560,58 @@ int main(int argc, const char *argv[]) try
     pthread_sigmask(SIG_BLOCK, &new_mask, &old_mask);
 #endif
 
-    auto routing_server = server::Server::CreateServer(ip_address, ip_port, requested_thread_num);
+    auto routing_server = server::Server::CreateServer(
+        ip_address, ip_port, requested_thread_num, compression, threading, unix_socket);
     auto service_handler = std::make_unique<server::ServiceHandler>(config);
 
+    for (const auto &worker_pool : worker_pools)
+    {
+        std::vector<std::string> fields;
+        boost::split(fields, worker_pool, boost::is_any_of(":"));
+
+        bool valid = fields.size() == 2 || fields.size() == 3;
+        try
+        {
+            const auto num_threads = valid ? std::stoul(fields[1]) : 0;
+            const auto max_queued_requests = fields.size() == 3 ? std::stoul(fields[2]) : 0;
+            valid = valid &&
+                    service_handler->AddWorkerPool(
+                        fields[0], num_threads, max_queued_requests, threading.warm_up);
+        }
+        catch (const std::logic_error &)
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            util::SimpleLogger().Write(logWARNING) << "[error] invalid worker pool "
+                                                   << worker_pool;
+            return EXIT_FAILURE;
+        }
+        util::SimpleLogger().Write() << "worker pool: " << worker_pool;
+    }
+
     routing_server->RegisterServiceHandler(std::move(service_handler));
 
+    if (!slow_query_log.empty())
+    {
+        routing_server->RegisterSlowQueryLog(std::make_unique<server::SlowQueryLog>(
+            slow_query_log,
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double, std::milli>(slow_query_threshold))));
+        util::SimpleLogger().Write() << "slow query log: " << slow_query_log << ", threshold "
+                                     << slow_query_threshold << "ms";
+    }
+
+    if (query_timeout > 0)
+    {
+        routing_server->SetQueryTimeout(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double, std::milli>(query_timeout)));
+        util::SimpleLogger().Write() << "query timeout: " << query_timeout << "ms";
+    }
+
     if (trial_run)
     {
         util::SimpleLogger().Write() << "trial run, quitting after successful initialization";
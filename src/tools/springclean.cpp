@@ -29,6 +29,10 @@ void deleteRegion(const SharedDataType region)
                 return "LAYOUT_2";
             case DATA_2:
                 return "DATA_2";
+            case METRIC_1:
+                return "METRIC_1";
+            case METRIC_2:
+                return "METRIC_2";
             case LAYOUT_NONE:
                 return "LAYOUT_NONE";
             default: // DATA_NONE:
@@ -48,6 +52,8 @@ void springclean()
     deleteRegion(LAYOUT_1);
     deleteRegion(DATA_2);
     deleteRegion(LAYOUT_2);
+    deleteRegion(METRIC_1);
+    deleteRegion(METRIC_2);
     deleteRegion(CURRENT_REGIONS);
 }
 }
@@ -1,3 +1,4 @@
+#include "storage/inspect.hpp"
 #include "storage/storage.hpp"
 #include "util/exception.hpp"
 #include "util/simple_logger.hpp"
@@ -7,13 +8,31 @@
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 
+#include <string>
+#include <utility>
+#include <vector>
+
 using namespace osrm;
 
 // generate boost::program_options object for the routing part
 bool generateDataStoreOptions(const int argc,
                               const char *argv[],
                               boost::filesystem::path &base_path,
-                              int &max_wait)
+                              int &max_wait,
+                              bool &from_container,
+                              bool &write_container,
+                              bool &from_package,
+                              bool &write_package,
+                              int &package_level,
+                              boost::filesystem::path &package_path,
+                              boost::filesystem::path &delta_base,
+                              bool &only_metric,
+                              bool &huge_pages,
+                              bool &compress_coordinates,
+                              bool &weight_offsets,
+                              bool &compress_geometries,
+                              bool &list,
+                              std::vector<std::string> &metrics)
 {
     // declare a group of options that will be allowed only on command line
     boost::program_options::options_description generic_options("Options");
@@ -25,7 +44,68 @@ bool generateDataStoreOptions(const int argc,
     config_options.add_options()(
         "max-wait",
         boost::program_options::value<int>(&max_wait)->default_value(-1),
-        "Maximum number of seconds to wait on requests that use the old dataset.");
+        "Maximum number of seconds to wait for clients attaching the current dataset.")(
+        "from-container",
+        boost::program_options::value<bool>(&from_container)->implicit_value(true)->default_value(
+            false),
+        "Load the dataset from the container instead of the individual files.")(
+        "write-container",
+        boost::program_options::value<bool>(&write_container)->implicit_value(true)->default_value(
+            false),
+        "Write the dataset to a container that can be memory mapped, then exit.")(
+        "from-package",
+        boost::program_options::value<bool>(&from_package)->implicit_value(true)->default_value(
+            false),
+        "Load the dataset from the package instead of the individual files.")(
+        "write-package",
+        boost::program_options::value<bool>(&write_package)->implicit_value(true)->default_value(
+            false),
+        "Write the dataset to a package with compressed blocks for distribution, then exit.")(
+        "package-level",
+        boost::program_options::value<int>(&package_level)->default_value(3),
+        "zstd compression level of the blocks of the package, 0 stores them uncompressed.")(
+        "package",
+        boost::program_options::value<boost::filesystem::path>(&package_path),
+        "Path of the package to load or write instead of <base>.osrm.package.")(
+        "delta-from",
+        boost::program_options::value<boost::filesystem::path>(&delta_base),
+        "Write a delta package that only holds the changes to the dataset of this full package. "
+        "A delta is loaded with --from-package onto the dataset it was made against.")(
+        "only-metric",
+        boost::program_options::value<bool>(&only_metric)->implicit_value(true)->default_value(
+            false),
+        "Only load the edge weights, graph and datasources, sharing all other data with the "
+        "dataset in shared memory.")(
+        "huge-pages",
+        boost::program_options::value<bool>(&huge_pages)->implicit_value(true)->default_value(
+            false),
+        "Back the shared memory with huge pages, falling back to transparent huge pages.")(
+        "compress-coordinates",
+        boost::program_options::value<bool>(&compress_coordinates)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Store the coordinates delta encoded in blocks, which takes less memory but is slower to "
+        "read.")(
+        "weight-offsets",
+        boost::program_options::value<bool>(&weight_offsets)->implicit_value(true)->default_value(
+            false),
+        "Store the offsets of the segments in their geometry, which takes 8 bytes per segment but "
+        "spares snapping the sums over the segments of long geometries.")(
+        "compress-geometries",
+        boost::program_options::value<bool>(&compress_geometries)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Store the nodes of the geometries delta encoded in blocks, which takes less memory but "
+        "is slower to read.")(
+        "metric",
+        boost::program_options::value<std::vector<std::string>>(&metrics)->composing(),
+        "Load an additional metric written by osrm-contract --metric, sharing all other data with "
+        "the default metric.")(
+        "list",
+        boost::program_options::value<bool>(&list)->implicit_value(true)->default_value(false),
+        "List the blocks of the dataset in shared memory with their size and how much of them is "
+        "resident in memory, then exit. With --from-container the blocks of the container and how "
+        "much of them is in the page cache.");
 
     // hidden options, will be allowed on command line but will not be shown to the user
     boost::program_options::options_description hidden_options("Hidden options");
@@ -93,17 +173,143 @@ int main(const int argc, const char *argv[]) try
 
     boost::filesystem::path base_path;
     int max_wait = -1;
-    if (!generateDataStoreOptions(argc, argv, base_path, max_wait))
+    bool from_container = false;
+    bool write_container = false;
+    bool from_package = false;
+    bool write_package = false;
+    int package_level = 3;
+    boost::filesystem::path package_path;
+    boost::filesystem::path delta_base;
+    bool only_metric = false;
+    bool huge_pages = false;
+    bool compress_coordinates = false;
+    bool weight_offsets = false;
+    bool compress_geometries = false;
+    bool list = false;
+    std::vector<std::string> metrics;
+    if (!generateDataStoreOptions(argc,
+                                  argv,
+                                  base_path,
+                                  max_wait,
+                                  from_container,
+                                  write_container,
+                                  from_package,
+                                  write_package,
+                                  package_level,
+                                  package_path,
+                                  delta_base,
+                                  only_metric,
+                                  huge_pages,
+                                  compress_coordinates,
+                                  weight_offsets,
+                                  compress_geometries,
+                                  list,
+                                  metrics))
     {
         return EXIT_SUCCESS;
     }
+    if (list)
+    {
+        if (from_package || write_container || write_package)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "--list only lists shared memory or a container";
+            return EXIT_FAILURE;
+        }
+        try
+        {
+            if (from_container)
+            {
+                storage::listContainer(storage::StorageConfig(base_path).container_path);
+            }
+            else
+            {
+                storage::listSharedMemory();
+            }
+        }
+        catch (const util::exception &e)
+        {
+            util::SimpleLogger().Write(logWARNING) << e.what();
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+    if (from_container + write_container + from_package + write_package > 1)
+    {
+        util::SimpleLogger().Write(logWARNING) << "--from-container, --write-container, "
+                                                  "--from-package and --write-package are "
+                                                  "mutually exclusive";
+        return EXIT_FAILURE;
+    }
+    if (!delta_base.empty() && !write_package)
+    {
+        util::SimpleLogger().Write(logWARNING) << "--delta-from needs --write-package";
+        return EXIT_FAILURE;
+    }
+    // packages hold the same data as containers
+    from_container = from_container || from_package;
+    write_container = write_container || write_package;
+    if (only_metric && (from_container || write_container))
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "--only-metric loads the individual files, containers hold the whole dataset";
+        return EXIT_FAILURE;
+    }
+    if (!metrics.empty() && (from_container || write_container))
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "--metric loads the individual files, containers only hold the default metric";
+        return EXIT_FAILURE;
+    }
+    if (compress_coordinates && (from_container || only_metric))
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "--compress-coordinates loads the coordinates from the individual files";
+        return EXIT_FAILURE;
+    }
+    if (compress_geometries && (from_container || only_metric))
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "--compress-geometries loads the geometries from the individual files";
+        return EXIT_FAILURE;
+    }
+    if (weight_offsets && from_container)
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "--weight-offsets computes the offsets from the individual files, containers hold "
+               "the ones they were written with";
+        return EXIT_FAILURE;
+    }
     storage::StorageConfig config(base_path);
-    if (!config.IsValid())
+    config.metrics = std::move(metrics);
+    if (!package_path.empty())
+    {
+        config.package_path = package_path;
+    }
+    if (from_container ? !boost::filesystem::is_regular_file(from_package ? config.package_path
+                                                                          : config.container_path)
+                       : !config.IsValid())
     {
         util::SimpleLogger().Write(logWARNING) << "Config contains invalid file paths. Exiting!";
         return EXIT_FAILURE;
     }
-    storage::Storage storage(std::move(config));
+    storage::Storage storage(
+        std::move(config), compress_coordinates, weight_offsets, compress_geometries);
+
+    if (write_package)
+    {
+        storage.WritePackage(package_level, delta_base);
+        return EXIT_SUCCESS;
+    }
+    if (write_container)
+    {
+        storage.WriteContainer();
+        return EXIT_SUCCESS;
+    }
+
+    const auto source = from_package ? storage::Storage::Package
+                                     : from_container ? storage::Storage::Container
+                                                      : storage::Storage::Files;
 
     // We will attempt to load this dataset to memory several times if we encounter
     // an error we can recover from. This is needed when we need to clear mutexes
@@ -118,7 +324,7 @@ int main(const int argc, const char *argv[]) try
             util::SimpleLogger().Write(logWARNING) << "Try number " << (retry_counter + 1)
                                                    << " to load the dataset.";
         }
-        code = storage.Run(max_wait);
+        code = storage.Run(max_wait, source, only_metric, huge_pages);
         retry_counter++;
     }
 
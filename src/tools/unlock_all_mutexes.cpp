@@ -9,8 +9,6 @@ int main()
     osrm::util::SimpleLogger().Write() << "Releasing all locks";
 
     osrm::storage::SharedBarriers::resetCurrentRegions();
-    osrm::storage::SharedBarriers::resetRegions1();
-    osrm::storage::SharedBarriers::resetRegions2();
 
     return 0;
 }
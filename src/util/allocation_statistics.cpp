@@ -0,0 +1,62 @@
+#include "util/allocation_statistics.hpp"
+
+#ifdef OSRM_ALLOCATION_TRACKING
+
+#include <cstdlib>
+#include <new>
+
+// Builds with ENABLE_ALLOCATION_TRACKING replace the global allocation functions of every
+// binary that links the util objects, so that every allocation through operator new counts
+// into the current phase of the allocating thread.
+namespace
+{
+void *allocate(const std::size_t size)
+{
+    osrm::util::countAllocation(size);
+    while (true)
+    {
+        if (void *pointer = std::malloc(size == 0 ? 1 : size))
+        {
+            return pointer;
+        }
+        const auto handler = std::get_new_handler();
+        if (!handler)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void *allocateNoThrow(const std::size_t size) noexcept
+{
+    try
+    {
+        return allocate(size);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return nullptr;
+    }
+}
+}
+
+void *operator new(std::size_t size) { return allocate(size); }
+void *operator new[](std::size_t size) { return allocate(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocateNoThrow(size);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocateNoThrow(size);
+}
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete[](void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
+
+#endif
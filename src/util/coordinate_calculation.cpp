@@ -5,10 +5,12 @@
 
 #include <boost/assert.hpp>
 
+#include <algorithm>
 #include <cmath>
 
 #include <limits>
 #include <utility>
+#include <vector>
 
 namespace osrm
 {
@@ -110,6 +112,179 @@ double perpendicularDistance(const Coordinate source_coordinate,
         source_coordinate, target_coordinate, query_location, nearest_location, ratio);
 }
 
+namespace
+{
+// Taylor polynomials, for arguments in [-pi/2, pi/2] their absolute errors are below 1e-14
+inline double sinPolynomial(const double x)
+{
+    const double x2 = x * x;
+    return x * (1. +
+                x2 * (-1. / 6 +
+                      x2 * (1. / 120 +
+                            x2 * (-1. / 5040 +
+                                  x2 * (1. / 362880 +
+                                        x2 * (-1. / 39916800 +
+                                              x2 * (1. / 6227020800 +
+                                                    x2 * (-1. / 1307674368000. +
+                                                          x2 / 355687428096000.))))))));
+}
+
+inline double cosPolynomial(const double x)
+{
+    const double x2 = x * x;
+    return 1. +
+           x2 * (-1. / 2 +
+                 x2 * (1. / 24 +
+                       x2 * (-1. / 720 +
+                             x2 * (1. / 40320 +
+                                   x2 * (-1. / 3628800 +
+                                         x2 * (1. / 479001600 +
+                                               x2 * (-1. / 87178291200. +
+                                                     x2 / 20922789888000.)))))));
+}
+
+// Sine and cosine of an angle in [-2pi, 2pi], folded into [-pi/2, pi/2] with selects only
+inline void sinCos(double x, double &sin, double &cos)
+{
+    using namespace boost::math::constants;
+    x = x > pi<double>() ? x - two_pi<double>() : x;
+    x = x < -pi<double>() ? x + two_pi<double>() : x;
+    // sin(x) = sin(pi - x) and cos(x) = -cos(pi - x)
+    const double folded = x > half_pi<double>() ? pi<double>() - x
+                                                : (x < -half_pi<double>() ? -pi<double>() - x : x);
+    const double sign = x > half_pi<double>() || x < -half_pi<double>() ? -1. : 1.;
+    sin = sinPolynomial(folded);
+    cos = sign * cosPolynomial(folded);
+}
+
+double toRadians(const FixedLongitude value)
+{
+    return static_cast<std::int32_t>(value) / COORDINATE_PRECISION * detail::DEGREE_TO_RAD;
+}
+
+double toRadians(const FixedLatitude value)
+{
+    return static_cast<std::int32_t>(value) / COORDINATE_PRECISION * detail::DEGREE_TO_RAD;
+}
+
+// Radians of the coordinates of a batch, as arrays of their own
+struct RadianCoordinates
+{
+    explicit RadianCoordinates(const ArrayView<Coordinate> coordinates)
+        : lon(coordinates.size()), lat(coordinates.size())
+    {
+        for (std::size_t i = 0; i < coordinates.size(); ++i)
+        {
+            lon[i] = toRadians(coordinates[i].lon);
+            lat[i] = toRadians(coordinates[i].lat);
+        }
+    }
+
+    std::vector<double> lon;
+    std::vector<double> lat;
+};
+}
+
+void haversineDistances(const Coordinate source,
+                        const ArrayView<Coordinate> targets,
+                        std::vector<double> &distances)
+{
+    BOOST_ASSERT(source.IsValid());
+    const RadianCoordinates radians(targets);
+    const double source_lon = toRadians(source.lon);
+    const double source_lat = toRadians(source.lat);
+    const double cos_source_lat = std::cos(source_lat);
+    const auto count = targets.size();
+
+    // the haversine of the central angle, vectorized
+    distances.resize(count);
+    double *haversines = distances.data();
+    const double *lon = radians.lon.data();
+    const double *lat = radians.lat.data();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const double sin_half_dlat = sinPolynomial((source_lat - lat[i]) / 2.);
+        double sin_half_dlon, cos_half_dlon;
+        sinCos((source_lon - lon[i]) / 2., sin_half_dlon, cos_half_dlon);
+        haversines[i] = sin_half_dlat * sin_half_dlat +
+                        cos_source_lat * cosPolynomial(lat[i]) * sin_half_dlon * sin_half_dlon;
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const double haversine = std::min(1., std::max(0., haversines[i]));
+        distances[i] = detail::EARTH_RADIUS * 2. *
+                       std::atan2(std::sqrt(haversine), std::sqrt(1.0 - haversine));
+    }
+}
+
+void greatCircleDistances(const Coordinate source,
+                          const ArrayView<Coordinate> targets,
+                          std::vector<double> &distances)
+{
+    BOOST_ASSERT(source.IsValid());
+    const RadianCoordinates radians(targets);
+    const double source_lon = toRadians(source.lon);
+    const double source_lat = toRadians(source.lat);
+    const auto count = targets.size();
+
+    distances.resize(count);
+    double *result = distances.data();
+    const double *lon = radians.lon.data();
+    const double *lat = radians.lat.data();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const double x_value = (lon[i] - source_lon) * cosPolynomial((source_lat + lat[i]) / 2.0);
+        const double y_value = lat[i] - source_lat;
+        result[i] = std::sqrt(x_value * x_value + y_value * y_value) * detail::EARTH_RADIUS;
+    }
+}
+
+void bearings(const Coordinate source,
+              const ArrayView<Coordinate> targets,
+              std::vector<double> &bearings,
+              const bool approximate)
+{
+    BOOST_ASSERT(source.IsValid());
+    const RadianCoordinates radians(targets);
+    const double source_lon = toRadians(source.lon);
+    const double source_lat = toRadians(source.lat);
+    const double sin_source_lat = std::sin(source_lat);
+    const double cos_source_lat = std::cos(source_lat);
+    const auto count = targets.size();
+
+    // the components of the bearing vector, vectorized
+    std::vector<double> ys(count);
+    bearings.resize(count);
+    double *xs = bearings.data();
+    const double *lon = radians.lon.data();
+    const double *lat = radians.lat.data();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        double sin_dlon, cos_dlon;
+        sinCos(lon[i] - source_lon, sin_dlon, cos_dlon);
+        const double sin_lat = sinPolynomial(lat[i]);
+        const double cos_lat = cosPolynomial(lat[i]);
+        ys[i] = sin_dlon * cos_lat;
+        xs[i] = cos_source_lat * sin_lat - sin_source_lat * cos_lat * cos_dlon;
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const double angle = approximate ? atan2_lookup(ys[i], xs[i]) : std::atan2(ys[i], xs[i]);
+        double result = angle * detail::RAD_TO_DEGREE;
+        if (result < 0.0)
+        {
+            result += 360.0;
+        }
+        if (result >= 360.0)
+        {
+            result -= 360.0;
+        }
+        bearings[i] = result;
+    }
+}
+
 Coordinate centroid(const Coordinate lhs, const Coordinate rhs)
 {
     Coordinate centroid;
@@ -0,0 +1,138 @@
+#include "util/crc32c.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define OSRM_CRC32C_SSE42
+#include <nmmintrin.h>
+#endif
+
+namespace osrm
+{
+namespace util
+{
+
+namespace
+{
+// reflected polynomial of CRC32C
+const constexpr std::uint32_t CRC32C_POLYNOMIAL = 0x82F63B78;
+
+std::array<std::uint32_t, 256> makeTable()
+{
+    std::array<std::uint32_t, 256> table;
+    for (std::uint32_t byte = 0; byte < table.size(); ++byte)
+    {
+        auto remainder = byte;
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            remainder = (remainder >> 1) ^ ((remainder & 1) ? CRC32C_POLYNOMIAL : 0);
+        }
+        table[byte] = remainder;
+    }
+    return table;
+}
+
+std::uint32_t computeInSoftware(const char *data, const std::size_t size, const std::uint32_t crc)
+{
+    static const auto table = makeTable();
+    auto remainder = ~crc;
+    for (std::size_t index = 0; index < size; ++index)
+    {
+        remainder = table[(remainder ^ static_cast<unsigned char>(data[index])) & 0xFF] ^
+                    (remainder >> 8);
+    }
+    return ~remainder;
+}
+
+#ifdef OSRM_CRC32C_SSE42
+__attribute__((target("sse4.2"))) std::uint32_t
+computeInHardware(const char *data, std::size_t size, const std::uint32_t crc)
+{
+    std::uint64_t remainder = ~crc;
+    for (; size >= sizeof(std::uint64_t); size -= sizeof(std::uint64_t))
+    {
+        std::uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        remainder = _mm_crc32_u64(remainder, word);
+        data += sizeof(word);
+    }
+    auto remainder32 = static_cast<std::uint32_t>(remainder);
+    for (; size > 0; --size)
+    {
+        remainder32 = _mm_crc32_u8(remainder32, static_cast<unsigned char>(*data));
+        ++data;
+    }
+    return ~remainder32;
+}
+
+bool hasHardwareSupport()
+{
+    static const bool supported = __builtin_cpu_supports("sse4.2");
+    return supported;
+}
+#endif
+}
+
+std::uint32_t crc32c(const char *data, const std::size_t size, const std::uint32_t crc)
+{
+#ifdef OSRM_CRC32C_SSE42
+    if (hasHardwareSupport())
+    {
+        return computeInHardware(data, size, crc);
+    }
+#endif
+    return computeInSoftware(data, size, crc);
+}
+
+std::uint32_t blockChecksum(const char *data, const std::size_t size)
+{
+    if (size <= CHECKSUM_CHUNK_SIZE)
+    {
+        return crc32c(data, size);
+    }
+
+    std::vector<std::uint32_t> chunk_checksums((size + CHECKSUM_CHUNK_SIZE - 1) /
+                                               CHECKSUM_CHUNK_SIZE);
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, chunk_checksums.size()),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          for (auto chunk = range.begin(); chunk != range.end(); ++chunk)
+                          {
+                              const auto offset = chunk * CHECKSUM_CHUNK_SIZE;
+                              chunk_checksums[chunk] = crc32c(
+                                  data + offset, std::min(CHECKSUM_CHUNK_SIZE, size - offset));
+                          }
+                      });
+    return combineChunkChecksums(chunk_checksums);
+}
+
+std::uint32_t combineChunkChecksums(const std::vector<std::uint32_t> &chunk_checksums)
+{
+    if (chunk_checksums.empty())
+    {
+        return crc32c(nullptr, 0);
+    }
+    if (chunk_checksums.size() == 1)
+    {
+        return chunk_checksums.front();
+    }
+
+    // the checksums are combined in a little endian layout independent of the host
+    std::vector<char> chunk_bytes(chunk_checksums.size() * sizeof(std::uint32_t));
+    for (std::size_t chunk = 0; chunk < chunk_checksums.size(); ++chunk)
+    {
+        for (std::size_t byte = 0; byte < sizeof(std::uint32_t); ++byte)
+        {
+            chunk_bytes[chunk * sizeof(std::uint32_t) + byte] =
+                static_cast<char>(chunk_checksums[chunk] >> (8 * byte));
+        }
+    }
+    return crc32c(chunk_bytes.data(), chunk_bytes.size());
+}
+}
+}
@@ -0,0 +1,105 @@
+#include "util/huge_pages.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace osrm
+{
+namespace util
+{
+
+std::size_t getHugePageSize()
+{
+#ifdef __linux__
+    std::ifstream meminfo("/proc/meminfo");
+    std::string line;
+    while (std::getline(meminfo, line))
+    {
+        std::istringstream fields(line);
+        std::string name;
+        std::size_t kilobytes = 0;
+        if (fields >> name >> kilobytes && name == "Hugepagesize:")
+        {
+            return kilobytes * 1024;
+        }
+    }
+#endif
+    return 0;
+}
+
+bool adviseHugePages(void *begin, const std::size_t size)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    const auto page_size = getHugePageSize();
+    if (page_size == 0)
+    {
+        return false;
+    }
+
+    // only whole huge pages can be advised
+    const auto first = reinterpret_cast<std::uintptr_t>(begin);
+    const auto aligned_first = (first + page_size - 1) / page_size * page_size;
+    const auto aligned_last = (first + size) / page_size * page_size;
+    if (aligned_first >= aligned_last)
+    {
+        return true;
+    }
+    return 0 == ::madvise(reinterpret_cast<void *>(aligned_first),
+                          aligned_last - aligned_first,
+                          MADV_HUGEPAGE);
+#else
+    (void)begin;
+    (void)size;
+    return false;
+#endif
+}
+
+std::size_t getHugePageBackedBytes(const void *begin, const std::size_t size)
+{
+    std::size_t huge_page_bytes = 0;
+#ifdef __linux__
+    const auto first = reinterpret_cast<std::uintptr_t>(begin);
+    const auto last = first + size;
+
+    // /proc/self/smaps lists every mapping as an address range followed by its statistics
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    bool overlaps = false;
+    while (std::getline(smaps, line))
+    {
+        std::istringstream fields(line);
+        std::string name;
+        fields >> name;
+
+        const auto dash = name.find('-');
+        if (dash != std::string::npos && name.back() != ':')
+        {
+            const auto mapping_first = std::stoull(name.substr(0, dash), nullptr, 16);
+            const auto mapping_last = std::stoull(name.substr(dash + 1), nullptr, 16);
+            overlaps = mapping_first < last && first < mapping_last;
+            continue;
+        }
+
+        std::size_t kilobytes = 0;
+        if (overlaps && (name == "AnonHugePages:" || name == "ShmemPmdMapped:" ||
+                         name == "Shared_Hugetlb:" || name == "Private_Hugetlb:") &&
+            fields >> kilobytes)
+        {
+            huge_page_bytes += kilobytes * 1024;
+        }
+    }
+#else
+    (void)begin;
+#endif
+    // mappings can extend beyond the range
+    return std::min(huge_page_bytes, size);
+}
+}
+}
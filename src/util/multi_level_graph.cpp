@@ -0,0 +1,157 @@
+#include "util/multi_level_graph.hpp"
+
+#include "util/exception.hpp"
+#include "util/io.hpp"
+
+#include <istream>
+#include <ostream>
+
+namespace osrm
+{
+namespace util
+{
+
+MultiLevelPartition::MultiLevelPartition(const std::vector<std::vector<CellID>> &level_cells)
+{
+    const auto number_of_nodes = level_cells.empty() ? 0 : level_cells.front().size();
+    for (const auto &cells_of_level : level_cells)
+    {
+        BOOST_ASSERT(cells_of_level.size() == number_of_nodes);
+        const auto max_cell = std::max_element(cells_of_level.begin(), cells_of_level.end());
+        level_cell_counts.push_back(max_cell == cells_of_level.end() ? 0 : *max_cell + 1);
+    }
+    ComputeMasks();
+
+    cells.resize(number_of_nodes, 0);
+    for (const auto level : irange<std::size_t>(0, level_cells.size()))
+    {
+        for (const auto node : irange<std::size_t>(0, number_of_nodes))
+        {
+            cells[node] |= static_cast<std::uint64_t>(level_cells[level][node])
+                           << level_offsets[level];
+        }
+    }
+}
+
+void MultiLevelPartition::ComputeMasks()
+{
+    level_offsets.clear();
+    level_masks.clear();
+    std::uint32_t offset = 0;
+    for (const auto number_of_cells : level_cell_counts)
+    {
+        std::uint32_t bits = 0;
+        while (bits < 32 && (std::uint64_t{1} << bits) < number_of_cells)
+        {
+            ++bits;
+        }
+        if (offset + bits > 64)
+        {
+            throw util::exception("The cells of the partition do not fit into 64 bits, use "
+                                  "fewer levels or larger cells");
+        }
+        level_offsets.push_back(static_cast<std::uint8_t>(offset));
+        level_masks.push_back((std::uint64_t{1} << bits) - 1);
+        offset += bits;
+    }
+}
+
+bool MultiLevelPartition::Write(std::ostream &stream) const
+{
+    return serializeVector(stream, level_cell_counts) && serializeVector(stream, cells);
+}
+
+bool MultiLevelPartition::Read(std::istream &stream)
+{
+    if (!deserializeVector(stream, level_cell_counts) || !deserializeVector(stream, cells))
+    {
+        return false;
+    }
+    ComputeMasks();
+    return true;
+}
+
+void MultiLevelGraph::BuildCells()
+{
+    const auto number_of_levels = partition.GetNumberOfLevels();
+    const auto number_of_nodes = GetNumberOfNodes();
+
+    level_first_cell.assign(1, 0);
+    for (const auto level : irange<LevelID>(1, number_of_levels + 1))
+    {
+        level_first_cell.push_back(level_first_cell.back() + partition.GetNumberOfCells(level));
+    }
+
+    // boundary nodes have an arc to or from a node in another cell of the level
+    const auto is_boundary_node = [&](const LevelID level, const NodeID node) {
+        const auto cell = partition.GetCell(level, node);
+        const auto leaves_cell = [&](const Arc &arc) {
+            return partition.GetCell(level, arc.head) != cell;
+        };
+        return std::any_of(out_arcs.begin() + out_first_arc[node],
+                           out_arcs.begin() + out_first_arc[node + 1],
+                           leaves_cell) ||
+               std::any_of(in_arcs.begin() + in_first_arc[node],
+                           in_arcs.begin() + in_first_arc[node + 1],
+                           leaves_cell);
+    };
+
+    std::vector<std::uint32_t> boundary_counts(level_first_cell.back(), 0);
+    for (const auto level : irange<LevelID>(1, number_of_levels + 1))
+    {
+        for (const auto node : irange<NodeID>(0, number_of_nodes))
+        {
+            if (is_boundary_node(level, node))
+            {
+                ++boundary_counts[CellIndex(level, partition.GetCell(level, node))];
+            }
+        }
+    }
+
+    boundary_offsets.assign(1, 0);
+    clique_offsets.assign(1, 0);
+    for (const auto count : boundary_counts)
+    {
+        boundary_offsets.push_back(boundary_offsets.back() + count);
+        clique_offsets.push_back(clique_offsets.back() + std::uint64_t{count} * count);
+    }
+
+    // nodes are visited in ascending order, which sorts the boundary nodes of every cell
+    boundary_nodes.resize(boundary_offsets.back());
+    auto positions = boundary_offsets;
+    for (const auto level : irange<LevelID>(1, number_of_levels + 1))
+    {
+        for (const auto node : irange<NodeID>(0, number_of_nodes))
+        {
+            if (is_boundary_node(level, node))
+            {
+                boundary_nodes[positions[CellIndex(level, partition.GetCell(level, node))]++] =
+                    node;
+            }
+        }
+    }
+    clique_weights.assign(clique_offsets.back(), INVALID_EDGE_WEIGHT);
+}
+
+bool MultiLevelGraph::Write(std::ostream &stream) const
+{
+    return partition.Write(stream) && serializeVector(stream, out_first_arc) &&
+           serializeVector(stream, out_arcs) && serializeVector(stream, in_first_arc) &&
+           serializeVector(stream, in_arcs) && serializeVector(stream, level_first_cell) &&
+           serializeVector(stream, boundary_offsets) && serializeVector(stream, boundary_nodes) &&
+           serializeVector(stream, clique_offsets) && serializeVector(stream, clique_weights);
+}
+
+bool MultiLevelGraph::Read(std::istream &stream)
+{
+    return partition.Read(stream) && deserializeVector(stream, out_first_arc) &&
+           deserializeVector(stream, out_arcs) && deserializeVector(stream, in_first_arc) &&
+           deserializeVector(stream, in_arcs) && deserializeVector(stream, level_first_cell) &&
+           deserializeVector(stream, boundary_offsets) &&
+           deserializeVector(stream, boundary_nodes) &&
+           deserializeVector(stream, clique_offsets) &&
+           deserializeVector(stream, clique_weights) && !out_first_arc.empty() &&
+           out_first_arc.size() == partition.GetNumberOfNodes() + 1;
+}
+}
+}
@@ -2,7 +2,6 @@
 #include "util/exception.hpp"
 #include "util/simple_logger.hpp"
 
-#include <algorithm>
 #include <fstream>
 #include <limits>
 
@@ -48,7 +47,7 @@ NameTable::NameTable(const std::string &filename)
                         filename);
 }
 
-std::string NameTable::GetNameForID(const unsigned name_id) const
+StringView NameTable::GetNameForID(const unsigned name_id) const
 {
     if (std::numeric_limits<unsigned>::max() == name_id)
     {
@@ -56,19 +55,10 @@ std::string NameTable::GetNameForID(const unsigned name_id) const
     }
     auto range = m_name_table.GetRange(name_id);
 
-    std::string result;
-    result.reserve(range.size());
-    if (range.begin() != range.end())
-    {
-        result.resize(range.back() - range.front() + 1);
-        std::copy(m_names_char_list.begin() + range.front(),
-                  m_names_char_list.begin() + range.back() + 1,
-                  result.begin());
-    }
-    return result;
+    return StringView(m_names_char_list.data() + range.front(), range.size());
 }
 
-std::string NameTable::GetRefForID(const unsigned name_id) const
+StringView NameTable::GetRefForID(const unsigned name_id) const
 {
     // Way string data is stored in blocks based on `name_id` as follows:
     //
@@ -85,7 +75,7 @@ std::string NameTable::GetRefForID(const unsigned name_id) const
     return GetNameForID(name_id + OFFSET_REF);
 }
 
-std::string NameTable::GetPronunciationForID(const unsigned name_id) const
+StringView NameTable::GetPronunciationForID(const unsigned name_id) const
 {
     // Way string data is stored in blocks based on `name_id` as follows:
     //
@@ -0,0 +1,169 @@
+#include "util/numa.hpp"
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace osrm
+{
+namespace util
+{
+
+namespace
+{
+// Parses a sysfs cpu list like "0-3,8-11"
+std::vector<unsigned> parseCpuList(const std::string &cpu_list)
+{
+    std::vector<unsigned> cpus;
+    std::vector<std::string> ranges;
+    boost::split(ranges, cpu_list, boost::is_any_of(","));
+    for (const auto &range : ranges)
+    {
+        if (range.empty())
+        {
+            continue;
+        }
+        const auto dash = range.find('-');
+        const auto first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+        const auto last = dash == std::string::npos
+                              ? first
+                              : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+        for (auto cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+std::vector<std::vector<unsigned>> readNumaNodes()
+{
+    std::vector<std::vector<unsigned>> nodes;
+#ifdef __linux__
+    // node ids are contiguous on all but exotic hosts, stop at the first missing one
+    for (unsigned node = 0;; ++node)
+    {
+        std::ifstream cpu_list_file("/sys/devices/system/node/node" + std::to_string(node) +
+                                    "/cpulist");
+        std::string cpu_list;
+        if (!cpu_list_file || !std::getline(cpu_list_file, cpu_list))
+        {
+            break;
+        }
+        nodes.push_back(parseCpuList(cpu_list));
+    }
+#endif
+    if (nodes.empty())
+    {
+        const unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+        nodes.emplace_back();
+        for (unsigned cpu = 0; cpu < hardware_threads; ++cpu)
+        {
+            nodes.back().push_back(cpu);
+        }
+    }
+    return nodes;
+}
+
+std::vector<unsigned> makeCpuToNode(const std::vector<std::vector<unsigned>> &nodes)
+{
+    std::vector<unsigned> cpu_to_node;
+    for (unsigned node = 0; node < nodes.size(); ++node)
+    {
+        for (const auto cpu : nodes[node])
+        {
+            if (cpu >= cpu_to_node.size())
+            {
+                cpu_to_node.resize(cpu + 1, 0);
+            }
+            cpu_to_node[cpu] = node;
+        }
+    }
+    return cpu_to_node;
+}
+
+#ifdef __linux__
+bool bindThread(const pthread_t thread, const unsigned node)
+{
+    const auto &nodes = getNumaNodes();
+    if (node >= nodes.size())
+    {
+        return false;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const auto cpu : nodes[node])
+    {
+        CPU_SET(cpu, &cpu_set);
+    }
+    return pthread_setaffinity_np(thread, sizeof(cpu_set), &cpu_set) == 0;
+}
+#endif
+}
+
+const std::vector<std::vector<unsigned>> &getNumaNodes()
+{
+    static const auto nodes = readNumaNodes();
+    return nodes;
+}
+
+unsigned getCurrentNumaNode()
+{
+#ifdef __linux__
+    static const auto cpu_to_node = makeCpuToNode(getNumaNodes());
+    const auto cpu = sched_getcpu();
+    if (cpu >= 0 && static_cast<std::size_t>(cpu) < cpu_to_node.size())
+    {
+        return cpu_to_node[cpu];
+    }
+#endif
+    return 0;
+}
+
+bool bindToNumaNode(std::thread &thread, const unsigned node)
+{
+#ifdef __linux__
+    return bindThread(thread.native_handle(), node);
+#else
+    (void)thread;
+    (void)node;
+    return false;
+#endif
+}
+
+void runOnNumaNode(const unsigned node, const std::function<void()> &task)
+{
+    std::exception_ptr error;
+    std::thread thread([&] {
+        // bind before touching any memory
+#ifdef __linux__
+        bindThread(pthread_self(), node);
+#else
+        (void)node;
+#endif
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+    });
+    thread.join();
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+}
+}
@@ -6,10 +6,18 @@
 #else
 #include <unistd.h>
 #endif
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace osrm
 {
@@ -27,6 +35,188 @@ static const char YELLOW[]{"\x1b[33m"};
 // static const char BLUE[] { "\x1b[34m"};
 // static const char MAGENTA[] { "\x1b[35m"};
 // static const char CYAN[] { "\x1b[36m"};
+
+bool isTerminal()
+{
+    static const bool is_terminal = static_cast<bool>(isatty(fileno(stdout)));
+    return is_terminal;
+}
+
+// serializes the lines written to the standard streams
+std::mutex &getOutputMutex()
+{
+    static std::mutex output_mutex;
+    return output_mutex;
+}
+
+struct LogLine
+{
+    bool is_warning;
+    std::string text;
+};
+
+void writeLine(const LogLine &line)
+{
+    (line.is_warning ? std::cerr : std::cout) << line.text << '\n';
+}
+
+// The lines of one thread on their way to the writer thread. Only the thread pushes and only the
+// writer thread drains, so the ring needs no lock.
+class LineRing
+{
+  public:
+    static constexpr std::size_t CAPACITY = 512;
+
+    // false if the ring is full
+    bool TryPush(LogLine &line)
+    {
+        const auto tail = tail_index.load(std::memory_order_relaxed);
+        if (tail - head_index.load(std::memory_order_acquire) == CAPACITY)
+        {
+            return false;
+        }
+        slots[tail % CAPACITY] = std::move(line);
+        tail_index.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename Consumer> void Drain(Consumer consumer)
+    {
+        const auto head = head_index.load(std::memory_order_relaxed);
+        const auto tail = tail_index.load(std::memory_order_acquire);
+        for (auto index = head; index != tail; ++index)
+        {
+            consumer(slots[index % CAPACITY]);
+        }
+        head_index.store(tail, std::memory_order_release);
+    }
+
+    bool Empty() const
+    {
+        return head_index.load(std::memory_order_acquire) ==
+               tail_index.load(std::memory_order_acquire);
+    }
+
+    // set once the thread of the ring has exited
+    std::atomic<bool> closed{false};
+
+  private:
+    std::array<LogLine, CAPACITY> slots;
+    std::atomic<std::size_t> head_index{0};
+    std::atomic<std::size_t> tail_index{0};
+};
+
+// Writes the lines of all threads from a thread of its own, the threads that log only format
+// their lines and hand them over. The lines of a thread keep their order, the lines of different
+// threads are written in the order they are collected. The rings are drained once the writer is
+// woken up by a line or at the latest every FLUSH_INTERVAL, and when the writer is destroyed at
+// exit.
+class AsyncWriter
+{
+  public:
+    AsyncWriter() : writer_thread([this] { Run(); }) {}
+
+    ~AsyncWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            stopping = true;
+        }
+        wake_up.notify_one();
+        writer_thread.join();
+    }
+
+    void Push(LogLine line)
+    {
+        // a full ring waits for the writer, lines are neither dropped nor reordered
+        auto &ring = GetThreadRing();
+        while (!ring.TryPush(line))
+        {
+            wake_up.notify_one();
+            std::this_thread::yield();
+        }
+        wake_up.notify_one();
+    }
+
+  private:
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{10};
+
+    struct ThreadRing
+    {
+        ~ThreadRing()
+        {
+            if (ring)
+            {
+                ring->closed.store(true, std::memory_order_release);
+            }
+        }
+
+        std::shared_ptr<LineRing> ring;
+    };
+
+    LineRing &GetThreadRing()
+    {
+        static thread_local ThreadRing thread_ring;
+        if (!thread_ring.ring)
+        {
+            thread_ring.ring = std::make_shared<LineRing>();
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            rings.push_back(thread_ring.ring);
+        }
+        return *thread_ring.ring;
+    }
+
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(rings_mutex);
+        while (true)
+        {
+            // lines pushed before stopping are drained by this last pass
+            const bool stop = stopping;
+            const auto current_rings = rings;
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> output_lock(getOutputMutex());
+                for (const auto &ring : current_rings)
+                {
+                    ring->Drain([](const LogLine &line) { writeLine(line); });
+                }
+                std::cout.flush();
+            }
+            lock.lock();
+
+            // the rings of exited threads are dropped once they are drained
+            rings.erase(std::remove_if(rings.begin(),
+                                       rings.end(),
+                                       [](const std::shared_ptr<LineRing> &ring) {
+                                           return ring->closed.load(std::memory_order_acquire) &&
+                                                  ring->Empty();
+                                       }),
+                        rings.end());
+
+            if (stop)
+            {
+                break;
+            }
+            wake_up.wait_for(lock, FLUSH_INTERVAL);
+        }
+    }
+
+    std::mutex rings_mutex;
+    std::condition_variable wake_up;
+    std::vector<std::shared_ptr<LineRing>> rings;
+    bool stopping = false;
+    std::thread writer_thread;
+};
+
+constexpr std::size_t LineRing::CAPACITY;
+constexpr std::chrono::milliseconds AsyncWriter::FLUSH_INTERVAL;
+
+AsyncWriter &getAsyncWriter()
+{
+    static AsyncWriter writer;
+    return writer;
+}
 }
 
 void LogPolicy::Unmute() { m_is_mute = false; }
@@ -35,24 +225,33 @@ void LogPolicy::Mute() { m_is_mute = true; }
 
 bool LogPolicy::IsMute() const { return m_is_mute; }
 
+void LogPolicy::EnableAsyncOutput() { m_is_async = true; }
+
+bool LogPolicy::IsAsync() const { return m_is_async; }
+
 LogPolicy &LogPolicy::GetInstance()
 {
     static LogPolicy runningInstance;
     return runningInstance;
 }
 
-SimpleLogger::SimpleLogger() : level(logINFO) {}
-
-std::mutex &SimpleLogger::get_mutex()
-{
-    static std::mutex mtx;
-    return mtx;
-}
+SimpleLogger::SimpleLogger() : level(logINFO), enabled(false) {}
 
 std::ostringstream &SimpleLogger::Write(LogLevel lvl) noexcept
 {
-    std::lock_guard<std::mutex> lock(get_mutex());
     level = lvl;
+#ifdef NDEBUG
+    enabled = level != logDEBUG && !LogPolicy::GetInstance().IsMute();
+#else
+    enabled = !LogPolicy::GetInstance().IsMute();
+#endif
+    if (!enabled)
+    {
+        // a stream in a failed state skips the formatting of everything written to it
+        os.setstate(std::ios_base::badbit);
+        return os;
+    }
+
     os << "[";
     switch (level)
     {
@@ -60,9 +259,7 @@ std::ostringstream &SimpleLogger::Write(LogLevel lvl) noexcept
         os << "warn";
         break;
     case logDEBUG:
-#ifndef NDEBUG
         os << "debug";
-#endif
         break;
     default: // logINFO:
         os << "info";
@@ -74,28 +271,38 @@ std::ostringstream &SimpleLogger::Write(LogLevel lvl) noexcept
 
 SimpleLogger::~SimpleLogger()
 {
-    std::lock_guard<std::mutex> lock(get_mutex());
-    if (!LogPolicy::GetInstance().IsMute())
+    if (!enabled)
     {
-        const bool is_terminal = static_cast<bool>(isatty(fileno(stdout)));
-        switch (level)
-        {
-        case logWARNING:
-            std::cerr << (is_terminal ? RED : "") << os.str() << (is_terminal ? COL_RESET : "")
-                      << std::endl;
-            break;
-        case logDEBUG:
+        return;
+    }
+
+    const bool is_terminal = isTerminal();
+    LogLine line{level == logWARNING, std::string()};
+    switch (level)
+    {
+    case logWARNING:
+        line.text = (is_terminal ? RED : "") + os.str() + (is_terminal ? COL_RESET : "");
+        break;
+    case logDEBUG:
 #ifndef NDEBUG
-            std::cout << (is_terminal ? YELLOW : "") << os.str() << (is_terminal ? COL_RESET : "")
-                      << std::endl;
+        line.text = (is_terminal ? YELLOW : "") + os.str() + (is_terminal ? COL_RESET : "");
 #endif
-            break;
-        case logINFO:
-        default:
-            std::cout << os.str() << (is_terminal ? COL_RESET : "") << std::endl;
-            break;
-        }
+        break;
+    case logINFO:
+    default:
+        line.text = os.str() + (is_terminal ? COL_RESET : "");
+        break;
     }
+
+    if (LogPolicy::GetInstance().IsAsync())
+    {
+        getAsyncWriter().Push(std::move(line));
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(getOutputMutex());
+    writeLine(line);
+    (line.is_warning ? std::cerr : std::cout).flush();
 }
 }
 }
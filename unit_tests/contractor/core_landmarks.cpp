@@ -0,0 +1,81 @@
+#include "contractor/core_landmarks.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(core_landmarks)
+
+using namespace osrm;
+using namespace osrm::contractor;
+
+namespace
+{
+QueryEdge makeEdge(const NodeID source,
+                   const NodeID target,
+                   const EdgeWeight weight,
+                   const bool forward,
+                   const bool backward)
+{
+    QueryEdge::EdgeData data;
+    data.weight = weight;
+    data.forward = forward;
+    data.backward = backward;
+    return {source, target, data};
+}
+}
+
+BOOST_AUTO_TEST_CASE(farthest_landmarks_test)
+{
+    // 0 <-> 1 -> 2 <-> 3 -> 0 in the core, node 4 is contracted
+    const std::vector<bool> is_core_node = {true, true, true, true, false};
+    const std::vector<QueryEdge> edges = {makeEdge(0, 1, 10, true, true),
+                                          makeEdge(1, 2, 5, true, false),
+                                          makeEdge(3, 2, 7, true, true),
+                                          makeEdge(3, 0, 20, true, false),
+                                          makeEdge(4, 2, 1, true, true)};
+
+    const auto landmarks = computeCoreLandmarks(is_core_node, edges, 2);
+    BOOST_REQUIRE_EQUAL(landmarks.number_of_landmarks, 2);
+    const std::vector<NodeID> core_indices = {0, 1, 2, 3, SPECIAL_NODEID};
+    BOOST_CHECK_EQUAL_COLLECTIONS(landmarks.core_indices.begin(),
+                                  landmarks.core_indices.end(),
+                                  core_indices.begin(),
+                                  core_indices.end());
+
+    // 3 is the farthest from 0, 1 the farthest from 3
+    const std::vector<EdgeWeight> weights = {
+        20, 10, 22, 10, // from and to 3 and 1 of node 0
+        30, 0,  12, 0,  // node 1
+        7,  5,  7,  37, // node 2
+        0,  12, 0,  30  // node 3
+    };
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        landmarks.weights.begin(), landmarks.weights.end(), weights.begin(), weights.end());
+}
+
+BOOST_AUTO_TEST_CASE(unreachable_landmarks_test)
+{
+    // two islands, the second one is only picked once the first one is used up
+    const std::vector<bool> is_core_node = {true, true, true};
+    const std::vector<QueryEdge> edges = {makeEdge(0, 1, 3, true, true)};
+
+    const auto landmarks = computeCoreLandmarks(is_core_node, edges, 4);
+    BOOST_REQUIRE_EQUAL(landmarks.number_of_landmarks, 3);
+    // from and to the landmarks 1, 0 and 2
+    const auto INVALID = INVALID_EDGE_WEIGHT;
+    const std::vector<EdgeWeight> weights = {
+        3,       0,       INVALID, 3,       0,       INVALID, // node 0
+        0,       3,       INVALID, 0,       3,       INVALID, // node 1
+        INVALID, INVALID, 0,       INVALID, INVALID, 0        // node 2
+    };
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        landmarks.weights.begin(), landmarks.weights.end(), weights.begin(), weights.end());
+
+    // no core, no landmarks
+    const auto no_landmarks = computeCoreLandmarks({false, false, false}, edges, 4);
+    BOOST_CHECK_EQUAL(no_landmarks.number_of_landmarks, 0);
+    BOOST_CHECK(no_landmarks.weights.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,99 @@
+#include "contractor/geographic_partition.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(geographic_partition)
+
+using namespace osrm;
+using namespace osrm::contractor;
+
+BOOST_AUTO_TEST_CASE(partition_with_overlap_test)
+{
+    // nodes about 1.1km apart along the equator and one without a location
+    std::vector<util::Coordinate> coordinates;
+    for (const auto index : {0, 1, 2, 3, 4, 5, 6, 7})
+    {
+        coordinates.emplace_back(util::FloatLongitude{index * 0.01}, util::FloatLatitude{0});
+    }
+    coordinates.emplace_back();
+
+    const auto partition = partitionByCoordinates(coordinates, 2, 1500);
+    BOOST_CHECK_EQUAL(partition.NumberOfCells(), 2);
+    const std::vector<CellID> node_cells = {0, 0, 0, 0, 1, 1, 1, 1, INVALID_CELL_ID};
+    BOOST_CHECK_EQUAL_COLLECTIONS(partition.node_cells.begin(),
+                                  partition.node_cells.end(),
+                                  node_cells.begin(),
+                                  node_cells.end());
+
+    // the shards reach 1.5km into the other cell
+    const std::vector<NodeID> shard_nodes = {0, 1, 2, 3, 4, 5, 3, 4, 5, 6, 7};
+    BOOST_CHECK_EQUAL_COLLECTIONS(partition.shard_nodes.begin(),
+                                  partition.shard_nodes.end(),
+                                  shard_nodes.begin(),
+                                  shard_nodes.end());
+    const auto is_shard_node = partition.GetShardNodes(1);
+    BOOST_CHECK(!is_shard_node[2]);
+    BOOST_CHECK(is_shard_node[3]);
+    BOOST_CHECK(!is_shard_node[8]);
+
+    // without an overlap the shards are the cells
+    const auto cells = partitionByCoordinates(coordinates, 2, 0);
+    BOOST_CHECK_EQUAL(cells.shard_offsets[1], 4);
+    BOOST_CHECK_EQUAL(cells.shard_offsets[2], 8);
+}
+
+BOOST_AUTO_TEST_CASE(partition_into_levels_test)
+{
+    std::vector<util::Coordinate> coordinates;
+    for (const auto index : {0, 1, 2, 3, 4, 5, 6, 7})
+    {
+        coordinates.emplace_back(util::FloatLongitude{index * 0.01}, util::FloatLatitude{0});
+    }
+
+    // cells of at most 2 nodes nested in cells of at most 4 nodes
+    const auto level_cells = partitionIntoLevels(coordinates, {2, 4});
+    BOOST_REQUIRE_EQUAL(level_cells.size(), 2);
+    const std::vector<CellID> lower_cells = {0, 0, 1, 1, 2, 2, 3, 3};
+    const std::vector<CellID> upper_cells = {0, 0, 0, 0, 1, 1, 1, 1};
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        level_cells[0].begin(), level_cells[0].end(), lower_cells.begin(), lower_cells.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        level_cells[1].begin(), level_cells[1].end(), upper_cells.begin(), upper_cells.end());
+}
+
+BOOST_AUTO_TEST_CASE(border_nodes_test)
+{
+    GeographicPartition partition;
+    partition.node_cells = {0, 0, 1, 1};
+    util::DeallocatingVector<extractor::EdgeBasedEdge> edges;
+    edges.push_back({0, 1, 0, 1, 1, true, false});
+    edges.push_back({1, 2, 1, 1, 1, true, false});
+    edges.push_back({3, 2, 2, 1, 1, false, true});
+
+    const auto cell_border_nodes = getBorderNodes(partition, 0, edges);
+    BOOST_CHECK_EQUAL(cell_border_nodes.size(), 1);
+    BOOST_CHECK_EQUAL(cell_border_nodes.front(), 1);
+    const auto other_border_nodes = getBorderNodes(partition, 1, edges);
+    BOOST_CHECK_EQUAL(other_border_nodes.size(), 1);
+    BOOST_CHECK_EQUAL(other_border_nodes.front(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(overlay_edges_test)
+{
+    util::DeallocatingVector<extractor::EdgeBasedEdge> edges;
+    edges.push_back({0, 1, 0, 1, 1, true, false});
+    edges.push_back({2, 1, 1, 1, 1, false, true});
+    edges.push_back({2, 3, 2, 2, 1, true, false});
+    edges.push_back({0, 3, 3, 10, 1, true, false});
+
+    // 3 reaches no other border node
+    const auto overlay_edges = computeOverlayEdges(4, {0, 3}, edges);
+    BOOST_REQUIRE_EQUAL(overlay_edges.size(), 1);
+    BOOST_CHECK_EQUAL(overlay_edges.front().source, 0);
+    BOOST_CHECK_EQUAL(overlay_edges.front().target, 3);
+    BOOST_CHECK_EQUAL(overlay_edges.front().weight, 4);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,157 @@
+#include "contractor/multi_level_customizer.hpp"
+#include "util/integer_range.hpp"
+#include "util/multi_level_graph.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <functional>
+#include <queue>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(multi_level_customizer)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+struct TestEdge
+{
+    NodeID source;
+    NodeID target;
+    EdgeWeight weight;
+    NodeID edge_id;
+    bool forward;
+    bool backward;
+};
+
+// 4x4 grid, the rows are two-way and all columns but the last one-way downwards. The cells of
+// level 1 are the 2x2 quarters, those of level 2 the left and right half.
+std::vector<TestEdge> makeGridEdges()
+{
+    std::vector<TestEdge> edges;
+    for (const auto y : irange<NodeID>(0, 4))
+    {
+        for (const auto x : irange<NodeID>(0, 4))
+        {
+            const auto node = y * 4 + x;
+            if (x < 3)
+            {
+                edges.push_back({node, node + 1, 1 + (x * 3 + y * 7) % 5, node, true, true});
+            }
+            if (y < 3)
+            {
+                edges.push_back({node, node + 4, 1 + (x * 5 + y) % 4, 16 + node, true, x == 3});
+            }
+        }
+    }
+    return edges;
+}
+
+MultiLevelPartition makeGridPartition()
+{
+    std::vector<std::vector<MultiLevelPartition::CellID>> level_cells(2);
+    for (const auto node : irange<NodeID>(0, 16))
+    {
+        const auto x = node % 4, y = node / 4;
+        level_cells[0].push_back((y / 2) * 2 + x / 2);
+        level_cells[1].push_back(x / 2);
+    }
+    return MultiLevelPartition(level_cells);
+}
+
+// Dijkstra on the base arcs between nodes that pass the filter
+template <typename FilterT>
+std::vector<EdgeWeight>
+shortestPaths(const MultiLevelGraph &graph, const NodeID source, const FilterT &filter)
+{
+    std::vector<EdgeWeight> weights(graph.GetNumberOfNodes(), INVALID_EDGE_WEIGHT);
+    using Entry = std::pair<EdgeWeight, NodeID>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    weights[source] = 0;
+    queue.push({0, source});
+    while (!queue.empty())
+    {
+        const auto entry = queue.top();
+        queue.pop();
+        if (entry.first > weights[entry.second])
+        {
+            continue;
+        }
+        for (const auto arc : graph.GetOutArcs(entry.second))
+        {
+            const auto &data = graph.GetOutArc(arc);
+            if (filter(data.head) && entry.first + data.weight < weights[data.head])
+            {
+                weights[data.head] = entry.first + data.weight;
+                queue.push({weights[data.head], data.head});
+            }
+        }
+    }
+    return weights;
+}
+}
+
+BOOST_AUTO_TEST_CASE(boundary_nodes_test)
+{
+    const MultiLevelGraph graph(makeGridPartition(), makeGridEdges());
+    BOOST_CHECK_EQUAL(graph.GetNumberOfNodes(), 16);
+
+    // the upper left quarter connects to the right over 1 and 5, downwards over 4 and 5
+    const auto quarter = graph.GetBoundaryNodes(1, 0);
+    const std::vector<NodeID> quarter_nodes = {1, 4, 5};
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        quarter.first, quarter.second, quarter_nodes.begin(), quarter_nodes.end());
+    BOOST_CHECK_EQUAL(graph.GetBoundaryIndex(1, 5), 2);
+    BOOST_CHECK_EQUAL(graph.GetBoundaryIndex(1, 0), SPECIAL_NODEID);
+
+    const auto half = graph.GetBoundaryNodes(2, 1);
+    const std::vector<NodeID> half_nodes = {2, 6, 10, 14};
+    BOOST_CHECK_EQUAL_COLLECTIONS(half.first, half.second, half_nodes.begin(), half_nodes.end());
+}
+
+BOOST_AUTO_TEST_CASE(customization_test)
+{
+    MultiLevelGraph graph(makeGridPartition(), makeGridEdges());
+    contractor::customizeMultiLevelGraph(graph);
+
+    // the cliques hold the shortest paths inside the cells
+    const auto &partition = graph.GetPartition();
+    for (const auto level : irange<MultiLevelGraph::LevelID>(1, 3))
+    {
+        const auto number_of_cells = partition.GetNumberOfCells(level);
+        for (const auto cell : irange<MultiLevelGraph::CellID>(0, number_of_cells))
+        {
+            const auto boundary = graph.GetBoundaryNodes(level, cell);
+            const auto size = static_cast<std::size_t>(boundary.second - boundary.first);
+            const auto weights = graph.GetCliqueWeights(level, cell);
+            for (const auto from : irange<std::size_t>(0, size))
+            {
+                const auto expected =
+                    shortestPaths(graph, boundary.first[from], [&](const NodeID node) {
+                        return partition.GetCell(level, node) == cell;
+                    });
+                for (const auto to : irange<std::size_t>(0, size))
+                {
+                    BOOST_CHECK_EQUAL(weights[from * size + to], expected[boundary.first[to]]);
+                }
+            }
+        }
+    }
+
+    // inside the upper left quarter there is no way up from 4 to 1
+    const auto quarter = graph.GetCliqueWeights(1, 0);
+    BOOST_CHECK_EQUAL(quarter[1 * 3 + 0], INVALID_EDGE_WEIGHT);
+
+    std::stringstream stream;
+    BOOST_REQUIRE(graph.Write(stream));
+    MultiLevelGraph read_graph;
+    BOOST_REQUIRE(read_graph.Read(stream));
+    BOOST_CHECK_EQUAL(read_graph.GetNumberOfNodes(), 16);
+    BOOST_CHECK_EQUAL(read_graph.GetPartition().GetCell(1, 15), 3);
+    BOOST_CHECK_EQUAL(read_graph.GetCliqueWeights(1, 0)[2], graph.GetCliqueWeights(1, 0)[2]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <string>
 
 // RFC 4648 "The Base16, Base32, and Base64 Data Encodings"
 BOOST_AUTO_TEST_SUITE(base64)
@@ -75,4 +76,47 @@ BOOST_AUTO_TEST_CASE(hint_encoding_decoding_roundtrip_bytewise)
                            reinterpret_cast<const unsigned char *>(&decoded)));
 }
 
+BOOST_AUTO_TEST_CASE(hint_encoding_into_buffer)
+{
+    using namespace osrm::engine;
+
+    PhantomNode phantom;
+    phantom.forward_segment_id = {1234, true};
+    phantom.fwd_segment_position = 42;
+    const Hint hint{phantom, 0xdeadbeef};
+
+    char encoded[ENCODED_HINT_SIZE];
+    hint.ToBase64(encoded);
+    BOOST_CHECK_EQUAL(std::string(encoded, ENCODED_HINT_SIZE), hint.ToBase64());
+    BOOST_CHECK_EQUAL(Hint::FromBase64(encoded), hint);
+}
+
+BOOST_AUTO_TEST_CASE(url_safe_alphabet)
+{
+    using namespace osrm::engine;
+
+    const std::string bytes{'\xfb', '\xff', '\xbf'};
+    BOOST_CHECK_EQUAL(encodeBase64(bytes), "+/+/");
+    BOOST_CHECK_EQUAL(encodeBase64(bytes.data(), bytes.size(), Base64Alphabet::URLSafe), "-_-_");
+
+    // both alphabets decode to the same bytes
+    BOOST_CHECK_EQUAL(decodeBase64("+/+/"), bytes);
+    BOOST_CHECK_EQUAL(decodeBase64("-_-_"), bytes);
+}
+
+BOOST_AUTO_TEST_CASE(all_bytes_roundtrip)
+{
+    using namespace osrm::engine;
+
+    std::string bytes;
+    for (int value = 0; value < 256; ++value)
+    {
+        bytes.push_back(static_cast<char>(value));
+        BOOST_CHECK_EQUAL(decodeBase64(encodeBase64(bytes)), bytes);
+        BOOST_CHECK_EQUAL(
+            decodeBase64(encodeBase64(bytes.data(), bytes.size(), Base64Alphabet::URLSafe)),
+            bytes);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
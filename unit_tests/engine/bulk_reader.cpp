@@ -0,0 +1,85 @@
+#include "storage/bulk_reader.hpp"
+#include "util/exception.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(bulk_reader)
+
+using namespace osrm;
+using namespace osrm::storage::io;
+
+namespace
+{
+struct TemporaryFile
+{
+    TemporaryFile()
+        : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+    {
+    }
+    ~TemporaryFile() { boost::filesystem::remove(path); }
+    boost::filesystem::path path;
+};
+
+// a count followed by the numbers up to it, long enough for a few chunks
+std::vector<std::uint32_t> writeNumbers(const boost::filesystem::path &path)
+{
+    std::vector<std::uint32_t> numbers(3 * BulkReader::CHUNK_SIZE / 4 + 1234);
+    for (std::uint32_t index = 0; index < numbers.size(); ++index)
+    {
+        numbers[index] = index * 2654435761u;
+    }
+    boost::filesystem::ofstream stream(path, std::ios::binary);
+    const std::uint64_t count = numbers.size();
+    stream.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    stream.write(reinterpret_cast<const char *>(numbers.data()),
+                 numbers.size() * sizeof(std::uint32_t));
+    return numbers;
+}
+}
+
+BOOST_AUTO_TEST_CASE(read_test)
+{
+    TemporaryFile file;
+    const auto numbers = writeNumbers(file.path);
+
+    BulkReader reader(file.path);
+    BOOST_CHECK_EQUAL(reader.GetSize(), sizeof(std::uint64_t) + numbers.size() * 4);
+    const auto count = reader.Read<std::uint64_t>(0);
+    BOOST_REQUIRE_EQUAL(count, numbers.size());
+
+    // the whole array, which starts at an unaligned offset, and a part of it into an unaligned
+    // buffer
+    std::vector<std::uint32_t> all(count);
+    std::vector<std::uint32_t> part(1001);
+    reader.Queue(sizeof(count), all.data(), count * sizeof(std::uint32_t));
+    reader.Queue(sizeof(count) + 4 * 4095, part.data() + 1, 1000 * sizeof(std::uint32_t));
+    reader.Wait();
+    BOOST_CHECK_EQUAL_COLLECTIONS(all.begin(), all.end(), numbers.begin(), numbers.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        part.begin() + 1, part.end(), numbers.begin() + 4095, numbers.begin() + 5095);
+
+    // the reader can be used again, the tail of the file ends within a block
+    std::vector<std::uint32_t> tail(10);
+    reader.Queue(reader.GetSize() - 40, tail.data(), 40);
+    reader.Wait();
+    BOOST_CHECK_EQUAL_COLLECTIONS(tail.begin(), tail.end(), numbers.end() - 10, numbers.end());
+}
+
+BOOST_AUTO_TEST_CASE(invalid_read_test)
+{
+    TemporaryFile file;
+    writeNumbers(file.path);
+
+    BulkReader reader(file.path);
+    std::vector<char> buffer(16);
+    BOOST_CHECK_THROW(reader.Queue(reader.GetSize() - 8, buffer.data(), 16), util::exception);
+    BOOST_CHECK_THROW(reader.Read(reader.GetSize() - 8, buffer.data(), 16), util::exception);
+    BOOST_CHECK_THROW(BulkReader(file.path.string() + ".missing"), util::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,102 @@
+#include "engine/routing_algorithms/core_landmark_potential.hpp"
+#include "util/array_view.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(core_landmark_potential)
+
+using namespace osrm;
+using namespace osrm::engine::routing_algorithms;
+
+namespace
+{
+const auto INVALID = INVALID_EDGE_WEIGHT;
+
+// The core 0 <-> 1 -> 2 <-> 3 -> 0 with the landmarks 3 and 1, node 4 is an island of the core
+// and node 5 is outside of it
+struct LandmarkFacade
+{
+    unsigned GetNumberOfCoreLandmarks() const { return 2; }
+
+    util::ArrayView<EdgeWeight> GetCoreLandmarkWeights(const NodeID id) const
+    {
+        const auto &node_weights = weights[id];
+        return {node_weights.data(), node_weights.data() + node_weights.size()};
+    }
+
+    const std::vector<std::vector<EdgeWeight>> weights = {{20, 10, 22, 10},
+                                                          {30, 0, 12, 0},
+                                                          {7, 5, 7, 37},
+                                                          {0, 12, 0, 30},
+                                                          {INVALID, INVALID, INVALID, INVALID},
+                                                          {}};
+};
+
+struct Arc
+{
+    NodeID source;
+    NodeID target;
+    EdgeWeight weight;
+};
+const std::vector<Arc> arcs = {{0, 1, 10}, {1, 0, 10}, {1, 2, 5}, {2, 3, 7}, {3, 2, 7}, {3, 0, 20}};
+
+// weights of the shortest paths between the nodes of the core
+const std::vector<std::vector<EdgeWeight>> path_weights = {
+    {0, 10, 15, 22}, {10, 0, 5, 12}, {27, 37, 0, 7}, {20, 30, 7, 0}};
+}
+
+BOOST_AUTO_TEST_CASE(single_target_test)
+{
+    const LandmarkFacade facade;
+    const CoreLandmarkPotential<LandmarkFacade> potential(facade, {{2, 4}});
+
+    // the landmarks bound the weights to the target exactly on this core
+    for (const NodeID node : {0, 1, 2, 3})
+    {
+        BOOST_CHECK_EQUAL(potential(node), path_weights[node][2] + 4);
+    }
+    // the target reaches the landmarks, the island does not
+    BOOST_CHECK_EQUAL(potential(4), INVALID_EDGE_WEIGHT);
+}
+
+BOOST_AUTO_TEST_CASE(consistent_test)
+{
+    const LandmarkFacade facade;
+    const std::vector<std::pair<NodeID, EdgeWeight>> targets = {{1, 0}, {3, 5}};
+    const CoreLandmarkPotential<LandmarkFacade> potential(facade, targets);
+
+    for (const NodeID node : {0, 1, 2, 3})
+    {
+        EdgeWeight target_weight = INVALID_EDGE_WEIGHT;
+        for (const auto &target : targets)
+        {
+            target_weight =
+                std::min(target_weight, path_weights[node][target.first] + target.second);
+        }
+        BOOST_CHECK_LE(potential(node), target_weight);
+    }
+    for (const auto &arc : arcs)
+    {
+        BOOST_CHECK_LE(potential(arc.source), arc.weight + potential(arc.target));
+    }
+    // the targets themselves are bounded by their weights
+    BOOST_CHECK_EQUAL(potential(1), 0);
+    BOOST_CHECK_EQUAL(potential(3), 5);
+}
+
+BOOST_AUTO_TEST_CASE(target_outside_of_core_test)
+{
+    // without the landmarks the weights of the targets are the only bound
+    const LandmarkFacade facade;
+    const CoreLandmarkPotential<LandmarkFacade> potential(facade, {{2, 4}, {5, 3}});
+    for (const NodeID node : {0, 1, 2, 3, 4})
+    {
+        BOOST_CHECK_EQUAL(potential(node), 3);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
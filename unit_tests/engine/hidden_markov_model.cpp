@@ -0,0 +1,126 @@
+#include "engine/map_matching/hidden_markov_model.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(hidden_markov_model)
+
+using namespace osrm;
+using namespace osrm::engine::map_matching;
+
+BOOST_AUTO_TEST_CASE(layout_test)
+{
+    const std::vector<std::vector<int>> candidates = {{1, 2}, {}, {3, 4, 5}};
+
+    HiddenMarkovModel model;
+    model.Initialize(candidates);
+
+    BOOST_CHECK_EQUAL(model.NumberOfTimestamps(), 3);
+    BOOST_CHECK_EQUAL(model.NumberOfCandidates(0), 2);
+    BOOST_CHECK_EQUAL(model.NumberOfCandidates(1), 0);
+    BOOST_CHECK_EQUAL(model.NumberOfCandidates(2), 3);
+    BOOST_CHECK_EQUAL(model.Index(2, 0), 2);
+    BOOST_CHECK_EQUAL(model.Index(2, 2), 4);
+    BOOST_CHECK_EQUAL(model.viterbi.size(), 5);
+    BOOST_CHECK_EQUAL(model.emission_log_probabilities.size(), 5);
+    for (const auto index : util::irange<std::size_t>(0UL, 5UL))
+    {
+        BOOST_CHECK_EQUAL(model.viterbi[index], IMPOSSIBLE_LOG_PROB);
+        BOOST_CHECK(model.pruned[index]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(initialize_skips_broken_timestamps_test)
+{
+    const std::vector<std::vector<int>> candidates = {{1}, {2, 3}, {4}};
+
+    HiddenMarkovModel model;
+    model.Initialize(candidates);
+    model.emission_log_probabilities = {IMPOSSIBLE_LOG_PROB, -2., -1., -3.};
+
+    BOOST_CHECK_EQUAL(model.initialize(0), 1);
+    BOOST_CHECK(model.breakage[0]);
+    BOOST_CHECK(!model.breakage[1]);
+    BOOST_CHECK_EQUAL(model.viterbi[model.Index(1, 1)], -1.);
+    BOOST_CHECK_EQUAL(model.parents[model.Index(1, 1)].first, 1);
+    BOOST_CHECK_EQUAL(model.parents[model.Index(1, 1)].second, 1);
+
+    // clearing keeps the timestamps before the split
+    model.Clear(2);
+    BOOST_CHECK_EQUAL(model.viterbi[model.Index(1, 1)], -1.);
+    BOOST_CHECK(model.breakage[2]);
+}
+
+BOOST_AUTO_TEST_CASE(reuse_test)
+{
+    HiddenMarkovModel model;
+    model.Initialize(std::vector<std::vector<int>>{{1, 2, 3}, {4, 5, 6}});
+    model.emission_log_probabilities = {-1., -2., -3., -4., -5., -6.};
+    BOOST_CHECK_EQUAL(model.initialize(0), 0);
+
+    // a shorter trace starts from a clean state
+    model.Initialize(std::vector<std::vector<int>>{{1}, {2, 3}});
+    BOOST_CHECK_EQUAL(model.NumberOfTimestamps(), 2);
+    BOOST_CHECK_EQUAL(model.viterbi.size(), 3);
+    for (const auto index : util::irange<std::size_t>(0UL, 3UL))
+    {
+        BOOST_CHECK_EQUAL(model.viterbi[index], IMPOSSIBLE_LOG_PROB);
+        BOOST_CHECK(model.pruned[index]);
+    }
+    BOOST_CHECK(model.breakage[0]);
+    BOOST_CHECK(model.breakage[1]);
+}
+
+BOOST_AUTO_TEST_CASE(append_test)
+{
+    std::vector<std::vector<int>> candidates = {{1, 2}, {3}};
+
+    HiddenMarkovModel model;
+    model.Initialize(candidates);
+    model.emission_log_probabilities = {-1., -2., -3.};
+    BOOST_CHECK_EQUAL(model.initialize(0), 0);
+
+    // appending keeps the values of the timestamps there are
+    candidates.push_back({4, 5, 6});
+    model.Append(candidates);
+    BOOST_CHECK_EQUAL(model.NumberOfTimestamps(), 3);
+    BOOST_CHECK_EQUAL(model.NumberOfCandidates(2), 3);
+    BOOST_CHECK_EQUAL(model.viterbi.size(), 6);
+    BOOST_CHECK_EQUAL(model.viterbi[model.Index(0, 1)], -2.);
+    BOOST_CHECK(!model.breakage[0]);
+    BOOST_CHECK(model.breakage[2]);
+    BOOST_CHECK(model.pruned[model.Index(2, 0)]);
+}
+
+BOOST_AUTO_TEST_CASE(drop_front_test)
+{
+    HiddenMarkovModel model;
+    model.Initialize(std::vector<std::vector<int>>{{1}, {2, 3}, {4, 5}});
+    model.emission_log_probabilities = {-1., -2., -3., -4., -5.};
+    BOOST_CHECK_EQUAL(model.initialize(0), 0);
+    model.parents[model.Index(1, 0)] = std::make_pair(0, 0);
+    model.parents[model.Index(1, 1)] = std::make_pair(0, 0);
+    model.path_distances[model.Index(1, 0)] = 10;
+    model.parents[model.Index(2, 0)] = std::make_pair(1, 1);
+    model.parents[model.Index(2, 1)] = std::make_pair(1, 0);
+    model.path_distances[model.Index(2, 0)] = 20;
+
+    model.DropFront(1);
+    BOOST_CHECK_EQUAL(model.NumberOfTimestamps(), 2);
+    BOOST_CHECK_EQUAL(model.offsets.size(), 3);
+    BOOST_CHECK_EQUAL(model.Index(1, 0), 2);
+    BOOST_CHECK_EQUAL(model.emission_log_probabilities[model.Index(0, 0)], -2.);
+
+    // the paths start at the first timestamp that is left
+    BOOST_CHECK_EQUAL(model.parents[model.Index(0, 0)].first, 0);
+    BOOST_CHECK_EQUAL(model.parents[model.Index(0, 0)].second, 0);
+    BOOST_CHECK_EQUAL(model.path_distances[model.Index(0, 0)], 0.);
+    BOOST_CHECK_EQUAL(model.parents[model.Index(0, 1)].second, 1);
+    BOOST_CHECK_EQUAL(model.parents[model.Index(1, 0)].first, 0);
+    BOOST_CHECK_EQUAL(model.parents[model.Index(1, 0)].second, 1);
+    BOOST_CHECK_EQUAL(model.path_distances[model.Index(1, 0)], 20.);
+    BOOST_CHECK_EQUAL(model.parents[model.Index(1, 1)].second, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
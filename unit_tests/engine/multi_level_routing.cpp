@@ -0,0 +1,210 @@
+#include "engine/routing_algorithms/multi_level_routing.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/integer_range.hpp"
+#include "util/multi_level_graph.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(multi_level_routing)
+
+using namespace osrm;
+using namespace osrm::engine;
+using namespace osrm::util;
+
+namespace
+{
+struct TestEdge
+{
+    NodeID source;
+    NodeID target;
+    EdgeWeight weight;
+    NodeID edge_id;
+    bool forward;
+    bool backward;
+};
+
+// 6x6 grid, the rows are two-way and the columns one-way downwards except for the last one. The
+// cells of level 1 are 3x3 squares, those of level 2 the upper and lower half.
+MultiLevelGraph makeGridGraph()
+{
+    std::vector<TestEdge> edges;
+    std::vector<std::vector<MultiLevelPartition::CellID>> level_cells(2);
+    for (const auto y : irange<NodeID>(0, 6))
+    {
+        for (const auto x : irange<NodeID>(0, 6))
+        {
+            const auto node = y * 6 + x;
+            if (x < 5)
+            {
+                edges.push_back({node,
+                                 node + 1,
+                                 static_cast<EdgeWeight>(1 + (x * 3 + y * 7) % 5),
+                                 node,
+                                 true,
+                                 true});
+            }
+            if (y < 5)
+            {
+                edges.push_back({node,
+                                 node + 6,
+                                 static_cast<EdgeWeight>(1 + (x * 5 + y) % 4),
+                                 36 + node,
+                                 true,
+                                 x == 5});
+            }
+            level_cells[0].push_back((y / 3) * 2 + x / 3);
+            level_cells[1].push_back(y / 3);
+        }
+    }
+    return MultiLevelGraph(MultiLevelPartition(level_cells), edges);
+}
+
+std::vector<EdgeWeight> shortestPaths(const MultiLevelGraph &graph,
+                                      const NodeID source,
+                                      const std::function<bool(NodeID)> &filter)
+{
+    std::vector<EdgeWeight> weights(graph.GetNumberOfNodes(), INVALID_EDGE_WEIGHT);
+    using Entry = std::pair<EdgeWeight, NodeID>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    weights[source] = 0;
+    queue.push({0, source});
+    while (!queue.empty())
+    {
+        const auto entry = queue.top();
+        queue.pop();
+        if (entry.first > weights[entry.second])
+        {
+            continue;
+        }
+        for (const auto arc : graph.GetOutArcs(entry.second))
+        {
+            const auto &data = graph.GetOutArc(arc);
+            if (filter(data.head) && entry.first + data.weight < weights[data.head])
+            {
+                weights[data.head] = entry.first + data.weight;
+                queue.push({weights[data.head], data.head});
+            }
+        }
+    }
+    return weights;
+}
+
+// sets the cliques to the shortest paths inside the cells, which the customization computes
+void fillCliques(MultiLevelGraph &graph)
+{
+    const auto &partition = graph.GetPartition();
+    for (const auto level : irange<MultiLevelGraph::LevelID>(1, 3))
+    {
+        const auto number_of_cells = partition.GetNumberOfCells(level);
+        for (const auto cell : irange<MultiLevelGraph::CellID>(0, number_of_cells))
+        {
+            const auto boundary = graph.GetBoundaryNodes(level, cell);
+            const auto size = static_cast<std::size_t>(boundary.second - boundary.first);
+            const auto weights = graph.GetCliqueWeights(level, cell);
+            for (const auto from : irange<std::size_t>(0, size))
+            {
+                const auto cell_weights =
+                    shortestPaths(graph, boundary.first[from], [&](const NodeID node) {
+                        return partition.GetCell(level, node) == cell;
+                    });
+                for (const auto to : irange<std::size_t>(0, size))
+                {
+                    weights[from * size + to] = cell_weights[boundary.first[to]];
+                }
+            }
+        }
+    }
+}
+}
+
+BOOST_AUTO_TEST_CASE(search_test)
+{
+    auto graph = makeGridGraph();
+    fillCliques(graph);
+
+    using Heap = SearchEngineData::MultiLevelQueryHeap;
+    Heap forward_heap(graph.GetNumberOfNodes());
+    Heap reverse_heap(graph.GetNumberOfNodes());
+    Heap unpacking_heap(graph.GetNumberOfNodes());
+    std::vector<MultiLevelGraph::Arc> path;
+    for (const auto from : irange<NodeID>(0, graph.GetNumberOfNodes()))
+    {
+        const auto expected = shortestPaths(graph, from, [](const NodeID) { return true; });
+        for (const auto to : irange<NodeID>(0, graph.GetNumberOfNodes()))
+        {
+            forward_heap.Clear();
+            reverse_heap.Clear();
+            forward_heap.Insert(from, 0, {from, SPECIAL_EDGEID, 0});
+            reverse_heap.Insert(to, 0, {to, SPECIAL_EDGEID, 0});
+            path.clear();
+            NodeID source = SPECIAL_NODEID;
+            const auto weight = routing_algorithms::searchMultiLevelGraph(
+                graph, forward_heap, reverse_heap, unpacking_heap, {from, to}, source, path);
+            BOOST_CHECK_EQUAL(weight, expected[to]);
+            if (weight == INVALID_EDGE_WEIGHT)
+            {
+                continue;
+            }
+
+            // the path consists of base arcs from the source to the target
+            BOOST_CHECK_EQUAL(source, from);
+            NodeID node = from;
+            EdgeWeight path_weight = 0;
+            for (const auto &arc : path)
+            {
+                bool found = false;
+                for (const auto id : graph.GetOutArcs(node))
+                {
+                    found |= graph.GetOutArc(id).head == arc.head &&
+                             graph.GetOutArc(id).edge_id == arc.edge_id;
+                }
+                BOOST_REQUIRE(found);
+                path_weight += arc.weight;
+                node = arc.head;
+            }
+            BOOST_CHECK_EQUAL(node, to);
+            BOOST_CHECK_EQUAL(path_weight, weight);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(search_with_offsets_test)
+{
+    auto graph = makeGridGraph();
+    fillCliques(graph);
+
+    // sources and targets with offsets, like the segments of phantom nodes
+    using Heap = SearchEngineData::MultiLevelQueryHeap;
+    Heap forward_heap(graph.GetNumberOfNodes());
+    Heap reverse_heap(graph.GetNumberOfNodes());
+    Heap unpacking_heap(graph.GetNumberOfNodes());
+    forward_heap.Insert(0, -3, {0, SPECIAL_EDGEID, 0});
+    forward_heap.Insert(5, -1, {5, SPECIAL_EDGEID, 0});
+    reverse_heap.Insert(35, 2, {35, SPECIAL_EDGEID, 0});
+    reverse_heap.Insert(30, 4, {30, SPECIAL_EDGEID, 0});
+
+    const auto all_nodes = [](const NodeID) { return true; };
+    EdgeWeight expected = INVALID_EDGE_WEIGHT;
+    for (const auto &source : {std::make_pair(0u, -3), std::make_pair(5u, -1)})
+    {
+        const auto weights = shortestPaths(graph, source.first, all_nodes);
+        expected = std::min({expected,
+                             source.second + weights[35] + 2,
+                             source.second + weights[30] + 4});
+    }
+
+    std::vector<MultiLevelGraph::Arc> path;
+    NodeID source = SPECIAL_NODEID;
+    const auto weight = routing_algorithms::searchMultiLevelGraph(
+        graph, forward_heap, reverse_heap, unpacking_heap, {0, 5, 30, 35}, source, path);
+    BOOST_CHECK_EQUAL(weight, expected);
+    BOOST_CHECK(!path.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
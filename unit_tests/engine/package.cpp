@@ -0,0 +1,206 @@
+#include "storage/package.hpp"
+#include "util/exception.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(package)
+
+using namespace osrm;
+using namespace osrm::storage;
+
+namespace
+{
+struct TemporaryFile
+{
+    TemporaryFile()
+        : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+    {
+    }
+    ~TemporaryFile() { boost::filesystem::remove(path); }
+    boost::filesystem::path path;
+};
+
+// a dataset with a few chunks in the data region and a small metric region
+struct Dataset
+{
+    Dataset()
+    {
+        layout.SetBlockSize<char>(SharedDataLayout::NAME_CHAR_LIST, 3 * 1024 * 1024 + 123);
+        layout.SetBlockSize<std::uint32_t>(SharedDataLayout::NAME_ID_LIST, 1000);
+        layout.SetBlockSize<std::uint32_t>(SharedDataLayout::GRAPH_NODE_LIST, 5000);
+        data.reset(new char[layout.GetSizeOfLayout()]());
+        metric.reset(new char[layout.GetSizeOfMetric()]());
+
+        // names compress well, the ids do not
+        auto names = layout.GetBlockPtr<char, true>(data.get(), SharedDataLayout::NAME_CHAR_LIST);
+        for (std::size_t index = 0; index < 3 * 1024 * 1024 + 123; ++index)
+        {
+            names[index] = "Main Street"[index % 11];
+        }
+        auto ids = layout.GetBlockPtr<std::uint32_t, true>(data.get(),
+                                                             SharedDataLayout::NAME_ID_LIST);
+        for (std::uint32_t index = 0; index < 1000; ++index)
+        {
+            ids[index] = index * 2654435761u;
+        }
+        auto nodes = layout.GetBlockPtr<std::uint32_t, true>(metric.get(),
+                                                               SharedDataLayout::GRAPH_NODE_LIST);
+        for (std::uint32_t index = 0; index < 5000; ++index)
+        {
+            nodes[index] = index;
+        }
+        // like osrm-datastore, every block gets its canaries
+        for (auto index = 0; index < SharedDataLayout::NUM_BLOCKS; ++index)
+        {
+            const auto block = static_cast<SharedDataLayout::BlockID>(index);
+            layout.GetBlockPtr<char, true>(
+                SharedDataLayout::IsMetricBlock(block) ? metric.get() : data.get(), block);
+        }
+        layout.ComputeChecksums(data.get(), metric.get());
+    }
+
+    SharedDataLayout layout;
+    std::unique_ptr<char[]> data;
+    std::unique_ptr<char[]> metric;
+};
+
+std::uint64_t checkRoundTrip(const int level)
+{
+    TemporaryFile file;
+    Dataset dataset;
+    const auto size = writePackage(
+        file.path, dataset.layout, dataset.data.get(), dataset.metric.get(), level);
+    BOOST_CHECK_EQUAL(size, boost::filesystem::file_size(file.path));
+
+    PackageReader reader(file.path);
+    const auto &layout = reader.GetLayout();
+    BOOST_CHECK(layout.HasSameData(dataset.layout));
+    BOOST_CHECK_EQUAL(layout.GetSizeOfMetric(), dataset.layout.GetSizeOfMetric());
+
+    std::vector<char> data(layout.GetSizeOfLayout());
+    std::vector<char> metric(layout.GetSizeOfMetric());
+    reader.Read(data.data(), metric.data());
+    BOOST_CHECK(std::equal(data.begin(), data.end(), dataset.data.get()));
+    BOOST_CHECK(std::equal(metric.begin(), metric.end(), dataset.metric.get()));
+    return size;
+}
+}
+
+BOOST_AUTO_TEST_CASE(chunks_test)
+{
+    Dataset dataset;
+    const auto chunks = getPackageChunks(dataset.layout);
+    // four chunks of names, one of ids and one of nodes
+    BOOST_REQUIRE_EQUAL(chunks.size(), 6u);
+    BOOST_CHECK_EQUAL(chunks[0].block, SharedDataLayout::NAME_CHAR_LIST);
+    BOOST_CHECK_EQUAL(chunks[3].size, 124u);
+    BOOST_CHECK_EQUAL(chunks[4].block, SharedDataLayout::NAME_ID_LIST);
+    BOOST_CHECK_EQUAL(chunks[5].block, SharedDataLayout::GRAPH_NODE_LIST);
+    BOOST_CHECK_EQUAL(chunks[5].size, 5000u * sizeof(std::uint32_t));
+}
+
+BOOST_AUTO_TEST_CASE(stored_test) { checkRoundTrip(0); }
+
+BOOST_AUTO_TEST_CASE(compressed_test)
+{
+    if (!packageCompressionSupported())
+    {
+        BOOST_CHECK_THROW(checkRoundTrip(3), util::exception);
+        return;
+    }
+    // the names shrink to a fraction, the ids are stored
+    BOOST_CHECK_LT(checkRoundTrip(3), checkRoundTrip(0) / 2);
+}
+
+BOOST_AUTO_TEST_CASE(skip_and_corruption_test)
+{
+    TemporaryFile file;
+    Dataset dataset;
+    writePackage(file.path, dataset.layout, dataset.data.get(), dataset.metric.get(), 0);
+
+    // only the metric region
+    {
+        PackageReader reader(file.path);
+        std::vector<char> metric(reader.GetLayout().GetSizeOfMetric());
+        reader.Read(nullptr, metric.data());
+        BOOST_CHECK(std::equal(metric.begin(), metric.end(), dataset.metric.get()));
+    }
+
+    // a flipped byte in the last frame, which holds the nodes
+    {
+        boost::filesystem::fstream stream(file.path,
+                                          std::ios::binary | std::ios::in | std::ios::out);
+        stream.seekp(boost::filesystem::file_size(file.path) - 7);
+        stream.put('x');
+    }
+    PackageReader reader(file.path);
+    std::vector<char> data(reader.GetLayout().GetSizeOfLayout());
+    std::vector<char> metric(reader.GetLayout().GetSizeOfMetric());
+    reader.Read(data.data(), nullptr);
+    BOOST_CHECK_THROW(reader.Read(data.data(), metric.data()), util::exception);
+
+    BOOST_CHECK_THROW(PackageReader(file.path.string() + ".missing"), util::exception);
+}
+
+BOOST_AUTO_TEST_CASE(delta_test)
+{
+    TemporaryFile full_file;
+    TemporaryFile delta_file;
+    Dataset base;
+    const auto level = packageCompressionSupported() ? 3 : 0;
+    const auto full_size = writePackage(
+        full_file.path, base.layout, base.data.get(), base.metric.get(), level);
+
+    // a few updated weights
+    Dataset dataset;
+    auto nodes = dataset.layout.GetBlockPtr<std::uint32_t>(dataset.metric.get(),
+                                                           SharedDataLayout::GRAPH_NODE_LIST);
+    nodes[17] = 4711;
+    nodes[4000] = 42;
+    dataset.layout.ComputeChecksums(dataset.data.get(), dataset.metric.get());
+    const PackageBase package_base{&base.layout, base.data.get(), base.metric.get()};
+    const auto delta_size = writePackage(delta_file.path,
+                                         dataset.layout,
+                                         dataset.data.get(),
+                                         dataset.metric.get(),
+                                         level,
+                                         package_base);
+    BOOST_CHECK_LT(delta_size, full_size);
+    if (packageCompressionSupported())
+    {
+        // the index, the header and a patch of the weights
+        BOOST_CHECK_LT(delta_size, PACKAGE_INDEX_OFFSET + 6 * sizeof(PackageFrame) + 1024);
+    }
+
+    PackageReader reader(delta_file.path);
+    BOOST_CHECK(reader.IsDelta());
+    const auto &layout = reader.GetLayout();
+    std::vector<char> data(layout.GetSizeOfLayout());
+    std::vector<char> metric(layout.GetSizeOfMetric());
+    BOOST_CHECK_THROW(reader.Read(data.data(), metric.data()), util::exception);
+    reader.Read(data.data(), metric.data(), package_base);
+    BOOST_CHECK(std::equal(data.begin(), data.end(), dataset.data.get()));
+    BOOST_CHECK(std::equal(metric.begin(), metric.end(), dataset.metric.get()));
+
+    // the data is shared with the base, only the metric is applied
+    std::vector<char> applied_metric(layout.GetSizeOfMetric());
+    const PackageBase metric_base{&base.layout, nullptr, base.metric.get()};
+    reader.Read(nullptr, applied_metric.data(), metric_base);
+    BOOST_CHECK(std::equal(applied_metric.begin(), applied_metric.end(), dataset.metric.get()));
+
+    // a delta only applies to its base
+    Dataset other;
+    auto ids =
+        other.layout.GetBlockPtr<std::uint32_t>(other.data.get(), SharedDataLayout::NAME_ID_LIST);
+    ids[0] = 1;
+    const PackageBase other_base{&other.layout, other.data.get(), other.metric.get()};
+    BOOST_CHECK_THROW(reader.Read(data.data(), metric.data(), other_base), util::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
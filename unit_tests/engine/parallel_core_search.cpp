@@ -0,0 +1,195 @@
+#include "engine/routing_algorithms/routing_base.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/integer_range.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(parallel_core_search)
+
+using namespace osrm;
+using namespace osrm::engine;
+using namespace osrm::engine::routing_algorithms;
+
+namespace
+{
+// A graph that is all core, as the ones contracted with a core factor of 0
+struct CoreFacade
+{
+    struct EdgeData
+    {
+        NodeID target;
+        EdgeWeight weight;
+        bool forward;
+        bool backward;
+    };
+
+    bool IsCoreNode(const NodeID) const { return true; }
+    unsigned GetNumberOfCoreLandmarks() const { return 0; }
+    util::ArrayView<EdgeWeight> GetCoreLandmarkWeights(const NodeID) const { return {}; }
+
+    util::range<EdgeID> GetForwardEdgeRange(const NodeID node) const
+    {
+        return util::irange(offsets[node], offsets[node + 1]);
+    }
+    util::range<EdgeID> GetBackwardEdgeRange(const NodeID node) const
+    {
+        return util::irange(offsets[node], offsets[node + 1]);
+    }
+    const EdgeData &GetHotEdgeData(const EdgeID edge) const { return edges[edge]; }
+
+    std::vector<EdgeID> offsets;
+    std::vector<EdgeData> edges;
+};
+
+class CoreRouting final : public BasicRoutingInterface<CoreFacade, CoreRouting>
+{
+};
+
+const NodeID GRID_SIZE = 20;
+
+// Grid with two-way rows and columns that are one-way in alternating directions
+CoreFacade makeGridFacade()
+{
+    std::vector<std::vector<CoreFacade::EdgeData>> adjacency(GRID_SIZE * GRID_SIZE);
+    const auto addArc = [&](const NodeID from, const NodeID to, const EdgeWeight weight) {
+        adjacency[from].push_back({to, weight, true, false});
+        adjacency[to].push_back({from, weight, false, true});
+    };
+    for (const auto y : util::irange<NodeID>(0, GRID_SIZE))
+    {
+        for (const auto x : util::irange<NodeID>(0, GRID_SIZE))
+        {
+            const auto node = y * GRID_SIZE + x;
+            if (x + 1 < GRID_SIZE)
+            {
+                const EdgeWeight weight = 1 + (x * 7 + y * 3) % 11;
+                addArc(node, node + 1, weight);
+                addArc(node + 1, node, weight);
+            }
+            if (y + 1 < GRID_SIZE)
+            {
+                const EdgeWeight weight = 1 + (x * 5 + y * 13) % 9;
+                if (x % 2 == 0)
+                    addArc(node, node + GRID_SIZE, weight);
+                else
+                    addArc(node + GRID_SIZE, node, weight);
+            }
+        }
+    }
+
+    CoreFacade facade;
+    facade.offsets.push_back(0);
+    for (const auto &node_edges : adjacency)
+    {
+        facade.edges.insert(facade.edges.end(), node_edges.begin(), node_edges.end());
+        facade.offsets.push_back(facade.edges.size());
+    }
+    return facade;
+}
+
+EdgeWeight shortestPath(const CoreFacade &facade, const NodeID source, const NodeID target)
+{
+    std::vector<EdgeWeight> weights(facade.offsets.size() - 1, INVALID_EDGE_WEIGHT);
+    using Entry = std::pair<EdgeWeight, NodeID>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    weights[source] = 0;
+    queue.push({0, source});
+    while (!queue.empty())
+    {
+        const auto entry = queue.top();
+        queue.pop();
+        if (entry.first > weights[entry.second])
+        {
+            continue;
+        }
+        for (const auto edge : facade.GetForwardEdgeRange(entry.second))
+        {
+            const auto &data = facade.GetHotEdgeData(edge);
+            if (data.forward && entry.first + data.weight < weights[data.target])
+            {
+                weights[data.target] = entry.first + data.weight;
+                queue.push({weights[data.target], data.target});
+            }
+        }
+    }
+    return weights[target];
+}
+
+// Weight of the path along the nodes, INVALID_EDGE_WEIGHT if two of them are not adjacent
+EdgeWeight pathWeight(const CoreFacade &facade, const std::vector<NodeID> &path)
+{
+    EdgeWeight weight = 0;
+    for (const auto index : util::irange<std::size_t>(1, path.size()))
+    {
+        EdgeWeight arc_weight = INVALID_EDGE_WEIGHT;
+        for (const auto edge : facade.GetForwardEdgeRange(path[index - 1]))
+        {
+            const auto &data = facade.GetHotEdgeData(edge);
+            if (data.forward && data.target == path[index])
+            {
+                arc_weight = std::min(arc_weight, data.weight);
+            }
+        }
+        if (arc_weight == INVALID_EDGE_WEIGHT)
+        {
+            return INVALID_EDGE_WEIGHT;
+        }
+        weight += arc_weight;
+    }
+    return weight;
+}
+}
+
+BOOST_AUTO_TEST_CASE(shortest_paths_test)
+{
+    const auto facade = makeGridFacade();
+    const CoreRouting routing;
+    SearchEngineData heaps;
+    SearchEngineData::Lease lease;
+    heaps.InitializeOrClearFirstThreadLocalStorage(GRID_SIZE * GRID_SIZE);
+    heaps.InitializeOrClearSecondThreadLocalStorage(GRID_SIZE * GRID_SIZE);
+
+    const std::vector<std::pair<NodeID, NodeID>> queries = {
+        {0, GRID_SIZE * GRID_SIZE - 1}, {GRID_SIZE * GRID_SIZE - 1, 0}, {5, 5}, {17, 342},
+        {399, 20}, {123, 124}, {124, 123}, {210, 9}};
+    for (const auto &query : queries)
+    {
+        for (const bool search_core_in_parallel : {false, true})
+        {
+            auto &forward_heap = *heaps.forward_heap_1;
+            auto &reverse_heap = *heaps.reverse_heap_1;
+            forward_heap.Clear();
+            reverse_heap.Clear();
+            forward_heap.Insert(query.first, 0, query.first);
+            reverse_heap.Insert(query.second, 0, query.second);
+
+            EdgeWeight weight = INVALID_EDGE_WEIGHT;
+            std::vector<NodeID> packed_leg;
+            routing.SearchWithCore(facade,
+                                   forward_heap,
+                                   reverse_heap,
+                                   *heaps.forward_heap_2,
+                                   *heaps.reverse_heap_2,
+                                   weight,
+                                   packed_leg,
+                                   false,
+                                   false,
+                                   INVALID_EDGE_WEIGHT,
+                                   search_core_in_parallel);
+
+            const auto expected_weight = shortestPath(facade, query.first, query.second);
+            BOOST_CHECK_EQUAL(weight, expected_weight);
+            BOOST_REQUIRE(!packed_leg.empty());
+            BOOST_CHECK_EQUAL(packed_leg.front(), query.first);
+            BOOST_CHECK_EQUAL(packed_leg.back(), query.second);
+            BOOST_CHECK_EQUAL(pathWeight(facade, packed_leg), expected_weight);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
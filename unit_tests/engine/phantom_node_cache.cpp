@@ -0,0 +1,75 @@
+#include "engine/phantom_node_cache.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(phantom_node_cache)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+PhantomNodePair makePhantomNodes(const NodeID node)
+{
+    PhantomNodePair phantom_nodes;
+    phantom_nodes.first.forward_segment_id = {node, true};
+    phantom_nodes.second.forward_segment_id = {node + 1, true};
+    return phantom_nodes;
+}
+}
+
+BOOST_AUTO_TEST_CASE(insert_find_test)
+{
+    PhantomNodeCache cache(64);
+    const util::Coordinate coordinate{util::FloatLongitude{7.41}, util::FloatLatitude{43.73}};
+    const boost::optional<double> no_radius;
+    const boost::optional<Bearing> no_bearing;
+
+    PhantomNodePair phantom_nodes;
+    BOOST_CHECK(!cache.Find(coordinate, no_radius, no_bearing, phantom_nodes));
+
+    cache.Insert(coordinate, no_radius, no_bearing, makePhantomNodes(10));
+    BOOST_CHECK(cache.Find(coordinate, no_radius, no_bearing, phantom_nodes));
+    BOOST_CHECK_EQUAL(phantom_nodes.first.forward_segment_id.id, 10);
+    BOOST_CHECK_EQUAL(phantom_nodes.second.forward_segment_id.id, 11);
+
+    // the radius and bearing are part of the key
+    BOOST_CHECK(!cache.Find(coordinate, boost::optional<double>{100.}, no_bearing, phantom_nodes));
+    BOOST_CHECK(!cache.Find(coordinate, no_radius, Bearing{0, 180}, phantom_nodes));
+    BOOST_CHECK(!cache.Find(
+        util::Coordinate{util::FloatLongitude{7.410001}, util::FloatLatitude{43.73}},
+        no_radius,
+        no_bearing,
+        phantom_nodes));
+
+    cache.Insert(coordinate, no_radius, Bearing{90, 20}, makePhantomNodes(20));
+    BOOST_CHECK(cache.Find(coordinate, no_radius, Bearing{90, 20}, phantom_nodes));
+    BOOST_CHECK_EQUAL(phantom_nodes.first.forward_segment_id.id, 20);
+    BOOST_CHECK(cache.Find(coordinate, no_radius, no_bearing, phantom_nodes));
+    BOOST_CHECK_EQUAL(phantom_nodes.first.forward_segment_id.id, 10);
+    BOOST_CHECK_EQUAL(cache.GetNumberOfEntries(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(bounded_test)
+{
+    const std::size_t number_of_shards = PhantomNodeCache::NUMBER_OF_SHARDS;
+    PhantomNodeCache cache(number_of_shards);
+    const boost::optional<double> no_radius;
+    const boost::optional<Bearing> no_bearing;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        const util::Coordinate coordinate{util::FixedLongitude{i}, util::FixedLatitude{0}};
+        cache.Insert(coordinate, no_radius, no_bearing, makePhantomNodes(i));
+
+        // the entry that was just inserted is never evicted right away
+        PhantomNodePair phantom_nodes;
+        BOOST_CHECK(cache.Find(coordinate, no_radius, no_bearing, phantom_nodes));
+        BOOST_CHECK_EQUAL(phantom_nodes.first.forward_segment_id.id, i);
+    }
+    // every shard holds a single entry
+    BOOST_CHECK_LE(cache.GetNumberOfEntries(), number_of_shards);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
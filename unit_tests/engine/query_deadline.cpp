@@ -0,0 +1,84 @@
+#include "engine/query_deadline.hpp"
+#include "engine/trip/trip_held_karp.hpp"
+#include "util/dist_table_wrapper.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(query_deadline)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+BOOST_AUTO_TEST_CASE(no_deadline_test)
+{
+    QueryDeadline deadline;
+    BOOST_CHECK(!deadline.IsActive());
+    for (unsigned call = 0; call < 2 * QueryDeadline::CHECK_INTERVAL; ++call)
+    {
+        deadline.Check();
+    }
+    deadline.CheckNow();
+}
+
+BOOST_AUTO_TEST_CASE(expired_deadline_test)
+{
+    QueryDeadline deadline(QueryDeadline::Clock::now() - std::chrono::milliseconds(1), nullptr);
+    BOOST_CHECK(deadline.IsActive());
+    BOOST_CHECK_EXCEPTION(deadline.CheckNow(), QueryCancelled, [](const QueryCancelled &e) {
+        return e.TimedOut() && std::string(e.Code()) == "Timeout";
+    });
+
+    // the clock is only read every CHECK_INTERVAL calls
+    for (unsigned call = 1; call < QueryDeadline::CHECK_INTERVAL; ++call)
+    {
+        deadline.Check();
+    }
+    BOOST_CHECK_THROW(deadline.Check(), QueryCancelled);
+}
+
+BOOST_AUTO_TEST_CASE(cancelled_test)
+{
+    const auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    QueryDeadline deadline(QueryDeadline::Clock::time_point::max(), cancelled);
+    BOOST_CHECK(deadline.IsActive());
+    deadline.CheckNow();
+
+    cancelled->store(true);
+    BOOST_CHECK_EXCEPTION(deadline.CheckNow(), QueryCancelled, [](const QueryCancelled &e) {
+        return !e.TimedOut() && std::string(e.Code()) == "Cancelled";
+    });
+}
+
+BOOST_AUTO_TEST_CASE(scope_test)
+{
+    BOOST_CHECK(!GetQueryDeadline().IsActive());
+    {
+        QueryDeadlineScope scope(QueryDeadline(QueryDeadline::Clock::now(), nullptr));
+        BOOST_CHECK(GetQueryDeadline().IsActive());
+        BOOST_CHECK_THROW(GetQueryDeadline().CheckNow(), QueryCancelled);
+    }
+    BOOST_CHECK(!GetQueryDeadline().IsActive());
+}
+
+BOOST_AUTO_TEST_CASE(trip_stops_at_deadline_test)
+{
+    const std::size_t size = 12;
+    std::vector<EdgeWeight> weights(size * size, 1);
+    const util::DistTableWrapper<EdgeWeight> table(weights, size);
+    std::vector<NodeID> component(size);
+    for (std::size_t node = 0; node < size; ++node)
+    {
+        component[node] = node;
+    }
+
+    QueryDeadlineScope scope(QueryDeadline(QueryDeadline::Clock::now(), nullptr));
+    BOOST_CHECK_THROW(trip::HeldKarpTrip(component.begin(), component.end(), size, table),
+                      QueryCancelled);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
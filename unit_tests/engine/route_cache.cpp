@@ -0,0 +1,124 @@
+#include "engine/route_cache.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(route_cache)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+api::RouteParameters makeParameters()
+{
+    api::RouteParameters parameters;
+    parameters.coordinates = {{util::FloatLongitude{7.41}, util::FloatLatitude{43.73}},
+                              {util::FloatLongitude{7.42}, util::FloatLatitude{43.74}}};
+    return parameters;
+}
+
+util::json::Object makeResponse(const std::string &code)
+{
+    util::json::Object response;
+    response.values["code"] = code;
+    return response;
+}
+}
+
+BOOST_AUTO_TEST_CASE(key_test)
+{
+    const auto parameters = makeParameters();
+    BOOST_CHECK_EQUAL(RouteCache::MakeKey(parameters), RouteCache::MakeKey(makeParameters()));
+
+    auto with_steps = makeParameters();
+    with_steps.steps = true;
+    BOOST_CHECK_NE(RouteCache::MakeKey(parameters), RouteCache::MakeKey(with_steps));
+
+    auto with_radius = makeParameters();
+    with_radius.radiuses = {boost::none, 100.};
+    BOOST_CHECK_NE(RouteCache::MakeKey(parameters), RouteCache::MakeKey(with_radius));
+
+    // unset radiuses are the same as no radiuses
+    auto without_radius = makeParameters();
+    without_radius.radiuses = {boost::none, boost::none};
+    BOOST_CHECK_EQUAL(RouteCache::MakeKey(parameters), RouteCache::MakeKey(without_radius));
+
+    auto continue_straight = makeParameters();
+    continue_straight.continue_straight = false;
+    BOOST_CHECK_NE(RouteCache::MakeKey(parameters), RouteCache::MakeKey(continue_straight));
+
+    auto reversed = makeParameters();
+    std::swap(reversed.coordinates.front(), reversed.coordinates.back());
+    BOOST_CHECK_NE(RouteCache::MakeKey(parameters), RouteCache::MakeKey(reversed));
+
+    auto pbf = makeParameters();
+    pbf.output_format = api::OutputFormatType::PBF;
+    BOOST_CHECK_NE(RouteCache::MakeKey(parameters), RouteCache::MakeKey(pbf));
+
+    auto departure_time = makeParameters();
+    departure_time.departure_time = 1477000800;
+    BOOST_CHECK_NE(RouteCache::MakeKey(parameters), RouteCache::MakeKey(departure_time));
+
+    auto without_hints = makeParameters();
+    without_hints.generate_hints = false;
+    BOOST_CHECK_NE(RouteCache::MakeKey(parameters), RouteCache::MakeKey(without_hints));
+}
+
+BOOST_AUTO_TEST_CASE(insert_find_test)
+{
+    RouteCache cache(1024 * 1024);
+    const auto key = RouteCache::MakeKey(makeParameters());
+
+    util::json::Object result;
+    BOOST_CHECK(!cache.Find(key, result));
+
+    cache.Insert(key, makeResponse("Ok"));
+    BOOST_CHECK(cache.Find(key, result));
+    BOOST_CHECK_EQUAL(result.values["code"].get<util::json::String>().value, "Ok");
+    BOOST_CHECK_EQUAL(cache.GetNumberOfEntries(), 1);
+    BOOST_CHECK_GT(cache.GetMemoryUsage(), 0);
+
+    std::string pbf_result;
+    cache.Insert("pbf", std::string("response"));
+    BOOST_CHECK(cache.Find("pbf", pbf_result));
+    BOOST_CHECK_EQUAL(pbf_result, "response");
+}
+
+BOOST_AUTO_TEST_CASE(admission_test)
+{
+    RouteCache cache(64 * 1024);
+
+    // more than 1/64 of the budget
+    cache.Insert("large", std::string(2048, 'x'));
+    std::string result;
+    BOOST_CHECK(!cache.Find("large", result));
+    BOOST_CHECK_EQUAL(cache.GetNumberOfEntries(), 0);
+
+    cache.Insert("small", std::string(256, 'x'));
+    BOOST_CHECK(cache.Find("small", result));
+}
+
+BOOST_AUTO_TEST_CASE(memory_budget_test)
+{
+    const std::size_t memory_budget = 64 * 1024;
+    RouteCache cache(memory_budget);
+
+    std::string result;
+    for (int i = 0; i < 1000; ++i)
+    {
+        cache.Insert(std::to_string(i), std::string(512, 'x'));
+        BOOST_CHECK_LE(cache.GetMemoryUsage(), memory_budget);
+
+        // keeps the first response the most recently used one
+        BOOST_CHECK(cache.Find("0", result));
+    }
+    BOOST_CHECK_GT(cache.GetNumberOfEntries(), 1);
+    BOOST_CHECK_LT(cache.GetNumberOfEntries(), 1000);
+    BOOST_CHECK(!cache.Find("1", result));
+    BOOST_CHECK(cache.Find("999", result));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
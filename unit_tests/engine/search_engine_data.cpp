@@ -0,0 +1,95 @@
+#include "engine/search_engine_data.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(search_engine_data)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+BOOST_AUTO_TEST_CASE(lease_test)
+{
+    // the pool is process wide, other tests leave their sets in it
+    SearchEngineData::SetMaxHeapSets(0);
+    SearchEngineData::ClearIdleHeapSets();
+    BOOST_CHECK(SearchEngineData::GetHeapSet() == nullptr);
+
+    SearchEngineData::HeapSet *leased_set = nullptr;
+    {
+        SearchEngineData::Lease lease;
+        leased_set = SearchEngineData::GetHeapSet();
+        BOOST_REQUIRE(leased_set != nullptr);
+
+        SearchEngineData engine_working_data;
+        engine_working_data.InitializeOrClearFirstThreadLocalStorage(10);
+        BOOST_CHECK_EQUAL(engine_working_data.forward_heap_1->MaxID(), 10u);
+        engine_working_data.forward_heap_1->Insert(3, 1, {3});
+
+        // a nested lease, like the tasks of a query on its own thread, uses the same set
+        {
+            SearchEngineData::Lease task_lease(SearchEngineData::Lease::Task);
+            BOOST_CHECK_EQUAL(SearchEngineData::GetHeapSet(), leased_set);
+        }
+        BOOST_CHECK_EQUAL(SearchEngineData::GetHeapSet(), leased_set);
+
+        // a query that runs nested on the thread gets a set of its own
+        {
+            SearchEngineData::Lease query_lease;
+            BOOST_REQUIRE(SearchEngineData::GetHeapSet() != nullptr);
+            BOOST_CHECK(SearchEngineData::GetHeapSet() != leased_set);
+            engine_working_data.InitializeOrClearFirstThreadLocalStorage(10);
+            BOOST_CHECK(engine_working_data.forward_heap_1->Empty());
+        }
+        BOOST_CHECK_EQUAL(SearchEngineData::GetHeapSet(), leased_set);
+        BOOST_CHECK(engine_working_data.forward_heap_1->WasInserted(3));
+    }
+    BOOST_CHECK(SearchEngineData::GetHeapSet() == nullptr);
+    BOOST_CHECK_GE(SearchEngineData::GetNumberOfIdleHeapSets(), 1u);
+
+    // the next query takes the idle set, its heaps are cleared or replaced by larger ones
+    SearchEngineData::Lease lease;
+    BOOST_CHECK_EQUAL(SearchEngineData::GetHeapSet(), leased_set);
+    SearchEngineData engine_working_data;
+    engine_working_data.InitializeOrClearFirstThreadLocalStorage(5);
+    BOOST_CHECK(engine_working_data.forward_heap_1->Empty());
+    engine_working_data.InitializeOrClearFirstThreadLocalStorage(20);
+    BOOST_CHECK_EQUAL(engine_working_data.forward_heap_1->MaxID(), 20u);
+}
+
+BOOST_AUTO_TEST_CASE(bounded_pool_test)
+{
+    SearchEngineData::SetMaxHeapSets(1);
+
+    std::atomic<bool> query_started{false};
+    std::atomic<bool> task_started{false};
+    std::thread query_thread;
+    {
+        SearchEngineData::Lease lease;
+
+        // a second query waits for the set while tasks of a query never wait
+        query_thread = std::thread([&query_started] {
+            SearchEngineData::Lease query_lease;
+            query_started = true;
+        });
+        std::thread task_thread([&task_started] {
+            SearchEngineData::Lease task_lease(SearchEngineData::Lease::Task);
+            task_started = SearchEngineData::GetHeapSet() != nullptr;
+        });
+        task_thread.join();
+        BOOST_CHECK(task_started);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        BOOST_CHECK(!query_started);
+    }
+    query_thread.join();
+    BOOST_CHECK(query_started);
+    BOOST_CHECK_LE(SearchEngineData::GetNumberOfIdleHeapSets(), 1u);
+
+    SearchEngineData::SetMaxHeapSets(0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
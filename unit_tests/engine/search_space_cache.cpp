@@ -0,0 +1,64 @@
+#include "engine/search_space_cache.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+
+BOOST_AUTO_TEST_SUITE(search_space_cache)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+std::shared_ptr<const SearchSpace> makeSearchSpace(const NodeID node)
+{
+    return std::make_shared<SearchSpace>(SearchSpace{{node, 0, 0}, {node + 1, 10, 100}});
+}
+}
+
+BOOST_AUTO_TEST_CASE(insert_find_test)
+{
+    SearchSpaceCache cache(64);
+    const SearchSpaceCache::Key key{1, 2, 5, 7, INVALID_EDGE_DISTANCE, INVALID_EDGE_DISTANCE};
+    BOOST_CHECK(!cache.Find(key));
+
+    cache.Insert(key, makeSearchSpace(10));
+    const auto search_space = cache.Find(key);
+    BOOST_REQUIRE(search_space);
+    BOOST_REQUIRE_EQUAL(search_space->size(), 2);
+    BOOST_CHECK_EQUAL((*search_space)[1].node, 11);
+    BOOST_CHECK_EQUAL((*search_space)[1].weight, 10);
+
+    // the weights and distances of the start are part of the key
+    BOOST_CHECK(!cache.Find({1, 2, 5, 8, INVALID_EDGE_DISTANCE, INVALID_EDGE_DISTANCE}));
+    BOOST_CHECK(!cache.Find({1, SPECIAL_NODEID, 5, 0, INVALID_EDGE_DISTANCE, 0}));
+    BOOST_CHECK(!cache.Find({1, 2, 5, 7, 30, 40}));
+
+    cache.Insert({1, 2, 5, 7, 30, 40}, makeSearchSpace(20));
+    BOOST_CHECK_EQUAL((*cache.Find({1, 2, 5, 7, 30, 40}))[0].node, 20);
+    BOOST_CHECK_EQUAL((*cache.Find(key))[0].node, 10);
+    BOOST_CHECK_EQUAL(cache.GetNumberOfEntries(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(bounded_test)
+{
+    const std::size_t number_of_shards = SearchSpaceCache::NUMBER_OF_SHARDS;
+    SearchSpaceCache cache(number_of_shards);
+
+    for (NodeID node = 0; node < 1000; ++node)
+    {
+        const SearchSpaceCache::Key key{node, SPECIAL_NODEID, 0, 0, 0, 0};
+        cache.Insert(key, makeSearchSpace(node));
+
+        // the entry that was just inserted is never evicted right away
+        const auto search_space = cache.Find(key);
+        BOOST_REQUIRE(search_space);
+        BOOST_CHECK_EQUAL(search_space->front().node, node);
+    }
+    // every shard holds a single entry
+    BOOST_CHECK_LE(cache.GetNumberOfEntries(), number_of_shards);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,56 @@
+#include "engine/shortcut_cache.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(shortcut_cache)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+std::vector<ShortcutCache::OriginalEdge> makeOriginalEdges(const std::size_t number_of_edges)
+{
+    std::vector<ShortcutCache::OriginalEdge> edges;
+    for (NodeID node = 0; node < number_of_edges; ++node)
+    {
+        edges.push_back({node, node + 1, node + 100});
+    }
+    return edges;
+}
+}
+
+BOOST_AUTO_TEST_CASE(insert_find_test)
+{
+    ShortcutCache cache(8);
+    BOOST_CHECK(cache.Find(3) == nullptr);
+
+    cache.Insert(3, makeOriginalEdges(ShortcutCache::MIN_CACHED_EDGES));
+    const auto *entry = cache.Find(3);
+    BOOST_REQUIRE(entry != nullptr);
+    BOOST_CHECK_EQUAL(entry->shortcut, 3);
+    BOOST_REQUIRE(entry->original_edges.size() == ShortcutCache::MIN_CACHED_EDGES);
+    BOOST_CHECK_EQUAL(entry->original_edges.front().source, 0);
+    BOOST_CHECK_EQUAL(entry->original_edges.back().edge, ShortcutCache::MIN_CACHED_EDGES + 99);
+
+    // shortcuts in the same slot do not replace the cached one
+    cache.Insert(11, makeOriginalEdges(ShortcutCache::MIN_CACHED_EDGES));
+    BOOST_CHECK(cache.Find(11) == nullptr);
+    BOOST_CHECK(cache.Find(3) == entry);
+}
+
+BOOST_AUTO_TEST_CASE(bounds_test)
+{
+    ShortcutCache cache(8);
+    cache.Insert(1, makeOriginalEdges(ShortcutCache::MIN_CACHED_EDGES - 1));
+    BOOST_CHECK(cache.Find(1) == nullptr);
+    cache.Insert(2, makeOriginalEdges(ShortcutCache::MAX_CACHED_EDGES + 1));
+    BOOST_CHECK(cache.Find(2) == nullptr);
+    cache.Insert(2, makeOriginalEdges(ShortcutCache::MAX_CACHED_EDGES));
+    BOOST_CHECK(cache.Find(2) != nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,241 @@
+#include "engine/routing_algorithms/routing_base.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/integer_range.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(stall_on_demand)
+
+using namespace osrm;
+using namespace osrm::engine;
+using namespace osrm::engine::routing_algorithms;
+
+namespace
+{
+// The search graph of a contraction hierarchy: the edges are stored at their lower node
+struct HierarchyFacade
+{
+    struct EdgeData
+    {
+        NodeID target;
+        EdgeWeight weight;
+        bool forward;
+        bool backward;
+    };
+
+    util::range<EdgeID> GetForwardEdgeRange(const NodeID node) const
+    {
+        return util::irange(offsets[node], offsets[node + 1]);
+    }
+    util::range<EdgeID> GetBackwardEdgeRange(const NodeID node) const
+    {
+        return util::irange(offsets[node], offsets[node + 1]);
+    }
+    const EdgeData &GetHotEdgeData(const EdgeID edge) const { return edges[edge]; }
+
+    std::vector<EdgeID> offsets;
+    std::vector<EdgeData> edges;
+};
+
+class HierarchyRouting final : public BasicRoutingInterface<HierarchyFacade, HierarchyRouting>
+{
+};
+
+// arcs of a directed graph by their source, with the weight of the lightest arc to a target
+using Adjacency = std::vector<std::map<NodeID, EdgeWeight>>;
+
+Adjacency makeRandomGraph(std::mt19937 &generator, const NodeID number_of_nodes)
+{
+    Adjacency arcs(number_of_nodes);
+    std::uniform_int_distribution<NodeID> node_distribution(0, number_of_nodes - 1);
+    std::uniform_int_distribution<EdgeWeight> weight_distribution(1, 20);
+    for (const auto arc : util::irange<NodeID>(0, 3 * number_of_nodes))
+    {
+        (void)arc;
+        const auto source = node_distribution(generator);
+        const auto target = node_distribution(generator);
+        if (source == target)
+        {
+            continue;
+        }
+        const auto weight = weight_distribution(generator);
+        auto inserted = arcs[source].emplace(target, weight);
+        inserted.first->second = std::min(inserted.first->second, weight);
+    }
+    return arcs;
+}
+
+// Contracts the nodes in a random order. Every path over a contracted node gets a shortcut,
+// without witness searches, which is a valid if naive hierarchy.
+HierarchyFacade makeHierarchy(std::mt19937 &generator, const Adjacency &graph)
+{
+    const auto number_of_nodes = static_cast<NodeID>(graph.size());
+    std::vector<NodeID> order(number_of_nodes);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), generator);
+    std::vector<NodeID> rank(number_of_nodes);
+    for (const auto index : util::irange<NodeID>(0, number_of_nodes))
+    {
+        rank[order[index]] = index;
+    }
+
+    Adjacency outgoing = graph;
+    Adjacency incoming(number_of_nodes);
+    for (const auto source : util::irange<NodeID>(0, number_of_nodes))
+    {
+        for (const auto &arc : graph[source])
+        {
+            incoming[arc.first][source] = arc.second;
+        }
+    }
+    const auto addArc = [&](const NodeID source, const NodeID target, const EdgeWeight weight) {
+        auto inserted = outgoing[source].emplace(target, weight);
+        inserted.first->second = std::min(inserted.first->second, weight);
+        incoming[target][source] = inserted.first->second;
+    };
+    for (const auto node : order)
+    {
+        for (const auto &in : incoming[node])
+        {
+            for (const auto &out : outgoing[node])
+            {
+                if (rank[in.first] > rank[node] && rank[out.first] > rank[node] &&
+                    in.first != out.first)
+                {
+                    addArc(in.first, out.first, in.second + out.second);
+                }
+            }
+        }
+    }
+
+    std::vector<std::vector<HierarchyFacade::EdgeData>> edges(number_of_nodes);
+    for (const auto source : util::irange<NodeID>(0, number_of_nodes))
+    {
+        for (const auto &arc : outgoing[source])
+        {
+            if (rank[source] < rank[arc.first])
+            {
+                edges[source].push_back({arc.first, arc.second, true, false});
+            }
+            else
+            {
+                edges[arc.first].push_back({source, arc.second, false, true});
+            }
+        }
+    }
+
+    HierarchyFacade facade;
+    facade.offsets.push_back(0);
+    for (const auto &node_edges : edges)
+    {
+        facade.edges.insert(facade.edges.end(), node_edges.begin(), node_edges.end());
+        facade.offsets.push_back(facade.edges.size());
+    }
+    return facade;
+}
+
+EdgeWeight shortestPath(const Adjacency &graph, const NodeID source, const NodeID target)
+{
+    std::vector<EdgeWeight> weights(graph.size(), INVALID_EDGE_WEIGHT);
+    using Entry = std::pair<EdgeWeight, NodeID>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    weights[source] = 0;
+    queue.push({0, source});
+    while (!queue.empty())
+    {
+        const auto entry = queue.top();
+        queue.pop();
+        if (entry.first > weights[entry.second])
+        {
+            continue;
+        }
+        for (const auto &arc : graph[entry.second])
+        {
+            if (entry.first + arc.second < weights[arc.first])
+            {
+                weights[arc.first] = entry.first + arc.second;
+                queue.push({weights[arc.first], arc.first});
+            }
+        }
+    }
+    return weights[target];
+}
+
+// The bidirectional search of BasicRoutingInterface::Search, with or without stalling
+EdgeWeight hierarchyQuery(const HierarchyRouting &routing,
+                          const HierarchyFacade &facade,
+                          SearchEngineData::QueryHeap &forward_heap,
+                          SearchEngineData::QueryHeap &reverse_heap,
+                          const NodeID source,
+                          const NodeID target,
+                          const bool stalling)
+{
+    forward_heap.Clear();
+    reverse_heap.Clear();
+    forward_heap.Insert(source, 0, source);
+    reverse_heap.Insert(target, 0, target);
+
+    NodeID middle = SPECIAL_NODEID;
+    std::int32_t weight = INVALID_EDGE_WEIGHT;
+    while (0 < forward_heap.Size() + reverse_heap.Size())
+    {
+        if (!forward_heap.Empty())
+        {
+            routing.RoutingStep(
+                facade, forward_heap, reverse_heap, middle, weight, 0, true, stalling, false, false);
+        }
+        if (!reverse_heap.Empty())
+        {
+            routing.RoutingStep(
+                facade, reverse_heap, forward_heap, middle, weight, 0, false, stalling, false, false);
+        }
+    }
+    return middle == SPECIAL_NODEID ? INVALID_EDGE_WEIGHT : weight;
+}
+}
+
+BOOST_AUTO_TEST_CASE(random_graphs_test)
+{
+    const NodeID number_of_nodes = 200;
+    const HierarchyRouting routing;
+    SearchEngineData heaps;
+    SearchEngineData::Lease lease;
+    heaps.InitializeOrClearFirstThreadLocalStorage(number_of_nodes);
+    auto &forward_heap = *heaps.forward_heap_1;
+    auto &reverse_heap = *heaps.reverse_heap_1;
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<NodeID> node_distribution(0, number_of_nodes - 1);
+    for (const auto graph_index : util::irange(0, 10))
+    {
+        (void)graph_index;
+        const auto graph = makeRandomGraph(generator, number_of_nodes);
+        const auto facade = makeHierarchy(generator, graph);
+
+        for (const auto query : util::irange(0, 200))
+        {
+            (void)query;
+            const auto source = node_distribution(generator);
+            const auto target = node_distribution(generator);
+            const auto expected_weight = shortestPath(graph, source, target);
+
+            BOOST_CHECK_EQUAL(
+                hierarchyQuery(routing, facade, forward_heap, reverse_heap, source, target, false),
+                expected_weight);
+            BOOST_CHECK_EQUAL(
+                hierarchyQuery(routing, facade, forward_heap, reverse_heap, source, target, true),
+                expected_weight);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,112 @@
+#include "engine/target_set_cache.hpp"
+#include "mocks/mock_datafacade.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+
+BOOST_AUTO_TEST_SUITE(target_set_cache)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+TargetSetCache::Targets makeTargets(const double longitude)
+{
+    auto targets = std::make_shared<api::BaseParameters>();
+    targets->coordinates.emplace_back(util::FloatLongitude{longitude},
+                                      util::FloatLatitude{43.73});
+    return targets;
+}
+
+TargetSetCache::SnappedTargets makeSnappedTargets(const std::size_t number_of_targets)
+{
+    auto snapped_targets = std::make_shared<SnappedTargetSet>();
+    snapped_targets->buckets.number_of_targets = number_of_targets;
+    return snapped_targets;
+}
+}
+
+BOOST_AUTO_TEST_CASE(register_find_test)
+{
+    TargetSetCache cache(4);
+    const auto facade = std::make_shared<test::MockDataFacade>();
+    BOOST_CHECK(!cache.FindTargets("depots"));
+
+    const auto targets = makeTargets(7.41);
+    cache.Register("depots", targets);
+    BOOST_CHECK(cache.FindTargets("depots") == targets);
+    BOOST_CHECK(!cache.Find("depots", targets, *facade));
+
+    cache.Insert("depots", targets, facade, makeSnappedTargets(1));
+    const auto snapped_targets = cache.Find("depots", targets, *facade);
+    BOOST_REQUIRE(snapped_targets);
+    BOOST_CHECK_EQUAL(snapped_targets->buckets.number_of_targets, 1);
+
+    // the set is searched once per facade
+    const auto other_facade = std::make_shared<test::MockDataFacade>();
+    BOOST_CHECK(!cache.Find("depots", targets, *other_facade));
+    cache.Insert("depots", targets, other_facade, makeSnappedTargets(2));
+    BOOST_CHECK_EQUAL(cache.Find("depots", targets, *other_facade)->buckets.number_of_targets, 2);
+    BOOST_CHECK_EQUAL(cache.Find("depots", targets, *facade)->buckets.number_of_targets, 1);
+}
+
+BOOST_AUTO_TEST_CASE(replace_test)
+{
+    TargetSetCache cache(4);
+    const auto facade = std::make_shared<test::MockDataFacade>();
+    const auto targets = makeTargets(7.41);
+    cache.Register("depots", targets);
+    cache.Insert("depots", targets, facade, makeSnappedTargets(1));
+
+    // registering the name again drops the searched set
+    const auto new_targets = makeTargets(7.42);
+    cache.Register("depots", new_targets);
+    BOOST_CHECK(cache.FindTargets("depots") == new_targets);
+    BOOST_CHECK(!cache.Find("depots", targets, *facade));
+    BOOST_CHECK(!cache.Find("depots", new_targets, *facade));
+
+    // a search of the replaced set is not kept
+    cache.Insert("depots", targets, facade, makeSnappedTargets(1));
+    BOOST_CHECK(!cache.Find("depots", new_targets, *facade));
+    BOOST_CHECK_EQUAL(cache.GetNumberOfSets(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(dropped_facade_test)
+{
+    TargetSetCache cache(4);
+    const auto targets = makeTargets(7.41);
+    cache.Register("depots", targets);
+
+    auto facade = std::make_shared<test::MockDataFacade>();
+    const std::weak_ptr<test::MockDataFacade> dropped_facade = facade;
+    cache.Insert("depots", targets, facade, makeSnappedTargets(1));
+    facade.reset();
+    BOOST_CHECK(dropped_facade.expired());
+
+    // the set of the dropped facade is not found again and removed by the next search
+    const auto new_facade = std::make_shared<test::MockDataFacade>();
+    BOOST_CHECK(!cache.Find("depots", targets, *new_facade));
+    cache.Insert("depots", targets, new_facade, makeSnappedTargets(2));
+    BOOST_CHECK_EQUAL(cache.Find("depots", targets, *new_facade)->buckets.number_of_targets, 2);
+    BOOST_CHECK(cache.FindTargets("depots") == targets);
+}
+
+BOOST_AUTO_TEST_CASE(bounded_test)
+{
+    TargetSetCache cache(2);
+    cache.Register("a", makeTargets(7.41));
+    cache.Register("b", makeTargets(7.42));
+    // a is used more recently than b
+    BOOST_CHECK(cache.FindTargets("a"));
+    cache.Register("c", makeTargets(7.43));
+
+    BOOST_CHECK_EQUAL(cache.GetNumberOfSets(), 2);
+    BOOST_CHECK(cache.FindTargets("a"));
+    BOOST_CHECK(!cache.FindTargets("b"));
+    BOOST_CHECK(cache.FindTargets("c"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,53 @@
+#include "engine/tile_cache.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(tile_cache)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+BOOST_AUTO_TEST_CASE(insert_find_test)
+{
+    TileCache cache(4);
+    std::string buffer;
+    BOOST_CHECK(!cache.Find(14, 8800, 5370, buffer));
+
+    cache.Insert(14, 8800, 5370, "tile");
+    BOOST_CHECK(cache.Find(14, 8800, 5370, buffer));
+    BOOST_CHECK_EQUAL(buffer, "tile");
+
+    // the coordinates are not mixed up
+    BOOST_CHECK(!cache.Find(14, 5370, 8800, buffer));
+    BOOST_CHECK(!cache.Find(15, 8800, 5370, buffer));
+
+    // a tile rendered twice keeps the first version
+    cache.Insert(14, 8800, 5370, "other tile");
+    BOOST_CHECK(cache.Find(14, 8800, 5370, buffer));
+    BOOST_CHECK_EQUAL(buffer, "tile");
+    BOOST_CHECK_EQUAL(cache.GetNumberOfTiles(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(eviction_test)
+{
+    TileCache cache(2);
+    std::string buffer;
+
+    cache.Insert(12, 1, 1, "a");
+    cache.Insert(12, 1, 2, "b");
+    // a becomes more recently used than b
+    BOOST_CHECK(cache.Find(12, 1, 1, buffer));
+
+    cache.Insert(12, 1, 3, "c");
+    BOOST_CHECK_EQUAL(cache.GetNumberOfTiles(), 2);
+    BOOST_CHECK(!cache.Find(12, 1, 2, buffer));
+    BOOST_CHECK(cache.Find(12, 1, 1, buffer));
+    BOOST_CHECK_EQUAL(buffer, "a");
+    BOOST_CHECK(cache.Find(12, 1, 3, buffer));
+    BOOST_CHECK_EQUAL(buffer, "c");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
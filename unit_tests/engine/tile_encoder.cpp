@@ -0,0 +1,124 @@
+#include "engine/tile_encoder.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(tile_encoder)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+std::vector<std::vector<tile::Point>> clip(const std::vector<tile::Point> &line)
+{
+    tile::ClippedLines lines;
+    tile::clipLine(line.data(), line.data() + line.size(), lines);
+
+    std::vector<std::vector<tile::Point>> parts;
+    for (const auto part : util::irange<std::size_t>(0, lines.GetNumberOfLines()))
+    {
+        parts.emplace_back(lines.Begin(part), lines.End(part));
+    }
+    return parts;
+}
+
+void checkLine(const std::vector<tile::Point> &actual, const std::vector<tile::Point> &expected)
+{
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (const auto index : util::irange<std::size_t>(0, actual.size()))
+    {
+        BOOST_CHECK_EQUAL(actual[index].x, expected[index].x);
+        BOOST_CHECK_EQUAL(actual[index].y, expected[index].y);
+    }
+}
+}
+
+BOOST_AUTO_TEST_CASE(value_table_offsets)
+{
+    tile::ValueTable<int> values;
+    BOOST_CHECK_EQUAL(values.Use(7), 0);
+    BOOST_CHECK_EQUAL(values.Use(-3), 1);
+    BOOST_CHECK_EQUAL(values.Use(7), 0);
+    BOOST_CHECK_EQUAL(values.Size(), 2);
+
+    // the offsets stay the same when the table grows
+    for (int value = 100; value < 1100; ++value)
+    {
+        BOOST_CHECK_EQUAL(values.Use(value), value - 98);
+    }
+    BOOST_CHECK_EQUAL(values.Use(-3), 1);
+    BOOST_CHECK_EQUAL(values.Use(1099), 1001);
+    BOOST_CHECK_EQUAL(values.Size(), 1002);
+    BOOST_CHECK_EQUAL(values.Values()[1], -3);
+}
+
+BOOST_AUTO_TEST_CASE(value_table_floats)
+{
+    tile::ValueTable<float> values;
+    values.Reserve(4);
+    BOOST_CHECK_EQUAL(values.Use(0.f), 0);
+    BOOST_CHECK_EQUAL(values.Use(-0.f), 0);
+    BOOST_CHECK_EQUAL(values.Use(1.5f), 1);
+    BOOST_CHECK_EQUAL(values.Size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(value_table_strings)
+{
+    tile::ValueTable<std::string> values;
+    const std::string name = "Avenue de la Costa";
+    BOOST_CHECK_EQUAL(values.Use(util::StringView(name)), 0);
+    BOOST_CHECK_EQUAL(values.Use(std::string("")), 1);
+    BOOST_CHECK_EQUAL(values.Use(name), 0);
+    BOOST_CHECK_EQUAL(values.Use(util::StringView(name.data(), 6)), 2);
+    BOOST_REQUIRE_EQUAL(values.Size(), 3);
+    BOOST_CHECK_EQUAL(values.Values()[0], name);
+    BOOST_CHECK_EQUAL(values.Values()[2], "Avenue");
+}
+
+BOOST_AUTO_TEST_CASE(clip_segment)
+{
+    double t0, t1;
+    BOOST_CHECK(tile::clipSegment(0, 0, 100, 100, t0, t1));
+    BOOST_CHECK_EQUAL(t0, 0.);
+    BOOST_CHECK_EQUAL(t1, 1.);
+
+    // crosses the whole tile with its buffer of 128 pixels
+    BOOST_CHECK(tile::clipSegment(-1128, 0, 5224, 0, t0, t1));
+    BOOST_CHECK_CLOSE(t0, 1000. / 6352., 1e-9);
+    BOOST_CHECK_CLOSE(t1, 5352. / 6352., 1e-9);
+
+    BOOST_CHECK(!tile::clipSegment(-500, -500, 5000, -200, t0, t1));
+    BOOST_CHECK(!tile::clipSegment(-400, 4000, 0, 4800, t0, t1));
+    BOOST_CHECK(!tile::clipSegment(5000, 5000, 5000, 5000, t0, t1));
+}
+
+BOOST_AUTO_TEST_CASE(clip_line)
+{
+    // inside, the repeated point is dropped
+    auto parts = clip({{0, 0}, {100, 0}, {100, 0}, {100, 100}});
+    BOOST_REQUIRE_EQUAL(parts.size(), 1);
+    checkLine(parts[0], {{0, 0}, {100, 0}, {100, 100}});
+
+    // leaves the tile and enters it again
+    parts = clip({{0, 0}, {0, 5000}, {100, 5000}, {100, 0}});
+    BOOST_REQUIRE_EQUAL(parts.size(), 2);
+    checkLine(parts[0], {{0, 0}, {0, 4224}});
+    checkLine(parts[1], {{100, 4224}, {100, 0}});
+
+    // crosses the tile
+    parts = clip({{-1000, 2000}, {5000, 2000}});
+    BOOST_REQUIRE_EQUAL(parts.size(), 1);
+    checkLine(parts[0], {{-128, 2000}, {4224, 2000}});
+
+    // outside or a single point inside
+    BOOST_CHECK(clip({{-1000, -1000}, {5000, -1000}}).empty());
+    BOOST_CHECK(clip({{10, 10}, {10, 10}}).empty());
+    BOOST_CHECK(clip({{10, 10}}).empty());
+    BOOST_CHECK(clip({}).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
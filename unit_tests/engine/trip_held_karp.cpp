@@ -0,0 +1,109 @@
+#include "engine/trip/trip_brute_force.hpp"
+#include "engine/trip/trip_held_karp.hpp"
+#include "util/dist_table_wrapper.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(trip_held_karp)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+EdgeWeight tripWeight(const util::DistTableWrapper<EdgeWeight> &table,
+                      const std::vector<NodeID> &route)
+{
+    EdgeWeight weight = 0;
+    for (std::size_t i = 0; i < route.size(); ++i)
+    {
+        weight += table(route[i], route[(i + 1) % route.size()]);
+    }
+    return weight;
+}
+}
+
+BOOST_AUTO_TEST_CASE(one_way_ring_test)
+{
+    // going around the ring 0 -> 2 -> 1 -> 3 is cheap, everything else is expensive
+    const util::DistTableWrapper<EdgeWeight> table({0, 50, 1, 50, //
+                                                    50, 0, 50, 1, //
+                                                    50, 1, 0, 50, //
+                                                    1, 50, 50, 0},
+                                                   4);
+    const std::vector<NodeID> component = {0, 1, 2, 3};
+
+    const std::vector<NodeID> expected_route = {0, 2, 1, 3};
+
+    const auto route = trip::HeldKarpTrip(component.begin(), component.end(), 4, table);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        route.begin(), route.end(), expected_route.begin(), expected_route.end());
+}
+
+BOOST_AUTO_TEST_CASE(brute_force_comparison_test)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<EdgeWeight> weights(1, 1000);
+
+    for (std::size_t size = 1; size <= 8; ++size)
+    {
+        for (int round = 0; round < 20; ++round)
+        {
+            // the component is a subset of the table in arbitrary order
+            const std::size_t number_of_locations = size + 2;
+            std::vector<EdgeWeight> values(number_of_locations * number_of_locations);
+            for (auto &value : values)
+            {
+                value = weights(generator);
+            }
+            const util::DistTableWrapper<EdgeWeight> table(std::move(values), number_of_locations);
+
+            std::vector<NodeID> component(number_of_locations);
+            std::iota(component.begin(), component.end(), 0);
+            std::shuffle(component.begin(), component.end(), generator);
+            component.resize(size);
+
+            auto sorted_component = component;
+            std::sort(sorted_component.begin(), sorted_component.end());
+
+            const auto route = trip::HeldKarpTrip(
+                component.begin(), component.end(), number_of_locations, table);
+            const auto expected_route = trip::BruteForceTrip(
+                sorted_component.begin(), sorted_component.end(), number_of_locations, table);
+
+            BOOST_REQUIRE_EQUAL(route.size(), size);
+            BOOST_CHECK_EQUAL(route.front(), component.front());
+            auto sorted_route = route;
+            std::sort(sorted_route.begin(), sorted_route.end());
+            BOOST_CHECK(sorted_route == sorted_component);
+            BOOST_CHECK_EQUAL(tripWeight(table, route), tripWeight(table, expected_route));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(max_locations_test)
+{
+    // all legs weigh 10 except for the ones along the ring of increasing ids
+    const std::size_t size = trip::HELD_KARP_MAX_LOCATIONS;
+    std::vector<EdgeWeight> values(size * size, 10);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        values[i * size + i] = 0;
+        values[i * size + (i + 1) % size] = 1;
+    }
+    const util::DistTableWrapper<EdgeWeight> table(std::move(values), size);
+
+    std::vector<NodeID> component(size);
+    std::iota(component.begin(), component.end(), 0);
+
+    const auto route = trip::HeldKarpTrip(component.begin(), component.end(), size, table);
+    BOOST_CHECK_EQUAL_COLLECTIONS(route.begin(), route.end(), component.begin(), component.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+#include "engine/trip/trip_farthest_insertion.hpp"
+#include "engine/trip/trip_local_search.hpp"
+#include "util/dist_table_wrapper.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(trip_local_search)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+EdgeWeight tripWeight(const util::DistTableWrapper<EdgeWeight> &table,
+                      const std::vector<NodeID> &route)
+{
+    EdgeWeight weight = 0;
+    for (std::size_t i = 0; i < route.size(); ++i)
+    {
+        weight += table(route[i], route[(i + 1) % route.size()]);
+    }
+    return weight;
+}
+
+// locations on a plane, going east takes a bit longer than going west
+util::DistTableWrapper<EdgeWeight> makeTable(const std::size_t number_of_locations,
+                                             std::mt19937 &generator)
+{
+    std::uniform_real_distribution<double> coordinates(0, 1000);
+    std::vector<std::pair<double, double>> locations(number_of_locations);
+    for (auto &location : locations)
+    {
+        location = {coordinates(generator), coordinates(generator)};
+    }
+
+    std::vector<EdgeWeight> values;
+    for (const auto &from : locations)
+    {
+        for (const auto &to : locations)
+        {
+            const auto distance =
+                std::hypot(to.first - from.first, to.second - from.second) +
+                std::max(0., to.first - from.first) * 0.2;
+            values.push_back(static_cast<EdgeWeight>(distance));
+        }
+    }
+    return util::DistTableWrapper<EdgeWeight>(std::move(values), number_of_locations);
+}
+
+const auto far_deadline = std::chrono::steady_clock::now() + std::chrono::hours(1);
+}
+
+BOOST_AUTO_TEST_CASE(crossing_test)
+{
+    // the corners of a square and two points on its sides, the trip crosses the square twice
+    // and its shortest version goes around the square
+    const std::vector<std::pair<int, int>> corners = {
+        {0, 0}, {0, 10}, {10, 10}, {10, 0}, {5, 0}, {0, 5}};
+    std::vector<EdgeWeight> values;
+    for (const auto &from : corners)
+    {
+        for (const auto &to : corners)
+        {
+            values.push_back(std::abs(to.first - from.first) + std::abs(to.second - from.second));
+        }
+    }
+    const util::DistTableWrapper<EdgeWeight> table(std::move(values), corners.size());
+
+    std::vector<NodeID> route = {0, 2, 5, 1, 3, 4};
+    trip::ImproveTrip(route, table, far_deadline);
+
+    BOOST_CHECK_EQUAL(route.front(), 0);
+    BOOST_CHECK_EQUAL(tripWeight(table, route), 40);
+}
+
+BOOST_AUTO_TEST_CASE(farthest_insertion_test)
+{
+    std::mt19937 generator(1);
+    for (const std::size_t size : {5, 8, 20, 50, 100})
+    {
+        const auto table = makeTable(size, generator);
+        std::vector<NodeID> component(size);
+        std::iota(component.begin(), component.end(), 0);
+
+        auto route = trip::FarthestInsertionTrip(component.begin(), component.end(), size, table);
+        const auto initial_route = route;
+        trip::ImproveTrip(route, table, far_deadline);
+
+        BOOST_CHECK_EQUAL(route.front(), initial_route.front());
+        BOOST_CHECK_LE(tripWeight(table, route), tripWeight(table, initial_route));
+        auto sorted_route = route;
+        std::sort(sorted_route.begin(), sorted_route.end());
+        BOOST_CHECK(sorted_route == component);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(deadline_test)
+{
+    std::mt19937 generator(2);
+    const auto table = makeTable(50, generator);
+    std::vector<NodeID> component(50);
+    std::iota(component.begin(), component.end(), 0);
+
+    auto route = trip::FarthestInsertionTrip(component.begin(), component.end(), 50, table);
+    const auto initial_route = route;
+    trip::ImproveTrip(route, table, std::chrono::steady_clock::now());
+
+    BOOST_CHECK(route == initial_route);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,30 @@
+#include "extractor/class_data.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(class_data)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+BOOST_AUTO_TEST_CASE(class_names_test)
+{
+    BOOST_CHECK_EQUAL(getClass("toll"), 1);
+    BOOST_CHECK_EQUAL(getClass("ferry"), 4);
+    BOOST_CHECK_EQUAL(getClass("tolls"), 0);
+
+    const std::vector<std::string> toll_ferry = {"toll", "ferry"};
+    const std::vector<std::string> ferry_toll = {"ferry", "toll"};
+    const std::vector<std::string> unknown = {"ferry", "highway"};
+    BOOST_CHECK_EQUAL(getClasses(toll_ferry), 5);
+    BOOST_CHECK_EQUAL(getClasses(unknown), 0);
+
+    // the metric name does not depend on the order of the classes
+    BOOST_CHECK_EQUAL(getExcludeMetricName(getClasses(toll_ferry)), "exclude-toll-ferry");
+    BOOST_CHECK_EQUAL(getExcludeMetricName(getClasses(ferry_toll)), "exclude-toll-ferry");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,9 +1,15 @@
 #include "extractor/compressed_edge_container.hpp"
+#include "util/coordinate_calculation.hpp"
 #include "util/typedefs.hpp"
 
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
 #include <boost/test/test_case_template.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <cstdint>
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(compressed_edge_container)
 
 using namespace osrm;
@@ -87,4 +93,86 @@ BOOST_AUTO_TEST_CASE(t_crossing)
     BOOST_CHECK_EQUAL(container.GetLastEdgeSourceID(2), 3);
 }
 
+BOOST_AUTO_TEST_CASE(renumbered_zip_test)
+{
+    // 0---1---2 with the forward edge 0 and the reverse edge 2
+    CompressedEdgeContainer container;
+    container.CompressEdge(0, 1, 1, 2, 1, 2);
+    container.CompressEdge(2, 3, 1, 0, 2, 1);
+
+    container.RenumberEdges({3, SPECIAL_EDGEID, 0, SPECIAL_EDGEID});
+    BOOST_CHECK(container.HasEntryForID(0));
+    BOOST_CHECK(!container.HasEntryForID(1));
+    BOOST_CHECK(!container.HasEntryForID(2));
+    BOOST_CHECK(container.HasEntryForID(3));
+    BOOST_CHECK(!container.HasEntryForID(4));
+    BOOST_CHECK_EQUAL(container.GetFirstEdgeTargetID(3), 1);
+    BOOST_CHECK_EQUAL(container.GetLastEdgeTargetID(3), 2);
+    BOOST_CHECK_EQUAL(container.GetLastEdgeTargetID(0), 0);
+    BOOST_CHECK(!container.IsTrivial(0));
+
+    container.InitializeBothwayVector();
+    BOOST_CHECK_EQUAL(container.ZipEdges(3, 0), 0);
+    BOOST_CHECK(container.HasZippedEntryForForwardID(3));
+    BOOST_CHECK(!container.HasZippedEntryForForwardID(0));
+    BOOST_CHECK(container.HasZippedEntryForReverseID(0));
+    BOOST_CHECK(!container.HasZippedEntryForReverseID(3));
+    BOOST_CHECK_EQUAL(container.GetZippedPositionForForwardID(3), 0);
+    BOOST_CHECK_EQUAL(container.GetZippedPositionForReverseID(0), 0);
+
+    const auto path = boost::filesystem::temp_directory_path() / "osrm_renumbered_zip_test";
+    container.SerializeInternalVector(path.string());
+
+    boost::filesystem::ifstream geometry_stream(path, std::ios::binary);
+    const auto read = [&geometry_stream](const std::size_t count) {
+        std::vector<unsigned> values(count);
+        geometry_stream.read(reinterpret_cast<char *>(values.data()),
+                             sizeof(unsigned) * values.size());
+        return values;
+    };
+    // index size, index with sentinel, number of nodes, nodes, forward and reverse weights
+    const auto values = read(1 + 2 + 1 + 3 + 3 + 3);
+    geometry_stream.close();
+    boost::filesystem::remove(path);
+
+    const auto INVALID = static_cast<unsigned>(INVALID_EDGE_WEIGHT);
+    const std::vector<unsigned> expected = {2, 0, 3, 3, 0, 1, 2, INVALID, 1, 2, 1, 2, INVALID};
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(segment_lengths_test)
+{
+    // 0---1----------------2
+    CompressedEdgeContainer container;
+    container.CompressEdge(0, 1, 1, 2, 1, 1);
+    container.CompressEdge(2, 3, 1, 0, 1, 1);
+    container.InitializeBothwayVector();
+    BOOST_CHECK_EQUAL(container.ZipEdges(0, 2), 0);
+
+    const std::vector<QueryNode> nodes = {
+        QueryNode{util::FixedLongitude{0}, util::FixedLatitude{0}, OSMNodeID{0}},
+        QueryNode{util::FixedLongitude{1000}, util::FixedLatitude{0}, OSMNodeID{1}},
+        QueryNode{util::FixedLongitude{1000000}, util::FixedLatitude{0}, OSMNodeID{2}}};
+
+    const auto path = boost::filesystem::temp_directory_path() / "osrm_segment_lengths_test";
+    container.SerializeSegmentLengths(path.string(), nodes);
+
+    boost::filesystem::ifstream lengths_stream(path, std::ios::binary);
+    std::uint64_t number_of_lengths = 0;
+    lengths_stream.read(reinterpret_cast<char *>(&number_of_lengths), sizeof(number_of_lengths));
+    BOOST_REQUIRE_EQUAL(number_of_lengths, 3);
+    std::vector<SegmentLength> lengths(number_of_lengths);
+    lengths_stream.read(reinterpret_cast<char *>(lengths.data()),
+                        sizeof(SegmentLength) * lengths.size());
+    lengths_stream.close();
+    boost::filesystem::remove(path);
+
+    // the first node has no segment and the second segment is too long for a SegmentLength
+    const auto first_length = util::coordinate_calculation::haversineDistance(
+        util::Coordinate{nodes[0].lon, nodes[0].lat}, util::Coordinate{nodes[1].lon, nodes[1].lat});
+    BOOST_CHECK(lengths[0] == INVALID_SEGMENT_LENGTH);
+    BOOST_CHECK_EQUAL(lengths[1], std::round(10 * first_length));
+    BOOST_CHECK(lengths[2] == INVALID_SEGMENT_LENGTH);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -7,7 +7,10 @@
 #include <boost/test/test_case_template.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 BOOST_AUTO_TEST_SUITE(graph_compressor)
 
@@ -543,4 +546,137 @@ BOOST_AUTO_TEST_CASE(direction_changes)
     BOOST_CHECK(graph.FindEdge(1, 2) != SPECIAL_EDGEID);
 }
 
+BOOST_AUTO_TEST_CASE(parallel_chains_test)
+{
+    //
+    //     1---2
+    //    /     \
+    //   0       4
+    //    \     /
+    //     --3--
+    //
+    GraphCompressor compressor;
+
+    std::unordered_set<NodeID> barrier_nodes = {0, 4};
+    std::unordered_set<NodeID> traffic_lights;
+    RestrictionMap map;
+    CompressedEdgeContainer container;
+
+    std::vector<InputEdge> edges;
+    const std::vector<std::pair<NodeID, NodeID>> segments = {
+        {0, 1}, {1, 2}, {2, 4}, {0, 3}, {3, 4}};
+    for (const auto &segment : segments)
+    {
+        for (const auto &direction : {segment, std::make_pair(segment.second, segment.first)})
+        {
+            edges.push_back({direction.first,
+                             direction.second,
+                             1,
+                             SPECIAL_EDGEID,
+                             0,
+                             false,
+                             false,
+                             false,
+                             true,
+                             TRAVEL_MODE_DRIVING,
+                             INVALID_LANE_DESCRIPTIONID});
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    Graph graph(5, edges);
+    compressor.Compress(barrier_nodes, traffic_lights, map, graph, container);
+
+    // the chain over 1 and 2 is compressed into 0---4, the one over 3 can't be compressed anymore
+    BOOST_CHECK_EQUAL(graph.GetOutDegree(1), 0);
+    BOOST_CHECK_EQUAL(graph.GetOutDegree(2), 0);
+    BOOST_CHECK_EQUAL(graph.GetOutDegree(3), 2);
+    const auto edge = graph.FindEdge(0, 4);
+    BOOST_REQUIRE(edge != SPECIAL_EDGEID);
+    BOOST_CHECK_EQUAL(graph.GetEdgeData(edge).distance, 3);
+    BOOST_CHECK(graph.FindEdge(4, 0) != SPECIAL_EDGEID);
+    BOOST_CHECK(graph.FindEdge(0, 3) != SPECIAL_EDGEID);
+    BOOST_CHECK(graph.FindEdge(3, 4) != SPECIAL_EDGEID);
+
+    const auto &geometry = container.GetBucketReference(edge);
+    BOOST_REQUIRE_EQUAL(geometry.size(), 3);
+    BOOST_CHECK_EQUAL(geometry[0].node_id, 1);
+    BOOST_CHECK_EQUAL(geometry[1].node_id, 2);
+    BOOST_CHECK_EQUAL(geometry[2].node_id, 4);
+}
+
+BOOST_AUTO_TEST_CASE(static_graph_test)
+{
+    //
+    // 0---1---2---3
+    //         |
+    //         4
+    //
+    GraphCompressor compressor;
+
+    std::unordered_set<NodeID> barrier_nodes;
+    std::unordered_set<NodeID> traffic_lights;
+    RestrictionMap map;
+    CompressedEdgeContainer container;
+
+    const auto make_edge = [](const NodeID source, const NodeID target) {
+        return InputEdge(source,
+                         target,
+                         1,
+                         SPECIAL_EDGEID,
+                         0,
+                         false,
+                         false,
+                         false,
+                         true,
+                         TRAVEL_MODE_INACCESSIBLE,
+                         INVALID_LANE_DESCRIPTIONID);
+    };
+    std::vector<InputEdge> edges = {make_edge(0, 1),
+                                    make_edge(1, 0),
+                                    make_edge(1, 2),
+                                    make_edge(2, 1),
+                                    make_edge(2, 3),
+                                    make_edge(2, 4),
+                                    make_edge(3, 2),
+                                    make_edge(4, 2)};
+
+    Graph graph(5, edges);
+    compressor.Compress(barrier_nodes, traffic_lights, map, graph, container);
+
+    std::vector<EdgeID> new_edge_ids;
+    const auto static_graph = util::NodeBasedStaticGraphFromDynamic(graph, new_edge_ids);
+    container.RenumberEdges(new_edge_ids);
+
+    BOOST_CHECK_EQUAL(static_graph->GetNumberOfNodes(), 5);
+    BOOST_CHECK_EQUAL(static_graph->GetNumberOfEdges(), graph.GetNumberOfEdges());
+    BOOST_CHECK_EQUAL(static_graph->GetNumberOfEdges(), 6);
+    BOOST_CHECK_EQUAL(static_graph->GetOutDegree(1), 0);
+    BOOST_CHECK_EQUAL(static_graph->GetOutDegree(2), 3);
+
+    for (const auto node : util::irange(0u, graph.GetNumberOfNodes()))
+    {
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            const auto static_edge = new_edge_ids[edge];
+            BOOST_REQUIRE(static_edge != SPECIAL_EDGEID);
+            BOOST_CHECK(static_edge >= static_graph->BeginEdges(node));
+            BOOST_CHECK(static_edge < static_graph->EndEdges(node));
+            BOOST_CHECK_EQUAL(static_graph->GetTarget(static_edge), graph.GetTarget(edge));
+            BOOST_CHECK_EQUAL(static_graph->GetEdgeData(static_edge).distance,
+                              graph.GetEdgeData(edge).distance);
+            BOOST_CHECK(container.HasEntryForID(static_edge));
+        }
+    }
+
+    // the geometries move to the edges of the static graph
+    const auto edge = static_graph->FindEdge(0, 2);
+    BOOST_REQUIRE(edge != SPECIAL_EDGEID);
+    BOOST_CHECK_EQUAL(static_graph->GetEdgeData(edge).distance, 2);
+    const auto &geometry = container.GetBucketReference(edge);
+    BOOST_REQUIRE_EQUAL(geometry.size(), 2);
+    BOOST_CHECK_EQUAL(geometry[0].node_id, 1);
+    BOOST_CHECK_EQUAL(geometry[1].node_id, 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+#include "extractor/osm_change_set.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(osm_change_set)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+namespace
+{
+boost::filesystem::path writeChangeFile(const std::string &name, const std::string &changes)
+{
+    const auto path = boost::filesystem::temp_directory_path() / name;
+    boost::filesystem::ofstream out(path);
+    out << "<?xml version='1.0' encoding='UTF-8'?>\n<osmChange version=\"0.6\">\n"
+        << changes << "</osmChange>\n";
+    return path;
+}
+
+const osmium::OSMObject &makeObject(const osmium::item_type type, const osmium::object_id_type id)
+{
+    static osmium::memory::Buffer buffer(1024, osmium::memory::Buffer::auto_grow::yes);
+    const auto offset = type == osmium::item_type::node
+                            ? osmium::builder::add_node(buffer, osmium::builder::attr::_id(id))
+                            : osmium::builder::add_way(buffer, osmium::builder::attr::_id(id));
+    return buffer.get<osmium::OSMObject>(offset);
+}
+}
+
+BOOST_AUTO_TEST_CASE(latest_versions_test)
+{
+    const auto first = writeChangeFile(
+        "osrm_change_set_test_1.osc",
+        "<create><node id=\"1\" version=\"1\" timestamp=\"2016-10-01T10:00:00Z\" lat=\"1\" "
+        "lon=\"1\"/></create>\n"
+        "<modify><node id=\"2\" version=\"4\" timestamp=\"2016-10-01T10:00:00Z\" lat=\"2\" "
+        "lon=\"2\"/></modify>\n"
+        "<modify><way id=\"2\" version=\"3\" timestamp=\"2016-10-01T10:00:00Z\">"
+        "<nd ref=\"1\"/><nd ref=\"2\"/></way></modify>\n");
+    const auto second = writeChangeFile(
+        "osrm_change_set_test_2.osc",
+        "<delete><node id=\"1\" version=\"2\" timestamp=\"2016-10-01T10:01:00Z\" lat=\"1\" "
+        "lon=\"1\"/></delete>\n"
+        "<modify><node id=\"2\" version=\"5\" timestamp=\"2016-10-01T10:02:00Z\" lat=\"3\" "
+        "lon=\"3\"/></modify>\n");
+
+    OSMChangeSet change_set({first, second});
+    boost::filesystem::remove(first);
+    boost::filesystem::remove(second);
+
+    BOOST_CHECK_EQUAL(change_set.GetNumberOfChanged(), 3);
+    BOOST_CHECK_EQUAL(change_set.GetNumberOfDeleted(), 1);
+    BOOST_CHECK_EQUAL(change_set.GetLatestTimestamp().to_iso(), "2016-10-01T10:02:00Z");
+
+    BOOST_CHECK(change_set.IsChanged(makeObject(osmium::item_type::node, 1)));
+    BOOST_CHECK(change_set.IsChanged(makeObject(osmium::item_type::node, 2)));
+    BOOST_CHECK(!change_set.IsChanged(makeObject(osmium::item_type::node, 3)));
+    BOOST_CHECK(change_set.IsChanged(makeObject(osmium::item_type::way, 2)));
+    BOOST_CHECK(!change_set.IsChanged(makeObject(osmium::item_type::way, 1)));
+
+    // the deleted node is dropped, the modified node has its latest version
+    const auto visible_objects = change_set.MoveOutVisibleObjects();
+    std::vector<const osmium::OSMObject *> objects;
+    for (const auto &object : visible_objects.select<osmium::OSMObject>())
+    {
+        objects.push_back(&object);
+    }
+    BOOST_REQUIRE_EQUAL(objects.size(), 2);
+    BOOST_CHECK(objects[0]->type() == osmium::item_type::node);
+    BOOST_CHECK_EQUAL(objects[0]->id(), 2);
+    BOOST_CHECK_EQUAL(objects[0]->version(), 5);
+    BOOST_CHECK(objects[1]->type() == osmium::item_type::way);
+    BOOST_CHECK_EQUAL(objects[1]->id(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
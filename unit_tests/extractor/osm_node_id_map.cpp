@@ -0,0 +1,68 @@
+#include "extractor/osm_node_id_map.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(osm_node_id_map)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+BOOST_AUTO_TEST_CASE(empty_map_test)
+{
+    OSMNodeIDMap map;
+    map.BuildIndex();
+    BOOST_CHECK_EQUAL(map.Size(), 0);
+    BOOST_CHECK_EQUAL(map.Find(OSMNodeID{0}), SPECIAL_NODEID);
+    BOOST_CHECK_EQUAL(map.Find(OSMNodeID{42}), SPECIAL_NODEID);
+}
+
+BOOST_AUTO_TEST_CASE(sparse_ids_test)
+{
+    const std::vector<std::uint64_t> osm_ids = {
+        3, 4, 5, 17, 1000, 1001, 123456789, 4000000000, 4000000001, 5000000000000};
+
+    OSMNodeIDMap map;
+    map.Reserve(osm_ids.size());
+    for (const auto osm_id : osm_ids)
+    {
+        map.PushBack(OSMNodeID{osm_id});
+    }
+    map.BuildIndex();
+
+    BOOST_CHECK_EQUAL(map.Size(), osm_ids.size());
+    for (NodeID internal_id = 0; internal_id < osm_ids.size(); ++internal_id)
+    {
+        BOOST_CHECK_EQUAL(map.Find(OSMNodeID{osm_ids[internal_id]}), internal_id);
+    }
+
+    BOOST_CHECK_EQUAL(map.Find(OSMNodeID{0}), SPECIAL_NODEID);
+    BOOST_CHECK_EQUAL(map.Find(OSMNodeID{6}), SPECIAL_NODEID);
+    BOOST_CHECK_EQUAL(map.Find(OSMNodeID{999}), SPECIAL_NODEID);
+    BOOST_CHECK_EQUAL(map.Find(OSMNodeID{4000000002}), SPECIAL_NODEID);
+    BOOST_CHECK_EQUAL(map.Find(OSMNodeID{5000000000001}), SPECIAL_NODEID);
+    BOOST_CHECK_EQUAL(map.Find(SPECIAL_OSM_NODEID), SPECIAL_NODEID);
+}
+
+BOOST_AUTO_TEST_CASE(dense_ids_test)
+{
+    OSMNodeIDMap map;
+    for (std::uint64_t osm_id = 100; osm_id < 10100; osm_id += 2)
+    {
+        map.PushBack(OSMNodeID{osm_id});
+    }
+    map.BuildIndex();
+
+    BOOST_CHECK_EQUAL(map.Size(), 5000);
+    for (std::uint64_t osm_id = 100; osm_id < 10100; ++osm_id)
+    {
+        const NodeID expected = osm_id % 2 == 0 ? (osm_id - 100) / 2 : SPECIAL_NODEID;
+        BOOST_CHECK_EQUAL(map.Find(OSMNodeID{osm_id}), expected);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
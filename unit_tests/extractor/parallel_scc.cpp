@@ -0,0 +1,95 @@
+#include "extractor/parallel_scc.hpp"
+#include "extractor/tarjan_scc.hpp"
+#include "util/static_graph.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(parallel_scc)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+struct EdgeData
+{
+};
+using Graph = util::StaticGraph<EdgeData>;
+using InputEdge = Graph::InputEdge;
+
+// Both searches have to partition the nodes the same way, the component ids may differ
+void checkSameComponents(const NodeID number_of_nodes, std::vector<InputEdge> edges)
+{
+    std::sort(edges.begin(), edges.end());
+    const auto graph = std::make_shared<const Graph>(number_of_nodes, edges);
+
+    TarjanSCC<Graph> tarjan(graph);
+    tarjan.Run();
+    ParallelSCC<Graph> parallel(graph);
+    parallel.Run();
+
+    BOOST_REQUIRE_EQUAL(parallel.GetNumberOfComponents(), tarjan.GetNumberOfComponents());
+    BOOST_CHECK_EQUAL(parallel.GetSizeOneCount(), tarjan.GetSizeOneCount());
+
+    std::vector<unsigned> tarjan_to_parallel(tarjan.GetNumberOfComponents(), SPECIAL_NODEID);
+    for (NodeID node = 0; node < number_of_nodes; ++node)
+    {
+        const auto tarjan_id = tarjan.GetComponentID(node);
+        const auto parallel_id = parallel.GetComponentID(node);
+        if (tarjan_to_parallel[tarjan_id] == SPECIAL_NODEID)
+        {
+            tarjan_to_parallel[tarjan_id] = parallel_id;
+            BOOST_CHECK_EQUAL(parallel.GetComponentSize(parallel_id),
+                              tarjan.GetComponentSize(tarjan_id));
+        }
+        BOOST_REQUIRE_EQUAL(tarjan_to_parallel[tarjan_id], parallel_id);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(small_graph_test)
+{
+    //  0 <-> 1 -> 2 <-> 3
+    //        ^    |
+    //        |    v
+    //        5 <- 4    6
+    std::vector<InputEdge> edges = {
+        {0, 1}, {1, 0}, {1, 2}, {2, 3}, {3, 2}, {2, 4}, {4, 5}, {5, 1}};
+    checkSameComponents(7, edges);
+
+    std::sort(edges.begin(), edges.end());
+    const auto graph = std::make_shared<const Graph>(7, edges);
+    ParallelSCC<Graph> scc(graph);
+    scc.Run();
+    BOOST_CHECK_EQUAL(scc.GetNumberOfComponents(), 2);
+    BOOST_CHECK_EQUAL(scc.GetSizeOneCount(), 1);
+    BOOST_CHECK_EQUAL(scc.GetComponentSize(scc.GetComponentID(0)), 6);
+    BOOST_CHECK_EQUAL(scc.GetComponentSize(scc.GetComponentID(6)), 1);
+}
+
+BOOST_AUTO_TEST_CASE(random_graph_test)
+{
+    std::mt19937 generator(42);
+    for (const NodeID number_of_nodes : {10u, 1000u, 200000u})
+    {
+        std::uniform_int_distribution<NodeID> node_distribution(0, number_of_nodes - 1);
+        std::vector<InputEdge> edges;
+        for (NodeID node = 0; node < number_of_nodes; ++node)
+        {
+            // mostly local edges, so there are large weak and many small strong components
+            const NodeID neighbour = std::min(number_of_nodes - 1, node + 1);
+            edges.emplace_back(node, neighbour);
+            if (generator() % 3 == 0)
+                edges.emplace_back(neighbour, node);
+            if (generator() % 16 == 0)
+                edges.emplace_back(node, node_distribution(generator));
+        }
+        checkSameComponents(number_of_nodes, edges);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -79,4 +79,48 @@ BOOST_AUTO_TEST_CASE(raster_test)
         util::exception);
 }
 
+BOOST_AUTO_TEST_CASE(tiled_raster_test)
+{
+    const auto tiled_path =
+        boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    // tiles of 4 by 4 values pad the 10 by 10 grid at the edges
+    WriteTiledRaster("../unit_tests/fixtures/raster_data.asc", tiled_path, 10, 10, 4);
+    BOOST_CHECK(RasterGrid::IsTiledRaster(tiled_path));
+    BOOST_CHECK(!RasterGrid::IsTiledRaster("../unit_tests/fixtures/raster_data.asc"));
+
+    SourceContainer sources;
+    BOOST_CHECK_EQUAL(sources.LoadRasterSource(
+                          "../unit_tests/fixtures/raster_data.asc", 1, 1.09, 1, 1.09, 10, 10),
+                      0);
+    BOOST_CHECK_EQUAL(sources.LoadRasterSource(tiled_path.string(), 1, 1.09, 1, 1.09, 10, 10), 1);
+
+    // the tiled raster has the values of the grid
+    for (double lon = 0.995; lon < 1.1; lon += 0.003)
+    {
+        for (double lat = 0.995; lat < 1.1; lat += 0.003)
+        {
+            BOOST_CHECK_EQUAL(sources.GetRasterDataFromSource(0, lon, lat).datum,
+                              sources.GetRasterDataFromSource(1, lon, lat).datum);
+            BOOST_CHECK_EQUAL(sources.GetRasterInterpolateFromSource(0, lon, lat).datum,
+                              sources.GetRasterInterpolateFromSource(1, lon, lat).datum);
+        }
+    }
+
+    SourceContainer other_sources;
+    BOOST_CHECK_THROW(
+        other_sources.LoadRasterSource(tiled_path.string(), 1, 1.09, 1, 1.09, 10, 11),
+        util::exception);
+    BOOST_CHECK_THROW(WriteTiledRaster("../unit_tests/fixtures/raster_data.asc",
+                                       tiled_path,
+                                       10,
+                                       11,
+                                       4),
+                      util::exception);
+    BOOST_CHECK_THROW(
+        WriteTiledRaster("../unit_tests/fixtures/raster_data.asc", tiled_path, 10, 10, 3),
+        util::exception);
+
+    boost::filesystem::remove(tiled_path);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,80 @@
+#include "extractor/restriction_map.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(restriction_map)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+namespace
+{
+TurnRestriction
+makeRestriction(const NodeID from, const NodeID via, const NodeID to, const bool is_only)
+{
+    TurnRestriction restriction(is_only);
+    restriction.from.node = from;
+    restriction.via.node = via;
+    restriction.to.node = to;
+    return restriction;
+}
+
+void checkLookups(const RestrictionMap &map)
+{
+    BOOST_CHECK_EQUAL(map.size(), 4);
+
+    BOOST_CHECK(map.IsViaNode(1));
+    BOOST_CHECK(map.IsViaNode(5));
+    BOOST_CHECK(map.IsViaNode(12));
+    BOOST_CHECK(!map.IsViaNode(0));
+    BOOST_CHECK(!map.IsViaNode(7));
+    BOOST_CHECK(!map.IsViaNode(100));
+
+    // no turns
+    BOOST_CHECK(map.CheckIfTurnIsRestricted(0, 1, 2));
+    BOOST_CHECK(map.CheckIfTurnIsRestricted(0, 1, 3));
+    BOOST_CHECK(!map.CheckIfTurnIsRestricted(0, 1, 4));
+    BOOST_CHECK(map.CheckIfTurnIsRestricted(9, 12, 11));
+    BOOST_CHECK(!map.CheckIfTurnIsRestricted(11, 12, 9));
+    BOOST_CHECK_EQUAL(map.CheckForEmanatingIsOnlyTurn(0, 1), SPECIAL_NODEID);
+
+    // the only turn replaced the no turn before it and is not a restricted turn itself
+    BOOST_CHECK_EQUAL(map.CheckForEmanatingIsOnlyTurn(4, 5), 6);
+    BOOST_CHECK(!map.CheckIfTurnIsRestricted(4, 5, 6));
+    BOOST_CHECK(!map.CheckIfTurnIsRestricted(4, 5, 3));
+
+    BOOST_CHECK_EQUAL(map.CheckForEmanatingIsOnlyTurn(3, 5), SPECIAL_NODEID);
+    BOOST_CHECK_EQUAL(map.CheckForEmanatingIsOnlyTurn(5, 4), SPECIAL_NODEID);
+    BOOST_CHECK(!map.CheckIfTurnIsRestricted(2, 1, 0));
+}
+}
+
+BOOST_AUTO_TEST_CASE(frozen_lookups_test)
+{
+    const std::vector<TurnRestriction> restrictions = {makeRestriction(0, 1, 2, false),
+                                                       makeRestriction(4, 5, 3, false),
+                                                       makeRestriction(0, 1, 3, false),
+                                                       makeRestriction(4, 5, 6, true),
+                                                       makeRestriction(4, 5, 7, false),
+                                                       makeRestriction(9, 12, 11, false)};
+
+    RestrictionMap map(restrictions);
+    checkLookups(map);
+
+    map.Freeze();
+    checkLookups(map);
+}
+
+BOOST_AUTO_TEST_CASE(empty_test)
+{
+    RestrictionMap map;
+    map.Freeze();
+    BOOST_CHECK_EQUAL(map.size(), 0);
+    BOOST_CHECK(!map.IsViaNode(0));
+    BOOST_CHECK(!map.CheckIfTurnIsRestricted(0, 1, 2));
+    BOOST_CHECK_EQUAL(map.CheckForEmanatingIsOnlyTurn(0, 1), SPECIAL_NODEID);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
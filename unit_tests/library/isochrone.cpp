@@ -0,0 +1,73 @@
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "args.hpp"
+#include "coordinates.hpp"
+#include "fixture.hpp"
+
+#include "osrm/isochrone_parameters.hpp"
+
+#include "osrm/coordinate.hpp"
+#include "osrm/engine_config.hpp"
+#include "osrm/json_container.hpp"
+#include "osrm/osrm.hpp"
+#include "osrm/status.hpp"
+
+BOOST_AUTO_TEST_SUITE(isochrone)
+
+BOOST_AUTO_TEST_CASE(test_isochrone_response)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    IsochroneParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.duration = 60;
+
+    json::Object result;
+    const auto rc = osrm.Isochrone(params, result);
+    BOOST_REQUIRE(rc == Status::Ok);
+
+    const auto code = result.values.at("code").get<json::String>().value;
+    BOOST_CHECK_EQUAL(code, "Ok");
+
+    const auto &waypoints = result.values.at("waypoints").get<json::Array>().values;
+    BOOST_CHECK_EQUAL(waypoints.size(), 1);
+
+    const auto &segments = result.values.at("segments").get<json::Object>();
+    const auto type = segments.values.at("type").get<json::String>().value;
+    BOOST_CHECK_EQUAL(type, "MultiLineString");
+
+    // at least the segment of the waypoint is reachable
+    const auto &lines = segments.values.at("coordinates").get<json::Array>().values;
+    BOOST_CHECK(!lines.empty());
+    for (const auto &line : lines)
+    {
+        BOOST_CHECK_EQUAL(line.get<json::Array>().values.size(), 2);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_isochrone_response_longer_duration)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    IsochroneParameters params;
+    params.coordinates.push_back(get_dummy_location());
+
+    const auto number_of_segments = [&](const unsigned duration) {
+        params.duration = duration;
+        json::Object result;
+        BOOST_REQUIRE(osrm.Isochrone(params, result) == Status::Ok);
+        const auto &segments = result.values.at("segments").get<json::Object>();
+        return segments.values.at("coordinates").get<json::Array>().values.size();
+    };
+
+    BOOST_CHECK_LE(number_of_segments(10), number_of_segments(300));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
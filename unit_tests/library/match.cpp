@@ -11,6 +11,7 @@
 #include "osrm/coordinate.hpp"
 #include "osrm/engine_config.hpp"
 #include "osrm/json_container.hpp"
+#include "osrm/match_session.hpp"
 #include "osrm/osrm.hpp"
 #include "osrm/status.hpp"
 
@@ -68,4 +69,103 @@ BOOST_AUTO_TEST_CASE(test_match)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_match_beam_width)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    EngineConfig config;
+    config.storage_config = {args[0]};
+    config.use_shared_memory = false;
+    config.matching_beam_width = 1;
+
+    OSRM osrm{config};
+
+    MatchParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+
+    json::Object result;
+
+    const auto rc = osrm.Match(params, result);
+
+    BOOST_CHECK(rc == Status::Ok);
+    const auto code = result.values.at("code").get<json::String>().value;
+    BOOST_CHECK_EQUAL(code, "Ok");
+
+    const auto &tracepoints = result.values.at("tracepoints").get<json::Array>().values;
+    BOOST_CHECK_EQUAL(tracepoints.size(), params.coordinates.size());
+}
+
+BOOST_AUTO_TEST_CASE(test_match_session)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    const auto locations = get_locations_in_big_component();
+    MatchSession session;
+    std::size_t number_of_tracepoints = 0;
+    for (const auto &location : locations)
+    {
+        MatchParameters params;
+        params.coordinates.push_back(location);
+
+        json::Object result;
+        const auto rc = osrm.Match(session, params, result);
+        BOOST_CHECK(rc == Status::Ok);
+        BOOST_CHECK_EQUAL(result.values.at("code").get<json::String>().value, "Ok");
+        number_of_tracepoints += result.values.at("tracepoints").get<json::Array>().values.size();
+        BOOST_CHECK_EQUAL(number_of_tracepoints, session.NumberOfTracepoints());
+    }
+    BOOST_CHECK_EQUAL(session.NumberOfCoordinates(), locations.size());
+
+    // finishing without new coordinates responds with the remaining tracepoints
+    json::Object result;
+    const auto rc = osrm.FinishMatch(session, MatchParameters{}, result);
+    BOOST_CHECK(rc == Status::Ok);
+    number_of_tracepoints += result.values.at("tracepoints").get<json::Array>().values.size();
+    BOOST_CHECK_EQUAL(number_of_tracepoints, locations.size());
+
+    // a finished session starts a new trace
+    BOOST_CHECK_EQUAL(session.NumberOfCoordinates(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_match_session_timestamps)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    MatchSession session;
+    MatchParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.timestamps.push_back(10);
+
+    json::Object result;
+    BOOST_CHECK(osrm.Match(session, params, result) == Status::Ok);
+
+    // timestamps of later coordinates can not be earlier
+    params.timestamps.front() = 5;
+    json::Object earlier_result;
+    BOOST_CHECK(osrm.Match(session, params, earlier_result) == Status::Error);
+    BOOST_CHECK_EQUAL(earlier_result.values.at("code").get<json::String>().value,
+                      "InvalidValue");
+
+    // all coordinates of a session have timestamps or none
+    params.timestamps.clear();
+    json::Object missing_result;
+    BOOST_CHECK(osrm.Match(session, params, missing_result) == Status::Error);
+    BOOST_CHECK_EQUAL(session.NumberOfCoordinates(), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -43,6 +43,32 @@ BOOST_AUTO_TEST_CASE(test_nearest_response)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_nearest_response_no_hints)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    NearestParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.generate_hints = false;
+
+    json::Object result;
+    const auto rc = osrm.Nearest(params, result);
+    BOOST_REQUIRE(rc == Status::Ok);
+
+    const auto &waypoints = result.values.at("waypoints").get<json::Array>().values;
+    BOOST_CHECK(!waypoints.empty());
+
+    for (const auto &waypoint : waypoints)
+    {
+        const auto &waypoint_object = waypoint.get<json::Object>();
+        BOOST_CHECK(waypoint_object.values.count("hint") == 0);
+        BOOST_CHECK(waypoint_object.values.count("location") == 1);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(test_nearest_response_no_coordinates)
 {
     const auto args = get_args();
@@ -13,6 +13,14 @@
 #include "osrm/osrm.hpp"
 #include "osrm/route_parameters.hpp"
 #include "osrm/status.hpp"
+#include "util/integer_range.hpp"
+
+#include <protozero/pbf_reader.hpp>
+
+#include <future>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 BOOST_AUTO_TEST_SUITE(route)
 
@@ -361,4 +369,239 @@ BOOST_AUTO_TEST_CASE(test_route_response_for_locations_across_components)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_route_pbf)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    RouteParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+
+    std::string result;
+    const auto rc = osrm.Route(params, result);
+    BOOST_CHECK(rc == Status::Ok);
+
+    std::string code;
+    std::size_t number_of_waypoints = 0;
+    std::size_t number_of_routes = 0;
+    std::size_t number_of_legs = 0;
+    protozero::pbf_reader response{result};
+    while (response.next())
+    {
+        switch (response.tag())
+        {
+        case 1:
+            code = response.get_string();
+            break;
+        case 3:
+            ++number_of_waypoints;
+            response.skip();
+            break;
+        case 4:
+        {
+            ++number_of_routes;
+            auto route = response.get_message();
+            while (route.next(4))
+            {
+                ++number_of_legs;
+                route.skip();
+            }
+            break;
+        }
+        default:
+            response.skip();
+        }
+    }
+
+    BOOST_CHECK_EQUAL(code, "Ok");
+    BOOST_CHECK_EQUAL(number_of_waypoints, params.coordinates.size());
+    BOOST_CHECK_EQUAL(number_of_routes, 1);
+    BOOST_CHECK_EQUAL(number_of_legs, params.coordinates.size() - 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_route_annotations_subset)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    RouteParameters params;
+    params.annotations = true;
+    params.annotations_type =
+        RouteParameters::AnnotationsType::Duration | RouteParameters::AnnotationsType::Nodes;
+    for (const auto &location : get_locations_in_big_component())
+    {
+        params.coordinates.push_back(location);
+    }
+
+    json::Object result;
+    const auto rc = osrm.Route(params, result);
+    BOOST_CHECK(rc == Status::Ok);
+
+    const auto &routes = result.values.at("routes").get<json::Array>().values;
+    const auto &legs = routes.at(0).get<json::Object>().values.at("legs").get<json::Array>().values;
+    for (const auto &leg : legs)
+    {
+        const auto &annotation =
+            leg.get<json::Object>().values.at("annotation").get<json::Object>().values;
+        BOOST_CHECK_EQUAL(annotation.size(), 2);
+        const auto &durations = annotation.at("duration").get<json::Array>().values;
+        const auto &nodes = annotation.at("nodes").get<json::Array>().values;
+        BOOST_CHECK(!durations.empty());
+        BOOST_CHECK_EQUAL(nodes.size(), durations.size() + 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_route_batch)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    const auto big_component = get_locations_in_big_component();
+    const auto small_component = get_locations_in_small_component();
+
+    std::vector<RouteParameters> batch(3);
+    batch[0].coordinates = {big_component.at(0), big_component.at(2)};
+    batch[1].coordinates = {small_component.at(0), small_component.at(1)};
+    // fails with an invalid coordinate
+    batch[2].coordinates = {big_component.at(1), Location{Longitude{190}, Latitude{0}}};
+
+    std::vector<json::Object> results(batch.size());
+    std::vector<Status> statuses(batch.size(), Status::Error);
+    std::vector<unsigned> number_of_calls(batch.size(), 0);
+    std::mutex results_mutex;
+    osrm.Route(batch, [&](const std::size_t index, const Status status, json::Object &result) {
+        std::lock_guard<std::mutex> lock(results_mutex);
+        number_of_calls.at(index)++;
+        statuses[index] = status;
+        results[index] = std::move(result);
+    });
+
+    for (const auto index : {0, 1, 2})
+    {
+        BOOST_CHECK_EQUAL(number_of_calls[index], 1);
+
+        // the same result as a single query
+        json::Object reference;
+        const auto rc = osrm.Route(batch[index], reference);
+        BOOST_CHECK(statuses[index] == rc);
+        CHECK_EQUAL_JSON(reference, results[index]);
+    }
+    BOOST_CHECK(statuses[0] == Status::Ok);
+    BOOST_CHECK(statuses[2] == Status::Error);
+}
+
+BOOST_AUTO_TEST_CASE(test_route_batch_parallel_search)
+{
+    const auto args = get_args();
+
+    using namespace osrm;
+
+    // The threads of the batch that wait for the other half of a parallel core search must not
+    // run other routes of the batch on the heaps of their own one meanwhile.
+    EngineConfig config;
+    config.storage_config = {args.at(0)};
+    config.use_shared_memory = false;
+    config.parallel_search_distance = 500;
+    BOOST_REQUIRE(config.IsValid());
+    OSRM osrm{config};
+    auto reference_osrm = getOSRM(args.at(0));
+
+    auto locations = get_locations_in_big_component();
+    locations.push_back(get_dummy_location());
+    locations.push_back({Longitude{7.426700}, Latitude{43.731500}});
+    locations.push_back({Longitude{7.412600}, Latitude{43.729900}});
+    std::vector<RouteParameters> batch;
+    for (const auto &source : locations)
+    {
+        for (const auto &target : locations)
+        {
+            if (source != target)
+            {
+                batch.emplace_back();
+                batch.back().coordinates = {source, target};
+            }
+        }
+    }
+
+    std::vector<json::Object> results(batch.size());
+    std::vector<Status> statuses(batch.size(), Status::Error);
+    std::mutex results_mutex;
+    osrm.Route(batch, [&](const std::size_t index, const Status status, json::Object &result) {
+        std::lock_guard<std::mutex> lock(results_mutex);
+        statuses[index] = status;
+        results[index] = std::move(result);
+    });
+
+    for (const auto index : util::irange<std::size_t>(0UL, batch.size()))
+    {
+        json::Object reference;
+        const auto rc = reference_osrm.Route(batch[index], reference);
+        BOOST_CHECK(statuses[index] == rc);
+        CHECK_EQUAL_JSON(reference, results[index]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_route_profiles)
+{
+    const auto args = get_args();
+
+    using namespace osrm;
+
+    EngineConfig config;
+    config.storage_config = {args.at(0)};
+    config.use_shared_memory = false;
+    config.profiles["foot"] = {args.at(0)};
+    BOOST_REQUIRE(config.IsValid());
+    OSRM osrm{config};
+
+    RouteParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+
+    json::Object reference;
+    BOOST_CHECK(osrm.Route(params, reference) == Status::Ok);
+
+    // the profile with a dataset of its own and one that uses the default dataset
+    for (const auto profile : {"foot", "driving"})
+    {
+        params.profile = profile;
+        json::Object result;
+        BOOST_CHECK(osrm.Route(params, result) == Status::Ok);
+        CHECK_EQUAL_JSON(reference, result);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_route_async)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    RouteParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+
+    json::Object reference;
+    const auto reference_status = osrm.Route(params, reference);
+
+    std::promise<std::pair<Status, json::Object>> promise;
+    auto future = promise.get_future();
+    osrm.Route(params, [&promise](const Status status, json::Object &result) {
+        promise.set_value(std::make_pair(status, std::move(result)));
+    });
+
+    const auto response = future.get();
+    BOOST_CHECK(response.first == reference_status);
+    CHECK_EQUAL_JSON(reference, response.second);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
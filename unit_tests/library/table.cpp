@@ -11,9 +11,13 @@
 #include "osrm/coordinate.hpp"
 #include "osrm/engine_config.hpp"
 #include "osrm/json_container.hpp"
+#include "util/integer_range.hpp"
+#include "util/json_writer.hpp"
 #include "osrm/osrm.hpp"
 #include "osrm/status.hpp"
 
+#include <protozero/pbf_reader.hpp>
+
 BOOST_AUTO_TEST_SUITE(table)
 
 BOOST_AUTO_TEST_CASE(test_table_three_coords_one_source_one_dest_matrix)
@@ -161,4 +165,238 @@ BOOST_AUTO_TEST_CASE(test_table_three_coordinates_matrix)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_table_three_coordinates_distances)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    TableParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.annotations = TableParameters::AnnotationsType::Distance;
+
+    json::Object result;
+
+    const auto rc = osrm.Table(params, result);
+
+    BOOST_CHECK(rc == Status::Ok);
+    const auto code = result.values.at("code").get<json::String>().value;
+    BOOST_CHECK_EQUAL(code, "Ok");
+    BOOST_CHECK(result.values.find("durations") == result.values.end());
+
+    // all coordinates are the same, so are the distances
+    const auto &distances_array = result.values.at("distances").get<json::Array>().values;
+    BOOST_CHECK_EQUAL(distances_array.size(), params.coordinates.size());
+    for (const auto &row : distances_array)
+    {
+        const auto &distances_matrix = row.get<json::Array>().values;
+        BOOST_CHECK_EQUAL(distances_matrix.size(), params.coordinates.size());
+        for (const auto &distance : distances_matrix)
+        {
+            BOOST_CHECK_EQUAL(distance.get<json::Number>().value, 0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_table_approximate)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    // enough sources on a grid over the city for the approximation to kick in
+    TableParameters params;
+    for (const auto x : util::irange(0, 10))
+    {
+        for (const auto y : util::irange(0, 10))
+        {
+            params.coordinates.push_back(
+                {Longitude{7.414 + 0.0015 * x}, Latitude{43.730 + 0.0015 * y}});
+        }
+    }
+
+    json::Object exact_result;
+    BOOST_REQUIRE(osrm.Table(params, exact_result) == Status::Ok);
+    params.approximate = true;
+    json::Object approximate_result;
+    BOOST_REQUIRE(osrm.Table(params, approximate_result) == Status::Ok);
+
+    const auto &exact_rows = exact_result.values.at("durations").get<json::Array>().values;
+    const auto &approximate_rows =
+        approximate_result.values.at("durations").get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(exact_rows.size(), params.coordinates.size());
+    BOOST_REQUIRE_EQUAL(approximate_rows.size(), params.coordinates.size());
+    for (const auto row : util::irange<std::size_t>(0UL, params.coordinates.size()))
+    {
+        const auto &exact_row = exact_rows[row].get<json::Array>().values;
+        const auto &approximate_row = approximate_rows[row].get<json::Array>().values;
+        BOOST_REQUIRE_EQUAL(approximate_row.size(), exact_row.size());
+        for (const auto column : util::irange<std::size_t>(0UL, exact_row.size()))
+        {
+            // unreachable targets stay so
+            BOOST_REQUIRE_EQUAL(approximate_row[column].is<json::Null>(),
+                                exact_row[column].is<json::Null>());
+            if (exact_row[column].is<json::Null>())
+            {
+                continue;
+            }
+            const auto exact = exact_row[column].get<json::Number>().value;
+            const auto approximate = approximate_row[column].get<json::Number>().value;
+            // the durations are rounded to tenth of seconds
+            BOOST_CHECK_GE(approximate, exact - 0.01);
+            BOOST_CHECK_LE(approximate,
+                           exact * (1 + TableParameters::APPROXIMATE_MAX_ERROR) + 0.01);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_table_streamed)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    TableParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.sources.push_back(0);
+    params.destinations.push_back(1);
+    params.destinations.push_back(2);
+
+    json::Writer result;
+
+    const auto rc = osrm.Table(params, result);
+
+    BOOST_CHECK(rc == Status::Ok);
+    const auto &buffer = result.GetBuffer();
+    const std::string response(buffer.begin(), buffer.end());
+    BOOST_CHECK_EQUAL(response.find("{\"code\":\"Ok\""), 0);
+    BOOST_CHECK(response.find("\"durations\":[[") != std::string::npos);
+    BOOST_CHECK(response.find("\"sources\":[{") != std::string::npos);
+    BOOST_CHECK(response.find("\"destinations\":[{") != std::string::npos);
+    BOOST_CHECK_EQUAL(response.back(), '}');
+}
+
+BOOST_AUTO_TEST_CASE(test_table_pbf)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    TableParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.sources.push_back(0);
+    params.destinations.push_back(1);
+    params.destinations.push_back(2);
+
+    std::string result;
+
+    const auto rc = osrm.Table(params, result);
+
+    BOOST_CHECK(rc == Status::Ok);
+
+    std::string code;
+    std::size_t number_of_sources = 0;
+    std::size_t number_of_destinations = 0;
+    std::size_t number_of_durations = 0;
+    std::uint32_t number_of_columns = 0;
+    protozero::pbf_reader response{result};
+    while (response.next())
+    {
+        switch (response.tag())
+        {
+        case 1:
+            code = response.get_string();
+            break;
+        case 5:
+            ++number_of_sources;
+            response.skip();
+            break;
+        case 6:
+            ++number_of_destinations;
+            response.skip();
+            break;
+        case 7:
+        {
+            const auto durations = response.get_packed_sint32();
+            number_of_durations = std::distance(durations.begin(), durations.end());
+            break;
+        }
+        case 8:
+            number_of_columns = response.get_uint32();
+            break;
+        default:
+            response.skip();
+        }
+    }
+
+    BOOST_CHECK_EQUAL(code, "Ok");
+    BOOST_CHECK_EQUAL(number_of_sources, 1);
+    BOOST_CHECK_EQUAL(number_of_destinations, 2);
+    BOOST_CHECK_EQUAL(number_of_columns, 2);
+    BOOST_CHECK_EQUAL(number_of_durations, 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_table_binary)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    TableParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.sources.push_back(0);
+    params.destinations.push_back(1);
+    params.destinations.push_back(2);
+    params.output_format = engine::api::OutputFormatType::Binary;
+    params.binary_values = TableParameters::BinaryValuesType::Int32;
+    params.annotations = TableParameters::AnnotationsType::All;
+
+    std::string result;
+
+    const auto rc = osrm.Table(params, result);
+
+    BOOST_CHECK(rc == Status::Ok);
+
+    const auto word = [&result](const std::size_t index) {
+        const auto bytes = reinterpret_cast<const unsigned char *>(result.data()) + 4 * index;
+        return std::uint32_t{bytes[0]} | std::uint32_t{bytes[1]} << 8 |
+               std::uint32_t{bytes[2]} << 16 | std::uint32_t{bytes[3]} << 24;
+    };
+
+    // header, a duration and a distance matrix of one row and two columns
+    BOOST_REQUIRE_EQUAL(result.size(), 4 * (6 + 2 * 2));
+    BOOST_CHECK_EQUAL(result.substr(0, 4), "OSRM");
+    BOOST_CHECK_EQUAL(word(1), 1);
+    BOOST_CHECK_EQUAL(word(2), 1);
+    BOOST_CHECK_EQUAL(word(3), 1);
+    BOOST_CHECK_EQUAL(word(4), 2);
+    BOOST_CHECK_EQUAL(word(5), 3);
+    // the dummy locations snap to the same place
+    BOOST_CHECK_EQUAL(word(6), 0);
+    BOOST_CHECK_EQUAL(word(7), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -520,4 +520,53 @@ BOOST_AUTO_TEST_CASE(test_tile_speeds)
     BOOST_CHECK(actual_names == expected_names);
 }
 
+BOOST_AUTO_TEST_CASE(test_overview_tile)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    // This tile of the overview levels contains all of monaco
+    TileParameters params{1066, 746, 11};
+
+    std::string result;
+    const auto rc = osrm.Tile(params, result);
+    BOOST_CHECK(rc == Status::Ok);
+
+    protozero::pbf_reader tile_message(result);
+    tile_message.next();
+    BOOST_CHECK_EQUAL(tile_message.tag(), util::vector_tile::LAYER_TAG); // must be a layer
+    protozero::pbf_reader layer_message = tile_message.get_message();
+
+    auto number_of_features = 0u;
+    auto number_of_keys = 0u;
+    while (layer_message.next())
+    {
+        switch (layer_message.tag())
+        {
+        case util::vector_tile::NAME_TAG:
+            BOOST_CHECK_EQUAL(layer_message.get_string(), "speeds");
+            break;
+        case util::vector_tile::FEATURE_TAG:
+            layer_message.skip();
+            number_of_features++;
+            break;
+        case util::vector_tile::KEY_TAG:
+            layer_message.get_string();
+            number_of_keys++;
+            break;
+        default:
+            layer_message.skip();
+            break;
+        }
+    }
+
+    BOOST_CHECK_GT(number_of_features, 0);
+    BOOST_CHECK_EQUAL(number_of_keys, 5);
+
+    // the overview has no turn layer
+    BOOST_CHECK(!tile_message.next());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
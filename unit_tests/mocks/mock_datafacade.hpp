@@ -21,19 +21,33 @@ class MockDataFacade final : public engine::datafacade::BaseDataFacade
 {
   private:
     EdgeData foo;
+    engine::HotEdgeData hot_foo{};
+    const std::uint16_t weight = 1;
 
   public:
     unsigned GetNumberOfNodes() const override { return 0; }
     unsigned GetNumberOfEdges() const override { return 0; }
     unsigned GetOutDegree(const NodeID /* n */) const override { return 0; }
     NodeID GetTarget(const EdgeID /* e */) const override { return SPECIAL_NODEID; }
-    const EdgeData &GetEdgeData(const EdgeID /* e */) const override { return foo; }
+    EdgeData GetEdgeData(const EdgeID /* e */) const override { return foo; }
+    const engine::HotEdgeData &GetHotEdgeData(const EdgeID /* e */) const override
+    {
+        return hot_foo;
+    }
     EdgeID BeginEdges(const NodeID /* n */) const override { return SPECIAL_EDGEID; }
     EdgeID EndEdges(const NodeID /* n */) const override { return SPECIAL_EDGEID; }
     osrm::engine::datafacade::EdgeRange GetAdjacentEdgeRange(const NodeID /* node */) const override
     {
         return util::irange(static_cast<EdgeID>(0), static_cast<EdgeID>(0));
     }
+    osrm::engine::datafacade::EdgeRange GetForwardEdgeRange(const NodeID /* node */) const override
+    {
+        return util::irange(static_cast<EdgeID>(0), static_cast<EdgeID>(0));
+    }
+    osrm::engine::datafacade::EdgeRange GetBackwardEdgeRange(const NodeID /* node */) const override
+    {
+        return util::irange(static_cast<EdgeID>(0), static_cast<EdgeID>(0));
+    }
     EdgeID FindEdge(const NodeID /* from */, const NodeID /* to */) const override
     {
         return SPECIAL_EDGEID;
@@ -66,33 +80,45 @@ class MockDataFacade final : public engine::datafacade::BaseDataFacade
     {
         return GeometryID{SPECIAL_GEOMETRYID, false};
     }
-    std::vector<NodeID> GetUncompressedForwardGeometry(const EdgeID /* id */) const override
+    util::GeometryNodeView GetUncompressedForwardGeometry(const EdgeID /* id */) const override
+    {
+        return {};
+    }
+    util::GeometryNodeView GetUncompressedReverseGeometry(const EdgeID /* id */) const override
     {
         return {};
     }
-    std::vector<NodeID> GetUncompressedReverseGeometry(const EdgeID /* id */) const override
+    util::SegmentWeightView GetUncompressedForwardWeights(const EdgeID /* id */) const override
+    {
+        return util::SegmentWeightView(&weight, nullptr, nullptr, 0, 1);
+    }
+    util::SegmentWeightView GetUncompressedReverseWeights(const EdgeID /* id */) const override
+    {
+        return util::SegmentWeightView(&weight, nullptr, nullptr, 0, 1);
+    }
+    util::ArrayView<EdgeWeight>
+    GetUncompressedForwardWeightOffsets(const EdgeID /*id*/) const override
     {
         return {};
     }
-    std::vector<EdgeWeight> GetUncompressedForwardWeights(const EdgeID /* id */) const override
+    util::ArrayView<EdgeWeight>
+    GetUncompressedReverseWeightOffsets(const EdgeID /*id*/) const override
     {
-        std::vector<EdgeWeight> result_weights;
-        result_weights.resize(1);
-        result_weights[0] = 1;
-        return result_weights;
+        return {};
     }
-    std::vector<EdgeWeight> GetUncompressedReverseWeights(const EdgeID /* id */) const override
+    util::ArrayView<SegmentLength> GetUncompressedForwardLengths(const EdgeID /*id*/) const override
     {
-        std::vector<EdgeWeight> result_weights;
-        result_weights.resize(1);
-        result_weights[0] = 1;
-        return result_weights;
+        return {};
     }
-    std::vector<uint8_t> GetUncompressedForwardDatasources(const EdgeID /*id*/) const override
+    util::ArrayView<SegmentLength> GetUncompressedReverseLengths(const EdgeID /*id*/) const override
     {
         return {};
     }
-    std::vector<uint8_t> GetUncompressedReverseDatasources(const EdgeID /*id*/) const override
+    util::ArrayView<uint8_t> GetUncompressedForwardDatasources(const EdgeID /*id*/) const override
+    {
+        return {};
+    }
+    util::ArrayView<uint8_t> GetUncompressedReverseDatasources(const EdgeID /*id*/) const override
     {
         return {};
     }
@@ -100,6 +126,11 @@ class MockDataFacade final : public engine::datafacade::BaseDataFacade
     {
         return "";
     }
+    util::ArrayView<std::uint8_t> GetSpeedProfile(const NodeID /*from*/,
+                                                  const NodeID /*to*/) const override
+    {
+        return {};
+    }
     extractor::guidance::TurnInstruction
     GetTurnInstructionForEdgeID(const unsigned /* id */) const override
     {
@@ -109,6 +140,10 @@ class MockDataFacade final : public engine::datafacade::BaseDataFacade
     {
         return TRAVEL_MODE_INACCESSIBLE;
     }
+    extractor::EdgeBasedNodeData GetEdgeBasedNodeData(const NodeID /* id */) const override
+    {
+        return {};
+    }
     std::vector<RTreeLeaf> GetEdgesInBox(const util::Coordinate /* south_west */,
                                          const util::Coordinate /*north_east */) const override
     {
@@ -198,12 +233,24 @@ class MockDataFacade final : public engine::datafacade::BaseDataFacade
 
     unsigned GetCheckSum() const override { return 0; }
     bool IsCoreNode(const NodeID /* id */) const override { return false; }
+    NodeID GetHierarchyNode(const NodeID id) const override { return id; }
     unsigned GetNameIndexFromEdgeID(const unsigned /* id */) const override { return 0; }
-    std::string GetNameForID(const unsigned /* name_id */) const override { return ""; }
-    std::string GetRefForID(const unsigned /* name_id */) const override { return ""; }
-    std::string GetPronunciationForID(const unsigned /* name_id */) const override { return ""; }
-    std::string GetDestinationsForID(const unsigned /* name_id */) const override { return ""; }
+    util::StringView GetNameForID(const unsigned /* name_id */) const override { return ""; }
+    util::StringView GetRefForID(const unsigned /* name_id */) const override { return ""; }
+    util::StringView GetPronunciationForID(const unsigned /* name_id */) const override
+    {
+        return "";
+    }
+    util::StringView GetDestinationsForID(const unsigned /* name_id */) const override
+    {
+        return "";
+    }
     std::size_t GetCoreSize() const override { return 0; }
+    unsigned GetNumberOfCoreLandmarks() const override { return 0; }
+    util::ArrayView<EdgeWeight> GetCoreLandmarkWeights(const NodeID /* id */) const override
+    {
+        return {};
+    }
     std::string GetTimestamp() const override { return ""; }
     bool GetContinueStraightDefault() const override { return true; }
     double GetMapMatchingMaxSpeed() const override { return 180 / 3.6; }
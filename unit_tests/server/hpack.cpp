@@ -0,0 +1,171 @@
+#include "server/http2/hpack.hpp"
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(hpack)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+std::string fromHex(const std::string &hex)
+{
+    std::string bytes;
+    for (std::size_t index = 0; index + 1 < hex.size(); index += 2)
+    {
+        bytes.push_back(static_cast<char>(std::stoi(hex.substr(index, 2), nullptr, 16)));
+    }
+    return bytes;
+}
+
+bool decode(http2::HeaderDecoder &decoder,
+            const std::string &hex,
+            std::vector<http::header> &headers)
+{
+    const auto block = fromHex(hex);
+    headers.clear();
+    return decoder.Decode(block.data(), block.data() + block.size(), headers);
+}
+
+void checkHeaders(const std::vector<http::header> &headers,
+                  const std::vector<std::pair<std::string, std::string>> &expected)
+{
+    BOOST_REQUIRE_EQUAL(headers.size(), expected.size());
+    for (std::size_t index = 0; index < headers.size(); ++index)
+    {
+        BOOST_CHECK_EQUAL(headers[index].name, expected[index].first);
+        BOOST_CHECK_EQUAL(headers[index].value, expected[index].second);
+    }
+}
+}
+
+// RFC 7541, C.3: requests without Huffman coding that fill the dynamic table
+BOOST_AUTO_TEST_CASE(decode_requests_test)
+{
+    http2::HeaderDecoder decoder(64 * 1024);
+    std::vector<http::header> headers;
+
+    BOOST_CHECK(decode(decoder, "828684410f7777772e6578616d706c652e636f6d", headers));
+    checkHeaders(headers,
+                 {{":method", "GET"},
+                  {":scheme", "http"},
+                  {":path", "/"},
+                  {":authority", "www.example.com"}});
+
+    BOOST_CHECK(decode(decoder, "828684be58086e6f2d6361636865", headers));
+    checkHeaders(headers,
+                 {{":method", "GET"},
+                  {":scheme", "http"},
+                  {":path", "/"},
+                  {":authority", "www.example.com"},
+                  {"cache-control", "no-cache"}});
+
+    BOOST_CHECK(decode(
+        decoder, "828785bf400a637573746f6d2d6b65790c637573746f6d2d76616c7565", headers));
+    checkHeaders(headers,
+                 {{":method", "GET"},
+                  {":scheme", "https"},
+                  {":path", "/index.html"},
+                  {":authority", "www.example.com"},
+                  {"custom-key", "custom-value"}});
+}
+
+// RFC 7541, C.4: the same requests with Huffman coding
+BOOST_AUTO_TEST_CASE(decode_huffman_requests_test)
+{
+    http2::HeaderDecoder decoder(64 * 1024);
+    std::vector<http::header> headers;
+
+    BOOST_CHECK(decode(decoder, "828684418cf1e3c2e5f23a6ba0ab90f4ff", headers));
+    checkHeaders(headers,
+                 {{":method", "GET"},
+                  {":scheme", "http"},
+                  {":path", "/"},
+                  {":authority", "www.example.com"}});
+
+    BOOST_CHECK(decode(decoder, "828684be5886a8eb10649cbf", headers));
+    checkHeaders(headers,
+                 {{":method", "GET"},
+                  {":scheme", "http"},
+                  {":path", "/"},
+                  {":authority", "www.example.com"},
+                  {"cache-control", "no-cache"}});
+
+    BOOST_CHECK(
+        decode(decoder, "828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf", headers));
+    checkHeaders(headers,
+                 {{":method", "GET"},
+                  {":scheme", "https"},
+                  {":path", "/index.html"},
+                  {":authority", "www.example.com"},
+                  {"custom-key", "custom-value"}});
+}
+
+BOOST_AUTO_TEST_CASE(decode_invalid_test)
+{
+    std::vector<http::header> headers;
+
+    // index beyond the empty dynamic table
+    http2::HeaderDecoder decoder(64 * 1024);
+    BOOST_CHECK(!decode(decoder, "be", headers));
+
+    // truncated literal
+    http2::HeaderDecoder truncated_decoder(64 * 1024);
+    BOOST_CHECK(!decode(truncated_decoder, "410f7777", headers));
+
+    // header list larger than allowed
+    http2::HeaderDecoder small_decoder(40);
+    BOOST_CHECK(!decode(small_decoder, "828684410f7777772e6578616d706c652e636f6d", headers));
+}
+
+BOOST_AUTO_TEST_CASE(huffman_test)
+{
+    std::string output;
+    auto input = fromHex("f1e3c2e5f23a6ba0ab90f4ff");
+    BOOST_CHECK(http2::decodeHuffman(input.data(), input.data() + input.size(), output));
+    BOOST_CHECK_EQUAL(output, "www.example.com");
+
+    output.clear();
+    input = fromHex("6402");
+    BOOST_CHECK(http2::decodeHuffman(input.data(), input.data() + input.size(), output));
+    BOOST_CHECK_EQUAL(output, "302");
+
+    // padding has to be shorter than a byte and consist of ones
+    output.clear();
+    input = fromHex("6402ff");
+    BOOST_CHECK(!http2::decodeHuffman(input.data(), input.data() + input.size(), output));
+    output.clear();
+    input = fromHex("64");
+    BOOST_CHECK(!http2::decodeHuffman(input.data(), input.data() + input.size(), output));
+}
+
+BOOST_AUTO_TEST_CASE(encode_test)
+{
+    std::vector<http::header> reply_headers;
+    reply_headers.emplace_back("Content-Type", "application/json; charset=UTF-8");
+    reply_headers.emplace_back("Connection", "keep-alive");
+    reply_headers.emplace_back("Content-Length", "42");
+    std::vector<char> block;
+    http2::encodeHeaders(400, reply_headers, block);
+
+    http2::HeaderDecoder decoder(64 * 1024);
+    std::vector<http::header> headers;
+    BOOST_CHECK(decoder.Decode(block.data(), block.data() + block.size(), headers));
+    checkHeaders(headers,
+                 {{":status", "400"},
+                  {"content-type", "application/json; charset=UTF-8"},
+                  {"content-length", "42"}});
+
+    block.clear();
+    http2::encodeHeaders(404, {}, block);
+    headers.clear();
+    BOOST_CHECK(decoder.Decode(block.data(), block.data() + block.size(), headers));
+    checkHeaders(headers, {{":status", "404"}});
+}
+
+BOOST_AUTO_TEST_SUITE_END()
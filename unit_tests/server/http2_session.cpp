@@ -0,0 +1,249 @@
+#include "server/http2/session.hpp"
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(http2_session)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+// GET / with the authority www.example.com, from RFC 7541 C.3.1
+const std::string GET_BLOCK("\x82\x86\x84\x41\x0f"
+                            "www.example.com");
+
+struct Frame
+{
+    unsigned type;
+    unsigned flags;
+    std::uint32_t stream_id;
+    std::string payload;
+};
+
+std::string makeFrame(const unsigned type,
+                      const unsigned flags,
+                      const std::uint32_t stream_id,
+                      const std::string &payload)
+{
+    std::string frame;
+    frame.push_back(static_cast<char>((payload.size() >> 16) & 0xff));
+    frame.push_back(static_cast<char>((payload.size() >> 8) & 0xff));
+    frame.push_back(static_cast<char>(payload.size() & 0xff));
+    frame.push_back(static_cast<char>(type));
+    frame.push_back(static_cast<char>(flags));
+    for (const auto shift : {24, 16, 8, 0})
+    {
+        frame.push_back(static_cast<char>((stream_id >> shift) & 0xff));
+    }
+    return frame + payload;
+}
+
+std::string makeUint32(const std::uint32_t value)
+{
+    std::string bytes;
+    for (const auto shift : {24, 16, 8, 0})
+    {
+        bytes.push_back(static_cast<char>((value >> shift) & 0xff));
+    }
+    return bytes;
+}
+
+std::uint32_t readUint32(const std::string &bytes, const std::size_t offset)
+{
+    std::uint32_t value = 0;
+    for (std::size_t index = offset; index < offset + 4; ++index)
+    {
+        value = (value << 8) | static_cast<unsigned char>(bytes[index]);
+    }
+    return value;
+}
+
+std::vector<Frame> takeFrames(http2::Session &session)
+{
+    std::vector<char> output;
+    session.TakeOutput(output);
+    std::vector<Frame> frames;
+    std::size_t position = 0;
+    while (position + 9 <= output.size())
+    {
+        const std::string header(output.begin() + position, output.begin() + position + 9);
+        const std::size_t length = readUint32(header, 0) >> 8;
+        frames.push_back({static_cast<unsigned char>(header[3]),
+                          static_cast<unsigned char>(header[4]),
+                          readUint32(header, 5),
+                          std::string(output.begin() + position + 9,
+                                      output.begin() + position + 9 + length)});
+        position += 9 + length;
+    }
+    BOOST_CHECK_EQUAL(position, output.size());
+    return frames;
+}
+
+bool consume(http2::Session &session,
+             const std::string &input,
+             std::vector<std::uint32_t> &complete_streams)
+{
+    complete_streams.clear();
+    return session.Consume(input.data(), input.data() + input.size(), complete_streams);
+}
+
+// Sends the settings of the client and drops the ones of the server and the acknowledgement
+void start(http2::Session &session)
+{
+    std::vector<std::uint32_t> complete_streams;
+    BOOST_REQUIRE(consume(session, makeFrame(0x4, 0, 0, ""), complete_streams));
+    const auto frames = takeFrames(session);
+    BOOST_REQUIRE_EQUAL(frames.size(), 2);
+    BOOST_CHECK_EQUAL(frames[0].type, 0x4);
+    BOOST_CHECK_EQUAL(frames[0].flags, 0);
+    BOOST_CHECK_EQUAL(frames[1].type, 0x4);
+    BOOST_CHECK_EQUAL(frames[1].flags, 0x1);
+}
+}
+
+BOOST_AUTO_TEST_CASE(request_reply_test)
+{
+    http2::Session session;
+    start(session);
+
+    // the request arrives split in two reads
+    std::vector<std::uint32_t> complete_streams;
+    const auto headers = makeFrame(0x1, 0x5, 1, GET_BLOCK);
+    BOOST_CHECK(consume(session, headers.substr(0, 7), complete_streams));
+    BOOST_CHECK(complete_streams.empty());
+    BOOST_CHECK(consume(session, headers.substr(7), complete_streams));
+    BOOST_REQUIRE_EQUAL(complete_streams.size(), 1);
+    BOOST_CHECK_EQUAL(complete_streams[0], 1);
+    BOOST_CHECK_EQUAL(session.GetRequest(1).uri, "/");
+    BOOST_CHECK(session.HasStreams());
+
+    auto &reply = session.GetReply(1);
+    reply.status = http::reply::ok;
+    reply.headers.emplace_back("Content-Type", "application/json; charset=UTF-8");
+    session.SendReply(1, std::vector<char>{'{', '}'});
+
+    const auto frames = takeFrames(session);
+    BOOST_REQUIRE_EQUAL(frames.size(), 2);
+    BOOST_CHECK_EQUAL(frames[0].type, 0x1);
+    BOOST_CHECK_EQUAL(frames[0].flags, 0x4);
+    BOOST_CHECK_EQUAL(frames[0].stream_id, 1);
+    BOOST_CHECK_EQUAL(frames[1].type, 0x0);
+    BOOST_CHECK_EQUAL(frames[1].flags, 0x1);
+    BOOST_CHECK_EQUAL(frames[1].payload, "{}");
+    BOOST_CHECK(!session.HasStreams());
+    BOOST_CHECK(!session.IsDone());
+}
+
+BOOST_AUTO_TEST_CASE(flow_control_test)
+{
+    http2::Session session;
+    start(session);
+
+    std::vector<std::uint32_t> complete_streams;
+    BOOST_REQUIRE(consume(session, makeFrame(0x1, 0x5, 1, GET_BLOCK), complete_streams));
+    session.SendReply(1, std::vector<char>(100000, 'x'));
+
+    // the body is sent as far as the initial windows allow
+    auto frames = takeFrames(session);
+    std::size_t sent = 0;
+    for (const auto &frame : frames)
+    {
+        if (frame.type == 0x0)
+        {
+            BOOST_CHECK_EQUAL(frame.flags, 0);
+            sent += frame.payload.size();
+        }
+    }
+    BOOST_CHECK_EQUAL(sent, 65535);
+    BOOST_CHECK(session.HasStreams());
+
+    // the rest once the client enlarges them
+    BOOST_CHECK(consume(session,
+                        makeFrame(0x8, 0, 0, makeUint32(40000)) +
+                            makeFrame(0x8, 0, 1, makeUint32(40000)),
+                        complete_streams));
+    frames = takeFrames(session);
+    sent = 0;
+    for (const auto &frame : frames)
+    {
+        BOOST_CHECK_EQUAL(frame.type, 0x0);
+        sent += frame.payload.size();
+    }
+    BOOST_CHECK_EQUAL(sent, 100000 - 65535);
+    BOOST_REQUIRE(!frames.empty());
+    BOOST_CHECK_EQUAL(frames.back().flags, 0x1);
+    BOOST_CHECK(!session.HasStreams());
+}
+
+BOOST_AUTO_TEST_CASE(ping_reset_test)
+{
+    http2::Session session;
+    start(session);
+
+    std::vector<std::uint32_t> complete_streams;
+    BOOST_REQUIRE(consume(session, makeFrame(0x1, 0x5, 1, GET_BLOCK), complete_streams));
+    const auto cancelled = session.GetRequest(1).cancelled;
+    BOOST_REQUIRE(cancelled);
+
+    BOOST_CHECK(consume(session,
+                        makeFrame(0x6, 0, 0, "12345678") + makeFrame(0x3, 0, 1, makeUint32(0x8)),
+                        complete_streams));
+    auto frames = takeFrames(session);
+    BOOST_REQUIRE_EQUAL(frames.size(), 1);
+    BOOST_CHECK_EQUAL(frames[0].type, 0x6);
+    BOOST_CHECK_EQUAL(frames[0].flags, 0x1);
+    BOOST_CHECK_EQUAL(frames[0].payload, "12345678");
+
+    // the running query is cancelled and its reply dropped
+    BOOST_CHECK(cancelled->load());
+    BOOST_CHECK(session.HasStreams());
+    session.SendReply(1, std::vector<char>{'{', '}'});
+    BOOST_CHECK(!session.HasOutput());
+    BOOST_CHECK(!session.HasStreams());
+}
+
+BOOST_AUTO_TEST_CASE(invalid_request_test)
+{
+    http2::Session session;
+    start(session);
+
+    // a request without a path is refused, the connection stays usable
+    std::vector<std::uint32_t> complete_streams;
+    BOOST_CHECK(consume(session, makeFrame(0x1, 0x5, 1, "\x82\x86"), complete_streams));
+    BOOST_CHECK(complete_streams.empty());
+    auto frames = takeFrames(session);
+    BOOST_REQUIRE_EQUAL(frames.size(), 1);
+    BOOST_CHECK_EQUAL(frames[0].type, 0x3);
+    BOOST_CHECK_EQUAL(readUint32(frames[0].payload, 0), 0x1);
+
+    // streams have to use odd ids
+    BOOST_CHECK(!consume(session, makeFrame(0x1, 0x5, 2, GET_BLOCK), complete_streams));
+    frames = takeFrames(session);
+    BOOST_REQUIRE_EQUAL(frames.size(), 1);
+    BOOST_CHECK_EQUAL(frames[0].type, 0x7);
+    BOOST_CHECK_EQUAL(readUint32(frames[0].payload, 0), 1);
+    BOOST_CHECK_EQUAL(readUint32(frames[0].payload, 4), 0x1);
+    BOOST_CHECK(session.IsDone());
+}
+
+BOOST_AUTO_TEST_CASE(missing_settings_test)
+{
+    http2::Session session;
+    takeFrames(session);
+
+    std::vector<std::uint32_t> complete_streams;
+    BOOST_CHECK(!consume(session, makeFrame(0x1, 0x5, 1, GET_BLOCK), complete_streams));
+    const auto frames = takeFrames(session);
+    BOOST_REQUIRE_EQUAL(frames.size(), 1);
+    BOOST_CHECK_EQUAL(frames[0].type, 0x7);
+    BOOST_CHECK(session.IsDone());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
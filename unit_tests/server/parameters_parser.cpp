@@ -3,6 +3,7 @@
 #include "parameters_io.hpp"
 
 #include "engine/api/base_parameters.hpp"
+#include "engine/api/isochrone_parameters.hpp"
 #include "engine/api/match_parameters.hpp"
 #include "engine/api/nearest_parameters.hpp"
 #include "engine/api/route_parameters.hpp"
@@ -63,6 +64,12 @@ BOOST_AUTO_TEST_CASE(invalid_route_urls)
     BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>(std::string{"1,2;3,4"} + '\0' + ".json"),
                       7);
     BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>(std::string{"1,2;3,"} + '\0'), 6);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4.pbf?nooptions"), 12);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4?departure_time=now"), 23UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4?exclude=tolls"), 20UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4.xml"), 8);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4?metric="), 15UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4?metric=a.b"), 16UL);
 
     // BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>(), );
 }
@@ -75,6 +82,35 @@ BOOST_AUTO_TEST_CASE(invalid_table_urls)
         testInvalidOptions<TableParameters>("1,2;3,4?sources=1&destinations=1&bla=foo"), 32UL);
     BOOST_CHECK_EQUAL(testInvalidOptions<TableParameters>("1,2;3,4?sources=foo"), 16UL);
     BOOST_CHECK_EQUAL(testInvalidOptions<TableParameters>("1,2;3,4?destinations=foo"), 21UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<TableParameters>("1,2;3,4?annotations=speed"), 20UL);
+}
+
+BOOST_AUTO_TEST_CASE(valid_route_annotations)
+{
+    using AnnotationsType = RouteParameters::AnnotationsType;
+
+    auto result_1 = parseParameters<RouteParameters>("1,2;3,4?annotations=true");
+    BOOST_CHECK(result_1);
+    BOOST_CHECK(result_1->annotations);
+    BOOST_CHECK(result_1->annotations_type == AnnotationsType::All);
+
+    auto result_2 = parseParameters<RouteParameters>("1,2;3,4?annotations=duration,nodes");
+    BOOST_CHECK(result_2);
+    BOOST_CHECK(result_2->annotations);
+    BOOST_CHECK(result_2->annotations_type == (AnnotationsType::Duration | AnnotationsType::Nodes));
+
+    auto result_3 =
+        parseParameters<RouteParameters>("1,2;3,4?annotations=distance&annotations=false");
+    BOOST_CHECK(result_3);
+    BOOST_CHECK(!result_3->annotations);
+
+    auto result_4 = parseParameters<MatchParameters>("1,2;3,4?annotations=datasources");
+    BOOST_CHECK(result_4);
+    BOOST_CHECK(result_4->annotations);
+    BOOST_CHECK(result_4->annotations_type == AnnotationsType::Datasources);
+
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4?annotations=speed"), 20UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4?annotations=nodes,"), 25UL);
 }
 
 BOOST_AUTO_TEST_CASE(valid_route_hint)
@@ -296,6 +332,36 @@ BOOST_AUTO_TEST_CASE(valid_route_urls)
     CHECK_EQUAL_RANGE(reference_10.radiuses, result_10->radiuses);
     CHECK_EQUAL_RANGE(reference_10.coordinates, result_10->coordinates);
     CHECK_EQUAL_RANGE(reference_10.hints, result_10->hints);
+
+    auto result_11 = parseParameters<RouteParameters>("1,2;3,4.json");
+    BOOST_CHECK(result_11);
+    BOOST_CHECK(result_11->output_format == engine::api::OutputFormatType::JSON);
+
+    auto result_12 = parseParameters<RouteParameters>("1,2;3,4.pbf?overview=false");
+    BOOST_CHECK(result_12);
+    BOOST_CHECK(result_12->output_format == engine::api::OutputFormatType::PBF);
+    BOOST_CHECK_EQUAL(result_12->overview, RouteParameters::OverviewType::False);
+    CHECK_EQUAL_RANGE(coords_1, result_12->coordinates);
+
+    auto result_13 = parseParameters<RouteParameters>("1,2;3,4?metric=fuel_v-2&steps=true");
+    BOOST_CHECK(result_13);
+    BOOST_CHECK_EQUAL(result_13->metric, "fuel_v-2");
+    BOOST_CHECK_EQUAL(result_13->steps, true);
+    BOOST_CHECK_EQUAL(result_11->metric, "");
+
+    auto result_14 =
+        parseParameters<RouteParameters>("1,2;3,4?departure_time=1477000800&steps=true");
+    BOOST_CHECK(result_14);
+    BOOST_CHECK(result_14->departure_time);
+    BOOST_CHECK_EQUAL(*result_14->departure_time, 1477000800UL);
+    BOOST_CHECK(!result_11->departure_time);
+
+    auto result_15 = parseParameters<RouteParameters>("1,2;3,4?exclude=toll,ferry");
+    BOOST_CHECK(result_15);
+    const std::vector<std::string> exclude_15 = {"toll", "ferry"};
+    CHECK_EQUAL_RANGE(exclude_15, result_15->exclude);
+    BOOST_CHECK(result_15->IsValid());
+    BOOST_CHECK(result_11->exclude.empty());
 }
 
 BOOST_AUTO_TEST_CASE(valid_table_urls)
@@ -332,6 +398,62 @@ BOOST_AUTO_TEST_CASE(valid_table_urls)
     CHECK_EQUAL_RANGE(reference_1.bearings, result_3->bearings);
     CHECK_EQUAL_RANGE(reference_1.radiuses, result_3->radiuses);
     CHECK_EQUAL_RANGE(reference_1.coordinates, result_3->coordinates);
+
+    auto result_4 = parseParameters<TableParameters>("1,2;3,4.pbf?sources=1;2;3");
+    BOOST_CHECK(result_4);
+    BOOST_CHECK(result_4->output_format == engine::api::OutputFormatType::PBF);
+    CHECK_EQUAL_RANGE(sources_2, result_4->sources);
+    CHECK_EQUAL_RANGE(reference_1.coordinates, result_4->coordinates);
+
+    auto result_5 = parseParameters<TableParameters>("1,2;3,4?metric=distance");
+    BOOST_CHECK(result_5);
+    BOOST_CHECK_EQUAL(result_5->metric, "distance");
+    BOOST_CHECK(result_5->annotations == TableParameters::AnnotationsType::Duration);
+
+    auto result_6 = parseParameters<TableParameters>("1,2;3,4?annotations=distance");
+    BOOST_CHECK(result_6);
+    BOOST_CHECK(result_6->annotations == TableParameters::AnnotationsType::Distance);
+    BOOST_CHECK(result_6->IsValid());
+
+    std::vector<std::size_t> sources_7 = {0};
+    auto result_7 =
+        parseParameters<TableParameters>("1,2;3,4?sources=0&annotations=distance,duration");
+    BOOST_CHECK(result_7);
+    BOOST_CHECK(result_7->annotations == TableParameters::AnnotationsType::All);
+    CHECK_EQUAL_RANGE(sources_7, result_7->sources);
+
+    auto result_8 = parseParameters<TableParameters>("1,2;3,4.bin?binary_values=int32");
+    BOOST_CHECK(result_8);
+    BOOST_CHECK(result_8->output_format == engine::api::OutputFormatType::Binary);
+    BOOST_CHECK(result_8->binary_values == TableParameters::BinaryValuesType::Int32);
+    CHECK_EQUAL_RANGE(reference_1.coordinates, result_8->coordinates);
+
+    auto result_9 = parseParameters<TableParameters>("1,2;3,4.bin");
+    BOOST_CHECK(result_9);
+    BOOST_CHECK(result_9->binary_values == TableParameters::BinaryValuesType::Float32);
+
+    // the targets of a registered set are not part of the coordinates
+    auto result_10 = parseParameters<TableParameters>("1,2?target_set=depots_2-a");
+    BOOST_CHECK(result_10);
+    BOOST_CHECK_EQUAL(result_10->target_set, "depots_2-a");
+    BOOST_CHECK(result_10->UsesTargetSet());
+    BOOST_CHECK(result_10->IsValid());
+
+    auto result_11 = parseParameters<TableParameters>("1,2;3,4?destinations=1&target_set=depots");
+    BOOST_CHECK(result_11);
+    BOOST_CHECK(!result_11->UsesTargetSet());
+    BOOST_CHECK(result_11->IsValid());
+
+    auto result_12 = parseParameters<TableParameters>("1,2;3,4?approximate=true");
+    BOOST_CHECK(result_12);
+    BOOST_CHECK(result_12->approximate);
+    BOOST_CHECK(result_12->IsValid());
+
+    // the error is only bounded for durations
+    auto result_13 =
+        parseParameters<TableParameters>("1,2;3,4?approximate=true&annotations=distance");
+    BOOST_CHECK(result_13);
+    BOOST_CHECK(!result_13->IsValid());
 }
 
 BOOST_AUTO_TEST_CASE(valid_match_urls)
@@ -383,6 +505,61 @@ BOOST_AUTO_TEST_CASE(valid_nearest_urls)
     CHECK_EQUAL_RANGE(reference_2.coordinates, result_2->coordinates);
 }
 
+BOOST_AUTO_TEST_CASE(list_parameters)
+{
+    auto result_1 = parseParameters<RouteParameters>(
+        "13.388860,52.517037;.5,-.5;7.,1.00000000000000001.json?radiuses=1e3;unlimited;5.&"
+        "bearings=;-10,+20;0090,45");
+    BOOST_CHECK(result_1);
+    std::vector<util::Coordinate> coords_1 = {
+        {util::FloatLongitude{13.388860}, util::FloatLatitude{52.517037}},
+        {util::FloatLongitude{0.5}, util::FloatLatitude{-0.5}},
+        {util::FloatLongitude{7}, util::FloatLatitude{1}}};
+    std::vector<boost::optional<double>> radiuses_1 = {
+        1000., std::numeric_limits<double>::infinity(), 5.};
+    std::vector<boost::optional<engine::Bearing>> bearings_1 = {
+        boost::none, engine::Bearing{-10, 20}, engine::Bearing{90, 45}};
+    CHECK_EQUAL_RANGE(coords_1, result_1->coordinates);
+    CHECK_EQUAL_RANGE(radiuses_1, result_1->radiuses);
+    CHECK_EQUAL_RANGE(bearings_1, result_1->bearings);
+
+    auto result_2 = parseParameters<RouteParameters>("1,2?generate_hints=false");
+    BOOST_CHECK(result_2);
+    BOOST_CHECK(!result_2->generate_hints);
+    BOOST_CHECK(RouteParameters{}.generate_hints);
+
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3"), 5UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,"), 6UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2?bearings=1"), 14UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2?bearings=40000,1"), 13UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2?radiuses=1;unlimite"), 15UL);
+}
+
+BOOST_AUTO_TEST_CASE(valid_isochrone_urls)
+{
+    std::vector<util::Coordinate> coords_1 = {{util::FloatLongitude{1}, util::FloatLatitude{2}}};
+
+    auto result_1 = parseParameters<IsochroneParameters>("1,2");
+    BOOST_CHECK(result_1);
+    BOOST_CHECK(!result_1->IsValid()); // the duration has to be given
+
+    IsochroneParameters reference_2{};
+    reference_2.coordinates = coords_1;
+    reference_2.duration = 600;
+    auto result_2 = parseParameters<IsochroneParameters>("1,2?duration=600&radiuses=50");
+    BOOST_CHECK(result_2);
+    BOOST_CHECK(result_2->IsValid());
+    BOOST_CHECK_EQUAL(reference_2.duration, result_2->duration);
+    BOOST_CHECK_EQUAL(result_2->radiuses.size(), 1);
+    CHECK_EQUAL_RANGE(reference_2.coordinates, result_2->coordinates);
+
+    auto result_3 = parseParameters<IsochroneParameters>("1,2;3,4?duration=600");
+    BOOST_CHECK(result_3);
+    BOOST_CHECK(!result_3->IsValid()); // only one coordinate is supported
+
+    BOOST_CHECK_EQUAL(testInvalidOptions<IsochroneParameters>("1,2?duration=-1"), 13UL);
+}
+
 BOOST_AUTO_TEST_CASE(invalid_tile_urls)
 {
     TileParameters reference_1{1, 2, 3};
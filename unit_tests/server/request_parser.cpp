@@ -0,0 +1,164 @@
+#include "server/http/request.hpp"
+#include "server/request_parser.hpp"
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(request_parser)
+
+using namespace osrm;
+using namespace osrm::server;
+
+RequestParser::RequestStatus
+parse(RequestParser &parser, http::request &request, char *&begin, char *end)
+{
+    RequestParser::RequestStatus status;
+    http::compression_type compression;
+    std::tie(status, compression) = parser.parse(request, begin, end);
+    return status;
+}
+
+RequestParser::RequestStatus parse(const std::string &input, http::request &request)
+{
+    RequestParser parser;
+    std::vector<char> buffer(input.begin(), input.end());
+    char *begin = buffer.data();
+    return parse(parser, request, begin, buffer.data() + buffer.size());
+}
+
+BOOST_AUTO_TEST_CASE(keep_alive)
+{
+    http::request http_11;
+    BOOST_CHECK(parse("GET /route HTTP/1.1\r\nHost: localhost\r\n\r\n", http_11) ==
+                RequestParser::RequestStatus::valid);
+    BOOST_CHECK_EQUAL(http_11.uri, "/route");
+    BOOST_CHECK(http_11.keep_alive);
+
+    http::request http_11_close;
+    BOOST_CHECK(parse("GET /route HTTP/1.1\r\nConnection: close\r\n\r\n", http_11_close) ==
+                RequestParser::RequestStatus::valid);
+    BOOST_CHECK(!http_11_close.keep_alive);
+
+    http::request http_10;
+    BOOST_CHECK(parse("GET /route HTTP/1.0\r\n\r\n", http_10) ==
+                RequestParser::RequestStatus::valid);
+    BOOST_CHECK(!http_10.keep_alive);
+
+    http::request http_10_keep_alive;
+    BOOST_CHECK(parse("GET /route HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n",
+                      http_10_keep_alive) == RequestParser::RequestStatus::valid);
+    BOOST_CHECK(http_10_keep_alive.keep_alive);
+}
+
+BOOST_AUTO_TEST_CASE(pipelined_requests)
+{
+    const std::string input = "GET /first HTTP/1.1\r\nConnection: keep-alive\r\n\r\n"
+                              "GET /second HTTP/1.1\r\nConnection: close\r\n\r\n";
+    std::vector<char> buffer(input.begin(), input.end());
+    char *begin = buffer.data();
+    char *end = buffer.data() + buffer.size();
+
+    RequestParser parser;
+    http::request first;
+    BOOST_CHECK(parse(parser, first, begin, end) == RequestParser::RequestStatus::valid);
+    BOOST_CHECK_EQUAL(first.uri, "/first");
+    BOOST_CHECK(first.keep_alive);
+    BOOST_CHECK(begin != end);
+
+    parser.reset();
+    http::request second;
+    BOOST_CHECK(parse(parser, second, begin, end) == RequestParser::RequestStatus::valid);
+    BOOST_CHECK_EQUAL(second.uri, "/second");
+    BOOST_CHECK(!second.keep_alive);
+    BOOST_CHECK(begin == end);
+}
+
+BOOST_AUTO_TEST_CASE(incomplete_request)
+{
+    const std::string input = "GET /route HTTP/1.1\r\nHost: local";
+    http::request request;
+    BOOST_CHECK(parse(input, request) == RequestParser::RequestStatus::indeterminate);
+}
+
+BOOST_AUTO_TEST_CASE(post_body)
+{
+    const std::string input = "POST /table/v1/driving HTTP/1.1\r\nContent-Length: 11\r\n\r\n"
+                              "0,1;2,3;4,5"
+                              "GET /next HTTP/1.1\r\n\r\n";
+    std::vector<char> buffer(input.begin(), input.end());
+    char *begin = buffer.data();
+    char *end = buffer.data() + buffer.size();
+
+    // the body arrives in two reads
+    RequestParser parser;
+    http::request request;
+    char *split = begin + input.find("2,3");
+    BOOST_CHECK(parse(parser, request, begin, split) ==
+                RequestParser::RequestStatus::indeterminate);
+    BOOST_CHECK(!parser.await_continue());
+    BOOST_CHECK(parse(parser, request, begin, end) == RequestParser::RequestStatus::valid);
+    BOOST_CHECK_EQUAL(request.uri, "/table/v1/driving");
+    BOOST_CHECK_EQUAL(request.body, "0,1;2,3;4,5");
+
+    parser.reset();
+    http::request next;
+    BOOST_CHECK(parse(parser, next, begin, end) == RequestParser::RequestStatus::valid);
+    BOOST_CHECK_EQUAL(next.uri, "/next");
+    BOOST_CHECK(next.body.empty());
+}
+
+BOOST_AUTO_TEST_CASE(post_body_expect_continue)
+{
+    const std::string input =
+        "POST /match/v1/car HTTP/1.1\r\nExpect: 100-continue\r\nContent-Length: 3\r\n\r\n";
+    std::vector<char> buffer(input.begin(), input.end());
+    char *begin = buffer.data();
+
+    RequestParser parser;
+    http::request request;
+    BOOST_CHECK(parse(parser, request, begin, buffer.data() + buffer.size()) ==
+                RequestParser::RequestStatus::indeterminate);
+    BOOST_CHECK(parser.await_continue());
+    BOOST_CHECK(!parser.await_continue());
+}
+
+BOOST_AUTO_TEST_CASE(invalid_content_length)
+{
+    http::request not_a_number;
+    BOOST_CHECK(parse("POST /route HTTP/1.1\r\nContent-Length: 1x\r\n\r\n", not_a_number) ==
+                RequestParser::RequestStatus::invalid);
+
+    http::request too_large;
+    const auto length = std::to_string(RequestParser::MAX_CONTENT_LENGTH + 1);
+    BOOST_CHECK(parse("POST /route HTTP/1.1\r\nContent-Length: " + length + "\r\n\r\n",
+                      too_large) == RequestParser::RequestStatus::invalid);
+}
+
+BOOST_AUTO_TEST_CASE(timeout_header)
+{
+    http::request without_timeout;
+    BOOST_CHECK(parse("GET /route HTTP/1.1\r\n\r\n", without_timeout) ==
+                RequestParser::RequestStatus::valid);
+    BOOST_CHECK(without_timeout.timeout == std::chrono::milliseconds::zero());
+
+    http::request with_timeout;
+    BOOST_CHECK(parse("GET /route HTTP/1.1\r\nX-OSRM-Timeout: 250\r\n\r\n", with_timeout) ==
+                RequestParser::RequestStatus::valid);
+    BOOST_CHECK(with_timeout.timeout == std::chrono::milliseconds(250));
+
+    http::request long_timeout;
+    BOOST_CHECK(parse("GET /route HTTP/1.1\r\nX-OSRM-Timeout: 99999999999999999999999\r\n\r\n",
+                      long_timeout) == RequestParser::RequestStatus::valid);
+    BOOST_CHECK(long_timeout.timeout ==
+                std::chrono::milliseconds(RequestParser::MAX_TIMEOUT_MILLISECONDS));
+
+    http::request not_a_number;
+    BOOST_CHECK(parse("GET /route HTTP/1.1\r\nX-OSRM-Timeout: 1s\r\n\r\n", not_a_number) ==
+                RequestParser::RequestStatus::invalid);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
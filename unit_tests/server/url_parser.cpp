@@ -116,4 +116,16 @@ BOOST_AUTO_TEST_CASE(valid_urls)
     BOOST_CHECK_EQUAL(reference_7.prefix_length, result_7->prefix_length);
 }
 
+BOOST_AUTO_TEST_CASE(valid_url_in_place)
+{
+    const std::string url = "/route/v1/profile/0,1%3B2,3?hints=%3B";
+    auto iter = url.cbegin();
+    auto result = api::parseURL(iter, url.cend());
+    BOOST_CHECK(result);
+    BOOST_CHECK(iter == url.cend());
+    BOOST_CHECK_EQUAL(result->service, "route");
+    BOOST_CHECK_EQUAL(result->query, "0,1;2,3?hints=;");
+    BOOST_CHECK_EQUAL(result->prefix_length, 18UL);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
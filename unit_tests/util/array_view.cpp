@@ -0,0 +1,62 @@
+#include "util/array_view.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <numeric>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(array_view)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(forward_and_reverse)
+{
+    const std::vector<int> values = {1, 2, 3, 4, 5};
+
+    const ArrayView<int> forward(values.data() + 1, values.data() + 4);
+    BOOST_CHECK_EQUAL(forward.size(), 3);
+    BOOST_CHECK_EQUAL(forward.front(), 2);
+    BOOST_CHECK_EQUAL(forward.back(), 4);
+    const std::vector<int> forward_values(forward.begin(), forward.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        forward_values.begin(), forward_values.end(), values.begin() + 1, values.begin() + 4);
+
+    const ArrayView<int> reverse(values.data() + 1, values.data() + 4, true);
+    BOOST_CHECK_EQUAL(reverse.size(), 3);
+    BOOST_CHECK_EQUAL(reverse[0], 4);
+    BOOST_CHECK_EQUAL(reverse[2], 2);
+    const std::vector<int> reverse_values(reverse.begin(), reverse.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        reverse_values.begin(), reverse_values.end(), values.rbegin() + 1, values.rbegin() + 4);
+    BOOST_CHECK_EQUAL(std::accumulate(reverse.begin(), reverse.end(), 0), 9);
+    BOOST_CHECK_EQUAL(reverse.end() - reverse.begin(), 3);
+
+    const ArrayView<int> empty_reverse(values.data(), values.data(), true);
+    BOOST_CHECK(empty_reverse.empty());
+    BOOST_CHECK(empty_reverse.begin() == empty_reverse.end());
+
+    // reversing a view flips its order either way
+    const auto reversed_forward = forward.Reversed();
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        reversed_forward.begin(), reversed_forward.end(), reverse.begin(), reverse.end());
+    const auto reversed_reverse = reverse.Reversed();
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        reversed_reverse.begin(), reversed_reverse.end(), forward.begin(), forward.end());
+    BOOST_CHECK(empty_reverse.Reversed().empty());
+}
+
+BOOST_AUTO_TEST_CASE(default_values)
+{
+    const ArrayView<unsigned char> zeros(4);
+    BOOST_CHECK_EQUAL(zeros.size(), 4);
+    for (const auto value : zeros)
+    {
+        BOOST_CHECK_EQUAL(value, 0);
+    }
+
+    BOOST_CHECK(ArrayView<int>().empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
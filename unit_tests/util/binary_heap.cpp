@@ -24,6 +24,7 @@ typedef NodeID TestNodeID;
 typedef int TestKey;
 typedef int TestWeight;
 typedef boost::mpl::list<ArrayStorage<TestNodeID, TestKey>,
+                         TimestampedArrayStorage<TestNodeID, TestKey>,
                          MapStorage<TestNodeID, TestKey>,
                          UnorderedMapStorage<TestNodeID, TestKey>>
     storage_types;
@@ -123,6 +124,39 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(delete_all_test, T, storage_types, RandomDataFi
     BOOST_CHECK(heap.Empty());
 }
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(clear_test, T, storage_types, RandomDataFixture<NUM_NODES>)
+{
+    BinaryHeap<TestNodeID, TestKey, TestWeight, TestData, T> heap(NUM_NODES);
+
+    for (unsigned idx : order)
+    {
+        heap.Insert(ids[idx], weights[idx], data[idx]);
+    }
+
+    heap.Clear();
+
+    BOOST_CHECK(heap.Empty());
+    for (auto id : ids)
+    {
+        BOOST_CHECK(!heap.WasInserted(id));
+    }
+
+    // only re-insert every other node, the rest must stay invisible
+    for (unsigned idx : order)
+    {
+        if (idx % 2 == 0)
+        {
+            heap.Insert(ids[idx], weights[idx], data[idx]);
+        }
+    }
+
+    for (auto id : ids)
+    {
+        BOOST_CHECK_EQUAL(heap.WasInserted(id), id % 2 == 0);
+    }
+    BOOST_CHECK_EQUAL(heap.Min(), ids[0]);
+}
+
 BOOST_FIXTURE_TEST_CASE_TEMPLATE(decrease_key_test, T, storage_types, RandomDataFixture<10>)
 {
     BinaryHeap<TestNodeID, TestKey, TestWeight, TestData, T> heap(10);
@@ -0,0 +1,54 @@
+#include "util/cast.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(cast_test)
+
+using namespace osrm;
+using namespace osrm::util;
+
+std::string appended(const double value)
+{
+    std::vector<char> output;
+    cast::append_with_precision(output, value);
+    return std::string(output.begin(), output.end());
+}
+
+BOOST_AUTO_TEST_CASE(append_with_precision_test)
+{
+    BOOST_CHECK_EQUAL(appended(0.), "0");
+    BOOST_CHECK_EQUAL(appended(-0.), "-0");
+    BOOST_CHECK_EQUAL(appended(10.), "10");
+    BOOST_CHECK_EQUAL(appended(0.1), "0.1");
+    BOOST_CHECK_EQUAL(appended(-13.37), "-13.37");
+    BOOST_CHECK_EQUAL(appended(1e-7), "0");
+    BOOST_CHECK_EQUAL(appended(0.9999996), "1");
+    // exact ties are rounded to even like printf does
+    BOOST_CHECK_EQUAL(appended(0.0078125), "0.007812");
+    BOOST_CHECK_EQUAL(appended(0.0234375), "0.023438");
+}
+
+BOOST_AUTO_TEST_CASE(append_with_precision_matches_stream)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> distribution(-1e6, 1e6);
+    for (int i = 0; i < 10000; ++i)
+    {
+        const auto value = distribution(generator);
+        BOOST_CHECK_EQUAL(appended(value), cast::to_string_with_precision(value));
+    }
+
+    for (const auto value : {1e20, -1e300, std::numeric_limits<double>::infinity()})
+    {
+        BOOST_CHECK_EQUAL(appended(value), cast::to_string_with_precision(value));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
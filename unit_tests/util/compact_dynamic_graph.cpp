@@ -0,0 +1,98 @@
+#include "util/compact_dynamic_graph.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(compact_dynamic_graph)
+
+using namespace osrm;
+using namespace osrm::util;
+
+struct TestData
+{
+    EdgeID id;
+};
+
+typedef CompactDynamicGraph<TestData> TestGraph;
+typedef TestGraph::InputEdge TestInputEdge;
+
+std::vector<std::pair<NodeID, EdgeID>> Adjacency(const TestGraph &graph, const NodeID node)
+{
+    std::vector<std::pair<NodeID, EdgeID>> adjacency;
+    for (const auto edge : graph.GetAdjacentEdgeRange(node))
+    {
+        adjacency.emplace_back(graph.GetTarget(edge), graph.GetEdgeData(edge).id);
+    }
+    std::sort(adjacency.begin(), adjacency.end());
+    return adjacency;
+}
+
+BOOST_AUTO_TEST_CASE(find_test)
+{
+    std::vector<TestInputEdge> input_edges = {TestInputEdge{0, 1, TestData{1}},
+                                              TestInputEdge{3, 0, TestData{2}},
+                                              TestInputEdge{3, 0, TestData{5}},
+                                              TestInputEdge{3, 4, TestData{3}},
+                                              TestInputEdge{4, 3, TestData{4}}};
+    TestGraph graph(5, input_edges);
+
+    BOOST_CHECK_EQUAL(graph.GetNumberOfEdges(), 5);
+    BOOST_CHECK_EQUAL(graph.GetEdgeData(graph.FindEdge(0, 1)).id, 1);
+    BOOST_CHECK_EQUAL(graph.FindEdge(1, 0), SPECIAL_EDGEID);
+    BOOST_CHECK_EQUAL(graph.GetEdgeData(graph.FindEdge(3, 0)).id, 2);
+    BOOST_CHECK_EQUAL(graph.GetEdgeData(graph.FindEdge(3, 4)).id, 3);
+    BOOST_CHECK_EQUAL(graph.GetOutDegree(2), 0);
+}
+
+BOOST_AUTO_TEST_CASE(insert_delete_compact_test)
+{
+    std::vector<TestInputEdge> input_edges = {TestInputEdge{0, 1, TestData{1}},
+                                              TestInputEdge{0, 2, TestData{2}},
+                                              TestInputEdge{1, 0, TestData{3}},
+                                              TestInputEdge{1, 2, TestData{4}},
+                                              TestInputEdge{2, 0, TestData{5}},
+                                              TestInputEdge{2, 1, TestData{6}},
+                                              TestInputEdge{3, 0, TestData{7}},
+                                              TestInputEdge{3, 1, TestData{8}}};
+    TestGraph graph(4, input_edges);
+
+    // the blocks have no room left, inserting moves them to the end
+    graph.ReserveEdges(0, 1);
+    graph.InsertEdge(0, 3, TestData{9});
+    graph.InsertEdge(1, 3, TestData{10});
+    graph.InsertEdge(2, 3, TestData{11});
+    BOOST_CHECK_EQUAL(graph.GetNumberOfEdges(), 11);
+
+    BOOST_CHECK_EQUAL(graph.DeleteEdgesTo(1, 3), 1);
+    BOOST_CHECK_EQUAL(graph.DeleteEdgesTo(1, 3), 0);
+    BOOST_CHECK_EQUAL(graph.GetNumberOfEdges(), 10);
+
+    const std::vector<std::vector<std::pair<NodeID, EdgeID>>> expected = {
+        {{1, 1}, {2, 2}, {3, 9}}, {{0, 3}, {2, 4}}, {{0, 5}, {1, 6}, {3, 11}}, {{0, 7}, {1, 8}}};
+    for (const auto node : irange(0u, 4u))
+    {
+        BOOST_CHECK(Adjacency(graph, node) == expected[node]);
+    }
+
+    // the three moved blocks left more than a quarter of the edge array unused
+    graph.CompactIfFragmented();
+    BOOST_CHECK_EQUAL(graph.BeginEdges(3), 0);
+    BOOST_CHECK_EQUAL(graph.BeginEdges(0), 2);
+    BOOST_CHECK_EQUAL(graph.EndEdges(2), 10);
+    for (const auto node : irange(0u, 4u))
+    {
+        BOOST_CHECK(Adjacency(graph, node) == expected[node]);
+    }
+
+    // compacting dropped the slack, so the next insertion moves the block again
+    graph.InsertEdge(3, 2, TestData{12});
+    BOOST_CHECK_EQUAL(graph.BeginEdges(3), 10);
+    BOOST_CHECK_EQUAL(graph.GetEdgeData(graph.FindEdge(3, 2)).id, 12);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
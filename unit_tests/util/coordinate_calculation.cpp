@@ -6,6 +6,8 @@
 #include <osrm/coordinate.hpp>
 
 #include <cmath>
+#include <random>
+#include <vector>
 
 using namespace osrm;
 using namespace osrm::util;
@@ -311,4 +313,70 @@ BOOST_AUTO_TEST_CASE(circleCenter)
     BOOST_CHECK(!result);
 }
 
+// The batched functions against the scalar ones, on random coordinates around the world and on
+// targets close to the source
+BOOST_AUTO_TEST_CASE(batched_accuracy)
+{
+    std::mt19937 generator(23);
+    std::uniform_int_distribution<std::int32_t> longitude(-180000000, 180000000);
+    std::uniform_int_distribution<std::int32_t> latitude(-85000000, 85000000);
+    std::uniform_int_distribution<std::int32_t> step(-5000, 5000);
+
+    for (int run = 0; run < 20; ++run)
+    {
+        const Coordinate source(FixedLongitude{longitude(generator)},
+                                FixedLatitude{latitude(generator)});
+        std::vector<Coordinate> targets;
+        for (int i = 0; i < 500; ++i)
+        {
+            targets.emplace_back(FixedLongitude{longitude(generator)},
+                                 FixedLatitude{latitude(generator)});
+            targets.emplace_back(
+                FixedLongitude{std::max(-180000000,
+                                        std::min(180000000,
+                                                 static_cast<std::int32_t>(source.lon) +
+                                                     step(generator)))},
+                FixedLatitude{static_cast<std::int32_t>(source.lat) + step(generator)});
+        }
+        const ArrayView<Coordinate> view(targets.data(), targets.data() + targets.size());
+
+        std::vector<double> haversines, great_circles, bearings, approximate_bearings;
+        coordinate_calculation::haversineDistances(source, view, haversines);
+        coordinate_calculation::greatCircleDistances(source, view, great_circles);
+        coordinate_calculation::bearings(source, view, bearings);
+        coordinate_calculation::bearings(source, view, approximate_bearings, true);
+        BOOST_REQUIRE_EQUAL(haversines.size(), targets.size());
+        BOOST_REQUIRE_EQUAL(great_circles.size(), targets.size());
+        BOOST_REQUIRE_EQUAL(bearings.size(), targets.size());
+        BOOST_REQUIRE_EQUAL(approximate_bearings.size(), targets.size());
+
+        for (std::size_t i = 0; i < targets.size(); ++i)
+        {
+            // relative errors in percent
+            BOOST_CHECK_CLOSE(
+                haversines[i], coordinate_calculation::haversineDistance(source, targets[i]), 1e-8);
+            BOOST_CHECK_CLOSE(great_circles[i],
+                              coordinate_calculation::greatCircleDistance(source, targets[i]),
+                              1e-8);
+
+            // bearings close to 0 and 360 are the same direction
+            const auto bearing = coordinate_calculation::bearing(source, targets[i]);
+            const auto difference = [bearing](const double other) {
+                const auto absolute = std::abs(other - bearing);
+                return std::min(absolute, 360. - absolute);
+            };
+            BOOST_CHECK_SMALL(difference(bearings[i]), 1e-4);
+            BOOST_CHECK_SMALL(difference(approximate_bearings[i]), 0.03);
+            BOOST_CHECK(bearings[i] >= 0. && bearings[i] < 360.);
+            BOOST_CHECK(approximate_bearings[i] >= 0. && approximate_bearings[i] < 360.);
+        }
+    }
+
+    std::vector<double> empty;
+    coordinate_calculation::haversineDistances(Coordinate(FixedLongitude{0}, FixedLatitude{0}),
+                                               ArrayView<Coordinate>(nullptr, nullptr),
+                                               empty);
+    BOOST_CHECK(empty.empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,106 @@
+#include "util/coordinate_list.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <iterator>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(coordinate_list)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+// A walk of small steps with a few jumps across the world
+std::vector<Coordinate> makeCoordinates(const std::size_t count)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<std::int32_t> step(-2000, 2000);
+    std::uniform_int_distribution<std::int32_t> longitude(-180000000, 180000000);
+    std::uniform_int_distribution<std::int32_t> latitude(-85000000, 85000000);
+
+    std::vector<Coordinate> coordinates;
+    std::int32_t lon = 13388860, lat = 52517037;
+    for (std::size_t index = 0; index < count; ++index)
+    {
+        if (index % 37 == 0)
+        {
+            lon = longitude(generator);
+            lat = latitude(generator);
+        }
+        else
+        {
+            lon = std::max(-180000000, std::min(180000000, lon + step(generator)));
+            lat = std::max(-85000000, std::min(85000000, lat + step(generator)));
+        }
+        coordinates.emplace_back(FixedLongitude{lon}, FixedLatitude{lat});
+    }
+    coordinates.emplace_back(FixedLongitude{-180000000}, FixedLatitude{-85000000});
+    coordinates.emplace_back(FixedLongitude{180000000}, FixedLatitude{85000000});
+    return coordinates;
+}
+
+CoordinateList<false> compress(const std::vector<Coordinate> &coordinates)
+{
+    CoordinateEncoder counter;
+    for (const auto &coordinate : coordinates)
+        counter.push_back(coordinate);
+
+    std::vector<CoordinateBlock> blocks(counter.GetNumberOfBlocks());
+    std::vector<std::uint8_t> bytes(counter.GetNumberOfBytes());
+    CoordinateEncoder encoder(blocks.data(), bytes.data());
+    for (const auto &coordinate : coordinates)
+        encoder.push_back(coordinate);
+    BOOST_CHECK_EQUAL(encoder.GetNumberOfBytes(), bytes.size());
+
+    return CoordinateList<false>(blocks, bytes, coordinates.size());
+}
+}
+
+BOOST_AUTO_TEST_CASE(random_access)
+{
+    const auto coordinates = makeCoordinates(1000);
+    const auto list = compress(coordinates);
+    BOOST_CHECK(list.compressed());
+    BOOST_REQUIRE_EQUAL(list.size(), coordinates.size());
+
+    for (std::size_t index = 0; index < coordinates.size(); ++index)
+    {
+        BOOST_CHECK_EQUAL(list[index], coordinates[index]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(decode_ranges)
+{
+    const auto coordinates = makeCoordinates(300);
+    const auto list = compress(coordinates);
+
+    for (const auto &range : {std::make_pair(0, 302), std::make_pair(5, 6), std::make_pair(15, 49),
+                              std::make_pair(32, 64), std::make_pair(100, 100)})
+    {
+        std::vector<Coordinate> decoded;
+        list.decode(range.first, range.second, std::back_inserter(decoded));
+        BOOST_CHECK_EQUAL_COLLECTIONS(decoded.begin(),
+                                      decoded.end(),
+                                      coordinates.begin() + range.first,
+                                      coordinates.begin() + range.second);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(plain_coordinates)
+{
+    auto coordinates = makeCoordinates(20);
+    const auto original = coordinates;
+    const CoordinateList<false> list(coordinates);
+    BOOST_CHECK(!list.compressed());
+    BOOST_REQUIRE_EQUAL(list.size(), original.size());
+    for (std::size_t index = 0; index < original.size(); ++index)
+    {
+        BOOST_CHECK_EQUAL(list[index], original[index]);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
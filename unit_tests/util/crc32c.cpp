@@ -0,0 +1,54 @@
+#include "util/crc32c.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(crc32c_test)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(check_value)
+{
+    const std::string input = "123456789";
+    BOOST_CHECK_EQUAL(crc32c(input.data(), input.size()), 0xE3069283u);
+    BOOST_CHECK_EQUAL(crc32c(input.data(), 0), 0u);
+
+    // continuing from a prefix gives the checksum of the whole input
+    const auto prefix = crc32c(input.data(), 4);
+    BOOST_CHECK_EQUAL(crc32c(input.data() + 4, input.size() - 4, prefix), 0xE3069283u);
+}
+
+BOOST_AUTO_TEST_CASE(block_checksum)
+{
+    std::vector<char> block(3 * 1024 * 1024 + 17);
+    for (std::size_t index = 0; index < block.size(); ++index)
+    {
+        block[index] = static_cast<char>(index * 31 + index / 4096);
+    }
+    const auto checksum = blockChecksum(block.data(), block.size());
+    BOOST_CHECK_EQUAL(blockChecksum(block.data(), block.size()), checksum);
+
+    // the checksum follows from the checksums of the chunks
+    std::vector<std::uint32_t> chunk_checksums;
+    for (std::size_t offset = 0; offset < block.size(); offset += CHECKSUM_CHUNK_SIZE)
+    {
+        chunk_checksums.push_back(crc32c(block.data() + offset,
+                                         std::min(CHECKSUM_CHUNK_SIZE, block.size() - offset)));
+    }
+    BOOST_CHECK_EQUAL(combineChunkChecksums(chunk_checksums), checksum);
+    BOOST_CHECK_EQUAL(combineChunkChecksums({chunk_checksums.front()}),
+                      blockChecksum(block.data(), CHECKSUM_CHUNK_SIZE));
+
+    block[2 * 1024 * 1024 + 5] ^= 1;
+    BOOST_CHECK_NE(blockChecksum(block.data(), block.size()), checksum);
+
+    BOOST_CHECK_EQUAL(blockChecksum(block.data(), 9), crc32c(block.data(), 9));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
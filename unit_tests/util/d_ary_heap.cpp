@@ -0,0 +1,211 @@
+#include "util/d_ary_heap.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/mpl/list.hpp>
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(d_ary_heap)
+
+using namespace osrm;
+using namespace osrm::util;
+
+struct TestData
+{
+    unsigned value;
+};
+
+typedef NodeID TestNodeID;
+typedef int TestKey;
+typedef int TestWeight;
+typedef boost::mpl::list<
+    DAryHeap<TestNodeID, TestKey, TestWeight, TestData, ArrayStorage<TestNodeID, TestKey>, 2>,
+    DAryHeap<TestNodeID,
+             TestKey,
+             TestWeight,
+             TestData,
+             TimestampedArrayStorage<TestNodeID, TestKey>,
+             4>,
+    DAryHeap<TestNodeID,
+             TestKey,
+             TestWeight,
+             TestData,
+             UnorderedMapStorage<TestNodeID, TestKey>,
+             8>>
+    heap_types;
+
+constexpr unsigned NUM_NODES = 100;
+
+template <unsigned NUM_ELEM> struct RandomDataFixture
+{
+    RandomDataFixture()
+    {
+        for (unsigned i = 0; i < NUM_ELEM; i++)
+        {
+            data.push_back(TestData{i * 3});
+            weights.push_back((i + 1) * 100);
+            ids.push_back(i);
+            order.push_back(i);
+        }
+
+        std::mt19937 g(15);
+        std::shuffle(order.begin(), order.end(), g);
+    }
+
+    std::vector<TestData> data;
+    std::vector<TestWeight> weights;
+    std::vector<TestNodeID> ids;
+    std::vector<unsigned> order;
+};
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(insert_test, T, heap_types, RandomDataFixture<NUM_NODES>)
+{
+    T heap(NUM_NODES);
+
+    TestWeight min_weight = std::numeric_limits<TestWeight>::max();
+    TestNodeID min_id;
+
+    for (unsigned idx : order)
+    {
+        BOOST_CHECK(!heap.WasInserted(ids[idx]));
+
+        heap.Insert(ids[idx], weights[idx], data[idx]);
+
+        BOOST_CHECK(heap.WasInserted(ids[idx]));
+
+        if (weights[idx] < min_weight)
+        {
+            min_weight = weights[idx];
+            min_id = ids[idx];
+        }
+        BOOST_CHECK_EQUAL(min_id, heap.Min());
+        BOOST_CHECK_EQUAL(min_weight, heap.MinKey());
+    }
+
+    for (auto id : ids)
+    {
+        BOOST_CHECK_EQUAL(heap.GetData(id).value, data[id].value);
+        BOOST_CHECK_EQUAL(heap.GetKey(id), weights[id]);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(delete_min_test, T, heap_types, RandomDataFixture<NUM_NODES>)
+{
+    T heap(NUM_NODES);
+
+    for (unsigned idx : order)
+    {
+        heap.Insert(ids[idx], weights[idx], data[idx]);
+    }
+
+    for (auto id : ids)
+    {
+        BOOST_CHECK(!heap.WasRemoved(id));
+
+        BOOST_CHECK_EQUAL(heap.Min(), id);
+        BOOST_CHECK_EQUAL(id, heap.DeleteMin());
+        if (id + 1 < NUM_NODES)
+            BOOST_CHECK_EQUAL(heap.Min(), id + 1);
+
+        BOOST_CHECK(heap.WasRemoved(id));
+    }
+    BOOST_CHECK(heap.Empty());
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(delete_all_test, T, heap_types, RandomDataFixture<NUM_NODES>)
+{
+    T heap(NUM_NODES);
+
+    for (unsigned idx : order)
+    {
+        heap.Insert(ids[idx], weights[idx], data[idx]);
+    }
+
+    heap.DeleteAll();
+
+    BOOST_CHECK(heap.Empty());
+    for (auto id : ids)
+    {
+        BOOST_CHECK(heap.WasInserted(id));
+        BOOST_CHECK(heap.WasRemoved(id));
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(decrease_key_test, T, heap_types, RandomDataFixture<10>)
+{
+    T heap(10);
+
+    for (unsigned idx : order)
+    {
+        heap.Insert(ids[idx], weights[idx], data[idx]);
+    }
+
+    std::vector<TestNodeID> rids(ids);
+    std::reverse(rids.begin(), rids.end());
+
+    for (auto id : rids)
+    {
+        TestNodeID min_id = heap.Min();
+        TestWeight min_weight = heap.GetKey(min_id);
+
+        // decrease weight until we reach min weight
+        while (weights[id] > min_weight)
+        {
+            heap.DecreaseKey(id, weights[id]);
+            BOOST_CHECK_EQUAL(heap.Min(), min_id);
+            BOOST_CHECK_EQUAL(heap.MinKey(), min_weight);
+            weights[id]--;
+        }
+
+        // make weight smaller than min
+        weights[id] -= 2;
+        heap.DecreaseKey(id, weights[id]);
+        BOOST_CHECK_EQUAL(heap.Min(), id);
+        BOOST_CHECK_EQUAL(heap.MinKey(), weights[id]);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(random_order_test, T, heap_types, RandomDataFixture<NUM_NODES>)
+{
+    T heap(NUM_NODES);
+
+    std::mt19937 g(42);
+    std::uniform_int_distribution<TestWeight> weight_distribution(-1000, 1000);
+
+    std::vector<TestWeight> random_weights;
+    for (auto id : ids)
+    {
+        random_weights.push_back(weight_distribution(g));
+        heap.Insert(id, random_weights.back(), data[id]);
+    }
+
+    // decrease every third key to exercise the sift-up path on interior nodes
+    for (auto id : ids)
+    {
+        if (id % 3 == 0)
+        {
+            random_weights[id] -= 500;
+            heap.DecreaseKey(id, random_weights[id]);
+        }
+    }
+
+    std::vector<TestWeight> popped;
+    while (!heap.Empty())
+    {
+        const auto weight = heap.MinKey();
+        const auto node = heap.DeleteMin();
+        BOOST_CHECK_EQUAL(weight, random_weights[node]);
+        popped.push_back(weight);
+    }
+
+    std::sort(random_weights.begin(), random_weights.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        popped.begin(), popped.end(), random_weights.begin(), random_weights.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
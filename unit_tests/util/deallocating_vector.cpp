@@ -0,0 +1,77 @@
+#include "util/deallocating_vector.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <numeric>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(deallocating_vector)
+
+using namespace osrm;
+using namespace osrm::util;
+
+using TestVector = DeallocatingVector<int, 4>;
+
+namespace
+{
+TestVector makeVector(const int first, const int count)
+{
+    TestVector vector;
+    for (int value = first; value < first + count; ++value)
+        vector.push_back(value);
+    return vector;
+}
+
+void checkValues(const TestVector &vector, const int count)
+{
+    BOOST_REQUIRE_EQUAL(vector.size(), count);
+    for (int index = 0; index < count; ++index)
+        BOOST_CHECK_EQUAL(vector[index], index);
+}
+}
+
+BOOST_AUTO_TEST_CASE(append_range)
+{
+    std::vector<int> values(11);
+    std::iota(values.begin(), values.end(), 3);
+
+    auto vector = makeVector(0, 3);
+    vector.append(values.begin(), values.end());
+    checkValues(vector, 14);
+
+    vector.push_back(14);
+    checkValues(vector, 15);
+}
+
+BOOST_AUTO_TEST_CASE(append_vector)
+{
+    // ends on a bucket boundary, the buckets are taken over
+    auto full_buckets = makeVector(0, 8);
+    auto other = makeVector(8, 7);
+    full_buckets.append(std::move(other));
+    BOOST_CHECK_EQUAL(other.size(), 0);
+    checkValues(full_buckets, 15);
+    full_buckets.push_back(15);
+    full_buckets.push_back(16);
+    checkValues(full_buckets, 17);
+
+    // ends inside of a bucket, the elements are copied
+    auto partial_bucket = makeVector(0, 5);
+    auto next = makeVector(5, 6);
+    partial_bucket.append(std::move(next));
+    BOOST_CHECK_EQUAL(next.size(), 0);
+    checkValues(partial_bucket, 11);
+
+    // the emptied vector can be filled again
+    next.push_back(0);
+    checkValues(next, 1);
+
+    TestVector empty;
+    empty.append(makeVector(0, 4));
+    checkValues(empty, 4);
+    empty.push_back(4);
+    checkValues(empty, 5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
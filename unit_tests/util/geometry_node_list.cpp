@@ -0,0 +1,132 @@
+#include "util/geometry_node_list.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(geometry_node_list)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+GeometryNodeList<false> compress(const std::vector<NodeID> &nodes)
+{
+    GeometryNodeEncoder counter;
+    for (const auto node : nodes)
+        counter.push_back(node);
+
+    std::vector<GeometryNodeBlock> blocks(counter.GetNumberOfBlocks());
+    std::vector<std::uint8_t> bytes(counter.GetNumberOfBytes());
+    GeometryNodeEncoder encoder(blocks.data(), bytes.data());
+    for (const auto node : nodes)
+        encoder.push_back(node);
+
+    return GeometryNodeList<false>(blocks, bytes, nodes.size());
+}
+
+// runs of close ids with jumps in between and the extremes of the id range
+std::vector<NodeID> makeNodes()
+{
+    std::vector<NodeID> nodes;
+    for (NodeID node = 1000; node < 1040; ++node)
+        nodes.push_back(node);
+    nodes.push_back(0);
+    nodes.push_back(SPECIAL_NODEID);
+    nodes.push_back(7);
+    for (NodeID node = 500000; node > 499950; node -= 2)
+        nodes.push_back(node);
+    nodes.push_back(123456789);
+    return nodes;
+}
+
+void checkViews(const GeometryNodeList<false> &list, const std::vector<NodeID> &nodes)
+{
+    BOOST_REQUIRE_EQUAL(list.size(), nodes.size());
+    for (std::size_t index = 0; index < nodes.size(); ++index)
+    {
+        BOOST_CHECK_EQUAL(list[index], nodes[index]);
+    }
+
+    for (const auto &range : {std::make_pair(0, 50), std::make_pair(14, 33), std::make_pair(15, 17),
+                              std::make_pair(40, 44), std::make_pair(0, 0)})
+    {
+        const std::vector<NodeID> expected(nodes.begin() + range.first,
+                                           nodes.begin() + range.second);
+        const auto forward = list.GetView(range.first, range.second);
+        const std::vector<NodeID> forward_nodes(forward.begin(), forward.end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            forward_nodes.begin(), forward_nodes.end(), expected.begin(), expected.end());
+
+        const std::vector<NodeID> reversed_expected(expected.rbegin(), expected.rend());
+        const auto reverse = list.GetView(range.first, range.second, true);
+        std::vector<NodeID> reverse_nodes;
+        reverse.decode(std::back_inserter(reverse_nodes));
+        BOOST_CHECK_EQUAL_COLLECTIONS(reverse_nodes.begin(),
+                                      reverse_nodes.end(),
+                                      reversed_expected.begin(),
+                                      reversed_expected.end());
+        for (std::size_t index = 0; index < reverse.size(); ++index)
+        {
+            BOOST_CHECK_EQUAL(reverse[index], reversed_expected[index]);
+        }
+
+        // walking back from the end decodes against the direction of the view
+        std::vector<NodeID> backwards;
+        for (auto node = reverse.end(); node != reverse.begin();)
+        {
+            backwards.push_back(*--node);
+        }
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            backwards.begin(), backwards.end(), expected.begin(), expected.end());
+    }
+}
+}
+
+BOOST_AUTO_TEST_CASE(compressed_test)
+{
+    const auto nodes = makeNodes();
+    const auto list = compress(nodes);
+    BOOST_CHECK(list.compressed());
+    checkViews(list, nodes);
+}
+
+BOOST_AUTO_TEST_CASE(plain_test)
+{
+    auto nodes = makeNodes();
+    const auto expected = nodes;
+    const GeometryNodeList<false> list(nodes);
+    BOOST_CHECK(!list.compressed());
+    checkViews(list, expected);
+}
+
+BOOST_AUTO_TEST_CASE(size_test)
+{
+    GeometryNodeEncoder counter;
+    for (NodeID node = 1000; node < 1000 + 10 * GEOMETRY_NODE_BLOCK_SIZE; ++node)
+        counter.push_back(node);
+    BOOST_CHECK_EQUAL(counter.GetNumberOfBlocks(), 10);
+    // the first difference takes two bytes, every other one byte
+    BOOST_CHECK_EQUAL(counter.GetNumberOfBytes(), 10 * GEOMETRY_NODE_BLOCK_SIZE + 1);
+}
+
+BOOST_AUTO_TEST_CASE(iterator_test)
+{
+    const auto nodes = makeNodes();
+    const auto list = compress(nodes);
+    const auto view = list.GetView(3, 60);
+    auto node = view.begin() + 20;
+    BOOST_CHECK_EQUAL(*node, nodes[23]);
+    BOOST_CHECK_EQUAL(*--node, nodes[22]);
+    node += 30;
+    BOOST_CHECK_EQUAL(*node, nodes[52]);
+    BOOST_CHECK_EQUAL(*++node, nodes[53]);
+    BOOST_CHECK_EQUAL(view.end() - node, 57 - 50);
+    BOOST_CHECK_EQUAL(view.front(), nodes[3]);
+    BOOST_CHECK_EQUAL(view.back(), nodes[59]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,111 @@
+#include "util/json_renderer.hpp"
+#include "util/json_writer.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(json_writer)
+
+using namespace osrm;
+using namespace osrm::util;
+
+std::string toString(const std::vector<char> &buffer)
+{
+    return std::string(buffer.begin(), buffer.end());
+}
+
+BOOST_AUTO_TEST_CASE(empty_containers)
+{
+    json::Writer writer;
+    writer.BeginObject();
+    writer.Key("array");
+    writer.BeginArray();
+    writer.EndArray();
+    writer.Key("object");
+    writer.BeginObject();
+    writer.EndObject();
+    writer.EndObject();
+
+    BOOST_CHECK_EQUAL(toString(writer.GetBuffer()), "{\"array\":[],\"object\":{}}");
+}
+
+BOOST_AUTO_TEST_CASE(values)
+{
+    json::Writer writer;
+    writer.BeginArray();
+    writer.String("a \"quoted\" string");
+    writer.Number(1.5);
+    writer.Number(10);
+    writer.True();
+    writer.False();
+    writer.Null();
+    writer.BeginArray();
+    writer.Number(0.25);
+    writer.EndArray();
+    writer.EndArray();
+
+    BOOST_CHECK_EQUAL(toString(writer.GetBuffer()),
+                      "[\"a \\\"quoted\\\" string\",1.5,10,true,false,null,[0.25]]");
+}
+
+BOOST_AUTO_TEST_CASE(same_output_as_renderer)
+{
+    json::Array array;
+    array.values.push_back(json::Number(3.14159));
+    array.values.push_back(json::String("text"));
+    array.values.push_back(json::Null());
+    json::Object object;
+    object.values["key"] = array;
+
+    std::vector<char> rendered;
+    json::render(rendered, object);
+
+    json::Writer streamed;
+    streamed.BeginObject();
+    streamed.Key("key");
+    streamed.BeginArray();
+    streamed.Number(3.14159);
+    streamed.String("text");
+    streamed.Null();
+    streamed.EndArray();
+    streamed.EndObject();
+    BOOST_CHECK_EQUAL(toString(streamed.GetBuffer()), toString(rendered));
+
+    json::Writer embedded;
+    embedded.Write(object);
+    BOOST_CHECK_EQUAL(toString(embedded.GetBuffer()), toString(rendered));
+}
+
+BOOST_AUTO_TEST_CASE(tenths_same_as_number)
+{
+    const std::vector<std::int64_t> values = {
+        0, 1, 9, 10, 11, 99, 100, 123456, -1, -10, -123, 2147483647, -2147483647};
+    for (const auto value : values)
+    {
+        json::Writer tenths;
+        tenths.Tenths(value);
+        json::Writer number;
+        number.Number(value / 10.);
+        BOOST_CHECK_EQUAL(toString(tenths.GetBuffer()), toString(number.GetBuffer()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(recycled_buffer)
+{
+    std::vector<char> previous(4096, 'x');
+    const auto capacity = previous.capacity();
+
+    json::Writer writer(std::move(previous));
+    writer.BeginArray();
+    writer.Number(1);
+    writer.Null();
+    writer.EndArray();
+    BOOST_CHECK_EQUAL(toString(writer.GetBuffer()), "[1,null]");
+    BOOST_CHECK_EQUAL(writer.GetBuffer().capacity(), capacity);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
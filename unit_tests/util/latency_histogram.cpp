@@ -0,0 +1,57 @@
+#include "util/latency_histogram.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+
+BOOST_AUTO_TEST_SUITE(latency_histogram)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(bucket_bounds)
+{
+    // every duration falls into the bucket whose bounds enclose it, buckets are contiguous
+    std::uint64_t lower_bound = 0;
+    for (std::size_t bucket = 0; bucket + 1 < LatencyHistogram::NUM_BUCKETS; ++bucket)
+    {
+        const auto upper_bound = LatencyHistogram::BucketUpperBound(bucket);
+        BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(lower_bound), bucket);
+        BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(upper_bound), bucket);
+        // relative error of the upper bound
+        BOOST_CHECK_LE(upper_bound - lower_bound, lower_bound / LatencyHistogram::SUB_BUCKETS);
+        lower_bound = upper_bound + 1;
+    }
+
+    BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(std::uint64_t{1} << 62),
+                      LatencyHistogram::NUM_BUCKETS - 1);
+}
+
+BOOST_AUTO_TEST_CASE(quantiles)
+{
+    LatencyHistogram first;
+    LatencyHistogram second;
+    for (std::uint64_t microseconds = 1; microseconds <= 1000; ++microseconds)
+    {
+        (microseconds % 2 == 0 ? first : second).Record(microseconds);
+    }
+
+    LatencySummary summary;
+    first.Collect(summary);
+    second.Collect(summary);
+    BOOST_CHECK_EQUAL(summary.count, 1000);
+    BOOST_CHECK_EQUAL(summary.sum, 500500);
+
+    const auto median = summary.Quantile(0.5);
+    BOOST_CHECK_GE(median, 500);
+    BOOST_CHECK_LE(median, 500 + 500 / LatencyHistogram::SUB_BUCKETS);
+    const auto p99 = summary.Quantile(0.99);
+    BOOST_CHECK_GE(p99, 990);
+    BOOST_CHECK_LE(p99, 990 + 990 / LatencyHistogram::SUB_BUCKETS);
+    BOOST_CHECK_EQUAL(summary.Quantile(0.), 1);
+
+    BOOST_CHECK_EQUAL(LatencySummary().Quantile(0.5), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
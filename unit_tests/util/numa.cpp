@@ -0,0 +1,37 @@
+#include "util/numa.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+
+BOOST_AUTO_TEST_SUITE(numa)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(nodes)
+{
+    const auto &nodes = getNumaNodes();
+    BOOST_REQUIRE(!nodes.empty());
+    for (const auto &cpus : nodes)
+    {
+        BOOST_CHECK(!cpus.empty());
+    }
+    BOOST_CHECK_LT(getCurrentNumaNode(), nodes.size());
+}
+
+BOOST_AUTO_TEST_CASE(run_on_node)
+{
+    for (unsigned node = 0; node < getNumaNodes().size(); ++node)
+    {
+        unsigned current_node = getNumaNodes().size();
+        runOnNumaNode(node, [&] { current_node = getCurrentNumaNode(); });
+        BOOST_CHECK_EQUAL(current_node, node);
+    }
+
+    BOOST_CHECK_THROW(runOnNumaNode(0, [] { throw std::runtime_error("task failed"); }),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,9 @@
 #include <boost/test/test_case_template.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <iterator>
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(packed_vector_test)
 
 using namespace osrm;
@@ -31,6 +34,48 @@ BOOST_AUTO_TEST_CASE(insert_and_retrieve_packed_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(set_and_decode_packed_test)
+{
+    PackedVector<OSMNodeID, false> packed_ids;
+    std::vector<OSMNodeID> original_ids;
+
+    // values that use all 33 bits, split between words at every offset
+    for (std::size_t i = 0; i < 200; i++)
+    {
+        const OSMNodeID id{(std::uint64_t{1} << 32) | (i * 2654435761u % 4294967291u)};
+        packed_ids.push_back(OSMNodeID{0});
+        original_ids.push_back(id);
+    }
+    for (std::size_t i = 0; i < original_ids.size(); i++)
+    {
+        packed_ids.set(original_ids.size() - 1 - i, original_ids[original_ids.size() - 1 - i]);
+    }
+
+    std::vector<OSMNodeID> decoded;
+    packed_ids.decode(0, packed_ids.size(), std::back_inserter(decoded));
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        decoded.begin(), decoded.end(), original_ids.begin(), original_ids.end());
+
+    decoded.clear();
+    packed_ids.decode(17, 101, std::back_inserter(decoded));
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        decoded.begin(), decoded.end(), original_ids.begin() + 17, original_ids.begin() + 101);
+}
+
+BOOST_AUTO_TEST_CASE(packed_vector_bitsize_test)
+{
+    PackedVector<std::uint64_t, false, 7> packed_values;
+    for (std::uint64_t i = 0; i < 300; i++)
+    {
+        packed_values.push_back(i);
+    }
+
+    for (std::uint64_t i = 0; i < 300; i++)
+    {
+        BOOST_CHECK_EQUAL(packed_values.at(i), i % 128);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(packed_vector_capacity_test)
 {
     PackedVector<OSMNodeID, false> packed_vec;
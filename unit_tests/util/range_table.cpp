@@ -5,6 +5,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <numeric>
+#include <vector>
 #include <stxxl/vector>
 
 BOOST_AUTO_TEST_SUITE(range_table)
@@ -108,4 +109,32 @@ BOOST_AUTO_TEST_CASE(construction_test)
     ConstructionTest(multiple_lengths, multiple_offsets);
 }
 
+template <unsigned TEST_BLOCK_SIZE> void BlockSizeTest(const std::vector<unsigned> &lengths)
+{
+    std::vector<unsigned> offsets(lengths.size() + 1, 0);
+    std::partial_sum(lengths.begin(), lengths.end(), offsets.begin() + 1);
+
+    RangeTable<TEST_BLOCK_SIZE, false> table(lengths);
+    for (unsigned i = 0; i < lengths.size(); i++)
+    {
+        auto range = table.GetRange(i);
+        BOOST_CHECK_EQUAL(range.front(), offsets[i]);
+        BOOST_CHECK_EQUAL(range.front() + range.size(), offsets[i + 1]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(block_size_test)
+{
+    // the largest lengths do not overflow the sums of the lanes
+    std::vector<unsigned> lengths(200, 255);
+    // empty ranges and small lengths mixed in
+    for (unsigned i = 0; i < lengths.size(); i += 3)
+        lengths[i] = i % 7;
+
+    BlockSizeTest<8>(lengths);
+    BlockSizeTest<12>(lengths);
+    BlockSizeTest<16>(lengths);
+    BlockSizeTest<32>(lengths);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,137 @@
+#include "util/segment_weight_list.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(segment_weight_list)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+SegmentWeightList<false> pack(const std::vector<EdgeWeight> &weights)
+{
+    SegmentWeightEncoder counter;
+    for (const auto weight : weights)
+        counter.push_back(weight);
+
+    std::vector<std::uint16_t> values(counter.GetNumberOfWeights());
+    std::vector<SegmentWeightOverflow> overflows(counter.GetNumberOfOverflows());
+    SegmentWeightEncoder encoder(values.data(), overflows.data());
+    for (const auto weight : weights)
+        encoder.push_back(weight);
+
+    return SegmentWeightList<false>(values, overflows);
+}
+
+const std::vector<EdgeWeight> weights = {
+    0, 1, 65533, 65534, INVALID_EDGE_WEIGHT, 7, 100000, 3, 65535, 12, -1, 5};
+}
+
+BOOST_AUTO_TEST_CASE(random_access)
+{
+    const auto list = pack(weights);
+    BOOST_REQUIRE_EQUAL(list.size(), weights.size());
+    for (std::size_t index = 0; index < weights.size(); ++index)
+    {
+        BOOST_CHECK_EQUAL(list[index], weights[index]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(views)
+{
+    const auto list = pack(weights);
+
+    const auto forward = list.GetView(2, 10);
+    BOOST_CHECK_EQUAL(forward.size(), 8);
+    BOOST_CHECK_EQUAL(forward.front(), 65533);
+    BOOST_CHECK_EQUAL(forward.back(), 12);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        forward.begin(), forward.end(), weights.begin() + 2, weights.begin() + 10);
+
+    const auto reverse = list.GetView(1, 11, true);
+    const std::vector<EdgeWeight> reversed_weights(weights.rbegin() + 1, weights.rbegin() + 11);
+    BOOST_CHECK_EQUAL(reverse.front(), -1);
+    BOOST_CHECK_EQUAL(reverse.back(), 1);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        reverse.begin(), reverse.end(), reversed_weights.begin(), reversed_weights.end());
+
+    BOOST_CHECK(list.GetView(4, 4).empty());
+    BOOST_CHECK(list.GetView(4, 4, true).empty());
+}
+
+BOOST_AUTO_TEST_CASE(decode_views)
+{
+    const auto list = pack(weights);
+    for (const auto reversed : {false, true})
+    {
+        for (std::size_t first = 0; first <= weights.size(); ++first)
+        {
+            for (std::size_t last = first; last <= weights.size(); ++last)
+            {
+                std::vector<EdgeWeight> expected(weights.begin() + first, weights.begin() + last);
+                if (reversed)
+                    std::reverse(expected.begin(), expected.end());
+
+                std::vector<EdgeWeight> decoded;
+                list.GetView(first, last, reversed).decode(std::back_inserter(decoded));
+                BOOST_CHECK_EQUAL_COLLECTIONS(
+                    decoded.begin(), decoded.end(), expected.begin(), expected.end());
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(weight_offsets)
+{
+    // three geometries of 3, 1 and 4 nodes and an empty one, the weights before a forward and
+    // after a reverse geometry are not part of it
+    const std::vector<unsigned> indices = {0, 3, 4, 4, 8};
+    const std::vector<EdgeWeight> forward_weights = {-1, 2, 3, -1, -1, 5, 6, 70000};
+    const std::vector<EdgeWeight> reverse_weights = {1, 2, -1, -1, 4, 5, 70000, -1};
+
+    auto forward = forward_weights;
+    auto reverse = reverse_weights;
+    toSegmentWeightOffsets(
+        indices.data(), indices.data() + indices.size(), forward.data(), reverse.data());
+
+    const std::vector<EdgeWeight> expected_forward = {0, 2, 5, 0, 0, 5, 11, 70011};
+    const std::vector<EdgeWeight> expected_reverse = {3, 2, 0, 0, 70009, 70005, 70000, 0};
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        forward.begin(), forward.end(), expected_forward.begin(), expected_forward.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        reverse.begin(), reverse.end(), expected_reverse.begin(), expected_reverse.end());
+
+    // the offsets of a segment are the sums of the weights before it in its direction
+    const auto forward_list = pack(forward_weights);
+    const auto reverse_list = pack(reverse_weights);
+    for (std::size_t geometry = 0; geometry + 1 < indices.size(); ++geometry)
+    {
+        const auto first = indices[geometry];
+        const auto last = indices[geometry + 1];
+        if (first == last)
+            continue;
+
+        const auto forward_view = forward_list.GetView(first + 1, last);
+        const auto reverse_view = reverse_list.GetView(first, last - 1, true);
+        for (std::size_t position = 0; position <= forward_view.size(); ++position)
+        {
+            BOOST_CHECK_EQUAL(forward[first + position],
+                              std::accumulate(forward_view.begin(),
+                                              forward_view.begin() + position,
+                                              EdgeWeight{0}));
+            BOOST_CHECK_EQUAL(reverse[last - 1 - position],
+                              std::accumulate(reverse_view.begin(),
+                                              reverse_view.begin() + position,
+                                              EdgeWeight{0}));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -21,6 +21,7 @@
 #include <memory>
 #include <random>
 #include <string>
+#include <tuple>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -39,7 +40,7 @@ using namespace osrm::test;
 constexpr uint32_t TEST_BRANCHING_FACTOR = 8;
 constexpr uint32_t TEST_LEAF_NODE_SIZE = 64;
 
-using TestData = extractor::EdgeBasedNode;
+using TestData = extractor::EdgeBasedNodeSegment;
 using TestStaticRTree = StaticRTree<TestData,
                                     std::vector<Coordinate>,
                                     false,
@@ -137,7 +138,7 @@ template <unsigned NUM_NODES, unsigned NUM_EDGES> struct RandomGraphFixture
             if (used_edges.find(std::pair<unsigned, unsigned>(
                     std::min(data.u, data.v), std::max(data.u, data.v))) == used_edges.end())
             {
-                data.component.id = 0;
+                data.is_tiny_component = false;
                 edges.emplace_back(data);
                 used_edges.emplace(std::min(data.u, data.v), std::max(data.u, data.v));
             }
@@ -246,6 +247,34 @@ void sampling_verify_rtree(RTreeT &rtree,
     }
 }
 
+template <typename RTreeT>
+void batch_verify_rtree(RTreeT &rtree, unsigned num_samples)
+{
+    std::mt19937 g(RANDOM_SEED);
+    std::uniform_int_distribution<> lat_udist(WORLD_MIN_LAT, WORLD_MAX_LAT);
+    std::uniform_int_distribution<> lon_udist(WORLD_MIN_LON, WORLD_MAX_LON);
+    std::vector<Coordinate> queries;
+    for (unsigned i = 0; i < num_samples; i++)
+    {
+        queries.emplace_back(FixedLongitude{lon_udist(g)}, FixedLatitude{lat_udist(g)});
+    }
+
+    const auto batch_results = rtree.Nearest(queries, 3);
+    BOOST_REQUIRE_EQUAL(batch_results.size(), queries.size());
+
+    for (const auto index : util::irange<std::size_t>(0UL, queries.size()))
+    {
+        const auto single_results = rtree.Nearest(queries[index], 3);
+        const auto &batch_result = batch_results[index];
+        BOOST_REQUIRE_EQUAL(batch_result.size(), single_results.size());
+        for (const auto result_index : util::irange<std::size_t>(0UL, single_results.size()))
+        {
+            BOOST_CHECK_EQUAL(batch_result[result_index].u, single_results[result_index].u);
+            BOOST_CHECK_EQUAL(batch_result[result_index].v, single_results[result_index].v);
+        }
+    }
+}
+
 template <typename FixtureT, typename RTreeT = TestStaticRTree>
 void build_rtree(const std::string &prefix,
                  FixtureT *fixture,
@@ -269,6 +298,11 @@ void construction_test(const std::string &prefix, FixtureT *fixture)
 
     simple_verify_rtree(rtree, fixture->coords, fixture->edges);
     sampling_verify_rtree(rtree, lsnn, fixture->coords, 100);
+    batch_verify_rtree(rtree, 100);
+
+    // prefetching only affects paging and must not change any results
+    rtree.PrefetchLeafNodes();
+    batch_verify_rtree(rtree, 10);
 }
 
 BOOST_FIXTURE_TEST_CASE(construct_tiny, TestRandomGraphFixture_10_30)
@@ -396,6 +430,18 @@ BOOST_AUTO_TEST_CASE(bearing_tests)
         BOOST_CHECK_EQUAL(results.size(), 2);
         BOOST_CHECK_EQUAL(results.back().phantom_node.forward_segment_id.id, 0);
         BOOST_CHECK_EQUAL(results.back().phantom_node.reverse_segment_id.id, 1);
+
+        // the phantom nodes of several results are made from the weights of their geometries at
+        // once, a single one on its own
+        const auto nearest = query.NearestPhantomNodes(input, 1);
+        BOOST_REQUIRE_EQUAL(nearest.size(), 1);
+        const auto &lhs = nearest.front().phantom_node;
+        const auto &rhs = results.front().phantom_node;
+        BOOST_CHECK_EQUAL(lhs.forward_weight, rhs.forward_weight);
+        BOOST_CHECK_EQUAL(lhs.forward_offset, rhs.forward_offset);
+        BOOST_CHECK_EQUAL(lhs.reverse_weight, rhs.reverse_weight);
+        BOOST_CHECK_EQUAL(lhs.reverse_offset, rhs.reverse_offset);
+        BOOST_CHECK_EQUAL(nearest.front().distance, results.front().distance);
     }
 
     {
@@ -440,6 +486,112 @@ BOOST_AUTO_TEST_CASE(bearing_tests)
     }
 }
 
+BOOST_AUTO_TEST_CASE(bearing_classes_tests)
+{
+    using Coord = std::pair<FloatLongitude, FloatLatitude>;
+    using Edge = std::pair<unsigned, unsigned>;
+
+    // a grid with streets in all four directions and diagonals to the north east
+    std::vector<Coord> coords;
+    std::vector<Edge> edges;
+    const unsigned size = 20;
+    for (unsigned y = 0; y < size; ++y)
+    {
+        for (unsigned x = 0; x < size; ++x)
+        {
+            // moved a bit, so no two segments have the same distance to the input
+            coords.emplace_back(FloatLongitude{x * 0.001 + (x * 7 + y * 13) % 5 * 0.00003},
+                                FloatLatitude{y * 0.001 + (x * 11 + y * 3) % 7 * 0.00002});
+            const auto node = y * size + x;
+            if (x + 1 < size)
+                edges.emplace_back(node, node + 1);
+            if (y + 1 < size)
+                edges.emplace_back(node + size, node);
+            if (x + 1 < size && y + 1 < size)
+                edges.emplace_back(node, node + size + 1);
+        }
+    }
+    GraphFixture fixture(coords, edges);
+    // one way streets that can only be used to the east
+    for (auto &edge : fixture.edges)
+    {
+        if (edge.v == edge.u + 1)
+            edge.reverse_segment_id.enabled = false;
+    }
+
+    std::string leaves_path;
+    std::string nodes_path;
+    build_rtree<GraphFixture, TestStaticRTree>(
+        "test_bearing_classes", &fixture, leaves_path, nodes_path);
+    TestStaticRTree rtree(nodes_path, leaves_path, fixture.coords);
+
+    const Coordinate input(FloatLongitude{0.01053}, FloatLatitude{0.00937});
+    for (const auto filter_bearing : {0, 45, 90, 180, 225, 270, 359})
+    {
+        for (const auto filter_range : {5, 10, 30, 90, 180})
+        {
+            const auto filter = [&](const TestStaticRTree::CandidateSegment &segment) {
+                const auto forward_bearing = coordinate_calculation::bearing(
+                    fixture.coords[segment.data.u], fixture.coords[segment.data.v]);
+                const auto backward_bearing = (forward_bearing + 180) > 360
+                                                  ? (forward_bearing - 180)
+                                                  : (forward_bearing + 180);
+                return std::make_pair(segment.data.forward_segment_id.enabled &&
+                                          bearing::CheckInBounds(std::round(forward_bearing),
+                                                                 filter_bearing,
+                                                                 filter_range),
+                                      segment.data.reverse_segment_id.enabled &&
+                                          bearing::CheckInBounds(std::round(backward_bearing),
+                                                                 filter_bearing,
+                                                                 filter_range));
+            };
+            const auto terminate = [&input](const std::size_t,
+                                            const TestStaticRTree::CandidateSegment &segment) {
+                return coordinate_calculation::haversineDistance(
+                           input, web_mercator::toWGS84(segment.fixed_projected_coordinate)) > 300;
+            };
+
+            // segments with the same distance to the input can come in any order
+            const auto sorted = [](std::vector<TestData> segments) {
+                std::sort(segments.begin(),
+                          segments.end(),
+                          [](const TestData &lhs, const TestData &rhs) {
+                              return std::tie(lhs.u, lhs.v) < std::tie(rhs.u, rhs.v);
+                          });
+                return segments;
+            };
+            const auto expected = sorted(rtree.Nearest(input, filter, terminate));
+            const auto results = sorted(
+                rtree.Nearest(input,
+                              TestStaticRTree::GetBearingClasses(filter_bearing, filter_range),
+                              filter,
+                              terminate));
+
+            BOOST_CHECK_EQUAL(results.size(), expected.size());
+            for (std::size_t i = 0; i < std::min(results.size(), expected.size()); ++i)
+            {
+                BOOST_CHECK_EQUAL(results[i].u, expected[i].u);
+                BOOST_CHECK_EQUAL(results[i].v, expected[i].v);
+                BOOST_CHECK_EQUAL(results[i].forward_segment_id.enabled,
+                                  expected[i].forward_segment_id.enabled);
+                BOOST_CHECK_EQUAL(results[i].reverse_segment_id.enabled,
+                                  expected[i].reverse_segment_id.enabled);
+            }
+        }
+    }
+
+    // no street goes to the south east
+    BOOST_CHECK_EQUAL(rtree.Nearest(input,
+                                    TestStaticRTree::GetBearingClasses(135, 10),
+                                    [](const TestStaticRTree::CandidateSegment &) {
+                                        return std::make_pair(true, true);
+                                    },
+                                    [](const std::size_t,
+                                       const TestStaticRTree::CandidateSegment &) { return false; })
+                          .size(),
+                      0);
+}
+
 BOOST_AUTO_TEST_CASE(bbox_search_tests)
 {
     using Coord = std::pair<FloatLongitude, FloatLatitude>;
@@ -0,0 +1,27 @@
+#include "util/system_memory.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(system_memory)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(resident_memory)
+{
+    // written memory is resident, also at unaligned ends of the range
+    std::vector<char> memory(1 << 20, 1);
+    const auto resident = getResidentMemory(memory.data() + 3, memory.size() - 5);
+    BOOST_REQUIRE(resident);
+    BOOST_CHECK_EQUAL(*resident, memory.size() - 5);
+
+    const auto empty = getResidentMemory(memory.data(), 0);
+    BOOST_REQUIRE(empty);
+    BOOST_CHECK_EQUAL(*empty, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,7 @@
 #include <osrm/coordinate.hpp>
 
 #include <cmath>
+#include <vector>
 
 using namespace osrm;
 using namespace osrm::util;
@@ -81,4 +82,64 @@ BOOST_AUTO_TEST_CASE(xyz_to_mercator)
     BOOST_CHECK_CLOSE(maxy, 19971868.880408578, 0.0001);
 }
 
+BOOST_AUTO_TEST_CASE(lat_to_y_approx)
+{
+    // the approximation is exact up to 1e-11 degrees where it is used and exact elsewhere
+    for (double latitude = -85.; latitude <= 85.; latitude += 0.001)
+    {
+        const auto y = web_mercator::latToY(util::FloatLatitude{latitude});
+        const auto y_approx = web_mercator::latToYapprox(util::FloatLatitude{latitude});
+        BOOST_CHECK_SMALL(y_approx - y, 1e-11);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(from_wgs84_batch)
+{
+    const std::vector<util::Coordinate> coordinates = {
+        {util::FloatLongitude{7.41}, util::FloatLatitude{43.73}},
+        {util::FloatLongitude{-122.42}, util::FloatLatitude{37.77}},
+        {util::FloatLongitude{25.78}, util::FloatLatitude{71.17}}};
+
+    std::vector<util::FloatCoordinate> projected(coordinates.size());
+    web_mercator::fromWGS84(coordinates.begin(), coordinates.end(), projected.begin());
+    for (const auto index : {0, 1, 2})
+    {
+        BOOST_CHECK(projected[index] == web_mercator::fromWGS84(coordinates[index]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(tile_projection)
+{
+    // z=14 tile of Monaco
+    const int x = 8529, y = 5975, z = 14;
+    const double extent = 4096;
+    double minx, miny, maxx, maxy;
+    web_mercator::xyzToMercator(x, y, z, minx, miny, maxx, maxy);
+    const web_mercator::TileProjection projection(x, y, z, extent);
+
+    for (const auto &coordinate :
+         {util::Coordinate{util::FloatLongitude{7.41}, util::FloatLatitude{43.73}},
+          util::Coordinate{util::FloatLongitude{7.4321}, util::FloatLatitude{43.7412}},
+          util::Coordinate{util::FloatLongitude{7.35}, util::FloatLatitude{43.80}}})
+    {
+        const double mercator_x =
+            static_cast<double>(toFloating(coordinate.lon)) * web_mercator::DEGREE_TO_PX;
+        const double mercator_y =
+            web_mercator::latToY(toFloating(coordinate.lat)) * web_mercator::DEGREE_TO_PX;
+        BOOST_CHECK_SMALL(projection.X(coordinate.lon) -
+                              (mercator_x - minx) * extent / (maxx - minx),
+                          1e-6);
+        BOOST_CHECK_SMALL(projection.Y(coordinate.lat) -
+                              (maxy - mercator_y) * extent / (maxy - miny),
+                          1e-6);
+    }
+
+    // the corners of the tile, a fixed coordinate is a fifth of a pixel at z=14
+    web_mercator::xyzToWGS84(x, y, z, minx, miny, maxx, maxy);
+    BOOST_CHECK_SMALL(projection.X(toFixed(util::FloatLongitude{minx})), 0.5);
+    BOOST_CHECK_CLOSE(projection.X(toFixed(util::FloatLongitude{maxx})), extent, 0.02);
+    BOOST_CHECK_SMALL(projection.Y(toFixed(util::FloatLatitude{maxy})), 0.5);
+    BOOST_CHECK_CLOSE(projection.Y(toFixed(util::FloatLatitude{miny})), extent, 0.02);
+}
+
 BOOST_AUTO_TEST_SUITE_END()